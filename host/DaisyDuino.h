@@ -0,0 +1,228 @@
+#pragma once
+#ifndef DSY_HOST_DAISYDUINO_H
+#define DSY_HOST_DAISYDUINO_H
+
+// Host stand-in for DaisyDuino.h, for the native env: enough of the
+// Arduino and DaisyDuino API for src/main.cpp and include/, with the
+// real DaisySP and the hardware-free DaisyDuino utilities underneath. Audio does not run on a timer; the runner
+// (host/host_main.cpp) pushes blocks through the callback begin() was
+// given, as fast as it goes.
+//
+// Only what the sketch uses at the codec is here. Anything it calls that
+// is not, fails to compile rather than silently doing nothing.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "daisysp.h"
+#include "utility/param_block.h"
+#include "utility/sdram_arena.h"
+#include "utility/section_profiler.h"
+#include "utility/seqlock.h"
+
+using namespace daisysp;
+
+// No TCMs, SDRAM or non-cached SRAM on the host.
+#define DSY_SDRAM_BSS
+#define DMA_BUFFER_MEM_SECTION
+#define DTCM_MEM_SECTION
+#define DSY_ITCM_FUNC
+
+#define OUT_L out[0]
+#define OUT_R out[1]
+#define IN_L in[0]
+#define IN_R in[1]
+
+#define D7 7
+#define D9 9
+
+#define INPUT_PULLUP 2
+
+enum DaisyDuinoDevice : short
+{
+  DAISY_SEED,
+  DAISY_POD,
+  DAISY_PETAL,
+  DAISY_FIELD,
+  DAISY_PATCH,
+  DAISY_PATCH_SM,
+  DAISY_LAST,
+};
+
+enum DaisyDuinoSampleRate
+{
+  AUDIO_SR_8K,
+  AUDIO_SR_16K,
+  AUDIO_SR_32K,
+  AUDIO_SR_48K,
+  AUDIO_SR_96K,
+  AUDIO_SR_192K,
+  AUDIO_SR_LAST,
+};
+
+namespace daisy
+{
+struct SaiHandle
+{
+  struct Config
+  {
+    enum class BitDepth
+    {
+      SAI_16BIT,
+      SAI_24BIT,
+      SAI_32BIT,
+    };
+    enum class Clock
+    {
+      INTERNAL,
+      EXTERNAL,
+    };
+    enum class Slots
+    {
+      STEREO,
+      TDM_4,
+      TDM_8,
+    };
+  };
+};
+
+class AudioHandle
+{
+public:
+  typedef void (*AudioCallback)(float** in, float** out, size_t size);
+  typedef void (*InterleavingAudioCallback)(float* in, float* out, size_t size);
+  typedef void (*NativeAudioCallback)(const int32_t* const* in, int32_t* const* out, size_t size);
+  typedef void (*ControlCallback)(size_t frames);
+};
+
+// No load to govern: the runner goes as fast as it can, so every stage
+// stays at full quality and Add() hands out none.
+class QualityStage
+{
+public:
+  uint8_t GetTier() const { return 0; }
+};
+
+class QualityGovernor
+{
+public:
+  QualityStage* Add(const char* name, uint8_t tiers)
+  {
+    (void)name;
+    (void)tiers;
+    return nullptr;
+  }
+};
+
+// No buttons on the host: a Switch is never pressed, so the sketch stays
+// in the mode it starts in.
+class Switch
+{
+public:
+  void Init(float update_rate, bool invert, uint8_t pin, uint8_t mode)
+  {
+    (void)update_rate;
+    (void)invert;
+    (void)pin;
+    (void)mode;
+  }
+  void Debounce() {}
+  bool RisingEdge() { return false; }
+  bool FallingEdge() { return false; }
+  bool Pressed() { return false; }
+};
+
+class System
+{
+public:
+  // Clock profiles mean nothing here; kept so init() calls compile.
+  struct Config
+  {
+    void Defaults() {}
+    void Boost() {}
+  };
+};
+} // namespace daisy
+
+using namespace daisy;
+
+class DaisyHardware
+{
+};
+
+// The audio engine, driven by the host runner instead of the SAI.
+class AudioClass
+{
+public:
+  AudioClass();
+
+  DaisyHardware init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr = AUDIO_SR_48K,
+                     bool flush_denormals = false);
+  DaisyHardware init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr,
+                     const System::Config& sys, bool flush_denormals = false);
+
+  void SetFlushDenormals(bool enable);
+
+  void begin(AudioHandle::AudioCallback cb);
+  void begin(AudioHandle::InterleavingAudioCallback cb);
+  void begin(AudioHandle::NativeAudioCallback cb);
+  void end();
+
+  float get_samplerate() { return sample_rate_; }
+  float get_callbackrate() { return sample_rate_ / block_size_; }
+
+  void SetControlCallback(AudioHandle::ControlCallback cb, size_t every_blocks = 1);
+  void SetAudioBlockSize(size_t blocksize);
+  size_t AudioBlockSize() { return block_size_; }
+  void SetAudioDmaSegments(size_t segments) { (void)segments; }
+  size_t AudioDroppedBlocks() { return 0; }
+  void SetAudioClock(SaiHandle::Config::Clock clock) { (void)clock; }
+  // The runner is stereo: no TDM.
+  bool SetAudioSlots(SaiHandle::Config::Slots slots) { return slots == SaiHandle::Config::Slots::STEREO; }
+  size_t AudioChannels() { return 2; }
+  uint32_t AudioFrameCount() { return frames_; }
+  uint32_t AudioBlockFrame() { return block_frame_; }
+  SaiHandle::Config::BitDepth AudioBitDepth() { return SaiHandle::Config::BitDepth::SAI_24BIT; }
+
+  void SetIdleSleep(bool enable, bool gate_clocks = false)
+  {
+    (void)enable;
+    (void)gate_clocks;
+  }
+  void Idle() {}
+  QualityGovernor& Governor() { return governor_; }
+
+  // Host only: true once begin() has a callback to run.
+  bool HostRunning() const;
+
+  // Host only: one block of size frames (at most AudioBlockSize())
+  // through the callback, non-interleaved stereo, and the control
+  // callback on its schedule. A native callback gets and gives 24-bit
+  // words, as from the Seed's codec.
+  void HostProcess(const float* in_l, const float* in_r, float* out_l, float* out_r, size_t size);
+
+private:
+  float sample_rate_;
+  size_t block_size_;
+  AudioHandle::AudioCallback cb_;
+  AudioHandle::InterleavingAudioCallback interleaved_cb_;
+  AudioHandle::NativeAudioCallback native_cb_;
+  AudioHandle::ControlCallback control_cb_;
+  size_t control_every_;
+  size_t control_count_;
+  size_t control_frames_;
+  uint32_t frames_;
+  uint32_t block_frame_;
+  QualityGovernor governor_;
+};
+
+extern AudioClass DAISY;
+
+/** Milliseconds of audio run so far, so time-based logic in loop()
+  follows the audio as on the target. */
+uint32_t millis();
+uint32_t micros();
+
+#endif
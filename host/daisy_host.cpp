@@ -0,0 +1,192 @@
+#include "DaisyDuino.h"
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
+
+AudioClass DAISY;
+
+static float SampleRateHz(DaisyDuinoSampleRate sr)
+{
+  switch (sr)
+  {
+  case AUDIO_SR_8K: return 8000.0f;
+  case AUDIO_SR_16K: return 16000.0f;
+  case AUDIO_SR_32K: return 32000.0f;
+  case AUDIO_SR_96K: return 96000.0f;
+  case AUDIO_SR_192K: return 192000.0f;
+  default: return 48000.0f;
+  }
+}
+
+// The Seed codec's right-aligned 24-bit words, as the SAI delivers them.
+static int32_t FloatToSai24(float x)
+{
+  x = x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x);
+  return static_cast<int32_t>(x * 8388607.0f) & 0xFFFFFF;
+}
+
+static float Sai24ToFloat(int32_t w)
+{
+  const int32_t s = static_cast<int32_t>(static_cast<uint32_t>(w) << 8) >> 8;
+  return static_cast<float>(s) * (1.0f / 8388608.0f);
+}
+
+AudioClass::AudioClass()
+    : sample_rate_(48000.0f), block_size_(48), cb_(nullptr), interleaved_cb_(nullptr),
+      native_cb_(nullptr), control_cb_(nullptr), control_every_(1), control_count_(0),
+      control_frames_(0), frames_(0), block_frame_(0)
+{
+}
+
+DaisyHardware AudioClass::init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr,
+                               bool flush_denormals)
+{
+  (void)device;
+  sample_rate_ = SampleRateHz(sr);
+  SetFlushDenormals(flush_denormals);
+  return DaisyHardware();
+}
+
+DaisyHardware AudioClass::init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr,
+                               const System::Config& sys, bool flush_denormals)
+{
+  (void)sys;
+  return init(device, sr, flush_denormals);
+}
+
+void AudioClass::SetFlushDenormals(bool enable)
+{
+  // For the whole process: one thread runs the callback and everything
+  // else alike.
+#if defined(__SSE__) || defined(__x86_64__)
+  const unsigned int ftz_daz = 0x8040;
+  _mm_setcsr(enable ? (_mm_getcsr() | ftz_daz) : (_mm_getcsr() & ~ftz_daz));
+#elif defined(__aarch64__)
+  uint64_t fpcr;
+  asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+  const uint64_t fz = 1u << 24;
+  fpcr = enable ? (fpcr | fz) : (fpcr & ~fz);
+  asm volatile("msr fpcr, %0" : : "r"(fpcr));
+#else
+  (void)enable;
+#endif
+}
+
+void AudioClass::begin(AudioHandle::AudioCallback cb)
+{
+  end();
+  cb_ = cb;
+}
+
+void AudioClass::begin(AudioHandle::InterleavingAudioCallback cb)
+{
+  end();
+  interleaved_cb_ = cb;
+}
+
+void AudioClass::begin(AudioHandle::NativeAudioCallback cb)
+{
+  end();
+  native_cb_ = cb;
+}
+
+void AudioClass::end()
+{
+  cb_ = nullptr;
+  interleaved_cb_ = nullptr;
+  native_cb_ = nullptr;
+}
+
+void AudioClass::SetControlCallback(AudioHandle::ControlCallback cb, size_t every_blocks)
+{
+  control_cb_ = cb;
+  control_every_ = every_blocks > 0 ? every_blocks : 1;
+  control_count_ = 0;
+  control_frames_ = 0;
+}
+
+void AudioClass::SetAudioBlockSize(size_t blocksize)
+{
+  block_size_ = blocksize > 0 && blocksize <= 1024 ? blocksize : 48;
+}
+
+bool AudioClass::HostRunning() const
+{
+  return cb_ || interleaved_cb_ || native_cb_;
+}
+
+void AudioClass::HostProcess(const float* in_l, const float* in_r, float* out_l, float* out_r,
+                             size_t size)
+{
+  // The target's callback buffers, sized like AudioHandle's: planar
+  // float, interleaved float, or interleaved codec words.
+  static float planar_in[2][1024], planar_out[2][1024];
+  static float inter_in[2 * 1024], inter_out[2 * 1024];
+  static int32_t words_in[2 * 1024], words_out[2 * 1024];
+
+  size = size < block_size_ ? size : block_size_;
+  block_frame_ = frames_;
+  if (cb_)
+  {
+    memcpy(planar_in[0], in_l, size * sizeof(float));
+    memcpy(planar_in[1], in_r, size * sizeof(float));
+    float* in[2] = {planar_in[0], planar_in[1]};
+    float* out[2] = {planar_out[0], planar_out[1]};
+    cb_(in, out, size);
+    memcpy(out_l, planar_out[0], size * sizeof(float));
+    memcpy(out_r, planar_out[1], size * sizeof(float));
+  }
+  else if (interleaved_cb_)
+  {
+    for (size_t i = 0; i < size; i++)
+    {
+      inter_in[2 * i] = in_l[i];
+      inter_in[2 * i + 1] = in_r[i];
+    }
+    interleaved_cb_(inter_in, inter_out, size * 2);
+    for (size_t i = 0; i < size; i++)
+    {
+      out_l[i] = inter_out[2 * i];
+      out_r[i] = inter_out[2 * i + 1];
+    }
+  }
+  else if (native_cb_)
+  {
+    for (size_t i = 0; i < size; i++)
+    {
+      words_in[2 * i] = FloatToSai24(in_l[i]);
+      words_in[2 * i + 1] = FloatToSai24(in_r[i]);
+    }
+    const int32_t* in[1] = {words_in};
+    int32_t* out[1] = {words_out};
+    native_cb_(in, out, size);
+    for (size_t i = 0; i < size; i++)
+    {
+      out_l[i] = Sai24ToFloat(words_out[2 * i]);
+      out_r[i] = Sai24ToFloat(words_out[2 * i + 1]);
+    }
+  }
+  frames_ += static_cast<uint32_t>(size);
+
+  // On the target the control callback runs below the audio interrupt
+  // once every every_blocks blocks; here, between them.
+  control_frames_ += size;
+  if (control_cb_ && ++control_count_ >= control_every_)
+  {
+    control_count_ = 0;
+    control_cb_(control_frames_);
+    control_frames_ = 0;
+  }
+}
+
+uint32_t millis()
+{
+  return static_cast<uint32_t>(static_cast<double>(DAISY.AudioFrameCount()) * 1000.0 /
+                               static_cast<double>(DAISY.get_samplerate()));
+}
+
+uint32_t micros()
+{
+  return static_cast<uint32_t>(static_cast<double>(DAISY.AudioFrameCount()) * 1000000.0 /
+                               static_cast<double>(DAISY.get_samplerate()));
+}
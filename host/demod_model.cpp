@@ -0,0 +1,238 @@
+#include "demod_model.h"
+#include <DaisyDuino.h>
+#include <cmath>
+#include <complex>
+
+using Complex = std::complex<double>;
+
+// Without the Annex G NaN handling operator* goes through, which
+// dominates the run time otherwise.
+static inline Complex Mul(const Complex& a, const Complex& b)
+{
+  return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+// exp(-2 pi i k / n) for k < n / 2, for Fft() at size n.
+static std::vector<Complex> Twiddles(size_t n)
+{
+  std::vector<Complex> w(n / 2);
+  for (size_t k = 0; k < n / 2; k++)
+    w[k] = std::polar(1.0, -2.0 * M_PI * (double)k / (double)n);
+  return w;
+}
+
+// In-place radix-2 FFT; size a power of two, twiddles from Twiddles().
+// inverse leaves out the 1/n.
+static void Fft(std::vector<Complex>& x, const std::vector<Complex>& twiddles, bool inverse)
+{
+  const size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; i++)
+  {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j |= bit;
+    if (i < j)
+      std::swap(x[i], x[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1)
+  {
+    const size_t stride = n / len;
+    for (size_t i = 0; i < n; i += len)
+    {
+      for (size_t k = 0; k < len / 2; k++)
+      {
+        const Complex w = inverse ? std::conj(twiddles[k * stride]) : twiddles[k * stride];
+        const Complex u = x[i + k];
+        const Complex v = Mul(x[i + k + len / 2], w);
+        x[i + k] = u + v;
+        x[i + k + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+void Demodulate(const std::vector<float>& out, float sample_rate, std::vector<float>& audible)
+{
+  static HilbertFir<255> hilbert;
+  constexpr size_t kDelay = HilbertFir<255>::GetLatency() + 1;
+
+  const size_t n = out.size();
+  std::vector<float> i_out(n), q_out(n);
+  hilbert.Init();
+  hilbert.ProcessBlock(out.data(), i_out.data(), q_out.data(), n);
+
+  // E^2 two frames back, one back and now; the difference is centred on
+  // the middle one.
+  const double w = 2.0 * M_PI * (double)kDemodRefHz;
+  const double scale = (double)sample_rate * (double)sample_rate / (w * w);
+  std::vector<float> d2(n, 0.0f);
+  double e0 = 0.0, e1 = 0.0;
+  for (size_t k = 0; k < n; k++)
+  {
+    const double e = (double)i_out[k] * (double)i_out[k] + (double)q_out[k] * (double)q_out[k];
+    if (k >= 2)
+      d2[k] = (float)((e - 2.0 * e1 + e0) * scale);
+    e0 = e1;
+    e1 = e;
+  }
+
+  BiquadCascade<4> ear;
+  ear.Init();
+  const float fc = kDemodAudibleHz < 0.45f * sample_rate ? kDemodAudibleHz : 0.45f * sample_rate;
+  IirDesign::Load(ear, IirDesign::Butterworth<8>(IirDesign::Response::LOWPASS, sample_rate, fc));
+  ear.ProcessBlock(d2.data(), d2.data(), n);
+
+  audible.assign(n, 0.0f);
+  for (size_t k = kDelay; k < n; k++)
+    audible[k - kDelay] = d2[k];
+}
+
+namespace
+{
+// Welch sums over the segments, per bin: the input auto- and
+// cross-spectra, and each input against the estimate.
+struct Spectra
+{
+  std::vector<double> s11, s22, syy;
+  std::vector<Complex> s12, s1y, s2y;
+  size_t segments = 0;
+};
+} // namespace
+
+// y is read from offset on, so a positive offset takes out that lag.
+// Segments start every hop frames, at least half a segment.
+static void Accumulate(const WavData& in, const std::vector<float>& y, size_t start, long offset,
+                       size_t hop, Spectra& s)
+{
+  const size_t n = kDemodSegment;
+  const size_t bins = n / 2 + 1;
+  s = Spectra();
+  s.s11.assign(bins, 0.0);
+  s.s22.assign(bins, 0.0);
+  s.syy.assign(bins, 0.0);
+  s.s12.assign(bins, 0.0);
+  s.s1y.assign(bins, 0.0);
+  s.s2y.assign(bins, 0.0);
+
+  std::vector<double> window(n);
+  for (size_t k = 0; k < n; k++)
+    window[k] = 0.5 - 0.5 * std::cos(2.0 * M_PI * (double)k / (double)n);
+
+  // Both inputs in one transform, as real and imaginary parts, split
+  // apart by symmetry after.
+  const std::vector<Complex> twiddles = Twiddles(n);
+  std::vector<Complex> u(n), v(n);
+  const long frames = (long)y.size();
+  hop = hop > n / 2 ? hop : n / 2;
+  for (size_t at = start; at + n <= in.l.size(); at += hop)
+  {
+    const long first = (long)at + offset;
+    if (first < 0 || first + (long)n > frames)
+      continue;
+    for (size_t k = 0; k < n; k++)
+    {
+      u[k] = Complex((double)in.l[at + k] * window[k], (double)in.r[at + k] * window[k]);
+      v[k] = (double)y[(size_t)first + k] * window[k];
+    }
+    Fft(u, twiddles, false);
+    Fft(v, twiddles, false);
+    for (size_t b = 0; b < bins; b++)
+    {
+      const Complex z = u[b];
+      const Complex zm = std::conj(u[(n - b) % n]);
+      const Complex u1 = 0.5 * (z + zm);
+      const Complex u2 = Complex(0.0, -0.5) * (z - zm);
+      s.s11[b] += std::norm(u1);
+      s.s22[b] += std::norm(u2);
+      s.syy[b] += std::norm(v[b]);
+      s.s12[b] += Mul(std::conj(u1), u2);
+      s.s1y[b] += Mul(std::conj(u1), v[b]);
+      s.s2y[b] += Mul(std::conj(u2), v[b]);
+    }
+    s.segments++;
+  }
+}
+
+// The lag of the cross-correlation peak against the stronger-coupled
+// input, within half a segment either way.
+static long Lag(const Spectra& s)
+{
+  const size_t n = kDemodSegment;
+  double c1 = 0.0, c2 = 0.0;
+  for (size_t b = 0; b <= n / 2; b++)
+  {
+    c1 += std::abs(s.s1y[b]);
+    c2 += std::abs(s.s2y[b]);
+  }
+  const std::vector<Complex>& cross = c1 >= c2 ? s.s1y : s.s2y;
+  std::vector<Complex> r(n);
+  for (size_t b = 0; b <= n / 2; b++)
+  {
+    r[b] = cross[b];
+    if (b > 0 && b < n / 2)
+      r[n - b] = std::conj(cross[b]);
+  }
+  Fft(r, Twiddles(n), true);
+  size_t best = 0;
+  for (size_t k = 1; k < n; k++)
+    if (std::abs(r[k].real()) > std::abs(r[best].real()))
+      best = k;
+  return best < n / 2 ? (long)best : (long)best - (long)n;
+}
+
+DemodMeasure Measure(const std::vector<float>& audible, const WavData& in, float sample_rate)
+{
+  DemodMeasure m;
+  const size_t n = kDemodSegment;
+  const size_t frames = audible.size() < in.l.size() ? audible.size() : in.l.size();
+  size_t start = (size_t)(kDemodSettleSeconds * sample_rate);
+  start = start < frames / 4 ? start : frames / 4;
+  if (frames < start + 2 * n)
+    return m;
+
+  double sum = 0.0;
+  for (size_t k = start; k < frames; k++)
+    sum += (double)audible[k] * (double)audible[k];
+  const double rms = std::sqrt(sum / (double)(frames - start));
+  m.level_db = 20.0 * std::log10(rms > 1e-12 ? rms : 1e-12);
+
+  Spectra s;
+  // For the lag, kLagSegments spread over the input are plenty.
+  constexpr size_t kLagSegments = 16;
+  Accumulate(in, audible, start, 0, (frames - start - n) / kLagSegments, s);
+  m.lag = Lag(s);
+  Accumulate(in, audible, start, m.lag, n / 2, s);
+  if (s.segments == 0)
+    return m;
+
+  const double hz = (double)sample_rate / (double)n;
+  const size_t lo = (size_t)std::ceil((double)kDemodBandLoHz / hz);
+  size_t hi = (size_t)((double)kDemodBandHiHz / hz);
+  hi = hi < n / 2 ? hi : n / 2;
+  double total = 0.0, residual = 0.0;
+  for (size_t b = lo; b <= hi; b++)
+  {
+    const double s11 = s.s11[b], s22 = s.s22[b];
+    const Complex a = s.s1y[b], c = s.s2y[b];
+    const double det = s11 * s22 - std::norm(s.s12[b]);
+    double explained;
+    if (det > 1e-6 * s11 * s22 && det > 0.0)
+    {
+      // s^H Sxx^-1 s, s = (S1y, S2y): both inputs at once.
+      explained = (s22 * std::norm(a) + s11 * std::norm(c) - 2.0 * Mul(Mul(std::conj(a), s.s12[b]), c).real()) / det;
+    }
+    else
+    {
+      // The inputs are one signal (mono, or one side silent).
+      explained = s11 >= s22 ? (s11 > 0.0 ? std::norm(a) / s11 : 0.0) : std::norm(c) / s22;
+    }
+    total += s.syy[b];
+    residual += s.syy[b] - explained > 0.0 ? s.syy[b] - explained : 0.0;
+  }
+  if (total <= 0.0)
+    return m;
+  m.residual_db = 10.0 * std::log10(residual > 1e-30 * total ? residual / total : 1e-30);
+  m.valid = true;
+  return m;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "wav_file.h"
+
+// What the air makes of the output, for the host runner: Berktay's
+// far-field model of the parametric array. The audible pressure on the
+// axis is proportional to the second time derivative of the squared
+// envelope of the ultrasound,
+//
+//   p(t) ~ d^2/dt^2 E^2(t)
+//
+// so a modulator can be judged offline by what it would put in the
+// room, not by its electrical output.
+//
+// Demodulate() takes one output channel at its own rate. E^2 is
+// i^2 + q^2 from a HilbertFir<255>, the analytic signal's power, which
+// has no 2fc term to alias the way squaring the raw signal would (at
+// 96 kHz, 2 x 39.5 kHz folds to 17 kHz). The second difference times
+// fs^2 is divided by (2 pi kDemodRefHz)^2, so a 1 kHz component of E^2
+// keeps its amplitude, then an 8th-order Butterworth at kDemodAudibleHz
+// stands in for the ear and the microphone. The Hilbert and
+// second-difference delays are taken out; the Butterworth's is left in.
+//
+// Measure() compares the estimate with the input that drove it. It
+// takes the cross-spectra (Welch, Hann, kDemodSegment points, half
+// overlap) of the estimate against both input channels, after the
+// settling time, and splits the estimate's power from kDemodBandLoHz to
+// kDemodBandHiHz into the part a linear filter of the input explains
+// (multiple coherence) and the rest: distortion and noise. Any EQ,
+// pre-emphasis or latency the firmware applies is linear, so only what
+// the modulator and the square law add counts against it. The estimate
+// is first aligned by the cross-correlation peak, which is reported as
+// the lag: the firmware's latency plus the Butterworth's. On periodic
+// input (tones) the lag is only known modulo the period.
+struct DemodMeasure
+{
+  bool valid = false;      // the input was long enough
+  double level_db = 0.0;    // estimate RMS after settling, dB re 1.0
+  double residual_db = 0.0; // distortion and noise against the in-band power
+  long lag = 0;             // frames the estimate trails the input by
+};
+
+constexpr float kDemodRefHz = 1000.0f;
+constexpr float kDemodAudibleHz = 20000.0f;
+constexpr float kDemodBandLoHz = 100.0f;
+constexpr float kDemodBandHiHz = 16000.0f;
+constexpr size_t kDemodSegment = 8192;
+constexpr float kDemodSettleSeconds = 0.5f;
+
+void Demodulate(const std::vector<float>& out, float sample_rate, std::vector<float>& audible);
+DemodMeasure Measure(const std::vector<float>& audible, const WavData& in, float sample_rate);
@@ -0,0 +1,147 @@
+// Host runner for the native env: the firmware's setup(), then its
+// audio callback over a WAV file, block by block, as fast as the host
+// goes, with the control callback and loop() in between as on the
+// target.
+//
+//   program                   10 s of generated input, timing only
+//   program in.wav            in.wav through the callback, timing only
+//   program in.wav out.wav    and the output as 32-bit float stereo
+//   program in.wav out.wav audible.wav
+//                             and the demodulated estimate, the same way
+//
+// Prints the frames run, the wall-clock time, how many times faster
+// than real time that is, and each output channel's peak and RMS, which
+// a regression run can compare. Then, after the timing, each channel
+// through the demodulation model in demod_model.h: the level of what
+// the air would make of it, its distortion and noise against the input,
+// and its lag. The input should be at the rate the firmware asks init()
+// for; it is not resampled.
+#include <DaisyDuino.h>
+#include <chrono>
+#include <cstdio>
+#include "demod_model.h"
+#include "wav_file.h"
+
+void setup();
+void loop();
+
+static void Generate(WavData& wav, float sample_rate, float seconds)
+{
+  // Left, a 20 Hz to 20 kHz log sweep at -6 dBFS; right, white noise at
+  // -12 dBFS.
+  const size_t frames = (size_t)(sample_rate * seconds);
+  wav.l.resize(frames);
+  wav.r.resize(frames);
+  wav.sample_rate = (uint32_t)sample_rate;
+  wav.channels = 2;
+  const double k = std::log(1000.0) / frames;
+  double phase = 0.0;
+  uint32_t x = 1;
+  for (size_t i = 0; i < frames; i++)
+  {
+    phase += 2.0 * M_PI * 20.0 * std::exp(k * (double)i) / (double)sample_rate;
+    wav.l[i] = (float)(0.5 * std::sin(phase));
+    x = x * 1664525u + 1013904223u;
+    wav.r[i] = (float)(int32_t)x * (0.25f / 2147483648.0f);
+  }
+}
+
+static void Levels(const char* name, const std::vector<float>& s)
+{
+  double sum = 0.0;
+  float peak = 0.0f;
+  for (float v : s)
+  {
+    sum += (double)v * (double)v;
+    peak = std::fabs(v) > peak ? std::fabs(v) : peak;
+  }
+  const double rms = s.empty() ? 0.0 : std::sqrt(sum / s.size());
+  printf("  %s peak %.6f  rms %.6f\n", name, (double)peak, rms);
+}
+
+static void Audible(const char* name, const std::vector<float>& audible, const WavData& in,
+                    float sample_rate)
+{
+  const DemodMeasure m = Measure(audible, in, sample_rate);
+  if (!m.valid)
+  {
+    printf("  %s too short to measure\n", name);
+    return;
+  }
+  printf("  %s level %.1f dB  distortion+noise %.1f dB (%.2f%%)  lag %ld frames\n", name,
+         m.level_db, m.residual_db, 100.0 * std::pow(10.0, m.residual_db / 20.0), m.lag);
+}
+
+int main(int argc, char** argv)
+{
+  setup();
+  if (!DAISY.HostRunning())
+  {
+    fprintf(stderr, "setup() did not start the audio\n");
+    return 1;
+  }
+  const float sample_rate = DAISY.get_samplerate();
+
+  WavData in;
+  if (argc > 1)
+  {
+    if (!ReadWav(argv[1], in))
+    {
+      fprintf(stderr, "cannot read %s as 16/24/32-bit PCM or float WAV\n", argv[1]);
+      return 1;
+    }
+    if (in.sample_rate != (uint32_t)sample_rate)
+      fprintf(stderr, "warning: %s is %u Hz, the firmware runs at %.0f Hz\n", argv[1],
+              in.sample_rate, (double)sample_rate);
+  }
+  else
+  {
+    Generate(in, sample_rate, 10.0f);
+  }
+
+  WavData out;
+  out.sample_rate = (uint32_t)sample_rate;
+  out.l.resize(in.l.size());
+  out.r.resize(in.r.size());
+
+  const size_t frames = in.l.size();
+  const size_t block = DAISY.AudioBlockSize();
+  const auto t0 = std::chrono::steady_clock::now();
+  for (size_t pos = 0; pos < frames; pos += block)
+  {
+    const size_t n = frames - pos < block ? frames - pos : block;
+    DAISY.HostProcess(&in.l[pos], &in.r[pos], &out.l[pos], &out.r[pos], n);
+    loop();
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+
+  const double wall = std::chrono::duration<double>(t1 - t0).count();
+  const double audio = frames / (double)sample_rate;
+  printf("%zu frames at %.0f Hz in blocks of %zu\n", frames, (double)sample_rate, block);
+  printf("  %.3f s of audio in %.3f s: %.1fx real time, %.1f ns/frame\n", audio, wall,
+         wall > 0.0 ? audio / wall : 0.0, frames ? wall * 1e9 / frames : 0.0);
+  Levels("out[0]", out.l);
+  Levels("out[1]", out.r);
+
+  if (argc > 2 && !WriteWav(argv[2], out))
+  {
+    fprintf(stderr, "cannot write %s\n", argv[2]);
+    return 1;
+  }
+
+  WavData audible;
+  audible.sample_rate = out.sample_rate;
+  Demodulate(out.l, sample_rate, audible.l);
+  Demodulate(out.r, sample_rate, audible.r);
+  printf("demodulated, %.0f Hz reference, %.0f Hz to %.0f Hz:\n", (double)kDemodRefHz,
+         (double)kDemodBandLoHz, (double)kDemodBandHiHz);
+  Audible("audible[0]", audible.l, in, sample_rate);
+  Audible("audible[1]", audible.r, in, sample_rate);
+
+  if (argc > 3 && !WriteWav(argv[3], audible))
+  {
+    fprintf(stderr, "cannot write %s\n", argv[3]);
+    return 1;
+  }
+  return 0;
+}
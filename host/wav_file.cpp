@@ -0,0 +1,137 @@
+#include "wav_file.h"
+#include <cstdio>
+#include <cstring>
+
+static uint32_t Le32(const uint8_t* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t Le16(const uint8_t* p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void Put32(std::vector<uint8_t>& b, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+    b.push_back((uint8_t)(v >> (8 * i)));
+}
+
+static void Put16(std::vector<uint8_t>& b, uint16_t v)
+{
+  b.push_back((uint8_t)v);
+  b.push_back((uint8_t)(v >> 8));
+}
+
+static float Sample(const uint8_t* p, uint16_t format, uint16_t bits)
+{
+  if (format == 3)
+  {
+    float f;
+    memcpy(&f, p, 4);
+    return f;
+  }
+  switch (bits)
+  {
+  case 16: return (float)(int16_t)Le16(p) * (1.0f / 32768.0f);
+  case 24:
+  {
+    const uint32_t w = ((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24);
+    return (float)((int32_t)w >> 8) * (1.0f / 8388608.0f);
+  }
+  default: return (float)(int32_t)Le32(p) * (1.0f / 2147483648.0f);
+  }
+}
+
+bool ReadWav(const char* path, WavData& out)
+{
+  FILE* f = fopen(path, "rb");
+  if (!f)
+    return false;
+  std::vector<uint8_t> file;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    file.insert(file.end(), buf, buf + n);
+  fclose(f);
+
+  const uint8_t* p = file.data();
+  const size_t size = file.size();
+  if (size < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0)
+    return false;
+
+  uint16_t format = 0, channels = 0, bits = 0;
+  uint32_t rate = 0;
+  for (size_t at = 12; at + 8 <= size;)
+  {
+    const uint8_t* chunk = p + at;
+    const uint32_t len = Le32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0 && len >= 16 && at + 8 + len <= size)
+    {
+      format = Le16(chunk + 8);
+      channels = Le16(chunk + 10);
+      rate = Le32(chunk + 12);
+      bits = Le16(chunk + 22);
+      // WAVE_FORMAT_EXTENSIBLE: the real format leads the sub-format GUID.
+      if (format == 0xFFFE && len >= 40)
+        format = Le16(chunk + 32);
+    }
+    else if (memcmp(chunk, "data", 4) == 0)
+    {
+      const bool pcm = format == 1 && (bits == 16 || bits == 24 || bits == 32);
+      const bool flt = format == 3 && bits == 32;
+      if ((!pcm && !flt) || channels < 1 || channels > 2)
+        return false;
+      const size_t frame_bytes = (size_t)channels * bits / 8;
+      const size_t avail = size - (at + 8);
+      const size_t frames = (len < avail ? len : avail) / frame_bytes;
+      out.l.resize(frames);
+      out.r.resize(frames);
+      out.sample_rate = rate;
+      out.channels = channels;
+      const uint8_t* s = chunk + 8;
+      for (size_t i = 0; i < frames; i++, s += frame_bytes)
+      {
+        out.l[i] = Sample(s, format, bits);
+        out.r[i] = channels == 2 ? Sample(s + bits / 8, format, bits) : out.l[i];
+      }
+      return true;
+    }
+    at += 8 + len + (len & 1);
+  }
+  return false;
+}
+
+bool WriteWav(const char* path, const WavData& in)
+{
+  const size_t frames = in.l.size() < in.r.size() ? in.l.size() : in.r.size();
+  const uint32_t data_bytes = (uint32_t)(frames * 2 * sizeof(float));
+  std::vector<uint8_t> b;
+  b.reserve(44 + data_bytes);
+  b.insert(b.end(), {'R', 'I', 'F', 'F'});
+  Put32(b, 36 + data_bytes);
+  b.insert(b.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+  Put32(b, 16);
+  Put16(b, 3); // IEEE float
+  Put16(b, 2);
+  Put32(b, in.sample_rate);
+  Put32(b, in.sample_rate * 2 * sizeof(float));
+  Put16(b, 2 * sizeof(float));
+  Put16(b, 32);
+  b.insert(b.end(), {'d', 'a', 't', 'a'});
+  Put32(b, data_bytes);
+  for (size_t i = 0; i < frames; i++)
+  {
+    uint8_t s[8];
+    memcpy(s, &in.l[i], 4);
+    memcpy(s + 4, &in.r[i], 4);
+    b.insert(b.end(), s, s + 8);
+  }
+
+  FILE* f = fopen(path, "wb");
+  if (!f)
+    return false;
+  const bool ok = fwrite(b.data(), 1, b.size(), f) == b.size();
+  return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// WAV reading and writing for the host runner.
+//
+// Reads PCM at 16, 24 or 32 bits and 32-bit float (plain or
+// WAVE_FORMAT_EXTENSIBLE), mono or stereo, into planar float at +/- 1.0
+// full scale; mono fills both channels. Writes 32-bit float stereo,
+// so nothing the pipeline produces above full scale is clipped.
+struct WavData
+{
+  std::vector<float> l;
+  std::vector<float> r;
+  uint32_t sample_rate = 0;
+  unsigned channels = 0; // in the file
+};
+
+bool ReadWav(const char* path, WavData& out);
+bool WriteWav(const char* path, const WavData& in);
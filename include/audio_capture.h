@@ -0,0 +1,218 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include "modulator_pipeline.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// Streams one point of the pipeline to the host over USB serial, so the
+// baseband, the carrier or the final output can be looked at without a
+// scope (scripts/capture.py records and analyses it).
+//
+// Place a CaptureTap<capture, point> stage in the Pipeline wherever a
+// point should be available; the host picks which one records, and at
+// what decimation, with a line over the same port:
+//   tap <point> [decimation [channels]]   channels 1: l, 2: r, 3: both
+//   tap off
+// The taps that are not selected cost a compare per block.
+//
+// In the audio callback, the selected tap converts its block to 16 bits,
+// keeps every decimation-th frame and fills 64-frame packets into a
+// ring; loop() sends them with Poll(), as far as the CDC transmit queue
+// has room, so the ISR never waits on USB. A packet that finds the ring
+// full is dropped and counted; the host sees the gap in the sequence
+// numbers. Full-rate stereo at 96 kHz is 400 kB/s, near what the core's
+// CDC sustains over full-speed USB: take one channel or decimate for
+// long captures. Decimation drops frames without filtering, so above
+// the baseband points it aliases the carrier.
+//
+// On the wire, each packet is a Packet as laid out below, little-endian.
+class AudioCapture
+{
+public:
+  static constexpr size_t kMaxPoints = 8;
+  static constexpr size_t kPacketFrames = 64;
+  static constexpr uint32_t kMagic = 0x50414344; // "DCAP"
+
+  struct Packet
+  {
+    uint32_t magic;
+    uint32_t seq;         // counts every packet, sent or dropped
+    uint32_t sample_rate; // of the data, after decimation
+    uint8_t point;
+    uint8_t channels; // 1: l, 2: r, 3: both, interleaved
+    uint16_t frames;
+    int16_t data[2 * kPacketFrames];
+  };
+
+  void Init()
+  {
+    config_ = kOff;
+    active_ = kOff;
+    seq_ = 0;
+    dropped_ = 0;
+    line_len_ = 0;
+    for (float& r : rates_)
+      r = 0.0f;
+  }
+
+  // From loop(): starts recording point, every decimation-th frame of
+  // the channels given. One word, so the ISR never sees half a change.
+  void Select(uint8_t point, uint32_t decimation = 1, uint8_t channels = 3)
+  {
+    if (point >= kMaxPoints || channels < 1 || channels > 3)
+      return;
+    decimation = decimation < 1 ? 1 : (decimation > 0xFFFF ? 0xFFFF : decimation);
+    config_ = ((uint32_t)point << 24) | ((uint32_t)channels << 16) | decimation;
+  }
+
+  void Stop() { config_ = kOff; }
+
+  // Packets lost to a full ring since Init().
+  uint32_t Dropped() const { return dropped_; }
+
+  // From a tap's Init(): the rate its blocks run at.
+  void SetRate(uint8_t point, float sample_rate)
+  {
+    if (point < kMaxPoints)
+      rates_[point] = sample_rate;
+  }
+
+  // From a tap in the audio callback.
+  template <typename Block>
+  inline void Tap(uint8_t point, const Block& b)
+  {
+    const uint32_t config = config_;
+    if ((config >> 24) != point)
+      return;
+    if (config != active_)
+      Start(config);
+
+    const uint8_t channels = (config >> 16) & 0xFF;
+    const uint32_t decimation = config & 0xFFFF;
+    for (size_t i = skip_; i < b.size; i += decimation)
+    {
+      int16_t* dst = &packet_.data[packet_.frames * (channels == 3 ? 2 : 1)];
+      if (channels & 1)
+        *dst++ = ToS16(b.l[i]);
+      if (channels & 2)
+        *dst = ToS16(b.r[i]);
+      if (++packet_.frames == kPacketFrames)
+        Flush();
+    }
+    // Where the next block's first kept frame is.
+    const size_t past = b.size > skip_ ? (b.size - skip_) % decimation : 0;
+    skip_ = b.size > skip_ ? (past ? decimation - past : 0) : skip_ - b.size;
+  }
+
+  // From loop(): handles tap commands from port and sends what the ring
+  // holds, as much as port takes without blocking.
+  void Poll(Stream& port)
+  {
+    while (port.available() > 0)
+    {
+      const int c = port.read();
+      if (c == '\n' || c == '\r')
+      {
+        line_[line_len_] = '\0';
+        Command(line_);
+        line_len_ = 0;
+      }
+      else if (line_len_ + 1 < sizeof(line_))
+      {
+        line_[line_len_++] = (char)c;
+      }
+    }
+
+    while (const Packet* p = ring_.Peek())
+    {
+      if (port.availableForWrite() < (int)sizeof(Packet))
+        break;
+      port.write(reinterpret_cast<const uint8_t*>(p), sizeof(Packet));
+      ring_.Discard();
+    }
+  }
+
+private:
+  static constexpr uint32_t kOff = 0xFFFFFFFF;
+
+  static inline int16_t ToS16(float x)
+  {
+    x = x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x);
+    return (int16_t)(x * 32767.0f);
+  }
+
+  // Q31 pipeline samples, 1.0 at 2^30 (kQ31Unity).
+  static inline int16_t ToS16(int32_t q)
+  {
+    const int32_t s = q >> 15;
+    return (int16_t)(s > 32767 ? 32767 : (s < -32768 ? -32768 : s));
+  }
+
+  void Start(uint32_t config)
+  {
+    active_ = config;
+    const uint8_t point = config >> 24;
+    packet_.magic = kMagic;
+    packet_.point = point;
+    packet_.channels = (config >> 16) & 0xFF;
+    packet_.sample_rate = (uint32_t)(rates_[point] / (float)(config & 0xFFFF));
+    packet_.frames = 0;
+    skip_ = 0;
+  }
+
+  void Flush()
+  {
+    packet_.seq = seq_++;
+    if (!ring_.Push(packet_))
+      dropped_++;
+    packet_.frames = 0;
+  }
+
+  void Command(char* line)
+  {
+    if (strncmp(line, "tap", 3) != 0)
+      return;
+    char* at = line + 3;
+    while (*at == ' ')
+      at++;
+    if (strncmp(at, "off", 3) == 0)
+    {
+      Stop();
+      return;
+    }
+    char* end;
+    const unsigned long point = strtoul(at, &end, 10);
+    if (end == at)
+      return;
+    const unsigned long decimation = strtoul(end, &at, 10);
+    const unsigned long channels = strtoul(at, &end, 10);
+    Select((uint8_t)point, decimation ? (uint32_t)decimation : 1, channels ? (uint8_t)channels : 3);
+  }
+
+  volatile uint32_t config_; // point << 24 | channels << 16 | decimation
+  uint32_t active_;          // the config packet_ is being filled for
+  size_t skip_;              // frames into the next block before a kept one
+  uint32_t seq_;
+  volatile uint32_t dropped_;
+  float rates_[kMaxPoints];
+  Packet packet_;
+  SpscRing<Packet, 16> ring_;
+  char line_[32];
+  size_t line_len_;
+};
+
+// Pipeline stage that hands its block to capture as point.
+//   Pipeline<..., LowShelf, CaptureTap<capture, 0>, Modulation, ...>
+template <AudioCapture& capture, uint8_t point>
+struct CaptureTap
+{
+  void Init(float sample_rate) { capture.SetRate(point, sample_rate); }
+
+  template <typename Block>
+  inline void Process(Block& b)
+  {
+    capture.Tap(point, b);
+  }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <cmath>
+#include <cstddef>
+
+// Stereo-linked feed-forward compressor for the baseband path.
+//
+// The detector is a one-pole peak follower on max(|l|, |r|), so both
+// channels always get the same gain and the stereo image does not
+// wander. Attack/release selection is a ternary on floats, which the
+// M7 compiles to VSEL rather than a branch.
+//
+// The gain computer works in the log2 domain and only runs once per
+// kSubBlock samples:
+//   gain_log2 = max(log2(env) - log2(threshold), 0) * (1 / ratio - 1)
+// using fastlog2f() and pow10f(). The gain is then ramped linearly
+// across the next sub-block, which avoids zipper noise and keeps
+// transcendental calls to 1/kSubBlock of the sample rate.
+class BasebandCompressor
+{
+public:
+  static constexpr size_t kSubBlock = 16;
+
+  void Init()
+  {
+    env_ = 0.0f;
+    gain_ = 1.0f;
+  }
+
+  // Already-derived settings (see ModulatorParams::Update), so this is
+  // cheap enough to call every block.
+  //   log2_threshold = log2(threshold)
+  //   slope          = 1 / ratio - 1
+  //   attack/release = one-pole coefficients per sample
+  void SetCoeffs(float log2_threshold, float slope, float attack, float release)
+  {
+    log2_threshold_ = log2_threshold;
+    slope_ = slope;
+    attack_ = attack;
+    release_ = release;
+  }
+
+  // Compresses a stereo block in place.
+  void ProcessBlock(float* l, float* r, size_t size)
+  {
+    float env = env_;
+    float gain = gain_;
+    const float attack = attack_;
+    const float release = release_;
+
+    for (size_t start = 0; start < size; start += kSubBlock)
+    {
+      const size_t n = (size - start) < kSubBlock ? (size - start) : kSubBlock;
+
+      // Detector pass across the sub-block.
+      for (size_t i = start; i < start + n; i++)
+      {
+        const float ax = daisysp::fmax(fabsf(l[i]), fabsf(r[i]));
+        const float coef = (ax > env) ? attack : release;
+        env += (ax - env) * coef;
+      }
+
+      // Gain computer, once per sub-block.
+      const float over = daisysp::fmax(daisysp::fastlog2f(env + 1e-9f) - log2_threshold_, 0.0f);
+      const float target = daisysp::pow10f(over * slope_ * 0.30102999566f);
+
+      // Ramp from the previous gain to the new target.
+      const float step = (target - gain) / static_cast<float>(n);
+      for (size_t i = start; i < start + n; i++)
+      {
+        gain += step;
+        l[i] *= gain;
+        r[i] *= gain;
+      }
+      gain = target;
+    }
+
+    env_ = env;
+    gain_ = gain;
+  }
+
+  // Gain applied to the last sample, for metering.
+  float Gain() const { return gain_; }
+
+private:
+  float env_ = 0.0f;
+  float gain_ = 1.0f;
+  float log2_threshold_ = 0.0f;
+  float slope_ = 0.0f;
+  float attack_ = 1.0f;
+  float release_ = 1.0f;
+};
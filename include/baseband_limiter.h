@@ -0,0 +1,160 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Stereo-linked lookahead brickwall limiter for the baseband path.
+//
+// The signal is delayed by the lookahead so the gain is already down
+// when a peak comes out. Peaks are taken between samples as well: the
+// detector looks at each sample and at the 4-point cubic midpoint to
+// the next, which catches most of the overshoot a band-limited signal
+// has between samples (about 2x oversampled true peak).
+//
+// Per sample:
+//   peak   = sliding max of the detector over the lookahead window,
+//            a monotonic deque, O(1) amortised
+//   target = min(1, ceiling / peak)
+//   gain   = moving average of target over the lookahead, so it ramps
+//            down over the whole window and reaches target in time;
+//            kept as an integer running sum so it never drifts
+//   gain   = released upwards through a one-pole, never above target
+// Every output sample is then at most the ceiling; a final clamp
+// covers the inter-sample estimate and rounding.
+class BasebandLimiter
+{
+public:
+  // Ring size: 2 ms at 192 kHz plus the detector delay fits.
+  static constexpr size_t kRingSize = 512;
+  static constexpr size_t kMaxLookahead = kRingSize - 8;
+
+  // lookahead in samples, fixed after Init(): changing it would move
+  // the output in time.
+  void Init(size_t lookahead)
+  {
+    lookahead_ = lookahead < 1 ? 1 : (lookahead > kMaxLookahead ? kMaxLookahead : lookahead);
+    // The detector value at n covers samples n - 2 and n - 1, so the
+    // window is one longer than the average and the audio two later.
+    window_ = lookahead_ + 2;
+    delay_ = lookahead_ + 2;
+    avg_scale_ = 1.0f / (static_cast<float>(lookahead_ + 1) * kGainScale);
+    for (size_t i = 0; i < kRingSize; i++)
+    {
+      delay_l_[i] = 0.0f;
+      delay_r_[i] = 0.0f;
+      gains_[i] = kGainOne;
+    }
+    for (size_t i = 0; i < 3; i++)
+    {
+      hist_l_[i] = 0.0f;
+      hist_r_[i] = 0.0f;
+    }
+    head_ = tail_ = 0;
+    sum_ = kGainOne * static_cast<uint32_t>(lookahead_ + 1);
+    n_ = 0;
+    gain_ = 1.0f;
+  }
+
+  // Already-derived settings (see ModulatorParams::Update):
+  //   ceiling = largest output magnitude
+  //   release = one-pole coefficient per sample
+  void SetCoeffs(float ceiling, float release)
+  {
+    ceiling_ = ceiling;
+    release_ = release;
+  }
+
+  // Limits a stereo block in place; the output lags by Latency().
+  void ProcessBlock(float* l, float* r, size_t size)
+  {
+    const float ceiling = ceiling_;
+    const float release = release_;
+    const uint32_t window = static_cast<uint32_t>(window_);
+    const uint32_t avg_len = static_cast<uint32_t>(lookahead_ + 1);
+    float gain = gain_;
+    uint32_t n = n_;
+    uint32_t sum = sum_;
+
+    for (size_t i = 0; i < size; i++, n++)
+    {
+      const float xl = l[i];
+      const float xr = r[i];
+
+      // Peak over [n - 2, n - 1]: both ends and the midpoint.
+      const float pk = daisysp::fmax(Peak(hist_l_, xl), Peak(hist_r_, xr));
+
+      // Sliding max: drop smaller entries behind, expired ones in front.
+      while (tail_ != head_ && peaks_[(tail_ - 1) & kMask] <= pk)
+        tail_--;
+      peaks_[tail_ & kMask] = pk;
+      times_[tail_ & kMask] = n;
+      tail_++;
+      while (n - times_[head_ & kMask] >= window)
+        head_++;
+      const float peak = peaks_[head_ & kMask];
+
+      const float target = peak > ceiling ? ceiling / peak : 1.0f;
+      const uint32_t q = static_cast<uint32_t>(target * kGainScale);
+      sum += q - gains_[(n - avg_len) & kMask];
+      gains_[n & kMask] = q;
+      const float smooth = static_cast<float>(sum) * avg_scale_;
+      gain = smooth < gain ? smooth : gain + (smooth - gain) * release;
+
+      const uint32_t w = n & kMask;
+      const uint32_t rd = (n - static_cast<uint32_t>(delay_)) & kMask;
+      delay_l_[w] = xl;
+      delay_r_[w] = xr;
+      l[i] = daisysp::fclamp(delay_l_[rd] * gain, -ceiling, ceiling);
+      r[i] = daisysp::fclamp(delay_r_[rd] * gain, -ceiling, ceiling);
+    }
+
+    gain_ = gain;
+    n_ = n;
+    sum_ = sum;
+  }
+
+  // Samples from input to output.
+  size_t Latency() const { return delay_; }
+
+  // Gain applied to the last sample, for metering.
+  float Gain() const { return gain_; }
+
+private:
+  static constexpr uint32_t kMask = kRingSize - 1;
+  // Gains in Q22: kRingSize of them sum to under 2^32.
+  static constexpr float kGainScale = 4194304.0f;
+  static constexpr uint32_t kGainOne = 1u << 22;
+
+  // Detector for one channel: h holds x[n - 3], x[n - 2], x[n - 1].
+  static inline float Peak(float* h, float x)
+  {
+    const float mid = (9.0f * (h[1] + h[2]) - (h[0] + x)) * 0.0625f;
+    const float pk = daisysp::fmax(daisysp::fmax(fabsf(h[1]), fabsf(h[2])), fabsf(mid));
+    h[0] = h[1];
+    h[1] = h[2];
+    h[2] = x;
+    return pk;
+  }
+
+  size_t lookahead_ = 1;
+  size_t window_ = 3;
+  size_t delay_ = 3;
+  float avg_scale_ = 0.0f;
+  float ceiling_ = 1.0f;
+  float release_ = 1.0f;
+  float gain_ = 1.0f;
+  uint32_t n_ = 0;
+  uint32_t sum_ = 0;
+  uint32_t head_ = 0;
+  uint32_t tail_ = 0;
+
+  float hist_l_[3];
+  float hist_r_[3];
+  float peaks_[kRingSize];
+  uint32_t times_[kRingSize];
+  uint32_t gains_[kRingSize];
+  float delay_l_[kRingSize];
+  float delay_r_[kRingSize];
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+
+// Per-element delays and gains for one steering angle, in the units
+// FractionalDelayBank::SetOutput() takes.
+template <size_t elements>
+struct BeamTaps
+{
+  float delay[elements]; // samples
+  float gain[elements];
+};
+
+// Steering of a uniform linear array, one element per output channel,
+// all fed the same modulated signal.
+//
+// Element i sits at i * pitch along the array. Steering to an angle
+// (degrees from broadside, positive toward the last element) delays
+// element i by (center - i) * pitch * sin(angle) / c, on top of a bulk
+// delay that keeps every element's delay positive at +/-90 degrees, so
+// the wavefronts add up in the steered direction. Per-element gains
+// shade the aperture (sidelobes) or trim mismatched transducers; trims
+// add delay for an element's wiring or mounting.
+//
+// Same contract as ModulatorParams: setters record the value, Update()
+// from loop() or the control callback computes the taps (sinf) and
+// publishes them through a ParamBlock, and Process() in the audio
+// callback takes the newest set once per block. The bank then glides
+// every delay and gain to it across the block, so an angle change never
+// steps.
+//
+// With a pitch above half a wavelength (4.3 mm at 39.5 kHz) the array
+// also radiates grating lobes, closer to the main beam the wider the
+// pitch and the farther it is steered; 10 mm transducers cannot get
+// below it.
+template <size_t elements>
+class BeamSteer
+{
+public:
+  static constexpr float kSpeedOfSound = 343.0f; // m/s in air at 20 C
+
+  BeamSteer()
+  {
+    for (float& g : gain_)
+      g = 1.0f;
+  }
+
+  // min_delay: the bank's GetMinDelay().
+  void Init(float sample_rate, float pitch_m, float min_delay)
+  {
+    sample_rate_ = sample_rate;
+    pitch_m_ = pitch_m;
+    min_delay_ = min_delay;
+    dirty_ = true;
+    Update();
+  }
+
+  void SetAngle(float degrees) { Set(angle_deg_, degrees); }
+  void SetGain(size_t element, float gain) { Set(gain_[element], gain); }
+  void SetTrim(size_t element, float seconds) { Set(trim_s_[element], seconds); }
+
+  float Angle() const { return angle_deg_; }
+
+  // Most delay an element can need, trims aside: the bank's max_delay
+  // must be at least this.
+  float SpanSamples() const
+  {
+    return min_delay_ + (float)(elements - 1) * pitch_m_ / kSpeedOfSound * sample_rate_;
+  }
+
+  // Recomputes and publishes the taps if a setter changed a value since
+  // the last call. Returns true when a new set went out.
+  bool Update()
+  {
+    if (!dirty_)
+      return false;
+    dirty_ = false;
+
+    const float center = 0.5f * (float)(elements - 1);
+    const float step = pitch_m_ / kSpeedOfSound * sample_rate_; // samples per element at 90 degrees
+    const float s = sinf(angle_deg_ * 3.14159265358979323846f / 180.0f);
+    BeamTaps<elements>& next = taps_.Back();
+    for (size_t i = 0; i < elements; i++)
+    {
+      next.delay[i] = min_delay_ + step * (center + (center - (float)i) * s) + trim_s_[i] * sample_rate_;
+      next.gain[i] = gain_[i];
+    }
+    taps_.Publish();
+    return true;
+  }
+
+  // Audio callback: fans in[size] out to out[0 .. elements - 1] through
+  // bank, steered to the newest angle. in may be out[0].
+  template <typename Bank>
+  inline void Process(Bank& bank, const float* in, float* const* out, size_t size)
+  {
+    static_assert(Bank::GetOutputs() >= elements, "one bank output per element");
+    const BeamTaps<elements>& taps = taps_.Acquire();
+    for (size_t i = 0; i < elements; i++)
+      bank.SetOutput(i, taps.delay[i], taps.gain[i]);
+    bank.ProcessBlock(in, out, size);
+  }
+
+private:
+  void Set(float& field, float value)
+  {
+    if (field != value)
+    {
+      field = value;
+      // An Update() preempting us must not see the flag before the value.
+      std::atomic_signal_fence(std::memory_order_release);
+      dirty_ = true;
+    }
+  }
+
+  float sample_rate_ = 96000.0f;
+  float pitch_m_ = 0.010f;
+  float min_delay_ = 0.0f;
+  float angle_deg_ = 0.0f;
+  float gain_[elements];
+  float trim_s_[elements] = {};
+  volatile bool dirty_ = true;
+
+  ParamBlock<BeamTaps<elements>> taps_;
+};
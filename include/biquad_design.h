@@ -0,0 +1,160 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <array>
+#include <cmath>
+
+// RBJ audio-EQ-cookbook biquad designs, normalised to a0 == 1.
+// These use libm; call them from setup or control-rate code, for bands
+// that move. IirDesign (DaisySP) has the same three constexpr, for
+// bands fixed at build time, next to its true N-th order Butterworth /
+// Chebyshev / Linkwitz-Riley lowpass and highpass cascades.
+
+inline void ConfigurePeaking(BiquadSection& bq, float fs, float f0, float q, float gain_db)
+{
+  const float A = powf(10.0f, gain_db / 40.0f);
+  const float w0 = 2.0f * 3.14159265358979323846f * (f0 / fs);
+  const float cosw0 = cosf(w0);
+  const float sinw0 = sinf(w0);
+  const float alpha = sinw0 / (2.0f * q);
+
+  const float b0 = 1.0f + alpha * A;
+  const float b1 = -2.0f * cosw0;
+  const float b2 = 1.0f - alpha * A;
+  const float a0 = 1.0f + alpha / A;
+  const float a1 = -2.0f * cosw0;
+  const float a2 = 1.0f - alpha / A;
+
+  bq.b0 = b0 / a0;
+  bq.b1 = b1 / a0;
+  bq.b2 = b2 / a0;
+  bq.a1 = a1 / a0;
+  bq.a2 = a2 / a0;
+}
+
+inline void ConfigureHighShelf(BiquadSection& bq, float fs, float f0, float q, float gain_db)
+{
+  const float A = powf(10.0f, gain_db / 40.0f);
+  const float w0 = 2.0f * 3.14159265358979323846f * (f0 / fs);
+  const float cosw0 = cosf(w0);
+  const float sinw0 = sinf(w0);
+  const float alpha = sinw0 / (2.0f * q);
+  const float sqrtA = sqrtf(A);
+
+  const float b0 =    A * ((A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha);
+  const float b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0);
+  const float b2 =    A * ((A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha);
+  const float a0 =         (A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha;
+  const float a1 =  2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0);
+  const float a2 =         (A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha;
+
+  bq.b0 = b0 / a0;
+  bq.b1 = b1 / a0;
+  bq.b2 = b2 / a0;
+  bq.a1 = a1 / a0;
+  bq.a2 = a2 / a0;
+}
+
+inline void ConfigureLowShelf(BiquadSection& bq, float fs, float f0, float q, float gain_db)
+{
+  const float A = powf(10.0f, gain_db / 40.0f);
+  const float w0 = 2.0f * 3.14159265358979323846f * (f0 / fs);
+  const float cosw0 = cosf(w0);
+  const float sinw0 = sinf(w0);
+  const float alpha = sinw0 / (2.0f * q);
+  const float sqrtA = sqrtf(A);
+
+  const float b0 =    A * ((A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha);
+  const float b1 =  2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw0);
+  const float b2 =    A * ((A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha);
+  const float a0 =         (A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha;
+  const float a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw0);
+  const float a2 =         (A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha;
+
+  bq.b0 = b0 / a0;
+  bq.b1 = b1 / a0;
+  bq.b2 = b2 / a0;
+  bq.a1 = a1 / a0;
+  bq.a2 = a2 / a0;
+}
+
+enum class BiquadShape : uint8_t
+{
+  kPeaking,
+  kHighShelf,
+  kLowShelf,
+};
+
+// The last N cookbook designs, for EQ presets switched or swept at
+// control rate: a design asked for again is a scan of N keys instead of
+// powf, cosf, sinf and five divides. Keys compare exactly, so a preset
+// recalled with the same settings always hits. Call from one context.
+template <size_t N>
+class BiquadDesignCache
+{
+public:
+  void Init() { cache_.Init(); }
+
+  const BiquadSection& Get(BiquadShape shape, float fs, float f0, float q, float gain_db)
+  {
+    return cache_.Get(Key{shape, fs, f0, q, gain_db}, [](const Key& k) {
+      BiquadSection bq;
+      switch (k.shape)
+      {
+        case BiquadShape::kHighShelf: ConfigureHighShelf(bq, k.fs, k.f0, k.q, k.gain_db); break;
+        case BiquadShape::kLowShelf: ConfigureLowShelf(bq, k.fs, k.f0, k.q, k.gain_db); break;
+        default: ConfigurePeaking(bq, k.fs, k.f0, k.q, k.gain_db); break;
+      }
+      return bq;
+    });
+  }
+
+  uint32_t Hits() const { return cache_.GetHits(); }
+  uint32_t Misses() const { return cache_.GetMisses(); }
+
+private:
+  struct Key
+  {
+    BiquadShape shape;
+    float fs, f0, q, gain_db;
+    bool operator==(const Key& o) const
+    {
+      return shape == o.shape && fs == o.fs && f0 == o.f0 && q == o.q && gain_db == o.gain_db;
+    }
+  };
+
+  daisysp::CoeffCache<Key, BiquadSection, N> cache_;
+};
+
+// A fixed filter's sections, designed by the compiler at every rate it
+// can run at. Stage::Sections(fs) is constexpr (IirDesign); Rates::kRates
+// lists the rates. Get(fs) at one of them returns literals from flash,
+// so Init() runs no design math at all. Any other rate runs the same
+// constexpr design at Init(), which is slower than libm but still a
+// setup-time cost only.
+template <class Stage, class Rates>
+struct PrebuiltDesign
+{
+  using Sections = decltype(Stage::Sections(1.0f));
+  static constexpr size_t kNumRates = sizeof(Rates::kRates) / sizeof(Rates::kRates[0]);
+
+  static constexpr std::array<Sections, kNumRates> Build()
+  {
+    std::array<Sections, kNumRates> out{};
+    for (size_t i = 0; i < kNumRates; i++)
+      out[i] = Stage::Sections(Rates::kRates[i]);
+    return out;
+  }
+
+  static constexpr std::array<Sections, kNumRates> kSections = Build();
+
+  static Sections Get(float fs)
+  {
+    for (size_t i = 0; i < kNumRates; i++)
+    {
+      if (fs == Rates::kRates[i])
+        return kSections[i];
+    }
+    return Stage::Sections(fs);
+  }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include "modulator_pipeline.h"
+#include <cstddef>
+#include <cstdint>
+
+// A set of independent carriers, one quadrature Nco each, for stages
+// that modulate several basebands at once (MultiZoneMod).
+//
+// Each carrier keeps its own 32-bit phase, so carriers on different
+// frequencies never drift against each other or against the frame
+// count, and no carrier calls libm: the Ncos read the shared table (or
+// rotate, with Backend::ROTATION). Cost is one Nco block plus a
+// multiply-add per carrier and sample, linear in the carrier count.
+template <size_t carriers, Nco::Backend backend = Nco::Backend::LUT>
+class CarrierBank
+{
+public:
+  static constexpr size_t kCarriers = carriers;
+
+  void Init(float fs)
+  {
+    for (Nco& nco : nco_)
+      nco.Init(fs, backend);
+  }
+
+  // Once per block, before Modulate(): carrier c's frequency.
+  inline void SetPhaseInc(size_t c, uint32_t inc)
+  {
+    if (inc != nco_[c].GetPhaseInc())
+      nco_[c].SetPhaseInc(inc);
+  }
+
+  // Every carrier to the phase of a common frame count, as AmMod does
+  // for the array sync.
+  inline void Sync(uint32_t frame)
+  {
+    for (Nco& nco : nco_)
+      nco.SetPhase(nco.GetPhaseInc() * frame);
+  }
+
+  // out = (level + depth * x) * sin(w_c t), advancing carrier c by
+  // size samples. out may be x.
+  inline void Modulate(size_t c, const float* x, float level, float depth, float* out, size_t size)
+  {
+    nco_[c].ProcessBlock(sin_, nullptr, size);
+    for (size_t i = 0; i < size; i++)
+      out[i] = (level + depth * x[i]) * sin_[i];
+  }
+
+  // Carrier c's sin and cos for the next size samples, for quadrature
+  // (SSB) modulators.
+  inline void Quadrature(size_t c, float* s, float* co, size_t size) { nco_[c].ProcessBlock(s, co, size); }
+
+private:
+  Nco nco_[carriers];
+  float sin_[kPipelineMaxBlock];
+};
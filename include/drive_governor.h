@@ -0,0 +1,198 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Thermal protection for the transducers: holds each output's RMS drive,
+// over a window of seconds, to a limit, so a sustained overdrive cannot
+// cook them while short peaks still pass at full level.
+//
+// The audio callback's share is one multiply-add per sample and
+// channel, for x^2, plus the channel's gain, ramped across the block.
+// The window is kSlices slices: each finished slice's energy goes into
+// a ring, and a running sum over the ring (re-added in full once per
+// lap, so float error cannot pile up) is the window's energy.
+//
+// Govern() from the control callback turns that into gains. A channel
+// whose window RMS is over limit_rms is turned down toward
+// limit_rms / rms, never below floor_gain, with attack_s, and back up
+// with release_s once it is under. The RMS is measured ahead of the
+// gain, of the drive asked for, so the gain takes the window to the
+// limit in one step instead of chasing its own output.
+//
+// Full scale is 1.0: the default carrier (0.5) alone is 0.354 RMS, and
+// full modulation on top about 0.43.
+template <size_t channels, size_t slices = 32>
+class DriveGovernor
+{
+public:
+  struct Config
+  {
+    float window_s = 2.0f;
+    float limit_rms = 0.45f;
+    float attack_s = 0.2f;
+    float release_s = 2.0f;
+    float floor_gain = 0.25f;
+  };
+
+  static constexpr size_t kSlices = slices;
+
+  void Init(float sample_rate) { Init(sample_rate, Config()); }
+
+  void Init(float sample_rate, const Config& config)
+  {
+    sample_rate_ = sample_rate;
+    config_ = config;
+    const float len = sample_rate * config.window_s / (float)slices;
+    slice_len_ = len > 1.0f ? (uint32_t)len : 1;
+    slice_fill_ = 0;
+    next_ = 0;
+    window_n_ = 0;
+    for (uint32_t& n : ring_n_)
+      n = 0;
+    for (size_t ch = 0; ch < channels; ch++)
+    {
+      acc_[ch] = 0.0f;
+      sum_[ch] = 0.0f;
+      window_[ch] = 0.0f;
+      gain_[ch] = target_[ch] = smooth_[ch] = 1.0f;
+      for (float& e : ring_[ch])
+        e = 0.0f;
+    }
+  }
+
+  // Audio callback, last: measures out[0 .. n - 1] and applies their
+  // gains, in place.
+  inline void Process(float* const* out, size_t n, size_t size)
+  {
+    n = n < channels ? n : channels;
+    if (size == 0)
+      return;
+    const float step = 1.0f / (float)size;
+    for (size_t ch = 0; ch < n; ch++)
+    {
+      float* x = out[ch];
+      const float g0 = gain_[ch];
+      const float g1 = target_[ch];
+      float e = 0.0f;
+      if (g0 == 1.0f && g1 == 1.0f)
+      {
+        for (size_t i = 0; i < size; i++)
+          e += x[i] * x[i];
+      }
+      else
+      {
+        const float dg = (g1 - g0) * step;
+        for (size_t i = 0; i < size; i++)
+        {
+          const float s = x[i];
+          e += s * s;
+          x[i] = s * (g0 + dg * (float)(i + 1));
+        }
+      }
+      gain_[ch] = g1;
+      acc_[ch] += e;
+    }
+    slice_fill_ += (uint32_t)size;
+    if (slice_fill_ >= slice_len_)
+      Push(n);
+  }
+
+  // Control callback: frames since the last call, as ControlCallback
+  // gets them.
+  void Govern(size_t frames)
+  {
+    const uint32_t n = window_n_;
+    if (n == 0)
+      return;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    const float dt = (float)frames / sample_rate_;
+    const float attack = 1.0f - expf(-dt / config_.attack_s);
+    const float release = 1.0f - expf(-dt / config_.release_s);
+    const float inv_n = 1.0f / (float)n;
+    for (size_t ch = 0; ch < channels; ch++)
+    {
+      const float rms = sqrtf(window_[ch] * inv_n);
+      float want = 1.0f;
+      if (rms > config_.limit_rms)
+        want = daisysp::fmax(config_.limit_rms / rms, config_.floor_gain);
+      float g = smooth_[ch];
+      g += (want - g) * (want < g ? attack : release);
+      smooth_[ch] = g;
+      target_[ch] = g;
+    }
+  }
+
+  // Window RMS ahead of the gain, and the gain now; for metering.
+  float Rms(size_t ch) const
+  {
+    const uint32_t n = window_n_;
+    return n > 0 ? sqrtf(window_[ch] / (float)n) : 0.0f;
+  }
+  float Gain(size_t ch) const { return smooth_[ch]; }
+
+  // Whether any channel is turned down.
+  bool Limiting() const
+  {
+    for (size_t ch = 0; ch < channels; ch++)
+      if (smooth_[ch] < 1.0f)
+        return true;
+    return false;
+  }
+
+private:
+  void Push(size_t n)
+  {
+    const size_t slot = next_;
+    next_ = (slot + 1) % slices;
+    uint32_t total = window_n_ + slice_fill_ - ring_n_[slot];
+    ring_n_[slot] = slice_fill_;
+    slice_fill_ = 0;
+    if (next_ == 0)
+    {
+      total = 0;
+      for (uint32_t c : ring_n_)
+        total += c;
+    }
+    for (size_t ch = 0; ch < n; ch++)
+    {
+      float sum = sum_[ch] + acc_[ch] - ring_[ch][slot];
+      ring_[ch][slot] = acc_[ch];
+      acc_[ch] = 0.0f;
+      if (next_ == 0)
+      {
+        sum = 0.0f;
+        for (float e : ring_[ch])
+          sum += e;
+      }
+      sum_[ch] = sum;
+      window_[ch] = sum;
+    }
+    // Govern() must not see the count before the sums it covers.
+    std::atomic_signal_fence(std::memory_order_release);
+    window_n_ = total;
+  }
+
+  float sample_rate_ = 96000.0f;
+  Config config_;
+  uint32_t slice_len_ = 1;
+
+  // Audio callback only.
+  uint32_t slice_fill_ = 0;
+  size_t next_ = 0;
+  float acc_[channels];
+  float sum_[channels];
+  float gain_[channels];
+  float ring_[channels][slices];
+  uint32_t ring_n_[slices];
+
+  // Audio callback writes, Govern() reads.
+  volatile float window_[channels];
+  volatile uint32_t window_n_ = 0;
+  // Govern() writes, the audio callback reads.
+  volatile float target_[channels];
+  float smooth_[channels];
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <DaisyDuino.h>
+
+// Tightly coupled memory placement for the audio hot path.
+//
+//   DSP_DTCM  data in DTCM (0x20000000, 128 KB). Zero wait states,
+//             not behind the D-cache, so access time does not depend on
+//             what the rest of the firmware touched last.
+//   DSP_ITCM  code in ITCM (0x00000000, 64 KB). Zero wait states, no
+//             flash/I-cache fetch jitter inside the ISR.
+//
+// The sections come from ld/dsp_sections.ld, which scripts/dsp_placement.py
+// adds to the link on top of the board's own linker script. The same
+// script prints a placement report after every link and fails the build
+// if either section did not land in its TCM.
+//
+// Rules for DSP_DTCM objects:
+// - The section is zero-filled at startup but has no load image, so
+//   static initializers are not preserved. Only place objects that are
+//   fully set up by their Init() (pipelines, filters, scratch buffers).
+// - Not reachable by DMA. Audio DMA buffers stay in DMA_BUFFER_MEM_SECTION.
+//
+// DSP_ITCM functions are copied from flash at startup. Calls to and from
+// flash go through linker veneers, so mark the callback itself and let
+// its inlined callees come along rather than tagging small helpers.
+//
+// DaisyDuino tags its own audio interrupt path (DMA and SAI handlers,
+// conversion loops) with DSY_ITCM_FUNC; ld/dsp_sections.ld gathers it
+// into the same output section, so every env that links the supplement
+// must also build src/dsp_placement.cpp.
+//
+// The zero-fill and copy run from src/dsp_placement.cpp before any C++
+// constructor. Both macros expand to nothing off-target (host builds).
+#if defined(__arm__)
+#define DSP_DTCM __attribute__((section(".dsp_dtcm_bss")))
+#define DSP_ITCM __attribute__((section(".dsp_itcm_text"), noinline))
+#else
+#define DSP_DTCM
+#define DSP_ITCM
+#endif
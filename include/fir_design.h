@@ -0,0 +1,28 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <cmath>
+#include <cstddef>
+
+// Kaiser-windowed sinc designs for the linear-phase FIR stages, on
+// DaisySP's ConstTable::Kaiser() window. Double precision; call them
+// from setup code.
+
+// Adds gain times a lowpass with its -6 dB point at cutoff (cycles per
+// sample, up to 0.5) into h[taps]. beta sets the window: 8 gives about
+// 80 dB of stopband, and a transition of about 5.1 / taps either side of
+// the cutoff. Symmetric, so tail-first and head-first are the same.
+// Unnormalised: the DC gain is gain to within the window's ripple.
+inline void AddKaiserLowpass(double* h, size_t taps, double cutoff, double beta, double gain)
+{
+  const double pi = 3.14159265358979323846;
+  const double center = 0.5 * (double)(taps - 1);
+  const double wc = 2.0 * pi * cutoff;
+  for (size_t k = 0; k < taps; k++)
+  {
+    const double t = (double)k - center;
+    const double x = center > 0.0 ? 0.5 * (double)k / center : 0.5;
+    const double sinc = t == 0.0 ? wc / pi : sin(wc * t) / (pi * t);
+    h[k] += gain * sinc * daisysp::ConstTable::Kaiser(x, beta);
+  }
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include "modulator_pipeline.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Skips the pipeline's work while the input is silent, so the CPU load
+// (and, with MODULATOR_LOW_POWER, the supply current) follows the
+// program material.
+//
+// Detect() takes each block's input peak. Once it has stayed under the
+// threshold for hold_s, the gate waits for the baseband stages to ring
+// out: the Gated<> wrapper around them closes it on the first block
+// whose baseband output is under the threshold too, so no tail is cut
+// off. Then, by mode:
+//   - kCarrier: the baseband stages are skipped and their output is
+//     silence. The modulator and band limit still run, so the carrier
+//     goes on with its phase and filter state as they were, and the
+//     output is what the full path would give for silent input.
+//   - kMute: the carrier fades out over fade_s; then the whole pipeline
+//     is skipped and the outputs are silent. The stages keep their
+//     state meanwhile, the NCO and band-pass in step with each other,
+//     and the carrier fades back in from there.
+// A block over the threshold opens the gate at once; in kMute the
+// signal rises with the fade-in, which cuts fade_s off its start.
+//
+// The skipped stages' state is left as it was when the gate closed,
+// which by then is their decayed response to silence under the
+// threshold: running them on would only have taken it closer to zero.
+// Float pipeline only.
+class InputGate
+{
+public:
+  enum class Mode : uint8_t
+  {
+    kCarrier, // carrier only while silent
+    kMute,    // no output while silent
+  };
+
+  struct Config
+  {
+    float threshold = 0.0001f; // block peak, full scale 1 (-80 dBFS)
+    float hold_s = 0.25f;
+    float fade_s = 0.005f; // kMute only
+    Mode mode = Mode::kCarrier;
+  };
+
+  void Init(float sample_rate) { Init(sample_rate, Config()); }
+
+  void Init(float sample_rate, const Config& config)
+  {
+    config_ = config;
+    hold_frames_ = (uint32_t)(config.hold_s * sample_rate);
+    const float fade = config.fade_s * sample_rate;
+    fade_step_ = fade > 1.0f ? 1.0f / fade : 1.0f;
+    silent_frames_ = 0;
+    gain_ = 1.0f;
+    state_ = kOpen;
+    gated_blocks_ = 0;
+  }
+
+  // Audio callback, first: the block's input, before any stage.
+  inline void Detect(const float* l, const float* r, size_t size)
+  {
+    if (Peak(l, r, size) >= config_.threshold)
+    {
+      silent_frames_ = 0;
+      if (state_ == kClosing || state_ == kBypass)
+        state_ = kOpen;
+      else if (state_ == kMuted || state_ == kFadeOut)
+        state_ = kFadeIn;
+      return;
+    }
+    if (silent_frames_ < hold_frames_)
+      silent_frames_ += (uint32_t)size;
+    if (state_ == kOpen && silent_frames_ >= hold_frames_)
+      state_ = kClosing;
+  }
+
+  // From Gated<>: whether the baseband stages run this block.
+  inline bool RunBaseband() const { return state_ != kBypass; }
+
+  // From Gated<>: the baseband stages' output, while the gate waits for
+  // it to ring out.
+  inline void Settle(const float* l, const float* r, size_t size)
+  {
+    if (state_ != kClosing || Peak(l, r, size) >= config_.threshold)
+      return;
+    state_ = config_.mode == Mode::kCarrier ? kBypass : kFadeOut;
+  }
+
+  // Whether the audio callback skips the pipeline this block.
+  inline bool Muted() const { return state_ == kMuted; }
+
+  // Audio callback, after the pipeline: fades the outputs, or fills
+  // them with silence while muted.
+  inline void Apply(float** out, size_t channels, size_t size)
+  {
+    if (state_ == kBypass)
+      gated_blocks_++;
+    if (state_ == kMuted)
+    {
+      gated_blocks_++;
+      for (size_t ch = 0; ch < channels; ch++)
+        memset(out[ch], 0, size * sizeof(float));
+      return;
+    }
+    if (state_ != kFadeOut && state_ != kFadeIn)
+      return;
+    const float step = state_ == kFadeIn ? fade_step_ : -fade_step_;
+    float g = gain_;
+    for (size_t i = 0; i < size; i++)
+    {
+      g = daisysp::fclamp(g + step, 0.0f, 1.0f);
+      for (size_t ch = 0; ch < channels; ch++)
+        out[ch][i] *= g;
+    }
+    gain_ = g;
+    if (g <= 0.0f)
+      state_ = kMuted;
+    else if (g >= 1.0f)
+      state_ = kOpen;
+  }
+
+  // Whether the gate is anywhere but open, e.g. for a meter.
+  bool Closed() const { return state_ != kOpen; }
+
+  // Blocks that took the carrier-only or muted path since Init().
+  uint32_t GatedBlocks() const { return gated_blocks_; }
+
+private:
+  enum State : uint8_t
+  {
+    kOpen,
+    kClosing, // input silent for hold_s, baseband still ringing
+    kBypass,  // kCarrier: baseband skipped
+    kFadeOut, // kMute: full pipeline, carrier fading
+    kMuted,   // kMute: pipeline skipped
+    kFadeIn,  // kMute: full pipeline, carrier coming back
+  };
+
+  static inline float Peak(const float* l, const float* r, size_t size)
+  {
+    float peak = 0.0f;
+    for (size_t i = 0; i < size; i++)
+      peak = daisysp::fmax(peak, daisysp::fmax(fabsf(l[i]), fabsf(r[i])));
+    return peak;
+  }
+
+  Config config_;
+  uint32_t hold_frames_ = 0;
+  uint32_t silent_frames_ = 0;
+  float fade_step_ = 1.0f;
+  float gain_ = 1.0f;
+  volatile State state_ = kOpen;
+  uint32_t gated_blocks_ = 0;
+};
+
+// Baseband stage (a Pipeline or DecimatedBaseband of them) that gate
+// skips while the input is silent:
+//   Pipeline<Gated<gate, Baseband<...>>, Modulation, ...>
+template <InputGate& gate, class Stage>
+struct Gated : Stage
+{
+  inline void Process(StereoBlock& b)
+  {
+    if (!gate.RunBaseband())
+    {
+      memset(b.l, 0, b.size * sizeof(float));
+      memset(b.r, 0, b.size * sizeof(float));
+      return;
+    }
+    Stage::Process(b);
+    gate.Settle(b.l, b.r, b.size);
+  }
+};
+
+// Gated<gate, Stage> when enabled, plain Stage otherwise.
+template <bool enabled, InputGate& gate, class Stage>
+using GatedIf = typename std::conditional<enabled, Gated<gate, Stage>, Stage>::type;
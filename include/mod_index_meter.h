@@ -0,0 +1,169 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "modulator_pipeline.h"
+
+// Modulation index meter, for setting the gain staging without a scope.
+//
+// The index of a baseband sample x is depth * x / carrier_level, from
+// the block's own coefficients; past 1 the AM envelope would cross
+// zero. A ModIndexTap just ahead of the modulator hands every block to
+// Tap(), which keeps a running max of |x| over both channels and a sum
+// of x^2 per channel, a few operations per sample, and counts the block
+// as over-modulated if its peak index is over 1. Every kWindowMs the
+// window goes out through a Seqlock.
+//
+// Poll() from the control callback takes each window as it comes, and
+// keeps the report: the last window's peak index and RMS index (of the
+// hotter channel), the peak held since the last ResetHold(), and
+// over-modulated blocks in the window and in total. loop() reads it with GetReport() or Print().
+//
+// With the adaptive carrier the block's carrier_level is the most the
+// carrier rises to, so the figure is the index against full carrier.
+// For SSB and SRAM it is the same measure of baseband drive.
+class ModIndexMeter
+{
+public:
+  static constexpr uint32_t kWindowMs = 100;
+
+  struct Report
+  {
+    float peak;          // last window
+    float rms;           // last window
+    float peak_hold;     // since ResetHold()
+    uint32_t over;       // over-modulated blocks, last window
+    uint32_t over_total; // since Init()
+    uint32_t windows;    // since Init()
+  };
+
+  void Init(float sample_rate)
+  {
+    window_frames_ = (uint32_t)(sample_rate * (float)kWindowMs / 1000.0f);
+    acc_ = Window();
+    seen_ = window_.GetSequence();
+    report_state_ = Report();
+    report_.Write(report_state_);
+    reset_hold_ = false;
+  }
+
+  // Audio callback: the baseband block, before modulation.
+  inline void Tap(const StereoBlock& b)
+  {
+    const float* l = b.l;
+    const float* r = b.r;
+    float peak = 0.0f;
+    float sum_l = 0.0f;
+    float sum_r = 0.0f;
+    for (size_t i = 0; i < b.size; i++)
+    {
+      peak = daisysp::fmax(peak, daisysp::fmax(fabsf(l[i]), fabsf(r[i])));
+      sum_l += l[i] * l[i];
+      sum_r += r[i] * r[i];
+    }
+    const ModulatorCoeffs& p = b.p;
+    const float scale = p.carrier_level > 0.0f ? p.depth / p.carrier_level : 0.0f;
+    const float index = peak * scale;
+    acc_.peak = daisysp::fmax(acc_.peak, index);
+    acc_.sum_l += sum_l * scale * scale;
+    acc_.sum_r += sum_r * scale * scale;
+    acc_.frames += (uint32_t)b.size;
+    if (index > 1.0f)
+      acc_.over++;
+    if (acc_.frames >= window_frames_)
+    {
+      window_.Write(acc_);
+      acc_ = Window();
+    }
+  }
+
+  // Control callback: folds in each finished window.
+  void Poll()
+  {
+    const uint32_t seq = window_.GetSequence();
+    if (seq == seen_)
+      return;
+    seen_ = seq;
+    Window w;
+    window_.Read(w);
+    Report& r = report_state_;
+    if (reset_hold_)
+    {
+      reset_hold_ = false;
+      r.peak_hold = 0.0f;
+    }
+    r.peak = w.peak;
+    r.rms = w.frames > 0 ? sqrtf(daisysp::fmax(w.sum_l, w.sum_r) / (float)w.frames) : 0.0f;
+    r.peak_hold = daisysp::fmax(r.peak_hold, w.peak);
+    r.over = w.over;
+    r.over_total += w.over;
+    r.windows++;
+    report_.Write(r);
+  }
+
+  // From loop().
+  Report GetReport() const
+  {
+    Report r;
+    report_.Read(r);
+    return r;
+  }
+
+  // From loop(): the held peak restarts with the next window.
+  void ResetHold() { reset_hold_ = true; }
+
+  // From loop(): one line. Integers only: newlib-nano has no %f.
+  void Print(::Print& out) const
+  {
+    const Report r = GetReport();
+    char peak[12], rms[12], hold[12];
+    Hundredths(peak, sizeof(peak), r.peak);
+    Hundredths(rms, sizeof(rms), r.rms);
+    Hundredths(hold, sizeof(hold), r.peak_hold);
+    char line[96];
+    snprintf(line, sizeof(line), "mod index: peak %s, rms %s, hold %s, over %lu (%lu total)\r\n", peak, rms,
+             hold, (unsigned long)r.over, (unsigned long)r.over_total);
+    out.print(line);
+  }
+
+private:
+  struct Window
+  {
+    float peak = 0.0f;
+    float sum_l = 0.0f;
+    float sum_r = 0.0f;
+    uint32_t frames = 0;
+    uint32_t over = 0;
+  };
+
+  static void Hundredths(char* buf, size_t size, float v)
+  {
+    v = v > 9999.0f ? 9999.0f : v;
+    const unsigned long t = (unsigned long)lroundf(v * 100.0f);
+    snprintf(buf, size, "%lu.%02lu", t / 100, t % 100);
+  }
+
+  // Audio callback only.
+  uint32_t window_frames_ = 9600;
+  Window acc_;
+  daisy::Seqlock<Window> window_;
+
+  // Control callback only, but for the flag from loop().
+  uint32_t seen_ = 0;
+  Report report_state_ = {};
+  volatile bool reset_hold_ = false;
+  daisy::Seqlock<Report> report_;
+};
+
+// Pipeline stage that meters its block with meter, unchanged.
+//   Pipeline<..., LowShelf, ModIndexTap<mod_meter>, Modulation, ...>
+template <ModIndexMeter& meter>
+struct ModIndexTap
+{
+  void Init(float sample_rate) { meter.Init(sample_rate); }
+
+  inline void Process(StereoBlock& b) { meter.Tap(b); }
+};
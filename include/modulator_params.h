@@ -0,0 +1,207 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+// Carriers MultiZoneMod can run, one per zone.
+static constexpr size_t kMaxZones = 4;
+
+// What SwitchableMod runs; the fixed-mode builds ignore it.
+enum class ModulationMode : uint8_t
+{
+  kAm,         // double sideband with carrier
+  kDsbSc,      // double sideband, suppressed carrier
+  kSsbUpper,   // upper sideband with carrier
+  kSsbLower,   // lower sideband with carrier
+  kSram,       // square-root AM
+  kAdaptiveAm, // AM with the adaptive carrier level
+};
+static constexpr size_t kModulationModes = 6;
+
+// Everything the audio callback needs from the modulator settings,
+// already reduced to the numbers the hot loop multiplies by.
+struct ModulatorCoeffs
+{
+  uint32_t carrier_phase_inc = 0; // Nco::SetPhaseInc() units
+  float carrier_level = 0.5f;
+  float carrier_floor = 0.05f;    // lowest adaptive carrier level
+  float carrier_release = 0.0f;   // adaptive level fall, per sample
+  float depth = 1.0f;             // mod depth * baseband gain
+  float comp_log2_threshold = 0.0f;
+  float comp_slope = 0.0f;        // 1 / ratio - 1
+  float comp_attack = 0.0f;       // one-pole coefficients per sample
+  float comp_release = 0.0f;
+  float limit_ceiling = 1.0f;     // baseband peak for the set modulation index
+  float limit_release = 0.0f;     // one-pole coefficient per sample
+  // MultiZoneMod: each zone's carrier, its share of the output, which
+  // input it carries (0 left, 1 right) and which outputs it adds to
+  // (bit 0 left, bit 1 right).
+  uint32_t zone_phase_inc[kMaxZones] = {};
+  float zone_gain[kMaxZones] = {};
+  uint8_t zone_source[kMaxZones] = {};
+  uint8_t zone_outputs[kMaxZones] = {};
+  ModulationMode modulation = ModulationMode::kAm;
+};
+
+// User-facing modulator settings plus their derived coefficients.
+//
+// Setters only record the new value. Update() does the libm work
+// (expf, log2f, phase increment) for whatever changed and publishes a fresh
+// ModulatorCoeffs. Call it from loop() or the control-rate callback,
+// never from the audio callback. Setters may run from loop() while
+// Update() runs in the control-rate interrupt.
+//
+// Publishing goes through a ParamBlock triple buffer: Update() fills
+// the writer's copy and swaps it in, and the audio callback takes the
+// newest through Snapshot() at the start of each block and holds it
+// for the block. Neither side can see the other's copy. ParamBlock has
+// a single writer, so Update() may run from loop() or from the control
+// callback, but only one of them: the control callback preempts loop().
+class ModulatorParams
+{
+public:
+  void Init(float sample_rate)
+  {
+    sample_rate_ = sample_rate;
+    dirty_ = true;
+    Update();
+  }
+
+  void SetCarrierFreq(float hz) { Set(carrier_hz_, hz); }
+  void SetCarrierLevel(float level) { Set(carrier_level_, level); }
+  // Adaptive carrier (AmMod<..., true>): carrier_level is then the most
+  // it rises to, floor the least, release how fast it falls back.
+  void SetCarrierFloor(float level) { Set(carrier_floor_, level); }
+  void SetCarrierRelease(float seconds) { Set(carrier_release_s_, seconds); }
+  void SetModDepth(float depth) { Set(mod_depth_, depth); }
+  void SetBasebandGain(float gain) { Set(baseband_gain_, gain); }
+  void SetCompThreshold(float threshold) { Set(comp_threshold_, threshold); }
+  void SetCompRatio(float ratio) { Set(comp_ratio_, ratio); }
+  void SetCompAttack(float seconds) { Set(comp_attack_s_, seconds); }
+  void SetCompRelease(float seconds) { Set(comp_release_s_, seconds); }
+  // Peak modulation index the limiter holds the output to; 1 keeps the
+  // AM envelope just above zero.
+  void SetLimitIndex(float index) { Set(limit_index_, index); }
+  void SetLimitRelease(float seconds) { Set(limit_release_s_, seconds); }
+  // Multi-zone AM (MultiZoneMod): zone z's carrier, its gain on the
+  // outputs it goes to, and its routing. Zones added on one output
+  // share its headroom, so their gains should sum to 1 at most.
+  void SetZoneCarrierFreq(size_t zone, float hz) { Set(zone_hz_[zone], hz); }
+  void SetZoneGain(size_t zone, float gain) { Set(zone_gain_[zone], gain); }
+  void SetZoneRoute(size_t zone, uint8_t source, uint8_t outputs)
+  {
+    source &= 1;
+    outputs &= 3;
+    if (zone_source_[zone] != source || zone_outputs_[zone] != outputs)
+    {
+      zone_source_[zone] = source;
+      zone_outputs_[zone] = outputs;
+      std::atomic_signal_fence(std::memory_order_release);
+      dirty_ = true;
+    }
+  }
+
+  // SwitchableMod's mode; it crossfades to a new one.
+  void SetModulation(ModulationMode mode)
+  {
+    if (modulation_ != mode)
+    {
+      modulation_ = mode;
+      std::atomic_signal_fence(std::memory_order_release);
+      dirty_ = true;
+    }
+  }
+
+  ModulationMode Modulation() const { return modulation_; }
+  float CarrierFreq() const { return carrier_hz_; }
+  float ZoneCarrierFreq(size_t zone) const { return zone_hz_[zone]; }
+  float ZoneGain(size_t zone) const { return zone_gain_[zone]; }
+  float CarrierLevel() const { return carrier_level_; }
+  float CarrierFloor() const { return carrier_floor_; }
+  float CarrierRelease() const { return carrier_release_s_; }
+  float ModDepth() const { return mod_depth_; }
+  float BasebandGain() const { return baseband_gain_; }
+  float CompThreshold() const { return comp_threshold_; }
+  float CompRatio() const { return comp_ratio_; }
+  float CompAttack() const { return comp_attack_s_; }
+  float CompRelease() const { return comp_release_s_; }
+  float LimitIndex() const { return limit_index_; }
+  float LimitRelease() const { return limit_release_s_; }
+  float SampleRate() const { return sample_rate_; }
+
+  // Recomputes and publishes the coefficients if any setter changed a
+  // value since the last call. Returns true when a new snapshot went out.
+  bool Update()
+  {
+    if (!dirty_)
+      return false;
+    dirty_ = false;
+
+    // Every field: the back buffer holds an older set.
+    ModulatorCoeffs& next = coeffs_.Back();
+    next.carrier_phase_inc = Nco::FreqToPhaseInc(carrier_hz_, sample_rate_);
+    next.carrier_level = carrier_level_;
+    next.carrier_floor = carrier_floor_ < carrier_level_ ? carrier_floor_ : carrier_level_;
+    next.carrier_release = 1.0f - expf(-1.0f / (carrier_release_s_ * sample_rate_));
+    next.depth = mod_depth_ * baseband_gain_;
+    next.comp_log2_threshold = log2f(comp_threshold_);
+    next.comp_slope = (1.0f / comp_ratio_) - 1.0f;
+    next.comp_attack = 1.0f - expf(-1.0f / (comp_attack_s_ * sample_rate_));
+    next.comp_release = 1.0f - expf(-1.0f / (comp_release_s_ * sample_rate_));
+    // carrier_level + depth * x >= 0 while |x| <= carrier_level / depth.
+    next.limit_ceiling = next.depth > 0.0f ? limit_index_ * carrier_level_ / next.depth : 1.0f;
+    next.limit_release = 1.0f - expf(-1.0f / (limit_release_s_ * sample_rate_));
+    for (size_t z = 0; z < kMaxZones; z++)
+    {
+      next.zone_phase_inc[z] = Nco::FreqToPhaseInc(zone_hz_[z], sample_rate_);
+      next.zone_gain[z] = zone_gain_[z];
+      next.zone_source[z] = zone_source_[z];
+      next.zone_outputs[z] = zone_outputs_[z];
+    }
+    next.modulation = modulation_;
+
+    coeffs_.Publish();
+    return true;
+  }
+
+  // The newest coefficient set; the audio callback's, once per block.
+  const ModulatorCoeffs& Snapshot() { return coeffs_.Acquire(); }
+
+private:
+  void Set(float& field, float value)
+  {
+    if (field != value)
+    {
+      field = value;
+      // An Update() preempting us must not see the flag before the value.
+      std::atomic_signal_fence(std::memory_order_release);
+      dirty_ = true;
+    }
+  }
+
+  float sample_rate_ = 96000.0f;
+  float carrier_hz_ = 39500.0f;
+  float carrier_level_ = 0.5f;
+  float carrier_floor_ = 0.05f;
+  float carrier_release_s_ = 0.200f;
+  float mod_depth_ = 1.0f;
+  float baseband_gain_ = 1.0f;
+  float comp_threshold_ = 0.6f;
+  float comp_ratio_ = 3.0f;
+  float comp_attack_s_ = 0.005f;
+  float comp_release_s_ = 0.050f;
+  float limit_index_ = 0.95f;
+  float limit_release_s_ = 0.050f;
+  // Default zones: left input on the left output, right on the right,
+  // a kilohertz apart; the other two silent.
+  float zone_hz_[kMaxZones] = {39500.0f, 40500.0f, 39000.0f, 41000.0f};
+  float zone_gain_[kMaxZones] = {1.0f, 1.0f, 0.0f, 0.0f};
+  uint8_t zone_source_[kMaxZones] = {0, 1, 0, 1};
+  uint8_t zone_outputs_[kMaxZones] = {1, 2, 0, 0};
+  ModulationMode modulation_ = ModulationMode::kAm;
+  volatile bool dirty_ = true;
+
+  ParamBlock<ModulatorCoeffs> coeffs_;
+};
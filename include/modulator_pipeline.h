@@ -0,0 +1,115 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include "modulator_params.h"
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+// AudioHandle caps the block size at 1024 frames; stages that need
+// scratch buffers size them from this.
+static constexpr size_t kPipelineMaxBlock = 1024;
+
+// One stereo block on its way through the pipeline. Every stage works
+// in place on l/r and reads its per-block coefficients from p.
+//
+// With has_frame set, frame is the common sample index of l[0] across
+// boards (SampleSync), and the modulators set their carrier phase from
+// it instead of free-running, so every board's carrier lines up.
+struct StereoBlock
+{
+  float* l;
+  float* r;
+  size_t size;
+  const ModulatorCoeffs& p;
+  bool has_frame = false;
+  uint32_t frame = 0;
+};
+
+// Same block in the fixed-point pipeline (MODULATOR_Q31): Q31 samples
+// scaled by kQ31Unity, see modulator_stages_q31.h.
+struct Q31Block
+{
+  int32_t* l;
+  int32_t* r;
+  size_t size;
+  const ModulatorCoeffs& p;
+  bool has_frame = false;
+  uint32_t frame = 0;
+};
+
+// Placeholder for a stage that is switched off at compile time. It has
+// no state, so it takes no memory in the pipeline tuple beyond padding,
+// and its empty Process() inlines away.
+struct NullStage
+{
+  void Init(float) {}
+  template <typename Block>
+  void Process(Block&) {}
+};
+
+// Picks Stage when enabled, NullStage otherwise:
+//   Pipeline<..., StageIf<kEnableCompressor, Compressor>, ...>
+template <bool enabled, class Stage>
+using StageIf = typename std::conditional<enabled, Stage, NullStage>::type;
+
+// Stage timed as a row of the section profiler's table in -DDSY_PROFILE
+// builds (utility/section_profiler.h), plain Stage otherwise. name needs
+// static storage:
+//   static constexpr char kBandPassName[] = "bandpass";
+//   Pipeline<..., Profiled<kBandPassName, BandPass>, ...>
+#if defined(DSY_PROFILE)
+template <const char* name, class Stage>
+struct Profiled : Stage
+{
+  template <typename Block>
+  inline void Process(Block& block)
+  {
+    DSY_PROFILE_SCOPE(name);
+    Stage::Process(block);
+  }
+};
+#else
+template <const char* name, class Stage>
+using Profiled = Stage;
+#endif
+
+// Fixed-order chain of block stages, resolved entirely at compile time.
+//
+// A stage is any type with
+//   void Init(float sample_rate);
+//   void Process(StereoBlock& block);
+// or, for the fixed-point pipeline, Process(Q31Block& block).
+// Process() calls are expanded in declaration order with a fold
+// expression, so there is no virtual dispatch and no per-stage flag in
+// the hot path. Stages not listed are not compiled in at all.
+//
+// Each stage runs over the whole block before the next one starts. For
+// the biquad stages that keeps the state and coefficients in registers
+// for the entire inner loop, the same trade BiquadCascade makes.
+template <typename... Stages>
+class Pipeline
+{
+public:
+  void Init(float sample_rate)
+  {
+    std::apply([sample_rate](auto&... stage) { (stage.Init(sample_rate), ...); }, stages_);
+  }
+
+  template <typename Block>
+  inline void Process(Block& block)
+  {
+    std::apply([&block](auto&... stage) { (stage.Process(block), ...); }, stages_);
+  }
+
+  // Access to a listed stage, e.g. for metering. Each stage type may
+  // appear only once for this to compile.
+  template <typename Stage>
+  Stage& Get() { return std::get<Stage>(stages_); }
+
+  static constexpr size_t NumStages() { return sizeof...(Stages); }
+
+private:
+  std::tuple<Stages...> stages_;
+};
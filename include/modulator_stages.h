@@ -0,0 +1,943 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <cstdint>
+#include <cstring>
+#include "baseband_compressor.h"
+#include "baseband_limiter.h"
+#include "biquad_design.h"
+#include "carrier_bank.h"
+#include "fir_design.h"
+#include "modulator_pipeline.h"
+#include "multiband_compressor.h"
+#include "periodic_carrier.h"
+
+// Stages for Pipeline<>. Frequencies and Qs are the tuned values for
+// the 39.5 kHz carrier at 96 kHz; each filter stage gives its sections
+// in a constexpr Sections(fs), and Design() loads them into any cascade
+// type, so the Q31 pipeline (modulator_stages_q31.h) reuses the same
+// tuning.
+
+using IirResponse = IirDesign::Response;
+
+// The rates a filter stage runs at in one build or another: ahead of
+// the modulator at the codec rate (96 or 192 kHz) or a quarter of it
+// (MODULATOR_DECIMATED_BASEBAND); after it at the codec rate or twice
+// 96 kHz (MODULATOR_OVERSAMPLE_2X). Each stage's design at each of
+// these is done by the compiler (PrebuiltDesign).
+struct BasebandRates
+{
+  static constexpr float kRates[] = {24000.0f, 48000.0f, 96000.0f, 192000.0f};
+};
+
+struct CarrierRates
+{
+  static constexpr float kRates[] = {96000.0f, 192000.0f};
+};
+
+// Shared body for the biquad stages: one stereo cascade filtered in
+// place, with Stage::Sections() designed at Rates ahead of time.
+template <class Stage, size_t num_stages, class Rates>
+class FilterStage
+{
+public:
+  static constexpr size_t kNumStages = num_stages;
+
+  template <class Cascade>
+  static void Design(Cascade& c, float fs)
+  {
+    c.Init();
+    IirDesign::Load(c, PrebuiltDesign<Stage, Rates>::Get(fs));
+  }
+
+  void Init(float fs) { Design(cascade_, fs); }
+
+  inline void Process(StereoBlock& b) { cascade_.ProcessBlock(b.l, b.r, b.l, b.r, b.size); }
+
+protected:
+  StereoBiquadCascade<num_stages> cascade_;
+};
+
+// ---- Baseband (before modulation) ----
+
+// Removes DC and rumble below the transducer's useful range.
+class BaseHpf : public FilterStage<BaseHpf, 1, BasebandRates>
+{
+public:
+  static constexpr IirDesign::Sections<2> Sections(float fs)
+  {
+    return IirDesign::Butterworth<2>(IirResponse::HIGHPASS, fs, 200.0f);
+  }
+};
+
+// Limits the baseband so the sidebands stay inside the band-pass.
+class BaseLpf : public FilterStage<BaseLpf, 1, BasebandRates>
+{
+public:
+  static constexpr IirDesign::Sections<2> Sections(float fs)
+  {
+    return IirDesign::Butterworth<2>(IirResponse::LOWPASS, fs, 5000.0f);
+  }
+};
+
+class LowShelf : public FilterStage<LowShelf, 1, BasebandRates>
+{
+public:
+  static constexpr std::array<BiquadSection, 1> Sections(float fs)
+  {
+    return {IirDesign::LowShelf(fs, 200.0f, 1.5f, -3.0f)};
+  }
+};
+
+// +6 dB high shelf from 3 kHz, off in the default build.
+class PreEmphasis : public FilterStage<PreEmphasis, 1, BasebandRates>
+{
+public:
+  static constexpr std::array<BiquadSection, 1> Sections(float fs)
+  {
+    return {IirDesign::HighShelf(fs, 3000.0f, 0.7f, 6.0f)};
+  }
+};
+
+// Stereo-linked compressor, coefficients from the block snapshot.
+class BaseComp
+{
+public:
+  void Init(float) { comp_.Init(); }
+
+  inline void Process(StereoBlock& b)
+  {
+    comp_.SetCoeffs(b.p.comp_log2_threshold, b.p.comp_slope, b.p.comp_attack, b.p.comp_release);
+    comp_.ProcessBlock(b.l, b.r, b.size);
+  }
+
+  float Gain() const { return comp_.Gain(); }
+
+private:
+  BasebandCompressor comp_;
+};
+
+// Compresses the bass only, which drives most of the modulation index:
+// two LR4 bands split at kSplitHz, the low one with the compressor
+// settings of the snapshot, the high one at unity. Same CPU as
+// BaseComp plus the crossover, and no latency.
+class BaseBassComp
+{
+public:
+  static constexpr float kSplitHz = 300.0f;
+
+  void Init(float fs)
+  {
+    const float split[1] = {kSplitHz};
+    comp_.Init(fs, split);
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    comp_.SetCoeffs(0, b.p.comp_log2_threshold, b.p.comp_slope, b.p.comp_attack, b.p.comp_release);
+    comp_.ProcessBlock(b.l, b.r, b.size);
+  }
+
+  float Gain() const { return comp_.Gain(0); }
+
+private:
+  MultibandCompressor<2> comp_;
+};
+
+// Lookahead brickwall limiter, last before modulation, holding the
+// baseband to the modulation index set in ModulatorParams so transients
+// never over-modulate. Delays both channels by the lookahead
+// (lookahead_us, 500 to 2000) plus 2 samples.
+template <uint32_t lookahead_us = 1000>
+class BaseLimit
+{
+public:
+  static_assert(lookahead_us >= 500 && lookahead_us <= 2000, "lookahead must be 0.5 to 2 ms");
+
+  void Init(float fs) { limit_.Init(static_cast<size_t>(fs * (lookahead_us * 1e-6f))); }
+
+  inline void Process(StereoBlock& b)
+  {
+    limit_.SetCoeffs(b.p.limit_ceiling, b.p.limit_release);
+    limit_.ProcessBlock(b.l, b.r, b.size);
+  }
+
+  float Gain() const { return limit_.Gain(); }
+
+private:
+  BasebandLimiter limit_;
+};
+
+// ---- Modulation ----
+
+// Double sideband AM with carrier:
+//   out = (carrier_level + depth * x) * sin(wt)
+//
+// adaptive: the carrier level follows the baseband instead of sitting
+// at carrier_level, so a quiet passage no longer radiates full carrier
+// power. Each block, per channel, the level needed for a modulation
+// index of 1 on the block's peak, depth * max|x|, is clamped to
+// [carrier_floor, carrier_level]. A rise is taken within the block,
+// a fall through carrier_release. The level is ramped linearly across
+// the block, and the envelope held at or above 0, so a peak right at
+// the start of a rising block is clipped rather than phase-inverted.
+template <Nco::Backend backend = Nco::Backend::LUT, bool adaptive = false>
+class AmMod
+{
+public:
+  void Init(float fs)
+  {
+    osc_.Init(fs, backend);
+    level_[0] = level_[1] = -1.0f; // first block starts at its target
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    const ModulatorCoeffs& p = b.p;
+    if (p.carrier_phase_inc != osc_.GetPhaseInc())
+      osc_.SetPhaseInc(p.carrier_phase_inc);
+    if (b.has_frame)
+      osc_.SetFrame(b.frame);
+    osc_.ProcessBlock(carrier_, nullptr, b.size);
+
+    if constexpr (adaptive)
+    {
+      Adaptive(b.l, 0, b);
+      Adaptive(b.r, 1, b);
+      return;
+    }
+
+    float* l = b.l;
+    float* r = b.r;
+    for (size_t i = 0; i < b.size; i++)
+    {
+      const float carrier = carrier_[i];
+      l[i] = (p.carrier_level + (p.depth * l[i])) * carrier;
+      r[i] = (p.carrier_level + (p.depth * r[i])) * carrier;
+    }
+  }
+
+  // Carrier level at the end of the last block, for metering.
+  float Level(size_t ch) const { return adaptive ? level_[ch & 1] : 0.0f; }
+
+private:
+  void Adaptive(float* x, size_t ch, const StereoBlock& b)
+  {
+    const ModulatorCoeffs& p = b.p;
+    const size_t size = b.size;
+    float peak = 0.0f;
+    for (size_t i = 0; i < size; i++)
+      peak = daisysp::fmax(peak, fabsf(x[i]));
+
+    const float target = daisysp::fclamp(p.depth * peak, p.carrier_floor, p.carrier_level);
+    const float from = level_[ch] < 0.0f ? target : level_[ch];
+    const float coef = daisysp::fmin(p.carrier_release * static_cast<float>(size), 1.0f);
+    const float to = target > from ? target : from + (target - from) * coef;
+
+    const float step = (to - from) / static_cast<float>(size);
+    const float depth = p.depth;
+    float level = from;
+    for (size_t i = 0; i < size; i++)
+    {
+      level += step;
+      const float env = daisysp::fmax(level + depth * x[i], 0.0f);
+      x[i] = env * carrier_[i];
+    }
+    level_[ch] = to;
+  }
+
+  PeriodicCarrier<> osc_;
+  float level_[2];
+  float carrier_[kPipelineMaxBlock];
+};
+
+// Several AM carriers at once, for multi-zone output: zone z modulates
+// one input onto its own carrier (ModulatorParams::SetZone*()), and
+// adds the result, times its gain, to one or both outputs:
+//   out += gain * (carrier_level + depth * x) * sin(w_z t)
+// The zones are summed before the band-pass, so the band-limit filters
+// after this stage run once per output however many zones there are,
+// and each zone costs an Nco block and a few multiply-adds per sample.
+// Zones whose beams meet in the air beat at their carriers' difference
+// as well; aim them apart.
+template <size_t zones = 2, Nco::Backend backend = Nco::Backend::LUT>
+class MultiZoneMod
+{
+public:
+  static_assert(zones >= 1 && zones <= kMaxZones, "zones: 1 to kMaxZones");
+
+  void Init(float fs) { bank_.Init(fs); }
+
+  inline void Process(StereoBlock& b)
+  {
+    const ModulatorCoeffs& p = b.p;
+    for (size_t z = 0; z < zones; z++)
+      bank_.SetPhaseInc(z, p.zone_phase_inc[z]);
+    if (b.has_frame)
+      bank_.Sync(b.frame);
+
+    const size_t size = b.size;
+    memcpy(src_[0], b.l, size * sizeof(float));
+    memcpy(src_[1], b.r, size * sizeof(float));
+    memset(b.l, 0, size * sizeof(float));
+    memset(b.r, 0, size * sizeof(float));
+    for (size_t z = 0; z < zones; z++)
+    {
+      const float g = p.zone_gain[z];
+      const uint8_t outputs = p.zone_outputs[z];
+      // A silent zone still advances its carrier, to stay on the frame.
+      bank_.Modulate(z, src_[p.zone_source[z]], g * p.carrier_level, g * p.depth, zone_, size);
+      if (outputs & 1)
+        for (size_t i = 0; i < size; i++)
+          b.l[i] += zone_[i];
+      if (outputs & 2)
+        for (size_t i = 0; i < size; i++)
+          b.r[i] += zone_[i];
+    }
+  }
+
+private:
+  CarrierBank<zones, backend> bank_;
+  float src_[2][kPipelineMaxBlock];
+  float zone_[kPipelineMaxBlock];
+};
+
+// Square-root AM, predistorted for self-demodulation. A parametric
+// array demodulates roughly as d^2/dt^2 of the squared envelope, so
+// plain DSB's (c + x)^2 brings a strong second harmonic with it. Here
+//   envelope^2 = 1 + depth * g,   g = x integrated twice
+//   out = carrier_level * sqrt(max(envelope^2, 0)) * sin(wt)
+// and the array's output follows x itself.
+//
+// The integrators leak below kLeakHz so DC cannot build up, and are
+// scaled for unity gain at kRefHz, near the bottom of the band where
+// the double integral is largest; higher up it falls 12 dB/octave as
+// the array's demodulation rises. sqrt is a bit-level reciprocal
+// square root estimate with two Newton steps, a few pipelined
+// multiplies instead of the non-pipelined VSQRT. One step leaves 0.2%
+// error, which shows up as a -41 dB second harmonic at light depths;
+// two leave the envelope's harmonics below -88 dB.
+template <Nco::Backend backend = Nco::Backend::LUT>
+class SramMod
+{
+public:
+  static constexpr float kRefHz = 250.0f;
+  static constexpr float kLeakHz = 100.0f;
+
+  void Init(float fs)
+  {
+    osc_.Init(fs, backend);
+    leak_ = expf(-2.0f * 3.14159265358979323846f * kLeakHz / fs);
+    scale_ = 2.0f * 3.14159265358979323846f * kRefHz / fs;
+    for (size_t c = 0; c < 2; c++)
+      g1_[c] = g2_[c] = 0.0f;
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    const ModulatorCoeffs& p = b.p;
+    if (p.carrier_phase_inc != osc_.GetPhaseInc())
+      osc_.SetPhaseInc(p.carrier_phase_inc);
+    if (b.has_frame)
+      osc_.SetFrame(b.frame);
+    osc_.ProcessBlock(carrier_, nullptr, b.size);
+
+    Channel(b.l, 0, b);
+    Channel(b.r, 1, b);
+  }
+
+private:
+  // sqrt(x) = x / sqrt(x), for x >= 0; 0 gives 0.
+  static inline float FastSqrt(float x)
+  {
+    uint32_t i;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x5f3759dfu - (i >> 1);
+    float y;
+    memcpy(&y, &i, sizeof(y));
+    const float half = 0.5f * x;
+    y = y * (1.5f - half * y * y);
+    y = y * (1.5f - half * y * y);
+    return x * y;
+  }
+
+  void Channel(float* x, size_t ch, const StereoBlock& b)
+  {
+    const float leak = leak_;
+    const float scale = scale_;
+    const float depth = b.p.depth;
+    const float level = b.p.carrier_level;
+    float g1 = g1_[ch];
+    float g2 = g2_[ch];
+    for (size_t i = 0; i < b.size; i++)
+    {
+      g1 = leak * g1 + scale * x[i];
+      g2 = leak * g2 + scale * g1;
+      const float e2 = daisysp::fmax(1.0f + depth * g2, 0.0f);
+      x[i] = level * FastSqrt(e2) * carrier_[i];
+    }
+    g1_[ch] = g1;
+    g2_[ch] = g2;
+  }
+
+  PeriodicCarrier<> osc_;
+  float leak_ = 0.0f;
+  float scale_ = 0.0f;
+  float g1_[2];
+  float g2_[2];
+  float carrier_[kPipelineMaxBlock];
+};
+
+// Two Hilberts behind one QualityStage of DAISY.Governor(): Full at
+// tier 1, Light at tier 0. stage is set up in setup(); until then, or
+// if the governor had no room for it, Full runs. Only the selected one
+// runs, so the other's state is stale by the time it is switched to: it
+// is cleared, and the in-phase delay steps between the two (127
+// samples for HilbertFir<255> against none for HilbertIir) with a
+// click, which is still far less than an overrunning callback.
+template <QualityStage*& stage, class Full, class Light>
+class TieredHilbert
+{
+public:
+  void Init()
+  {
+    full_.Init();
+    light_.Init();
+    light_on_ = false;
+  }
+
+  void ProcessBlock(const float* in, float* out_i, float* out_q, size_t size)
+  {
+    const bool light = stage != nullptr && stage->GetTier() == 0;
+    if (light != light_on_)
+    {
+      if (light)
+        light_.Reset();
+      else
+        full_.Reset();
+      light_on_ = light;
+    }
+    if (light)
+      light_.ProcessBlock(in, out_i, out_q, size);
+    else
+      full_.ProcessBlock(in, out_i, out_q, size);
+  }
+
+private:
+  Full full_;
+  Light light_;
+  bool light_on_ = false;
+};
+
+enum class Sideband
+{
+  Upper,
+  Lower,
+};
+
+// SSB with carrier (phasing method), relative to a sin() carrier:
+//   USB = (c + x) * sin(wt) + xh * cos(wt)
+//   LSB = (c + x) * sin(wt) - xh * cos(wt)
+// where xh is the Hilbert transform of x. The in-phase output
+// replaces the baseband in place, delayed to match xh.
+//
+// Hilbert is HilbertFir<N> or HilbertIir:
+// - FIR: 255 taps gives 127 samples (1.3 ms) of group delay at 96 kHz.
+//   The phase split is accurate from roughly 1 kHz upward at this
+//   length; content near the 200 Hz BaseHpf corner leaks into the
+//   opposite sideband. ~64 MACs per sample per channel.
+// - IIR: allpass phase splitter, 90 +/- 0.7 degrees from ~33 Hz up,
+//   near-zero latency, 8 multiplies per sample per channel.
+//
+// sideband is where the stage starts; SetSideband() moves it at run
+// time (SwitchableMod) by ramping the quadrature term's sign through
+// zero, so the output passes through DSB rather than stepping.
+template <Sideband sideband, class Hilbert, Nco::Backend backend = Nco::Backend::LUT>
+class SsbMod
+{
+public:
+  void Init(float fs)
+  {
+    osc_.Init(fs, backend);
+    hilbert_l_.Init();
+    hilbert_r_.Init();
+    sign_ = target_ = Sign(sideband);
+    step_ = 0.0f;
+  }
+
+  // Audio callback, between blocks: over the next ramp samples (0 for a
+  // step), to side.
+  void SetSideband(Sideband side, uint32_t ramp)
+  {
+    target_ = Sign(side);
+    if (ramp == 0)
+      sign_ = target_;
+    step_ = ramp > 0 ? (target_ - sign_) / (float)ramp : 0.0f;
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    const ModulatorCoeffs& p = b.p;
+    if (p.carrier_phase_inc != osc_.GetPhaseInc())
+      osc_.SetPhaseInc(p.carrier_phase_inc);
+    if (b.has_frame)
+      osc_.SetFrame(b.frame);
+    osc_.ProcessBlock(sin_, cos_, b.size);
+
+    float* l = b.l;
+    float* r = b.r;
+    hilbert_l_.ProcessBlock(l, l, q_l_, b.size);
+    hilbert_r_.ProcessBlock(r, r, q_r_, b.size);
+
+    const float depth = p.depth;
+    if (sign_ == target_)
+    {
+      const float q_sign = sign_ * depth;
+      for (size_t i = 0; i < b.size; i++)
+      {
+        const float s = sin_[i];
+        const float c = cos_[i];
+        l[i] = (p.carrier_level + depth * l[i]) * s + q_sign * q_l_[i] * c;
+        r[i] = (p.carrier_level + depth * r[i]) * s + q_sign * q_r_[i] * c;
+      }
+      return;
+    }
+
+    float sign = sign_;
+    const float lo = daisysp::fmin(sign, target_);
+    const float hi = daisysp::fmax(sign, target_);
+    for (size_t i = 0; i < b.size; i++)
+    {
+      sign = daisysp::fclamp(sign + step_, lo, hi);
+      const float s = sin_[i];
+      const float c = cos_[i];
+      const float q_sign = sign * depth;
+      l[i] = (p.carrier_level + depth * l[i]) * s + q_sign * q_l_[i] * c;
+      r[i] = (p.carrier_level + depth * r[i]) * s + q_sign * q_r_[i] * c;
+    }
+    sign_ = sign;
+  }
+
+private:
+  static constexpr float Sign(Sideband side) { return side == Sideband::Upper ? 1.0f : -1.0f; }
+
+  PeriodicCarrier<> osc_;
+  Hilbert hilbert_l_;
+  Hilbert hilbert_r_;
+  float sin_[kPipelineMaxBlock];
+  float cos_[kPipelineMaxBlock];
+  float q_l_[kPipelineMaxBlock];
+  float q_r_[kPipelineMaxBlock];
+  float sign_ = 1.0f; // quadrature term's sign, -1 to 1
+  float target_ = 1.0f;
+  float step_ = 0.0f;
+};
+
+// Every modulation above in one stage, switchable while running:
+// ModulatorParams::SetModulation() picks AM, DSB-SC (AM with the
+// carrier level at zero), upper or lower SSB, SRAM or adaptive AM.
+//
+// Each mode's stage is a member, set up in Init(), so a switch
+// allocates nothing and designs no tables; only the active mode runs.
+// On a change the outgoing and incoming modes both run for a while and
+// the output crossfades from one to the other:
+//   - kPrerollMs with the incoming mode muted, long enough to fill the
+//     FIR Hilbert's history and flush whatever stale state the mode
+//     was left with since it last ran, then
+//   - kFadeMs of linear crossfade.
+// A further change waits for the fade to finish. USB and LSB share one
+// SsbMod: between them the sideband ramps over kFadeMs instead.
+//
+// Every mode runs with the frame sync on, on the array's frame count or
+// on one counted here, so their carriers stay in phase and the fade
+// does not comb two carrier phases against each other.
+template <class Hilbert, Nco::Backend backend = Nco::Backend::LUT>
+class SwitchableMod
+{
+public:
+  static constexpr float kPrerollMs = 3.0f;
+  static constexpr float kFadeMs = 10.0f;
+
+  void Init(float fs)
+  {
+    am_.Init(fs);
+    dsb_sc_.Init(fs);
+    adaptive_.Init(fs);
+    ssb_.Init(fs);
+    sram_.Init(fs);
+    preroll_ = (int32_t)(fs * kPrerollMs / 1000.0f);
+    const int32_t fade = (int32_t)(fs * kFadeMs / 1000.0f);
+    fade_ = fade > 0 ? fade : 1;
+    inv_fade_ = 1.0f / (float)fade_;
+    mode_ = from_ = ModulationMode::kAm;
+    fading_ = false;
+    pos_ = 0;
+    frame_ = 0;
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    const uint32_t frame = b.has_frame ? b.frame : frame_;
+    frame_ = frame + (uint32_t)b.size;
+    StereoBlock out{b.l, b.r, b.size, b.p, true, frame};
+    if (!fading_ && b.p.modulation != mode_)
+      Switch(b.p.modulation);
+    if (!fading_)
+    {
+      Run(mode_, out);
+      return;
+    }
+
+    const size_t size = b.size;
+    memcpy(in_l_, b.l, size * sizeof(float));
+    memcpy(in_r_, b.r, size * sizeof(float));
+    StereoBlock in{in_l_, in_r_, size, b.p, true, frame};
+    Run(from_, out);
+    Run(mode_, in);
+
+    float* l = b.l;
+    float* r = b.r;
+    for (size_t i = 0; i < size; i++)
+    {
+      const int32_t pos = pos_ + (int32_t)i;
+      const float w = pos <= 0 ? 0.0f : daisysp::fmin((float)pos * inv_fade_, 1.0f);
+      l[i] += w * (in_l_[i] - l[i]);
+      r[i] += w * (in_r_[i] - r[i]);
+    }
+    pos_ += (int32_t)size;
+    fading_ = pos_ < fade_;
+  }
+
+  // The mode the output is on, or fading to.
+  ModulationMode Mode() const { return mode_; }
+
+private:
+  static bool IsSsb(ModulationMode m) { return m == ModulationMode::kSsbUpper || m == ModulationMode::kSsbLower; }
+
+  static Sideband Side(ModulationMode m) { return m == ModulationMode::kSsbLower ? Sideband::Lower : Sideband::Upper; }
+
+  void Switch(ModulationMode next)
+  {
+    if (IsSsb(mode_) && IsSsb(next))
+    {
+      ssb_.SetSideband(Side(next), (uint32_t)fade_);
+      mode_ = next;
+      return;
+    }
+    if (IsSsb(next))
+      ssb_.SetSideband(Side(next), 0);
+    from_ = mode_;
+    mode_ = next;
+    pos_ = -preroll_;
+    fading_ = true;
+  }
+
+  void Run(ModulationMode mode, StereoBlock& b)
+  {
+    switch (mode)
+    {
+    case ModulationMode::kDsbSc:
+    {
+      ModulatorCoeffs p = b.p;
+      p.carrier_level = 0.0f;
+      StereoBlock sc{b.l, b.r, b.size, p, b.has_frame, b.frame};
+      dsb_sc_.Process(sc);
+      break;
+    }
+    case ModulationMode::kSsbUpper:
+    case ModulationMode::kSsbLower:
+      ssb_.Process(b);
+      break;
+    case ModulationMode::kSram:
+      sram_.Process(b);
+      break;
+    case ModulationMode::kAdaptiveAm:
+      adaptive_.Process(b);
+      break;
+    case ModulationMode::kAm:
+    default:
+      am_.Process(b);
+      break;
+    }
+  }
+
+  AmMod<backend, false> am_;
+  AmMod<backend, false> dsb_sc_;
+  AmMod<backend, true> adaptive_;
+  SsbMod<Sideband::Upper, Hilbert, backend> ssb_;
+  SramMod<backend> sram_;
+  ModulationMode mode_ = ModulationMode::kAm;
+  ModulationMode from_ = ModulationMode::kAm;
+  bool fading_ = false;
+  int32_t pos_ = 0; // samples into the fade; negative during the preroll
+  int32_t preroll_ = 0;
+  int32_t fade_ = 1;
+  float inv_fade_ = 1.0f;
+  uint32_t frame_ = 0;
+  float in_l_[kPipelineMaxBlock];
+  float in_r_[kPipelineMaxBlock];
+};
+
+// ---- Band limit (after modulation) ----
+
+// Carrier band: 2nd order Butterworth HPF at 24 kHz, then a 4th order
+// Butterworth LPF at 45 kHz. (Two 0.707 sections would make a
+// Linkwitz-Riley, already -6 dB at the corner.)
+class BandPass : public FilterStage<BandPass, 3, CarrierRates>
+{
+public:
+  static constexpr std::array<BiquadSection, 3> Sections(float fs)
+  {
+    const auto hp = IirDesign::Butterworth<2>(IirResponse::HIGHPASS, fs, 24000.0f);
+    const auto lp = IirDesign::Butterworth<4>(IirResponse::LOWPASS, fs, 45000.0f);
+    return {hp[0], lp[0], lp[1]};
+  }
+};
+
+// 4th order Butterworth HPF at 19 kHz to keep the audible band clean.
+class PostHpf : public FilterStage<PostHpf, 2, CarrierRates>
+{
+public:
+  static constexpr IirDesign::Sections<4> Sections(float fs)
+  {
+    return IirDesign::Butterworth<4>(IirResponse::HIGHPASS, fs, 19000.0f);
+  }
+};
+
+// Band limit as one linear-phase FIR, for -DMODULATOR_BAND_FIR in place
+// of BandPass and PostHpf: a Kaiser-windowed band-pass, the difference
+// of two sinc lowpasses with their -6 dB points at kLowHz and kHighHz.
+// The lower skirt reaches the IIR pair's stopband (PostHpf's 19 kHz)
+// and the upper one stays clear of 44.5 kHz, where the 45 kHz
+// Butterworth is already 3 dB down. Every frequency is delayed by the
+// same (taps - 1) / 2 samples, so the sidebands keep their phase
+// relation to the carrier. The IIR cascade's group delay changes across
+// the band.
+//
+// Symmetric taps are folded: each output is (taps + 1) / 2
+// multiply-adds over pairs of inputs, instead of taps. 63 taps at
+// 96 kHz, or 127 at 192 kHz for the same edges, cost 32 (64) per sample
+// and channel, against the IIR pair's 25 multiplies; see
+// src/bench/band_fir_bench.cpp.
+template <size_t taps>
+class BandFir
+{
+public:
+  static_assert(taps % 2 == 1, "taps: odd, for a centre tap");
+
+  static constexpr float kLowHz = 29250.0f;
+  static constexpr float kHighHz = 46750.0f;
+  static constexpr float kRefHz = 39500.0f; // unity gain here
+  static constexpr float kBeta = 7.0f;
+
+  void Init(float fs)
+  {
+    double h[taps] = {};
+    const double hi = (double)kHighHz / (double)fs;
+    AddKaiserLowpass(h, taps, hi < 0.5 ? hi : 0.5, (double)kBeta, 1.0);
+    AddKaiserLowpass(h, taps, (double)kLowHz / (double)fs, (double)kBeta, -1.0);
+    const double w = 2.0 * 3.14159265358979323846 * (double)kRefHz / (double)fs;
+    double re = 0.0, im = 0.0;
+    for (size_t k = 0; k < taps; k++)
+    {
+      re += h[k] * cos(w * (double)k);
+      im -= h[k] * sin(w * (double)k);
+    }
+    const double scale = 1.0 / sqrt(re * re + im * im);
+    for (size_t k = 0; k <= kHalf; k++)
+      coef_[k] = (float)(h[k] * scale);
+    for (float& x : state_l_)
+      x = 0.0f;
+    for (float& x : state_r_)
+      x = 0.0f;
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    Channel(b.l, state_l_, b.size);
+    Channel(b.r, state_r_, b.size);
+  }
+
+  // Added delay in samples.
+  static constexpr size_t GetLatency() { return kHalf; }
+
+private:
+  static constexpr size_t kHalf = (taps - 1) / 2;
+
+  // state holds the last taps - 1 inputs, oldest first; the block goes
+  // on behind them, and x[j] comes out of state[j .. j + taps - 1].
+  void Channel(float* x, float* state, size_t size)
+  {
+    memcpy(state + taps - 1, x, size * sizeof(float));
+    for (size_t j = 0; j < size; j++)
+    {
+      const float* w = state + j;
+      float acc = coef_[kHalf] * w[kHalf];
+      for (size_t k = 0; k < kHalf; k++)
+        acc += coef_[k] * (w[k] + w[taps - 1 - k]);
+      x[j] = acc;
+    }
+    memmove(state, state + size, (taps - 1) * sizeof(float));
+  }
+
+  float coef_[kHalf + 1];
+  float state_l_[taps - 1 + kPipelineMaxBlock];
+  float state_r_[taps - 1 + kPipelineMaxBlock];
+};
+
+// ---- Oversampling ----
+
+// Runs the wrapped stages at twice the codec rate:
+//   up (half-band) -> Stages... at 2 fs -> down (half-band)
+// so the carrier and its sidebands sit well below the inner Nyquist
+// and the band-limit filters no longer warp against it. The base block
+// is processed in chunks of kPipelineMaxBlock / 2, so the inner stages
+// never see more than kPipelineMaxBlock samples.
+//
+// The inner stages get a copy of the block coefficients with the
+// carrier phase increment halved for the doubled rate, and a common
+// frame index counted at the doubled rate.
+template <size_t up_taps, size_t down_taps, typename... Stages>
+class Oversample2x
+{
+public:
+  void Init(float fs)
+  {
+    up_l_.Init();
+    up_r_.Init();
+    down_l_.Init();
+    down_r_.Init();
+    inner_.Init(2.0f * fs);
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    ModulatorCoeffs p = b.p;
+    p.carrier_phase_inc >>= 1;
+    for (uint32_t& inc : p.zone_phase_inc)
+      inc >>= 1;
+
+    for (size_t start = 0; start < b.size; start += kChunk)
+    {
+      const size_t n = (b.size - start) < kChunk ? (b.size - start) : kChunk;
+      float* l = b.l + start;
+      float* r = b.r + start;
+
+      up_l_.ProcessBlock(l, hi_l_, n);
+      up_r_.ProcessBlock(r, hi_r_, n);
+      StereoBlock hi{hi_l_, hi_r_, 2 * n, p};
+      hi.has_frame = b.has_frame;
+      hi.frame = 2 * (b.frame + (uint32_t)start);
+      inner_.Process(hi);
+      down_l_.ProcessBlock(hi_l_, l, n);
+      down_r_.ProcessBlock(hi_r_, r, n);
+    }
+  }
+
+  // Added delay in base-rate samples, rounded down.
+  static constexpr size_t GetLatency()
+  {
+    return (HalfbandDesign<up_taps>::kCenter + HalfbandDesign<down_taps>::kCenter) / 2;
+  }
+
+private:
+  static constexpr size_t kChunk = kPipelineMaxBlock / 2;
+
+  Upsampler2x<up_taps, kChunk> up_l_;
+  Upsampler2x<up_taps, kChunk> up_r_;
+  Downsampler2x<down_taps, kChunk> down_l_;
+  Downsampler2x<down_taps, kChunk> down_r_;
+  Pipeline<Stages...> inner_;
+  float hi_l_[kPipelineMaxBlock];
+  float hi_r_[kPipelineMaxBlock];
+};
+
+// Runs the wrapped baseband stages at 1 / factor of the codec rate:
+//   down (polyphase FIR) -> Stages... at fs / factor -> up (polyphase FIR)
+// The baseband is limited to 5 kHz, so at 96 kHz and factor 4 the inner
+// stages see a 24 kHz stream and cost a quarter of what they would at
+// the full rate. Both resamplers share one Kaiser-windowed sinc with its
+// cutoff at the low rate's Nyquist; 48 taps at beta 8 pass 5 kHz flat
+// and hold the interpolator's images of it, from 19 kHz up, around
+// 80 dB down, before they can reach the carrier. Each costs
+// taps / factor multiply-adds per codec-rate sample and channel.
+//
+// Block sizes must be a multiple of factor. The inner stages get a copy
+// of the block coefficients with the per-sample one-pole coefficients
+// (compressor, limiter) rescaled for the lower rate. The limiter then
+// sees the peaks of the low-rate samples only; the interpolated signal
+// between them can overshoot its ceiling by a percent or so.
+template <size_t factor, size_t taps, typename... Stages>
+class DecimatedBaseband
+{
+public:
+  static_assert(factor >= 2, "factor: at least 2");
+  static_assert(taps % factor == 0, "taps: a multiple of factor");
+
+  static constexpr float kBeta = 8.0f;
+
+  void Init(float fs)
+  {
+    float h[taps];
+    Design(h, 1.0f);
+    down_l_.Init(h, taps, false);
+    down_r_.Init(h, taps, false);
+    Design(h, (float)factor);
+    up_l_.Init(h, taps, false);
+    up_r_.Init(h, taps, false);
+    inner_.Init(fs / (float)factor);
+  }
+
+  inline void Process(StereoBlock& b)
+  {
+    ModulatorCoeffs p = b.p;
+    p.comp_attack = Slower(p.comp_attack);
+    p.comp_release = Slower(p.comp_release);
+    p.limit_release = Slower(p.limit_release);
+
+    const size_t n = b.size / factor;
+    down_l_.ProcessBlock(b.l, lo_l_, n * factor);
+    down_r_.ProcessBlock(b.r, lo_r_, n * factor);
+    StereoBlock lo{lo_l_, lo_r_, n, p};
+    inner_.Process(lo);
+    up_l_.ProcessBlock(lo_l_, b.l, n);
+    up_r_.ProcessBlock(lo_r_, b.r, n);
+  }
+
+  // Added delay in codec-rate samples: both linear-phase FIRs.
+  static constexpr size_t GetLatency() { return taps - 1; }
+
+private:
+  static constexpr size_t kLowBlock = kPipelineMaxBlock / factor;
+
+  // 1 - (1 - c)^factor: the same time constant at 1 / factor the rate.
+  static float Slower(float c)
+  {
+    const float keep = 1.0f - c;
+    float k = 1.0f;
+    for (size_t i = 0; i < factor; i++)
+      k *= keep;
+    return 1.0f - k;
+  }
+
+  // Unity DC gain times gain. Symmetric, so the tail-first order SetIR
+  // wants is the same.
+  static void Design(float* h, float gain)
+  {
+    double tmp[taps] = {};
+    AddKaiserLowpass(tmp, taps, 0.5 / (double)factor, (double)kBeta, 1.0);
+    double sum = 0.0;
+    for (double t : tmp)
+      sum += t;
+    for (size_t k = 0; k < taps; k++)
+      h[k] = (float)(tmp[k] * (double)gain / sum);
+  }
+
+  FIRDecimator<taps, kPipelineMaxBlock, factor> down_l_;
+  FIRDecimator<taps, kPipelineMaxBlock, factor> down_r_;
+  FIRInterpolator<taps, kLowBlock, factor> up_l_;
+  FIRInterpolator<taps, kLowBlock, factor> up_r_;
+  Pipeline<Stages...> inner_;
+  float lo_l_[kLowBlock];
+  float lo_r_[kLowBlock];
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include "modulator_pipeline.h"
+#include "modulator_stages.h"
+#include <cstdint>
+
+// Fixed-point versions of the AM pipeline stages (MODULATOR_Q31).
+//
+// Samples are Q31 with one bit of headroom: kQ31Unity (2^30) is 1.0 of
+// the float pipeline, so the AM envelope (carrier_level + depth * x)
+// and the band-pass overshoot can reach 2.0 before anything clips. The
+// codec's 24-bit words map onto this with a 7-bit shift each way
+// (Sai24ToQ31 / Q31ToSai24), so the 8 bits below the codec LSB carry
+// the filters' rounding noise instead of the signal.
+//
+// The filter stages reuse the float stages' Design() through
+// Q31Filter<>, so both pipelines always share one tuning.
+
+static constexpr float kQ31Unity = 1073741824.0f; // 2^30
+
+// Saturates a 64-bit intermediate to Q31.
+static inline int32_t SatQ31(int64_t x)
+{
+  return x > INT32_MAX ? INT32_MAX : (x < INT32_MIN ? INT32_MIN : (int32_t)x);
+}
+
+// Right-aligned, zero-padded 24-bit SAI word to pipeline Q31: sign
+// extend from bit 23, then scale by 2^7.
+static inline int32_t Sai24ToQ31(int32_t w)
+{
+  return (int32_t)((uint32_t)w << 8) >> 1;
+}
+
+// Pipeline Q31 back to a 24-bit SAI word, clipped to +/- 1.0 like
+// f2s24. The SAI only sends the low 24 bits.
+static inline int32_t Q31ToSai24(int32_t q)
+{
+  constexpr int32_t kHi = (1 << 30) - 1;
+  constexpr int32_t kLo = -(1 << 30);
+  q = q > kHi ? kHi : (q < kLo ? kLo : q);
+  return q >> 7;
+}
+
+// Fixed-point twin of a FilterStage: Stage::Design() quantized into a
+// Q31 cascade, filtered in place.
+template <class Stage>
+class Q31Filter
+{
+public:
+  void Init(float fs) { Stage::Design(cascade_, fs); }
+
+  inline void Process(Q31Block& b) { cascade_.ProcessBlock(b.l, b.r, b.l, b.r, b.size); }
+
+private:
+  StereoBiquadCascadeQ31<Stage::kNumStages> cascade_;
+};
+
+// AmMod in fixed point:
+//   out = (carrier_level + depth * x) * sin(wt)
+// The carrier still comes from a float table (PeriodicCarrier's or the
+// NCO's), converted once per sample; the envelope and the product are
+// integer multiplies.
+// depth is Q3.28 here (up to +/- 8), carrier_level and the output use
+// the pipeline scaling.
+template <Nco::Backend backend = Nco::Backend::LUT>
+class AmModQ31
+{
+public:
+  void Init(float fs) { osc_.Init(fs, backend); }
+
+  inline void Process(Q31Block& b)
+  {
+    const ModulatorCoeffs& p = b.p;
+    if (p.carrier_phase_inc != osc_.GetPhaseInc())
+      osc_.SetPhaseInc(p.carrier_phase_inc);
+    if (b.has_frame)
+      osc_.SetFrame(b.frame);
+    osc_.ProcessBlock(carrier_, nullptr, b.size);
+
+    const int32_t level = ToFixed(p.carrier_level, kQ31Unity);
+    const int32_t depth = ToFixed(p.depth, kDepthUnity);
+
+    int32_t* l = b.l;
+    int32_t* r = b.r;
+    for (size_t i = 0; i < b.size; i++)
+    {
+      const int32_t carrier = ToFixed(carrier_[i], kCarrierUnity);
+      const int32_t env_l = SatQ31((int64_t)level + (((int64_t)depth * l[i]) >> kDepthBits));
+      const int32_t env_r = SatQ31((int64_t)level + (((int64_t)depth * r[i]) >> kDepthBits));
+      // |carrier| < 2^31, so the products cannot reach 2^62.
+      l[i] = (int32_t)(((int64_t)env_l * carrier) >> 31);
+      r[i] = (int32_t)(((int64_t)env_r * carrier) >> 31);
+    }
+  }
+
+private:
+  static constexpr int kDepthBits = 28;
+  static constexpr float kDepthUnity = 268435456.0f;    // 2^28
+  static constexpr float kCarrierUnity = 2147483520.0f; // largest float below 2^31
+
+  // Scales and clamps a float to the int32 range.
+  static inline int32_t ToFixed(float x, float unity)
+  {
+    float v = x * unity;
+    v = v >= 2147483520.0f ? 2147483520.0f : v;
+    v = v <= -2147483648.0f ? -2147483648.0f : v;
+    return (int32_t)v;
+  }
+
+  PeriodicCarrier<> osc_;
+  float carrier_[kPipelineMaxBlock];
+};
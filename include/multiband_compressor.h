@@ -0,0 +1,143 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <cstddef>
+#include "baseband_compressor.h"
+
+// Stereo-linked multiband compressor on Linkwitz-Riley crossovers.
+//
+// The block is split in a chain: band 0 is the LR4 lowpass of the input
+// at the first crossover, the highpass goes on to be split at the next,
+// and the last band is what is left above the top crossover. Each band
+// has its own BasebandCompressor, so detection is decimated per band
+// the same way (kSubBlock) and costs what the single-band compressor
+// does; a band with slope 0 is left at unity and not detected at all.
+//
+// LR4 lowpass and highpass of one crossover sum to a 2nd-order allpass,
+// so the bands below a crossover need that allpass too before the sum.
+// It is applied once to the running sum of the lower bands at each
+// crossover above the first, so the output is flat in magnitude with
+// every band at unity: bands - 2 extra sections in all.
+//
+// Everything runs a chunk at a time, one filter or band over the whole
+// chunk before the next.
+template <size_t bands>
+class MultibandCompressor
+{
+public:
+  static_assert(bands >= 2 && bands <= 4, "MultibandCompressor has 2 to 4 bands");
+  static constexpr size_t kNumCrossovers = bands - 1;
+  static constexpr size_t kChunkSize = 64;
+
+  // crossover_hz ascending. The designs are constexpr IirDesign math,
+  // a setup-time cost only. Every band starts at unity.
+  void Init(float fs, const float (&crossover_hz)[kNumCrossovers])
+  {
+    using daisysp::IirDesign;
+    using Response = IirDesign::Response;
+    for (size_t k = 0; k < kNumCrossovers; k++)
+    {
+      lp_[k].Init();
+      hp_[k].Init();
+      IirDesign::Load(lp_[k], IirDesign::LinkwitzRiley<4>(Response::LOWPASS, fs, crossover_hz[k]));
+      IirDesign::Load(hp_[k], IirDesign::LinkwitzRiley<4>(Response::HIGHPASS, fs, crossover_hz[k]));
+      if (k > 0)
+      {
+        // LP + HP of LR4 is the allpass on the poles of its Butterworth half.
+        const BiquadSection bw = IirDesign::Butterworth<2>(Response::LOWPASS, fs, crossover_hz[k])[0];
+        BiquadSection ap;
+        ap.b0 = bw.a2;
+        ap.b1 = bw.a1;
+        ap.b2 = 1.0f;
+        ap.a1 = bw.a1;
+        ap.a2 = bw.a2;
+        ap_[k - 1].Init();
+        ap_[k - 1].SetSection(0, ap);
+      }
+    }
+    for (size_t b = 0; b < bands; b++)
+    {
+      comp_[b].Init();
+      active_[b] = false;
+    }
+  }
+
+  // Already-derived settings of one band, as BasebandCompressor takes
+  // them; slope 0 leaves the band uncompressed.
+  void SetCoeffs(size_t band, float log2_threshold, float slope, float attack, float release)
+  {
+    if (band >= bands)
+      return;
+    comp_[band].SetCoeffs(log2_threshold, slope, attack, release);
+    if (slope != 0.0f)
+    {
+      active_[band] = true;
+    }
+    else if (active_[band])
+    {
+      // Leaves at unity, not at whatever gain it was holding.
+      comp_[band].Init();
+      active_[band] = false;
+    }
+  }
+
+  // Compresses a stereo block in place.
+  void ProcessBlock(float* l, float* r, size_t size)
+  {
+    for (size_t pos = 0; pos < size; pos += kChunkSize)
+    {
+      const size_t n = (size - pos) < kChunkSize ? (size - pos) : kChunkSize;
+      ProcessChunk(l + pos, r + pos, n);
+    }
+  }
+
+  // Gain of one band on the last sample, for metering.
+  float Gain(size_t band) const { return band < bands ? comp_[band].Gain() : 1.0f; }
+
+private:
+  void ProcessChunk(float* l, float* r, size_t n)
+  {
+    // Split: band k into buf_[k], the rest stays in l / r and ends up
+    // as the top band.
+    for (size_t k = 0; k < kNumCrossovers; k++)
+    {
+      lp_[k].ProcessBlock(l, r, buf_[k][0], buf_[k][1], n);
+      hp_[k].ProcessBlock(l, r, l, r, n);
+    }
+    for (size_t b = 0; b < kNumCrossovers; b++)
+    {
+      if (active_[b])
+        comp_[b].ProcessBlock(buf_[b][0], buf_[b][1], n);
+    }
+    if (active_[bands - 1])
+      comp_[bands - 1].ProcessBlock(l, r, n);
+
+    // Sum from the bottom, phase-matching the lower bands at each
+    // crossover above the first.
+    float* acc_l = buf_[0][0];
+    float* acc_r = buf_[0][1];
+    for (size_t k = 1; k < kNumCrossovers; k++)
+    {
+      ap_[k - 1].ProcessBlock(acc_l, acc_r, acc_l, acc_r, n);
+      const float* bl = buf_[k][0];
+      const float* br = buf_[k][1];
+      for (size_t i = 0; i < n; i++)
+      {
+        acc_l[i] += bl[i];
+        acc_r[i] += br[i];
+      }
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+      l[i] += acc_l[i];
+      r[i] += acc_r[i];
+    }
+  }
+
+  StereoBiquadCascade<2> lp_[kNumCrossovers];
+  StereoBiquadCascade<2> hp_[kNumCrossovers];
+  StereoBiquadCascade<1> ap_[kNumCrossovers > 1 ? kNumCrossovers - 1 : 1];
+  BasebandCompressor comp_[bands];
+  bool active_[bands];
+  float buf_[kNumCrossovers][2][kChunkSize];
+};
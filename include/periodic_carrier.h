@@ -0,0 +1,191 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// A carrier that repeats exactly, read from a table of one period.
+//
+// A carrier at fc = fs * p / q, the fraction in lowest terms, goes
+// through exactly p cycles every q samples: 39.5 kHz is 79/192 of
+// 96 kHz and 79/384 of 192 kHz. Whenever q is at most max_period,
+// SetPhaseInc() builds the q samples of sin and cos once, in double,
+// and ProcessBlock() reads them with an integer index: no drift, no
+// interpolation error and no phase arithmetic per sample. Any other
+// frequency falls back to the Nco, on the backend given to Init().
+//
+// The period is found from the raw phase increment itself, so nothing
+// upstream changes: ModulatorParams still hands out
+// Nco::FreqToPhaseInc(). The continued fraction of inc / 2^32 gives
+// the first p / q whose rounded increment is inc, in a few dozen
+// integer steps. A frequency that misses stays on the Nco for that
+// cost only. A hit builds the table with a double-precision rotation,
+// about q * 20 cycles, in the audio callback when the carrier is
+// retuned. Switching between the two keeps the phase.
+//
+// Same calls as the Nco for the modulator stages. SetFrame() replaces
+// SetPhase(inc * frame) for the array sync: on the table it is frame
+// mod q, exact at any frame count. The table makes the object
+// 8 * max_period bytes; place the stage in DTCM for zero wait states.
+template <size_t max_period = 384>
+class PeriodicCarrier
+{
+public:
+  static_assert(max_period >= 2, "PeriodicCarrier needs a period of 2 or more");
+
+  void Init(float fs, Nco::Backend backend = Nco::Backend::LUT)
+  {
+    nco_.Init(fs, backend);
+    period_ = 0;
+    index_ = 0;
+  }
+
+  inline uint32_t GetPhaseInc() const { return nco_.GetPhaseInc(); }
+
+  // The table's period in samples, 0 while on the Nco.
+  inline uint32_t Period() const { return period_; }
+
+  // Carrier frequency, in Nco::SetPhaseInc() units; from the table if
+  // it has a period of max_period or less.
+  void SetPhaseInc(uint32_t inc)
+  {
+    const uint32_t phase = Phase();
+    nco_.SetPhaseInc(inc);
+    uint32_t p, q;
+    if (!FindPeriod(inc, p, q))
+    {
+      period_ = 0;
+      nco_.SetPhase(phase);
+      return;
+    }
+    Build(p, q);
+    // Index m has phase p m / q turns: m = round(phase q) / p mod q.
+    const uint32_t turn_q = (uint32_t)(((uint64_t)phase * q + (1ull << 31)) >> 32) % q;
+    index_ = (uint32_t)(((uint64_t)turn_q * Inverse(p, q)) % q);
+  }
+
+  // Phase of frame: the carrier as if it had run since frame 0.
+  inline void SetFrame(uint32_t frame)
+  {
+    if (period_ != 0)
+      index_ = frame % period_;
+    else
+      nco_.SetPhase(nco_.GetPhaseInc() * frame);
+  }
+
+  // sin and (optionally) cos of the next size samples.
+  void ProcessBlock(float* sin_out, float* cos_out, size_t size)
+  {
+    if (period_ == 0)
+    {
+      nco_.ProcessBlock(sin_out, cos_out, size);
+      return;
+    }
+    const uint32_t q = period_;
+    uint32_t m = index_;
+    if (cos_out != nullptr)
+    {
+      for (size_t i = 0; i < size; i++)
+      {
+        sin_out[i] = sin_[m];
+        cos_out[i] = cos_[m];
+        m = m + 1 == q ? 0 : m + 1;
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < size; i++)
+      {
+        sin_out[i] = sin_[m];
+        m = m + 1 == q ? 0 : m + 1;
+      }
+    }
+    index_ = m;
+  }
+
+private:
+  // The first convergent p / q of inc / 2^32 that rounds back to inc,
+  // with q <= max_period.
+  static bool FindPeriod(uint32_t inc, uint32_t& p, uint32_t& q)
+  {
+    uint64_t num = inc, den = 1ull << 32;
+    uint64_t h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+    while (den != 0)
+    {
+      const uint64_t a = num / den;
+      const uint64_t h = a * h1 + h0, k = a * k1 + k0;
+      if (k > max_period)
+        return false;
+      if (((h << 32) + k / 2) / k == inc)
+      {
+        p = (uint32_t)h;
+        q = (uint32_t)k;
+        return true;
+      }
+      const uint64_t r = num - a * den;
+      num = den;
+      den = r;
+      h0 = h1;
+      h1 = h;
+      k0 = k1;
+      k1 = k;
+    }
+    return false;
+  }
+
+  // p^-1 mod q, p and q coprime.
+  static uint32_t Inverse(uint32_t p, uint32_t q)
+  {
+    int64_t r0 = q, r1 = p % q, t0 = 0, t1 = 1;
+    while (r1 != 0)
+    {
+      const int64_t a = r0 / r1;
+      const int64_t r = r0 - a * r1, t = t0 - a * t1;
+      r0 = r1;
+      r1 = r;
+      t0 = t1;
+      t1 = t;
+    }
+    return (uint32_t)(t0 < 0 ? t0 + q : t0);
+  }
+
+  // sin and cos of 2 pi p m / q, rotated in double from m = 0; the
+  // error after max_period steps stays far below float resolution.
+  void Build(uint32_t p, uint32_t q)
+  {
+    const double w = 6.283185307179586 * (double)p / (double)q;
+    const double rc = cos(w), rs = sin(w);
+    double c = 1.0, s = 0.0;
+    for (uint32_t m = 0; m < q; m++)
+    {
+      sin_[m] = (float)s;
+      cos_[m] = (float)c;
+      const double ns = s * rc + c * rs;
+      c = c * rc - s * rs;
+      s = ns;
+    }
+    period_ = q;
+  }
+
+  // Where the carrier is, in Nco phase units, whichever source runs.
+  uint32_t Phase() const
+  {
+    if (period_ == 0)
+      return nco_.GetPhase();
+    const uint64_t turns_q = ((uint64_t)index_ * LastP()) % period_;
+    return (uint32_t)((turns_q << 32) / period_);
+  }
+
+  // The p of the current table, from its increment.
+  uint32_t LastP() const
+  {
+    return (uint32_t)(((uint64_t)nco_.GetPhaseInc() * period_ + (1ull << 31)) >> 32);
+  }
+
+  Nco nco_;
+  uint32_t period_;
+  uint32_t index_;
+  float sin_[max_period];
+  float cos_[max_period];
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include "modulator_pipeline.h"
+#include "periodic_carrier.h"
+#include <cstddef>
+#include <cstdint>
+
+// AM modulation and steering of an array in one pass, for BeamSteer in
+// place of a FractionalDelayBank: it takes the filtered baseband instead
+// of the modulated signal.
+//
+// Delaying an AM signal by t delays its envelope by t and turns its
+// carrier back by 2 pi fc t. So rather than a fractional-delay FIR over
+// the modulated waveform, each element gets:
+//   - the baseband through a delay line with linear interpolation,
+//     which is plenty for a signal band-limited to a tenth of fs, and
+//   - the carrier's sin and cos (PeriodicCarrier), run once per block
+//     for all elements, rotated by the element's phase: two
+//     multiply-adds.
+// The result is exact at any carrier frequency and does not need
+// 192 kHz. Every element costs the same few operations per sample,
+// rather than the FIR taps on top of a modulator, which is what lets
+// one core drive 16 or more elements.
+//
+// Same interface as FractionalDelayBank for BeamSteer::Process():
+// SetOutput() sets where an element's delay and gain go by the end of
+// the next ProcessBlock(), and the block glides there. The carrier
+// rotation does too, as a straight line between the two phasors, so a
+// large angle step dips the element's level for a moment. Before each
+// block, SetCarrier() passes the pipeline's carrier: frequency, level,
+// depth and the array frame sync.
+//
+// The AM chain only, with a fixed carrier level. The band-pass ahead of
+// the codec is left out: an NCO carrier times a band-limited baseband
+// is band-limited already, and running it per element would cost more
+// than everything above.
+template <size_t elements, size_t max_delay = 64, size_t max_block = 256, Nco::Backend backend = Nco::Backend::LUT>
+class PhaseSteer
+{
+public:
+  static_assert(max_block <= kPipelineMaxBlock, "max_block: at most kPipelineMaxBlock");
+
+  void Init(float fs)
+  {
+    osc_.Init(fs, backend);
+    for (float& x : ring_)
+      x = 0.0f;
+    write_ptr_ = 0;
+    level_ = 0.0f;
+    depth_ = 0.0f;
+    for (size_t e = 0; e < elements; e++)
+    {
+      delay_[e] = target_delay_[e] = 0.0f;
+      gain_[e] = target_gain_[e] = 1.0f;
+      rot_s_[e] = 1.0f;
+      rot_c_[e] = 0.0f;
+    }
+  }
+
+  static constexpr float GetMinDelay() { return 0.0f; }
+  static constexpr size_t GetOutputs() { return elements; }
+
+  // delay in samples, clipped to [0, max_delay].
+  inline void SetOutput(size_t element, float delay, float gain)
+  {
+    delay = delay < 0.0f ? 0.0f : delay;
+    delay = delay > (float)max_delay ? (float)max_delay : delay;
+    target_delay_[element] = delay;
+    target_gain_[element] = gain;
+  }
+
+  // Audio callback, before ProcessBlock(): the block's carrier.
+  inline void SetCarrier(const StereoBlock& b)
+  {
+    const ModulatorCoeffs& p = b.p;
+    if (p.carrier_phase_inc != osc_.GetPhaseInc())
+      osc_.SetPhaseInc(p.carrier_phase_inc);
+    if (b.has_frame)
+      osc_.SetFrame(b.frame);
+    level_ = p.carrier_level;
+    depth_ = p.depth;
+  }
+
+  // Stores the baseband in[size], then writes every element's
+  // out[e][size]. in may be one of the outputs.
+  void ProcessBlock(const float* in, float* const* out, size_t size)
+  {
+    size = size < max_block ? size : max_block;
+    if (size == 0)
+      return;
+    for (size_t i = 0; i < size; i++)
+    {
+      write_ptr_ = (write_ptr_ - 1) & kMask;
+      ring_[write_ptr_] = in[i];
+      ring_[write_ptr_ + kSize] = in[i];
+    }
+    osc_.ProcessBlock(sin_, cos_, size);
+
+    // Block sample i sits size - 1 - i frames behind the newest.
+    const float* newest = &ring_[write_ptr_];
+    const float step = 1.0f / (float)size;
+    const uint32_t inc = osc_.GetPhaseInc();
+    for (size_t e = 0; e < elements; e++)
+    {
+      // sin(wt - phi) = sin(wt) cos(phi) - cos(wt) sin(phi), phi the
+      // carrier's turn over the delay in raw phase units: 16.16 fixed
+      // point samples times the increment, exact mod 2^32.
+      const uint32_t phi = (uint32_t)(((uint64_t)(target_delay_[e] * 65536.0f) * inc) >> 16);
+      const float s1 = Nco::Cos(phi);
+      const float c1 = -Nco::Sin(phi);
+      const float s0 = rot_s_[e];
+      const float c0 = rot_c_[e];
+      const float ds = (s1 - s0) * step;
+      const float dc = (c1 - c0) * step;
+      const float g0 = gain_[e];
+      const float dg = (target_gain_[e] - g0) * step;
+      const float d0 = delay_[e];
+      const float d1 = target_delay_[e];
+      float* dst = out[e];
+      if (d0 == d1)
+      {
+        const size_t k = (size_t)d0;
+        const float f = d0 - (float)k;
+        for (size_t i = 0; i < size; i++)
+        {
+          const float* x = newest + (size - 1 - i) + k;
+          const float t = (float)(i + 1);
+          const float env = (g0 + dg * t) * (level_ + depth_ * (x[0] + f * (x[1] - x[0])));
+          dst[i] = env * (sin_[i] * (s0 + ds * t) + cos_[i] * (c0 + dc * t));
+        }
+      }
+      else
+      {
+        const float dd = (d1 - d0) * step;
+        for (size_t i = 0; i < size; i++)
+        {
+          const float t = (float)(i + 1);
+          const float d = d0 + dd * t;
+          const size_t k = (size_t)d;
+          const float f = d - (float)k;
+          const float* x = newest + (size - 1 - i) + k;
+          const float env = (g0 + dg * t) * (level_ + depth_ * (x[0] + f * (x[1] - x[0])));
+          dst[i] = env * (sin_[i] * (s0 + ds * t) + cos_[i] * (c0 + dc * t));
+        }
+      }
+      delay_[e] = d1;
+      gain_[e] = target_gain_[e];
+      rot_s_[e] = s1;
+      rot_c_[e] = c1;
+    }
+  }
+
+private:
+  static constexpr size_t RoundUp(size_t n)
+  {
+    size_t p = 1;
+    while (p < n)
+      p <<= 1;
+    return p;
+  }
+
+  static constexpr size_t kSize = RoundUp(max_block + max_delay + 2);
+  static constexpr size_t kMask = kSize - 1;
+
+  PeriodicCarrier<> osc_;
+  size_t write_ptr_;
+  float level_;
+  float depth_;
+  float delay_[elements];
+  float target_delay_[elements];
+  float gain_[elements];
+  float target_gain_[elements];
+  float rot_s_[elements]; // carrier rotation at the end of the last block
+  float rot_c_[elements];
+  float sin_[max_block];
+  float cos_[max_block];
+  float ring_[2 * kSize];
+};
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Finds the transducers' resonance and keeps the carrier on it.
+//
+// The response comes back on a codec input: a microphone in front of
+// the array, or the drive current across a sense resistor. At each test
+// frequency, two Goertzel filters over the same window measure the
+// carrier in what the callback sends out and in what comes back. Their
+// ratio is the analog path's gain at that frequency, free of the
+// digital chain's own tilt (the band-pass falls 0.5 dB from 39 to
+// 41 kHz). A Goertzel costs two multiply-adds per sample per channel,
+// and only while a window is open.
+//
+// Poll() from loop() runs the search and says where the carrier goes,
+// which is ModulatorParams::SetCarrierFreq()'s job:
+//   - sweep: lo_hz to hi_hz in step_hz steps, then the peak (parabolic
+//     between steps) becomes the carrier.
+//   - track: every track_interval_ms, probe the carrier and
+//     track_step_hz either side, and move to the parabola's vertex
+//     (at most one step) to follow the resonance as it drifts with
+//     temperature.
+// Each probe lets the carrier settle for settle_ms (pipeline and codec
+// delay, the transducer's ring-up) and then measures window_ms. Windows
+// and probe spacing are longer than the baseband's lowest frequencies,
+// so the modulation sidebands fall outside the Goertzel bin.
+//
+// The callback and loop() hand the window over with one flag, as in
+// SpectralMonitor: loop() sets the coefficient only while the callback
+// is not reading it.
+class ResonanceTracker
+{
+public:
+  struct Config
+  {
+    float lo_hz = 39000.0f;
+    float hi_hz = 41000.0f;
+    float step_hz = 50.0f;
+    float track_step_hz = 25.0f;
+    uint32_t settle_ms = 20;
+    uint32_t window_ms = 20;
+    uint32_t track_interval_ms = 10000;
+  };
+
+  enum class Event
+  {
+    kNone,
+    kProbe,  // Carrier() moved to a test frequency
+    kLocked, // Carrier() is a new resonance estimate
+  };
+
+  static constexpr size_t kMaxSteps = 128;
+
+  void Init(float sample_rate) { Init(sample_rate, Config()); }
+
+  void Init(float sample_rate, const Config& config)
+  {
+    sample_rate_ = sample_rate;
+    config_ = config;
+    size_t steps = (size_t)((config_.hi_hz - config_.lo_hz) / config_.step_hz) + 1;
+    steps_ = steps < kMaxSteps ? steps : kMaxSteps;
+    window_ = (uint32_t)(sample_rate_ * (float)config_.window_ms / 1000.0f);
+    resonance_hz_ = 0.5f * (config_.lo_hz + config_.hi_hz);
+    gain_db_ = -200.0f;
+    sweeps_ = 0;
+    resweep_ = false;
+    state_ = kIdle;
+    Start(kSweep, 0);
+  }
+
+  // Audio callback: drive is the block going to the transducers,
+  // response what the codec input brings back.
+  inline void Capture(const float* drive, const float* response, size_t size)
+  {
+    if (state_ != kMeasuring)
+      return;
+    const float coeff = coeff_;
+    float d1 = d1_, d2 = d2_, r1 = r1_, r2 = r2_;
+    uint32_t left = left_;
+    const size_t n = left < size ? left : size;
+    for (size_t i = 0; i < n; i++)
+    {
+      const float d = drive[i] + coeff * d1 - d2;
+      d2 = d1;
+      d1 = d;
+      const float r = response[i] + coeff * r1 - r2;
+      r2 = r1;
+      r1 = r;
+    }
+    d1_ = d1;
+    d2_ = d2;
+    r1_ = r1;
+    r2_ = r2;
+    left_ = left - n;
+    if (left_ == 0)
+    {
+      std::atomic_signal_fence(std::memory_order_release);
+      state_ = kDone;
+    }
+  }
+
+  // From loop(): advances the search. Returns whether, and why, the
+  // carrier should move to Carrier().
+  Event Poll(uint32_t now_ms)
+  {
+    if (state_ == kIdle && resweep_)
+    {
+      resweep_ = false;
+      Start(kSweep, 0);
+    }
+    if (state_ == kIdle)
+    {
+      if (phase_ == kWait)
+      {
+        if (now_ms - started_ms_ < config_.track_interval_ms)
+          return Event::kNone;
+        Start(kTrack, 0);
+      }
+      if (!probing_)
+      {
+        probing_ = true;
+        started_ms_ = now_ms;
+        carrier_hz_ = ProbeHz();
+        return Event::kProbe;
+      }
+      if (now_ms - started_ms_ < config_.settle_ms)
+        return Event::kNone;
+      Arm(carrier_hz_);
+      return Event::kNone;
+    }
+    if (state_ != kDone)
+      return Event::kNone;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    db_[probe_] = Db(Power(r1_, r2_), Power(d1_, d2_));
+    state_ = kIdle;
+    probing_ = false;
+    probe_++;
+    if (probe_ < (phase_ == kSweep ? steps_ : 3))
+      return Event::kNone;
+    if (phase_ == kSweep)
+      FinishSweep();
+    else
+      FinishTrack();
+    Start(kWait, 0);
+    started_ms_ = now_ms;
+    carrier_hz_ = resonance_hz_;
+    return Event::kLocked;
+  }
+
+  // From loop(): starts over with a full sweep, once the window being
+  // measured, if any, is in.
+  void Resweep() { resweep_ = true; }
+
+  // Where the carrier should be now.
+  float Carrier() const { return carrier_hz_; }
+  // Latest resonance estimate and the response gain there, dB.
+  float Resonance() const { return resonance_hz_; }
+  float GainDb() const { return gain_db_; }
+  // Sweeps completed; 0 until the first estimate.
+  uint32_t Sweeps() const { return sweeps_; }
+
+  // From loop(): one line. Integers only: newlib-nano has no %f.
+  void Print(::Print& out) const
+  {
+    char hz[12], gain[12];
+    Tenths(hz, sizeof(hz), resonance_hz_);
+    Tenths(gain, sizeof(gain), gain_db_);
+    char line[80];
+    snprintf(line, sizeof(line), "resonance %s Hz, response %s dB\r\n", hz, gain);
+    out.print(line);
+  }
+
+private:
+  enum State : uint32_t
+  {
+    kIdle,
+    kMeasuring,
+    kDone,
+  };
+  enum Phase
+  {
+    kSweep,
+    kTrack,
+    kWait,
+  };
+
+  void Start(Phase phase, size_t probe)
+  {
+    phase_ = phase;
+    probe_ = probe;
+    probing_ = false;
+  }
+
+  float ProbeHz() const
+  {
+    if (phase_ == kSweep)
+      return config_.lo_hz + config_.step_hz * (float)probe_;
+    return resonance_hz_ + config_.track_step_hz * ((float)probe_ - 1.0f);
+  }
+
+  // Only while the callback is not reading: state_ is kIdle.
+  void Arm(float hz)
+  {
+    coeff_ = 2.0f * cosf(2.0f * 3.14159265358979323846f * hz / sample_rate_);
+    d1_ = d2_ = r1_ = r2_ = 0.0f;
+    left_ = window_;
+    std::atomic_signal_fence(std::memory_order_release);
+    state_ = kMeasuring;
+  }
+
+  float Power(float s1, float s2) const { return s1 * s1 + s2 * s2 - coeff_ * s1 * s2; }
+
+  static float Db(float response, float drive)
+  {
+    const float ratio = response / (drive > 1e-20f ? drive : 1e-20f);
+    return 10.0f * log10f(ratio > 1e-20f ? ratio : 1e-20f);
+  }
+
+  // Vertex of the parabola through three equally spaced points, in
+  // steps from the middle one, within +/-1.
+  static float Vertex(float a, float b, float c)
+  {
+    const float curve = a - 2.0f * b + c;
+    const float x = curve < 0.0f ? 0.5f * (a - c) / curve : 0.0f;
+    return x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x);
+  }
+
+  void FinishSweep()
+  {
+    size_t peak = 0;
+    for (size_t i = 1; i < steps_; i++)
+      if (db_[i] > db_[peak])
+        peak = i;
+    float offset = 0.0f;
+    if (peak > 0 && peak + 1 < steps_)
+      offset = Vertex(db_[peak - 1], db_[peak], db_[peak + 1]);
+    resonance_hz_ = config_.lo_hz + config_.step_hz * ((float)peak + offset);
+    gain_db_ = db_[peak];
+    sweeps_++;
+  }
+
+  void FinishTrack()
+  {
+    const float offset = Vertex(db_[0], db_[1], db_[2]);
+    float hz = resonance_hz_ + config_.track_step_hz * offset;
+    hz = hz < config_.lo_hz ? config_.lo_hz : (hz > config_.hi_hz ? config_.hi_hz : hz);
+    resonance_hz_ = hz;
+    gain_db_ = db_[1];
+  }
+
+  static void Tenths(char* buf, size_t size, float v)
+  {
+    v = v > 999999.0f ? 999999.0f : (v < -999999.0f ? -999999.0f : v);
+    const long t = lroundf(v * 10.0f);
+    const unsigned long a = (unsigned long)(t < 0 ? -t : t) % 10000000;
+    snprintf(buf, size, "%s%lu.%lu", t < 0 ? "-" : "", a / 10, a % 10);
+  }
+
+  float sample_rate_ = 96000.0f;
+  Config config_;
+  size_t steps_ = 0;
+  uint32_t window_ = 0;
+  Phase phase_ = kSweep;
+  size_t probe_ = 0;
+  bool probing_ = false;
+  bool resweep_ = false; // Resweep() asked, from loop() like Poll()
+  uint32_t started_ms_ = 0;
+  float carrier_hz_ = 39500.0f;
+  float resonance_hz_ = 39500.0f;
+  float gain_db_ = -200.0f;
+  uint32_t sweeps_ = 0;
+  float db_[kMaxSteps];
+
+  // Goertzel state: loop() writes while kIdle, the callback while
+  // kMeasuring, loop() reads once kDone.
+  volatile uint32_t state_ = kIdle;
+  float coeff_ = 0.0f;
+  float d1_ = 0.0f, d2_ = 0.0f, r1_ = 0.0f, r2_ = 0.0f;
+  uint32_t left_ = 0;
+};
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Carrier purity and sideband levels of the output, measured on the
+// board: patch an output to a codec input and the monitor analyses what
+// actually reaches the DAC.
+//
+// The audio callback hands it the loopback input with Capture(), which
+// costs a compare per block except while a frame is being filled, then a
+// copy of the block. Trigger() from loop() asks for the next fft_size
+// samples; once they are in, Poll() from loop() windows them (4-term
+// Blackman-Harris, sidelobes at -92 dB), runs RealFft over them
+// (arm_rfft_fast_f32 with USE_ARM_DSP) and reduces the spectrum to a
+// Result. Capture() owns the frame while filling it and loop() while
+// analysing it, handed over with one flag each way, so nothing is
+// masked and the ISR never waits. At one frame a second this is cheap
+// enough to leave in a production build.
+//
+// Each level is the power summed over a band of bins, so a tone between
+// bins reads the same as one on a bin:
+// - carrier: the main lobe around the strongest bin near the nominal
+//   carrier, as dBFS (a full-scale sine is 0 dBFS), and its frequency
+//   interpolated between bins.
+// - sidebands: carrier +/- sideband_hz without the carrier lobe, dBc.
+// - THD: carrier harmonics 2 to kHarmonics, dBc. The digital pipeline
+//   aliases them into the band below fs / 2 before the DAC, so they are
+//   looked for where they fold to; one that lands inside the sideband
+//   band cannot be told from the modulation and is left out.
+// - leakage: everything else from kMinHz to fs / 2 outside the carrier
+//   and sideband band, dBc: noise, spurs and audible leakage.
+//
+// carrier_dbfs is the level at the codec input, after its analog gain;
+// the levels relative to the carrier do not depend on that.
+template <size_t fft_size = 4096>
+class SpectralMonitor
+{
+public:
+  static_assert(fft_size >= 256 && (fft_size & (fft_size - 1)) == 0, "fft_size: a power of two from 256");
+
+  static constexpr size_t kHarmonics = 5;
+  static constexpr size_t kLobeBins = 4; // Blackman-Harris main lobe half-width
+  static constexpr size_t kSearchBins = 16;
+  static constexpr float kMinHz = 20.0f;
+
+  struct Result
+  {
+    uint32_t frames;     // analysed since Init()
+    float carrier_hz;    // measured
+    float carrier_dbfs;
+    float sideband_dbc;  // both sidebands together
+    float thd_dbc;
+    float leakage_dbc;
+  };
+
+  void Init(float sample_rate)
+  {
+    sample_rate_ = sample_rate;
+    fft_.Init();
+    // Periodic 4-term Blackman-Harris.
+    float sum2 = 0.0f;
+    for (size_t i = 0; i < fft_size; i++)
+    {
+      const float x = 2.0f * 3.14159265358979323846f * (float)i / (float)fft_size;
+      const float w = 0.35875f - 0.48829f * cosf(x) + 0.14128f * cosf(2.0f * x) - 0.01168f * cosf(3.0f * x);
+      window_[i] = w;
+      sum2 += w * w;
+    }
+    // Bin power to mean square: one side of the spectrum holds half of
+    // a tone's power, and the window takes sum2 / fft_size of it.
+    power_scale_ = 2.0f / ((float)fft_size * sum2);
+    result_ = {};
+    fill_ = 0;
+    state_ = kIdle;
+  }
+
+  // From loop(): starts filling a frame at the next block, unless one
+  // is already being filled or waits for Poll().
+  void Trigger()
+  {
+    if (state_ != kIdle)
+      return;
+    fill_ = 0;
+    std::atomic_signal_fence(std::memory_order_release);
+    state_ = kFilling;
+  }
+
+  // Audio callback: takes x[0], x[stride], ... while a frame is wanted,
+  // each through to_float() to 1.0 full scale.
+  template <typename T, typename Convert>
+  inline void Capture(const T* x, size_t stride, size_t size, Convert to_float)
+  {
+    if (state_ != kFilling)
+      return;
+    size_t n = fft_size - fill_;
+    n = n < size ? n : size;
+    float* dst = &frame_[fill_];
+    for (size_t i = 0; i < n; i++)
+      dst[i] = to_float(x[i * stride]);
+    fill_ += n;
+    if (fill_ == fft_size)
+    {
+      std::atomic_signal_fence(std::memory_order_release);
+      state_ = kFull;
+    }
+  }
+
+  inline void Capture(const float* x, size_t size)
+  {
+    Capture(x, 1, size, [](float s) { return s; });
+  }
+
+  // From loop(): analyses a completed frame, looking for the carrier
+  // near carrier_hz with its sidebands out to sideband_hz either side.
+  // Returns true when Last() has a new result.
+  bool Poll(float carrier_hz, float sideband_hz)
+  {
+    if (state_ != kFull)
+      return false;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    Analyze(carrier_hz, sideband_hz);
+    state_ = kIdle;
+    return true;
+  }
+
+  const Result& Last() const { return result_; }
+
+  // From loop(): one line of Last(). Integers only: newlib-nano has no %f.
+  void Print(::Print& out) const
+  {
+    char hz[12], carrier[12], sideband[12], thd[12], leakage[12];
+    Tenths(hz, sizeof(hz), result_.carrier_hz);
+    Tenths(carrier, sizeof(carrier), result_.carrier_dbfs);
+    Tenths(sideband, sizeof(sideband), result_.sideband_dbc);
+    Tenths(thd, sizeof(thd), result_.thd_dbc);
+    Tenths(leakage, sizeof(leakage), result_.leakage_dbc);
+    char line[160];
+    snprintf(line,
+             sizeof(line),
+             "spectrum %lu: carrier %s Hz %s dBFS, sidebands %s dBc, thd %s dBc, leakage %s dBc\r\n",
+             (unsigned long)result_.frames,
+             hz,
+             carrier,
+             sideband,
+             thd,
+             leakage);
+    out.print(line);
+  }
+
+private:
+  enum State : uint32_t
+  {
+    kIdle,
+    kFilling,
+    kFull,
+  };
+
+  static constexpr size_t kBins = fft_size / 2;
+
+  static float Db(float ratio) { return 10.0f * log10f(ratio > 1e-20f ? ratio : 1e-20f); }
+
+  static void Tenths(char* buf, size_t size, float v)
+  {
+    v = v > 999999.0f ? 999999.0f : (v < -999999.0f ? -999999.0f : v);
+    const long t = lroundf(v * 10.0f);
+    const unsigned long a = (unsigned long)(t < 0 ? -t : t) % 10000000;
+    snprintf(buf, size, "%s%lu.%lu", t < 0 ? "-" : "", a / 10, a % 10);
+  }
+
+  // Power of bins [lo, hi], clipped to the spectrum.
+  float Band(long lo, long hi) const
+  {
+    lo = lo < 1 ? 1 : lo;
+    hi = hi > (long)kBins ? (long)kBins : hi;
+    float sum = 0.0f;
+    for (long k = lo; k <= hi; k++)
+      sum += power_[k];
+    return sum;
+  }
+
+  void Analyze(float carrier_hz, float sideband_hz)
+  {
+    for (size_t i = 0; i < fft_size; i++)
+      frame_[i] *= window_[i];
+    fft_.Forward(frame_, spectrum_);
+    // Packed layout: {X[0].re, X[n/2].re, X[1].re, X[1].im, ...}.
+    power_[0] = 0.0f;
+    power_[kBins] = spectrum_[1] * spectrum_[1] * power_scale_;
+    for (size_t k = 1; k < kBins; k++)
+    {
+      const float re = spectrum_[2 * k];
+      const float im = spectrum_[2 * k + 1];
+      power_[k] = (re * re + im * im) * power_scale_;
+    }
+
+    const float hz_per_bin = sample_rate_ / (float)fft_size;
+    const long lobe = (long)kLobeBins;
+    const long first = lobe + 1;
+    const long last = (long)kBins - lobe - 1;
+    long nominal = lroundf(carrier_hz / hz_per_bin);
+    nominal = nominal < first ? first : (nominal > last ? last : nominal);
+    long peak = nominal;
+    for (long k = nominal - (long)kSearchBins; k <= nominal + (long)kSearchBins; k++)
+      if (k >= first && k <= last && power_[k] > power_[peak])
+        peak = k;
+
+    // Parabola through the log powers around the peak.
+    const float a = Db(power_[peak - 1]);
+    const float b = Db(power_[peak]);
+    const float c = Db(power_[peak + 1]);
+    const float curve = a - 2.0f * b + c;
+    const float offset = curve < 0.0f ? 0.5f * (a - c) / curve : 0.0f;
+    const float fc = ((float)peak + offset) * hz_per_bin;
+
+    // Each band summed on its own: differences of the totals would lose
+    // the small ones to float rounding next to the carrier.
+    const float carrier = Band(peak - lobe, peak + lobe);
+    const long sb = lroundf(sideband_hz / hz_per_bin);
+    const long band_lo = peak - sb - lobe;
+    const long band_hi = peak + sb + lobe;
+    const float sidebands = Band(band_lo, peak - lobe - 1) + Band(peak + lobe + 1, band_hi);
+
+    long harmonic_bin[kHarmonics + 1];
+    float harmonics = 0.0f;
+    for (size_t h = 2; h <= kHarmonics; h++)
+    {
+      float f = fmodf(fc * (float)h, sample_rate_);
+      f = f > 0.5f * sample_rate_ ? sample_rate_ - f : f;
+      const long k = lroundf(f / hz_per_bin);
+      const bool in_band = k + lobe >= band_lo && k - lobe <= band_hi;
+      harmonic_bin[h] = in_band ? -1 : k;
+      if (!in_band)
+        harmonics += Band(k - lobe, k + lobe);
+    }
+
+    const long min_bin = lroundf(kMinHz / hz_per_bin);
+    float outside = 0.0f;
+    for (long k = min_bin > 1 ? min_bin : 1; k <= (long)kBins; k++)
+    {
+      if (k >= band_lo && k <= band_hi)
+        continue;
+      bool harmonic = false;
+      for (size_t h = 2; h <= kHarmonics; h++)
+        harmonic = harmonic || (harmonic_bin[h] >= 0 && k >= harmonic_bin[h] - lobe && k <= harmonic_bin[h] + lobe);
+      if (!harmonic)
+        outside += power_[k];
+    }
+    const float ref = carrier > 1e-20f ? carrier : 1e-20f;
+
+    result_.frames++;
+    result_.carrier_hz = fc;
+    result_.carrier_dbfs = Db(carrier / 0.5f); // a full-scale sine's mean square
+    result_.sideband_dbc = Db(sidebands / ref);
+    result_.thd_dbc = Db(harmonics / ref);
+    result_.leakage_dbc = Db(outside / ref);
+  }
+
+  float sample_rate_ = 96000.0f;
+  float power_scale_ = 0.0f;
+  volatile uint32_t state_ = kIdle;
+  volatile size_t fill_ = 0;
+  Result result_ = {};
+  float window_[fft_size];
+  float frame_[fft_size];
+  float spectrum_[fft_size];
+  float power_[kBins + 1];
+  daisysp::RealFft<fft_size> fft_;
+};
@@ -0,0 +1,477 @@
+#pragma once
+
+#include <DaisyDuino.h>
+#include "modulator_params.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Binary command link over USB serial, for tuning the modulator in the
+// field without a rebuild (scripts/tune.py is the host side).
+//
+// Each frame on the wire is a payload followed by its CRC-16/CCITT
+// (poly 0x1021, init 0xFFFF, little-endian), COBS-encoded and ended by
+// a 0x00, so a receiver that joins mid-stream or loses bytes is back in
+// step at the next zero. The payload is
+//   op, tag, body...
+// and every request gets one reply with op | 0x80, the same tag and a
+// Status byte ahead of its body:
+//   kPing                        -> version, kNumParams
+//   kSet      id, f32 value      -> (nothing)
+//   kGet      id                 -> f32 value
+//   kMeters                      -> Meters
+//   kStream   u16 period_ms      -> (nothing); 0 stops
+//   kCalibrate what              -> (nothing), once it has started
+// While streaming, Poll() also sends kMeterFrame frames with Meters as
+// the body and a running count as the tag, so the host sees a gap when
+// one was skipped. All values are little-endian; floats are IEEE single.
+//
+// Everything runs in Poll(), from loop() or a TaskRunner task: parsing,
+// replies and meter frames. kSet calls the ModulatorParams setter, and
+// the control callback's Update() publishes it to the audio callback
+// through the ParamBlock, as for any other setter in loop(); the audio
+// path never sees the link. A reply or meter frame goes out only if
+// the CDC transmit queue has room for all of it, so loop() never waits
+// on USB: a reply that does not fit is dropped (the host retries on
+// its tag), a meter frame is counted in Skipped(). A meter frame is
+// 50 bytes or so, 5 kB/s at 100 Hz.
+class TuningLink
+{
+public:
+  static constexpr uint8_t kVersion = 1;
+  static constexpr uint32_t kMinPeriodMs = 10;
+
+  enum Op : uint8_t
+  {
+    kPing = 0x00,
+    kSet = 0x01,
+    kGet = 0x02,
+    kMeters = 0x03,
+    kStream = 0x04,
+    kCalibrate = 0x05,
+    kReply = 0x80,
+    kMeterFrame = kReply | kMeters,
+  };
+
+  enum Status : uint8_t
+  {
+    kOk = 0,
+    kUnknownOp = 1,
+    kBadLength = 2,
+    kBadParam = 3,
+    kOutOfRange = 4,
+    kUnsupported = 5, // not in this build
+  };
+
+  // Parameter ids: the settings of ModulatorParams, then zone z's
+  // carrier at kZoneCarrierFreq + z and its gain at kZoneGain + z.
+  enum Param : uint8_t
+  {
+    kCarrierFreq = 0,
+    kCarrierLevel,
+    kCarrierFloor,
+    kCarrierRelease,
+    kModDepth,
+    kBasebandGain,
+    kCompThreshold,
+    kCompRatio,
+    kCompAttack,
+    kCompRelease,
+    kLimitIndex,
+    kLimitRelease,
+    kModulation, // a ModulationMode, as a whole number
+    kNumParams,
+    kZoneCarrierFreq = 0x10,
+    kZoneGain = 0x20,
+  };
+
+  // What a meter frame carries. Fields a build does not have read 0.
+  struct Meters
+  {
+    uint32_t time_ms;
+    float load_avg; // callback load, 1.0 the whole block period
+    float load_max; // since the last kCalibrate kResetMeters
+    uint32_t overruns;
+    uint32_t dropped_blocks;
+    float carrier_hz; // where the carrier is now, e.g. after auto-tune
+    float mod_peak;   // MODULATOR_MOD_METER: last window's index
+    float mod_rms;
+    uint32_t mod_over; // over-modulated blocks since boot
+    float drive_gain[2];
+  };
+  static_assert(sizeof(Meters) == 44, "Meters goes on the wire as laid out");
+
+  // kCalibrate's argument; the callback given to Init() carries it out.
+  enum Calibration : uint8_t
+  {
+    kResetMeters = 0, // load max, overruns, held peaks
+    kResweep = 1,     // MODULATOR_AUTOTUNE: a fresh resonance sweep
+  };
+
+  typedef void (*MeterFn)(Meters& m);
+  typedef Status (*CalibrateFn)(uint8_t what);
+
+  void Init(ModulatorParams& params, MeterFn meters, CalibrateFn calibrate)
+  {
+    params_ = &params;
+    meters_ = meters;
+    calibrate_ = calibrate;
+    rx_len_ = 0;
+    overflow_ = false;
+    period_ms_ = 0;
+    next_ms_ = 0;
+    frame_tag_ = 0;
+    errors_ = 0;
+    skipped_ = 0;
+  }
+
+  // From loop(): handles every complete request port has, and sends a
+  // meter frame when one is due.
+  void Poll(Stream& port, uint32_t now_ms)
+  {
+    while (port.available() > 0)
+    {
+      const uint8_t c = (uint8_t)port.read();
+      if (c != 0)
+      {
+        if (rx_len_ < sizeof(rx_))
+          rx_[rx_len_++] = c;
+        else
+          overflow_ = true;
+        continue;
+      }
+      if (overflow_)
+        errors_++;
+      else if (rx_len_ > 0)
+        Frame(port, now_ms);
+      rx_len_ = 0;
+      overflow_ = false;
+    }
+
+    if (period_ms_ != 0 && (int32_t)(now_ms - next_ms_) >= 0)
+    {
+      next_ms_ += period_ms_;
+      // Behind by more than a period: pick up from now, not in a burst.
+      if ((int32_t)(now_ms - next_ms_) >= 0)
+        next_ms_ = now_ms + period_ms_;
+      Meters m = ReadMeters(now_ms);
+      if (!Send(port, kMeterFrame, frame_tag_++, &m, sizeof(m)))
+        skipped_++;
+    }
+  }
+
+  // Frames dropped for a bad CRC, bad COBS or overlength since Init().
+  uint32_t Errors() const { return errors_; }
+  // Meter frames the port had no room for since Init().
+  uint32_t Skipped() const { return skipped_; }
+
+private:
+  static constexpr size_t kMaxPayload = 2 + 1 + sizeof(Meters);
+  // COBS adds a byte per 254 and the start; then the CRC and the zero.
+  static constexpr size_t kMaxWire = kMaxPayload + 2 + 2 + 1;
+
+  static uint16_t Crc16(const uint8_t* data, size_t size)
+  {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++)
+    {
+      crc ^= (uint16_t)(data[i] << 8);
+      for (int b = 0; b < 8; b++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+  }
+
+  // In place: the decoded bytes never overtake the encoded ones.
+  // Returns the decoded size, 0 for a malformed frame.
+  static size_t CobsDecode(uint8_t* buf, size_t size)
+  {
+    size_t r = 0;
+    size_t w = 0;
+    while (r < size)
+    {
+      const uint8_t code = buf[r++];
+      if (code == 0 || r + code - 1 > size)
+        return 0;
+      for (uint8_t i = 1; i < code; i++)
+        buf[w++] = buf[r++];
+      if (code != 0xFF && r < size)
+        buf[w++] = 0;
+    }
+    return w;
+  }
+
+  static size_t CobsEncode(const uint8_t* in, size_t size, uint8_t* out)
+  {
+    size_t code_at = 0;
+    size_t w = 1;
+    uint8_t code = 1;
+    for (size_t r = 0; r < size; r++)
+    {
+      if (in[r] != 0)
+      {
+        out[w++] = in[r];
+        code++;
+      }
+      if (in[r] == 0 || code == 0xFF)
+      {
+        out[code_at] = code;
+        code_at = w++;
+        code = 1;
+      }
+    }
+    out[code_at] = code;
+    return w;
+  }
+
+  void Frame(Stream& port, uint32_t now_ms)
+  {
+    const size_t size = CobsDecode(rx_, rx_len_);
+    if (size < 4)
+    {
+      errors_++;
+      return;
+    }
+    const uint16_t crc = (uint16_t)(rx_[size - 2] | (rx_[size - 1] << 8));
+    if (crc != Crc16(rx_, size - 2))
+    {
+      errors_++;
+      return;
+    }
+    const uint8_t op = rx_[0];
+    const uint8_t tag = rx_[1];
+    const uint8_t* body = rx_ + 2;
+    const size_t len = size - 4;
+
+    uint8_t reply[sizeof(Meters) + 1];
+    size_t reply_len = 1;
+    Status status = kOk;
+    switch (op)
+    {
+      case kPing:
+        reply[1] = kVersion;
+        reply[2] = kNumParams;
+        reply_len = 3;
+        break;
+      case kSet:
+        if (len != 5)
+        {
+          status = kBadLength;
+          break;
+        }
+        {
+          float value;
+          memcpy(&value, body + 1, sizeof(value));
+          status = Set(body[0], value);
+        }
+        break;
+      case kGet:
+        if (len != 1)
+        {
+          status = kBadLength;
+          break;
+        }
+        {
+          float value = 0.0f;
+          status = Get(body[0], value);
+          if (status == kOk)
+          {
+            memcpy(reply + 1, &value, sizeof(value));
+            reply_len += sizeof(value);
+          }
+        }
+        break;
+      case kMeters:
+        {
+          const Meters m = ReadMeters(now_ms);
+          memcpy(reply + 1, &m, sizeof(m));
+          reply_len += sizeof(m);
+        }
+        break;
+      case kStream:
+        if (len != 2)
+        {
+          status = kBadLength;
+          break;
+        }
+        {
+          const uint32_t period = (uint32_t)(body[0] | (body[1] << 8));
+          if (period != 0 && period < kMinPeriodMs)
+          {
+            status = kOutOfRange;
+            break;
+          }
+          period_ms_ = period;
+          next_ms_ = now_ms;
+        }
+        break;
+      case kCalibrate:
+        if (len != 1)
+          status = kBadLength;
+        else
+          status = calibrate_ != nullptr ? calibrate_(body[0]) : kUnsupported;
+        break;
+      default:
+        status = kUnknownOp;
+        break;
+    }
+    reply[0] = status;
+    Send(port, (uint8_t)(op | kReply), tag, reply, reply_len);
+  }
+
+  Meters ReadMeters(uint32_t now_ms) const
+  {
+    Meters m = {};
+    if (meters_ != nullptr)
+      meters_(m);
+    m.time_ms = now_ms;
+    return m;
+  }
+
+  Status Set(uint8_t id, float v)
+  {
+    if (!std::isfinite(v))
+      return kOutOfRange;
+    ModulatorParams& p = *params_;
+    if (id >= kZoneCarrierFreq && id < kZoneCarrierFreq + kMaxZones)
+    {
+      if (!InRange(v, 1000.0f, 0.5f * p.SampleRate()))
+        return kOutOfRange;
+      p.SetZoneCarrierFreq(id - kZoneCarrierFreq, v);
+      return kOk;
+    }
+    if (id >= kZoneGain && id < kZoneGain + kMaxZones)
+    {
+      if (!InRange(v, 0.0f, 1.0f))
+        return kOutOfRange;
+      p.SetZoneGain(id - kZoneGain, v);
+      return kOk;
+    }
+    switch (id)
+    {
+      case kCarrierFreq:
+        if (!InRange(v, 1000.0f, 0.5f * p.SampleRate()))
+          return kOutOfRange;
+        p.SetCarrierFreq(v);
+        return kOk;
+      case kCarrierLevel:
+        if (!InRange(v, 0.0f, 1.0f))
+          return kOutOfRange;
+        p.SetCarrierLevel(v);
+        return kOk;
+      case kCarrierFloor:
+        if (!InRange(v, 0.0f, 1.0f))
+          return kOutOfRange;
+        p.SetCarrierFloor(v);
+        return kOk;
+      case kModDepth:
+        if (!InRange(v, 0.0f, 4.0f))
+          return kOutOfRange;
+        p.SetModDepth(v);
+        return kOk;
+      case kBasebandGain:
+        if (!InRange(v, 0.0f, 16.0f))
+          return kOutOfRange;
+        p.SetBasebandGain(v);
+        return kOk;
+      case kCompThreshold:
+        if (!InRange(v, 0.0001f, 1.0f))
+          return kOutOfRange;
+        p.SetCompThreshold(v);
+        return kOk;
+      case kCompRatio:
+        if (!InRange(v, 1.0f, 100.0f))
+          return kOutOfRange;
+        p.SetCompRatio(v);
+        return kOk;
+      case kLimitIndex:
+        if (!InRange(v, 0.01f, 2.0f))
+          return kOutOfRange;
+        p.SetLimitIndex(v);
+        return kOk;
+      case kModulation:
+        if (!InRange(v, 0.0f, (float)(kModulationModes - 1)) || v != floorf(v))
+          return kOutOfRange;
+        p.SetModulation((ModulationMode)(uint8_t)v);
+        return kOk;
+      default:
+        break;
+    }
+    // Time constants: Update() divides by them.
+    if (!InRange(v, 0.0001f, 10.0f))
+      return kOutOfRange;
+    switch (id)
+    {
+      case kCarrierRelease: p.SetCarrierRelease(v); return kOk;
+      case kCompAttack: p.SetCompAttack(v); return kOk;
+      case kCompRelease: p.SetCompRelease(v); return kOk;
+      case kLimitRelease: p.SetLimitRelease(v); return kOk;
+      default: return kBadParam;
+    }
+  }
+
+  Status Get(uint8_t id, float& v) const
+  {
+    const ModulatorParams& p = *params_;
+    if (id >= kZoneCarrierFreq && id < kZoneCarrierFreq + kMaxZones)
+      v = p.ZoneCarrierFreq(id - kZoneCarrierFreq);
+    else if (id >= kZoneGain && id < kZoneGain + kMaxZones)
+      v = p.ZoneGain(id - kZoneGain);
+    else
+    {
+      switch (id)
+      {
+        case kCarrierFreq: v = p.CarrierFreq(); break;
+        case kCarrierLevel: v = p.CarrierLevel(); break;
+        case kCarrierFloor: v = p.CarrierFloor(); break;
+        case kCarrierRelease: v = p.CarrierRelease(); break;
+        case kModDepth: v = p.ModDepth(); break;
+        case kBasebandGain: v = p.BasebandGain(); break;
+        case kCompThreshold: v = p.CompThreshold(); break;
+        case kCompRatio: v = p.CompRatio(); break;
+        case kCompAttack: v = p.CompAttack(); break;
+        case kCompRelease: v = p.CompRelease(); break;
+        case kLimitIndex: v = p.LimitIndex(); break;
+        case kLimitRelease: v = p.LimitRelease(); break;
+        case kModulation: v = (float)(uint8_t)p.Modulation(); break;
+        default: return kBadParam;
+      }
+    }
+    return kOk;
+  }
+
+  static bool InRange(float v, float lo, float hi) { return v >= lo && v <= hi; }
+
+  // All or nothing: a frame cut short would cost the host the next one
+  // too, so it goes only if the port has room for all of it.
+  bool Send(Stream& port, uint8_t op, uint8_t tag, const void* body, size_t size)
+  {
+    uint8_t payload[kMaxPayload + 2];
+    payload[0] = op;
+    payload[1] = tag;
+    memcpy(payload + 2, body, size);
+    const uint16_t crc = Crc16(payload, size + 2);
+    payload[size + 2] = (uint8_t)crc;
+    payload[size + 3] = (uint8_t)(crc >> 8);
+    uint8_t wire[kMaxWire];
+    size_t n = CobsEncode(payload, size + 4, wire);
+    wire[n++] = 0;
+    if (port.availableForWrite() < (int)n)
+      return false;
+    port.write(wire, n);
+    return true;
+  }
+
+  ModulatorParams* params_ = nullptr;
+  MeterFn meters_ = nullptr;
+  CalibrateFn calibrate_ = nullptr;
+  uint8_t rx_[32];
+  size_t rx_len_ = 0;
+  bool overflow_ = false; // the frame coming in is too long for rx_
+  uint32_t period_ms_ = 0; // meter frames, 0 off
+  uint32_t next_ms_ = 0;
+  uint8_t frame_tag_ = 0;
+  uint32_t errors_ = 0;
+  uint32_t skipped_ = 0;
+};
@@ -4,7 +4,8 @@
 #define NUM_CONTROLS 4
 
 DaisyHardware hw;
-ModalVoice modal;
+// Four voices, so notes ring on under the next ones.
+ModalVoiceBank<4> modal;
 
 uint8_t buttons[16];
 // Use bottom row to set major scale
@@ -32,14 +33,15 @@ void AudioCallback(float **in, float **out, size_t size) {
 
   for (size_t i = 0; i < 16; i++) {
     if (hw.KeyboardRisingEdge(i) && i != 8 && i != 11 && i != 15) {
-      modal.Trig();
       float m = (12.0f * octaves) + 24.0f + scale[i];
-      modal.SetFreq(mtof(m));
+      modal.Strike(mtof(m));
     }
   }
 
+  modal.ProcessBlock(out[0], size);
   for (size_t i = 0; i < size; i++) {
-    out[0][i] = out[1][i] = modal.Process();
+    out[0][i] *= 0.5f;
+    out[1][i] = out[0][i];
   }
 }
 
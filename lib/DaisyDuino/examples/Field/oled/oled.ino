@@ -8,9 +8,12 @@
 
 DaisyHardware hw;
 
-// the magic incantation
-U8G2_SSD1309_128X64_NONAME2_F_4W_SW_SPI
-    oled(U8G2_R0, /* clock=*/8, /* data=*/10, /* cs=*/7, /* dc=*/9);
+// U8g2 draws into its buffer only: never begin() it, the pins are the
+// display driver's, which pushes the changed pages by SPI DMA.
+U8G2_SSD1309_128X64_NONAME2_F_4W_SW_SPI oled(U8G2_R0, U8X8_PIN_NONE,
+                                             U8X8_PIN_NONE, U8X8_PIN_NONE,
+                                             U8X8_PIN_NONE);
+OledSsd1309 display;
 
 int x, y;
 int xvel, yvel;
@@ -26,7 +29,10 @@ void setup() {
   oled.setFont(u8g2_font_inb16_mf);
   oled.setFontDirection(0);
   oled.setFontMode(1);
-  oled.begin();
+
+  OledSsd1309::Config config;
+  config.reset_pin = NUM_DIGITAL_PINS;
+  display.Init(config);
 }
 
 void loop() {
@@ -49,6 +55,6 @@ void loop() {
     pos %= 10;
   }
 
-  oled.sendBuffer();
+  display.Update(oled.getBufferPtr());
   delay(5);
 }
\ No newline at end of file
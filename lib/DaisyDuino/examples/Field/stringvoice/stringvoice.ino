@@ -4,7 +4,8 @@
 #define NUM_CONTROLS 4
 
 DaisyHardware hw;
-StringVoice str;
+// Four voices, so notes ring on under the next ones.
+StringVoiceBank<4> str;
 
 uint8_t buttons[16];
 // Use bottom row to set major scale
@@ -37,14 +38,15 @@ void AudioCallback(float **in, float **out, size_t size) {
 
   for (size_t i = 0; i < 16; i++) {
     if (hw.KeyboardRisingEdge(i) && i != 8 && i != 11 && i != 15) {
-      str.Trig();
       float m = (12.0f * octaves) + 24.0f + scale[i];
-      str.SetFreq(mtof(m));
+      str.Strike(mtof(m));
     }
   }
 
+  str.ProcessBlock(out[0], size);
   for (size_t i = 0; i < size; i++) {
-    out[0][i] = out[1][i] = str.Process();
+    out[0][i] *= 0.5f;
+    out[1][i] = out[0][i];
   }
 }
 
@@ -38,39 +38,16 @@ struct ConditionalUpdate
 
 ConditionalUpdate condUpdates[4];
 
-struct Filter{
-    Svf filt;
-    float amp;
-    
-    void Init(float samplerate, float freq)
-    {
-        filt.Init(samplerate);
-        filt.SetRes(1);
-        filt.SetDrive(.002);
-        filt.SetFreq(freq);
-        amp = .5f;
-    }
-    
-    float Process(float in)
-    {
-        filt.Process(in);
-        return filt.Peak() * amp;
-    }
-};
-
-Filter filters[16];
+// all 16 peak filters, run together on each block
+FilterBank<16> filters;
 uint8_t controls[4];
 
 static void AudioCallback(float **in, float **out, size_t size)
 {
+    filters.ProcessBlock(in[0], out[0], size);
     for (size_t i = 0; i < size; i++)
     {
-        float sig = 0.f;
-        for (int j = 0; j < 16; j++)
-        {
-            sig += filters[j].Process(in[0][i]);
-        }
-        sig *= .06;
+        float sig = out[0][i] * .06f;
   
         out[0][i] = out[1][i] = out[2][i] = out[3][i] = sig;
     }
@@ -98,9 +75,14 @@ void InitFreqs()
 
 void InitFilters(float samplerate)
 {
+    filters.Init(samplerate);
+    filters.SetOutput(FilterBank<16>::Output::PEAK);
+    filters.SetDrive(.002);
     for (int i = 0; i < 16; i++)
     {
-        filters[i].Init(samplerate, freqs[i]);
+        filters.SetRes(i, 1);
+        filters.SetFreq(i, freqs[i]);
+        filters.SetGain(i, .5f);
     }
 }
 
@@ -171,7 +153,7 @@ void UpdateControls()
         float val = patch.controls[i].Value();
         if (condUpdates[i].Process(val))
         {
-            filters[i + bank * 4].amp = val;
+            filters.SetGain(i + bank * 4, val);
         }
     }
 
@@ -22,17 +22,13 @@ DaisyHardware patch;
 U8X8_SSD1309_128X64_NONAME0_4W_SW_SPI oled(/* clock=*/8, /* data=*/10,
                                            /* cs=*/7, /* dc=*/9, /* reset=*/30);
 
-float amp[4];
+// four inputs onto one output, each gain ramped across the block
+Mixer<4, 1> mixer;
 
 static void AudioCallback(float **in, float **out, size_t size) {
-  for (size_t i = 0; i < size; i++) {
-    float sig = 0.f;
-    for (size_t chn = 0; chn < 4; chn++) {
-      sig += amp[chn] * in[chn][i];
-    }
-
-    sig *= .25;
-    out[0][i] = out[1][i] = out[2][i] = out[3][i] = sig;
+  mixer.ProcessBlock(in, out, size);
+  for (size_t chn = 1; chn < 4; chn++) {
+    memcpy(out[chn], out[0], size * sizeof(float));
   }
 }
 
@@ -42,7 +38,7 @@ void setup() {
   patch = DAISY.init(DAISY_PATCH, AUDIO_SR_48K);
   samplerate = DAISY.get_samplerate();
 
-  amp[0] = amp[1] = amp[2] = amp[3] = 0.f;
+  mixer.Init(samplerate);
 
   oled.setFont(u8x8_font_chroma48medium8_r);
   oled.begin();
@@ -52,8 +48,10 @@ void setup() {
 }
 
 void loop() {
-  amp[0] = (1023 - analogRead(PIN_PATCH_CTRL_1)) / 1023.f;
-  amp[1] = (1023 - analogRead(PIN_PATCH_CTRL_2)) / 1023.f;
-  amp[2] = (1023 - analogRead(PIN_PATCH_CTRL_3)) / 1023.f;
-  amp[3] = (1023 - analogRead(PIN_PATCH_CTRL_4)) / 1023.f;
+  // attenuated by 1/4
+  const int pins[4] = {PIN_PATCH_CTRL_1, PIN_PATCH_CTRL_2, PIN_PATCH_CTRL_3,
+                       PIN_PATCH_CTRL_4};
+  for (size_t chn = 0; chn < 4; chn++) {
+    mixer.SetGain(0, chn, .25f * (1023 - analogRead(pins[chn])) / 1023.f);
+  }
 }
@@ -16,20 +16,23 @@ DaisyHardware patch;
 
 float samplerate;
 
-DelayLine<float, MAX_DELAY> DSY_SDRAM_BSS delMems[3];
+// One buffer for all three lines, so their writes share cache lines
+// rather than evicting each other.
+InterleavedDelay<float, MAX_DELAY, 3> DSY_SDRAM_BSS delMem;
 
 struct del {
-  DelayLine<float, MAX_DELAY> *del;
+  size_t line;
   float currentDelay;
   float delayTarget;
 
-  float Process(float feedback, float in) {
+  // Returns the delayed sample; the caller writes the next input.
+  float Process(float feedback, float in, float &write) {
     // set delay times
     fonepole(currentDelay, delayTarget, .0002f);
-    del->SetDelay(currentDelay);
+    delMem.SetDelay(line, currentDelay);
 
-    float read = del->Read();
-    del->Write((feedback * read) + in);
+    float read = delMem.Read(line);
+    write = (feedback * read) + in;
 
     return read;
   }
@@ -48,14 +51,16 @@ static void AudioCallback(float **in, float **out, size_t size) {
   for (size_t i = 0; i < size; i++) {
     float mix = 0;
     float fdrywet = (float)drywet / 100.f;
+    float write[3];
 
     // update delayline with feedback
     for (int d = 0; d < 3; d++) {
-      float sig = delays[d].Process(feedback, in[0][i]);
+      float sig = delays[d].Process(feedback, in[0][i], write[d]);
       mix += sig;
       // out[d][i] = sig * fdrywet + (1.f - fdrywet) * in[0][i];
       out[d][i] = sig;
     }
+    delMem.Write(write);
 
     // apply drywet and attenuate
     mix = fdrywet * mix * .3f + (1.0f - fdrywet) * in[0][i];
@@ -64,10 +69,9 @@ static void AudioCallback(float **in, float **out, size_t size) {
 }
 
 void InitDelays() {
+  delMem.Init();
   for (int i = 0; i < 3; i++) {
-    // Init delays
-    delMems[i].Init();
-    delays[i].del = &delMems[i];
+    delays[i].line = i;
   }
 }
 
@@ -22,37 +22,19 @@ struct ConditionalUpdate {
 
 ConditionalUpdate condUpdates[4];
 
-struct Filter {
-  Svf filt;
-  float amp;
-
-  void Init(float samplerate, float freq) {
-    filt.Init(samplerate);
-    filt.SetRes(1);
-    filt.SetDrive(.002);
-    filt.SetFreq(freq);
-    amp = .5f;
-  }
-
-  float Process(float in) {
-    filt.Process(in);
-    return filt.Peak() * amp;
-  }
-};
-
-Filter filters[8];
+// all 8 peak filters, run together on each block
+FilterBank<8> filters;
 bool passthru;
 void UpdateControls();
 
 static void AudioCallback(float **in, float **out, size_t size) {
   UpdateControls();
 
+  if (!passthru) {
+    filters.ProcessBlock(in[0], out[0], size);
+  }
   for (size_t i = 0; i < size; i++) {
-    float sig = 0.f;
-    for (int j = 0; j < 8; j++) {
-      sig += filters[j].Process(in[0][i]);
-    }
-    sig *= .06;
+    float sig = out[0][i] * .06f;
 
     if (!passthru) {
       out[0][i] = out[1][i] = sig;
@@ -75,8 +57,13 @@ void InitFreqs() {
 }
 
 void InitFilters(float samplerate) {
+  filters.Init(samplerate);
+  filters.SetOutput(FilterBank<8>::Output::PEAK);
+  filters.SetDrive(.002);
   for (int i = 0; i < 8; i++) {
-    filters[i].Init(samplerate, freqs[i]);
+    filters.SetRes(i, 1);
+    filters.SetFreq(i, freqs[i]);
+    filters.SetGain(i, .5f);
   }
 }
 
@@ -119,19 +106,19 @@ void UpdateControls() {
   for (int i = 0; i < 4; i++) {
     float val = petal.controls[i + 2].Process();
     if (condUpdates[i].Process(val)) {
-      filters[i + bank * 4].amp = val;
+      filters.SetGain(i + bank * 4, val);
     }
   }
 }
 
 void UpdateLeds() {
   for (int i = 0; i < 4; i++) {
-    petal.SetRingLed(i, filters[i].amp,
-                     (bank == 0) * filters[i].amp, filters[i].amp);
+    petal.SetRingLed(i, filters.GetGain(i),
+                     (bank == 0) * filters.GetGain(i), filters.GetGain(i));
   }
   for (int i = 4; i < 8; i++) {
-    petal.SetRingLed(i, filters[i].amp,
-                     (bank == 1) * filters[i].amp, filters[i].amp);
+    petal.SetRingLed(i, filters.GetGain(i),
+                     (bank == 1) * filters.GetGain(i), filters.GetGain(i));
   }
 
   petal.SetFootswitchLed(0, !passthru);
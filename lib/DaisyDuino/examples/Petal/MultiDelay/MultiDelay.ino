@@ -10,27 +10,25 @@
 
 #define MAX_DELAY static_cast<size_t>(48000 * 1.f)
 
+static const size_t kChunkSize = 32;
+
 static DaisyHardware petal;
 
-DelayLine<float, MAX_DELAY> DSY_SDRAM_BSS delMems[3];
+SmoothDelay<MAX_DELAY> DSY_SDRAM_BSS delMems[3];
 
 struct del
 {
-    DelayLine<float, MAX_DELAY> *del;
-    float                        currentDelay;
-    float                        delayTarget;
-    float                        feedback;
+    SmoothDelay<MAX_DELAY> *del;
+    float                   currentDelay;
+    float                   delayTarget;
+    float                   feedback;
 
-    float Process(float in)
+    // Once per chunk: the knob glide, then the delay ramps across the chunk
+    void Update(size_t size)
     {
-        //set delay times
-        fonepole(currentDelay, delayTarget, .0002f);
+        fonepole(currentDelay, delayTarget, fminf(.0002f * size, 1.f));
         del->SetDelay(currentDelay);
-
-        float read = del->Read();
-        del->Write((feedback * read) + in);
-
-        return read;
+        del->SetFeedback(feedback);
     }
 };
 
@@ -47,21 +45,31 @@ static void AudioCallback(float **in, float **out, size_t size)
 {
     ProcessControls();
 
-    for(size_t i = 0; i < size; i++)
-    {
-        float mix     = 0;
-        float fdrywet = passThruOn ? 0.f : (float)drywet / 100.f;
+    float fdrywet = passThruOn ? 0.f : (float)drywet / 100.f;
 
-        //update delayline with feedback
+    float wet[kChunkSize];
+    for(size_t pos = 0; pos < size; pos += kChunkSize)
+    {
+        size_t n = size - pos < kChunkSize ? size - pos : kChunkSize;
+        float  mix[kChunkSize] = {};
         for(int d = 0; d < 3; d++)
         {
-            float sig = delays[d].Process(in[0][i]);
-            mix += sig;
+            delays[d].Update(n);
+            delays[d].del->ProcessBlock(in[0] + pos, wet, n);
+            for(size_t i = 0; i < n; i++)
+            {
+                mix[i] += wet[i];
+            }
         }
 
         //apply drywet and attenuate
-        mix       = fdrywet * mix * .3f + (1.0f - fdrywet) * in[0][i];
-        out[0][i] = out[1][i] = mix;
+        for(size_t i = 0; i < n; i++)
+        {
+            float dry       = in[0][pos + i];
+            float sig       = fdrywet * mix[i] * .3f + (1.0f - fdrywet) * dry;
+            out[0][pos + i] = sig;
+            out[1][pos + i] = sig;
+        }
     }
 }
 
@@ -70,7 +78,7 @@ void InitDelays(float samplerate)
     for(int i = 0; i < 3; i++)
     {
         //Init delays
-        delMems[i].Init();
+        delMems[i].Init(samplerate);
         delays[i].del = &delMems[i];
         //3 delay times
         params[i].Init(petal.controls[i * 2],
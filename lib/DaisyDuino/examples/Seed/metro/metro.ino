@@ -13,19 +13,25 @@ static Metro clock;
 static Oscillator osc_sine;
 
 void MyCallback(float **in, float **out, size_t size) {
-  float sine, freq;
-  uint8_t tic;
-  for (size_t i = 0; i < size; i++) {
-    tic = clock.Process();
-    if (tic) {
-      freq = rand() % 500;
-      osc_sine.SetFreq(freq);
+  // The ticks in this block, as sample offsets. The oscillator renders
+  // the runs between them and changes note exactly on the tick sample.
+  size_t ticks[4];
+  size_t num_ticks = clock.ProcessBlock(size, ticks, 4);
+  num_ticks = num_ticks < 4 ? num_ticks : 4;
+
+  size_t start = 0;
+  for (size_t t = 0; t <= num_ticks; t++) {
+    size_t end = t < num_ticks ? ticks[t] : size;
+    osc_sine.ProcessBlock(out[0] + start, end - start);
+    if (t < num_ticks) {
+      osc_sine.SetFreq(rand() % 500);
     }
+    start = end;
+  }
 
-    sine = osc_sine.Process();
-
-    for (size_t chn = 0; chn < num_channels; chn++) {
-      out[chn][i] = sine;
+  for (size_t chn = 1; chn < num_channels; chn++) {
+    for (size_t i = 0; i < size; i++) {
+      out[chn][i] = out[0][i];
     }
   }
 }
@@ -0,0 +1,64 @@
+// Title: sample_player
+// Description: Plays a WAV file from QSPI flash on four voices
+// Hardware: Daisy Seed
+//
+// Flash a 16-bit mono or stereo WAV to the QSPI first, e.g. with the
+// Daisy bootloader: dfu-util -a 0 -s 0x90000000:leave -D kick.wav
+// A metro retriggers it on the next voice each half second, at one of
+// four pitches. Nothing is loaded into RAM: each voice reads the flash
+// through its own 4 kB cache in AXI SRAM.
+
+#include "DaisyDuino.h"
+
+static const size_t kVoices = 4;
+static const float kSpeeds[kVoices] = {1.0f, 0.75f, 1.5f, 0.5f};
+
+DaisyHardware hw;
+
+static QspiFlash qspi;
+static SamplePlayer voices[kVoices];
+static int16_t DSY_MEM_AXI caches[kVoices][SamplePlayer::kCacheSamples];
+static SamplePlayer::Sample sample;
+static Metro tick;
+static size_t next_voice;
+
+void MyCallback(float **in, float **out, size_t size) {
+  float l[kVoices][48], r[kVoices][48];
+  for (size_t pos = 0; pos < size; pos += 48) {
+    const size_t n = size - pos < 48 ? size - pos : 48;
+    for (size_t v = 0; v < kVoices; v++)
+      voices[v].ProcessBlock(l[v], r[v], n);
+    for (size_t i = 0; i < n; i++) {
+      if (tick.Process()) {
+        voices[next_voice].SetSpeed(kSpeeds[next_voice]);
+        voices[next_voice].Play(sample);
+        next_voice = (next_voice + 1) % kVoices;
+      }
+      float mix_l = 0.f, mix_r = 0.f;
+      for (size_t v = 0; v < kVoices; v++) {
+        mix_l += l[v][i];
+        mix_r += r[v][i];
+      }
+      out[0][pos + i] = mix_l * 0.5f;
+      out[1][pos + i] = mix_r * 0.5f;
+    }
+  }
+}
+
+void setup() {
+  float sample_rate;
+  hw = DAISY.init(DAISY_SEED, AUDIO_SR_48K);
+  sample_rate = DAISY.get_samplerate();
+
+  if (qspi.Init() != QspiFlash::Result::OK ||
+      !SamplePlayer::ParseWav(qspi.GetData(0), QspiFlash::kSize, sample))
+    return; // no flash, or no WAV in it: stay silent
+
+  for (size_t v = 0; v < kVoices; v++)
+    voices[v].Init(sample_rate, caches[v]);
+  tick.Init(2.0f, sample_rate);
+
+  DAISY.begin(MyCallback);
+}
+
+void loop() {}
@@ -56,17 +56,36 @@ dsy_gpio ak4556_reset_pin;
 AudioClass DAISY;
 TwoWire daisy_i2c2;
 
+// Starts the SDRAM; dsy_sdram_init_finish() completes it once the rest
+// of init() has run through its power-up wait.
 void AudioClass::ConfigureSdram() {
   dsy_gpio_pin *pin_group;
   sdram_handle.state = DSY_SDRAM_STATE_ENABLE;
   pin_group = sdram_handle.pin_config;
   pin_group[DSY_SDRAM_PIN_SDNWE] = dsy_pin(DSY_GPIOH, 5);
 
-  dsy_sdram_init(&sdram_handle);
+  dsy_sdram_init_start(&sdram_handle);
 }
 
 DaisyHardware AudioClass::init(DaisyDuinoDevice device,
-                               DaisyDuinoSampleRate sr) {
+                               DaisyDuinoSampleRate sr, bool flush_denormals) {
+  return Init(device, sr, flush_denormals, nullptr);
+}
+
+DaisyHardware AudioClass::init(DaisyDuinoDevice device,
+                               DaisyDuinoSampleRate sr,
+                               const System::Config& sys,
+                               bool flush_denormals) {
+  return Init(device, sr, flush_denormals, &sys);
+}
+
+uint32_t AudioClass::SysClkFreq() { return System::GetSysClkFreq(); }
+
+DaisyHardware AudioClass::Init(DaisyDuinoDevice device,
+                               DaisyDuinoSampleRate sr, bool flush_denormals,
+                               const System::Config* sys) {
+  SetFlushDenormals(flush_denormals);
+
   // convert DaisyDuino sr to SaiHandle sr to ensure bwd compatibility
   SaiHandle::Config::SampleRate sample_rate;
 
@@ -101,6 +120,20 @@ DaisyHardware AudioClass::init(DaisyDuinoDevice device,
   dsy_dma_init(); // may interfere with core STM32 Arduino stuff...
   dsy_mpu_init();
 
+  // After the MPU, so the DMA buffers are non-cacheable before the
+  // D-cache comes on; before SDRAM and SAI, which run off the PLLs.
+  if (sys != nullptr) {
+    System system;
+    system.InitClocks(*sys);
+  }
+  sdram_handle.timing =
+      sys != nullptr && sys->sdram_timing == System::Config::SdramTiming::DATASHEET
+          ? DSY_SDRAM_TIMING_DATASHEET
+          : DSY_SDRAM_TIMING_LEGACY;
+
+  // The SDRAM's power-up wait overlaps the SAI and codec setup below.
+  ConfigureSdram();
+
   // Set up audio
   // SAI1
   SaiHandle::Config sai_config[2];
@@ -125,10 +158,8 @@ DaisyHardware AudioClass::init(DaisyDuinoDevice device,
       sai_config[0].a_dir         = SaiHandle::Config::Direction::RECEIVE;
       sai_config[0].b_dir         = SaiHandle::Config::Direction::TRANSMIT;
 
-      Wm8731::Config codec_cfg;
-      codec_cfg.Defaults();
-      Wm8731 codec;
-      codec.Init(codec_cfg, &daisy_i2c2);
+      wm8731_.Init(wm8731_cfg_, &daisy_i2c2);
+      codec_ = Codec::WM8731;
     }
     break;
 
@@ -158,8 +189,8 @@ DaisyHardware AudioClass::init(DaisyDuinoDevice device,
   sai_handle[0].Init(sai_config[0]);
 
   if(_device == DAISY_PATCH_SM){
-    Pcm3060 codec;
-    codec.Init(&daisy_i2c2);
+    pcm3060_.Init(pcm3060_cfg_, &daisy_i2c2);
+    codec_ = Codec::PCM3060;
   }
 
   // SAI2
@@ -198,13 +229,16 @@ DaisyHardware AudioClass::init(DaisyDuinoDevice device,
     audio_handle.Init(cfg, sai_handle[0]);
   }
 
-  ConfigureSdram();
+  dsy_sdram_init_finish();
 
   DaisyHardware hw;
   callback_rate_ = AudioSampleRate() / AudioBlockSize();
 
   hw.Init(callback_rate_, device);
 
+  // Last, over whatever the HAL, the codec's Wire and the board init left.
+  ApplyIrqPriorities();
+
   return hw;
 }
 
@@ -213,9 +247,10 @@ void AudioClass::begin(AudioHandle::AudioCallback cb) {
 }
 
 void AudioClass::begin(AudioHandle::InterleavingAudioCallback cb) {
-  if (_device == DAISY_PATCH) {
-    end();
-  }
+  audio_handle.Start(cb);
+}
+
+void AudioClass::begin(AudioHandle::NativeAudioCallback cb) {
   audio_handle.Start(cb);
 }
 
@@ -223,7 +258,10 @@ void AudioClass::end() { audio_handle.Stop(); }
 
 float AudioClass::get_samplerate() { return audio_handle.GetSampleRate(); }
 
-float AudioClass::get_callbackrate() { return callback_rate_; }
+float AudioClass::get_callbackrate() {
+  // The block size can change under a running stream.
+  return AudioSampleRate() / AudioBlockSize();
+}
 
 float AudioClass::get_blocksize() { return audio_handle.GetConfig().blocksize; }
 
@@ -233,12 +271,10 @@ void AudioClass::StartAudio(AudioHandle::InterleavingAudioCallback cb) {
 
 void AudioClass::StartAudio(AudioHandle::AudioCallback cb) { begin(cb); }
 
+void AudioClass::StartAudio(AudioHandle::NativeAudioCallback cb) { begin(cb); }
+
 void AudioClass::ChangeAudioCallback(
     AudioHandle::InterleavingAudioCallback cb) {
-  if (_device == DAISY_PATCH) {
-    end();
-  }
-
   audio_handle.ChangeCallback(cb);
 }
 
@@ -246,8 +282,31 @@ void AudioClass::ChangeAudioCallback(AudioHandle::AudioCallback cb) {
   audio_handle.ChangeCallback(cb);
 }
 
+void AudioClass::ChangeAudioCallback(AudioHandle::NativeAudioCallback cb) {
+  audio_handle.ChangeCallback(cb);
+}
+
+bool AudioClass::SwapAudioCallback(AudioHandle::InterleavingAudioCallback cb,
+                                   size_t warm_blocks, bool shadow_input) {
+  return audio_handle.SwapCallback(cb, warm_blocks, shadow_input) ==
+         AudioHandle::Result::OK;
+}
+
+bool AudioClass::SwapAudioCallback(AudioHandle::AudioCallback cb,
+                                   size_t warm_blocks, bool shadow_input) {
+  return audio_handle.SwapCallback(cb, warm_blocks, shadow_input) ==
+         AudioHandle::Result::OK;
+}
+
+bool AudioClass::AudioCallbackSwapping() { return audio_handle.IsSwapping(); }
+
 void AudioClass::StopAudio() { end(); }
 
+void AudioClass::SetControlCallback(AudioHandle::ControlCallback cb,
+                                    size_t every_blocks) {
+  audio_handle.SetControlCallback(cb, every_blocks);
+}
+
 void AudioClass::SetAudioSampleRate(SaiHandle::Config::SampleRate samplerate) {
   audio_handle.SetSampleRate(samplerate);
   callback_rate_ = AudioSampleRate() / AudioBlockSize();
@@ -256,15 +315,128 @@ void AudioClass::SetAudioSampleRate(SaiHandle::Config::SampleRate samplerate) {
 float AudioClass::AudioSampleRate() { return get_samplerate(); }
 
 void AudioClass::SetAudioBlockSize(size_t blocksize) {
-  audio_handle.SetBlockSize(blocksize);
+  audio_handle.ChangeBlockSize(blocksize);
   callback_rate_ = AudioSampleRate() / AudioBlockSize();
 }
 
+void AudioClass::SetAdaptiveBlockSize(bool enable, size_t min_size,
+                                      size_t max_size) {
+  audio_handle.SetAdaptiveBlockSize(enable, min_size, max_size);
+}
+
 size_t AudioClass::AudioBlockSize() { return get_blocksize(); }
 
+void AudioClass::SetAudioChannels(uint8_t input_mask, uint8_t output_mask,
+                                  bool mono_fanout) {
+  audio_handle.SetChannelMask(input_mask, output_mask, mono_fanout);
+}
+
+void AudioClass::SetAudioDither(AudioHandle::Dither dither) {
+  audio_handle.SetDither(dither);
+}
+
+void AudioClass::SetMdmaOffload(bool enable) {
+  audio_handle.SetMdmaOffload(enable);
+}
+
+void AudioClass::SetAudioDmaSegments(size_t segments) {
+  audio_handle.SetDmaSegments(segments);
+}
+
+size_t AudioClass::AudioDroppedBlocks() {
+  return audio_handle.GetDroppedBlocks();
+}
+
+void AudioClass::SetAudioClock(SaiHandle::Config::Clock clock) {
+  audio_handle.SetClock(clock);
+}
+
+bool AudioClass::SetAudioSlots(SaiHandle::Config::Slots slots) {
+  const bool ok = audio_handle.SetSlots(slots) == AudioHandle::Result::OK;
+  callback_rate_ = AudioSampleRate() / AudioBlockSize();
+  return ok;
+}
+
+bool AudioClass::SetAudioSampleFormat(SaiHandle::Config::BitDepth depth,
+                                      bool packed16) {
+  const bool ok =
+      audio_handle.SetSampleFormat(depth, packed16) == AudioHandle::Result::OK;
+  callback_rate_ = AudioSampleRate() / AudioBlockSize();
+  return ok;
+}
+
+size_t AudioClass::AudioChannels() { return audio_handle.GetChannels(); }
+
+uint32_t AudioClass::AudioFrameCount() { return audio_handle.GetFrameCount(); }
+
+uint32_t AudioClass::AudioBlockFrame() { return audio_handle.GetBlockFrame(); }
+
+uint64_t AudioClass::AudioFrameCount64() { return audio_handle.GetFrameCount64(); }
+
+SaiHandle::BlockTime AudioClass::AudioBlockTime() { return audio_handle.GetBlockTime(); }
+
+uint64_t AudioClass::AudioFrameAt(uint32_t cycles) { return audio_handle.GetFrameAt(cycles); }
+
 float AudioClass::AudioCallbackRate() { return get_callbackrate(); }
 
+float AudioClass::AudioLatency() {
+  return (float)audio_handle.GetConfig().dma_segments * AudioBlockSize() /
+         AudioSampleRate();
+}
+
+bool AudioClass::SetCodecConfig(const Pcm3060::Config& cfg) {
+  pcm3060_cfg_ = cfg;
+  if (codec_ != Codec::PCM3060)
+    return true;
+  return pcm3060_.SetFilters(cfg) == Pcm3060::Result::OK;
+}
+
+bool AudioClass::SetCodecConfig(const Wm8731::Config& cfg) {
+  wm8731_cfg_ = cfg;
+  if (codec_ != Codec::WM8731)
+    return true;
+  return wm8731_.SetFilters(cfg) == Wm8731::Result::OK;
+}
+
+SaiHandle::Config::BitDepth AudioClass::AudioBitDepth() {
+  return audio_handle.GetBitDepth();
+}
+
+CpuLoadMeter& AudioClass::CpuLoad() { return audio_handle.GetCpuLoadMeter(); }
+
+WcetTracker& AudioClass::Wcet() { return audio_handle.GetWcetTracker(); }
+
+QualityGovernor& AudioClass::Governor() { return audio_handle.GetQualityGovernor(); }
+
+void AudioClass::SetIdleSleep(bool enable, bool gate_clocks) {
+  idle_.Init(enable && gate_clocks);
+  idle_sleep_ = enable;
+}
+
+void AudioClass::Idle() {
+  if (idle_sleep_)
+    idle_.Sleep();
+}
+
+uint32_t AudioClass::IdleWakeCycles() { return idle_.GetWakeCyclesMax(); }
+
+void AudioClass::SetFlushDenormals(bool enable) {
+  // On exception entry FPSCR is loaded from FPDSCR, so this is the
+  // rounding/flush mode the audio and control interrupts run with.
+  const uint32_t bits = FPU_FPDSCR_FZ_Msk | FPU_FPDSCR_DN_Msk;
+  if (enable)
+    FPU->FPDSCR |= bits;
+  else
+    FPU->FPDSCR &= ~bits;
+}
+
+uint32_t AudioClass::BootTimeUs() { return audio_handle.GetFirstBlockUs(); }
+
 AudioClass::BoardVersion AudioClass::BoardVersionCheck(){
+#if defined(DSY_SEED_BOARD_VERSION)
+    return DSY_SEED_BOARD_VERSION == 1 ? BoardVersion::DAISY_SEED_1_1
+                                       : BoardVersion::DAISY_SEED;
+#else
     /** Version Checks:
      *  * Fall through is Daisy Seed v1 (aka Daisy Seed rev4)
      *  * PD3 tied to gnd is Daisy Seed v1.1 (aka Daisy Seed rev5)
@@ -279,4 +451,5 @@ AudioClass::BoardVersion AudioClass::BoardVersionCheck(){
     else{
         return BoardVersion::DAISY_SEED;
     }
+#endif
 }
\ No newline at end of file
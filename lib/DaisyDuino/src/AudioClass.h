@@ -5,6 +5,10 @@
 #include "utility/sai.h"
 #include "utility/sdram.h"
 #include "utility/codec_pcm3060.h"
+#include "utility/codec_wm8731.h"
+#include "utility/system.h"
+#include "utility/irq_priority.h"
+#include "utility/idle_sleep.h"
 #include <stdio.h>
 
 #include <Wire.h>
@@ -27,18 +31,44 @@ enum DaisyDuinoDevice : short;
 class AudioClass
 {
     public:
-        AudioClass() {}
+        AudioClass()
+        {
+            pcm3060_cfg_.Defaults();
+            wm8731_cfg_.Defaults();
+        }
 
         // Initializes the audio for the given platform, and returns a DaisyHardware object
 		//default samplerate is 48kHz
-        DaisyHardware init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr = AUDIO_SR_48K);
+		//flush_denormals: interrupt handlers, the audio callback included,
+		//run with flush-to-zero and default-NaN (see SetFlushDenormals)
+        DaisyHardware init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr = AUDIO_SR_48K,
+                           bool flush_denormals = false);
+
+		/** As above, first switching the clock tree and caches to sys
+		 *  (System::Config::Defaults() for 400MHz, Boost() for 480MHz).
+		 *  Without it the Arduino core's clocks are kept. Check the result
+		 *  with SysClkFreq(). sys.sdram_timing picks the SDRAM timing
+		 *  profile; the overload above always uses LEGACY. */
+		DaisyHardware init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr,
+		                   const System::Config& sys, bool flush_denormals = false);
+
+		/** SYSCLK as configured now, in Hz. The CPU runs at this rate. */
+		uint32_t SysClkFreq();
+
+		/** Sets flush-to-zero and default-NaN for the FPU context that every
+		 *  interrupt handler starts with (FPDSCR), so the audio ISR never
+		 *  takes the slow path on denormals. loop() is not affected. */
+		void SetFlushDenormals(bool enable);
         
 		/** for bwd compatibility */
 		void begin(AudioHandle::AudioCallback cb);
 
-		/** for bwd compatibility. Does not work with Daisy Patch!! */
+		/** for bwd compatibility. 4-channel frames on Daisy Patch. */
 		void begin(AudioHandle::InterleavingAudioCallback cb);
 
+		/** Native-format callback, straight on the DMA buffers. */
+		void begin(AudioHandle::NativeAudioCallback cb);
+
 		/** for bwd compatibility */			
 		void end();
 
@@ -51,35 +81,182 @@ class AudioClass
 		/** for bwd compatibility */			
 		inline float get_blocksize();
 		
-		/** Interleaving callback not supported on patch. */
 		void StartAudio(AudioHandle::InterleavingAudioCallback cb);
 
 		void StartAudio(AudioHandle::AudioCallback cb);
 
-		/** Won't work on Patch! */
+		void StartAudio(AudioHandle::NativeAudioCallback cb);
+
 		void ChangeAudioCallback(AudioHandle::InterleavingAudioCallback cb);
 
 		void ChangeAudioCallback(AudioHandle::AudioCallback cb);
 
+		void ChangeAudioCallback(AudioHandle::NativeAudioCallback cb);
+
+		/** Click-free ChangeAudioCallback: the new callback warms up off air
+		 *  for warm_blocks, then crossfades in over one block, see
+		 *  AudioHandle::SwapCallback. false while a swap is still going. */
+		bool SwapAudioCallback(AudioHandle::InterleavingAudioCallback cb,
+		                       size_t warm_blocks = 4, bool shadow_input = true);
+
+		bool SwapAudioCallback(AudioHandle::AudioCallback cb,
+		                       size_t warm_blocks = 4, bool shadow_input = true);
+
+		bool AudioCallbackSwapping();
+
 		void StopAudio();
 
+		/** Runs cb from a low-priority interrupt every every_blocks audio
+		 *  blocks, see AudioHandle::SetControlCallback */
+		void SetControlCallback(AudioHandle::ControlCallback cb, size_t every_blocks = 1);
+
 		/** Works with the new samplerates */
 		void SetAudioSampleRate(SaiHandle::Config::SampleRate samplerate);
 
 		float AudioSampleRate();
 
+		/** Applies live while running, see AudioHandle::ChangeBlockSize */
 		void SetAudioBlockSize(size_t blocksize);
 
+		/** Block size follows the CPU load, see AudioHandle::SetAdaptiveBlockSize */
+		void SetAdaptiveBlockSize(bool enable, size_t min_size = 4, size_t max_size = 256);
+
 		size_t AudioBlockSize();
 
+		/** Channel enable masks and mono fan-out for the non-interleaving
+		 *  callback, see AudioHandle::Config */
+		void SetAudioChannels(uint8_t input_mask, uint8_t output_mask, bool mono_fanout = false);
+
+		/** TPDF dither, optionally noise shaped, on the float callbacks
+		 *  output, see AudioHandle::Config::dither */
+		void SetAudioDither(AudioHandle::Dither dither);
+
+		/** Moves the (de)interleave to the MDMA controller for the
+		 *  non-interleaving callback, see AudioHandle::Config::mdma_offload */
+		void SetMdmaOffload(bool enable);
+
+		/** DMA ring depth, before begin(): 3 or 4 absorb a callback that
+		 *  runs long now and then, see AudioHandle::Config::dma_segments */
+		void SetAudioDmaSegments(size_t segments);
+
+		/** Blocks lost to a callback that fell behind the whole ring */
+		size_t AudioDroppedBlocks();
+
+		/** Before begin(): EXTERNAL clocks the SAIs from SCK, FS and MCLK
+		 *  wired over from another board, see SaiHandle::Config::Clock */
+		void SetAudioClock(SaiHandle::Config::Clock clock);
+
+		/** Before begin(): TDM_4 or TDM_8 runs SAI1 as one TDM port, with a
+		 *  callback channel per slot, see AudioHandle::SetSlots. The stock
+		 *  codecs are stereo; this is for a TDM DAC on SAI1's pins. */
+		bool SetAudioSlots(SaiHandle::Config::Slots slots);
+
+		/** Before begin(): the SAIs' bit depth, and with packed16 two 16 bit
+		 *  samples per DMA word, see AudioHandle::SetSampleFormat */
+		bool SetAudioSampleFormat(SaiHandle::Config::BitDepth depth,
+		                          bool packed16 = false);
+
+		/** Callback channels: 2, 4 with two SAIs, or the TDM slots */
+		size_t AudioChannels();
+
+		/** Frames since begin(), to the frame; safe from any interrupt */
+		uint32_t AudioFrameCount();
+
+		/** AudioFrameCount() at the first frame of the current block.
+		 *  Call from the audio callback. */
+		uint32_t AudioBlockFrame();
+
+		/** AudioFrameCount() in 64 bits: never wraps. Safe from any
+		 *  interrupt. */
+		uint64_t AudioFrameCount64();
+
+		/** The current block's first frame, in 64 bits, and the DWT
+		 *  cycle count at the DMA interrupt that brought its input in.
+		 *  Safe from any interrupt; between callbacks, the last block. */
+		SaiHandle::BlockTime AudioBlockTime();
+
+		/** Which frame was coming in when DWT->CYCCNT read cycles: a
+		 *  MIDI or trigger interrupt that stamps its events can place
+		 *  them in the block to the sample. Within 4 s of the block. */
+		uint64_t AudioFrameAt(uint32_t cycles);
+
 		float AudioCallbackRate();
+
+		/** Input-to-output delay of the buffering, in seconds: a frame waits
+		 *  for its input half to fill, then for the other half to play out
+		 *  before the output half it was written to starts, 2 * blocksize
+		 *  frames in all, or dma_segments * blocksize with a deeper ring.
+		 *  The codec's ADC and DAC filters add their group delay on top.
+		 *  Blocksizes 1, 2 and 4 run fixed-size conversion handlers. */
+		float AudioLatency();
+
+		/** Codec filter settings init() applies, or applies at once if the
+		 *  codec is already running. Each only reaches its own codec: the
+		 *  PCM3060 on the Patch SM, the WM8731 on the Seed 1.1. The
+		 *  AK4556 has none, and the WM8731 ignores all but adc_hpf once
+		 *  running. From loop(), not an interrupt: these go over Wire.
+		 *  \return false if that codec is running and did not take it */
+		bool SetCodecConfig(const Pcm3060::Config& cfg);
+		bool SetCodecConfig(const Wm8731::Config& cfg);
+
+		/** Sample format seen by a NativeAudioCallback */
+		SaiHandle::Config::BitDepth AudioBitDepth();
+
+		/** Callback load as a fraction of the block period, plus overrun
+		 *  count. Rearmed with the current blocksize on every start. */
+		CpuLoadMeter& CpuLoad();
+
+		/** Slowest callback since the last start or Reset(), with its block
+		 *  index, frame and profiled sections, and an optional trigger pin
+		 *  pulsed on every late block, see WcetTracker */
+		WcetTracker& Wcet();
+
+		/** Steps registered stages to cheaper tiers when the callback
+		 *  nears its block period, and back, see QualityGovernor */
+		QualityGovernor& Governor();
+
+		/** Lets Idle() sleep the core until the next interrupt, with the
+		 *  sleep-mode clock gating of IdleSleep if gate_clocks. */
+		void SetIdleSleep(bool enable, bool gate_clocks = false);
+
+		/** Call from loop() when it has nothing to do: sleeps until the
+		 *  next interrupt has run, or returns at once if not enabled. */
+		void Idle();
+
+		/** Largest wake-up latency out of Idle() so far, in CPU cycles */
+		uint32_t IdleWakeCycles();
+
+		/** Time from power-up to the first audio callback, in us, or 0
+		 *  before it has run. Counted by micros(), which starts in the
+		 *  core's HAL_Init, well under a millisecond after reset.
+		 *
+		 *  To shorten it, build with -DDSY_FAST_BOOT: the codecs poll
+		 *  their status instead of sitting out fixed delays, and the
+		 *  SDRAM power-up wait drops from 100 ms to 1 ms.
+		 *  On the Seed, -DDSY_SEED_BOARD_VERSION=0 (rev4, AK4556) or =1
+		 *  (1.1, WM8731) also skips probing PD3 for the board. */
+		uint32_t BootTimeUs();
 				
     private:
 		float callback_rate_;
+		bool idle_sleep_ = false;
+		IdleSleep idle_;
         
 		AudioHandle audio_handle;
 		DaisyDuinoDevice _device;
         dsy_sdram_handle sdram_handle;
+
+		enum class Codec
+		{
+			NONE,
+			PCM3060,
+			WM8731,
+		};
+		Codec codec_ = Codec::NONE;
+		Pcm3060 pcm3060_;
+		Wm8731 wm8731_;
+		Pcm3060::Config pcm3060_cfg_;
+		Wm8731::Config wm8731_cfg_;
 		
 		/** Internal indices for DaisySeed-equivalent devices 
 			*  This shouldn't have any effect on user-facing code,
@@ -100,6 +277,9 @@ class AudioClass
 		BoardVersion BoardVersionCheck();
 
 	void ConfigureSdram();
+
+		DaisyHardware Init(DaisyDuinoDevice device, DaisyDuinoSampleRate sr,
+		                   bool flush_denormals, const System::Config* sys);
 };
 
 extern AudioClass DAISY;
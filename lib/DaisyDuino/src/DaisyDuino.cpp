@@ -2,6 +2,7 @@
 
 void DaisyHardware::Init(float control_update_rate, DaisyDuinoDevice device) {
   device_ = device;
+  control_rate_ = control_update_rate;
   num_channels = 2;
   numControls = 0;
   numGates = 0;
@@ -29,6 +30,18 @@ void DaisyHardware::Init(float control_update_rate, DaisyDuinoDevice device) {
   default:
     break;
   }
+
+  for (int i = 0; i < numSwitches; i++) {
+    buttons[i].UseBank(debounce_);
+  }
+  for (int i = 0; i < numGates; i++) {
+    gateIns[i].UseBank(debounce_);
+  }
+  if (device_ == DAISY_PATCH || device_ == DAISY_POD || device_ == DAISY_PETAL) {
+    // A and B sit on distinct EXTI lines on all three.
+    encoder.UseInterrupts();
+    encoder.UseBank(debounce_);
+  }
 }
 
 void DaisyHardware::InitPod(float control_update_rate) {
@@ -128,6 +141,11 @@ void DaisyHardware::InitField(float control_update_rate) {
   keyboard_cfg.latch = PIN_FIELD_CD4021_CS;
   keyboard_cfg.data[0] = PIN_FIELD_CD4021_D1;
   keyboard_sr_.Init(keyboard_cfg);
+  keyboard_sr_.StartScan();
+  for (size_t i = 0; i < 8; i++) {
+    keyboard_hist_[i] = 0xffff;
+  }
+  keyboard_held_ = keyboard_rise_ = keyboard_fall_ = 0;
 
   //cv ins
   cv[0].InitBipolarCv(PIN_FIELD_ADC_CV_1, control_update_rate);
@@ -180,15 +198,15 @@ float DaisyHardware::GetKnobValue(uint8_t idx) {
 }
 
 bool DaisyHardware::KeyboardState(size_t idx) {
-  return keyboard_state_[idx] == 0x00;
+  return (keyboard_held_ >> idx) & 1;
 }
 
 bool DaisyHardware::KeyboardRisingEdge(size_t idx) {
-  return keyboard_state_[idx] == 0x80;
+  return (keyboard_rise_ >> idx) & 1;
 }
 
 bool DaisyHardware::KeyboardFallingEdge(size_t idx) {
-  return keyboard_state_[idx] == 0x7F;
+  return (keyboard_fall_ >> idx) & 1;
 }
 
 void DaisyHardware::ProcessAnalogControls() {
@@ -201,20 +219,67 @@ void DaisyHardware::ProcessAnalogControls() {
   }
 }
 
+bool DaisyHardware::StartAnalogScan(AdcScan::Oversample ovs) {
+  if (device_ == DAISY_FIELD || adc_scan_.IsRunning()) {
+    return false;
+  }
+
+  for (int i = 0; i < numControls; i++) {
+    if (!controls[i].UseScan(adc_scan_)) {
+      return false;
+    }
+  }
+
+  if (device_ == DAISY_PETAL && !expression.UseScan(adc_scan_)) {
+    return false;
+  }
+
+  return adc_scan_.Start(ovs);
+}
+
+bool DaisyHardware::StartCvStream(float rate) {
+  if (cv_stream_.IsRunning()) {
+    return false;
+  }
+
+  const uint32_t pins[2] = {PA4, PA5};
+  for (int i = 0; i < 2; i++) {
+    const int slot = cv_stream_.AddPin(pins[i]);
+    if (slot < 0) {
+      return false;
+    }
+    cv_pins_[slot] = pins[i];
+  }
+
+  return cv_stream_.Start(rate);
+}
+
 void DaisyHardware::ProcessDigitalControls() {
+  debounce_.Update();
+
   if (device_ == DAISY_PATCH || device_ == DAISY_POD || device_ == DAISY_PETAL) {
     encoder.Debounce();
   }
 
   else if (device_ == DAISY_FIELD) {
     keyboard_sr_.Update();
-    for (size_t i = 0; i < 16; i++) {
-      uint8_t keyidx, keyoffset;
-      keyoffset = i > 7 ? 8 : 0;
-      keyidx = (7 - (i % 8)) + keyoffset;
-      keyboard_state_[keyidx] =
-          keyboard_sr_.State(i) | (keyboard_state_[keyidx] << 1);
+    // key 7 - n of each row is register input n: reverse every byte
+    const uint16_t keys = __REV(__RBIT(keyboard_sr_.States()));
+    for (size_t i = 7; i > 0; i--) {
+      keyboard_hist_[i] = keyboard_hist_[i - 1];
     }
+    keyboard_hist_[0] = keys;
+
+    // all 16 keys at once, one bit each
+    uint16_t any_high = 0, all_high = 0xffff;
+    for (size_t i = 0; i < 7; i++) {
+      any_high |= keyboard_hist_[i];
+      all_high &= keyboard_hist_[i];
+    }
+    const uint16_t oldest = keyboard_hist_[7];
+    keyboard_held_ = ~any_high & ~oldest;
+    keyboard_rise_ = ~any_high & oldest;
+    keyboard_fall_ = all_high & ~oldest;
   }
 
   for (int i = 0; i < numSwitches; i++) {
@@ -232,6 +297,67 @@ void DaisyHardware::ProcessAllControls() {
 }
 
 // petal led setters
+bool DaisyHardware::StartControlTask(TIM_TypeDef *instance) {
+  if (control_timer_ != nullptr || control_rate_ <= 0.f) {
+    return false;
+  }
+  if (device_ != DAISY_FIELD) {
+    StartAnalogScan();
+  }
+
+  task_state_ = ControlSnapshot{};
+  snapshot_.Write(task_state_);
+
+  control_timer_ = new HardwareTimer(instance);
+  control_timer_->setOverflow(static_cast<uint32_t>(control_rate_ + 0.5f),
+                              HERTZ_FORMAT);
+  control_timer_->setInterruptPriority(IRQ_PRIORITY_CONTROL, 0);
+  control_timer_->attachInterrupt([this]() { RunControlTask(); });
+  control_timer_->resume();
+  return true;
+}
+
+void DaisyHardware::RunControlTask() {
+  ProcessAllControls();
+
+  ControlSnapshot &s = task_state_;
+  for (int i = 0; i < numControls; i++) {
+    s.controls[i] = controls[i].Value();
+  }
+  if (device_ == DAISY_FIELD) {
+    for (int i = 0; i < 4; i++) {
+      s.cv[i] = cv[i].Process();
+    }
+    s.keys_held = keyboard_held_;
+  }
+  if (device_ == DAISY_PETAL) {
+    s.expression = expression.Value();
+  }
+
+  uint8_t held = 0;
+  for (int i = 0; i < numSwitches; i++) {
+    held |= buttons[i].Pressed() << i;
+    s.button_presses[i] += buttons[i].RisingEdge();
+  }
+  s.buttons_held = held;
+
+  uint8_t high = 0;
+  for (int i = 0; i < numGates; i++) {
+    high |= gateIns[i].State() << i;
+    s.gate_triggers[i] += gateIns[i].Trig();
+  }
+  s.gates_high = high;
+
+  if (device_ == DAISY_PATCH || device_ == DAISY_POD || device_ == DAISY_PETAL) {
+    s.encoder_position += encoder.Increment();
+    s.encoder_held = encoder.Pressed();
+    s.encoder_presses += encoder.RisingEdge();
+  }
+
+  s.ticks++;
+  snapshot_.Write(s);
+}
+
 void DaisyHardware::SetRingLed(uint8_t idx, float r, float g, float b) {
   if (idx < 0 || idx > 7 || device_ != DAISY_PETAL) {
     return; // bad idx or wrong board
@@ -13,14 +13,35 @@
 #include "daisy_pod.h"
 #include "daisy_patch_sm.h"
 
+#include "utility/audio_graph.h"
+#include "utility/audio_stream.h"
 #include "utility/ctrl.h"
+#include "utility/dac_stream.h"
+#include "utility/debounce_bank.h"
 #include "utility/encoder.h"
 #include "utility/gatein.h"
+#include "utility/itm_trace.h"
 #include "utility/led.h"
 #include "utility/led_driver.h"
+#include "utility/mem_pools.h"
+#include "utility/midi_uart.h"
+#include "utility/oled_ssd1309.h"
+#include "utility/param_block.h"
 #include "utility/parameter.h"
+#include "utility/preset_store.h"
+#include "utility/qspi_flash.h"
+#include "utility/sample_sync.h"
+#include "utility/sd_stream.h"
+#include "utility/sdram_arena.h"
+#include "utility/sdram_fill.h"
+#include "utility/section_profiler.h"
+#include "utility/seqlock.h"
 #include "utility/sr_4021.h"
 #include "utility/switch.h"
+#include "utility/sys_mpu.h"
+#include "utility/task_runner.h"
+#include "utility/usb_audio.h"
+#include "utility/work_queue.h"
 
 #define OUT_L out[0]
 #define OUT_R out[1]
@@ -41,6 +62,24 @@ enum DaisyDuinoDevice : short {
 
 class AudioClass; // forward declaration
 
+// Control state as the control task last saw it. Edges are counted,
+// not flagged, so a reader slower than the task misses none: compare
+// with the counts from its previous read.
+struct ControlSnapshot {
+  float controls[12];
+  float cv[4];            // field
+  float expression;       // petal
+  uint8_t buttons_held;   // bit n for buttons[n]
+  uint16_t button_presses[7];
+  uint8_t gates_high;     // bit n for gateIns[n]
+  uint16_t gate_triggers[2];
+  int32_t encoder_position; // sum of Increment()
+  bool encoder_held;
+  uint16_t encoder_presses;
+  uint16_t keys_held;     // field keyboard, bit n for key n
+  uint32_t ticks;         // task runs so far
+};
+
 class DaisyHardware {
 public:
   DaisyHardware() {}
@@ -71,10 +110,24 @@ public:
     return constrain(volts * 51.2f, 0, 255);
   }
 
+  // 0-5 V; after StartCvStream() a 12-bit ramp from the last value on
+  // the DAC pins, else an 8-bit analogWrite().
   void WriteCvOut(uint8_t pin, float voltage){
+    const int slot = CvStreamSlot(pin);
+    if(slot >= 0){
+      cv_stream_.Ramp(slot, voltage * 0.2f);
+      return;
+    }
     analogWrite(pin, VoltsToAnalogWrite(voltage));
   }
 
+  // Streams size samples of 0-5 V to a DAC pin, at the rate given to
+  // StartCvStream(), e.g. an envelope from the audio callback. Nothing
+  // until then.
+  void WriteCvBlock(uint8_t pin, const float *volts, size_t size){
+    cv_stream_.Write(CvStreamSlot(pin), volts, size, 0.2f);
+  }
+
   //Gets the value from a control
   float GetAdcValue(size_t idx){
     if(idx < numControls){
@@ -113,6 +166,20 @@ public:
   // process knobs
   void ProcessAnalogControls();
 
+  // Converts the knobs and CVs in the background by DMA from here on,
+  // so ProcessAnalogControls() only reads memory. Call after Init.
+  // analogRead() on those pins stops working. Not on the Field: its
+  // knobs share one multiplexed pin read right after switching.
+  bool StartAnalogScan(AdcScan::Oversample ovs = AdcScan::Oversample::OVS_16);
+
+  // Drives the DAC pins, PA4 and PA5 (the Field's and Patch SM's CV
+  // outs), from a DMA ring paced by TIM6 at rate Hz, up to audio rates,
+  // so WriteCvOut() is 12 bits and smooth and WriteCvBlock() can stream
+  // at the audio rate, with no CPU per DAC update. WriteCvOut() is then
+  // for a steady caller, e.g. the control task; see DacStream::Ramp.
+  // Call after Init.
+  bool StartCvStream(float rate = 48000.f);
+
   // process buttons and encoders
   void ProcessDigitalControls();
 
@@ -122,6 +189,17 @@ public:
   // process boths
   void ProcessAllControls();
 
+  // Runs the control processing from a timer interrupt at the rate
+  // given to Init, at IRQ_PRIORITY_CONTROL: below audio, above loop().
+  // Also starts the analog scan where there is one, so the task never
+  // waits on the ADC. Do not call the Process functions yourself after
+  // this; read the state through ReadControls() instead.
+  bool StartControlTask(TIM_TypeDef *instance = TIM16);
+
+  // Latest state from the control task; from any context, including
+  // the audio callback, without touching a peripheral.
+  void ReadControls(ControlSnapshot &out) const { snapshot_.Read(out); }
+
 private:
   void InitPod(float control_update_rate);
   void InitPatch(float control_update_rate);
@@ -129,11 +207,34 @@ private:
   void InitField(float control_update_rate);
   void InitPatchSM(float control_update_rate);
 
+  void RunControlTask();
+
+  // DacStream slot of a pin, -1 unless the CV stream drives it
+  int CvStreamSlot(uint32_t pin) const {
+    if(!cv_stream_.IsRunning()) return -1;
+    for(int i = 0; i < 2; i++){
+      if(cv_pins_[i] == pin) return i;
+    }
+    return -1;
+  }
+
   DaisyDuinoDevice device_;
+  float control_rate_;
+  HardwareTimer *control_timer_ = nullptr;
+  ControlSnapshot task_state_;
+  Seqlock<ControlSnapshot> snapshot_;
+  AdcScan adc_scan_;
+  DacStream cv_stream_;
+  uint32_t cv_pins_[2] = {NUM_DIGITAL_PINS, NUM_DIGITAL_PINS};
+  // every switch, gate and encoder pin, read a port at a time
+  DebounceBank debounce_;
 
   // field keyboard
   ShiftRegister4021<2> keyboard_sr_; /**< Two 4021s daisy-chained. */
-  uint8_t keyboard_state_[16];
+  // Last 8 scans, newest first, bit n for key n; a key is low when held.
+  uint16_t keyboard_hist_[8];
+  // held for 8 scans / just held for 7 / just released for 7
+  uint16_t keyboard_held_, keyboard_rise_, keyboard_fall_;
 };
 
 #endif
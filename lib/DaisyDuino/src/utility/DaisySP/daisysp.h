@@ -10,6 +10,7 @@
 //        - all modules will have an Init() function, and a Process() function.
 //        - all modules, unless otherwise noted, will process a single sample at a time.
 //        - all processing will be done with 'float' type unless otherwise noted.
+//        - every module has a constexpr Module::kStateBytes, its sizeof: the memory it needs wherever it is placed (DTCM, AXI SRAM, SDRAM), not counting buffers the user supplies.
 //
 #pragma once
 #ifndef DSYSP_H
@@ -18,6 +19,7 @@
 /** Control Modules */
 #include "modules/adenv.h"
 #include "modules/adsr.h"
+#include "modules/env_coeff.h"
 #include "modules/line.h"
 #include "modules/phasor.h"
 
@@ -33,6 +35,7 @@
 #include "modules/compressor.h"
 #include "modules/crossfade.h"
 #include "modules/limiter.h"
+#include "modules/mixer.h"
 
 /** Effects Modules */
 #include "modules/autowah.h"
@@ -41,7 +44,9 @@
 #include "modules/decimator.h"
 #include "modules/flanger.h"
 #include "modules/fold.h"
+#include "modules/fx_rack.h"
 #include "modules/overdrive.h"
+#include "modules/waveshaper.h"
 #include "modules/reverbsc.h"
 #include "modules/phaser.h"
 #include "modules/pitchshifter.h"
@@ -52,19 +57,36 @@
 #include "modules/allpass.h"
 #include "modules/atone.h"
 #include "modules/biquad.h"
+#include "modules/biquad_cascade.h"
+#include "modules/biquad_cascade_q31.h"
+#include "modules/parallel_biquad.h"
+#include "modules/block_chain.h"
+#include "modules/coeff_cache.h"
+#include "modules/iir_design.h"
 #include "modules/comb.h"
+#include "modules/comb_bank.h"
+#include "modules/filter_bank.h"
 #include "modules/mode.h"
 #include "modules/moogladder.h"
 #include "modules/nlfilt.h"
 #include "modules/svf.h"
 #include "modules/tone.h"
 #include "modules/fir.h"
+#include "modules/fft_convolver.h"
+#include "modules/convolution_reverb.h"
+#include "modules/real_fft.h"
+#include "modules/stft.h"
+#include "modules/goertzel_bank.h"
+#include "modules/halfband.h"
+#include "modules/resampler.h"
+#include "modules/hilbert.h"
 
 /** Noise Modules */
 #include "modules/clockednoise.h"
 #include "modules/dust.h"
 #include "modules/fractal_noise.h"
 #include "modules/grainlet.h"
+#include "modules/granulator.h"
 #include "modules/particle.h"
 #include "modules/whitenoise.h"
 
@@ -80,25 +102,45 @@
 /** Synthesis Modules */
 #include "modules/blosc.h"
 #include "modules/fm2.h"
+#include "modules/fm_voice.h"
 #include "modules/formantosc.h"
 #include "modules/harmonic_osc.h"
+#include "modules/nco.h"
+#include "modules/fast_sin.h"
 #include "modules/oscillator.h"
 #include "modules/oscillatorbank.h"
 #include "modules/variablesawosc.h"
 #include "modules/variableshapeosc.h"
 #include "modules/vosim.h"
+#include "modules/wavetable_osc.h"
 #include "modules/zoscillator.h"
 
 /** modules Modules */
 #include "modules/dcblock.h"
 #include "modules/delayline.h"
+#include "modules/multitap_delay.h"
+#include "modules/interleaved_delay.h"
+#include "modules/fractional_delay_bank.h"
 #include "modules/dsp.h"
+#include "modules/const_table.h"
+#include "modules/fixed.h"
+#include "modules/fast_random.h"
+#include "modules/semitones.h"
+#include "modules/pending_trigger.h"
 #include "modules/jitter.h"
 #include "modules/looper.h"
 #include "modules/maytrig.h"
 #include "modules/metro.h"
+#include "modules/mod_delay.h"
 #include "modules/port.h"
 #include "modules/samplehold.h"
+#include "modules/sample_player.h"
+#include "modules/smooth_delay.h"
 #include "modules/smooth_random.h"
+#include "modules/smoother_bank.h"
+#include "modules/voice_allocator.h"
+#include "modules/drum_kit.h"
+#include "modules/modal_voice_bank.h"
+#include "modules/string_voice_bank.h"
 
 #endif
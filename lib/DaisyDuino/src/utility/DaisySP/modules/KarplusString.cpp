@@ -1,35 +1,63 @@
 #include <cmath>
 #include "dsp.h"
+#include "semitones.h"
 #include "KarplusString.h"
-#include <stdlib.h>
 
 using namespace daisysp;
 
+#if DSY_STRINGOSC_MAX_DELAY > 0
 void StringOsc::Init(float sample_rate)
+{
+    Setup(sample_rate, nullptr, sizeof(storage_) / sizeof(storage_[0]));
+}
+#endif
+
+void StringOsc::Init(float sample_rate, float *mem, size_t size)
+{
+    Setup(sample_rate, mem, size);
+}
+
+void StringOsc::Setup(float sample_rate, float *mem, size_t size)
 {
     sample_rate_ = sample_rate;
 
-    SetFreq(440.f);
-    non_linearity_amount_ = .5f;
+    // The largest power of two whose line and quarter fit.
+    size_t n = 1;
+    while(n * 2 + n / 2 <= size)
+        n *= 2;
+    while(n > 1 && n + n / 4 > size)
+        n /= 2;
+    mem_          = mem;
+    string_size_  = n;
+    string_mask_  = n - 1;
+    stretch_mask_ = n / 4 - 1;
+
+    interpolation_        = Interpolation::HERMITE;
+    frequency_            = 440.f / sample_rate_;
+    damping_              = .8f;
+    non_linearity_amount_ = .1f;
     brightness_           = .5f;
-    damping_              = .5f;
 
-    string_.Init();
-    stretch_.Init();
     Reset();
 
-    SetFreq(440.f);
-    SetDamping(.8f);
-    SetNonLinearity(.1f);
-    SetBrightness(.5f);
-
     crossfade_.Init();
+    rng_.Init();
+}
+
+void StringOsc::SetSeed(uint32_t seed)
+{
+    rng_.Init(seed);
 }
 
 void StringOsc::Reset()
 {
-    string_.Reset();
-    stretch_.Reset();
+    float *line = Line();
+    for(size_t i = 0; i < string_size_ + string_size_ / 4; i++)
+        line[i] = 0.0f;
+    string_ptr_    = 0;
+    stretch_ptr_   = 0;
+    allpass_state_ = 0.0f;
+
     iir_damping_filter_.Init(sample_rate_);
 
     dc_blocker_.Init(sample_rate_);
@@ -38,68 +66,93 @@ void StringOsc::Reset()
     curved_bridge_    = 0.0f;
     out_sample_[0] = out_sample_[1] = 0.0f;
     src_phase_                      = 0.0f;
+
+    // The damping filter's coefficients, among others.
+    Update();
 }
 
 float StringOsc::Process(const float in)
 {
-    if(non_linearity_amount_ <= 0.0f)
-    {
-        non_linearity_amount_ *= -1;
-        float ret = ProcessInternal<STRING_NON_LINEARITY_CURVED_BRIDGE>(in);
-        non_linearity_amount_ *= -1;
-        return ret;
-    }
-    else
-    {
-        return ProcessInternal<STRING_NON_LINEARITY_DISPERSION>(in);
-    }
+    float out;
+    Dispatch(&in, &out, 1);
+    return out;
+}
+
+void StringOsc::ProcessBlock(const float *in, float *out, size_t size)
+{
+    Dispatch(in, out, size);
 }
 
 void StringOsc::SetFreq(float freq)
 {
     freq /= sample_rate_;
-    frequency_ = fclamp(freq, 0.f, .25f);
+    freq = fclamp(freq, 0.f, .25f);
+    if(freq != frequency_)
+    {
+        frequency_ = freq;
+        Update();
+    }
 }
 
 void StringOsc::SetNonLinearity(float non_linearity_amount)
 {
-    non_linearity_amount_ = fclamp(non_linearity_amount, 0.f, 1.f);
+    non_linearity_amount = fclamp(non_linearity_amount, 0.f, 1.f);
+    if(non_linearity_amount != non_linearity_amount_)
+    {
+        non_linearity_amount_ = non_linearity_amount;
+        Update();
+    }
 }
 
 void StringOsc::SetBrightness(float brightness)
 {
-    brightness_ = fclamp(brightness, 0.f, 1.f);
+    brightness = fclamp(brightness, 0.f, 1.f);
+    if(brightness != brightness_)
+    {
+        brightness_ = brightness;
+        Update();
+    }
 }
 
 void StringOsc::SetDamping(float damping)
 {
-    damping_ = fclamp(damping, 0.f, 1.f);
+    damping = fclamp(damping, 0.f, 1.f);
+    if(damping != damping_)
+    {
+        damping_ = damping;
+        Update();
+    }
+}
+
+void StringOsc::SetInterpolation(Interpolation interpolation)
+{
+    interpolation_ = interpolation;
 }
 
-template <StringNonLinearity non_linearity>
-float StringOsc::ProcessInternal(const float in)
+void StringOsc::Update()
 {
     float brightness = brightness_;
 
     float delay = 1.0f / frequency_;
-    delay       = fclamp(delay, 4.f, kDelayLineSize - 4.0f);
+    delay = fclamp(delay, 4.f, static_cast<float>(string_size_) - 4.0f);
 
     // If there is not enough delay time in the delay line, we play at the
     // lowest possible note and we upsample on the fly with a shitty linear
     // interpolator. We don't care because it's a corner case (frequency_ < 11.7Hz)
     float src_ratio = delay * frequency_;
-    if(src_ratio >= 0.9999f)
+    full_rate_      = src_ratio >= 0.9999f;
+    if(full_rate_)
     {
         // When we are above 11.7 Hz, we make sure that the linear interpolator
         // does not get in the way.
-        src_phase_ = 1.0f;
-        src_ratio  = 1.0f;
+        src_ratio = 1.0f;
     }
+    src_ratio_ = src_ratio;
 
     float damping_cutoff
         = fmin(12.0f + damping_ * damping_ * 60.0f + brightness * 24.0f, 84.0f);
     float damping_f
-        = fmin(frequency_ * powf(2.f, damping_cutoff * kOneTwelfth), 0.499f);
+        = fmin(frequency_ * SemitonesToRatio(damping_cutoff), 0.499f);
 
     // Crossfade to infinite decay.
     if(damping_ >= 0.95f)
@@ -113,85 +166,187 @@ float StringOsc::ProcessInternal(const float in)
     float temp_f = damping_f * sample_rate_;
     iir_damping_filter_.SetFreq(temp_f);
 
-    float ratio                = powf(2.f, damping_cutoff * kOneTwelfth);
+    float ratio                = SemitonesToRatio(damping_cutoff);
     float damping_compensation = 1.f - 2.f * atanf(1.f / ratio) / (TWOPI_F);
+    damped_delay_              = delay * damping_compensation;
 
-    float stretch_point
-        = non_linearity_amount_ * (2.0f - non_linearity_amount_) * 0.225f;
+    // At 0 the curved bridge, with no curving; above, dispersion.
+    curved_bridge_mode_         = non_linearity_amount_ <= 0.0f;
+    const float non_linearity   = fabsf(non_linearity_amount_);
+
+    stretch_point_ = non_linearity * (2.0f - non_linearity) * 0.225f;
+    stretch_k_     = 0.408f - stretch_point_ * 0.308f;
     float stretch_correction = (160.0f / sample_rate_) * delay;
-    stretch_correction       = fclamp(stretch_correction, 1.f, 2.1f);
+    stretch_correction_      = fclamp(stretch_correction, 1.f, 2.1f);
 
-    float noise_amount_sqrt = non_linearity_amount_ > 0.75f
-                                  ? 4.0f * (non_linearity_amount_ - 0.75f)
-                                  : 0.0f;
-    float noise_amount = noise_amount_sqrt * noise_amount_sqrt * 0.1f;
-    float noise_filter = 0.06f + 0.94f * brightness * brightness;
+    float noise_amount_sqrt
+        = non_linearity > 0.75f ? 4.0f * (non_linearity - 0.75f) : 0.0f;
+    noise_amount_ = noise_amount_sqrt * noise_amount_sqrt * 0.1f;
+    noise_filter_ = 0.06f + 0.94f * brightness * brightness;
 
-    float bridge_curving_sqrt = non_linearity_amount_;
-    float bridge_curving = bridge_curving_sqrt * bridge_curving_sqrt * 0.01f;
+    float bridge_curving_sqrt = non_linearity;
+    bridge_curving_ = bridge_curving_sqrt * bridge_curving_sqrt * 0.01f;
 
-    float ap_gain = -0.618f * non_linearity_amount_
-                    / (0.15f + fabsf(non_linearity_amount_));
+    ap_gain_ = -0.618f * non_linearity / (0.15f + fabsf(non_linearity));
+}
 
-    src_phase_ += src_ratio;
-    if(src_phase_ > 1.0f)
+void StringOsc::Dispatch(const float *in, float *out, size_t size)
+{
+    if(curved_bridge_mode_)
     {
-        src_phase_ -= 1.0f;
-
-        delay   = delay * damping_compensation;
-        float s = 0.0f;
-
-        if(non_linearity == STRING_NON_LINEARITY_DISPERSION)
+        switch(interpolation_)
         {
-            float noise = rand() * kRandFrac - 0.5f;
-            fonepole(dispersion_noise_, noise, noise_filter);
-            delay *= 1.0f + dispersion_noise_ * noise_amount;
+            case Interpolation::LINEAR:
+                Run<STRING_NON_LINEARITY_CURVED_BRIDGE, Interpolation::LINEAR>(
+                    in, out, size);
+                break;
+            case Interpolation::ALLPASS:
+                Run<STRING_NON_LINEARITY_CURVED_BRIDGE, Interpolation::ALLPASS>(
+                    in, out, size);
+                break;
+            default:
+                Run<STRING_NON_LINEARITY_CURVED_BRIDGE, Interpolation::HERMITE>(
+                    in, out, size);
+                break;
         }
-        else
+    }
+    else
+    {
+        switch(interpolation_)
         {
-            delay *= 1.0f - curved_bridge_ * bridge_curving;
+            case Interpolation::LINEAR:
+                Run<STRING_NON_LINEARITY_DISPERSION, Interpolation::LINEAR>(
+                    in, out, size);
+                break;
+            case Interpolation::ALLPASS:
+                Run<STRING_NON_LINEARITY_DISPERSION, Interpolation::ALLPASS>(
+                    in, out, size);
+                break;
+            default:
+                Run<STRING_NON_LINEARITY_DISPERSION, Interpolation::HERMITE>(
+                    in, out, size);
+                break;
         }
+    }
+}
+
+template <StringOsc::Interpolation interpolation, bool stretched>
+inline float StringOsc::ReadString(const float *line, float delay)
+{
+    int32_t delay_integral   = static_cast<int32_t>(delay);
+    float   delay_fractional = delay - static_cast<float>(delay_integral);
+    const size_t t           = string_ptr_ + delay_integral;
+    const size_t mask        = string_mask_;
+
+    if(interpolation == Interpolation::ALLPASS)
+    {
+        const float a   = line[t & mask];
+        const float b   = line[(t + 1) & mask];
+        const float eta = (1.0f - delay_fractional) / (1.0f + delay_fractional);
+        allpass_state_  = b + (a - allpass_state_) * eta;
+        return allpass_state_;
+    }
+    else if(interpolation == Interpolation::LINEAR || stretched)
+    {
+        const float a = line[t & mask];
+        const float b = line[(t + 1) & mask];
+        return a + (b - a) * delay_fractional;
+    }
+    else
+    {
+        const float xm1   = line[(t - 1) & mask];
+        const float x0    = line[t & mask];
+        const float x1    = line[(t + 1) & mask];
+        const float x2    = line[(t + 2) & mask];
+        const float c     = (x1 - xm1) * 0.5f;
+        const float v     = x0 - x1;
+        const float w     = c + v;
+        const float a     = w + v + (x2 - x0) * 0.5f;
+        const float b_neg = w + a;
+        const float f     = delay_fractional;
+        return (((a * f) - b_neg) * f + c) * f + x0;
+    }
+}
+
+template <StringNonLinearity non_linearity, StringOsc::Interpolation interpolation>
+void StringOsc::Run(const float *in, float *out, size_t size)
+{
+    float *const string  = Line();
+    float *const stretch = string + string_size_;
 
-        if(non_linearity == STRING_NON_LINEARITY_DISPERSION)
+    for(size_t i = 0; i < size; i++)
+    {
+        if(full_rate_)
+            src_phase_ = 1.0f;
+        src_phase_ += src_ratio_;
+        if(src_phase_ > 1.0f)
         {
-            float ap_delay   = delay * stretch_point;
-            float main_delay = delay
-                               - ap_delay * (0.408f - stretch_point * 0.308f)
-                                     * stretch_correction;
-            if(ap_delay >= 4.0f && main_delay >= 4.0f)
+            src_phase_ -= 1.0f;
+
+            float delay = damped_delay_;
+            float s     = 0.0f;
+
+            if(non_linearity == STRING_NON_LINEARITY_DISPERSION)
             {
-                s = string_.Read(main_delay);
-                s = stretch_.Allpass(s, ap_delay, ap_gain);
+                float noise = rng_.NextFloat() - 0.5f;
+                fonepole(dispersion_noise_, noise, noise_filter_);
+                delay *= 1.0f + dispersion_noise_ * noise_amount_;
             }
             else
             {
-                s = string_.ReadHermite(delay);
+                delay *= 1.0f - curved_bridge_ * bridge_curving_;
             }
-        }
-        else
-        {
-            s = string_.ReadHermite(delay);
-        }
 
-        if(non_linearity == STRING_NON_LINEARITY_CURVED_BRIDGE)
-        {
-            float value    = fabsf(s) - 0.025f;
-            float sign     = s > 0.0f ? 1.0f : -1.5f;
-            curved_bridge_ = (fabsf(value) + value) * sign;
-        }
+            if(non_linearity == STRING_NON_LINEARITY_DISPERSION)
+            {
+                float ap_delay = delay * stretch_point_;
+                float main_delay
+                    = delay - ap_delay * stretch_k_ * stretch_correction_;
+                if(ap_delay >= 4.0f && main_delay >= 4.0f)
+                {
+                    s = ReadString<interpolation, true>(string, main_delay);
+
+                    // The dispersion allpass, on its own ring.
+                    const size_t p = stretch_ptr_;
+                    const float  read
+                        = stretch[(p + static_cast<size_t>(ap_delay))
+                                  & stretch_mask_];
+                    const float write = s + ap_gain_ * read;
+                    stretch[p]        = write;
+                    stretch_ptr_      = (p - 1) & stretch_mask_;
+                    s                 = -write * ap_gain_ + read;
+                }
+                else
+                {
+                    s = ReadString<interpolation, false>(string, delay);
+                }
+            }
+            else
+            {
+                s = ReadString<interpolation, false>(string, delay);
+            }
 
-        s += in;
-        s = fclamp(s, -20.f, +20.f);
+            if(non_linearity == STRING_NON_LINEARITY_CURVED_BRIDGE)
+            {
+                float value    = fabsf(s) - 0.025f;
+                float sign     = s > 0.0f ? 1.0f : -1.5f;
+                curved_bridge_ = (fabsf(value) + value) * sign;
+            }
 
-        s = dc_blocker_.Process(s);
+            s += in[i];
+            s = fclamp(s, -20.f, +20.f);
 
-        s = iir_damping_filter_.Process(s);
-        string_.Write(s);
+            s = dc_blocker_.Process(s);
 
-        out_sample_[1] = out_sample_[0];
-        out_sample_[0] = s;
-    }
+            s                    = iir_damping_filter_.Process(s);
+            string[string_ptr_] = s;
+            string_ptr_          = (string_ptr_ - 1) & string_mask_;
+
+            out_sample_[1] = out_sample_[0];
+            out_sample_[0] = s;
+        }
 
-    crossfade_.SetPos(src_phase_);
-    return crossfade_.Process(out_sample_[1], out_sample_[0]);
+        crossfade_.SetPos(src_phase_);
+        out[i] = crossfade_.Process(out_sample_[1], out_sample_[0]);
+    }
 }
\ No newline at end of file
@@ -3,14 +3,25 @@
 #define DSY_STRING_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 
 #include "crossfade.h"
 #include "dcblock.h"
-#include "delayline.h"
+#include "fast_random.h"
 #include "svf.h"
 #include "tone.h"
 
+/** Longest string delay inside each StringOsc, in samples, a power of
+    two; the dispersion line takes a quarter of that again. Build with
+    -DDSY_STRINGOSC_MAX_DELAY=0 (for every file, as it changes the class)
+    to drop it and always pass memory to Init(), which takes a voice from
+    about 5 KB to a few hundred bytes.
+*/
+#ifndef DSY_STRINGOSC_MAX_DELAY
+#define DSY_STRINGOSC_MAX_DELAY 1024
+#endif
+
 #ifdef __cplusplus
 
 /** @file string.h */
@@ -25,34 +36,87 @@ enum StringNonLinearity
     STRING_NON_LINEARITY_DISPERSION
 };
 
-/**  
+/**
        @brief Comb filter / KS string.
 	   @author Ben Sergentanis
-	   @date Jan 2021 
-	   "Lite" version of the implementation used in Rings \n \n 
+	   @date Jan 2021
+	   "Lite" version of the implementation used in Rings \n \n
 	   Ported from pichenettes/eurorack/plaits/dsp/oscillator/formant_oscillator.h \n
 	   to an independent module. \n
 	   Original code written by Emilie Gillet in 2016. \n
+
+    The string and dispersion lines are power-of-two rings indexed with a
+    mask, inside the object or, with Init(sample_rate, mem, size), in the
+    caller's memory: from MemPools, say, so a bank of 16 voices puts its
+    lines in DTCM while it lasts. Everything the settings determine is
+    worked out when one changes, so per sample there is only the string
+    itself; ProcessBlock() picks the non-linearity and interpolation once
+    per block.
+
+    static float DSY_MEM_DTCM mem[16][StringOsc::GetMemorySize(512)];
+    for(size_t i = 0; i < 16; i++)
+        str[i].Init(sample_rate, mem[i], StringOsc::GetMemorySize(512));
 */
 class StringOsc
 {
   public:
+    static const size_t kStateBytes;
+
     StringOsc() {}
     ~StringOsc() {}
 
+    /** How the string's delay is read between samples */
+    enum class Interpolation
+    {
+        HERMITE, /**< cubic; linear with the dispersion stretch. The default. */
+        LINEAR,  /**< linear throughout: cheapest, dulls high notes */
+        ALLPASS, /**< first-order allpass: flat magnitude, for high notes */
+    };
+
+#if DSY_STRINGOSC_MAX_DELAY > 0
     /** Initialize the module.
 		\param sample_rate Audio engine sample rate
 	*/
     void Init(float sample_rate);
+#endif
+
+    /** Initialize the module on the caller's memory.
+        \param sample_rate Audio engine sample rate
+        \param mem Delay memory, cleared here
+        \param size Floats at mem: GetMemorySize() of the longest delay.
+               Notes too low for it are upsampled, as below 11.7 Hz with
+               the full line.
+    */
+    void Init(float sample_rate, float *mem, size_t size);
+
+    /** \return floats of memory for a string delay of up to max_delay
+        samples, rounded up to a power of two, and its dispersion line
+    */
+    static constexpr size_t GetMemorySize(size_t max_delay = kDelayLineSize)
+    {
+        return RoundUp(max_delay) + RoundUp(max_delay) / 4;
+    }
 
     /** Clear the delay line */
     void Reset();
 
+    /** Restarts the dispersion noise from a given seed, for repeatable
+        output. Call after Init().
+    */
+    void SetSeed(uint32_t seed);
+
     /** Get the next floating point sample
 		\param in Signal to excite the string.
 	*/
     float Process(const float in);
 
+    /** Processes a block, the same as Process() on each sample.
+        \param in Excitation
+        \param out Output, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size);
+
     /** Set the string frequency.
 		\param freq Frequency in Hz
 	*/
@@ -73,32 +137,87 @@ class StringOsc
 	*/
     void SetDamping(float damping);
 
+    /** Choose how the string's delay is interpolated. */
+    void SetInterpolation(Interpolation interpolation);
+
 
   private:
-    template <StringNonLinearity non_linearity>
-    float ProcessInternal(const float in);
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
 
-    DelayLine<float, kDelayLineSize>     string_;
-    DelayLine<float, kDelayLineSize / 4> stretch_;
+    void Setup(float sample_rate, float *mem, size_t size);
+
+    /** Derives the coefficients below from the settings */
+    void Update();
+
+    template <StringNonLinearity non_linearity, Interpolation interpolation>
+    void Run(const float *in, float *out, size_t size);
+
+    void Dispatch(const float *in, float *out, size_t size);
+
+    template <Interpolation interpolation, bool stretched>
+    inline float ReadString(const float *line, float delay);
+
+    inline float *Line()
+    {
+#if DSY_STRINGOSC_MAX_DELAY > 0
+        return mem_ ? mem_ : storage_;
+#else
+        return mem_;
+#endif
+    }
 
     float frequency_, non_linearity_amount_, brightness_, damping_;
 
     float sample_rate_;
 
+    Interpolation interpolation_;
+
+    // From the settings, by Update().
+    bool  curved_bridge_mode_;
+    bool  full_rate_;
+    float src_ratio_;
+    float damped_delay_;
+    float stretch_point_, stretch_k_, stretch_correction_;
+    float noise_amount_, noise_filter_;
+    float bridge_curving_;
+    float ap_gain_;
+
+    // Rings: the string at the start of the memory, the dispersion line
+    // after it. Written downwards, read at write pointer + delay.
+    float *mem_; /**< the caller's, or nullptr for storage_ */
+    size_t string_size_, string_mask_, string_ptr_;
+    size_t stretch_mask_, stretch_ptr_;
+    float  allpass_state_;
+
     Tone iir_damping_filter_;
 
     DcBlock dc_blocker_;
 
     CrossFade crossfade_;
 
-    float dispersion_noise_;
-    float curved_bridge_;
+    float      dispersion_noise_;
+    float      curved_bridge_;
+    FastRandom rng_;
 
     // Very crappy linear interpolation upsampler used for low pitches that
     // do not fit the delay line. Rarely used.
     float src_phase_;
     float out_sample_[2];
+
+#if DSY_STRINGOSC_MAX_DELAY > 0
+    static_assert((DSY_STRINGOSC_MAX_DELAY & (DSY_STRINGOSC_MAX_DELAY - 1)) == 0,
+                  "DSY_STRINGOSC_MAX_DELAY must be a power of two");
+    float storage_[DSY_STRINGOSC_MAX_DELAY + DSY_STRINGOSC_MAX_DELAY / 4];
+#endif
 };
+
+inline constexpr size_t StringOsc::kStateBytes = sizeof(StringOsc);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -23,6 +23,8 @@ template <size_t num_voices>
 class PolyPluck
 {
   public:
+    static const size_t kStateBytes;
+
     /** Initializes the PolyPluck instance.
         \param sample_rate: rate in Hz that the Process() function will be called.
     */
@@ -85,6 +87,10 @@ class PolyPluck
     size_t  active_voice_;
 };
 
+template <size_t num_voices>
+constexpr size_t PolyPluck<num_voices>::kStateBytes
+    = sizeof(PolyPluck<num_voices>);
+
 } // namespace daisysp
 
 #endif
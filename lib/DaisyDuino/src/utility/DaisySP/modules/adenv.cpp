@@ -1,142 +1,140 @@
 #include <math.h>
 #include "adenv.h"
+#include "dsp.h"
+#include "env_coeff.h"
 
 using namespace daisysp;
 
-//#define EXPF expf
-// This causes with infinity with certain curves,
-// which then causes NaN erros...
-#define EXPF expf_fast
-
-// To resolve annoying bugs when using this you can:
-// if (val != val)
-//     val = 0.0f; // This will un-NaN the value.
-
-// Fast Exp approximation
-// 8x multiply version
-//inline float expf_fast(float x)
-//{
-//   x = 1.0f + x / 256.0f;
-//   x *= x;
-//   x *= x;
-//   x *= x;
-//   x *= x;
-//   x *= x;
-//   x *= x;
-//   x *= x;
-//   x *= x;
-//   return x;
-//}
-
-// 10x multiply version
-inline float expf_fast(float x)
-{
-    x = 1.0f + x / 1024.0f;
-    x *= x;
-    x *= x;
-    x *= x;
-    x *= x;
-    x *= x;
-    x *= x;
-    x *= x;
-    x *= x;
-    x *= x;
-    x *= x;
-    return x;
-}
-
 // Private Functions
 void AdEnv::Init(float sample_rate)
 {
+    EnvCoeff::InitTable();
     sample_rate_     = sample_rate;
     current_segment_ = ADENV_SEG_IDLE;
+    prev_segment_    = ADENV_SEG_IDLE;
     curve_scalar_    = 0.0f; // full linear
+    curve_exp_       = 1.0f;
+    curve_e_         = 1.0f;
     phase_           = 0;
     min_             = 0.0f;
     max_             = 1.0f;
     output_          = 0.0001f;
+    trigger_         = 0;
     for(uint8_t i = 0; i < ADENV_SEG_LAST; i++)
     {
         segment_time_[i] = 0.05f;
     }
 }
 
+void AdEnv::SetCurve(float scalar)
+{
+    if(scalar != curve_scalar_)
+    {
+        curve_scalar_ = scalar;
+        curve_exp_    = math::exp(scalar);
+    }
+}
+
 float AdEnv::Process()
 {
-    uint32_t time_samps;
-    float    val, out, end, beg, inc;
+    float out;
+    ProcessBlock(&out, 1);
+    return out;
+}
 
+void AdEnv::ProcessBlock(float* out, size_t size)
+{
     // Handle Retriggering
     if(trigger_)
     {
         trigger_         = 0;
         current_segment_ = ADENV_SEG_ATTACK;
         phase_           = 0;
-        curve_x_         = 0.0f;
+        curve_e_         = 1.0f;
         retrig_val_      = output_;
     }
 
-    time_samps = (uint32_t)(segment_time_[current_segment_] * sample_rate_);
-
-    // Fixed for now, but we could always make this a more flexible multi-segment envelope
-    switch(current_segment_)
+    const float scale = max_ - min_;
+    float       val   = output_;
+    size_t      i     = 0;
+    while(i < size)
     {
-        case ADENV_SEG_ATTACK:
-            beg = retrig_val_;
-            end = 1.0f;
-            break;
-        case ADENV_SEG_DECAY:
-            beg = 1.0f;
-            end = 0.0f;
-            break;
-        case ADENV_SEG_IDLE:
-        default:
-            beg = 0;
-            end = 0;
+        if(current_segment_ == ADENV_SEG_IDLE)
+        {
+            for(; i < size; i++)
+            {
+                out[i] = min_;
+            }
+            prev_segment_ = ADENV_SEG_IDLE;
+            val           = 0.0f;
             break;
-    }
-
-    if(prev_segment_ != current_segment_)
-    {
-        //Reset at segment beginning
-        curve_x_ = 0;
-        phase_   = 0;
-    }
-
-    //recalculate increment value
-    if(curve_scalar_ == 0.0f)
-    {
-        c_inc_ = (end - beg) / time_samps;
-    }
-    else
-    {
-        c_inc_ = (end - beg) / (1.0f - EXPF(curve_scalar_));
-    }
-
+        }
 
-    // update output
-    val = output_;
-    inc = c_inc_;
-    out = val;
-    if(curve_scalar_ == 0.0f)
-    {
-        val += inc;
-    }
-    else
-    {
-        curve_x_ += (curve_scalar_ / time_samps);
-        val = beg + inc * (1.0f - EXPF(curve_x_));
-        if(val != val)
-            val = 0.0f; // NaN check
-    }
+        if(prev_segment_ != current_segment_)
+        {
+            //Reset at segment beginning
+            curve_e_ = 1.0f;
+            phase_   = 0;
+        }
+        prev_segment_ = current_segment_;
+
+        // Fixed for now, but we could always make this a more flexible multi-segment envelope
+        const bool  attack = current_segment_ == ADENV_SEG_ATTACK;
+        const float beg    = attack ? retrig_val_ : 1.0f;
+        const float end    = attack ? 1.0f : 0.0f;
+        // The segment ends on out >= 1 in the attack, out <= 0 in the
+        // decay: dir * out >= edge for both.
+        const float dir  = attack ? 1.0f : -1.0f;
+        const float edge = attack ? 1.0f : 0.0f;
+
+        uint32_t time_samps
+            = (uint32_t)(segment_time_[current_segment_] * sample_rate_);
+        time_samps = time_samps > 0 ? time_samps : 1;
+
+        const size_t start = i;
+        bool         done  = false;
+        if(curve_scalar_ == 0.0f)
+        {
+            const float inc = (end - beg) / time_samps;
+            for(; i < size; i++)
+            {
+                const float prev = val;
+                val += inc;
+                out[i] = prev * scale + min_;
+                if(dir * prev >= edge)
+                {
+                    done = true;
+                    i++;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            // exp(curve * phase / time_samps), one ratio per sample.
+            const float inc   = (end - beg) / (1.0f - curve_exp_);
+            const float ratio = EnvCoeff::Exp(curve_scalar_ / time_samps);
+            float       e     = curve_e_;
+            for(; i < size; i++)
+            {
+                const float prev = val;
+                e *= ratio;
+                val = beg + inc * (1.0f - e);
+                if(val != val)
+                    val = 0.0f; // NaN check
+                out[i] = prev * scale + min_;
+                if(dir * prev >= edge)
+                {
+                    done = true;
+                    i++;
+                    break;
+                }
+            }
+            curve_e_ = e;
+        }
+        phase_ += i - start;
 
-    // Update Segment
-    phase_ += 1;
-    prev_segment_ = current_segment_;
-    if(current_segment_ != ADENV_SEG_IDLE)
-    {
-        if((out >= 1.f && current_segment_ == ADENV_SEG_ATTACK)
-           || (out <= 0.f && current_segment_ == ADENV_SEG_DECAY))
+        if(done)
         {
             // Advance segment
             current_segment_++;
@@ -144,14 +142,10 @@ float AdEnv::Process()
             if(current_segment_ > ADENV_SEG_DECAY)
             {
                 current_segment_ = ADENV_SEG_IDLE;
+                val              = 0.0f;
+                out[i - 1]       = min_;
             }
         }
     }
-    if(current_segment_ == ADENV_SEG_IDLE)
-    {
-        val = out = 0.0f;
-    }
     output_ = val;
-
-    return out * (max_ - min_) + min_;
 }
@@ -2,6 +2,7 @@
 #ifndef ADENV_H
 #define ADENV_H
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -23,6 +24,10 @@ enum AdEnvSegment
 
 /** Trigger-able envelope with adjustable min/max, and independent per-segment time control.
 
+    The curve is a geometric run per segment: its ratio comes from
+    EnvCoeff's table keyed by the segment time, so neither samples nor
+    time changes call libm.
+
     \author shensley
     \todo - Add Cycling
     \todo - Implement Curve (its only linear for now).
@@ -31,6 +36,8 @@ enum AdEnvSegment
 class AdEnv
 {
   public:
+    static const size_t kStateBytes;
+
     AdEnv() {}
     ~AdEnv() {}
     /** Initializes the ad envelope.
@@ -52,6 +59,14 @@ class AdEnv
     */
     float Process();
 
+    /** Renders a block, the same as size calls to Process(). Each
+        segment runs in its own loop, its increment or curve ratio worked
+        out once, up to the next transition.
+        \param out receives size samples
+        \param size number of samples
+    */
+    void ProcessBlock(float* out, size_t size);
+
     /** Starts or retriggers the envelope.*/
     inline void Trigger() { trigger_ = 1; }
     /** Sets the length of time (in seconds) for a specific segment. */
@@ -59,7 +74,7 @@ class AdEnv
     /** Sets the amount of curve applied. A positve value will create a log
         curve. Input range: -100 to 100.  (or more)
     */
-    inline void SetCurve(float scalar) { curve_scalar_ = scalar; }
+    void SetCurve(float scalar);
     /** Sets the minimum value of the envelope output.
         Input range: -FLTmax_, to FLTmax_
     */
@@ -82,11 +97,13 @@ class AdEnv
     uint8_t  current_segment_, prev_segment_;
     float    segment_time_[ADENV_SEG_LAST];
     float    sample_rate_, min_, max_, output_, curve_scalar_;
-    float    c_inc_, curve_x_, retrig_val_;
+    float    curve_e_, curve_exp_, retrig_val_;
     uint32_t phase_;
     uint8_t  trigger_;
 };
 
+inline constexpr size_t AdEnv::kStateBytes = sizeof(AdEnv);
+
 } // namespace daisysp
 #endif
 #endif
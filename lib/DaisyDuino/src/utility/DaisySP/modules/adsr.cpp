@@ -1,4 +1,5 @@
 #include "adsr.h"
+#include "env_coeff.h"
 #include <math.h>
 
 using namespace daisysp;
@@ -6,6 +7,7 @@ using namespace daisysp;
 
 void Adsr::Init(float sample_rate, int blockSize)
 {
+    EnvCoeff::InitTable();
     sample_rate_  = sample_rate / blockSize;
     attackShape_  = -1.f;
     attackTarget_ = 0.0f;
@@ -50,18 +52,20 @@ void Adsr::SetTime(int seg, float time)
 
 void Adsr::SetAttackTime(float timeInS, float shape)
 {
-    if((timeInS != attackTime_) || (shape != attackShape_))
+    if(shape != attackShape_)
     {
-        attackTime_  = timeInS;
-        attackShape_ = shape;
+        attackShape_    = shape;
+        float x         = shape;
+        float target    = 9.f * powf(x, 10.f) + 0.3f * x + 1.01f;
+        attackTarget_   = target;
+        attackK_        = -logf(1.f - (1.f / target)); // 1 for decay
+        attackTime_     = -1.f; // coefficient below is stale
+    }
+    if(timeInS != attackTime_)
+    {
+        attackTime_ = timeInS;
         if(timeInS > 0.f)
-        {
-            float x         = shape;
-            float target    = 9.f * powf(x, 10.f) + 0.3f * x + 1.01f;
-            attackTarget_   = target;
-            float logTarget = logf(1.f - (1.f / target)); // -1 for decay
-            attackD0_       = 1.f - expf(logTarget / (timeInS * sample_rate_));
-        }
+            attackD0_ = EnvCoeff::FromTime(timeInS, sample_rate_, attackK_);
         else
             attackD0_ = 1.f; // instant change
     }
@@ -82,10 +86,7 @@ void Adsr::SetTimeConstant(float timeInS, float& time, float& coeff)
     {
         time = timeInS;
         if(time > 0.f)
-        {
-            const float target = logf(1. / M_E);
-            coeff              = 1.f - expf(target / (time * sample_rate_));
-        }
+            coeff = EnvCoeff::FromTime(time, sample_rate_);
         else
             coeff = 1.f; // instant change
     }
@@ -134,3 +135,73 @@ float Adsr::Process(bool gate)
     }
     return out;
 }
+
+void Adsr::ProcessBlock(float* out, size_t size, bool gate)
+{
+    if(gate && !gate_) // rising edge
+        mode_ = ADSR_SEG_ATTACK;
+    else if(!gate && gate_) // falling edge
+        mode_ = ADSR_SEG_RELEASE;
+    gate_ = gate;
+
+    float  x = x_;
+    size_t i = 0;
+    while(i < size)
+    {
+        if(mode_ == ADSR_SEG_ATTACK)
+        {
+            const float d0     = attackD0_;
+            const float target = attackTarget_;
+            for(; i < size; i++)
+            {
+                x += d0 * (target - x);
+                if(x > 1.f)
+                {
+                    x        = 1.f;
+                    out[i++] = x;
+                    mode_    = ADSR_SEG_DECAY;
+                    break;
+                }
+                out[i] = x;
+            }
+        }
+        else if(mode_ == ADSR_SEG_DECAY && sus_level_ >= 0.f)
+        {
+            // A convex step towards a target at or above zero never
+            // crosses it: no transition until the gate falls.
+            const float d0     = decayD0_;
+            const float target = sus_level_;
+            for(; i < size; i++)
+            {
+                x += d0 * (target - x);
+                out[i] = x;
+            }
+        }
+        else if(mode_ != ADSR_SEG_IDLE)
+        {
+            const float d0
+                = mode_ == ADSR_SEG_DECAY ? decayD0_ : releaseD0_;
+            const float target = mode_ == ADSR_SEG_DECAY ? sus_level_ : -0.01f;
+            for(; i < size; i++)
+            {
+                x += d0 * (target - x);
+                if(x < 0.f)
+                {
+                    x        = 0.f;
+                    out[i++] = x;
+                    mode_    = ADSR_SEG_IDLE;
+                    break;
+                }
+                out[i] = x;
+            }
+        }
+        else
+        {
+            for(; i < size; i++)
+            {
+                out[i] = 0.f;
+            }
+        }
+    }
+    x_ = x;
+}
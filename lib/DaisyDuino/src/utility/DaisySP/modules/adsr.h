@@ -3,6 +3,7 @@
 #define DSY_ADSR_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -29,10 +30,16 @@ Original author(s) : Paul Batchelor
 Ported from Soundpipe by Ben Sergentanis, May 2020
  
 Remake by Steffan DIedrichsen, May 2021
+
+Segment coefficients come from EnvCoeff's table, so setting a time
+costs a division and a lookup, no libm; the attack shape alone is
+computed when it changes.
 */
 class Adsr
 {
   public:
+    static const size_t kStateBytes;
+
     Adsr() {}
     ~Adsr() {}
     /** Initializes the Adsr module.
@@ -48,6 +55,14 @@ class Adsr
         \param gate - trigger the envelope, hold it to sustain 
     */
     float Process(bool gate);
+    /** Renders a block, the same as size calls to Process(gate).
+        Each segment runs in its own loop up to the next transition;
+        decay to a sustain above zero has none and runs unchecked.
+        \param out - receives size samples
+        \param size - number of samples
+        \param gate - held for the whole block
+    */
+    void ProcessBlock(float* out, size_t size, bool gate);
     /** Sets time
         Set time per segment in seconds
     */
@@ -83,6 +98,7 @@ class Adsr
     float   x_{0.f};
     float   attackShape_{-1.f};
     float   attackTarget_{0.0f};
+    float   attackK_{0.0f};
     float   attackTime_{-1.0f};
     float   decayTime_{-1.0f};
     float   releaseTime_{-1.0f};
@@ -93,6 +109,8 @@ class Adsr
     uint8_t mode_{ADSR_SEG_IDLE};
     bool    gate_{false};
 };
+
+inline constexpr size_t Adsr::kStateBytes = sizeof(Adsr);
 } // namespace daisysp
 #endif
 #endif
@@ -1,4 +1,5 @@
 #include "allpass.h"
+#include "dsp.h"
 #include <math.h>
 
 using namespace daisysp;
@@ -22,7 +23,7 @@ float Allpass::Process(float in)
     if(prvt_ != rev_time_)
     {
         prvt_ = rev_time_;
-        coef_ = expf(-6.9078 * loop_time_ / prvt_);
+        coef_ = math::exp(-6.9078 * loop_time_ / prvt_);
     }
 
     y              = buf_[buf_pos_];
@@ -35,6 +36,33 @@ float Allpass::Process(float in)
     return out;
 }
 
+void Allpass::ProcessBlock(const float* in, float* out, size_t size)
+{
+    if(prvt_ != rev_time_)
+    {
+        prvt_ = rev_time_;
+        coef_ = math::exp(-6.9078 * loop_time_ / prvt_);
+    }
+
+    const float coef = coef_;
+    const int   mod  = mod_;
+    float*      buf  = buf_;
+    int         pos  = buf_pos_;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        const float y = buf[pos];
+        const float z = coef * y + in[i];
+        buf[pos]      = z;
+        out[i]        = y - coef * z;
+
+        // The % only bites after SetFreq() shortened the loop.
+        if(++pos >= mod)
+            pos %= mod;
+    }
+    buf_pos_ = pos;
+}
+
 void Allpass::SetFreq(float freq)
 {
     loop_time_ = fmaxf(fminf(freq, max_loop_time_), .0001);
@@ -21,6 +21,8 @@ namespace daisysp
 class Allpass
 {
   public:
+    static const size_t kStateBytes;
+
     Allpass() {}
     ~Allpass() {}
 
@@ -38,6 +40,13 @@ class Allpass
     */
     float Process(float in);
 
+    /** Processes a block, the same as Process() on each sample.
+     \param in Input samples.
+     \param out Output samples, may be in.
+     \param size Number of samples.
+    */
+    void ProcessBlock(const float* in, float* out, size_t size);
+
     /**
        Sets the filter frequency (Implemented by delay time).
        \param looptime Filter looptime in seconds.
@@ -55,6 +64,8 @@ class Allpass
     float* buf_;
     int    buf_pos_, mod_;
 };
+
+inline constexpr size_t Allpass::kStateBytes = sizeof(Allpass);
 } // namespace daisysp
 #endif
 #endif
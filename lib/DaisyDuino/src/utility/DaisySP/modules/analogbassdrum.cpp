@@ -1,5 +1,7 @@
 #include "dsp.h"
 #include "analogbassdrum.h"
+#include "semitones.h"
+#include "fast_sin.h"
 #include <cmath>
 
 using namespace daisysp;
@@ -9,6 +11,7 @@ void AnalogBassDrum::Init(float sample_rate)
     sample_rate_ = sample_rate;
 
     trig_ = false;
+    trig_at_.Init();
 
     pulse_remaining_samples_    = 0;
     fm_pulse_remaining_samples_ = 0;
@@ -21,7 +24,13 @@ void AnalogBassDrum::Init(float sample_rate)
     tone_lp_                    = 0.0f;
     sustain_gain_               = 0.0f;
     phase_                      = 0.f;
+    tone_                       = 0.f;
 
+    trigger_pulse_samples_ = static_cast<int>(1.0e-3f * sample_rate_);
+    fm_pulse_samples_      = static_cast<int>(6.0e-3f * sample_rate_);
+    pulse_decay_           = 1.0f - 1.0f / (0.2e-3f * sample_rate_);
+    pulse_filter_          = 1.0f / (0.1e-3f * sample_rate_);
+    retrig_pulse_decay_    = 1.0f - 1.0f / (0.05f * sample_rate_);
 
     SetSustain(false);
     SetAccent(.1f);
@@ -32,6 +41,9 @@ void AnalogBassDrum::Init(float sample_rate)
     SetAttackFmAmount(.5f);
 
     resonator_.Init(sample_rate_);
+    // Retuned every sample: fastsinf() and sqrtf() in place of sinf() and
+    // powf(). Process() takes the new coefficients at once either way.
+    resonator_.SetSmoothing(true);
 }
 
 inline float AnalogBassDrum::Diode(float x)
@@ -47,27 +59,16 @@ inline float AnalogBassDrum::Diode(float x)
     }
 }
 
-float AnalogBassDrum::Process(bool trigger)
+inline float AnalogBassDrum::Render()
 {
-    const int kTriggerPulseDuration  = static_cast<int>(1.0e-3f * sample_rate_);
-    const int kFMPulseDuration       = static_cast<int>(6.0e-3f * sample_rate_);
-    const float kPulseDecayTime      = 0.2e-3f * sample_rate_;
-    const float kPulseFilterTime     = 0.1e-3f * sample_rate_;
-    const float kRetrigPulseDuration = 0.05f * sample_rate_;
-
-    const float scale = 0.001f / f0_;
-    const float q     = 1500.0f * powf(2.f, kOneTwelfth * decay_ * 80.0f);
-    const float tone_f
-        = fmin(4.0f * f0_ * powf(2.f, kOneTwelfth * tone_ * 108.0f), 1.0f);
     const float exciter_leak = 0.08f * (tone_ + 0.25f);
 
-
-    if(trigger || trig_)
+    if(trig_)
     {
         trig_ = false;
 
-        pulse_remaining_samples_    = kTriggerPulseDuration;
-        fm_pulse_remaining_samples_ = kFMPulseDuration;
+        pulse_remaining_samples_    = trigger_pulse_samples_;
+        fm_pulse_remaining_samples_ = fm_pulse_samples_;
         pulse_height_               = 3.0f + 7.0f * accent_;
         lp_out_                     = 0.0f;
     }
@@ -82,7 +83,7 @@ float AnalogBassDrum::Process(bool trigger)
     }
     else
     {
-        pulse_ *= 1.0f - 1.0f / kPulseDecayTime;
+        pulse_ *= pulse_decay_;
         pulse = pulse_;
     }
     if(sustain_)
@@ -91,7 +92,7 @@ float AnalogBassDrum::Process(bool trigger)
     }
 
     // C40 / R163 / R162 / D83
-    fonepole(pulse_lp_, pulse, 1.0f / kPulseFilterTime);
+    fonepole(pulse_lp_, pulse, pulse_filter_);
     pulse = Diode((pulse - pulse_lp_) + pulse * 0.044f);
 
     // Q41 / Q42
@@ -106,13 +107,13 @@ float AnalogBassDrum::Process(bool trigger)
     else
     {
         // C39 / R161
-        retrig_pulse_ *= 1.0f - 1.0f / kRetrigPulseDuration;
+        retrig_pulse_ *= retrig_pulse_decay_;
     }
     if(sustain_)
     {
         fm_pulse = 0.0f;
     }
-    fonepole(fm_pulse_lp_, fm_pulse, 1.0f / kPulseFilterTime);
+    fonepole(fm_pulse_lp_, fm_pulse, pulse_filter_);
 
     // Q43 and R170 leakage
     float punch = 0.7f + Diode(10.0f * lp_out_ - 1.0f);
@@ -130,28 +131,49 @@ float AnalogBassDrum::Process(bool trigger)
         phase_ += f;
         phase_ = phase_ >= 1.f ? phase_ - 1.f : phase_;
 
-        resonator_out = sin(TWOPI_F * phase_) * sustain_gain_;
-        lp_out_       = cos(TWOPI_F * phase_) * sustain_gain_;
+        resonator_out = FastSin::Sin(phase_) * sustain_gain_;
+        lp_out_       = FastSin::Cos(phase_) * sustain_gain_;
     }
     else
     {
         resonator_.SetFreq(f * sample_rate_);
         //resonator_.SetRes(1.0f + q * f);
-        resonator_.SetRes(.4f * q * f);
+        resonator_.SetRes(.4f * q_ * f);
 
-        resonator_.Process((pulse - retrig_pulse_ * 0.2f) * scale);
+        resonator_.Process((pulse - retrig_pulse_ * 0.2f) * scale_);
         resonator_out = resonator_.Band();
         lp_out_       = resonator_.Low();
     }
 
-    fonepole(tone_lp_, pulse * exciter_leak + resonator_out, tone_f);
+    fonepole(tone_lp_, pulse * exciter_leak + resonator_out, tone_f_);
 
     return tone_lp_;
 }
 
-void AnalogBassDrum::Trig()
+float AnalogBassDrum::Process(bool trigger)
+{
+    if(trig_at_.Advance(1) == 0)
+        trig_ = true;
+    trig_ = trig_ || trigger;
+    return Render();
+}
+
+void AnalogBassDrum::ProcessBlock(float *out, size_t size)
+{
+    const size_t at = trig_at_.Advance(size);
+    for(size_t i = 0; i < at; i++)
+        out[i] = Render();
+    if(at < size)
+    {
+        trig_ = true;
+        for(size_t i = at; i < size; i++)
+            out[i] = Render();
+    }
+}
+
+void AnalogBassDrum::Trig(size_t offset)
 {
-    trig_ = true;
+    trig_at_.Set(offset);
 }
 
 void AnalogBassDrum::SetSustain(bool sustain)
@@ -167,18 +189,22 @@ void AnalogBassDrum::SetAccent(float accent)
 void AnalogBassDrum::SetFreq(float f0)
 {
     f0 /= sample_rate_;
-    f0_ = fclamp(f0, 0.f, .5f);
+    f0_    = fclamp(f0, 0.f, .5f);
+    scale_ = 0.001f / f0_;
+    UpdateTone();
 }
 
 void AnalogBassDrum::SetTone(float tone)
 {
     tone_ = fclamp(tone, 0.f, 1.f);
+    UpdateTone();
 }
 
 void AnalogBassDrum::SetDecay(float decay)
 {
     decay_ = decay * .1f;
     decay_ -= .1f;
+    q_ = 1500.0f * SemitonesToRatio(decay_ * 80.0f);
 }
 
 void AnalogBassDrum::SetAttackFmAmount(float attack_fm_amount)
@@ -190,3 +216,8 @@ void AnalogBassDrum::SetSelfFmAmount(float self_fm_amount)
 {
     self_fm_amount_ = self_fm_amount * 50.f;
 }
+
+void AnalogBassDrum::UpdateTone()
+{
+    tone_f_ = fmin(4.0f * f0_ * SemitonesToRatio(tone_ * 108.0f), 1.0f);
+}
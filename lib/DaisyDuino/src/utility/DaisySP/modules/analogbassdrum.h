@@ -7,6 +7,7 @@
 
 #include "oscillator.h"
 #include "svf.h"
+#include "pending_trigger.h"
 
 /** @file analogbassdrum.h */
 
@@ -23,6 +24,8 @@ namespace daisysp
 class AnalogBassDrum
 {
   public:
+    static const size_t kStateBytes;
+
     AnalogBassDrum() {}
     ~AnalogBassDrum() {}
 
@@ -36,8 +39,17 @@ class AnalogBassDrum
 	*/
     float Process(bool trigger = false);
 
-    /** Strikes the drum. */
-    void Trig();
+    /** Fills out with size samples, the same as calling Process() for
+        each; a Trig(offset) before the call strikes offset samples in.
+    */
+    void ProcessBlock(float *out, size_t size);
+
+    /** Strikes the drum.
+        \param offset Samples into the next ProcessBlock() (or Process()
+               calls from now) to strike on; past the block's end it
+               carries into the next. 0, the next sample, by default.
+    */
+    void Trig(size_t offset = 0);
 
     /** Set the bassdrum to play infinitely
 		\param sustain True = infinite length
@@ -77,12 +89,24 @@ class AnalogBassDrum
   private:
     inline float Diode(float x);
 
+    /** One sample; Process() and ProcessBlock() both run it. */
+    inline float Render();
+
+    /** Refresh tone_f_, per change rather than per sample. */
+    void UpdateTone();
+
     float sample_rate_;
 
     float accent_, f0_, tone_, decay_;
     float attack_fm_amount_, self_fm_amount_;
 
+    // From the settings and sample rate above.
+    float scale_, q_, tone_f_;
+    float pulse_decay_, pulse_filter_, retrig_pulse_decay_;
+    int   trigger_pulse_samples_, fm_pulse_samples_;
+
     bool trig_, sustain_;
+    PendingTrigger trig_at_;
 
     int   pulse_remaining_samples_;
     int   fm_pulse_remaining_samples_;
@@ -100,6 +124,8 @@ class AnalogBassDrum
     //for use in sin + cos osc. in sustain mode
     float phase_;
 };
+
+inline constexpr size_t AnalogBassDrum::kStateBytes = sizeof(AnalogBassDrum);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
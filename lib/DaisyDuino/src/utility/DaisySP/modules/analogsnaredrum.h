@@ -3,6 +3,7 @@
 #define DSY_ANALOG_SNARE_H
 
 #include "svf.h"
+#include "fast_random.h"
 
 #include <stdint.h>
 #ifdef __cplusplus
@@ -22,6 +23,8 @@ namespace daisysp
 class AnalogSnareDrum
 {
   public:
+    static const size_t kStateBytes;
+
     AnalogSnareDrum() {}
     ~AnalogSnareDrum() {}
 
@@ -32,6 +35,11 @@ class AnalogSnareDrum
 	*/
     void Init(float sample_rate);
 
+    /** Restarts the noise from a given seed, for repeatable output.
+        Call after Init().
+    */
+    void SetSeed(uint32_t seed);
+
     /** Get the next sample
 		\param trigger Hit the drum with true. Defaults to false.
 	*/
@@ -90,9 +98,13 @@ class AnalogSnareDrum
     Svf resonator_[kNumModes];
     Svf noise_filter_;
 
+    FastRandom rng_;
+
     // Replace the resonators in "free running" (sustain) mode.
     float phase_[kNumModes];
 };
+
+inline constexpr size_t AnalogSnareDrum::kStateBytes = sizeof(AnalogSnareDrum);
 } // namespace daisysp
 #endif
 #endif
@@ -3,6 +3,7 @@
 #define DSY_ATONE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -19,6 +20,8 @@ namespace daisysp
 class ATone
 {
   public:
+    static const size_t kStateBytes;
+
     ATone() {}
     ~ATone() {}
     /** Initializes the ATone module.
@@ -32,6 +35,13 @@ class ATone
     */
     float Process(float &in);
 
+    /** Processes a block, the same as Process() on each sample.
+        \param in - size input samples
+        \param out - size output samples, may be in
+        \param size - number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size);
+
     /** Sets the cutoff frequency or half-way point of the filter.
         \param freq - frequency value in Hz. Range: Any positive value.
     */
@@ -50,6 +60,8 @@ class ATone
     void  CalculateCoefficients();
     float out_, prevout_, in_, freq_, c2_, sample_rate_;
 };
+
+inline constexpr size_t ATone::kStateBytes = sizeof(ATone);
 } // namespace daisysp
 #endif
 #endif
@@ -1,4 +1,5 @@
 #include "autowah.h"
+#include "dsp.h"
 #include <math.h>
 
 using namespace daisysp;
@@ -10,56 +11,93 @@ void Autowah::Init(float sample_rate)
     const1_        = 1413.72f / sampling_freq_;
     const2_        = expf(0.0f - (100.0f / sampling_freq_));
     const4_        = expf(0.0f - (10.0f / sampling_freq_));
+    // The settings' 0.999 per sample smoothing, over a control period.
+    smooth_k_ = powf(0.999f, static_cast<float>(kControlRate));
 
     wet_dry_ = 100.0f;
     level_   = 0.1f;
     wah_     = 0.0;
 
+    env_fast_ = env_slow_ = 0.0f;
+    b1_ = b2_ = gain_ = 0.0f;
+    b1_cur_ = b2_cur_ = gain_cur_ = 0.0f;
+    b1_inc_ = b2_inc_ = gain_inc_ = 0.0f;
+    y1_ = y2_  = 0.0f;
+    countdown_ = 0;
+}
 
-    for(int i = 0; i < 2; i++)
-    {
-        rec1_[i] = rec2_[i] = rec3_[i] = rec4_[i] = rec5_[i] = 0.0f;
-    }
+void Autowah::UpdateControl()
+{
+    const float fTemp2 = fminf(1.0f, env_slow_);
+    const float fTemp3 = math::exp2(2.3f * fTemp2);
+    // fTemp3 / 2^(1 + 2 (1 - fTemp2))
+    const float fTemp4 = 1.0f - const1_ * math::exp2(4.3f * fTemp2 - 3.0f);
 
-    for(int i = 0; i < 3; i++)
-    {
-        rec0_[i] = 0.0f;
-    }
+    const float k = smooth_k_;
+    b1_ = k * b1_ + (1.0f - k) * (-2.0f * fTemp4 * math::cos(const1_ * 2 * fTemp3));
+    b2_ = k * b2_ + (1.0f - k) * (fTemp4 * fTemp4);
+    // 0.0001 in at 0.999 settles at 0.1 of the target.
+    gain_ = k * gain_ + (1.0f - k) * (0.1f * math::exp2(2.0f * fTemp2));
+
+    const float step = 1.0f / kControlRate;
+    b1_inc_          = (b1_ - b1_cur_) * step;
+    b2_inc_          = (b2_ - b2_cur_) * step;
+    gain_inc_        = (gain_ - gain_cur_) * step;
+    countdown_       = kControlRate;
 }
 
 float Autowah::Process(float in)
 {
     float out;
-    float fSlow2 = (0.01f * (wet_dry_ * level_));
-    float fSlow3 = (1.0f - 0.01f * wet_dry_) + (1.f - wah_);
+    ProcessBlock(&in, &out, 1);
+    return out;
+}
 
-    float fTemp1 = fabs(in);
-    rec3_[0]
-        = fmaxf(fTemp1, (const4_ * rec3_[1]) + ((1.0f - const4_) * fTemp1));
-    rec2_[0]     = (const2_ * rec2_[1]) + ((1.0f - const2_) * rec3_[0]);
-    float fTemp2 = fminf(1.0f, rec2_[0]);
-    float fTemp3 = powf(2.0f, (2.3f * fTemp2));
-    float fTemp4
-        = 1.0f
-          - (const1_ * fTemp3 / powf(2.0f, (1.0f + 2.0f * (1.0f - fTemp2))));
-    rec1_[0]
-        = ((0.999f * rec1_[1])
-           + (0.001f
-              * (0.0f - (2.0f * (fTemp4 * cosf((const1_ * 2 * fTemp3)))))));
-    rec4_[0] = ((0.999f * rec4_[1]) + (0.001f * fTemp4 * fTemp4));
-    rec5_[0] = ((0.999f * rec5_[1]) + (0.0001f * powf(4.0f, fTemp2)));
-    rec0_[0] = (0.0f
-                - (((rec1_[0] * rec0_[1]) + (rec4_[0] * rec0_[2]))
-                   - (fSlow2 * (rec5_[0] * in))));
+void Autowah::ProcessBlock(const float *in, float *out, size_t size)
+{
+    const float fSlow2 = (0.01f * (wet_dry_ * level_));
+    const float fSlow3 = (1.0f - 0.01f * wet_dry_) + (1.f - wah_);
+    const float wah    = wah_;
+    const float c2     = const2_;
+    const float c4     = const4_;
 
-    out      = ((wah_ * (rec0_[0] - rec0_[1])) + (fSlow3 * in));
-    rec3_[1] = rec3_[0];
-    rec2_[1] = rec2_[0];
-    rec1_[1] = rec1_[0];
-    rec4_[1] = rec4_[0];
-    rec5_[1] = rec5_[0];
-    rec0_[2] = rec0_[1];
-    rec0_[1] = rec0_[0];
+    float env_fast = env_fast_, env_slow = env_slow_;
+    float y1 = y1_, y2 = y2_;
 
-    return out;
+    size_t i = 0;
+    while(i < size)
+    {
+        if(countdown_ == 0)
+        {
+            env_slow_ = env_slow;
+            UpdateControl();
+        }
+        const size_t n   = countdown_ < size - i ? countdown_ : size - i;
+        const size_t end = i + n;
+        float        b1 = b1_cur_, b2 = b2_cur_, g = gain_cur_;
+        for(; i < end; i++)
+        {
+            const float x = in[i];
+            const float a = fabsf(x);
+            env_fast      = fmaxf(a, (c4 * env_fast) + ((1.0f - c4) * a));
+            env_slow      = (c2 * env_slow) + ((1.0f - c2) * env_fast);
+
+            b1 += b1_inc_;
+            b2 += b2_inc_;
+            g += gain_inc_;
+            const float y = (fSlow2 * g * x) - ((b1 * y1) + (b2 * y2));
+            out[i]        = (wah * (y - y1)) + (fSlow3 * x);
+            y2            = y1;
+            y1            = y;
+        }
+        b1_cur_   = b1;
+        b2_cur_   = b2;
+        gain_cur_ = g;
+        countdown_ -= n;
+    }
+
+    env_fast_ = env_fast;
+    env_slow_ = env_slow;
+    y1_       = y1;
+    y2_       = y2;
 }
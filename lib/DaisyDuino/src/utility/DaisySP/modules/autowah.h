@@ -3,6 +3,7 @@
 #define DSY_AUTOWAH_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -12,10 +13,17 @@ namespace daisysp
     Original author(s) :
 
     Ported from soundpipe by Ben Sergentanis, May 2020
+
+    The envelope followers run every sample; the resonator's pitch,
+    damping and gain are worked out from them every kControlRate
+    samples and ramped linearly in between, so the exp2f/cosf calls
+    are at control rate and the audio loop is a biquad.
 */
 class Autowah
 {
   public:
+    static const size_t kStateBytes;
+
     Autowah() {}
     ~Autowah() {}
     /** Initializes the Autowah module.
@@ -29,6 +37,13 @@ class Autowah
     */
     float Process(float in);
 
+    /** Wah'd block
+        \param in - input samples
+        \param out - output samples, may be in
+        \param size - number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size);
+
 
     /** sets wah
         \param wah : set wah amount, , 0...1.0
@@ -43,10 +58,24 @@ class Autowah
     */
     inline void SetLevel(float level) { level_ = level; }
 
+    /** Samples between resonator updates */
+    static constexpr size_t kControlRate = 16;
+
   private:
-    float sampling_freq_, const1_, const2_, const4_, wah_, level_, wet_dry_,
-        rec0_[3], rec1_[2], rec2_[2], rec3_[2], rec4_[2], rec5_[2];
+    /** Next resonator settings from the envelope, and ramps to them */
+    void UpdateControl();
+
+    float sampling_freq_, const1_, const2_, const4_, smooth_k_, wah_,
+        level_, wet_dry_;
+    float  env_fast_, env_slow_;  /**< envelope followers */
+    float  b1_, b2_, gain_;       /**< smoothed settings, at control points */
+    float  b1_inc_, b2_inc_, gain_inc_;
+    float  b1_cur_, b2_cur_, gain_cur_; /**< ramped, per sample */
+    float  y1_, y2_;
+    size_t countdown_;
 };
+
+inline constexpr size_t Autowah::kStateBytes = sizeof(Autowah);
 } // namespace daisysp
 #endif
 #endif
@@ -6,15 +6,25 @@ using namespace daisysp;
 
 void Balance::Init(float sample_rate)
 {
-    float b;
     sample_rate_ = sample_rate;
-    ihp_         = 10.0f;
-    b            = 2.0f - cosf(ihp_ * (TWOPI_F / sample_rate_));
-    c2_          = b - sqrtf(b * b - 1.0f);
-    c1_          = 1.0f - c2_;
+    SetCutoff(10.0f);
     prvq_ = prvr_ = prva_ = 0.0f;
 }
 
+void Balance::SetCutoff(float cutoff)
+{
+    float b;
+    ihp_ = cutoff;
+    b    = 2.0f - cosf(ihp_ * (TWOPI_F / sample_rate_));
+    c2_  = b - math::sqrt(b * b - 1.0f);
+    c1_  = 1.0f - c2_;
+}
+
+inline float Balance::Gain(float q, float r)
+{
+    return q != 0.0f ? math::sqrt(r / q) : math::sqrt(r);
+}
+
 float Balance::Process(float sig, float comp)
 {
     float q, r, a, diff, out;
@@ -32,14 +42,7 @@ float Balance::Process(float sig, float comp)
     prvq_ = q;
     prvr_ = r;
 
-    if(q != 0.0f)
-    {
-        a = sqrtf(r / q);
-    }
-    else
-    {
-        a = sqrtf(r);
-    }
+    a = Gain(q, r);
 
     if((diff = a - prva_) != 0.0f)
     {
@@ -54,3 +57,37 @@ float Balance::Process(float sig, float comp)
 
     return out;
 }
+
+void Balance::ProcessBlock(const float *sig,
+                           const float *comp,
+                           float *      out,
+                           size_t       size)
+{
+    if(size == 0)
+        return;
+    const float c1 = c1_;
+    const float c2 = c2_;
+    float       q  = prvq_;
+    float       r  = prvr_;
+
+    // The gain ramps from where it was to where the followers are at
+    // the end of the block; the followers do not depend on it, so they
+    // run first.
+    for(size_t i = 0; i < size; i++)
+    {
+        q = c1 * sig[i] * sig[i] + c2 * q;
+        r = c1 * comp[i] * comp[i] + c2 * r;
+    }
+    const float a    = Gain(q, r);
+    const float step = (a - prva_) / size;
+    float       g    = prva_;
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = sig[i] * g;
+        g += step;
+    }
+
+    prvq_ = q;
+    prvr_ = r;
+    prva_ = a;
+}
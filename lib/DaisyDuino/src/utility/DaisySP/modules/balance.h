@@ -4,6 +4,7 @@
 #define DSY_BALANCE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -15,10 +16,15 @@ namespace daisysp
     *Year: 1991
 
     *Ported from soundpipe by Ben Sergentanis, May 2020
+
+    ProcessBlock() runs the two power followers per sample but takes the
+    square root and the division once per block, ramping the gain to it.
 */
 class Balance
 {
   public:
+    static const size_t kStateBytes;
+
     Balance() {}
     ~Balance() {}
     /** Initializes the balance module.
@@ -31,17 +37,30 @@ class Balance
     */
     float Process(float sig, float comp);
 
+    /** adjust a block of sig to the level of comp
+        \param sig Signal to adjust
+        \param comp Comparator signal
+        \param out Adjusted signal, may be sig
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *sig, const float *comp, float *out, size_t size);
+
 
     /** adjusts the rate at which level compensation happens
         \param cutoff : Sets half power point of special internal cutoff filter.
 
         defaults to 10
     */
-    inline void SetCutoff(float cutoff) { ihp_ = cutoff; }
+    void SetCutoff(float cutoff);
 
   private:
+    /** gain for the follower levels */
+    static inline float Gain(float q, float r);
+
     float sample_rate_, ihp_, c2_, c1_, prvq_, prvr_, prva_;
 };
+
+inline constexpr size_t Balance::kStateBytes = sizeof(Balance);
 } // namespace daisysp
 #endif
 #endif
@@ -6,21 +6,61 @@ using namespace daisysp;
 
 void Biquad::Reset()
 {
-    float con   = cutoff_ * two_pi_d_sr_;
-    float alpha = 1.0f - 2.0f * res_ * cosf(con) * cosf(con)
-                  + res_ * res_ * cosf(2 * con);
-    float beta  = 1.0f + cosf(con);
-    float gamma = 1 + cosf(con);
-    float m1    = alpha * gamma + beta * sinf(con);
-    float m2    = alpha * gamma - beta * sinf(con);
-    float den   = sqrtf(m1 * m1 + m2 * m2);
+    if(smooth_)
+    {
+        ResetFast();
+        return;
+    }
+
+    const float con = cutoff_ * two_pi_d_sr_;
+    const auto  design = [](float x) -> Trig {
+        return {cosf(x), sinf(x), cosf(2 * x)};
+    };
+    const Trig t = cache_ ? cache_->Get(con, design) : design(con);
+
+    float alpha = 1.0f - 2.0f * res_ * t.c * t.c + res_ * res_ * t.c2;
+    float beta  = 1.0f + t.c;
+    float gamma = 1 + t.c;
+    float m1    = alpha * gamma + beta * t.s;
+    float m2    = alpha * gamma - beta * t.s;
+    float den   = math::sqrt(m1 * m1 + m2 * m2);
 
     b0_ = 1.5f * (alpha * alpha + beta * beta) / den;
     b1_ = b0_;
     b2_ = 0.0f;
     a0_ = 1.0f;
-    a1_ = -2.0 * res_ * cosf(con);
+    a1_ = -2.0 * res_ * t.c;
     a2_ = res_ * res_;
+
+    tb0_ = b0_;
+    ta1_ = a1_;
+    ta2_ = a2_;
+}
+
+void Biquad::ResetFast()
+{
+    float con = cutoff_ * two_pi_d_sr_;
+    con       = con > PI_F ? PI_F : con;
+
+    // cos(2 con) from cos(con), so one sin and one cos for the lot.
+    const float c     = fastcosf(con);
+    const float s     = fastsinf(con);
+    const float alpha = 1.0f - 2.0f * res_ * c * c + res_ * res_ * (2.0f * c * c - 1.0f);
+    const float beta  = 1.0f + c;
+    const float m1    = alpha * beta + beta * s;
+    const float m2    = alpha * beta - beta * s;
+    const float den   = math::sqrt(m1 * m1 + m2 * m2);
+
+    tb0_ = 1.5f * (alpha * alpha + beta * beta) / den;
+    ta1_ = -2.0f * res_ * c;
+    ta2_ = res_ * res_;
+}
+
+void Biquad::SetSmoothing(bool enable)
+{
+    smooth_ = enable;
+    if(!enable)
+        Reset();
 }
 
 void Biquad::Init(float sample_rate)
@@ -30,6 +70,8 @@ void Biquad::Init(float sample_rate)
 
     cutoff_ = 500;
     res_    = 0.7;
+    smooth_ = false;
+    cache_  = nullptr;
 
     Reset();
 
@@ -38,6 +80,13 @@ void Biquad::Init(float sample_rate)
 
 float Biquad::Process(float in)
 {
+    if(smooth_)
+    {
+        b0_ = b1_ = tb0_;
+        a1_       = ta1_;
+        a2_       = ta2_;
+    }
+
     float xn, yn;
     float a0 = a0_, a1 = a1_, a2 = a2_;
     float b0 = b0_, b1 = b1_, b2 = b2_;
@@ -57,3 +106,60 @@ float Biquad::Process(float in)
 
     return yn;
 }
+
+void Biquad::ProcessBlock(const float* in, float* out, size_t size)
+{
+    if(smooth_ && size > 0 && (b0_ != tb0_ || a1_ != ta1_ || a2_ != ta2_))
+        Run<true>(in, out, size);
+    else
+        Run<false>(in, out, size);
+}
+
+template <bool ramp>
+void Biquad::Run(const float* in, float* out, size_t size)
+{
+    float b0 = b0_, b1 = b1_, a1 = a1_, a2 = a2_;
+    const float b2 = b2_;
+    // a0_ is 1 for every design Reset() makes, where this is exact.
+    const float inv_a0 = 1.0f / a0_;
+    float       xnm1 = xnm1_, xnm2 = xnm2_, ynm1 = ynm1_, ynm2 = ynm2_;
+
+    float db0 = 0.0f, da1 = 0.0f, da2 = 0.0f;
+    if(ramp)
+    {
+        const float inv_size = 1.0f / (float)size;
+        db0                  = (tb0_ - b0) * inv_size;
+        da1                  = (ta1_ - a1) * inv_size;
+        da2                  = (ta2_ - a2) * inv_size;
+    }
+
+    for(size_t i = 0; i < size; i++)
+    {
+        if(ramp)
+        {
+            b0 += db0;
+            b1 = b0;
+            a1 += da1;
+            a2 += da2;
+        }
+        const float xn = in[i];
+        const float yn
+            = (b0 * xn + b1 * xnm1 + b2 * xnm2 - a1 * ynm1 - a2 * ynm2) * inv_a0;
+        xnm2   = xnm1;
+        xnm1   = xn;
+        ynm2   = ynm1;
+        ynm1   = yn;
+        out[i] = yn;
+    }
+
+    if(ramp)
+    {
+        b0_ = b1_ = tb0_;
+        a1_       = ta1_;
+        a2_       = ta2_;
+    }
+    xnm1_ = xnm1;
+    xnm2_ = xnm2;
+    ynm1_ = ynm1;
+    ynm2_ = ynm2;
+}
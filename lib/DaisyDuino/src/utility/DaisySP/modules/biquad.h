@@ -3,6 +3,8 @@
 #define DSY_BIQUAD_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include "coeff_cache.h"
 #ifdef __cplusplus
 
 namespace daisysp
@@ -18,6 +20,19 @@ namespace daisysp
 class Biquad
 {
   public:
+    static const size_t kStateBytes;
+
+    /** cos, sin and cos 2x of the cutoff's angle, all the libm a design
+        takes; the resonance only enters the arithmetic after.
+    */
+    struct Trig
+    {
+        float c, s, c2;
+    };
+
+    /** Designs keyed on the cutoff's angle, for SetCache() */
+    typedef CoeffCache<float, Trig, 8> Cache;
+
     Biquad() {}
     ~Biquad() {}
     /** Initializes the biquad module.
@@ -31,6 +46,30 @@ class Biquad
     */
     float Process(float in);
 
+    /** Filters a block, the same as Process() on each sample.
+        \param in - size input samples
+        \param out - size output samples, may be in
+        \param size - number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size);
+
+
+    /** Coefficient interpolation, for a cutoff or resonance that moves
+        every block. With it on, SetCutoff() and SetRes() only compute new
+        target coefficients, with fastsinf() / fastcosf() instead of libm,
+        and ProcessBlock() ramps the coefficients linearly to them across
+        the block. Process() jumps straight to the target. Off after
+        Init(); switching it off applies the exact coefficients.
+    */
+    void SetSmoothing(bool enable);
+
+    /** Looks the cutoff's trig up in cache, shared by any filters set
+        from the same context, rather than calling libm on every change:
+        going back to a recent cutoff costs a scan of it. The output is
+        the same. nullptr, the default after Init(), for none. Only the
+        exact coefficients use it; smoothing's fast ones are cheaper.
+    */
+    inline void SetCache(Cache* cache) { cache_ = cache; }
 
     /** Sets resonance amount
         \param res : Set filter resonance.
@@ -54,8 +93,17 @@ class Biquad
   private:
     float sample_rate_, cutoff_, res_, b0_, b1_, b2_, a0_, a1_, a2_,
         two_pi_d_sr_, xnm1_, xnm2_, ynm1_, ynm2_;
-    void Reset();
+    // Targets of the smoothing ramp; b1 follows b0, b2 and a0 are fixed.
+    float tb0_, ta1_, ta2_;
+    bool   smooth_;
+    Cache* cache_;
+    void   Reset();
+    void   ResetFast();
+    template <bool ramp>
+    void Run(const float* in, float* out, size_t size);
 };
+
+inline constexpr size_t Biquad::kStateBytes = sizeof(Biquad);
 } // namespace daisysp
 #endif
 #endif
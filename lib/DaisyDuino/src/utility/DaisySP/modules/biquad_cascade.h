@@ -0,0 +1,343 @@
+#pragma once
+#ifndef DSY_BIQUAD_CASCADE_H
+#define DSY_BIQUAD_CASCADE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef USE_ARM_DSP
+#include "arm_math.h" // required for platform-optimized version
+#endif
+
+namespace daisysp
+{
+/** Normalized second order section coefficients (a0 == 1).
+
+    Transfer function:
+    H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+*/
+struct BiquadSection
+{
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+    float a1 = 0.0f, a2 = 0.0f;
+};
+
+/** Cascade of num_stages transposed direct form II biquads,
+    processed a whole block at a time.
+
+    Each stage runs over the full block before the next one starts,
+    so a stage's two state variables and five coefficients stay in
+    registers for the entire inner loop instead of being reloaded
+    per sample.
+
+    On ARM with USE_ARM_DSP defined, ProcessBlock() is backed by
+    CMSIS arm_biquad_cascade_df2T_f32.
+
+    declaration example:
+
+    BiquadCascade<3> baseband; // HPF -> LPF -> low shelf
+*/
+template <size_t num_stages>
+class BiquadCascade
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(num_stages > 0, "BiquadCascade needs at least one stage");
+
+    BiquadCascade() {}
+    ~BiquadCascade() {}
+
+    /** Copies keep filtering on their own arrays: the CMSIS instance
+        is pointed at the copy's coefficients and state, not left on
+        the source's. */
+    BiquadCascade(const BiquadCascade& other) { *this = other; }
+    BiquadCascade& operator=(const BiquadCascade& other)
+    {
+        for(size_t i = 0; i < num_stages; i++)
+        {
+            sections_[i] = other.sections_[i];
+        }
+        for(size_t i = 0; i < 2 * num_stages; i++)
+        {
+            state_[i] = other.state_[i];
+        }
+        Sync();
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        // Not arm_biquad_cascade_df2T_init_f32(), which clears the state.
+        arm_.numStages = num_stages;
+        arm_.pState    = state_;
+        arm_.pCoeffs   = arm_coefs_;
+#endif
+        return *this;
+    }
+
+    /** Sets every stage to passthrough and clears the state.
+        Must be called before processing.
+    */
+    void Init()
+    {
+        for(size_t i = 0; i < num_stages; i++)
+        {
+            sections_[i] = BiquadSection();
+        }
+        Sync();
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        arm_biquad_cascade_df2T_init_f32(&arm_, num_stages, arm_coefs_, state_);
+#endif
+        Reset();
+    }
+
+    /** Clears the filter state, keeping the coefficients. */
+    void Reset()
+    {
+        for(size_t i = 0; i < 2 * num_stages; i++)
+        {
+            state_[i] = 0.0f;
+        }
+    }
+
+    /** Sets the coefficients of one stage. Does not touch the state.
+        \param idx - stage index, 0 is applied first
+        \param section - normalized coefficients for that stage
+    */
+    void SetSection(size_t idx, const BiquadSection& section)
+    {
+        if(idx >= num_stages)
+            return;
+        sections_[idx] = section;
+        Sync();
+    }
+
+    /** Returns the coefficients of one stage. */
+    const BiquadSection& GetSection(size_t idx) const
+    {
+        return sections_[idx < num_stages ? idx : num_stages - 1];
+    }
+
+    /** Number of stages in the cascade. */
+    static constexpr size_t GetNumStages() { return num_stages; }
+
+    /** Filters a single sample through every stage. */
+    inline float Process(float in)
+    {
+        float x = in;
+        for(size_t s = 0; s < num_stages; s++)
+        {
+            const BiquadSection& c  = sections_[s];
+            float*               st = &state_[2 * s];
+            const float          y  = c.b0 * x + st[0];
+            st[0]                   = c.b1 * x - c.a1 * y + st[1];
+            st[1]                   = c.b2 * x - c.a2 * y;
+            x                       = y;
+        }
+        return x;
+    }
+
+    /** Filters a block through every stage.
+        in and out may point to the same buffer.
+        \param in - input samples
+        \param out - output samples
+        \param size - number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        arm_biquad_cascade_df2T_f32(&arm_, const_cast<float*>(in), out, size);
+#else
+        const float* src = in;
+        for(size_t s = 0; s < num_stages; s++)
+        {
+            const float b0 = sections_[s].b0, b1 = sections_[s].b1,
+                        b2 = sections_[s].b2;
+            const float a1 = sections_[s].a1, a2 = sections_[s].a2;
+            float       z1 = state_[2 * s], z2 = state_[2 * s + 1];
+            for(size_t i = 0; i < size; i++)
+            {
+                const float x = src[i];
+                const float y = b0 * x + z1;
+                z1            = b1 * x - a1 * y + z2;
+                z2            = b2 * x - a2 * y;
+                out[i]        = y;
+            }
+            state_[2 * s]     = z1;
+            state_[2 * s + 1] = z2;
+            src               = out;
+        }
+#endif
+    }
+
+  private:
+    /** Mirrors the sections into the CMSIS coefficient layout
+        {b0, b1, b2, -a1, -a2} per stage. The CMSIS instance keeps a
+        pointer to that array, so updates take effect without touching
+        the state. No-op on generic builds. */
+    void Sync()
+    {
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        for(size_t s = 0; s < num_stages; s++)
+        {
+            arm_coefs_[5 * s + 0] = sections_[s].b0;
+            arm_coefs_[5 * s + 1] = sections_[s].b1;
+            arm_coefs_[5 * s + 2] = sections_[s].b2;
+            arm_coefs_[5 * s + 3] = -sections_[s].a1;
+            arm_coefs_[5 * s + 4] = -sections_[s].a2;
+        }
+#endif
+    }
+
+    BiquadSection sections_[num_stages];
+    float         state_[2 * num_stages];
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+    float                                  arm_coefs_[5 * num_stages];
+    arm_biquad_cascade_df2T_instance_f32 arm_;
+#endif
+};
+
+template <size_t num_stages>
+constexpr size_t BiquadCascade<num_stages>::kStateBytes
+    = sizeof(BiquadCascade<num_stages>);
+
+/** Two-channel version of BiquadCascade with shared coefficients.
+
+    Left and right run in lockstep through each stage: the five
+    coefficients are loaded once per stage and both channels' state
+    is updated in the same inner loop. The two recursions are
+    independent, which gives the M7's dual-issue FPU two dependency
+    chains to interleave instead of one.
+
+    Works on planar (non-interleaved) buffers, as handed out by
+    AudioHandle::AudioCallback.
+
+    declaration example:
+
+    StereoBiquadCascade<5> band; // identical L/R band-limit filters
+*/
+template <size_t num_stages>
+class StereoBiquadCascade
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(num_stages > 0,
+                  "StereoBiquadCascade needs at least one stage");
+
+    StereoBiquadCascade() {}
+    ~StereoBiquadCascade() {}
+
+    /** Sets every stage to passthrough and clears the state. */
+    void Init()
+    {
+        for(size_t i = 0; i < num_stages; i++)
+        {
+            sections_[i] = BiquadSection();
+        }
+        Reset();
+    }
+
+    /** Clears the filter state of both channels, keeping the coefficients. */
+    void Reset()
+    {
+        for(size_t i = 0; i < num_stages; i++)
+        {
+            state_[i] = StereoState();
+        }
+    }
+
+    /** Sets the coefficients of one stage for both channels. */
+    void SetSection(size_t idx, const BiquadSection& section)
+    {
+        if(idx < num_stages)
+            sections_[idx] = section;
+    }
+
+    /** Returns the coefficients of one stage. */
+    const BiquadSection& GetSection(size_t idx) const
+    {
+        return sections_[idx < num_stages ? idx : num_stages - 1];
+    }
+
+    /** Number of stages in the cascade. */
+    static constexpr size_t GetNumStages() { return num_stages; }
+
+    /** Filters one frame through every stage.
+        \param l - left sample, replaced by the filtered value
+        \param r - right sample, replaced by the filtered value
+    */
+    inline void Process(float& l, float& r)
+    {
+        for(size_t s = 0; s < num_stages; s++)
+        {
+            const BiquadSection& c  = sections_[s];
+            StereoState&         st = state_[s];
+            const float          yl = c.b0 * l + st.z1l;
+            const float          yr = c.b0 * r + st.z1r;
+            st.z1l                  = c.b1 * l - c.a1 * yl + st.z2l;
+            st.z1r                  = c.b1 * r - c.a1 * yr + st.z2r;
+            st.z2l                  = c.b2 * l - c.a2 * yl;
+            st.z2r                  = c.b2 * r - c.a2 * yr;
+            l                       = yl;
+            r                       = yr;
+        }
+    }
+
+    /** Filters a stereo block through every stage.
+        Input and output buffers may alias channel-wise (in_l == out_l).
+        \param in_l, in_r - input samples
+        \param out_l, out_r - output samples
+        \param size - number of frames
+    */
+    void ProcessBlock(const float* in_l,
+                      const float* in_r,
+                      float*       out_l,
+                      float*       out_r,
+                      size_t       size)
+    {
+        const float* src_l = in_l;
+        const float* src_r = in_r;
+        for(size_t s = 0; s < num_stages; s++)
+        {
+            const float b0 = sections_[s].b0, b1 = sections_[s].b1,
+                        b2 = sections_[s].b2;
+            const float a1 = sections_[s].a1, a2 = sections_[s].a2;
+            float       z1l = state_[s].z1l, z2l = state_[s].z2l;
+            float       z1r = state_[s].z1r, z2r = state_[s].z2r;
+            for(size_t i = 0; i < size; i++)
+            {
+                const float xl = src_l[i];
+                const float xr = src_r[i];
+                const float yl = b0 * xl + z1l;
+                const float yr = b0 * xr + z1r;
+                z1l            = b1 * xl - a1 * yl + z2l;
+                z1r            = b1 * xr - a1 * yr + z2r;
+                z2l            = b2 * xl - a2 * yl;
+                z2r            = b2 * xr - a2 * yr;
+                out_l[i]       = yl;
+                out_r[i]       = yr;
+            }
+            state_[s].z1l = z1l;
+            state_[s].z2l = z2l;
+            state_[s].z1r = z1r;
+            state_[s].z2r = z2r;
+            src_l         = out_l;
+            src_r         = out_r;
+        }
+    }
+
+  private:
+    /** Per-stage state, both channels adjacent in memory. */
+    struct StereoState
+    {
+        float z1l = 0.0f, z1r = 0.0f, z2l = 0.0f, z2r = 0.0f;
+    };
+
+    BiquadSection sections_[num_stages];
+    StereoState   state_[num_stages];
+};
+
+template <size_t num_stages>
+constexpr size_t StereoBiquadCascade<num_stages>::kStateBytes
+    = sizeof(StereoBiquadCascade<num_stages>);
+
+} // namespace daisysp
+#endif
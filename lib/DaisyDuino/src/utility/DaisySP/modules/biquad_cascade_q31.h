@@ -0,0 +1,217 @@
+#pragma once
+#ifndef DSY_BIQUAD_CASCADE_Q31_H
+#define DSY_BIQUAD_CASCADE_Q31_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "biquad_cascade.h"
+
+#ifdef USE_ARM_DSP
+#include "arm_math.h" // required for platform-optimized version
+#endif
+
+namespace daisysp
+{
+/** Two-channel fixed-point biquad cascade, Q31 samples.
+
+    Direct form I with a 64-bit accumulator and 64-bit (Q63) feedback
+    state, the same arithmetic as CMSIS arm_biquad_cas_df1_32x64_q31.
+    Keeping the recursive state at 64 bits is what makes fixed point
+    usable for low corners: a 200 Hz section at 96 kHz has poles within
+    1% of the unit circle, and a 32-bit state would feed its own
+    rounding noise back through that near-unity gain.
+
+    Coefficients are set from the same float BiquadSection as the float
+    cascades and stored in Q(31 - post_shift), so they span
+    +/- 2^post_shift. The default of 2 covers the shelves and the
+    a1 ~ -2 of low-corner sections.
+
+    There is no headroom inside the format: outputs at or above full
+    scale saturate on generic builds, and wrap in the CMSIS kernel.
+    Scale the signal so the filters' peak gain stays below full scale.
+
+    Like StereoBiquadCascade, left and right share the coefficients and
+    run in lockstep through each stage. On ARM with USE_ARM_DSP
+    defined, ProcessBlock() runs one CMSIS instance per channel.
+
+    declaration example:
+
+    StereoBiquadCascadeQ31<3> band; // HPF + two LPF, Q31 samples
+*/
+template <size_t num_stages, int post_shift = 2>
+class StereoBiquadCascadeQ31
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(num_stages > 0,
+                  "StereoBiquadCascadeQ31 needs at least one stage");
+    static_assert(post_shift >= 0 && post_shift < 8,
+                  "post_shift must leave most of the coefficient bits");
+
+    StereoBiquadCascadeQ31() {}
+    ~StereoBiquadCascadeQ31() {}
+
+    /** Sets every stage to passthrough and clears the state. */
+    void Init()
+    {
+        for(size_t i = 0; i < num_stages; i++)
+        {
+            SetSection(i, BiquadSection());
+        }
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        arm_biquad_cas_df1_32x64_init_q31(
+            &arm_l_, num_stages, coefs_, arm_state_l_, post_shift);
+        arm_biquad_cas_df1_32x64_init_q31(
+            &arm_r_, num_stages, coefs_, arm_state_r_, post_shift);
+#endif
+        Reset();
+    }
+
+    /** Clears the filter state of both channels, keeping the coefficients. */
+    void Reset()
+    {
+        for(size_t i = 0; i < num_stages; i++)
+        {
+            state_l_[i] = State();
+            state_r_[i] = State();
+        }
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        for(size_t i = 0; i < 4 * num_stages; i++)
+        {
+            arm_state_l_[i] = 0;
+            arm_state_r_[i] = 0;
+        }
+#endif
+    }
+
+    /** Quantizes and sets the coefficients of one stage for both
+        channels. Does not touch the state.
+        \param idx - stage index, 0 is applied first
+        \param section - normalized float coefficients for that stage
+    */
+    void SetSection(size_t idx, const BiquadSection& section)
+    {
+        if(idx >= num_stages)
+            return;
+        // Stored as {b0, b1, b2, -a1, -a2}, the CMSIS layout.
+        int32_t* c = &coefs_[5 * idx];
+        c[0]       = ToCoef(section.b0);
+        c[1]       = ToCoef(section.b1);
+        c[2]       = ToCoef(section.b2);
+        c[3]       = ToCoef(-section.a1);
+        c[4]       = ToCoef(-section.a2);
+    }
+
+    /** Number of stages in the cascade. */
+    static constexpr size_t GetNumStages() { return num_stages; }
+
+    /** Filters a stereo block through every stage.
+        Input and output buffers may alias channel-wise (in_l == out_l).
+        \param in_l, in_r - input samples, Q31
+        \param out_l, out_r - output samples, Q31
+        \param size - number of frames
+    */
+    void ProcessBlock(const int32_t* in_l,
+                      const int32_t* in_r,
+                      int32_t*       out_l,
+                      int32_t*       out_r,
+                      size_t         size)
+    {
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        arm_biquad_cas_df1_32x64_q31(
+            &arm_l_, const_cast<int32_t*>(in_l), out_l, size);
+        arm_biquad_cas_df1_32x64_q31(
+            &arm_r_, const_cast<int32_t*>(in_r), out_r, size);
+#else
+        const int32_t* src_l = in_l;
+        const int32_t* src_r = in_r;
+        for(size_t s = 0; s < num_stages; s++)
+        {
+            const int32_t* c  = &coefs_[5 * s];
+            const int32_t  b0 = c[0], b1 = c[1], b2 = c[2];
+            const int32_t  a1 = c[3], a2 = c[4];
+            State          l = state_l_[s];
+            State          r = state_r_[s];
+            for(size_t i = 0; i < size; i++)
+            {
+                const int32_t xl = src_l[i];
+                const int32_t xr = src_r[i];
+                out_l[i]         = Step(l, xl, b0, b1, b2, a1, a2);
+                out_r[i]         = Step(r, xr, b0, b1, b2, a1, a2);
+            }
+            state_l_[s] = l;
+            state_r_[s] = r;
+            src_l       = out_l;
+            src_r       = out_r;
+        }
+#endif
+    }
+
+  private:
+    /** Per-stage, per-channel DF1 state. */
+    struct State
+    {
+        int32_t x1 = 0, x2 = 0;
+        int64_t y1 = 0, y2 = 0; // Q63
+    };
+
+    static constexpr int     kShift  = post_shift + 1;
+    static constexpr int64_t kAccMax = (int64_t)1 << (62 - post_shift);
+
+    static int32_t ToCoef(float c)
+    {
+        const float scale = (float)(1u << (31 - post_shift));
+        const float v     = c * scale;
+        if(v >= 2147483647.0f)
+            return INT32_MAX;
+        if(v <= -2147483648.0f)
+            return INT32_MIN;
+        return (int32_t)(v + (v >= 0.0f ? 0.5f : -0.5f));
+    }
+
+    /** (Q63 * Q31) >> 32, as CMSIS mult32x64(). */
+    static inline int64_t Mul32x64(int64_t y, int32_t c)
+    {
+        return ((int64_t)(uint32_t)y * c >> 32) + (y >> 32) * c;
+    }
+
+    static inline int32_t Step(State&  st,
+                               int32_t x,
+                               int32_t b0,
+                               int32_t b1,
+                               int32_t b2,
+                               int32_t a1,
+                               int32_t a2)
+    {
+        int64_t acc = (int64_t)b0 * x + (int64_t)b1 * st.x1
+                      + (int64_t)b2 * st.x2 + Mul32x64(st.y1, a1)
+                      + Mul32x64(st.y2, a2);
+        // Q(62 - post_shift); clamp so the Q63 shift below cannot wrap.
+        acc = acc >= kAccMax ? kAccMax - 1 : acc;
+        acc = acc < -kAccMax ? -kAccMax : acc;
+        const int64_t y = acc * ((int64_t)1 << kShift);
+        st.x2           = st.x1;
+        st.x1           = x;
+        st.y2           = st.y1;
+        st.y1           = y;
+        return (int32_t)(y >> 32);
+    }
+
+    int32_t coefs_[5 * num_stages];
+    State   state_l_[num_stages];
+    State   state_r_[num_stages];
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+    int64_t                           arm_state_l_[4 * num_stages];
+    int64_t                           arm_state_r_[4 * num_stages];
+    arm_biquad_cas_df1_32x64_ins_q31 arm_l_;
+    arm_biquad_cas_df1_32x64_ins_q31 arm_r_;
+#endif
+};
+
+template <size_t num_stages, int post_shift>
+constexpr size_t StereoBiquadCascadeQ31<num_stages, post_shift>::kStateBytes
+    = sizeof(StereoBiquadCascadeQ31<num_stages, post_shift>);
+
+} // namespace daisysp
+#endif
@@ -3,6 +3,7 @@
 #define DSY_BITCRUSH_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -16,6 +17,8 @@ Ported from soundpipe by Ben Sergentanis, May 2020
 class Bitcrush
 {
   public:
+    static const size_t kStateBytes;
+
     Bitcrush() {}
     ~Bitcrush() {}
     /** Initializes the bitcrush module.
@@ -42,6 +45,8 @@ class Bitcrush
     float sample_rate_, crush_rate_;
     int   bit_depth_;
 };
+
+inline constexpr size_t Bitcrush::kStateBytes = sizeof(Bitcrush);
 } // namespace daisysp
 #endif
 #endif
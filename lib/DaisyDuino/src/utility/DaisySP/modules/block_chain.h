@@ -0,0 +1,262 @@
+#pragma once
+#ifndef DSY_BLOCK_CHAIN_H
+#define DSY_BLOCK_CHAIN_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <tuple>
+#include <utility>
+
+/** @file block_chain.h */
+
+namespace daisysp
+{
+/** @brief Block processing for a module that only has Process(), with no
+    virtual call.
+
+    Derived supplies float Process(float in); BlockProcessor gives it
+
+        void ProcessBlock(const float *in, float *out, size_t size);
+
+    as a loop the compiler sees through, Process() inlined into it, and
+    in == out allowed. A Derived with a faster ProcessBlock() of its own
+    declares it and hides this one. Either way any module with a
+    ProcessBlock() can go in a BlockChain, a FunctionChain or an
+    AudioGraph node: the interface is a naming convention checked at
+    compile time, not a base class looked up at run time.
+
+    class Drive : public BlockProcessor<Drive>
+    {
+      public:
+        float Process(float in) { return math::tanh(gain_ * in); }
+        ...
+    };
+*/
+template <class Derived>
+class BlockProcessor
+{
+  public:
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        Derived &self = static_cast<Derived &>(*this);
+        for(size_t i = 0; i < size; i++)
+        {
+            out[i] = self.Process(in[i]);
+        }
+    }
+
+  protected:
+    BlockProcessor() {}
+    ~BlockProcessor() {}
+};
+
+/** @brief Any module with float Process(float), e.g. Mode or Resonator,
+    as a block processor. GetModule() reaches the wrapped module.
+*/
+template <class Module>
+class PerSample : public BlockProcessor<PerSample<Module>>
+{
+  public:
+    static const size_t kStateBytes;
+
+    PerSample() {}
+    ~PerSample() {}
+
+    inline float Process(float in) { return module_.Process(in); }
+
+    Module &GetModule() { return module_; }
+
+  private:
+    Module module_;
+};
+
+template <class Module>
+constexpr size_t PerSample<Module>::kStateBytes = sizeof(PerSample<Module>);
+
+/** @brief Mono chain of block modules, fixed at compile time.
+
+    Each Stage is any class with
+
+        void ProcessBlock(const float *in, float *out, size_t size);
+
+    which the filters and effects have, and BlockProcessor<> and
+    PerSample<> give the rest. The stages live in a tuple and are called
+    by type, so each call is direct and can be inlined: a chain costs
+    what the same calls written out by hand would.
+
+    ProcessBlock() runs each stage over the whole block before the next.
+    The first reads in and writes out; the others work in place on out,
+    so the chain has no scratch, but every stage after the first must
+    allow in == out. in and out may alias if the first stage does too.
+
+    Init() is the caller's, stage by stage through Get<>(), as the
+    stages' Init() take different arguments.
+
+    declaration example:
+
+    static BlockChain<Biquad, Tone, DcBlock> chain;
+    chain.Get<0>().Init(sample_rate);
+    ...
+    chain.ProcessBlock(in[0], out[0], size);
+*/
+template <class... Stage>
+class BlockChain
+{
+  public:
+    static const size_t kStateBytes;
+
+    BlockChain() {}
+    ~BlockChain() {}
+
+    static constexpr size_t kNumStages = sizeof...(Stage);
+
+    /** Processes a block through every stage in order
+        \param in Input samples
+        \param out Output samples
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        if(kNumStages == 0)
+        {
+            if(out != in)
+                memmove(out, in, size * sizeof(float));
+            return;
+        }
+        RunAll(in, out, size, std::index_sequence_for<Stage...>{});
+    }
+
+    /** \return stage idx, for its Init() and settings */
+    template <size_t idx>
+    auto &Get()
+    {
+        return std::get<idx>(stages_);
+    }
+
+    /** Calls f on every stage in order, e.g. to Init() the ones that
+        take the sample rate alone.
+    */
+    template <class F>
+    void ForEach(F f)
+    {
+        std::apply([&f](auto &... s) { (f(s), ...); }, stages_);
+    }
+
+  private:
+    template <size_t... I>
+    inline void
+    RunAll(const float *in, float *out, size_t size, std::index_sequence<I...>)
+    {
+        (std::get<I>(stages_).ProcessBlock(I == 0 ? in : out, out, size), ...);
+    }
+
+    std::tuple<Stage...> stages_;
+};
+
+template <class... Stage>
+constexpr size_t BlockChain<Stage...>::kStateBytes
+    = sizeof(BlockChain<Stage...>);
+
+/** @brief Mono chain of block modules, put together at run time.
+
+    The counterpart of BlockChain for a chain known only once the
+    program runs, e.g. from a preset. Add() stores a pointer to the
+    module and a call through a template made for its type, so a stage
+    costs one indirect call per block instead of a virtual dispatch per
+    sample, and the module needs no base class. The table is filled in
+    setup, not per block.
+
+    The modules stay the caller's and must outlive the chain. The same
+    aliasing rules as BlockChain apply.
+
+    declaration example:
+
+    static FunctionChain<8> chain;
+    chain.Init();
+    chain.Add(biquad);
+    chain.Add(tone);
+    ...
+    chain.ProcessBlock(in[0], out[0], size);
+*/
+template <size_t max_stages>
+class FunctionChain
+{
+  public:
+    static const size_t kStateBytes;
+
+    typedef void (*StageFn)(void *ctx, const float *in, float *out, size_t size);
+
+    FunctionChain() {}
+    ~FunctionChain() {}
+
+    /** Empties the chain */
+    void Init() { num_stages_ = 0; }
+
+    /** Appends a module with ProcessBlock(const float*, float*, size_t)
+        \return false if the chain already has max_stages
+    */
+    template <class Module>
+    bool Add(Module &module)
+    {
+        return Add(&Call<Module>, &module);
+    }
+
+    /** Appends a function over one block, called with ctx */
+    bool Add(StageFn fn, void *ctx)
+    {
+        if(num_stages_ >= max_stages || fn == nullptr)
+            return false;
+        stages_[num_stages_++] = {fn, ctx};
+        return true;
+    }
+
+    /** \return stages added since Init() */
+    inline size_t GetNumStages() const { return num_stages_; }
+
+    /** Processes a block through every stage in order
+        \param in Input samples
+        \param out Output samples
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        if(num_stages_ == 0)
+        {
+            if(out != in)
+                memmove(out, in, size * sizeof(float));
+            return;
+        }
+        stages_[0].fn(stages_[0].ctx, in, out, size);
+        for(size_t i = 1; i < num_stages_; i++)
+        {
+            stages_[i].fn(stages_[i].ctx, out, out, size);
+        }
+    }
+
+  private:
+    static_assert(max_stages > 0, "max_stages must be at least one");
+
+    template <class Module>
+    static void Call(void *ctx, const float *in, float *out, size_t size)
+    {
+        static_cast<Module *>(ctx)->ProcessBlock(in, out, size);
+    }
+
+    struct Entry
+    {
+        StageFn fn;
+        void *  ctx;
+    };
+
+    Entry  stages_[max_stages];
+    size_t num_stages_;
+};
+
+template <size_t max_stages>
+constexpr size_t FunctionChain<max_stages>::kStateBytes
+    = sizeof(FunctionChain<max_stages>);
+} // namespace daisysp
+#endif
+#endif
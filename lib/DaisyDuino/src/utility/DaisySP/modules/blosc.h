@@ -3,6 +3,7 @@
 #define DSY_BLOSC_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -18,6 +19,8 @@ namespace daisysp
 class BlOsc
 {
   public:
+    static const size_t kStateBytes;
+
     BlOsc() {}
     ~BlOsc() {}
     /** Bl Waveforms
@@ -71,6 +74,8 @@ class BlOsc
     float ProcessTriangle();
     float ProcessSaw();
 };
+
+inline constexpr size_t BlOsc::kStateBytes = sizeof(BlOsc);
 } // namespace daisysp
 #endif
 #endif
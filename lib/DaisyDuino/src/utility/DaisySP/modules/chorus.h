@@ -4,7 +4,9 @@
 #ifdef __cplusplus
 
 #include <stdint.h>
-#include "delayline.h"
+#include <stddef.h>
+#include "dsp.h"
+#include "mod_delay.h"
 
 /** @file chorus.h */
 
@@ -13,66 +15,110 @@ namespace daisysp
 /**  
     @brief Single Chorus engine. Used in Chorus.
     @author Ben Sergentanis
+
+    The line is sized for max_sample_rate at compile time, see ModDelay;
+    ChorusEngine is the one for DSY_MOD_DELAY_MAX_SAMPLE_RATE.
 */
-class ChorusEngine
+template <size_t max_sample_rate>
+class BasicChorusEngine
 {
   public:
-    ChorusEngine() {}
-    ~ChorusEngine() {}
+    static const size_t kStateBytes;
+
+    BasicChorusEngine() {}
+    ~BasicChorusEngine() {}
 
     /** Initialize the module
         \param sample_rate Audio engine sample rate.
     */
-    void Init(float sample_rate);
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+
+        del_.Init(sample_rate);
+        SetFeedback(.2f);
+        SetDelay(.75f);
+
+        SetLfoFreq(.3f);
+        SetLfoDepth(.9f);
+    }
 
     /** Get the next sample
         \param in Sample to process
     */
-    float Process(float in);
+    float Process(float in)
+    {
+        return (in + del_.Process(in)) * .5f; //equal mix
+    }
+
+    /** Process a block, the lfo stepped once per ModDelay::kSubBlock.
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        float wet[kChunkSize];
+        for(size_t pos = 0; pos < size; pos += kChunkSize)
+        {
+            const size_t n = size - pos < kChunkSize ? size - pos : kChunkSize;
+            del_.ProcessBlock(in + pos, wet, n);
+            for(size_t i = 0; i < n; i++)
+            {
+                out[pos + i] = (in[pos + i] + wet[i]) * .5f;
+            }
+        }
+    }
 
     /** How much to modulate the delay by.
         \param depth Works 0-1.
     */
-    void SetLfoDepth(float depth);
+    void SetLfoDepth(float depth) { del_.SetLfoDepth(depth); }
 
     /** Set lfo frequency.
         \param freq Frequency in Hz
     */
-    void SetLfoFreq(float freq);
+    void SetLfoFreq(float freq) { del_.SetLfoFreq(freq); }
 
     /** Set the internal delay rate. 
-        \param delay Tuned for 0-1. Maps to .1 to 50 ms.
+        \param delay Tuned for 0-1. Maps to .1 to 8 ms.
     */
-    void SetDelay(float delay);
+    void SetDelay(float delay)
+    {
+        delay = (.1f + delay * 7.9f); //.1 to 8 ms
+        SetDelayMs(delay);
+    }
 
     /** Set the delay time in ms.
         \param ms Delay time in ms, 0 to 50 ms.
     */
-    void SetDelayMs(float ms);
+    void SetDelayMs(float ms)
+    {
+        ms = fmax(.1f, ms);
+        del_.SetDelay(ms * .001f * sample_rate_); //ms to samples
+    }
 
     /** Set the feedback amount.
         \param feedback Amount from 0-1.
     */
-    void SetFeedback(float feedback);
+    void SetFeedback(float feedback)
+    {
+        del_.SetFeedback(fclamp(feedback, 0.f, 1.f));
+    }
 
   private:
-    float                    sample_rate_;
-    static constexpr int32_t kDelayLength
-        = 2400; // 50 ms at 48kHz = .05 * 48000
-
-    //triangle lfos
-    float lfo_phase_;
-    float lfo_freq_;
-    float lfo_amp_;
+    static constexpr size_t kChunkSize = 32;
 
-    float feedback_;
+    float sample_rate_;
 
-    float delay_;
+    ModDelay<50, max_sample_rate> del_; // up to 50 ms
+};
 
-    DelayLine<float, kDelayLength> del_;
+template <size_t max_sample_rate>
+constexpr size_t BasicChorusEngine<max_sample_rate>::kStateBytes
+    = sizeof(BasicChorusEngine<max_sample_rate>);
 
-    float ProcessLfo();
-};
+using ChorusEngine = BasicChorusEngine<DSY_MOD_DELAY_MAX_SAMPLE_RATE>;
 
 //wraps up all of the chorus engines
 /**  
@@ -81,102 +127,196 @@ class ChorusEngine
     @date Jan 2021
     Based on https://www.izotope.com/en/learn/understanding-chorus-flangers-and-phasers-in-audio-production.html \n
     and https://www.researchgate.net/publication/236629475_Implementing_Professional_Audio_Effects_with_DSPs \n
+
+    Chorus is the one for DSY_MOD_DELAY_MAX_SAMPLE_RATE;
+    BasicChorus<48000> holds half as much where 96 kHz is never used.
 */
-class Chorus
+template <size_t max_sample_rate>
+class BasicChorus
 {
   public:
-    Chorus() {}
-    ~Chorus() {}
+    static const size_t kStateBytes;
+
+    BasicChorus() {}
+    ~BasicChorus() {}
 
     /** Initialize the module
         \param sample_rate Audio engine sample rate
     */
-    void Init(float sample_rate);
+    void Init(float sample_rate)
+    {
+        engines_[0].Init(sample_rate);
+        engines_[1].Init(sample_rate);
+        SetPan(.25f, .75f);
+
+        gain_frac_ = .5f;
+        sigl_ = sigr_ = 0.f;
+    }
 
     /** Get the net floating point sample. Defaults to left channel.
         \param in Sample to process
     */
-    float Process(float in);
+    float Process(float in)
+    {
+        sigl_ = 0.f;
+        sigr_ = 0.f;
+
+        for(int i = 0; i < 2; i++)
+        {
+            float sig = engines_[i].Process(in);
+            sigl_ += (1.f - pan_[i]) * sig;
+            sigr_ += pan_[i] * sig;
+        }
+
+        sigl_ *= gain_frac_;
+        sigr_ *= gain_frac_;
+
+        return sigl_;
+    }
+
+    /** Process a block into both channels, as Process() with GetLeft()
+        and GetRight() per sample, the lfos stepped per sub-block.
+        \param in Input samples
+        \param left Left channel out, may be in
+        \param right Right channel out
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *left, float *right, size_t size)
+    {
+        float sig[2][kChunkSize];
+        for(size_t pos = 0; pos < size; pos += kChunkSize)
+        {
+            const size_t n = size - pos < kChunkSize ? size - pos : kChunkSize;
+            engines_[0].ProcessBlock(in + pos, sig[0], n);
+            engines_[1].ProcessBlock(in + pos, sig[1], n);
+            for(size_t i = 0; i < n; i++)
+            {
+                float l = (1.f - pan_[0]) * sig[0][i];
+                float r = pan_[0] * sig[0][i];
+                l += (1.f - pan_[1]) * sig[1][i];
+                r += pan_[1] * sig[1][i];
+                left[pos + i]  = l * gain_frac_;
+                right[pos + i] = r * gain_frac_;
+            }
+        }
+        if(size > 0)
+        {
+            sigl_ = left[size - 1];
+            sigr_ = right[size - 1];
+        }
+    }
 
     /** Get the left channel's last sample */
-    float GetLeft();
+    float GetLeft() { return sigl_; }
 
     /** Get the right channel's last sample */
-    float GetRight();
+    float GetRight() { return sigr_; }
 
     /** Pan both channels individually.
         \param panl Pan the left channel. 0 is left, 1 is right.
         \param panr Pan the right channel.
     */
-    void SetPan(float panl, float panr);
+    void SetPan(float panl, float panr)
+    {
+        pan_[0] = fclamp(panl, 0.f, 1.f);
+        pan_[1] = fclamp(panr, 0.f, 1.f);
+    }
 
     /** Pan both channels.
         \param pan Where to pan both channels to. 0 is left, 1 is right.
     */
-    void SetPan(float pan);
+    void SetPan(float pan) { SetPan(pan, pan); }
 
     /** Set both lfo depths individually.
         \param depthl Left channel lfo depth. Works 0-1.
         \param depthr Right channel lfo depth.
     */
-    void SetLfoDepth(float depthl, float depthr);
+    void SetLfoDepth(float depthl, float depthr)
+    {
+        engines_[0].SetLfoDepth(depthl);
+        engines_[1].SetLfoDepth(depthr);
+    }
 
     /** Set both lfo depths.
         \param depth Both channels lfo depth. Works 0-1.
     */
-    void SetLfoDepth(float depth);
+    void SetLfoDepth(float depth) { SetLfoDepth(depth, depth); }
 
     /** Set both lfo frequencies individually.
         \param depthl Left channel lfo freq in Hz.
         \param depthr Right channel lfo freq in Hz.
     */
-    void SetLfoFreq(float freql, float freqr);
+    void SetLfoFreq(float freql, float freqr)
+    {
+        engines_[0].SetLfoFreq(freql);
+        engines_[1].SetLfoFreq(freqr);
+    }
 
     /** Set both lfo frequencies.
         \param depth Both channel lfo freqs in Hz.
     */
-    void SetLfoFreq(float freq);
+    void SetLfoFreq(float freq) { SetLfoFreq(freq, freq); }
 
     /** Set both channel delay amounts individually.
         \param delayl Left channel delay amount. Works 0-1.
         \param delayr Right channel delay amount.
     */
-    void SetDelay(float delayl, float delayr);
+    void SetDelay(float delayl, float delayr)
+    {
+        engines_[0].SetDelay(delayl);
+        engines_[1].SetDelay(delayr);
+    }
 
     /** Set both channel delay amounts.
         \param delay Both channel delay amount. Works 0-1.
     */
-    void SetDelay(float delay);
+    void SetDelay(float delay) { SetDelay(delay, delay); }
 
     /** Set both channel delay individually.
         \param msl Left channel delay in ms.
         \param msr Right channel delay in ms.
     */
-    void SetDelayMs(float msl, float msr);
+    void SetDelayMs(float msl, float msr)
+    {
+        engines_[0].SetDelayMs(msl);
+        engines_[1].SetDelayMs(msr);
+    }
 
     /** Set both channel delay in ms.
         \param ms Both channel delay amounts in ms.
     */
-    void SetDelayMs(float ms);
+    void SetDelayMs(float ms) { SetDelayMs(ms, ms); }
 
     /** Set both channels feedback individually.
         \param feedbackl Left channel feedback. Works 0-1.
         \param feedbackr Right channel feedback.
     */
-    void SetFeedback(float feedbackl, float feedbackr);
+    void SetFeedback(float feedbackl, float feedbackr)
+    {
+        engines_[0].SetFeedback(feedbackl);
+        engines_[1].SetFeedback(feedbackr);
+    }
 
     /** Set both channels feedback.
         \param feedback Both channel feedback. Works 0-1.
     */
-    void SetFeedback(float feedback);
+    void SetFeedback(float feedback) { SetFeedback(feedback, feedback); }
 
   private:
-    ChorusEngine engines_[2];
-    float        gain_frac_;
-    float        pan_[2];
+    static constexpr size_t kChunkSize = 32;
+
+    BasicChorusEngine<max_sample_rate> engines_[2];
+    float                              gain_frac_;
+    float                              pan_[2];
 
     float sigl_, sigr_;
 };
+
+template <size_t max_sample_rate>
+constexpr size_t BasicChorus<max_sample_rate>::kStateBytes
+    = sizeof(BasicChorus<max_sample_rate>);
+
+using Chorus = BasicChorus<DSY_MOD_DELAY_MAX_SAMPLE_RATE>;
 } //namespace daisysp
 #endif
 #endif
@@ -1,4 +1,3 @@
-#include <random>
 #include "dsp.h"
 #include "clockednoise.h"
 
@@ -7,6 +6,7 @@ using namespace daisysp;
 void ClockedNoise::Init(float sample_rate)
 {
     sample_rate_ = sample_rate;
+    rng_.Init();
 
     phase_       = 0.0f;
     sample_      = 0.0f;
@@ -22,7 +22,7 @@ float ClockedNoise::Process()
     float this_sample = next_sample;
     next_sample       = 0.0f;
 
-    const float raw_sample = rand() * kRandFrac * 2.0f - 1.0f;
+    const float raw_sample = rng_.NextBipolar();
     float       raw_amount = 4.0f * (frequency_ - 0.25f);
     raw_amount             = fclamp(raw_amount, 0.0f, 1.0f);
 
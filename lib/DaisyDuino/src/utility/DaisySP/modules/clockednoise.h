@@ -3,6 +3,7 @@
 #define DSY_CLOCKEDNOISE_H
 
 #include <stdint.h>
+#include "fast_random.h"
 #ifdef __cplusplus
 
 /** @file clockednoise.h */
@@ -21,6 +22,8 @@ namespace daisysp
 class ClockedNoise
 {
   public:
+    static const size_t kStateBytes;
+
     ClockedNoise() {}
     ~ClockedNoise() {}
 
@@ -51,8 +54,10 @@ class ClockedNoise
 
     float sample_rate_;
 
-    static constexpr float kRandFrac = 1.f / (float)RAND_MAX;
+    FastRandom rng_;
 };
+
+inline constexpr size_t ClockedNoise::kStateBytes = sizeof(ClockedNoise);
 } // namespace daisysp
 #endif
 #endif
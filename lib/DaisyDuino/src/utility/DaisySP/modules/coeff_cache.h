@@ -0,0 +1,95 @@
+#pragma once
+#ifndef DSY_COEFF_CACHE_H
+#define DSY_COEFF_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** The last N filter designs, keyed on what they were designed from.
+
+    Toggling between a few presets, or a sweep run again, asks for the
+    same few designs over and over; with the trig and powf in each
+    costing some hundreds of cycles, a scan of N keys is cheaper. Get()
+    returns the cached value for key, or, on a miss, designs it with
+    design(key) into the least recently used entry.
+
+    Key needs operator==, compared exactly: the same settings give the
+    same key bit for bit, so there is no tolerance to pick. Value is
+    plain data. Not reentrant: share one cache only between filters that
+    are set from the same context.
+
+    usage:
+
+    static CoeffCache<float, float, 8> sines;
+    sines.Init();
+    ...
+    const float s = sines.Get(w, [](float w) { return sinf(w); });
+*/
+template <typename Key, typename Value, size_t N>
+class CoeffCache
+{
+  public:
+    static const size_t kStateBytes;
+
+    CoeffCache() {}
+    ~CoeffCache() {}
+
+    /** Empties the cache and clears the counts */
+    void Init()
+    {
+        clock_  = 0;
+        hits_   = 0;
+        misses_ = 0;
+        for(size_t i = 0; i < N; i++)
+            age_[i] = 0;
+    }
+
+    /** \return the value for key, designed with design(key) on a miss.
+        Valid until the next miss.
+    */
+    template <typename Design>
+    const Value& Get(const Key& key, Design design)
+    {
+        // Empty entries have age 0, so they go before any used one.
+        size_t lru = 0;
+        for(size_t i = 0; i < N; i++)
+        {
+            if(age_[i] != 0 && keys_[i] == key)
+            {
+                age_[i] = ++clock_;
+                hits_++;
+                return values_[i];
+            }
+            if(age_[i] < age_[lru])
+                lru = i;
+        }
+        misses_++;
+        keys_[lru]   = key;
+        values_[lru] = design(key);
+        age_[lru]    = ++clock_;
+        return values_[lru];
+    }
+
+    /** \return lookups found in the cache since Init() */
+    inline uint32_t GetHits() const { return hits_; }
+
+    /** \return lookups that designed a new entry since Init() */
+    inline uint32_t GetMisses() const { return misses_; }
+
+  private:
+    Key      keys_[N];
+    Value    values_[N];
+    uint32_t age_[N]; /**< last use, 0 while empty */
+    uint32_t clock_;
+    uint32_t hits_, misses_;
+};
+
+template <typename Key, typename Value, size_t N>
+constexpr size_t CoeffCache<Key, Value, N>::kStateBytes
+    = sizeof(CoeffCache<Key, Value, N>);
+} // namespace daisysp
+#endif
+#endif
@@ -35,7 +35,7 @@ float Comb::Process(float in)
         }
         else
         {
-            coef = coef_ = expf(exp_arg);
+            coef = coef_ = math::exp(exp_arg);
         }
     }
 
@@ -48,6 +48,43 @@ float Comb::Process(float in)
     return outsamp;
 }
 
+void Comb::ProcessBlock(const float* in, float* out, size_t size)
+{
+    if(prvt_ != rev_time_)
+    {
+        prvt_         = rev_time_;
+        float exp_arg = (float)(log001 * loop_time_ / prvt_);
+        if(exp_arg < -36.8413615)
+        {
+            coef_ = 0;
+        }
+        else
+        {
+            coef_ = math::exp(exp_arg);
+        }
+    }
+
+    const float  coef     = coef_;
+    const size_t max_size = max_size_;
+    float*       buf      = buf_;
+    size_t       pos      = buf_pos_;
+    // pos < max_size and mod_ <= max_size, so one wrap does for the %.
+    size_t       tap      = pos + mod_;
+    if(tap >= max_size)
+        tap -= max_size;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        const float outsamp = buf[tap];
+        buf[pos]            = (outsamp * coef) + in[i];
+        out[i]              = outsamp;
+
+        pos = pos == 0 ? max_size - 1 : pos - 1;
+        tap = tap == 0 ? max_size - 1 : tap - 1;
+    }
+    buf_pos_ = pos;
+}
+
 void Comb::SetPeriod(float looptime)
 {
     if(looptime > 0)
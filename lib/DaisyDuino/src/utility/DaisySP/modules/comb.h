@@ -16,6 +16,8 @@ namespace daisysp
 class Comb
 {
   public:
+    static const size_t kStateBytes;
+
     Comb() {}
     ~Comb() {}
 
@@ -31,6 +33,11 @@ class Comb
     */
     float Process(float in);
 
+    /** processes a block, the same as Process() on each sample;
+        out may be in
+    */
+    void ProcessBlock(const float* in, float* out, size_t size);
+
 
     /** Sets the period of the comb filter in seconds
     */
@@ -55,6 +62,8 @@ class Comb
     float* buf_;
     size_t buf_pos_, mod_, max_size_;
 };
+
+inline constexpr size_t Comb::kStateBytes = sizeof(Comb);
 } // namespace daisysp
 
 #endif
@@ -0,0 +1,322 @@
+#pragma once
+#ifndef DSY_COMB_BANK_H
+#define DSY_COMB_BANK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "dsp.h"
+
+namespace daisysp
+{
+/** N parallel feedback combs over one buffer, summed.
+
+    The Schroeder / Freeverb front end: lengths are set once, in samples,
+    and the lines sit back to back in a single user-provided slab (in
+    practice SDRAM). The feedback coefficients follow the reverb time as
+    for Comb, 0.001 ^ (length / (rt * fs)), but are only recomputed, N
+    expf, on the first Process after SetRevTime() changed. SetDamp() adds
+    Freeverb's one-pole lowpass in the loop; 0 gives a plain Comb.
+
+    ProcessBlock() runs each line over the whole block before moving on,
+    keeping that line's state in registers and its buffer walk sequential.
+
+    declaration example:
+
+    float DSY_SDRAM_BSS slab[8192];
+    CombBank<4> combs;
+    const size_t lengths[4] = {1557, 1617, 1491, 1422};
+    combs.Init(48000.f, slab, 8192, lengths);
+*/
+template <size_t num_lines>
+class CombBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    CombBank() {}
+    ~CombBank() {}
+
+    /** Initializes the bank and clears the slab.
+        \param sample_rate  Audio engine sample rate
+        \param slab  Buffer for all lines, kept in global space
+        \param size  Size of slab, at least the sum of lengths
+        \param lengths  Loop length of each line in samples, > 0
+        \return false if the lines do not fit the slab
+    */
+    bool Init(float sample_rate, float* slab, size_t size, const size_t* lengths)
+    {
+        sample_rate_ = sample_rate;
+        rev_time_    = 3.5f;
+        damp_        = 0.0f;
+        dirty_       = true;
+
+        size_t offset = 0;
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            if(lengths[i] == 0 || lengths[i] > size - offset)
+            {
+                return false;
+            }
+            line_[i] = slab + offset;
+            len_[i]  = lengths[i];
+            pos_[i]  = 0;
+            lp_[i]   = 0.0f;
+            offset += lengths[i];
+        }
+        for(size_t i = 0; i < offset; i++)
+        {
+            slab[i] = 0.0f;
+        }
+        return true;
+    }
+
+    /** Processes one sample through every line.
+        \return The sum of the line outputs.
+    */
+    float Process(float in)
+    {
+        if(dirty_)
+        {
+            UpdateCoeffs();
+        }
+        float sum = 0.0f;
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            float*      buf = line_[i];
+            const float y   = buf[pos_[i]];
+            lp_[i]          = y + (lp_[i] - y) * damp_;
+            buf[pos_[i]]    = in + coef_[i] * lp_[i];
+            if(++pos_[i] >= len_[i])
+                pos_[i] = 0;
+            sum += y;
+        }
+        return sum;
+    }
+
+    /** Processes a block, the same as Process() on each sample.
+        out must not be in.
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        if(dirty_)
+        {
+            UpdateCoeffs();
+        }
+        for(size_t j = 0; j < size; j++)
+        {
+            out[j] = 0.0f;
+        }
+        const float damp = damp_;
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            float*       buf  = line_[i];
+            const size_t len  = len_[i];
+            const float  coef = coef_[i];
+            size_t       pos  = pos_[i];
+            float        lp   = lp_[i];
+            for(size_t j = 0; j < size; j++)
+            {
+                const float y = buf[pos];
+                lp            = y + (lp - y) * damp;
+                buf[pos]      = in[j] + coef * lp;
+                if(++pos >= len)
+                    pos = 0;
+                out[j] += y;
+            }
+            pos_[i] = pos;
+            lp_[i]  = lp;
+        }
+    }
+
+    /** Sets the decay time, shared by all lines.
+        \param revtime  Time to -60 dB in seconds, > 0
+    */
+    inline void SetRevTime(float revtime)
+    {
+        if(revtime != rev_time_)
+        {
+            rev_time_ = revtime;
+            dirty_    = true;
+        }
+    }
+
+    /** Sets the high frequency damping in the loops.
+        \param damp  0 (none) to just below 1
+    */
+    inline void SetDamp(float damp) { damp_ = damp; }
+
+  private:
+    void UpdateCoeffs()
+    {
+        // log(.001), as in Comb
+        const float k = -6.9078f / (rev_time_ * sample_rate_);
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            coef_[i] = math::exp(k * (float)len_[i]);
+        }
+        dirty_ = false;
+    }
+
+    float  sample_rate_, rev_time_, damp_;
+    bool   dirty_;
+    float* line_[num_lines];
+    size_t len_[num_lines];
+    size_t pos_[num_lines];
+    float  coef_[num_lines];
+    float  lp_[num_lines];
+};
+
+template <size_t num_lines>
+constexpr size_t CombBank<num_lines>::kStateBytes = sizeof(CombBank<num_lines>);
+
+/** N allpasses in series over one buffer.
+
+    The diffusion stage after a CombBank, with the same slab layout and
+    lazy coefficients. The per-line gain follows the reverb time as for
+    Allpass, or is fixed by SetGain() (Freeverb uses 0.5), which stops
+    the reverb time tracking. Process() and ProcessBlock() may run in
+    place.
+*/
+template <size_t num_lines>
+class AllpassBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    AllpassBank() {}
+    ~AllpassBank() {}
+
+    /** Initializes the bank and clears the slab.
+        \param sample_rate  Audio engine sample rate
+        \param slab  Buffer for all lines, kept in global space
+        \param size  Size of slab, at least the sum of lengths
+        \param lengths  Loop length of each line in samples, > 0
+        \return false if the lines do not fit the slab
+    */
+    bool Init(float sample_rate, float* slab, size_t size, const size_t* lengths)
+    {
+        sample_rate_ = sample_rate;
+        rev_time_    = 3.5f;
+        fixed_       = false;
+        dirty_       = true;
+
+        size_t offset = 0;
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            if(lengths[i] == 0 || lengths[i] > size - offset)
+            {
+                return false;
+            }
+            line_[i] = slab + offset;
+            len_[i]  = lengths[i];
+            pos_[i]  = 0;
+            offset += lengths[i];
+        }
+        for(size_t i = 0; i < offset; i++)
+        {
+            slab[i] = 0.0f;
+        }
+        return true;
+    }
+
+    /** Processes one sample through the chain */
+    float Process(float in)
+    {
+        if(dirty_)
+        {
+            UpdateCoeffs();
+        }
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            float*      buf = line_[i];
+            const float y   = buf[pos_[i]];
+            const float z   = coef_[i] * y + in;
+            buf[pos_[i]]    = z;
+            in              = y - coef_[i] * z;
+            if(++pos_[i] >= len_[i])
+                pos_[i] = 0;
+        }
+        return in;
+    }
+
+    /** Processes a block, the same as Process() on each sample.
+        out may be in.
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        if(dirty_)
+        {
+            UpdateCoeffs();
+        }
+        const float* src = in;
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            float*       buf  = line_[i];
+            const size_t len  = len_[i];
+            const float  coef = coef_[i];
+            size_t       pos  = pos_[i];
+            for(size_t j = 0; j < size; j++)
+            {
+                const float y = buf[pos];
+                const float z = coef * y + src[j];
+                buf[pos]      = z;
+                out[j]        = y - coef * z;
+                if(++pos >= len)
+                    pos = 0;
+            }
+            pos_[i] = pos;
+            src     = out;
+        }
+    }
+
+    /** Sets the decay time, shared by all lines.
+        \param revtime  Time to -60 dB in seconds, > 0
+    */
+    inline void SetRevTime(float revtime)
+    {
+        if(fixed_ || revtime != rev_time_)
+        {
+            rev_time_ = revtime;
+            fixed_    = false;
+            dirty_    = true;
+        }
+    }
+
+    /** Sets one gain for every line instead of following the reverb time.
+        \param gain  Allpass coefficient, below 1
+    */
+    inline void SetGain(float gain)
+    {
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            coef_[i] = gain;
+        }
+        fixed_ = true;
+        dirty_ = false;
+    }
+
+  private:
+    void UpdateCoeffs()
+    {
+        const float k = -6.9078f / (rev_time_ * sample_rate_);
+        for(size_t i = 0; i < num_lines; i++)
+        {
+            coef_[i] = math::exp(k * (float)len_[i]);
+        }
+        dirty_ = false;
+    }
+
+    float  sample_rate_, rev_time_;
+    bool   fixed_, dirty_;
+    float* line_[num_lines];
+    size_t len_[num_lines];
+    size_t pos_[num_lines];
+    float  coef_[num_lines];
+};
+
+template <size_t num_lines>
+constexpr size_t AllpassBank<num_lines>::kStateBytes
+    = sizeof(AllpassBank<num_lines>);
+} // namespace daisysp
+#endif
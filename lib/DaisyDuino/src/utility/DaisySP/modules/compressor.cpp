@@ -24,6 +24,12 @@ void Compressor::Init(float sample_rate)
     sample_rate_inv_  = 1.0f / (float)sample_rate_;
     sample_rate_inv2_ = 2.0f / (float)sample_rate_;
 
+    divisor_     = 1;
+    inv_divisor_ = 1.f;
+    count_       = 0;
+    level_sum_   = 0.f;
+    step_        = 0.f;
+
     // Initializing the params in this order to avoid dividing by zero
 
     SetRatio(2.0f);
@@ -34,10 +40,18 @@ void Compressor::Init(float sample_rate)
 
     gain_rec_  = 0.1f;
     slope_rec_ = 0.1f;
+    gain_      = pow10f(0.05f * (gain_rec_ + makeup_gain_));
 }
 
 float Compressor::Process(float in)
 {
+    if(divisor_ > 1)
+    {
+        float *i = &in, *o = &in;
+        ProcessDecimated(&i, &o, &in, 1, 1);
+        return in;
+    }
+
     float inAbs   = fabsf(in);
     float cur_slo = ((slope_rec_ > inAbs) ? rel_slo_ : atk_slo_);
     slope_rec_    = ((slope_rec_ * cur_slo) + ((1.0f - cur_slo) * inAbs));
@@ -51,6 +65,11 @@ float Compressor::Process(float in)
 
 void Compressor::ProcessBlock(float *in, float *out, float *key, size_t size)
 {
+    if(divisor_ > 1)
+    {
+        ProcessDecimated(&in, &out, key, 1, size);
+        return;
+    }
     for(size_t i = 0; i < size; i++)
     {
         Process(key[i]);
@@ -65,6 +84,11 @@ void Compressor::ProcessBlock(float **in,
                               size_t  channels,
                               size_t  size)
 {
+    if(divisor_ > 1)
+    {
+        ProcessDecimated(in, out, key, channels, size);
+        return;
+    }
     for(size_t i = 0; i < size; i++)
     {
         Process(key[i]);
@@ -74,3 +98,100 @@ void Compressor::ProcessBlock(float **in,
         }
     }
 }
+
+// Multi-channel, detecting on the loudest channel
+void Compressor::ProcessBlock(float **in,
+                              float **out,
+                              size_t  channels,
+                              size_t  size)
+{
+    if(divisor_ > 1)
+    {
+        ProcessDecimated(in, out, nullptr, channels, size);
+        return;
+    }
+    for(size_t i = 0; i < size; i++)
+    {
+        float peak = 0.f;
+        for(size_t c = 0; c < channels; c++)
+        {
+            peak = fmax(peak, fabsf(in[c][i]));
+        }
+        Process(peak);
+        for(size_t c = 0; c < channels; c++)
+        {
+            out[c][i] = Apply(in[c][i]);
+        }
+    }
+}
+
+void Compressor::Detect()
+{
+    // The mean level steps the follower as divisor_ samples of it would.
+    const float level = level_sum_ * inv_divisor_;
+    float cur_slo = ((slope_rec_ > level) ? rel_slo_d_ : atk_slo_d_);
+    slope_rec_    = ((slope_rec_ * cur_slo) + ((1.0f - cur_slo) * level));
+    gain_rec_     = ((atk_slo2_d_ * gain_rec_)
+                 + (ratio_mul_d_
+                    * fmax(((20.f * fastlog10f(slope_rec_)) - thresh_), 0.f)));
+    const float target = pow10f(0.05f * (gain_rec_ + makeup_gain_));
+
+    step_      = (target - gain_) * inv_divisor_;
+    level_sum_ = 0.f;
+    count_     = 0;
+}
+
+void Compressor::ProcessDecimated(float **in,
+                                  float **out,
+                                  float * key,
+                                  size_t  channels,
+                                  size_t  size)
+{
+    size_t i = 0;
+    while(i < size)
+    {
+        // Up to the next detector update, the gain a straight ramp.
+        const size_t left = divisor_ - count_;
+        const size_t n    = size - i < left ? size - i : left;
+        float        sum  = level_sum_;
+        if(key != nullptr)
+        {
+            for(size_t k = i; k < i + n; k++)
+            {
+                sum += fabsf(key[k]);
+            }
+        }
+        else
+        {
+            for(size_t k = i; k < i + n; k++)
+            {
+                float peak = 0.f;
+                for(size_t c = 0; c < channels; c++)
+                {
+                    peak = fmax(peak, fabsf(in[c][k]));
+                }
+                sum += peak;
+            }
+        }
+        level_sum_ = sum;
+
+        const float step = step_;
+        for(size_t c = 0; c < channels; c++)
+        {
+            const float *src  = in[c];
+            float *      dst  = out[c];
+            float        gain = gain_;
+            for(size_t k = i; k < i + n; k++)
+            {
+                gain += step;
+                dst[k] = gain * src[k];
+            }
+        }
+        gain_ += step * static_cast<float>(n);
+
+        i += n;
+        count_ += n;
+        if(count_ == divisor_)
+            Detect();
+    }
+}
@@ -26,6 +26,8 @@ by: shensley, improved upon by AvAars
 class Compressor
 {
   public:
+    static const size_t kStateBytes;
+
     Compressor() {}
     ~Compressor() {}
     /** Initializes compressor
@@ -84,6 +86,38 @@ class Compressor
                       size_t  channels,
                       size_t  size);
 
+    /** Compresses a block of multiple channels of audio with one detector
+        on the loudest of them, so all get the same gain
+        \param in audio input signals (to be compressed)
+        \param out audio output signals
+        \param channels the number of audio channels
+        \param size the size of the block
+    */
+    void ProcessBlock(float **in, float **out, size_t channels, size_t size);
+
+    /** Runs the detector and gain computer once every divisor samples on
+        the mean level since the last time, and ramps the gain linearly across
+        the next divisor samples. The two dB conversions are then paid once
+        per divisor samples; 4 to 16 is inaudible at usual attack times.
+        \param divisor 1 (every sample, the default) to kMaxDivisor
+    */
+    void SetDetectionDivisor(size_t divisor)
+    {
+        divisor_     = divisor < 1 ? 1
+                                   : (divisor > kMaxDivisor ? kMaxDivisor : divisor);
+        inv_divisor_ = 1.f / static_cast<float>(divisor_);
+        count_       = 0;
+        level_sum_   = 0.f;
+        step_        = 0.f;
+        RecalculateAttack();
+        RecalculateRelease();
+    }
+
+    /** Gets the detection divisor */
+    size_t GetDetectionDivisor() { return divisor_; }
+
+    static constexpr size_t kMaxDivisor = 64;
+
     /** Gets the amount of gain reduction */
     float GetRatio() { return ratio_; }
 
@@ -165,6 +199,14 @@ class Compressor
     // Internals from faust
     float atk_slo2_, ratio_mul_, atk_slo_, rel_slo_;
 
+    // The same over divisor_ samples, for the decimated detector
+    float atk_slo2_d_, ratio_mul_d_, atk_slo_d_, rel_slo_d_;
+
+    // Decimated detector: samples since the last update, the sum of their
+    // levels, and the gain ramp towards the last result
+    size_t divisor_, count_;
+    float  inv_divisor_, level_sum_, step_;
+
     int   sample_rate_;
     float sample_rate_inv2_, sample_rate_inv_;
 
@@ -174,18 +216,38 @@ class Compressor
     // Methods for recalculating internals
     void RecalculateRatio()
     {
-        ratio_mul_ = ((1.0f - atk_slo2_) * ((1.0f / ratio_) - 1.0f));
+        ratio_mul_   = ((1.0f - atk_slo2_) * ((1.0f / ratio_) - 1.0f));
+        ratio_mul_d_ = ((1.0f - atk_slo2_d_) * ((1.0f / ratio_) - 1.0f));
     }
 
     void RecalculateAttack()
     {
-        atk_slo_  = expf(-(sample_rate_inv_ / atk_));
-        atk_slo2_ = expf(-(sample_rate_inv2_ / atk_));
+        const float d = static_cast<float>(divisor_);
+        atk_slo_      = math::exp(-(sample_rate_inv_ / atk_));
+        atk_slo2_     = math::exp(-(sample_rate_inv2_ / atk_));
+        atk_slo_d_    = math::exp(-(d * sample_rate_inv_ / atk_));
+        atk_slo2_d_   = math::exp(-(d * sample_rate_inv2_ / atk_));
 
         RecalculateRatio();
     }
 
-    void RecalculateRelease() { rel_slo_ = expf((-(sample_rate_inv_ / rel_))); }
+    void RecalculateRelease()
+    {
+        rel_slo_   = math::exp((-(sample_rate_inv_ / rel_)));
+        rel_slo_d_ = math::exp(-(static_cast<float>(divisor_) * sample_rate_inv_ / rel_));
+    }
+
+    // Detector and gain computer on the level of the last divisor_ samples;
+    // sets the ramp to the new gain
+    void Detect();
+
+    // Decimated path of the ProcessBlock()s; key nullptr detects on the
+    // loudest channel
+    void ProcessDecimated(float **in,
+                          float **out,
+                          float * key,
+                          size_t  channels,
+                          size_t  size);
 
     void RecalculateMakeup()
     {
@@ -194,6 +256,8 @@ class Compressor
     }
 };
 
+inline constexpr size_t Compressor::kStateBytes = sizeof(Compressor);
+
 } // namespace daisysp
 
 #endif // DSY_COMPRESSOR_H
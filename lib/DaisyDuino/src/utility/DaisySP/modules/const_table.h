@@ -0,0 +1,275 @@
+#pragma once
+#ifndef DSY_CONST_TABLE_H
+#define DSY_CONST_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+namespace daisysp
+{
+/** Tables computed by the compiler: windows, sinc and Hilbert kernels,
+    sine and exponential lookups.
+
+    Everything here is constexpr, in double, without libm. A table
+    assigned to a constexpr variable is therefore finished at compile
+    time and lands in .rodata (flash). At boot it costs nothing, and no
+    table-building code or libm is linked for it.
+
+    A module that wants its table in a TCM keeps a RAM copy in that
+    section and memcpy()s from the flash table at Init(). That is a few
+    microseconds instead of a libm call per entry. A module without a
+    placement reads the flash table directly.
+
+    The math functions keep double precision over the ranges the tables
+    and IirDesign use. They iterate and range-reduce, so they cost far
+    more per call than libm, which is fine at compile time and at setup.
+
+    declaration example:
+
+    static constexpr auto kHann
+        = ConstTable::Make<513>([](size_t i) {
+              return ConstTable::Hann(static_cast<double>(i) / 512.0);
+          });
+*/
+class ConstTable
+{
+  public:
+    static const size_t kStateBytes;
+
+    static constexpr double kPi  = 3.14159265358979323846;
+    static constexpr double kLn2 = 0.69314718055994530942;
+
+    /** Table of size entries, entry i = (float)f(i). f takes a size_t
+        and returns double; a constexpr lambda does.
+    */
+    template <size_t size, class F>
+    static constexpr std::array<float, size> Make(F f)
+    {
+        std::array<float, size> out{};
+        for(size_t i = 0; i < size; i++)
+        {
+            out[i] = static_cast<float>(f(i));
+        }
+        return out;
+    }
+
+    /** sin(2 pi i / size) for i in 0 .. size: one cycle plus the guard
+        point that linear interpolation reads past the end.
+    */
+    template <size_t size>
+    static constexpr std::array<float, size + 1> Sine()
+    {
+        return Make<size + 1>([](size_t i) {
+            return Sin(2.0 * kPi * static_cast<double>(i)
+                       / static_cast<double>(size));
+        });
+    }
+
+    // Windows over x in [0, 1]: 0 and 1 are the edges, 0.5 the peak.
+
+    static constexpr double Hann(double x)
+    {
+        return 0.5 - 0.5 * Cos(2.0 * kPi * x);
+    }
+
+    /** 4-term Blackman-Harris, -92 dB sidelobes. */
+    static constexpr double BlackmanHarris(double x)
+    {
+        return 0.35875 - 0.48829 * Cos(2.0 * kPi * x)
+               + 0.14128 * Cos(4.0 * kPi * x) - 0.01168 * Cos(6.0 * kPi * x);
+    }
+
+    static constexpr double Triangle(double x)
+    {
+        return 1.0 - Abs(2.0 * x - 1.0);
+    }
+
+    /** Flat top with Hann edges, each edge fraction of the length. */
+    static constexpr double Tukey(double x, double edge)
+    {
+        const double d = x < 0.5 ? x : 1.0 - x;
+        return d < edge ? 0.5 - 0.5 * Cos(kPi * d / edge) : 1.0;
+    }
+
+    /** Kaiser window of shape beta, 1 / I0(beta) at the edges. */
+    static constexpr double Kaiser(double x, double beta)
+    {
+        const double r = 2.0 * x - 1.0;
+        return r * r <= 1.0
+                   ? BesselI0(beta * Sqrt(1.0 - r * r)) / BesselI0(beta)
+                   : 0.0;
+    }
+
+    /** sin(pi x) / (pi x) */
+    static constexpr double Sinc(double x)
+    {
+        return Abs(x) < 1e-9 ? 1.0 : Sin(kPi * x) / (kPi * x);
+    }
+
+    /** Kaiser-windowed sinc lowpass of num_taps taps, normalised to unity
+        DC gain. cutoff is the -6 dB point as a part of Nyquist.
+    */
+    template <size_t num_taps>
+    static constexpr std::array<float, num_taps> WindowedSinc(double cutoff,
+                                                              double beta)
+    {
+        static_assert(num_taps > 1, "WindowedSinc needs two taps or more");
+        std::array<double, num_taps> tmp{};
+        double                       sum = 0.0;
+        for(size_t k = 0; k < num_taps; k++)
+        {
+            const double t = static_cast<double>(k)
+                             - 0.5 * static_cast<double>(num_taps - 1);
+            const double x
+                = static_cast<double>(k) / static_cast<double>(num_taps - 1);
+            tmp[k] = cutoff * Sinc(cutoff * t) * Kaiser(x, beta);
+            sum += tmp[k];
+        }
+        return Make<num_taps>([&](size_t k) { return tmp[k] / sum; });
+    }
+
+    /** The distinct taps of a Blackman-Harris windowed Hilbert kernel of
+        num_taps (odd) taps, in HilbertFir's layout: entry p is the tap
+        2p + 1 after the centre, 2 / (pi (2p + 1)) times the window; the
+        taps before the centre are its negatives, the even ones zero.
+    */
+    template <size_t num_taps>
+    static constexpr std::array<float, (num_taps + 1) / 4> HilbertPairs()
+    {
+        static_assert(num_taps >= 3 && (num_taps & 1) == 1,
+                      "a Hilbert kernel needs an odd number of taps");
+        constexpr size_t center = (num_taps - 1) / 2;
+        return Make<(num_taps + 1) / 4>([](size_t p) {
+            const size_t m = 2 * p + 1;
+            const double x = static_cast<double>(center + m)
+                             / static_cast<double>(num_taps - 1);
+            return 2.0 / (kPi * static_cast<double>(m)) * BlackmanHarris(x);
+        });
+    }
+
+    // constexpr replacements for libm, to double precision over the
+    // ranges the tables use.
+
+    static constexpr double Abs(double x) { return x < 0.0 ? -x : x; }
+
+    static constexpr double Sin(double x)
+    {
+        while(x > kPi)
+            x -= 2.0 * kPi;
+        while(x < -kPi)
+            x += 2.0 * kPi;
+        double term = x, sum = x;
+        for(int n = 1; n < 14; n++)
+        {
+            term *= -x * x / (double)((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    static constexpr double Cos(double x) { return Sin(x + 0.5 * kPi); }
+
+    static constexpr double Tan(double x) { return Sin(x) / Cos(x); }
+
+    static constexpr double Sqrt(double x)
+    {
+        if(x <= 0.0)
+            return 0.0;
+        // Newton from above the root converges monotonically.
+        double r = x > 1.0 ? x : 1.0;
+        for(int i = 0; i < 80; i++)
+        {
+            const double next = 0.5 * (r + x / r);
+            if(next >= r)
+                break;
+            r = next;
+        }
+        return r;
+    }
+
+    static constexpr double Exp(double x)
+    {
+        int halvings = 0;
+        while(x > 0.5 || x < -0.5)
+        {
+            x *= 0.5;
+            halvings++;
+        }
+        double term = 1.0, sum = 1.0;
+        for(int n = 1; n < 18; n++)
+        {
+            term *= x / (double)n;
+            sum += term;
+        }
+        for(int i = 0; i < halvings; i++)
+            sum *= sum;
+        return sum;
+    }
+
+    /** exp(x) - 1 without the cancellation near 0. */
+    static constexpr double Expm1(double x)
+    {
+        if(Abs(x) >= 0.5)
+            return Exp(x) - 1.0;
+        double term = x, sum = x;
+        for(int n = 2; n < 20; n++)
+        {
+            term *= x / (double)n;
+            sum += term;
+        }
+        return sum;
+    }
+
+    static constexpr double Log(double x)
+    {
+        // x = m 2^e with m in [1, 2), then 2 atanh((m - 1) / (m + 1)).
+        int e = 0;
+        while(x >= 2.0)
+        {
+            x *= 0.5;
+            e++;
+        }
+        while(x < 1.0)
+        {
+            x *= 2.0;
+            e--;
+        }
+        const double y = (x - 1.0) / (x + 1.0), y2 = y * y;
+        double       term = y, sum = 0.0;
+        for(int n = 0; n < 30; n++)
+        {
+            sum += term / (double)(2 * n + 1);
+            term *= y2;
+        }
+        return 2.0 * sum + (double)e * kLn2;
+    }
+
+    /** x 2^e, exact. */
+    static constexpr double Ldexp(double x, int e)
+    {
+        for(; e > 0; e--)
+            x *= 2.0;
+        for(; e < 0; e++)
+            x *= 0.5;
+        return x;
+    }
+
+    /** Zeroth-order modified Bessel function, power series. */
+    static constexpr double BesselI0(double x)
+    {
+        double       sum = 1.0, term = 1.0;
+        const double q   = 0.25 * x * x;
+        for(int k = 1; k < 32; k++)
+        {
+            term *= q / static_cast<double>(k * k);
+            sum += term;
+        }
+        return sum;
+    }
+};
+
+inline constexpr size_t ConstTable::kStateBytes = sizeof(ConstTable);
+
+} // namespace daisysp
+#endif
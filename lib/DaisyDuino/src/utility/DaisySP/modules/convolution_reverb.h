@@ -0,0 +1,247 @@
+#pragma once
+#ifndef DSY_CONVOLUTION_REVERB_H
+#define DSY_CONVOLUTION_REVERB_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "fft_convolver.h"
+
+/** @file convolution_reverb.h */
+
+namespace daisysp
+{
+/** @brief Rough cycle costs of FFTConvolver, for sizing an IR to a budget.
+
+    Defaults are estimates for the STM32H750 at -O2 with the partitions
+    in SDRAM; measure a loaded reverb with CpuLoadMeter and scale them
+    if the report is off.
+*/
+struct ConvolutionCost
+{
+#ifdef USE_ARM_DSP
+    float fft = 1.5f; /**< cycles per n log2 n of one real FFT */
+#else
+    float fft = 4.f;
+#endif
+    float bin   = 8.f; /**< cycles per complex bin, per partition */
+    float block = 6.f; /**< copies and mixing, cycles per sample */
+};
+
+/** @brief How much of an IR a ConvolutionReverb runs, and at what cost. */
+struct ConvolutionPlan
+{
+    size_t   taps;           /**< IR samples convolved */
+    size_t   partitions;     /**< blocks of them */
+    size_t   dropped;        /**< IR samples cut off the tail */
+    bool     memory_limited; /**< the partition memory was the limit */
+    bool     budget_limited; /**< the CPU budget was the limit */
+    uint32_t cycles;         /**< expected cycles per block */
+    float    load;           /**< expected part of the block period */
+};
+
+/** @brief Convolution reverb streaming its IR in from read-only memory.
+
+    The impulse response is read in place from any address the core can
+    load from, such as QSPI flash in memory-mapped mode (0x90000000 on
+    the Seed) or a const array in internal flash: no file, no decoding,
+    plain floats at the audio sample rate.
+
+    Loading transforms the IR into FFTConvolver partitions in caller
+    memory, e.g. DSY_SDRAM_BSS, which take 4 * block floats each. It runs
+    from the main loop, a few partitions per LoadStep(), and the audio
+    side plays dry until the last one is in; the audio interrupt never
+    sees a partly loaded filter, and nothing is transformed on it.
+
+    Plan() picks how many partitions to run before loading: the IR, the
+    memory and a CPU budget each bound it, using ConvolutionCost. The
+    plan it returns is the load-time report: taps kept and dropped, which
+    limit applied, and the expected cycles and load per block.
+
+    declaration example:
+
+    static float DSY_SDRAM_BSS parts[64 * 4 * 128];
+    static ConvolutionReverb<64> reverb;
+    reverb.Init(sample_rate, parts, 64 * 4 * 128);
+    ConvolutionPlan plan = reverb.Plan(ir_len, .25f);
+    reverb.Load(reinterpret_cast<const float *>(0x90000000), plan);
+    while(!reverb.LoadStep()) {}
+    ...
+    reverb.ProcessBlock(in[0], out[0], size); // size a multiple of 64
+
+    \param block Partition length, a power of two from 16 to 2048
+*/
+template <size_t block>
+class ConvolutionReverb
+{
+  public:
+    static const size_t kStateBytes;
+
+    ConvolutionReverb() {}
+    ~ConvolutionReverb() {}
+
+    /** Initializes with no IR, dry only, half wet once loaded.
+        \param sample_rate Audio engine sample rate
+        \param mem Partition memory, e.g. in SDRAM
+        \param size Floats at mem, 4 * block per partition
+    */
+    void Init(float sample_rate, float* mem, size_t size)
+    {
+        sample_rate_ = sample_rate;
+        conv_.SetPartitionBuffer(mem, size);
+        ir_      = nullptr;
+        ir_len_  = 0;
+        loaded_  = 0;
+        to_load_ = 0;
+        ready_   = false;
+        SetMix(.5f);
+    }
+
+    /** Sizes an IR to the memory and a CPU budget; does not load it.
+        \param ir_len IR length in samples
+        \param budget Part of the block period to spend, e.g. .25; at
+                      least one partition is always kept
+        \param cpu_hz Core clock
+        \param cost Cycle estimates
+    */
+    ConvolutionPlan Plan(size_t                 ir_len,
+                         float                  budget,
+                         float                  cpu_hz = 480000000.f,
+                         const ConvolutionCost& cost   = ConvolutionCost())
+        const
+    {
+        ConvolutionPlan plan;
+        const size_t    wanted = (ir_len + block - 1) / block;
+        const size_t    memory = conv_.GetMaxPartitions();
+
+        const float period = cpu_hz * static_cast<float>(block) / sample_rate_;
+        const float fixed  = FixedCycles(cost);
+        const float per    = cost.bin * static_cast<float>(block);
+        const float spare  = budget * period - fixed;
+        const size_t afford
+            = spare > per ? static_cast<size_t>(spare / per) : 1;
+
+        size_t parts        = wanted;
+        plan.memory_limited = memory < parts;
+        parts               = plan.memory_limited ? memory : parts;
+        plan.budget_limited = afford < parts;
+        parts               = plan.budget_limited ? afford : parts;
+
+        plan.partitions = parts;
+        plan.taps       = parts * block < ir_len ? parts * block : ir_len;
+        plan.dropped    = ir_len - plan.taps;
+        const float cycles
+            = parts > 0 ? fixed + per * static_cast<float>(parts) : 0.f;
+        plan.cycles = static_cast<uint32_t>(cycles);
+        plan.load   = cycles / period;
+        return plan;
+    }
+
+    /** Starts loading an IR as planned; the output is dry until done.
+        Call from the main loop, not the audio callback.
+        \param ir IR samples, e.g. memory-mapped QSPI flash
+        \param plan From Plan(), for this IR
+        \return false if nothing fits
+    */
+    bool Load(const float* ir, const ConvolutionPlan& plan)
+    {
+        // Taken before touching the partitions; the audio interrupt
+        // checks it once per block, so it is not mid-filter after this.
+        ready_   = false;
+        ir_      = ir;
+        ir_len_  = plan.taps;
+        to_load_ = conv_.BeginIR(plan.taps);
+        loaded_  = 0;
+        return to_load_ > 0;
+    }
+
+    /** Transforms the next partitions of the IR being loaded.
+        \param count Partitions per call, each one real FFT
+        \return true once the IR is in and playing
+    */
+    bool LoadStep(size_t count = 4)
+    {
+        if(ready_ || to_load_ == 0)
+            return ready_;
+        for(size_t i = 0; i < count && loaded_ < to_load_; i++)
+        {
+            conv_.LoadPartition(ir_, ir_len_, loaded_++);
+        }
+        if(loaded_ == to_load_)
+        {
+            conv_.Reset();
+            ready_ = true;
+        }
+        return ready_;
+    }
+
+    /** Mixes the reverb into a block; dry only while loading.
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size A multiple of block
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        if(!ready_)
+        {
+            for(size_t i = 0; i < size; i++)
+            {
+                out[i] = in[i] * dry_;
+            }
+            return;
+        }
+        for(size_t pos = 0; pos < size; pos += block)
+        {
+            conv_.ProcessBlock(in + pos, wet_buf_, block);
+            for(size_t i = 0; i < block; i++)
+            {
+                out[pos + i] = in[pos + i] * dry_ + wet_buf_[i] * wet_;
+            }
+        }
+    }
+
+    /** Dry to wet balance
+        \param mix 0 dry to 1 wet
+    */
+    inline void SetMix(float mix)
+    {
+        mix  = fclamp(mix, 0.f, 1.f);
+        dry_ = 1.f - mix;
+        wet_ = mix;
+    }
+
+    /** \return whether an IR is loaded and playing */
+    inline bool IsReady() const { return ready_; }
+
+    /** \return partitions of the IR loaded so far */
+    inline size_t GetLoaded() const { return loaded_; }
+
+    static constexpr size_t GetBlockSize() { return block; }
+
+  private:
+    /** Per block cost independent of the IR length */
+    static float FixedCycles(const ConvolutionCost& cost)
+    {
+        const float n = 2.f * static_cast<float>(block);
+        return 2.f * cost.fft * n * log2f(n)
+               + cost.block * static_cast<float>(block);
+    }
+
+    FFTConvolver<block, FFTCONVOLVER_USER_MEMORY> conv_;
+
+    float         sample_rate_;
+    float         dry_, wet_;
+    const float*  ir_;
+    size_t        ir_len_, loaded_, to_load_;
+    volatile bool ready_;
+
+    float wet_buf_[block];
+};
+
+template <size_t block>
+constexpr size_t ConvolutionReverb<block>::kStateBytes
+    = sizeof(ConvolutionReverb<block>);
+} // namespace daisysp
+#endif
+#endif
@@ -1,6 +1,7 @@
 #include <math.h>
 #include "crossfade.h"
 #include "dsp.h"
+#include "fast_sin.h"
 
 #define REALLYSMALLFLOAT 0.000001f
 
@@ -9,29 +10,62 @@ using namespace daisysp;
 const float kCrossLogMin = logf(REALLYSMALLFLOAT);
 const float kCrossLogMax = logf(1.0f);
 
-float CrossFade::Process(float &in1, float &in2)
+void CrossFade::Init(int curve)
 {
-    float scalar_1, scalar_2;
+    FastSin::Init();
+    pos_   = 0.5f;
+    curve_ = curve < CROSSFADE_LAST ? curve : CROSSFADE_LIN;
+    UpdateGains();
+    last1_ = gain1_;
+    last2_ = gain2_;
+}
+
+void CrossFade::UpdateGains()
+{
+    float scalar_1;
     switch(curve_)
     {
-        case CROSSFADE_LIN:
-            scalar_1 = pos_;
-            return (in1 * (1.0f - scalar_1)) + (in2 * scalar_1);
+        case CROSSFADE_LIN: scalar_1 = pos_; break;
 
         case CROSSFADE_CPOW:
-            scalar_1 = sinf(pos_ * HALFPI_F);
-            scalar_2 = sinf((1.0f - pos_) * HALFPI_F);
-            return (in1 * scalar_2) + (in2 * scalar_1);
+            // sin and cos of a quarter turn, libm-free.
+            gain1_ = FastSin::Sin((1.0f - pos_) * 0.25f);
+            gain2_ = FastSin::Sin(pos_ * 0.25f);
+            return;
 
         case CROSSFADE_LOG:
             scalar_1
-                = expf(pos_ * (kCrossLogMax - kCrossLogMin) + kCrossLogMin);
-            return (in1 * (1.0f - scalar_1)) + (in2 * scalar_1);
+                = math::exp(pos_ * (kCrossLogMax - kCrossLogMin) + kCrossLogMin);
+            break;
+
+        case CROSSFADE_EXP: scalar_1 = pos_ * pos_; break;
 
-        case CROSSFADE_EXP:
-            scalar_1 = pos_ * pos_;
-            return (in1 * (1.0f - scalar_1)) + (in2 * scalar_1);
+        default:
+            gain1_ = gain2_ = 0.0f;
+            return;
+    }
+    gain1_ = 1.0f - scalar_1;
+    gain2_ = scalar_1;
+}
 
-        default: return 0;
+void CrossFade::ProcessBlock(const float *in1,
+                             const float *in2,
+                             float *      out,
+                             size_t       size)
+{
+    if(size == 0)
+        return;
+    const float step = 1.0f / size;
+    const float d1   = (gain1_ - last1_) * step;
+    const float d2   = (gain2_ - last2_) * step;
+    float       g1   = last1_;
+    float       g2   = last2_;
+    for(size_t i = 0; i < size; i++)
+    {
+        g1 += d1;
+        g2 += d2;
+        out[i] = (in1[i] * g1) + (in2[i] * g2);
     }
+    last1_ = gain1_;
+    last2_ = gain2_;
 }
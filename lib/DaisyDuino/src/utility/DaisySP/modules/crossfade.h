@@ -2,6 +2,7 @@
 #ifndef DSY_CROSSFADE_H
 #define DSY_CROSSFADE_H
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -29,10 +30,16 @@ enum
     Ported from Soundpipe by Andrew Ikenberry
 
     added curve option for constant power, etc.
+
+    The two gains are worked out when the position or the curve changes,
+    not per sample; ProcessBlock() ramps them from the last block's to
+    the current ones, so a position set once per block does not step.
 */
 class CrossFade
 {
   public:
+    static const size_t kStateBytes;
+
     CrossFade() {}
     ~CrossFade() {}
     /** Initializes CrossFade module
@@ -40,28 +47,51 @@ class CrossFade
         - current position = .5
         - curve = linear
     */
-    inline void Init(int curve)
-    {
-        pos_   = 0.5f;
-        curve_ = curve < CROSSFADE_LAST ? curve : CROSSFADE_LIN;
-    }
+    void Init(int curve);
 
     /** Initialize with default linear curve 
     */
     inline void Init() { Init(CROSSFADE_LIN); }
     /** processes CrossFade and returns single sample
     */
-    float Process(float &in1, float &in2);
+    inline float Process(float &in1, float &in2)
+    {
+        last1_ = gain1_;
+        last2_ = gain2_;
+        return (in1 * gain1_) + (in2 * gain2_);
+    }
+
+    /** CrossFades a block, the gains ramped from the previous block's
+        \param in1 First input, at position 0
+        \param in2 Second input, at position 1
+        \param out Output, may be either input
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in1, const float *in2, float *out, size_t size);
 
 
     /** Sets position of CrossFade between two input signals
         Input range: 0 to 1
     */
-    inline void SetPos(float pos) { pos_ = pos; }
+    inline void SetPos(float pos)
+    {
+        if(pos != pos_)
+        {
+            pos_ = pos;
+            UpdateGains();
+        }
+    }
     /** Sets current curve applied to CrossFade 
     Expected input: See [Curve Options](##curve-options)
     */
-    inline void SetCurve(uint8_t curve) { curve_ = curve; }
+    inline void SetCurve(uint8_t curve)
+    {
+        if(curve != curve_)
+        {
+            curve_ = curve;
+            UpdateGains();
+        }
+    }
     /** Returns current position
     */
     inline float GetPos(float pos) { return pos_; }
@@ -70,9 +100,15 @@ class CrossFade
     inline uint8_t GetCurve(uint8_t curve) { return curve_; }
 
   private:
+    void UpdateGains();
+
     float   pos_;
+    float   gain1_, gain2_; /**< at pos_ */
+    float   last1_, last2_; /**< where the last block or sample ended */
     uint8_t curve_;
 };
+
+inline constexpr size_t CrossFade::kStateBytes = sizeof(CrossFade);
 } // namespace daisysp
 #endif
 #endif
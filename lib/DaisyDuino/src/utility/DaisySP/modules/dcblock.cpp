@@ -18,3 +18,22 @@ float DcBlock::Process(float in)
     input_  = in;
     return out;
 }
+
+void DcBlock::ProcessBlock(const float* in, float* out, size_t size)
+{
+    const float gain   = gain_;
+    float       input  = input_;
+    float       output = output_;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        const float x = in[i];
+        output        = x - input + (gain * output);
+        input         = x;
+        out[i]        = output;
+    }
+
+    input_  = input;
+    output_ = output;
+}
+
@@ -4,6 +4,8 @@
 #define DSY_DCBLOCK_H
 #ifdef __cplusplus
 
+#include <stddef.h>
+
 namespace daisysp
 {
 /** Removes DC component of a signal
@@ -11,6 +13,8 @@ namespace daisysp
 class DcBlock
 {
   public:
+    static const size_t kStateBytes;
+
     DcBlock(){};
     ~DcBlock(){};
 
@@ -22,9 +26,15 @@ class DcBlock
     */
     float Process(float in);
 
+    /** performs DcBlock Process on a block; out may be in
+    */
+    void ProcessBlock(const float* in, float* out, size_t size);
+
   private:
     float input_, output_, gain_;
 };
+
+inline constexpr size_t DcBlock::kStateBytes = sizeof(DcBlock);
 } // namespace daisysp
 #endif
 #endif
@@ -3,6 +3,7 @@
 #ifndef DECIMATOR_H
 #define DECIMATOR_H
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -12,6 +13,8 @@ namespace daisysp
 class Decimator
 {
   public:
+    static const size_t kStateBytes;
+
     Decimator() {}
     ~Decimator() {}
     /** Initializes downsample module
@@ -64,6 +67,8 @@ class Decimator
     float         downsampled_, bitcrushed_;
     uint32_t      inc_, threshold_;
 };
+
+inline constexpr size_t Decimator::kStateBytes = sizeof(Decimator);
 } // namespace daisysp
 #endif
 #endif
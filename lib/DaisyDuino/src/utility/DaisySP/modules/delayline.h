@@ -3,8 +3,52 @@
 #define DSY_DELAY_H
 #include <stdlib.h>
 #include <stdint.h>
+#include "dsp.h"
 namespace daisysp
 {
+/** How a DelayLine stores its samples.
+
+The default keeps T as it is. Specialisations store a narrower type
+and convert on every access, with the arithmetic in float: int16_t
+(full scale +-1, saturating) always, and __fp16 where the compiler
+provides it (-mfp16-format=ieee on ARM GCC). Either halves the
+footprint and memory traffic of a long line in SDRAM, at the price of
+a conversion per sample moved; int16_t has about 90 dB of dynamic
+range, __fp16 an 11-bit mantissa at any level.
+*/
+template <typename T>
+struct DelaySample
+{
+    typedef T value_type;
+    static inline T Load(const T s) { return s; }
+    static inline T Store(const T v) { return v; }
+};
+
+template <>
+struct DelaySample<int16_t>
+{
+    typedef float value_type;
+    static inline float Load(const int16_t s)
+    {
+        return static_cast<float>(s) * (1.0f / 32767.0f);
+    }
+    static inline int16_t Store(float v)
+    {
+        v = v > 1.0f ? 1.0f : (v < -1.0f ? -1.0f : v);
+        return static_cast<int16_t>(v * 32767.0f + (v < 0.0f ? -0.5f : 0.5f));
+    }
+};
+
+#if defined(__ARM_FP16_FORMAT_IEEE)
+template <>
+struct DelaySample<__fp16>
+{
+    typedef float value_type;
+    static inline float  Load(const __fp16 s) { return s; }
+    static inline __fp16 Store(const float v) { return v; }
+};
+#endif
+
 /** Simple Delay line.
 November 2019
 
@@ -14,27 +58,43 @@ declaration example: (1 second of floats)
 
 DelayLine<float, SAMPLE_RATE> del;
 
+Half the memory, with samples still written and read as float:
+
+DelayLine<int16_t, SAMPLE_RATE> del;
+
+Storage is rounded up to a power of two so every index wraps with a
+mask; the usable delay is still max_size - 1 samples.
+
 By: shensley
 */
 template <typename T, size_t max_size>
 class DelayLine
 {
   public:
+    static const size_t kStateBytes;
+
+    /** What Write() takes and Read() returns: float for the 16-bit
+        storage types, otherwise T */
+    typedef typename DelaySample<T>::value_type value_type;
+
     DelayLine() {}
     ~DelayLine() {}
     /** initializes the delay line by clearing the values within, and setting delay to 1 sample.
     */
     void Init() { Reset(); }
+    /** as Init(), for a line whose memory already reads as zero: no pass
+        over the buffer, which for a long line is most of the cost.
+    */
+    void Init(ZeroedMemory) { Restart(); }
     /** clears buffer, sets write ptr to 0, and delay to 1 sample.
     */
     void Reset()
     {
-        for(size_t i = 0; i < max_size; i++)
+        for(size_t i = 0; i < kSize; i++)
         {
             line_[i] = T(0);
         }
-        write_ptr_ = 0;
-        delay_     = 1;
+        Restart();
     }
 
     /** sets the delay time in samples
@@ -59,63 +119,160 @@ class DelayLine
 
     /** writes the sample of type T to the delay line, and advances the write ptr
     */
-    inline void Write(const T sample)
+    inline void Write(const value_type sample)
     {
-        line_[write_ptr_] = sample;
-        write_ptr_        = (write_ptr_ - 1 + max_size) % max_size;
+        line_[write_ptr_] = Store(sample);
+        write_ptr_        = (write_ptr_ - 1) & kMask;
+    }
+
+    /** writes size samples, as size calls to Write()
+    */
+    inline void WriteBlock(const value_type* in, size_t size)
+    {
+        size_t i = 0;
+        while(i < size)
+        {
+            // Runs down from write_ptr_ to 0, then wraps once to the top.
+            const size_t run = size - i < write_ptr_ + 1 ? size - i
+                                                         : write_ptr_ + 1;
+            T* dst = &line_[write_ptr_];
+            for(size_t k = 0; k < run; k++)
+            {
+                *dst-- = Store(in[i + k]);
+            }
+            i += run;
+            write_ptr_ = (write_ptr_ - run) & kMask;
+        }
     }
 
     /** returns the next sample of type T in the delay line, interpolated if necessary.
     */
-    inline const T Read() const
+    inline const value_type Read() const
     {
-        T a = line_[(write_ptr_ + delay_) % max_size];
-        T b = line_[(write_ptr_ + delay_ + 1) % max_size];
+        value_type a = Load(line_[(write_ptr_ + delay_) & kMask]);
+        value_type b = Load(line_[(write_ptr_ + delay_ + 1) & kMask]);
         return a + (b - a) * frac_;
     }
 
+    /** reads size samples at the current delay, as Read() would return
+        before each of the next size calls to Write(). So ReadBlock() then
+        WriteBlock() of the same size is size rounds of Read() then Write(),
+        for delays of at least size samples.
+    */
+    inline void ReadBlock(value_type* out, size_t size) const
+    {
+        size_t p = (write_ptr_ + delay_) & kMask;
+        size_t i = 0;
+        while(i < size)
+        {
+            if(p == kMask)
+            {
+                // The one sample whose neighbour wraps.
+                const value_type a = Load(line_[kMask]);
+                out[i++]           = a + (Load(line_[0]) - a) * frac_;
+                p--;
+                continue;
+            }
+            const size_t run = size - i < p + 1 ? size - i : p + 1;
+            const T*     src = &line_[p];
+            for(size_t k = 0; k < run; k++, src--)
+            {
+                const value_type a = Load(src[0]);
+                out[i + k]         = a + (Load(src[1]) - a) * frac_;
+            }
+            i += run;
+            p = (p - run) & kMask;
+        }
+    }
+
     /** Read from a set location */
-    inline const T Read(float delay) const
+    inline const value_type Read(float delay) const
     {
         int32_t delay_integral   = static_cast<int32_t>(delay);
         float   delay_fractional = delay - static_cast<float>(delay_integral);
-        const T a = line_[(write_ptr_ + delay_integral) % max_size];
-        const T b = line_[(write_ptr_ + delay_integral + 1) % max_size];
+        const size_t     t = write_ptr_ + delay_integral;
+        const value_type a = Load(line_[t & kMask]);
+        const value_type b = Load(line_[(t + 1) & kMask]);
         return a + (b - a) * delay_fractional;
     }
 
-    inline const T ReadHermite(float delay) const
+    inline const value_type ReadHermite(float delay) const
     {
         int32_t delay_integral   = static_cast<int32_t>(delay);
         float   delay_fractional = delay - static_cast<float>(delay_integral);
 
-        int32_t     t     = (write_ptr_ + delay_integral + max_size);
-        const T     xm1   = line_[(t - 1) % max_size];
-        const T     x0    = line_[(t) % max_size];
-        const T     x1    = line_[(t + 1) % max_size];
-        const T     x2    = line_[(t + 2) % max_size];
-        const float c     = (x1 - xm1) * 0.5f;
-        const float v     = x0 - x1;
-        const float w     = c + v;
-        const float a     = w + v + (x2 - x0) * 0.5f;
-        const float b_neg = w + a;
-        const float f     = delay_fractional;
+        const size_t     t     = write_ptr_ + delay_integral;
+        const value_type xm1   = Load(line_[(t - 1) & kMask]);
+        const value_type x0    = Load(line_[t & kMask]);
+        const value_type x1    = Load(line_[(t + 1) & kMask]);
+        const value_type x2    = Load(line_[(t + 2) & kMask]);
+        const float      c     = (x1 - xm1) * 0.5f;
+        const float      v     = x0 - x1;
+        const float      w     = c + v;
+        const float      a     = w + v + (x2 - x0) * 0.5f;
+        const float      b_neg = w + a;
+        const float      f     = delay_fractional;
         return (((a * f) - b_neg) * f + c) * f + x0;
     }
 
-    inline const T Allpass(const T sample, size_t delay, const T coefficient)
+    /** Read from a set location through a first-order allpass, which
+        keeps a flat magnitude at any fraction where linear interpolation
+        dulls the top end. Suits fixed or slowly moving delays, such as
+        tuning a string; state holds the previous output, one per reader,
+        starting at 0.
+    */
+    inline const value_type ReadAllpass(float delay, value_type& state) const
     {
-        T read  = line_[(write_ptr_ + delay) % max_size];
-        T write = sample + coefficient * read;
+        int32_t delay_integral   = static_cast<int32_t>(delay);
+        float   delay_fractional = delay - static_cast<float>(delay_integral);
+
+        const size_t     t   = write_ptr_ + delay_integral;
+        const value_type a   = Load(line_[t & kMask]);
+        const value_type b   = Load(line_[(t + 1) & kMask]);
+        const float      eta = (1.0f - delay_fractional) / (1.0f + delay_fractional);
+        state                = b + (a - state) * eta;
+        return state;
+    }
+
+    inline const value_type
+    Allpass(const value_type sample, size_t delay, const value_type coefficient)
+    {
+        value_type read  = Load(line_[(write_ptr_ + delay) & kMask]);
+        value_type write = sample + coefficient * read;
         Write(write);
         return -write * coefficient + read;
     }
 
   private:
+    void Restart()
+    {
+        frac_      = 0.0f;
+        write_ptr_ = 0;
+        delay_     = 1;
+    }
+
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    static inline value_type Load(const T s) { return DelaySample<T>::Load(s); }
+    static inline T Store(const value_type v) { return DelaySample<T>::Store(v); }
+
+    static constexpr size_t kSize = RoundUp(max_size);
+    static constexpr size_t kMask = kSize - 1;
+
     float  frac_;
     size_t write_ptr_;
     size_t delay_;
-    T      line_[max_size];
+    T      line_[kSize];
 };
+
+template <typename T, size_t max_size>
+constexpr size_t DelayLine<T, max_size>::kStateBytes
+    = sizeof(DelayLine<T, max_size>);
 } // namespace daisysp
 #endif
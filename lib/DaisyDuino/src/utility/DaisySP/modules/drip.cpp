@@ -1,6 +1,5 @@
 #include "drip.h"
 #include <math.h>
-#include <cstdlib>
 #include "dsp.h"
 
 using namespace daisysp;
@@ -18,19 +17,18 @@ using namespace daisysp;
 
 int Drip::my_random(int max)
 {
-    return (rand() % (max + 1));
+    return static_cast<int>(rng_.NextBelow(static_cast<uint32_t>(max) + 1));
 }
 
 float Drip::noise_tick()
 {
-    float temp;
-    temp = 1.0f * rand() - 1073741823.5f;
-    return temp * (1.0f / 1073741823.0f);
+    return rng_.NextBipolar();
 }
 
 void Drip::Init(float sample_rate, float dettack)
 {
     sample_rate_ = sample_rate;
+    rng_.Init();
     float temp;
     dettack_   = dettack;
     num_tubes_ = 10;
@@ -63,11 +61,11 @@ void Drip::Init(float sample_rate, float dettack)
     temp    = logf(WUTR_NUM_SOURCES) * WUTR_GAIN / WUTR_NUM_SOURCES;
     gains0_ = gains1_ = gains2_ = temp;
     coeffs01_                   = WUTR_RESON * WUTR_RESON;
-    coeffs00_ = -WUTR_RESON * 2.0f * cosf(WUTR_CENTER_FREQ0 * tpidsr);
+    coeffs00_ = -WUTR_RESON * 2.0f * math::cos(WUTR_CENTER_FREQ0 * tpidsr);
     coeffs11_ = WUTR_RESON * WUTR_RESON;
-    coeffs10_ = -WUTR_RESON * 2.0f * cosf(WUTR_CENTER_FREQ1 * tpidsr);
+    coeffs10_ = -WUTR_RESON * 2.0f * math::cos(WUTR_CENTER_FREQ1 * tpidsr);
     coeffs21_ = WUTR_RESON * WUTR_RESON;
-    coeffs20_ = -WUTR_RESON * 2.0f * cosf(WUTR_CENTER_FREQ2 * tpidsr);
+    coeffs20_ = -WUTR_RESON * 2.0f * math::cos(WUTR_CENTER_FREQ2 * tpidsr);
 
     shake_energy_ = amp_ * 1.0f * MAX_SHAKE * 0.1f;
     shake_damp_   = 0.0f;
@@ -100,7 +98,7 @@ float Drip::Process(bool trig)
     if(freq_ != 0.0f && freq_ != res_freq0_)
     {
         res_freq0_ = freq_;
-        coeffs00_  = -WUTR_RESON * 2.0f * cosf(res_freq0_ * tpidsr);
+        coeffs00_  = -WUTR_RESON * 2.0f * math::cos(res_freq0_ * tpidsr);
     }
     if(damp_ != 0.0f && damp_ != shake_damp_)
     {
@@ -117,12 +115,12 @@ float Drip::Process(bool trig)
     if(freq1_ != 0.0f && freq1_ != res_freq1_)
     {
         res_freq1_ = freq1_;
-        coeffs10_  = -WUTR_RESON * 2.0f * cosf(res_freq1_ * tpidsr);
+        coeffs10_  = -WUTR_RESON * 2.0f * math::cos(res_freq1_ * tpidsr);
     }
     if(freq2_ != 0.0f && freq2_ != res_freq2_)
     {
         res_freq2_ = freq2_;
-        coeffs20_  = -WUTR_RESON * 2.0f * cosf(res_freq2_ * tpidsr);
+        coeffs20_  = -WUTR_RESON * 2.0f * math::cos(res_freq2_ * tpidsr);
     }
     if((--kloop_) == 0.0f)
     {
@@ -164,19 +162,19 @@ float Drip::Process(bool trig)
     if(gains0_ > 0.001f)
     {
         center_freqs0_ *= WUTR_FREQ_SWEEP;
-        coeffs00_ = -WUTR_RESON * 2.0f * cosf(center_freqs0_ * tpidsr);
+        coeffs00_ = -WUTR_RESON * 2.0f * math::cos(center_freqs0_ * tpidsr);
     }
     gains1_ *= WUTR_RESON;
     if(gains1_ > 0.00f)
     {
         center_freqs1_ *= WUTR_FREQ_SWEEP;
-        coeffs10_ = -WUTR_RESON * 2.0f * cosf(center_freqs1_ * tpidsr);
+        coeffs10_ = -WUTR_RESON * 2.0f * math::cos(center_freqs1_ * tpidsr);
     }
     gains2_ *= WUTR_RESON;
     if(gains2_ > 0.001f)
     {
         center_freqs2_ *= WUTR_FREQ_SWEEP;
-        coeffs20_ = -WUTR_RESON * 2.0f * cosf(center_freqs2_ * tpidsr);
+        coeffs20_ = -WUTR_RESON * 2.0f * math::cos(center_freqs2_ * tpidsr);
     }
 
     sndLevel *= soundDecay;
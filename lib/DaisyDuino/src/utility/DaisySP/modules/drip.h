@@ -3,6 +3,8 @@
 #define DSY_DRIP_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include "fast_random.h"
 #ifdef __cplusplus
 
 /**  @file drip.h */
@@ -18,6 +20,8 @@ namespace daisysp
 class Drip
 {
   public:
+    static const size_t kStateBytes;
+
     Drip() {}
     ~Drip() {}
 
@@ -28,6 +32,11 @@ class Drip
     */
     void Init(float sample_rate, float dettack);
 
+    /** Restarts the noise and the drip timing from a given seed, for
+        repeatable output. Call after Init().
+    */
+    void SetSeed(uint32_t seed) { rng_.Init(seed); }
+
     /** 
         Process the next floating point sample.
         \param trig If true, begins a new drip.
@@ -47,7 +56,11 @@ class Drip
 
     int   my_random(int max);
     float noise_tick();
+
+    FastRandom rng_;
 };
+
+inline constexpr size_t Drip::kStateBytes = sizeof(Drip);
 } // namespace daisysp
 #endif
 #endif
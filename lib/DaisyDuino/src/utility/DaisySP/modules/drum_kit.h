@@ -0,0 +1,271 @@
+#pragma once
+#ifndef DSY_DRUM_KIT_H
+#define DSY_DRUM_KIT_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <tuple>
+#include <utility>
+#include "pending_trigger.h"
+
+/** @file drum_kit.h */
+
+namespace daisysp
+{
+/** @brief A fixed set of triggered drum voices that sleep once silent.
+
+    Each Drum is any class with
+
+        void  Init(float sample_rate);
+        void  Trig();
+        float Process();
+
+    as AnalogBassDrum, AnalogSnareDrum, SyntheticBassDrum,
+    SyntheticSnareDrum, HiHat, ModalVoice and StringVoice all have
+    (Process(bool trigger) with its default).
+
+    None of them says when it has decayed, so the kit watches the output
+    instead: a voice is sounding from its strike until hold_time of
+    consecutive samples under the threshold, and asleep after that, not
+    processed at all, until the next Trig(). A sleeping voice costs one
+    flag test per block, so between hits a kit costs next to nothing
+    however many voices it has. A voice in sustain never falls silent and
+    so never sleeps, nor does one that rings on, as AnalogSnareDrum's
+    shell does for tens of seconds at the default decay; one whose tail
+    is wanted below -80 dBFS needs a lower SetThreshold().
+
+    Its state stays as it was when it fell asleep, with its tail some way
+    under the threshold, and it picks up from there on the next Trig().
+
+    Trig(idx, offset) strikes offset samples into the next block, the
+    kit calling the voice's own Trig() on that sample, so a voice struck
+    mid-block starts there whatever its block size.
+
+    declaration example:
+
+    DrumKit<AnalogBassDrum, SyntheticSnareDrum, HiHat<>> kit;
+    kit.Init(sample_rate);
+    kit.Get<0>().SetFreq(50.f);
+    ...
+    kit.Trig(0);
+    kit.ProcessBlock(out, size);
+*/
+template <class... Drums>
+class DrumKit
+{
+  public:
+    static const size_t kStateBytes;
+
+    DrumKit() {}
+    ~DrumKit() {}
+
+    static constexpr size_t kNumVoices = sizeof...(Drums);
+
+    /** Initializes every voice, all asleep at level 1.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        std::apply(
+            [sample_rate](auto &... drum) { (drum.Init(sample_rate), ...); },
+            drums_);
+        for(size_t i = 0; i < kNumVoices; i++)
+        {
+            level_[i]    = 1.0f;
+            quiet_[i]    = 0;
+            sounding_[i] = false;
+            trig_at_[i].Init();
+        }
+        num_active_ = 0;
+        SetThreshold(1e-4f);
+        SetHoldTime(0.01f);
+    }
+
+    /** Strikes voice idx, waking it.
+        \param offset Samples into the next Process / ProcessBlock to
+               strike on; past the block's end it carries into the next.
+               0, the next sample, by default.
+    */
+    void Trig(size_t idx, size_t offset = 0)
+    {
+        if(idx < kNumVoices)
+            trig_at_[idx].Set(offset);
+    }
+
+    /** Sums one sample of the voices that are sounding. */
+    float Process()
+    {
+        float sum = 0.0f;
+        ProcessAll(sum, std::index_sequence_for<Drums...>{});
+        return sum;
+    }
+
+    /** Fills out with the sum of the sounding voices, the same as
+        Process() for each sample, running one voice over the block at a
+        time.
+    */
+    void ProcessBlock(float *out, size_t size)
+    {
+        for(size_t j = 0; j < size; j++)
+            out[j] = 0.0f;
+        BlockAll(out, size, std::index_sequence_for<Drums...>{});
+    }
+
+    /** Writes each voice to its own block, outs[i] for voice i, sleeping
+        ones as silence, for a mixer or separate outputs. The per-voice
+        levels apply here too.
+    */
+    void ProcessBlock(float *const *outs, size_t size)
+    {
+        for(size_t i = 0; i < kNumVoices; i++)
+        {
+            for(size_t j = 0; j < size; j++)
+                outs[i][j] = 0.0f;
+        }
+        SplitAll(outs, size, std::index_sequence_for<Drums...>{});
+    }
+
+    /** Output level of voice idx in the sum, 1 by default. */
+    inline void SetLevel(size_t idx, float level)
+    {
+        if(idx < kNumVoices)
+            level_[idx] = level;
+    }
+
+    /** The level under which the output counts as silence.
+        \param threshold Linear, 1e-4 (-80 dBFS) by default
+    */
+    inline void SetThreshold(float threshold) { threshold_ = threshold; }
+
+    /** How long the output must stay under the threshold before the
+        voice sleeps: long enough to span the decay's slow zero crossings.
+        \param seconds 10 ms by default
+    */
+    inline void SetHoldTime(float seconds)
+    {
+        const float n = seconds * sample_rate_;
+        hold_         = n > 1.0f ? static_cast<uint32_t>(n) : 1;
+    }
+
+    /** \return whether voice idx is sounding (is processed) */
+    inline bool IsSounding(size_t idx) const
+    {
+        return idx < kNumVoices && sounding_[idx];
+    }
+
+    /** \return voices sounding after the last Process / ProcessBlock */
+    inline size_t GetActiveCount() const { return num_active_; }
+
+    /** \return voice idx, for its settings */
+    template <size_t idx>
+    auto &Get()
+    {
+        return std::get<idx>(drums_);
+    }
+
+  private:
+    template <size_t... I>
+    inline void ProcessAll(float &sum, std::index_sequence<I...>)
+    {
+        (ProcessOne<I>(sum), ...);
+    }
+
+    template <size_t I>
+    inline void ProcessOne(float &sum)
+    {
+        if(trig_at_[I].Advance(1) == 0)
+            Strike<I>();
+        if(!sounding_[I])
+            return;
+        const float s = std::get<I>(drums_).Process();
+        sum += s * level_[I];
+        quiet_[I] = fabsf(s) < threshold_ ? quiet_[I] + 1 : 0;
+        if(quiet_[I] >= hold_)
+            Sleep(I);
+    }
+
+    template <size_t... I>
+    inline void BlockAll(float *out, size_t size, std::index_sequence<I...>)
+    {
+        (BlockOne<I>(out, size), ...);
+    }
+
+    template <size_t... I>
+    inline void
+    SplitAll(float *const *outs, size_t size, std::index_sequence<I...>)
+    {
+        (BlockOne<I>(outs[I], size), ...);
+    }
+
+    /** Adds voice I into out, striking it where its trigger falls */
+    template <size_t I>
+    inline void BlockOne(float *out, size_t size)
+    {
+        const size_t at = trig_at_[I].Advance(size);
+        RunOne<I>(out, 0, at);
+        if(at < size)
+        {
+            Strike<I>();
+            RunOne<I>(out, at, size);
+        }
+    }
+
+    template <size_t I>
+    inline void Strike()
+    {
+        std::get<I>(drums_).Trig();
+        quiet_[I] = 0;
+        if(!sounding_[I])
+        {
+            sounding_[I] = true;
+            num_active_++;
+        }
+    }
+
+    /** Adds voice I into out from begin to end or until it sleeps */
+    template <size_t I>
+    inline void RunOne(float *out, size_t begin, size_t end)
+    {
+        if(!sounding_[I])
+            return;
+        auto &         drum      = std::get<I>(drums_);
+        const float    level     = level_[I];
+        const float    threshold = threshold_;
+        const uint32_t hold      = hold_;
+        uint32_t       quiet     = quiet_[I];
+        for(size_t j = begin; j < end && quiet < hold; j++)
+        {
+            const float s = drum.Process();
+            out[j] += s * level;
+            quiet = fabsf(s) < threshold ? quiet + 1 : 0;
+        }
+        quiet_[I] = quiet;
+        if(quiet >= hold)
+            Sleep(I);
+    }
+
+    inline void Sleep(size_t idx)
+    {
+        sounding_[idx] = false;
+        num_active_--;
+    }
+
+    std::tuple<Drums...> drums_;
+    float                level_[kNumVoices];
+    uint32_t quiet_[kNumVoices]; /**< consecutive samples under threshold_ */
+    bool     sounding_[kNumVoices];
+    PendingTrigger trig_at_[kNumVoices];
+    size_t   num_active_;
+    float    threshold_;
+    uint32_t hold_;
+    float    sample_rate_;
+};
+
+template <class... Drums>
+constexpr size_t DrumKit<Drums...>::kStateBytes = sizeof(DrumKit<Drums...>);
+} // namespace daisysp
+#endif
+#endif
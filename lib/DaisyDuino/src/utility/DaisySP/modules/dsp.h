@@ -4,7 +4,9 @@
 #ifndef DSY_CORE_DSP
 #define DSY_CORE_DSP
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <random>
 #include <cmath>
 
@@ -26,6 +28,21 @@ static constexpr float kRandFrac = 1.f / (float)RAND_MAX;
 //Convert from semitones to other units. e.g. 2 ^ (kOneTwelfth * x)
 static constexpr float kOneTwelfth = 1.f / 12.f;
 
+/** Tag for the Init() overloads that skip clearing a module's memory,
+    for memory known to read as zero already, so a large module is not
+    cleared twice. That holds for static objects in internal RAM, whose
+    .bss the startup code zeroes, for daisy::SdramArena::NewCleared()
+    and AllocateCleared(), and after an SdramFill of 0. It does not for
+    DSY_SDRAM_BSS, which nothing clears at boot, nor for memory a
+    previous patch ran on.
+
+    static DelayLine<float, 48000> del; // .bss in AXI SRAM
+    del.Init(ZeroedMemory());
+*/
+struct ZeroedMemory
+{
+};
+
 /** efficient floating point min/max
 c/o stephen mccaul
 */
@@ -118,6 +135,315 @@ inline float fastlog10f(float f)
     return fastlog2f(f) * 0.3010299956639812f;
 }
 
+/** Polynomial sinf for coefficient updates, without libm.
+    Accurate to 4e-7 for x in [-PI_F, PI_F]: folds into [-PI_F/2, PI_F/2]
+    and evaluates a degree 9 odd polynomial there.
+*/
+inline float fastsinf(float x)
+{
+    if(x > HALFPI_F)
+        x = PI_F - x;
+    else if(x < -HALFPI_F)
+        x = -PI_F - x;
+    const float x2 = x * x;
+    return x
+           * (1.0f
+              + x2
+                    * (-0.1666665668f
+                       + x2
+                             * (0.008333025139f
+                                + x2
+                                      * (-0.0001980661520f
+                                         + x2 * 0.000002601886990f))));
+}
+
+/** cosf counterpart of fastsinf(), for x in [-PI_F / 2, 3 * PI_F / 2] */
+inline float fastcosf(float x)
+{
+    return fastsinf(HALFPI_F - x);
+}
+
+/** Fast approximations of the libm functions the modules call, for
+    coefficient updates and per-sample curves, with a block version of
+    each, in place or out of it. No tables and one division at most,
+    so they run as fast from flash as from ITCM.
+
+    Max error against double precision, over every float in the range
+    (every 3rd to 64th float for the widest), on the host:
+
+    function  range            max error                 method
+    sin, cos  |x| <= pi        abs 1.7e-7                reduce by pi, degree 9
+              |x| < 65536      abs 1.7e-7 + 1.6e-11 |x|
+    tan       |x| < 1.5        rel 2.3e-7                reduce by pi/2, sin / cos
+    exp2      any              rel 1.1e-7                2^int * degree 6
+    exp       any              rel 1.4e-7 + 4.4e-8 |x|   exp2(x log2(e))
+    log2      [1/2, 2]         abs 9.2e-8                exponent + degree 9
+              x > 0, normal    1 ulp
+    tanh      any              abs 1.1e-7                series, 1 - 2 / (e^2x + 1)
+    sqrt      x >= 0           exact                     vsqrt.f32
+
+    tan beyond +/-1.5 adds sin's reduction error, relative to how close
+    x is to a pole. exp2 holds at 2^-126 below -126 and just under 2^128
+    above 128. Out of range (a NaN, a negative log2 or sqrt) gives an
+    unspecified result: none of libm's checks and errno. Cycles per call
+    on the Seed, fast against libm, scalar and block, are what
+    src/bench/fast_math_bench.cpp prints.
+
+    The modules do not call these directly but through math:: below,
+    libm unless DAISYSP_FAST_MATH is defined.
+*/
+namespace fast
+{
+namespace detail
+{
+    inline float AsFloat(uint32_t i)
+    {
+        float f;
+        std::memcpy(&f, &i, sizeof(f));
+        return f;
+    }
+
+    inline uint32_t AsBits(float f)
+    {
+        uint32_t i;
+        std::memcpy(&i, &f, sizeof(i));
+        return i;
+    }
+
+    inline int32_t RoundToInt(float x)
+    {
+        return static_cast<int32_t>(x + (x >= 0.0f ? 0.5f : -0.5f));
+    }
+
+    /** sin(r) for |r| <= PI_F / 2, degree 9 odd (as fastsinf()) */
+    inline float SinKernel(float r)
+    {
+        const float y = r * r;
+        return r
+               * (0.9999999957f
+                  + y
+                        * (-0.1666665797f
+                           + y
+                                 * (0.008333050617f
+                                    + y * (-0.0001980904636f
+                                           + y * 2.605166275e-06f))));
+    }
+
+    /** cos(r) for |r| <= PI_F / 4, degree 8 even */
+    inline float CosKernel(float r)
+    {
+        const float y = r * r;
+        return 1.0f
+               + y
+                     * (-0.4999999962f
+                        + y
+                              * (0.04166661672f
+                                 + y * (-0.00138866186f + y * 2.437988015e-05f)));
+    }
+
+    // pi, and pi / 2, split so that k times the high part is exact
+    // for |k| < 2^16 (Cody and Waite).
+    static constexpr float kPiHi  = 3.140625f;
+    static constexpr float kPiLo  = 9.676535897932e-4f;
+    static constexpr float kInvPi = 0.3183098861837907f;
+    static constexpr float kLog2E = 1.4426950408889634f;
+} // namespace detail
+
+/** sin(x), |x| < 65536 */
+inline float sin(float x)
+{
+    // x = k pi + r, |r| <= pi / 2: sin(x) = (-1)^k sin(r)
+    const int32_t k  = detail::RoundToInt(x * detail::kInvPi);
+    const float   kf = static_cast<float>(k);
+    const float   r  = (x - kf * detail::kPiHi) - kf * detail::kPiLo;
+    const float   s  = detail::SinKernel(r);
+    return (k & 1) ? -s : s;
+}
+
+/** cos(x), |x| < 65536 */
+inline float cos(float x)
+{
+    // x = (k + 1/2) pi + r: cos(x) = (-1)^(k + 1) sin(r)
+    const int32_t k  = detail::RoundToInt(x * detail::kInvPi - 0.5f);
+    const float   kf = static_cast<float>(k) + 0.5f;
+    const float   r  = (x - kf * detail::kPiHi) - kf * detail::kPiLo;
+    const float   s  = detail::SinKernel(r);
+    return (k & 1) ? s : -s;
+}
+
+/** tan(x), |x| < 65536 */
+inline float tan(float x)
+{
+    // x = k pi / 2 + r, |r| <= pi / 4: tan(r) for k even, -1 / tan(r) odd
+    const int32_t k  = detail::RoundToInt(x * (2.0f * detail::kInvPi));
+    const float   kf = 0.5f * static_cast<float>(k);
+    const float   r  = (x - kf * detail::kPiHi) - kf * detail::kPiLo;
+    const float   s  = detail::SinKernel(r);
+    const float   c  = detail::CosKernel(r);
+    return (k & 1) ? -c / s : s / c;
+}
+
+/** 2^x; held at 2^-126 below -126 and just short of 2^128 above 128 */
+inline float exp2(float x)
+{
+    x = x < -126.0f ? -126.0f : (x > 127.9999924f ? 127.9999924f : x);
+    int32_t i = static_cast<int32_t>(x);
+    i         = static_cast<float>(i) > x ? i - 1 : i; // floor
+    const float f = x - static_cast<float>(i);
+    float       p = 0.0002187750477f;
+    p             = p * f + 0.001238782148f;
+    p             = p * f + 0.009684580452f;
+    p             = p * f + 0.05548042633f;
+    p             = p * f + 0.240230502f;
+    p             = p * f + 0.6931469287f;
+    p             = p * f + 1.000000003f;
+    return p * detail::AsFloat(static_cast<uint32_t>(i + 127) << 23);
+}
+
+/** e^x */
+inline float exp(float x)
+{
+    return exp2(x * detail::kLog2E);
+}
+
+/** log2(x), x > 0 and not denormal */
+inline float log2(float x)
+{
+    // x = 2^e m, m in [sqrt(1/2), sqrt(2)): log2(x) = e + log2(1 + u)
+    const uint32_t bits = detail::AsBits(x);
+    int32_t        e    = static_cast<int32_t>(bits >> 23) - 127;
+    float          m    = detail::AsFloat((bits & 0x007fffff) | 0x3f800000);
+    if(m > 1.414213562f)
+    {
+        m *= 0.5f;
+        e++;
+    }
+    const float u = m - 1.0f;
+    float       q = 0.1261484659f;
+    q             = q * u - 0.2074210351f;
+    q             = q * u + 0.2156698591f;
+    q             = q * u - 0.2389203398f;
+    q             = q * u + 0.2879183245f;
+    q             = q * u - 0.3607048281f;
+    q             = q * u + 0.4809106099f;
+    q             = q * u - 0.7213473334f;
+    q             = q * u + 1.442695004f;
+    return static_cast<float>(e) + u * q;
+}
+
+/** tanh(x), odd series near 0, 1 - 2 / (e^2x + 1) beyond */
+inline float tanh(float x)
+{
+    const float a = fabsf(x);
+    float       t;
+    if(a < 0.125f)
+    {
+        const float y = a * a;
+        t = a
+            * (1.0f
+               + y * (-0.3333333333f + y * (0.1333333333f + y * -0.05396825397f)));
+    }
+    else if(a < 9.0f)
+        t = 1.0f - 2.0f / (exp2(a * (2.0f * detail::kLog2E)) + 1.0f);
+    else
+        t = 1.0f;
+    return x < 0.0f ? -t : t;
+}
+
+/** sqrt(x), x >= 0: the FPU's, without libm's errno path around it */
+inline float sqrt(float x)
+{
+#ifdef __arm__
+    float r;
+    asm("vsqrt.f32 %[d], %[n]" : [d] "=t"(r) : [n] "t"(x) :);
+    return r;
+#else
+    return __builtin_sqrtf(x);
+#endif // __arm__
+}
+
+// Block versions: out[i] = f(in[i]) for size samples; in == out is fine.
+#define DSY_FAST_BLOCK(name)                                      \
+    inline void name(const float* in, float* out, size_t size)   \
+    {                                                             \
+        for(size_t i = 0; i < size; i++)                          \
+            out[i] = name(in[i]);                                 \
+    }
+DSY_FAST_BLOCK(sin)
+DSY_FAST_BLOCK(cos)
+DSY_FAST_BLOCK(tan)
+DSY_FAST_BLOCK(exp2)
+DSY_FAST_BLOCK(exp)
+DSY_FAST_BLOCK(log2)
+DSY_FAST_BLOCK(tanh)
+DSY_FAST_BLOCK(sqrt)
+#undef DSY_FAST_BLOCK
+} // namespace fast
+
+/** The libm calls of the DaisySP modules, where fast:: is accurate
+    enough for what they compute (filter and envelope coefficients,
+    window curves, saturators): libm by default, fast:: with
+    DAISYSP_FAST_MATH defined (a build flag, or before including
+    daisysp.h). Off by default, as it changes the modules' output in
+    the last few bits; src/bench/fast_math_bench.cpp times both ways.
+
+    Left on libm either way: the narrow-band coefficients (Tone, ATone,
+    Balance, ReverbSc's damping) where 2 - cos(w) loses the low bits at
+    low cutoffs, the tables built once at Init(), and powf().
+*/
+namespace math
+{
+#ifdef DAISYSP_FAST_MATH
+inline float sin(float x)
+{
+    return fast::sin(x);
+}
+inline float cos(float x)
+{
+    return fast::cos(x);
+}
+inline float exp2(float x)
+{
+    return fast::exp2(x);
+}
+inline float exp(float x)
+{
+    return fast::exp(x);
+}
+inline float tanh(float x)
+{
+    return fast::tanh(x);
+}
+#else
+inline float sin(float x)
+{
+    return sinf(x);
+}
+inline float cos(float x)
+{
+    return cosf(x);
+}
+inline float exp2(float x)
+{
+    return exp2f(x);
+}
+inline float exp(float x)
+{
+    return expf(x);
+}
+inline float tanh(float x)
+{
+    return tanhf(x);
+}
+#endif // DAISYSP_FAST_MATH
+
+/** Exact either way: the FPU's square root */
+inline float sqrt(float x)
+{
+    return fast::sqrt(x);
+}
+} // namespace math
+
 /** Midi to frequency helper
 */
 inline float mtof(float m)
@@ -300,6 +626,15 @@ inline float soft_saturate(float in, float thresh)
     //                                    + (((val - thresh) / (1.0f - thresh))
     //                                       * ((val - thresh) / (1.0f - thresh))));
 }
+
+/** Samples in ms milliseconds at sample_rate, rounded down, e.g. to size
+    a buffer at compile time.
+*/
+constexpr size_t ms_to_samples(size_t ms, size_t sample_rate)
+{
+    return ms * sample_rate / 1000;
+}
+
 constexpr bool is_power2(uint32_t x)
 {
     return ((x - 1) & x) == 0;
@@ -1,9 +1,8 @@
 #pragma once
 #ifndef DSY_DUST_H
 #define DSY_DUST_H
-#include <cstdlib>
-#include <random>
 #include "dsp.h"
+#include "fast_random.h"
 #ifdef __cplusplus
 
 /** @file dust.h */
@@ -23,15 +22,25 @@ namespace daisysp
 class Dust
 {
   public:
+    static const size_t kStateBytes;
+
     Dust() {}
     ~Dust() {}
 
-    void Init() { SetDensity(.5f); }
+    void Init()
+    {
+        rng_.Init();
+        SetDensity(.5f);
+    }
+
+    /** Restarts the noise from a given seed, for repeatable output.
+    */
+    inline void SetSeed(uint32_t seed) { rng_.Init(seed); }
 
     float Process()
     {
         float inv_density = 1.0f / density_;
-        float u           = rand() * kRandFrac;
+        float u           = rng_.NextFloat();
         if(u < density_)
         {
             return u * inv_density;
@@ -46,9 +55,11 @@ class Dust
     }
 
   private:
-    float                  density_;
-    static constexpr float kRandFrac = 1.f / RAND_MAX;
+    float      density_;
+    FastRandom rng_;
 };
+
+inline constexpr size_t Dust::kStateBytes = sizeof(Dust);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
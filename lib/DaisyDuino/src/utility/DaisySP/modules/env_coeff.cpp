@@ -0,0 +1,18 @@
+#include <string.h>
+#include "env_coeff.h"
+
+using namespace daisysp;
+
+float DSY_ENV_COEFF_SECTION EnvCoeff::table_[EnvCoeff::kTableSize + 1];
+bool                        EnvCoeff::table_ready_ = false;
+
+// Computed by the compiler, in double, into flash.
+constexpr std::array<float, EnvCoeff::kTableSize + 1> EnvCoeff::kTable
+    = ConstTable::Make<EnvCoeff::kTableSize + 1>(EnvCoeff::Entry);
+
+void EnvCoeff::BuildTable()
+{
+    // Once at Init, never from the ISR: a copy into the table's section.
+    memcpy(table_, kTable.data(), sizeof(table_));
+    table_ready_ = true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef DSY_ENV_COEFF_H
+#define DSY_ENV_COEFF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <array>
+#include "const_table.h"
+#ifdef __cplusplus
+
+/** Memory section for the envelope coefficient table, as for the Nco
+    table: computed at compile time into flash, copied here at the first
+    InitTable(). Define before including daisysp.h to override.
+*/
+#ifndef DSY_ENV_COEFF_SECTION
+#if defined(__arm__)
+#define DSY_ENV_COEFF_SECTION __attribute__((section(".dtcmram_bss")))
+#else
+#define DSY_ENV_COEFF_SECTION
+#endif
+#endif
+
+namespace daisysp
+{
+/** One-pole envelope coefficients, 1 - exp(-u), from a table.
+
+    The envelopes turn a segment time into a per-sample coefficient
+    u = k / (time * sample_rate) and then 1 - exp(-u). This does the
+    second step without libm, so times can follow a knob every block on
+    many voices.
+
+    The table is keyed by the float bits of u: 16 entries per octave
+    from 2^-28 (hours at 48 kHz) to 2^5, where the coefficient is 1 to
+    float precision. It holds (1 - exp(-u)) / u, which is smooth and
+    close to 1, interpolated linearly along the mantissa. Relative error
+    is under 2e-7 below u = 1/64, any segment longer than a few dozen
+    samples, 4e-5 up to u = 1 and 1e-3 at worst, around u = 16.
+*/
+class EnvCoeff
+{
+  public:
+    static const size_t kStateBytes;
+
+    /** Copies the table in if needed. Setup only; the envelopes call it
+        from their Init().
+    */
+    static inline void InitTable()
+    {
+        if(!table_ready_)
+            BuildTable();
+    }
+
+    /** 1 - exp(-u), u >= 0 */
+    static inline float OnePole(float u)
+    {
+        uint32_t bits;
+        memcpy(&bits, &u, sizeof(bits));
+        if(bits < kLowBits)
+            return u; // u or less: 1 - exp(-u) rounds to u
+        if(bits >= kHighBits)
+            return 1.f;
+        const uint32_t rel  = bits - kLowBits;
+        const uint32_t idx  = rel >> kFracBits;
+        const float    frac = static_cast<float>(rel & kFracMask) * kFracScale;
+        const float    a    = table_[idx];
+        return u * (a + (table_[idx + 1] - a) * frac);
+    }
+
+    /** exp(v) for |v| up to about 32, from the same table */
+    static inline float Exp(float v)
+    {
+        return v < 0.f ? 1.f - OnePole(-v) : 1.f / (1.f - OnePole(v));
+    }
+
+    /** Coefficient reaching 1 - exp(-k) of the way in time seconds
+        \param time Segment time, positive
+        \param sample_rate Rate the envelope is processed at
+        \param k Time constants per segment, 1 for a plain one-pole
+    */
+    static inline float FromTime(float time, float sample_rate, float k = 1.f)
+    {
+        return OnePole(k / (time * sample_rate));
+    }
+
+  private:
+    static constexpr int      kMinExp       = -28;
+    static constexpr int      kMaxExp       = 5;
+    static constexpr uint32_t kStepsPerOct  = 16;
+    static constexpr uint32_t kFracBits     = 23 - 4;
+    static constexpr uint32_t kFracMask     = (1u << kFracBits) - 1u;
+    static constexpr float    kFracScale    = 1.f / (1u << kFracBits);
+    static constexpr uint32_t kLowBits      = uint32_t(127 + kMinExp) << 23;
+    static constexpr uint32_t kHighBits     = uint32_t(127 + kMaxExp) << 23;
+    static constexpr size_t   kTableSize
+        = size_t(kMaxExp - kMinExp) * kStepsPerOct;
+
+    /** Entry i: (1 - exp(-u)) / u at u = (1 + (i % 16) / 16) 2^(i / 16 - 28) */
+    static constexpr double Entry(size_t i)
+    {
+        const double u = ConstTable::Ldexp(
+            1.0 + static_cast<double>(i % kStepsPerOct) / kStepsPerOct,
+            kMinExp + static_cast<int>(i / kStepsPerOct));
+        return -ConstTable::Expm1(-u) / u;
+    }
+
+    static void BuildTable();
+
+    static float table_[kTableSize + 1];
+    static const std::array<float, kTableSize + 1> kTable;
+    static bool  table_ready_;
+};
+
+inline constexpr size_t EnvCoeff::kStateBytes = sizeof(EnvCoeff);
+} // namespace daisysp
+#endif
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+#ifndef DSY_FAST_RANDOM_H
+#define DSY_FAST_RANDOM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** Shared random number core for the noise sources.
+
+    Four independent xorshift32 lanes. Next() and the single-value
+    helpers step the first one, three shifts and three xors; FillBlock()
+    steps all four together so the dependency chains overlap, and writes
+    four samples per iteration. Floats come from the top 23 bits placed
+    into a mantissa with the exponent of [1, 2) or [2, 4), then one
+    subtract: no int-to-float conversion and no multiply.
+
+    Unlike rand(), each generator has its own state, so it is reentrant
+    and takes no lock; Init() with no seed hands out a new one per
+    instance, keeping generators started together uncorrelated.
+*/
+class FastRandom
+{
+  public:
+    static const size_t kStateBytes;
+
+    FastRandom() {}
+    ~FastRandom() {}
+
+    /** Seeds the generator.
+        \param seed - any value; 0 takes the next of a shared sequence,
+                      different for every such call (setup only)
+    */
+    void Init(uint32_t seed = 0)
+    {
+        if(seed == 0)
+        {
+            seed = (next_seed_ += 0x9e3779b9u);
+        }
+        for(int i = 0; i < 4; i++)
+        {
+            s_[i] = Mix(seed + static_cast<uint32_t>(i) * 0x6a09e667u);
+        }
+    }
+
+    /** \return 32 random bits */
+    inline uint32_t Next() { return Step(s_[0]); }
+
+    /** \return uniform in [0, 1) */
+    inline float NextFloat() { return Unipolar(Next()); }
+
+    /** \return uniform in [-1, 1) */
+    inline float NextBipolar() { return Bipolar(Next()); }
+
+    /** \return uniform in [0, n), by a multiply and shift, not a divide
+        \param n - number of values, 1 or more
+    */
+    inline uint32_t NextBelow(uint32_t n)
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(Next()) * n) >> 32);
+    }
+
+    /** A different seed from the same one, for a second generator inside
+        a module seeded with seed. 0 stays 0, so the shared sequence stays
+        the shared sequence.
+    */
+    static constexpr uint32_t DeriveSeed(uint32_t seed)
+    {
+        return seed * 0x2545f491u;
+    }
+
+    /** Fills out with uniform noise in [-amp, amp).
+        \param out - destination
+        \param size - number of samples
+        \param amp - scale of the output
+    */
+    void FillBlock(float *out, size_t size, float amp = 1.0f)
+    {
+        uint32_t s0 = s_[0], s1 = s_[1], s2 = s_[2], s3 = s_[3];
+        size_t   i  = 0;
+        for(; i + 4 <= size; i += 4)
+        {
+            out[i]     = Bipolar(Step(s0)) * amp;
+            out[i + 1] = Bipolar(Step(s1)) * amp;
+            out[i + 2] = Bipolar(Step(s2)) * amp;
+            out[i + 3] = Bipolar(Step(s3)) * amp;
+        }
+        for(; i < size; i++)
+        {
+            out[i] = Bipolar(Step(s0)) * amp;
+        }
+        s_[0] = s0;
+        s_[1] = s1;
+        s_[2] = s2;
+        s_[3] = s3;
+    }
+
+    /** Bits to [0, 1) */
+    static inline float Unipolar(uint32_t x)
+    {
+        return BitsToFloat((x >> 9) | 0x3f800000u) - 1.0f;
+    }
+
+    /** Bits to [-1, 1) */
+    static inline float Bipolar(uint32_t x)
+    {
+        return BitsToFloat((x >> 9) | 0x40000000u) - 3.0f;
+    }
+
+  private:
+    static inline uint32_t Step(uint32_t &x)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    }
+
+    static inline float BitsToFloat(uint32_t bits)
+    {
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    /** Scrambles a seed into a non-zero lane state */
+    static inline uint32_t Mix(uint32_t z)
+    {
+        z = (z ^ (z >> 16)) * 0x85ebca6bu;
+        z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+        z ^= z >> 16;
+        return z != 0 ? z : 0x2545f491u;
+    }
+
+    static inline uint32_t next_seed_ = 0;
+
+    uint32_t s_[4];
+};
+
+inline constexpr size_t FastRandom::kStateBytes = sizeof(FastRandom);
+} // namespace daisysp
+#endif
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+#ifndef DSY_FAST_SIN_H
+#define DSY_FAST_SIN_H
+
+#include <stdint.h>
+#include <math.h>
+#include "dsp.h"
+#include "nco.h"
+#ifdef __cplusplus
+
+/** Accuracy tier the DaisySP oscillators use, one of FastSin::Tier.
+    Define before including daisysp.h (or as a build flag) to override.
+*/
+#ifndef DSY_FASTSIN_TIER
+#define DSY_FASTSIN_TIER POLY7
+#endif
+
+namespace daisysp
+{
+/** Shared sine kernel for the oscillators: sin(2 pi phase), phase in
+    cycles.
+
+    Tiers, worst-case absolute error:
+    - LIBM: sinf(phase * TWOPI_F), the reference.
+    - TABLE: Nco's 1024-point table in DTCM, linearly interpolated, 5e-6.
+    - POLY5: odd minimax polynomial on a quarter turn, 7e-5 (-83 dB).
+    - POLY7: 7e-7 (-123 dB). The default.
+    - POLY9: 2e-7, float rounding, as good as LIBM over a cycle.
+    The polynomials fold any phase into [-1/4, 1/4] with one truncation
+    and two compares, no libm and no memory reads.
+
+    Oscillator, HarmonicOscillator, ZOscillator, FormantOscillator,
+    VosimOscillator and GrainletOscillator all go through Sin(), so
+    DSY_FASTSIN_TIER switches them together.
+*/
+class FastSin
+{
+  public:
+    static const size_t kStateBytes;
+
+    enum class Tier
+    {
+        LIBM,
+        TABLE,
+        POLY5,
+        POLY7,
+        POLY9,
+    };
+
+    static constexpr Tier kDefaultTier = Tier::DSY_FASTSIN_TIER;
+
+    /** Builds the TABLE tier's table (shared with Nco) if needed.
+        Setup only; the oscillators call it from their Init().
+    */
+    static inline void Init() { Nco::InitTable(); }
+
+    /** sin(2 pi phase) */
+    template <Tier tier = kDefaultTier>
+    static inline float Sin(float phase)
+    {
+        if constexpr(tier == Tier::LIBM)
+        {
+            return sinf(phase * TWOPI_F);
+        }
+        else if constexpr(tier == Tier::TABLE)
+        {
+            // Into (-1, 1) cycles, then onto the 32-bit phase circle.
+            phase -= static_cast<float>(static_cast<int32_t>(phase));
+            const uint32_t p = static_cast<uint32_t>(
+                static_cast<int32_t>(phase * 2147483648.0f));
+            return Nco::Sin(p << 1);
+        }
+        else
+        {
+            const float x  = Fold(phase);
+            const float x2 = x * x;
+            if constexpr(tier == Tier::POLY5)
+            {
+                return x
+                       * (6.2812800766f
+                          + x2 * (-41.095242689f + x2 * 73.585514754f));
+            }
+            else if constexpr(tier == Tier::POLY7)
+            {
+                return x
+                       * (6.2831640443f
+                          + x2
+                                * (-41.337142371f
+                                   + x2 * (81.340768889f - x2 * 70.993433283f)));
+            }
+            else
+            {
+                return x
+                       * (6.2831844842f
+                          + x2
+                                * (-41.341559047f
+                                   + x2
+                                         * (81.596639976f
+                                            + x2
+                                                  * (-76.470197215f
+                                                     + x2 * 39.030822049f))));
+            }
+        }
+    }
+
+    /** cos(2 pi phase) */
+    template <Tier tier = kDefaultTier>
+    static inline float Cos(float phase)
+    {
+        return Sin<tier>(phase + 0.25f);
+    }
+
+  private:
+    /** phase, in cycles, to the same sine within [-1/4, 1/4] */
+    static inline float Fold(float phase)
+    {
+        phase -= static_cast<float>(static_cast<int32_t>(phase));
+        if(phase > 0.5f)
+            phase -= 1.0f;
+        else if(phase < -0.5f)
+            phase += 1.0f;
+        if(phase > 0.25f)
+            phase = 0.5f - phase;
+        else if(phase < -0.25f)
+            phase = -0.5f - phase;
+        return phase;
+    }
+};
+
+inline constexpr size_t FastSin::kStateBytes = sizeof(FastSin);
+} // namespace daisysp
+#endif
+#endif
@@ -0,0 +1,257 @@
+#pragma once
+#ifndef DSY_FFT_CONVOLVER_H
+#define DSY_FFT_CONVOLVER_H
+
+#include <cstdint>
+#include <cstring> // for memset
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include "dsp.h"
+#include "real_fft.h"
+
+namespace daisysp
+{
+/* use this as the max_partitions parameter to indicate user-provided memory */
+#define FFTCONVOLVER_USER_MEMORY 0
+
+/** Memory for the frequency-domain partitions of FFTConvolver:
+ * the IR spectra, then the spectra of as many past input blocks.
+ * \param block - partition length
+ * \param max_partitions - maximal number of partitions
+ * if max_partitions is 0 (via FFTCONVOLVER_USER_MEMORY macro)
+ * does NOT allocate any memory and instead requires a user-provided
+ * buffer, see SetPartitionBuffer()
+ *
+ * Not intended to be used directly, so constructor is not exposed
+ */
+template <size_t block, size_t max_partitions>
+struct FFTConvolverMemory
+{
+  protected:
+    FFTConvolverMemory() : parts_{0} {}
+
+    static constexpr size_t MaxPartitions() { return max_partitions; }
+
+    float* Parts() { return parts_; }
+
+    float parts_[max_partitions * 4u * block]; /*< IR and input spectra */
+};
+
+/* Specialization for user-provided memory */
+template <size_t block>
+struct FFTConvolverMemory<block, FFTCONVOLVER_USER_MEMORY>
+{
+  public:
+    /** Set user-provided partition buffer
+     * \param buffer - pointer to the allocated memory block
+     * \param length - length of the provided memory block (in elements)
+     * The length should be at least 4 * block * partitions.
+     * Call before SetIR().
+     */
+    void SetPartitionBuffer(float buffer[], size_t length)
+    {
+        parts_  = buffer;
+        length_ = length;
+    }
+
+  protected:
+    FFTConvolverMemory() : parts_(nullptr), length_(0) {}
+
+    size_t MaxPartitions() const { return length_ / (4u * block); }
+
+    float* Parts() { return parts_; }
+
+    float* parts_;  /*< IR and input spectra */
+    size_t length_; /*< length of the partition buffer */
+};
+
+
+/** Uniformly partitioned overlap-save convolution for long FIRs
+ *
+ * The IR is cut into partitions of block taps, each held as the spectrum
+ * of a 2 * block point real FFT. Every block of input costs one forward
+ * and one inverse FFT plus one complex multiply-accumulate per partition,
+ * so a 2048 tap IR at block = 64 is ~32 x 64 complex MACs per block
+ * instead of 2048 MACs per sample. There is no added latency: output
+ * blocks come out with their input.
+ *
+ * On ARM with USE_ARM_DSP defined the FFTs are arm_rfft_fast_f32, so
+ * block must be a power of two from 16 to 2048.
+ *
+ * \param block - partition length; ProcessBlock() takes multiples of it
+ * \param max_partitions - maximal IR length, in blocks. If 0 (via the
+ * FFTCONVOLVER_USER_MEMORY macro), set the buffer with
+ * SetPartitionBuffer() before SetIR()
+ *
+ * The IR is only read by SetIR(), so a long one can stay in SDRAM while
+ * the partitions, read every block, sit in the internal AXI SRAM that
+ * plain globals go to:
+ *
+ *     float DSY_SDRAM_BSS eq_ir[4096];
+ *     FFTConvolver<64, 64> eq;
+ *     eq.SetIR(eq_ir, 4096);
+ */
+template <size_t block, size_t max_partitions>
+class FFTConvolver : public FFTConvolverMemory<block, max_partitions>
+{
+  private:
+    using FFTMem = FFTConvolverMemory<block, max_partitions>; // shorthand
+    static_assert(block >= 16u && block <= 2048u && (block & (block - 1u)) == 0,
+                  "block must be a power of two from 16 to 2048");
+
+    static constexpr size_t kFftSize = 2u * block;
+
+  public:
+    static const size_t kStateBytes;
+
+    /* Default constructor */
+    FFTConvolver() : partitions_(0), pos_(0) {}
+
+    /* Partitioned convolution adds no latency to FIR */
+    static constexpr size_t GetLatency() { return 0; }
+
+    static constexpr size_t GetBlockSize() { return block; }
+
+    /* Reset the filter state (but not the IR) */
+    void Reset()
+    {
+        memset(in_, 0, sizeof(in_));
+        if(partitions_ > 0)
+        {
+            memset(History(),
+                   0,
+                   partitions_ * kFftSize * sizeof(FFTMem::Parts()[0]));
+        }
+        pos_ = 0;
+    }
+
+    /** Process a block of data
+     * \param size - a multiple of block; in place is allowed
+     */
+    void ProcessBlock(const float* pSrc, float* pDst, size_t size)
+    {
+        assert(size % block == 0u);
+        assert(partitions_ > 0u);
+        assert(nullptr != pSrc);
+        assert(nullptr != pDst);
+
+        for(size_t start = 0; start < size; start += block)
+        {
+            ProcessPartition(pSrc + start, pDst + start);
+        }
+    }
+
+    /** Set filter coefficients (aka Impulse Response), in natural order,
+     * and transform them into the partitions.
+     * IRs longer than the partitions available are truncated silently,
+     * as with FIR.
+     * \return false if no partition memory is available
+     */
+    bool SetIR(const float* ir, size_t len)
+    {
+        assert(nullptr != ir || 0 == len);
+        const size_t parts = BeginIR(len);
+        for(size_t p = 0; p < parts; p++)
+        {
+            LoadPartition(ir, len, p);
+        }
+        Reset();
+        return parts > 0;
+    }
+
+    /** First step of SetIR() in pieces, for an IR too long to transform
+     * at once: sizes the filter for len taps, truncated to the memory.
+     * Then LoadPartition() for each partition and Reset(); the filter
+     * must not be run until all are loaded.
+     * \return number of partitions to load
+     */
+    size_t BeginIR(size_t len)
+    {
+        const size_t max_len = FFTMem::MaxPartitions() * block;
+        partitions_          = (DSY_MIN(len, max_len) + block - 1u) / block;
+        fft_.Init();
+        return partitions_;
+    }
+
+    /** Transforms partition p of ir, len taps as given to BeginIR() */
+    void LoadPartition(const float* ir, size_t len, size_t p)
+    {
+        assert(p < partitions_);
+        const size_t first = p * block;
+        const size_t taps  = first < len ? DSY_MIN(block, len - first) : 0;
+        memset(work_, 0, sizeof(work_));
+        memcpy(work_, ir + first, taps * sizeof(ir[0]));
+        fft_.Forward(work_, Spectra() + p * kFftSize);
+    }
+
+    /** \return partitions the memory holds, the longest IR in blocks */
+    size_t GetMaxPartitions() const { return FFTMem::MaxPartitions(); }
+
+    /** \return partitions of the IR set */
+    size_t GetPartitions() const { return partitions_; }
+
+    /* Create an alias to comply with DaisySP API conventions */
+    template <typename... Args>
+    inline auto Init(Args&&... args)
+        -> decltype(SetIR(std::forward<Args>(args)...))
+    {
+        return SetIR(std::forward<Args>(args)...);
+    }
+
+  private:
+    float* Spectra() { return FFTMem::Parts(); }
+
+    float* History() { return FFTMem::Parts() + partitions_ * kFftSize; }
+
+    void ProcessPartition(const float* in, float* out)
+    {
+        /* Overlap-save window: the previous block, then this one */
+        memcpy(in_, in_ + block, block * sizeof(in_[0]));
+        memcpy(in_ + block, in, block * sizeof(in_[0]));
+        memcpy(work_, in_, sizeof(work_));
+
+        /* Newest input spectrum into the delay line, then
+         * out = sum_p X[now - p] H[p] */
+        fft_.Forward(work_, History() + pos_ * kFftSize);
+        memset(acc_, 0, sizeof(acc_));
+        size_t slot = pos_;
+        for(size_t p = 0; p < partitions_; p++)
+        {
+            MulAcc(History() + slot * kFftSize, Spectra() + p * kFftSize);
+            slot = slot > 0 ? slot - 1u : partitions_ - 1u;
+        }
+        pos_ = pos_ + 1u < partitions_ ? pos_ + 1u : 0;
+
+        /* Only the second half is free of circular wrap */
+        fft_.Inverse(acc_, work_);
+        memcpy(out, work_ + block, block * sizeof(out[0]));
+    }
+
+    /* acc_ += x * h, packed spectra: DC and Nyquist come first, real */
+    void MulAcc(const float* x, const float* h)
+    {
+        acc_[0] += x[0] * h[0];
+        acc_[1] += x[1] * h[1];
+        for(size_t i = 2; i < kFftSize; i += 2)
+        {
+            acc_[i] += x[i] * h[i] - x[i + 1] * h[i + 1];
+            acc_[i + 1] += x[i] * h[i + 1] + x[i + 1] * h[i];
+        }
+    }
+
+    RealFft<kFftSize> fft_;
+    float             in_[kFftSize];   /*< overlap-save input window */
+    float             work_[kFftSize]; /*< FFT scratch */
+    float             acc_[kFftSize];  /*< spectrum accumulator */
+    size_t            partitions_;     /*< active partitions */
+    size_t            pos_;            /*< newest slot in the history */
+};
+
+template <size_t block, size_t max_partitions>
+constexpr size_t FFTConvolver<block, max_partitions>::kStateBytes
+    = sizeof(FFTConvolver<block, max_partitions>);
+
+} // namespace daisysp
+
+#endif // DSY_FFT_CONVOLVER_H
@@ -0,0 +1,340 @@
+#pragma once
+#ifndef DSY_FILTER_BANK_H
+#define DSY_FILTER_BANK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "dsp.h"
+
+namespace daisysp
+{
+/** N Svf bands on one input, each with a gain and an envelope follower.
+
+    The same double-sampled state variable filter as Svf, with the same
+    SetFreq(), SetRes() and SetDrive() meaning, so a bank of Svf objects
+    ports over and sounds the same. One Output is picked for the whole
+    bank. ProcessBlock() sums gain * output over the bands.
+
+    The coefficients and states are arrays per field and ProcessBlock()
+    runs four bands at a time over the whole block. Those bands' states
+    and coefficients stay in registers from the first sample to the
+    last, and the four share each input read and each add into out. A
+    bank of separate Svf objects instead pays a call, and a load and
+    store of every member, per band per sample.
+
+    Each band also follows its output's envelope: rectified, with a
+    one-pole attack and release (SetEnvelope()). That is the analysis
+    half of a channel vocoder. The synthesis half is a second bank over
+    the carrier whose band gains are the analysis envelopes, ramped
+    across each block.
+
+    declaration example:
+
+    FilterBank<16> voice, carrier;
+    voice.Init(sample_rate);
+    carrier.Init(sample_rate);
+    voice.SetLogSpaced(100.f, 8000.f);
+    carrier.SetLogSpaced(100.f, 8000.f);
+    ...
+    // audio callback
+    voice.Analyze(in[0], size);
+    carrier.ProcessBlock(saw, out[0], size, voice.GetEnvelopes());
+
+    \param num_bands Number of bands
+*/
+template <size_t num_bands>
+class FilterBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(num_bands > 0, "a FilterBank needs a band");
+
+    /** The Svf output every band runs */
+    enum class Output
+    {
+        LOW,
+        HIGH,
+        BAND,
+        NOTCH,
+        PEAK,
+    };
+
+    FilterBank() {}
+    ~FilterBank() {}
+
+    /** Every band at 200 Hz, res 0.5 and gain 1, drive 0.5, as Svf;
+        the BAND output, and 5 ms attack and 50 ms release.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        drive_       = 0.5f;
+        output_      = Output::BAND;
+        for(size_t k = 0; k < num_bands; k++)
+        {
+            gain_[k] = 1.f;
+            res_[k]  = 0.5f;
+            SetFreq(k, 200.f);
+        }
+        SetEnvelope(0.005f, 0.05f);
+        Reset();
+    }
+
+    /** Clears the filters and the envelopes, keeping the settings. */
+    void Reset()
+    {
+        for(size_t k = 0; k < num_bands; k++)
+        {
+            low_[k] = band_[k] = env_[k] = 0.f;
+        }
+    }
+
+    /** Cutoff or center of one band, as Svf::SetFreq().
+        \param band Band index
+        \param freq Frequency in Hz, up to a quarter of the sample rate
+    */
+    void SetFreq(size_t band, float freq)
+    {
+        const float fc = freq < 0.000001f ? 0.000001f : freq;
+        const float w  = PI_F * fminf(0.25f, fc / (sample_rate_ * 2.f));
+        freq_[band]    = 2.f * sinf(w);
+        UpdateDamp(band);
+    }
+
+    /** Resonance of one band, as Svf::SetRes().
+        \param band Band index
+        \param res 0 to 1
+    */
+    void SetRes(size_t band, float res)
+    {
+        res_[band] = fclamp(res, 0.f, 1.f);
+        UpdateDamp(band);
+    }
+
+    /** Spaces the bands evenly in pitch, from lo to hi.
+        \param lo Frequency of band 0 in Hz
+        \param hi Frequency of the last band in Hz
+    */
+    void SetLogSpaced(float lo, float hi)
+    {
+        const float ratio
+            = num_bands > 1 ? powf(hi / lo, 1.f / (float)(num_bands - 1))
+                            : 1.f;
+        float f = lo;
+        for(size_t k = 0; k < num_bands; k++, f *= ratio)
+        {
+            SetFreq(k, f);
+        }
+    }
+
+    /** Internal distortion of every band, as Svf::SetDrive() */
+    inline void SetDrive(float drive) { drive_ = drive; }
+
+    /** Weight of one band in ProcessBlock()'s sum */
+    inline void SetGain(size_t band, float gain) { gain_[band] = gain; }
+
+    inline float GetGain(size_t band) const { return gain_[band]; }
+
+    inline void SetOutput(Output output) { output_ = output; }
+
+    /** Envelope follower time constants, shared by the bands.
+        \param attack Rise time constant in seconds, > 0
+        \param release Fall time constant in seconds, > 0
+    */
+    void SetEnvelope(float attack, float release)
+    {
+        attack_  = 1.f - expf(-1.f / (attack * sample_rate_));
+        release_ = 1.f - expf(-1.f / (release * sample_rate_));
+    }
+
+    /** Filters a block through every band and sums them, each times its
+        gain, updating the envelopes. out must not be in.
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        Clear(out, size);
+        Dispatch<Mix::GAIN>(in, out, size, nullptr);
+    }
+
+    /** As above, gains ramped from the previous ones to gains[] over the
+        block, and left there: the vocoder synthesis. No envelopes.
+        \param gains num_bands gains, GetEnvelopes() of an analysis bank
+    */
+    void
+    ProcessBlock(const float* in, float* out, size_t size, const float* gains)
+    {
+        Clear(out, size);
+        Dispatch<Mix::RAMP>(in, out, size, gains);
+    }
+
+    /** Filters a block for the envelopes only, nothing written. */
+    void Analyze(const float* in, size_t size)
+    {
+        Dispatch<Mix::NONE>(in, nullptr, size, nullptr);
+    }
+
+    /** Envelope of one band at the end of the last block */
+    inline float GetEnvelope(size_t band) const { return env_[band]; }
+
+    /** All num_bands envelopes */
+    inline const float* GetEnvelopes() const { return env_; }
+
+  private:
+    // What a pass does with each band: the envelope only, the envelope
+    // and the gain sum, or the sum with ramped gains.
+    enum class Mix
+    {
+        NONE,
+        GAIN,
+        RAMP,
+    };
+
+    static constexpr size_t kWidth = 4;
+
+    void UpdateDamp(size_t band)
+    {
+        const float f = freq_[band];
+        damp_[band]   = fminf(2.f * (1.f - sqrtf(sqrtf(res_[band]))),
+                            fminf(2.f, 2.f / f - f * 0.5f));
+    }
+
+    static void Clear(float* out, size_t size)
+    {
+        for(size_t i = 0; i < size; i++)
+            out[i] = 0.f;
+    }
+
+    template <Mix mix>
+    void Dispatch(const float* in, float* out, size_t size, const float* gains)
+    {
+        if(size == 0)
+            return;
+        switch(output_)
+        {
+            case Output::LOW:
+                Run<Output::LOW, mix>(in, out, size, gains);
+                break;
+            case Output::HIGH:
+                Run<Output::HIGH, mix>(in, out, size, gains);
+                break;
+            case Output::BAND:
+                Run<Output::BAND, mix>(in, out, size, gains);
+                break;
+            case Output::NOTCH:
+                Run<Output::NOTCH, mix>(in, out, size, gains);
+                break;
+            case Output::PEAK:
+                Run<Output::PEAK, mix>(in, out, size, gains);
+                break;
+        }
+    }
+
+    template <Output output, Mix mix>
+    void Run(const float* in, float* out, size_t size, const float* gains)
+    {
+        size_t k = 0;
+        for(; k + kWidth <= num_bands; k += kWidth)
+        {
+            Group<output, mix, kWidth>(k, in, out, size, gains);
+        }
+        constexpr size_t tail = num_bands % kWidth;
+        if(tail != 0)
+        {
+            Group<output, mix, tail != 0 ? tail : 1>(k, in, out, size, gains);
+        }
+    }
+
+    // Svf::Process() twice per sample, on width bands from first held in
+    // locals for the whole block.
+    template <Output output, Mix mix, size_t width>
+    void Group(size_t       first,
+               const float* in,
+               float*       out,
+               size_t       size,
+               const float* gains)
+    {
+        float low[width], band[width], freq[width], damp[width];
+        float env[width], gain[width], step[width];
+        const float drive = drive_, attack = attack_, release = release_;
+        for(size_t k = 0; k < width; k++)
+        {
+            low[k]  = low_[first + k];
+            band[k] = band_[first + k];
+            freq[k] = freq_[first + k];
+            damp[k] = damp_[first + k];
+            env[k]  = env_[first + k];
+            gain[k] = gain_[first + k];
+            step[k] = mix == Mix::RAMP
+                          ? (gains[first + k] - gain[k]) / (float)size
+                          : 0.f;
+        }
+        for(size_t i = 0; i < size; i++)
+        {
+            const float x   = in[i];
+            float       sum = 0.f;
+            for(size_t k = 0; k < width; k++)
+            {
+                float y = 0.f;
+                for(size_t pass = 0; pass < 2; pass++)
+                {
+                    const float b     = band[k];
+                    const float notch = x - damp[k] * b;
+                    low[k]            = low[k] + freq[k] * b;
+                    const float high  = notch - low[k];
+                    band[k]           = freq[k] * high + b - drive * b * b * b;
+                    switch(output)
+                    {
+                        case Output::LOW: y += low[k]; break;
+                        case Output::HIGH: y += high; break;
+                        case Output::BAND: y += band[k]; break;
+                        case Output::NOTCH: y += notch; break;
+                        case Output::PEAK: y += low[k] - high; break;
+                    }
+                }
+                y *= 0.5f;
+                if(mix != Mix::RAMP)
+                {
+                    const float r = fabsf(y);
+                    env[k] += (r - env[k]) * (r > env[k] ? attack : release);
+                }
+                if(mix != Mix::NONE)
+                {
+                    sum += gain[k] * y;
+                }
+                if(mix == Mix::RAMP)
+                {
+                    gain[k] += step[k];
+                }
+            }
+            if(mix != Mix::NONE)
+            {
+                out[i] += sum;
+            }
+        }
+        for(size_t k = 0; k < width; k++)
+        {
+            low_[first + k]  = low[k];
+            band_[first + k] = band[k];
+            env_[first + k]  = env[k];
+            // The ramp lands exactly, whatever the rounding on the way.
+            gain_[first + k] = mix == Mix::RAMP ? gains[first + k] : gain[k];
+        }
+    }
+
+    // Coefficients, then state, one array per field.
+    float  freq_[num_bands], damp_[num_bands], res_[num_bands];
+    float  gain_[num_bands];
+    float  low_[num_bands], band_[num_bands], env_[num_bands];
+    float  sample_rate_, drive_, attack_, release_;
+    Output output_;
+};
+
+template <size_t num_bands>
+constexpr size_t FilterBank<num_bands>::kStateBytes
+    = sizeof(FilterBank<num_bands>);
+
+} // namespace daisysp
+#endif
@@ -162,6 +162,8 @@ class FIRFilterImplGeneric : public FIRMemory<max_size, max_block>
     using FIRMem = FIRMemory<max_size, max_block>; // just a shorthand
 
   public:
+    static const size_t kStateBytes;
+
     /* Default constructor */
     FIRFilterImplGeneric() {}
 
@@ -254,6 +256,211 @@ class FIRFilterImplGeneric : public FIRMemory<max_size, max_block>
     using FIRMem::state_; /*< FIR state buffer or pointer */
 };
 
+template <size_t max_size, size_t max_block>
+constexpr size_t FIRFilterImplGeneric<max_size, max_block>::kStateBytes
+    = sizeof(FIRFilterImplGeneric<max_size, max_block>);
+
+
+/** Generic polyphase decimator, always available: filters and keeps every
+ * factor-th output, computing only those.
+ * y[n] = sum_k h[k] * x[n * factor - k], as arm_fir_decimate_f32
+ * \param max_size - maximal filter length
+ * \param max_block - maximal input block size for ProcessBlock()
+ * \param factor - decimation factor
+ * Memory model as for FIRFilterImplGeneric, FIRFILTER_USER_MEMORY included
+ */
+template <size_t max_size, size_t max_block, size_t factor>
+class FIRDecimatorImplGeneric : public FIRMemory<max_size, max_block>
+{
+  private:
+    using FIRMem = FIRMemory<max_size, max_block>; // just a shorthand
+    static_assert(factor > 0u, "decimation factor must be at least 1");
+
+  public:
+    static const size_t kStateBytes;
+
+    /* Default constructor */
+    FIRDecimatorImplGeneric() {}
+
+    /* Reset filter state (but not the coefficients) */
+    using FIRMem::Reset;
+
+    static constexpr size_t GetLatency() { return 0; }
+
+    static constexpr size_t GetFactor() { return factor; }
+
+    /** Process a block of data
+     * \param block - input length, a multiple of factor;
+     *                block / factor outputs are written to pDst
+     */
+    void ProcessBlock(const float* pSrc, float* pDst, size_t block)
+    {
+        assert(block <= FIRMem::MaxBlock());
+        assert(block % factor == 0u);
+        assert(size_ > 0u);
+        assert(nullptr != pSrc);
+        assert(nullptr != pDst);
+
+        /* Feed the whole block, then run the kept outputs only */
+        for(size_t j = 0; j < block; j++)
+        {
+            state_[size_ - 1u + j] = pSrc[j];
+        }
+        for(size_t j = 0, m = 0; j < block; j += factor, m++)
+        {
+            float acc = 0.0f;
+            for(size_t i = 0; i < size_; i++)
+            {
+                acc += state_[j + i] * coefs_[i];
+            }
+            pDst[m] = acc;
+        }
+
+        /* Copy data tail for the next block */
+        for(size_t i = 0; i < size_ - 1u; i++)
+        {
+            state_[i] = state_[block + i];
+        }
+    }
+
+    /** Set filter coefficients (aka Impulse Response)
+     * Coefficients need to be in reversed order (tail-first)
+     * If internal storage is used, makes a local copy
+     * and allows reversing the impulse response
+     */
+    bool SetIR(const float* ir, size_t len, bool reverse)
+    {
+        /* Function order is important */
+        const bool result = FIRMem::SetCoefs(ir, len, reverse);
+        Reset();
+        return result;
+    }
+
+    /* Create an alias to comply with DaisySP API conventions */
+    template <typename... Args>
+    inline auto Init(Args&&... args)
+        -> decltype(SetIR(std::forward<Args>(args)...))
+    {
+        return SetIR(std::forward<Args>(args)...);
+    }
+
+  protected:
+    using FIRMem::coefs_; /*< FIR coefficients buffer or pointer */
+    using FIRMem::size_;  /*< FIR length */
+    using FIRMem::state_; /*< FIR state buffer or pointer */
+};
+
+template <size_t max_size, size_t max_block, size_t factor>
+constexpr size_t FIRDecimatorImplGeneric<max_size, max_block, factor>::kStateBytes
+    = sizeof(FIRDecimatorImplGeneric<max_size, max_block, factor>);
+
+
+/** Generic polyphase interpolator, always available: factor outputs per
+ * input, each from one size / factor tap branch, so the zeros of the
+ * stuffed input are never multiplied.
+ * y[n * factor + p] = sum_k h[p + k * factor] * x[n - k],
+ * as arm_fir_interpolate_f32. The taps carry the gain: factor times
+ * unity for a flat passband.
+ * \param max_size - maximal filter length, a multiple of factor
+ * \param max_block - maximal input block size for ProcessBlock()
+ * \param factor - interpolation factor
+ * Memory model as for FIRFilterImplGeneric, FIRFILTER_USER_MEMORY included
+ */
+template <size_t max_size, size_t max_block, size_t factor>
+class FIRInterpolatorImplGeneric : public FIRMemory<max_size, max_block>
+{
+  private:
+    using FIRMem = FIRMemory<max_size, max_block>; // just a shorthand
+    static_assert(factor > 0u, "interpolation factor must be at least 1");
+
+  public:
+    static const size_t kStateBytes;
+
+    /* Default constructor */
+    FIRInterpolatorImplGeneric() {}
+
+    /* Reset filter state (but not the coefficients) */
+    using FIRMem::Reset;
+
+    static constexpr size_t GetLatency() { return 0; }
+
+    static constexpr size_t GetFactor() { return factor; }
+
+    /** Process a block of data
+     * \param block - input length; block * factor outputs
+     *                are written to pDst
+     */
+    void ProcessBlock(const float* pSrc, float* pDst, size_t block)
+    {
+        assert(block <= FIRMem::MaxBlock());
+        assert(size_ > 0u);
+        assert(nullptr != pSrc);
+        assert(nullptr != pDst);
+
+        const size_t phase_len = size_ / factor;
+
+        for(size_t j = 0; j < block; j++)
+        {
+            /* Feed data into the buffer */
+            state_[phase_len - 1u + j] = pSrc[j];
+
+            /* One branch per output phase. Tail-first taps:
+             * h[p + k * factor] is coefs_[size_ - 1 - p - k * factor] */
+            const float* x = &state_[j];
+            for(size_t p = 0; p < factor; p++)
+            {
+                const float* c   = &coefs_[factor - 1u - p];
+                float        acc = 0.0f;
+                for(size_t k = 0; k < phase_len; k++)
+                {
+                    acc += x[k] * c[k * factor];
+                }
+                pDst[j * factor + p] = acc;
+            }
+        }
+
+        /* Copy data tail for the next block */
+        for(size_t i = 0; i + 1u < phase_len; i++)
+        {
+            state_[i] = state_[block + i];
+        }
+    }
+
+    /** Set filter coefficients (aka Impulse Response)
+     * Coefficients need to be in reversed order (tail-first)
+     * If internal storage is used, makes a local copy
+     * and allows reversing the impulse response
+     * \return false unless len is a multiple of factor
+     */
+    bool SetIR(const float* ir, size_t len, bool reverse)
+    {
+        if(len % factor != 0u)
+        {
+            return false;
+        }
+        /* Function order is important */
+        const bool result = FIRMem::SetCoefs(ir, len, reverse);
+        Reset();
+        return result;
+    }
+
+    /* Create an alias to comply with DaisySP API conventions */
+    template <typename... Args>
+    inline auto Init(Args&&... args)
+        -> decltype(SetIR(std::forward<Args>(args)...))
+    {
+        return SetIR(std::forward<Args>(args)...);
+    }
+
+  protected:
+    using FIRMem::coefs_; /*< FIR coefficients buffer or pointer */
+    using FIRMem::size_;  /*< FIR length */
+    using FIRMem::state_; /*< FIR state buffer or pointer */
+};
+
+template <size_t max_size, size_t max_block, size_t factor>
+constexpr size_t FIRInterpolatorImplGeneric<max_size, max_block, factor>::kStateBytes
+    = sizeof(FIRInterpolatorImplGeneric<max_size, max_block, factor>);
 
 #if(defined(USE_ARM_DSP) && defined(__arm__))
 
@@ -271,6 +478,8 @@ class FIRFilterImplARM : public FIRMemory<max_size, max_block>
     using FIRMem = FIRMemory<max_size, max_block>; // just a shorthand
 
   public:
+    static const size_t kStateBytes;
+
     /* Default constructor */
     FIRFilterImplARM() : fir_{0} {}
 
@@ -323,11 +532,157 @@ class FIRFilterImplARM : public FIRMemory<max_size, max_block>
     using FIRMem::state_;      /*< FIR state buffer or pointer */
 };
 
+template <size_t max_size, size_t max_block>
+constexpr size_t FIRFilterImplARM<max_size, max_block>::kStateBytes
+    = sizeof(FIRFilterImplARM<max_size, max_block>);
+
+
+/** ARM-specific decimator, see FIRDecimatorImplGeneric */
+template <size_t max_size, size_t max_block, size_t factor>
+class FIRDecimatorImplARM : public FIRMemory<max_size, max_block>
+{
+  private:
+    using FIRMem = FIRMemory<max_size, max_block>; // just a shorthand
+    static_assert(factor > 0u, "decimation factor must be at least 1");
+    static_assert(max_block % factor == 0u,
+                  "max_block must be a multiple of the decimation factor");
+
+  public:
+    static const size_t kStateBytes;
+
+    /* Default constructor */
+    FIRDecimatorImplARM() : fir_{0} {}
+
+    /* Reset filter state (but not the coefficients) */
+    using FIRMem::Reset;
+
+    static constexpr size_t GetLatency() { return 0; }
+
+    static constexpr size_t GetFactor() { return factor; }
+
+    /* Process a block of data, block a multiple of factor */
+    void ProcessBlock(const float* pSrc, float* pDst, size_t block)
+    {
+        assert(block <= FIRMem::MaxBlock());
+        assert(block % factor == 0u);
+        arm_fir_decimate_f32(&fir_, const_cast<float*>(pSrc), pDst, block);
+    }
+
+    /** Set filter coefficients (aka Impulse Response)
+     * Coefficients need to be in reversed order (tail-first)
+     * If internal storage is used, makes a local copy
+     * and allows reversing the impulse response
+     */
+    bool SetIR(const float* ir, size_t len, bool reverse)
+    {
+        /* Function order is important */
+        const bool result = FIRMem::SetCoefs(ir, len, reverse);
+        Reset();
+        return result
+               && ARM_MATH_SUCCESS
+                      == arm_fir_decimate_init_f32(
+                          &fir_, size_, factor, (float*)coefs_, state_, max_block);
+    }
+
+    /* Create an alias to comply with DaisySP API conventions */
+    template <typename... Args>
+    inline auto Init(Args&&... args)
+        -> decltype(SetIR(std::forward<Args>(args)...))
+    {
+        return SetIR(std::forward<Args>(args)...);
+    }
+
+  protected:
+    arm_fir_decimate_instance_f32 fir_; /*< CMSIS decimator instance */
+    using FIRMem::coefs_;               /*< FIR coefficients buffer or pointer */
+    using FIRMem::size_;                /*< FIR length*/
+    using FIRMem::state_;               /*< FIR state buffer or pointer */
+};
+
+template <size_t max_size, size_t max_block, size_t factor>
+constexpr size_t FIRDecimatorImplARM<max_size, max_block, factor>::kStateBytes
+    = sizeof(FIRDecimatorImplARM<max_size, max_block, factor>);
+
+
+/** ARM-specific interpolator, see FIRInterpolatorImplGeneric */
+template <size_t max_size, size_t max_block, size_t factor>
+class FIRInterpolatorImplARM : public FIRMemory<max_size, max_block>
+{
+  private:
+    using FIRMem = FIRMemory<max_size, max_block>; // just a shorthand
+    static_assert(factor > 0u && factor < 256u,
+                  "CMSIS takes interpolation factors of 1 to 255");
+
+  public:
+    static const size_t kStateBytes;
+
+    /* Default constructor */
+    FIRInterpolatorImplARM() : fir_{0} {}
+
+    /* Reset filter state (but not the coefficients) */
+    using FIRMem::Reset;
+
+    static constexpr size_t GetLatency() { return 0; }
+
+    static constexpr size_t GetFactor() { return factor; }
+
+    /* Process a block of data, block * factor outputs */
+    void ProcessBlock(const float* pSrc, float* pDst, size_t block)
+    {
+        assert(block <= FIRMem::MaxBlock());
+        arm_fir_interpolate_f32(&fir_, const_cast<float*>(pSrc), pDst, block);
+    }
+
+    /** Set filter coefficients (aka Impulse Response)
+     * Coefficients need to be in reversed order (tail-first)
+     * If internal storage is used, makes a local copy
+     * and allows reversing the impulse response
+     * \return false unless len is a multiple of factor
+     */
+    bool SetIR(const float* ir, size_t len, bool reverse)
+    {
+        if(len % factor != 0u)
+        {
+            return false;
+        }
+        /* Function order is important */
+        const bool result = FIRMem::SetCoefs(ir, len, reverse);
+        Reset();
+        return result
+               && ARM_MATH_SUCCESS
+                      == arm_fir_interpolate_init_f32(
+                          &fir_, factor, size_, (float*)coefs_, state_, max_block);
+    }
+
+    /* Create an alias to comply with DaisySP API conventions */
+    template <typename... Args>
+    inline auto Init(Args&&... args)
+        -> decltype(SetIR(std::forward<Args>(args)...))
+    {
+        return SetIR(std::forward<Args>(args)...);
+    }
+
+  protected:
+    arm_fir_interpolate_instance_f32 fir_; /*< CMSIS interpolator instance */
+    using FIRMem::coefs_;                  /*< FIR coefficients buffer or pointer */
+    using FIRMem::size_;                   /*< FIR length*/
+    using FIRMem::state_;                  /*< FIR state buffer or pointer */
+};
+
+template <size_t max_size, size_t max_block, size_t factor>
+constexpr size_t FIRInterpolatorImplARM<max_size, max_block, factor>::kStateBytes
+    = sizeof(FIRInterpolatorImplARM<max_size, max_block, factor>);
 
 /* default to ARM implementation */
 template <size_t max_size, size_t max_block>
 using FIR = FIRFilterImplARM<max_size, max_block>;
 
+template <size_t max_size, size_t max_block, size_t factor>
+using FIRDecimator = FIRDecimatorImplARM<max_size, max_block, factor>;
+
+template <size_t max_size, size_t max_block, size_t factor>
+using FIRInterpolator = FIRInterpolatorImplARM<max_size, max_block, factor>;
+
 
 #else // USE_ARM_DSP
 
@@ -335,6 +690,12 @@ using FIR = FIRFilterImplARM<max_size, max_block>;
 template <size_t max_size, size_t max_block>
 using FIR = FIRFilterImplGeneric<max_size, max_block>;
 
+template <size_t max_size, size_t max_block, size_t factor>
+using FIRDecimator = FIRDecimatorImplGeneric<max_size, max_block, factor>;
+
+template <size_t max_size, size_t max_block, size_t factor>
+using FIRInterpolator = FIRInterpolatorImplGeneric<max_size, max_block, factor>;
+
 #endif // USE_ARM_DSP
 
 
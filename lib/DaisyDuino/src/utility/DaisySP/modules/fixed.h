@@ -0,0 +1,725 @@
+#pragma once
+#ifndef DSY_FIXED_H
+#define DSY_FIXED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <array>
+#include "biquad_cascade.h"
+#include "const_table.h"
+#include "dsp.h"
+#include "nco.h"
+
+namespace daisysp
+{
+/** Fixed-point versions of the most used modules: Biquad, Svf, OnePole,
+    Nco and DelayLine.
+
+    Each is a template on its sample format, fixed::Q15 (int16_t) or
+    fixed::Q31 (int32_t), and has the same block API:
+    ProcessBlock(in, out, size) for the filters and the delay line,
+    ProcessBlock(sin_out, cos_out, size) for the Nco. Buffers may alias
+    (in == out).
+
+    The format is what the module takes, returns and stores. The
+    arithmetic is Q31 for both, with 64-bit accumulators:
+    - Q15 samples are widened on the way in (<< 16).
+    - Results are rounded and saturated on the way out.
+    So a Q15 filter is as quiet as a Q31 one below its 16-bit output.
+    The gain from Q15 is in memory: a Q15 DelayLine holds twice the
+    time of a Q31 one.
+
+    Nothing wraps. Sums that can leave the format saturate:
+    - On ARM (__ARM_FEATURE_DSP) this uses QADD / QSUB / SSAT, the
+      instructions behind CMSIS __QADD / __QSUB / __SSAT.
+    - Elsewhere it is the same clamp in C.
+    The Q31 x Q31 products accumulate in 64 bits, and GCC emits SMULL /
+    SMLAL for them without an intrinsic.
+
+    Coefficients are set from float, or from the same BiquadSection as
+    the float cascades, at control rate. Process() never touches float.
+
+    Scaling is the user's: full scale is +/- 1.0. Keep a filter's peak
+    gain below that (the Svf band output peaks at 1 / (2 - 2 * res)),
+    or it clips.
+*/
+namespace fixed
+{
+/** Saturates a 64-bit intermediate to Q31. */
+inline int32_t SatQ31(int64_t x)
+{
+    return x > INT32_MAX   ? INT32_MAX
+           : x < INT32_MIN ? INT32_MIN
+                           : static_cast<int32_t>(x);
+}
+
+/** Saturating Q31 add. */
+inline int32_t QAdd(int32_t a, int32_t b)
+{
+#if defined(__ARM_FEATURE_DSP)
+    int32_t r;
+    __asm__("qadd %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+#else
+    return SatQ31(static_cast<int64_t>(a) + b);
+#endif
+}
+
+/** Saturating Q31 subtract. */
+inline int32_t QSub(int32_t a, int32_t b)
+{
+#if defined(__ARM_FEATURE_DSP)
+    int32_t r;
+    __asm__("qsub %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+#else
+    return SatQ31(static_cast<int64_t>(a) - b);
+#endif
+}
+
+/** Saturates x to a signed bits-wide integer. */
+template <int bits>
+inline int32_t Ssat(int32_t x)
+{
+    static_assert(bits >= 1 && bits <= 32, "SSAT takes 1 to 32 bits");
+#if defined(__ARM_FEATURE_DSP)
+    int32_t r;
+    __asm__("ssat %0, %1, %2" : "=r"(r) : "I"(bits), "r"(x));
+    return r;
+#else
+    const int64_t hi = (static_cast<int64_t>(1) << (bits - 1)) - 1;
+    const int64_t lo = -(static_cast<int64_t>(1) << (bits - 1));
+    return static_cast<int32_t>(x > hi ? hi : (x < lo ? lo : x));
+#endif
+}
+
+/** A float scaled by 2^frac_bits, rounded and saturated to int32. */
+inline int32_t FloatToFixed(float x, int frac_bits)
+{
+    const float v
+        = x * static_cast<float>(static_cast<int64_t>(1) << frac_bits);
+    if(v >= 2147483520.0f) // largest float below 2^31
+        return INT32_MAX;
+    if(v <= -2147483648.0f)
+        return INT32_MIN;
+    return static_cast<int32_t>(v + (v >= 0.0f ? 0.5f : -0.5f));
+}
+
+/** 16-bit samples, full scale +/- 1.0. */
+struct Q15
+{
+    typedef int16_t sample_type;
+
+    static inline int32_t ToQ31(int16_t s)
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(s) << 16);
+    }
+    /** Rounds to nearest, saturating at the top. */
+    static inline int16_t FromQ31(int32_t q)
+    {
+        return static_cast<int16_t>(Ssat<16>((q >> 16) + ((q >> 15) & 1)));
+    }
+    static inline int16_t FromFloat(float x)
+    {
+        return FromQ31(FloatToFixed(x, 31));
+    }
+    static inline float ToFloat(int16_t s)
+    {
+        return static_cast<float>(s) * (1.0f / 32768.0f);
+    }
+};
+
+/** 32-bit samples, full scale +/- 1.0. */
+struct Q31
+{
+    typedef int32_t sample_type;
+
+    static inline int32_t ToQ31(int32_t s) { return s; }
+    static inline int32_t FromQ31(int32_t q) { return q; }
+    static inline int32_t FromFloat(float x) { return FloatToFixed(x, 31); }
+    static inline float   ToFloat(int32_t s)
+    {
+        return static_cast<float>(s) * (1.0f / 2147483648.0f);
+    }
+};
+
+/** One biquad section, direct form I.
+
+    The arithmetic of StereoBiquadCascadeQ31 for one channel: a 64-bit
+    accumulator and a 64-bit (Q63) feedback state, so low corners stay
+    clean. Coefficients come from a float BiquadSection, as IirDesign /
+    BiquadCascade produce them. They are stored in Q(31 - post_shift),
+    which spans +/- 2^post_shift.
+
+    declaration example:
+
+    fixed::Biquad<fixed::Q15> hpf;
+    hpf.Init();
+    hpf.SetSection(IirDesign::Butterworth<2>(
+        IirDesign::Response::HIGHPASS, 48000.0f, 200.0f)[0]);
+*/
+template <class Format, int post_shift = 2>
+class Biquad
+{
+  public:
+    static const size_t kStateBytes;
+
+    typedef typename Format::sample_type sample_type;
+
+    static_assert(post_shift >= 0 && post_shift < 8,
+                  "post_shift must leave most of the coefficient bits");
+
+    Biquad() {}
+    ~Biquad() {}
+
+    /** Passthrough, state cleared. */
+    void Init()
+    {
+        SetSection(BiquadSection());
+        Reset();
+    }
+
+    /** Clears the state, keeping the coefficients. */
+    void Reset()
+    {
+        x1_ = x2_ = 0;
+        y1_ = y2_ = 0;
+    }
+
+    /** Quantizes and sets the coefficients. Does not touch the state. */
+    void SetSection(const BiquadSection& section)
+    {
+        b0_ = FloatToFixed(section.b0, 31 - post_shift);
+        b1_ = FloatToFixed(section.b1, 31 - post_shift);
+        b2_ = FloatToFixed(section.b2, 31 - post_shift);
+        a1_ = FloatToFixed(-section.a1, 31 - post_shift);
+        a2_ = FloatToFixed(-section.a2, 31 - post_shift);
+    }
+
+    inline sample_type Process(sample_type in)
+    {
+        return Format::FromQ31(Step(Format::ToQ31(in)));
+    }
+
+    void ProcessBlock(const sample_type* in, sample_type* out, size_t size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            out[i] = Format::FromQ31(Step(Format::ToQ31(in[i])));
+        }
+    }
+
+  private:
+    static constexpr int     kShift  = post_shift + 1;
+    static constexpr int64_t kAccMax = static_cast<int64_t>(1)
+                                       << (62 - post_shift);
+
+    /** (Q63 * Q31) >> 32, as CMSIS mult32x64(). */
+    static inline int64_t Mul32x64(int64_t y, int32_t c)
+    {
+        return ((static_cast<int64_t>(static_cast<uint32_t>(y)) * c) >> 32)
+               + (y >> 32) * c;
+    }
+
+    inline int32_t Step(int32_t x)
+    {
+        int64_t acc = static_cast<int64_t>(b0_) * x
+                      + static_cast<int64_t>(b1_) * x1_
+                      + static_cast<int64_t>(b2_) * x2_ + Mul32x64(y1_, a1_)
+                      + Mul32x64(y2_, a2_);
+        // Q(62 - post_shift); clamp so the Q63 shift below cannot wrap.
+        acc             = acc >= kAccMax ? kAccMax - 1 : acc;
+        acc             = acc < -kAccMax ? -kAccMax : acc;
+        const int64_t y = acc * (static_cast<int64_t>(1) << kShift);
+        x2_             = x1_;
+        x1_             = x;
+        y2_             = y1_;
+        y1_             = y;
+        return static_cast<int32_t>(y >> 32);
+    }
+
+    int32_t b0_, b1_, b2_, a1_, a2_;
+    int32_t x1_, x2_;
+    int64_t y1_, y2_; // Q63
+};
+
+template <class Format, int post_shift>
+constexpr size_t Biquad<Format, post_shift>::kStateBytes
+    = sizeof(Biquad<Format, post_shift>);
+
+/** One-pole lowpass, y += a * (x - y), with the highpass x - y beside it.
+
+    The state is Q62, so a cutoff of a few Hz, whose a is a few parts
+    per million, still moves the output by less than one LSB per sample
+    instead of sticking.
+
+    declaration example:
+
+    fixed::OnePole<fixed::Q31> smooth;
+    smooth.Init(48000.0f);
+    smooth.SetFreq(20.0f);
+*/
+template <class Format>
+class OnePole
+{
+  public:
+    static const size_t kStateBytes;
+
+    typedef typename Format::sample_type sample_type;
+
+    OnePole() {}
+    ~OnePole() {}
+
+    /** Passthrough (a = 1), state cleared. */
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        coef_        = INT32_MAX;
+        Reset();
+    }
+
+    void Reset() { state_ = 0; }
+
+    /** Sets the -3 dB corner in Hz, through expf(). Control rate. */
+    void SetFreq(float freq)
+    {
+        SetCoeff(1.0f - expf(-TWOPI_F * freq / sample_rate_));
+    }
+
+    /** Sets a directly, 0 (frozen) to 1 (passthrough). */
+    void SetCoeff(float a) { coef_ = FloatToFixed(fclamp(a, 0.0f, 1.0f), 31); }
+
+    /** Returns the lowpass output. */
+    inline sample_type Process(sample_type in)
+    {
+        return Format::FromQ31(Step(Format::ToQ31(in)));
+    }
+
+    /** Returns the highpass output, in - lowpass. */
+    inline sample_type ProcessHigh(sample_type in)
+    {
+        const int32_t x = Format::ToQ31(in);
+        return Format::FromQ31(QSub(x, Step(x)));
+    }
+
+    /** Processes a block, the same as Process() on each sample, writing
+        the lowpass to low and the highpass to high. Either output may be
+        nullptr, and either may be in.
+    */
+    void ProcessBlock(const sample_type* in,
+                      sample_type*       low,
+                      sample_type*       high,
+                      size_t             size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            const int32_t x = Format::ToQ31(in[i]);
+            const int32_t y = Step(x);
+            if(low)
+                low[i] = Format::FromQ31(y);
+            if(high)
+                high[i] = Format::FromQ31(QSub(x, y));
+        }
+    }
+
+  private:
+    inline int32_t Step(int32_t x)
+    {
+        // a < 2^31 and |x - y| < 2^32, so the product is below 2^63;
+        // the state stays between x and y, within +/- 2^62.
+        const int32_t y = SatQ31(state_ >> 31);
+        state_ += static_cast<int64_t>(coef_) * (static_cast<int64_t>(x) - y);
+        return SatQ31(state_ >> 31);
+    }
+
+    float   sample_rate_;
+    int32_t coef_;  // Q31
+    int64_t state_; // Q62
+};
+
+template <class Format>
+constexpr size_t OnePole<Format>::kStateBytes = sizeof(OnePole<Format>);
+
+/** State variable filter, trapezoidal (Zavalishin / Simper) form.
+
+    Unlike the float Svf's double-sampled Chamberlin loop, this form is
+    stable at every cutoff below Nyquist. It needs no oversampling, and
+    all three of its coefficients lie in [0, 1), which makes it the
+    form that suits Q31. g = tan(pi * fc / fs) and the coefficients are
+    computed in float at SetFreq() / SetRes().
+
+    res runs 0 to 1 as in the float Svf. The damping k = 2 - 2 * res is
+    held at 0.02 or above, so the band output peaks at 1 / k, up to 50
+    times (34 dB).
+
+    declaration example:
+
+    fixed::Svf<fixed::Q31> svf;
+    svf.Init(48000.0f);
+    svf.SetFreq(1000.0f);
+    svf.SetRes(0.7f);
+*/
+template <class Format>
+class Svf
+{
+  public:
+    static const size_t kStateBytes;
+
+    typedef typename Format::sample_type sample_type;
+
+    Svf() {}
+    ~Svf() {}
+
+    /** 1 kHz, res 0, state cleared. */
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        freq_        = 1000.0f;
+        res_         = 0.0f;
+        UpdateCoeffs();
+        Reset();
+    }
+
+    void Reset()
+    {
+        ic1_ = ic2_ = 0;
+        low_ = band_ = high_ = notch_ = 0;
+    }
+
+    /** Sets the cutoff in Hz, held below 0.49 * sample_rate. */
+    void SetFreq(float freq)
+    {
+        freq_ = fclamp(freq, 0.0f, 0.49f * sample_rate_);
+        UpdateCoeffs();
+    }
+
+    /** Sets the resonance, 0 to 1. */
+    void SetRes(float res)
+    {
+        res_ = fclamp(res, 0.0f, 1.0f);
+        UpdateCoeffs();
+    }
+
+    /** Processes one sample, updating all of the outputs. */
+    inline void Process(sample_type in) { Step(Format::ToQ31(in)); }
+
+    /** Processes a block, the same as Process() on each sample, writing
+        each output to its own buffer. Any output may be nullptr, and any
+        may be in. Low() etc. return the last sample's outputs afterwards.
+    */
+    void ProcessBlock(const sample_type* in,
+                      sample_type*       low,
+                      sample_type*       high,
+                      sample_type*       band,
+                      sample_type*       notch,
+                      size_t             size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            Step(Format::ToQ31(in[i]));
+            if(low)
+                low[i] = Format::FromQ31(low_);
+            if(high)
+                high[i] = Format::FromQ31(high_);
+            if(band)
+                band[i] = Format::FromQ31(band_);
+            if(notch)
+                notch[i] = Format::FromQ31(notch_);
+        }
+    }
+
+    inline sample_type Low() const { return Format::FromQ31(low_); }
+    inline sample_type High() const { return Format::FromQ31(high_); }
+    inline sample_type Band() const { return Format::FromQ31(band_); }
+    inline sample_type Notch() const { return Format::FromQ31(notch_); }
+
+  private:
+    void UpdateCoeffs()
+    {
+        const float g  = tanf(PI_F * freq_ / sample_rate_);
+        const float k  = fmax(2.0f - 2.0f * res_, 0.02f);
+        const float a1 = 1.0f / (1.0f + g * (g + k));
+        const float a2 = g * a1;
+        a1_            = FloatToFixed(a1, 31);
+        a2_            = FloatToFixed(a2, 31);
+        a3_            = FloatToFixed(g * a2, 31);
+        k_             = FloatToFixed(k, 30);
+    }
+
+    inline void Step(int32_t x)
+    {
+        // Every operand is Q31 and every coefficient below 1, so each
+        // sum of two products stays below 2^63.
+        const int32_t v3 = QSub(x, ic2_);
+        const int32_t v1 = SatQ31((static_cast<int64_t>(a1_) * ic1_
+                                   + static_cast<int64_t>(a2_) * v3)
+                                  >> 31);
+        const int32_t v2 = QAdd(ic2_,
+                                SatQ31((static_cast<int64_t>(a2_) * ic1_
+                                        + static_cast<int64_t>(a3_) * v3)
+                                       >> 31));
+        ic1_ = SatQ31(2 * static_cast<int64_t>(v1) - ic1_);
+        ic2_ = SatQ31(2 * static_cast<int64_t>(v2) - ic2_);
+
+        low_  = v2;
+        band_ = v1;
+        high_ = SatQ31(static_cast<int64_t>(x)
+                       - ((static_cast<int64_t>(k_) * v1) >> 30) - v2);
+        notch_ = QAdd(low_, high_);
+    }
+
+    float   sample_rate_, freq_, res_;
+    int32_t a1_, a2_, a3_; // Q31
+    int32_t k_;            // Q30
+    int32_t ic1_, ic2_;
+    int32_t low_, band_, high_, notch_;
+};
+
+template <class Format>
+constexpr size_t Svf<Format>::kStateBytes = sizeof(Svf<Format>);
+
+/** sin(2 pi i / size) for i in 0 .. size, in Q31. */
+template <size_t size>
+constexpr std::array<int32_t, size + 1> SineQ31()
+{
+    std::array<int32_t, size + 1> out{};
+    for(size_t i = 0; i <= size; i++)
+    {
+        const double v = ConstTable::Sin(2.0 * ConstTable::kPi
+                                         * static_cast<double>(i)
+                                         / static_cast<double>(size))
+                         * 2147483647.0;
+        out[i] = static_cast<int32_t>(v + (v >= 0.0 ? 0.5 : -0.5));
+    }
+    return out;
+}
+
+/** The Q31 sine table the fixed Nco reads, shared by every format.
+    Computed by the compiler into flash, so there is nothing to build.
+*/
+class NcoTable
+{
+  public:
+    static constexpr size_t kSize = daisysp::Nco::kTableSize;
+
+    /** Interpolated table sine of a raw 32-bit phase, Q31. */
+    static inline int32_t Sin(uint32_t phase)
+    {
+        const uint32_t idx  = phase >> kFracBits;
+        const int32_t  frac = static_cast<int32_t>(phase & kFracMask);
+        const int32_t  a    = kTable[idx];
+        const int32_t  b    = kTable[idx + 1];
+        return a
+               + static_cast<int32_t>(
+                   (static_cast<int64_t>(b - a) * frac) >> kFracBits);
+    }
+
+  private:
+    static constexpr uint32_t kFracBits = 32 - daisysp::Nco::kTableBits;
+    static constexpr uint32_t kFracMask = (1u << kFracBits) - 1u;
+
+    static constexpr std::array<int32_t, kSize + 1> kTable = SineQ31<kSize>();
+};
+
+/** Quadrature NCO with integer output: the float Nco's phase
+    accumulator and LUT backend, table and interpolation in Q31.
+
+    declaration example:
+
+    fixed::Nco<fixed::Q31> lo;
+    lo.Init(48000.0f);
+    lo.SetFreq(440.0f);
+*/
+template <class Format>
+class Nco
+{
+  public:
+    static const size_t kStateBytes;
+
+    typedef typename Format::sample_type sample_type;
+
+    Nco() {}
+    ~Nco() {}
+
+    /** 0 Hz, phase 0. */
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        phase_       = 0;
+        phase_inc_   = 0;
+    }
+
+    void SetFreq(float freq)
+    {
+        phase_inc_ = daisysp::Nco::FreqToPhaseInc(freq, sample_rate_);
+    }
+
+    /** Sets the raw 32-bit phase increment (2^32 == one cycle per sample). */
+    inline void     SetPhaseInc(uint32_t inc) { phase_inc_ = inc; }
+    inline uint32_t GetPhaseInc() const { return phase_inc_; }
+
+    /** Sets the raw 32-bit phase (2^32 == one cycle). */
+    inline void     SetPhase(uint32_t phase) { phase_ = phase; }
+    inline uint32_t GetPhase() const { return phase_; }
+
+    /** Generates one sine sample and advances the phase. */
+    inline sample_type Process()
+    {
+        const int32_t s = NcoTable::Sin(phase_);
+        phase_ += phase_inc_;
+        return Format::FromQ31(s);
+    }
+
+    /** Generates one quadrature sample and advances the phase. */
+    inline void Process(sample_type& s, sample_type& c)
+    {
+        s = Format::FromQ31(NcoTable::Sin(phase_));
+        c = Format::FromQ31(NcoTable::Sin(phase_ + daisysp::Nco::kQuarterTurn));
+        phase_ += phase_inc_;
+    }
+
+    /** Generates a block of sine and (optionally) cosine samples.
+        \param cos_out - may be nullptr
+    */
+    void ProcessBlock(sample_type* sin_out, sample_type* cos_out, size_t size)
+    {
+        uint32_t phase = phase_;
+        for(size_t i = 0; i < size; i++, phase += phase_inc_)
+        {
+            sin_out[i] = Format::FromQ31(NcoTable::Sin(phase));
+            if(cos_out)
+                cos_out[i] = Format::FromQ31(
+                    NcoTable::Sin(phase + daisysp::Nco::kQuarterTurn));
+        }
+        phase_ = phase;
+    }
+
+  private:
+    float    sample_rate_;
+    uint32_t phase_;
+    uint32_t phase_inc_;
+};
+
+template <class Format>
+constexpr size_t Nco<Format>::kStateBytes = sizeof(Nco<Format>);
+
+/** Delay line of Format samples, with a linearly interpolated read.
+
+    Works like the float DelayLine: Read() before Write(), the delay
+    from 1 to max_size - 1 samples, and storage rounded up to a power of
+    two. The fractional part of the delay is Q31.
+
+    declaration example: (one second of 16-bit samples, 96 KB)
+
+    fixed::DelayLine<fixed::Q15, 48000> DSY_SDRAM_BSS del;
+*/
+template <class Format, size_t max_size>
+class DelayLine
+{
+  public:
+    static const size_t kStateBytes;
+
+    typedef typename Format::sample_type sample_type;
+
+    DelayLine() {}
+    ~DelayLine() {}
+
+    void Init() { Reset(); }
+
+    /** as Init(), for a line whose memory already reads as zero. */
+    void Init(ZeroedMemory) { Restart(); }
+
+    /** Clears the line, write position 0, delay 1 sample. */
+    void Reset()
+    {
+        for(size_t i = 0; i < kSize; i++)
+        {
+            line_[i] = 0;
+        }
+        Restart();
+    }
+
+    inline void SetDelay(size_t delay)
+    {
+        frac_  = 0;
+        delay_ = delay < max_size ? delay : max_size - 1;
+    }
+
+    inline void SetDelay(float delay)
+    {
+        const size_t int_delay = static_cast<size_t>(delay);
+        frac_  = FloatToFixed(delay - static_cast<float>(int_delay), 31);
+        delay_ = int_delay < max_size ? int_delay : max_size - 1;
+    }
+
+    inline void Write(sample_type sample)
+    {
+        line_[write_ptr_] = sample;
+        write_ptr_        = (write_ptr_ - 1) & kMask;
+    }
+
+    /** The sample at the set delay, interpolated. */
+    inline sample_type Read() const { return ReadAt(write_ptr_ + delay_); }
+
+    /** The sample delay samples back, no interpolation. */
+    inline sample_type Read(size_t delay) const
+    {
+        return line_[(write_ptr_ + delay) & kMask];
+    }
+
+    /** Read() then Write() on each sample of in, into out. */
+    void ProcessBlock(const sample_type* in, sample_type* out, size_t size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            const sample_type x = in[i];
+            out[i]              = Read();
+            Write(x);
+        }
+    }
+
+  private:
+    /** Smallest power of two >= n. */
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t kSize = RoundUp(max_size);
+    static constexpr size_t kMask = kSize - 1;
+
+    void Restart()
+    {
+        write_ptr_ = 0;
+        delay_     = 1;
+        frac_      = 0;
+    }
+
+    inline sample_type ReadAt(size_t t) const
+    {
+        const int32_t a = Format::ToQ31(line_[t & kMask]);
+        if(frac_ == 0)
+            return Format::FromQ31(a);
+        const int32_t b = Format::ToQ31(line_[(t + 1) & kMask]);
+        // |b - a| < 2^32 and frac_ < 2^31: the product fits.
+        const int64_t d = static_cast<int64_t>(b) - a;
+        return Format::FromQ31(a + static_cast<int32_t>((d * frac_) >> 31));
+    }
+
+    size_t      write_ptr_;
+    size_t      delay_;
+    int32_t     frac_; // Q31
+    sample_type line_[kSize];
+};
+
+template <class Format, size_t max_size>
+constexpr size_t DelayLine<Format, max_size>::kStateBytes
+    = sizeof(DelayLine<Format, max_size>);
+
+} // namespace fixed
+} // namespace daisysp
+#endif
@@ -4,7 +4,9 @@
 #ifdef __cplusplus
 
 #include <stdint.h>
-#include "delayline.h"
+#include <stddef.h>
+#include "dsp.h"
+#include "mod_delay.h"
 
 /** @file flanger.h */
 
@@ -14,62 +16,107 @@ namespace daisysp
  *
  * Generates a modulating phase shifted copy of a signal, and recombines
  * with the original to create a 'flanging' sound effect.
+ *
+ * The line is sized for max_sample_rate at compile time, see ModDelay;
+ * Flanger is the one for DSY_MOD_DELAY_MAX_SAMPLE_RATE.
  */
-class Flanger
+template <size_t max_sample_rate>
+class BasicFlanger
 {
   public:
+    static const size_t kStateBytes;
+
     /** Initialize the modules
         \param sample_rate Audio engine sample rate.
     */
-    void Init(float sample_rate);
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+
+        del_.Init(sample_rate, 1.f);
+        SetFeedback(.2f);
+        SetDelay(.75f);
+
+        SetLfoFreq(.3f);
+        SetLfoDepth(.9f);
+    }
 
     /** Get the next sample
         \param in Sample to process
     */
-    float Process(float in);
+    float Process(float in)
+    {
+        return (in + del_.Process(in)) * .5f; //equal mix
+    }
+
+    /** Process a block, the lfo stepped once per ModDelay::kSubBlock.
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        float wet[kChunkSize];
+        for(size_t pos = 0; pos < size; pos += kChunkSize)
+        {
+            const size_t n = size - pos < kChunkSize ? size - pos : kChunkSize;
+            del_.ProcessBlock(in + pos, wet, n);
+            for(size_t i = 0; i < n; i++)
+            {
+                out[pos + i] = (in[pos + i] + wet[i]) * .5f;
+            }
+        }
+    }
 
     /** How much of the signal to feedback into the delay line.
         \param feedback Works 0-1.
     */
-    void SetFeedback(float feedback);
+    void SetFeedback(float feedback)
+    {
+        del_.SetFeedback(fclamp(feedback, 0.f, 1.f) * .97f);
+    }
 
     /** How much to modulate the delay by.
         \param depth Works 0-1.
     */
-    void SetLfoDepth(float depth);
+    void SetLfoDepth(float depth) { del_.SetLfoDepth(depth); }
 
     /** Set lfo frequency.
         \param freq Frequency in Hz
     */
-    void SetLfoFreq(float freq);
+    void SetLfoFreq(float freq) { del_.SetLfoFreq(freq); }
 
     /** Set the internal delay rate. 
         \param delay Tuned for 0-1. Maps to .1 to 7 ms.
     */
-    void SetDelay(float delay);
+    void SetDelay(float delay)
+    {
+        delay = (.1f + delay * 6.9f); //.1 to 7 ms
+        SetDelayMs(delay);
+    }
 
     /** Set the delay time in ms.
         \param ms Delay time in ms, .1 to 7 ms.
     */
-    void SetDelayMs(float ms);
+    void SetDelayMs(float ms)
+    {
+        ms = fmax(.1f, ms);
+        del_.SetDelay(ms * .001f * sample_rate_); //ms to samples
+    }
 
   private:
-    float                    sample_rate_;
-    static constexpr int32_t kDelayLength = 960; // 20 ms at 48kHz = .02 * 48000
-
-    float feedback_;
+    static constexpr size_t kChunkSize = 32;
 
-    //triangle lfos
-    float lfo_phase_;
-    float lfo_freq_;
-    float lfo_amp_;
+    float sample_rate_;
 
-    float delay_;
+    ModDelay<20, max_sample_rate> del_; // up to 20 ms
+};
 
-    DelayLine<float, kDelayLength> del_;
+template <size_t max_sample_rate>
+constexpr size_t BasicFlanger<max_sample_rate>::kStateBytes
+    = sizeof(BasicFlanger<max_sample_rate>);
 
-    float ProcessLfo();
-};
+using Flanger = BasicFlanger<DSY_MOD_DELAY_MAX_SAMPLE_RATE>;
 } //namespace daisysp
 #endif
 #endif
@@ -18,6 +18,8 @@ namespace daisysp
 class Fm2
 {
   public:
+    static const size_t kStateBytes;
+
     Fm2() {}
     ~Fm2() {}
 
@@ -60,6 +62,8 @@ class Fm2
     float      idx_;
     float      freq_, lfreq_, ratio_, lratio_;
 };
+
+inline constexpr size_t Fm2::kStateBytes = sizeof(Fm2);
 } // namespace daisysp
 #endif
 #endif
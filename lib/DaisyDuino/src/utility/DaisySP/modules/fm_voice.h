@@ -0,0 +1,288 @@
+#pragma once
+#ifndef DSY_FM_VOICE_H
+#define DSY_FM_VOICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fast_sin.h"
+#include "nco.h"
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** Operator routings for FmVoice, fixed at compile time.
+
+    Operators are numbered from 0. kMod[i] has bit j set when operator j
+    modulates operator i; modulators always have a higher number than
+    the operators they feed, so one pass from the top down renders a
+    sample. kCarriers is the mask of operators mixed to the output and
+    kFeedback is the operator fed back into itself.
+
+    The 6-operator ones are the DX7 algorithms of the same number, with
+    DX7 operator n as operator n - 1 here.
+*/
+namespace fm_algorithm
+{
+/** 3 -> 2 -> 1 -> 0 */
+struct Stack4
+{
+    static constexpr size_t  kNumOps   = 4;
+    static constexpr uint8_t kMod[4]   = {0x2, 0x4, 0x8, 0x0};
+    static constexpr uint8_t kCarriers = 0x1;
+    static constexpr size_t  kFeedback = 3;
+};
+
+/** 1 -> 0, 3 -> 2 */
+struct TwoPairs4
+{
+    static constexpr size_t  kNumOps   = 4;
+    static constexpr uint8_t kMod[4]   = {0x2, 0x0, 0x8, 0x0};
+    static constexpr uint8_t kCarriers = 0x5;
+    static constexpr size_t  kFeedback = 3;
+};
+
+/** (3 -> 2) + 1 -> 0 */
+struct Branch4
+{
+    static constexpr size_t  kNumOps   = 4;
+    static constexpr uint8_t kMod[4]   = {0x6, 0x0, 0x8, 0x0};
+    static constexpr uint8_t kCarriers = 0x1;
+    static constexpr size_t  kFeedback = 3;
+};
+
+/** 3 -> 0, 1, 2 */
+struct OneToThree4
+{
+    static constexpr size_t  kNumOps   = 4;
+    static constexpr uint8_t kMod[4]   = {0x8, 0x8, 0x8, 0x0};
+    static constexpr uint8_t kCarriers = 0x7;
+    static constexpr size_t  kFeedback = 3;
+};
+
+/** all carriers, organ-like */
+struct Additive4
+{
+    static constexpr size_t  kNumOps   = 4;
+    static constexpr uint8_t kMod[4]   = {0x0, 0x0, 0x0, 0x0};
+    static constexpr uint8_t kCarriers = 0xf;
+    static constexpr size_t  kFeedback = 3;
+};
+
+/** DX7 1: 5 -> 4 -> 3 -> 2, 1 -> 0 */
+struct Dx1
+{
+    static constexpr size_t  kNumOps   = 6;
+    static constexpr uint8_t kMod[6]   = {0x02, 0x00, 0x08, 0x10, 0x20, 0x00};
+    static constexpr uint8_t kCarriers = 0x05;
+    static constexpr size_t  kFeedback = 5;
+};
+
+/** DX7 5: 1 -> 0, 3 -> 2, 5 -> 4 */
+struct Dx5
+{
+    static constexpr size_t  kNumOps   = 6;
+    static constexpr uint8_t kMod[6]   = {0x02, 0x00, 0x08, 0x00, 0x20, 0x00};
+    static constexpr uint8_t kCarriers = 0x15;
+    static constexpr size_t  kFeedback = 5;
+};
+
+/** DX7 32: all carriers */
+struct Dx32
+{
+    static constexpr size_t  kNumOps   = 6;
+    static constexpr uint8_t kMod[6]   = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    static constexpr uint8_t kCarriers = 0x3f;
+    static constexpr size_t  kFeedback = 5;
+};
+
+/** Number of carriers in an algorithm */
+template <class Algorithm>
+constexpr size_t CountCarriers()
+{
+    size_t c = 0;
+    for(size_t i = 0; i < Algorithm::kNumOps; i++)
+        c += (Algorithm::kCarriers >> i) & 1;
+    return c;
+}
+} // namespace fm_algorithm
+
+/** Block-based N-operator FM (phase modulation) voice.
+
+    The routing is a compile-time fm_algorithm, so the operator loop and
+    its modulation sums unroll with no per-sample branching. Operators
+    are sines from FastSin on the default tier, each at a ratio of the
+    voice frequency, on 32-bit phase accumulators as for Nco.
+
+    An operator's level is its output amplitude; feeding another
+    operator, a level of 1 is a deviation of one cycle (2 pi rad) peak.
+    Levels are targets: ProcessBlock() ramps every operator linearly
+    from the level it ended the last block on, so envelopes run once per
+    block (an Adsr ticked per block and passed to SetLevel()) without
+    zipper noise. The carriers are summed and scaled by 1 / their count.
+
+    declaration example:
+
+    FmVoice<fm_algorithm::Stack4> voice;
+    voice.Init(48000.f);
+    voice.SetFreq(220.f);
+    voice.SetRatio(1, 2.f);
+    voice.SetLevel(1, 0.3f);
+*/
+template <class Algorithm>
+class FmVoice
+{
+  public:
+    static const size_t kStateBytes;
+
+    FmVoice() {}
+    ~FmVoice() {}
+
+    static constexpr size_t kNumOps = Algorithm::kNumOps;
+
+    /** Initializes the voice at 440 Hz, all operators at ratio 1,
+        carriers at level 1, modulators and feedback at 0.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        freq_        = 440.0f;
+        feedback_    = 0.0f;
+        fb_[0] = fb_[1] = 0.0f;
+        for(size_t i = 0; i < kNumOps; i++)
+        {
+            ratio_[i]  = 1.0f;
+            phase_[i]  = 0;
+            level_[i]  = (Algorithm::kCarriers >> i) & 1 ? 1.0f : 0.0f;
+            target_[i] = level_[i];
+        }
+        UpdateIncrements();
+        FastSin::Init();
+    }
+
+    /** Sets the voice frequency in Hz, ratio 1. */
+    inline void SetFreq(float freq)
+    {
+        freq_ = fabsf(freq);
+        UpdateIncrements();
+    }
+
+    /** Sets an operator's frequency as a ratio of the voice frequency. */
+    inline void SetRatio(size_t op, float ratio)
+    {
+        if(op < kNumOps)
+        {
+            ratio_[op] = fabsf(ratio);
+            inc_[op]   = Nco::FreqToPhaseInc(freq_ * ratio_[op], sample_rate_);
+        }
+    }
+
+    /** Sets the level an operator reaches at the end of the next block. */
+    inline void SetLevel(size_t op, float level)
+    {
+        if(op < kNumOps)
+            target_[op] = level;
+    }
+
+    /** Sets the feedback of Algorithm::kFeedback, same units as levels. */
+    inline void SetFeedback(float feedback) { feedback_ = feedback; }
+
+    /** Resets all operator phases and the feedback memory, for a hard
+        retrigger on note on.
+    */
+    void Reset()
+    {
+        for(size_t i = 0; i < kNumOps; i++)
+            phase_[i] = 0;
+        fb_[0] = fb_[1] = 0.0f;
+    }
+
+    /** Renders size samples, ramping the levels to their targets. */
+    void ProcessBlock(float* out, size_t size)
+    {
+        if(size == 0)
+            return;
+
+        uint32_t    phase[kNumOps], inc[kNumOps];
+        float       level[kNumOps], step[kNumOps];
+        const float ramp = 1.0f / static_cast<float>(size);
+        for(size_t i = 0; i < kNumOps; i++)
+        {
+            phase[i] = phase_[i];
+            inc[i]   = inc_[i];
+            level[i] = level_[i];
+            step[i]  = (target_[i] - level_[i]) * ramp;
+        }
+        float       fb0 = fb_[0], fb1 = fb_[1];
+        const float fb_gain = 0.5f * feedback_;
+
+        for(size_t n = 0; n < size; n++)
+        {
+            float y[kNumOps];
+            float sum = 0.0f;
+            for(size_t k = kNumOps; k-- > 0;)
+            {
+                float m = 0.0f;
+                for(size_t j = k + 1; j < kNumOps; j++)
+                {
+                    if((Algorithm::kMod[k] >> j) & 1)
+                        m += y[j];
+                }
+                if(k == Algorithm::kFeedback)
+                    m += fb_gain * (fb0 + fb1);
+
+                level[k] += step[k];
+                // Signed, the phase is [-1/2, 1/2) cycles: one vcvt.
+                const float p
+                    = static_cast<float>(static_cast<int32_t>(phase[k]))
+                      * kPhaseScale;
+                y[k] = level[k] * FastSin::Sin(p + m);
+                phase[k] += inc[k];
+
+                if((Algorithm::kCarriers >> k) & 1)
+                    sum += y[k];
+            }
+            fb1    = fb0;
+            fb0    = y[Algorithm::kFeedback];
+            out[n] = sum * kCarrierGain;
+        }
+
+        for(size_t i = 0; i < kNumOps; i++)
+        {
+            phase_[i] = phase[i];
+            level_[i] = target_[i];
+        }
+        fb_[0] = fb0;
+        fb_[1] = fb1;
+    }
+
+  private:
+    static_assert(kNumOps <= 8, "kMod and kCarriers are 8-bit masks");
+    static_assert(Algorithm::kFeedback < kNumOps, "feedback operator");
+    static_assert(fm_algorithm::CountCarriers<Algorithm>() > 0, "at least one carrier");
+
+    static constexpr float kCarrierGain
+        = 1.0f / static_cast<float>(fm_algorithm::CountCarriers<Algorithm>());
+
+    static constexpr float kPhaseScale = 1.0f / 4294967296.0f;
+
+    void UpdateIncrements()
+    {
+        for(size_t i = 0; i < kNumOps; i++)
+            inc_[i] = Nco::FreqToPhaseInc(freq_ * ratio_[i], sample_rate_);
+    }
+
+    float    sample_rate_, freq_, feedback_;
+    float    fb_[2]; /**< last two outputs of the feedback operator */
+    float    ratio_[kNumOps];
+    uint32_t phase_[kNumOps];
+    uint32_t inc_[kNumOps];
+    float    level_[kNumOps];
+    float    target_[kNumOps];
+};
+
+template <class Algorithm>
+constexpr size_t FmVoice<Algorithm>::kStateBytes = sizeof(FmVoice<Algorithm>);
+} // namespace daisysp
+#endif
+#endif
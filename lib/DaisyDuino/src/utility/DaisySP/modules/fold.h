@@ -3,6 +3,7 @@
 #define DSY_FOLD_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -18,6 +19,8 @@ Ported from soundpipe by Ben Sergentanis, May 2020
 class Fold
 {
   public:
+    static const size_t kStateBytes;
+
     Fold() {}
     ~Fold() {}
     /** Initializes the fold module.
@@ -39,6 +42,8 @@ class Fold
     float incr_, index_, value_;
     int   sample_index_;
 };
+
+inline constexpr size_t Fold::kStateBytes = sizeof(Fold);
 } // namespace daisysp
 #endif
 #endif
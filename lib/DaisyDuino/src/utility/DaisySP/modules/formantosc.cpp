@@ -1,4 +1,5 @@
 #include "dsp.h"
+#include "fast_sin.h"
 #include "formantosc.h"
 #include <math.h>
 
@@ -6,6 +7,7 @@ using namespace daisysp;
 
 void FormantOscillator::Init(float sample_rate)
 {
+    FastSin::Init();
     carrier_phase_ = 0.0f;
     formant_phase_ = 0.0f;
     next_sample_   = 0.0f;
@@ -13,47 +15,71 @@ void FormantOscillator::Init(float sample_rate)
     carrier_frequency_ = 0.0f;
     formant_frequency_ = 100.f;
     phase_shift_       = 0.0f;
+    ps_inc_            = 0.0f;
 
     sample_rate_ = sample_rate;
 }
 
 float FormantOscillator::Process()
 {
-    float this_sample = next_sample_;
-    float next_sample = 0.0f;
-    carrier_phase_ += carrier_frequency_;
+    float out;
+    ProcessBlock(&out, 1);
+    return out;
+}
 
-    if(carrier_phase_ >= 1.0f)
-    {
-        carrier_phase_ -= 1.0f;
-        float reset_time = carrier_phase_ / carrier_frequency_;
-
-        float formant_phase_at_reset
-            = formant_phase_ + (1.0f - reset_time) * formant_frequency_;
-        float before        = Sine(formant_phase_at_reset + phase_shift_
-                            + (ps_inc_ * (1.0f - reset_time)));
-        float after         = Sine(0.0f + phase_shift_ + ps_inc_);
-        float discontinuity = after - before;
-        this_sample += discontinuity * ThisBlepSample(reset_time);
-        next_sample += discontinuity * NextBlepSample(reset_time);
-        formant_phase_ = reset_time * formant_frequency_;
-    }
-    else
+void FormantOscillator::ProcessBlock(float *out, size_t size)
+{
+    const float carrier_frequency = carrier_frequency_;
+    const float formant_frequency = formant_frequency_;
+
+    float carrier_phase = carrier_phase_;
+    float formant_phase = formant_phase_;
+    float phase_shift   = phase_shift_;
+    float ps_inc        = ps_inc_;
+    float next_sample_z = next_sample_;
+
+    for(size_t i = 0; i < size; i++)
     {
-        formant_phase_ += formant_frequency_;
-        if(formant_phase_ >= 1.0f)
+        float this_sample = next_sample_z;
+        float next_sample = 0.0f;
+        carrier_phase += carrier_frequency;
+
+        if(carrier_phase >= 1.0f)
         {
-            formant_phase_ -= 1.0f;
+            carrier_phase -= 1.0f;
+            float reset_time = carrier_phase / carrier_frequency;
+
+            float formant_phase_at_reset
+                = formant_phase + (1.0f - reset_time) * formant_frequency;
+            float before        = Sine(formant_phase_at_reset + phase_shift
+                                + (ps_inc * (1.0f - reset_time)));
+            float after         = Sine(0.0f + phase_shift + ps_inc);
+            float discontinuity = after - before;
+            this_sample += discontinuity * ThisBlepSample(reset_time);
+            next_sample += discontinuity * NextBlepSample(reset_time);
+            formant_phase = reset_time * formant_frequency;
         }
-    }
+        else
+        {
+            formant_phase += formant_frequency;
+            formant_phase -= formant_phase >= 1.0f ? 1.0f : 0.0f;
+        }
+
+        // A new phase shift lands on the first sample only.
+        phase_shift += ps_inc;
+        ps_inc = 0.f;
 
-    phase_shift_ += ps_inc_;
-    ps_inc_ = 0.f;
+        next_sample += Sine(formant_phase + phase_shift);
 
-    next_sample += Sine(formant_phase_ + phase_shift_);
+        next_sample_z = next_sample;
+        out[i]        = this_sample;
+    }
 
-    next_sample_ = next_sample;
-    return this_sample;
+    carrier_phase_ = carrier_phase;
+    formant_phase_ = formant_phase;
+    phase_shift_   = phase_shift;
+    ps_inc_        = ps_inc;
+    next_sample_   = next_sample_z;
 }
 
 void FormantOscillator::SetFormantFreq(float freq)
@@ -81,7 +107,7 @@ void FormantOscillator::SetPhaseShift(float ps)
 
 inline float FormantOscillator::Sine(float phase)
 {
-    return sinf(phase * TWOPI_F);
+    return FastSin::Sin(phase);
 }
 
 inline float FormantOscillator::ThisBlepSample(float t)
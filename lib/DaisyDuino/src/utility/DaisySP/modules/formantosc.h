@@ -3,6 +3,7 @@
 #define DSY_FORMANTOSCILLATOR_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file formantosc.h */
@@ -21,6 +22,8 @@ namespace daisysp
 class FormantOscillator
 {
   public:
+    static const size_t kStateBytes;
+
     FormantOscillator() {}
     ~FormantOscillator() {}
 
@@ -33,6 +36,11 @@ class FormantOscillator
     */
     float Process();
 
+    /** Processes a block, the same as Process() on each sample, with the
+        phases in registers across it.
+    */
+    void ProcessBlock(float *out, size_t size);
+
     /** Set the formant frequency.
         \param freq Frequency in Hz
     */
@@ -68,6 +76,9 @@ class FormantOscillator
 
     //DISALLOW_COPY_AND_ASSIGN(FormantOscillator);
 };
+
+inline constexpr size_t FormantOscillator::kStateBytes
+    = sizeof(FormantOscillator);
 } //namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define DSY_FRACTAL_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file fractal_noise.h */
@@ -24,6 +25,8 @@ template <typename T, int order>
 class FractalRandomGenerator
 {
   public:
+    static const size_t kStateBytes;
+
     FractalRandomGenerator() {}
     ~FractalRandomGenerator() {}
 
@@ -77,6 +80,10 @@ class FractalRandomGenerator
 
     T generator_[order];
 };
+
+template <typename T, int order>
+constexpr size_t FractalRandomGenerator<T, order>::kStateBytes
+    = sizeof(FractalRandomGenerator<T, order>);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
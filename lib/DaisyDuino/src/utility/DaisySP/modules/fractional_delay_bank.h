@@ -0,0 +1,271 @@
+#pragma once
+#ifndef DSY_FRACTIONAL_DELAY_BANK_H
+#define DSY_FRACTIONAL_DELAY_BANK_H
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "dsp.h"
+namespace daisysp
+{
+/** One signal fanned out to several outputs, each with its own
+fractional delay and gain, as a transducer array's steering needs.
+
+The input is stored once, in a mirrored ring, and every output reads it
+through a polyphase fractional-delay FIR of taps coefficients: the
+integer part of its delay picks where in the ring, the fraction a blend
+of the two nearest of phases + 1 coefficient sets. That is taps
+multiply-adds per output and sample on contiguous memory, where N
+DelayLines would each store and interpolate their own copy; an output
+whose delay holds over a block blends its set once.
+
+The coefficient sets are weighted least-squares fits to the ideal delay
+over [band_lo, band_hi], designed in Init(), with a small penalty on
+their energy so the gain outside the band stays near 1. A polynomial
+(Farrow, Lagrange) interpolator is flat only well below fs / 4; this
+one holds a 40 kHz carrier band to about -68 dB of error with 8 taps at
+192 kHz. At 96 kHz the band sits too close to Nyquist for a short FIR:
+16 taps reach about -35 dB.
+
+Each ProcessBlock() moves every output's delay and gain linearly from
+where the last block left them to the values set since, so a change
+never steps.
+
+Delays run from GetMinDelay(), the FIR's own half length, to max_delay
+samples. Blocks are at most max_block frames.
+
+declaration example:
+
+FractionalDelayBank<8, 64> DSY_SDRAM_BSS bank;
+bank.Init(192000.f, 34500.f, 44500.f);
+bank.SetOutput(3, 12.25f, 0.8f);
+bank.ProcessBlock(in, out, size); // out[0] ... out[7]
+*/
+template <size_t outputs,
+          size_t max_delay,
+          size_t taps      = 8,
+          size_t phases    = 64,
+          size_t max_block = 256>
+class FractionalDelayBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(taps >= 2 && taps <= 32 && taps % 2 == 0,
+                  "taps: an even number from 2 to 32");
+    static_assert(phases >= 1, "phases: at least 1");
+
+    FractionalDelayBank() {}
+    ~FractionalDelayBank() {}
+
+    /** Designs the coefficient sets for the band and clears the ring.
+        Every output starts at GetMinDelay() and unity gain.
+        \param band_lo_hz lower edge of the band to fit, 0 for all of it
+        \param band_hi_hz upper edge, below sample_rate / 2
+    */
+    void Init(float sample_rate, float band_lo_hz, float band_hi_hz)
+    {
+        const double w1 = (double)TWOPI_F * (double)band_lo_hz
+                          / (double)sample_rate;
+        const double w2 = (double)TWOPI_F * (double)band_hi_hz
+                          / (double)sample_rate;
+        for(size_t p = 0; p <= phases; p++)
+        {
+            Design(&coeffs_[p * taps],
+                   (double)GetMinDelay() + (double)p / (double)phases,
+                   w1,
+                   w2);
+        }
+        for(size_t i = 0; i < 2 * kSize; i++)
+        {
+            ring_[i] = 0.f;
+        }
+        write_ptr_ = 0;
+        for(size_t o = 0; o < outputs; o++)
+        {
+            delay_[o] = target_delay_[o] = GetMinDelay();
+            gain_[o] = target_gain_[o] = 1.f;
+        }
+    }
+
+    /** Sets where an output goes by the end of the next ProcessBlock().
+        \param delay samples, clipped to [GetMinDelay(), max_delay]
+    */
+    inline void SetOutput(size_t output, float delay, float gain)
+    {
+        delay = delay < GetMinDelay() ? GetMinDelay() : delay;
+        delay = delay > (float)max_delay ? (float)max_delay : delay;
+        target_delay_[output] = delay;
+        target_gain_[output]  = gain;
+    }
+
+    /** Stores in[size], then writes every output's out[o][size].
+        in may be one of the outputs.
+    */
+    void ProcessBlock(const float* in, float* const* out, size_t size)
+    {
+        size = size < max_block ? size : max_block;
+        if(size == 0)
+            return;
+        for(size_t i = 0; i < size; i++)
+        {
+            write_ptr_                = (write_ptr_ - 1) & kMask;
+            ring_[write_ptr_]         = in[i];
+            ring_[write_ptr_ + kSize] = in[i];
+        }
+
+        // Block sample i sits size - 1 - i frames behind the newest; the
+        // mirror keeps every tap's read contiguous, with no wrap.
+        const float* newest = &ring_[write_ptr_];
+        const float  step   = 1.f / (float)size;
+        for(size_t o = 0; o < outputs; o++)
+        {
+            float*      dst = out[o];
+            const float d0  = delay_[o] - GetMinDelay();
+            const float d1  = target_delay_[o] - GetMinDelay();
+            const float g0  = gain_[o];
+            const float dg  = (target_gain_[o] - g0) * step;
+            float       c[taps];
+            size_t      k;
+            if(d0 == d1)
+            {
+                Phase(d0, c, k);
+                for(size_t i = 0; i < size; i++)
+                {
+                    dst[i] = (g0 + dg * (float)(i + 1))
+                             * Fir(c, newest + (size - 1 - i) + k);
+                }
+            }
+            else
+            {
+                const float dd = (d1 - d0) * step;
+                for(size_t i = 0; i < size; i++)
+                {
+                    Phase(d0 + dd * (float)(i + 1), c, k);
+                    dst[i] = (g0 + dg * (float)(i + 1))
+                             * Fir(c, newest + (size - 1 - i) + k);
+                }
+            }
+            delay_[o] = target_delay_[o];
+            gain_[o]  = target_gain_[o];
+        }
+    }
+
+    /** The FIR's own delay, the least an output can have */
+    static constexpr float GetMinDelay() { return (float)(taps / 2 - 1); }
+
+    static constexpr size_t GetOutputs() { return outputs; }
+
+  private:
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t kSize = RoundUp(max_block + max_delay + taps);
+    static constexpr size_t kMask = kSize - 1;
+    static constexpr double kRidge = 1e-5; // relative energy penalty
+
+    /** Coefficients for excess delay e into c, its whole samples into k.
+        Blending the two nearest sets keeps the fraction exact to well
+        below what phases sets alone resolve. */
+    inline void Phase(float e, float* c, size_t& k) const
+    {
+        k                = (size_t)e;
+        const float  f   = (e - (float)k) * (float)phases;
+        size_t       p   = (size_t)f;
+        p                = p < phases ? p : phases - 1;
+        const float  mu  = f - (float)p;
+        const float* lo  = &coeffs_[p * taps];
+        const float* hi  = lo + taps;
+        for(size_t t = 0; t < taps; t++)
+        {
+            c[t] = lo[t] + mu * (hi[t] - lo[t]);
+        }
+    }
+
+    static inline float Fir(const float* c, const float* x)
+    {
+        float acc = 0.f;
+        for(size_t t = 0; t < taps; t++)
+        {
+            acc += c[t] * x[t];
+        }
+        return acc;
+    }
+
+    /** Integral of cos(m w) over [w1, w2] */
+    static double CosIntegral(double m, double w1, double w2)
+    {
+        return fabs(m) < 1e-12 ? w2 - w1 : (sin(w2 * m) - sin(w1 * m)) / m;
+    }
+
+    /** Least-squares fit of taps coefficients to a delay of d samples
+        over [w1, w2]: the normal equations, solved by Gauss-Jordan
+        elimination with partial pivoting, in double since the band
+        makes them ill-conditioned. */
+    static void Design(float* h, double d, double w1, double w2)
+    {
+        double a[taps][taps + 1];
+        for(size_t r = 0; r < taps; r++)
+        {
+            for(size_t c = 0; c < taps; c++)
+            {
+                a[r][c] = CosIntegral((double)r - (double)c, w1, w2);
+            }
+            a[r][r] += kRidge * (w2 - w1);
+            a[r][taps] = CosIntegral((double)r - d, w1, w2);
+        }
+        for(size_t c = 0; c < taps; c++)
+        {
+            size_t pivot = c;
+            for(size_t r = c + 1; r < taps; r++)
+            {
+                if(fabs(a[r][c]) > fabs(a[pivot][c]))
+                    pivot = r;
+            }
+            for(size_t q = 0; q <= taps; q++)
+            {
+                const double t = a[c][q];
+                a[c][q]        = a[pivot][q];
+                a[pivot][q]    = t;
+            }
+            for(size_t r = 0; r < taps; r++)
+            {
+                if(r == c)
+                    continue;
+                const double f = a[r][c] / a[c][c];
+                for(size_t q = c; q <= taps; q++)
+                {
+                    a[r][q] -= f * a[c][q];
+                }
+            }
+        }
+        for(size_t t = 0; t < taps; t++)
+        {
+            h[t] = (float)(a[t][taps] / a[t][t]);
+        }
+    }
+
+    size_t write_ptr_;
+    float  delay_[outputs];
+    float  gain_[outputs];
+    float  target_delay_[outputs];
+    float  target_gain_[outputs];
+    float  coeffs_[(phases + 1) * taps];
+    float  ring_[2 * kSize];
+};
+
+template <size_t outputs,
+          size_t max_delay,
+          size_t taps,
+          size_t phases,
+          size_t max_block>
+constexpr size_t
+    FractionalDelayBank<outputs, max_delay, taps, phases, max_block>::
+        kStateBytes
+    = sizeof(FractionalDelayBank<outputs, max_delay, taps, phases, max_block>);
+} // namespace daisysp
+#endif
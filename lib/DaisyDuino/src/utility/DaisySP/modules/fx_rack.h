@@ -0,0 +1,225 @@
+#pragma once
+#ifndef DSY_FX_RACK_H
+#define DSY_FX_RACK_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <tuple>
+#include <utility>
+
+/** @file fx_rack.h */
+
+namespace daisysp
+{
+/** @brief A mono block effect run on both channels with the same settings.
+
+    Module is any class with Init(float sample_rate) and
+    ProcessBlock(const float *in, float *out, size_t size), e.g. Tone,
+    Flanger, Phaser or PitchShifter. Set() applies one setting
+    to both copies, so the channels stay linked.
+
+    rack.Get<0>().Set([](Flanger &f) { f.SetFeedback(.5f); });
+*/
+template <class Module>
+class LinkedFx
+{
+  public:
+    static const size_t kStateBytes;
+
+    LinkedFx() {}
+    ~LinkedFx() {}
+
+    void Init(float sample_rate)
+    {
+        left_.Init(sample_rate);
+        right_.Init(sample_rate);
+    }
+
+    void ProcessBlock(const float *in_l,
+                      const float *in_r,
+                      float *      out_l,
+                      float *      out_r,
+                      size_t       size)
+    {
+        left_.ProcessBlock(in_l, out_l, size);
+        right_.ProcessBlock(in_r, out_r, size);
+    }
+
+    /** Calls f on both channels' module */
+    template <class F>
+    void Set(F f)
+    {
+        f(left_);
+        f(right_);
+    }
+
+    Module &Left() { return left_; }
+    Module &Right() { return right_; }
+
+  private:
+    Module left_, right_;
+};
+
+template <class Module>
+constexpr size_t LinkedFx<Module>::kStateBytes = sizeof(LinkedFx<Module>);
+
+/** @brief Stereo chain of block effects, fixed at compile time.
+
+    Each Fx is any class with
+
+        void Init(float sample_rate);
+        void ProcessBlock(const float *in_l, const float *in_r,
+                          float *out_l, float *out_r, size_t size);
+
+    which ReverbSc and StereoBiquadCascade-based effects have directly,
+    and LinkedFx<> gives any mono ProcessBlock() module.
+
+    ProcessBlock() runs one effect over the whole block before the next
+    starts, so each keeps its state in registers for its own loop rather
+    than being reloaded every sample. Between effects the signal
+    ping-pongs through two scratch blocks inside the rack: place the rack
+    in DTCM (DTCM_MEM_SECTION) and they sit in zero wait state memory.
+    The first effect reads the input and the last writes the output
+    directly, so one effect alone costs no copies; the input and output
+    may then alias only if that effect allows it.
+
+    A bypassed effect is skipped altogether: no call, no state update, no
+    copy. It resumes from where it stopped when re-enabled.
+
+    max_block is the longest block done in one pass; longer ones are
+    split. The scratch blocks take 4 * max_block floats.
+
+    declaration example:
+
+    static FxRack<48, LinkedFx<Flanger>, ReverbSc> DTCM_MEM_SECTION rack;
+    rack.Init(sample_rate);
+    rack.SetBypass(1, true);
+    ...
+    rack.ProcessBlock(in[0], in[1], out[0], out[1], size);
+*/
+template <size_t max_block, class... Fx>
+class FxRack
+{
+  public:
+    static const size_t kStateBytes;
+
+    FxRack() {}
+    ~FxRack() {}
+
+    static constexpr size_t kNumFx = sizeof...(Fx);
+
+    /** Initializes every effect, none bypassed.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        std::apply([sample_rate](auto &... fx) { (fx.Init(sample_rate), ...); },
+                   fx_);
+        for(size_t i = 0; i < kNumFx; i++)
+        {
+            bypass_[i] = false;
+        }
+    }
+
+    /** Processes a stereo block through every effect not bypassed.
+        \param in_l, in_r Input samples
+        \param out_l, out_r Output samples
+        \param size Number of frames
+    */
+    void ProcessBlock(const float *in_l,
+                      const float *in_r,
+                      float *      out_l,
+                      float *      out_r,
+                      size_t       size)
+    {
+        size_t last = kNumFx;
+        for(size_t i = 0; i < kNumFx; i++)
+        {
+            if(!bypass_[i])
+                last = i;
+        }
+        if(last == kNumFx)
+        {
+            if(out_l != in_l)
+                memmove(out_l, in_l, size * sizeof(float));
+            if(out_r != in_r)
+                memmove(out_r, in_r, size * sizeof(float));
+            return;
+        }
+        for(size_t pos = 0; pos < size; pos += max_block)
+        {
+            const size_t n = size - pos < max_block ? size - pos : max_block;
+            Chunk chunk{in_l + pos, in_r + pos, out_l + pos, out_r + pos, n, last, 0};
+            RunAll(chunk, std::index_sequence_for<Fx...>{});
+        }
+    }
+
+    /** Skips an effect entirely, or puts it back in the chain. */
+    inline void SetBypass(size_t idx, bool bypass)
+    {
+        if(idx < kNumFx)
+            bypass_[idx] = bypass;
+    }
+
+    /** \return whether effect idx is skipped */
+    inline bool IsBypassed(size_t idx) const
+    {
+        return idx < kNumFx && bypass_[idx];
+    }
+
+    /** \return effect idx, for its settings */
+    template <size_t idx>
+    auto &Get()
+    {
+        return std::get<idx>(fx_);
+    }
+
+  private:
+    static_assert(max_block > 0, "max_block must be at least one frame");
+
+    /** One pass: where the signal is now and where it goes next */
+    struct Chunk
+    {
+        const float *src_l, *src_r;
+        float *      out_l, *out_r;
+        size_t       size;
+        size_t       last; /**< last effect not bypassed */
+        size_t       ping; /**< scratch block written next */
+    };
+
+    template <size_t... I>
+    inline void RunAll(Chunk &c, std::index_sequence<I...>)
+    {
+        (Run<I>(c), ...);
+    }
+
+    template <size_t I>
+    inline void Run(Chunk &c)
+    {
+        if(bypass_[I])
+            return;
+        float *dst_l = c.out_l, *dst_r = c.out_r;
+        if(I != c.last)
+        {
+            dst_l  = scratch_[c.ping][0];
+            dst_r  = scratch_[c.ping][1];
+            c.ping = c.ping ^ 1;
+        }
+        std::get<I>(fx_).ProcessBlock(c.src_l, c.src_r, dst_l, dst_r, c.size);
+        c.src_l = dst_l;
+        c.src_r = dst_r;
+    }
+
+    std::tuple<Fx...> fx_;
+    bool              bypass_[kNumFx > 0 ? kNumFx : 1];
+    float             scratch_[2][2][max_block];
+};
+
+template <size_t max_block, class... Fx>
+constexpr size_t FxRack<max_block, Fx...>::kStateBytes
+    = sizeof(FxRack<max_block, Fx...>);
+} // namespace daisysp
+#endif
+#endif
@@ -0,0 +1,274 @@
+#pragma once
+#ifndef DSY_GOERTZEL_BANK_H
+#define DSY_GOERTZEL_BANK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+/** @file goertzel_bank.h */
+
+namespace daisysp
+{
+/** @brief N single-frequency detectors: the amplitude of a sine at each.
+
+    For a handful of bins (a pilot tone, a carrier, the peak of a
+    resonance) this is far cheaper than an FFT. Each bin costs one
+    multiply-add and a subtract per sample.
+
+    Two modes, chosen by Init():
+    - Block: every window samples, each bin gets the amplitude over
+      those samples, and the next window starts afresh. The
+      frequencies are free. Each bin is about 2 sr / window wide
+      (first zeros).
+    - Sliding: the amplitude over the last window samples, updated at
+      the end of each ProcessBlock(). It takes a window-sample history
+      buffer. The frequencies snap to multiples of sr / window, so
+      that one comb, x(n) - x(n - window), serves every bin. The
+      resonators are damped to 1 - 1e-5 per sample for stability; the
+      last sample weighs 1, the oldest a little less.
+
+    The state is kept as arrays per field (coefficients, then the two
+    delays of every bin) and ProcessBlock() runs two bins per pass over
+    the block, so their recursions hide each other's latency.
+
+    ProcessBlock() runs in the audio callback and only ever writes.
+    GetMagnitudes(), from the control task or loop(), copies a
+    consistent set and retries if a frame lands meanwhile; neither side
+    locks. The amplitude is that of a sine on the bin: a full scale sine
+    reads 1.
+
+    declaration example:
+
+    static float DSY_SDRAM_BSS history[4800];
+    static GoertzelBank<4> pilots;
+    pilots.Init(sample_rate, history, 4800);
+    pilots.SetFreq(0, 19000.f);
+    // audio callback:  pilots.ProcessBlock(in[0], size);
+    // loop():          float mag[4]; pilots.GetMagnitudes(mag);
+
+    \param N Number of bins
+*/
+template <size_t N>
+class GoertzelBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    GoertzelBank() {}
+    ~GoertzelBank() {}
+
+    static_assert(N > 0, "a GoertzelBank needs a bin");
+
+    /** Block mode: a new set of magnitudes every window samples.
+        \param sample_rate Audio engine sample rate
+        \param window Samples per measurement
+    */
+    void Init(float sample_rate, size_t window)
+    {
+        Init(sample_rate, nullptr, window);
+    }
+
+    /** Sliding mode: the magnitudes over the last window samples.
+        \param sample_rate Audio engine sample rate
+        \param history window floats, owned by the caller
+        \param window Samples per measurement
+    */
+    void Init(float sample_rate, float *history, size_t window)
+    {
+        sample_rate_ = sample_rate;
+        window_      = window > 0 ? window : 1;
+        history_     = history;
+        pos_         = 0;
+        count_       = 0;
+        seq_         = 0;
+        if(history_ != nullptr)
+        {
+            memset(history_, 0, window_ * sizeof(float));
+            a2_      = kDamp * kDamp;
+            oldest_  = powf(kDamp, static_cast<float>(window_));
+            norm_    = 2.f * (1.f - kDamp) / (1.f - oldest_);
+        }
+        else
+        {
+            a2_     = 1.f;
+            oldest_ = 0.f;
+            norm_   = 2.f / static_cast<float>(window_);
+        }
+        for(size_t i = 0; i < N; i++)
+        {
+            freq_[i] = a1_[i] = y1_[i] = y2_[i] = mag_[i] = 0.f;
+        }
+    }
+
+    /** Frequency of bin i. Sliding mode rounds it to the nearest
+        multiple of sample_rate / window (see GetFreq()).
+        \param i Bin
+        \param freq Frequency in Hz, below Nyquist
+    */
+    void SetFreq(size_t i, float freq)
+    {
+        float w = freq / sample_rate_;
+        if(history_ != nullptr)
+        {
+            const float   bins = static_cast<float>(window_);
+            const int32_t k    = static_cast<int32_t>(w * bins + .5f);
+            w                  = static_cast<float>(k) / bins;
+        }
+        freq_[i] = w * sample_rate_;
+        a1_[i]   = 2.f * Damp() * cosf(6.28318531f * w);
+    }
+
+    /** \return frequency of bin i as measured, in Hz */
+    inline float GetFreq(size_t i) const { return freq_[i]; }
+
+    /** Audio side: runs every bin over a block.
+        \param in Input samples
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, size_t size)
+    {
+        if(history_ != nullptr)
+        {
+            ProcessSliding(in, size);
+            return;
+        }
+        while(size > 0)
+        {
+            const size_t left = window_ - count_;
+            const size_t n    = size < left ? size : left;
+            Run(in, n);
+            in += n;
+            size -= n;
+            count_ += n;
+            if(count_ == window_)
+            {
+                Publish();
+                for(size_t i = 0; i < N; i++)
+                {
+                    y1_[i] = y2_[i] = 0.f;
+                }
+                count_ = 0;
+            }
+        }
+    }
+
+    /** Control side: copies the latest magnitudes.
+        \param out Receives N amplitudes
+        \return frames published so far, to tell a new set from the last
+    */
+    uint32_t GetMagnitudes(float *out) const
+    {
+        uint32_t seq;
+        do
+        {
+            seq = seq_;
+            std::atomic_signal_fence(std::memory_order_acquire);
+            for(size_t i = 0; i < N; i++)
+            {
+                out[i] = mag_[i];
+            }
+            std::atomic_signal_fence(std::memory_order_acquire);
+        } while((seq & 1) != 0 || seq != seq_);
+        return seq >> 1;
+    }
+
+    /** \return the latest amplitude of bin i alone */
+    inline float GetMagnitude(size_t i) const { return mag_[i]; }
+
+  private:
+    static constexpr float  kDamp  = 1.f - 1e-5f;
+    static constexpr size_t kChunk = 32;
+
+    inline float Damp() const { return history_ != nullptr ? kDamp : 1.f; }
+
+    /** y = x + a1 y1 - a2 y2 over n samples, two bins per pass */
+    void Run(const float *x, size_t n)
+    {
+        const float a2 = a2_;
+        size_t      i  = 0;
+        for(; i + 1 < N; i += 2)
+        {
+            const float c0 = a1_[i], c1 = a1_[i + 1];
+            float       p0 = y1_[i], q0 = y2_[i];
+            float       p1 = y1_[i + 1], q1 = y2_[i + 1];
+            for(size_t k = 0; k < n; k++)
+            {
+                const float s0 = x[k] + c0 * p0 - a2 * q0;
+                const float s1 = x[k] + c1 * p1 - a2 * q1;
+                q0             = p0;
+                p0             = s0;
+                q1             = p1;
+                p1             = s1;
+            }
+            y1_[i]     = p0;
+            y2_[i]     = q0;
+            y1_[i + 1] = p1;
+            y2_[i + 1] = q1;
+        }
+        if(i < N)
+        {
+            const float c = a1_[i];
+            float       p = y1_[i], q = y2_[i];
+            for(size_t k = 0; k < n; k++)
+            {
+                const float s = x[k] + c * p - a2 * q;
+                q             = p;
+                p             = s;
+            }
+            y1_[i] = p;
+            y2_[i] = q;
+        }
+    }
+
+    /** The comb into a chunk, then the resonators over it */
+    void ProcessSliding(const float *in, size_t size)
+    {
+        float comb[kChunk];
+        while(size > 0)
+        {
+            const size_t n = size < kChunk ? size : kChunk;
+            for(size_t k = 0; k < n; k++)
+            {
+                comb[k]        = in[k] - oldest_ * history_[pos_];
+                history_[pos_] = in[k];
+                if(++pos_ == window_)
+                    pos_ = 0;
+            }
+            Run(comb, n);
+            in += n;
+            size -= n;
+        }
+        Publish();
+    }
+
+    /** |X|^2 = y1^2 + a2 y2^2 - a1 y1 y2, scaled to a sine's amplitude */
+    void Publish()
+    {
+        seq_ = seq_ + 1;
+        std::atomic_signal_fence(std::memory_order_release);
+        for(size_t i = 0; i < N; i++)
+        {
+            const float p = y1_[i], q = y2_[i];
+            const float power = p * p + a2_ * q * q - a1_[i] * p * q;
+            mag_[i]           = norm_ * sqrtf(power > 0.f ? power : 0.f);
+        }
+        std::atomic_signal_fence(std::memory_order_release);
+        seq_ = seq_ + 1;
+    }
+
+    float  freq_[N], a1_[N], y1_[N], y2_[N], mag_[N];
+    float  sample_rate_, a2_, oldest_, norm_;
+    float *history_;
+    size_t window_, pos_, count_;
+    // Odd while Publish() writes mag_.
+    volatile uint32_t seq_;
+};
+
+template <size_t N>
+constexpr size_t GoertzelBank<N>::kStateBytes = sizeof(GoertzelBank<N>);
+
+} // namespace daisysp
+#endif
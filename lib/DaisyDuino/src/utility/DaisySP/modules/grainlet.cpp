@@ -1,4 +1,5 @@
 #include "dsp.h"
+#include "fast_sin.h"
 #include "grainlet.h"
 #include <math.h>
 
@@ -6,6 +7,7 @@ using namespace daisysp;
 
 void GrainletOscillator::Init(float sample_rate)
 {
+    FastSin::Init();
     sample_rate_ = sample_rate;
 
     carrier_phase_ = 0.0f;
@@ -21,50 +23,87 @@ void GrainletOscillator::Init(float sample_rate)
     SetBleed(.5f);
 }
 
-float GrainletOscillator::Process()
+inline float GrainletOscillator::Step(float& carrier_phase,
+                                     float& formant_phase,
+                                     float& next_out,
+                                     float  shape_inc,
+                                     float  bleed_inc)
 {
-    float this_sample = next_sample_;
+    float this_sample = next_out;
     float next_sample = 0.0f;
 
-    carrier_phase_ += carrier_frequency_;
+    carrier_phase += carrier_frequency_;
 
-    if(carrier_phase_ >= 1.0f)
+    if(carrier_phase >= 1.0f)
     {
-        carrier_phase_ -= 1.0f;
-        float reset_time = carrier_phase_ / carrier_frequency_;
-
-        float shape_inc = new_carrier_shape_ - carrier_shape_;
-        float bleed_inc = new_carrier_bleed_ - carrier_bleed_;
+        carrier_phase -= 1.0f;
+        float reset_time = carrier_phase / carrier_frequency_;
 
+        const float bleed
+            = new_carrier_bleed_ + bleed_inc * (1.0f - reset_time);
         float before = Grainlet(
             1.0f,
-            formant_phase_ + (1.0f - reset_time) * formant_frequency_,
-            new_carrier_shape_ + shape_inc * (1.0f - reset_time),
-            new_carrier_bleed_ + bleed_inc * (1.0f - reset_time));
+            formant_phase + (1.0f - reset_time) * formant_frequency_,
+            MakeShape(new_carrier_shape_ + shape_inc * (1.0f - reset_time)),
+            bleed,
+            1.0f / (1.0f + bleed));
 
-        float after
-            = Grainlet(0.0f, 0.0f, new_carrier_shape_, new_carrier_bleed_);
+        float after = Grainlet(
+            0.0f, 0.0f, new_shape_, new_carrier_bleed_, new_bleed_norm_);
 
         float discontinuity = after - before;
         this_sample += discontinuity * ThisBlepSample(reset_time);
         next_sample += discontinuity * NextBlepSample(reset_time);
-        formant_phase_ = reset_time * formant_frequency_;
+        formant_phase = reset_time * formant_frequency_;
     }
     else
     {
-        formant_phase_ += formant_frequency_;
-        if(formant_phase_ >= 1.0f)
+        formant_phase += formant_frequency_;
+        if(formant_phase >= 1.0f)
         {
-            formant_phase_ -= 1.0f;
+            formant_phase -= 1.0f;
         }
     }
 
+    next_sample += Grainlet(carrier_phase,
+                            formant_phase,
+                            new_shape_,
+                            new_carrier_bleed_,
+                            new_bleed_norm_);
+    next_out = next_sample;
+    return this_sample;
+}
+
+float GrainletOscillator::Process()
+{
+    const float out = Step(carrier_phase_,
+                           formant_phase_,
+                           next_sample_,
+                           new_carrier_shape_ - carrier_shape_,
+                           new_carrier_bleed_ - carrier_bleed_);
     carrier_bleed_ = new_carrier_bleed_;
     carrier_shape_ = new_carrier_shape_;
-    next_sample += Grainlet(
-        carrier_phase_, formant_phase_, carrier_shape_, carrier_bleed_);
-    next_sample_ = next_sample;
-    return this_sample;
+    return out;
+}
+
+void GrainletOscillator::ProcessBlock(float* out, size_t size)
+{
+    if(size == 0)
+        return;
+
+    // Only the first sample can see a parameter change.
+    out[0] = Process();
+
+    float carrier_phase = carrier_phase_;
+    float formant_phase = formant_phase_;
+    float next_sample   = next_sample_;
+    for(size_t i = 1; i < size; i++)
+    {
+        out[i] = Step(carrier_phase, formant_phase, next_sample, 0.0f, 0.0f);
+    }
+    carrier_phase_ = carrier_phase;
+    formant_phase_ = formant_phase;
+    next_sample_   = next_sample;
 }
 
 void GrainletOscillator::SetFreq(float freq)
@@ -82,20 +121,22 @@ void GrainletOscillator::SetFormantFreq(float freq)
 void GrainletOscillator::SetShape(float shape)
 {
     new_carrier_shape_ = shape;
+    new_shape_         = MakeShape(shape);
 }
 
 void GrainletOscillator::SetBleed(float bleed)
 {
     new_carrier_bleed_ = bleed;
+    new_bleed_norm_    = 1.0f / (1.0f + bleed);
 }
 
 
 float GrainletOscillator::Sine(float phase)
 {
-    return sinf(phase * TWOPI_F);
+    return FastSin::Sin(phase);
 }
 
-float GrainletOscillator::Carrier(float phase, float shape)
+GrainletOscillator::CarrierShape GrainletOscillator::MakeShape(float shape)
 {
     shape *= 3.0f;
     int   shape_integral   = static_cast<int>(shape);
@@ -103,44 +144,66 @@ float GrainletOscillator::Carrier(float phase, float shape)
 
     float t = 1.0f - shape_fractional;
 
+    CarrierShape c = {2, 0.0f, 0.0f, 0.0f};
     if(shape_integral == 0)
     {
-        phase = phase * (1.0f + t * t * t * 15.0f);
+        c.segment = 0;
+        c.scale   = 1.0f + t * t * t * 15.0f;
+    }
+    else if(shape_integral == 1)
+    {
+        c.segment    = 1;
+        c.breakpoint = 0.001f + 0.499f * t * t * t;
+        c.scale      = 0.5f / c.breakpoint;
+        c.scale_hi   = 0.5f / (1.0f - c.breakpoint);
+    }
+    else
+    {
+        t       = 1.0f - t;
+        c.scale = 0.5f + t * t * t * 14.5f;
+    }
+    return c;
+}
+
+float GrainletOscillator::Carrier(float phase, const CarrierShape& shape)
+{
+    if(shape.segment == 0)
+    {
+        phase = phase * shape.scale;
         if(phase >= 1.0f)
         {
             phase = 1.0f;
         }
         phase += 0.75f;
     }
-    else if(shape_integral == 1)
+    else if(shape.segment == 1)
     {
-        float breakpoint = 0.001f + 0.499f * t * t * t;
-        if(phase < breakpoint)
+        if(phase < shape.breakpoint)
         {
-            phase *= (0.5f / breakpoint);
+            phase *= shape.scale;
         }
         else
         {
-            phase = 0.5f + (phase - breakpoint) * 0.5f / (1.0f - breakpoint);
+            phase = 0.5f + (phase - shape.breakpoint) * shape.scale_hi;
         }
         phase += 0.75f;
     }
     else
     {
-        t     = 1.0f - t;
-        phase = 0.25f + phase * (0.5f + t * t * t * 14.5f);
+        phase = 0.25f + phase * shape.scale;
         if(phase >= 0.75f)
             phase = 0.75f;
     }
     return (Sine(phase) + 1.0f) * 0.25f;
 }
 
-float GrainletOscillator::Grainlet(float carrier_phase,
-                                   float formant_phase,
-                                   float shape,
-                                   float bleed)
+float GrainletOscillator::Grainlet(float               carrier_phase,
+                                   float               formant_phase,
+                                   const CarrierShape& shape,
+                                   float               bleed,
+                                   float               bleed_norm)
 {
     float carrier = Carrier(carrier_phase, shape);
     float formant = Sine(formant_phase);
-    return carrier * (formant + bleed) / (1.0f + bleed);
+    return carrier * (formant + bleed) * bleed_norm;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define DSY_GRAINLET_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file grainlet.h */
@@ -22,6 +23,8 @@ namespace daisysp
 class GrainletOscillator
 {
   public:
+    static const size_t kStateBytes;
+
     GrainletOscillator() {}
     ~GrainletOscillator() {}
 
@@ -33,6 +36,12 @@ class GrainletOscillator
     /** Get the next sample */
     float Process();
 
+    /** Fills out with size samples, the same as Process() for each.
+        \param out Output buffer
+        \param size Number of samples
+    */
+    void ProcessBlock(float* out, size_t size);
+
     /** Sets the carrier frequency
         \param freq Frequency in Hz
     */
@@ -54,14 +63,34 @@ class GrainletOscillator
     void SetBleed(float bleed);
 
   private:
+    /** Phase distortion of one shape setting, worked out once per
+        SetShape() rather than per sample.
+    */
+    struct CarrierShape
+    {
+        int   segment; /**< 0, 1 or 2: which of the three shapes */
+        float scale;
+        float breakpoint;
+        float scale_hi; /**< segment 1, above the breakpoint */
+    };
+
+    static CarrierShape MakeShape(float shape);
+
     float Sine(float phase);
 
-    float Carrier(float phase, float shape);
+    float Carrier(float phase, const CarrierShape& shape);
+
+    float Grainlet(float               carrier_phase,
+                   float               formant_phase,
+                   const CarrierShape& shape,
+                   float               bleed,
+                   float               bleed_norm);
 
-    float Grainlet(float carrier_phase,
-                   float formant_phase,
-                   float shape,
-                   float bleed);
+    float Step(float& carrier_phase,
+               float& formant_phase,
+               float& next_out,
+               float  shape_inc,
+               float  bleed_inc);
 
     // Oscillator state.
     float carrier_phase_;
@@ -77,8 +106,14 @@ class GrainletOscillator
     float new_carrier_shape_;
     float new_carrier_bleed_;
 
+    CarrierShape new_shape_;
+    float        new_bleed_norm_; /**< 1 / (1 + new_carrier_bleed_) */
+
     float sample_rate_;
 };
+
+inline constexpr size_t GrainletOscillator::kStateBytes
+    = sizeof(GrainletOscillator);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include <math.h>
+#include "dsp.h"
+#include "granulator.h"
+
+using namespace daisysp;
+
+constexpr std::array<float, Granulator::kWindowSize + 1>
+    Granulator::windows_[Granulator::kNumWindows]
+    = {MakeWindow(Window::HANN),
+       MakeWindow(Window::TRIANGLE),
+       MakeWindow(Window::TUKEY)};
+
+void Granulator::Init(float sample_rate, float* mem, size_t size)
+{
+    sample_rate_ = sample_rate;
+    buf_         = mem;
+    size_        = size;
+    write_       = 0;
+    recorded_    = 0;
+    record_      = true;
+
+    num_         = 0;
+    max_grains_  = kMaxGrains;
+    limit_       = kMaxGrains;
+    load_target_ = .8f;
+    rng_.Init();
+
+    next_onset_ = 0.f;
+    interval_   = 0.f;
+    len_        = 2.f;
+    ratio_      = 1.f;
+    position_   = .1f;
+    spread_     = 0.f;
+    window_     = windows_[0].data();
+    SetGrainSize(80.f);
+    SetDensity(20.f);
+}
+
+float Granulator::Process(float in)
+{
+    float out;
+    ProcessBlock(&in, &out, 1);
+    return out;
+}
+
+void Granulator::ProcessBlock(const float* in, float* out, size_t size)
+{
+    for(size_t pos = 0; pos < size; pos += kMaxBlock)
+    {
+        const size_t n = size - pos < kMaxBlock ? size - pos : kMaxBlock;
+        Render(in + pos, out + pos, n);
+    }
+}
+
+void Granulator::Render(const float* in, float* out, size_t size)
+{
+    const size_t head = write_;
+    if(record_)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            buf_[write_] = in[i];
+            write_       = write_ + 1 < size_ ? write_ + 1 : 0;
+        }
+        recorded_ = recorded_ + size < size_ ? recorded_ + size : size_;
+    }
+
+    // The input has been taken, out may now be overwritten.
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = 0.f;
+    }
+
+    if(interval_ > 0.f)
+    {
+        const float end = static_cast<float>(size);
+        while(next_onset_ < end)
+        {
+            const size_t offset = next_onset_ > 0.f
+                                      ? static_cast<size_t>(next_onset_)
+                                      : 0;
+            Spawn(head, offset, size);
+            next_onset_
+                += interval_ * (1.f + .5f * spread_ * rng_.NextBipolar());
+        }
+        next_onset_ -= end;
+    }
+
+    size_t g = 0;
+    while(g < num_)
+    {
+        if(RenderGrain(g, out, size))
+        {
+            // Done: the last grain takes its slot, still to render.
+            const size_t last = --num_;
+            idx_[g]    = idx_[last];
+            frac_[g]   = frac_[last];
+            inc_[g]    = inc_[last];
+            phase_[g]  = phase_[last];
+            dphase_[g] = dphase_[last];
+            left_[g]   = left_[last];
+            start_[g]  = start_[last];
+            amp_[g]    = amp_[last];
+            win_[g]    = win_[last];
+        }
+        else
+        {
+            g++;
+        }
+    }
+}
+
+void Granulator::Spawn(size_t head, size_t offset, size_t size)
+{
+    if(num_ >= limit_)
+        return;
+
+    // A grain is len_ samples reading ratio_ * len_ of the recording.
+    // Delays are from the write position at its onset; recording, that
+    // keeps moving, so the read must neither pass it nor fall behind
+    // what it overwrites.
+    if(size_ <= kGuard)
+        return;
+    const float span = ratio_ * len_;
+    float       lo, hi, avail;
+    size_t      at = head;
+    if(record_)
+    {
+        at    = at + offset < size_ ? at + offset : at + offset - size_;
+        avail = static_cast<float>(recorded_ - (size - offset));
+        if(recorded_ + kGuard > size_)
+            avail = static_cast<float>(size_ - kGuard);
+        lo = fmaxf(span - len_, 0.f) + 2.f;
+        hi = avail - fmaxf(len_ - span, 0.f);
+    }
+    else
+    {
+        avail = static_cast<float>(recorded_);
+        lo    = span + 2.f;
+        hi    = avail;
+    }
+    if(hi < lo)
+        return; // not enough recorded yet
+
+    const float p
+        = fclamp(position_ + spread_ * rng_.NextBipolar(), 0.f, 1.f);
+    const size_t   delay = static_cast<size_t>(lo + (hi - lo) * p);
+    const uint32_t len   = static_cast<uint32_t>(len_);
+
+    const size_t g = num_++;
+    idx_[g]
+        = static_cast<uint32_t>(at >= delay ? at - delay : at + size_ - delay);
+    frac_[g]   = 0.f;
+    inc_[g]    = ratio_;
+    phase_[g]  = 0;
+    dphase_[g] = static_cast<uint32_t>(4294967296.f / static_cast<float>(len));
+    left_[g]   = len;
+    start_[g]  = static_cast<uint32_t>(offset);
+    amp_[g]    = gain_;
+    win_[g]    = window_;
+}
+
+bool Granulator::RenderGrain(size_t g, float* out, size_t size)
+{
+    const size_t   start = start_[g];
+    const size_t   n     = size - start < left_[g] ? size - start : left_[g];
+    const float*   buf   = buf_;
+    const float*   win   = win_[g];
+    const size_t   wrap  = size_;
+    const float    inc   = inc_[g];
+    const uint32_t dph   = dphase_[g];
+    const float    gain  = amp_[g];
+    size_t         idx   = idx_[g];
+    float          frac  = frac_[g];
+    uint32_t       ph    = phase_[g];
+
+    float* o = out + start;
+    for(size_t i = 0; i < n; i++)
+    {
+        const size_t next = idx + 1 < wrap ? idx + 1 : 0;
+        const float  a    = buf[idx];
+        const float  s    = a + (buf[next] - a) * frac;
+
+        const uint32_t wi = ph >> kFracBits;
+        const float    wf = static_cast<float>(ph & kFracMask) * kFracScale;
+        const float    w  = win[wi] + (win[wi + 1] - win[wi]) * wf;
+        o[i] += s * w * gain;
+
+        ph += dph;
+        frac += inc;
+        const size_t whole = static_cast<size_t>(frac);
+        frac -= static_cast<float>(whole);
+        idx += whole;
+        idx = idx < wrap ? idx : idx - wrap;
+    }
+
+    idx_[g]   = static_cast<uint32_t>(idx);
+    frac_[g]  = frac;
+    phase_[g] = ph;
+    start_[g] = 0;
+    left_[g] -= static_cast<uint32_t>(n);
+    return left_[g] == 0;
+}
+
+void Granulator::SetDensity(float density)
+{
+    interval_ = density > 0.f ? fmaxf(sample_rate_ / density, 1.f) : 0.f;
+    UpdateGain();
+}
+
+void Granulator::SetGrainSize(float ms)
+{
+    ms   = fclamp(ms, 1.f, 1000.f);
+    len_ = fmaxf(ms * .001f * sample_rate_, 2.f);
+    UpdateGain();
+}
+
+void Granulator::SetPitch(float semitones)
+{
+    ratio_ = powf(2.f, fclamp(semitones, -24.f, 24.f) / 12.f);
+}
+
+void Granulator::SetWindow(Window window)
+{
+    const size_t w = static_cast<size_t>(window);
+    window_        = windows_[w < kNumWindows ? w : 0].data();
+}
+
+void Granulator::SetMaxGrains(size_t max)
+{
+    max_grains_ = max < 1 ? 1 : (max > kMaxGrains ? kMaxGrains : max);
+    limit_      = limit_ < max_grains_ ? limit_ : max_grains_;
+}
+
+void Granulator::SetLoad(float load)
+{
+    if(load > load_target_)
+    {
+        // Back off by an eighth, at least one grain, never below one.
+        const size_t step = (limit_ + 7) / 8;
+        limit_            = limit_ > step ? limit_ - step : 1;
+    }
+    else if(load < load_target_ - .1f && limit_ < max_grains_)
+    {
+        limit_++;
+    }
+}
+
+void Granulator::UpdateGain()
+{
+    // Overlapping grains add up roughly as their power does.
+    const float overlap = interval_ > 0.f ? len_ / interval_ : 1.f;
+    gain_               = 1.f / math::sqrt(fmaxf(overlap, 1.f));
+}
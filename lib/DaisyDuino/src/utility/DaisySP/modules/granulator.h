@@ -0,0 +1,189 @@
+#pragma once
+#ifndef DSY_GRANULATOR_H
+#define DSY_GRANULATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include "const_table.h"
+#include "fast_random.h"
+#ifdef __cplusplus
+
+/** @file granulator.h */
+namespace daisysp
+{
+/** @brief Granular sampler over a live recording.
+
+    Input is written into a ring of caller memory, e.g. DSY_SDRAM_BSS,
+    taken the way Looper takes it: Init() does not clear it, and grains
+    only ever read what has been recorded since. Up to kMaxGrains grains
+    play at once, each a window from a lookup table over a stretch of the
+    recording, resampled by the pitch ratio. SetRecord(false) freezes the
+    ring and the grains keep playing from it.
+
+    Onsets are scheduled per block: ProcessBlock() writes the input,
+    starts the grains falling inside the block at their sample offsets,
+    then renders one grain at a time over the whole block. Grain state
+    lives in parallel arrays with the sounding grains packed at the
+    front, so the loop walks only those.
+
+    SetLoad() takes the audio CPU load, e.g.
+    DAISY.CpuLoad().GetAvgCpuLoad(), once per block. Above the target it
+    trims how many grains may sound at once, then lets the limit grow
+    back one grain per call while the load is well below it. Sounding
+    grains are never cut; onsets are skipped while at the limit.
+
+    Blocks of up to kMaxBlock frames; longer ones are split.
+*/
+class Granulator
+{
+  public:
+    static const size_t kStateBytes;
+
+    Granulator() {}
+    ~Granulator() {}
+
+    static constexpr size_t kMaxGrains = 64;
+    static constexpr size_t kMaxBlock  = 1024;
+
+    /** Grain envelope, each a lookup table shared by all instances */
+    enum class Window
+    {
+        HANN,     /**< raised cosine, smooth */
+        TRIANGLE, /**< linear in and out */
+        TUKEY,    /**< cosine edges over a quarter each, flat middle */
+    };
+
+    /** Initializes the granulator, recording.
+        \param sample_rate Audio engine sample rate
+        \param mem Recording memory, not cleared
+        \param size Floats at mem; the longest history is a bit less
+    */
+    void Init(float sample_rate, float* mem, size_t size);
+
+    /** Get the next sample
+        \param in Sample to record
+    */
+    float Process(float in);
+
+    /** Records a block and renders the grains over it.
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size);
+
+    /** Writing the input on or off
+        \param record false freezes the recording
+    */
+    inline void SetRecord(bool record) { record_ = record; }
+
+    /** Grain onsets per second
+        \param density 0 stops starting new grains
+    */
+    void SetDensity(float density);
+
+    /** Grain length
+        \param ms 1 to 1000 ms
+    */
+    void SetGrainSize(float ms);
+
+    /** Where in the recording grains start
+        \param position 0 newest to 1 oldest
+    */
+    inline void SetPosition(float position) { position_ = position; }
+
+    /** Randomizes each grain's position and onset time
+        \param spread 0 none to 1, the whole recording
+    */
+    inline void SetSpread(float spread) { spread_ = spread; }
+
+    /** Grain playback pitch
+        \param semitones -24 to 24; 0 plays at the recorded speed
+    */
+    void SetPitch(float semitones);
+
+    /** Envelope for the grains started from now on */
+    void SetWindow(Window window);
+
+    /** Hard limit on simultaneous grains
+        \param max 1 to kMaxGrains
+    */
+    void SetMaxGrains(size_t max);
+
+    /** Adapts the grain limit to the audio CPU load; once per block.
+        \param load Load as a fraction of the block period
+    */
+    void SetLoad(float load);
+
+    /** Load SetLoad() keeps below, .8 by default */
+    inline void SetLoadTarget(float target) { load_target_ = target; }
+
+    /** \return grains sounding after the last block */
+    inline size_t GetActiveGrains() const { return num_; }
+
+    /** \return grains allowed at once, after SetLoad() */
+    inline size_t GetGrainLimit() const { return limit_; }
+
+  private:
+    static constexpr size_t   kWindowBits = 9;
+    static constexpr size_t   kWindowSize = 1u << kWindowBits;
+    static constexpr uint32_t kFracBits   = 32 - kWindowBits;
+    static constexpr uint32_t kFracMask   = (1u << kFracBits) - 1u;
+    static constexpr float    kFracScale
+        = 1.0f / static_cast<float>(1u << kFracBits);
+    static constexpr size_t kNumWindows = 3;
+    /** Writes up to a block ahead of a grain's read never reach it */
+    static constexpr size_t kGuard = kMaxBlock + 2;
+
+    /** One window, kWindowSize + 1 points over [0, 1]. constexpr:
+        the tables are computed by the compiler into flash.
+    */
+    static constexpr std::array<float, kWindowSize + 1>
+    MakeWindow(Window window)
+    {
+        return ConstTable::Make<kWindowSize + 1>([window](size_t i) {
+            const double x = static_cast<double>(i) / kWindowSize;
+            return window == Window::HANN       ? ConstTable::Hann(x)
+                   : window == Window::TRIANGLE ? ConstTable::Triangle(x)
+                                                : ConstTable::Tukey(x, 0.25);
+        });
+    }
+
+    void Render(const float* in, float* out, size_t size);
+    void Spawn(size_t head, size_t offset, size_t size);
+    bool RenderGrain(size_t g, float* out, size_t size);
+    void UpdateGain();
+
+    static const std::array<float, kWindowSize + 1> windows_[kNumWindows];
+
+    float* buf_;
+    size_t size_, write_, recorded_;
+    bool   record_;
+
+    float        sample_rate_;
+    float        interval_, next_onset_;
+    float        len_, ratio_, position_, spread_, gain_;
+    const float* window_;
+
+    size_t num_, limit_, max_grains_;
+    float  load_target_;
+
+    FastRandom rng_;
+
+    // Grain state, one entry per grain, [0, num_) sounding.
+    uint32_t     idx_[kMaxGrains];   /**< read index into buf_ */
+    float        frac_[kMaxGrains];  /**< read fraction */
+    float        inc_[kMaxGrains];   /**< read step, the pitch ratio */
+    uint32_t     phase_[kMaxGrains]; /**< window phase, 32-bit */
+    uint32_t     dphase_[kMaxGrains];
+    uint32_t     left_[kMaxGrains];  /**< samples still to play */
+    uint32_t     start_[kMaxGrains]; /**< onset within the next block */
+    float        amp_[kMaxGrains];   /**< gain set at the onset */
+    const float* win_[kMaxGrains];
+};
+
+inline constexpr size_t Granulator::kStateBytes = sizeof(Granulator);
+} // namespace daisysp
+#endif
+#endif
@@ -0,0 +1,240 @@
+#pragma once
+#ifndef DSY_HALFBAND_H
+#define DSY_HALFBAND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "fir.h"
+#include "const_table.h"
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** Kaiser-windowed half-band lowpass, split into its two polyphase
+    branches.
+
+    A half-band kernel of length 4M - 1 has its centre tap at 0.5 and
+    every other tap on either side exactly zero. One polyphase branch is
+    therefore a pure delay and only the other, with 2M taps, needs a
+    FIR. That makes the 2x resamplers below cost 2M MACs per low-rate
+    sample, about half of a direct-form half-band.
+
+    Not intended to be used directly; see Upsampler2x and Downsampler2x.
+*/
+template <size_t num_taps>
+struct HalfbandDesign
+{
+    static_assert((num_taps & 3) == 3,
+                  "half-band length must be 4M - 1 (7, 11, 15, ...)");
+
+    /** Taps in the FIR branch. */
+    static constexpr size_t kBranchTaps = (num_taps + 1) / 2;
+    /** Centre tap index, also the group delay at the high rate. */
+    static constexpr size_t kCenter = (num_taps - 1) / 2;
+
+    /** Writes the non-zero (even index) taps, scaled so that the full
+        kernel has unity DC gain, times gain.
+        Uses double-precision libm; setup-time only.
+        \param branch - receives kBranchTaps coefficients
+        \param beta - Kaiser window shape, ~8 gives around 80 dB stopband
+        \param gain - extra scale, 2 for interpolation
+    */
+    static void Compute(float* branch, float beta, float gain)
+    {
+        const double pi = 3.14159265358979323846;
+        double       tmp[kBranchTaps];
+        double       sum = 0.0;
+        for(size_t j = 0; j < kBranchTaps; j++)
+        {
+            const double k = static_cast<double>(2 * j);
+            const double t = k - static_cast<double>(kCenter); // odd
+            const double x = k / static_cast<double>(num_taps - 1);
+            const double w = ConstTable::Kaiser(x, static_cast<double>(beta));
+            tmp[j]         = sin(0.5 * pi * t) / (pi * t) * w;
+            sum += tmp[j];
+        }
+        // The even taps of a unity-gain half-band sum to 0.5; the centre
+        // tap supplies the other half.
+        const double scale = 0.5 * static_cast<double>(gain) / sum;
+        for(size_t j = 0; j < kBranchTaps; j++)
+        {
+            branch[j] = static_cast<float>(tmp[j] * scale);
+        }
+    }
+};
+
+/** 2x polyphase interpolator built on FIR (CMSIS arm_fir_f32 on ARM).
+
+    For every input sample x[n] it produces
+      out[2n]     = sum_j g[j] x[n - j]      (FIR branch)
+      out[2n + 1] = x[n - (M - 1)]           (delay branch)
+    with g the even taps of the half-band kernel times two.
+
+    \param num_taps - half-band length, 4M - 1
+    \param max_block - largest input block passed to ProcessBlock()
+
+    declaration example:
+
+    Upsampler2x<23, 512> up; // 96 kHz -> 192 kHz
+*/
+template <size_t num_taps, size_t max_block>
+class Upsampler2x
+{
+  public:
+    static const size_t kStateBytes;
+
+    Upsampler2x() {}
+    ~Upsampler2x() {}
+
+    /** Designs the filter and clears the state. Setup-time only.
+        \param beta - Kaiser window shape
+    */
+    void Init(float beta = 8.0f)
+    {
+        float branch[Kernel::kBranchTaps];
+        Kernel::Compute(branch, beta, 2.0f);
+        fir_.Init(branch, Kernel::kBranchTaps, false);
+        Reset();
+    }
+
+    /** Clears the FIR and delay branch state. */
+    void Reset()
+    {
+        fir_.Reset();
+        for(size_t i = 0; i < kDelay + max_block; i++)
+        {
+            delay_[i] = 0.0f;
+        }
+    }
+
+    /** Group delay in high-rate samples. */
+    static constexpr size_t GetLatency() { return Kernel::kCenter; }
+
+    /** Interpolates a block.
+        \param in - size input samples
+        \param out - receives 2 * size samples, must not alias in
+        \param size - input samples, up to max_block
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        // Both branches read the same input; the delay line doubles as
+        // the (non-const) FIR source CMSIS wants.
+        float* x = &delay_[kDelay];
+        for(size_t n = 0; n < size; n++)
+        {
+            x[n] = in[n];
+        }
+        fir_.ProcessBlock(x, even_, size);
+        for(size_t n = 0; n < size; n++)
+        {
+            out[2 * n]     = even_[n];
+            out[2 * n + 1] = delay_[n];
+        }
+        for(size_t i = 0; i < kDelay; i++)
+        {
+            delay_[i] = delay_[size + i];
+        }
+    }
+
+  private:
+    using Kernel                  = HalfbandDesign<num_taps>;
+    static constexpr size_t kDelay = (num_taps + 1) / 4 - 1;
+
+    FIR<Kernel::kBranchTaps, max_block> fir_;
+    float                               delay_[kDelay + max_block];
+    float                               even_[max_block];
+};
+
+template <size_t num_taps, size_t max_block>
+constexpr size_t Upsampler2x<num_taps, max_block>::kStateBytes
+    = sizeof(Upsampler2x<num_taps, max_block>);
+
+/** 2x polyphase decimator built on FIR (CMSIS arm_fir_f32 on ARM).
+
+    Splits the input into even and odd phases e[n] = in[2n],
+    o[n] = in[2n + 1] and computes
+      out[n] = sum_j h[j] e[n - j] + 0.5 * o[n - M]
+    with h the even taps of the half-band kernel.
+
+    \param num_taps - half-band length, 4M - 1
+    \param max_block - largest output block passed to ProcessBlock()
+
+    declaration example:
+
+    Downsampler2x<127, 512> down; // 192 kHz -> 96 kHz
+*/
+template <size_t num_taps, size_t max_block>
+class Downsampler2x
+{
+  public:
+    static const size_t kStateBytes;
+
+    Downsampler2x() {}
+    ~Downsampler2x() {}
+
+    /** Designs the filter and clears the state. Setup-time only.
+        \param beta - Kaiser window shape
+    */
+    void Init(float beta = 8.0f)
+    {
+        float branch[Kernel::kBranchTaps];
+        Kernel::Compute(branch, beta, 1.0f);
+        fir_.Init(branch, Kernel::kBranchTaps, false);
+        Reset();
+    }
+
+    /** Clears the FIR and delay branch state. */
+    void Reset()
+    {
+        fir_.Reset();
+        for(size_t i = 0; i < kDelay + max_block; i++)
+        {
+            odd_[i] = 0.0f;
+        }
+    }
+
+    /** Group delay in high-rate samples. */
+    static constexpr size_t GetLatency() { return Kernel::kCenter; }
+
+    /** Decimates a block.
+        out may alias in (all input is split before any output is written).
+        \param in - 2 * size input samples
+        \param out - receives size samples
+        \param size - output samples, up to max_block
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        float* o = &odd_[kDelay];
+        for(size_t n = 0; n < size; n++)
+        {
+            even_[n] = in[2 * n];
+            o[n]     = in[2 * n + 1];
+        }
+        fir_.ProcessBlock(even_, out, size);
+        for(size_t n = 0; n < size; n++)
+        {
+            out[n] += 0.5f * odd_[n];
+        }
+        for(size_t i = 0; i < kDelay; i++)
+        {
+            odd_[i] = odd_[size + i];
+        }
+    }
+
+  private:
+    using Kernel                  = HalfbandDesign<num_taps>;
+    static constexpr size_t kDelay = (num_taps + 1) / 4;
+
+    FIR<Kernel::kBranchTaps, max_block> fir_;
+    float                               odd_[kDelay + max_block];
+    float                               even_[max_block];
+};
+
+template <size_t num_taps, size_t max_block>
+constexpr size_t Downsampler2x<num_taps, max_block>::kStateBytes
+    = sizeof(Downsampler2x<num_taps, max_block>);
+
+} // namespace daisysp
+#endif
+#endif
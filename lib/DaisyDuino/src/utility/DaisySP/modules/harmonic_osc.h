@@ -3,7 +3,9 @@
 #define DSY_HARMONIC_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "dsp.h"
+#include "fast_sin.h"
 #ifdef __cplusplus
 
 
@@ -17,6 +19,10 @@ namespace daisysp
        Harmonic Oscillator Module based on Chebyshev polynomials \n 
        Works well for a small number of harmonics. For the higher order harmonics. \n
        We need to reinitialize the recurrence by computing two high harmonics. \n \n
+       The fundamental is kept as a unit phasor rotated once per sample and \n
+       renormalised every 64 samples, so no sine is evaluated per sample; \n
+       SetFreq() computes the rotation. ProcessBlock() takes parameter \n
+       changes once per block and keeps the phasor in registers. \n \n
 	   Ported from pichenettes/eurorack/plaits/dsp/oscillator/harmonic_oscillator.h \n
 	   to an independent module. \n
 	   Original code written by Emilie Gillet in 2016. \n
@@ -25,6 +31,8 @@ template <int num_harmonics = 16>
 class HarmonicOscillator
 {
   public:
+    static const size_t kStateBytes;
+
     HarmonicOscillator() {}
     ~HarmonicOscillator() {}
 
@@ -34,7 +42,11 @@ class HarmonicOscillator
     void Init(float sample_rate)
     {
         sample_rate_ = sample_rate;
-        phase_       = 0.0f;
+        sin_         = 0.0f;
+        cos_         = 1.0f;
+        renorm_      = 0;
+        frequency_   = 0.0f;
+        FastSin::Init();
 
         for(int i = 0; i < num_harmonics; ++i)
         {
@@ -55,48 +67,41 @@ class HarmonicOscillator
     {
         if(recalc_)
         {
-            recalc_ = false;
-            for(int i = 0; i < num_harmonics; ++i)
-            {
-                float f = frequency_
-                          * static_cast<float>(first_harmonic_index_ + i);
-                if(f >= 0.5f)
-                {
-                    f = 0.5f;
-                }
-                amplitude_[i] = newamplitude_[i] * (1.0f - f * 2.0f);
-            }
+            UpdateAmplitudes();
         }
-
-        phase_ += frequency_;
-        if(phase_ >= 1.0f)
+        const float sum = Render(sin_, cos_);
+        if(++renorm_ >= kRenormInterval)
         {
-            phase_ -= 1.0f;
+            Renormalize(sin_, cos_);
+            renorm_ = 0;
         }
-        const float two_x = 2.0f * sinf(phase_ * TWOPI_F);
-        float       previous, current;
-        if(first_harmonic_index_ == 1)
-        {
-            previous = 1.0f;
-            current  = two_x * 0.5f;
-        }
-        else
+        return sum;
+    }
+
+    /** Fills out with size samples, the same as calling Process() for each.
+        \param out Output buffer
+        \param size Number of samples
+    */
+    void ProcessBlock(float* out, size_t size)
+    {
+        if(recalc_)
         {
-            const float k = first_harmonic_index_;
-            previous      = sinf((phase_ * (k - 1.0f) + 0.25f) * TWOPI_F);
-            current       = sinf((phase_ * k) * TWOPI_F);
+            UpdateAmplitudes();
         }
-
-        float sum = 0.0f;
-        for(int i = 0; i < num_harmonics; ++i)
+        float  s = sin_, c = cos_;
+        size_t n = renorm_;
+        for(size_t i = 0; i < size; i++)
         {
-            sum += amplitude_[i] * current;
-            float temp = current;
-            current    = two_x * current - previous;
-            previous   = temp;
+            out[i] = Render(s, c);
+            if(++n >= kRenormInterval)
+            {
+                Renormalize(s, c);
+                n = 0;
+            }
         }
-
-        return sum;
+        sin_    = s;
+        cos_    = c;
+        renorm_ = n;
     }
 
     /** Set the main frequency 
@@ -110,6 +115,8 @@ class HarmonicOscillator
         freq       = freq <= -.5f ? -.5f : freq;
         recalc_    = cmp(freq, frequency_) || recalc_;
         frequency_ = freq;
+        rot_sin_   = FastSin::Sin<FastSin::Tier::POLY9>(freq);
+        rot_cos_   = FastSin::Cos<FastSin::Tier::POLY9>(freq);
     }
 
     /** Offset the set of harmonics. Passing in 3 means "harmonic 0" is the 3rd harm., 1 is the 4th, etc.
@@ -150,17 +157,78 @@ class HarmonicOscillator
 
 
   private:
+    static constexpr size_t kRenormInterval = 64;
+
     bool cmp(float a, float b) { return fabsf(a - b) > .000001f; }
 
-    float sample_rate_;
-    float phase_;
-    float frequency_;
+    void UpdateAmplitudes()
+    {
+        recalc_ = false;
+        for(int i = 0; i < num_harmonics; ++i)
+        {
+            float f = frequency_ * static_cast<float>(first_harmonic_index_ + i);
+            if(f >= 0.5f)
+            {
+                f = 0.5f;
+            }
+            amplitude_[i] = newamplitude_[i] * (1.0f - f * 2.0f);
+        }
+    }
+
+    /** Advances the phasor one sample and sums the harmonics at it. */
+    inline float Render(float& s, float& c) const
+    {
+        const float ns = s * rot_cos_ + c * rot_sin_;
+        const float nc = c * rot_cos_ - s * rot_sin_;
+        s              = ns;
+        c              = nc;
+
+        // Chebyshev recurrence T(n+1) = 2x T(n) - T(n-1) on x = sin,
+        // started from T0 = 1, T1 = x and run up to the first harmonic.
+        const float two_x    = 2.0f * s;
+        float       previous = 1.0f;
+        float       current  = s;
+        for(int k = 1; k < first_harmonic_index_; ++k)
+        {
+            const float temp = current;
+            current          = two_x * current - previous;
+            previous         = temp;
+        }
+
+        float sum = 0.0f;
+        for(int i = 0; i < num_harmonics; ++i)
+        {
+            sum += amplitude_[i] * current;
+            float temp = current;
+            current    = two_x * current - previous;
+            previous   = temp;
+        }
+        return sum;
+    }
+
+    /** First order Newton step towards |(c, s)| == 1. */
+    static inline void Renormalize(float& s, float& c)
+    {
+        const float g = 1.5f - 0.5f * (s * s + c * c);
+        s *= g;
+        c *= g;
+    }
+
+    float  sample_rate_;
+    float  frequency_;
+    float  sin_, cos_;         /**< phasor of the fundamental */
+    float  rot_sin_, rot_cos_; /**< its rotation per sample */
+    size_t renorm_;
     float amplitude_[num_harmonics];
     float newamplitude_[num_harmonics];
     bool  recalc_;
 
     int first_harmonic_index_;
 };
+
+template <int num_harmonics>
+constexpr size_t HarmonicOscillator<num_harmonics>::kStateBytes
+    = sizeof(HarmonicOscillator<num_harmonics>);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -13,6 +13,13 @@ void SquareNoise::Init(float sample_rate)
 }
 
 float SquareNoise::Process(float f0)
+{
+    float out;
+    ProcessBlock(f0, &out, 1);
+    return out;
+}
+
+void SquareNoise::ProcessBlock(float f0, float* out, size_t size)
 {
     const float ratios[6] = {// Nominal f0: 414 Hz
                              1.0f,
@@ -23,36 +30,35 @@ float SquareNoise::Process(float f0)
                              2.536f};
 
     uint32_t increment[6];
-    uint32_t phase[6];
     for(int i = 0; i < 6; ++i)
     {
         float f = f0 * ratios[i];
         if(f >= 0.499f)
             f = 0.499f;
         increment[i] = static_cast<uint32_t>(f * 4294967296.0f);
-        phase[i]     = phase_[i];
     }
 
-    phase[0] += increment[0];
-    phase[1] += increment[1];
-    phase[2] += increment[2];
-    phase[3] += increment[3];
-    phase[4] += increment[4];
-    phase[5] += increment[5];
-    uint32_t noise = 0;
-    noise += (phase[0] >> 31);
-    noise += (phase[1] >> 31);
-    noise += (phase[2] >> 31);
-    noise += (phase[3] >> 31);
-    noise += (phase[4] >> 31);
-    noise += (phase[5] >> 31);
-
-    for(int i = 0; i < 6; ++i)
+    uint32_t p0 = phase_[0], p1 = phase_[1], p2 = phase_[2];
+    uint32_t p3 = phase_[3], p4 = phase_[4], p5 = phase_[5];
+    for(size_t i = 0; i < size; i++)
     {
-        phase_[i] = phase[i];
+        p0 += increment[0];
+        p1 += increment[1];
+        p2 += increment[2];
+        p3 += increment[3];
+        p4 += increment[4];
+        p5 += increment[5];
+        // Each square is the top bit of its phase.
+        const uint32_t noise = (p0 >> 31) + (p1 >> 31) + (p2 >> 31)
+                               + (p3 >> 31) + (p4 >> 31) + (p5 >> 31);
+        out[i] = 0.33f * static_cast<float>(noise) - 1.0f;
     }
-
-    return 0.33f * static_cast<float>(noise) - 1.0f;
+    phase_[0] = p0;
+    phase_[1] = p1;
+    phase_[2] = p2;
+    phase_[3] = p3;
+    phase_[4] = p4;
+    phase_[5] = p5;
 }
 
 void RingModNoise::Init(float sample_rate)
@@ -82,6 +88,14 @@ float RingModNoise::Process(float f0)
     return out;
 }
 
+void RingModNoise::ProcessBlock(float f0, float* out, size_t size)
+{
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = Process(f0);
+    }
+}
+
 float RingModNoise::ProcessPair(Oscillator* osc, float f1, float f2)
 {
     osc[0].SetWaveform(Oscillator::WAVE_SQUARE);
@@ -4,9 +4,11 @@
 
 #include "svf.h"
 #include "oscillator.h"
+#include "fast_random.h"
+#include "semitones.h"
+#include "pending_trigger.h"
 
 #include <stdint.h>
-#include <stdlib.h>
 #ifdef __cplusplus
 
 /** @file hihat.h */
@@ -20,10 +22,16 @@ namespace daisysp
 	   Ported from pichenettes/eurorack/plaits/dsp/drums/hihat.h \n
 	   to an independent module. \n
 	   Original code written by Emilie Gillet in 2016. \n
+
+    The oscillators are 32-bit phase accumulators, each square its
+    phase's top bit, so the bank is six adds and shifts a sample with no
+    branches; ProcessBlock() works out the increments once per block.
 */
 class SquareNoise
 {
   public:
+    static const size_t kStateBytes;
+
     SquareNoise() {}
     ~SquareNoise() {}
 
@@ -31,10 +39,18 @@ class SquareNoise
 
     float Process(float f0);
 
+    /** Processes a block at a fixed f0, the same as Process() on each
+        sample.
+        \param f0 Frequency in cycles per sample
+    */
+    void ProcessBlock(float f0, float* out, size_t size);
+
   private:
     uint32_t phase_[6];
 };
 
+inline constexpr size_t SquareNoise::kStateBytes = sizeof(SquareNoise);
+
 /**  
        @brief Ring mod style metallic noise generator.
 	   @author Ben Sergentanis
@@ -46,6 +62,8 @@ class SquareNoise
 class RingModNoise
 {
   public:
+    static const size_t kStateBytes;
+
     RingModNoise() {}
     ~RingModNoise() {}
 
@@ -53,6 +71,11 @@ class RingModNoise
 
     float Process(float f0);
 
+    /** Processes a block at a fixed f0, the same as Process() on each
+        sample.
+    */
+    void ProcessBlock(float f0, float* out, size_t size);
+
   private:
     float      ProcessPair(Oscillator* osc, float f1, float f2);
     Oscillator oscillator_[6];
@@ -60,6 +83,8 @@ class RingModNoise
     float sample_rate_;
 };
 
+inline constexpr size_t RingModNoise::kStateBytes = sizeof(RingModNoise);
+
 /**  
        @brief Swing type VCA
 	   @author Ben Sergentanis
@@ -71,6 +96,8 @@ class RingModNoise
 class SwingVCA
 {
   public:
+    static const size_t kStateBytes;
+
     float operator()(float s, float gain)
     {
         s *= s > 0.0f ? 10.0f : 0.1f;
@@ -79,6 +106,8 @@ class SwingVCA
     }
 };
 
+inline constexpr size_t SwingVCA::kStateBytes = sizeof(SwingVCA);
+
 /**  
        @brief Linear type VCA
 	   @author Ben Sergentanis
@@ -90,18 +119,28 @@ class SwingVCA
 class LinearVCA
 {
   public:
+    static const size_t kStateBytes;
+
     float operator()(float s, float gain) { return s * gain; }
 };
 
+inline constexpr size_t LinearVCA::kStateBytes = sizeof(LinearVCA);
+
 /**  
        @brief 808 HH, with a few extra parameters to push things to the CY territory...
 	   @author Ben Sergentanis
 	   @date Jan 2021
 	   The template parameter MetallicNoiseSource allows another kind of "metallic \n
-	   noise" to be used, for results which are more similar to KR-55 or FM hi-hats. \n \n 
+	   noise" to be used, for results which are more similar to KR-55 or FM hi-hats. \n
+	   It needs Init(sample_rate), Process(f0) and ProcessBlock(f0, out, size), \n
+	   f0 in cycles per sample, as SquareNoise and RingModNoise have. \n \n
 	   Ported from pichenettes/eurorack/plaits/dsp/drums/hihat.h \n
 	   to an independent module. \n
 	   Original code written by Emilie Gillet in 2016. \n
+
+    The filters' and envelope's coefficients are worked out when a
+    setting changes, and ProcessBlock() runs each stage, the noise, the
+    band-pass, the VCA and the high-pass, over the whole block in turn.
 */
 template <typename MetallicNoiseSource = SquareNoise,
           typename VCA                 = LinearVCA,
@@ -109,6 +148,8 @@ template <typename MetallicNoiseSource = SquareNoise,
 class HiHat
 {
   public:
+    static const size_t kStateBytes;
+
     HiHat() {}
     ~HiHat() {}
 
@@ -120,11 +161,21 @@ class HiHat
         sample_rate_ = sample_rate;
 
         trig_ = false;
+        trig_at_.Init();
 
         envelope_     = 0.0f;
         noise_clock_  = 0.0f;
         noise_sample_ = 0.0f;
-        sustain_gain_ = 0.0f;
+
+        metallic_noise_.Init(sample_rate_);
+        noise_coloration_svf_.Init(sample_rate_);
+        hpf_.Init(sample_rate_);
+        hpf_.SetRes(.5f);
+        rng_.Init();
+
+        // Out of range, so each setter below goes through.
+        f0_ = tone_ = noisiness_ = -1.0f;
+        decay_                   = -10.0f;
 
         SetFreq(3000.f);
         SetTone(.5f);
@@ -132,75 +183,45 @@ class HiHat
         SetNoisiness(.8f);
         SetAccent(.8f);
         SetSustain(false);
-
-        metallic_noise_.Init(sample_rate_);
-        noise_coloration_svf_.Init(sample_rate_);
-        hpf_.Init(sample_rate_);
     }
 
+    /** Restarts the clocked noise from a given seed, for repeatable output.
+        Call after Init().
+    */
+    void SetSeed(uint32_t seed) { rng_.Init(seed); }
+
     /** Get the next sample
 		\param trigger Hit the hihat with true. Defaults to false.
 	*/
     float Process(bool trigger = false)
     {
-        const float envelope_decay
-            = 1.0f - 0.003f * SemitonesToRatio(-decay_ * 84.0f);
-        const float cut_decay
-            = 1.0f - 0.0025f * SemitonesToRatio(-decay_ * 36.0f);
-
-        if(trigger || trig_)
-        {
-            trig_ = false;
-
-            envelope_
-                = (1.5f + 0.5f * (1.0f - decay_)) * (0.3f + 0.7f * accent_);
-        }
-
-        // Process the metallic noise.
-        float out = metallic_noise_.Process(2.0f * f0_);
-
-        // Apply BPF on the metallic noise.
-        float cutoff = 150.0f / sample_rate_ * SemitonesToRatio(tone_ * 72.0f);
-
-        cutoff = fclamp(cutoff, 0.0f, 16000.0f / sample_rate_);
-
-
-        noise_coloration_svf_.SetFreq(cutoff * sample_rate_);
-        noise_coloration_svf_.SetRes(resonance ? 3.0f + 6.0f * tone_ : 1.0f);
-
-        noise_coloration_svf_.Process(out);
-        out = noise_coloration_svf_.Band();
-
-        // This is not at all part of the 808 circuit! But to add more variety, we
-        // add a variable amount of clocked noise to the output of the 6 schmitt
-        // trigger oscillators.
-        float noise_f = f0_ * (16.0f + 16.0f * (1.0f - noisiness_));
-        noise_f       = fclamp(noise_f, 0.0f, 0.5f);
+        if(trig_at_.Advance(1) == 0 || trigger)
+            trig_ = true;
+        float out;
+        Run(&out, 1);
+        return out;
+    }
 
-        noise_clock_ += noise_f;
-        if(noise_clock_ >= 1.0f)
+    /** Processes a block, the same as Process() on each sample; a
+        Trig(offset) before the call strikes offset samples in.
+    */
+    void ProcessBlock(float* out, size_t size)
+    {
+        const size_t at = trig_at_.Advance(size);
+        Run(out, at);
+        if(at < size)
         {
-            noise_clock_ -= 1.0f;
-            noise_sample_ = rand() * kRandFrac - 0.5f;
+            trig_ = true;
+            Run(out + at, size - at);
         }
-        out += noisiness_ * (noise_sample_ - out);
-
-        // Apply VCA.
-        sustain_gain_ = accent_ * decay_;
-        VCA vca;
-        envelope_ *= envelope_ > 0.5f ? envelope_decay : cut_decay;
-        out = vca(out, sustain_ ? sustain_gain_ : envelope_);
-
-        hpf_.SetFreq(cutoff * sample_rate_);
-        hpf_.SetRes(.5f);
-        hpf_.Process(out);
-        out = hpf_.High();
-
-        return out;
     }
 
-    /** Trigger the hihat */
-    void Trig() { trig_ = true; }
+    /** Trigger the hihat
+        \param offset Samples into the next ProcessBlock() (or Process()
+               calls from now) to strike on; past the block's end it
+               carries into the next. 0, the next sample, by default.
+    */
+    void Trig(size_t offset = 0) { trig_at_.Set(offset); }
 
     /** Make the hihat ring out infinitely.
 		\param sustain True = infinite sustain.
@@ -218,22 +239,45 @@ class HiHat
     void SetFreq(float f0)
     {
         f0 /= sample_rate_;
-        f0_ = fclamp(f0, 0.f, 1.f);
+        f0 = fclamp(f0, 0.f, 1.f);
+        if(f0 != f0_)
+        {
+            f0_ = f0;
+            UpdateNoiseClock();
+        }
     }
 
     /** Set the overall brightness / darkness of the hihat.
 		\param tone Works from 0-1.
 	*/
-    void SetTone(float tone) { tone_ = fclamp(tone, 0.f, 1.f); }
+    void SetTone(float tone)
+    {
+        tone = fclamp(tone, 0.f, 1.f);
+        if(tone == tone_)
+            return;
+        tone_ = tone;
+
+        float cutoff = 150.0f / sample_rate_ * SemitonesToRatio(tone_ * 72.0f);
+        cutoff       = fclamp(cutoff, 0.0f, 16000.0f / sample_rate_);
+
+        noise_coloration_svf_.SetFreq(cutoff * sample_rate_);
+        noise_coloration_svf_.SetRes(resonance ? 3.0f + 6.0f * tone_ : 1.0f);
+        hpf_.SetFreq(cutoff * sample_rate_);
+    }
 
     /** Set the length of the hihat decay
 		\param decay Works > 0. Tuned for 0-1.
 	*/
     void SetDecay(float decay)
     {
-        decay_ = fmax(decay, 0.f);
-        decay_ *= 1.7;
-        decay_ -= 1.2;
+        decay = fmax(decay, 0.f);
+        decay *= 1.7f;
+        decay -= 1.2f;
+        if(decay == decay_)
+            return;
+        decay_          = decay;
+        envelope_decay_ = 1.0f - 0.003f * SemitonesToRatio(-decay_ * 84.0f);
+        cut_decay_      = 1.0f - 0.0025f * SemitonesToRatio(-decay_ * 36.0f);
     }
 
     /** Sets the mix between tone and noise
@@ -241,29 +285,99 @@ class HiHat
 	*/
     void SetNoisiness(float noisiness)
     {
-        noisiness_ = fclamp(noisiness, 0.f, 1.f);
-        noisiness_ *= noisiness_;
+        noisiness = fclamp(noisiness, 0.f, 1.f);
+        noisiness *= noisiness;
+        if(noisiness != noisiness_)
+        {
+            noisiness_ = noisiness;
+            UpdateNoiseClock();
+        }
     }
 
 
   private:
+    /** Renders size samples, striking on the first if trig_ is set */
+    void Run(float* out, size_t size)
+    {
+        if(size == 0)
+            return;
+
+        if(trig_)
+        {
+            trig_ = false;
+
+            envelope_
+                = (1.5f + 0.5f * (1.0f - decay_)) * (0.3f + 0.7f * accent_);
+        }
+
+        // Process the metallic noise, and apply BPF on it.
+        metallic_noise_.ProcessBlock(2.0f * f0_, out, size);
+        noise_coloration_svf_.ProcessBlock(
+            out, nullptr, nullptr, out, nullptr, nullptr, size);
+
+        // This is not at all part of the 808 circuit! But to add more variety, we
+        // add a variable amount of clocked noise to the output of the 6 schmitt
+        // trigger oscillators.
+        const float noise_f      = noise_f_;
+        const float noisiness    = noisiness_;
+        const float sustain_gain = accent_ * decay_;
+        float       noise_clock  = noise_clock_;
+        float       noise_sample = noise_sample_;
+        float       envelope     = envelope_;
+        VCA         vca;
+        for(size_t i = 0; i < size; i++)
+        {
+            float s = out[i];
+            noise_clock += noise_f;
+            if(noise_clock >= 1.0f)
+            {
+                noise_clock -= 1.0f;
+                noise_sample = rng_.NextFloat() - 0.5f;
+            }
+            s += noisiness * (noise_sample - s);
+
+            // Apply VCA.
+            envelope *= envelope > 0.5f ? envelope_decay_ : cut_decay_;
+            out[i] = vca(s, sustain_ ? sustain_gain : envelope);
+        }
+        noise_clock_  = noise_clock;
+        noise_sample_ = noise_sample;
+        envelope_     = envelope;
+
+        hpf_.ProcessBlock(out, nullptr, out, nullptr, nullptr, nullptr, size);
+    }
+
+    /** The clocked noise's rate, from f0_ and noisiness_ */
+    void UpdateNoiseClock()
+    {
+        noise_f_ = f0_ * (16.0f + 16.0f * (1.0f - noisiness_));
+        noise_f_ = fclamp(noise_f_, 0.0f, 0.5f);
+    }
+
     float sample_rate_;
 
     float accent_, f0_, tone_, decay_, noisiness_;
     bool  sustain_;
     bool  trig_;
+    PendingTrigger trig_at_;
 
-    float SemitonesToRatio(float in) { return powf(2.f, in * kOneTwelfth); }
+    // From the settings.
+    float envelope_decay_, cut_decay_;
+    float noise_f_;
 
     float envelope_;
     float noise_clock_;
     float noise_sample_;
-    float sustain_gain_;
 
     MetallicNoiseSource metallic_noise_;
     Svf                 noise_coloration_svf_;
     Svf                 hpf_;
+    FastRandom          rng_;
 };
+
+template <typename MetallicNoiseSource, typename VCA, bool resonance>
+constexpr size_t HiHat<MetallicNoiseSource, VCA, resonance>::kStateBytes
+    = sizeof(HiHat<MetallicNoiseSource, VCA, resonance>);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
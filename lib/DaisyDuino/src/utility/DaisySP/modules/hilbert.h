@@ -0,0 +1,288 @@
+#pragma once
+#ifndef DSY_HILBERT_H
+#define DSY_HILBERT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <array>
+#include "const_table.h"
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** Windowed FIR Hilbert transformer (type III, odd length).
+
+    Produces an in-phase output (the input delayed by the FIR's group
+    delay) and a quadrature output (the input shifted by -90 degrees),
+    for single-sideband modulation and envelope detection.
+
+    Every other tap of an ideal Hilbert kernel is zero and the kernel is
+    antisymmetric around its centre, so only (num_taps + 1) / 4 distinct
+    coefficients are stored. Each output costs one multiply per pair of
+    mirrored taps, roughly a quarter of the MACs of a direct FIR.
+
+    The delay line is stored twice back to back (double-length mirrored
+    buffer). That keeps the whole window contiguous, so the inner loop
+    has no wrap check or modulo.
+
+    declaration example:
+
+    HilbertFir<255> hilbert; // 127 samples group delay
+*/
+template <size_t num_taps>
+class HilbertFir
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(num_taps >= 3 && (num_taps & 1) == 1,
+                  "HilbertFir needs an odd number of taps");
+
+    HilbertFir() {}
+    ~HilbertFir() {}
+
+    /** Loads the Blackman-Harris windowed kernel and clears the state.
+        The kernel is computed at compile time (kKernel, in flash); this
+        copies it next to the delay line, so it follows the object into
+        DTCM or wherever it is placed.
+    */
+    void Init()
+    {
+        memcpy(coefs_, kKernel.data(), sizeof(coefs_));
+        Reset();
+    }
+
+    /** Clears the delay line, keeping the coefficients. */
+    void Reset()
+    {
+        for(size_t i = 0; i < 2 * num_taps; i++)
+        {
+            line_[i] = 0.0f;
+        }
+        write_ = 0;
+    }
+
+    /** Group delay of both outputs, in samples. */
+    static constexpr size_t GetLatency() { return kCenter; }
+
+    /** Processes one sample.
+        \param in - input sample
+        \param out_i - receives the input delayed by GetLatency()
+        \param out_q - receives the Hilbert transform, same delay
+    */
+    inline void Process(float in, float &out_i, float &out_q)
+    {
+        const float *x = Push(in);
+        out_i          = x[kCenter];
+        out_q          = Convolve(x);
+    }
+
+    /** Processes a block.
+        in may alias out_i (each input is read before its output is written).
+        \param in - input samples
+        \param out_i - in-phase (delayed) output
+        \param out_q - quadrature output
+        \param size - number of samples
+    */
+    void ProcessBlock(const float *in, float *out_i, float *out_q, size_t size)
+    {
+        for(size_t n = 0; n < size; n++)
+        {
+            const float *x = Push(in[n]);
+            out_i[n]       = x[kCenter];
+            out_q[n]       = Convolve(x);
+        }
+    }
+
+  private:
+    static constexpr size_t kCenter = (num_taps - 1) / 2;
+    static constexpr size_t kPairs  = (kCenter + 1) / 2;
+
+    static constexpr std::array<float, kPairs> kKernel
+        = ConstTable::HilbertPairs<num_taps>();
+
+    /** Writes a sample into both copies of the line and returns the
+        window start, where x[k] is the input from k samples ago. */
+    inline const float *Push(float in)
+    {
+        write_ = (write_ == 0) ? num_taps - 1 : write_ - 1;
+        line_[write_]            = in;
+        line_[write_ + num_taps] = in;
+        return &line_[write_];
+    }
+
+    /** Sum over the mirrored odd-offset tap pairs around the centre. */
+    inline float Convolve(const float *x) const
+    {
+        const float *older = x + kCenter + 1;
+        const float *newer = x + kCenter - 1;
+        float        acc   = 0.0f;
+        for(size_t p = 0; p < kPairs; p++)
+        {
+            acc += coefs_[p] * (*older - *newer);
+            older += 2;
+            newer -= 2;
+        }
+        return acc;
+    }
+
+    float  coefs_[kPairs];
+    float  line_[2 * num_taps];
+    size_t write_;
+};
+
+template <size_t num_taps>
+constexpr size_t HilbertFir<num_taps>::kStateBytes
+    = sizeof(HilbertFir<num_taps>);
+
+/** IIR Hilbert transformer (allpass phase splitter).
+
+    Two parallel chains of four second-order allpasses in z^-2,
+    y[n] = a^2 * (x[n] + y[n-2]) - x[n-2], whose outputs differ in phase
+    by 90 degrees (+/- 0.7 degrees) from 0.0007 to 0.9993 of Nyquist.
+    That is about 33 Hz to 47.9 kHz at 96 kHz.
+
+    Costs 8 multiplies per sample and adds almost no latency. The
+    trade-off against HilbertFir is that both outputs are phase-warped
+    relative to the input (only their difference is 90 degrees). That
+    does not matter for SSB or envelope detection.
+
+    Coefficients by Olli Niemitalo, "Hilbert transform by IIR allpass".
+
+    Same interface as HilbertFir, so either one can be chosen at compile
+    time.
+*/
+class HilbertIir
+{
+  public:
+    static const size_t kStateBytes;
+
+    HilbertIir() {}
+    ~HilbertIir() {}
+
+    /** Clears the state. The coefficients are fixed. */
+    void Init() { Reset(); }
+
+    /** Clears the state. */
+    void Reset()
+    {
+        for(size_t i = 0; i < kSections; i++)
+        {
+            state_i_[i] = Section();
+            state_q_[i] = Section();
+        }
+        delay_q_ = 0.0f;
+    }
+
+    /** Nominal latency. Both paths are phase-warped rather than delayed. */
+    static constexpr size_t GetLatency() { return 0; }
+
+    /** Processes one sample.
+        \param in - input sample
+        \param out_i - receives the in-phase output
+        \param out_q - receives the quadrature output (-90 degrees from out_i)
+    */
+    inline void Process(float in, float &out_i, float &out_q)
+    {
+        float i = in, q = in;
+        for(size_t s = 0; s < kSections; s++)
+        {
+            i = Tick(state_i_[s], kCoefsI[s], i);
+            q = Tick(state_q_[s], kCoefsQ[s], q);
+        }
+        out_i    = i;
+        out_q    = delay_q_;
+        delay_q_ = q;
+    }
+
+    /** Processes a block, one allpass section at a time.
+        in may alias out_i.
+        \param in - input samples
+        \param out_i - in-phase output
+        \param out_q - quadrature output
+        \param size - number of samples
+    */
+    void ProcessBlock(const float *in, float *out_i, float *out_q, size_t size)
+    {
+        // The quadrature path reads the input first, so in == out_i is safe.
+        RunChain(state_q_, kCoefsQ, in, out_q, size);
+        RunChain(state_i_, kCoefsI, in, out_i, size);
+        float d = delay_q_;
+        for(size_t n = 0; n < size; n++)
+        {
+            const float y = out_q[n];
+            out_q[n]      = d;
+            d             = y;
+        }
+        delay_q_ = d;
+    }
+
+  private:
+    static constexpr size_t kSections = 4;
+
+    struct Section
+    {
+        float x1 = 0.0f, x2 = 0.0f, y1 = 0.0f, y2 = 0.0f;
+    };
+
+    static inline float Tick(Section &st, float a2, float x)
+    {
+        const float y = a2 * (x + st.y2) - st.x2;
+        st.x2         = st.x1;
+        st.x1         = x;
+        st.y2         = st.y1;
+        st.y1         = y;
+        return y;
+    }
+
+    static void RunChain(Section      *chain,
+                         const float  *coefs,
+                         const float  *in,
+                         float        *out,
+                         size_t        size)
+    {
+        const float *src = in;
+        for(size_t s = 0; s < kSections; s++)
+        {
+            const float a2 = coefs[s];
+            float       x1 = chain[s].x1, x2 = chain[s].x2;
+            float       y1 = chain[s].y1, y2 = chain[s].y2;
+            for(size_t n = 0; n < size; n++)
+            {
+                const float x = src[n];
+                const float y = a2 * (x + y2) - x2;
+                x2            = x1;
+                x1            = x;
+                y2            = y1;
+                y1            = y;
+                out[n]        = y;
+            }
+            chain[s].x1 = x1;
+            chain[s].x2 = x2;
+            chain[s].y1 = y1;
+            chain[s].y2 = y2;
+            src         = out;
+        }
+    }
+
+    /** Squared allpass coefficients (a^2) of each path. */
+    static constexpr float kCoefsI[kSections] = {0.4021921162426f * 0.4021921162426f,
+                                                 0.8561710882420f * 0.8561710882420f,
+                                                 0.9722909545651f * 0.9722909545651f,
+                                                 0.9952884791278f * 0.9952884791278f};
+    static constexpr float kCoefsQ[kSections] = {0.6923878f * 0.6923878f,
+                                                 0.9360654322959f * 0.9360654322959f,
+                                                 0.9882295226860f * 0.9882295226860f,
+                                                 0.9987488452737f * 0.9987488452737f};
+
+    Section state_i_[kSections];
+    Section state_q_[kSections];
+    float   delay_q_; /**< one-sample delay on the quadrature path */
+};
+
+inline constexpr size_t HilbertIir::kStateBytes = sizeof(HilbertIir);
+
+} // namespace daisysp
+#endif
+#endif
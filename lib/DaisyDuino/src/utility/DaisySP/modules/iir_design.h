@@ -0,0 +1,286 @@
+#pragma once
+#ifndef DSY_IIR_DESIGN_H
+#define DSY_IIR_DESIGN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include "biquad_cascade.h"
+#include "const_table.h"
+
+namespace daisysp
+{
+/** Fixed-order IIR designs, as the normalized sections of a biquad
+    cascade.
+
+    Butterworth, Chebyshev type I and Linkwitz-Riley lowpass and highpass
+    filters of any order, for BiquadCascade, StereoBiquadCascade or
+    StereoBiquadCascadeQ31. Each conjugate pole pair of the analog
+    prototype becomes one section and an odd order adds a first-order
+    section (b2 = a2 = 0) last, through the bilinear transform prewarped
+    at the cutoff. So a 4th order Butterworth is two sections with Qs of
+    0.54 and 1.31, not two 0.707 sections: those make a Linkwitz-Riley.
+
+    The math is constexpr, in double, without libm: a design is free at
+    compile time when the rate is known, and at run time is a setup-time
+    cost only.
+
+    declaration example:
+
+    constexpr auto lp = IirDesign::Butterworth<4>(IirDesign::Response::LOWPASS, 96000.0f, 45000.0f);
+    IirDesign::Load(cascade, lp);
+*/
+class IirDesign
+{
+  public:
+    static const size_t kStateBytes;
+
+    enum class Response
+    {
+        LOWPASS,
+        HIGHPASS,
+    };
+
+    /** Sections of an order-n Butterworth or Chebyshev design */
+    template <size_t order>
+    using Sections = std::array<BiquadSection, (order + 1) / 2>;
+
+    /** Maximally flat, -3 dB at fc.
+        \param fs - sample rate in Hz
+        \param fc - cutoff in Hz, below fs / 2
+    */
+    template <size_t order>
+    static constexpr Sections<order>
+    Butterworth(Response response, float fs, float fc)
+    {
+        return Design<order>(response, fs, fc, 1.0, 1.0, 1.0);
+    }
+
+    /** Equiripple passband of ripple_db (> 0) up to fc, then a steeper
+        edge than Butterworth of the same order. The passband peaks at
+        0 dB; even orders start at -ripple_db at DC (or Nyquist for a
+        highpass).
+    */
+    template <size_t order>
+    static constexpr Sections<order>
+    Chebyshev(Response response, float fs, float fc, float ripple_db)
+    {
+        const double eps = ConstTable::Sqrt(
+            ConstTable::Exp((double)ripple_db * (kLn10 / 10.0)) - 1.0);
+        const double mu   = Asinh(1.0 / eps) / (double)order;
+        const double gain
+            = (order % 2) ? 1.0 : 1.0 / ConstTable::Sqrt(1.0 + eps * eps);
+        return Design<order>(response, fs, fc, Sinh(mu), Cosh(mu), gain);
+    }
+
+    /** A Butterworth of half the order, squared: -6 dB at fc, and the
+        lowpass and highpass of one order sum flat for a crossover. LR2's
+        highpass then needs its polarity inverted; LR4 and LR8 sum as is.
+    */
+    template <size_t order>
+    static constexpr std::array<BiquadSection, order / 2>
+    LinkwitzRiley(Response response, float fs, float fc)
+    {
+        static_assert(order >= 2 && order % 2 == 0,
+                      "Linkwitz-Riley orders are even");
+        constexpr size_t half = order / 2;
+        const auto       bw   = Butterworth<half>(response, fs, fc);
+
+        std::array<BiquadSection, order / 2> out{};
+        size_t                               n = 0;
+        for(size_t k = 0; k < half / 2; k++)
+        {
+            out[n++] = bw[k];
+            out[n++] = bw[k];
+        }
+        if(half % 2)
+        {
+            // Two identical first-order sections in one biquad.
+            const BiquadSection& f = bw[half / 2];
+            BiquadSection        s{};
+            s.b0     = f.b0 * f.b0;
+            s.b1     = 2.0f * f.b0 * f.b1;
+            s.b2     = f.b1 * f.b1;
+            s.a1     = 2.0f * f.a1;
+            s.a2     = f.a1 * f.a1;
+            out[n++] = s;
+        }
+        return out;
+    }
+
+    // RBJ cookbook (Audio EQ Cookbook) sections, as biquad_design.h's
+    // Configure*() but constexpr: for bands fixed at build time.
+
+    /** Bell of gain_db at f0, bandwidth f0 / q */
+    static constexpr BiquadSection
+    Peaking(float fs, float f0, float q, float gain_db)
+    {
+        const double a     = Amplitude(gain_db);
+        const double w0    = 2.0 * kPi * (double)f0 / (double)fs;
+        const double cosw  = ConstTable::Cos(w0);
+        const double alpha = ConstTable::Sin(w0) / (2.0 * (double)q);
+        return Normalize(1.0 + alpha * a,
+                         -2.0 * cosw,
+                         1.0 - alpha * a,
+                         1.0 + alpha / a,
+                         -2.0 * cosw,
+                         1.0 - alpha / a);
+    }
+
+    /** gain_db below f0, 0 dB above; q 0.707 is the steepest without
+        overshoot */
+    static constexpr BiquadSection
+    LowShelf(float fs, float f0, float q, float gain_db)
+    {
+        return Shelf(fs, f0, q, gain_db, 1.0);
+    }
+
+    /** 0 dB below f0, gain_db above */
+    static constexpr BiquadSection
+    HighShelf(float fs, float f0, float q, float gain_db)
+    {
+        return Shelf(fs, f0, q, gain_db, -1.0);
+    }
+
+    /** Copies a design into a cascade, from stage first on.
+        Does not touch the state.
+    */
+    template <class Cascade, size_t n>
+    static void Load(Cascade&                                 cascade,
+                     const std::array<BiquadSection, n>& sections,
+                     size_t                                   first = 0)
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            cascade.SetSection(first + i, sections[i]);
+        }
+    }
+
+  private:
+    static constexpr double kPi   = 3.14159265358979323846;
+    static constexpr double kLn10 = 2.30258509299404568402;
+
+    /** Poles of the lowpass prototype, normalized to the cutoff:
+        -sh sin(theta_k) +/- j ch cos(theta_k), so sh = ch = 1 is
+        Butterworth. gain scales the first section.
+    */
+    template <size_t order>
+    static constexpr Sections<order> Design(Response response,
+                                            float    fs,
+                                            float    fc,
+                                            double   sh,
+                                            double   ch,
+                                            double   gain)
+    {
+        static_assert(order > 0, "IirDesign needs at least order 1");
+        const bool   low = response == Response::LOWPASS;
+        const double k   = ConstTable::Tan(kPi * (double)fc / (double)fs);
+
+        Sections<order> out{};
+        for(size_t i = 0; i < order / 2; i++)
+        {
+            const double theta = kPi * (double)(2 * i + 1) / (double)(2 * order);
+            const double sigma = sh * ConstTable::Sin(theta);
+            const double omega = ch * ConstTable::Cos(theta);
+            const double w0
+                = ConstTable::Sqrt(sigma * sigma + omega * omega);
+            // Lowpass to highpass maps the pole radius w0 to 1 / w0.
+            out[i] = Second(low, low ? k * w0 : k / w0, w0 / (2.0 * sigma));
+        }
+        if(order % 2)
+        {
+            out[order / 2] = First(low, low ? k * sh : k / sh);
+        }
+
+        out[0].b0 = (float)((double)out[0].b0 * gain);
+        out[0].b1 = (float)((double)out[0].b1 * gain);
+        out[0].b2 = (float)((double)out[0].b2 * gain);
+        return out;
+    }
+
+    /** 1 / (s^2 + s / q + 1) or its highpass, with s prewarped by k */
+    static constexpr BiquadSection Second(bool low, double k, double q)
+    {
+        const double  k2   = k * k;
+        const double  norm = 1.0 / (1.0 + k / q + k2);
+        const double  b0   = low ? k2 * norm : norm;
+        BiquadSection s{};
+        s.b0 = (float)b0;
+        s.b1 = (float)(low ? 2.0 * b0 : -2.0 * b0);
+        s.b2 = (float)b0;
+        s.a1 = (float)(2.0 * (k2 - 1.0) * norm);
+        s.a2 = (float)((1.0 - k / q + k2) * norm);
+        return s;
+    }
+
+    /** 1 / (s + 1) or its highpass, with s prewarped by k */
+    static constexpr BiquadSection First(bool low, double k)
+    {
+        const double  norm = 1.0 / (k + 1.0);
+        BiquadSection s{};
+        s.b0 = (float)(low ? k * norm : norm);
+        s.b1 = (float)(low ? k * norm : -norm);
+        s.b2 = 0.0f;
+        s.a1 = (float)((k - 1.0) * norm);
+        s.a2 = 0.0f;
+        return s;
+    }
+
+    /** The cookbook's shelves differ only in the sign of cos(w0): +1
+        for the low shelf, -1 for the high one. */
+    static constexpr BiquadSection
+    Shelf(float fs, float f0, float q, float gain_db, double side)
+    {
+        const double a     = Amplitude(gain_db);
+        const double w0    = 2.0 * kPi * (double)f0 / (double)fs;
+        const double cosw  = side * ConstTable::Cos(w0);
+        const double alpha = ConstTable::Sin(w0) / (2.0 * (double)q);
+        const double root  = 2.0 * ConstTable::Sqrt(a) * alpha;
+        return Normalize(a * ((a + 1.0) - (a - 1.0) * cosw + root),
+                         side * 2.0 * a * ((a - 1.0) - (a + 1.0) * cosw),
+                         a * ((a + 1.0) - (a - 1.0) * cosw - root),
+                         (a + 1.0) + (a - 1.0) * cosw + root,
+                         side * -2.0 * ((a - 1.0) + (a + 1.0) * cosw),
+                         (a + 1.0) + (a - 1.0) * cosw - root);
+    }
+
+    /** 10^(gain_db / 40) */
+    static constexpr double Amplitude(float gain_db)
+    {
+        return ConstTable::Exp((double)gain_db * (kLn10 / 40.0));
+    }
+
+    static constexpr BiquadSection Normalize(
+        double b0, double b1, double b2, double a0, double a1, double a2)
+    {
+        BiquadSection s{};
+        s.b0 = (float)(b0 / a0);
+        s.b1 = (float)(b1 / a0);
+        s.b2 = (float)(b2 / a0);
+        s.a1 = (float)(a1 / a0);
+        s.a2 = (float)(a2 / a0);
+        return s;
+    }
+
+    // The rest of the libm the designs need, on ConstTable's.
+
+    static constexpr double Sinh(double x)
+    {
+        return 0.5 * (ConstTable::Exp(x) - ConstTable::Exp(-x));
+    }
+
+    static constexpr double Cosh(double x)
+    {
+        return 0.5 * (ConstTable::Exp(x) + ConstTable::Exp(-x));
+    }
+
+    static constexpr double Asinh(double x)
+    {
+        return ConstTable::Log(x + ConstTable::Sqrt(x * x + 1.0));
+    }
+};
+
+inline constexpr size_t IirDesign::kStateBytes = sizeof(IirDesign);
+
+} // namespace daisysp
+#endif
@@ -0,0 +1,143 @@
+#pragma once
+#ifndef DSY_INTERLEAVED_DELAY_H
+#define DSY_INTERLEAVED_DELAY_H
+#include <stdlib.h>
+#include <stdint.h>
+#include "dsp.h"
+namespace daisysp
+{
+/** Several delay lines sharing one interleaved buffer.
+
+Sample i of every line sits in one frame, so the lines' writes land on
+the same cache lines instead of on lines of their own. Separate
+DelayLines of one size in an SDRAM array are a power of two plus a few
+bytes apart, which maps their write pointers onto the same D-cache sets
+(4-way, 4 kB apart) where they evict each other's reads; here the
+write traffic of all lines is one stream.
+
+Each line keeps its own fractional delay. One Write() per sample takes
+a sample for every line. Storage is rounded up to a power of two of
+frames, as for DelayLine; the usable delay is max_size - 1 samples.
+
+declaration example: (three 1 second lines, in SDRAM)
+
+InterleavedDelay<float, 48000, 3> DSY_SDRAM_BSS delays;
+*/
+template <typename T, size_t max_size, size_t lines>
+class InterleavedDelay
+{
+  public:
+    static const size_t kStateBytes;
+
+    InterleavedDelay() {}
+    ~InterleavedDelay() {}
+
+    /** initializes the lines by clearing the values within, and setting
+        every delay to 1 sample.
+    */
+    void Init() { Reset(); }
+
+    /** as Init(), for memory that already reads as zero: skips the
+        pass over the buffer.
+    */
+    void Init(ZeroedMemory) { Restart(); }
+
+    /** clears buffer, sets write ptr to 0, and every delay to 1 sample.
+    */
+    void Reset()
+    {
+        for(size_t i = 0; i < kSize * lines; i++)
+        {
+            line_[i] = T(0);
+        }
+        Restart();
+    }
+
+    /** sets one line's delay in samples, with a fractional part
+        interpolated linearly.
+    */
+    inline void SetDelay(size_t line, float delay)
+    {
+        int32_t int_delay = static_cast<int32_t>(delay);
+        frac_[line]       = delay - static_cast<float>(int_delay);
+        delay_[line]      = static_cast<size_t>(int_delay) < max_size
+                                ? int_delay
+                                : max_size - 1;
+    }
+
+    /** writes in[lines], one sample per line, and advances the write ptr
+    */
+    inline void Write(const T* in)
+    {
+        T* frame = &line_[write_ptr_ * lines];
+        for(size_t l = 0; l < lines; l++)
+        {
+            frame[l] = in[l];
+        }
+        write_ptr_ = (write_ptr_ - 1) & kMask;
+    }
+
+    /** returns one line's next sample */
+    inline const T Read(size_t line) const
+    {
+        const size_t p = write_ptr_ + delay_[line];
+        const T      a = line_[(p & kMask) * lines + line];
+        const T      b = line_[((p + 1) & kMask) * lines + line];
+        return a + (b - a) * frac_[line];
+    }
+
+    /** reads one line at delay samples, not its set delay */
+    inline const T Read(size_t line, float delay) const
+    {
+        int32_t delay_integral   = static_cast<int32_t>(delay);
+        float   delay_fractional = delay - static_cast<float>(delay_integral);
+        const size_t p = write_ptr_ + delay_integral;
+        const T      a = line_[(p & kMask) * lines + line];
+        const T      b = line_[((p + 1) & kMask) * lines + line];
+        return a + (b - a) * delay_fractional;
+    }
+
+    /** reads every line's next sample into out[lines] */
+    inline void Read(T* out) const
+    {
+        for(size_t l = 0; l < lines; l++)
+        {
+            out[l] = Read(l);
+        }
+    }
+
+    static constexpr size_t GetLines() { return lines; }
+
+  private:
+    void Restart()
+    {
+        for(size_t l = 0; l < lines; l++)
+        {
+            delay_[l] = 1;
+            frac_[l]  = 0.0f;
+        }
+        write_ptr_ = 0;
+    }
+
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t kSize = RoundUp(max_size);
+    static constexpr size_t kMask = kSize - 1;
+
+    size_t write_ptr_;
+    size_t delay_[lines];
+    float  frac_[lines];
+    T      line_[kSize * lines];
+};
+
+template <typename T, size_t max_size, size_t lines>
+constexpr size_t InterleavedDelay<T, max_size, lines>::kStateBytes
+    = sizeof(InterleavedDelay<T, max_size, lines>);
+} // namespace daisysp
+#endif
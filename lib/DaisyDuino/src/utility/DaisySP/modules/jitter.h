@@ -2,6 +2,9 @@
 #ifndef DAISY_JITTER
 #define DAISY_JITTER
 
+#include <stdint.h>
+#include <stddef.h>
+
 namespace daisysp
 {
 /** Randomly segmented line generator \n 
@@ -17,6 +20,8 @@ namespace daisysp
 class Jitter
 {
   public:
+    static const size_t kStateBytes;
+
     Jitter() {}
     ~Jitter() {}
 
@@ -52,6 +57,8 @@ class Jitter
     float   biRandGab();
     void    Reset();
 };
+
+inline constexpr size_t Jitter::kStateBytes = sizeof(Jitter);
 } // namespace daisysp
 
 #endif
@@ -13,6 +13,8 @@ Credit to pichenettes/Mutable Instruments
 class Limiter
 {
   public:
+    static const size_t kStateBytes;
+
     Limiter() {}
     ~Limiter() {}
     /** Initializes the Limiter instance. 
@@ -29,5 +31,7 @@ class Limiter
   private:
     float peak_;
 };
+
+inline constexpr size_t Limiter::kStateBytes = sizeof(Limiter);
 } // namespace daisysp
 #endif
@@ -2,6 +2,7 @@
 #ifndef LINE_H
 #define LINE_H
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -11,6 +12,8 @@ namespace daisysp
 class Line
 {
   public:
+    static const size_t kStateBytes;
+
     Line() {}
     ~Line() {}
     /** Initializes Line module.
@@ -34,6 +37,8 @@ class Line
     float   inc_, val_, sample_rate_;
     uint8_t finished_;
 };
+
+inline constexpr size_t Line::kStateBytes = sizeof(Line);
 } // namespace daisysp
 #endif
 #endif
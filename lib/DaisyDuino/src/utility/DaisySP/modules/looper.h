@@ -1,5 +1,7 @@
 #pragma once
-#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "dsp.h"
 
 namespace daisysp
@@ -13,10 +15,17 @@ namespace daisysp
 *  - Frippertronics
 *
 * Read more about the looper modes in the mode enum documentation.
+*
+* Init() does not clear the memory: the first loop is always recorded
+* forward from the start, overwriting, and nothing past it is ever read,
+* so a loop of tens of MB in SDRAM starts at once. The position is held
+* in half samples as an integer, exact over any buffer size.
 */
 class Looper
 {
   public:
+    static const size_t kStateBytes;
+
     Looper() {}
     ~Looper() {}
 
@@ -43,63 +52,64 @@ class Looper
         buffer_size_ = size;
         buff_        = mem;
 
-        InitBuff();
         state_      = State::EMPTY;
         mode_       = Mode::NORMAL;
         half_speed_ = false;
         reverse_    = false;
         rec_queue_  = false;
         win_idx_    = 0;
+        win_at_     = kWindowSamps;
+        win_        = 0.f;
+        pos_        = 0;
+        recsize_    = 0;
     }
 
     /** Handles reading/writing to the Buffer depending on the mode. */
     float Process(const float input)
     {
-        float sig = 0.f;
-        float inc;
+        float sig     = 0.f;
         bool  hitloop = false;
         // Record forward at normal speed during the first loop no matter what.
-        inc = state_ == State::EMPTY || state_ == State::REC_FIRST
-                  ? 1.f
-                  : GetIncrementSize();
-        win_ = WindowVal(win_idx_ * kWindowFactor);
+        const int32_t inc = Increment();
+        const size_t  idx = static_cast<size_t>(pos_ >> 1);
+        UpdateWindow();
         switch(state_)
         {
             case State::EMPTY: sig = 0.0f; break;
             case State::REC_FIRST:
                 sig = 0.f;
-                Write(pos_, input * win_);
+                Write(idx, input * win_);
                 if(win_idx_ < kWindowSamps - 1)
                     win_idx_ += 1;
-                recsize_ = pos_;
+                recsize_ = idx;
                 pos_ += inc;
-                if(pos_ > buffer_size_ - 1)
+                if(pos_ > LastPos(buffer_size_))
                 {
                     state_   = State::PLAYING;
-                    recsize_ = pos_ - 1;
+                    recsize_ = static_cast<size_t>(pos_ >> 1) - 1;
                     pos_     = 0;
                 }
                 break;
             case State::PLAYING:
-                sig = Read(pos_);
+                sig = Read(idx);
                 /** This is a way of 'seamless looping'
 				 ** The first N samps after recording is done are recorded with the input faded out. 
 				 */
                 if(win_idx_ < kWindowSamps - 1)
                 {
-                    Write(pos_, sig + input * (1.f - win_));
+                    Write(idx, sig + input * (1.f - win_));
                     win_idx_ += 1;
                 }
 
                 pos_ += inc;
-                if(pos_ > recsize_ - 1)
+                if(pos_ > LastPos(recsize_))
                 {
                     pos_    = 0;
                     hitloop = true;
                 }
                 else if(pos_ < 0)
                 {
-                    pos_    = recsize_ - 1;
+                    pos_    = LastPos(recsize_);
                     hitloop = true;
                 }
                 if(hitloop)
@@ -114,28 +124,28 @@ class Looper
                 }
                 break;
             case State::REC_DUB:
-                sig = Read(pos_);
+                sig = Read(idx);
                 switch(mode_)
                 {
-                    case Mode::REPLACE: Write(pos_, input * win_); break;
+                    case Mode::REPLACE: Write(idx, input * win_); break;
                     case Mode::FRIPPERTRONICS:
-                        Write(pos_, (input * win_) + (sig * kFripDecayVal));
+                        Write(idx, (input * win_) + (sig * kFripDecayVal));
                         break;
                     case Mode::NORMAL:
                     case Mode::ONETIME_DUB:
-                    default: Write(pos_, (input * win_) + sig); break;
+                    default: Write(idx, (input * win_) + sig); break;
                 }
                 if(win_idx_ < kWindowSamps - 1)
                     win_idx_ += 1;
                 pos_ += inc;
-                if(pos_ > recsize_ - 1)
+                if(pos_ > LastPos(recsize_))
                 {
                     pos_    = 0;
                     hitloop = true;
                 }
                 else if(pos_ < 0)
                 {
-                    pos_    = recsize_ - 1;
+                    pos_    = LastPos(recsize_);
                     hitloop = true;
                 }
                 if(hitloop && mode_ == Mode::ONETIME_DUB)
@@ -147,13 +157,36 @@ class Looper
                 break;
             default: break;
         }
-        near_beginning_ = state_ != State::EMPTY && !Recording() && pos_ < 4800
-                              ? true
-                              : false;
+        UpdateNearBeginning();
 
         return sig;
     }
 
+    /** Processes a block, the same as Process() on each sample.
+        Between the fades and the loop points, which go through
+        Process(), the state, mode and wrap are worked out once per
+        stretch and the samples run in a plain loop.
+        \param in - input buffer
+        \param out - output buffer, may be in
+        \param size - number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        size_t i = 0;
+        while(i < size)
+        {
+            const size_t n = SteadySamples(size - i);
+            if(n == 0)
+            {
+                out[i] = Process(in[i]);
+                i++;
+                continue;
+            }
+            RunSteady(in + i, out + i, n);
+            i += n;
+        }
+    }
+
     /** Effectively erases the buffer 
      ** Note: This does not actually change what is in the buffer  */
     inline void Clear() { state_ = State::EMPTY; }
@@ -174,6 +207,11 @@ class Looper
                 reverse_    = false;
                 break;
             case State::REC_FIRST:
+                // Play from the start, never from the unwritten sample
+                // after the take; with nothing written there is no loop.
+                state_ = pos_ == 0 ? State::EMPTY : State::PLAYING;
+                pos_   = 0;
+                break;
             case State::REC_DUB: state_ = State::PLAYING; break;
             case State::PLAYING:
                 if(mode_ == Mode::ONETIME_DUB)
@@ -232,36 +270,123 @@ class Looper
     static constexpr float kWindowFactor      = (1.f / kWindowSamps);
 
     /** Private Member Functions */
-    float GetIncrementSize()
+
+    /** Playback step in half samples */
+    int32_t GetIncrementSize() const
     {
-        float inc = 1.f;
+        int32_t inc = 2;
         if(half_speed_)
-            inc = 0.5f;
+            inc = 1;
         return reverse_ ? -inc : inc;
     }
 
-    /** Initialize the buffer */
-    void InitBuff() { std::fill(&buff_[0], &buff_[buffer_size_ - 1], 0); }
-
-    /** Get a floating point sample from the buffer */
-    inline const float Read(size_t pos) const { return buff_[pos]; }
+    /** Step for the current state, in half samples */
+    inline int32_t Increment() const
+    {
+        return state_ == State::EMPTY || state_ == State::REC_FIRST
+                   ? 2
+                   : GetIncrementSize();
+    }
 
-    /** Reads from a specified point in the delay line using linear interpolation */
-    float ReadF(float pos)
+    /** Position of the last sample of a length, in half samples */
+    static inline int32_t LastPos(size_t length)
     {
-        float    a, b, frac;
-        uint32_t i_idx = static_cast<uint32_t>(pos);
-        frac           = pos - i_idx;
-        a              = buff_[i_idx];
-        b              = buff_[(i_idx + 1) % buffer_size_];
-        return a + (b - a) * frac;
+        return 2 * (static_cast<int32_t>(length) - 1);
     }
 
+    /** Get a floating point sample from the buffer */
+    inline const float Read(size_t pos) const { return buff_[pos]; }
+
     /** Write to a known location in the buffer */
     inline void Write(size_t pos, float val) { buff_[pos] = val; }
 
     /** Linear to Constpower approximation for windowing*/
-    float WindowVal(float in) { return sin(HALFPI_F * in); }
+    float WindowVal(float in) { return math::sin(HALFPI_F * in); }
+
+    /** Recomputes win_ only when win_idx_ has moved */
+    inline void UpdateWindow()
+    {
+        if(win_at_ != win_idx_)
+        {
+            win_at_ = win_idx_;
+            win_    = WindowVal(win_idx_ * kWindowFactor);
+        }
+    }
+
+    inline void UpdateNearBeginning()
+    {
+        near_beginning_ = state_ != State::EMPTY && !Recording()
+                          && pos_ < 2 * 4800;
+    }
+
+    /** Samples from now, at most max, that need no fade and reach no
+        loop point or buffer end: none of them changes the state.
+    */
+    size_t SteadySamples(size_t max) const
+    {
+        if(state_ == State::EMPTY)
+            return max;
+        if(win_idx_ < kWindowSamps - 1)
+            return 0;
+        const int32_t inc  = Increment();
+        const int32_t last = state_ == State::REC_FIRST ? LastPos(buffer_size_)
+                                                        : LastPos(recsize_);
+        int32_t steps = 0;
+        if(pos_ <= last && pos_ >= 0)
+            steps = inc > 0 ? (last - pos_) / inc : pos_ / -inc;
+        return static_cast<size_t>(steps) < max ? static_cast<size_t>(steps)
+                                                : max;
+    }
+
+    /** SteadySamples() worth of Process() */
+    void RunSteady(const float *in, float *out, size_t size)
+    {
+        UpdateWindow();
+        const int32_t inc = Increment();
+        const float   win = win_;
+        int32_t       pos = pos_;
+        switch(state_)
+        {
+            case State::EMPTY:
+                for(size_t i = 0; i < size; i++)
+                    out[i] = 0.f;
+                break;
+            case State::REC_FIRST:
+                for(size_t i = 0; i < size; i++, pos += inc)
+                {
+                    Write(static_cast<size_t>(pos >> 1), in[i] * win);
+                    out[i] = 0.f;
+                }
+                recsize_ = static_cast<size_t>((pos - inc) >> 1);
+                break;
+            case State::PLAYING:
+                for(size_t i = 0; i < size; i++, pos += inc)
+                    out[i] = Read(static_cast<size_t>(pos >> 1));
+                break;
+            case State::REC_DUB:
+                for(size_t i = 0; i < size; i++, pos += inc)
+                {
+                    const size_t idx = static_cast<size_t>(pos >> 1);
+                    const float  sig = Read(idx);
+                    const float  x   = in[i] * win;
+                    switch(mode_)
+                    {
+                        case Mode::REPLACE: Write(idx, x); break;
+                        case Mode::FRIPPERTRONICS:
+                            Write(idx, x + (sig * kFripDecayVal));
+                            break;
+                        case Mode::NORMAL:
+                        case Mode::ONETIME_DUB:
+                        default: Write(idx, x + sig); break;
+                    }
+                    out[i] = sig;
+                }
+                break;
+            default: break;
+        }
+        pos_ = pos;
+        UpdateNearBeginning();
+    }
 
     // Private Enums
 
@@ -275,17 +400,21 @@ class Looper
     };
 
     /** Private Member Variables */
-    Mode   mode_;
-    State  state_;
-    float *buff_;
-    size_t buffer_size_;
-    float  pos_, win_;
-    size_t win_idx_;
-    bool   half_speed_;
-    bool   reverse_;
-    size_t recsize_;
-    bool   rec_queue_;
-    bool   near_beginning_;
+    Mode    mode_;
+    State   state_;
+    float * buff_;
+    size_t  buffer_size_;
+    int32_t pos_; /**< in half samples */
+    float   win_;
+    size_t  win_idx_;
+    size_t  win_at_; /**< win_idx_ that win_ was computed for */
+    bool    half_speed_;
+    bool    reverse_;
+    size_t  recsize_;
+    bool    rec_queue_;
+    bool    near_beginning_;
 };
 
+inline constexpr size_t Looper::kStateBytes = sizeof(Looper);
+
 } // namespace daisysp
@@ -3,6 +3,7 @@
 #define DSY_MAYTRIG_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -16,6 +17,8 @@ Ported from soundpipe by Ben Sergentanis, May 2020
 class Maytrig
 {
   public:
+    static const size_t kStateBytes;
+
     Maytrig() {}
     ~Maytrig() {}
     /** probabilistically generates triggers
@@ -31,6 +34,8 @@ class Maytrig
 
   private:
 };
+
+inline constexpr size_t Maytrig::kStateBytes = sizeof(Maytrig);
 } // namespace daisysp
 #endif
 #endif
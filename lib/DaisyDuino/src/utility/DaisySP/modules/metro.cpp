@@ -4,27 +4,56 @@
 
 using namespace daisysp;
 
+static uint32_t PhaseInc(float freq, float sample_rate)
+{
+    // Cycles per sample in [0, 1), then onto the 32-bit phase circle; at
+    // or above the sample rate it saturates at a tick per sample.
+    float ratio = freq / sample_rate;
+    ratio       = fclamp(ratio, 0.0f, 0.99999994f);
+    return static_cast<uint32_t>(ratio * 4294967296.0f);
+}
+
 void Metro::Init(float freq, float sample_rate)
 {
     freq_        = freq;
-    phs_         = 0.0f;
+    phs_         = 0;
     sample_rate_ = sample_rate;
-    phs_inc_     = (TWOPI_F * freq_) / sample_rate_;
+    phs_inc_     = PhaseInc(freq_, sample_rate_);
 }
 
 uint8_t Metro::Process()
 {
+    const uint32_t prev = phs_;
     phs_ += phs_inc_;
-    if(phs_ >= TWOPI_F)
+    return phs_ < prev ? 1 : 0;
+}
+
+size_t Metro::ProcessBlock(size_t size, size_t *offsets, size_t max_offsets)
+{
+    size_t count = 0;
+    if(phs_inc_ != 0)
     {
-        phs_ -= TWOPI_F;
-        return 1;
+        // The next tick is q samples after pos, q + 1 being the smallest
+        // n with phs_ + n * inc >= 2^32: q = (2^32 - 1 - phs_) / inc.
+        size_t pos = 0;
+        for(;;)
+        {
+            const uint32_t q = ~phs_ / phs_inc_;
+            if(q >= size - pos)
+                break;
+            if(count < max_offsets)
+                offsets[count] = pos + q;
+            count++;
+            pos += q + 1;
+            phs_ += (q + 1) * phs_inc_;
+        }
+        phs_ += static_cast<uint32_t>(size - pos) * phs_inc_;
     }
-    return 0;
+    return count;
 }
 
 void Metro::SetFreq(float freq)
 {
     freq_    = freq;
-    phs_inc_ = (TWOPI_F * freq_) / sample_rate_;
+    phs_inc_ = PhaseInc(freq_, sample_rate_);
 }
@@ -2,15 +2,22 @@
 #ifndef DSY_METRO_H
 #define DSY_METRO_H
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
 {
 /** Creates a clock signal at a specific frequency.
+
+    The phase is an unsigned 32-bit accumulator, so the tick positions
+    are exact and ProcessBlock() can find them with one division per
+    tick instead of stepping through every sample.
 */
 class Metro
 {
   public:
+    static const size_t kStateBytes;
+
     Metro() {}
     ~Metro() {}
     /** Initializes Metro module.
@@ -26,9 +33,34 @@ class Metro
     */
     uint8_t Process();
 
+    /** Advances size samples, the same as size calls to Process(), and
+        reports at which of them a tick fired. Generator code can then run
+        in runs between ticks, e.g. with Oscillator::ProcessBlock(), with
+        events landing exactly on the tick sample:
+
+            size_t ticks[4], start = 0;
+            size_t n = metro.ProcessBlock(size, ticks, 4);
+            n        = n < 4 ? n : 4;
+            for(size_t t = 0; t <= n; t++)
+            {
+                const size_t end = t < n ? ticks[t] : size;
+                osc.ProcessBlock(out + start, end - start);
+                if(t < n)
+                    osc.SetFreq(NextNote()); // from sample end on
+                start = end;
+            }
+
+        \param size - number of samples to advance
+        \param offsets - receives the sample offsets of the ticks, ascending
+        \param max_offsets - capacity of offsets; ticks beyond it are counted
+            and consumed, not stored
+        \return number of ticks in the block
+    */
+    size_t ProcessBlock(size_t size, size_t *offsets, size_t max_offsets);
+
     /** resets phase to 0
     */
-    inline void Reset() { phs_ = 0.0f; }
+    inline void Reset() { phs_ = 0; }
     /** Sets frequency at which Metro module will run at.
     */
     void SetFreq(float freq);
@@ -38,9 +70,11 @@ class Metro
     inline float GetFreq() { return freq_; }
 
   private:
-    float freq_;
-    float phs_, sample_rate_, phs_inc_;
+    float    freq_, sample_rate_;
+    uint32_t phs_, phs_inc_; /**< 2^32 == one tick period */
 };
+
+inline constexpr size_t Metro::kStateBytes = sizeof(Metro);
 } // namespace daisysp
 #endif
 #endif
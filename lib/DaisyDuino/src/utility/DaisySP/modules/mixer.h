@@ -0,0 +1,244 @@
+#pragma once
+#ifndef DSY_MIXER_H
+#define DSY_MIXER_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** @file mixer.h */
+
+namespace daisysp
+{
+/** @brief Matrix mixer of num_in inputs onto num_out outputs.
+
+    Every output is the sum of every input times its own gain, so a
+    Mixer<4, 1> is a four channel mixer and a Mixer<4, 2> one with
+    per-channel pan. Set gains as often as the knobs are read. Each
+    ProcessBlock() ramps a gain linearly from the last block's value to
+    the new one, so no per-knob fonepole() is needed and a gain set once
+    per block does not step.
+
+    Mute() fades an input out, or back in, linearly over the mute time,
+    across as many blocks as that takes.
+
+    The inputs of an output are summed four at a time: one pass over the
+    block reads four inputs, steps four gain ramps and does four
+    multiply-adds into one store. A gain that is 0 and stays 0 costs
+    nothing, so a sparse routing matrix runs at the speed of its
+    connections.
+
+    declaration example:
+
+    Mixer<4, 2> mixer;
+    mixer.Init(sample_rate);
+    mixer.SetGain(0, 2, knob);
+    mixer.SetPan(3, .25f, 1.f);
+    mixer.Mute(1, true);
+    ...
+    mixer.ProcessBlock(in, out, size);
+
+    \param num_in Number of input channels
+    \param num_out Number of output channels
+*/
+template <size_t num_in, size_t num_out>
+class Mixer
+{
+  public:
+    static const size_t kStateBytes;
+
+    Mixer() {}
+    ~Mixer() {}
+
+    static_assert(num_in > 0 && num_out > 0, "a Mixer needs channels");
+
+    /** Every gain at 0, nothing muted.
+        \param sample_rate Audio engine sample rate
+        \param mute_time Fade time of Mute(), in seconds
+    */
+    void Init(float sample_rate, float mute_time = .01f)
+    {
+        sample_rate_ = sample_rate;
+        for(size_t o = 0; o < num_out; o++)
+        {
+            for(size_t i = 0; i < num_in; i++)
+            {
+                gain_[o][i] = last_[o][i] = 0.f;
+            }
+        }
+        for(size_t i = 0; i < num_in; i++)
+        {
+            level_[i] = 1.f;
+            muted_[i] = false;
+        }
+        SetMuteTime(mute_time);
+    }
+
+    /** Gain from input in to output out, ramped to over the next block */
+    inline void SetGain(size_t out, size_t in, float gain)
+    {
+        gain_[out][in] = gain;
+    }
+
+    /** Sends input in to outputs 0 and 1 with an equal-power pan law:
+        pan 0 is left, .5 centre (-3 dB each), 1 right.
+        \param in Input channel
+        \param pan Position, 0 to 1
+        \param gain Overall gain
+    */
+    void SetPan(size_t in, float pan, float gain)
+    {
+        static_assert(num_out >= 2, "SetPan needs two outputs");
+        pan = pan < 0.f ? 0.f : (pan > 1.f ? 1.f : pan);
+        // cos / sin of pi / 4 + p, p = (pan - .5) pi / 2, from the
+        // series of cos p and sin p: within 4e-4, with no libm per
+        // knob read.
+        const float p = (pan - .5f) * 1.57079633f, p2 = p * p;
+        const float c = 1.f - p2 * (.5f - p2 * (1.f / 24.f));
+        const float s = p * (1.f - p2 * (1.f / 6.f - p2 * (1.f / 120.f)));
+        gain_[0][in]  = gain * .70710678f * (c - s);
+        gain_[1][in]  = gain * .70710678f * (c + s);
+    }
+
+    /** \return gain from input in to output out, as last set */
+    inline float GetGain(size_t out, size_t in) const
+    {
+        return gain_[out][in];
+    }
+
+    /** Fades input in out (true) or back in (false) */
+    inline void Mute(size_t in, bool mute) { muted_[in] = mute; }
+
+    /** Fades every input out or in */
+    inline void MuteAll(bool mute)
+    {
+        for(size_t i = 0; i < num_in; i++)
+        {
+            muted_[i] = mute;
+        }
+    }
+
+    /** \return whether input in is muted or fading out */
+    inline bool IsMuted(size_t in) const { return muted_[in]; }
+
+    /** Fade time of Mute(), in seconds; 0 cuts within one block */
+    inline void SetMuteTime(float time)
+    {
+        mute_rate_ = time > 0.f ? 1.f / (time * sample_rate_) : 1.f;
+    }
+
+    /** Mixes one block.
+        \param in num_in input channels of size samples
+        \param out num_out output channels of size samples; none may be
+            one of the inputs
+        \param size Samples per channel
+    */
+    void ProcessBlock(const float *const *in, float *const *out, size_t size)
+    {
+        if(size == 0)
+            return;
+        const float inv    = 1.f / static_cast<float>(size);
+        const float change = mute_rate_ * static_cast<float>(size);
+        for(size_t i = 0; i < num_in; i++)
+        {
+            const float l = level_[i] + (muted_[i] ? -change : change);
+            level_[i]     = l < 0.f ? 0.f : (l > 1.f ? 1.f : l);
+        }
+
+        for(size_t o = 0; o < num_out; o++)
+        {
+            const float *src[num_in];
+            float        from[num_in], step[num_in];
+            size_t       count = 0;
+            for(size_t i = 0; i < num_in; i++)
+            {
+                const float to = gain_[o][i] * level_[i];
+                if(to != 0.f || last_[o][i] != 0.f)
+                {
+                    src[count]  = in[i];
+                    from[count] = last_[o][i];
+                    step[count] = (to - last_[o][i]) * inv;
+                    count++;
+                }
+                last_[o][i] = to;
+            }
+
+            if(count == 0)
+            {
+                memset(out[o], 0, size * sizeof(float));
+                continue;
+            }
+            // The first four inputs write the output, the rest add.
+            size_t lanes = count < 4 ? count : 4;
+            Pass<false>(lanes, out[o], src, from, step, size);
+            for(size_t k = lanes; k < count; k += lanes)
+            {
+                lanes = count - k < 4 ? count - k : 4;
+                Pass<true>(lanes, out[o], src + k, from + k, step + k, size);
+            }
+        }
+    }
+
+  private:
+    template <bool accumulate>
+    static inline void Pass(size_t              lanes,
+                            float *             out,
+                            const float *const *src,
+                            const float *       from,
+                            const float *       step,
+                            size_t              size)
+    {
+        switch(lanes)
+        {
+            case 4: Mac<4, accumulate>(out, src, from, step, size); break;
+            case 3: Mac<3, accumulate>(out, src, from, step, size); break;
+            case 2: Mac<2, accumulate>(out, src, from, step, size); break;
+            default: Mac<1, accumulate>(out, src, from, step, size); break;
+        }
+    }
+
+    /** out (+)= the sum of lanes inputs times their ramps. The lanes
+        loop is unrolled by the compiler, every gain in a register.
+    */
+    template <size_t lanes, bool accumulate>
+    static inline void Mac(float *             out,
+                           const float *const *src,
+                           const float *       from,
+                           const float *       step,
+                           size_t              size)
+    {
+        const float *x[lanes];
+        float        g[lanes], d[lanes];
+        for(size_t j = 0; j < lanes; j++)
+        {
+            x[j] = src[j];
+            g[j] = from[j];
+            d[j] = step[j];
+        }
+        for(size_t n = 0; n < size; n++)
+        {
+            float acc = accumulate ? out[n] : 0.f;
+            for(size_t j = 0; j < lanes; j++)
+            {
+                g[j] += d[j];
+                acc += g[j] * x[j][n];
+            }
+            out[n] = acc;
+        }
+    }
+
+    float gain_[num_out][num_in]; /**< as set */
+    float last_[num_out][num_in]; /**< where the last block ended */
+    float level_[num_in];         /**< mute fade, 0 muted to 1 */
+    bool  muted_[num_in];
+    float sample_rate_, mute_rate_;
+};
+
+template <size_t num_in, size_t num_out>
+constexpr size_t Mixer<num_in, num_out>::kStateBytes
+    = sizeof(Mixer<num_in, num_out>);
+
+} // namespace daisysp
+#endif
+#endif
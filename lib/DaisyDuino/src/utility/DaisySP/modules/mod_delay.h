@@ -0,0 +1,245 @@
+#pragma once
+#ifndef DSY_MOD_DELAY_H
+#define DSY_MOD_DELAY_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "delayline.h"
+#include "dsp.h"
+
+/** Highest sample rate the modulation effects size their lines for by
+    default: Flanger, Chorus, Phaser and ModDelay<max_ms>. 48000 halves
+    their memory where 96 kHz is never used; BasicFlanger<48000> and the
+    like do the same for one object.
+*/
+#ifndef DSY_MOD_DELAY_MAX_SAMPLE_RATE
+#define DSY_MOD_DELAY_MAX_SAMPLE_RATE 96000
+#endif
+
+/** @file mod_delay.h */
+
+namespace daisysp
+{
+/** @brief Triangle LFO of Chorus, Flanger and Phaser.
+
+    Runs from -1 to 1 and back, turning at each end.
+*/
+class TriangleLfo
+{
+  public:
+    static const size_t kStateBytes;
+
+    TriangleLfo() {}
+    ~TriangleLfo() {}
+
+    /** Largest Advance(), so one turn at each end covers any rate */
+    static constexpr size_t kMaxAdvance = 8;
+
+    /** Starts at 0, stopped */
+    void Init()
+    {
+        phase_ = 0.f;
+        freq_  = 0.f;
+    }
+
+    /** Set lfo frequency, keeping the current direction.
+        \param freq Frequency in Hz
+        \param sample_rate Audio engine sample rate
+    */
+    void SetFreq(float freq, float sample_rate)
+    {
+        freq = 4.f * freq / sample_rate;
+        freq *= freq_ < 0.f ? -1.f : 1.f;  //if we're headed down, keep going
+        freq_ = fclamp(freq, -.25f, .25f); //clip at +/- .125 * sr
+    }
+
+    /** Steps one sample.
+        \return the new phase
+    */
+    inline float Process()
+    {
+        phase_ += freq_;
+
+        //wrap around and flip direction
+        if(phase_ > 1.f)
+        {
+            phase_ = 1.f - (phase_ - 1.f);
+            freq_ *= -1.f;
+        }
+        else if(phase_ < -1.f)
+        {
+            phase_ = -1.f - (phase_ + 1.f);
+            freq_ *= -1.f;
+        }
+        return phase_;
+    }
+
+    /** Steps size samples at once, up to kMaxAdvance; the same phase as
+        size calls to Process() up to rounding.
+        \return the new phase
+    */
+    inline float Advance(size_t size)
+    {
+        // |freq_| <= .25, so this overshoots an end by at most 2.
+        phase_ += freq_ * static_cast<float>(size);
+        if(phase_ > 1.f)
+        {
+            phase_ = 1.f - (phase_ - 1.f);
+            freq_ *= -1.f;
+        }
+        else if(phase_ < -1.f)
+        {
+            phase_ = -1.f - (phase_ + 1.f);
+            freq_ *= -1.f;
+        }
+        return phase_;
+    }
+
+    /** \return the phase after the last step */
+    inline float GetPhase() const { return phase_; }
+
+  private:
+    float phase_;
+    float freq_;
+};
+
+inline constexpr size_t TriangleLfo::kStateBytes = sizeof(TriangleLfo);
+
+/** @brief Modulated delay line shared by Chorus and Flanger.
+
+    A feedback delay whose length is swept by a TriangleLfo. max_ms
+    bounds the delay; the line holds that much at max_sample_rate,
+    worked out at compile time, and Init() limits it to max_ms at the
+    actual rate, so the same object runs at any rate up to that one.
+
+    Process() returns the delayed (wet) signal only. ProcessBlock()
+    evaluates the LFO once per kSubBlock samples and sweeps the delay
+    linearly in between, which differs from Process() only where the
+    triangle turns inside a sub-block.
+*/
+template <size_t max_ms, size_t max_sample_rate = DSY_MOD_DELAY_MAX_SAMPLE_RATE>
+class ModDelay
+{
+  public:
+    static const size_t kStateBytes;
+
+    ModDelay() {}
+    ~ModDelay() {}
+
+    /** Samples per LFO evaluation in ProcessBlock() */
+    static constexpr size_t kSubBlock = TriangleLfo::kMaxAdvance;
+
+    /** Clears the line and stops the LFO, with no delay or feedback.
+        \param sample_rate Audio engine sample rate
+        \param offset Samples added to every delay, e.g. 1 to never read
+                      the sample being written
+    */
+    void Init(float sample_rate, float offset = 0.f)
+    {
+        sample_rate_ = sample_rate;
+        offset_      = offset;
+        line_.Init();
+        lfo_.Init();
+        size_t len = ms_to_samples(max_ms, static_cast<size_t>(sample_rate));
+        len        = len < kMaxSamples ? len : kMaxSamples;
+        max_delay_ = static_cast<float>(len) - 1.f;
+        delay_     = 0.f;
+        lfo_amp_   = 0.f;
+        feedback_  = 0.f;
+    }
+
+    /** Get the next wet sample
+        \param in Sample to process
+    */
+    inline float Process(float in)
+    {
+        const float lfo_sig = lfo_.Process() * lfo_amp_;
+        const float out     = Read(offset_ + lfo_sig + delay_);
+        line_.Write(in + out * feedback_);
+        return out;
+    }
+
+    /** Wet output of a block, the LFO stepped per kSubBlock.
+        \param in Input samples
+        \param out Wet samples out, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        float d0 = offset_ + lfo_.GetPhase() * lfo_amp_ + delay_;
+        for(size_t pos = 0; pos < size; pos += kSubBlock)
+        {
+            const size_t n  = size - pos < kSubBlock ? size - pos : kSubBlock;
+            const float  d1 = offset_ + lfo_.Advance(n) * lfo_amp_ + delay_;
+            const float  step
+                = (d1 - d0)
+                  * (n == kSubBlock ? 1.f / kSubBlock
+                                    : 1.f / static_cast<float>(n));
+            float d = d0;
+            for(size_t i = 0; i < n; i++)
+            {
+                d += step;
+                const float x   = in[pos + i];
+                const float wet = Read(d);
+                line_.Write(x + wet * feedback_);
+                out[pos + i] = wet;
+            }
+            d0 = d1;
+        }
+    }
+
+    /** Set lfo frequency.
+        \param freq Frequency in Hz
+    */
+    inline void SetLfoFreq(float freq) { lfo_.SetFreq(freq, sample_rate_); }
+
+    /** How much to modulate the delay by, as a part of it.
+        \param depth Works 0-1, clipped at .93.
+    */
+    inline void SetLfoDepth(float depth)
+    {
+        lfo_amp_ = fclamp(depth, 0.f, .93f) * delay_;
+    }
+
+    /** Set the delay time, shortening the sweep to fit if needed.
+        \param samples Delay in samples
+    */
+    inline void SetDelay(float samples)
+    {
+        delay_   = samples;
+        lfo_amp_ = fminf(lfo_amp_, delay_); //clip this if needed
+    }
+
+    /** Set the feedback amount, unclamped.
+        \param feedback Part of the wet signal written back
+    */
+    inline void SetFeedback(float feedback) { feedback_ = feedback; }
+
+  private:
+    static constexpr size_t kMaxSamples = ms_to_samples(max_ms, max_sample_rate);
+    static_assert(kMaxSamples > 1, "max_ms too short at max_sample_rate");
+
+    inline float Read(float delay) const
+    {
+        return line_.Read(delay < max_delay_ ? delay : max_delay_);
+    }
+
+    float sample_rate_;
+    float offset_;
+    float max_delay_;
+    float delay_;
+    float lfo_amp_;
+    float feedback_;
+
+    TriangleLfo                   lfo_;
+    DelayLine<float, kMaxSamples> line_;
+};
+
+template <size_t max_ms, size_t max_sample_rate>
+constexpr size_t ModDelay<max_ms, max_sample_rate>::kStateBytes
+    = sizeof(ModDelay<max_ms, max_sample_rate>);
+} //namespace daisysp
+#endif
+#endif
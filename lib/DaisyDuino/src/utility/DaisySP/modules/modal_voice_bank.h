@@ -0,0 +1,478 @@
+#pragma once
+#ifndef DSY_MODAL_VOICE_BANK_H
+#define DSY_MODAL_VOICE_BANK_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "dsp.h"
+#include "dust.h"
+#include "resonator.h"
+#include "pending_trigger.h"
+#include "semitones.h"
+
+/** @file modal_voice_bank.h */
+
+namespace daisysp
+{
+/** @brief num_voices ModalVoices sharing their exciter and settings.
+
+    Each voice is a ModalVoice body, 24 modes struck at 0.015, with its
+    own pitch; accent, structure, brightness, damping and sustain are the
+    bank's. What N ModalVoices would each work out per sample, the bank
+    works out once:
+
+    - the sustain exciter, one Dust for the whole bank, filled a chunk at
+      a time and read by every voice through its own low-pass;
+    - the excitation filter and mode coefficients, per voice, only when
+      its pitch or a shared setting changes.
+
+    The mode state is kept as arrays per field, each voice's modes in a
+    row, and a voice is run a pair of modes at a time down the whole
+    chunk with their state in registers, where the Resonator steps all
+    its modes once per sample. Voices sleep as in DrumKit, hold_time under
+    the threshold after their strike, and cost nothing until the next;
+    in sustain every voice is excited and none sleeps.
+
+    The sound is ModalVoice's (Process() of a bank of one matches it to
+    float rounding), but for the dust grains in sustain, which all the
+    voices share.
+
+    declaration example:
+
+    ModalVoiceBank<4> bank;
+    bank.Init(sample_rate);
+    ...
+    bank.Strike(mtof(note));
+    bank.ProcessBlock(out, size);
+*/
+template <size_t num_voices>
+class ModalVoiceBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    ModalVoiceBank() {}
+    ~ModalVoiceBank() {}
+
+    static constexpr size_t kNumVoices = num_voices;
+
+    /** Initializes the bank with ModalVoice's defaults, every voice
+        asleep at 440 Hz.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        dust_.Init();
+
+        num_modes_            = Resonator::NumModes(kResolution);
+        const float amplitude = Resonator::ModeAmplitude(kPosition);
+        for(int m = 0; m < Resonator::kMaxNumModes; m++)
+            amplitude_[m] = amplitude;
+
+        clock_      = 0;
+        num_active_ = 0;
+        for(size_t v = 0; v < num_voices; v++)
+        {
+            freq_[v]     = 0.0f;
+            age_[v]      = 0;
+            quiet_[v]    = 0;
+            trig_at_[v].Init();
+            sounding_[v] = false;
+            ex_s1_[v] = ex_s2_[v] = 0.0f;
+            for(int m = 0; m < Resonator::kMaxNumModes; m++)
+                s1_[v][m] = s2_[v][m] = 0.0f;
+            SetFreq(v, 440.f);
+        }
+
+        sustain_    = false;
+        accent_     = .3f;
+        structure_  = .6f;
+        brightness_ = .8f;
+        damping_    = .6f;
+        UpdateShared();
+
+        SetThreshold(1e-4f);
+        SetHoldTime(0.01f);
+    }
+
+    /** Restarts the sustain dust from a given seed, for repeatable
+        output. Call after Init().
+    */
+    void SetSeed(uint32_t seed) { dust_.SetSeed(seed); }
+
+    /** Strikes voice idx, waking it.
+        \param offset Samples into the next ProcessBlock() to strike on;
+               past the block's end it carries into the next. 0, the
+               next sample, by default.
+    */
+    void Trig(size_t idx, size_t offset = 0)
+    {
+        if(idx >= num_voices)
+            return;
+        trig_at_[idx].Set(offset);
+        age_[idx] = ++clock_;
+    }
+
+    /** Pitch of voice idx.
+        \param freq Frequency in Hz
+    */
+    void SetFreq(size_t idx, float freq)
+    {
+        if(idx >= num_voices)
+            return;
+        const float f = freq / sample_rate_;
+        if(f != freq_[idx])
+        {
+            freq_[idx]  = f;
+            f0_[idx]    = fclamp(f, 0.f, .25f);
+            dirty_[idx] = true;
+        }
+    }
+
+    /** Strikes a sleeping voice, else the one struck longest ago, at freq.
+        \param freq Frequency in Hz
+        \param offset As Trig()
+        \return the voice struck
+    */
+    size_t Strike(float freq, size_t offset = 0)
+    {
+        size_t idx = 0;
+        for(size_t v = 1; v < num_voices; v++)
+        {
+            if(Busy(v) != Busy(idx) ? !Busy(v) : age_[v] < age_[idx])
+                idx = v;
+        }
+        SetFreq(idx, freq);
+        Trig(idx, offset);
+        return idx;
+    }
+
+    /** Sets whether every voice is continually excited, as ModalVoice */
+    void SetSustain(bool sustain)
+    {
+        if(sustain != sustain_)
+        {
+            sustain_ = sustain;
+            UpdateShared();
+        }
+    }
+
+    /** Strike accent, 0-1 */
+    void SetAccent(float accent)
+    {
+        accent = fclamp(accent, 0.f, 1.f);
+        if(accent != accent_)
+        {
+            accent_ = accent;
+            UpdateShared();
+        }
+    }
+
+    /** Stiffness of the bodies, 0-1 */
+    void SetStructure(float structure)
+    {
+        structure = fclamp(structure, 0.f, 1.f);
+        if(structure != structure_)
+        {
+            structure_ = structure;
+            UpdateShared();
+        }
+    }
+
+    /** Brightness of the bodies, and the density of the sustain dust, 0-1 */
+    void SetBrightness(float brightness)
+    {
+        brightness = fclamp(brightness, 0.f, 1.f);
+        if(brightness != brightness_)
+        {
+            brightness_ = brightness;
+            UpdateShared();
+        }
+    }
+
+    /** Decay of the bodies, 0-1 */
+    void SetDamping(float damping)
+    {
+        damping = fclamp(damping, 0.f, 1.f);
+        if(damping != damping_)
+        {
+            damping_ = damping;
+            UpdateShared();
+        }
+    }
+
+    /** The level under which a voice counts as silent, as DrumKit.
+        \param threshold Linear, 1e-4 (-80 dBFS) by default
+    */
+    inline void SetThreshold(float threshold) { threshold_ = threshold; }
+
+    /** How long a voice must stay under the threshold before it sleeps.
+        \param seconds 10 ms by default
+    */
+    inline void SetHoldTime(float seconds)
+    {
+        const float n = seconds * sample_rate_;
+        hold_         = n > 1.0f ? static_cast<uint32_t>(n) : 1;
+    }
+
+    /** \return whether voice idx is sounding (is processed) */
+    inline bool IsSounding(size_t idx) const
+    {
+        return idx < num_voices && sounding_[idx];
+    }
+
+    /** \return voices sounding after the last ProcessBlock */
+    inline size_t GetActiveCount() const { return num_active_; }
+
+    /** Fills out with the sum of the voices. */
+    void ProcessBlock(float *out, size_t size)
+    {
+        for(size_t j = 0; j < size; j++)
+            out[j] = 0.0f;
+        if(sustain_)
+        {
+            for(size_t v = 0; v < num_voices; v++)
+                Wake(v);
+        }
+        bool busy = false;
+        for(size_t v = 0; v < num_voices; v++)
+            busy |= Busy(v);
+        if(!busy)
+            return;
+
+        float        dust[kChunkSize];
+        const float *excite = sustain_ ? dust : nullptr;
+        for(size_t pos = 0; pos < size; pos += kChunkSize)
+        {
+            const size_t n = size - pos < kChunkSize ? size - pos : kChunkSize;
+            if(excite)
+            {
+                for(size_t j = 0; j < n; j++)
+                    dust[j] = dust_.Process() * dust_gain_;
+            }
+            for(size_t v = 0; v < num_voices; v++)
+            {
+                const size_t at = trig_at_[v].Advance(n);
+                if(at < n)
+                {
+                    quiet_[v] = 0;
+                    Wake(v);
+                }
+                if(sounding_[v])
+                    Render(v, excite, at, out + pos, n);
+            }
+        }
+    }
+
+    /** \return one sample of the sum of the voices, through ProcessBlock() */
+    float Process()
+    {
+        float out;
+        ProcessBlock(&out, 1);
+        return out;
+    }
+
+  private:
+    static constexpr size_t kChunkSize  = 32;
+    static constexpr int    kResolution = 24;
+    static constexpr float  kPosition   = 0.015f;
+
+    /** The settings every voice shares, with ModalVoice's accent */
+    void UpdateShared()
+    {
+        brightness_eff_ = brightness_ + 0.25f * accent_ * (1.0f - brightness_);
+        damping_eff_    = damping_ + 0.25f * accent_ * (1.0f - damping_);
+
+        const float density = brightness_ * brightness_;
+        const float dust_f  = 0.00005f + 0.99995f * density * density;
+        dust_.SetDensity(dust_f);
+        dust_gain_ = (4.0f - dust_f * 3.0f) * accent_;
+
+        for(size_t v = 0; v < num_voices; v++)
+            dirty_[v] = true;
+    }
+
+    /** Voice v's excitation filter, strike and modes */
+    void Update(size_t v)
+    {
+        const float b      = brightness_eff_;
+        const float range  = sustain_ ? 36.0f : 60.0f;
+        const float f      = sustain_ ? 4.0f * f0_[v] : 2.0f * f0_[v];
+        const float cutoff = fmin(
+            f * SemitonesToRatio((b * (2.0f - b) - 0.5f) * range), 0.499f);
+        const float q = sustain_ ? 0.7f : 1.5f;
+
+        // ResonatorSvf<1>, low-pass.
+        const float g = ResonatorSvf<1>::fasttan(cutoff);
+        const float r = 1.0f / q;
+        ex_g_[v]      = g;
+        ex_h_[v]      = 1.0f / (1.0f + r * g + g * g);
+        ex_r_plus_g_[v] = r + g;
+
+        const float attenuation = 1.0f - damping_eff_ * 0.5f;
+        const float amplitude   = (0.12f + 0.08f * accent_) * attenuation;
+        strike_[v]
+            = amplitude * SemitonesToRatio(cutoff * cutoff * 24.0f) / cutoff;
+
+        Resonator::ComputeModes(freq_[v],
+                                structure_,
+                                brightness_eff_,
+                                damping_eff_,
+                                amplitude_,
+                                num_modes_,
+                                g_[v],
+                                r_plus_g_[v],
+                                h_[v],
+                                gain_[v]);
+        dirty_[v] = false;
+    }
+
+    /** Adds n samples of voice v into out, excited by dust in sustain
+        (nullptr otherwise), else struck on sample at if it is under n */
+    void
+    Render(size_t v, const float *dust, size_t at, float *out, size_t n)
+    {
+        if(dirty_[v])
+            Update(v);
+
+        // The excitation: the shared dust or the strike, low-passed.
+        float e[kChunkSize];
+        if(dust)
+        {
+            for(size_t j = 0; j < n; j++)
+                e[j] = dust[j];
+        }
+        else
+        {
+            for(size_t j = 0; j < n; j++)
+                e[j] = 0.0f;
+            if(at < n)
+                e[at] = strike_[v];
+        }
+        {
+            const float g = ex_g_[v], r_plus_g = ex_r_plus_g_[v], h = ex_h_[v];
+            float       s1 = ex_s1_[v], s2 = ex_s2_[v];
+            for(size_t j = 0; j < n; j++)
+            {
+                const float hp = (e[j] - r_plus_g * s1 - s2) * h;
+                const float bp = g * hp + s1;
+                s1             = g * hp + bp;
+                const float lp = g * bp + s2;
+                s2             = g * bp + lp;
+                e[j]           = lp;
+            }
+            ex_s1_[v] = s1;
+            ex_s2_[v] = s2;
+        }
+
+        // The modes, two at a time down the chunk.
+        float y[kChunkSize];
+        for(size_t j = 0; j < n; j++)
+            y[j] = 0.0f;
+        for(int m = 0; m < num_modes_; m += 2)
+        {
+            const float ga = g_[v][m], gb = g_[v][m + 1];
+            const float ra = r_plus_g_[v][m], rb = r_plus_g_[v][m + 1];
+            const float ha = h_[v][m], hb = h_[v][m + 1];
+            const float ka = gain_[v][m], kb = gain_[v][m + 1];
+            float       a1 = s1_[v][m], a2 = s2_[v][m];
+            float       b1 = s1_[v][m + 1], b2 = s2_[v][m + 1];
+            for(size_t j = 0; j < n; j++)
+            {
+                const float x   = e[j];
+                const float ahp = (x - ra * a1 - a2) * ha;
+                const float abp = ga * ahp + a1;
+                a1              = ga * ahp + abp;
+                const float alp = ga * abp + a2;
+                a2              = ga * abp + alp;
+                const float bhp = (x - rb * b1 - b2) * hb;
+                const float bbp = gb * bhp + b1;
+                b1              = gb * bhp + bbp;
+                const float blp = gb * bbp + b2;
+                b2              = gb * bbp + blp;
+                y[j] += ka * abp + kb * bbp;
+            }
+            s1_[v][m]     = a1;
+            s2_[v][m]     = a2;
+            s1_[v][m + 1] = b1;
+            s2_[v][m + 1] = b2;
+        }
+
+        const float threshold = threshold_;
+        uint32_t    quiet     = quiet_[v];
+        for(size_t j = 0; j < n; j++)
+        {
+            out[j] += y[j];
+            quiet = fabsf(y[j]) < threshold ? quiet + 1 : 0;
+        }
+        quiet_[v] = quiet;
+        if(!sustain_ && quiet >= hold_)
+            Sleep(v);
+    }
+
+    /** Sounding, or struck and waiting for its offset */
+    inline bool Busy(size_t v) const
+    {
+        return sounding_[v] || trig_at_[v].IsPending();
+    }
+
+    inline void Wake(size_t v)
+    {
+        if(!sounding_[v])
+        {
+            sounding_[v] = true;
+            num_active_++;
+        }
+    }
+
+    inline void Sleep(size_t v)
+    {
+        sounding_[v] = false;
+        num_active_--;
+    }
+
+    float sample_rate_;
+    int   num_modes_;
+    float amplitude_[Resonator::kMaxNumModes];
+    Dust  dust_;
+    float dust_gain_;
+
+    bool  sustain_;
+    float accent_, structure_, brightness_, damping_;
+    float brightness_eff_, damping_eff_; // with the accent
+
+    // Per voice.
+    float    freq_[num_voices]; // cycles per sample, for the modes
+    float    f0_[num_voices];   // the same clamped, for the excitation
+    uint32_t age_[num_voices];  // clock_ at the last strike
+    uint32_t quiet_[num_voices];
+    PendingTrigger trig_at_[num_voices];
+    bool     sounding_[num_voices];
+    bool     dirty_[num_voices];
+    float    strike_[num_voices];
+    float    ex_g_[num_voices], ex_r_plus_g_[num_voices], ex_h_[num_voices];
+    float    ex_s1_[num_voices], ex_s2_[num_voices];
+
+    // Per voice and mode, see Resonator::ComputeModes().
+    float g_[num_voices][Resonator::kMaxNumModes];
+    float r_plus_g_[num_voices][Resonator::kMaxNumModes];
+    float h_[num_voices][Resonator::kMaxNumModes];
+    float gain_[num_voices][Resonator::kMaxNumModes];
+    float s1_[num_voices][Resonator::kMaxNumModes];
+    float s2_[num_voices][Resonator::kMaxNumModes];
+
+    uint32_t clock_;
+    size_t   num_active_;
+    float    threshold_;
+    uint32_t hold_;
+};
+
+template <size_t num_voices>
+constexpr size_t ModalVoiceBank<num_voices>::kStateBytes
+    = sizeof(ModalVoiceBank<num_voices>);
+} // namespace daisysp
+#endif
+#endif
@@ -1,4 +1,5 @@
 #include "modalvoice.h"
+#include "semitones.h"
 #include <algorithm>
 
 using namespace daisysp;
@@ -73,9 +74,8 @@ float ModalVoice::Process(bool trigger)
     const float f      = sustain_ ? 4.0f * f0_ : 2.0f * f0_;
     const float cutoff = fmin(
         f
-            * powf(2.f,
-                   kOneTwelfth
-                       * ((brightness * (2.0f - brightness) - 0.5f) * range)),
+            * SemitonesToRatio((brightness * (2.0f - brightness) - 0.5f)
+                               * range),
         0.499f);
     const float q = sustain_ ? 0.7f : 1.5f;
 
@@ -91,7 +91,7 @@ float ModalVoice::Process(bool trigger)
     {
         const float attenuation = 1.0f - damping * 0.5f;
         const float amplitude   = (0.12f + 0.08f * accent_) * attenuation;
-        temp = amplitude * powf(2.f, kOneTwelfth * (cutoff * cutoff * 24.0f))
+        temp = amplitude * SemitonesToRatio(cutoff * cutoff * 24.0f)
                / cutoff;
         trig_ = false;
     }
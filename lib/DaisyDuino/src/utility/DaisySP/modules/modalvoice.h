@@ -25,6 +25,8 @@ namespace daisysp
 class ModalVoice
 {
   public:
+    static const size_t kStateBytes;
+
     ModalVoice() {}
     ~ModalVoice() {}
 
@@ -86,6 +88,8 @@ class ModalVoice
     Resonator       resonator_;
     Dust            dust_;
 };
+
+inline constexpr size_t ModalVoice::kStateBytes = sizeof(ModalVoice);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #ifndef DAISY_MODE
 #define DAISY_MODE
+#include <stddef.h>
 
 namespace daisysp
 {
@@ -19,6 +20,8 @@ namespace daisysp
 class Mode
 {
   public:
+    static const size_t kStateBytes;
+
     Mode() {}
     ~Mode() {}
     /** Initializes the instance of the module.
@@ -48,6 +51,8 @@ class Mode
     float xnm1_, ynm1_, ynm2_, a0_, a1_, a2_;
     float d_, lfq_, lq_, sr_;
 };
+
+inline constexpr size_t Mode::kStateBytes = sizeof(Mode);
 } // namespace daisysp
 
 #endif
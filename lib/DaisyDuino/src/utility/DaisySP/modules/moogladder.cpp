@@ -3,6 +3,8 @@
 
 using namespace daisysp;
 
+static constexpr float kThermal = 0.000025f;
+
 float MoogLadder::my_tanh(float x)
 {
     int sign = 1;
@@ -20,7 +22,15 @@ float MoogLadder::my_tanh(float x)
     {
         return x * sign;
     }
-    return sign * tanhf(x);
+    return sign * math::tanh(x);
+}
+
+float MoogLadder::fast_tanh(float x)
+{
+    // Pade (3,2) of tanh, reaching +/-1 with zero slope at |x| = 3.
+    x             = fclamp(x, -3.0f, 3.0f);
+    const float x2 = x * x;
+    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
 }
 
 void MoogLadder::Init(float sample_rate)
@@ -29,6 +39,7 @@ void MoogLadder::Init(float sample_rate)
     istor_       = 0.0f;
     res_         = 0.4f;
     freq_        = 1000.0f;
+    fast_tanh_   = false;
 
     for(int i = 0; i < 6; i++)
     {
@@ -36,66 +47,55 @@ void MoogLadder::Init(float sample_rate)
         tanhstg_[i % 3] = 0.0;
     }
 
-    old_freq_ = 0.0f;
-    old_res_  = -1.0f;
+    UpdateCoeffs();
 }
 
-float MoogLadder::Process(float in)
+void MoogLadder::SetFreq(float freq)
 {
-    float  freq = freq_;
-    float  res  = res_;
-    float  res4;
-    float* delay   = delay_;
-    float* tanhstg = tanhstg_;
-    float  stg[4];
-    float  acr, tune;
-
-    float THERMAL = 0.000025;
+    freq_ = freq;
+    UpdateCoeffs();
+}
 
-    if(res < 0)
-    {
-        res = 0;
-    }
+void MoogLadder::SetRes(float res)
+{
+    res_ = res < 0.0f ? 0.0f : res;
+    UpdateCoeffs();
+}
 
-    if(old_freq_ != freq || old_res_ != res)
-    {
-        float f, fc, fc2, fc3, fcr;
-        old_freq_ = freq;
-        fc        = (freq / sample_rate_);
-        f         = 0.5f * fc;
-        fc2       = fc * fc;
-        fc3       = fc2 * fc2;
-
-        fcr  = 1.8730f * fc3 + 0.4955f * fc2 - 0.6490f * fc + 0.9988f;
-        acr  = -3.9364f * fc2 + 1.8409f * fc + 0.9968f;
-        tune = (1.0f - expf(-((2 * PI_F) * f * fcr))) / THERMAL;
-
-        old_res_  = res;
-        old_acr_  = acr;
-        old_tune_ = tune;
-    }
-    else
-    {
-        res  = old_res_;
-        acr  = old_acr_;
-        tune = old_tune_;
-    }
+void MoogLadder::UpdateCoeffs()
+{
+    float f, fc, fc2, fc3, fcr;
+    fc  = (freq_ / sample_rate_);
+    f   = 0.5f * fc;
+    fc2 = fc * fc;
+    fc3 = fc2 * fc2;
 
-    res4 = 4.0f * res * acr;
+    fcr   = 1.8730f * fc3 + 0.4955f * fc2 - 0.6490f * fc + 0.9988f;
+    acr_  = -3.9364f * fc2 + 1.8409f * fc + 0.9968f;
+    tune_ = (1.0f - math::exp(-((2 * PI_F) * f * fcr))) / kThermal;
+}
 
+template <bool fast>
+inline float MoogLadder::Run(float  in,
+                             float  res4,
+                             float  tune,
+                             float* delay,
+                             float* tanhstg)
+{
+    float stg[4];
     for(int j = 0; j < 2; j++)
     {
         in -= res4 * delay[5];
         delay[0] = stg[0]
-            = delay[0] + tune * (my_tanh(in * THERMAL) - tanhstg[0]);
+            = delay[0] + tune * (Tanh<fast>(in * kThermal) - tanhstg[0]);
         for(int k = 1; k < 4; k++)
         {
             in     = stg[k - 1];
             stg[k] = delay[k]
                      + tune
-                           * ((tanhstg[k - 1] = my_tanh(in * THERMAL))
+                           * ((tanhstg[k - 1] = Tanh<fast>(in * kThermal))
                               - (k != 3 ? tanhstg[k]
-                                        : my_tanh(delay[k] * THERMAL)));
+                                        : Tanh<fast>(delay[k] * kThermal)));
             delay[k] = stg[k];
         }
         delay[5] = (stg[3] + delay[4]) * 0.5f;
@@ -103,3 +103,41 @@ float MoogLadder::Process(float in)
     }
     return delay[5];
 }
+
+float MoogLadder::Process(float in)
+{
+    const float res4 = 4.0f * res_ * acr_;
+    return fast_tanh_ ? Run<true>(in, res4, tune_, delay_, tanhstg_)
+                      : Run<false>(in, res4, tune_, delay_, tanhstg_);
+}
+
+template <bool fast>
+void MoogLadder::RunBlock(const float* in, float* out, size_t size)
+{
+    const float res4 = 4.0f * res_ * acr_;
+    const float tune = tune_;
+    float       delay[6], tanhstg[3];
+
+    for(int k = 0; k < 6; k++)
+        delay[k] = delay_[k];
+    for(int k = 0; k < 3; k++)
+        tanhstg[k] = tanhstg_[k];
+
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = Run<fast>(in[i], res4, tune, delay, tanhstg);
+    }
+
+    for(int k = 0; k < 6; k++)
+        delay_[k] = delay[k];
+    for(int k = 0; k < 3; k++)
+        tanhstg_[k] = tanhstg[k];
+}
+
+void MoogLadder::ProcessBlock(const float* in, float* out, size_t size)
+{
+    if(fast_tanh_)
+        RunBlock<true>(in, out, size);
+    else
+        RunBlock<false>(in, out, size);
+}
@@ -3,6 +3,7 @@
 #define DSY_MOOGLADDER_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -17,6 +18,8 @@ Original author(s) : Victor Lazzarini, John ffitch (fast tanh), Bob Moog
 class MoogLadder
 {
   public:
+    static const size_t kStateBytes;
+
     MoogLadder() {}
     ~MoogLadder() {}
     /** Initializes the MoogLadder module.
@@ -29,22 +32,54 @@ class MoogLadder
     */
     float Process(float in);
 
+    /** Processes a block, the same as Process() on each sample.
+        out may be in.
+    */
+    void ProcessBlock(const float* in, float* out, size_t size);
+
     /** 
         Sets the cutoff frequency or half-way point of the filter.
+        Computes the tuning (one expf), so call it at control rate.
         Arguments
         - freq - frequency value in Hz. Range: Any positive value.
     */
-    inline void SetFreq(float freq) { freq_ = freq; }
+    void SetFreq(float freq);
     /** 
         Sets the resonance of the filter.
     */
-    inline void SetRes(float res) { res_ = res; }
+    void SetRes(float res);
+
+    /** Swaps the stage saturation from tanhf to a clamped rational
+        approximation, within 0.025 of tanh and much cheaper. It also
+        saturates negative swings, which the default passes linearly.
+        Off after Init().
+    */
+    inline void SetFastTanh(bool fast) { fast_tanh_ = fast; }
 
   private:
-    float istor_, res_, freq_, delay_[6], tanhstg_[3], old_freq_, old_res_,
-        sample_rate_, old_acr_, old_tune_;
-    float my_tanh(float x);
+    float istor_, res_, freq_, delay_[6], tanhstg_[3], sample_rate_, acr_,
+        tune_;
+    bool fast_tanh_;
+
+    void         UpdateCoeffs();
+    static float my_tanh(float x);
+    static float fast_tanh(float x);
+
+    template <bool fast>
+    static inline float Tanh(float x)
+    {
+        return fast ? fast_tanh(x) : my_tanh(x);
+    }
+
+    template <bool fast>
+    inline float
+    Run(float in, float res4, float tune, float* delay, float* tanhstg);
+
+    template <bool fast>
+    void RunBlock(const float* in, float* out, size_t size);
 };
+
+inline constexpr size_t MoogLadder::kStateBytes = sizeof(MoogLadder);
 } // namespace daisysp
 #endif
 #endif
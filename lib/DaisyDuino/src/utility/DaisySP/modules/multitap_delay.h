@@ -0,0 +1,145 @@
+#pragma once
+#ifndef DSY_MULTITAP_DELAY_H
+#define DSY_MULTITAP_DELAY_H
+#include <stdlib.h>
+#include <stdint.h>
+#include "dsp.h"
+namespace daisysp
+{
+/** Delay line with several fractional read taps.
+
+One Write() per sample feeds every tap, and each tap keeps its integer
+and fractional delay from SetDelay(), so a read is two loads and a lerp
+off the shared write position. Multi-voice chorus and multitap echo
+then cost one line instead of one per voice.
+
+Storage is rounded up to a power of two, as for DelayLine; the usable
+delay is max_size - 1 samples per tap.
+
+declaration example: (4 taps over 1 second of floats, in SDRAM)
+
+MultiTapDelay<float, 48000, 4> DSY_SDRAM_BSS echo;
+*/
+template <typename T, size_t max_size, size_t taps>
+class MultiTapDelay
+{
+  public:
+    static const size_t kStateBytes;
+
+    MultiTapDelay() {}
+    ~MultiTapDelay() {}
+
+    /** initializes the line by clearing the values within, and setting
+        every tap to 1 sample.
+    */
+    void Init() { Reset(); }
+
+    /** as Init(), for memory that already reads as zero: skips the
+        pass over the buffer.
+    */
+    void Init(ZeroedMemory) { Restart(); }
+
+    /** clears buffer, sets write ptr to 0, and every tap to 1 sample.
+    */
+    void Reset()
+    {
+        for(size_t i = 0; i < kSize; i++)
+        {
+            line_[i] = T(0);
+        }
+        Restart();
+    }
+
+    /** sets one tap's delay in samples, with a fractional part
+        interpolated linearly.
+    */
+    inline void SetDelay(size_t tap, float delay)
+    {
+        int32_t int_delay = static_cast<int32_t>(delay);
+        frac_[tap]        = delay - static_cast<float>(int_delay);
+        delay_[tap]       = static_cast<size_t>(int_delay) < max_size
+                                ? int_delay
+                                : max_size - 1;
+    }
+
+    /** sets every tap's delay in samples, from delays[taps] */
+    inline void SetDelays(const float* delays)
+    {
+        for(size_t t = 0; t < taps; t++)
+        {
+            SetDelay(t, delays[t]);
+        }
+    }
+
+    /** writes the sample of type T to the line, and advances the write ptr
+    */
+    inline void Write(const T sample)
+    {
+        line_[write_ptr_] = sample;
+        write_ptr_        = (write_ptr_ - 1) & kMask;
+    }
+
+    /** returns one tap's next sample */
+    inline const T Read(size_t tap) const
+    {
+        const size_t p = write_ptr_ + delay_[tap];
+        const T      a = line_[p & kMask];
+        const T      b = line_[(p + 1) & kMask];
+        return a + (b - a) * frac_[tap];
+    }
+
+    /** reads every tap's next sample into out[taps] */
+    inline void Read(T* out) const
+    {
+        for(size_t t = 0; t < taps; t++)
+        {
+            out[t] = Read(t);
+        }
+    }
+
+    /** returns the taps mixed by gains[taps], as for a multitap echo */
+    inline const T ReadMix(const float* gains) const
+    {
+        T sum = T(0);
+        for(size_t t = 0; t < taps; t++)
+        {
+            sum += Read(t) * gains[t];
+        }
+        return sum;
+    }
+
+    static constexpr size_t GetTaps() { return taps; }
+
+  private:
+    void Restart()
+    {
+        for(size_t t = 0; t < taps; t++)
+        {
+            delay_[t] = 1;
+            frac_[t]  = 0.0f;
+        }
+        write_ptr_ = 0;
+    }
+
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t kSize = RoundUp(max_size);
+    static constexpr size_t kMask = kSize - 1;
+
+    size_t write_ptr_;
+    size_t delay_[taps];
+    float  frac_[taps];
+    T      line_[kSize];
+};
+
+template <typename T, size_t max_size, size_t taps>
+constexpr size_t MultiTapDelay<T, max_size, taps>::kStateBytes
+    = sizeof(MultiTapDelay<T, max_size, taps>);
+} // namespace daisysp
+#endif
@@ -0,0 +1,119 @@
+#include <math.h>
+#include <string.h>
+#include "dsp.h"
+#include "nco.h"
+
+using namespace daisysp;
+
+#if !defined(DSY_NCO_LUT_FLASH)
+float DSY_NCO_LUT_SECTION Nco::sine_table_[Nco::kTableSize + 1];
+#endif
+bool Nco::table_ready_ = false;
+
+void Nco::BuildTable()
+{
+    // Once at Init, never from the ISR. kSineTable was computed (in
+    // double) by the compiler; this only moves it to its section.
+#if !defined(DSY_NCO_LUT_FLASH)
+    memcpy(sine_table_, kSineTable.data(), sizeof(sine_table_));
+#endif
+    table_ready_ = true;
+}
+
+void Nco::Init(float sample_rate, Backend backend)
+{
+    if(!table_ready_)
+        BuildTable();
+    sample_rate_ = sample_rate;
+    backend_     = backend;
+    phase_       = 0;
+    phase_inc_   = 0;
+    UpdateRotation();
+}
+
+uint32_t Nco::FreqToPhaseInc(float freq, float sample_rate)
+{
+    // Wrap into [0, 1) cycles per sample, then scale to 2^32.
+    double ratio = static_cast<double>(freq) / static_cast<double>(sample_rate);
+    ratio -= floor(ratio);
+    return static_cast<uint32_t>(ratio * 4294967296.0 + 0.5);
+}
+
+void Nco::SetFreq(float freq)
+{
+    phase_inc_ = FreqToPhaseInc(freq, sample_rate_);
+    UpdateRotation();
+}
+
+void Nco::UpdateRotation()
+{
+    SinCosPrecise(phase_inc_, rot_s_, rot_c_);
+}
+
+void Nco::SinCosPrecise(uint32_t phase, float &s, float &c)
+{
+    const uint32_t idx = phase >> kFracBits;
+    const float    d   = static_cast<float>(phase & kFracMask)
+                    * (TWOPI_F / static_cast<float>(1ull << 32));
+    const float s0 = sine_table_[idx];
+    const float c0 = sine_table_[(idx + kTableSize / 4) & (kTableSize - 1)];
+    const float d2 = d * d;
+    const float cd = 1.0f - 0.5f * d2;
+    const float sd = d * (1.0f - d2 * (1.0f / 6.0f));
+    s              = s0 * cd + c0 * sd;
+    c              = c0 * cd - s0 * sd;
+}
+
+void Nco::ProcessBlock(float *sin_out, float *cos_out, size_t size)
+{
+    if(backend_ == Backend::LUT)
+    {
+        uint32_t       phase = phase_;
+        const uint32_t inc   = phase_inc_;
+        if(cos_out != nullptr)
+        {
+            for(size_t i = 0; i < size; i++)
+            {
+                sin_out[i] = Sin(phase);
+                cos_out[i] = Sin(phase + kQuarterTurn);
+                phase += inc;
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < size; i++)
+            {
+                sin_out[i] = Sin(phase);
+                phase += inc;
+            }
+        }
+        phase_ = phase;
+        return;
+    }
+
+    // ROTATION: seed from the exact phase so nothing accumulates.
+    float       s, c;
+    const float rc = rot_c_, rs = rot_s_;
+    SinCosPrecise(phase_, s, c);
+    size_t i = 0;
+    while(i < size)
+    {
+        const size_t end
+            = (size - i) > kRenormInterval ? i + kRenormInterval : size;
+        for(; i < end; i++)
+        {
+            sin_out[i] = s;
+            if(cos_out != nullptr)
+                cos_out[i] = c;
+            const float ns = s * rc + c * rs;
+            const float nc = c * rc - s * rs;
+            s              = ns;
+            c              = nc;
+        }
+        // First order Newton step towards |(c, s)| == 1.
+        const float g = 1.5f - 0.5f * (s * s + c * c);
+        s *= g;
+        c *= g;
+    }
+    phase_ += phase_inc_ * static_cast<uint32_t>(size);
+}
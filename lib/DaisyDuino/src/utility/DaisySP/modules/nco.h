@@ -0,0 +1,179 @@
+#pragma once
+#ifndef DSY_NCO_H
+#define DSY_NCO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include "const_table.h"
+#ifdef __cplusplus
+
+/** Memory section for the shared sine table.
+    Defaults to DTCM on ARM (zero wait states, not touched by the D-cache).
+    Define before including daisysp.h to override. The table is computed
+    at compile time into flash and copied here by the first Init(); with
+    DSY_NCO_LUT_FLASH defined, the Nco reads the flash copy instead and
+    the section is not used.
+*/
+#ifndef DSY_NCO_LUT_SECTION
+#if defined(__arm__)
+#define DSY_NCO_LUT_SECTION __attribute__((section(".dtcmram_bss")))
+#else
+#define DSY_NCO_LUT_SECTION
+#endif
+#endif
+
+namespace daisysp
+{
+/** Quadrature numerically controlled oscillator (sine + cosine).
+
+    The phase is an unsigned 32-bit accumulator, so it wraps exactly and
+    never drifts no matter how long the oscillator runs. The frequency
+    resolution is sample_rate / 2^32 (about 22 uHz at 96 kHz).
+
+    Two backends, selected at Init():
+    - LUT: reads a 1024-point sine table with linear interpolation.
+      The cosine is the same table a quarter turn ahead.
+      Worst-case error is about 5e-6 (-106 dB).
+    - ROTATION: multiplies a unit phasor by a fixed rotation each sample
+      (4 multiplies, 2 adds). It is renormalised every 64 samples and
+      re-seeded from the exact phase at the start of every block, so
+      amplitude and phase errors cannot accumulate across blocks.
+
+    Neither backend calls libm after Init().
+*/
+class Nco
+{
+  public:
+    static const size_t kStateBytes;
+
+    Nco() {}
+    ~Nco() {}
+
+    enum class Backend
+    {
+        LUT,
+        ROTATION,
+    };
+
+    /** Initializes the oscillator at 0 Hz and phase 0.
+        The first call also builds the shared sine table.
+        \param sample_rate - rate at which Process() / ProcessBlock() run
+        \param backend - sine generation method, see class description
+    */
+    void Init(float sample_rate, Backend backend = Backend::LUT);
+
+    /** Sets the oscillator frequency in Hz. Negative values run backwards. */
+    void SetFreq(float freq);
+
+    /** Sets the raw 32-bit phase increment (2^32 == one cycle per sample). */
+    inline void SetPhaseInc(uint32_t inc)
+    {
+        phase_inc_ = inc;
+        UpdateRotation();
+    }
+
+    /** Returns the raw 32-bit phase increment. */
+    inline uint32_t GetPhaseInc() const { return phase_inc_; }
+
+    /** Sets the raw 32-bit phase (2^32 == one cycle). */
+    inline void SetPhase(uint32_t phase) { phase_ = phase; }
+
+    /** Returns the raw 32-bit phase of the next sample to be generated. */
+    inline uint32_t GetPhase() const { return phase_; }
+
+    /** Returns the selected backend. */
+    inline Backend GetBackend() const { return backend_; }
+
+    /** Generates one sine sample and advances the phase. */
+    inline float Process()
+    {
+        const float s = Sin(phase_);
+        phase_ += phase_inc_;
+        return s;
+    }
+
+    /** Generates one quadrature sample and advances the phase.
+        \param s - receives sin(phase)
+        \param c - receives cos(phase)
+    */
+    inline void Process(float &s, float &c)
+    {
+        s = Sin(phase_);
+        c = Sin(phase_ + kQuarterTurn);
+        phase_ += phase_inc_;
+    }
+
+    /** Generates a block of sine and (optionally) cosine samples.
+        \param sin_out - receives size sine samples
+        \param cos_out - receives size cosine samples, may be nullptr
+        \param size - number of samples
+    */
+    void ProcessBlock(float *sin_out, float *cos_out, size_t size);
+
+    /** Interpolated table sine of a raw 32-bit phase. */
+    static inline float Sin(uint32_t phase)
+    {
+        const uint32_t idx  = phase >> kFracBits;
+        const float    frac = static_cast<float>(phase & kFracMask) * kFracScale;
+        const float    a    = sine_table_[idx];
+        const float    b    = sine_table_[idx + 1];
+        return a + (b - a) * frac;
+    }
+
+    /** Interpolated table cosine of a raw 32-bit phase. */
+    static inline float Cos(uint32_t phase) { return Sin(phase + kQuarterTurn); }
+
+    /** Copies the shared sine table in if no Nco::Init() has yet. Setup
+        only. */
+    static inline void InitTable()
+    {
+        if(!table_ready_)
+            BuildTable();
+    }
+
+    /** Converts a frequency to a raw 32-bit phase increment. */
+    static uint32_t FreqToPhaseInc(float freq, float sample_rate);
+
+    static constexpr size_t   kTableBits   = 10;
+    static constexpr size_t   kTableSize   = 1u << kTableBits;
+    static constexpr uint32_t kQuarterTurn = 0x40000000u;
+
+    /** The sine table as the compiler computed it, in flash. */
+    static constexpr std::array<float, kTableSize + 1> kSineTable
+        = ConstTable::Sine<kTableSize>();
+
+  private:
+    static constexpr uint32_t kFracBits = 32 - kTableBits;
+    static constexpr uint32_t kFracMask = (1u << kFracBits) - 1u;
+    static constexpr float    kFracScale
+        = 1.0f / static_cast<float>(1u << kFracBits);
+    static constexpr size_t kRenormInterval = 64;
+
+    static void BuildTable();
+    void        UpdateRotation();
+
+    /** Near-exact sin/cos of a raw phase: table lookup at the nearest
+        lower entry plus a third order angle-addition correction.
+        Used to seed the rotation backend; error < 1e-8. */
+    static void SinCosPrecise(uint32_t phase, float &s, float &c);
+
+#if defined(DSY_NCO_LUT_FLASH)
+    static constexpr const float *sine_table_ = kSineTable.data();
+#else
+    static float sine_table_[kTableSize + 1];
+#endif
+    static bool table_ready_;
+
+    float    sample_rate_;
+    uint32_t phase_;
+    uint32_t phase_inc_;
+    Backend  backend_;
+    float    rot_c_, rot_s_; /**< cos/sin of the per-sample phase step */
+};
+
+inline constexpr size_t Nco::kStateBytes = sizeof(Nco);
+
+} // namespace daisysp
+#endif
+#endif
@@ -30,6 +30,8 @@ namespace daisysp
 class NlFilt
 {
   public:
+    static const size_t kStateBytes;
+
     /** Initializes the NlFilt object.
         */
     void Init();
@@ -75,6 +77,8 @@ class NlFilt
     float   delay_[DSY_NLFILT_MAX_DELAY];
     int32_t point_;
 };
+
+inline constexpr size_t NlFilt::kStateBytes = sizeof(NlFilt);
 } // namespace daisysp
 
 #endif
@@ -1,51 +1,94 @@
 #include "dsp.h"
+#include "fast_sin.h"
 #include "oscillator.h"
 
 using namespace daisysp;
-static inline float Polyblep(float phase_inc, float t);
+static inline float Polyblep(float dt, float t);
 
 constexpr float TWO_PI_RECIP = 1.0f / TWOPI_F;
 
-float Oscillator::Process()
+/** One sample of waveform wf at phase, before the amplitude.
+    dt is phase_inc * TWO_PI_RECIP, for the PolyBLEP corrections. */
+template <uint8_t wf>
+static inline float
+Render(float phase, float phase_inc, float dt, float &last_out)
 {
     float out, t;
-    switch(waveform_)
+    switch(wf)
     {
-        case WAVE_SIN: out = sinf(phase_); break;
-        case WAVE_TRI:
-            t   = -1.0f + (2.0f * phase_ * TWO_PI_RECIP);
+        case Oscillator::WAVE_SIN: out = FastSin::Sin(phase * TWO_PI_RECIP); break;
+        case Oscillator::WAVE_TRI:
+            t   = -1.0f + (2.0f * phase * TWO_PI_RECIP);
             out = 2.0f * (fabsf(t) - 0.5f);
             break;
-        case WAVE_SAW:
-            out = -1.0f * (((phase_ * TWO_PI_RECIP * 2.0f)) - 1.0f);
+        case Oscillator::WAVE_SAW:
+            out = -1.0f * (((phase * TWO_PI_RECIP * 2.0f)) - 1.0f);
             break;
-        case WAVE_RAMP: out = ((phase_ * TWO_PI_RECIP * 2.0f)) - 1.0f; break;
-        case WAVE_SQUARE: out = phase_ < PI_F ? (1.0f) : -1.0f; break;
-        case WAVE_POLYBLEP_TRI:
-            t   = phase_ * TWO_PI_RECIP;
-            out = phase_ < PI_F ? 1.0f : -1.0f;
-            out += Polyblep(phase_inc_, t);
-            out -= Polyblep(phase_inc_, fmodf(t + 0.5f, 1.0f));
+        case Oscillator::WAVE_RAMP:
+            out = ((phase * TWO_PI_RECIP * 2.0f)) - 1.0f;
+            break;
+        case Oscillator::WAVE_SQUARE: out = phase < PI_F ? (1.0f) : -1.0f; break;
+        case Oscillator::WAVE_POLYBLEP_TRI:
+            t   = phase * TWO_PI_RECIP;
+            out = phase < PI_F ? 1.0f : -1.0f;
+            out += Polyblep(dt, t);
+            out -= Polyblep(dt, fmodf(t + 0.5f, 1.0f));
             // Leaky Integrator:
             // y[n] = A + x[n] + (1 - A) * y[n-1]
-            out       = phase_inc_ * out + (1.0f - phase_inc_) * last_out_;
-            last_out_ = out;
+            out      = phase_inc * out + (1.0f - phase_inc) * last_out;
+            last_out = out;
             break;
-        case WAVE_POLYBLEP_SAW:
-            t   = phase_ * TWO_PI_RECIP;
+        case Oscillator::WAVE_POLYBLEP_SAW:
+            t   = phase * TWO_PI_RECIP;
             out = (2.0f * t) - 1.0f;
-            out -= Polyblep(phase_inc_, t);
+            out -= Polyblep(dt, t);
             out *= -1.0f;
             break;
-        case WAVE_POLYBLEP_SQUARE:
-            t   = phase_ * TWO_PI_RECIP;
-            out = phase_ < PI_F ? 1.0f : -1.0f;
-            out += Polyblep(phase_inc_, t);
-            out -= Polyblep(phase_inc_, fmodf(t + 0.5f, 1.0f));
+        case Oscillator::WAVE_POLYBLEP_SQUARE:
+            t   = phase * TWO_PI_RECIP;
+            out = phase < PI_F ? 1.0f : -1.0f;
+            out += Polyblep(dt, t);
+            out -= Polyblep(dt, fmodf(t + 0.5f, 1.0f));
             out *= 0.707f; // ?
             break;
         default: out = 0.0f; break;
     }
+    return out;
+}
+
+float Oscillator::Process()
+{
+    float       out;
+    const float dt = phase_inc_ * TWO_PI_RECIP;
+    switch(waveform_)
+    {
+        case WAVE_SIN:
+            out = Render<WAVE_SIN>(phase_, phase_inc_, dt, last_out_);
+            break;
+        case WAVE_TRI:
+            out = Render<WAVE_TRI>(phase_, phase_inc_, dt, last_out_);
+            break;
+        case WAVE_SAW:
+            out = Render<WAVE_SAW>(phase_, phase_inc_, dt, last_out_);
+            break;
+        case WAVE_RAMP:
+            out = Render<WAVE_RAMP>(phase_, phase_inc_, dt, last_out_);
+            break;
+        case WAVE_SQUARE:
+            out = Render<WAVE_SQUARE>(phase_, phase_inc_, dt, last_out_);
+            break;
+        case WAVE_POLYBLEP_TRI:
+            out = Render<WAVE_POLYBLEP_TRI>(phase_, phase_inc_, dt, last_out_);
+            break;
+        case WAVE_POLYBLEP_SAW:
+            out = Render<WAVE_POLYBLEP_SAW>(phase_, phase_inc_, dt, last_out_);
+            break;
+        case WAVE_POLYBLEP_SQUARE:
+            out = Render<WAVE_POLYBLEP_SQUARE>(
+                phase_, phase_inc_, dt, last_out_);
+            break;
+        default: out = 0.0f; break;
+    }
     phase_ += phase_inc_;
     if(phase_ > TWOPI_F)
     {
@@ -61,14 +104,79 @@ float Oscillator::Process()
     return out * amp_;
 }
 
+template <uint8_t wf, bool mod>
+void Oscillator::RunBlock(float *out, const float *fm, size_t size)
+{
+    const float inc  = phase_inc_;
+    const float dt   = inc * TWO_PI_RECIP;
+    const float amp  = amp_;
+    float       phase = phase_;
+    float       last  = last_out_;
+    bool        eoc   = eoc_;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        if(mod)
+            phase += (fm[i] * TWOPI_F);
+        out[i] = Render<wf>(phase, inc, dt, last) * amp;
+        phase += inc;
+        eoc = phase > TWOPI_F;
+        if(eoc)
+            phase -= TWOPI_F;
+    }
+
+    if(size > 0)
+    {
+        eoc_ = eoc;
+        eor_ = (phase - inc < PI_F && phase >= PI_F);
+    }
+    phase_    = phase;
+    last_out_ = last;
+}
+
+template <bool mod>
+void Oscillator::Dispatch(float *out, const float *fm, size_t size)
+{
+    switch(waveform_)
+    {
+        case WAVE_SIN: RunBlock<WAVE_SIN, mod>(out, fm, size); break;
+        case WAVE_TRI: RunBlock<WAVE_TRI, mod>(out, fm, size); break;
+        case WAVE_SAW: RunBlock<WAVE_SAW, mod>(out, fm, size); break;
+        case WAVE_RAMP: RunBlock<WAVE_RAMP, mod>(out, fm, size); break;
+        case WAVE_SQUARE: RunBlock<WAVE_SQUARE, mod>(out, fm, size); break;
+        case WAVE_POLYBLEP_TRI:
+            RunBlock<WAVE_POLYBLEP_TRI, mod>(out, fm, size);
+            break;
+        case WAVE_POLYBLEP_SAW:
+            RunBlock<WAVE_POLYBLEP_SAW, mod>(out, fm, size);
+            break;
+        case WAVE_POLYBLEP_SQUARE:
+            RunBlock<WAVE_POLYBLEP_SQUARE, mod>(out, fm, size);
+            break;
+        default:
+            for(size_t i = 0; i < size; i++)
+                out[i] = 0.0f;
+            break;
+    }
+}
+
+void Oscillator::ProcessBlock(float *out, size_t size)
+{
+    Dispatch<false>(out, nullptr, size);
+}
+
+void Oscillator::ProcessBlock(float *out, const float *fm, size_t size)
+{
+    Dispatch<true>(out, fm, size);
+}
+
 float Oscillator::CalcPhaseInc(float f)
 {
     return (TWOPI_F * f) * sr_recip_;
 }
 
-static float Polyblep(float phase_inc, float t)
+static float Polyblep(float dt, float t)
 {
-    float dt = phase_inc * TWO_PI_RECIP;
     if(t < dt)
     {
         t /= dt;
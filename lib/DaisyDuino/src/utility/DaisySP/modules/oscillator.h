@@ -2,7 +2,9 @@
 #ifndef DSY_OSCILLATOR_H
 #define DSY_OSCILLATOR_H
 #include <stdint.h>
+#include <stddef.h>
 #include "dsp.h"
+#include "fast_sin.h"
 #ifdef __cplusplus
 
 namespace daisysp
@@ -12,6 +14,8 @@ namespace daisysp
 class Oscillator
 {
   public:
+    static const size_t kStateBytes;
+
     Oscillator() {}
     ~Oscillator() {}
     /** Choices for output waveforms, POLYBLEP are appropriately labeled. Others are naive forms.
@@ -50,6 +54,8 @@ class Oscillator
         waveform_  = WAVE_SIN;
         eoc_       = true;
         eor_       = true;
+        last_out_  = 0.0f;
+        FastSin::Init();
     }
 
 
@@ -92,6 +98,18 @@ class Oscillator
     */
     float Process();
 
+    /** Fills out with size samples, the same as calling Process() for each.
+        The waveform is dispatched once per block, and the phase, increment
+        and amplitude stay in registers across it; IsEOC() and IsEOR() then
+        report the last sample.
+    */
+    void ProcessBlock(float *out, size_t size);
+
+    /** As ProcessBlock(out, size), with phase_mod[i] added to the phase
+        before sample i, as for PhaseAdd() before each Process(): 0.0-1.0 of
+        a cycle, for PM and "FM" at audio rate.
+    */
+    void ProcessBlock(float *out, const float *phase_mod, size_t size);
 
     /** Adds a value 0.0-1.0 (mapped to 0.0-TWO_PI) to the current phase. Useful for PM and "FM" synthesis.
     */
@@ -102,12 +120,18 @@ class Oscillator
 
   private:
     float   CalcPhaseInc(float f);
+    template <uint8_t wf, bool mod>
+    void RunBlock(float *out, const float *fm, size_t size);
+    template <bool mod>
+    void Dispatch(float *out, const float *fm, size_t size);
     uint8_t waveform_;
     float   amp_, freq_;
     float   sr_, sr_recip_, phase_, phase_inc_;
     float   last_out_, last_freq_;
     bool    eor_, eoc_;
 };
+
+inline constexpr size_t Oscillator::kStateBytes = sizeof(Oscillator);
 } // namespace daisysp
 #endif
 #endif
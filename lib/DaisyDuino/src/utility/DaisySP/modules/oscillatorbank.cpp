@@ -10,7 +10,7 @@ void OscillatorBank::Init(float sample_rate)
 
     phase_       = 0.0f;
     next_sample_ = 0.0f;
-    segment_     = 0.0f;
+    segment_     = 0;
 
     frequency_  = 0.f;
     saw_8_gain_ = 0.0f;
@@ -30,7 +30,7 @@ void OscillatorBank::Init(float sample_rate)
     SetFreq(440.f);
 }
 
-float OscillatorBank::Process()
+void OscillatorBank::UpdateRegistration()
 {
     if(recalc_)
     {
@@ -56,11 +56,13 @@ float OscillatorBank::Process()
         {
             registration_[i + shift] = unshifted_registration_[i];
         }
+        recalc_gain_ = true;
     }
 
-    if(recalc_gain_ || recalc_)
+    if(recalc_gain_)
     {
-        saw_8_gain_ = (registration_[0] + 2.0f * registration_[1]) * gain_;
+        recalc_gain_ = false;
+        saw_8_gain_  = (registration_[0] + 2.0f * registration_[1]) * gain_;
         saw_4_gain_
             = (registration_[2] - registration_[1] + 2.0f * registration_[3])
               * gain_;
@@ -69,46 +71,89 @@ float OscillatorBank::Process()
               * gain_;
         saw_1_gain_ = (registration_[6] - registration_[5]) * gain_;
     }
+}
 
-    float this_sample_ = next_sample_;
-    next_sample_       = 0.0f;
+/** One sample of the divide-down saws, shared by Process and ProcessBlock */
+static inline float Render(float&      phase,
+                           float&      next_sample,
+                           int&        segment,
+                           const float frequency,
+                           const float saw_8_gain,
+                           const float saw_4_gain,
+                           const float saw_2_gain,
+                           const float saw_1_gain)
+{
+    float this_sample = next_sample;
+    next_sample       = 0.0f;
 
-    phase_ += frequency_;
-    int next_segment_ = static_cast<int>(phase_);
-    if(next_segment_ != segment_)
+    phase += frequency;
+    int next_segment = static_cast<int>(phase);
+    if(next_segment != segment)
     {
         float discontinuity = 0.0f;
-        if(next_segment_ == 8)
+        if(next_segment == 8)
         {
-            phase_ -= 8.0f;
-            next_segment_ -= 8;
-            discontinuity -= saw_8_gain_;
+            phase -= 8.0f;
+            next_segment -= 8;
+            discontinuity -= saw_8_gain;
         }
-        if((next_segment_ & 3) == 0)
+        if((next_segment & 3) == 0)
         {
-            discontinuity -= saw_4_gain_;
+            discontinuity -= saw_4_gain;
         }
-        if((next_segment_ & 1) == 0)
+        if((next_segment & 1) == 0)
         {
-            discontinuity -= saw_2_gain_;
+            discontinuity -= saw_2_gain;
         }
-        discontinuity -= saw_1_gain_;
+        discontinuity -= saw_1_gain;
         if(discontinuity != 0.0f)
         {
-            float fraction = phase_ - static_cast<float>(next_segment_);
-            float t        = fraction / frequency_;
-            this_sample_ += ThisBlepSample(t) * discontinuity;
-            next_sample_ += NextBlepSample(t) * discontinuity;
+            float fraction = phase - static_cast<float>(next_segment);
+            float t        = fraction / frequency;
+            this_sample += ThisBlepSample(t) * discontinuity;
+            next_sample += NextBlepSample(t) * discontinuity;
         }
     }
-    segment_ = next_segment_;
+    segment = next_segment;
+
+    next_sample += (phase - 4.0f) * saw_8_gain * 0.125f;
+    next_sample += (phase - float(segment & 4) - 2.0f) * saw_4_gain * 0.25f;
+    next_sample += (phase - float(segment & 6) - 1.0f) * saw_2_gain * 0.5f;
+    next_sample += (phase - float(segment & 7) - 0.5f) * saw_1_gain;
+
+    return 2.0f * this_sample;
+}
 
-    next_sample_ += (phase_ - 4.0f) * saw_8_gain_ * 0.125f;
-    next_sample_ += (phase_ - float(segment_ & 4) - 2.0f) * saw_4_gain_ * 0.25f;
-    next_sample_ += (phase_ - float(segment_ & 6) - 1.0f) * saw_2_gain_ * 0.5f;
-    next_sample_ += (phase_ - float(segment_ & 7) - 0.5f) * saw_1_gain_;
+float OscillatorBank::Process()
+{
+    UpdateRegistration();
+    return Render(phase_,
+                  next_sample_,
+                  segment_,
+                  frequency_,
+                  saw_8_gain_,
+                  saw_4_gain_,
+                  saw_2_gain_,
+                  saw_1_gain_);
+}
 
-    return 2.0f * this_sample_;
+void OscillatorBank::ProcessBlock(float* out, size_t size)
+{
+    UpdateRegistration();
+    const float frequency = frequency_;
+    const float g8 = saw_8_gain_, g4 = saw_4_gain_;
+    const float g2 = saw_2_gain_, g1 = saw_1_gain_;
+    float       phase       = phase_;
+    float       next_sample = next_sample_;
+    int         segment     = segment_;
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = Render(
+            phase, next_sample, segment, frequency, g8, g4, g2, g1);
+    }
+    phase_       = phase;
+    next_sample_ = next_sample;
+    segment_     = segment;
 }
 
 void OscillatorBank::SetFreq(float freq)
@@ -142,6 +187,6 @@ void OscillatorBank::SetGain(float gain)
 {
     gain         = gain > 1.f ? 1.f : gain;
     gain         = gain < 0.f ? 0.f : gain;
-    recalc_gain_ = cmp(gain, gain_) || recalc_gain_;
+    recalc_gain_ = gain != gain_ || recalc_gain_;
     gain_        = gain;
 }
\ No newline at end of file
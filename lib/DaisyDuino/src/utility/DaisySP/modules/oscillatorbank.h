@@ -3,6 +3,8 @@
 #define DSY_OSCILLATORBANK_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include "fast_sin.h"
 #ifdef __cplusplus
 
 /** @file oscillatorbank.h */
@@ -22,6 +24,8 @@ namespace daisysp
 class OscillatorBank
 {
   public:
+    static const size_t kStateBytes;
+
     OscillatorBank() {}
     ~OscillatorBank() {}
 
@@ -34,6 +38,13 @@ class OscillatorBank
     */
     float Process();
 
+    /** Fills out with size samples, the same as calling Process() for
+        each. Frequency, registration and gain changes are picked up once,
+        at the start of the block, and the oscillator state stays in
+        registers across it.
+    */
+    void ProcessBlock(float* out, size_t size);
+
     /** Set oscillator frequency (8' oscillator)
         \param freq Frequency in Hz
     */
@@ -56,6 +67,8 @@ class OscillatorBank
     void SetGain(float gain);
 
   private:
+    void UpdateRegistration();
+
     // Oscillator state.
     float phase_;
     float next_sample_;
@@ -73,8 +86,191 @@ class OscillatorBank
     float sample_rate_;
     bool  recalc_, recalc_gain_;
 
-    bool cmp(float a, float b) { return fabsf(a - b) > .0000001; }
+    bool cmp(float a, float b) { return fabsf(a - b) > .0000001f; }
 };
+
+inline constexpr size_t OscillatorBank::kStateBytes = sizeof(OscillatorBank);
+
+/** N sine partials over one fundamental, for organ-style additive patches.
+
+    Each partial has a frequency ratio (a drawbar footage: 16' is 0.5, 8'
+    is 1, 5 1/3' is 1.5 ...) and an amplitude. The state is kept as
+    struct-of-arrays, phases, increments and gains, and is only
+    recomputed on the first Process after a setter changed something.
+    Silent partials and those at or above Nyquist are dropped from the
+    render list, and hold their phase.
+
+    ProcessBlock() runs each partial over the whole block, four samples
+    at a time, with its phase, increment and gain in registers. Sines go
+    through FastSin on the default tier.
+
+    declaration example:
+
+    AdditiveBank<9> organ;
+    const float footage[9] = {0.5f, 1.5f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 8.f};
+    organ.Init(48000.f);
+    organ.SetRatios(footage);
+*/
+template <size_t num_partials>
+class AdditiveBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    AdditiveBank() {}
+    ~AdditiveBank() {}
+
+    /** Initializes the bank at 440 Hz on the harmonic series 1 to N,
+        with only the first partial sounding, at full gain.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        sr_recip_ = 1.0f / sample_rate;
+        freq_     = 440.0f;
+        gain_     = 1.0f;
+        for(size_t i = 0; i < num_partials; i++)
+        {
+            ratio_[i] = static_cast<float>(i + 1);
+            amp_[i]   = i == 0 ? 1.0f : 0.0f;
+            phase_[i] = 0.0f;
+        }
+        dirty_ = true;
+        FastSin::Init();
+    }
+
+    /** Sets the fundamental, ratio 1, in Hz. */
+    inline void SetFreq(float freq)
+    {
+        if(freq != freq_)
+        {
+            freq_  = freq;
+            dirty_ = true;
+        }
+    }
+
+    /** Sets the frequency ratio of one partial to the fundamental. */
+    inline void SetRatio(size_t idx, float ratio)
+    {
+        if(idx < num_partials && ratio != ratio_[idx])
+        {
+            ratio_[idx] = ratio;
+            dirty_      = true;
+        }
+    }
+
+    /** Sets the ratios of all N partials at once. */
+    inline void SetRatios(const float* ratios)
+    {
+        for(size_t i = 0; i < num_partials; i++)
+            SetRatio(i, ratios[i]);
+    }
+
+    /** Sets the amplitude of one partial. */
+    inline void SetAmp(size_t idx, float amp)
+    {
+        if(idx < num_partials && amp != amp_[idx])
+        {
+            amp_[idx] = amp;
+            dirty_    = true;
+        }
+    }
+
+    /** Sets the amplitudes of all N partials at once. */
+    inline void SetAmplitudes(const float* amps)
+    {
+        for(size_t i = 0; i < num_partials; i++)
+            SetAmp(i, amps[i]);
+    }
+
+    /** Sets the overall gain, applied to the partial amplitudes. */
+    inline void SetGain(float gain)
+    {
+        if(gain != gain_)
+        {
+            gain_  = gain;
+            dirty_ = true;
+        }
+    }
+
+    /** Get next floating point sample */
+    float Process()
+    {
+        if(dirty_)
+            Update();
+        float sum = 0.0f;
+        for(size_t n = 0; n < num_active_; n++)
+        {
+            const size_t i = active_[n];
+            sum += Tick(phase_[i], inc_[i], g_[i]);
+        }
+        return sum;
+    }
+
+    /** Fills out with size samples, the same as Process() for each. */
+    void ProcessBlock(float* out, size_t size)
+    {
+        if(dirty_)
+            Update();
+        for(size_t j = 0; j < size; j++)
+            out[j] = 0.0f;
+        for(size_t n = 0; n < num_active_; n++)
+        {
+            const size_t i     = active_[n];
+            const float  inc   = inc_[i];
+            const float  g     = g_[i];
+            float        phase = phase_[i];
+            size_t       j     = 0;
+            for(; j + 4 <= size; j += 4)
+            {
+                out[j] += Tick(phase, inc, g);
+                out[j + 1] += Tick(phase, inc, g);
+                out[j + 2] += Tick(phase, inc, g);
+                out[j + 3] += Tick(phase, inc, g);
+            }
+            for(; j < size; j++)
+                out[j] += Tick(phase, inc, g);
+            phase_[i] = phase;
+        }
+    }
+
+  private:
+    static inline float Tick(float& phase, float inc, float g)
+    {
+        const float s = g * FastSin::Sin(phase);
+        phase += inc;
+        if(phase >= 1.0f)
+            phase -= 1.0f;
+        return s;
+    }
+
+    void Update()
+    {
+        num_active_ = 0;
+        for(size_t i = 0; i < num_partials; i++)
+        {
+            inc_[i] = freq_ * ratio_[i] * sr_recip_;
+            g_[i]   = amp_[i] * gain_;
+            if(g_[i] != 0.0f && inc_[i] > 0.0f && inc_[i] < 0.5f)
+                active_[num_active_++] = i;
+        }
+        dirty_ = false;
+    }
+
+    float  sr_recip_, freq_, gain_;
+    bool   dirty_;
+    size_t num_active_;
+    float  ratio_[num_partials];
+    float  amp_[num_partials];
+    float  phase_[num_partials];
+    float  inc_[num_partials];
+    float  g_[num_partials];
+    size_t active_[num_partials];
+};
+
+template <size_t num_partials>
+constexpr size_t AdditiveBank<num_partials>::kStateBytes
+    = sizeof(AdditiveBank<num_partials>);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define DSY_OVERDRIVE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file overdrive.h */
@@ -20,6 +21,8 @@ namespace daisysp
 class Overdrive
 {
   public:
+    static const size_t kStateBytes;
+
     Overdrive() {}
     ~Overdrive() {}
 
@@ -36,11 +39,18 @@ class Overdrive
 	  */
     void SetDrive(float drive);
 
+    /** Gain into the curve for the current drive, e.g. for Waveshaper */
+    inline float GetPreGain() const { return pre_gain_; }
+    /** Makeup gain out of the curve for the current drive */
+    inline float GetPostGain() const { return post_gain_; }
+
   private:
     float drive_;
     float pre_gain_;
     float post_gain_;
 };
+
+inline constexpr size_t Overdrive::kStateBytes = sizeof(Overdrive);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,316 @@
+#pragma once
+#ifndef DSY_PARALLEL_BIQUAD_H
+#define DSY_PARALLEL_BIQUAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <complex>
+#include "biquad_cascade.h"
+
+namespace daisysp
+{
+/** A cascade of biquads rewritten as a sum of independent sections.
+
+    SetCascade() expands the product of up to max_sections biquads
+    (an EQ of peaking bands and shelves, say) into partial fractions:
+
+    H(z) = d + sum_k (c0k + c1k z^-1) / (1 + a1k z^-1 + a2k z^-2)
+
+    The poles are the cascade's own; only the numerators change. The
+    response is the same, but no section waits for another's output. In
+    a cascade every stage's recursion sits in one chain, sample after
+    sample. Here ProcessBlock() runs two sections per pass over the
+    block. Their recursions interleave and fill each other's FPU
+    latency, and each costs four multiplies against five.
+
+    The expansion needs distinct poles. Two bands at the same frequency
+    and Q share a pole and cannot be split; bands very close together
+    give large residues that cancel, and lose precision in float.
+    SetCascade() checks the expanded response against the cascade's
+    and returns false, keeping the previous form, if they differ by
+    more than 1e-4 anywhere. A passthrough section (a 0 dB band) is
+    left out, and a pure gain is folded into d.
+
+    SetCascade() works in double, from setup or control rate code.
+
+    declaration example:
+
+    BiquadSection bands[8];
+    ... // ConfigurePeaking(bands[i], ...)
+    ParallelBiquad<8> eq;
+    eq.Init();
+    if(!eq.SetCascade(bands, 8))
+        ... // keep a BiquadCascade<8> instead
+*/
+template <size_t max_sections>
+class ParallelBiquad
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(max_sections > 0, "ParallelBiquad needs a section");
+
+    ParallelBiquad() {}
+    ~ParallelBiquad() {}
+
+    /** Passthrough, state cleared. Must be called before processing. */
+    void Init()
+    {
+        count_  = 0;
+        direct_ = 1.f;
+        Reset();
+    }
+
+    /** Clears the state, keeping the coefficients. */
+    void Reset()
+    {
+        for(size_t k = 0; k < max_sections; k++)
+        {
+            z1_[k] = z2_[k] = 0.f;
+        }
+    }
+
+    /** Expands a cascade into the parallel form. The state is cleared.
+        \param sections normalized sections, applied in any order
+        \param count number of sections, up to max_sections
+        \return false, the previous form kept, if the cascade has a
+            first order or FIR section, shares a pole between sections,
+            or does not expand within 1e-4
+    */
+    bool SetCascade(const BiquadSection* sections, size_t count)
+    {
+        typedef std::complex<double> Complex;
+        if(count > max_sections)
+            return false;
+
+        // The sections kept, in double; x = z^-1 below.
+        double pb0[max_sections] = {}, pb1[max_sections] = {};
+        double pb2[max_sections] = {}, pa1[max_sections] = {};
+        double pa2[max_sections] = {};
+        double gain = 1.0;
+        size_t n    = 0;
+        for(size_t i = 0; i < count; i++)
+        {
+            const BiquadSection& s = sections[i];
+            if(s.b0 == 1.f && s.b1 == s.a1 && s.b2 == s.a2)
+                continue;
+            if(s.a1 == 0.f && s.a2 == 0.f && s.b1 == 0.f && s.b2 == 0.f)
+            {
+                gain *= static_cast<double>(s.b0);
+                continue;
+            }
+            if(s.a2 == 0.f)
+                return false;
+            pb0[n] = s.b0;
+            pb1[n] = s.b1;
+            pb2[n] = s.b2;
+            pa1[n] = s.a1;
+            pa2[n] = s.a2;
+            n++;
+        }
+
+        // H(x) at x -> infinity.
+        double d = gain;
+        for(size_t k = 0; k < n; k++)
+        {
+            d *= pb2[k] / pa2[k];
+        }
+
+        // The residue at a pole x0 of section k, the other root x1, is
+        // B_k(x0) / (a2 (x0 - x1)) times every other section at x0.
+        // Taken from the factored form: expanding the product into one
+        // polynomial loses the poles clustered near z = 1 to rounding.
+        float c0[max_sections] = {}, c1[max_sections] = {};
+        for(size_t k = 0; k < n; k++)
+        {
+            const Complex root
+                = std::sqrt(Complex(pa1[k] * pa1[k] - 4.0 * pa2[k]));
+            const Complex x[2] = {(-pa1[k] + root) / (2.0 * pa2[k]),
+                                  (-pa1[k] - root) / (2.0 * pa2[k])};
+            Complex       res[2];
+            for(size_t j = 0; j < 2; j++)
+            {
+                const Complex x0 = x[j], x1 = x[1 - j];
+                if(x0 == x1)
+                    return false;
+                res[j] = (pb0[k] + x0 * (pb1[k] + x0 * pb2[k]))
+                         / (pa2[k] * (x0 - x1));
+                for(size_t m = 0; m < n; m++)
+                {
+                    if(m == k)
+                        continue;
+                    const Complex den = 1.0 + x0 * (pa1[m] + x0 * pa2[m]);
+                    if(den == 0.0)
+                        return false;
+                    res[j] *= (pb0[m] + x0 * (pb1[m] + x0 * pb2[m])) / den;
+                }
+            }
+            // res0 / (x - x0) + res1 / (x - x1), over 1 + a1 x + a2 x^2.
+            const double scale = gain * pa2[k];
+            c1[k] = static_cast<float>(scale * (res[0] + res[1]).real());
+            c0[k] = static_cast<float>(
+                -scale * (res[0] * x[1] + res[1] * x[0]).real());
+        }
+
+        if(!Matches(sections, count, d, c0, c1, pa1, pa2, n))
+            return false;
+        count_  = n;
+        direct_ = static_cast<float>(d);
+        for(size_t k = 0; k < n; k++)
+        {
+            c0_[k] = c0[k];
+            c1_[k] = c1[k];
+            a1_[k] = static_cast<float>(pa1[k]);
+            a2_[k] = static_cast<float>(pa2[k]);
+        }
+        Reset();
+        return true;
+    }
+
+    /** \return number of sections in use, passthroughs left out */
+    inline size_t GetNumSections() const { return count_; }
+
+    /** Filters a block. in and out may point to the same buffer.
+        \param in - input samples
+        \param out - output samples
+        \param size - number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        float x[kChunk];
+        while(size > 0)
+        {
+            const size_t len = size < kChunk ? size : kChunk;
+            memcpy(x, in, len * sizeof(float));
+            const float d = direct_;
+            for(size_t i = 0; i < len; i++)
+            {
+                out[i] = d * x[i];
+            }
+            size_t k = 0;
+            for(; k + 1 < count_; k += 2)
+            {
+                Pair(k, x, out, len);
+            }
+            if(k < count_)
+            {
+                Single(k, x, out, len);
+            }
+            in += len;
+            out += len;
+            size -= len;
+        }
+    }
+
+  private:
+    static constexpr size_t kChunk = 32;
+
+    /** Sections k and k + 1 into out, one pass, two recursions */
+    inline void Pair(size_t k, const float* x, float* out, size_t len)
+    {
+        const float b0 = c0_[k], b1 = c1_[k], p1 = a1_[k], p2 = a2_[k];
+        const float e0 = c0_[k + 1], e1 = c1_[k + 1];
+        const float q1 = a1_[k + 1], q2 = a2_[k + 1];
+        float       u1 = z1_[k], u2 = z2_[k];
+        float       v1 = z1_[k + 1], v2 = z2_[k + 1];
+        for(size_t i = 0; i < len; i++)
+        {
+            const float s = x[i];
+            const float y = b0 * s + u1;
+            const float w = e0 * s + v1;
+            u1            = b1 * s - p1 * y + u2;
+            v1            = e1 * s - q1 * w + v2;
+            u2            = -p2 * y;
+            v2            = -q2 * w;
+            out[i] += y + w;
+        }
+        z1_[k]     = u1;
+        z2_[k]     = u2;
+        z1_[k + 1] = v1;
+        z2_[k + 1] = v2;
+    }
+
+    inline void Single(size_t k, const float* x, float* out, size_t len)
+    {
+        const float b0 = c0_[k], b1 = c1_[k], p1 = a1_[k], p2 = a2_[k];
+        float       u1 = z1_[k], u2 = z2_[k];
+        for(size_t i = 0; i < len; i++)
+        {
+            const float s = x[i];
+            const float y = b0 * s + u1;
+            u1            = b1 * s - p1 * y + u2;
+            u2            = -p2 * y;
+            out[i] += y;
+        }
+        z1_[k] = u1;
+        z2_[k] = u2;
+    }
+
+    /** Both forms, float coefficients, on a grid over the unit circle
+        and at every pole angle, to 1e-4 of the largest response. */
+    static bool Matches(const BiquadSection* sections,
+                        size_t               count,
+                        double               d,
+                        const float*         c0,
+                        const float*         c1,
+                        const double*        a1,
+                        const double*        a2,
+                        size_t               n)
+    {
+        typedef std::complex<double> Complex;
+        const size_t kGrid = 64;
+        double       worst = 0.0, peak = 0.0;
+        for(size_t g = 0; g < kGrid + n; g++)
+        {
+            double w;
+            if(g < kGrid)
+            {
+                w = 3.14159265358979 * (static_cast<double>(g) + .5)
+                    / static_cast<double>(kGrid);
+            }
+            else
+            {
+                const size_t k = g - kGrid;
+                const double r = sqrt(a2[k] > 0.0 ? a2[k] : 1.0);
+                const double c = -a1[k] / (2.0 * r);
+                w = acos(c < -1.0 ? -1.0 : (c > 1.0 ? 1.0 : c));
+            }
+            const Complex x = std::polar(1.0, -w);
+            Complex       cascade(1.0), parallel(d);
+            for(size_t i = 0; i < count; i++)
+            {
+                const double b0 = sections[i].b0, b1 = sections[i].b1,
+                             b2 = sections[i].b2;
+                const double p1 = sections[i].a1, p2 = sections[i].a2;
+                cascade *= (b0 + x * (b1 + x * b2)) / (1.0 + x * (p1 + x * p2));
+            }
+            for(size_t k = 0; k < n; k++)
+            {
+                // The poles as ProcessBlock() has them, rounded to float.
+                const double n0 = c0[k], n1 = c1[k];
+                const double p1 = static_cast<float>(a1[k]);
+                const double p2 = static_cast<float>(a2[k]);
+                parallel += (n0 + x * n1) / (1.0 + x * (p1 + x * p2));
+            }
+            const double e = std::abs(cascade - parallel);
+            worst          = e > worst ? e : worst;
+            peak = std::abs(cascade) > peak ? std::abs(cascade) : peak;
+        }
+        return worst <= 1e-4 * peak;
+    }
+
+    float  c0_[max_sections], c1_[max_sections];
+    float  a1_[max_sections], a2_[max_sections];
+    float  z1_[max_sections], z2_[max_sections];
+    float  direct_;
+    size_t count_;
+};
+
+template <size_t max_sections>
+constexpr size_t ParallelBiquad<max_sections>::kStateBytes
+    = sizeof(ParallelBiquad<max_sections>);
+
+} // namespace daisysp
+#endif
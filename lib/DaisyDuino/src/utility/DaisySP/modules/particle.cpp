@@ -1,9 +1,27 @@
 #include "dsp.h"
 #include "particle.h"
 #include <math.h>
+#include <string.h>
 
 using namespace daisysp;
 
+namespace
+{
+// 2^x from the exponent bits and a cubic over the fraction, within 1e-4.
+inline float Pow2(float x)
+{
+    x = fclamp(x, -126.f, 126.f);
+    const float xi = floorf(x);
+    const float f  = x - xi;
+    const float p  = 1.f + f * (0.695834f + f * (0.226061f + f * 0.0781015f));
+    const uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(xi) + 127)
+                          << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+} // namespace
+
 void Particle::Init(float sample_rate)
 {
     sample_rate_ = sample_rate;
@@ -22,28 +40,29 @@ void Particle::Init(float sample_rate)
     pre_gain_ = 0.0f;
     filter_.Init(sample_rate_);
     filter_.SetDrive(.7f);
+
+    rng_.Init();
+    UpdateDensity();
 }
 
 float Particle::Process()
 {
-    float u = rand() * kRandFrac;
     float s = 0.0f;
-
-    if(u <= density_ || sync_)
+    if(gap_ == 0)
     {
-        s = u <= density_ ? u * gain_ : s;
-        rand_phase_ += rand_freq_;
-
-        if(rand_phase_ >= 1.f || sync_)
+        s = Impulse();
+        if(Advance() || sync_)
+            Retune();
+        gap_ = NextGap();
+    }
+    else
+    {
+        if(gap_ != kNever)
+            gap_--;
+        if(sync_)
         {
-            rand_phase_ = rand_phase_ >= 1.f ? rand_phase_ - 1.f : rand_phase_;
-
-            const float u = 2.0f * rand() * kRandFrac - 1.0f;
-            const float f
-                = fmin(powf(2.f, kRatioFrac * spread_ * u) * frequency_, .25f);
-            pre_gain_ = 0.5f / sqrtf(resonance_ * f * sqrtf(density_));
-            filter_.SetFreq(f * sample_rate_);
-            filter_.SetRes(resonance_);
+            Advance();
+            Retune();
         }
     }
     aux_ = s;
@@ -52,6 +71,110 @@ float Particle::Process()
     return filter_.Band();
 }
 
+void Particle::ProcessBlock(float* out, size_t size)
+{
+    if(size == 0)
+        return;
+
+    for(size_t i = 0; i < size; i++)
+        out[i] = 0.0f;
+
+    // Nothing arrives and nothing rings: leave the filter asleep.
+    if(!sync_ && gap_ >= size && fabsf(filter_.Low()) < kSilence
+       && fabsf(filter_.Band()) < kSilence && fabsf(filter_.High()) < kSilence)
+    {
+        if(gap_ != kNever)
+            gap_ -= static_cast<uint32_t>(size);
+        aux_ = 0.f;
+        return;
+    }
+
+    if(sync_)
+    {
+        Advance();
+        Retune();
+    }
+
+    // Impulses go into out, and the filter runs over it in place up to
+    // each change of its frequency.
+    float  s     = 0.0f;
+    size_t start = 0;
+    size_t i     = 0;
+    while(gap_ < size - i)
+    {
+        i += gap_;
+        s = Impulse();
+        if(Advance())
+        {
+            // Filter what came before with the old coefficients.
+            filter_.ProcessBlock(out + start,
+                                 nullptr,
+                                 nullptr,
+                                 out + start,
+                                 nullptr,
+                                 nullptr,
+                                 i - start);
+            start = i;
+            Retune();
+        }
+        out[i] = pre_gain_ * s;
+        gap_   = NextGap();
+        i++;
+    }
+    if(gap_ != kNever)
+        gap_ -= static_cast<uint32_t>(size - i);
+    aux_ = i == size ? s : 0.f;
+
+    filter_.ProcessBlock(
+        out + start, nullptr, nullptr, out + start, nullptr, nullptr, size - start);
+}
+
+float Particle::Impulse()
+{
+    // Given an impulse, the old per-sample test u <= density_ left u
+    // uniform over [0, density_].
+    return rng_.NextFloat() * density_ * gain_;
+}
+
+bool Particle::Advance()
+{
+    rand_phase_ += rand_freq_;
+    if(rand_phase_ >= 1.f)
+    {
+        rand_phase_ -= 1.f;
+        return true;
+    }
+    return false;
+}
+
+void Particle::Retune()
+{
+    const float u = rng_.NextBipolar();
+    float       f = Pow2(kRatioFrac * spread_ * u) * frequency_;
+    f             = f < .25f ? f : .25f;
+    pre_gain_     = 0.5f / math::sqrt(resonance_ * f * math::sqrt(density_));
+    filter_.SetFreq(f * sample_rate_);
+    filter_.SetRes(resonance_);
+}
+
+uint32_t Particle::NextGap()
+{
+    if(gap_scale_ == 0.f)
+        return kNever;
+    // Geometric: the number of samples failing a test of probability
+    // density_ before one passes, from a single uniform in (0, 1].
+    const float gap = fastlog2f(1.f - rng_.NextFloat()) * gap_scale_;
+    if(gap < 1.f)
+        return 0;
+    return gap < 1e9f ? static_cast<uint32_t>(gap) : 1000000000u;
+}
+
+void Particle::UpdateDensity()
+{
+    gap_scale_ = density_ > 0.f ? 1.f / log2f(1.f - density_) : 0.f;
+    gap_ = NextGap();
+}
+
 float Particle::GetNoise()
 {
     return aux_;
@@ -76,7 +199,12 @@ void Particle::SetRandomFreq(float freq)
 
 void Particle::SetDensity(float density)
 {
-    density_ = fclamp(density * .3f, 0.f, 1.f);
+    density = fclamp(density * .3f, 0.f, 1.f);
+    if(density != density_)
+    {
+        density_ = density;
+        UpdateDensity();
+    }
 }
 
 void Particle::SetGain(float gain)
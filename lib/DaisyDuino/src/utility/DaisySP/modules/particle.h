@@ -3,8 +3,9 @@
 #define DSY_PARTICLE_H
 
 #include "svf.h"
+#include "fast_random.h"
 #include <stdint.h>
-#include <cstdlib>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file particle.h */
@@ -18,11 +19,19 @@ namespace daisysp
        Noise processed by a sample and hold running at a target frequency. \n \n
        Ported from pichenettes/eurorack/plaits/dsp/noise/particle.h \n
        to an independent module. \n
-       Original code written by Emilie Gillet in 2016. \n
+       Original code written by Emilie Gillet in 2016. \n \n
+       Impulses are scheduled rather than tested for: the gap to the next
+       one is drawn from the geometric distribution of the density at each
+       impulse, so samples in between cost only a counter check, and
+       ProcessBlock() sets the buffer's impulses and runs the filter over
+       it in one pass. A block with no impulse and a filter that has rung
+       out is not filtered at all.
 */
 class Particle
 {
   public:
+    static const size_t kStateBytes;
+
     Particle() {}
     ~Particle() {}
 
@@ -34,7 +43,16 @@ class Particle
     /** Get the next sample */
     float Process();
 
-    /** Get the raw noise output. Must call Process() first. */
+    /** Fills out with size samples, as Process() for each except with
+        sync on: it then randomizes the frequency once per block.
+        \param out Output buffer
+        \param size Number of samples
+    */
+    void ProcessBlock(float* out, size_t size);
+
+    /** Get the raw noise output of the last sample. Must call Process()
+        or ProcessBlock() first.
+    */
     float GetNoise();
 
     /** Set the resonant filter frequency
@@ -73,12 +91,26 @@ class Particle
     void SetSync(bool sync);
 
   private:
-    static constexpr float kRandFrac  = 1.f / RAND_MAX;
-    static constexpr float kRatioFrac = 1.f / 12.f;
-    float                  sample_rate_;
+    static constexpr float    kRatioFrac = 1.f / 12.f;
+    static constexpr uint32_t kNever     = 0xffffffffu;
+
+    /** Level of the filter's outputs under which it has rung out */
+    static constexpr float kSilence = 1e-6f;
+
+    float    Impulse();
+    bool     Advance();
+    void     Retune();
+    uint32_t NextGap();
+    void     UpdateDensity();
+
+    float sample_rate_;
     float aux_, frequency_, density_, gain_, spread_, resonance_;
     bool  sync_;
 
+    uint32_t   gap_;       /**< samples before the next impulse */
+    float      gap_scale_; /**< 1 / log2(1 - density_) */
+    FastRandom rng_;
+
 
     float rand_phase_;
     float rand_freq_;
@@ -87,6 +119,8 @@ class Particle
     float pre_gain_;
     Svf   filter_;
 };
+
+inline constexpr size_t Particle::kStateBytes = sizeof(Particle);
 } // namespace daisysp
 #endif
 #endif
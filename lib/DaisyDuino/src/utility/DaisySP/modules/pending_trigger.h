@@ -0,0 +1,85 @@
+#pragma once
+#ifndef DSY_PENDING_TRIGGER_H
+#define DSY_PENDING_TRIGGER_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @file pending_trigger.h */
+
+namespace daisysp
+{
+/** A trigger held back a number of samples, for the voices whose Trig()
+    takes an offset into the next block.
+
+    A sketch that reads its controls, MIDI or clock once per callback
+    still knows where in the block an event fell; Trig(offset) keeps
+    that, so the voice starts on that sample, not on the block boundary
+    (half a millisecond late at worst with 48 samples at 96 kHz), and
+    larger blocks cost nothing in timing. An offset past the end of the
+    block carries into the ones after it.
+
+    The voice advances it once per block:
+
+    const size_t at = trig_at_.Advance(size);
+    Render(out, at); // up to the trigger
+    if(at < size)
+    {
+        Strike();
+        Render(out + at, size - at);
+    }
+*/
+class PendingTrigger
+{
+  public:
+    static const size_t kStateBytes;
+
+    PendingTrigger() {}
+    ~PendingTrigger() {}
+
+    /** Clears any trigger */
+    inline void Init()
+    {
+        pending_ = false;
+        delay_   = 0;
+    }
+
+    /** Arms the trigger offset samples from the start of the next block,
+        in place of any already pending.
+    */
+    inline void Set(size_t offset)
+    {
+        pending_ = true;
+        delay_   = offset;
+    }
+
+    /** \return whether a trigger is still to come */
+    inline bool IsPending() const { return pending_; }
+
+    /** Moves on by a block of size samples.
+        \return the trigger's offset in the block, which fires it, or size
+        if it does not fall in it
+    */
+    inline size_t Advance(size_t size)
+    {
+        if(!pending_)
+            return size;
+        if(delay_ >= size)
+        {
+            delay_ -= size;
+            return size;
+        }
+        pending_ = false;
+        return delay_;
+    }
+
+  private:
+    bool   pending_;
+    size_t delay_;
+};
+
+inline constexpr size_t PendingTrigger::kStateBytes = sizeof(PendingTrigger);
+} // namespace daisysp
+#endif
+#endif
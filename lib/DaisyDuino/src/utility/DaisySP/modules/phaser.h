@@ -4,7 +4,10 @@
 #ifdef __cplusplus
 
 #include <stdint.h>
+#include <stddef.h>
+#include "dsp.h"
 #include "delayline.h"
+#include "mod_delay.h"
 
 /** @file phaser.h */
 
@@ -13,119 +16,245 @@ namespace daisysp
 /**  
     @brief Single Phaser engine. Used in Phaser.
     @author Ben Sergentanis
+
+    The allpass line is sized for max_sample_rate at compile time;
+    PhaserEngine is the one for DSY_MOD_DELAY_MAX_SAMPLE_RATE.
 */
-class PhaserEngine
+template <size_t max_sample_rate>
+class BasicPhaserEngine
 {
   public:
-    PhaserEngine() {}
-    ~PhaserEngine() {}
+    static const size_t kStateBytes;
+
+    BasicPhaserEngine() {}
+    ~BasicPhaserEngine() {}
 
     /** Initialize the module
         \param sample_rate Audio engine sample rate.
     */
-    void Init(float sample_rate);
+    void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+
+        del_.Init();
+        lfo_.Init();
+        lfo_amp_  = 0.f;
+        feedback_ = .2f;
+        SetFreq(200.f);
+
+        del_.SetDelay(0.f);
+
+        deltime_ = 0.f;
+        target_  = Target(0.f);
+
+        last_sample_ = 0.f;
+        SetLfoFreq(.3f);
+        SetLfoDepth(.9f);
+    }
 
     /** Get the next sample
         \param in Sample to process
     */
-    float Process(float in);
+    float Process(float in)
+    {
+        target_ = Target(lfo_.Process());
+        fonepole(deltime_, target_, .0001f);
+
+        last_sample_ = del_.Allpass(in + feedback_ * last_sample_,
+                                    static_cast<size_t>(deltime_),
+                                    .3f);
+
+        return (in + last_sample_) * .5f; //equal mix
+    }
+
+    /** Process a block, the lfo and the allpass delay target computed
+        once per kSubBlock samples and swept linearly in between.
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        // deltime_ follows the target over ~10000 samples, so a straight
+        // line between sub-block ends is as good as a divide per sample.
+        for(size_t pos = 0; pos < size; pos += kSubBlock)
+        {
+            const size_t n = size - pos < kSubBlock ? size - pos : kSubBlock;
+            const float  target = Target(lfo_.Advance(n));
+            const float  step
+                = (target - target_)
+                  * (n == kSubBlock ? 1.f / kSubBlock
+                                    : 1.f / static_cast<float>(n));
+            float t = target_;
+            for(size_t i = 0; i < n; i++)
+            {
+                t += step;
+                fonepole(deltime_, t, .0001f);
+                const float x = in[pos + i];
+                last_sample_  = del_.Allpass(x + feedback_ * last_sample_,
+                                            static_cast<size_t>(deltime_),
+                                            .3f);
+                out[pos + i]  = (x + last_sample_) * .5f;
+            }
+            target_ = target;
+        }
+    }
+
+    /** Samples per lfo evaluation in ProcessBlock() */
+    static constexpr size_t kSubBlock = TriangleLfo::kMaxAdvance;
 
     /** How much to modulate the allpass filter by.
         \param depth Works 0-1.
     */
-    void SetLfoDepth(float depth);
+    void SetLfoDepth(float depth) { lfo_amp_ = fclamp(depth, 0.f, 1.f); }
 
     /** Set lfo frequency.
         \param lfo_freq Frequency in Hz
     */
-    void SetLfoFreq(float lfo_freq);
+    void SetLfoFreq(float lfo_freq) { lfo_.SetFreq(lfo_freq, sample_rate_); }
 
     /** Set the allpass frequency
         \param ap_freq Frequency in Hz.
     */
-    void SetFreq(float ap_freq);
+    void SetFreq(float ap_freq)
+    {
+        ap_freq_ = fclamp(ap_freq, 0.f, 20000.f); //0 - 20kHz
+    }
 
     /** Set the feedback amount.
         \param feedback Amount from 0-1.
     */
-    void SetFeedback(float feedback);
+    void SetFeedback(float feedback)
+    {
+        feedback_ = fclamp(feedback, 0.f, .75f);
+    }
 
   private:
-    float                    sample_rate_;
-    static constexpr int32_t kDelayLength
-        = 2400; // 50 ms at 48kHz = .05 * 48000
+    float sample_rate_;
 
-    //triangle lfo
-    float lfo_phase_;
-    float lfo_freq_;
-    float lfo_amp_;
+    // 30 hertz frequency offset, lower than this introduces crunch. The
+    // allpass delay is at most sample_rate_ / kOffset, and is held to
+    // the line above max_sample_rate.
+    static constexpr float  kOffset = 30.f;
+    static constexpr size_t kDelayLength
+        = static_cast<size_t>(max_sample_rate / kOffset) + 1;
+    static constexpr float kMaxDelay = static_cast<float>(kDelayLength - 1);
 
-    float os_;
+    TriangleLfo lfo_;
+    float       lfo_amp_;
 
     float feedback_;
     float ap_freq_;
 
     float deltime_;
+    float target_; // deltime_ is smoothed towards this
     float last_sample_;
 
     DelayLine<float, kDelayLength> del_;
 
-    float ProcessLfo();
+    inline float Target(float lfo_phase) const
+    {
+        return fmin(sample_rate_
+                        / (lfo_phase * lfo_amp_ * ap_freq_ + ap_freq_ + kOffset),
+                    kMaxDelay);
+    }
 };
 
+template <size_t max_sample_rate>
+constexpr size_t BasicPhaserEngine<max_sample_rate>::kStateBytes
+    = sizeof(BasicPhaserEngine<max_sample_rate>);
+
+using PhaserEngine = BasicPhaserEngine<DSY_MOD_DELAY_MAX_SAMPLE_RATE>;
+
 //wraps up all of the phaser engines
 /**  
     @brief Phaser Effect.
     @author Ben Sergentanis
     @date Jan 2021
+
+    Phaser is the one for DSY_MOD_DELAY_MAX_SAMPLE_RATE.
 */
-class Phaser
+template <size_t max_sample_rate>
+class BasicPhaser
 {
   public:
-    Phaser() {}
-    ~Phaser() {}
+    static const size_t kStateBytes;
+
+    BasicPhaser() {}
+    ~BasicPhaser() {}
 
     /** Initialize the module
         \param sample_rate Audio engine sample rate
     */
-    void Init(float sample_rate);
+    void Init(float sample_rate)
+    {
+        engine_.Init(sample_rate);
+
+        poles_     = 4;
+        gain_frac_ = .5f;
+    }
 
     /** Get the next floating point sample.
         \param in Sample to process
     */
-    float Process(float in);
+    float Process(float in)
+    {
+        return engine_.Process(in) * static_cast<float>(poles_);
+    }
+
+    /** Process a block, as PhaserEngine::ProcessBlock().
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        engine_.ProcessBlock(in, out, size);
+        const float gain = static_cast<float>(poles_);
+        for(size_t i = 0; i < size; i++)
+        {
+            out[i] *= gain;
+        }
+    }
 
     /** Number of allpass stages.
         \param poles Works 1 to 8.
     */
-    void SetPoles(int poles);
+    void SetPoles(int poles) { poles_ = DSY_CLAMP(poles, 1, 8); }
 
     /** Set all lfo depths
         \param depth Works 0-1.
     */
-    void SetLfoDepth(float depth);
+    void SetLfoDepth(float depth) { engine_.SetLfoDepth(depth); }
 
     /** Set all lfo frequencies.
         \param lfo_freq Lfo freq in Hz.
     */
-    void SetLfoFreq(float lfo_freq);
+    void SetLfoFreq(float lfo_freq) { engine_.SetLfoFreq(lfo_freq); }
 
     /** Set all channel allpass freq in Hz.
         \param ap_freq Frequency in Hz.
     */
-    void SetFreq(float ap_freq);
+    void SetFreq(float ap_freq) { engine_.SetFreq(ap_freq); }
 
     /** Set all channels feedback.
         \param feedback Works 0-1.
     */
-    void SetFeedback(float feedback);
+    void SetFeedback(float feedback) { engine_.SetFeedback(feedback); }
 
   private:
-    static constexpr int kMaxPoles = 8;
-    PhaserEngine         engines_[kMaxPoles];
-    float                gain_frac_;
-    int                  poles_;
+    // The stages all see the same input and settings, so they stay
+    // identical: one engine scaled by poles_ stands in for all of them.
+    BasicPhaserEngine<max_sample_rate> engine_;
+    float                              gain_frac_;
+    int                                poles_;
 };
+
+template <size_t max_sample_rate>
+constexpr size_t BasicPhaser<max_sample_rate>::kStateBytes
+    = sizeof(BasicPhaser<max_sample_rate>);
+
+using Phaser = BasicPhaser<DSY_MOD_DELAY_MAX_SAMPLE_RATE>;
 } //namespace daisysp
 #endif
 #endif
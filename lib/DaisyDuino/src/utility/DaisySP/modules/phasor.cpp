@@ -10,18 +10,34 @@ void Phasor::SetFreq(float freq)
     inc_  = (TWOPI_F * freq_) / sample_rate_;
 }
 
-float Phasor::Process()
+static inline float Step(float &phs, float inc)
 {
     float out;
-    out = phs_ / TWOPI_F;
-    phs_ += inc_;
-    if(phs_ > TWOPI_F)
+    out = phs / TWOPI_F;
+    phs += inc;
+    if(phs > TWOPI_F)
     {
-        phs_ -= TWOPI_F;
+        phs -= TWOPI_F;
     }
-    if(phs_ < 0.0f)
+    if(phs < 0.0f)
     {
-        phs_ = 0.0f;
+        phs = 0.0f;
     }
     return out;
 }
+
+float Phasor::Process()
+{
+    return Step(phs_, inc_);
+}
+
+void Phasor::ProcessBlock(float *out, size_t size)
+{
+    float       phs = phs_;
+    const float inc = inc_;
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = Step(phs, inc);
+    }
+    phs_ = phs;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #ifndef DSY_PHASOR_H
 #define DSY_PHASOR_H
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -14,6 +15,8 @@ namespace daisysp
 class Phasor
 {
   public:
+    static const size_t kStateBytes;
+
     Phasor() {}
     ~Phasor() {}
     /** Initializes the Phasor module
@@ -44,6 +47,10 @@ class Phasor
     */
     float Process();
 
+    /** Fills out with size samples, the same as calling Process() for each.
+    */
+    void ProcessBlock(float *out, size_t size);
+
 
     /** Sets frequency of the Phasor in Hz
     */
@@ -58,6 +65,8 @@ class Phasor
     float freq_;
     float sample_rate_, inc_, phs_;
 };
+
+inline constexpr size_t Phasor::kStateBytes = sizeof(Phasor);
 } // namespace daisysp
 #endif
 #endif
@@ -2,16 +2,16 @@
 #ifndef DSY_PITCHSHIFTER_H
 #define DSY_PITCHSHIFTER_H
 #include <stdint.h>
+#include <stddef.h>
 #include <cmath>
-#ifdef USE_ARM_DSP
-#include "arm_math.h"
-#endif
-#include "delayline.h"
+#include "fast_sin.h"
 #include "phasor.h"
 #include "dsp.h"
+#include "semitones.h"
 
 /** Shift can be 30-100 ms lets just start with 50 for now.
-0.050 * SR = 2400 samples (at 48kHz)
+0.050 * SR = 2400 samples (at 48kHz), 4800 at 96kHz; PitchShifterMs
+works that out at compile time.
 */
 #define SHIFT_BUFFER_SIZE 16384
 //#define SHIFT_BUFFER_SIZE 4800
@@ -39,7 +39,7 @@ inline uint32_t myrand()
 
 Author: shensley
 
-Based on "Pitch Shifting" from ucsd.edu 
+Based on "Pitch Shifting" from ucsd.edu
 
 t = 1 - ((s *f) / R)
 
@@ -51,87 +51,128 @@ where:
 solving for t = 12.0
 f = (12 - 1) * 48000 / SHIFT_BUFFER_SIZE;
 
+Both taps read one delay line, max_size floats rounded up to a power
+of two, inside the object. With max_size 0 there is none and Init()
+takes the caller's memory instead, e.g. in SDRAM. The crossfade gains
+come from FastSin, no libm or CMSIS-DSP, so it builds anywhere.
+
+PitchShifter is the 16384 sample version, 64 KB. The whole-semitone
+ratios SetTransposition() steps through come from the Semitones table,
+built at compile time and kept in flash, not worked out per object.
+
 \todo - move hash_xs32 and myrand to dsp.h and give appropriate names
 */
-class PitchShifter
+template <size_t max_size>
+class BasicPitchShifter
 {
   public:
-    PitchShifter() {}
-    ~PitchShifter() {}
-    /** Initialize pitch shifter
+    static const size_t kStateBytes;
+
+    BasicPitchShifter() {}
+    ~BasicPitchShifter() {}
+
+    /** Copies, moves included, carry the state along. On the internal
+        memory the copy gets its own line; on the caller's, the two
+        share it and only one may keep running.
     */
-    void Init(float sr)
+    BasicPitchShifter(const BasicPitchShifter &other) { *this = other; }
+    BasicPitchShifter &operator=(const BasicPitchShifter &other)
     {
-        force_recalc_ = false;
-        sr_           = sr;
-        mod_freq_     = 5.0f;
-        SetSemitones();
-        for(uint8_t i = 0; i < 2; i++)
+        if(this == &other)
+            return *this;
+        const bool own = other.line_ == other.storage_;
+        line_          = own ? storage_ : other.line_;
+        line_size_     = other.line_size_;
+        line_mask_     = other.line_mask_;
+        write_ptr_     = other.write_ptr_;
+        pitch_shift_   = other.pitch_shift_;
+        mod_freq_      = other.mod_freq_;
+        del_size_      = other.del_size_;
+        force_recalc_  = other.force_recalc_;
+        sr_            = other.sr_;
+        shift_up_      = other.shift_up_;
+        transpose_     = other.transpose_;
+        fun_           = other.fun_;
+        mod_a_amt_     = other.mod_a_amt_;
+        mod_b_amt_     = other.mod_b_amt_;
+        prev_phs_a_    = other.prev_phs_a_;
+        prev_phs_b_    = other.prev_phs_b_;
+        for(size_t i = 0; i < 2; i++)
         {
-            gain_[i] = 0.0f;
-            d_[i].Init();
-            phs_[i].Init(sr, 50, i == 0 ? 0 : PI_F);
+            phs_[i]        = other.phs_[i];
+            gain_[i]       = other.gain_[i];
+            mod_[i]        = other.mod_[i];
+            slewed_mod_[i] = other.slewed_mod_[i];
+            mod_coeff_[i]  = other.mod_coeff_[i];
         }
-        shift_up_ = true;
-        del_size_ = SHIFT_BUFFER_SIZE;
-        SetDelSize(del_size_);
-        fun_ = 0.0f;
+        if(own)
+        {
+            for(size_t i = 0; i < line_size_; i++)
+                storage_[i] = other.storage_[i];
+        }
+        return *this;
+    }
+
+    /** Initialize pitch shifter
+    */
+    void Init(float sr)
+    {
+        static_assert(max_size > 0, "no internal memory, pass it to Init()");
+        Setup(sr, storage_, kStorageSize, true);
+    }
+
+    /** As Init(), for a shifter whose memory already reads as zero, such
+        as a static one in internal RAM: skips clearing the line.
+    */
+    void Init(float sr, ZeroedMemory)
+    {
+        static_assert(max_size > 0, "no internal memory, pass it to Init()");
+        Setup(sr, storage_, kStorageSize, false);
+    }
+
+    /** Initialize pitch shifter on the caller's memory
+        \param sr - sample rate
+        \param mem - delay memory, cleared here
+        \param size - floats at mem, of which the largest power of two is
+                      used; that is also the longest SetDelSize()
+    */
+    void Init(float sr, float *mem, size_t size)
+    {
+        Setup(sr, mem, size, true);
+    }
+
+    /** As above, on memory that already reads as zero: skips clearing it
+    */
+    void Init(float sr, float *mem, size_t size, ZeroedMemory)
+    {
+        Setup(sr, mem, size, false);
     }
 
     /** process pitch shifter
     */
     float Process(float &in)
     {
-        float val, fade1, fade2;
-        // First Process delay mod/crossfade
-        fade1 = phs_[0].Process();
-        fade2 = phs_[1].Process();
-        if(prev_phs_a_ > fade1)
-        {
-            mod_a_amt_ = fun_ * ((float)(myrand() % 255) / 255.0f)
-                         * (del_size_ * 0.5f);
-            mod_coeff_[0]
-                = 0.0002f + (((float)(myrand() % 255) / 255.0f) * 0.001f);
-        }
-        if(prev_phs_b_ > fade2)
-        {
-            mod_b_amt_ = fun_ * ((float)(myrand() % 255) / 255.0f)
-                         * (del_size_ * 0.5f);
-            mod_coeff_[1]
-                = 0.0002f + (((float)(myrand() % 255) / 255.0f) * 0.001f);
-        }
-        slewed_mod_[0] += mod_coeff_[0] * (mod_a_amt_ - slewed_mod_[0]);
-        slewed_mod_[1] += mod_coeff_[1] * (mod_b_amt_ - slewed_mod_[1]);
-        prev_phs_a_ = fade1;
-        prev_phs_b_ = fade2;
-        if(shift_up_)
+        float fade1 = phs_[0].Process();
+        float fade2 = phs_[1].Process();
+        return Step(in, fade1, fade2);
+    }
+
+    /** Processes a block, the same as Process() on each sample.
+        \param in - input buffer
+        \param out - output buffer, may be in
+        \param size - number of samples
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        float fade1[kChunkSize], fade2[kChunkSize];
+        for(size_t pos = 0; pos < size; pos += kChunkSize)
         {
-            fade1 = 1.0f - fade1;
-            fade2 = 1.0f - fade2;
+            const size_t n = size - pos < kChunkSize ? size - pos : kChunkSize;
+            phs_[0].ProcessBlock(fade1, n);
+            phs_[1].ProcessBlock(fade2, n);
+            for(size_t i = 0; i < n; i++)
+                out[pos + i] = Step(in[pos + i], fade1[i], fade2[i]);
         }
-        mod_[0] = fade1 * (del_size_ - 1);
-        mod_[1] = fade2 * (del_size_ - 1);
-#ifdef USE_ARM_DSP
-        gain_[0] = arm_sin_f32(fade1 * (float)M_PI);
-        gain_[1] = arm_sin_f32(fade2 * (float)M_PI);
-#else
-        gain_[0] = sinf(fade1 * PI_F);
-        gain_[1] = sinf(fade2 * PI_F);
-#endif
-
-        // Handle Delay Writing
-        d_[0].Write(in);
-        d_[1].Write(in);
-        // Modulate Delay Lines
-        //mod_a_amt = mod_b_amt = 0.0f;
-        d_[0].SetDelay(mod_[0] + mod_a_amt_);
-        d_[1].SetDelay(mod_[1] + mod_b_amt_);
-        d_[0].SetDelay(mod_[0] + slewed_mod_[0]);
-        d_[1].SetDelay(mod_[1] + slewed_mod_[1]);
-        val = 0.0f;
-        val += (d_[0].Read() * gain_[0]);
-        val += (d_[1].Read() * gain_[1]);
-        return val;
     }
 
     /** sets transposition in semitones
@@ -144,7 +185,7 @@ class PitchShifter
         {
             transpose_ = transpose;
             idx        = (uint8_t)fabsf(transpose);
-            ratio      = semitone_ratios_[idx % 12];
+            ratio      = Semitones::WholeRatio(idx % 12);
             ratio *= (uint8_t)(fabsf(transpose) / 12) + 1;
             if(transpose > 0.0f)
             {
@@ -168,11 +209,11 @@ class PitchShifter
         }
     }
 
-    /** sets delay size changing the timbre of the pitchshifting 
+    /** sets delay size changing the timbre of the pitchshifting
     */
     void SetDelSize(uint32_t size)
     {
-        del_size_     = size < SHIFT_BUFFER_SIZE ? size : SHIFT_BUFFER_SIZE;
+        del_size_     = size < line_size_ ? size : line_size_;
         force_recalc_ = true;
         SetTransposition(transpose_);
     }
@@ -182,17 +223,114 @@ class PitchShifter
     inline void SetFun(float f) { fun_ = f; }
 
   private:
-    inline void SetSemitones()
+    void Setup(float sr, float *mem, size_t size, bool clear)
     {
-        for(size_t i = 0; i < 12; i++)
+        line_size_ = 1;
+        while(line_size_ * 2 <= size)
+            line_size_ *= 2;
+        line_      = mem;
+        line_mask_ = line_size_ - 1;
+        write_ptr_ = 0;
+        if(clear)
+        {
+            for(size_t i = 0; i < line_size_; i++)
+                line_[i] = 0.0f;
+        }
+
+        force_recalc_ = false;
+        sr_           = sr;
+        mod_freq_     = 5.0f;
+        transpose_    = 0.0f;
+        for(uint8_t i = 0; i < 2; i++)
         {
-            semitone_ratios_[i] = powf(2.0f, (float)i / 12);
+            gain_[i]       = 0.0f;
+            slewed_mod_[i] = 0.0f;
+            mod_coeff_[i]  = 0.0f;
+            phs_[i].Init(sr, 50, i == 0 ? 0 : PI_F);
         }
+        mod_a_amt_  = 0.0f;
+        mod_b_amt_  = 0.0f;
+        prev_phs_a_ = 0.0f;
+        prev_phs_b_ = 0.0f;
+        shift_up_   = true;
+        del_size_   = static_cast<uint32_t>(line_size_);
+        SetDelSize(del_size_);
+        fun_ = 0.0f;
+        FastSin::Init();
+    }
+
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t kStorageSize = RoundUp(max_size);
+
+    static constexpr size_t kChunkSize = 32;
+
+    /** Reads the line as DelayLine::SetDelay(delay) then Read() would */
+    inline float Tap(float delay) const
+    {
+        const int32_t int_delay = static_cast<int32_t>(delay);
+        const float   frac      = delay - static_cast<float>(int_delay);
+        const size_t  d = static_cast<size_t>(int_delay) < line_size_
+                              ? static_cast<size_t>(int_delay)
+                              : line_size_ - 1;
+        const float a = line_[(write_ptr_ + d) & line_mask_];
+        const float b = line_[(write_ptr_ + d + 1) & line_mask_];
+        return a + (b - a) * frac;
     }
-    typedef DelayLine<float, SHIFT_BUFFER_SIZE> ShiftDelay;
-    ShiftDelay                                  d_[2];
-    float                                       pitch_shift_, mod_freq_;
-    uint32_t                                    del_size_;
+
+    inline float Step(float in, float fade1, float fade2)
+    {
+        float val;
+        // First Process delay mod/crossfade
+        if(prev_phs_a_ > fade1)
+        {
+            mod_a_amt_ = fun_ * ((float)(myrand() % 255) / 255.0f)
+                         * (del_size_ * 0.5f);
+            mod_coeff_[0]
+                = 0.0002f + (((float)(myrand() % 255) / 255.0f) * 0.001f);
+        }
+        if(prev_phs_b_ > fade2)
+        {
+            mod_b_amt_ = fun_ * ((float)(myrand() % 255) / 255.0f)
+                         * (del_size_ * 0.5f);
+            mod_coeff_[1]
+                = 0.0002f + (((float)(myrand() % 255) / 255.0f) * 0.001f);
+        }
+        slewed_mod_[0] += mod_coeff_[0] * (mod_a_amt_ - slewed_mod_[0]);
+        slewed_mod_[1] += mod_coeff_[1] * (mod_b_amt_ - slewed_mod_[1]);
+        prev_phs_a_ = fade1;
+        prev_phs_b_ = fade2;
+        if(shift_up_)
+        {
+            fade1 = 1.0f - fade1;
+            fade2 = 1.0f - fade2;
+        }
+        mod_[0] = fade1 * (del_size_ - 1);
+        mod_[1] = fade2 * (del_size_ - 1);
+        // sin(fade * pi), fade in [0, 1]
+        gain_[0] = FastSin::Sin(fade1 * 0.5f);
+        gain_[1] = FastSin::Sin(fade2 * 0.5f);
+
+        // Handle Delay Writing
+        line_[write_ptr_] = in;
+        write_ptr_        = (write_ptr_ - 1) & line_mask_;
+        // Modulate Delay Lines
+        val = 0.0f;
+        val += (Tap(mod_[0] + slewed_mod_[0]) * gain_[0]);
+        val += (Tap(mod_[1] + slewed_mod_[1]) * gain_[1]);
+        return val;
+    }
+
+    float *  line_;
+    size_t   line_size_, line_mask_, write_ptr_;
+    float    pitch_shift_, mod_freq_;
+    uint32_t del_size_;
     /** lfo stuff
 */
     bool   force_recalc_;
@@ -202,10 +340,24 @@ class PitchShifter
     float  gain_[2], mod_[2], transpose_;
     float  fun_, mod_a_amt_, mod_b_amt_, prev_phs_a_, prev_phs_b_;
     float  slewed_mod_[2], mod_coeff_[2];
-    /** pitch stuff
-*/
-    float semitone_ratios_[12];
+    float storage_[max_size > 0 ? kStorageSize : 1];
 };
+
+template <size_t max_size>
+constexpr size_t BasicPitchShifter<max_size>::kStateBytes
+    = sizeof(BasicPitchShifter<max_size>);
+
+/** The original 16384 sample pitch shifter */
+using PitchShifter = BasicPitchShifter<SHIFT_BUFFER_SIZE>;
+
+/** A pitch shifter whose line holds max_ms at max_sample_rate, sized at
+    compile time, e.g. PitchShifterMs<100, 96000> for 100 ms at up to
+    96 kHz. SetDelSize() in samples still sets the window at the actual
+    rate.
+*/
+template <size_t max_ms, size_t max_sample_rate>
+using PitchShifterMs
+    = BasicPitchShifter<ms_to_samples(max_ms, max_sample_rate)>;
 } // namespace daisysp
 
 #endif
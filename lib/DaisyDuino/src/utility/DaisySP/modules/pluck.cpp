@@ -1,4 +1,3 @@
-#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "pluck.h"
@@ -11,18 +10,11 @@ using namespace daisysp;
 
 void Pluck::Reinit()
 {
-    int    n;
-    float  val = 0;
-    float *ap  = buf_;
     //npts_ = (int32_t)roundf(decay_ * (float)(maxpts_ - PLUKMIN) + PLUKMIN);
     npts_ = (int32_t)(decay_ * (float)(maxpts_ - PLUKMIN) + PLUKMIN);
     //sicps_ = ((float)npts_ * INTERPFACTOR + INTERPFACTOR/2.0f) * (1.0f / _sr);
     sicps_ = ((float)npts_ * 256.0f + 128.0f) * (1.0f / sample_rate_);
-    for(n = npts_; n--;)
-    {
-        val   = (float)((float)rand() / RAND_MAX);
-        *ap++ = (val * 2.0f) - 1.0f;
-    }
+    rng_.FillBlock(buf_, static_cast<size_t>(npts_));
     phs256_ = 0;
 }
 
@@ -38,6 +30,7 @@ void Pluck::Init(float sample_rate, float *buf, int32_t npts, int32_t mode)
     npts_   = npts;
     buf_    = buf;
 
+    rng_.Init();
     Reinit();
     /* tuned pitch convt */
     sicps_ = (npts * 256.0f + 128.0f) * (1.0f / sample_rate_);
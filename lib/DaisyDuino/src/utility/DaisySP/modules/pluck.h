@@ -4,6 +4,8 @@
 #define DSY_PLUCK_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include "fast_random.h"
 #ifdef __cplusplus
 
 namespace daisysp
@@ -33,6 +35,8 @@ enum
 class Pluck
 {
   public:
+    static const size_t kStateBytes;
+
     Pluck() {}
     ~Pluck() {}
     /** Initializes the Pluck module.
@@ -44,6 +48,11 @@ class Pluck
     */
     void Init(float sample_rate, float *buf, int32_t npt, int32_t mode);
 
+    /** Restarts the noise that fills buf on each trigger from a given
+        seed, for repeatable output. Call after Init().
+    */
+    inline void SetSeed(uint32_t seed) { rng_.Init(seed); }
+
 
     /** Processes the waveform to be generated, returning one sample. This should be called once per sample period.
     */
@@ -94,7 +103,11 @@ class Pluck
     float   sample_rate_;
     char    init_;
     int32_t mode_;
+
+    FastRandom rng_;
 };
+
+inline constexpr size_t Pluck::kStateBytes = sizeof(Pluck);
 } // namespace daisysp
 #endif
 #endif
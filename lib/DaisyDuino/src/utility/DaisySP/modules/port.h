@@ -2,6 +2,7 @@
 #pragma once
 #ifndef DSY_PORT_H
 #define DSY_PORT_H
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -26,6 +27,8 @@ Location: Opcodes/biquad.c
 class Port
 {
   public:
+    static const size_t kStateBytes;
+
     Port() {}
     ~Port() {}
     /** Initializes Port module
@@ -54,6 +57,8 @@ class Port
     float c1_, c2_, yt1_, prvhtim_;
     float sample_rate_, onedsr_;
 };
+
+inline constexpr size_t Port::kStateBytes = sizeof(Port);
 } // namespace daisysp
 #endif
 #endif
@@ -0,0 +1,179 @@
+#pragma once
+#ifndef DSY_REAL_FFT_H
+#define DSY_REAL_FFT_H
+
+#include <cstddef>
+#include <cstring> // for memcpy
+#include <cmath>
+#include <utility>
+#include "dsp.h"
+
+#ifdef USE_ARM_DSP
+#include "arm_math.h" // required for platform-optimized version
+#endif
+
+namespace daisysp
+{
+/** Real FFT of n points in the packed layout of arm_rfft_fast_f32:
+ * {X[0].re, X[n/2].re, X[1].re, X[1].im, ... X[n/2-1].im}.
+ * The inverse is scaled by 1/n. Both transforms overwrite their input.
+ * Generic version, always available: a radix-2 complex FFT of n/2 points
+ * plus the real split, with the twiddles tabulated in Init().
+ */
+template <size_t n>
+class RealFftGeneric
+{
+  public:
+    static const size_t kStateBytes;
+
+    RealFftGeneric() {}
+
+    void Init()
+    {
+        for(size_t k = 0; k < n / 2; k++)
+        {
+            const float w = TWOPI_F * (float)k / (float)n;
+            cos_[k]       = cosf(w);
+            sin_[k]       = -sinf(w);
+        }
+    }
+
+    void Forward(float* in, float* out)
+    {
+        memcpy(out, in, n * sizeof(out[0]));
+        Fft(out, false);
+
+        /* X[k] = E - j W^k O, X[m - k] = conj(E + j W^k O) */
+        const float z0r = out[0], z0i = out[1];
+        out[0] = z0r + z0i;
+        out[1] = z0r - z0i;
+        for(size_t k = 1; k <= m / 2; k++)
+        {
+            float*      a  = &out[2 * k];
+            float*      b  = &out[2 * (m - k)];
+            const float er = 0.5f * (a[0] + b[0]), ei = 0.5f * (a[1] - b[1]);
+            const float orr = 0.5f * (a[0] - b[0]), oi = 0.5f * (a[1] + b[1]);
+            const float tr = cos_[k] * orr - sin_[k] * oi;
+            const float ti = cos_[k] * oi + sin_[k] * orr;
+            a[0]           = er + ti;
+            a[1]           = ei - tr;
+            b[0]           = er - ti;
+            b[1]           = -(ei + tr);
+        }
+    }
+
+    void Inverse(float* in, float* out)
+    {
+        /* Undo the split, Z[k] = E + conj(W^k) T */
+        out[0] = 0.5f * (in[0] + in[1]);
+        out[1] = 0.5f * (in[0] - in[1]);
+        for(size_t k = 1; k <= m / 2; k++)
+        {
+            const float* a  = &in[2 * k];
+            const float* b  = &in[2 * (m - k)];
+            const float  er = 0.5f * (a[0] + b[0]), ei = 0.5f * (a[1] - b[1]);
+            const float  tr = -0.5f * (a[1] + b[1]), ti = 0.5f * (a[0] - b[0]);
+            const float  orr = cos_[k] * tr + sin_[k] * ti;
+            const float  oi  = cos_[k] * ti - sin_[k] * tr;
+            out[2 * k]           = er + orr;
+            out[2 * k + 1]       = ei + oi;
+            out[2 * (m - k)]     = er - orr;
+            out[2 * (m - k) + 1] = oi - ei;
+        }
+        Fft(out, true);
+
+        const float scale = 1.0f / (float)m;
+        for(size_t i = 0; i < n; i++)
+        {
+            out[i] *= scale;
+        }
+    }
+
+  private:
+    static constexpr size_t m = n / 2; /*< complex FFT length */
+
+    /* In-place radix-2 FFT of m interleaved complex points, unscaled */
+    void Fft(float* z, bool inverse)
+    {
+        for(size_t i = 1, j = 0; i < m; i++)
+        {
+            size_t bit = m >> 1;
+            for(; j & bit; bit >>= 1)
+            {
+                j ^= bit;
+            }
+            j ^= bit;
+            if(i < j)
+            {
+                std::swap(z[2 * i], z[2 * j]);
+                std::swap(z[2 * i + 1], z[2 * j + 1]);
+            }
+        }
+        for(size_t len = 2; len <= m; len <<= 1)
+        {
+            const size_t step = n / len;
+            for(size_t i = 0; i < m; i += len)
+            {
+                for(size_t k = 0; k < len / 2; k++)
+                {
+                    const float wr = cos_[k * step];
+                    const float wi = inverse ? -sin_[k * step] : sin_[k * step];
+                    float*      a  = &z[2 * (i + k)];
+                    float*      b  = &z[2 * (i + k + len / 2)];
+                    const float tr = b[0] * wr - b[1] * wi;
+                    const float ti = b[0] * wi + b[1] * wr;
+                    b[0]           = a[0] - tr;
+                    b[1]           = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+    }
+
+    float cos_[n / 2]; /*< cos(2 pi k / n) */
+    float sin_[n / 2]; /*< -sin(2 pi k / n) */
+};
+
+template <size_t n>
+constexpr size_t RealFftGeneric<n>::kStateBytes = sizeof(RealFftGeneric<n>);
+
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+
+/** ARM-specific real FFT, see RealFftGeneric */
+template <size_t n>
+class RealFftARM
+{
+  public:
+    static const size_t kStateBytes;
+
+    RealFftARM() : fft_{0} {}
+
+    void Init() { arm_rfft_fast_init_f32(&fft_, n); }
+
+    void Forward(float* in, float* out) { arm_rfft_fast_f32(&fft_, in, out, 0); }
+
+    void Inverse(float* in, float* out) { arm_rfft_fast_f32(&fft_, in, out, 1); }
+
+  private:
+    arm_rfft_fast_instance_f32 fft_; /*< CMSIS real FFT instance */
+};
+
+template <size_t n>
+constexpr size_t RealFftARM<n>::kStateBytes = sizeof(RealFftARM<n>);
+
+/* default to ARM implementation */
+template <size_t n>
+using RealFft = RealFftARM<n>;
+
+#else // #if(defined(USE_ARM_DSP) && defined(__arm__))
+
+/* default to generic implementation */
+template <size_t n>
+using RealFft = RealFftGeneric<n>;
+
+#endif // #if(defined(USE_ARM_DSP) && defined(__arm__))
+
+} // namespace daisysp
+
+#endif // DSY_REAL_FFT_H
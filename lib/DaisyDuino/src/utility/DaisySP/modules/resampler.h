@@ -0,0 +1,335 @@
+#pragma once
+#ifndef DSY_RESAMPLER_H
+#define DSY_RESAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "const_table.h"
+
+#ifdef USE_ARM_DSP
+#include "arm_math.h" // required for platform-optimized version
+#endif
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** Stereo sample rate converter, polyphase windowed sinc, between
+    sources on clocks of their own: a file at 44.1 kHz, a USB host, a
+    second codec.
+
+    Write() puts frames in at the source rate, into a FIFO of up to
+    max_frames; Read() takes them out at the output rate. Each output
+    frame is a num_taps point dot product of each channel's history with
+    a Kaiser-windowed sinc, cut off at the lower rate's Nyquist. The
+    sinc is tabulated at Init() for kPhases positions between two input
+    samples, and each output blends the two phases either side of its
+    position, so a ratio that is fixed, irrational or drifting all cost
+    the same: 4 * num_taps multiply-adds per output frame, both channels.
+    On ARM with USE_ARM_DSP defined these are CMSIS arm_dot_prod_f32.
+
+    num_taps is the quality; images and aliases are down by about, and
+    the response flat (to 0.3 dB) up to, at 44.1 kHz:
+      16 - 75 dB, 15 kHz: short and cheap
+      32 - 90 dB, 18 kHz: the usual choice for program audio
+      64 - 105 dB, 19 kHz
+    Downsampling by r keeps the taps, so the band edge there is r times
+    as wide; in_rate may be up to num_taps times out_rate.
+
+    Modes:
+      FIXED - the ratio is in_rate / out_rate exactly, e.g. for a file
+              pulled in as needed: Write() FramesNeeded(size) frames,
+              then Read(size).
+      ASYNC - the rates are nominal and the clocks drift, e.g. a source
+              pushing blocks from its own interrupt-paced clock. Read()
+              outputs silence until the FIFO holds max_frames / 2, then
+              steers the ratio, up to kMaxDrift either way, to keep it
+              there, as UsbAudio's feedback does for the host. A Read()
+              that runs dry starts that over.
+
+    Latency is num_taps / 2 input frames plus what the FIFO holds.
+    Write(), Read() and the rest are for one context, e.g. the audio
+    callback, like the other modules.
+
+    declaration example:
+
+    static Resampler<32, 512> src; // 21 KB
+    src.Init(44100.f, sample_rate);
+    ...
+    const size_t n = src.FramesNeeded(size); // AudioCallback
+    player.ProcessBlock(l, r, n);
+    src.Write(l, r, n);
+    src.Read(out[0], out[1], size);
+*/
+template <size_t num_taps, size_t max_frames>
+class Resampler
+{
+  public:
+    static const size_t kStateBytes;
+
+    enum class Mode
+    {
+        FIXED,
+        ASYNC,
+    };
+
+    Resampler() {}
+    ~Resampler() {}
+
+    /** Sinc positions tabulated between two input samples */
+    static constexpr size_t kPhases = 128;
+
+    /** Most ASYNC moves the ratio off in_rate / out_rate, 2000 ppm */
+    static constexpr float kMaxDrift = 0.002f;
+
+    /** Designs the filter and empties the FIFO. Setup-time only: the
+        table is built with double-precision libm.
+        \param in_rate Rate Write() is fed at
+        \param out_rate Rate Read() is taken at
+        \param mode FIXED or ASYNC
+    */
+    void Init(float in_rate, float out_rate, Mode mode = Mode::FIXED)
+    {
+        mode_     = mode;
+        nominal_  = in_rate / out_rate;
+        out_rate_ = out_rate;
+        // 32.32, from double so a FIXED ratio holds over hours
+        nominal_step_ = static_cast<uint64_t>(static_cast<double>(in_rate)
+                                              / static_cast<double>(out_rate)
+                                              * 4294967296.0);
+        Design(nominal_ > 1.f ? 1.f / nominal_ : 1.f);
+        Reset();
+    }
+
+    /** Empties the FIFO and the history, keeping the filter */
+    void Reset()
+    {
+        memset(buf_, 0, sizeof(buf_));
+        // The window starts on silence: the first output needs one frame.
+        read_      = 0;
+        write_     = num_taps - 1;
+        frac_      = 0;
+        primed_    = mode_ == Mode::FIXED;
+        fill_avg_  = static_cast<float>(kTarget);
+        underruns_ = 0;
+        overruns_  = 0;
+        SetDrift(0.f);
+    }
+
+    /** Puts frames in, at the source rate.
+        \return frames taken, short of frames only if the FIFO is full
+    */
+    size_t Write(const float *left, const float *right, size_t frames)
+    {
+        if(write_ + frames > kBufFrames && read_ > 0)
+        {
+            // Slide what is still to be read back to the start.
+            const size_t keep = write_ - read_;
+            memmove(buf_[0], buf_[0] + read_, keep * sizeof(float));
+            memmove(buf_[1], buf_[1] + read_, keep * sizeof(float));
+            read_  = 0;
+            write_ = keep;
+        }
+        size_t n = kBufFrames - write_;
+        if(n < frames)
+            overruns_++;
+        else
+            n = frames;
+        memcpy(buf_[0] + write_, left, n * sizeof(float));
+        memcpy(buf_[1] + write_, right, n * sizeof(float));
+        write_ += n;
+        return n;
+    }
+
+    /** Takes frames out, at the output rate. What the FIFO cannot cover
+        is silence, and counts as an underrun.
+        \return frames converted, the rest of size being silence
+    */
+    size_t Read(float *left, float *right, size_t size)
+    {
+        if(mode_ == Mode::ASYNC)
+            Steer(size);
+        size_t n = 0;
+        if(primed_)
+        {
+            for(; n < size && read_ + num_taps <= write_; n++)
+            {
+                const uint32_t ph = frac_ >> kPhaseShift;
+                const float    a
+                    = static_cast<float>(frac_ & kPhaseMask) * kPhaseScale;
+                const float *c0 = table_[ph];
+                const float *c1 = table_[ph + 1];
+                const float *xl = buf_[0] + read_;
+                const float *xr = buf_[1] + read_;
+                const float  l0 = Dot(xl, c0), l1 = Dot(xl, c1);
+                const float  r0 = Dot(xr, c0), r1 = Dot(xr, c1);
+                left[n]         = l0 + a * (l1 - l0);
+                right[n]        = r0 + a * (r1 - r0);
+
+                const uint64_t acc = static_cast<uint64_t>(frac_) + step_;
+                read_ += static_cast<size_t>(acc >> 32);
+                frac_ = static_cast<uint32_t>(acc);
+            }
+        }
+        if(n < size)
+        {
+            memset(left + n, 0, (size - n) * sizeof(float));
+            memset(right + n, 0, (size - n) * sizeof(float));
+            if(primed_)
+            {
+                underruns_++;
+                primed_ = mode_ == Mode::FIXED;
+            }
+        }
+        return n;
+    }
+
+    /** \return frames to Write() before Read(size) can fill all of size,
+        at the current ratio
+    */
+    size_t FramesNeeded(size_t size) const
+    {
+        if(size == 0)
+            return 0;
+        const uint64_t adv
+            = static_cast<uint64_t>(frac_) + (size - 1) * step_;
+        const size_t need = read_ + static_cast<size_t>(adv >> 32) + num_taps;
+        return need > write_ ? need - write_ : 0;
+    }
+
+    /** \return input frames in the FIFO ahead of the filter window */
+    inline size_t GetFill() const
+    {
+        return write_ > read_ + num_taps ? write_ - read_ - num_taps : 0;
+    }
+
+    /** \return input frames per output frame, as steered in ASYNC */
+    inline float GetRatio() const { return ratio_; }
+
+    /** \return Read() calls that ran out of input since Reset() */
+    inline uint32_t GetUnderruns() const { return underruns_; }
+
+    /** \return Write() calls the FIFO had no room for since Reset() */
+    inline uint32_t GetOverruns() const { return overruns_; }
+
+  private:
+    static_assert(num_taps >= 8 && num_taps % 2 == 0,
+                  "num_taps must be even, 8 or more");
+    static_assert(max_frames >= 2, "max_frames too small");
+
+    static constexpr size_t   kBufFrames  = max_frames + num_taps;
+    static constexpr size_t   kTarget     = max_frames / 2;
+    static constexpr uint32_t kPhaseShift = 25; // 32 - log2(kPhases)
+    static constexpr uint32_t kPhaseMask  = (1u << kPhaseShift) - 1;
+    static constexpr float    kPhaseScale = 1.f / (1u << kPhaseShift);
+    static_assert((1u << (32 - kPhaseShift)) == kPhases, "kPhaseShift");
+
+    /** Kaiser shape and -6 dB point, as a part of the lower Nyquist,
+        for each quality
+    */
+    static constexpr double kBeta
+        = num_taps >= 64 ? 10.0 : (num_taps >= 32 ? 8.0 : 6.0);
+    static constexpr double kCutoff
+        = num_taps >= 64 ? 0.95 : (num_taps >= 32 ? 0.92 : 0.85);
+
+    /** Row p is the kernel at p / kPhases of an input sample past the
+        window's centre, normalised to unity gain; kPhases + 1 rows, so
+        the last phase has one past it to blend with.
+    */
+    void Design(float bandwidth)
+    {
+        const double pi   = 3.14159265358979323846;
+        const double fc   = 0.5 * kCutoff * static_cast<double>(bandwidth);
+        const double half = 0.5 * static_cast<double>(num_taps);
+        for(size_t p = 0; p <= kPhases; p++)
+        {
+            double tmp[num_taps];
+            double sum = 0.0;
+            for(size_t k = 0; k < num_taps; k++)
+            {
+                const double t = static_cast<double>(k) - (half - 1.0)
+                                 - static_cast<double>(p) / kPhases;
+                const double x = 2.0 * pi * fc * t;
+                const double s = fabs(x) < 1e-9 ? 1.0 : sin(x) / x;
+                // Zero at the half-width itself: row kPhases is row 0 one
+                // tap on, and neither has a tap past the window.
+                const double r = t / half;
+                const double w
+                    = r * r < 1.0 ? ConstTable::Kaiser(0.5 + 0.5 * r, kBeta)
+                                  : 0.0;
+                tmp[k] = s * w;
+                sum += tmp[k];
+            }
+            for(size_t k = 0; k < num_taps; k++)
+            {
+                table_[p][k] = static_cast<float>(tmp[k] / sum);
+            }
+        }
+    }
+
+    static inline float Dot(const float *x, const float *c)
+    {
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+        float result;
+        arm_dot_prod_f32(x, c, num_taps, &result);
+        return result;
+#else
+        float acc = 0.f;
+        for(size_t k = 0; k < num_taps; k++)
+        {
+            acc += x[k] * c[k];
+        }
+        return acc;
+#endif
+    }
+
+    void SetDrift(float drift)
+    {
+        ratio_ = nominal_ * (1.f + drift);
+        step_  = nominal_step_
+                + static_cast<int64_t>(static_cast<float>(nominal_step_) * drift);
+    }
+
+    /** ASYNC: moves the ratio against the smoothed fill's distance from
+        kTarget. A full-scale 1% per kTarget frames gives a loop of about
+        a second at 48 kHz and settles 200 ppm of drift within ten
+        frames of the target.
+    */
+    void Steer(size_t size)
+    {
+        const float fill = static_cast<float>(GetFill());
+        if(!primed_)
+        {
+            if(GetFill() < kTarget)
+                return;
+            primed_   = true;
+            fill_avg_ = fill;
+        }
+        // ~50 ms smoothing, whatever the block size
+        const float coeff = static_cast<float>(size) / (0.05f * out_rate_);
+        fill_avg_ += (fill - fill_avg_) * (coeff < 1.f ? coeff : 1.f);
+        float drift = (fill_avg_ - static_cast<float>(kTarget))
+                      * (0.01f / static_cast<float>(kTarget));
+        drift = drift < -kMaxDrift ? -kMaxDrift
+                                   : (drift > kMaxDrift ? kMaxDrift : drift);
+        SetDrift(drift);
+    }
+
+    float    table_[kPhases + 1][num_taps];
+    float    buf_[2][kBufFrames];
+    size_t   read_, write_;
+    uint32_t frac_;
+    uint64_t step_, nominal_step_;
+    Mode     mode_;
+    float    nominal_, ratio_, out_rate_, fill_avg_;
+    bool     primed_;
+    uint32_t underruns_, overruns_;
+};
+
+template <size_t num_taps, size_t max_frames>
+constexpr size_t Resampler<num_taps, max_frames>::kStateBytes
+    = sizeof(Resampler<num_taps, max_frames>);
+} // namespace daisysp
+#endif
+#endif
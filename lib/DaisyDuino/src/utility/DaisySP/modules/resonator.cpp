@@ -6,6 +6,7 @@ using namespace daisysp;
 void Resonator::Init(float position, int resolution, float sample_rate)
 {
     sample_rate_ = sample_rate;
+    dirty_       = true;
 
     SetFreq(440.f);
     SetStructure(.5f);
@@ -13,15 +14,16 @@ void Resonator::Init(float position, int resolution, float sample_rate)
     SetDamping(.5f);
 
     resolution_ = fmin(resolution, kMaxNumModes);
+    num_modes_  = NumModes(resolution_);
 
-    for(int i = 0; i < resolution; ++i)
+    for(int i = 0; i < resolution_; ++i)
     {
-        mode_amplitude_[i] = cos(position * TWOPI_F) * 0.25f;
+        mode_amplitude_[i] = ModeAmplitude(position);
     }
 
-    for(int i = 0; i < kMaxNumModes / kModeBatchSize; ++i)
+    for(int i = 0; i < kMaxNumModes; ++i)
     {
-        mode_filters_[i].Init();
+        state_1_[i] = state_2_[i] = 0.0f;
     }
 }
 
@@ -45,32 +47,78 @@ inline float NthHarmonicCompensation(int n, float stiffness)
 
 float Resonator::Process(const float in)
 {
-    //convert Hz to cycles / sample
+    if(dirty_)
+    {
+        UpdateModes();
+    }
+
     float out = 0.f;
+    for(int b = 0; b < num_modes_; b += kModeBatchSize)
+    {
+        // Summed per batch, as the batched ResonatorSvf did.
+        float s_out = 0.0f;
+        for(int i = b; i < b + kModeBatchSize; ++i)
+        {
+            const float g  = mode_g_[i];
+            const float hp = (in - mode_r_plus_g_[i] * state_1_[i] - state_2_[i])
+                             * mode_h_[i];
+            const float bp = g * hp + state_1_[i];
+            state_1_[i]    = g * hp + bp;
+            const float lp = g * bp + state_2_[i];
+            state_2_[i]    = g * bp + lp;
+            s_out += mode_gain_[i] * bp;
+        }
+        out += s_out;
+    }
+    return out;
+}
 
-    float stiffness  = CalcStiff(structure_);
-    float f0         = frequency_ * NthHarmonicCompensation(3, stiffness);
-    float brightness = brightness_;
+void Resonator::UpdateModes()
+{
+    ComputeModes(frequency_,
+                 structure_,
+                 brightness_,
+                 damping_,
+                 mode_amplitude_,
+                 num_modes_,
+                 mode_g_,
+                 mode_r_plus_g_,
+                 mode_h_,
+                 mode_gain_);
+    dirty_ = false;
+}
+
+float Resonator::ModeAmplitude(float position)
+{
+    return cos(position * TWOPI_F) * 0.25f;
+}
+
+void Resonator::ComputeModes(float        frequency,
+                             float        structure,
+                             float        brightness,
+                             float        damping,
+                             const float *amplitude,
+                             int          num_modes,
+                             float *      g_out,
+                             float *      r_plus_g_out,
+                             float *      h_out,
+                             float *      gain_out)
+{
+    float stiffness = CalcStiff(structure);
+    float f0        = frequency * NthHarmonicCompensation(3, stiffness);
 
     float harmonic       = f0;
     float stretch_factor = 1.0f;
 
-    float input  = damping_ * 79.7f;
+    float input  = damping * 79.7f;
     float q_sqrt = powf(2.f, input * ratiofrac_);
 
     float q = 500.0f * q_sqrt * q_sqrt;
-    brightness *= 1.0f - structure_ * 0.3f;
-    brightness *= 1.0f - damping_ * 0.3f;
+    brightness *= 1.0f - structure * 0.3f;
+    brightness *= 1.0f - damping * 0.3f;
     float q_loss = brightness * (2.0f - brightness) * 0.85f + 0.15f;
 
-    float mode_q[kModeBatchSize];
-    float mode_f[kModeBatchSize];
-    float mode_a[kModeBatchSize];
-    int   batch_counter = 0;
-
-    ResonatorSvf<kModeBatchSize>* batch_processor = &mode_filters_[0];
-
-    for(int i = 0; i < resolution_; ++i)
+    for(int i = 0; i < num_modes; ++i)
     {
         float mode_frequency = harmonic * stretch_factor;
         if(mode_frequency >= 0.499f)
@@ -79,18 +127,12 @@ float Resonator::Process(const float in)
         }
         const float mode_attenuation = 1.0f - mode_frequency * 2.0f;
 
-        mode_f[batch_counter] = mode_frequency;
-        mode_q[batch_counter] = 1.0f + mode_frequency * q;
-        mode_a[batch_counter] = mode_amplitude_[i] * mode_attenuation;
-        ++batch_counter;
-
-        if(batch_counter == kModeBatchSize)
-        {
-            batch_counter = 0;
-            batch_processor->Process<batch_processor->BAND_PASS, true>(
-                mode_f, mode_q, mode_a, in, &out);
-            ++batch_processor;
-        }
+        const float g   = ResonatorSvf<kModeBatchSize>::fasttan(mode_frequency);
+        const float r   = 1.0f / (1.0f + mode_frequency * q);
+        g_out[i]        = g;
+        h_out[i]        = 1.0f / (1.0f + r * g + g * g);
+        r_plus_g_out[i] = r + g;
+        gain_out[i]     = amplitude[i] * mode_attenuation;
 
         stretch_factor += stiffness;
         if(stiffness < 0.0f)
@@ -106,28 +148,34 @@ float Resonator::Process(const float in)
         harmonic += f0;
         q *= q_loss;
     }
-
-    return out;
 }
 
 void Resonator::SetFreq(float freq)
 {
-    frequency_ = freq / sample_rate_;
+    const float f = freq / sample_rate_;
+    dirty_ |= f != frequency_;
+    frequency_ = f;
 }
 
 void Resonator::SetStructure(float structure)
 {
-    structure_ = fmax(fmin(structure, 1.f), 0.f);
+    const float s = fmax(fmin(structure, 1.f), 0.f);
+    dirty_ |= s != structure_;
+    structure_ = s;
 }
 
 void Resonator::SetBrightness(float brightness)
 {
-    brightness_ = fmax(fmin(brightness, 1.f), 0.f);
+    const float b = fmax(fmin(brightness, 1.f), 0.f);
+    dirty_ |= b != brightness_;
+    brightness_ = b;
 }
 
 void Resonator::SetDamping(float damping)
 {
-    damping_ = fmax(fmin(damping, 1.f), 0.f);
+    const float d = fmax(fmin(damping, 1.f), 0.f);
+    dirty_ |= d != damping_;
+    damping_ = d;
 }
 
 float Resonator::CalcStiff(float sig)
@@ -26,6 +26,8 @@ template <int batch_size>
 class ResonatorSvf
 {
   public:
+    static const size_t kStateBytes;
+
     enum FilterMode
     {
         LOW_PASS,
@@ -98,21 +100,27 @@ class ResonatorSvf
         }
     }
 
-  private:
-    static constexpr float kPiPow3 = PI_F * PI_F * PI_F;
-    static constexpr float kPiPow5 = kPiPow3 * PI_F * PI_F;
-    static inline float    fasttan(float f)
+    /** tan(pi f) for f in cycles per sample, below 0.5 */
+    static inline float fasttan(float f)
     {
-        const float a  = 3.260e-01 * kPiPow3;
-        const float b  = 1.823e-01 * kPiPow5;
+        const float a  = 3.260e-01f * kPiPow3;
+        const float b  = 1.823e-01f * kPiPow5;
         float       f2 = f * f;
         return f * (PI_F + f2 * (a + b * f2));
     }
 
+  private:
+    static constexpr float kPiPow3 = PI_F * PI_F * PI_F;
+    static constexpr float kPiPow5 = kPiPow3 * PI_F * PI_F;
+
     float state_1_[batch_size];
     float state_2_[batch_size];
 };
 
+template <int batch_size>
+constexpr size_t ResonatorSvf<batch_size>::kStateBytes
+    = sizeof(ResonatorSvf<batch_size>);
+
 
 /**         
        @brief Resonant Body Simulation
@@ -121,10 +129,17 @@ class ResonatorSvf
        Ported from pichenettes/eurorack/plaits/dsp/physical_modelling/resonator.h \n
        to an independent module. \n
        Original code written by Emilie Gillet in 2016. \n 
+
+       The modes are held as arrays of coefficients and states, one entry
+       per mode. The setters only mark the coefficients stale; the next
+       Process() recomputes every mode in one pass, so a sample costs the
+       mode filters alone while the parameters hold still.
 */
 class Resonator
 {
   public:
+    static const size_t kStateBytes;
+
     Resonator() {}
     ~Resonator() {}
 
@@ -160,24 +175,70 @@ class Resonator
     */
     void SetDamping(float damping);
 
+    static constexpr int kMaxNumModes   = 24;
+    static constexpr int kModeBatchSize = 4;
+
+    /** The mode filters' coefficients, as Process() uses them, for
+        num_modes modes of a body with these settings, for a bank of
+        voices that keeps its own. Each mode is the SVF of ResonatorSvf,
+        band-pass output:
+            hp = (in - r_plus_g * s1 - s2) * h, bp = g * hp + s1,
+            s1 = g * hp + bp, lp = g * bp + s2, s2 = g * bp + lp,
+            out += gain * bp
+        \param frequency Cycles per sample
+        \param structure, brightness, damping 0-1, as the setters take
+        \param amplitude Each mode's level, from the strike position
+    */
+    static void ComputeModes(float        frequency,
+                             float        structure,
+                             float        brightness,
+                             float        damping,
+                             const float *amplitude,
+                             int          num_modes,
+                             float *      g,
+                             float *      r_plus_g,
+                             float *      h,
+                             float *      gain);
+
+    /** \return the level of every mode struck at position, 0-1 */
+    static float ModeAmplitude(float position);
+
+    /** \return resolution rounded down to whole batches, as Process()
+        runs it */
+    static inline int NumModes(int resolution)
+    {
+        resolution = resolution < kMaxNumModes ? resolution : kMaxNumModes;
+        return resolution - resolution % kModeBatchSize;
+    }
+
   private:
     int   resolution_;
     float frequency_, brightness_, structure_, damping_;
 
-    static constexpr int   kMaxNumModes   = 24;
-    static constexpr int   kModeBatchSize = 4;
     static constexpr float ratiofrac_     = 1.f / 12.f;
     static constexpr float stiff_frac_    = 1.f / 64.f;
     static constexpr float stiff_frac_2   = 1.f / .6f;
 
     float sample_rate_;
+    int   num_modes_; // resolution_ rounded down to whole batches
+    bool  dirty_;
 
-    float CalcStiff(float sig);
+    static float CalcStiff(float sig);
+    void         UpdateModes();
 
-    float                        mode_amplitude_[kMaxNumModes];
-    ResonatorSvf<kModeBatchSize> mode_filters_[kMaxNumModes / kModeBatchSize];
+    float mode_amplitude_[kMaxNumModes];
+
+    // Per-mode SVF coefficients and state, see ResonatorSvf.
+    float mode_g_[kMaxNumModes];
+    float mode_r_plus_g_[kMaxNumModes];
+    float mode_h_[kMaxNumModes];
+    float mode_gain_[kMaxNumModes];
+    float state_1_[kMaxNumModes];
+    float state_2_[kMaxNumModes];
 };
 
+inline constexpr size_t Resonator::kStateBytes = sizeof(Resonator);
+
 } // namespace daisysp
 #endif
 #endif
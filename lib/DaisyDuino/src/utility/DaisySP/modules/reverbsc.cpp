@@ -38,12 +38,86 @@ static const float kReverbParams[8][4]
 
 static int DelayLineMaxSamples(float sr, float i_pitch_mod, int n);
 //static int InitDelayLine(dsy_reverbsc_dl *lp, int n);
-static int         DelayLineBytesAlloc(float sr, float i_pitch_mod, int n);
+static size_t      DelayLineFloatsAlloc(float sr, int n);
 static const float kOutputGain = 0.35;
 static const float kJpScale    = 0.25;
 
-int ReverbSc::Init(float sr)
+/* Samples per ProcessBlock() pass, below the shortest delay at MIN_SRATE */
+static const size_t kChunkSize = 32;
+
+/* Samples per step of the delay modulation in Quality::LINEAR */
+static const int kModRate = 8;
+
+#if DSY_REVERBSC_MAX_SIZE > 0
+int ReverbSc::Init(float sr, Quality quality)
+{
+    return Setup(sr, aux_, DSY_REVERBSC_MAX_SIZE, quality, true);
+}
+
+int ReverbSc::Init(float sr, ZeroedMemory, Quality quality)
+{
+    return Setup(sr, aux_, DSY_REVERBSC_MAX_SIZE, quality, false);
+}
+#endif
+
+int ReverbSc::Init(float sr, float *mem, size_t size, Quality quality)
+{
+    return Setup(sr, mem, size, quality, true);
+}
+
+int ReverbSc::Init(float        sr,
+                   float *      mem,
+                   size_t       size,
+                   ZeroedMemory,
+                   Quality      quality)
+{
+    return Setup(sr, mem, size, quality, false);
+}
+
+ReverbSc &ReverbSc::operator=(const ReverbSc &other)
+{
+    if(this == &other)
+        return *this;
+    quality_       = other.quality_;
+    feedback_      = other.feedback_;
+    lpfreq_        = other.lpfreq_;
+    i_sample_rate_ = other.i_sample_rate_;
+    i_pitch_mod_   = other.i_pitch_mod_;
+    i_skip_init_   = other.i_skip_init_;
+    sample_rate_   = other.sample_rate_;
+    damp_fact_     = other.damp_fact_;
+    prv_lpfreq_    = other.prv_lpfreq_;
+    init_done_     = other.init_done_;
+    for(int i = 0; i < 8; i++)
+        delay_lines_[i] = other.delay_lines_[i];
+#if DSY_REVERBSC_MAX_SIZE > 0
+    if(!init_done_)
+        return *this;
+    // Lines in other's own memory move to the same place in ours.
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(other.aux_);
+    const uintptr_t end   = begin + sizeof(other.aux_);
+    for(int i = 0; i < 8; i++)
+    {
+        ReverbScDl &    lp  = delay_lines_[i];
+        const uintptr_t buf = reinterpret_cast<uintptr_t>(lp.buf);
+        if(buf < begin || buf >= end)
+            continue;
+        lp.buf = aux_ + (lp.buf - other.aux_);
+        memcpy(lp.buf,
+               other.delay_lines_[i].buf,
+               sizeof(float) * lp.buffer_size);
+    }
+#endif
+    return *this;
+}
+
+int ReverbSc::Setup(float   sr,
+                    float * mem,
+                    size_t  size,
+                    Quality quality,
+                    bool    clear)
 {
+    quality_       = quality;
     i_sample_rate_ = sr;
     sample_rate_   = sr;
     feedback_      = 0.97;
@@ -52,18 +126,27 @@ int ReverbSc::Init(float sr)
     i_skip_init_   = 0;
     damp_fact_     = 1.0;
     prv_lpfreq_    = 0.0;
-    init_done_     = 1;
-    int i, n_bytes = 0;
-    n_bytes = 0;
-    for(i = 0; i < 8; i++)
+    init_done_     = 0;
+    size_t offset  = 0;
+    for(int i = 0; i < 8; i++)
     {
-        if(n_bytes > DSY_REVERBSC_MAX_SIZE)
-            return 1;
-        delay_lines_[i].buf = (aux_) + n_bytes;
-        InitDelayLine(&delay_lines_[i], i);
-        n_bytes += DelayLineBytesAlloc(sr, 1, i);
+        const size_t n_floats = DelayLineFloatsAlloc(sr, i);
+        if(offset + n_floats > size)
+            return REVSC_NOT_OK;
+        delay_lines_[i].buf = mem + offset;
+        InitDelayLine(&delay_lines_[i], i, clear);
+        offset += n_floats;
     }
-    return 0;
+    init_done_ = 1;
+    return REVSC_OK;
+}
+
+size_t ReverbSc::GetMemorySize(float sample_rate)
+{
+    size_t n_floats = 0;
+    for(int i = 0; i < 8; i++)
+        n_floats += DelayLineFloatsAlloc(sample_rate, i);
+    return n_floats;
 }
 
 static int DelayLineMaxSamples(float sr, float i_pitch_mod, int n)
@@ -75,12 +158,11 @@ static int DelayLineMaxSamples(float sr, float i_pitch_mod, int n)
     return (int)(max_del * sr + 16.5);
 }
 
-static int DelayLineBytesAlloc(float sr, float i_pitch_mod, int n)
+static size_t DelayLineFloatsAlloc(float sr, int n)
 {
-    int n_bytes = 0;
-
-    n_bytes += (DelayLineMaxSamples(sr, i_pitch_mod, n) * (int)sizeof(float));
-    return n_bytes;
+    /* rounded up to whole 32-byte cache lines, keeping the next aligned */
+    const size_t n_floats = (size_t)DelayLineMaxSamples(sr, 1, n);
+    return (n_floats + 7) & ~(size_t)7;
 }
 
 void ReverbSc::NextRandomLineseg(ReverbScDl *lp, int n)
@@ -110,7 +192,7 @@ void ReverbSc::NextRandomLineseg(ReverbScDl *lp, int n)
     lp->read_pos_frac_inc = (int)(phs_inc_val * DELAYPOS_SCALE + 0.5);
 }
 
-int ReverbSc::InitDelayLine(ReverbScDl *lp, int n)
+int ReverbSc::InitDelayLine(ReverbScDl *lp, int n, bool clear)
 {
     float read_pos;
     /* int     i; */
@@ -130,38 +212,206 @@ int ReverbSc::InitDelayLine(ReverbScDl *lp, int n)
     lp->read_pos_frac = (int)(read_pos + 0.5);
     /* initialise first random line segment */
     NextRandomLineseg(lp, n);
+    if(quality_ == Quality::FIXED)
+    {
+        /* nearest whole sample, never moving */
+        if(lp->read_pos_frac >= DELAYPOS_SCALE / 2)
+            lp->read_pos++;
+        if(lp->read_pos >= lp->buffer_size)
+            lp->read_pos -= lp->buffer_size;
+        lp->read_pos_frac     = 0;
+        lp->read_pos_frac_inc = DELAYPOS_SCALE;
+    }
+    lp->mod_cnt   = kModRate;
+    lp->frac_hold = (float)lp->read_pos_frac * (1.0f / (float)DELAYPOS_SCALE);
     /* clear delay line to zero */
     lp->filter_state = 0.0;
-    memset(lp->buf, 0, sizeof(float) * lp->buffer_size);
+    if(clear)
+        memset(lp->buf, 0, sizeof(float) * lp->buffer_size);
     return REVSC_OK;
 }
 
+float ReverbSc::UpdateDamping()
+{
+    /* calculate tone filter coefficient if frequency changed */
+    if(lpfreq_ != prv_lpfreq_)
+    {
+        float damp_fact;
+        prv_lpfreq_ = lpfreq_;
+        damp_fact
+            = 2.0f - cosf(prv_lpfreq_ * (2.0f * (float)M_PI) / sample_rate_);
+        damp_fact_ = damp_fact - math::sqrt(damp_fact * damp_fact - 1.0f);
+    }
+    return damp_fact_;
+}
+
+void ReverbSc::StepModulation(ReverbScDl *lp, int n)
+{
+    /* kModRate samples of the read position's drift at once */
+    lp->mod_cnt = kModRate;
+    lp->read_pos_frac += (lp->read_pos_frac_inc - DELAYPOS_SCALE) * kModRate;
+    if(lp->read_pos_frac < 0)
+    {
+        lp->read_pos_frac += DELAYPOS_SCALE;
+        lp->read_pos--;
+    }
+    else if(lp->read_pos_frac >= DELAYPOS_SCALE)
+    {
+        lp->read_pos_frac -= DELAYPOS_SCALE;
+        lp->read_pos++;
+    }
+    if(lp->read_pos < 0)
+        lp->read_pos += lp->buffer_size;
+    else if(lp->read_pos >= lp->buffer_size)
+        lp->read_pos -= lp->buffer_size;
+    lp->frac_hold = (float)lp->read_pos_frac * (1.0f / (float)DELAYPOS_SCALE);
+
+    lp->rand_line_cnt -= kModRate;
+    if(lp->rand_line_cnt <= 0)
+    {
+        NextRandomLineseg(lp, n);
+    }
+}
+
+template <ReverbSc::Quality quality>
+inline float ReverbSc::ReadLine(ReverbScDl *lp, int n, float damp_fact)
+{
+    float v0;
+    int   buffer_size = lp->buffer_size; /* Local copy */
+
+    if(quality == Quality::FIXED)
+    {
+        v0           = lp->buf[lp->read_pos];
+        lp->read_pos = lp->read_pos + 1 < buffer_size ? lp->read_pos + 1 : 0;
+    }
+    else if(quality == Quality::LINEAR)
+    {
+        /* read position steps one sample, the fraction every kModRate */
+        const int   rp  = lp->read_pos;
+        const int   rp1 = rp + 1 < buffer_size ? rp + 1 : 0;
+        const float a   = lp->buf[rp];
+        v0              = a + (lp->buf[rp1] - a) * lp->frac_hold;
+        lp->read_pos    = rp1;
+        if(--lp->mod_cnt <= 0)
+            StepModulation(lp, n);
+    }
+    else
+    {
+        v0 = ReadCubic(lp, n);
+    }
+
+    /* apply feedback gain and lowpass filter */
+
+    v0 *= (float)feedback_;
+    v0               = (lp->filter_state - v0) * damp_fact + v0;
+    lp->filter_state = v0;
+    return v0;
+}
+
+inline float ReverbSc::ReadCubic(ReverbScDl *lp, int n)
+{
+    float vm1, v0, v1, v2, am1, a0, a1, a2, frac;
+    int   read_pos;
+    int   buffer_size = lp->buffer_size; /* Local copy */
+
+    /* read from delay line with cubic interpolation */
+
+    if(lp->read_pos_frac >= DELAYPOS_SCALE)
+    {
+        lp->read_pos += (lp->read_pos_frac >> DELAYPOS_SHIFT);
+        lp->read_pos_frac &= DELAYPOS_MASK;
+    }
+    if(lp->read_pos >= buffer_size)
+        lp->read_pos -= buffer_size;
+    read_pos = lp->read_pos;
+    frac     = (float)lp->read_pos_frac * (1.0 / (float)DELAYPOS_SCALE);
+
+    /* calculate interpolation coefficients */
+
+    a2 = frac * frac;
+    a2 -= 1.0;
+    a2 *= (1.0 / 6.0);
+    a1 = frac;
+    a1 += 1.0;
+    a1 *= 0.5;
+    am1 = a1 - 1.0;
+    a0  = 3.0 * a2;
+    a1 -= a0;
+    am1 -= a2;
+    a0 -= frac;
+
+    /* read four samples for interpolation */
+
+    if(read_pos > 0 && read_pos < (buffer_size - 2))
+    {
+        vm1 = (float)(lp->buf[read_pos - 1]);
+        v0  = (float)(lp->buf[read_pos]);
+        v1  = (float)(lp->buf[read_pos + 1]);
+        v2  = (float)(lp->buf[read_pos + 2]);
+    }
+    else
+    {
+        /* at buffer wrap-around, need to check index */
+
+        if(--read_pos < 0)
+            read_pos += buffer_size;
+        vm1 = (float)lp->buf[read_pos];
+        if(++read_pos >= buffer_size)
+            read_pos -= buffer_size;
+        v0 = (float)lp->buf[read_pos];
+        if(++read_pos >= buffer_size)
+            read_pos -= buffer_size;
+        v1 = (float)lp->buf[read_pos];
+        if(++read_pos >= buffer_size)
+            read_pos -= buffer_size;
+        v2 = (float)lp->buf[read_pos];
+    }
+    v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
+
+    /* update buffer read position */
+
+    lp->read_pos_frac += lp->read_pos_frac_inc;
+
+    /* start next random line segment if current one has reached endpoint */
+
+    if(--(lp->rand_line_cnt) <= 0)
+    {
+        NextRandomLineseg(lp, n);
+    }
+    return v0;
+}
+
 int ReverbSc::Process(const float &in1,
                       const float &in2,
                       float *      out1,
                       float *      out2)
 {
-    float       a_in_l, a_in_r, a_out_l, a_out_r;
-    float       vm1, v0, v1, v2, am1, a0, a1, a2, frac;
-    ReverbScDl *lp;
-    int         read_pos;
-    uint32_t    n;
-    int         buffer_size; /* Local copy */
-    float       damp_fact = damp_fact_;
-
     //if (init_done_ <= 0) return REVSC_NOT_OK;
     if(init_done_ <= 0)
         return REVSC_NOT_OK;
 
-    /* calculate tone filter coefficient if frequency changed */
-    if(lpfreq_ != prv_lpfreq_)
+    switch(quality_)
     {
-        prv_lpfreq_ = lpfreq_;
-        damp_fact
-            = 2.0f - cosf(prv_lpfreq_ * (2.0f * (float)M_PI) / sample_rate_);
-        damp_fact = damp_fact_
-            = damp_fact - sqrtf(damp_fact * damp_fact - 1.0f);
+        case Quality::LINEAR:
+            Tick<Quality::LINEAR>(in1, in2, out1, out2);
+            break;
+        case Quality::FIXED:
+            Tick<Quality::FIXED>(in1, in2, out1, out2);
+            break;
+        default: Tick<Quality::CUBIC>(in1, in2, out1, out2); break;
     }
+    return REVSC_OK;
+}
+
+template <ReverbSc::Quality quality>
+void ReverbSc::Tick(float in1, float in2, float *out1, float *out2)
+{
+    float       a_in_l, a_in_r, a_out_l, a_out_r;
+    float       v0;
+    ReverbScDl *lp;
+    uint32_t    n;
+
+    const float damp_fact = UpdateDamping();
 
     /* calculate "resultant junction pressure" and mix to input signals */
 
@@ -178,103 +428,114 @@ int ReverbSc::Process(const float &in1,
 
     for(n = 0; n < 8; n++)
     {
-        lp          = &delay_lines_[n];
-        buffer_size = lp->buffer_size;
+        lp = &delay_lines_[n];
 
         /* send input signal and feedback to delay line */
 
         lp->buf[lp->write_pos]
             = (float)((n & 1 ? a_in_r : a_in_l) - lp->filter_state);
-        if(++lp->write_pos >= buffer_size)
+        if(++lp->write_pos >= lp->buffer_size)
         {
-            lp->write_pos -= buffer_size;
+            lp->write_pos -= lp->buffer_size;
         }
 
-        /* read from delay line with cubic interpolation */
+        v0 = ReadLine<quality>(lp, n, damp_fact);
 
-        if(lp->read_pos_frac >= DELAYPOS_SCALE)
-        {
-            lp->read_pos += (lp->read_pos_frac >> DELAYPOS_SHIFT);
-            lp->read_pos_frac &= DELAYPOS_MASK;
-        }
-        if(lp->read_pos >= buffer_size)
-            lp->read_pos -= buffer_size;
-        read_pos = lp->read_pos;
-        frac     = (float)lp->read_pos_frac * (1.0 / (float)DELAYPOS_SCALE);
-
-        /* calculate interpolation coefficients */
-
-        a2 = frac * frac;
-        a2 -= 1.0;
-        a2 *= (1.0 / 6.0);
-        a1 = frac;
-        a1 += 1.0;
-        a1 *= 0.5;
-        am1 = a1 - 1.0;
-        a0  = 3.0 * a2;
-        a1 -= a0;
-        am1 -= a2;
-        a0 -= frac;
-
-        /* read four samples for interpolation */
-
-        if(read_pos > 0 && read_pos < (buffer_size - 2))
+        /* mix to output */
+
+        if(n & 1)
         {
-            vm1 = (float)(lp->buf[read_pos - 1]);
-            v0  = (float)(lp->buf[read_pos]);
-            v1  = (float)(lp->buf[read_pos + 1]);
-            v2  = (float)(lp->buf[read_pos + 2]);
+            a_out_r += v0;
         }
         else
         {
-            /* at buffer wrap-around, need to check index */
-
-            if(--read_pos < 0)
-                read_pos += buffer_size;
-            vm1 = (float)lp->buf[read_pos];
-            if(++read_pos >= buffer_size)
-                read_pos -= buffer_size;
-            v0 = (float)lp->buf[read_pos];
-            if(++read_pos >= buffer_size)
-                read_pos -= buffer_size;
-            v1 = (float)lp->buf[read_pos];
-            if(++read_pos >= buffer_size)
-                read_pos -= buffer_size;
-            v2 = (float)lp->buf[read_pos];
+            a_out_l += v0;
         }
-        v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
+    }
+    /* someday, use a_out_r for multimono out */
 
-        /* update buffer read position */
+    *out1 = a_out_l * kOutputGain;
+    *out2 = a_out_r * kOutputGain;
+}
 
-        lp->read_pos_frac += lp->read_pos_frac_inc;
+int ReverbSc::ProcessBlock(const float *in1,
+                           const float *in2,
+                           float *      out1,
+                           float *      out2,
+                           size_t       size)
+{
+    if(init_done_ <= 0)
+        return REVSC_NOT_OK;
 
-        /* apply feedback gain and lowpass filter */
+    switch(quality_)
+    {
+        case Quality::LINEAR:
+            RunBlock<Quality::LINEAR>(in1, in2, out1, out2, size);
+            break;
+        case Quality::FIXED:
+            RunBlock<Quality::FIXED>(in1, in2, out1, out2, size);
+            break;
+        default: RunBlock<Quality::CUBIC>(in1, in2, out1, out2, size); break;
+    }
+    return REVSC_OK;
+}
 
-        v0 *= (float)feedback_;
-        v0               = (lp->filter_state - v0) * damp_fact + v0;
-        lp->filter_state = v0;
+template <ReverbSc::Quality quality>
+void ReverbSc::RunBlock(const float *in1,
+                        const float *in2,
+                        float *      out1,
+                        float *      out2,
+                        size_t       size)
+{
+    const float damp_fact = UpdateDamping();
 
-        /* mix to output */
+    /* A line's reads lag its writes by more than kChunkSize, and its
+       filter only sees its own reads, so each line can run the whole
+       chunk alone: read pass first, keeping the filter state every
+       sample saw, then the junction, then the write pass. */
+    float pre[8][kChunkSize];
+    float jp[kChunkSize], out_l[kChunkSize], out_r[kChunkSize];
+    int   write_start[8];
 
-        if(n & 1)
+    for(size_t pos = 0; pos < size; pos += kChunkSize)
+    {
+        const size_t len = size - pos < kChunkSize ? size - pos : kChunkSize;
+        for(size_t i = 0; i < len; i++)
+            jp[i] = out_l[i] = out_r[i] = 0.0f;
+
+        for(int n = 0; n < 8; n++)
         {
-            a_out_r += v0;
+            ReverbScDl *lp  = &delay_lines_[n];
+            float *     out = n & 1 ? out_r : out_l;
+            write_start[n]  = lp->write_pos;
+            for(size_t i = 0; i < len; i++)
+            {
+                pre[n][i] = lp->filter_state;
+                jp[i] += lp->filter_state;
+                /* NextRandomLineseg() reads write_pos */
+                if(++lp->write_pos >= lp->buffer_size)
+                    lp->write_pos -= lp->buffer_size;
+                out[i] += ReadLine<quality>(lp, n, damp_fact);
+            }
         }
-        else
+
+        for(int n = 0; n < 8; n++)
         {
-            a_out_l += v0;
+            ReverbScDl *lp  = &delay_lines_[n];
+            const float *in = (n & 1 ? in2 : in1) + pos;
+            int          wp = write_start[n];
+            for(size_t i = 0; i < len; i++)
+            {
+                lp->buf[wp] = (jp[i] * kJpScale + in[i]) - pre[n][i];
+                if(++wp >= lp->buffer_size)
+                    wp -= lp->buffer_size;
+            }
         }
 
-        /* start next random line segment if current one has reached endpoint */
-
-        if(--(lp->rand_line_cnt) <= 0)
+        for(size_t i = 0; i < len; i++)
         {
-            NextRandomLineseg(lp, n);
+            out1[pos + i] = out_l[i] * kOutputGain;
+            out2[pos + i] = out_r[i] * kOutputGain;
         }
     }
-    /* someday, use a_out_r for multimono out */
-
-    *out1 = a_out_l * kOutputGain;
-    *out2 = a_out_r * kOutputGain;
-    return REVSC_OK;
 }
@@ -2,7 +2,16 @@
 #ifndef DSYSP_REVERBSC_H
 #define DSYSP_REVERBSC_H
 
+#include <stddef.h>
+#include "dsp.h"
+
+/** Floats of delay memory inside each ReverbSc, enough for 192 kHz.
+    Build with -DDSY_REVERBSC_MAX_SIZE=0 (for every file, as it changes
+    the class) to drop it and always pass memory to Init().
+*/
+#ifndef DSY_REVERBSC_MAX_SIZE
 #define DSY_REVERBSC_MAX_SIZE 98936
+#endif
 
 namespace daisysp
 {
@@ -20,6 +29,8 @@ typedef struct
     int    rand_line_cnt;     /**< number of random lines */
     float  filter_state;      /**< state of filter */
     float *buf;               /**< buffer ptr */
+    int    mod_cnt;           /**< LINEAR: samples to the next mod step */
+    float  frac_hold;         /**< LINEAR: fraction held between steps */
 } ReverbScDl;
 
 /** Stereo Reverb
@@ -33,21 +44,97 @@ Year:                    1999, 2005
 Ported to soundpipe by:  Paul Batchelor
 
 Ported by:                Stephen Hensley
+
+The delay memory can be the caller's, sized with GetMemorySize(), so it
+can live in AXI SRAM or DTCM instead of SDRAM: about 99 KB at 48 kHz.
+The eight lines are packed one after the other, each starting on a
+32-byte cache line.
+
+ProcessBlock() runs each line over the whole block in turn, so its reads
+and writes are contiguous runs rather than eight strided streams.
+
+The Quality given to Init() trades the delay modulation for cost: CUBIC
+is the original, LINEAR moves the modulation every 8 samples and reads
+two taps, FIXED drops it for integer taps, a plain room ambience.
 */
 class ReverbSc
 {
   public:
+    static const size_t kStateBytes;
+
     ReverbSc() {}
     ~ReverbSc() {}
+
+    /** Copies, moves included, carry the reverb's state along. On the
+        internal memory the copy gets its own lines, so it can replace
+        the original, e.g. into an arena slot; on the caller's, the
+        two share it and only one may keep running.
+    */
+    ReverbSc(const ReverbSc &other) { *this = other; }
+    ReverbSc &operator=(const ReverbSc &other);
+
+    /** Delay line reads, cheapest last */
+    enum class Quality
+    {
+        CUBIC,  /**< cubic interpolation, modulated every sample */
+        LINEAR, /**< linear interpolation, modulated every 8 samples */
+        FIXED,  /**< integer taps, no modulation */
+    };
+#if DSY_REVERBSC_MAX_SIZE > 0
     /** Initializes the reverb module, and sets the sample_rate at which the Process function will be called.
         Returns 0 if all good, or 1 if it runs out of delay times exceed maximum allowed.
     */
-    int Init(float sample_rate);
+    int Init(float sample_rate, Quality quality = Quality::CUBIC);
+
+    /** As above, for a reverb whose memory already reads as zero, such
+        as a static one in internal RAM: skips clearing the lines.
+    */
+    int Init(float        sample_rate,
+             ZeroedMemory zeroed,
+             Quality      quality = Quality::CUBIC);
+#endif
+
+    /** Initializes the reverb on the caller's delay memory.
+        \param sample_rate - rate Process() / ProcessBlock() run at
+        \param mem - delay memory, 32-byte aligned for best cache use
+        \param size - floats at mem, at least GetMemorySize(sample_rate)
+        \param quality - delay line reads
+        \return 0 if all good, 1 if mem is too small
+    */
+    int Init(float   sample_rate,
+             float * mem,
+             size_t  size,
+             Quality quality = Quality::CUBIC);
+
+    /** As above, on memory that already reads as zero: skips clearing
+        it. SdramArena::AllocateCleared() memory, for instance.
+    */
+    int Init(float        sample_rate,
+             float *      mem,
+             size_t       size,
+             ZeroedMemory zeroed,
+             Quality      quality = Quality::CUBIC);
+
+    /** Floats of delay memory needed at a sample rate. */
+    static size_t GetMemorySize(float sample_rate);
 
     /** Process the input through the reverb, and updates values of out1, and out2 with the new processed signal.
     */
     int Process(const float &in1, const float &in2, float *out1, float *out2);
 
+    /** Processes a block, the same as Process() on each sample. The
+        outputs may be the inputs.
+        \param in1, in2 - inputs
+        \param out1, out2 - outputs
+        \param size - number of samples
+        \return 0 if all good, 1 if not initialized
+    */
+    int ProcessBlock(const float *in1,
+                     const float *in2,
+                     float *      out1,
+                     float *      out2,
+                     size_t       size);
+
     /** controls the reverb time. reverb tail becomes infinite when set to 1.0
         \param fb - sets reverb time. range: 0.0 to 1.0
     */
@@ -59,7 +146,26 @@ class ReverbSc
 
   private:
     void       NextRandomLineseg(ReverbScDl *lp, int n);
-    int        InitDelayLine(ReverbScDl *lp, int n);
+    int        Setup(float   sr,
+                     float * mem,
+                     size_t  size,
+                     Quality quality,
+                     bool    clear);
+    int        InitDelayLine(ReverbScDl *lp, int n, bool clear);
+    void       StepModulation(ReverbScDl *lp, int n);
+    float      ReadCubic(ReverbScDl *lp, int n);
+    template <Quality quality>
+    float      ReadLine(ReverbScDl *lp, int n, float damp_fact);
+    template <Quality quality>
+    void       Tick(float in1, float in2, float *out1, float *out2);
+    template <Quality quality>
+    void       RunBlock(const float *in1,
+                        const float *in2,
+                        float *      out1,
+                        float *      out2,
+                        size_t       size);
+    float      UpdateDamping();
+    Quality    quality_;
     float      feedback_, lpfreq_;
     float      i_sample_rate_, i_pitch_mod_, i_skip_init_;
     float      sample_rate_;
@@ -67,9 +173,13 @@ class ReverbSc
     float      prv_lpfreq_;
     int        init_done_;
     ReverbScDl delay_lines_[8];
-    float      aux_[DSY_REVERBSC_MAX_SIZE];
+#if DSY_REVERBSC_MAX_SIZE > 0
+    float aux_[DSY_REVERBSC_MAX_SIZE];
+#endif
 };
 
+inline constexpr size_t ReverbSc::kStateBytes = sizeof(ReverbSc);
+
 
 } // namespace daisysp
 #endif
@@ -0,0 +1,135 @@
+#include <string.h>
+#include "sample_player.h"
+
+using namespace daisysp;
+
+static inline uint32_t Le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t Le16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+bool SamplePlayer::ParseWav(const void* file, size_t size, Sample& out)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(file);
+    if(size < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0)
+        return false;
+
+    // Chunks in any order; only fmt and data matter.
+    size_t   at          = 12;
+    uint16_t channels    = 0;
+    uint16_t bits        = 0;
+    uint32_t sample_rate = 0;
+    while(at + 8 <= size)
+    {
+        const uint8_t* chunk = p + at;
+        const uint32_t len   = Le32(chunk + 4);
+        if(memcmp(chunk, "fmt ", 4) == 0 && len >= 16 && at + 8 + 16 <= size)
+        {
+            if(Le16(chunk + 8) != 1) // PCM
+                return false;
+            channels    = Le16(chunk + 10);
+            sample_rate = Le32(chunk + 12);
+            bits        = Le16(chunk + 22);
+        }
+        else if(memcmp(chunk, "data", 4) == 0)
+        {
+            if(bits != 16 || (channels != 1 && channels != 2)
+               || ((at + 8) & 1) != 0)
+                return false;
+            const size_t bytes
+                = len < size - (at + 8) ? len : size - (at + 8);
+            out.data        = reinterpret_cast<const int16_t*>(chunk + 8);
+            out.channels    = channels;
+            out.frames      = bytes / (2 * channels);
+            out.sample_rate = static_cast<float>(sample_rate);
+            return out.frames > 0;
+        }
+        at += 8 + len + (len & 1);
+    }
+    return false;
+}
+
+void SamplePlayer::Init(float sample_rate, int16_t* cache)
+{
+    sample_rate_ = sample_rate;
+    cache_       = cache;
+    speed_       = 1.f;
+    step_        = 1.f;
+    frac_        = 0.f;
+    pos_         = 0;
+    cache_start_ = cache_end_ = 0;
+    playing_                  = false;
+    loop_                     = false;
+    sample_.data              = nullptr;
+    sample_.frames            = 0;
+    sample_.channels          = 1;
+    sample_.sample_rate       = sample_rate;
+}
+
+void SamplePlayer::Play(const Sample& sample)
+{
+    if(sample.data == nullptr || sample.frames == 0
+       || (sample.channels != 1 && sample.channels != 2))
+    {
+        playing_ = false;
+        return;
+    }
+    sample_      = sample;
+    pos_         = 0;
+    frac_        = 0.f;
+    cache_start_ = cache_end_ = 0;
+    SetSpeed(speed_);
+    playing_ = true;
+}
+
+void SamplePlayer::SetSpeed(float speed)
+{
+    speed_ = speed > 0.f ? speed : speed_;
+    step_  = speed_ * sample_.sample_rate / sample_rate_;
+}
+
+void SamplePlayer::Prefetch()
+{
+    if(!playing_)
+        return;
+
+    // Keep the block being played and those after it; the one before
+    // is what gets overwritten.
+    const size_t first = pos_ & ~(kBlockFrames - 1);
+    if(first < cache_start_ || first > cache_end_)
+        cache_start_ = cache_end_ = first;
+    else
+        cache_start_ = first;
+
+    const size_t want = first + kCacheFrames < sample_.frames
+                            ? first + kCacheFrames
+                            : sample_.frames;
+    const size_t ch = sample_.channels;
+    while(cache_end_ < want)
+    {
+        const size_t n = want - cache_end_ < kBlockFrames ? want - cache_end_
+                                                          : kBlockFrames;
+        memcpy(&cache_[(cache_end_ & kMask) * ch],
+               &sample_.data[cache_end_ * ch],
+               n * ch * sizeof(int16_t));
+        cache_end_ += n;
+    }
+}
+
+void SamplePlayer::ProcessBlock(float* l, float* r, size_t size)
+{
+    Prefetch();
+    for(size_t i = 0; i < size; i++)
+    {
+        float a, b;
+        Process(a, b);
+        l[i] = a;
+        if(r)
+            r[i] = b;
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+#ifndef DSY_SAMPLE_PLAYER_H
+#define DSY_SAMPLE_PLAYER_H
+#include <stdint.h>
+#include <stddef.h>
+
+namespace daisysp
+{
+/** 16-bit PCM sample playback from slow memory, through a small cache.
+
+Plays mono or interleaved stereo int16 data straight from where it is
+stored, typically memory-mapped QSPI flash (daisy::QspiFlash), at any
+speed and with linear interpolation. Reading flash one sample at a time
+costs a bus transaction per miss; instead, Prefetch() copies the next
+blocks ahead of the play position into a cache the caller provides in
+fast memory (AXI SRAM, DTCM), and Process() reads from there. A read
+the cache does not hold yet, such as just after a loop wraps, falls back
+to the source, so playback is always right and only the cost changes.
+
+ProcessBlock() prefetches once per call. With Process(), call
+Prefetch() once per audio block. The cache is kCacheSamples int16 per
+voice, 4 kB: size a pool as voices * kCacheSamples.
+
+Play() and the setters are for the audio callback's context, or with
+the audio stopped, like the other modules.
+
+usage example:
+
+static int16_t DSY_MEM_AXI caches[kVoices][SamplePlayer::kCacheSamples];
+SamplePlayer::Sample kick;
+SamplePlayer::ParseWav(qspi.GetData(0), 65536, kick);
+voice.Init(sample_rate, caches[0]);
+voice.Play(kick);
+...
+voice.ProcessBlock(out[0], out[1], size);
+*/
+class SamplePlayer
+{
+  public:
+    static const size_t kStateBytes;
+
+    /** Frames per prefetch copy */
+    static constexpr size_t kBlockFrames = 256;
+    /** Frames the cache holds, a power of two */
+    static constexpr size_t kCacheFrames = 4 * kBlockFrames;
+    /** int16 in the cache Init() takes, room for stereo */
+    static constexpr size_t kCacheSamples = 2 * kCacheFrames;
+
+    /** Where a sample's frames are */
+    struct Sample
+    {
+        const int16_t* data;        /**< interleaved if stereo */
+        size_t         frames;      /**< per channel */
+        size_t         channels;    /**< 1 or 2 */
+        float          sample_rate; /**< of the data */
+    };
+
+    SamplePlayer() {}
+    ~SamplePlayer() {}
+
+    /** Finds the PCM in a RIFF WAVE file of 16-bit mono or stereo.
+        \param file Start of the file, e.g. in the QSPI mapping
+        \param size Bytes available at file
+        \param out Filled in on success
+        \return false if it is not such a file
+    */
+    static bool ParseWav(const void* file, size_t size, Sample& out);
+
+    /** \param sample_rate Audio rate Process() runs at
+        \param cache kCacheSamples int16 in fast memory, this voice's own
+    */
+    void Init(float sample_rate, int16_t* cache);
+
+    /** Starts sample from its first frame, at the current speed */
+    void Play(const Sample& sample);
+
+    /** Silences the voice */
+    inline void Stop() { playing_ = false; }
+
+    /** \param loop Wrap to the start at the end instead of stopping */
+    inline void SetLoop(bool loop) { loop_ = loop; }
+
+    /** \param speed Playback rate, 1 for the sample's own pitch, > 0 */
+    void SetSpeed(float speed);
+
+    /** \return true until the end of a sample when not looping */
+    inline bool IsPlaying() const { return playing_; }
+
+    /** Copies blocks at and ahead of the play position into the cache.
+        Call once per audio block when using Process(). */
+    void Prefetch();
+
+    /** Next frame, with l = r for mono. Both 0 when stopped. */
+    inline void Process(float& l, float& r)
+    {
+        if(!playing_)
+        {
+            l = r = 0.f;
+            return;
+        }
+        const size_t next = pos_ + 1 < sample_.frames ? pos_ + 1
+                                                      : (loop_ ? 0 : pos_);
+        const float  a_l  = Get(pos_, 0);
+        const float  b_l  = Get(next, 0);
+        l                 = (a_l + (b_l - a_l) * frac_) * kScale;
+        if(sample_.channels == 2)
+        {
+            const float a_r = Get(pos_, 1);
+            const float b_r = Get(next, 1);
+            r               = (a_r + (b_r - a_r) * frac_) * kScale;
+        }
+        else
+        {
+            r = l;
+        }
+        Advance();
+    }
+
+    /** Prefetch(), then size frames into l and r (r may be nullptr) */
+    void ProcessBlock(float* l, float* r, size_t size);
+
+  private:
+    static constexpr float  kScale = 1.f / 32768.f;
+    static constexpr size_t kMask  = kCacheFrames - 1;
+
+    inline float Get(size_t frame, size_t ch) const
+    {
+        const int16_t* src
+            = frame - cache_start_ < cache_end_ - cache_start_
+                  ? &cache_[(frame & kMask) * sample_.channels]
+                  : &sample_.data[frame * sample_.channels];
+        return static_cast<float>(src[ch]);
+    }
+
+    inline void Advance()
+    {
+        frac_ += step_;
+        const size_t whole = static_cast<size_t>(frac_);
+        frac_ -= static_cast<float>(whole);
+        pos_ += whole;
+        if(pos_ >= sample_.frames)
+        {
+            if(loop_)
+            {
+                pos_ %= sample_.frames;
+                // The cache runs forward only: start it again at the top.
+                cache_start_ = cache_end_ = 0;
+            }
+            else
+            {
+                pos_     = sample_.frames - 1;
+                playing_ = false;
+            }
+        }
+    }
+
+    float    sample_rate_;
+    float    speed_;
+    float    step_;
+    float    frac_;
+    int16_t* cache_;
+    Sample   sample_;
+    size_t   pos_;
+    size_t   cache_start_, cache_end_; // frames [start, end) are cached
+    bool     playing_;
+    bool     loop_;
+};
+
+inline constexpr size_t SamplePlayer::kStateBytes = sizeof(SamplePlayer);
+} // namespace daisysp
+#endif
@@ -3,6 +3,7 @@
 #define DSY_SAMPLEHOLD_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -15,6 +16,8 @@ namespace daisysp
 class SampleHold
 {
   public:
+    static const size_t kStateBytes;
+
     SampleHold() {}
     ~SampleHold() {}
 
@@ -56,6 +59,8 @@ class SampleHold
         previous_ = trigger;
     }
 };
+
+inline constexpr size_t SampleHold::kStateBytes = sizeof(SampleHold);
 } // namespace daisysp
 #endif
 #endif
@@ -3,6 +3,7 @@
 #define DSY_SR_REDUCER_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file sampleratereducer.h */
@@ -20,6 +21,8 @@ namespace daisysp
 class SampleRateReducer
 {
   public:
+    static const size_t kStateBytes;
+
     SampleRateReducer() {}
     ~SampleRateReducer() {}
 
@@ -43,6 +46,9 @@ class SampleRateReducer
     float previous_sample_;
     float next_sample_;
 };
+
+inline constexpr size_t SampleRateReducer::kStateBytes
+    = sizeof(SampleRateReducer);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
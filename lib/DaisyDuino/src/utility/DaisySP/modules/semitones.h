@@ -0,0 +1,102 @@
+#pragma once
+#ifndef DSY_SEMITONES_H
+#define DSY_SEMITONES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <array>
+#include "dsp.h"
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** Shared semitone-to-ratio kernel: 2 ^ (semitones / 12), for the drum
+    and string models that recompute pitches, cutoffs and decay rates
+    from their parameters every sample.
+
+    The integer part of semitones + 128 indexes a 257-entry table of
+    whole-semitone ratios, as in Mutable Instruments' lut_pitch_ratio_high;
+    the fraction, 0 to 1 semitone, goes through a cubic for
+    exp(f * ln 2 / 12), in place of lut_pitch_ratio_low. Relative error
+    is under 1e-6, float rounding, over -128 to +128 semitones; input
+    outside that is clamped. One truncation, one table read and a few
+    multiplies, against a libm powf.
+
+    The table is built at compile time and is const, so it lives in
+    flash alongside the code.
+
+    HiHat, SyntheticBassDrum, AnalogBassDrum, AnalogSnareDrum,
+    SyntheticSnareDrum, StringOsc, StringVoice and ModalVoice all go
+    through SemitonesToRatio(). Define DSY_SEMITONES_LIBM (before
+    including daisysp.h, or as a build flag) to send it back to powf, to
+    compare them module by module.
+*/
+class Semitones
+{
+  public:
+    static const size_t kStateBytes;
+
+    static constexpr float kMin = -128.0f;
+    static constexpr float kMax = 128.0f;
+
+    /** 2 ^ (semitones / 12) */
+    static inline float ToRatio(float semitones)
+    {
+#ifdef DSY_SEMITONES_LIBM
+        return powf(2.f, semitones * kOneTwelfth);
+#else
+        const float   s = fclamp(semitones, kMin, kMax) - kMin;
+        const int32_t i = static_cast<int32_t>(s);
+        const float   f = (s - static_cast<float>(i)) * kLn2Over12;
+        // exp(f), f < ln 2 / 12; the next term is under f^4 / 24 = 5e-7.
+        const float frac
+            = 1.0f + f * (1.0f + f * (0.5f + f * (1.0f / 6.0f)));
+        return kTable[static_cast<size_t>(i)] * frac;
+#endif
+    }
+
+    /** 2 ^ (semitones / 12) for whole semitones, straight from the
+        table, so exact to float rounding
+        \param semitones -128 to 128
+    */
+    static inline float WholeRatio(int32_t semitones)
+    {
+        return kTable[static_cast<size_t>(semitones + 128)];
+    }
+
+  private:
+    static constexpr float kLn2Over12 = 0.05776226504666211f;
+
+    static constexpr std::array<float, 257> MakeTable()
+    {
+        // 2^(1/12) to double precision; each entry from the last, so the
+        // error after 128 steps is still far under float's.
+        constexpr double kStep = 1.0594630943592952646;
+        std::array<float, 257> t{};
+        double                 up = 1.0, down = 1.0;
+        for(size_t k = 0; k <= 128; k++)
+        {
+            t[128 + k] = static_cast<float>(up);
+            t[128 - k] = static_cast<float>(down);
+            up *= kStep;
+            down /= kStep;
+        }
+        return t;
+    }
+
+    static const std::array<float, 257> kTable;
+};
+
+inline constexpr std::array<float, 257> Semitones::kTable
+    = Semitones::MakeTable();
+inline constexpr size_t Semitones::kStateBytes = sizeof(Semitones);
+
+/** 2 ^ (semitones / 12), through Semitones::ToRatio(). */
+inline float SemitonesToRatio(float semitones)
+{
+    return Semitones::ToRatio(semitones);
+}
+} // namespace daisysp
+#endif
+#endif
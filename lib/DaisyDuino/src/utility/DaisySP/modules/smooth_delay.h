@@ -0,0 +1,270 @@
+#pragma once
+#ifndef DSY_SMOOTH_DELAY_H
+#define DSY_SMOOTH_DELAY_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @file smooth_delay.h */
+
+namespace daisysp
+{
+/** @brief Feedback delay whose time glides per block, with tempo sync.
+
+    SetDelay() only sets a target. ProcessBlock() ramps the delay from
+    where it is to that target linearly across the block, so a knob read
+    once per block sweeps without zipper noise, pitching the repeats like
+    tape as it moves.
+
+    The delay is kept in 32.32 fixed point and the ramp is one
+    precomputed step per sample, folded into a single read position that
+    also follows the write head. The inner loop is an add, a shift, two
+    reads and a linear interpolation; no float to int split per sample
+    as DelayLine::SetDelay(float) does.
+
+    With SetCrossfade(), jumps of more than a threshold, e.g. a new
+    tapped tempo, do not glide: the output fades from the old time to the
+    new one instead, with no pitch bend. A target set while fading is
+    taken up once the fade ends.
+
+    Like DelayLine, storage is rounded up to a power of two and the
+    longest delay is max_size - 1 samples; the shortest is 1.
+
+    declaration example: (2 seconds at 48kHz)
+
+    SmoothDelay<96000> DSY_SDRAM_BSS del;
+    del.Init(sample_rate);
+    del.SetTempo(120.f, .75f); // dotted eighth
+    ...
+    del.ProcessBlock(in[0], wet, size);
+*/
+template <size_t max_size>
+class SmoothDelay
+{
+  public:
+    static const size_t kStateBytes;
+
+    SmoothDelay() {}
+    ~SmoothDelay() {}
+
+    /** Clears the line, at a 1 sample delay, no feedback, no crossfade.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        for(size_t i = 0; i < kSize; i++)
+        {
+            line_[i] = 0.f;
+        }
+        sample_rate_ = sample_rate;
+        write_ptr_   = 0;
+        current_     = kOne;
+        target_      = kOne;
+        feedback_    = 0.f;
+        fade_len_    = 0;
+        fade_left_   = 0;
+        fade_thresh_ = 0;
+        fade_gain_   = 0.f;
+        fade_step_   = 0.f;
+    }
+
+    /** Get the next wet sample; the delay reaches its target at once.
+        \param in Sample to write, with feedback
+    */
+    inline float Process(float in)
+    {
+        float out;
+        ProcessBlock(&in, &out, 1);
+        return out;
+    }
+
+    /** Wet output of a block, the delay ramped to its target across it.
+        \param in Input samples
+        \param out Wet samples out, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        if(size == 0)
+            return;
+        if(fade_left_ == 0 && fade_len_ > 0)
+        {
+            const int64_t jump = static_cast<int64_t>(target_ - current_);
+            if(jump > fade_thresh_ || -jump > fade_thresh_)
+            {
+                from_      = current_;
+                current_   = target_;
+                fade_left_ = fade_len_;
+                fade_gain_ = 0.f;
+            }
+        }
+        if(fade_left_ > 0)
+        {
+            const size_t n = size < fade_left_ ? size : fade_left_;
+            Fade(in, out, n);
+            // The rest of the block holds at the new time.
+            Ramp(in + n, out + n, size - n, 0);
+            return;
+        }
+        const int64_t step = static_cast<int64_t>(target_ - current_)
+                             / static_cast<int64_t>(size);
+        Ramp(in, out, size, step);
+    }
+
+    /** Sets the delay the next block ramps to.
+        \param samples 1 to max_size - 1, fractional
+    */
+    inline void SetDelay(float samples)
+    {
+        const float max = static_cast<float>(max_size - 1);
+        samples = samples < 1.f ? 1.f : (samples > max ? max : samples);
+        const uint32_t whole = static_cast<uint32_t>(samples);
+        const float    frac  = samples - static_cast<float>(whole);
+        // 24 fraction bits keep the product exact, never reaching 1.
+        target_ = (static_cast<uint64_t>(whole) << 32)
+                  | (static_cast<uint64_t>(
+                         static_cast<uint32_t>(frac * 16777216.f))
+                     << 8);
+    }
+
+    /** Sets the delay the next block ramps to.
+        \param ms Delay in milliseconds
+    */
+    inline void SetDelayMs(float ms) { SetDelay(ms * .001f * sample_rate_); }
+
+    /** Sets the delay to a note length at a tempo.
+        \param bpm Beats per minute, ignored unless positive
+        \param beats Note length in beats, e.g. .5 for an eighth at 4/4
+    */
+    inline void SetTempo(float bpm, float beats = 1.f)
+    {
+        if(bpm > 0.f)
+            SetDelay(beats * 60.f * sample_rate_ / bpm);
+    }
+
+    /** Set the feedback amount, unclamped.
+        \param feedback Part of the wet signal written back
+    */
+    inline void SetFeedback(float feedback) { feedback_ = feedback; }
+
+    /** Crossfades instead of gliding for larger jumps.
+        \param threshold Smallest jump in samples to crossfade
+        \param fade_samples Fade length, 0 always glides
+    */
+    inline void SetCrossfade(float threshold, size_t fade_samples)
+    {
+        threshold    = threshold > 0.f ? threshold : 0.f;
+        fade_thresh_ = static_cast<int64_t>(threshold * 4294967296.f);
+        fade_len_    = fade_samples;
+        fade_step_   = fade_samples > 0
+                           ? 1.f / static_cast<float>(fade_samples)
+                           : 0.f;
+    }
+
+    /** \return the delay after the last block, in samples */
+    inline float GetDelay() const
+    {
+        return static_cast<float>(current_ >> 32)
+               + static_cast<float>(static_cast<uint32_t>(current_))
+                     * kFracScale;
+    }
+
+    /** \return whether a crossfade is under way */
+    inline bool IsFading() const { return fade_left_ > 0; }
+
+  private:
+    static constexpr size_t RoundUp(size_t n)
+    {
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t   kSize      = RoundUp(max_size);
+    static constexpr size_t   kMask      = kSize - 1;
+    static constexpr uint64_t kOne       = 1ull << 32;
+    static constexpr float    kFracScale = 1.f / 4294967296.f;
+
+    /** Read position of the line for a 32.32 delay */
+    inline uint64_t Position(uint64_t delay) const
+    {
+        return (static_cast<uint64_t>(write_ptr_) << 32) + delay;
+    }
+
+    inline float Tap(uint64_t pos) const
+    {
+        const size_t idx  = static_cast<size_t>(pos >> 32) & kMask;
+        const float  frac = static_cast<float>(static_cast<uint32_t>(pos))
+                           * kFracScale;
+        const float a = line_[idx];
+        return a + (line_[(idx + 1) & kMask] - a) * frac;
+    }
+
+    /** size samples with the delay moving by step per sample */
+    void Ramp(const float* in, float* out, size_t size, int64_t step)
+    {
+        // The write head moves down one per sample, so the read position
+        // moves by step - 1.
+        const uint64_t adv = static_cast<uint64_t>(step) - kOne;
+        const float    fb  = feedback_;
+        uint64_t       pos = Position(current_) + static_cast<uint64_t>(step);
+        size_t         w   = write_ptr_;
+        for(size_t i = 0; i < size; i++)
+        {
+            const float x   = in[i];
+            const float wet = Tap(pos);
+            line_[w]        = x + wet * fb;
+            out[i]          = wet;
+            w               = (w - 1) & kMask;
+            pos += adv;
+        }
+        write_ptr_ = w;
+        current_ += static_cast<uint64_t>(step * static_cast<int64_t>(size));
+    }
+
+    /** size samples of the fade from from_ to current_, both held */
+    void Fade(const float* in, float* out, size_t size)
+    {
+        const float fb  = feedback_;
+        const float dg  = fade_step_;
+        float       g   = fade_gain_;
+        uint64_t    old = Position(from_);
+        uint64_t    pos = Position(current_);
+        size_t      w   = write_ptr_;
+        for(size_t i = 0; i < size; i++)
+        {
+            g += dg;
+            const float x   = in[i];
+            const float a   = Tap(old);
+            const float wet = a + (Tap(pos) - a) * g;
+            line_[w]        = x + wet * fb;
+            out[i]          = wet;
+            w               = (w - 1) & kMask;
+            old -= kOne;
+            pos -= kOne;
+        }
+        write_ptr_ = w;
+        fade_gain_ = g;
+        fade_left_ -= size;
+    }
+
+    float    sample_rate_;
+    float    feedback_;
+    size_t   write_ptr_;
+    uint64_t current_, target_, from_; /**< delays, 32.32 samples */
+
+    size_t  fade_len_, fade_left_;
+    int64_t fade_thresh_;
+    float   fade_gain_, fade_step_;
+
+    float line_[kSize];
+};
+
+template <size_t max_size>
+constexpr size_t SmoothDelay<max_size>::kStateBytes
+    = sizeof(SmoothDelay<max_size>);
+} // namespace daisysp
+#endif
+#endif
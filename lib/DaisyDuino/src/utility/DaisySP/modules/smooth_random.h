@@ -4,7 +4,7 @@
 
 #include "dsp.h"
 #include <stdint.h>
-#include <stdlib.h>
+#include "fast_random.h"
 #ifdef __cplusplus
 
 /** @file smooth_random.h */
@@ -22,6 +22,8 @@ namespace daisysp
 class SmoothRandomGenerator
 {
   public:
+    static const size_t kStateBytes;
+
     SmoothRandomGenerator() {}
     ~SmoothRandomGenerator() {}
 
@@ -31,6 +33,7 @@ class SmoothRandomGenerator
     void Init(float sample_rate)
     {
         sample_rate_ = sample_rate;
+        rng_.Init();
 
         SetFreq(1.f);
         phase_    = 0.0f;
@@ -46,7 +49,7 @@ class SmoothRandomGenerator
         {
             phase_ -= 1.0f;
             from_ += interval_;
-            interval_ = rand() * kRandFrac * 2.0f - 1.0f - from_;
+            interval_ = rng_.NextBipolar() - from_;
         }
         float t = phase_ * phase_ * (3.0f - 2.0f * phase_);
         return from_ + interval_ * t;
@@ -69,9 +72,12 @@ class SmoothRandomGenerator
 
     float sample_rate_;
 
-    static constexpr float kRandFrac = 1.f / (float)RAND_MAX;
+    FastRandom rng_;
 };
 
+inline constexpr size_t SmoothRandomGenerator::kStateBytes
+    = sizeof(SmoothRandomGenerator);
+
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+#ifndef DSY_SMOOTHER_BANK_H
+#define DSY_SMOOTHER_BANK_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include "env_coeff.h"
+
+/** @file smoother_bank.h */
+
+namespace daisysp
+{
+/** @brief One-pole smoothing of N parameters at once, at block rate.
+
+    Replaces a fonepole() or Port per knob per sample. Set() stores the
+    raw target whenever it is read; Update(), once per audio block, moves
+    all N one-poles a block's worth in one pass over plain arrays, and
+    leaves each parameter as a linear ramp across the block: the value
+    at sample n is Start(i) + Step(i) * (n + 1), ending on Value(i).
+
+    Modules either take the ramp directly (Ramp(), Fill()) or, when a
+    per-block value is enough, Value(). Nothing runs per sample here.
+
+    The time constant is in seconds, like Port's, and is converted with
+    EnvCoeff's table: changing it costs no libm.
+
+    declaration example:
+
+    enum { kCutoff, kRes, kMix, kNumParams };
+    SmootherBank<kNumParams> knobs;
+    knobs.Init(sample_rate, block_size, .02f);
+    ...
+    knobs.Set(kCutoff, analogRead(A0) / 1023.f);
+    knobs.Update(size);
+    filt.SetFreq(knobs.Value(kCutoff) * 8000.f);
+    knobs.Fill(kMix, mix_buf, size);
+
+    \param N Number of parameters
+*/
+template <size_t N>
+class SmootherBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    SmootherBank() {}
+    ~SmootherBank() {}
+
+    /** Ramp of one parameter across the last Update()'d block */
+    struct Ramp
+    {
+        float start; /**< value before the block */
+        float step;  /**< change per sample */
+
+        /** \return value at sample n of the block */
+        inline float At(size_t n) const
+        {
+            return start + step * static_cast<float>(n + 1);
+        }
+    };
+
+    /** Every parameter at 0, not moving.
+        \param sample_rate Audio engine sample rate
+        \param block_size Samples per Update()
+        \param time Time constant for all parameters, in seconds
+    */
+    void Init(float sample_rate, size_t block_size, float time = .05f)
+    {
+        EnvCoeff::InitTable();
+        control_rate_ = sample_rate / static_cast<float>(block_size);
+        for(size_t i = 0; i < N; i++)
+        {
+            target_[i] = value_[i] = start_[i] = step_[i] = 0.f;
+        }
+        SetTime(time);
+    }
+
+    /** Time constant of every parameter, in seconds; 0 follows at once */
+    inline void SetTime(float time)
+    {
+        const float c = Coeff(time);
+        for(size_t i = 0; i < N; i++)
+        {
+            coeff_[i] = c;
+        }
+    }
+
+    /** Time constant of one parameter, in seconds; 0 follows at once */
+    inline void SetTime(size_t i, float time) { coeff_[i] = Coeff(time); }
+
+    /** Sets where a parameter heads, e.g. a raw knob reading */
+    inline void Set(size_t i, float target) { target_[i] = target; }
+
+    /** Jumps a parameter to value, with no ramp */
+    inline void Reset(size_t i, float value)
+    {
+        target_[i] = value_[i] = start_[i] = value;
+        step_[i]                           = 0.f;
+    }
+
+    /** Advances every parameter by one block and sets up its ramp.
+        \param size Samples in the block the ramps cover
+    */
+    void Update(size_t size)
+    {
+        const float inv = 1.f / static_cast<float>(size > 0 ? size : 1);
+        for(size_t i = 0; i < N; i++)
+        {
+            const float from = value_[i];
+            const float to   = from + coeff_[i] * (target_[i] - from);
+            start_[i]        = from;
+            value_[i]        = to;
+            step_[i]         = (to - from) * inv;
+        }
+    }
+
+    /** \return value at the end of the block */
+    inline float Value(size_t i) const { return value_[i]; }
+    /** \return value before the block */
+    inline float Start(size_t i) const { return start_[i]; }
+    /** \return change per sample across the block */
+    inline float Step(size_t i) const { return step_[i]; }
+    /** \return the ramp of parameter i */
+    inline Ramp GetRamp(size_t i) const { return Ramp{start_[i], step_[i]}; }
+    /** \return whether parameter i moves in this block */
+    inline bool IsMoving(size_t i) const { return step_[i] != 0.f; }
+
+    /** Writes the ramp of parameter i across a block
+        \param i Parameter
+        \param out Receives size values
+        \param size Samples, as passed to Update()
+    */
+    inline void Fill(size_t i, float* out, size_t size) const
+    {
+        float       v    = start_[i];
+        const float step = step_[i];
+        for(size_t n = 0; n < size; n++)
+        {
+            v += step;
+            out[n] = v;
+        }
+    }
+
+  private:
+    inline float Coeff(float time) const
+    {
+        return time > 0.f ? EnvCoeff::FromTime(time, control_rate_) : 1.f;
+    }
+
+    float control_rate_;
+    float target_[N];
+    float value_[N];
+    float start_[N];
+    float step_[N];
+    float coeff_[N];
+};
+
+template <size_t N>
+constexpr size_t SmootherBank<N>::kStateBytes = sizeof(SmootherBank<N>);
+} // namespace daisysp
+#endif
+#endif
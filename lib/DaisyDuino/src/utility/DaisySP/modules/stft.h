@@ -0,0 +1,257 @@
+#pragma once
+#ifndef DSY_STFT_H
+#define DSY_STFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include "dsp.h"
+#include "real_fft.h"
+
+/** @file stft.h */
+
+namespace daisysp
+{
+/** @brief Short-time Fourier transform with overlap-add resynthesis.
+
+    Every hop input samples, the last fft_size of them are windowed,
+    transformed with RealFft (arm_rfft_fast_f32 with USE_ARM_DSP), handed
+    to the frame callback to change in place, transformed back, windowed
+    again and overlap-added into the output. The analysis and synthesis
+    windows are both sqrt periodic Hann, scaled so an untouched spectrum
+    gives the input back, delayed by GetLatency().
+
+    The work is split between two contexts:
+    - ProcessBlock(), from the audio callback, only copies samples into
+      the input ring and out of the output ring.
+    - ProcessFrames(), from the main loop or a lower priority interrupt,
+      transforms the frames the audio side has completed since.
+    Each side writes only its own counters, 32-bit stores the other reads,
+    so neither takes a lock. ProcessFrames() must keep up on average:
+    if the output of a frame is not ready in time the audio side plays
+    silence for it and counts an underrun; frames whose input has already
+    been overwritten are skipped and counted as dropped.
+
+    The spectrum is in the packed layout of arm_rfft_fast_f32,
+    {X[0].re, X[n/2].re, X[1].re, X[1].im, ...}.
+
+    declaration example:
+
+    static void Denoise(float *spectrum, size_t size, void *context);
+    static Stft<1024, 256> stft;
+    stft.Init(48, Denoise, nullptr);
+    // audio callback:  stft.ProcessBlock(in[0], out[0], size);
+    // loop():          stft.ProcessFrames();
+
+    \param fft_size Frame length, a power of two from 32 to 4096
+    \param hop Samples between frames, dividing fft_size, at most half of it
+*/
+template <size_t fft_size, size_t hop>
+class Stft
+{
+  public:
+    static const size_t kStateBytes;
+
+    Stft() {}
+    ~Stft() {}
+
+    static_assert(fft_size >= 32 && fft_size <= 4096
+                      && (fft_size & (fft_size - 1)) == 0,
+                  "fft_size must be a power of two from 32 to 4096");
+    static_assert(hop > 0 && fft_size % hop == 0 && hop <= fft_size / 2,
+                  "hop must divide fft_size, at most half of it");
+
+    /** Called once per frame with its spectrum, to modify in place
+        \param spectrum fft_size floats, packed
+        \param size fft_size
+        \param context as passed to Init()
+    */
+    typedef void (*FrameCallback)(float *spectrum, size_t size, void *context);
+
+    /** Initializes the transform and clears all buffers.
+        \param block_size Largest ProcessBlock() size, up to fft_size / 2
+        \param callback Frame callback, nullptr passes the spectrum through
+        \param context Handed to the callback
+    */
+    void Init(size_t block_size, FrameCallback callback, void *context)
+    {
+        block_size_ = block_size < fft_size / 2 ? block_size : fft_size / 2;
+        latency_    = fft_size + block_size_;
+        callback_   = callback;
+        context_    = context;
+        fft_.Init();
+
+        // sqrt periodic Hann both ways; its square overlaps to
+        // fft_size / (2 * hop), folded into the synthesis window.
+        float sum = 0.f;
+        for(size_t i = 0; i < fft_size; i++)
+        {
+            const float w = sinf(PI_F * static_cast<float>(i) / fft_size);
+            analysis_[i]  = w;
+            sum += w * w;
+        }
+        const float scale = static_cast<float>(hop) / sum;
+        for(size_t i = 0; i < fft_size; i++)
+        {
+            synthesis_[i] = analysis_[i] * scale;
+        }
+
+        memset(in_ring_, 0, sizeof(in_ring_));
+        memset(out_ring_, 0, sizeof(out_ring_));
+        memset(acc_, 0, sizeof(acc_));
+        // The ring starts with fft_size - hop zeros, so the first frame
+        // is due after hop samples.
+        in_count_  = fft_size - hop;
+        out_count_ = fft_size - hop;
+        frames_    = 0;
+        ready_     = 0;
+        underruns_ = 0;
+        dropped_   = 0;
+    }
+
+    /** Audio side: buffers a block in and plays one out, no transforms.
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples, up to the block_size of Init()
+    */
+    void ProcessBlock(const float *in, float *out, size_t size)
+    {
+        const uint32_t w = in_count_;
+        for(size_t i = 0; i < size; i++)
+        {
+            in_ring_[(w + i) & kRingMask] = in[i];
+        }
+
+        const uint32_t ready = ready_;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        // Output sample t is resynthesised sample t - latency_. Counters
+        // are compared by difference, so they may wrap; the first
+        // latency_ outputs read the cleared ring, as ready.
+        uint32_t r = out_count_ - static_cast<uint32_t>(latency_);
+        for(size_t i = 0; i < size; i++, r++)
+        {
+            if(static_cast<int32_t>(ready - r) > 0)
+            {
+                out[i] = out_ring_[r & kRingMask];
+            }
+            else
+            {
+                out[i] = 0.f;
+                underruns_++;
+            }
+        }
+        out_count_ = out_count_ + static_cast<uint32_t>(size);
+        std::atomic_signal_fence(std::memory_order_release);
+        in_count_ = w + static_cast<uint32_t>(size);
+    }
+
+    /** Frame side: transforms every frame completed by the audio side.
+        \return number of frames processed
+    */
+    size_t ProcessFrames()
+    {
+        size_t done = 0;
+        for(;;)
+        {
+            const uint32_t avail = in_count_;
+            std::atomic_signal_fence(std::memory_order_acquire);
+            const uint32_t start = frames_ * hop;
+            if(static_cast<int32_t>(avail - (start + fft_size)) < 0)
+                break;
+            if(avail - start > kRingSize - block_size_)
+            {
+                // Fell so far behind the input is being overwritten:
+                // restart from the newest complete frame.
+                Skip((avail - fft_size) / hop);
+                continue;
+            }
+            ProcessFrame(start);
+            frames_++;
+            done++;
+        }
+        return done;
+    }
+
+    /** \return samples from input to output */
+    inline size_t GetLatency() const { return latency_; }
+
+    /** \return output samples played as silence because their frame
+        was late */
+    inline uint32_t GetUnderruns() const { return underruns_; }
+
+    /** \return frames skipped because their input was overwritten */
+    inline uint32_t GetDropped() const { return dropped_; }
+
+  private:
+    static constexpr size_t   kRingSize = 2 * fft_size;
+    static constexpr uint32_t kRingMask = kRingSize - 1;
+
+    void ProcessFrame(uint32_t start)
+    {
+        for(size_t i = 0; i < fft_size; i++)
+        {
+            frame_[i] = in_ring_[(start + i) & kRingMask] * analysis_[i];
+        }
+        fft_.Forward(frame_, spectrum_);
+        if(callback_ != nullptr)
+            callback_(spectrum_, fft_size, context_);
+        fft_.Inverse(spectrum_, frame_);
+
+        for(size_t i = 0; i < fft_size; i++)
+        {
+            acc_[i] += frame_[i] * synthesis_[i];
+        }
+
+        // The first hop of the accumulator is final: publish it, then
+        // shift the rest down.
+        const uint32_t r = ready_;
+        for(size_t i = 0; i < hop; i++)
+        {
+            out_ring_[(r + i) & kRingMask] = acc_[i];
+        }
+        memmove(acc_, acc_ + hop, (fft_size - hop) * sizeof(float));
+        memset(acc_ + fft_size - hop, 0, hop * sizeof(float));
+        std::atomic_signal_fence(std::memory_order_release);
+        ready_ = r + static_cast<uint32_t>(hop);
+    }
+
+    /** Drops the frames before next, publishing silence for them */
+    void Skip(uint32_t next)
+    {
+        dropped_ += next - frames_;
+        const uint32_t r    = ready_;
+        const uint32_t end  = next * hop;
+        const uint32_t gap  = end - r;
+        const uint32_t fill = gap < kRingSize ? gap : kRingSize;
+        for(uint32_t i = 0; i < fill; i++)
+        {
+            out_ring_[(end - fill + i) & kRingMask] = 0.f;
+        }
+        memset(acc_, 0, sizeof(acc_));
+        frames_ = next;
+        std::atomic_signal_fence(std::memory_order_release);
+        ready_ = end;
+    }
+
+    RealFft<fft_size> fft_;
+    FrameCallback     callback_;
+    void *            context_;
+    size_t            block_size_, latency_;
+
+    float analysis_[fft_size], synthesis_[fft_size];
+    float frame_[fft_size], spectrum_[fft_size], acc_[fft_size];
+    float in_ring_[kRingSize], out_ring_[kRingSize];
+
+    // Audio side writes in_count_, out_count_ and underruns_; frame side
+    // writes frames_, ready_ and dropped_.
+    volatile uint32_t in_count_, out_count_, underruns_;
+    volatile uint32_t ready_;
+    uint32_t          frames_, dropped_;
+};
+
+template <size_t fft_size, size_t hop>
+constexpr size_t Stft<fft_size, hop>::kStateBytes = sizeof(Stft<fft_size, hop>);
+} // namespace daisysp
+#endif
@@ -0,0 +1,459 @@
+#pragma once
+#ifndef DSY_STRING_VOICE_BANK_H
+#define DSY_STRING_VOICE_BANK_H
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "dsp.h"
+#include "dust.h"
+#include "fast_random.h"
+#include "KarplusString.h"
+#include "pending_trigger.h"
+#include "semitones.h"
+#include "svf.h"
+
+/** @file string_voice_bank.h */
+
+namespace daisysp
+{
+/** @brief num_voices StringVoices sharing their exciters and settings.
+
+    Each voice is a StringVoice string with its own pitch; accent,
+    structure, brightness, damping and sustain are the bank's. Against N
+    StringVoices the bank generates its excitation once:
+
+    - one noise source for the strike bursts and one Dust for sustain,
+      each filled a chunk at a time and read by every voice that needs
+      it, through its own low-pass;
+    - the low-pass tuned, and the strings' damping and brightness set,
+      when the pitch or a setting changes, not every sample.
+
+    Each voice then runs its filter and string over the chunk with
+    Svf::ProcessBlock() and StringOsc::ProcessBlock(). Voices sleep as in
+    DrumKit, hold_time under the threshold after their strike; in sustain
+    every voice is excited and none sleeps.
+
+    The sound is StringVoice's, but that voices struck in the same chunk
+    start from the same burst of noise, and all share the dust grains.
+
+    The strings' lines are inside each StringOsc, or, with
+    Init(sample_rate, mem, size), in the caller's memory:
+
+    static float DSY_MEM_DTCM mem[StringVoiceBank<4>::GetMemorySize(512)];
+    bank.Init(sample_rate, mem, StringVoiceBank<4>::GetMemorySize(512));
+    ...
+    bank.Strike(mtof(note));
+    bank.ProcessBlock(out, size);
+*/
+template <size_t num_voices>
+class StringVoiceBank
+{
+  public:
+    static const size_t kStateBytes;
+
+    StringVoiceBank() {}
+    ~StringVoiceBank() {}
+
+    static constexpr size_t kNumVoices = num_voices;
+
+#if DSY_STRINGOSC_MAX_DELAY > 0
+    /** Initializes the bank with StringVoice's defaults, every voice
+        asleep at 440 Hz.
+        \param sample_rate Audio engine sample rate
+    */
+    void Init(float sample_rate)
+    {
+        for(size_t v = 0; v < num_voices; v++)
+            string_[v].Init(sample_rate);
+        Setup(sample_rate);
+    }
+#endif
+
+    /** Initializes the bank on the caller's memory, split evenly between
+        the strings.
+        \param sample_rate Audio engine sample rate
+        \param mem Delay memory, cleared here
+        \param size Floats at mem: GetMemorySize() of the longest delay
+    */
+    void Init(float sample_rate, float *mem, size_t size)
+    {
+        const size_t per_voice = size / num_voices;
+        for(size_t v = 0; v < num_voices; v++)
+            string_[v].Init(sample_rate, mem + v * per_voice, per_voice);
+        Setup(sample_rate);
+    }
+
+    /** \return floats of memory for every string's delay of up to
+        max_delay samples, as StringOsc::GetMemorySize()
+    */
+    static constexpr size_t GetMemorySize(size_t max_delay = kDelayLineSize)
+    {
+        return num_voices * StringOsc::GetMemorySize(max_delay);
+    }
+
+    /** Restarts the noise, dust and strings from a given seed, for
+        repeatable output. Call after Init().
+    */
+    void SetSeed(uint32_t seed)
+    {
+        rng_.Init(seed);
+        seed = FastRandom::DeriveSeed(seed);
+        dust_.SetSeed(seed);
+        for(size_t v = 0; v < num_voices; v++)
+        {
+            seed = FastRandom::DeriveSeed(seed);
+            string_[v].SetSeed(seed);
+        }
+    }
+
+    /** Plucks voice idx, waking it.
+        \param offset Samples into the next ProcessBlock() to pluck on;
+               past the block's end it carries into the next. 0, the
+               next sample, by default.
+    */
+    void Trig(size_t idx, size_t offset = 0)
+    {
+        if(idx >= num_voices)
+            return;
+        trig_at_[idx].Set(offset);
+        age_[idx] = ++clock_;
+    }
+
+    /** Pitch of voice idx.
+        \param freq Frequency in Hz
+    */
+    void SetFreq(size_t idx, float freq)
+    {
+        if(idx >= num_voices)
+            return;
+        string_[idx].SetFreq(freq);
+        const float f0 = fclamp(freq / sample_rate_, 0.f, .25f);
+        if(f0 != f0_[idx])
+        {
+            f0_[idx]    = f0;
+            dirty_[idx] = true;
+        }
+    }
+
+    /** Plucks a sleeping voice, else the one plucked longest ago, at freq.
+        \param freq Frequency in Hz
+        \param offset As Trig()
+        \return the voice plucked
+    */
+    size_t Strike(float freq, size_t offset = 0)
+    {
+        size_t idx = 0;
+        for(size_t v = 1; v < num_voices; v++)
+        {
+            if(Busy(v) != Busy(idx) ? !Busy(v) : age_[v] < age_[idx])
+                idx = v;
+        }
+        SetFreq(idx, freq);
+        Trig(idx, offset);
+        return idx;
+    }
+
+    /** Sets whether every voice is continually excited, as StringVoice */
+    void SetSustain(bool sustain)
+    {
+        if(sustain != sustain_)
+        {
+            sustain_ = sustain;
+            UpdateShared();
+        }
+    }
+
+    /** Pluck accent, 0-1 */
+    void SetAccent(float accent)
+    {
+        accent = fclamp(accent, 0.f, 1.f);
+        if(accent != accent_)
+        {
+            accent_ = accent;
+            UpdateShared();
+        }
+    }
+
+    /** Non-linearity of the strings, as StringVoice::SetStructure(), 0-1 */
+    void SetStructure(float structure)
+    {
+        structure = fclamp(structure, 0.f, 1.f);
+        const float non_linearity
+            = structure < 0.24f
+                  ? (structure - 0.24f) * 4.166f
+                  : (structure > 0.26f ? (structure - 0.26f) * 1.35135f
+                                       : 0.0f);
+        for(size_t v = 0; v < num_voices; v++)
+            string_[v].SetNonLinearity(non_linearity);
+    }
+
+    /** Brightness of the strings, and the density of the sustain dust, 0-1 */
+    void SetBrightness(float brightness)
+    {
+        brightness = fclamp(brightness, 0.f, 1.f);
+        if(brightness != brightness_)
+        {
+            brightness_ = brightness;
+            UpdateShared();
+        }
+    }
+
+    /** Decay of the strings, 0-1 */
+    void SetDamping(float damping)
+    {
+        damping = fclamp(damping, 0.f, 1.f);
+        if(damping != damping_)
+        {
+            damping_ = damping;
+            UpdateShared();
+        }
+    }
+
+    /** The level under which a voice counts as silent, as DrumKit.
+        \param threshold Linear, 1e-4 (-80 dBFS) by default
+    */
+    inline void SetThreshold(float threshold) { threshold_ = threshold; }
+
+    /** How long a voice must stay under the threshold before it sleeps.
+        \param seconds 10 ms by default
+    */
+    inline void SetHoldTime(float seconds)
+    {
+        const float n = seconds * sample_rate_;
+        hold_         = n > 1.0f ? static_cast<uint32_t>(n) : 1;
+    }
+
+    /** \return whether voice idx is sounding (is processed) */
+    inline bool IsSounding(size_t idx) const
+    {
+        return idx < num_voices && sounding_[idx];
+    }
+
+    /** \return voices sounding after the last ProcessBlock */
+    inline size_t GetActiveCount() const { return num_active_; }
+
+    /** \return voice idx's string, e.g. for its interpolation */
+    inline StringOsc &GetString(size_t idx) { return string_[idx]; }
+
+    /** Fills out with the sum of the voices. */
+    void ProcessBlock(float *out, size_t size)
+    {
+        for(size_t j = 0; j < size; j++)
+            out[j] = 0.0f;
+        if(sustain_)
+        {
+            for(size_t v = 0; v < num_voices; v++)
+                Wake(v);
+        }
+        bool busy = false;
+        for(size_t v = 0; v < num_voices; v++)
+            busy |= Busy(v);
+        if(!busy)
+            return;
+
+        float excite[kChunkSize];
+        for(size_t pos = 0; pos < size; pos += kChunkSize)
+        {
+            const size_t n = size - pos < kChunkSize ? size - pos : kChunkSize;
+            size_t       at[num_voices];
+            bool         bursting = false;
+            for(size_t v = 0; v < num_voices; v++)
+            {
+                at[v] = trig_at_[v].Advance(n);
+                if(at[v] < n)
+                {
+                    quiet_[v] = 0;
+                    Wake(v);
+                }
+                bursting |= sounding_[v] && (at[v] < n || remaining_[v]);
+            }
+            if(sustain_)
+            {
+                for(size_t j = 0; j < n; j++)
+                    excite[j] = dust_.Process() * dust_gain_;
+            }
+            else if(bursting)
+            {
+                rng_.FillBlock(excite, n);
+            }
+            for(size_t v = 0; v < num_voices; v++)
+            {
+                if(sounding_[v])
+                    Render(v, excite, at[v], out + pos, n);
+            }
+        }
+    }
+
+    /** \return one sample of the sum of the voices, through ProcessBlock() */
+    float Process()
+    {
+        float out;
+        ProcessBlock(&out, 1);
+        return out;
+    }
+
+  private:
+    static constexpr size_t kChunkSize = 32;
+
+    void Setup(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        dust_.Init();
+        rng_.Init();
+
+        clock_      = 0;
+        num_active_ = 0;
+        for(size_t v = 0; v < num_voices; v++)
+        {
+            excitation_filter_[v].Init(sample_rate);
+            f0_[v]        = 0.0f;
+            remaining_[v] = 0;
+            age_[v]       = 0;
+            quiet_[v]     = 0;
+            trig_at_[v].Init();
+            sounding_[v]  = false;
+            SetFreq(v, 440.f);
+        }
+
+        sustain_    = false;
+        accent_     = .8f;
+        brightness_ = .2f;
+        damping_    = .7f;
+        SetStructure(.7f);
+        UpdateShared();
+
+        SetThreshold(1e-4f);
+        SetHoldTime(0.01f);
+    }
+
+    /** The settings every voice shares, with StringVoice's accent */
+    void UpdateShared()
+    {
+        brightness_eff_ = brightness_ + .25f * accent_ * (1.f - brightness_);
+        const float damping = damping_ + .25f * accent_ * (1.f - damping_);
+        for(size_t v = 0; v < num_voices; v++)
+        {
+            string_[v].SetBrightness(brightness_eff_);
+            string_[v].SetDamping(damping);
+            dirty_[v] = true;
+        }
+
+        const float density = brightness_ * brightness_;
+        const float dust_f  = 0.00005f + 0.99995f * density * density;
+        dust_.SetDensity(dust_f);
+        dust_gain_ = (8.0f - dust_f * 6.0f) * accent_;
+    }
+
+    /** Voice v's excitation filter */
+    void Update(size_t v)
+    {
+        const float b      = brightness_eff_;
+        const float cutoff = fmin(
+            4.0f * f0_[v] * SemitonesToRatio((b * (2.0f - b) - 0.5f) * 72.0f),
+            0.499f);
+        excitation_filter_[v].SetFreq(cutoff * sample_rate_);
+        excitation_filter_[v].SetRes(sustain_ ? 1.0f : 0.5f);
+        dirty_[v] = false;
+    }
+
+    /** Adds n samples of voice v into out, excited by the shared dust in
+        sustain and otherwise by the shared noise while its burst lasts,
+        a new burst starting on sample at if it is under n.
+    */
+    void
+    Render(size_t v, const float *excite, size_t at, float *out, size_t n)
+    {
+        if(dirty_[v])
+            Update(v);
+
+        float e[kChunkSize];
+        if(sustain_)
+        {
+            for(size_t j = 0; j < n; j++)
+                e[j] = excite[j];
+        }
+        else
+        {
+            size_t remaining = remaining_[v];
+            for(size_t j = 0; j < n; j++)
+            {
+                if(j == at)
+                    remaining = static_cast<size_t>(1.0f / f0_[v]);
+                e[j] = remaining ? excite[j] : 0.0f;
+                remaining -= remaining ? 1 : 0;
+            }
+            remaining_[v] = remaining;
+        }
+
+        float y[kChunkSize];
+        excitation_filter_[v].ProcessBlock(
+            e, e, nullptr, nullptr, nullptr, nullptr, n);
+        string_[v].ProcessBlock(e, y, n);
+
+        const float threshold = threshold_;
+        uint32_t    quiet     = quiet_[v];
+        for(size_t j = 0; j < n; j++)
+        {
+            out[j] += y[j];
+            quiet = fabsf(y[j]) < threshold ? quiet + 1 : 0;
+        }
+        quiet_[v] = quiet;
+        if(!sustain_ && quiet >= hold_)
+            Sleep(v);
+    }
+
+    /** Sounding, or struck and waiting for its offset */
+    inline bool Busy(size_t v) const
+    {
+        return sounding_[v] || trig_at_[v].IsPending();
+    }
+
+    inline void Wake(size_t v)
+    {
+        if(!sounding_[v])
+        {
+            sounding_[v] = true;
+            num_active_++;
+        }
+    }
+
+    inline void Sleep(size_t v)
+    {
+        sounding_[v] = false;
+        num_active_--;
+    }
+
+    float      sample_rate_;
+    Dust       dust_;
+    float      dust_gain_;
+    FastRandom rng_;
+
+    bool  sustain_;
+    float accent_, brightness_, damping_;
+    float brightness_eff_; // with the accent
+
+    // Per voice.
+    StringOsc string_[num_voices];
+    Svf       excitation_filter_[num_voices];
+    float     f0_[num_voices]; // cycles per sample, clamped
+    size_t    remaining_[num_voices]; // samples of burst still to come
+    uint32_t  age_[num_voices]; // clock_ at the last pluck
+    uint32_t  quiet_[num_voices];
+    PendingTrigger trig_at_[num_voices];
+    bool      sounding_[num_voices];
+    bool      dirty_[num_voices];
+
+    uint32_t clock_;
+    size_t   num_active_;
+    float    threshold_;
+    uint32_t hold_;
+};
+
+template <size_t num_voices>
+constexpr size_t StringVoiceBank<num_voices>::kStateBytes
+    = sizeof(StringVoiceBank<num_voices>);
+} // namespace daisysp
+#endif
+#endif
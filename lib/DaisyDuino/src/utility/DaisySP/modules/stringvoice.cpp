@@ -1,16 +1,31 @@
 #include "stringvoice.h"
+#include "semitones.h"
 #include <algorithm>
 #include "dsp.h"
 
 using namespace daisysp;
 
+#if DSY_STRINGOSC_MAX_DELAY > 0
 void StringVoice::Init(float sample_rate)
+{
+    string_.Init(sample_rate);
+    Setup(sample_rate);
+}
+#endif
+
+void StringVoice::Init(float sample_rate, float *mem, size_t size)
+{
+    string_.Init(sample_rate, mem, size);
+    Setup(sample_rate);
+}
+
+void StringVoice::Setup(float sample_rate)
 {
     sample_rate_ = sample_rate;
 
     excitation_filter_.Init(sample_rate);
-    string_.Init(sample_rate_);
     dust_.Init();
+    rng_.Init();
     remaining_noise_samples_ = 0;
 
     SetSustain(false);
@@ -26,6 +41,14 @@ void StringVoice::Reset()
     string_.Reset();
 }
 
+void StringVoice::SetSeed(uint32_t seed)
+{
+    rng_.Init(seed);
+    seed = FastRandom::DeriveSeed(seed);
+    dust_.SetSeed(seed);
+    string_.SetSeed(FastRandom::DeriveSeed(seed));
+}
+
 void StringVoice::SetSustain(bool sustain)
 {
     sustain_ = sustain;
@@ -87,9 +110,8 @@ float StringVoice::Process(bool trigger)
         const float f      = 4.0f * f0_;
         const float cutoff = fmin(
             f
-                * powf(2.f,
-                       kOneTwelfth * (brightness * (2.0f - brightness) - 0.5f)
-                           * range),
+                * SemitonesToRatio((brightness * (2.0f - brightness) - 0.5f)
+                                   * range),
             0.499f);
         const float q            = sustain_ ? 1.0f : 0.5f;
         remaining_noise_samples_ = static_cast<size_t>(1.0f / f0_);
@@ -107,7 +129,7 @@ float StringVoice::Process(bool trigger)
     }
     else if(remaining_noise_samples_)
     {
-        temp = 2.0f * rand() * kRandFrac - 1.0f;
+        temp = rng_.NextBipolar();
         remaining_noise_samples_--;
         remaining_noise_samples_ = DSY_MAX(remaining_noise_samples_, 0.f);
     }
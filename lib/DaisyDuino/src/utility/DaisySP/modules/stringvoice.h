@@ -24,17 +24,34 @@ namespace daisysp
 class StringVoice
 {
   public:
+    static const size_t kStateBytes;
+
     StringVoice() {}
     ~StringVoice() {}
 
+#if DSY_STRINGOSC_MAX_DELAY > 0
     /** Initialize the module
         \param sample_rate Audio engine sample rate
     */
     void Init(float sample_rate);
+#endif
+
+    /** Initialize the module with the string's delay in the caller's
+        memory, as StringOsc::Init(sample_rate, mem, size).
+        \param sample_rate Audio engine sample rate
+        \param mem StringOsc::GetMemorySize() floats, cleared here
+        \param size Floats at mem
+    */
+    void Init(float sample_rate, float *mem, size_t size);
 
     /** Reset the string oscillator */
     void Reset();
 
+    /** Restarts the excitation, sustain and string noise from a given
+        seed, for repeatable output. Call after Init().
+    */
+    void SetSeed(uint32_t seed);
+
     /** Get the next sample
         \param trigger Strike the string. Defaults to false.
     */
@@ -77,6 +94,9 @@ class StringVoice
     float GetAux();
 
   private:
+    /** Everything but the string's own Init() */
+    void Setup(float sample_rate);
+
     float sample_rate_;
 
     bool  sustain_, trig_;
@@ -84,11 +104,14 @@ class StringVoice
     float density_, accent_;
     float aux_;
 
-    Dust   dust_;
-    Svf    excitation_filter_;
-    StringOsc string_;
-    size_t remaining_noise_samples_;
+    Dust       dust_;
+    Svf        excitation_filter_;
+    StringOsc  string_;
+    size_t     remaining_noise_samples_;
+    FastRandom rng_;
 };
+
+inline constexpr size_t StringVoice::kStateBytes = sizeof(StringVoice);
 } // namespace daisysp
 #endif
 #endif
@@ -5,6 +5,15 @@
 
 using namespace daisysp;
 
+namespace
+{
+enum : uint32_t
+{
+    kCacheSine,
+    kCacheRoot,
+};
+} // namespace
+
 void Svf::Init(float sample_rate)
 {
     sr_        = sample_rate;
@@ -24,10 +33,22 @@ void Svf::Init(float sample_rate)
     out_high_  = 0.0f;
     out_peak_  = 0.0f;
     out_band_  = 0.0f;
+
+    res_root_    = powf(res_, 0.25f);
+    target_freq_ = freq_;
+    target_damp_ = damp_;
+    smooth_      = false;
+    cache_       = nullptr;
 }
 
 void Svf::Process(float in)
 {
+    if(smooth_)
+    {
+        freq_ = target_freq_;
+        damp_ = target_damp_;
+    }
+
     input_ = in;
     // first pass
     notch_     = input_ - damp_ * band_;
@@ -66,14 +87,17 @@ void Svf::SetFreq(float f)
         fc_ = f;
     }
     // Set Internal Frequency for fc_
-    freq_ = 2.0f
-            * sinf(PI_F
-                   * MIN(0.25f,
-                         fc_ / (sr_ * 2.0f))); // fs*2 because double sampled
-    // recalculate damp
-    //damp = (MIN(2.0f * powf(res_, 0.25f), MIN(2.0f, 2.0f / freq - freq * 0.5f)));
-    damp_ = MIN(2.0f * (1.0f - powf(res_, 0.25f)),
-                MIN(2.0f, 2.0f / freq_ - freq_ * 0.5f));
+    const float w = PI_F * MIN(0.25f, fc_ / (sr_ * 2.0f)); // fs*2 because double sampled
+    float s;
+    if(smooth_)
+        s = fastsinf(w);
+    else if(cache_)
+        s = cache_->Get({w, kCacheSine},
+                        [](const CacheKey& k) { return sinf(k.x); });
+    else
+        s = math::sin(w);
+    target_freq_ = 2.0f * s;
+    UpdateCoeffs();
 }
 
 void Svf::SetRes(float r)
@@ -86,9 +110,130 @@ void Svf::SetRes(float r)
     {
         r = 1.0f;
     }
-    res_ = r;
+    res_      = r;
+    if(smooth_)
+        res_root_ = math::sqrt(math::sqrt(res_));
+    else if(cache_)
+        res_root_ = cache_->Get({res_, kCacheRoot},
+                                [](const CacheKey& k) { return powf(k.x, 0.25f); });
+    else
+        res_root_ = powf(res_, 0.25f);
+    UpdateCoeffs();
+}
+
+void Svf::SetSmoothing(bool enable)
+{
+    smooth_ = enable;
+    if(!enable)
+    {
+        SetFreq(fc_);
+        SetRes(res_);
+    }
+}
+
+void Svf::UpdateCoeffs()
+{
     // recalculate damp
     //damp = (MIN(2.0f * powf(res_, 0.25f), MIN(2.0f, 2.0f / freq - freq * 0.5f)));
-    damp_ = MIN(2.0f * (1.0f - powf(res_, 0.25f)),
-                MIN(2.0f, 2.0f / freq_ - freq_ * 0.5f));
+    target_damp_ = MIN(2.0f * (1.0f - res_root_),
+                       MIN(2.0f, 2.0f / target_freq_ - target_freq_ * 0.5f));
+    if(!smooth_)
+    {
+        freq_ = target_freq_;
+        damp_ = target_damp_;
+    }
+}
+
+void Svf::ProcessBlock(const float* in,
+                       float*       low,
+                       float*       high,
+                       float*       band,
+                       float*       notch,
+                       float*       peak,
+                       size_t       size)
+{
+    if(smooth_ && size > 0 && (freq_ != target_freq_ || damp_ != target_damp_))
+        Run<true>(in, low, high, band, notch, peak, size);
+    else
+        Run<false>(in, low, high, band, notch, peak, size);
+}
+
+template <bool ramp>
+void Svf::Run(const float* in,
+              float*       low,
+              float*       high,
+              float*       band,
+              float*       notch,
+              float*       peak,
+              size_t       size)
+{
+    const float drive = drive_;
+    float       freq = freq_, damp = damp_;
+    float       dfreq = 0.0f, ddamp = 0.0f;
+    if(ramp)
+    {
+        const float inv_size = 1.0f / (float)size;
+        dfreq                = (target_freq_ - freq) * inv_size;
+        ddamp                = (target_damp_ - damp) * inv_size;
+    }
+    float       x = input_, n = notch_, l = low_, h = high_, b = band_;
+    float       o_low = out_low_, o_high = out_high_, o_band = out_band_;
+    float       o_peak = out_peak_, o_notch = out_notch_;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        if(ramp)
+        {
+            freq += dfreq;
+            damp += ddamp;
+        }
+        x = in[i];
+        // first pass
+        n       = x - damp * b;
+        l       = l + freq * b;
+        h       = n - l;
+        b       = freq * h + b - drive * b * b * b;
+        o_low   = 0.5f * l;
+        o_high  = 0.5f * h;
+        o_band  = 0.5f * b;
+        o_peak  = 0.5f * (l - h);
+        o_notch = 0.5f * n;
+        // second pass
+        n = x - damp * b;
+        l = l + freq * b;
+        h = n - l;
+        b = freq * h + b - drive * b * b * b;
+        o_low += 0.5f * l;
+        o_high += 0.5f * h;
+        o_band += 0.5f * b;
+        o_peak += 0.5f * (l - h);
+        o_notch += 0.5f * n;
+
+        if(low)
+            low[i] = o_low;
+        if(high)
+            high[i] = o_high;
+        if(band)
+            band[i] = o_band;
+        if(notch)
+            notch[i] = o_notch;
+        if(peak)
+            peak[i] = o_peak;
+    }
+
+    if(ramp)
+    {
+        freq_ = target_freq_;
+        damp_ = target_damp_;
+    }
+    input_     = x;
+    notch_     = n;
+    low_       = l;
+    high_      = h;
+    band_      = b;
+    out_low_   = o_low;
+    out_high_  = o_high;
+    out_band_  = o_band;
+    out_peak_  = o_peak;
+    out_notch_ = o_notch;
 }
@@ -2,6 +2,10 @@
 #ifndef DSY_SVF_H
 #define DSY_SVF_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include "coeff_cache.h"
+
 namespace daisysp
 {
 /**      Double Sampled, Stable State Variable Filter
@@ -18,6 +22,24 @@ Ported by: Stephen Hensley
 class Svf
 {
   public:
+    static const size_t kStateBytes;
+
+    /** A setting the cache holds a libm result for: sinf() of the
+        cutoff's angle or powf() of the resonance
+    */
+    struct CacheKey
+    {
+        float    x;
+        uint32_t what;
+        bool     operator==(const CacheKey& other) const
+        {
+            return x == other.x && what == other.what;
+        }
+    };
+
+    /** Results keyed on the setting, for SetCache() */
+    typedef CoeffCache<CacheKey, float, 8> Cache;
+
     Svf() {}
     ~Svf() {}
     /** Initializes the filter
@@ -31,6 +53,18 @@ class Svf
     */
     void Process(float in);
 
+    /** Processes a block, the same as Process() on each sample, writing
+        each output to its own buffer. Any output may be nullptr, and any
+        may be in. Low() etc. return the last sample's outputs afterwards.
+    */
+    void ProcessBlock(const float* in,
+                      float*       low,
+                      float*       high,
+                      float*       band,
+                      float*       notch,
+                      float*       peak,
+                      size_t       size);
+
 
     /** sets the frequency of the cutoff frequency. 
         f must be between 0.0 and sample_rate / 2
@@ -42,6 +76,24 @@ class Svf
     */
     void SetRes(float r);
 
+    /** Coefficient interpolation, for a cutoff or resonance that moves
+        every block. With it on, SetFreq() and SetRes() only compute new
+        targets, with fastsinf() and sqrtf() in place of sinf() / powf(),
+        and ProcessBlock() ramps the coefficients linearly to them across
+        the block. Process() jumps straight to the target. Off after
+        Init(); switching it off applies the exact coefficients.
+    */
+    void SetSmoothing(bool enable);
+
+    /** Looks the sinf() of SetFreq() and the powf() of SetRes() up in
+        cache, shared by any filters set from the same context, so going
+        back to a recent cutoff or resonance costs a scan rather than
+        libm. Each is keyed on its own setting, so a preset that changes
+        only one still finds it. The output is the same. nullptr, the
+        default after Init(), for none; smoothing's fast math skips it.
+    */
+    inline void SetCache(Cache* cache) { cache_ = cache; }
+
     /** sets the drive of the filter 
         affects the response of the resonance of the filter
     */
@@ -72,7 +124,25 @@ class Svf
     float notch_, low_, high_, band_, peak_;
     float input_;
     float out_low_, out_high_, out_band_, out_peak_, out_notch_;
+    // res_^0.25, for damp_ on every SetFreq()
+    float res_root_;
+    // Targets of the smoothing ramp
+    float target_freq_, target_damp_;
+    bool   smooth_;
+    Cache* cache_;
+
+    void UpdateCoeffs();
+    template <bool ramp>
+    void Run(const float* in,
+             float*       low,
+             float*       high,
+             float*       band,
+             float*       notch,
+             float*       peak,
+             size_t       size);
 };
+
+inline constexpr size_t Svf::kStateBytes = sizeof(Svf);
 } // namespace daisysp
 
 #endif
@@ -1,6 +1,7 @@
 #include "synthbassdrum.h"
+#include "semitones.h"
+#include "fast_sin.h"
 #include <math.h>
-#include <stdlib.h>
 
 using namespace daisysp;
 
@@ -28,11 +29,12 @@ void SyntheticBassDrumAttackNoise::Init()
 {
     lp_ = 0.0f;
     hp_ = 0.0f;
+    rng_.Init();
 }
 
 float SyntheticBassDrumAttackNoise::Process()
 {
-    float sample = rand() * kRandFrac;
+    float sample = rng_.NextFloat();
     fonepole(lp_, sample, 0.05f);
     fonepole(hp_, lp_, 0.005f);
     return lp_ - hp_;
@@ -43,6 +45,7 @@ void SyntheticBassDrum::Init(float sample_rate)
     sample_rate_ = sample_rate;
 
     trig_ = false;
+    trig_at_.Init();
 
     phase_                = 0.0f;
     phase_noise_          = 0.0f;
@@ -51,10 +54,18 @@ void SyntheticBassDrum::Init(float sample_rate)
     fm_lp_                = 0.0f;
     body_env_lp_          = 0.0f;
     body_env_             = 0.0f;
+    transient_env_        = 0.0f;
+    transient_env_lp_     = 0.0f;
     body_env_pulse_width_ = 0;
     fm_pulse_width_       = 0;
     tone_lp_              = 0.0f;
     sustain_gain_         = 0.0f;
+    tone_                 = 0.0f;
+    dirtiness_            = 0.0f;
+
+    transient_env_decay_ = 1.0f - 1.0f / (0.005f * sample_rate_);
+    body_env_pulse_samples_ = static_cast<int>(sample_rate_ * 0.001f);
+    fm_pulse_samples_       = static_cast<int>(sample_rate_ * 0.0013f);
 
     SetFreq(100.f);
     SetSustain(false);
@@ -67,6 +78,13 @@ void SyntheticBassDrum::Init(float sample_rate)
 
     click_.Init(sample_rate);
     noise_.Init();
+    rng_.Init();
+}
+
+void SyntheticBassDrum::SetSeed(uint32_t seed)
+{
+    rng_.Init(seed);
+    noise_.SetSeed(FastRandom::DeriveSeed(seed));
 }
 
 inline float SyntheticBassDrum::DistortedSine(float phase,
@@ -82,7 +100,7 @@ inline float SyntheticBassDrum::DistortedSine(float phase,
     phase            = phase_fractional;
     float triangle   = (phase < 0.5f ? phase : 1.0f - phase) * 4.0f - 1.0f;
     float sine       = 2.0f * triangle / (1.0f + fabsf(triangle));
-    float clean_sine = sinf(TWOPI_F * (phase + 0.75f));
+    float clean_sine = FastSin::Sin(phase + 0.75f);
     return sine + (1.0f - dirtiness) * (clean_sine - sine);
 }
 
@@ -92,36 +110,23 @@ inline float SyntheticBassDrum::TransistorVCA(float s, float gain)
     return 3.0f * s / (2.0f + fabsf(s)) + gain * 0.3f;
 }
 
-float SyntheticBassDrum::Process(bool trigger)
+inline float SyntheticBassDrum::Render()
 {
-    float dirtiness = dirtiness_;
-    dirtiness *= fmax(1.0f - 8.0f * new_f0_, 0.0f);
-
-    const float fm_decay
-        = 1.0f
-          - 1.0f / (0.008f * (1.0f + fm_envelope_decay_ * 4.0f) * sample_rate_);
-
-    const float body_env_decay
-        = 1.0f
-          - 1.0f / (0.02f * sample_rate_)
-                * powf(2.f, (-decay_ * 60.0f) * kOneTwelfth);
-    const float transient_env_decay = 1.0f - 1.0f / (0.005f * sample_rate_);
-    const float tone_f              = fmin(
-        4.0f * new_f0_ * powf(2.f, (tone_ * 108.0f) * kOneTwelfth), 1.0f);
+    const float dirtiness       = dirtiness_f0_;
     const float transient_level = tone_;
 
-    if(trigger || trig_)
+    if(trig_)
     {
         trig_     = false;
         fm_       = 1.0f;
         body_env_ = transient_env_ = 0.3f + 0.7f * accent_;
-        body_env_pulse_width_      = sample_rate_ * 0.001f;
-        fm_pulse_width_            = sample_rate_ * 0.0013f;
+        body_env_pulse_width_      = body_env_pulse_samples_;
+        fm_pulse_width_            = fm_pulse_samples_;
     }
 
     sustain_gain_ = accent_ * decay_;
 
-    fonepole(phase_noise_, rand() * kRandFrac - 0.5f, 0.002f);
+    fonepole(phase_noise_, rng_.NextFloat() - 0.5f, 0.002f);
 
     float mix = 0.0f;
 
@@ -145,7 +150,7 @@ float SyntheticBassDrum::Process(bool trigger)
         }
         else
         {
-            fm_ *= fm_decay;
+            fm_ *= fm_decay_;
             float fm = 1.0f + fm_envelope_amount_ * 3.5f * fm_lp_;
             f0_      = new_f0_;
             phase_ += fmin(f0_ * fm, 0.5f);
@@ -161,8 +166,8 @@ float SyntheticBassDrum::Process(bool trigger)
         }
         else
         {
-            body_env_ *= body_env_decay;
-            transient_env_ *= transient_env_decay;
+            body_env_ *= body_env_decay_;
+            transient_env_ *= transient_env_decay_;
         }
 
         const float envelope_lp_f = 0.1f;
@@ -178,13 +183,34 @@ float SyntheticBassDrum::Process(bool trigger)
         mix -= transient * transient_env_lp_ * transient_level;
     }
 
-    fonepole(tone_lp_, mix, tone_f);
+    fonepole(tone_lp_, mix, tone_f_);
     return tone_lp_;
 }
 
-void SyntheticBassDrum::Trig()
+float SyntheticBassDrum::Process(bool trigger)
+{
+    if(trig_at_.Advance(1) == 0)
+        trig_ = true;
+    trig_ = trig_ || trigger;
+    return Render();
+}
+
+void SyntheticBassDrum::ProcessBlock(float *out, size_t size)
 {
-    trig_ = true;
+    const size_t at = trig_at_.Advance(size);
+    for(size_t i = 0; i < at; i++)
+        out[i] = Render();
+    if(at < size)
+    {
+        trig_ = true;
+        for(size_t i = at; i < size; i++)
+            out[i] = Render();
+    }
+}
+
+void SyntheticBassDrum::Trig(size_t offset)
+{
+    trig_at_.Set(offset);
 }
 
 void SyntheticBassDrum::SetSustain(bool sustain)
@@ -201,22 +227,29 @@ void SyntheticBassDrum::SetFreq(float freq)
 {
     freq /= sample_rate_;
     new_f0_ = fclamp(freq, 0.f, 1.f);
+    UpdateTone();
+    UpdateDirtiness();
 }
 
 void SyntheticBassDrum::SetTone(float tone)
 {
     tone_ = fclamp(tone, 0.f, 1.f);
+    UpdateTone();
 }
 
 void SyntheticBassDrum::SetDecay(float decay)
 {
     decay  = fclamp(decay, 0.f, 1.f);
     decay_ = decay * decay;
+    body_env_decay_
+        = 1.0f
+          - 1.0f / (0.02f * sample_rate_) * SemitonesToRatio(-decay_ * 60.0f);
 }
 
 void SyntheticBassDrum::SetDirtiness(float dirtiness)
 {
     dirtiness_ = fclamp(dirtiness, 0.f, 1.f);
+    UpdateDirtiness();
 }
 
 void SyntheticBassDrum::SetFmEnvelopeAmount(float fm_envelope_amount)
@@ -228,4 +261,17 @@ void SyntheticBassDrum::SetFmEnvelopeDecay(float fm_envelope_decay)
 {
     fm_envelope_decay  = fclamp(fm_envelope_decay, 0.f, 1.f);
     fm_envelope_decay_ = fm_envelope_decay * fm_envelope_decay;
+    fm_decay_
+        = 1.0f
+          - 1.0f / (0.008f * (1.0f + fm_envelope_decay_ * 4.0f) * sample_rate_);
+}
+
+void SyntheticBassDrum::UpdateTone()
+{
+    tone_f_ = fmin(4.0f * new_f0_ * SemitonesToRatio(tone_ * 108.0f), 1.0f);
+}
+
+void SyntheticBassDrum::UpdateDirtiness()
+{
+    dirtiness_f0_ = dirtiness_ * fmax(1.0f - 8.0f * new_f0_, 0.0f);
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "svf.h"
 #include "dsp.h"
+#include "fast_random.h"
+#include "pending_trigger.h"
 
 #include <stdint.h>
 #ifdef __cplusplus
@@ -23,6 +25,8 @@ namespace daisysp
 class SyntheticBassDrumClick
 {
   public:
+    static const size_t kStateBytes;
+
     SyntheticBassDrumClick() {}
     ~SyntheticBassDrumClick() {}
 
@@ -42,6 +46,9 @@ class SyntheticBassDrumClick
     Svf   filter_;
 };
 
+inline constexpr size_t SyntheticBassDrumClick::kStateBytes
+    = sizeof(SyntheticBassDrumClick);
+
 /**  
        @brief Attack Noise generator for SyntheticBassDrum. 
 	   @author Ben Sergentanis
@@ -53,20 +60,31 @@ class SyntheticBassDrumClick
 class SyntheticBassDrumAttackNoise
 {
   public:
+    static const size_t kStateBytes;
+
     SyntheticBassDrumAttackNoise() {}
     ~SyntheticBassDrumAttackNoise() {}
 
     /** Init the module */
     void Init();
 
+    /** Restarts the noise from a given seed, for repeatable output.
+        Call after Init().
+    */
+    void SetSeed(uint32_t seed) { rng_.Init(seed); }
+
     /** Get the next sample. */
     float Process();
 
   private:
-    float lp_;
-    float hp_;
+    float      lp_;
+    float      hp_;
+    FastRandom rng_;
 };
 
+inline constexpr size_t SyntheticBassDrumAttackNoise::kStateBytes
+    = sizeof(SyntheticBassDrumAttackNoise);
+
 /**  
        @brief Naive bass drum model (modulated oscillator with FM + envelope).
 	   @author Ben Sergentanis
@@ -79,6 +97,8 @@ class SyntheticBassDrumAttackNoise
 class SyntheticBassDrum
 {
   public:
+    static const size_t kStateBytes;
+
     SyntheticBassDrum() {}
     ~SyntheticBassDrum() {}
 
@@ -87,6 +107,11 @@ class SyntheticBassDrum
 	*/
     void Init(float sample_rate);
 
+    /** Restarts the phase and attack noise from a given seed, for
+        repeatable output. Call after Init().
+    */
+    void SetSeed(uint32_t seed);
+
     /** Generates a distorted sine wave */
     inline float DistortedSine(float phase, float phase_noise, float dirtiness);
 
@@ -101,8 +126,17 @@ class SyntheticBassDrum
 	*/
     float Process(bool trigger = false);
 
-    /** Trigger the drum */
-    void Trig();
+    /** Fills out with size samples, the same as calling Process() for
+        each; a Trig(offset) before the call strikes offset samples in.
+    */
+    void ProcessBlock(float *out, size_t size);
+
+    /** Strikes the drum.
+        \param offset Samples into the next ProcessBlock() (or Process()
+               calls from now) to strike on; past the block's end it
+               carries into the next. 0, the next sample, by default.
+    */
+    void Trig(size_t offset = 0);
 
     /** Allows the drum to play continuously
 		\param sustain True sets the drum on infinite sustain.
@@ -145,13 +179,28 @@ class SyntheticBassDrum
     void SetFmEnvelopeDecay(float fm_envelope_decay);
 
   private:
+    /** One sample; Process() and ProcessBlock() both run it. */
+    inline float Render();
+
+    /** Refresh the coefficients the setters derive, per change rather
+        than per sample.
+    */
+    void UpdateTone();
+    void UpdateDirtiness();
+
     float sample_rate_;
 
     bool  trig_;
+    PendingTrigger trig_at_;
     bool  sustain_;
     float accent_, new_f0_, tone_, decay_;
     float dirtiness_, fm_envelope_amount_, fm_envelope_decay_;
 
+    // From the settings above.
+    float fm_decay_, body_env_decay_, transient_env_decay_;
+    float tone_f_, dirtiness_f0_;
+    int   body_env_pulse_samples_, fm_pulse_samples_;
+
     float f0_;
     float phase_;
     float phase_noise_;
@@ -169,11 +218,15 @@ class SyntheticBassDrum
 
     SyntheticBassDrumClick       click_;
     SyntheticBassDrumAttackNoise noise_;
+    FastRandom                   rng_;
 
     int body_env_pulse_width_;
     int fm_pulse_width_;
 };
 
+inline constexpr size_t SyntheticBassDrum::kStateBytes
+    = sizeof(SyntheticBassDrum);
+
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
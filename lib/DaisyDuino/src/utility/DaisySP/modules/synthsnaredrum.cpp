@@ -1,7 +1,7 @@
 #include "dsp.h"
 #include "synthsnaredrum.h"
+#include "semitones.h"
 #include <math.h>
-#include <stdlib.h>
 
 using namespace daisysp;
 
@@ -29,6 +29,12 @@ void SyntheticSnareDrum::Init(float sample_rate)
     drum_lp_.Init(sample_rate_);
     snare_hp_.Init(sample_rate_);
     snare_lp_.Init(sample_rate_);
+    rng_.Init();
+}
+
+void SyntheticSnareDrum::SetSeed(uint32_t seed)
+{
+    rng_.Init(seed);
 }
 
 inline float SyntheticSnareDrum::DistortedSine(float phase)
@@ -45,22 +51,20 @@ float SyntheticSnareDrum::Process(bool trigger)
     const float drum_decay
         = 1.0f
           - 1.0f / (0.015f * sample_rate_)
-                * powf(2.f,
-                       kOneTwelfth
-                           * (-decay_xt * 72.0f - fm_amount_ * 12.0f
-                              + snappy_ * 7.0f));
+                * SemitonesToRatio(-decay_xt * 72.0f - fm_amount_ * 12.0f
+                                   + snappy_ * 7.0f);
 
     const float snare_decay
         = 1.0f
           - 1.0f / (0.01f * sample_rate_)
-                * powf(2.f, kOneTwelfth * (-decay_ * 60.0f - snappy_ * 7.0f));
+                * SemitonesToRatio(-decay_ * 60.0f - snappy_ * 7.0f);
     const float fm_decay = 1.0f - 1.0f / (0.007f * sample_rate_);
 
     float snappy = snappy_ * 1.1f - 0.05f;
     snappy       = fclamp(snappy, 0.0f, 1.0f);
 
-    const float drum_level  = sqrtf(1.0f - snappy);
-    const float snare_level = sqrtf(snappy);
+    const float drum_level  = math::sqrt(1.0f - snappy);
+    const float snare_level = math::sqrt(snappy);
 
     const float snare_f_min = fmin(10.0f * f0_, 0.5f);
     const float snare_f_max = fmin(35.0f * f0_, 0.5f);
@@ -153,7 +157,7 @@ float SyntheticSnareDrum::Process(bool trigger)
     drum_lp_.Process(drum);
     drum = drum_lp_.Low();
 
-    float noise = rand() * kRandFrac;
+    float noise = rng_.NextFloat();
     snare_lp_.Process(noise);
     float snare = snare_lp_.Low();
     snare_hp_.Process(snare);
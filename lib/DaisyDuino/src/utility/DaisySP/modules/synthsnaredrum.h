@@ -3,6 +3,7 @@
 #define DSY_SYNTHSD_H
 
 #include "svf.h"
+#include "fast_random.h"
 
 #include <stdint.h>
 #ifdef __cplusplus
@@ -26,6 +27,8 @@ namespace daisysp
 class SyntheticSnareDrum
 {
   public:
+    static const size_t kStateBytes;
+
     SyntheticSnareDrum() {}
     ~SyntheticSnareDrum() {}
 
@@ -34,6 +37,11 @@ class SyntheticSnareDrum
 	*/
     void Init(float sample_rate);
 
+    /** Restarts the noise from a given seed, for repeatable output.
+        Call after Init().
+    */
+    void SetSeed(uint32_t seed);
+
     /** Get the next sample.
 		\param trigger True = hit the drum. This argument is optional.
 	*/
@@ -91,7 +99,12 @@ class SyntheticSnareDrum
     Svf drum_lp_;
     Svf snare_hp_;
     Svf snare_lp_;
+
+    FastRandom rng_;
 };
+
+inline constexpr size_t SyntheticSnareDrum::kStateBytes
+    = sizeof(SyntheticSnareDrum);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -23,11 +23,25 @@ float Tone::Process(float &in)
     return out;
 }
 
+void Tone::ProcessBlock(const float *in, float *out, size_t size)
+{
+    const float c1 = c1_, c2 = c2_;
+    float       prevout = prevout_;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        prevout = c1 * in[i] + c2 * prevout;
+        out[i]  = prevout;
+    }
+
+    prevout_ = prevout;
+}
+
 void Tone::CalculateCoefficients()
 {
     float b, c1, c2;
     b   = 2.0f - cosf(TWOPI_F * freq_ / sample_rate_);
-    c2  = b - sqrtf(b * b - 1.0f);
+    c2  = b - math::sqrt(b * b - 1.0f);
     c1  = 1.0f - c2;
     c1_ = c1;
     c2_ = c2;
@@ -3,6 +3,7 @@
 #define DSY_TONE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 namespace daisysp
@@ -12,6 +13,8 @@ namespace daisysp
 class Tone
 {
   public:
+    static const size_t kStateBytes;
+
     Tone() {}
     ~Tone() {}
     /** Initializes the Tone module.
@@ -25,6 +28,11 @@ class Tone
     */
     float Process(float &in);
 
+    /** Processes a block, the same as Process() on each sample.
+        out may be in.
+    */
+    void ProcessBlock(const float *in, float *out, size_t size);
+
     /** Sets the cutoff frequency or half-way point of the filter.
 
         \param freq - frequency value in Hz. Range: Any positive value.
@@ -44,6 +52,8 @@ class Tone
     void  CalculateCoefficients();
     float out_, prevout_, in_, freq_, c1_, c2_, sample_rate_;
 };
+
+inline constexpr size_t Tone::kStateBytes = sizeof(Tone);
 } // namespace daisysp
 #endif
 #endif
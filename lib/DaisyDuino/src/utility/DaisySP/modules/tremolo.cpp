@@ -7,15 +7,51 @@ void Tremolo::Init(float sample_rate)
 {
     sample_rate_ = sample_rate;
 
-    osc_.Init(sample_rate_);
+    osc_.Init(sample_rate_ / kControlRate);
     SetDepth(1.f);
     SetFreq(1.f);
+    gain_      = 0.f;
+    gain_inc_  = 0.f;
+    countdown_ = 0;
+    primed_    = false;
 }
 
 float Tremolo::Process(float in)
 {
-    float modsig = dc_os_ + osc_.Process();
-    return in * modsig;
+    float out;
+    ProcessBlock(&in, &out, 1);
+    return out;
+}
+
+void Tremolo::ProcessBlock(const float* in, float* out, size_t size)
+{
+    if(!primed_)
+    {
+        // The ramp starts here, not in Init(), so it follows the depth
+        // and waveform set since.
+        gain_   = dc_os_ + osc_.Process();
+        primed_ = true;
+    }
+    size_t i = 0;
+    while(i < size)
+    {
+        if(countdown_ == 0)
+        {
+            const float next = dc_os_ + osc_.Process();
+            gain_inc_        = (next - gain_) * (1.f / kControlRate);
+            countdown_       = kControlRate;
+        }
+        const size_t n   = countdown_ < size - i ? countdown_ : size - i;
+        const size_t end = i + n;
+        float        g   = gain_;
+        for(; i < end; i++)
+        {
+            g += gain_inc_;
+            out[i] = in[i] * g;
+        }
+        gain_ = g;
+        countdown_ -= n;
+    }
 }
 
 void Tremolo::SetFreq(float freq)
@@ -3,6 +3,7 @@
 #define DSY_TREMOLO_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 #include <math.h>
@@ -17,10 +18,14 @@ namespace daisysp
     @author Ben Sergentanis
     @date Jan 2021
     Based on https://christianfloisand.wordpress.com/2012/04/18/coding-some-tremolo/ \n
+    The lfo runs at control rate, one sample every kControlRate, and the
+    gain is ramped linearly between them.
 */
 class Tremolo
 {
   public:
+    static const size_t kStateBytes;
+
     Tremolo() {}
     ~Tremolo() {}
 
@@ -35,6 +40,13 @@ class Tremolo
     */
     float Process(float in);
 
+    /** Tremolo on a block
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size);
+
     /** Sets the tremolo rate.
        \param freq Tremolo freq in Hz.
     */
@@ -51,10 +63,18 @@ class Tremolo
     void SetDepth(float depth);
 
 
+    /** Samples per lfo sample */
+    static constexpr size_t kControlRate = 16;
+
   private:
     float      sample_rate_, dc_os_;
+    float      gain_, gain_inc_;
+    size_t     countdown_;
+    bool       primed_;
     Oscillator osc_;
 };
+
+inline constexpr size_t Tremolo::kStateBytes = sizeof(Tremolo);
 } // namespace daisysp
 #endif
 #endif
@@ -20,51 +20,81 @@ void VariableSawOscillator::Init(float sample_rate)
 
 float VariableSawOscillator::Process()
 {
-    float next_sample = next_sample_;
+    float out;
+    ProcessBlock(&out, 1);
+    return out;
+}
 
-    float this_sample = next_sample;
-    next_sample       = 0.0f;
+void VariableSawOscillator::ProcessBlock(float *out, size_t size)
+{
+    if(size == 0)
+        return;
 
+    // Everything but the phase is fixed over the block.
+    const float frequency       = frequency_;
+    const float pw              = pw_;
     const float triangle_amount = waveshape_;
     const float notch_amount    = 1.0f - waveshape_;
-    const float slope_up        = 1.0f / (pw_);
-    const float slope_down      = 1.0f / (1.0f - pw_);
+    const float slope_up        = 1.0f / (pw);
+    const float slope_down      = 1.0f / (1.0f - pw);
+    const float triangle_step
+        = (slope_up + slope_down) * frequency * triangle_amount;
+    const float rise_notch = (kVariableSawNotchDepth + 1.0f - pw) * notch_amount;
+    const float fall_notch = (kVariableSawNotchDepth + 1.0f) * notch_amount;
+    const float scale      = 1.0f / (1.0f + kVariableSawNotchDepth);
 
-    phase_ += frequency_;
+    // The pulse width may have moved since the last block's last sample.
+    float rise_span = previous_pw_ - pw + frequency;
 
-    if(!high_ && phase_ >= pw_)
-    {
-        const float triangle_step
-            = (slope_up + slope_down) * frequency_ * triangle_amount;
-        const float notch
-            = (kVariableSawNotchDepth + 1.0f - pw_) * notch_amount;
-        const float t = (phase_ - pw_) / (previous_pw_ - pw_ + frequency_);
-        this_sample += notch * ThisBlepSample(t);
-        next_sample += notch * NextBlepSample(t);
-        this_sample -= triangle_step * ThisIntegratedBlepSample(t);
-        next_sample -= triangle_step * NextIntegratedBlepSample(t);
-        high_ = true;
-    }
-    else if(phase_ >= 1.0f)
+    float phase       = phase_;
+    float next_sample = next_sample_;
+    bool  high        = high_;
+    float edge        = high ? 1.0f : pw; // the next transition
+
+    for(size_t i = 0; i < size; i++)
     {
-        phase_ -= 1.0f;
-        const float triangle_step
-            = (slope_up + slope_down) * frequency_ * triangle_amount;
-        const float notch = (kVariableSawNotchDepth + 1.0f) * notch_amount;
-        const float t     = phase_ / frequency_;
-        this_sample -= notch * ThisBlepSample(t);
-        next_sample -= notch * NextBlepSample(t);
-        this_sample += triangle_step * ThisIntegratedBlepSample(t);
-        next_sample += triangle_step * NextIntegratedBlepSample(t);
-        high_ = false;
-    }
+        float this_sample = next_sample;
+        next_sample       = 0.0f;
+
+        phase += frequency;
 
-    next_sample += ComputeNaiveSample(
-        phase_, pw_, slope_up, slope_down, triangle_amount, notch_amount);
-    previous_pw_ = pw_;
+        // One compare a sample; the one edge due is the only one possible.
+        if(phase >= edge)
+        {
+            if(!high)
+            {
+                const float t = (phase - pw) / rise_span;
+                this_sample += rise_notch * ThisBlepSample(t);
+                next_sample += rise_notch * NextBlepSample(t);
+                this_sample -= triangle_step * ThisIntegratedBlepSample(t);
+                next_sample -= triangle_step * NextIntegratedBlepSample(t);
+                high = true;
+                edge = 1.0f;
+            }
+            else
+            {
+                phase -= 1.0f;
+                const float t = phase / frequency;
+                this_sample -= fall_notch * ThisBlepSample(t);
+                next_sample -= fall_notch * NextBlepSample(t);
+                this_sample += triangle_step * ThisIntegratedBlepSample(t);
+                next_sample += triangle_step * NextIntegratedBlepSample(t);
+                high = false;
+                edge = pw;
+            }
+        }
+        rise_span = frequency;
+
+        next_sample += ComputeNaiveSample(
+            phase, pw, slope_up, slope_down, triangle_amount, notch_amount);
+
+        out[i] = (2.0f * this_sample - 1.0f) * scale;
+    }
 
+    phase_       = phase;
     next_sample_ = next_sample;
-    return (2.0f * this_sample - 1.0f) / (1.0f + kVariableSawNotchDepth);
+    high_        = high;
+    previous_pw_ = pw;
 }
 
 void VariableSawOscillator::SetFreq(float frequency)
@@ -3,6 +3,7 @@
 #define DSY_VARISAWOSCILLATOR_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file variablesawosc.h */
@@ -20,6 +21,8 @@ namespace daisysp
 class VariableSawOscillator
 {
   public:
+    static const size_t kStateBytes;
+
     VariableSawOscillator() {}
     ~VariableSawOscillator() {}
 
@@ -28,6 +31,11 @@ class VariableSawOscillator
     /** Get the next sample */
     float Process();
 
+    /** Processes a block, the same as Process() on each sample but for
+        float rounding, with the shape's slopes worked out once for it.
+    */
+    void ProcessBlock(float* out, size_t size);
+
     /** Set master freq.
         \param frequency Freq in Hz.
     */
@@ -67,6 +75,9 @@ class VariableSawOscillator
     float pw_;
     float waveshape_;
 };
+
+inline constexpr size_t VariableSawOscillator::kStateBytes
+    = sizeof(VariableSawOscillator);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -23,108 +23,140 @@ void VariableShapeOscillator::Init(float sample_rate)
 
 float VariableShapeOscillator::Process()
 {
-    float next_sample = next_sample_;
-
-    bool  reset                   = false;
-    bool  transition_during_reset = false;
-    float reset_time              = 0.0f;
+    float out;
+    ProcessBlock(&out, 1);
+    return out;
+}
 
-    float this_sample = next_sample;
-    next_sample       = 0.0f;
+void VariableShapeOscillator::ProcessBlock(float* out, size_t size)
+{
+    if(size == 0)
+        return;
+
+    // Everything but the phases is fixed over the block.
+    const bool  enable_sync      = enable_sync_;
+    const float master_frequency = master_frequency_;
+    const float slave_frequency  = slave_frequency_;
+    const float pw               = pw_;
+    const float square_amount    = fmax(waveshape_ - 0.5f, 0.0f) * 2.0f;
+    const float triangle_amount  = fmax(1.0f - waveshape_ * 2.0f, 0.0f);
+    const float slope_up         = 1.0f / (pw);
+    const float slope_down       = 1.0f / (1.0f - pw);
+    float       triangle_step    = (slope_up + slope_down) * slave_frequency;
+    triangle_step *= triangle_amount;
+
+    // The pulse width may have moved since the last block's last sample.
+    float rise_span = previous_pw_ - pw + slave_frequency;
+
+    float master_phase = master_phase_;
+    float slave_phase  = slave_phase_;
+    float next_sample  = next_sample_;
+    bool  high         = high_;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        bool  reset                   = false;
+        bool  transition_during_reset = false;
+        float reset_time              = 0.0f;
 
-    const float square_amount   = fmax(waveshape_ - 0.5f, 0.0f) * 2.0f;
-    const float triangle_amount = fmax(1.0f - waveshape_ * 2.0f, 0.0f);
-    const float slope_up        = 1.0f / (pw_);
-    const float slope_down      = 1.0f / (1.0f - pw_);
+        float this_sample = next_sample;
+        next_sample       = 0.0f;
 
-    if(enable_sync_)
-    {
-        master_phase_ += master_frequency_;
-        if(master_phase_ >= 1.0f)
+        if(enable_sync)
         {
-            master_phase_ -= 1.0f;
-            reset_time = master_phase_ / master_frequency_;
-
-            float slave_phase_at_reset
-                = slave_phase_ + (1.0f - reset_time) * slave_frequency_;
-            reset = true;
-            if(slave_phase_at_reset >= 1.0f)
-            {
-                slave_phase_at_reset -= 1.0f;
-                transition_during_reset = true;
-            }
-            if(!high_ && slave_phase_at_reset >= pw_)
+            master_phase += master_frequency;
+            if(master_phase >= 1.0f)
             {
-                transition_during_reset = true;
+                master_phase -= 1.0f;
+                reset_time = master_phase / master_frequency;
+
+                float slave_phase_at_reset
+                    = slave_phase + (1.0f - reset_time) * slave_frequency;
+                reset = true;
+                if(slave_phase_at_reset >= 1.0f)
+                {
+                    slave_phase_at_reset -= 1.0f;
+                    transition_during_reset = true;
+                }
+                if(!high && slave_phase_at_reset >= pw)
+                {
+                    transition_during_reset = true;
+                }
+                float value = ComputeNaiveSample(slave_phase_at_reset,
+                                                 pw,
+                                                 slope_up,
+                                                 slope_down,
+                                                 triangle_amount,
+                                                 square_amount);
+                this_sample -= value * ThisBlepSample(reset_time);
+                next_sample -= value * NextBlepSample(reset_time);
             }
-            float value = ComputeNaiveSample(slave_phase_at_reset,
-                                             pw_,
-                                             slope_up,
-                                             slope_down,
-                                             triangle_amount,
-                                             square_amount);
-            this_sample -= value * ThisBlepSample(reset_time);
-            next_sample -= value * NextBlepSample(reset_time);
         }
-    }
 
-    slave_phase_ += slave_frequency_;
-    while(transition_during_reset || !reset)
-    {
-        if(!high_)
+        slave_phase += slave_frequency;
+
+        // Without a reset, one compare against the edge due next skips
+        // the transitions on all but the samples that have one.
+        const float edge = high ? 1.0f : pw;
+        if(reset ? transition_during_reset : slave_phase >= edge)
         {
-            if(slave_phase_ < pw_)
+            while(transition_during_reset || !reset)
             {
-                break;
+                if(!high)
+                {
+                    if(slave_phase < pw)
+                    {
+                        break;
+                    }
+                    float t = (slave_phase - pw) / rise_span;
+
+                    this_sample += square_amount * ThisBlepSample(t);
+                    next_sample += square_amount * NextBlepSample(t);
+                    this_sample -= triangle_step * ThisIntegratedBlepSample(t);
+                    next_sample -= triangle_step * NextIntegratedBlepSample(t);
+                    high = true;
+                }
+
+                if(high)
+                {
+                    if(slave_phase < 1.0f)
+                    {
+                        break;
+                    }
+                    slave_phase -= 1.0f;
+                    float t = slave_phase / slave_frequency;
+
+                    this_sample -= (1.0f - triangle_amount) * ThisBlepSample(t);
+                    next_sample -= (1.0f - triangle_amount) * NextBlepSample(t);
+                    this_sample += triangle_step * ThisIntegratedBlepSample(t);
+                    next_sample += triangle_step * NextIntegratedBlepSample(t);
+                    high = false;
+                }
             }
-            float t = (slave_phase_ - pw_)
-                      / (previous_pw_ - pw_ + slave_frequency_);
-            float triangle_step = (slope_up + slope_down) * slave_frequency_;
-            triangle_step *= triangle_amount;
-
-            this_sample += square_amount * ThisBlepSample(t);
-            next_sample += square_amount * NextBlepSample(t);
-            this_sample -= triangle_step * ThisIntegratedBlepSample(t);
-            next_sample -= triangle_step * NextIntegratedBlepSample(t);
-            high_ = true;
         }
+        rise_span = slave_frequency;
 
-        if(high_)
+        if(enable_sync && reset)
         {
-            if(slave_phase_ < 1.0f)
-            {
-                break;
-            }
-            slave_phase_ -= 1.0f;
-            float t             = slave_phase_ / slave_frequency_;
-            float triangle_step = (slope_up + slope_down) * slave_frequency_;
-            triangle_step *= triangle_amount;
-
-            this_sample -= (1.0f - triangle_amount) * ThisBlepSample(t);
-            next_sample -= (1.0f - triangle_amount) * NextBlepSample(t);
-            this_sample += triangle_step * ThisIntegratedBlepSample(t);
-            next_sample += triangle_step * NextIntegratedBlepSample(t);
-            high_ = false;
+            slave_phase = reset_time * slave_frequency;
+            high        = false;
         }
-    }
 
-    if(enable_sync_ && reset)
-    {
-        slave_phase_ = reset_time * slave_frequency_;
-        high_        = false;
-    }
-
-    next_sample += ComputeNaiveSample(slave_phase_,
-                                      pw_,
-                                      slope_up,
-                                      slope_down,
-                                      triangle_amount,
-                                      square_amount);
-    previous_pw_ = pw_;
+        next_sample += ComputeNaiveSample(slave_phase,
+                                          pw,
+                                          slope_up,
+                                          slope_down,
+                                          triangle_amount,
+                                          square_amount);
 
+        out[i] = 2.0f * this_sample - 1.0f;
+    }
 
-    next_sample_ = next_sample;
-    return (2.0f * this_sample - 1.0f);
+    master_phase_ = master_phase;
+    slave_phase_  = slave_phase;
+    next_sample_  = next_sample;
+    high_         = high;
+    previous_pw_  = pw;
 }
 
 void VariableShapeOscillator::SetFreq(float frequency)
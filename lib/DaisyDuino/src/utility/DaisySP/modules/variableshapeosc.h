@@ -3,6 +3,7 @@
 #define DSY_VARIABLESHAPEOSCILLATOR_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file variableshapeosc.h */
@@ -21,6 +22,8 @@ namespace daisysp
 class VariableShapeOscillator
 {
   public:
+    static const size_t kStateBytes;
+
     VariableShapeOscillator() {}
     ~VariableShapeOscillator() {}
 
@@ -33,6 +36,11 @@ class VariableShapeOscillator
     */
     float Process();
 
+    /** Processes a block, the same as Process() on each sample, with the
+        shape's slopes worked out once for it.
+    */
+    void ProcessBlock(float* out, size_t size);
+
     /** Set master freq.
         \param frequency Freq in Hz.
     */
@@ -82,6 +90,9 @@ class VariableShapeOscillator
     float pw_;
     float waveshape_;
 };
+
+inline constexpr size_t VariableShapeOscillator::kStateBytes
+    = sizeof(VariableShapeOscillator);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,322 @@
+#pragma once
+#ifndef DSY_VOICE_ALLOCATOR_H
+#define DSY_VOICE_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef __cplusplus
+
+namespace daisysp
+{
+/** Polyphonic note allocation over N voices, skipping the silent ones.
+
+    Voice is any class with:
+
+        void  NoteOn(float note, float velocity); // MIDI note, 0-1
+        void  NoteOff();                          // start the release
+        bool  IsActive() const;                   // false once silent
+        float Process();
+
+    IsActive() is usually the amplitude envelope's Adsr::IsRunning().
+    A voice sleeps from the sample its IsActive() goes false until its
+    next NoteOn(), and is not processed at all meanwhile, so the cost
+    follows what is sounding rather than N. Released voices keep running
+    their tails. GetActiveCount() is the number of voices awake after the
+    last Process, e.g. to log next to CpuLoadMeter.
+
+    NoteOn() reuses a voice already on that note, else a sleeping one,
+    else the oldest released one, and only then steals a held voice by
+    the StealPolicy.
+
+    With SetCycleCounter(), ProcessBlock() also times each voice's
+    render, e.g. with the DWT counter, so a Voice that switches between
+    engines shows what each is costing: GetVoiceCycles() for a voice and
+    GetCycles() for all of them, both for the last block.
+    StealPolicy::COSTLIEST then takes the held voice that cost the most,
+    and SetCycleBudget() lets NoteOn() steal, rather than wake another
+    voice, once the voices have reached the budget. It takes the
+    costliest released tail, else the costliest held voice, so a
+    ModalVoice goes before a Pluck and the callback keeps within its
+    period. Process() is not timed: two counter reads a voice per
+    sample would cost more than most voices.
+
+    declaration example:
+
+    VoiceAllocator<SynthVoice, 8> poly;
+    for(size_t i = 0; i < 8; i++)
+        poly.GetVoice(i).Init(sample_rate);
+    poly.Init();
+    ...
+    poly.NoteOn(60.f, 0.8f);
+    poly.ProcessBlock(out, size);
+
+    // CPU-aware stealing, with DAISY.CpuLoad() running the DWT counter.
+    poly.SetCycleCounter([]() -> uint32_t { return DWT->CYCCNT; });
+    poly.SetCycleBudget(DAISY.CpuLoad().GetPeriodCycles() * 7 / 10);
+    poly.SetStealPolicy(decltype(poly)::StealPolicy::COSTLIEST);
+*/
+template <class Voice, size_t num_voices>
+class VoiceAllocator
+{
+  public:
+    static const size_t kStateBytes;
+
+    VoiceAllocator() {}
+    ~VoiceAllocator() {}
+
+    /** Which held voice a NoteOn() takes once none is free or released */
+    enum class StealPolicy
+    {
+        OLDEST,  /**< the longest held */
+        LOWEST,  /**< the lowest note */
+        HIGHEST,   /**< the highest note */
+        COSTLIEST, /**< the most cycles last block, then the longest held */
+        NONE,      /**< none, the new note is dropped */
+    };
+
+    /** Reads a free-running cycle counter */
+    typedef uint32_t (*CycleCounter)();
+
+    /** Puts every voice to sleep. The voices themselves are initialized
+        through GetVoice() by the caller.
+        \param policy Voice stealing when all are held
+    */
+    void Init(StealPolicy policy = StealPolicy::OLDEST)
+    {
+        policy_     = policy;
+        clock_      = 0;
+        num_active_ = 0;
+        counter_    = nullptr;
+        budget_     = 0;
+        total_      = 0;
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            note_[i]   = 0.0f;
+            age_[i]    = 0;
+            cycles_[i] = 0;
+            held_[i]   = false;
+            active_[i] = false;
+        }
+    }
+
+    /** Starts a note on a voice chosen as described above.
+        \param note MIDI note number
+        \param velocity 0-1
+        \return the voice playing it, or nullptr if dropped
+    */
+    Voice* NoteOn(float note, float velocity)
+    {
+        const size_t i = Allocate(note);
+        if(i >= num_voices)
+            return nullptr;
+        voices_[i].NoteOn(note, velocity);
+        note_[i]   = note;
+        age_[i]    = ++clock_;
+        held_[i]   = true;
+        active_[i] = true;
+        return &voices_[i];
+    }
+
+    /** Releases every held voice on note; their tails keep sounding. */
+    void NoteOff(float note)
+    {
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(held_[i] && note_[i] == note)
+            {
+                voices_[i].NoteOff();
+                held_[i] = false;
+            }
+        }
+    }
+
+    /** Releases every held voice. */
+    void AllNotesOff()
+    {
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(held_[i])
+            {
+                voices_[i].NoteOff();
+                held_[i] = false;
+            }
+        }
+    }
+
+    /** Sums one sample of the voices that are awake. */
+    float Process()
+    {
+        float  sum    = 0.0f;
+        size_t active = 0;
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(active_[i])
+            {
+                sum += voices_[i].Process();
+                active_[i] = voices_[i].IsActive();
+                active += active_[i];
+            }
+        }
+        num_active_ = active;
+        return sum;
+    }
+
+    /** Fills out with the sum of the awake voices, the same as Process()
+        for each sample, running one voice over the block at a time, and
+        with a cycle counter set, timing each.
+    */
+    void ProcessBlock(float* out, size_t size)
+    {
+        for(size_t j = 0; j < size; j++)
+            out[j] = 0.0f;
+        size_t   active = 0;
+        uint32_t total  = 0;
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(!active_[i])
+            {
+                cycles_[i] = 0;
+                continue;
+            }
+            const uint32_t start = counter_ ? counter_() : 0;
+            Voice&         v     = voices_[i];
+            for(size_t j = 0; j < size && active_[i]; j++)
+            {
+                out[j] += v.Process();
+                active_[i] = v.IsActive();
+            }
+            if(counter_)
+            {
+                cycles_[i] = counter_() - start;
+                total += cycles_[i];
+            }
+            active += active_[i];
+        }
+        num_active_ = active;
+        total_      = total;
+    }
+
+    /** \return voices awake after the last Process / ProcessBlock */
+    inline size_t GetActiveCount() const { return num_active_; }
+
+    /** \return a voice, for Init() and per-voice settings */
+    inline Voice& GetVoice(size_t idx) { return voices_[idx]; }
+
+    /** Changes the stealing policy for later NoteOn() calls. */
+    inline void SetStealPolicy(StealPolicy policy) { policy_ = policy; }
+
+    /** Times each voice in ProcessBlock() with counter, or nothing with
+        nullptr, the default.
+    */
+    inline void SetCycleCounter(CycleCounter counter) { counter_ = counter; }
+
+    /** Once the last block's voices took budget cycles or more, NoteOn()
+        steals the costliest voice instead of waking one. 0, the default,
+        for no budget. Needs SetCycleCounter().
+    */
+    inline void SetCycleBudget(uint32_t budget) { budget_ = budget; }
+
+    /** \return cycles voice idx took in the last ProcessBlock(), 0 if
+        it slept through it or nothing is timed
+    */
+    inline uint32_t GetVoiceCycles(size_t idx) const { return cycles_[idx]; }
+
+    /** \return cycles all the voices took in the last ProcessBlock() */
+    inline uint32_t GetCycles() const { return total_; }
+
+  private:
+    size_t Allocate(float note) const
+    {
+        // Same note, then asleep.
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(active_[i] && note_[i] == note)
+                return i;
+        }
+        // Over budget, a costly voice makes way rather than adding one.
+        if(budget_ > 0 && total_ >= budget_)
+        {
+            size_t best = Costliest(false);
+            if(best == num_voices && policy_ != StealPolicy::NONE)
+                best = Costliest(true);
+            if(best < num_voices)
+                return best;
+        }
+
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(!active_[i])
+                return i;
+        }
+
+        // Oldest released tail.
+        size_t best = num_voices;
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(!held_[i] && (best == num_voices || age_[i] < age_[best]))
+                best = i;
+        }
+        if(best < num_voices || policy_ == StealPolicy::NONE)
+            return best;
+        if(policy_ == StealPolicy::COSTLIEST)
+            return Costliest(true);
+
+        // Every voice is held.
+        best = 0;
+        for(size_t i = 1; i < num_voices; i++)
+        {
+            switch(policy_)
+            {
+                case StealPolicy::LOWEST:
+                    if(note_[i] < note_[best])
+                        best = i;
+                    break;
+                case StealPolicy::HIGHEST:
+                    if(note_[i] > note_[best])
+                        best = i;
+                    break;
+                default:
+                    if(age_[i] < age_[best])
+                        best = i;
+                    break;
+            }
+        }
+        return best;
+    }
+
+    /** \return the awake voice, held or released, with the most cycles
+        last block, the older on a tie, or num_voices if there is none
+    */
+    size_t Costliest(bool held) const
+    {
+        size_t best = num_voices;
+        for(size_t i = 0; i < num_voices; i++)
+        {
+            if(!active_[i] || held_[i] != held)
+                continue;
+            if(best == num_voices || cycles_[i] > cycles_[best]
+               || (cycles_[i] == cycles_[best] && age_[i] < age_[best]))
+                best = i;
+        }
+        return best;
+    }
+
+    Voice        voices_[num_voices];
+    float        note_[num_voices];
+    uint32_t     age_[num_voices];    /**< NoteOn order, lower is older */
+    uint32_t     cycles_[num_voices]; /**< in the last ProcessBlock() */
+    bool         held_[num_voices];
+    bool         active_[num_voices];
+    uint32_t     clock_;
+    size_t       num_active_;
+    StealPolicy  policy_;
+    CycleCounter counter_;
+    uint32_t     budget_, total_;
+};
+
+template <class Voice, size_t num_voices>
+constexpr size_t VoiceAllocator<Voice, num_voices>::kStateBytes
+    = sizeof(VoiceAllocator<Voice, num_voices>);
+} // namespace daisysp
+#endif
+#endif
@@ -1,4 +1,5 @@
 #include "dsp.h"
+#include "fast_sin.h"
 #include "vosim.h"
 #include <math.h>
 
@@ -6,6 +7,7 @@ using namespace daisysp;
 
 void VosimOscillator::Init(float sample_rate)
 {
+    FastSin::Init();
     sample_rate_ = sample_rate;
 
     carrier_phase_   = 0.0f;
@@ -20,34 +22,50 @@ void VosimOscillator::Init(float sample_rate)
 
 float VosimOscillator::Process()
 {
-    carrier_phase_ += carrier_frequency_;
-    if(carrier_phase_ >= 1.0f)
-    {
-        carrier_phase_ -= 1.0f;
-        float reset_time = carrier_phase_ / carrier_frequency_;
-        formant_1_phase_ = reset_time * formant_1_frequency_;
-        formant_2_phase_ = reset_time * formant_2_frequency_;
-    }
-    else
+    float out;
+    ProcessBlock(&out, 1);
+    return out;
+}
+
+void VosimOscillator::ProcessBlock(float *out, size_t size)
+{
+    const float carrier_frequency   = carrier_frequency_;
+    const float formant_1_frequency = formant_1_frequency_;
+    const float formant_2_frequency = formant_2_frequency_;
+    const float reset_phase         = reset_phase_;
+    const float reset_amplitude     = reset_amplitude_;
+
+    float carrier_phase   = carrier_phase_;
+    float formant_1_phase = formant_1_phase_;
+    float formant_2_phase = formant_2_phase_;
+
+    for(size_t i = 0; i < size; i++)
     {
-        formant_1_phase_ += formant_1_frequency_;
-        if(formant_1_phase_ >= 1.0f)
+        carrier_phase += carrier_frequency;
+        if(carrier_phase >= 1.0f)
         {
-            formant_1_phase_ -= 1.0f;
+            carrier_phase -= 1.0f;
+            float reset_time = carrier_phase / carrier_frequency;
+            formant_1_phase  = reset_time * formant_1_frequency;
+            formant_2_phase  = reset_time * formant_2_frequency;
         }
-        formant_2_phase_ += formant_2_frequency_;
-        if(formant_2_phase_ >= 1.0f)
+        else
         {
-            formant_2_phase_ -= 1.0f;
+            formant_1_phase += formant_1_frequency;
+            formant_1_phase -= formant_1_phase >= 1.0f ? 1.0f : 0.0f;
+            formant_2_phase += formant_2_frequency;
+            formant_2_phase -= formant_2_phase >= 1.0f ? 1.0f : 0.0f;
         }
+
+        float carrier   = Sine(carrier_phase * 0.5f + 0.25f) + 1.0f;
+        float formant_0 = Sine(formant_1_phase + reset_phase) - reset_amplitude;
+        float formant_1 = Sine(formant_2_phase + reset_phase) - reset_amplitude;
+        out[i] = carrier * (formant_0 + formant_1) * 0.25f + reset_amplitude;
     }
 
-    float carrier         = Sine(carrier_phase_ * 0.5f + 0.25f) + 1.0f;
-    float reset_phase     = 0.75f - 0.25f * carrier_shape_;
-    float reset_amplitude = Sine(reset_phase);
-    float formant_0 = Sine(formant_1_phase_ + reset_phase) - reset_amplitude;
-    float formant_1 = Sine(formant_2_phase_ + reset_phase) - reset_amplitude;
-    return carrier * (formant_0 + formant_1) * 0.25f + reset_amplitude;
+    carrier_phase_   = carrier_phase;
+    formant_1_phase_ = formant_1_phase;
+    formant_2_phase_ = formant_2_phase;
 }
 
 void VosimOscillator::SetFreq(float freq)
@@ -72,10 +90,12 @@ void VosimOscillator::SetForm2Freq(float freq)
 
 void VosimOscillator::SetShape(float shape)
 {
-    carrier_shape_ = shape;
+    carrier_shape_   = shape;
+    reset_phase_     = 0.75f - 0.25f * carrier_shape_;
+    reset_amplitude_ = Sine(reset_phase_);
 }
 
 float VosimOscillator::Sine(float phase)
 {
-    return sinf(TWOPI_F * phase);
+    return FastSin::Sin(phase);
 }
\ No newline at end of file
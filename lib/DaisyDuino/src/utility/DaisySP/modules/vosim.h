@@ -3,6 +3,7 @@
 #define DSY_VOSIM_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file vosim.h */
@@ -17,10 +18,16 @@ namespace daisysp
 	   Ported from pichenettes/eurorack/plaits/dsp/oscillator/vosim_oscillator.h \n 
 	   \n to an independent module. \n
 	   Original code written by Emilie Gillet in 2016. \n
+
+       The formants' reset level is worked out in SetShape(), so a sample
+       is three FastSin lookups; ProcessBlock() keeps the phases in
+       registers across the block.
 */
 class VosimOscillator
 {
   public:
+    static const size_t kStateBytes;
+
     VosimOscillator() {}
     ~VosimOscillator() {}
 
@@ -33,6 +40,9 @@ class VosimOscillator
     */
     float Process();
 
+    /** Processes a block, the same as Process() on each sample. */
+    void ProcessBlock(float *out, size_t size);
+
     /** Set carrier frequency.
         \param freq Frequency in Hz.
     */
@@ -68,7 +78,13 @@ class VosimOscillator
     float formant_1_frequency_;
     float formant_2_frequency_;
     float carrier_shape_;
+
+    // From the shape.
+    float reset_phase_;
+    float reset_amplitude_;
 };
+
+inline constexpr size_t VosimOscillator::kStateBytes = sizeof(VosimOscillator);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,308 @@
+#pragma once
+#ifndef DSY_WAVESHAPER_H
+#define DSY_WAVESHAPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dsp.h"
+#include "halfband.h"
+#ifdef __cplusplus
+
+/** @file waveshaper.h */
+
+namespace daisysp
+{
+/** @brief Transfer curves for Waveshaper.
+
+    A curve is any type with a const Shape(float) member; stateless ones
+    are empty structs, QuantizeCurve carries its step. None of them call
+    libm or divide.
+*/
+/** Clamp to [-1, 1] */
+struct HardClipCurve
+{
+    inline float Shape(float x) const { return fclamp(x, -1.f, 1.f); }
+};
+
+/** x - 4/27 x^3 on [-1.5, 1.5], flat at +-1 outside: smooth to the first
+    derivative, only a third harmonic below the knee.
+*/
+struct CubicClipCurve
+{
+    inline float Shape(float x) const
+    {
+        x = fclamp(x, -1.5f, 1.5f);
+        return x - 0.148148148f * x * x * x;
+    }
+};
+
+/** Triangle wavefolder: +-1 folds back at every odd integer, so 0 maps
+    to 0 and a growing input folds over and over.
+*/
+struct TriangleFoldCurve
+{
+    inline float Shape(float x) const
+    {
+        // x / 4 + 1 / 4, wrapped to [0, 1) without floorf.
+        float       t = x * 0.25f + 0.25f;
+        const float w = t - static_cast<float>(static_cast<int32_t>(t));
+        t             = w < 0.f ? w + 1.f : w;
+        return 1.f - 4.f * fabsf(t - 0.5f);
+    }
+};
+
+/** Rounds to 2^bits levels over [-1, 1], the Bitcrush quantizer without
+    its rate reduction; oversampling removes most of its aliasing.
+*/
+class QuantizeCurve
+{
+  public:
+    static const size_t kStateBytes;
+
+    /** \param bits 1 to 24 */
+    inline void SetBits(int bits)
+    {
+        bits   = bits < 1 ? 1 : (bits > 24 ? 24 : bits);
+        scale_ = static_cast<float>(1ul << (bits - 1));
+        step_  = 1.f / scale_;
+    }
+
+    inline float Shape(float x) const
+    {
+        const float q = x * scale_;
+        return static_cast<float>(
+                   static_cast<int32_t>(q + (q < 0.f ? -.5f : .5f)))
+               * step_;
+    }
+
+  private:
+    float scale_ = 32768.f, step_ = 1.f / 32768.f;
+};
+
+inline constexpr size_t QuantizeCurve::kStateBytes = sizeof(QuantizeCurve);
+
+/** The SoftClip() of dsp.h as a constexpr function, for LutCurve. */
+struct SoftClipFunction
+{
+    static constexpr float kRange = 3.f;
+    static constexpr float Eval(float x)
+    {
+        return x < -3.f ? -1.f
+                        : (x > 3.f ? 1.f
+                                   : x * (27.f + x * x) / (27.f + 9.f * x * x));
+    }
+};
+
+/** Any constexpr curve as a table built at compile time, in flash, read
+    with linear interpolation; flat at Fn::Eval(+-Fn::kRange) beyond.
+    \param Fn Type with static constexpr Eval(float) and kRange
+    \param size Intervals over [-kRange, kRange]
+*/
+template <typename Fn, size_t size = 256>
+struct LutCurve
+{
+    inline float Shape(float x) const
+    {
+        const float t = (fclamp(x, -Fn::kRange, Fn::kRange) + Fn::kRange)
+                        * kScale;
+        const size_t idx  = static_cast<size_t>(t);
+        const float  frac = t - static_cast<float>(idx);
+        const float  a    = kTable.v[idx];
+        return a + (kTable.v[idx + 1] - a) * frac;
+    }
+
+  private:
+    static constexpr float kScale = size / (2.f * Fn::kRange);
+
+    // One guard entry past kRange, for t == size.
+    struct Table
+    {
+        float v[size + 2];
+    };
+    static constexpr Table Build()
+    {
+        Table t{};
+        for(size_t i = 0; i <= size; i++)
+        {
+            t.v[i] = Fn::Eval(-Fn::kRange + static_cast<float>(i) / kScale);
+        }
+        t.v[size + 1] = t.v[size];
+        return t;
+    }
+    static constexpr Table kTable = Build();
+};
+
+/** Overdrive's curve without the division. Within 6e-5 of SoftClip(). */
+using SoftClipLutCurve = LutCurve<SoftClipFunction, 256>;
+
+/** @brief Oversampled waveshaper: gain, curve at os times the rate, gain.
+
+    Each block is interpolated with the Upsampler2x polyphase half-bands
+    (twice for 4x), put through the curve at the high rate and decimated
+    back with Downsampler2x, so the harmonics the curve makes above the
+    base Nyquist are filtered out instead of folding back. Gains are
+    linear, so they are applied at the base rate.
+
+    The first 2x stage uses a taps-long half-band; the second stage of
+    4x only has to reject images above three quarters of its rate and
+    gets by with 11. Each 2x stage costs about (taps + 1) / 2 MACs per
+    sample each way. With os = 1 there are no filters at all, and a
+    LutCurve is a clamp, a lookup and a lerp: a fraction of Overdrive's
+    per-sample SoftClip() division and call.
+
+    Use it in place of Overdrive with Overdrive's own gains:
+
+    Waveshaper<SoftClipLutCurve, 2> drive;
+    Overdrive od;
+    drive.Init();
+    od.SetDrive(.6f);
+    drive.SetGains(od.GetPreGain(), od.GetPostGain());
+    ...
+    drive.ProcessBlock(in[0], out[0], size);
+
+    \param Curve Transfer curve type, see above
+    \param os Oversampling factor, 1, 2 or 4
+    \param taps First half-band length, 4M - 1
+    \param max_block Largest block processed in one go; longer ones are
+                     split
+*/
+template <typename Curve, size_t os = 2, size_t taps = 19, size_t max_block = 48>
+class Waveshaper
+{
+  public:
+    static const size_t kStateBytes;
+
+    static_assert(os == 1 || os == 2 || os == 4, "os must be 1, 2 or 4");
+
+    Waveshaper() {}
+    ~Waveshaper() {}
+
+    /** Designs the filters, clears them, unity gains. Setup only. */
+    void Init()
+    {
+        up1_.Init();
+        down1_.Init();
+        up2_.Init();
+        down2_.Init();
+        pre_  = 1.f;
+        post_ = 1.f;
+    }
+
+    /** Clears the filter state. */
+    void Reset()
+    {
+        up1_.Reset();
+        down1_.Reset();
+        up2_.Reset();
+        down2_.Reset();
+    }
+
+    /** \param pre Gain into the curve
+        \param post Gain out of it
+    */
+    inline void SetGains(float pre, float post)
+    {
+        pre_  = pre;
+        post_ = post;
+    }
+
+    /** The curve, for curves with settings such as QuantizeCurve */
+    inline Curve& GetCurve() { return curve_; }
+
+    /** \return delay of the filters in base-rate samples */
+    static constexpr float GetLatency()
+    {
+        return os == 1 ? 0.f
+                       : (os == 2 ? (2.f * First::kCenter) / 2.f
+                                  : (2.f * First::kCenter) / 2.f
+                                        + (2.f * Second::kCenter) / 4.f);
+    }
+
+    /** Shapes a block.
+        \param in Input samples
+        \param out Output samples, may be in
+        \param size Number of samples
+    */
+    void ProcessBlock(const float* in, float* out, size_t size)
+    {
+        for(size_t pos = 0; pos < size; pos += max_block)
+        {
+            const size_t n = size - pos < max_block ? size - pos : max_block;
+            ProcessChunk(in + pos, out + pos, n);
+        }
+    }
+
+    /** One sample; with os > 1 this runs the filters a sample at a time,
+        ProcessBlock() is much cheaper.
+    */
+    inline float Process(float in)
+    {
+        float out;
+        ProcessChunk(&in, &out, 1);
+        return out;
+    }
+
+  private:
+    static constexpr size_t kSecondTaps = 11;
+    using First                         = HalfbandDesign<taps>;
+    using Second                        = HalfbandDesign<kSecondTaps>;
+
+    void ProcessChunk(const float* in, float* out, size_t n)
+    {
+        const float pre  = pre_;
+        const float post = post_;
+        if constexpr(os == 1)
+        {
+            for(size_t i = 0; i < n; i++)
+            {
+                out[i] = curve_.Shape(in[i] * pre) * post;
+            }
+            return;
+        }
+
+        for(size_t i = 0; i < n; i++)
+        {
+            base_[i] = in[i] * pre;
+        }
+        float* hi = os == 2 ? hi_ : mid_;
+        up1_.ProcessBlock(base_, hi, n);
+        if constexpr(os == 4)
+        {
+            up2_.ProcessBlock(mid_, hi_, 2 * n);
+        }
+        for(size_t i = 0; i < os * n; i++)
+        {
+            hi_[i] = curve_.Shape(hi_[i]);
+        }
+        if constexpr(os == 4)
+        {
+            down2_.ProcessBlock(hi_, mid_, 2 * n);
+        }
+        down1_.ProcessBlock(hi, out, n);
+        for(size_t i = 0; i < n; i++)
+        {
+            out[i] *= post;
+        }
+    }
+
+    // Stages that are not used collapse to one-sample buffers.
+    static constexpr size_t kFirstBlock  = os > 1 ? max_block : 1;
+    static constexpr size_t kSecondBlock = os == 4 ? 2 * max_block : 1;
+
+    Curve                                    curve_;
+    float                                    pre_, post_;
+    Upsampler2x<taps, kFirstBlock>           up1_;
+    Downsampler2x<taps, kFirstBlock>         down1_;
+    Upsampler2x<kSecondTaps, kSecondBlock>   up2_;
+    Downsampler2x<kSecondTaps, kSecondBlock> down2_;
+    float                                    base_[kFirstBlock];
+    float                                    mid_[kSecondBlock];
+    float                                    hi_[os * max_block];
+};
+
+template <typename Curve, size_t os, size_t taps, size_t max_block>
+constexpr size_t Waveshaper<Curve, os, taps, max_block>::kStateBytes
+    = sizeof(Waveshaper<Curve, os, taps, max_block>);
+} // namespace daisysp
+#endif
+#endif
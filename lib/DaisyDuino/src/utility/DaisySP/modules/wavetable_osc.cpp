@@ -0,0 +1,167 @@
+#include <math.h>
+#include <string.h>
+#include "wavetable_osc.h"
+
+using namespace daisysp;
+
+void Wavetable::Init(float *storage)
+{
+    data_ = storage;
+    memset(data_, 0, kStorageSize * sizeof(float));
+}
+
+void Wavetable::BuildHarmonics(const float *amps, size_t count)
+{
+    // Nco's table hits every multiple of 1/1024 cycle exactly, so each
+    // harmonic is read without interpolation.
+    Nco::InitTable();
+    if(count > kMaxHarmonics)
+        count = kMaxHarmonics;
+
+    // Thinnest mip first; each richer one is the previous plus the
+    // harmonics of the next octave up.
+    size_t done = 0;
+    for(size_t m = kNumMips; m-- > 0;)
+    {
+        float *      mip = data_ + m * kMipSize;
+        const size_t top = kMaxHarmonics >> m;
+        if(m + 1 < kNumMips)
+            memcpy(mip, mip + kMipSize, kTableSize * sizeof(float));
+        else
+            memset(mip, 0, kTableSize * sizeof(float));
+        for(size_t k = done + 1; k <= top && k <= count; k++)
+        {
+            const float    amp  = amps[k - 1];
+            const uint32_t step = static_cast<uint32_t>(k) << (32 - kTableBits);
+            if(amp == 0.0f)
+                continue;
+            uint32_t phase = 0;
+            for(size_t i = 0; i < kTableSize; i++)
+            {
+                mip[i] += amp * Nco::Sin(phase);
+                phase += step;
+            }
+        }
+        done = top;
+    }
+
+    float peak = 0.0f;
+    for(size_t i = 0; i < kStorageSize; i++)
+    {
+        const float a = fabsf(data_[i]);
+        peak          = a > peak ? a : peak;
+    }
+    const float scale = peak > 0.0f ? 1.0f / peak : 0.0f;
+    for(size_t m = 0; m < kNumMips; m++)
+    {
+        float *mip = data_ + m * kMipSize;
+        for(size_t i = 0; i < kTableSize; i++)
+            mip[i] *= scale;
+        mip[kTableSize] = mip[0];
+    }
+}
+
+void Wavetable::BuildSaw()
+{
+    float amps[kMaxHarmonics];
+    for(size_t k = 1; k <= kMaxHarmonics; k++)
+        amps[k - 1] = 1.0f / static_cast<float>(k);
+    BuildHarmonics(amps, kMaxHarmonics);
+}
+
+void Wavetable::BuildSquare()
+{
+    float amps[kMaxHarmonics];
+    for(size_t k = 1; k <= kMaxHarmonics; k++)
+        amps[k - 1] = (k & 1) ? 1.0f / static_cast<float>(k) : 0.0f;
+    BuildHarmonics(amps, kMaxHarmonics);
+}
+
+void Wavetable::BuildTriangle()
+{
+    float amps[kMaxHarmonics];
+    for(size_t k = 1; k <= kMaxHarmonics; k++)
+    {
+        const float a = 1.0f / static_cast<float>(k * k);
+        amps[k - 1]   = (k & 1) ? ((k & 2) ? -a : a) : 0.0f;
+    }
+    BuildHarmonics(amps, kMaxHarmonics);
+}
+
+void Wavetable::CopyFrom(const Wavetable &src)
+{
+    memcpy(data_, src.data_, kStorageSize * sizeof(float));
+}
+
+void WavetableOsc::Init(float sample_rate, const Wavetable *table)
+{
+    sample_rate_ = sample_rate;
+    table_       = table;
+    amp_         = 0.5f;
+    phase_       = 0;
+    SetFreq(100.0f);
+}
+
+void WavetableOsc::SetTable(const Wavetable *table)
+{
+    table_ = table;
+    UpdateMips();
+}
+
+void WavetableOsc::SetFreq(float freq)
+{
+    phase_inc_ = Nco::FreqToPhaseInc(freq, sample_rate_);
+    UpdateMips();
+}
+
+void WavetableOsc::Reset(float phase)
+{
+    phase -= floorf(phase);
+    if(phase >= 1.0f) // -tiny wraps to 1.0f
+        phase = 0.0f;
+    phase_ = static_cast<uint32_t>(phase * 4294967296.0f);
+}
+
+void WavetableOsc::UpdateMips()
+{
+    // Octave position x = log2(|inc| * 512), mip m being alias-free for
+    // x <= m. Piecewise-linear log2 from the float's exponent: exact at
+    // each octave, monotonic between, which is all the crossfade needs.
+    const int32_t inc = static_cast<int32_t>(phase_inc_);
+    const float   mag = fabsf(static_cast<float>(inc))
+                      * (1.0f / static_cast<float>(1u << 23));
+    int         e;
+    const float mant = frexpf(mag, &e); // mag = mant * 2^e, mant in [0.5, 1)
+    const int   oct  = e - 1;           // floor(x)
+    const float frac = mant * 2.0f - 1.0f;
+
+    // Crossfade the first alias-free mip, oct + 1, into the next one.
+    const int last = static_cast<int>(Wavetable::kNumMips) - 1;
+    int       lo   = oct + 1;
+    mix_           = frac;
+    if(mag == 0.0f || lo < 0)
+    {
+        lo   = 0;
+        mix_ = 0.0f;
+    }
+    else if(lo >= last)
+    {
+        lo   = last;
+        mix_ = 0.0f;
+    }
+    lo_ = table_->Mip(static_cast<size_t>(lo));
+    hi_ = table_->Mip(static_cast<size_t>(lo < last ? lo + 1 : last));
+}
+
+void WavetableOsc::ProcessBlock(float *out, size_t size)
+{
+    uint32_t       phase = phase_;
+    const uint32_t inc   = phase_inc_;
+    const float    amp   = amp_;
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = Read(phase) * amp;
+        phase += inc;
+    }
+    phase_ = phase;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#ifndef DSY_WAVETABLE_OSC_H
+#define DSY_WAVETABLE_OSC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "nco.h"
+#ifdef __cplusplus
+
+/** Memory section for a Wavetable used as a cache of the active table.
+    Defaults to DTCM on ARM, as for the Nco sine table.
+    Define before including daisysp.h to override.
+*/
+#ifndef DSY_WAVETABLE_CACHE_SECTION
+#if defined(__arm__)
+#define DSY_WAVETABLE_CACHE_SECTION __attribute__((section(".dtcmram_bss")))
+#else
+#define DSY_WAVETABLE_CACHE_SECTION
+#endif
+#endif
+
+namespace daisysp
+{
+/** One single-cycle waveform as a chain of octave mip-maps.
+
+    Mip m holds harmonics 1 to 256 >> m (mip 0: 256, mip 8: the sine),
+    each 1024 samples plus a guard point, so every mip is oversampled at
+    least 4x for the linear interpolation. Mip m is alias-free up to a
+    fundamental of 2^m * sample_rate / 512.
+
+    The storage is the caller's, kStorageSize floats. Keep the built
+    tables in SDRAM and copy the ones voices are playing into a DTCM
+    Wavetable with CopyFrom(); both are used the same way.
+
+    The tables are scaled together to a peak of 1, so switching mips
+    does not change the level. Building is setup work, never the ISR.
+
+    declaration example:
+
+    float DSY_SDRAM_BSS saw_mem[Wavetable::kStorageSize];
+    float DSY_WAVETABLE_CACHE_SECTION cache_mem[Wavetable::kStorageSize];
+    Wavetable saw, cache;
+    saw.Init(saw_mem);
+    saw.BuildSaw();
+    cache.Init(cache_mem);
+    cache.CopyFrom(saw);
+*/
+class Wavetable
+{
+  public:
+    static const size_t kStateBytes;
+
+    Wavetable() {}
+    ~Wavetable() {}
+
+    static constexpr size_t kTableBits    = 10;
+    static constexpr size_t kTableSize    = 1u << kTableBits;
+    static constexpr size_t kMipSize      = kTableSize + 1;
+    static constexpr size_t kNumMips      = 9;
+    static constexpr size_t kMaxHarmonics = 256;
+    static constexpr size_t kStorageSize  = kNumMips * kMipSize;
+
+    /** Sets the storage and clears it to silence.
+        \param storage - kStorageSize floats, kept in global space
+    */
+    void Init(float *storage);
+
+    /** Builds the mips from harmonic sine amplitudes.
+        \param amps - amps[k] is the amplitude of harmonic k + 1
+        \param count - number of amplitudes, above kMaxHarmonics ignored
+    */
+    void BuildHarmonics(const float *amps, size_t count);
+
+    /** Falling band-limited saw, as Oscillator's WAVE_POLYBLEP_SAW */
+    void BuildSaw();
+
+    /** Band-limited square */
+    void BuildSquare();
+
+    /** Band-limited triangle */
+    void BuildTriangle();
+
+    /** Copies src's mips into this storage, e.g. SDRAM into DTCM. */
+    void CopyFrom(const Wavetable &src);
+
+    /** Returns mip m, kMipSize samples. */
+    inline const float *Mip(size_t m) const { return data_ + m * kMipSize; }
+
+  private:
+    float *data_;
+};
+
+inline constexpr size_t Wavetable::kStateBytes = sizeof(Wavetable);
+
+/** Wavetable oscillator over a mip-mapped Wavetable.
+
+    The mips are chosen from the phase increment at SetFreq(): the
+    output is a crossfade of the two lowest mips that are alias-free at
+    that pitch, richer to thinner across each octave, so brightness
+    moves continuously with the frequency and nothing folds over. The
+    per-sample cost is two interpolated reads, no libm and no branches.
+
+    The phase is an unsigned 32-bit accumulator as for Nco.
+*/
+class WavetableOsc
+{
+  public:
+    static const size_t kStateBytes;
+
+    WavetableOsc() {}
+    ~WavetableOsc() {}
+
+    /** Initializes the oscillator at 100 Hz, amplitude 0.5, phase 0.
+        \param sample_rate - rate at which Process() / ProcessBlock() run
+        \param table - built Wavetable to play, may be changed later
+    */
+    void Init(float sample_rate, const Wavetable *table);
+
+    /** Sets the table to play, keeping the phase. */
+    void SetTable(const Wavetable *table);
+
+    /** Sets the frequency in Hz and picks the mips for it. */
+    void SetFreq(float freq);
+
+    /** Sets the amplitude, 1.0 for the table's full scale. */
+    inline void SetAmp(float amp) { amp_ = amp; }
+
+    /** Resets the phase, 0.0-1.0 of a cycle. */
+    void Reset(float phase = 0.0f);
+
+    /** Generates one sample and advances the phase. */
+    inline float Process()
+    {
+        const float s = Read(phase_);
+        phase_ += phase_inc_;
+        return s * amp_;
+    }
+
+    /** Generates size samples, the same as Process() for each. */
+    void ProcessBlock(float *out, size_t size);
+
+  private:
+    static constexpr uint32_t kFracBits = 32 - Wavetable::kTableBits;
+    static constexpr uint32_t kFracMask = (1u << kFracBits) - 1u;
+    static constexpr float    kFracScale
+        = 1.0f / static_cast<float>(1u << kFracBits);
+
+    inline float Read(uint32_t phase) const
+    {
+        const uint32_t idx  = phase >> kFracBits;
+        const float    frac = static_cast<float>(phase & kFracMask) * kFracScale;
+        const float    a    = lo_[idx] + (lo_[idx + 1] - lo_[idx]) * frac;
+        const float    b    = hi_[idx] + (hi_[idx + 1] - hi_[idx]) * frac;
+        return a + (b - a) * mix_;
+    }
+
+    void UpdateMips();
+
+    const Wavetable *table_;
+    const float *    lo_, *hi_; /**< mips crossfaded from lo_ to hi_ */
+    float            sample_rate_, amp_, mix_;
+    uint32_t         phase_, phase_inc_;
+};
+
+inline constexpr size_t WavetableOsc::kStateBytes = sizeof(WavetableOsc);
+
+} // namespace daisysp
+#endif
+#endif
@@ -2,42 +2,54 @@
 #ifndef DSY_WHITENOISE_H
 #define DSY_WHITENOISE_H
 #include <stdint.h>
+#include <stddef.h>
+#include "fast_random.h"
 #ifdef __cplusplus
 namespace daisysp
 {
 /** fast white noise generator
 
-    I think this came from musicdsp.org at some point
+    Uniform noise from FastRandom; each instance gets its own seed.
 */
 class WhiteNoise
 {
   public:
+    static const size_t kStateBytes;
+
     WhiteNoise() {}
     ~WhiteNoise() {}
     /** Initializes the WhiteNoise object
     */
     void Init()
     {
-        amp_      = 1.0f;
-        randseed_ = 1;
+        amp_ = 1.0f;
+        rng_.Init();
     }
 
+    /** Restarts the noise from a given seed, for repeatable output.
+    */
+    inline void SetSeed(uint32_t seed) { rng_.Init(seed); }
+
     /** sets the amplitude of the noise output
     */
     inline void SetAmp(float a) { amp_ = a; }
     /** returns a new sample of noise in the range of -amp_ to amp_
     */
-    inline float Process()
+    inline float Process() { return rng_.NextBipolar() * amp_; }
+
+    /** fills out with size samples of noise, four per iteration
+    */
+    inline void FillBlock(float *out, size_t size)
     {
-        randseed_ *= 16807;
-        return (randseed_ * coeff_) * amp_;
+        rng_.FillBlock(out, size, amp_);
     }
 
   private:
-    static constexpr float coeff_ = 4.6566129e-010f;
-    float                  amp_;
-    int32_t                randseed_;
+    float      amp_;
+    FastRandom rng_;
 };
+
+inline constexpr size_t WhiteNoise::kStateBytes = sizeof(WhiteNoise);
 } // namespace daisysp
 #endif
 #endif
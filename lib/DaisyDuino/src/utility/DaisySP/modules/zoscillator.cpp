@@ -1,4 +1,5 @@
 #include "dsp.h"
+#include "fast_sin.h"
 #include "zoscillator.h"
 #include <math.h>
 
@@ -6,6 +7,7 @@ using namespace daisysp;
 
 void ZOscillator::Init(float sample_rate)
 {
+    FastSin::Init();
     sample_rate_ = sample_rate;
 
     carrier_phase_       = 0.0f;
@@ -91,7 +93,7 @@ float ZOscillator::Process()
 
 inline float ZOscillator::Sine(float phase)
 {
-    return sinf(phase * TWOPI_F);
+    return FastSin::Sin(phase);
 }
 
 void ZOscillator::SetFreq(float freq)
@@ -3,6 +3,7 @@
 #define DSY_ZOSCILLATOR_H
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef __cplusplus
 
 /** @file zoscillator.h */
@@ -20,6 +21,8 @@ namespace daisysp
 class ZOscillator
 {
   public:
+    static const size_t kStateBytes;
+
     ZOscillator() {}
     ~ZOscillator() {}
 
@@ -71,6 +74,8 @@ class ZOscillator
     float carrier_shape_, shape_new_;
     float mode_, mode_new_;
 };
+
+inline constexpr size_t ZOscillator::kStateBytes = sizeof(ZOscillator);
 } // namespace daisysp
 #endif
 #endif
\ No newline at end of file
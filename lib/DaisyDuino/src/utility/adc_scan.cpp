@@ -0,0 +1,147 @@
+#include "adc_scan.h"
+#include "daisy_core.h"
+#include <stm32h7xx_hal.h>
+
+using namespace daisy;
+
+static ADC_HandleTypeDef adc_scan_adc;
+static DMA_HandleTypeDef adc_scan_dma;
+
+// Written by the DMA only; uncached, so reads see the latest results.
+static volatile uint16_t DMA_BUFFER_MEM_SECTION
+    adc_scan_buffer[AdcScan::kMaxPins];
+
+static const uint32_t kRanks[AdcScan::kMaxPins] = {
+    ADC_REGULAR_RANK_1,  ADC_REGULAR_RANK_2,  ADC_REGULAR_RANK_3,
+    ADC_REGULAR_RANK_4,  ADC_REGULAR_RANK_5,  ADC_REGULAR_RANK_6,
+    ADC_REGULAR_RANK_7,  ADC_REGULAR_RANK_8,  ADC_REGULAR_RANK_9,
+    ADC_REGULAR_RANK_10, ADC_REGULAR_RANK_11, ADC_REGULAR_RANK_12,
+    ADC_REGULAR_RANK_13, ADC_REGULAR_RANK_14, ADC_REGULAR_RANK_15,
+    ADC_REGULAR_RANK_16,
+};
+
+// Right shift that keeps an oversampled sum at 16 bits, by ratio log2.
+static const uint32_t kShifts[] = {
+    ADC_RIGHTBITSHIFT_NONE,
+    ADC_RIGHTBITSHIFT_1,
+    ADC_RIGHTBITSHIFT_2,
+    ADC_RIGHTBITSHIFT_3,
+    ADC_RIGHTBITSHIFT_4,
+    ADC_RIGHTBITSHIFT_5,
+    ADC_RIGHTBITSHIFT_6,
+};
+
+int AdcScan::AddPin(uint32_t pin)
+{
+    if(running_ || num_pins_ >= kMaxPins)
+        return -1;
+    const PinName name = digitalPinToPinName(pin);
+    if(pinmap_peripheral(name, PinMap_ADC) != ADC1)
+        return -1;
+    const uint32_t function = pinmap_function(name, PinMap_ADC);
+    channels_[num_pins_]
+        = __LL_ADC_DECIMAL_NB_TO_CHANNEL(STM_PIN_CHANNEL(function));
+    pinmap_pinout(name, PinMap_ADC);
+    adc_scan_buffer[num_pins_] = 0;
+    return static_cast<int>(num_pins_++);
+}
+
+bool AdcScan::Start(Oversample ovs)
+{
+    if(num_pins_ == 0 || running_)
+        return false;
+
+    __HAL_RCC_ADC12_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    const uint32_t ovs_log2 = static_cast<uint32_t>(ovs);
+
+    ADC_HandleTypeDef* hadc        = &adc_scan_adc;
+    hadc->Instance                 = ADC1;
+    hadc->Init.ClockPrescaler      = ADC_CLOCK_SYNC_PCLK_DIV4;
+    hadc->Init.Resolution          = ADC_RESOLUTION_16B;
+    hadc->Init.ScanConvMode        = ADC_SCAN_ENABLE;
+    hadc->Init.EOCSelection        = ADC_EOC_SEQ_CONV;
+    hadc->Init.LowPowerAutoWait    = DISABLE;
+    hadc->Init.ContinuousConvMode  = ENABLE;
+    hadc->Init.NbrOfConversion     = num_pins_;
+    hadc->Init.DiscontinuousConvMode = DISABLE;
+    hadc->Init.ExternalTrigConv      = ADC_SOFTWARE_START;
+    hadc->Init.ExternalTrigConvEdge  = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc->Init.ConversionDataManagement = ADC_CONVERSIONDATA_DMA_CIRCULAR;
+    hadc->Init.Overrun                  = ADC_OVR_DATA_OVERWRITTEN;
+    hadc->Init.LeftBitShift             = ADC_LEFTBITSHIFT_NONE;
+    hadc->Init.OversamplingMode         = ovs_log2 > 0 ? ENABLE : DISABLE;
+    hadc->Init.Oversampling.Ratio       = 1u << ovs_log2;
+    hadc->Init.Oversampling.RightBitShift = kShifts[ovs_log2];
+    hadc->Init.Oversampling.TriggeredMode
+        = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+    hadc->Init.Oversampling.OversamplingStopReset
+        = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+    if(HAL_ADC_Init(hadc) != HAL_OK)
+        return false;
+
+    ADC_ChannelConfTypeDef channel = {};
+    channel.SamplingTime           = ADC_SAMPLETIME_64CYCLES_5;
+    channel.SingleDiff             = ADC_SINGLE_ENDED;
+    channel.OffsetNumber           = ADC_OFFSET_NONE;
+    channel.Offset                 = 0;
+    for(size_t i = 0; i < num_pins_; i++)
+    {
+        channel.Channel = channels_[i];
+        channel.Rank    = kRanks[i];
+        if(HAL_ADC_ConfigChannel(hadc, &channel) != HAL_OK)
+            return false;
+    }
+
+    DMA_HandleTypeDef* hdma        = &adc_scan_dma;
+    hdma->Instance                 = DMA1_Stream2;
+    hdma->Init.Request             = DMA_REQUEST_ADC1;
+    hdma->Init.Direction           = DMA_PERIPH_TO_MEMORY;
+    hdma->Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma->Init.MemInc              = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma->Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+    hdma->Init.Mode                = DMA_CIRCULAR;
+    hdma->Init.Priority            = DMA_PRIORITY_LOW;
+    hdma->Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+    if(HAL_DMA_Init(hdma) != HAL_OK)
+        return false;
+    __HAL_LINKDMA(hadc, DMA_Handle, *hdma);
+
+    if(HAL_ADCEx_Calibration_Start(
+           hadc, ADC_CALIB_OFFSET_LINEARITY, ADC_SINGLE_ENDED)
+       != HAL_OK)
+        return false;
+    if(HAL_ADC_Start_DMA(hadc,
+                         (uint32_t*)(uintptr_t)adc_scan_buffer,
+                         static_cast<uint32_t>(num_pins_))
+       != HAL_OK)
+        return false;
+
+    // Nothing to do per sequence: only transfer errors interrupt.
+    __HAL_DMA_DISABLE_IT(hdma, DMA_IT_HT | DMA_IT_TC);
+    __HAL_ADC_DISABLE_IT(hadc, ADC_IT_OVR);
+    running_ = true;
+    return true;
+}
+
+void AdcScan::Stop()
+{
+    if(!running_)
+        return;
+    HAL_ADC_Stop_DMA(&adc_scan_adc);
+    running_ = false;
+}
+
+uint16_t AdcScan::Raw(int slot) const
+{
+    return slot >= 0 && static_cast<size_t>(slot) < num_pins_
+               ? adc_scan_buffer[slot]
+               : 0;
+}
+
+extern "C" void DMA1_Stream2_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&adc_scan_dma);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef DSY_ADC_SCAN_H
+#define DSY_ADC_SCAN_H
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace daisy
+{
+/** Background conversion of analog pins on ADC1 by circular DMA.
+
+    analogRead() is a blocking single conversion of several microseconds
+    per pin, HAL setup included. Here every pin added is in ADC1's
+    regular sequence, converted continuously with the hardware
+    oversampler, and DMA (DMA1 stream 2) keeps a buffer of the latest
+    result of each pin up to date. Reading a value is a load from that
+    buffer, which lives in DMA_BUFFER_MEM_SECTION, uncached, so it is
+    current without cache maintenance; no interrupt runs per conversion
+    or per sequence.
+
+    While running, ADC1 belongs to the scan: analogRead() on any ADC1
+    pin reinitialises and then stops the ADC, so do not mix the two.
+    Pins must be on ADC1 (all of the Seed's ADC pins are).
+
+    One instance per firmware.
+*/
+class AdcScan
+{
+  public:
+    static constexpr size_t kMaxPins = 16;
+
+    /** Conversions averaged by the hardware per result; the result
+        stays 16-bit. Each doubling adds roughly half a bit of noise
+        rejection and halves the scan rate.
+    */
+    enum class Oversample : uint8_t
+    {
+        OVS_NONE = 0,
+        OVS_2,
+        OVS_4,
+        OVS_8,
+        OVS_16,
+        OVS_32,
+        OVS_64,
+    };
+
+    AdcScan() : num_pins_(0), running_(false) {}
+    ~AdcScan() {}
+
+    /** Adds a pin to the sequence and sets it to analog; before Start().
+        \return its slot, or -1 if the scan is running, full, or the pin
+                is not on ADC1
+    */
+    int AddPin(uint32_t pin);
+
+    /** Calibrates ADC1 and starts the scan.
+        \param ovs - hardware oversampling per result
+        \return false if no pins were added or the HAL failed
+    */
+    bool Start(Oversample ovs = Oversample::OVS_16);
+
+    /** Stops the scan; the buffer keeps the last values. */
+    void Stop();
+
+    /** Latest 16-bit result of a slot */
+    uint16_t Raw(int slot) const;
+
+    /** Latest result of a slot, 0 to 1 */
+    inline float Value(int slot) const
+    {
+        return static_cast<float>(Raw(slot)) * (1.f / 65535.f);
+    }
+
+    inline bool   IsRunning() const { return running_; }
+    inline size_t GetNumPins() const { return num_pins_; }
+
+  private:
+    uint32_t channels_[kMaxPins];
+    size_t   num_pins_;
+    bool     running_;
+};
+
+} // namespace daisy
+#endif
@@ -1,5 +1,15 @@
+#include <string.h>
+#include <atomic>
+#include <Arduino.h>
 #include "audio.h"
+#include "audio_convert.h"
+#include "cpu_load_meter.h"
+#include "wcet_tracker.h"
+#include "quality_governor.h"
+#include "irq_priority.h"
+#include "sai_mdma.h"
 #include "utility/dma.h"
+#include "sys_mpu.h"
 
 namespace daisy
 {
@@ -12,16 +22,99 @@ namespace daisy
 // these buffers will always be present, and usable.
 //
 static const size_t kAudioMaxBufferSize = 1024;
-static const size_t kAudioMaxChannels   = 4;
+// Two SAIs in stereo, or one SAI with up to 8 TDM slots.
+static const size_t kAudioMaxSais     = 2;
+static const size_t kAudioMaxChannels = 8;
+// Each DMA buffer holds two halves of interleaved stereo frames, or
+// Config::dma_segments blocks as a ring.
+static const size_t kAudioMaxBlockSize   = kAudioMaxBufferSize / 2 / 2;
+static const size_t kAudioMaxDmaSegments = 8;
+
+// Adaptive block size: decide once per hold period on the peak load seen.
+static const float kAdaptHoldSeconds = 1.0f;
+static const float kAdaptGrowLoad    = 0.75f;
+static const float kAdaptShrinkLoad  = 0.3f;
 
 // Static Global Buffers
 // 8kB in SRAM1, non-cached memory
 // 1k samples in, 1k samples out, 4 bytes per sample.
 // One buffer per 2 channels (Interleaved on hardware)
-static int32_t DMA_BUFFER_MEM_SECTION
-    dsy_audio_rx_buffer[kAudioMaxChannels / 2][kAudioMaxBufferSize];
-static int32_t DMA_BUFFER_MEM_SECTION
-    dsy_audio_tx_buffer[kAudioMaxChannels / 2][kAudioMaxBufferSize];
+//
+// With DSY_AUDIO_DMA_CACHED defined, the buffers are one 16kB block,
+// aligned to its size so a single MPU region can mark it write-back
+// cacheable on top of the non-cached SRAM1 window. The callback then
+// invalidates the rx half before reading it and cleans the tx half after
+// writing it, and every conversion runs on cached data.
+#if defined(DSY_AUDIO_DMA_CACHED)
+struct AudioDmaBuffers
+{
+    int32_t rx[kAudioMaxSais][kAudioMaxBufferSize];
+    int32_t tx[kAudioMaxSais][kAudioMaxBufferSize];
+};
+static_assert((sizeof(AudioDmaBuffers) & (sizeof(AudioDmaBuffers) - 1)) == 0,
+              "an MPU region must be a power of two in size");
+static AudioDmaBuffers DMA_BUFFER_MEM_SECTION
+    __attribute__((aligned(sizeof(AudioDmaBuffers)))) dsy_audio_dma;
+static int32_t (&dsy_audio_rx_buffer)[kAudioMaxSais]
+                                     [kAudioMaxBufferSize]
+    = dsy_audio_dma.rx;
+static int32_t (&dsy_audio_tx_buffer)[kAudioMaxSais]
+                                     [kAudioMaxBufferSize]
+    = dsy_audio_dma.tx;
+
+// Cortex-M7 D-cache lines are 32 bytes. Ranges are rounded out to whole
+// lines: the rx buffers are never written by the CPU, so invalidating a
+// neighbouring word is harmless, and a tx line shared with the other
+// half only writes back what the previous callback already cleaned.
+static inline void DCacheLines(const void* p, size_t bytes, uint32_t*& addr, int32_t& len)
+{
+    const uintptr_t start = (uintptr_t)p & ~(uintptr_t)31;
+    const uintptr_t end   = ((uintptr_t)p + bytes + 31) & ~(uintptr_t)31;
+    addr                  = (uint32_t*)start;
+    len                   = (int32_t)(end - start);
+}
+
+static inline void InvalidateDCacheRange(const void* p, size_t bytes)
+{
+    uint32_t* addr;
+    int32_t   len;
+    DCacheLines(p, bytes, addr, len);
+    SCB_InvalidateDCache_by_Addr(addr, len);
+}
+
+static inline void CleanDCacheRange(const void* p, size_t bytes)
+{
+    uint32_t* addr;
+    int32_t   len;
+    DCacheLines(p, bytes, addr, len);
+    SCB_CleanDCache_by_Addr(addr, len);
+}
+#else
+// 16-byte aligned for the DMA's 4-word bursts (SaiHandle::Config).
+static int32_t DMA_BUFFER_MEM_SECTION __attribute__((aligned(16)))
+dsy_audio_rx_buffer[kAudioMaxSais][kAudioMaxBufferSize];
+static int32_t DMA_BUFFER_MEM_SECTION __attribute__((aligned(16)))
+dsy_audio_tx_buffer[kAudioMaxSais][kAudioMaxBufferSize];
+#endif
+
+// Float conversion buffers for the user callback, 16kB each in DTCM.
+// Sized for kAudioMaxBufferSize frames on both channels of both SAIs,
+// so no block size can push them onto the ISR stack; a TDM block fits
+// too, its frames shrink with its slot count. Planar callbacks get one
+// contiguous run per channel, interleaved callbacks use the start.
+static float DTCM_MEM_SECTION __attribute__((aligned(32)))
+dsy_audio_fin[kAudioMaxSais * 2 * kAudioMaxBufferSize];
+static float DTCM_MEM_SECTION __attribute__((aligned(32)))
+dsy_audio_fout[kAudioMaxSais * 2 * kAudioMaxBufferSize];
+
+// A block never fills more than the lower half of either float buffer,
+// so SwapCallback() runs the incoming callback on the upper halves.
+static constexpr size_t kAudioShadowOffset = kAudioMaxSais * kAudioMaxBufferSize;
+
+// Planar word buffers for the MDMA offload (Config::mdma_offload), left
+// run then right run, in DTCM next to the float buffers.
+static int32_t DTCM_MEM_SECTION dsy_audio_win[2 * kAudioMaxBlockSize];
+static int32_t DTCM_MEM_SECTION dsy_audio_wout[2 * kAudioMaxBlockSize];
 
 // ================================================================
 // Private Implementation Definition
@@ -35,29 +128,54 @@ class AudioHandle::Impl
                         Init(const AudioHandle::Config config, SaiHandle sai1, SaiHandle sai2);
     AudioHandle::Result Start(AudioHandle::AudioCallback callback);
     AudioHandle::Result Start(AudioHandle::InterleavingAudioCallback callback);
+    AudioHandle::Result Start(AudioHandle::NativeAudioCallback callback);
     AudioHandle::Result Stop();
     AudioHandle::Result ChangeCallback(AudioHandle::AudioCallback callback);
     AudioHandle::Result
     ChangeCallback(AudioHandle::InterleavingAudioCallback callback);
+    AudioHandle::Result ChangeCallback(AudioHandle::NativeAudioCallback callback);
+
+    inline bool IsSwapping() const { return swap_to_ != nullptr; }
 
     inline size_t GetChannels() const
     {
         if(sai1_.IsInitialized() && sai2_.IsInitialized())
             return 4;
         else if(sai1_.IsInitialized() || sai2_.IsInitialized())
-            return 2;
+            return slots_;
         else
             return 0;
     }
 
+    inline bool TwoSai() const { return sai2_.IsInitialized(); }
+
+    // The ring shares the fixed buffers between its segments.
+    size_t MaxBlockSize() const
+    {
+        return kAudioMaxBufferSize / frame_words_ / config_.dma_segments;
+    }
+
+    // Words per SAI buffer actually handed to the DMA.
+    size_t DmaWords() const
+    {
+        return config_.blocksize * frame_words_ * config_.dma_segments;
+    }
+
     AudioHandle::Result SetBlockSize(size_t size)
     {
-        config_.blocksize
-            = size <= kAudioMaxBufferSize ? size : kAudioMaxBufferSize;
-        return size <= kAudioMaxBufferSize ? AudioHandle::Result::OK
-                                           : AudioHandle::Result::ERR;
+        const size_t max_size = MaxBlockSize();
+        config_.blocksize     = size <= max_size ? size : max_size;
+        return size <= max_size ? AudioHandle::Result::OK
+                                : AudioHandle::Result::ERR;
     }
 
+    AudioHandle::Result ChangeBlockSize(size_t size);
+    AudioHandle::Result
+    SetAdaptiveBlockSize(bool enable, size_t min_size, size_t max_size);
+    AudioHandle::Result
+    SetControlCallback(AudioHandle::ControlCallback callback,
+                       size_t                       every_blocks);
+
     float GetSampleRate() { return sai1_.GetSampleRate(); }
 
     AudioHandle::Result SetPostGain(float val)
@@ -70,15 +188,204 @@ class AudioHandle::Impl
     }
 
     AudioHandle::Result SetSampleRate(SaiHandle::Config::SampleRate sampelrate);
+    AudioHandle::Result SetClock(SaiHandle::Config::Clock clock);
+    AudioHandle::Result SetSlots(SaiHandle::Config::Slots slots);
+    AudioHandle::Result SetSampleFormat(SaiHandle::Config::BitDepth depth,
+                                        bool                        packed16);
+
+    AudioHandle::Result
+    SetChannelMask(uint8_t input_mask, uint8_t output_mask, bool mono_fanout)
+    {
+        config_.input_mask  = input_mask;
+        config_.output_mask = output_mask;
+        config_.mono_fanout = mono_fanout;
+        return AudioHandle::Result::OK;
+    }
+
+    AudioHandle::Result SetDither(AudioHandle::Dither dither)
+    {
+        for(SaiDitherChannel& ch : dither_)
+            ch = SaiDitherChannel();
+        config_.dither = dither;
+        return AudioHandle::Result::OK;
+    }
+
+    AudioHandle::Result SetMdmaOffload(bool enable);
+
+    AudioHandle::Result SetDmaSegments(size_t segments)
+    {
+        if(running_ || segments < 2 || segments > kAudioMaxDmaSegments
+           || config_.blocksize * frame_words_ * segments > kAudioMaxBufferSize)
+            return AudioHandle::Result::ERR;
+        config_.dma_segments = segments;
+        return AudioHandle::Result::OK;
+    }
 
     // Internal Callback
     static void InternalCallback(int32_t* in, int32_t* out, size_t size);
 
-    void *callback_, *interleaved_callback_;
+    enum class CallbackKind
+    {
+        PLANAR,
+        INTERLEAVED,
+        NATIVE,
+    };
+
+    AudioHandle::Result SwapCallback(void*        callback,
+                                     CallbackKind kind,
+                                     size_t       warm_blocks,
+                                     bool         shadow_input);
+
+    // Stand in for the user callback during a swap: run the outgoing one
+    // on air and the incoming one on the shadow buffers, then crossfade.
+    static void SwapPlanar(float** in, float** out, size_t size);
+    static void SwapInterleaved(float* in, float* out, size_t size);
+    void        Crossfade(float* out, const float* in, size_t frames, size_t stride);
+
+    // Per-block handler: converts, calls the user callback, converts back.
+    typedef void (*ProcessFn)(int32_t* in, int32_t* out, size_t size);
+
+    // fixed_frames != 0 builds a handler for exactly that block size, so
+    // the tiny blocks of low-latency operation convert with straight-line
+    // code instead of loops and tails. 0 takes the size per call.
+    static void ProcessNative(int32_t* in, int32_t* out, size_t size);
+    template <typename Format, size_t chns, size_t fixed_frames>
+    static void ProcessInterleaved(int32_t* in, int32_t* out, size_t size);
+    template <typename Format, size_t chns, size_t fixed_frames>
+    static void ProcessPlanar(int32_t* in, int32_t* out, size_t size);
+    template <typename Format, size_t slots>
+    static void ProcessTdm(int32_t* in, int32_t* out, size_t size);
+    // Packed 16-bit stereo (SaiHandle::Config::packed16): one word per
+    // frame on each SAI.
+    template <size_t chns>
+    static void ProcessPackedInterleaved(int32_t* in, int32_t* out, size_t size);
+    template <size_t chns>
+    static void ProcessPackedPlanar(int32_t* in, int32_t* out, size_t size);
+    static void PackPair(float* const* fout,
+                         int32_t*      out,
+                         size_t        frames,
+                         uint8_t       mask,
+                         size_t        ch);
+    static void DitherHalf(const float* in, int32_t* out, size_t half, size_t frames, size_t ch);
+    template <typename Format>
+    static ProcessFn
+    PickProcess(CallbackKind kind, size_t chns, size_t slots, size_t blocksize);
+
+    /** Resolves bit depth, channel count and block size into process_. */
+    void SelectProcess(CallbackKind kind);
+
+    void *callback_, *interleaved_callback_, *native_callback_;
+    ProcessFn    process_;
+    CallbackKind kind_;
+
+    // Callback hot swap: swap_to_ runs off air for swap_blocks_ more
+    // blocks, on a copy of the input or on silence, then takes over.
+    void* volatile  swap_from_;
+    void* volatile  swap_to_;
+    volatile size_t swap_blocks_;
+    bool            swap_shadow_;
+
+    // Timed around every callback; rearmed by Start() for the new period.
+    CpuLoadMeter    load_meter_;
+    WcetTracker     wcet_;
+    QualityGovernor governor_;
+
+    // micros() at the first callback since power-up, 0 before it.
+    volatile uint32_t first_block_us_;
+
+    // Live block size change, stepped once per callback so every step
+    // lands on a DMA half boundary: the last old block fades out, one
+    // silent block follows it, the DMA restarts at the new size and the
+    // first new block fades in. A deeper ring queues dma_segments - 1
+    // silent blocks, so the faded one has played before the restart.
+    enum class ResizeState
+    {
+        IDLE,
+        FADE_OUT,
+        MUTE,
+        RESTART,
+        FADE_IN,
+    };
+
+    // Config::dither on one output channel, channel ch of the callback;
+    // false, and nothing written, when it is off.
+    template <typename Format, typename Word = int32_t>
+    static bool DitherChannel(const float* in,
+                              size_t       in_stride,
+                              Word*        out,
+                              size_t       out_stride,
+                              size_t       frames,
+                              size_t       ch);
+    template <typename Format>
+    static void DitherPair(const float* l,
+                           const float* r,
+                           int32_t*     out,
+                           size_t       frames,
+                           uint8_t      mask,
+                           bool         fanout,
+                           size_t       ch);
+
+    SaiDitherChannel dither_[kAudioMaxChannels];
+    uint32_t         dither_rng_ = 0x2545f491u;
+
+    typedef void (*RampFn)(int32_t* buf, size_t frames, float g0, float g1);
+    template <typename Format>
+    static RampFn PickRamp(size_t slots);
+
+    /** Rearms the load meter and clears any pending resize. */
+    void PrepareStart();
+    void RampOutput(int32_t* out, size_t size, float g0, float g1);
+    void ClearOutput(int32_t* out, size_t size);
+    void RestartAtPendingSize();
+    void Adapt();
+
+    // Cache maintenance on this block's DMA halves, both SAIs. No-ops
+    // unless DSY_AUDIO_DMA_CACHED is defined.
+    void InvalidateInput(const int32_t* in, size_t size);
+    void CleanOutput(const int32_t* out, size_t size);
+
+    // MDMA offload (Config::mdma_offload): the audio interrupt starts
+    // rx_mdma_ on the input half and returns; the planar callback runs
+    // from its completion interrupt on contiguous words, and tx_mdma_
+    // interleaves the result into the output half, which plays a block
+    // period later.
+    typedef void (*MdmaProcessFn)(size_t frames);
+    template <typename Format>
+    static void ProcessPlanarMdma(size_t frames);
+    static void OnMdmaRxDone();
+    void        InitMdma();
+    bool        UseMdma() const;
+
+    SaiMdma       rx_mdma_, tx_mdma_;
+    MdmaProcessFn mdma_process_;
+    int32_t*      mdma_out_;
+    size_t        mdma_frames_;
+
+    bool            running_;
+    volatile size_t pending_blocksize_;
+    ResizeState     resize_state_;
+    size_t          mute_blocks_;
+    RampFn          ramp_;
+    bool            adaptive_;
+    size_t          adapt_min_, adapt_max_, adapt_frames_;
+    float           adapt_peak_;
+
+    // Control-rate callback: counted down in the audio interrupt, run
+    // from PendSV at IRQ_PRIORITY_CONTROL so the audio interrupt can
+    // always preempt it.
+    void TickControl(size_t frames);
+    void RunControl();
+
+    AudioHandle::ControlCallback control_callback_;
+    size_t                       control_every_, control_count_;
+    volatile size_t              control_frames_;
 
     // Data
     AudioHandle::Config config_;
     SaiHandle           sai1_, sai2_;
+    size_t              slots_;       // samples per frame on each SAI
+    size_t              frame_words_; // DMA words per frame, packed16 halves
+    bool                packed_;      // SaiHandle::Config::packed16
     int32_t*            buff_rx_[2];
     int32_t*            buff_tx_[2];
     float               postgain_recip_;
@@ -108,13 +415,28 @@ AudioHandle::Result AudioHandle::Impl::Init(const AudioHandle::Config config,
     {
         sai1_              = sai;
         config_.samplerate = sai1_.GetConfig().sr;
+        slots_             = sai1_.GetSlots();
+        frame_words_       = sai1_.GetWordsPerFrame();
+        packed_            = sai1_.GetConfig().packed16;
     }
     else
     {
         return Result::ERR;
     }
+    // The packed handlers are stereo only.
+    if(packed_ && slots_ != 2)
+        return Result::ERR;
+
+    if(config_.dma_segments < 2 || config_.dma_segments > kAudioMaxDmaSegments
+       || config_.blocksize > MaxBlockSize())
+        return Result::ERR;
     buff_rx_[0] = dsy_audio_rx_buffer[0];
     buff_tx_[0] = dsy_audio_tx_buffer[0];
+#if defined(DSY_AUDIO_DMA_CACHED)
+    dsy_mpu_set_cacheable(&dsy_audio_dma, sizeof(dsy_audio_dma));
+#endif
+    if(config_.mdma_offload)
+        InitMdma();
     return Result::OK;
 }
 
@@ -122,6 +444,11 @@ AudioHandle::Result AudioHandle::Impl::Init(const AudioHandle::Config config,
                                             SaiHandle                 sai1,
                                             SaiHandle                 sai2)
 {
+    // Four channels come from two stereo SAIs; TDM runs on one.
+    if(!sai1.IsInitialized() || !sai2.IsInitialized() || sai1.GetSlots() != 2
+       || sai2.GetSlots() != 2
+       || sai1.GetConfig().packed16 != sai2.GetConfig().packed16)
+        return Result::ERR;
     this->Init(config, sai1);
     sai2_       = sai2;
     buff_rx_[1] = dsy_audio_rx_buffer[1];
@@ -133,41 +460,178 @@ AudioHandle::Result AudioHandle::Impl::Init(const AudioHandle::Config config,
 AudioHandle::Result
 AudioHandle::Impl::Start(AudioHandle::AudioCallback callback)
 {
+    PrepareStart();
     // Get instance of object
     if(sai2_.IsInitialized())
     {
         // Start stream with no callback. Data will be filled externally.
-        sai2_.StartDma(
-            buff_rx_[1], buff_tx_[1], config_.blocksize * 2 * 2, nullptr);
+        sai2_.StartDma(buff_rx_[1],
+                       buff_tx_[1],
+                       DmaWords(),
+                       nullptr,
+                       config_.dma_segments);
     }
     sai1_.StartDma(buff_rx_[0],
                    buff_tx_[0],
-                   config_.blocksize * 2 * 2,
-                   audio_handle.InternalCallback);
-    callback_             = (void*)callback;
+                   DmaWords(),
+                   audio_handle.InternalCallback,
+                   config_.dma_segments);
+    callback_ = (void*)callback;
+    SelectProcess(CallbackKind::PLANAR);
     interleaved_callback_ = nullptr;
+    native_callback_      = nullptr;
     return Result::OK;
 }
 
 AudioHandle::Result
 AudioHandle::Impl::Start(AudioHandle::InterleavingAudioCallback callback)
 {
-    // Get instance of object
+    PrepareStart();
+    if(sai2_.IsInitialized())
+    {
+        // Start stream with no callback. Data will be filled externally.
+        sai2_.StartDma(buff_rx_[1],
+                       buff_tx_[1],
+                       DmaWords(),
+                       nullptr,
+                       config_.dma_segments);
+    }
     sai1_.StartDma(buff_rx_[0],
                    buff_tx_[0],
-                   config_.blocksize * 2 * 2,
-                   audio_handle.InternalCallback);
+                   DmaWords(),
+                   audio_handle.InternalCallback,
+                   config_.dma_segments);
     interleaved_callback_ = (void*)callback;
+    SelectProcess(CallbackKind::INTERLEAVED);
+    callback_        = nullptr;
+    native_callback_ = nullptr;
+    return Result::OK;
+}
+
+AudioHandle::Result
+AudioHandle::Impl::Start(AudioHandle::NativeAudioCallback callback)
+{
+    PrepareStart();
+    if(sai2_.IsInitialized())
+    {
+        // Start stream with no callback. Data will be filled externally.
+        sai2_.StartDma(buff_rx_[1],
+                       buff_tx_[1],
+                       DmaWords(),
+                       nullptr,
+                       config_.dma_segments);
+    }
+    sai1_.StartDma(buff_rx_[0],
+                   buff_tx_[0],
+                   DmaWords(),
+                   audio_handle.InternalCallback,
+                   config_.dma_segments);
+    native_callback_ = (void*)callback;
+    SelectProcess(CallbackKind::NATIVE);
     callback_             = nullptr;
+    interleaved_callback_ = nullptr;
     return Result::OK;
 }
 
 AudioHandle::Result AudioHandle::Impl::Stop()
 {
+    running_ = false;
     if(sai1_.IsInitialized())
         sai1_.StopDma();
     if(sai2_.IsInitialized())
         sai2_.StopDma();
+    rx_mdma_.Abort();
+    tx_mdma_.Abort();
+    // A resize still in flight applies at the next Start().
+    if(pending_blocksize_ != 0)
+        config_.blocksize = pending_blocksize_;
+    return Result::OK;
+}
+
+void AudioHandle::Impl::PrepareStart()
+{
+    load_meter_.Init(GetSampleRate(), config_.blocksize);
+    wcet_.Init(load_meter_.GetPeriodCycles());
+    governor_.Init(GetSampleRate() / (float)config_.blocksize);
+    pending_blocksize_ = 0;
+    resize_state_      = ResizeState::IDLE;
+    adapt_frames_      = 0;
+    adapt_peak_        = 0.f;
+    swap_to_           = nullptr;
+    running_           = true;
+}
+
+AudioHandle::Result AudioHandle::Impl::ChangeBlockSize(size_t size)
+{
+    if(size == 0 || size > MaxBlockSize())
+        return Result::ERR;
+    if(!running_)
+        return SetBlockSize(size);
+    // Picked up by the next callback; a later request before the restart
+    // simply replaces this one.
+    pending_blocksize_ = size;
+    return Result::OK;
+}
+
+AudioHandle::Result
+AudioHandle::Impl::SetControlCallback(AudioHandle::ControlCallback callback,
+                                      size_t                       every_blocks)
+{
+    if(every_blocks == 0)
+        return Result::ERR;
+    HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIORITY_CONTROL, 0);
+    control_callback_ = nullptr;
+    control_every_    = every_blocks;
+    control_count_    = 0;
+    control_frames_   = 0;
+    control_callback_ = callback;
+    return Result::OK;
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::TickControl(size_t frames)
+{
+    if(control_callback_ == nullptr)
+        return;
+    control_frames_ += frames;
+    if(++control_count_ >= control_every_)
+    {
+        control_count_ = 0;
+        SCB->ICSR      = SCB_ICSR_PENDSVSET_Msk;
+    }
+}
+
+void AudioHandle::Impl::RunControl()
+{
+    AudioHandle::ControlCallback cb = control_callback_;
+    if(cb == nullptr)
+        return;
+    // The audio interrupt adds to the count; take it in one piece.
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const size_t frames = control_frames_;
+    control_frames_     = 0;
+    __set_PRIMASK(primask);
+    cb(frames);
+}
+
+extern "C" void PendSV_Handler(void)
+{
+    audio_handle.RunControl();
+}
+
+AudioHandle::Result AudioHandle::Impl::SetAdaptiveBlockSize(bool   enable,
+                                                           size_t min_size,
+                                                           size_t max_size)
+{
+    if(enable
+       && (min_size == 0 || min_size > max_size
+           || max_size > MaxBlockSize()))
+        return Result::ERR;
+    adapt_min_    = min_size;
+    adapt_max_    = max_size;
+    adapt_frames_ = 0;
+    adapt_peak_   = 0.f;
+    adaptive_     = enable;
     return Result::OK;
 }
 
@@ -176,8 +640,11 @@ AudioHandle::Impl::ChangeCallback(AudioHandle::AudioCallback callback)
 {
     if(callback != nullptr)
     {
-        callback_             = (void*)callback;
+        callback_ = (void*)callback;
+        SelectProcess(CallbackKind::PLANAR);
         interleaved_callback_ = nullptr;
+        native_callback_      = nullptr;
+        swap_to_              = nullptr;
         return Result::OK;
     }
     else
@@ -192,7 +659,28 @@ AudioHandle::Result AudioHandle::Impl::ChangeCallback(
     if(callback != nullptr)
     {
         interleaved_callback_ = (void*)callback;
+        SelectProcess(CallbackKind::INTERLEAVED);
+        callback_        = nullptr;
+        native_callback_ = nullptr;
+        swap_to_         = nullptr;
+        return Result::OK;
+    }
+    else
+    {
+        return Result::ERR;
+    }
+}
+
+AudioHandle::Result
+AudioHandle::Impl::ChangeCallback(AudioHandle::NativeAudioCallback callback)
+{
+    if(callback != nullptr)
+    {
+        native_callback_ = (void*)callback;
+        SelectProcess(CallbackKind::NATIVE);
         callback_             = nullptr;
+        interleaved_callback_ = nullptr;
+        swap_to_              = nullptr;
         return Result::OK;
     }
     else
@@ -201,6 +689,103 @@ AudioHandle::Result AudioHandle::Impl::ChangeCallback(
     }
 }
 
+// The swap goes through the ordinary callback pointer, so every block
+// handler (and the MDMA path) carries it without knowing. The stand-in
+// installs itself last and hands over to the new callback on its own.
+AudioHandle::Result AudioHandle::Impl::SwapCallback(void*        callback,
+                                                    CallbackKind kind,
+                                                    size_t       warm_blocks,
+                                                    bool         shadow_input)
+{
+    if(callback == nullptr || kind != kind_ || IsSwapping())
+        return Result::ERR;
+    void** slot = kind == CallbackKind::PLANAR ? &callback_ : &interleaved_callback_;
+    if(!running_ || *slot == nullptr)
+    {
+        *slot = callback;
+        return Result::OK;
+    }
+    swap_from_   = *slot;
+    swap_blocks_ = warm_blocks;
+    swap_shadow_ = shadow_input;
+    swap_to_     = callback;
+    std::atomic_signal_fence(std::memory_order_release);
+    *slot = kind == CallbackKind::PLANAR ? (void*)&SwapPlanar : (void*)&SwapInterleaved;
+    return Result::OK;
+}
+
+// out toward in over frames, linearly, reaching in on the last frame.
+DSY_ITCM_FUNC void AudioHandle::Impl::Crossfade(float*       out,
+                                                const float* in,
+                                                size_t       frames,
+                                                size_t       stride)
+{
+    const float step = 1.f / (float)frames;
+    float       g    = step;
+    for(size_t i = 0; i < frames; i++, g += step)
+    {
+        for(size_t c = 0; c < stride; c++)
+        {
+            float& o = out[i * stride + c];
+            o += (in[i * stride + c] - o) * g;
+        }
+    }
+}
+
+DSY_ITCM_FUNC void
+AudioHandle::Impl::SwapInterleaved(float* in, float* out, size_t size)
+{
+    Impl&  h          = audio_handle;
+    float* shadow_in  = dsy_audio_fin + kAudioShadowOffset;
+    float* shadow_out = dsy_audio_fout + kAudioShadowOffset;
+    if(h.swap_shadow_)
+        memcpy(shadow_in, in, size * sizeof(float));
+    else
+        memset(shadow_in, 0, size * sizeof(float));
+    ((InterleavingAudioCallback)h.swap_from_)(in, out, size);
+    ((InterleavingAudioCallback)h.swap_to_)(shadow_in, shadow_out, size);
+    if(h.swap_blocks_ > 0)
+    {
+        h.swap_blocks_ = h.swap_blocks_ - 1;
+        return;
+    }
+    const size_t chns = h.GetChannels();
+    h.Crossfade(out, shadow_out, size / chns, chns);
+    h.interleaved_callback_ = h.swap_to_;
+    h.swap_to_              = nullptr;
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::SwapPlanar(float** in, float** out, size_t size)
+{
+    Impl&        h    = audio_handle;
+    const size_t chns = h.GetChannels();
+    float*       shadow_in[kAudioMaxChannels];
+    float*       shadow_out[kAudioMaxChannels];
+    for(size_t c = 0; c < chns; c++)
+    {
+        shadow_in[c]  = nullptr;
+        shadow_out[c] = out[c] + kAudioShadowOffset;
+        if(in[c] == nullptr)
+            continue;
+        shadow_in[c] = in[c] + kAudioShadowOffset;
+        if(h.swap_shadow_)
+            memcpy(shadow_in[c], in[c], size * sizeof(float));
+        else
+            memset(shadow_in[c], 0, size * sizeof(float));
+    }
+    ((AudioCallback)h.swap_from_)(in, out, size);
+    ((AudioCallback)h.swap_to_)(shadow_in, shadow_out, size);
+    if(h.swap_blocks_ > 0)
+    {
+        h.swap_blocks_ = h.swap_blocks_ - 1;
+        return;
+    }
+    for(size_t c = 0; c < chns; c++)
+        h.Crossfade(out[c], shadow_out[c], size, 1);
+    h.callback_ = h.swap_to_;
+    h.swap_to_  = nullptr;
+}
+
 AudioHandle::Result
 AudioHandle::Impl::SetSampleRate(SaiHandle::Config::SampleRate samplerate)
 {
@@ -230,221 +815,805 @@ AudioHandle::Impl::SetSampleRate(SaiHandle::Config::SampleRate samplerate)
     return Result::OK;
 }
 
-// This turned into a very large function due to the bit-depth conversions..
-// I didn't want to do a conditional conversion in a single loop because it seemed
-// far less efficient, so this is where I landed.
-//
-// Using function pointers for the x2f and f2x functions would have been ideal, but
-// wasn't possible due to the different parameter/return types for each function.
-void AudioHandle::Impl::InternalCallback(int32_t* in, int32_t* out, size_t size)
-{	
-    // Convert from sai format to float, and call user callback
-    size_t                      chns;
-    SaiHandle::Config::BitDepth bd;
-    bd   = audio_handle.sai1_.GetConfig().bit_depth;
-    chns = audio_handle.GetChannels();
-	
-    if(chns == 0)
+AudioHandle::Result AudioHandle::Impl::SetClock(SaiHandle::Config::Clock clock)
+{
+    if(running_)
+        return Result::ERR;
+    SaiHandle* sais[2] = {&sai1_, &sai2_};
+    for(SaiHandle* sai : sais)
+    {
+        if(!sai->IsInitialized())
+            continue;
+        SaiHandle::Config cfg = sai->GetConfig();
+        cfg.clock             = clock;
+        if(sai->Init(cfg) != SaiHandle::Result::OK)
+            return Result::ERR;
+    }
+    return Result::OK;
+}
+
+AudioHandle::Result AudioHandle::Impl::SetSlots(SaiHandle::Config::Slots slots)
+{
+    if(running_ || TwoSai() || !sai1_.IsInitialized()
+       || (packed_ && slots != SaiHandle::Config::Slots::STEREO))
+        return Result::ERR;
+    SaiHandle::Config cfg = sai1_.GetConfig();
+    cfg.slots             = slots;
+    if(sai1_.Init(cfg) != SaiHandle::Result::OK)
+        return Result::ERR;
+    slots_       = sai1_.GetSlots();
+    frame_words_ = sai1_.GetWordsPerFrame();
+    // More words per frame leave the ring room for fewer frames.
+    if(config_.blocksize > MaxBlockSize())
+        config_.blocksize = MaxBlockSize();
+    return Result::OK;
+}
+
+AudioHandle::Result
+AudioHandle::Impl::SetSampleFormat(SaiHandle::Config::BitDepth depth, bool packed16)
+{
+    if(running_ || !sai1_.IsInitialized()
+       || (packed16
+           && (depth != SaiHandle::Config::BitDepth::SAI_16BIT || slots_ != 2)))
+        return Result::ERR;
+    SaiHandle* sais[2] = {&sai1_, &sai2_};
+    for(SaiHandle* sai : sais)
+    {
+        if(!sai->IsInitialized())
+            continue;
+        SaiHandle::Config cfg = sai->GetConfig();
+        cfg.bit_depth         = depth;
+        cfg.packed16          = packed16;
+        if(sai->Init(cfg) != SaiHandle::Result::OK)
+            return Result::ERR;
+    }
+    frame_words_ = sai1_.GetWordsPerFrame();
+    packed_      = packed16;
+    if(config_.blocksize > MaxBlockSize())
+        config_.blocksize = MaxBlockSize();
+    return Result::OK;
+}
+
+// Conversion runs through a block handler picked once by SelectProcess()
+// for the callback type, bit depth and channel count, so the per-block
+// path has no bit-depth switch. The handlers are templated on the
+// sample format (audio_convert.h) and fold the post-gain into the
+// conversion scale.
+DSY_ITCM_FUNC void AudioHandle::Impl::InternalCallback(int32_t* in, int32_t* out, size_t size)
+{
+    Impl&     h       = audio_handle;
+    ProcessFn process = h.process_;
+    if(process == nullptr)
         return;
-    // Handle Interleaved / Non Interleaved separate
-    if(audio_handle.interleaved_callback_)
-    {
-        InterleavingAudioCallback cb
-            = (InterleavingAudioCallback)audio_handle.interleaved_callback_;
-        float fin[size];
-        float fout[size];
-        // There _must_ be a more elegant way to do this....
-        // Convert from int to float
-        switch(bd)
-        {
-            case SaiHandle::Config::BitDepth::SAI_16BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    fin[i] = s162f(in[i]) * audio_handle.postgain_recip_;
-                    fin[i + 1]
-                        = s162f(in[i + 1]) * audio_handle.postgain_recip_;
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_24BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    fin[i] = s242f(in[i]) * audio_handle.postgain_recip_;
-                    fin[i + 1]
-                        = s242f(in[i + 1]) * audio_handle.postgain_recip_;
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_32BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    fin[i] = s322f(in[i]) * audio_handle.postgain_recip_;
-                    fin[i + 1]
-                        = s322f(in[i + 1]) * audio_handle.postgain_recip_;
-                }
-                break;
-            default: break;
-        }
-        cb(fin, fout, size);
-        switch(bd)
+    if(h.first_block_us_ == 0)
+        h.first_block_us_ = micros();
+    h.InvalidateInput(in, size);
+    h.TickControl(size / h.frame_words_);
+    switch(h.resize_state_)
+    {
+        case ResizeState::IDLE:
+            if(h.pending_blocksize_ != 0)
+                h.resize_state_ = ResizeState::FADE_OUT;
+            break;
+        case ResizeState::MUTE:
+            // The faded block is playing or queued; silence behind it.
+            h.ClearOutput(out, size);
+            h.CleanOutput(out, size);
+            if(--h.mute_blocks_ == 0)
+                h.resize_state_ = ResizeState::RESTART;
+            return;
+        case ResizeState::RESTART:
+            // The silent half is playing, so nothing audible is cut.
+            h.RestartAtPendingSize();
+            return;
+        default: break;
+    }
+
+    if(h.resize_state_ == ResizeState::IDLE && h.UseMdma())
+    {
+        // Finished by OnMdmaRxDone().
+        const size_t frames = size / 2;
+        h.mdma_out_         = out;
+        h.mdma_frames_      = frames;
+        h.rx_mdma_.Start(in, dsy_audio_win, dsy_audio_win + frames, frames);
+        return;
+    }
+
+    h.load_meter_.OnBlockStart();
+    h.wcet_.OnBlockStart();
+    process(in, out, size);
+    h.wcet_.OnBlockEnd(h.sai1_.GetBlockFrame());
+    h.load_meter_.OnBlockEnd();
+    h.governor_.OnBlockEnd(h.load_meter_.GetLastCpuLoad());
+
+    switch(h.resize_state_)
+    {
+        case ResizeState::FADE_OUT:
+            h.RampOutput(out, size, 1.f, 0.f);
+            h.mute_blocks_  = h.config_.dma_segments - 1;
+            h.resize_state_ = ResizeState::MUTE;
+            break;
+        case ResizeState::FADE_IN:
+            h.RampOutput(out, size, 0.f, 1.f);
+            h.resize_state_ = ResizeState::IDLE;
+            break;
+        default:
+            if(h.adaptive_)
+                h.Adapt();
+            break;
+    }
+    h.CleanOutput(out, size);
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::InvalidateInput(const int32_t* in, size_t size)
+{
+#if defined(DSY_AUDIO_DMA_CACHED)
+    InvalidateDCacheRange(in, size * sizeof(int32_t));
+    if(TwoSai())
+        InvalidateDCacheRange(buff_rx_[1] + sai2_.GetOffset(),
+                              size * sizeof(int32_t));
+#else
+    (void)in;
+    (void)size;
+#endif
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::CleanOutput(const int32_t* out, size_t size)
+{
+#if defined(DSY_AUDIO_DMA_CACHED)
+    CleanDCacheRange(out, size * sizeof(int32_t));
+    if(TwoSai())
+        CleanDCacheRange(buff_tx_[1] + sai2_.GetOffset(),
+                         size * sizeof(int32_t));
+#else
+    (void)out;
+    (void)size;
+#endif
+}
+
+AudioHandle::Result AudioHandle::Impl::SetMdmaOffload(bool enable)
+{
+    config_.mdma_offload = enable;
+    if(enable)
+        InitMdma();
+    if(running_)
+        SelectProcess(kind_);
+    return Result::OK;
+}
+
+void AudioHandle::Impl::InitMdma()
+{
+    rx_mdma_.Init(0, SaiMdma::Direction::DEINTERLEAVE, &OnMdmaRxDone);
+    tx_mdma_.Init(1, SaiMdma::Direction::INTERLEAVE, nullptr);
+}
+
+DSY_ITCM_FUNC bool AudioHandle::Impl::UseMdma() const
+{
+    // Per block, so channel masks and fan-out changes take the CPU path
+    // at once. A transfer still in flight means the last block overran;
+    // that block also goes to the CPU.
+    return mdma_process_ != nullptr && (config_.input_mask & 3) == 3
+           && (config_.output_mask & 3) == 3 && !config_.mono_fanout
+           && !rx_mdma_.Busy() && !tx_mdma_.Busy();
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::OnMdmaRxDone()
+{
+    Impl&         h       = audio_handle;
+    MdmaProcessFn process = h.mdma_process_;
+    if(process == nullptr)
+        return;
+    const size_t frames = h.mdma_frames_;
+    h.load_meter_.OnBlockStart();
+    h.wcet_.OnBlockStart();
+    process(frames);
+    h.tx_mdma_.Start(
+        h.mdma_out_, dsy_audio_wout, dsy_audio_wout + frames, frames);
+    h.wcet_.OnBlockEnd(h.sai1_.GetBlockFrame());
+    h.load_meter_.OnBlockEnd();
+    h.governor_.OnBlockEnd(h.load_meter_.GetLastCpuLoad());
+    if(h.adaptive_)
+        h.Adapt();
+}
+
+// Both channels' words are one contiguous run each way, so each
+// conversion is a single unrolled loop over 2 * frames samples.
+template <typename Format>
+DSY_ITCM_FUNC void AudioHandle::Impl::ProcessPlanarMdma(size_t frames)
+{
+    AudioCallback cb = (AudioCallback)audio_handle.callback_;
+    if(cb == nullptr)
+        return;
+    float* fin[2]  = {dsy_audio_fin, dsy_audio_fin + frames};
+    float* fout[2] = {dsy_audio_fout, dsy_audio_fout + frames};
+    SaiToFloat<Format>(
+        dsy_audio_win, dsy_audio_fin, 2 * frames, audio_handle.postgain_recip_);
+    cb(fin, fout, frames);
+    if(DitherChannel<Format>(fout[0], 1, dsy_audio_wout, 1, frames, 0))
+    {
+        DitherChannel<Format>(
+            fout[1], 1, dsy_audio_wout + frames, 1, frames, 1);
+        return;
+    }
+    FloatToSai<Format>(dsy_audio_fout,
+                       dsy_audio_wout,
+                       2 * frames,
+                       audio_handle.config_.postgain);
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::RampOutput(int32_t* out,
+                                   size_t   size,
+                                   float    g0,
+                                   float    g1)
+{
+    if(ramp_ == nullptr)
+        return;
+    ramp_(out, size / frame_words_, g0, g1);
+    if(TwoSai())
+        ramp_(buff_tx_[1] + sai2_.GetOffset(), size / frame_words_, g0, g1);
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::ClearOutput(int32_t* out, size_t size)
+{
+    memset(out, 0, size * sizeof(int32_t));
+    if(TwoSai())
+        memset(buff_tx_[1] + sai2_.GetOffset(), 0, size * sizeof(int32_t));
+}
+
+void AudioHandle::Impl::RestartAtPendingSize()
+{
+    const size_t blocksize = pending_blocksize_;
+    pending_blocksize_     = 0;
+    config_.blocksize      = blocksize;
+
+    // New layout starts silent; the first block at the new size fades in.
+    const size_t words = DmaWords();
+    memset(buff_tx_[0], 0, words * sizeof(int32_t));
+    if(sai2_.IsInitialized())
+        memset(buff_tx_[1], 0, words * sizeof(int32_t));
+#if defined(DSY_AUDIO_DMA_CACHED)
+    CleanDCacheRange(dsy_audio_tx_buffer, sizeof(dsy_audio_tx_buffer));
+#endif
+    if(sai2_.IsInitialized())
+        sai2_.RestartDma(words);
+    sai1_.RestartDma(words);
+
+    // The fixed-size handlers only fit the size they were built for.
+    SelectProcess(kind_);
+    load_meter_.Init(GetSampleRate(), blocksize);
+    wcet_.Init(load_meter_.GetPeriodCycles());
+    governor_.Init(GetSampleRate() / (float)blocksize);
+    adapt_frames_ = 0;
+    adapt_peak_   = 0.f;
+    resize_state_ = ResizeState::FADE_IN;
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::Adapt()
+{
+    const float load = load_meter_.GetLastCpuLoad();
+    adapt_peak_      = load > adapt_peak_ ? load : adapt_peak_;
+    adapt_frames_ += config_.blocksize;
+    if((float)adapt_frames_ < kAdaptHoldSeconds * GetSampleRate())
+        return;
+
+    // Halving the block only adds per-block overhead, so a load under
+    // kAdaptShrinkLoad stays well under kAdaptGrowLoad after the step and
+    // the size does not hunt.
+    size_t next = config_.blocksize;
+    if(adapt_peak_ > kAdaptGrowLoad)
+        next = next * 2 < adapt_max_ ? next * 2 : adapt_max_;
+    else if(adapt_peak_ < kAdaptShrinkLoad)
+        next = next / 2 > adapt_min_ ? next / 2 : adapt_min_;
+    adapt_frames_ = 0;
+    adapt_peak_   = 0.f;
+    if(next != config_.blocksize)
+        pending_blocksize_ = next;
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::ProcessNative(int32_t* in, int32_t* out, size_t size)
+{
+    NativeAudioCallback cb = (NativeAudioCallback)audio_handle.native_callback_;
+    if(cb == nullptr)
+        return;
+    const bool     two_sai = audio_handle.TwoSai();
+    const size_t   offset  = audio_handle.sai2_.GetOffset();
+    const int32_t* nin[2]
+        = {in, two_sai ? audio_handle.buff_rx_[1] + offset : nullptr};
+    int32_t* nout[2]
+        = {out, two_sai ? audio_handle.buff_tx_[1] + offset : nullptr};
+    cb(nin, nout, size / audio_handle.frame_words_);
+}
+
+template <typename Format, typename Word>
+DSY_ITCM_FUNC bool AudioHandle::Impl::DitherChannel(const float* in,
+                                                    size_t       in_stride,
+                                                    Word*        out,
+                                                    size_t       out_stride,
+                                                    size_t       frames,
+                                                    size_t       ch)
+{
+    Impl&             h    = audio_handle;
+    const float       gain = h.config_.postgain;
+    SaiDitherChannel& s    = h.dither_[ch];
+    switch(h.config_.dither)
+    {
+        case Dither::TPDF:
+            FloatToSaiDithered<Format, 0, Word>(
+                in, in_stride, out, out_stride, frames, gain, s, h.dither_rng_);
+            return true;
+        case Dither::SHAPED_1:
+            FloatToSaiDithered<Format, 1, Word>(
+                in, in_stride, out, out_stride, frames, gain, s, h.dither_rng_);
+            return true;
+        case Dither::SHAPED_2:
+            FloatToSaiDithered<Format, 2, Word>(
+                in, in_stride, out, out_stride, frames, gain, s, h.dither_rng_);
+            return true;
+        default: return false;
+    }
+}
+
+// InterleavePair() with Config::dither on; the fanned-out channel
+// shares the left one's words.
+template <typename Format>
+DSY_ITCM_FUNC void AudioHandle::Impl::DitherPair(const float* l,
+                                                 const float* r,
+                                                 int32_t*     out,
+                                                 size_t       frames,
+                                                 uint8_t      mask,
+                                                 bool         fanout,
+                                                 size_t       ch)
+{
+    const bool en_l = mask & 1, en_r = !fanout && (mask & 2);
+    if(en_l)
+        DitherChannel<Format>(l, 1, out, 2, frames, ch);
+    else
+        SaiChannelClear(out, frames);
+    if(fanout && en_l)
+    {
+        for(size_t i = 0; i < frames; i++)
+            out[2 * i + 1] = out[2 * i];
+    }
+    else if(en_r)
+        DitherChannel<Format>(r, 1, out + 1, 2, frames, ch + 1);
+    else
+        SaiChannelClear(out + 1, frames);
+}
+
+// With two SAIs, both halves merge into one buffer of 4-channel frames,
+// SAI1's pair first, and split back the same way.
+template <typename Format, size_t chns, size_t fixed_frames>
+DSY_ITCM_FUNC void AudioHandle::Impl::ProcessInterleaved(int32_t* in,
+                                           int32_t* out,
+                                           size_t   size)
+{
+    InterleavingAudioCallback cb
+        = (InterleavingAudioCallback)audio_handle.interleaved_callback_;
+    if(cb == nullptr)
+        return;
+    const float gain_in  = audio_handle.postgain_recip_;
+    const float gain_out = audio_handle.config_.postgain;
+    if(chns > 2)
+    {
+        const size_t offset = audio_handle.sai2_.GetOffset();
+        const size_t frames = size / 2;
+        SaiMergePairsToFloat<Format>(
+            in, audio_handle.buff_rx_[1] + offset, dsy_audio_fin, frames, gain_in);
+        cb(dsy_audio_fin, dsy_audio_fout, frames * 4);
+        int32_t* out2 = audio_handle.buff_tx_[1] + offset;
+        if(audio_handle.config_.dither != Dither::OFF)
         {
-            case SaiHandle::Config::BitDepth::SAI_16BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    out[i] = f2s16(fout[i] * audio_handle.config_.postgain);
-                    out[i + 1]
-                        = f2s16(fout[i + 1] * audio_handle.config_.postgain);
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_24BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    out[i] = f2s24(fout[i] * audio_handle.config_.postgain);
-                    out[i + 1]
-                        = f2s24(fout[i + 1] * audio_handle.config_.postgain);
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_32BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    out[i] = f2s32(fout[i] * audio_handle.config_.postgain);
-                    out[i + 1]
-                        = f2s32(fout[i + 1] * audio_handle.config_.postgain);
-                }
-                break;
-            default: break;
+            for(size_t c = 0; c < 4; c++)
+                DitherChannel<Format>(dsy_audio_fout + c,
+                                      4,
+                                      (c < 2 ? out : out2) + (c & 1),
+                                      2,
+                                      frames,
+                                      c);
+            return;
         }
+        FloatToSaiSplitPairs<Format>(
+            dsy_audio_fout, out, out2, frames, gain_out);
+        return;
+    }
+    const size_t n = fixed_frames != 0 ? fixed_frames * 2 : size;
+    SaiToFloat<Format>(in, dsy_audio_fin, n, gain_in);
+    cb(dsy_audio_fin, dsy_audio_fout, n);
+    if(audio_handle.config_.dither != Dither::OFF)
+    {
+        const size_t slots = audio_handle.slots_;
+        for(size_t c = 0; c < slots; c++)
+            DitherChannel<Format>(
+                dsy_audio_fout + c, slots, out + c, slots, n / slots, c);
+        return;
+    }
+    FloatToSai<Format>(dsy_audio_fout, out, n, gain_out);
+}
+
+// One SAI's stereo pair for the planar handler; a nullptr channel is
+// skipped on the way in, and a disabled one zeroed on the way out.
+template <typename Format>
+DSY_ITCM_FUNC static inline void DeinterleavePair(const int32_t* in,
+                                    float*         l,
+                                    float*         r,
+                                    size_t         frames,
+                                    float          gain)
+{
+    if(l && r)
+        SaiDeinterleaveToFloat<Format>(in, l, r, frames, gain);
+    else if(l)
+        SaiChannelToFloat<Format>(in, l, frames, gain);
+    else if(r)
+        SaiChannelToFloat<Format>(in + 1, r, frames, gain);
+}
+
+template <typename Format>
+DSY_ITCM_FUNC static inline void InterleavePair(const float* l,
+                                  const float* r,
+                                  int32_t*     out,
+                                  size_t       frames,
+                                  float        gain,
+                                  uint8_t      mask,
+                                  bool         fanout)
+{
+    const bool en_l = mask & 1, en_r = !fanout && (mask & 2);
+    if(fanout && en_l)
+        FloatToSaiFanout<Format>(l, out, frames, gain);
+    else if(en_l && en_r)
+        FloatToSaiInterleave<Format>(l, r, out, frames, gain);
+    else if(en_l)
+    {
+        FloatToSaiChannel<Format>(l, out, frames, gain);
+        SaiChannelClear(out + 1, frames);
+    }
+    else if(en_r)
+    {
+        SaiChannelClear(out, frames);
+        FloatToSaiChannel<Format>(r, out + 1, frames, gain);
+    }
+    else
+        memset(out, 0, frames * 2 * sizeof(int32_t));
+}
+
+template <typename Format, size_t chns, size_t fixed_frames>
+DSY_ITCM_FUNC void AudioHandle::Impl::ProcessPlanar(int32_t* in, int32_t* out, size_t size)
+{
+    AudioCallback cb = (AudioCallback)audio_handle.callback_;
+    if(cb == nullptr)
+        return;
+    const float  gain_in  = audio_handle.postgain_recip_;
+    const float  gain_out = audio_handle.config_.postgain;
+    const size_t frames   = fixed_frames != 0 ? fixed_frames : size / 2;
+    // offset needed for 2nd audio codec.
+    const size_t offset = audio_handle.sai2_.GetOffset();
+
+    const uint8_t in_mask  = audio_handle.config_.input_mask;
+    const uint8_t out_mask = audio_handle.config_.output_mask;
+    const bool    fanout   = audio_handle.config_.mono_fanout;
+
+    float* fin[chns];
+    float* fout[chns];
+    for(size_t c = 0; c < chns; c++)
+    {
+        fin[c]  = (in_mask >> c) & 1 ? dsy_audio_fin + c * frames : nullptr;
+        fout[c] = dsy_audio_fout + c * frames;
+    }
+    // Deinterleave and scale
+    DeinterleavePair<Format>(in, fin[0], fin[1], frames, gain_in);
+    if(chns > 2)
+    {
+        DeinterleavePair<Format>(audio_handle.buff_rx_[1] + offset,
+                                 fin[2],
+                                 fin[3],
+                                 frames,
+                                 gain_in);
     }
-    else if(audio_handle.callback_)
-    {
-        AudioCallback cb = (AudioCallback)audio_handle.callback_;
-        // offset needed for 2nd audio codec.
-        size_t offset    = audio_handle.sai2_.GetOffset();
-        size_t buff_size = chns > 2 ? size * 2 : size;
-        float  finbuff[buff_size], foutbuff[buff_size];
-        float* fin[chns];
-        float* fout[chns];
-        fin[0]  = finbuff;
-        fin[1]  = finbuff + (buff_size / chns);
-        fout[0] = foutbuff;
-        fout[1] = foutbuff + (buff_size / chns);
+    cb(fin, fout, frames);
+    if(audio_handle.config_.dither != Dither::OFF)
+    {
+        DitherPair<Format>(fout[0], fout[1], out, frames, out_mask, fanout, 0);
         if(chns > 2)
         {
-            fin[2]  = fin[1] + (buff_size / chns);
-            fin[3]  = fin[2] + (buff_size / chns);
-            fout[2] = fout[1] + (buff_size / chns);
-            fout[3] = fout[2] + (buff_size / chns);
+            DitherPair<Format>(fout[2],
+                               fout[3],
+                               audio_handle.buff_tx_[1] + offset,
+                               frames,
+                               out_mask >> 2,
+                               fanout,
+                               2);
         }
-        // Deinterleave and scale
-        switch(bd)
+        return;
+    }
+    // Reinterleave and scale
+    InterleavePair<Format>(
+        fout[0], fout[1], out, frames, gain_out, out_mask, fanout);
+    if(chns > 2)
+    {
+        InterleavePair<Format>(fout[2],
+                               fout[3],
+                               audio_handle.buff_tx_[1] + offset,
+                               frames,
+                               gain_out,
+                               out_mask >> 2,
+                               fanout);
+    }
+}
+
+// One SAI in TDM: every slot is a channel, one strided pass per slot
+// each way. Masks and fan-out as for the stereo pairs.
+template <typename Format, size_t slots>
+DSY_ITCM_FUNC void AudioHandle::Impl::ProcessTdm(int32_t* in, int32_t* out, size_t size)
+{
+    static_assert(slots <= kAudioMaxChannels, "the channel masks cover 8 slots");
+    AudioCallback cb = (AudioCallback)audio_handle.callback_;
+    if(cb == nullptr)
+        return;
+    const size_t  frames  = size / slots;
+    const uint8_t in_mask = audio_handle.config_.input_mask;
+
+    float* fin[slots];
+    float* fout[slots];
+    for(size_t c = 0; c < slots; c++)
+    {
+        fin[c]  = (in_mask >> c) & 1 ? dsy_audio_fin + c * frames : nullptr;
+        fout[c] = dsy_audio_fout + c * frames;
+    }
+    SaiSlotsToFloat<Format, slots>(
+        in, fin, frames, audio_handle.postgain_recip_);
+    cb(fin, fout, frames);
+    if(audio_handle.config_.dither != Dither::OFF)
+    {
+        const uint8_t out_mask = audio_handle.config_.output_mask;
+        const bool    fanout   = audio_handle.config_.mono_fanout;
+        for(size_t s = 0; s < slots; s++)
         {
-            case SaiHandle::Config::BitDepth::SAI_16BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    fin[0][i / 2] = s162f(in[i]) * audio_handle.postgain_recip_;
-                    fin[1][i / 2]
-                        = s162f(in[i + 1]) * audio_handle.postgain_recip_;
-                    if(chns > 2)
-                    {
-                        fin[2][i / 2]
-                            = s162f(audio_handle.buff_rx_[1][offset + i])
-                              * audio_handle.postgain_recip_;
-                        fin[3][i / 2]
-                            = s162f(audio_handle.buff_rx_[1][offset + i + 1])
-                              * audio_handle.postgain_recip_;
-                    }
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_24BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    fin[0][i / 2] = s242f(in[i]) * audio_handle.postgain_recip_;
-                    fin[1][i / 2]
-                        = s242f(in[i + 1]) * audio_handle.postgain_recip_;
-                    if(chns > 2)
-                    {
-                        fin[2][i / 2]
-                            = s242f(audio_handle.buff_rx_[1][offset + i])
-                              * audio_handle.postgain_recip_;
-                        fin[3][i / 2]
-                            = s242f(audio_handle.buff_rx_[1][offset + i + 1])
-                              * audio_handle.postgain_recip_;
-                    }
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_32BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    fin[0][i / 2] = s322f(in[i]) * audio_handle.postgain_recip_;
-                    fin[1][i / 2]
-                        = s322f(in[i + 1]) * audio_handle.postgain_recip_;
-                    if(chns > 2)
-                    {
-                        fin[2][i / 2]
-                            = s322f(audio_handle.buff_rx_[1][offset + i])
-                              * audio_handle.postgain_recip_;
-                        fin[3][i / 2]
-                            = s322f(audio_handle.buff_rx_[1][offset + i + 1])
-                              * audio_handle.postgain_recip_;
-                    }
-                }
-                break;
-            default: break;
+            const size_t src = fanout ? (s & ~(size_t)1) : s;
+            if((out_mask >> src) & 1)
+                DitherChannel<Format>(fout[src], 1, out + s, slots, frames, s);
+            else
+                for(size_t i = 0; i < frames; i++)
+                    out[slots * i + s] = 0;
         }
-        cb((float**)fin, (float**)fout, size / 2);
-        // Reinterleave and scale
-        switch(bd)
+        return;
+    }
+    FloatToSaiSlots<Format, slots>(fout,
+                                   out,
+                                   frames,
+                                   audio_handle.config_.postgain,
+                                   audio_handle.config_.output_mask,
+                                   audio_handle.config_.mono_fanout);
+}
+
+// Packed words unpack with a sign extend and a shift per sample, with
+// no separate deinterleave pass; masks, fan-out and dither as above.
+template <size_t chns>
+DSY_ITCM_FUNC void
+AudioHandle::Impl::ProcessPackedInterleaved(int32_t* in, int32_t* out, size_t size)
+{
+    InterleavingAudioCallback cb
+        = (InterleavingAudioCallback)audio_handle.interleaved_callback_;
+    if(cb == nullptr)
+        return;
+    const float  gain_in  = audio_handle.postgain_recip_;
+    const float  gain_out = audio_handle.config_.postgain;
+    const bool   dither   = audio_handle.config_.dither != Dither::OFF;
+    const size_t frames   = size;
+    if(chns > 2)
+    {
+        const size_t offset = audio_handle.sai2_.GetOffset();
+        int32_t*     out2   = audio_handle.buff_tx_[1] + offset;
+        SaiMergePacked16ToFloat(
+            in, audio_handle.buff_rx_[1] + offset, dsy_audio_fin, frames, gain_in);
+        cb(dsy_audio_fin, dsy_audio_fout, frames * 4);
+        if(!dither)
         {
-            case SaiHandle::Config::BitDepth::SAI_16BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    out[i]
-                        = f2s16(fout[0][i / 2] * audio_handle.config_.postgain);
-                    out[i + 1]
-                        = f2s16(fout[1][i / 2] * audio_handle.config_.postgain);
-                    if(chns > 2)
-                    {
-                        audio_handle.buff_tx_[1][offset + i] = f2s16(
-                            fout[2][i / 2] * audio_handle.config_.postgain);
-                        audio_handle.buff_tx_[1][offset + i + 1] = f2s16(
-                            fout[3][i / 2] * audio_handle.config_.postgain);
-                    }
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_24BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    out[i]
-                        = f2s24(fout[0][i / 2] * audio_handle.config_.postgain);
-                    out[i + 1]
-                        = f2s24(fout[1][i / 2] * audio_handle.config_.postgain);
-                    if(chns > 2)
-                    {
-                        audio_handle.buff_tx_[1][offset + i] = f2s24(
-                            fout[2][i / 2] * audio_handle.config_.postgain);
-                        audio_handle.buff_tx_[1][offset + i + 1] = f2s24(
-                            fout[3][i / 2] * audio_handle.config_.postgain);
-                    }
-                }
-                break;
-            case SaiHandle::Config::BitDepth::SAI_32BIT:
-                for(size_t i = 0; i < size; i += 2)
-                {
-                    out[i]
-                        = f2s32(fout[0][i / 2] * audio_handle.config_.postgain);
-                    out[i + 1]
-                        = f2s32(fout[1][i / 2] * audio_handle.config_.postgain);
-                    if(chns > 2)
-                    {
-                        audio_handle.buff_tx_[1][offset + i] = f2s32(
-                            fout[2][i / 2] * audio_handle.config_.postgain);
-                        audio_handle.buff_tx_[1][offset + i + 1] = f2s32(
-                            fout[3][i / 2] * audio_handle.config_.postgain);
-                    }
-                }
-                break;
-            default: break;
+            FloatToSaiSplitPacked16(dsy_audio_fout, out, out2, frames, gain_out);
+            return;
         }
+        for(size_t c = 0; c < 4; c++)
+            DitherChannel<SaiFormat16, SaiHalf>(
+                dsy_audio_fout + c,
+                4,
+                (SaiHalf*)(c < 2 ? out : out2) + (c & 1),
+                2,
+                frames,
+                c);
+        return;
     }
+    SaiUnpack16ToFloat(in, dsy_audio_fin, frames, gain_in);
+    cb(dsy_audio_fin, dsy_audio_fout, frames * 2);
+    if(!dither)
+    {
+        FloatToSaiPack16(dsy_audio_fout, out, frames, gain_out);
+        return;
+    }
+    for(size_t c = 0; c < 2; c++)
+        DitherChannel<SaiFormat16, SaiHalf>(
+            dsy_audio_fout + c, 2, (SaiHalf*)out + c, 2, frames, c);
+}
 
+template <size_t chns>
+DSY_ITCM_FUNC void
+AudioHandle::Impl::ProcessPackedPlanar(int32_t* in, int32_t* out, size_t size)
+{
+    AudioCallback cb = (AudioCallback)audio_handle.callback_;
+    if(cb == nullptr)
+        return;
+    const float   gain_in  = audio_handle.postgain_recip_;
+    const size_t  frames   = size;
+    const size_t  offset   = audio_handle.sai2_.GetOffset();
+    const uint8_t in_mask  = audio_handle.config_.input_mask;
+    const uint8_t out_mask = audio_handle.config_.output_mask;
+
+    float* fin[chns];
+    float* fout[chns];
+    for(size_t c = 0; c < chns; c++)
+    {
+        fin[c]  = (in_mask >> c) & 1 ? dsy_audio_fin + c * frames : nullptr;
+        fout[c] = dsy_audio_fout + c * frames;
+    }
+    SaiUnpack16Deinterleave(in, fin[0], fin[1], frames, gain_in);
+    if(chns > 2)
+    {
+        SaiUnpack16Deinterleave(audio_handle.buff_rx_[1] + offset,
+                                fin[2],
+                                fin[3],
+                                frames,
+                                gain_in);
+    }
+    cb(fin, fout, frames);
+    PackPair(fout, out, frames, out_mask, 0);
+    if(chns > 2)
+        PackPair(fout + 2,
+                 audio_handle.buff_tx_[1] + offset,
+                 frames,
+                 out_mask >> 2,
+                 2);
+}
+
+// fout[0] and fout[1] into one SAI's words, as InterleavePair().
+DSY_ITCM_FUNC void AudioHandle::Impl::PackPair(float* const* fout,
+                                               int32_t*      out,
+                                               size_t        frames,
+                                               uint8_t       mask,
+                                               size_t        ch)
+{
+    const bool   fanout = audio_handle.config_.mono_fanout;
+    const float* l      = mask & 1 ? fout[0] : nullptr;
+    const float* r      = fanout ? l : (mask & 2 ? fout[1] : nullptr);
+    if(audio_handle.config_.dither == Dither::OFF)
+    {
+        FloatInterleaveToSaiPack16(
+            l, r, out, frames, audio_handle.config_.postgain);
+        return;
+    }
+    DitherHalf(l, out, 0, frames, ch);
+    DitherHalf(r, out, 1, frames, ch + 1);
+}
+
+DSY_ITCM_FUNC void AudioHandle::Impl::DitherHalf(const float* in,
+                                                 int32_t*     out,
+                                                 size_t       half,
+                                                 size_t       frames,
+                                                 size_t       ch)
+{
+    SaiHalf* o = (SaiHalf*)out + half;
+    if(in == nullptr)
+    {
+        for(size_t i = 0; i < frames; i++)
+            o[2 * i] = 0;
+        return;
+    }
+    DitherChannel<SaiFormat16, SaiHalf>(in, 1, o, 2, frames, ch);
+}
+
+template <typename Format>
+AudioHandle::Impl::ProcessFn AudioHandle::Impl::PickProcess(CallbackKind kind,
+                                                            size_t       chns,
+                                                            size_t       slots,
+                                                            size_t blocksize)
+{
+    switch(kind)
+    {
+        case CallbackKind::INTERLEAVED:
+            // The fixed-size handlers count stereo frames.
+            if(chns > 2 && slots == 2)
+                return &ProcessInterleaved<Format, 4, 0>;
+            if(slots != 2)
+                return &ProcessInterleaved<Format, 2, 0>;
+            switch(blocksize)
+            {
+                case 1: return &ProcessInterleaved<Format, 2, 1>;
+                case 2: return &ProcessInterleaved<Format, 2, 2>;
+                case 4: return &ProcessInterleaved<Format, 2, 4>;
+                default: return &ProcessInterleaved<Format, 2, 0>;
+            }
+        case CallbackKind::PLANAR:
+            if(slots == 8)
+                return &ProcessTdm<Format, 8>;
+            if(slots == 4)
+                return &ProcessTdm<Format, 4>;
+            if(chns > 2)
+                return &ProcessPlanar<Format, 4, 0>;
+            switch(blocksize)
+            {
+                case 1: return &ProcessPlanar<Format, 2, 1>;
+                case 2: return &ProcessPlanar<Format, 2, 2>;
+                case 4: return &ProcessPlanar<Format, 2, 4>;
+                default: return &ProcessPlanar<Format, 2, 0>;
+            }
+        default: return nullptr;
+    }
+}
+
+template <typename Format>
+AudioHandle::Impl::RampFn AudioHandle::Impl::PickRamp(size_t slots)
+{
+    switch(slots)
+    {
+        case 4: return &SaiRampInterleaved<Format, 4>;
+        case 8: return &SaiRampInterleaved<Format, 8>;
+        default: return &SaiRampInterleaved<Format>;
+    }
+}
+
+void AudioHandle::Impl::SelectProcess(CallbackKind kind)
+{
+    const size_t chns      = GetChannels();
+    const size_t blocksize = config_.blocksize;
+    kind_                  = kind;
+    if(chns == 0)
+    {
+        process_      = nullptr;
+        mdma_process_ = nullptr;
+        return;
+    }
+    switch(sai1_.GetConfig().bit_depth)
+    {
+        case SaiHandle::Config::BitDepth::SAI_16BIT:
+            process_
+                = PickProcess<SaiFormat16>(kind, chns, slots_, blocksize);
+            ramp_         = PickRamp<SaiFormat16>(slots_);
+            mdma_process_ = &ProcessPlanarMdma<SaiFormat16>;
+            break;
+        case SaiHandle::Config::BitDepth::SAI_24BIT:
+            process_
+                = PickProcess<SaiFormat24>(kind, chns, slots_, blocksize);
+            ramp_         = PickRamp<SaiFormat24>(slots_);
+            mdma_process_ = &ProcessPlanarMdma<SaiFormat24>;
+            break;
+        case SaiHandle::Config::BitDepth::SAI_32BIT:
+            process_
+                = PickProcess<SaiFormat32>(kind, chns, slots_, blocksize);
+            ramp_         = PickRamp<SaiFormat32>(slots_);
+            mdma_process_ = &ProcessPlanarMdma<SaiFormat32>;
+            break;
+        default:
+            process_      = nullptr;
+            ramp_         = nullptr;
+            mdma_process_ = nullptr;
+            break;
+    }
+    if(packed_)
+    {
+        const bool four = chns > 2;
+        if(kind == CallbackKind::INTERLEAVED)
+            process_ = four ? &ProcessPackedInterleaved<4>
+                            : &ProcessPackedInterleaved<2>;
+        else if(kind == CallbackKind::PLANAR)
+            process_ = four ? &ProcessPackedPlanar<4> : &ProcessPackedPlanar<2>;
+        ramp_         = &SaiRampPacked16;
+        mdma_process_ = nullptr;
+    }
+    if(kind == CallbackKind::NATIVE)
+        process_ = &ProcessNative;
+    // The offload covers one SAI and whole 32-byte cache lines per half
+    // (DSY_AUDIO_DMA_CACHED); tiny blocks keep their fixed handlers. Its
+    // completion interrupt sits at DMA priority, which would take away
+    // the slack a deeper ring is there to give.
+    if(!config_.mdma_offload || kind != CallbackKind::PLANAR || chns != 2
+       || blocksize <= 4 || blocksize % 4 != 0 || config_.dma_segments != 2)
+        mdma_process_ = nullptr;
 }
 
 // ================================================================
@@ -476,6 +1645,11 @@ size_t AudioHandle::GetChannels() const
     return pimpl_->GetChannels();
 }
 
+SaiHandle::Config::BitDepth AudioHandle::GetBitDepth() const
+{
+    return pimpl_->sai1_.GetConfig().bit_depth;
+}
+
 AudioHandle::Result AudioHandle::SetBlockSize(size_t size)
 {
     return pimpl_->SetBlockSize(size);
@@ -492,6 +1666,47 @@ AudioHandle::SetSampleRate(SaiHandle::Config::SampleRate samplerate)
     return pimpl_->SetSampleRate(samplerate);
 }
 
+AudioHandle::Result AudioHandle::SetClock(SaiHandle::Config::Clock clock)
+{
+    return pimpl_->SetClock(clock);
+}
+
+AudioHandle::Result AudioHandle::SetSlots(SaiHandle::Config::Slots slots)
+{
+    return pimpl_->SetSlots(slots);
+}
+
+AudioHandle::Result
+AudioHandle::SetSampleFormat(SaiHandle::Config::BitDepth depth, bool packed16)
+{
+    return pimpl_->SetSampleFormat(depth, packed16);
+}
+
+uint32_t AudioHandle::GetFrameCount() const
+{
+    return pimpl_->sai1_.GetFrameCount();
+}
+
+uint32_t AudioHandle::GetBlockFrame() const
+{
+    return pimpl_->sai1_.GetBlockFrame();
+}
+
+uint64_t AudioHandle::GetFrameCount64() const
+{
+    return pimpl_->sai1_.GetFrameCount64();
+}
+
+SaiHandle::BlockTime AudioHandle::GetBlockTime() const
+{
+    return pimpl_->sai1_.GetBlockTime();
+}
+
+uint64_t AudioHandle::GetFrameAt(uint32_t cycles) const
+{
+    return pimpl_->sai1_.GetFrameAt(cycles);
+}
+
 AudioHandle::Result AudioHandle::Start(AudioCallback callback)
 {
     return pimpl_->Start(callback);
@@ -502,6 +1717,11 @@ AudioHandle::Result AudioHandle::Start(InterleavingAudioCallback callback)
     return pimpl_->Start(callback);
 }
 
+AudioHandle::Result AudioHandle::Start(NativeAudioCallback callback)
+{
+    return pimpl_->Start(callback);
+}
+
 AudioHandle::Result AudioHandle::Stop()
 {
     return pimpl_->Stop();
@@ -518,9 +1738,101 @@ AudioHandle::ChangeCallback(InterleavingAudioCallback callback)
     return pimpl_->ChangeCallback(callback);
 }
 
+AudioHandle::Result AudioHandle::ChangeCallback(NativeAudioCallback callback)
+{
+    return pimpl_->ChangeCallback(callback);
+}
+
+AudioHandle::Result AudioHandle::SwapCallback(AudioCallback callback,
+                                              size_t        warm_blocks,
+                                              bool          shadow_input)
+{
+    return pimpl_->SwapCallback(
+        (void*)callback, Impl::CallbackKind::PLANAR, warm_blocks, shadow_input);
+}
+
+AudioHandle::Result AudioHandle::SwapCallback(InterleavingAudioCallback callback,
+                                              size_t warm_blocks,
+                                              bool   shadow_input)
+{
+    return pimpl_->SwapCallback((void*)callback,
+                                Impl::CallbackKind::INTERLEAVED,
+                                warm_blocks,
+                                shadow_input);
+}
+
+bool AudioHandle::IsSwapping() const
+{
+    return pimpl_->IsSwapping();
+}
+
+AudioHandle::Result AudioHandle::ChangeBlockSize(size_t size)
+{
+    return pimpl_->ChangeBlockSize(size);
+}
+
+AudioHandle::Result
+AudioHandle::SetAdaptiveBlockSize(bool enable, size_t min_size, size_t max_size)
+{
+    return pimpl_->SetAdaptiveBlockSize(enable, min_size, max_size);
+}
+
+AudioHandle::Result AudioHandle::SetControlCallback(ControlCallback callback,
+                                                   size_t every_blocks)
+{
+    return pimpl_->SetControlCallback(callback, every_blocks);
+}
+
+CpuLoadMeter& AudioHandle::GetCpuLoadMeter()
+{
+    return pimpl_->load_meter_;
+}
+
+WcetTracker& AudioHandle::GetWcetTracker()
+{
+    return pimpl_->wcet_;
+}
+
+QualityGovernor& AudioHandle::GetQualityGovernor()
+{
+    return pimpl_->governor_;
+}
+
+uint32_t AudioHandle::GetFirstBlockUs() const
+{
+    return pimpl_->first_block_us_;
+}
+
 AudioHandle::Result AudioHandle::SetPostGain(float val)
 {
     return pimpl_->SetPostGain(val);
 }
 
+AudioHandle::Result AudioHandle::SetChannelMask(uint8_t input_mask,
+                                                uint8_t output_mask,
+                                                bool    mono_fanout)
+{
+    return pimpl_->SetChannelMask(input_mask, output_mask, mono_fanout);
+}
+
+AudioHandle::Result AudioHandle::SetDither(Dither dither)
+{
+    return pimpl_->SetDither(dither);
+}
+
+AudioHandle::Result AudioHandle::SetMdmaOffload(bool enable)
+{
+    return pimpl_->SetMdmaOffload(enable);
+}
+
+AudioHandle::Result AudioHandle::SetDmaSegments(size_t segments)
+{
+    return pimpl_->SetDmaSegments(segments);
+}
+
+size_t AudioHandle::GetDroppedBlocks() const
+{
+    return pimpl_->sai1_.GetDroppedBlocks();
+}
+
 } // namespace daisy
@@ -2,12 +2,27 @@
 #define DSY_AUDIO_H /**< & */
 
 #include "sai.h"
+#include "cpu_load_meter.h"
+#include "wcet_tracker.h"
+#include "quality_governor.h"
 
 namespace daisy
 {
 class AudioHandle
 {
   public:
+    /** Requantization of the float output to the SAI words. OFF
+     ** truncates, as f2s24 does; the rest add TPDF dither of +-1 LSB
+     ** and round, with the error shaped by (1 - z^-1)^order. See
+     ** FloatToSaiDithered(). */
+    enum class Dither
+    {
+        OFF,
+        TPDF,
+        SHAPED_1,
+        SHAPED_2,
+    };
+
     /** Manually configurable details about the Audio Engine */
     /** TODO: Figure out how to get samplerate in here. */
     struct Config
@@ -15,6 +30,35 @@ class AudioHandle
         size_t                        blocksize;
         SaiHandle::Config::SampleRate samplerate;
         float                         postgain;
+        /** Non-interleaving callback only: bit n enables channel n.
+         ** A disabled input is not converted and its in[n] is nullptr;
+         ** a disabled output is not converted and its words are zeroed
+         ** (one memset when a whole SAI is off). out[n] stays valid. */
+        uint8_t input_mask  = 0xff;
+        uint8_t output_mask = 0xff;
+        /** Non-interleaving callback only: out[0] drives both channels of
+         ** the first SAI (out[2] both of the second), converted once.
+         ** In TDM each even channel drives its slot and the next. */
+        bool mono_fanout = false;
+        /** Non-interleaving callback, one SAI, block sizes above 4 that
+         ** are a multiple of 4: MDMA deinterleaves the input half into
+         ** DTCM and interleaves the output back, and the callback runs
+         ** from the MDMA interrupt. The CPU only converts contiguous runs.
+         ** Blocks with channel masks, fan-out or a resize in progress
+         ** take the CPU path. */
+        bool mdma_offload = false;
+        /** DMA blocks queued per direction. 2 is the plain ping-pong;
+         ** 3 or more lets one callback run long by a block period per
+         ** extra segment, for the same extra latency (see
+         ** SaiHandle::StartDma). The callback then runs from its own
+         ** interrupt below the DMA streams, and mdma_offload is ignored.
+         ** blocksize * slots * dma_segments must fit the 1024-word
+         ** buffers, slots being 2 or the SAI's TDM slot count. */
+        size_t dma_segments = 2;
+        /** Output requantization for the float callbacks; the native
+         ** callback writes its own words. 32-bit words are dithered at
+         ** 24 bits. */
+        Dither dither = Dither::OFF;
     };
 
     enum class Result
@@ -26,23 +70,54 @@ class AudioHandle
     /** Non-Interleaving Callback format. Both arrays arranged by float[chn][sample] */
     typedef void (*AudioCallback)(float** in, float** out, size_t size);
 
-    /** Non-Interleaving Callback format. 
-     ** audio is prepared as { L0, R0, L1, R1, . . . LN, RN }
+    /** Interleaving Callback format.
+     ** audio is prepared as { L0, R0, L1, R1, . . . LN, RN }, or with two
+     ** SAIs as 4-channel frames, SAI1's pair then SAI2's. size is the
+     ** number of samples in each buffer, all channels.
      */
     typedef void (*InterleavingAudioCallback)(float* in,
                                               float* out,
                                               size_t size);
 
+    /** Native-format callback, no conversion and no copies.
+     ** in/out point straight into the current DMA half of each SAI,
+     ** interleaved as { L0, R0, L1, R1, . . . LN, RN } (by slot in TDM,
+     ** see SaiHandle::Config::slots) in the SAI's
+     ** configured bit depth (see GetBitDepth()):
+     **   16 and 24 bit: right-aligned in each int32, not sign-extended
+     **   32 bit: Q31
+     **   packed 16 bit: one int32 per frame, left in the low half,
+     **   right in the high half, see SaiHandle::Config::packed16
+     ** in[1]/out[1] are the second SAI's buffers when two are running,
+     ** nullptr otherwise. size is in frames per SAI. Postgain is not applied.
+     */
+    typedef void (*NativeAudioCallback)(const int32_t* const* in,
+                                        int32_t* const*       out,
+                                        size_t                size);
+
+    /** Control-rate callback, for work that must keep pace with the
+     ** audio but not inside its interrupt: coefficient updates, metering,
+     ** parameter smoothing. Runs from PendSV at IRQ_PRIORITY_CONTROL,
+     ** so the audio callback preempts it and the I2C traffic waits.
+     ** frames is the number of audio frames since its previous run.
+     */
+    typedef void (*ControlCallback)(size_t frames);
+
     AudioHandle() : pimpl_(nullptr) {}
     ~AudioHandle() {}
 
     AudioHandle(const AudioHandle& other) = default;
     AudioHandle& operator=(const AudioHandle& other) = default;
 
-    /** Initializes audio to run using a single SAI configured in Stereo I2S mode. */
+    /** Initializes audio to run using a single SAI configured in Stereo I2S mode,
+     ** or in TDM with 4 or 8 slots (SaiHandle::Config::slots). In TDM the
+     ** non-interleaving callback gets one channel per slot, the
+     ** interleaving one the words in slot order, and the MDMA offload
+     ** does not apply. */
     Result Init(const Config& config, SaiHandle sai);
 
-    /** Initializes audio to run using two SAI, each configured in Stereo I2S mode. */
+    /** Initializes audio to run using two SAI, each configured in Stereo I2S mode.
+     ** Fails if either is set up for TDM. */
     Result Init(const Config& config, SaiHandle sai1, SaiHandle sai2);
 
     /** Returns the Global Configuration struct for the Audio */
@@ -50,38 +125,120 @@ class AudioHandle
 
     /** Returns the number of channels of audio.  
      **
-     ** When using a single SAI this returns 2, when using two SAI it returns 4
+     ** When using a single SAI this returns 2, or its slot count in TDM,
+     ** when using two SAI it returns 4
      ** If no SAI is initialized this returns 0
-     **
-     ** Eventually when we add non-standard I2S for each SAI this will be work differently
      */
     size_t GetChannels() const;
 
+    /** Returns the sample format handed to a NativeAudioCallback */
+    SaiHandle::Config::BitDepth GetBitDepth() const;
+
     /** Returns the Samplerate as a float */
     float GetSampleRate();
 
     /** Sets the samplerate, and reinitializes the sai as needed. */
     Result SetSampleRate(SaiHandle::Config::SampleRate samplerate);
 
+    /** Sets SaiHandle::Config::clock on every SAI and reinitializes them.
+     ** Only while stopped. */
+    Result SetClock(SaiHandle::Config::Clock clock);
+
+    /** Sets SaiHandle::Config::slots on the SAI and reinitializes it, for
+     ** a TDM DAC or codec on SAI1's pins: GetChannels() then follows.
+     ** Only while stopped, and only with one SAI. The block size shrinks
+     ** if it no longer fits the DMA buffers. */
+    Result SetSlots(SaiHandle::Config::Slots slots);
+
+    /** Sets SaiHandle::Config::bit_depth and packed16 on every SAI and
+     ** reinitializes them. Packed 16 bit halves the DMA buffers and the
+     ** bus traffic; stereo SAIs only, no TDM and no MDMA. Only while
+     ** stopped. The block size shrinks if it no longer fits. */
+    Result SetSampleFormat(SaiHandle::Config::BitDepth depth,
+                           bool                        packed16 = false);
+
+    /** Frames since Start(), see SaiHandle::GetFrameCount() */
+    uint32_t GetFrameCount() const;
+
+    /** First frame of the block being processed, on the GetFrameCount()
+     ** count. Call from the audio callback. */
+    uint32_t GetBlockFrame() const;
+
+    /** GetFrameCount() in 64 bits, see SaiHandle::GetFrameCount64() */
+    uint64_t GetFrameCount64() const;
+
+    /** The block being processed, or last processed: first frame in 64
+     ** bits and DWT time. See SaiHandle::GetBlockTime(). */
+    SaiHandle::BlockTime GetBlockTime() const;
+
+    /** The frame coming in at DWT time cycles, see SaiHandle::GetFrameAt() */
+    uint64_t GetFrameAt(uint32_t cycles) const;
+
     /** Sets the block size after initialization, and updates the internal configuration struct.
      ** Get BlockSize and other details via the GetConfig 
      */
     Result SetBlockSize(size_t size);
 
+    /** Changes the block size while the audio is running, without a
+     ** stop/start. The switch happens over the next few DMA half
+     ** boundaries: the last old block fades out, one silent block is
+     ** sent and the first block at the new size fades in.
+     ** When stopped this is the same as SetBlockSize().
+     ** With more than two DMA segments the silence runs dma_segments - 1
+     ** blocks, so the restart lands after everything queued has played.
+     ** \param size frames per callback, 1 to 1024 / slots / dma_segments
+     */
+    Result ChangeBlockSize(size_t size);
+
+    /** Lets the block size follow the CPU load meter while running.
+     ** About once a second the block size doubles if the peak load went
+     ** over 75% of the block period, or halves if it stayed under 30%,
+     ** within [min_size, max_size]. Each step is a ChangeBlockSize().
+     */
+    Result SetAdaptiveBlockSize(bool   enable,
+                                size_t min_size = 4,
+                                size_t max_size = 256);
+
     /** Sets the amount of gain adjustment to perform before and after callback.
      ** useful if the hardware has additional headroom, and the nominal value shouldn't be 1.0 
      ** 
      ** \param val Gain adjustment amount. The hardware will clip at the reciprical of this value. */
     Result SetPostGain(float val);
 
+    /** Sets Config::input_mask, output_mask and mono_fanout. Takes effect
+     ** from the next block. */
+    Result SetChannelMask(uint8_t input_mask,
+                          uint8_t output_mask,
+                          bool    mono_fanout = false);
+
+    /** Sets Config::dither and clears the shaping state. Takes effect
+     ** from the next block. */
+    Result SetDither(Dither dither);
+
+    /** Sets Config::mdma_offload. Takes effect from the next block. */
+    Result SetMdmaOffload(bool enable);
+
+    /** Sets Config::dma_segments, 2 to 8. Only while stopped; fails if
+     ** the current block size does not fit. */
+    Result SetDmaSegments(size_t segments);
+
+    /** Blocks skipped since the last start because the callback fell
+     ** more than dma_segments - 1 periods behind. Always 0 with two
+     ** segments, where a late callback overruns instead (see
+     ** CpuLoadMeter). */
+    size_t GetDroppedBlocks() const;
+
     /** Starts the Audio using the non-interleaving callback. */
     Result Start(AudioCallback callback);
 
-    /** Starts the Audio using the interleaving callback. 
-     ** For now only two channels are supported via this method. 
-     */
+    /** Starts the Audio using the interleaving callback: 2 channels, 4
+     ** with two SAIs, or the TDM slots. Channel masks and fan-out do
+     ** not apply. */
     Result Start(InterleavingAudioCallback callback);
 
+    /** Starts the Audio using the native-format callback. */
+    Result Start(NativeAudioCallback callback);
+
     /** Stop the Audio*/
     Result Stop();
 
@@ -91,6 +248,57 @@ class AudioHandle
     /** Immediatley changes the audio callback to the interleaving callback passed in. */
     Result ChangeCallback(InterleavingAudioCallback callback);
 
+    /** Immediatley changes the audio callback to the native-format callback passed in. */
+    Result ChangeCallback(NativeAudioCallback callback);
+
+    /** Changes the audio callback without a click, to one of the same
+     ** kind as the running one. For warm_blocks blocks the new callback
+     ** runs off air beside the old one, on a copy of the input
+     ** (shadow_input) or on silence, so its filters, envelopes and
+     ** smoothers settle; the block after that crossfades linearly from
+     ** the old output to the new one, and the new callback is left
+     ** installed. Both run for those warm_blocks + 1 blocks, which
+     ** is the whole extra CPU. Stopped, it is ChangeCallback().
+     ** Returns ERR while a swap is still going, see IsSwapping(), or
+     ** for a callback of the other kind: those change with
+     ** ChangeCallback(), which also cancels a swap.
+     */
+    Result SwapCallback(AudioCallback callback,
+                        size_t        warm_blocks  = 4,
+                        bool          shadow_input = true);
+
+    Result SwapCallback(InterleavingAudioCallback callback,
+                        size_t                    warm_blocks  = 4,
+                        bool                      shadow_input = true);
+
+    /** True from SwapCallback() until the new callback has taken over */
+    bool IsSwapping() const;
+
+    /** Runs callback from PendSV once every every_blocks audio blocks.
+     ** A run that is still going when the next is due simply runs again
+     ** straight after, with frames covering both.
+     ** Pass nullptr to stop it.
+     */
+    Result SetControlCallback(ControlCallback callback, size_t every_blocks);
+
+    /** Returns the meter timing every callback against the block period.
+     ** Its period is set when the audio is started.
+     */
+    CpuLoadMeter& GetCpuLoadMeter();
+
+    /** Returns the tracker keeping the slowest callback and its context.
+     ** Rearmed with the meter on every start.
+     */
+    WcetTracker& GetWcetTracker();
+
+    /** Returns the governor stepping registered stages' quality with the
+     ** load. Its windows follow the block size on every start.
+     */
+    QualityGovernor& GetQualityGovernor();
+
+    /** micros() when the first callback since power-up ran, 0 until then */
+    uint32_t GetFirstBlockUs() const;
+
 
     class Impl;
 
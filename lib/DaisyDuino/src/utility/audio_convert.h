@@ -0,0 +1,605 @@
+#pragma once
+#ifndef DSY_AUDIO_CONVERT_H
+#define DSY_AUDIO_CONVERT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <string.h>
+#include "daisy_core.h"
+
+#ifdef USE_ARM_DSP
+#include "arm_math.h" // required for platform-optimized version
+#endif
+
+/** @addtogroup utility
+    @{
+*/
+
+namespace daisy
+{
+/** SAI sample word formats.
+
+    ToFloat scale, FromFloat scale and sign extension for each bit depth,
+    matching s162f/f2s16, s242f/f2s24 and s322f/f2s32 in daisy_core.h.
+    The 16 and 24 bit words arrive right-aligned and zero-padded.
+    kDitherShift places the dither's LSB: 32-bit words carry a 24-bit
+    converter's samples, so they are requantized to 24 bits.
+*/
+struct SaiFormat16
+{
+    static constexpr float kToFloat     = S162F_SCALE;
+    static constexpr float kFromFloat   = F2S16_SCALE;
+    static constexpr int   kDitherShift = 0;
+    static inline int32_t  Extend(int32_t x) { return (int16_t)x; }
+};
+
+struct SaiFormat24
+{
+    static constexpr float kToFloat     = S242F_SCALE;
+    static constexpr float kFromFloat   = F2S24_SCALE;
+    static constexpr int   kDitherShift = 0;
+    static inline int32_t  Extend(int32_t x) { return (x ^ S24SIGN) - S24SIGN; }
+};
+
+struct SaiFormat32
+{
+    static constexpr float kToFloat     = S322F_SCALE;
+    static constexpr float kFromFloat   = F2S32_SCALE;
+    static constexpr int   kDitherShift = 8;
+    static inline int32_t  Extend(int32_t x) { return x; }
+};
+
+/** Converts n SAI words to float, times gain.
+    The gain is folded into the format scale, so each sample costs one
+    convert and one multiply. Unrolled by 4.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void SaiToFloat(const int32_t* in, float* out, size_t n, float gain)
+{
+    const float scale = Format::kToFloat * gain;
+    size_t      i     = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        out[i]     = (float)Format::Extend(in[i]) * scale;
+        out[i + 1] = (float)Format::Extend(in[i + 1]) * scale;
+        out[i + 2] = (float)Format::Extend(in[i + 2]) * scale;
+        out[i + 3] = (float)Format::Extend(in[i + 3]) * scale;
+    }
+    for(; i < n; i++)
+    {
+        out[i] = (float)Format::Extend(in[i]) * scale;
+    }
+}
+
+/** Scales one float sample to a saturated SAI word.
+    Clamping after the scale gives the same limits as f2sXX in a single
+    min/max pair (VMINNM/VMAXNM on the M7).
+*/
+template <typename Format>
+FORCE_INLINE int32_t FloatToSaiWord(float x, float scale)
+{
+    constexpr float hi = FBIPMAX * Format::kFromFloat;
+    constexpr float lo = FBIPMIN * Format::kFromFloat;
+    float           v  = x * scale;
+    v                  = v <= lo ? lo : v;
+    v                  = v >= hi ? hi : v;
+    return (int32_t)v;
+}
+
+/** Converts n floats, times gain, to saturated SAI words. Unrolled by 4. */
+template <typename Format>
+DSY_ITCM_FUNC inline void FloatToSai(const float* in, int32_t* out, size_t n, float gain)
+{
+    const float scale = Format::kFromFloat * gain;
+    size_t      i     = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        out[i]     = FloatToSaiWord<Format>(in[i], scale);
+        out[i + 1] = FloatToSaiWord<Format>(in[i + 1], scale);
+        out[i + 2] = FloatToSaiWord<Format>(in[i + 2], scale);
+        out[i + 3] = FloatToSaiWord<Format>(in[i + 3], scale);
+    }
+    for(; i < n; i++)
+    {
+        out[i] = FloatToSaiWord<Format>(in[i], scale);
+    }
+}
+
+/** One output channel's noise-shaping memory for FloatToSaiDithered(),
+    in LSBs of the requantized word. */
+struct SaiDitherChannel
+{
+    float e1 = 0.f;
+    float e2 = 0.f;
+};
+
+/** Converts one channel, times gain, to saturated SAI words, with TPDF
+    dither of +-1 LSB and the total error shaped by (1 - z^-1)^order.
+
+    Each sample takes one xorshift32 step, whose two 16-bit halves
+    subtract to the triangular dither, and rounds with floorf (VRINTM on
+    the M7) rather than truncating. Order 1 and 2 feed the error back,
+    lowering the noise at low frequencies by 6 or 12 dB per octave and
+    raising it towards fs / 2; order 0 is flat TPDF, the better choice
+    when the programme itself sits near fs / 2. The error is taken
+    before the clamp, so a clipped sample cannot wind the loop up.
+
+    \param in first sample, then every in_stride-th
+    \param out first word, then every out_stride-th; SaiHalf for the
+        halves of packed 16-bit words
+    \param rng xorshift32 state, non-zero, shared by the channels
+*/
+template <typename Format, int order, typename Word = int32_t>
+DSY_ITCM_FUNC inline void FloatToSaiDithered(const float*      in,
+                                             size_t            in_stride,
+                                             Word*             out,
+                                             size_t            out_stride,
+                                             size_t            frames,
+                                             float             gain,
+                                             SaiDitherChannel& ch,
+                                             uint32_t&         rng)
+{
+    static_assert(order >= 0 && order <= 2, "shaping order 0, 1 or 2");
+    constexpr float lsb   = (float)(1 << Format::kDitherShift);
+    constexpr float hi    = FBIPMAX * Format::kFromFloat / lsb;
+    constexpr float lo    = FBIPMIN * Format::kFromFloat / lsb;
+    constexpr int   mul   = 1 << Format::kDitherShift;
+    const float     scale = Format::kFromFloat * gain / lsb;
+    float           e1 = ch.e1, e2 = ch.e2;
+    uint32_t        x = rng;
+    for(size_t i = 0; i < frames; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        const float d
+            = (float)((int32_t)(x & 0xffff) - (int32_t)(x >> 16)) * (1.f / 65536.f);
+        float w = in[i * in_stride] * scale;
+        if(order == 1)
+            w -= e1;
+        else if(order == 2)
+            w -= 2.f * e1 - e2;
+        const float r = floorf(w + d + 0.5f);
+        if(order == 2)
+            e2 = e1;
+        if(order >= 1)
+            e1 = r - w;
+        float q             = r <= lo ? lo : r;
+        q                   = q >= hi ? hi : q;
+        out[i * out_stride] = (Word)((int32_t)q * mul);
+    }
+    ch.e1 = e1;
+    ch.e2 = e2;
+    rng   = x;
+}
+
+/** Splits interleaved stereo SAI words into two float channels, times gain.
+    Unrolled by 4 frames.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void SaiDeinterleaveToFloat(const int32_t* in,
+                                   float*         l,
+                                   float*         r,
+                                   size_t         frames,
+                                   float          gain)
+{
+    const float scale = Format::kToFloat * gain;
+    size_t      i     = 0;
+    for(; i + 4 <= frames; i += 4)
+    {
+        l[i]     = (float)Format::Extend(in[2 * i]) * scale;
+        r[i]     = (float)Format::Extend(in[2 * i + 1]) * scale;
+        l[i + 1] = (float)Format::Extend(in[2 * i + 2]) * scale;
+        r[i + 1] = (float)Format::Extend(in[2 * i + 3]) * scale;
+        l[i + 2] = (float)Format::Extend(in[2 * i + 4]) * scale;
+        r[i + 2] = (float)Format::Extend(in[2 * i + 5]) * scale;
+        l[i + 3] = (float)Format::Extend(in[2 * i + 6]) * scale;
+        r[i + 3] = (float)Format::Extend(in[2 * i + 7]) * scale;
+    }
+    for(; i < frames; i++)
+    {
+        l[i] = (float)Format::Extend(in[2 * i]) * scale;
+        r[i] = (float)Format::Extend(in[2 * i + 1]) * scale;
+    }
+}
+
+/** Interleaves two float channels, times gain, into saturated stereo
+    SAI words. Unrolled by 4 frames.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void FloatToSaiInterleave(const float* l,
+                                 const float* r,
+                                 int32_t*     out,
+                                 size_t       frames,
+                                 float        gain)
+{
+    const float scale = Format::kFromFloat * gain;
+    size_t      i     = 0;
+    for(; i + 4 <= frames; i += 4)
+    {
+        out[2 * i]     = FloatToSaiWord<Format>(l[i], scale);
+        out[2 * i + 1] = FloatToSaiWord<Format>(r[i], scale);
+        out[2 * i + 2] = FloatToSaiWord<Format>(l[i + 1], scale);
+        out[2 * i + 3] = FloatToSaiWord<Format>(r[i + 1], scale);
+        out[2 * i + 4] = FloatToSaiWord<Format>(l[i + 2], scale);
+        out[2 * i + 5] = FloatToSaiWord<Format>(r[i + 2], scale);
+        out[2 * i + 6] = FloatToSaiWord<Format>(l[i + 3], scale);
+        out[2 * i + 7] = FloatToSaiWord<Format>(r[i + 3], scale);
+    }
+    for(; i < frames; i++)
+    {
+        out[2 * i]     = FloatToSaiWord<Format>(l[i], scale);
+        out[2 * i + 1] = FloatToSaiWord<Format>(r[i], scale);
+    }
+}
+
+/** Converts one channel of interleaved stereo SAI words to float, times
+    gain. in points at that channel's first word.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void
+SaiChannelToFloat(const int32_t* in, float* out, size_t frames, float gain)
+{
+    const float scale = Format::kToFloat * gain;
+    for(size_t i = 0; i < frames; i++)
+    {
+        out[i] = (float)Format::Extend(in[2 * i]) * scale;
+    }
+}
+
+/** Writes one float channel, times gain, into one channel of interleaved
+    stereo SAI words. out points at that channel's first word.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void
+FloatToSaiChannel(const float* in, int32_t* out, size_t frames, float gain)
+{
+    const float scale = Format::kFromFloat * gain;
+    for(size_t i = 0; i < frames; i++)
+    {
+        out[2 * i] = FloatToSaiWord<Format>(in[i], scale);
+    }
+}
+
+/** Converts one float channel, times gain, once per frame and writes it
+    to both channels of interleaved stereo SAI words.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void
+FloatToSaiFanout(const float* in, int32_t* out, size_t frames, float gain)
+{
+    const float scale = Format::kFromFloat * gain;
+    for(size_t i = 0; i < frames; i++)
+    {
+        const int32_t w = FloatToSaiWord<Format>(in[i], scale);
+        out[2 * i]      = w;
+        out[2 * i + 1]  = w;
+    }
+}
+
+/** Zeroes one channel of interleaved stereo SAI words. */
+DSY_ITCM_FUNC inline void SaiChannelClear(int32_t* out, size_t frames)
+{
+    for(size_t i = 0; i < frames; i++)
+    {
+        out[2 * i] = 0;
+    }
+}
+
+/** Merges two SAIs' interleaved stereo words into one float buffer of
+    4-channel frames { a0, a1, b0, b1, . . . }, times gain. Each frame
+    takes a word pair from each side in turn, so both reads and the
+    write stay sequential. Unrolled by 2 frames.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void SaiMergePairsToFloat(const int32_t* a,
+                                               const int32_t* b,
+                                               float*         out,
+                                               size_t         frames,
+                                               float          gain)
+{
+    const float scale = Format::kToFloat * gain;
+    size_t      i     = 0;
+    for(; i + 2 <= frames; i += 2)
+    {
+        out[4 * i]     = (float)Format::Extend(a[2 * i]) * scale;
+        out[4 * i + 1] = (float)Format::Extend(a[2 * i + 1]) * scale;
+        out[4 * i + 2] = (float)Format::Extend(b[2 * i]) * scale;
+        out[4 * i + 3] = (float)Format::Extend(b[2 * i + 1]) * scale;
+        out[4 * i + 4] = (float)Format::Extend(a[2 * i + 2]) * scale;
+        out[4 * i + 5] = (float)Format::Extend(a[2 * i + 3]) * scale;
+        out[4 * i + 6] = (float)Format::Extend(b[2 * i + 2]) * scale;
+        out[4 * i + 7] = (float)Format::Extend(b[2 * i + 3]) * scale;
+    }
+    for(; i < frames; i++)
+    {
+        out[4 * i]     = (float)Format::Extend(a[2 * i]) * scale;
+        out[4 * i + 1] = (float)Format::Extend(a[2 * i + 1]) * scale;
+        out[4 * i + 2] = (float)Format::Extend(b[2 * i]) * scale;
+        out[4 * i + 3] = (float)Format::Extend(b[2 * i + 1]) * scale;
+    }
+}
+
+/** The reverse of SaiMergePairsToFloat(): 4-channel float frames, times
+    gain, split into two SAIs' saturated stereo words. Unrolled by 2
+    frames.
+*/
+template <typename Format>
+DSY_ITCM_FUNC inline void FloatToSaiSplitPairs(const float* in,
+                                               int32_t*     a,
+                                               int32_t*     b,
+                                               size_t       frames,
+                                               float        gain)
+{
+    const float scale = Format::kFromFloat * gain;
+    size_t      i     = 0;
+    for(; i + 2 <= frames; i += 2)
+    {
+        a[2 * i]     = FloatToSaiWord<Format>(in[4 * i], scale);
+        a[2 * i + 1] = FloatToSaiWord<Format>(in[4 * i + 1], scale);
+        b[2 * i]     = FloatToSaiWord<Format>(in[4 * i + 2], scale);
+        b[2 * i + 1] = FloatToSaiWord<Format>(in[4 * i + 3], scale);
+        a[2 * i + 2] = FloatToSaiWord<Format>(in[4 * i + 4], scale);
+        a[2 * i + 3] = FloatToSaiWord<Format>(in[4 * i + 5], scale);
+        b[2 * i + 2] = FloatToSaiWord<Format>(in[4 * i + 6], scale);
+        b[2 * i + 3] = FloatToSaiWord<Format>(in[4 * i + 7], scale);
+    }
+    for(; i < frames; i++)
+    {
+        a[2 * i]     = FloatToSaiWord<Format>(in[4 * i], scale);
+        a[2 * i + 1] = FloatToSaiWord<Format>(in[4 * i + 1], scale);
+        b[2 * i]     = FloatToSaiWord<Format>(in[4 * i + 2], scale);
+        b[2 * i + 1] = FloatToSaiWord<Format>(in[4 * i + 3], scale);
+    }
+}
+
+/** One 16-bit half of a packed SAI word (SaiHandle::Config::packed16),
+    allowed to alias the int32_t buffers. */
+typedef int16_t __attribute__((__may_alias__)) SaiHalf;
+
+/** Packs two saturated 16-bit samples into one word, a in the low half */
+FORCE_INLINE int32_t SaiPack16(int32_t a, int32_t b)
+{
+    return (int32_t)(((uint32_t)a & 0xffffu) | ((uint32_t)b << 16));
+}
+
+/** Converts n packed 16-bit words to 2 * n floats in order, times gain:
+    a sign extend of the low half and an arithmetic shift of the high
+    one, then a convert and multiply each. Unrolled by 2 words.
+*/
+DSY_ITCM_FUNC inline void
+SaiUnpack16ToFloat(const int32_t* in, float* out, size_t n, float gain)
+{
+    const float scale = SaiFormat16::kToFloat * gain;
+    size_t      i     = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        const int32_t w0 = in[i], w1 = in[i + 1];
+        out[2 * i]       = (float)(int16_t)w0 * scale;
+        out[2 * i + 1]   = (float)(w0 >> 16) * scale;
+        out[2 * i + 2]   = (float)(int16_t)w1 * scale;
+        out[2 * i + 3]   = (float)(w1 >> 16) * scale;
+    }
+    for(; i < n; i++)
+    {
+        out[2 * i]     = (float)(int16_t)in[i] * scale;
+        out[2 * i + 1] = (float)(in[i] >> 16) * scale;
+    }
+}
+
+/** Converts 2 * n floats in order, times gain, to n packed words */
+DSY_ITCM_FUNC inline void
+FloatToSaiPack16(const float* in, int32_t* out, size_t n, float gain)
+{
+    const float scale = SaiFormat16::kFromFloat * gain;
+    for(size_t i = 0; i < n; i++)
+    {
+        out[i] = SaiPack16(FloatToSaiWord<SaiFormat16>(in[2 * i], scale),
+                           FloatToSaiWord<SaiFormat16>(in[2 * i + 1], scale));
+    }
+}
+
+/** Splits packed stereo words into two float channels, times gain. A
+    nullptr channel is skipped. */
+DSY_ITCM_FUNC inline void SaiUnpack16Deinterleave(const int32_t* in,
+                                                  float*         l,
+                                                  float*         r,
+                                                  size_t         frames,
+                                                  float          gain)
+{
+    const float scale = SaiFormat16::kToFloat * gain;
+    if(l && r)
+    {
+        for(size_t i = 0; i < frames; i++)
+        {
+            l[i] = (float)(int16_t)in[i] * scale;
+            r[i] = (float)(in[i] >> 16) * scale;
+        }
+    }
+    else if(l)
+    {
+        for(size_t i = 0; i < frames; i++)
+            l[i] = (float)(int16_t)in[i] * scale;
+    }
+    else if(r)
+    {
+        for(size_t i = 0; i < frames; i++)
+            r[i] = (float)(in[i] >> 16) * scale;
+    }
+}
+
+/** Packs two float channels, times gain, into stereo words. A nullptr
+    channel is written as silence; l == r fans one channel out. */
+DSY_ITCM_FUNC inline void FloatInterleaveToSaiPack16(const float* l,
+                                                     const float* r,
+                                                     int32_t*     out,
+                                                     size_t       frames,
+                                                     float        gain)
+{
+    const float scale = SaiFormat16::kFromFloat * gain;
+    if(l && r)
+    {
+        for(size_t i = 0; i < frames; i++)
+        {
+            out[i] = SaiPack16(FloatToSaiWord<SaiFormat16>(l[i], scale),
+                               FloatToSaiWord<SaiFormat16>(r[i], scale));
+        }
+    }
+    else if(l)
+    {
+        for(size_t i = 0; i < frames; i++)
+            out[i] = SaiPack16(FloatToSaiWord<SaiFormat16>(l[i], scale), 0);
+    }
+    else if(r)
+    {
+        for(size_t i = 0; i < frames; i++)
+            out[i] = SaiPack16(0, FloatToSaiWord<SaiFormat16>(r[i], scale));
+    }
+    else
+        memset(out, 0, frames * sizeof(int32_t));
+}
+
+/** SaiMergePairsToFloat() from two SAIs' packed stereo words */
+DSY_ITCM_FUNC inline void SaiMergePacked16ToFloat(const int32_t* a,
+                                                  const int32_t* b,
+                                                  float*         out,
+                                                  size_t         frames,
+                                                  float          gain)
+{
+    const float scale = SaiFormat16::kToFloat * gain;
+    for(size_t i = 0; i < frames; i++)
+    {
+        const int32_t wa = a[i], wb = b[i];
+        out[4 * i]       = (float)(int16_t)wa * scale;
+        out[4 * i + 1]   = (float)(wa >> 16) * scale;
+        out[4 * i + 2]   = (float)(int16_t)wb * scale;
+        out[4 * i + 3]   = (float)(wb >> 16) * scale;
+    }
+}
+
+/** FloatToSaiSplitPairs() into two SAIs' packed stereo words */
+DSY_ITCM_FUNC inline void FloatToSaiSplitPacked16(const float* in,
+                                                  int32_t*     a,
+                                                  int32_t*     b,
+                                                  size_t       frames,
+                                                  float        gain)
+{
+    const float scale = SaiFormat16::kFromFloat * gain;
+    for(size_t i = 0; i < frames; i++)
+    {
+        a[i] = SaiPack16(FloatToSaiWord<SaiFormat16>(in[4 * i], scale),
+                         FloatToSaiWord<SaiFormat16>(in[4 * i + 1], scale));
+        b[i] = SaiPack16(FloatToSaiWord<SaiFormat16>(in[4 * i + 2], scale),
+                         FloatToSaiWord<SaiFormat16>(in[4 * i + 3], scale));
+    }
+}
+
+/** SaiRampInterleaved() on packed stereo frames, one word each */
+DSY_ITCM_FUNC inline void
+SaiRampPacked16(int32_t* buf, size_t frames, float g0, float g1)
+{
+    const float inc = (g1 - g0) / (float)frames;
+    float       g   = g0;
+    for(size_t i = 0; i < frames; i++)
+    {
+        const int32_t w = buf[i];
+        buf[i]          = SaiPack16((int32_t)((float)(int16_t)w * g),
+                                    (int32_t)((float)(w >> 16) * g));
+        g += inc;
+    }
+}
+
+/** Splits TDM SAI words, slots per frame, into one float channel per
+    slot, times gain. A nullptr channel is skipped.
+*/
+template <typename Format, size_t slots>
+DSY_ITCM_FUNC inline void SaiSlotsToFloat(const int32_t* in,
+                                          float* const*  out,
+                                          size_t         frames,
+                                          float          gain)
+{
+    const float scale = Format::kToFloat * gain;
+    for(size_t s = 0; s < slots; s++)
+    {
+        float* o = out[s];
+        if(o == nullptr)
+            continue;
+        const int32_t* w = in + s;
+        for(size_t i = 0; i < frames; i++)
+        {
+            o[i] = (float)Format::Extend(w[slots * i]) * scale;
+        }
+    }
+}
+
+/** Writes one float channel per slot, times gain, into saturated TDM SAI
+    words. A slot whose mask bit is clear is zeroed. With fanout, each
+    even channel drives its own slot and the odd one after it.
+*/
+template <typename Format, size_t slots>
+DSY_ITCM_FUNC inline void FloatToSaiSlots(const float* const* in,
+                                          int32_t*            out,
+                                          size_t              frames,
+                                          float               gain,
+                                          uint8_t             mask,
+                                          bool                fanout)
+{
+    const float scale = Format::kFromFloat * gain;
+    for(size_t s = 0; s < slots; s++)
+    {
+        const size_t src = fanout ? (s & ~(size_t)1) : s;
+        int32_t*     w   = out + s;
+        if(((mask >> src) & 1) == 0)
+        {
+            for(size_t i = 0; i < frames; i++)
+                w[slots * i] = 0;
+            continue;
+        }
+        const float* x = in[src];
+        for(size_t i = 0; i < frames; i++)
+        {
+            w[slots * i] = FloatToSaiWord<Format>(x[i], scale);
+        }
+    }
+}
+
+/** Multiplies interleaved SAI words, slots per frame, in place, by a
+    gain that moves linearly from g0 towards g1 across the frames. Used
+    to fade the output around DMA restarts.
+*/
+template <typename Format, size_t slots = 2>
+DSY_ITCM_FUNC inline void SaiRampInterleaved(int32_t* buf, size_t frames, float g0, float g1)
+{
+    const float inc = (g1 - g0) / (float)frames;
+    float       g   = g0;
+    for(size_t i = 0; i < frames; i++)
+    {
+        for(size_t s = 0; s < slots; s++)
+        {
+            int32_t& w = buf[slots * i + s];
+            w          = (int32_t)((float)Format::Extend(w) * g);
+        }
+        g += inc;
+    }
+}
+
+#if(defined(USE_ARM_DSP) && defined(__arm__))
+/** 32-bit words are already Q31, so the contiguous input conversion maps
+    onto CMSIS directly. The output side stays generic: arm_float_to_q31
+    saturates at full scale rather than at FBIPMAX.
+*/
+template <>
+DSY_ITCM_FUNC inline void
+SaiToFloat<SaiFormat32>(const int32_t* in, float* out, size_t n, float gain)
+{
+    arm_q31_to_float(const_cast<q31_t*>(in), out, n);
+    if(gain != 1.0f)
+        arm_scale_f32(out, gain, out, n);
+}
+#endif
+
+} // namespace daisy
+
+/** @} */
+#endif
@@ -0,0 +1,231 @@
+#include "audio_graph.h"
+#include <string.h>
+
+using namespace daisy;
+
+void AudioGraph::Init()
+{
+    num_nodes_   = 0;
+    num_buffers_ = 0;
+    max_block_   = 0;
+    compiled_    = false;
+    mem_         = nullptr;
+    for(size_t c = 0; c < kMaxChannels; c++)
+        out_wire_[c] = {Ref::NONE, 0, 0};
+}
+
+int AudioGraph::AddNode(const char* name,
+                        NodeFn      fn,
+                        void*       ctx,
+                        size_t      num_in,
+                        size_t      num_out)
+{
+    if(num_nodes_ >= kMaxNodes || fn == nullptr || num_in > kMaxPorts
+       || num_out > kMaxPorts)
+        return -1;
+    Node& n   = nodes_[num_nodes_];
+    n.fn      = fn;
+    n.ctx     = ctx;
+    n.name    = name;
+    n.num_in  = static_cast<uint8_t>(num_in);
+    n.num_out = static_cast<uint8_t>(num_out);
+    for(size_t p = 0; p < kMaxPorts; p++)
+        n.wire[p] = {Ref::NONE, 0, 0};
+    compiled_ = false;
+    return static_cast<int>(num_nodes_++);
+}
+
+AudioGraph::Result
+AudioGraph::Connect(int src, size_t out_port, int dst, size_t in_port)
+{
+    if(src < 0 || dst < 0 || (size_t)src >= num_nodes_
+       || (size_t)dst >= num_nodes_ || out_port >= nodes_[src].num_out
+       || in_port >= nodes_[dst].num_in)
+        return Result::ERR;
+    nodes_[dst].wire[in_port]
+        = {Ref::NODE, static_cast<uint8_t>(src), static_cast<uint8_t>(out_port)};
+    compiled_ = false;
+    return Result::OK;
+}
+
+AudioGraph::Result AudioGraph::ConnectInput(size_t channel, int dst, size_t in_port)
+{
+    if(channel >= kMaxChannels || dst < 0 || (size_t)dst >= num_nodes_
+       || in_port >= nodes_[dst].num_in)
+        return Result::ERR;
+    nodes_[dst].wire[in_port] = {Ref::INPUT, static_cast<uint8_t>(channel), 0};
+    compiled_                 = false;
+    return Result::OK;
+}
+
+AudioGraph::Result AudioGraph::ConnectOutput(int src, size_t out_port, size_t channel)
+{
+    if(channel >= kMaxChannels || src < 0 || (size_t)src >= num_nodes_
+       || out_port >= nodes_[src].num_out)
+        return Result::ERR;
+    out_wire_[channel]
+        = {Ref::NODE, static_cast<uint8_t>(src), static_cast<uint8_t>(out_port)};
+    compiled_ = false;
+    return Result::OK;
+}
+
+AudioGraph::Result AudioGraph::Compile(size_t max_block)
+{
+    compiled_  = false;
+    max_block_ = max_block;
+    if(max_block == 0)
+        return Result::ERR;
+
+    // Order: the lowest-numbered node whose sources have all run, until
+    // none is left; one that never gets there is on a cycle.
+    uint8_t step_of[kMaxNodes];
+    bool    done[kMaxNodes] = {};
+    for(size_t s = 0; s < num_nodes_; s++)
+    {
+        size_t pick = num_nodes_;
+        for(size_t i = 0; i < num_nodes_ && pick == num_nodes_; i++)
+        {
+            if(done[i])
+                continue;
+            bool ready = true;
+            for(size_t p = 0; p < nodes_[i].num_in; p++)
+            {
+                const Ref& w = nodes_[i].wire[p];
+                if(w.kind == Ref::NODE && !done[w.index])
+                    ready = false;
+            }
+            if(ready)
+                pick = i;
+        }
+        if(pick == num_nodes_)
+            return Result::ERR;
+        done[pick]    = true;
+        order_[s]     = static_cast<uint8_t>(pick);
+        step_of[pick] = static_cast<uint8_t>(s);
+    }
+
+    // Each output lives from its own step to its last reader's.
+    uint8_t last_use[kMaxNodes][kMaxPorts];
+    for(size_t i = 0; i < num_nodes_; i++)
+    {
+        for(size_t p = 0; p < kMaxPorts; p++)
+        {
+            last_use[i][p] = step_of[i];
+            nodes_[i].out[p] = {Ref::NONE, 0, 0};
+        }
+    }
+    for(size_t i = 0; i < num_nodes_; i++)
+    {
+        for(size_t p = 0; p < nodes_[i].num_in; p++)
+        {
+            const Ref& w = nodes_[i].wire[p];
+            if(w.kind == Ref::NODE && last_use[w.index][w.port] < step_of[i])
+                last_use[w.index][w.port] = step_of[i];
+        }
+    }
+
+    // An output going to the graph lives in the first channel it goes
+    // to; any further channel copies from there after the last node.
+    for(size_t c = 0; c < kMaxChannels; c++)
+    {
+        outputs_[c]  = {Ref::NONE, 0, 0};
+        copy_out_[c] = false;
+        const Ref& w = out_wire_[c];
+        if(w.kind != Ref::NODE)
+            continue;
+        Ref& o = nodes_[w.index].out[w.port];
+        if(o.kind == Ref::NONE)
+            o = {Ref::OUTPUT, static_cast<uint8_t>(c), 0};
+        else
+            copy_out_[c] = true;
+        outputs_[c] = o;
+    }
+
+    // Scratch in schedule order, each buffer free again after its
+    // holder's last reader: for intervals, as few as are ever alive.
+    uint8_t busy_until[kMaxNodes * kMaxPorts];
+    size_t  buffers = 0;
+    for(size_t s = 0; s < num_nodes_; s++)
+    {
+        Node& n = nodes_[order_[s]];
+        for(size_t p = 0; p < n.num_out; p++)
+        {
+            if(n.out[p].kind != Ref::NONE)
+                continue;
+            size_t b = 0;
+            while(b < buffers && busy_until[b] >= s)
+                b++;
+            if(b == buffers)
+                buffers++;
+            busy_until[b] = last_use[order_[s]][p];
+            n.out[p]      = {Ref::SCRATCH, static_cast<uint8_t>(b), 0};
+        }
+    }
+    num_buffers_ = buffers;
+
+    for(size_t i = 0; i < num_nodes_; i++)
+    {
+        Node& n = nodes_[i];
+        for(size_t p = 0; p < n.num_in; p++)
+        {
+            const Ref& w = n.wire[p];
+            if(w.kind == Ref::NODE)
+                n.in[p] = nodes_[w.index].out[w.port];
+            else if(w.kind == Ref::INPUT)
+                n.in[p] = w;
+            else
+                n.in[p] = {Ref::SILENCE, 0, 0};
+        }
+    }
+    compiled_ = true;
+    mem_      = nullptr;
+    return Result::OK;
+}
+
+AudioGraph::Result AudioGraph::SetMemory(float* mem, size_t size)
+{
+    if(!compiled_ || mem == nullptr || size < GetMemorySize())
+        return Result::ERR;
+    mem_ = mem;
+    memset(mem_ + num_buffers_ * max_block_, 0, max_block_ * sizeof(float));
+    return Result::OK;
+}
+
+const float*
+AudioGraph::Read(const Ref& r, const float* const* in, float* const* out) const
+{
+    switch(r.kind)
+    {
+        case Ref::INPUT: return in[r.index];
+        case Ref::SCRATCH: return mem_ + r.index * max_block_;
+        case Ref::OUTPUT: return out[r.index];
+        default: return mem_ + num_buffers_ * max_block_;
+    }
+}
+
+float* AudioGraph::Write(const Ref& r, float* const* out) const
+{
+    return r.kind == Ref::OUTPUT ? out[r.index] : mem_ + r.index * max_block_;
+}
+
+void AudioGraph::Process(const float* const* in, float* const* out, size_t size)
+{
+    if(mem_ == nullptr || size > max_block_)
+        return;
+    for(size_t s = 0; s < num_nodes_; s++)
+    {
+        const Node&  n = nodes_[order_[s]];
+        const float* ins[kMaxPorts];
+        float*       outs[kMaxPorts];
+        for(size_t p = 0; p < n.num_in; p++)
+            ins[p] = Read(n.in[p], in, out);
+        for(size_t p = 0; p < n.num_out; p++)
+            outs[p] = Write(n.out[p], out);
+        n.fn(n.ctx, ins, outs, size);
+    }
+    for(size_t c = 0; c < kMaxChannels; c++)
+    {
+        if(copy_out_[c])
+            memcpy(out[c], Read(outputs_[c], in, out), size * sizeof(float));
+    }
+}
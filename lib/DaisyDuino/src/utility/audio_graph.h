@@ -0,0 +1,181 @@
+#pragma once
+#ifndef DSY_AUDIO_GRAPH_H
+#define DSY_AUDIO_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace daisy
+{
+/** A patch of block-processing nodes, scheduled once at setup.
+
+    Each node is a function over one block, with up to kMaxPorts inputs
+    and outputs, usually a DaisySP module's ProcessBlock() through
+    Filter<> or Source<>. Connect() wires an output to any number of
+    inputs; ConnectInput() and ConnectOutput() wire the graph's own
+    channels. Compile() then:
+
+    - sorts the nodes so each runs after everything it reads, in the
+      order they were added where the wiring leaves a choice, and
+      fails on a cycle;
+    - works out when each output is last read, and assigns it a scratch
+      buffer no output alive at the same time has: the buffers are
+      handed out in schedule order and taken back after their last
+      reader, which for lifetimes like these needs no more than the
+      most outputs ever alive at once, the fewest possible;
+    - writes straight to the graph's output buffer for an output that
+      only goes there, so the last stage of a chain needs no scratch.
+
+    GetMemorySize() is then what SetMemory() needs, e.g. from MemPools
+    in DTCM. Process() just runs the schedule: no sorting, searching
+    or allocation per block.
+
+    A node must not write its inputs, which may be shared with other
+    readers; inputs left unconnected read silence. The graph's output
+    buffers must not alias its inputs.
+
+    usage:
+
+    static AudioGraph graph;
+    graph.Init();
+    const int osc = graph.AddNode("osc", AudioGraph::Source<Oscillator>, &o, 0, 1);
+    const int lp  = graph.AddNode("lp", AudioGraph::Filter<Biquad>, &bq, 1, 1);
+    const int vca = graph.AddNode("vca", Multiply, nullptr, 2, 1);
+    graph.Connect(osc, 0, lp, 0);
+    graph.Connect(lp, 0, vca, 0);
+    graph.ConnectInput(0, vca, 1);
+    graph.ConnectOutput(vca, 0, 0);
+    graph.Compile(48);
+    graph.SetMemory(mem.AllocateFastest<float>(MemTier::DTCM,
+                                               graph.GetMemorySize()),
+                    graph.GetMemorySize());
+    ...
+    graph.Process(in, out, size); // AudioCallback
+*/
+class AudioGraph
+{
+  public:
+    enum class Result
+    {
+        OK,
+        ERR,
+    };
+
+    static constexpr size_t kMaxNodes    = 32;
+    static constexpr size_t kMaxPorts    = 4;
+    static constexpr size_t kMaxChannels = 8;
+
+    /** One block of a node: in[num_in], out[num_out], size samples */
+    typedef void (*NodeFn)(void*               ctx,
+                           const float* const* in,
+                           float* const*       out,
+                           size_t              size);
+
+    /** A module with ProcessBlock(const float* in, float* out, size) */
+    template <class Module>
+    static void Filter(void* ctx, const float* const* in, float* const* out, size_t size)
+    {
+        static_cast<Module*>(ctx)->ProcessBlock(in[0], out[0], size);
+    }
+
+    /** A module with ProcessBlock(float* out, size) */
+    template <class Module>
+    static void Source(void* ctx, const float* const*, float* const* out, size_t size)
+    {
+        static_cast<Module*>(ctx)->ProcessBlock(out[0], size);
+    }
+
+    AudioGraph() {}
+    ~AudioGraph() {}
+
+    /** Empties the graph */
+    void Init();
+
+    /** \return the new node's index, or -1 if kMaxNodes are added or
+        a port count is over kMaxPorts
+    */
+    int AddNode(const char* name,
+                NodeFn      fn,
+                void*       ctx,
+                size_t      num_in,
+                size_t      num_out);
+
+    /** Feeds input in_port of node dst from output out_port of node src,
+        replacing what fed it before
+    */
+    Result Connect(int src, size_t out_port, int dst, size_t in_port);
+
+    /** Feeds input in_port of node dst from the graph's input channel */
+    Result ConnectInput(size_t channel, int dst, size_t in_port);
+
+    /** Sends output out_port of node src to the graph's output channel */
+    Result ConnectOutput(int src, size_t out_port, size_t channel);
+
+    /** Schedules the nodes and assigns the buffers, for blocks of up to
+        max_block samples. ERR on a cycle.
+    */
+    Result Compile(size_t max_block);
+
+    /** \return floats of scratch the compiled graph needs */
+    inline size_t GetMemorySize() const
+    {
+        return (num_buffers_ + 1) * max_block_;
+    }
+
+    /** \return scratch buffers after Compile(), not counting silence */
+    inline size_t GetNumBuffers() const { return num_buffers_; }
+
+    /** Hands the graph its scratch, GetMemorySize() floats or more */
+    Result SetMemory(float* mem, size_t size);
+
+    /** Runs every node once on in, filling out. Output channels nothing
+        is connected to are left alone.
+        \param size up to the max_block of Compile()
+    */
+    void Process(const float* const* in, float* const* out, size_t size);
+
+  private:
+    /** Where a port's samples are */
+    struct Ref
+    {
+        enum Kind : uint8_t
+        {
+            NONE,     /**< unconnected */
+            NODE,     /**< index: node, port: its output */
+            INPUT,    /**< index: the graph's input channel */
+            SCRATCH,  /**< index: buffer */
+            OUTPUT,   /**< index: the graph's output channel */
+            SILENCE,
+        };
+        Kind    kind;
+        uint8_t index;
+        uint8_t port;
+    };
+
+    struct Node
+    {
+        NodeFn      fn;
+        void*       ctx;
+        const char* name;
+        uint8_t     num_in, num_out;
+        Ref         wire[kMaxPorts]; /**< what feeds each input */
+        Ref         in[kMaxPorts];   /**< where Compile() put it */
+        Ref         out[kMaxPorts];
+    };
+
+    const float* Read(const Ref& r, const float* const* in, float* const* out) const;
+    float*       Write(const Ref& r, float* const* out) const;
+
+    Node    nodes_[kMaxNodes];
+    size_t  num_nodes_;
+    uint8_t order_[kMaxNodes];
+    Ref     out_wire_[kMaxChannels];
+    Ref     outputs_[kMaxChannels]; /**< where Compile() put them */
+    bool    copy_out_[kMaxChannels];
+    size_t  num_buffers_, max_block_;
+    bool    compiled_;
+    float*  mem_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,150 @@
+#include "audio_stream.h"
+#include "daisy_core.h"
+#include <atomic>
+#include <string.h>
+
+using namespace daisy;
+
+bool AudioStream::Init(float* capture,
+                       float* playback,
+                       size_t ring_frames,
+                       size_t channels,
+                       size_t latency_frames)
+{
+    if(channels == 0 || ring_frames < 2
+       || (ring_frames & (ring_frames - 1)) != 0)
+        return false;
+    capture_    = capture;
+    playback_   = playback;
+    frames_     = ring_frames;
+    channels_   = channels;
+    cap_head_   = 0;
+    cap_tail_   = 0;
+    play_head_  = 0;
+    play_tail_  = 0;
+    primed_     = false;
+    underruns_  = 0;
+    overruns_   = 0;
+    SetLatency(latency_frames);
+    return true;
+}
+
+void AudioStream::SetLatency(size_t frames)
+{
+    latency_ = frames < frames_ ? frames : frames_;
+}
+
+// At most two copies: up to the end of the ring, then from its start.
+DSY_ITCM_FUNC void AudioStream::CopyIn(float*       ring,
+                                       uint32_t     at,
+                                       const float* src,
+                                       size_t       frames)
+{
+    const size_t start = at & (frames_ - 1);
+    const size_t first = frames < frames_ - start ? frames : frames_ - start;
+    memcpy(ring + start * channels_, src, first * channels_ * sizeof(float));
+    memcpy(ring,
+           src + first * channels_,
+           (frames - first) * channels_ * sizeof(float));
+}
+
+DSY_ITCM_FUNC void AudioStream::CopyOut(const float* ring,
+                                        uint32_t     at,
+                                        float*       dst,
+                                        size_t       frames) const
+{
+    const size_t start = at & (frames_ - 1);
+    const size_t first = frames < frames_ - start ? frames : frames_ - start;
+    memcpy(dst, ring + start * channels_, first * channels_ * sizeof(float));
+    memcpy(dst + first * channels_,
+           ring,
+           (frames - first) * channels_ * sizeof(float));
+}
+
+DSY_ITCM_FUNC void AudioStream::Process(const float* in, float* out, size_t size)
+{
+    const size_t frames = size / channels_;
+    if(capture_ != nullptr)
+    {
+        // A whole block or none, so the channels never shift.
+        const uint32_t head = cap_head_;
+        if(frames_ - (head - cap_tail_) >= frames)
+        {
+            CopyIn(capture_, head, in, frames);
+            std::atomic_signal_fence(std::memory_order_release);
+            cap_head_ = head + frames;
+        }
+        else
+        {
+            overruns_ = overruns_ + 1;
+        }
+    }
+
+    if(playback_ == nullptr)
+    {
+        memset(out, 0, size * sizeof(float));
+        return;
+    }
+    const uint32_t tail = play_tail_;
+    const size_t   fill = play_head_ - tail;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    if(!primed_)
+    {
+        // Fill up to the latency first rather than click every block.
+        primed_ = fill >= latency_ && fill >= frames;
+        if(!primed_)
+        {
+            memset(out, 0, size * sizeof(float));
+            return;
+        }
+    }
+    const size_t n = fill < frames ? fill : frames;
+    CopyOut(playback_, tail, out, n);
+    memset(out + n * channels_, 0, (size - n * channels_) * sizeof(float));
+    std::atomic_signal_fence(std::memory_order_release);
+    play_tail_ = tail + n;
+    if(n < frames)
+    {
+        underruns_ = underruns_ + 1;
+        primed_    = false;
+    }
+}
+
+size_t AudioStream::ReadAvailable() const
+{
+    return capture_ != nullptr ? cap_head_ - cap_tail_ : 0;
+}
+
+size_t AudioStream::Read(float* dst, size_t frames)
+{
+    const uint32_t tail  = cap_tail_;
+    const size_t   avail = ReadAvailable();
+    const size_t   n     = frames < avail ? frames : avail;
+    if(n == 0)
+        return 0;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    CopyOut(capture_, tail, dst, n);
+    std::atomic_signal_fence(std::memory_order_release);
+    cap_tail_ = tail + n;
+    return n;
+}
+
+size_t AudioStream::WriteAvailable() const
+{
+    if(playback_ == nullptr)
+        return 0;
+    return frames_ - (play_head_ - play_tail_);
+}
+
+size_t AudioStream::Write(const float* src, size_t frames)
+{
+    const uint32_t head  = play_head_;
+    const size_t   avail = WriteAvailable();
+    const size_t   n     = frames < avail ? frames : avail;
+    if(n == 0)
+        return 0;
+    CopyIn(playback_, head, src, n);
+    std::atomic_signal_fence(std::memory_order_release);
+    play_head_ = head + n;
+    return n;
+}
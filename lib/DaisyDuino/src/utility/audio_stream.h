@@ -0,0 +1,131 @@
+#pragma once
+#ifndef DSY_AUDIO_STREAM_H
+#define DSY_AUDIO_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace daisy
+{
+/** Pull-mode audio: the callback only moves samples between the DMA
+    side and two rings, and the processing runs elsewhere, in large
+    chunks.
+
+    Spectral analysis, SD playback or a long FIR run better on 1024
+    frames at a time than on the callback's 48. With a stream, the
+    interleaving callback hands each block to Process(). Process()
+    copies the input into the capture ring and the output out of the
+    playback ring, never more. A lower context (loop(), a TaskRunner
+    task, the control callback) Read()s the captured frames in whatever
+    size suits it, works on them, and Write()s the results back.
+
+    Each ring has one writer and one reader, so neither side locks; the
+    indices count frames and the copies are memcpy, two at most per
+    call across the wrap.
+
+    Latency is SetLatency() frames plus one block: Process() plays
+    silence until the playback ring first holds that much, as after
+    every underrun. A producer that turns each captured chunk straight
+    around keeps the fill there from then on, since both rings move at
+    the sample rate. Working in chunks of C frames it needs a latency
+    of at least C plus one block; the margin over that is how late it
+    may run. A player with nothing captured may simply keep the ring
+    full. GetUnderruns() counts blocks the playback ring came up short
+    for, GetOverruns() input blocks dropped to a full capture ring.
+
+    Either ring may be left out: capture only for analysis, playback
+    only for a file player. Process() from the audio callback,
+    everything else from one lower context. The rings are the
+    caller's, ring_frames interleaved frames of channels floats each,
+    ring_frames a power of two: SDRAM or AXI SRAM for long ones.
+
+    usage:
+
+    static float DSY_SDRAM_BSS cap[2 * 4096], play[2 * 4096];
+    static AudioStream stream;
+    stream.Init(cap, play, 4096, 2, 2048);
+    ...
+    // interleaving audio callback
+    stream.Process(in, out, size);
+    ...
+    // loop()
+    while(stream.ReadAvailable() >= 1024)
+    {
+        stream.Read(chunk, 1024);
+        ... // process chunk
+        stream.Write(chunk, 1024);
+    }
+*/
+class AudioStream
+{
+  public:
+    AudioStream() {}
+    ~AudioStream() {}
+
+    /** Sets up both rings, empty, and the counters cleared.
+        \param capture input ring, nullptr for none
+        \param playback output ring, nullptr for none
+        \param ring_frames frames in each ring, a power of two
+        \param channels samples per frame, AudioChannels()
+        \param latency_frames see SetLatency()
+        \return false, and no ring set up, if ring_frames is not a
+            power of two or channels is 0
+    */
+    bool Init(float* capture,
+              float* playback,
+              size_t ring_frames,
+              size_t channels,
+              size_t latency_frames);
+
+    /** From the interleaving callback: its in and out, size samples.
+        Without a playback ring, out is zeroed. */
+    void Process(const float* in, float* out, size_t size);
+
+    /** Captured frames waiting for Read() */
+    size_t ReadAvailable() const;
+
+    /** Moves up to frames captured frames into dst, interleaved.
+        \return frames moved */
+    size_t Read(float* dst, size_t frames);
+
+    /** Frames Write() takes now: the ring's free space */
+    size_t WriteAvailable() const;
+
+    /** Queues up to frames interleaved frames from src for playback.
+        \return frames queued */
+    size_t Write(const float* src, size_t frames);
+
+    /** The playback fill Process() waits for before it starts, at most
+        the ring size. Takes effect at the next start or underrun. */
+    void SetLatency(size_t frames);
+
+    inline size_t GetLatency() const { return latency_; }
+
+    /** Frames waiting to play */
+    inline size_t GetPlaybackFill() const { return play_head_ - play_tail_; }
+
+    /** Blocks the playback ring could not fill, since Init() */
+    inline uint32_t GetUnderruns() const { return underruns_; }
+
+    /** Input blocks dropped to a full capture ring, since Init() */
+    inline uint32_t GetOverruns() const { return overruns_; }
+
+  private:
+    void CopyIn(float* ring, uint32_t at, const float* src, size_t frames);
+    void CopyOut(const float* ring, uint32_t at, float* dst, size_t frames)
+        const;
+
+    float*            capture_  = nullptr;
+    float*            playback_ = nullptr;
+    size_t            frames_   = 0;
+    size_t            channels_ = 1;
+    volatile size_t   latency_  = 0;
+    volatile uint32_t cap_head_ = 0, cap_tail_ = 0;
+    volatile uint32_t play_head_ = 0, play_tail_ = 0;
+    volatile bool     primed_    = false;
+    volatile uint32_t underruns_ = 0;
+    volatile uint32_t overruns_  = 0;
+};
+
+} // namespace daisy
+#endif
@@ -12,9 +12,17 @@ void Ak4556::Init(dsy_gpio_pin reset_pin)
     reset.pull = DSY_GPIO_NOPULL;
     dsy_gpio_init(&reset);
     dsy_gpio_write(&reset, 1);
+#if defined(DSY_FAST_BOOT)
+    // The reset pulse only needs 150ns; a microsecond of spinning at any
+    // core clock, not two SysTick-rounded milliseconds.
+    for(volatile uint32_t i = SystemCoreClock / 1000000; i > 0; i--) {}
+    dsy_gpio_write(&reset, 0);
+    for(volatile uint32_t i = SystemCoreClock / 1000000; i > 0; i--) {}
+#else
     System::Delay(1);
     dsy_gpio_write(&reset, 0);
     System::Delay(1);
+#endif
     dsy_gpio_write(&reset, 1);
 }
 
@@ -13,8 +13,6 @@
 // x = R/W|
 
 // TODO:
-// * add Deemphasis configuration
-// * add filter-rolloff configuration
 // * add format control configuration
 // * add digital attenuation for adc/dac
 
@@ -41,10 +39,27 @@ const uint8_t kDacPsvBitMask = 0x10;
 // This can be used for FMT1[1:0] and FMT2[1:0]
 const uint8_t kFmtBitMask = 0x03;
 
+// DacCtrl2 masks
+const uint8_t kOverBitMask = 0x40;
+
+// DigCtrl masks
+const uint8_t kFltBitMask = 0x80;
+const uint8_t kDmcBitMask = 0x10;
+
+// AdcCtrl2 masks
+const uint8_t kBypBitMask = 0x08;
+
 
 namespace daisy
 {
 Pcm3060::Result Pcm3060::Init(TwoWire* wire)
+{
+    Config config;
+    config.Defaults();
+    return Init(config, wire);
+}
+
+Pcm3060::Result Pcm3060::Init(const Config& config, TwoWire* wire)
 {
     _wire = wire;
 
@@ -66,7 +81,8 @@ Pcm3060::Result Pcm3060::Init(TwoWire* wire)
     sysreg &= ~(kMrstBitMask);
     if(WriteRegister(kAddrRegSysCtrl, sysreg) != Result::OK)
         return Result::ERR;
-    System::Delay(4);
+    if(WaitReset(kMrstBitMask) != Result::OK)
+        return Result::ERR;
 
     // SRST
     if(ReadRegister(kAddrRegSysCtrl, &sysreg) != Result::OK)
@@ -74,7 +90,8 @@ Pcm3060::Result Pcm3060::Init(TwoWire* wire)
     sysreg &= ~(kSrstBitMask);
     if(WriteRegister(kAddrRegSysCtrl, sysreg) != Result::OK)
         return Result::ERR;
-    System::Delay(4);
+    if(WaitReset(kSrstBitMask) != Result::OK)
+        return Result::ERR;
 
     // ADC/DAC Format set to 24-bit LJ
     uint8_t dac_ctrl, adc_ctrl;
@@ -89,6 +106,10 @@ Pcm3060::Result Pcm3060::Init(TwoWire* wire)
     if(WriteRegister(kAddrRegAdcCtrl1, adc_ctrl) != Result::OK)
         return Result::ERR;
 
+    // Filters, while the converters are still in power save
+    if(SetFilters(config) != Result::OK)
+        return Result::ERR;
+
     // Disable Powersave for ADC/DAC
     if(ReadRegister(kAddrRegSysCtrl, &sysreg) != Result::OK)
         return Result::ERR;
@@ -101,13 +122,66 @@ Pcm3060::Result Pcm3060::Init(TwoWire* wire)
     return Result::OK;
 }
 
+Pcm3060::Result Pcm3060::SetFilters(const Config& config)
+{
+    uint8_t dac_ctrl2, dig_ctrl, adc_ctrl2;
+    if(ReadRegister(kAddrRegDacCtrl2, &dac_ctrl2) != Result::OK)
+        return Result::ERR;
+    if(ReadRegister(kAddrRegDigCtrl, &dig_ctrl) != Result::OK)
+        return Result::ERR;
+    if(ReadRegister(kAddrRegAdcCtrl2, &adc_ctrl2) != Result::OK)
+        return Result::ERR;
+
+    dac_ctrl2 &= ~(kOverBitMask);
+    if(config.dac_oversampling == Config::DacOversampling::DOUBLE)
+        dac_ctrl2 |= kOverBitMask;
+
+    // De-emphasis off
+    dig_ctrl &= ~(kFltBitMask | kDmcBitMask);
+    if(config.dac_filter == Config::DacFilter::SLOW_ROLLOFF)
+        dig_ctrl |= kFltBitMask;
+
+    adc_ctrl2 &= ~(kBypBitMask);
+    if(!config.adc_hpf)
+        adc_ctrl2 |= kBypBitMask;
+
+    if(WriteRegister(kAddrRegDacCtrl2, dac_ctrl2) != Result::OK)
+        return Result::ERR;
+    if(WriteRegister(kAddrRegDigCtrl, dig_ctrl) != Result::OK)
+        return Result::ERR;
+    if(WriteRegister(kAddrRegAdcCtrl2, adc_ctrl2) != Result::OK)
+        return Result::ERR;
+    return Result::OK;
+}
+
+Pcm3060::Result Pcm3060::WaitReset(uint8_t mask)
+{
+#if defined(DSY_FAST_BOOT)
+    // MRST and SRST read back as 0 until the reset is through. Poll for
+    // them, for no longer than the fixed delay below.
+    const uint32_t start  = HAL_GetTick();
+    uint8_t        sysreg = 0;
+    do
+    {
+        if(ReadRegister(kAddrRegSysCtrl, &sysreg) != Result::OK)
+            return Result::ERR;
+        if(sysreg & mask)
+            break;
+    } while(HAL_GetTick() - start < 4);
+#else
+    (void)mask;
+    System::Delay(4);
+#endif
+    return Result::OK;
+}
+
 Pcm3060::Result Pcm3060::ReadRegister(uint8_t addr, uint8_t* data)
 {
     _wire->beginTransmission(dev_addr_ >> 1);
     _wire->write(addr);
     _wire->endTransmission(false);
     _wire->requestFrom(dev_addr_ >> 1, 1);
-    *data = Wire.read();
+    *data = _wire->read();
 
     return Result::OK;
 }
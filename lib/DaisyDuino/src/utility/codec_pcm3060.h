@@ -14,9 +14,9 @@ namespace daisy
  * For now this is a limited interface that uses I2C to communicate with the PCM3060
  * The device can also be accessed with SPI, which is not yet supported.
  * 
- * For now all registers are set to their defaults, and the Init function will 
- * perform a MRST and SRST before setting the format to 24bit LJ, and disabling 
- * power save for both the ADC and DAC.
+ * The Init function will perform a MRST and SRST before setting the format to
+ * 24bit LJ, applying the filter settings of its Config, and disabling power
+ * save for both the ADC and DAC. Other registers are left at their defaults.
  *
  */
 class Pcm3060
@@ -28,15 +28,78 @@ class Pcm3060
         ERR,
     };
 
+    /** Digital filter and modulator settings.
+     *
+     * The ADC filter is fixed; the DAC interpolation filter has two
+     * responses. The sharp roll-off is flat to about 0.45 fs, so at 96kHz
+     * it passes the 39.5kHz carrier untouched. The slow roll-off has a
+     * shorter impulse response, and so less delay, but starts to droop
+     * well inside the audio band and takes the top off the carrier: use
+     * it for live input at 48kHz or for low-passed material.
+     *
+     * The resulting input-to-output delay depends on the rate and is best
+     * measured on the board: src/bench/codec_latency_bench.cpp steps
+     * through the settings with a patch cable from output to input.
+     *
+     * De-emphasis is always off: it only exists for 32, 44.1 and 48kHz
+     * pre-emphasised sources.
+     */
+    struct Config
+    {
+        /** DAC interpolation filter response (FLT) */
+        enum class DacFilter
+        {
+            SHARP_ROLLOFF,
+            SLOW_ROLLOFF,
+        };
+
+        /** DAC delta-sigma oversampling (OVER). DOUBLE runs the modulator
+         *  twice as fast, pushing its noise further above the band. No
+         *  change to the filter delay. */
+        enum class DacOversampling
+        {
+            NORMAL,
+            DOUBLE,
+        };
+
+        DacFilter       dac_filter;
+        DacOversampling dac_oversampling;
+
+        /** ADC high-pass (DC removal). false bypasses it (BYP) and passes
+         *  DC from the inputs. */
+        bool adc_hpf;
+
+        /** Sharp roll-off, normal oversampling, ADC high-pass on: the
+         *  codec's reset state. */
+        void Defaults()
+        {
+            dac_filter       = DacFilter::SHARP_ROLLOFF;
+            dac_oversampling = DacOversampling::NORMAL;
+            adc_hpf          = true;
+        }
+    };
+
     Pcm3060() {}
     ~Pcm3060() {}
 
-    /** Initializes the PCM3060 in 24-bit MSB aligned I2S mode, and disables powersave 
+    /** Initializes the PCM3060 in 24-bit MSB aligned I2S mode with the
+     * default Config, and disables powersave 
      * \param i2c Initialized I2CHandle configured at 400kHz or less
      */
     Result Init(TwoWire *wire = &Wire);
 
+    /** As above, with the filter settings of config */
+    Result Init(const Config &config, TwoWire *wire = &Wire);
+
+    /** Changes the filter settings of a running codec, without a reset.
+     *  The output may click as the filter changes. Not from an interrupt:
+     *  this goes over the blocking Wire driver. */
+    Result SetFilters(const Config &config);
+
   private:
+    /** Waits for a MRST or SRST (mask) to complete */
+    Result WaitReset(uint8_t mask);
+
     /** Reads the data byte corresponding to the register address */
     Result ReadRegister(uint8_t addr, uint8_t *data);
 
@@ -47,12 +47,12 @@ enum CodecSettings
     CODEC_ADC_LINE          = 0x0,
     CODEC_OUTPUT_DAC_ENABLE = 0x10,
     CODEC_OUTPUT_MONITOR    = 0x20,
-    CODEC_DEEMPHASIS_NONE   = 0x00,
-    CODEC_DEEMPHASIS_32K    = 0x01,
-    CODEC_DEEMPHASIS_44K    = 0x02,
-    CODEC_DEEMPHASIS_48K    = 0x03,
-    CODEC_SOFT_MUTE         = 0x01,
-    CODEC_ADC_HPF           = 0x00,
+    CODEC_ADC_HPF_DISABLE   = 0x01,
+    CODEC_DEEMPHASIS_NONE   = 0x00 << 1,
+    CODEC_DEEMPHASIS_32K    = 0x01 << 1,
+    CODEC_DEEMPHASIS_44K    = 0x02 << 1,
+    CODEC_DEEMPHASIS_48K    = 0x03 << 1,
+    CODEC_SOFT_MUTE         = 0x08,
 
     CODEC_POWER_DOWN_LINE_IN      = 0x01,
     CODEC_POWER_DOWN_MIC          = 0x02,
@@ -128,8 +128,7 @@ Wm8731::Result Wm8731::Init(const Wm8731::Config &config, TwoWire* wire)
     if(res != Result::OK)
         return Result::ERR;
 
-    res = WriteControlRegister(CODEC_REG_DIGITAL_ROUTING,
-                               CODEC_DEEMPHASIS_NONE);
+    res = SetFilters(cfg_);
     if(res != Result::OK)
         return Result::ERR;
 
@@ -172,11 +171,35 @@ Wm8731::Result Wm8731::Init(const Wm8731::Config &config, TwoWire* wire)
     return Result::OK;
 }
 
+Wm8731::Result Wm8731::SetFilters(const Config &config)
+{
+    cfg_.adc_hpf = config.adc_hpf;
+    uint16_t routing = CODEC_DEEMPHASIS_NONE;
+    if(!cfg_.adc_hpf)
+        routing |= CODEC_ADC_HPF_DISABLE;
+    return WriteControlRegister(CODEC_REG_DIGITAL_ROUTING, routing);
+}
+
 Wm8731::Result Wm8731::WriteControlRegister(uint8_t address, uint16_t data)
 {
     uint8_t byte_1  = ((address << 1) & 0xfe) | ((data >> 8) & 0x01);
     uint8_t byte_2  = data & 0xff;
 
+#if defined(DSY_FAST_BOOT)
+    // No fixed wait: the WM8731 takes a write at once, and its ACK is the
+    // only status it has. Poll on that for as long as the delay below.
+    const uint32_t start = HAL_GetTick();
+    for(;;)
+    {
+        wire_->beginTransmission(dev_addr_);
+        wire_->write(byte_1);
+        wire_->write(byte_2);
+        if(wire_->endTransmission() == 0)
+            return Result::OK;
+        if(HAL_GetTick() - start >= 10)
+            return Result::ERR;
+    }
+#else
     wire_->beginTransmission(dev_addr_);
     wire_->write(byte_1);
     wire_->write(byte_2);
@@ -184,6 +207,7 @@ Wm8731::Result Wm8731::WriteControlRegister(uint8_t address, uint16_t data)
 
     System::Delay(10);
     return Result::OK;
+#endif
 }
 
 } // namespace daisy
\ No newline at end of file
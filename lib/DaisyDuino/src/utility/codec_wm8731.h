@@ -82,12 +82,23 @@ class Wm8731
         Format     fmt;
         WordLength wl;
 
+        /** ADC high-pass (DC removal). false disables it (ADCHPD) and
+         ** passes DC from the inputs.
+         **
+         ** There is no filter choice beyond this: the WM8731 picks its
+         ** digital filter type from the sample rate setting, which stays
+         ** at 48kHz (the filters scale with MCLK, so they follow the SAI
+         ** rate). De-emphasis is always off. Measure the delay on the
+         ** board with src/bench/codec_latency_bench.cpp. */
+        bool adc_hpf;
+
         /** Sets the following config:
          ** MCU is master = true 
          ** L/R Swap = false
          ** CSB Pin state = false
          ** Format = MSB First LJ 
-         ** WordLength = 24-bit  */
+         ** WordLength = 24-bit
+         ** ADC high-pass = on */
         void Defaults()
         {
             mcu_is_master = true;
@@ -95,6 +106,7 @@ class Wm8731
             csb_pin_state = false;
             fmt           = Format::MSB_FIRST_LJ;
             wl            = WordLength::BITS_24;
+            adc_hpf       = true;
         }
     };
 
@@ -104,6 +116,10 @@ class Wm8731
     /** Initializes the WM8731 device */
     Result Init(const Config &config, TwoWire* wire = &Wire);
 
+    /** Changes the filter settings of a running codec (adc_hpf; the
+     ** rest of config is ignored). Blocks on Wire; not from an interrupt. */
+    Result SetFilters(const Config &config);
+
   private:
     TwoWire* wire_;
     Config    cfg_;
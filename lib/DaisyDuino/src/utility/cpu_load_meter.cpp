@@ -0,0 +1,30 @@
+#include "cpu_load_meter.h"
+#include <math.h>
+
+using namespace daisy;
+
+void CpuLoadMeter::Init(float sample_rate, size_t block_size, float smoothing_hz)
+{
+    EnableCycleCounter();
+
+    const float period_s = (float)block_size / sample_rate;
+    period_cycles_       = (uint32_t)(period_s * (float)SystemCoreClock);
+    period_recip_        = 1.0f / (float)period_cycles_;
+
+    // One-pole smoother updated once per block.
+    const float twopi      = 6.283185307f;
+    const float block_rate = sample_rate / (float)block_size;
+    coeff_ = 1.0f - expf(-twopi * smoothing_hz / block_rate);
+
+    Reset();
+}
+
+void CpuLoadMeter::Reset()
+{
+    min_      = 0.0f;
+    max_      = 0.0f;
+    avg_      = 0.0f;
+    last_     = 0.0f;
+    overruns_ = 0;
+    first_    = true;
+}
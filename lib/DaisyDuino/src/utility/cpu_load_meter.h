@@ -0,0 +1,108 @@
+#pragma once
+#ifndef DSY_CPU_LOAD_METER_H
+#define DSY_CPU_LOAD_METER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** Starts the DWT cycle counter. Trace must be enabled before the DWT
+    registers can be written, and the M7 also keeps them behind the
+    CoreSight lock: without the unlock the enable only takes with a
+    debugger attached.
+*/
+inline void EnableCycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/** Measures how much of each audio block period the callback uses.
+
+    OnBlockStart() and OnBlockEnd() timestamp the callback with the DWT
+    cycle counter, which runs at the core clock and costs a single load
+    to read. The busy time is reported as a fraction of the block period
+    (blocksize / samplerate), so 1.0 means the callback used the whole
+    budget.
+
+    A block whose busy time exceeds the period is counted as an overrun:
+    the next DMA half-complete has already fired and the callback is
+    late servicing it.
+
+    AudioHandle feeds its own meter around every callback; read it from
+    the main loop with DAISY.CpuLoad().
+*/
+class CpuLoadMeter
+{
+  public:
+    CpuLoadMeter() {}
+    ~CpuLoadMeter() {}
+
+    /** Enables the DWT cycle counter and sets the block period.
+        \param sample_rate - audio sample rate in Hz
+        \param block_size - frames per callback
+        \param smoothing_hz - cutoff of the average's one-pole smoother,
+                              in Hz of wall-clock time
+    */
+    void Init(float sample_rate, size_t block_size, float smoothing_hz = 1.0f);
+
+    /** Call first thing in the audio callback. */
+    inline void OnBlockStart() { start_ = DWT->CYCCNT; }
+
+    /** Call last thing in the audio callback. */
+    inline void OnBlockEnd()
+    {
+        const uint32_t busy = DWT->CYCCNT - start_;
+        const float    load = (float)busy * period_recip_;
+        last_               = load;
+        if(busy > period_cycles_)
+            overruns_++;
+        if(first_)
+        {
+            min_   = load;
+            max_   = load;
+            avg_   = load;
+            first_ = false;
+            return;
+        }
+        min_ = load < min_ ? load : min_;
+        max_ = load > max_ ? load : max_;
+        avg_ += coeff_ * (load - avg_);
+    }
+
+    /** \return load of the most recent block */
+    float GetLastCpuLoad() const { return last_; }
+
+    /** \return smoothed load, 0 to 1 (above 1 while overrunning) */
+    float GetAvgCpuLoad() const { return avg_; }
+
+    /** \return lowest load since the last Reset() */
+    float GetMinCpuLoad() const { return min_; }
+
+    /** \return highest load since the last Reset() */
+    float GetMaxCpuLoad() const { return max_; }
+
+    /** \return blocks that ran past their period since the last Reset() */
+    uint32_t GetOverruns() const { return overruns_; }
+
+    /** \return the block period in core clock cycles */
+    uint32_t GetPeriodCycles() const { return period_cycles_; }
+
+    /** Clears min, max, average and the overrun count. */
+    void Reset();
+
+  private:
+    uint32_t          start_;
+    uint32_t          period_cycles_;
+    float             period_recip_;
+    float             coeff_;
+    float             min_, max_, avg_, last_;
+    volatile uint32_t overruns_;
+    volatile bool     first_;
+};
+
+} // namespace daisy
+#endif
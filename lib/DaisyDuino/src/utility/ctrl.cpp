@@ -36,11 +36,21 @@ void AnalogControl::InitBipolarCv(uint8_t pin, float sr)
     invert_     = true;
 }
 
+bool AnalogControl::UseScan(AdcScan& scan)
+{
+    const int slot = scan.AddPin(pin_);
+    if(slot < 0)
+        return false;
+    scan_ = &scan;
+    slot_ = slot;
+    return true;
+}
+
 float AnalogControl::Process()
 {
     float t;
 
-	t = (float)analogRead(pin_) * frac_;
+	t = scan_ ? scan_->Value(slot_) : (float)analogRead(pin_) * frac_;
 
     if(flip_)
         t = 1.f - t;
@@ -3,6 +3,7 @@
 #define DSY_KNOB_H /**< & */
 #include <stdint.h>
 #include "Arduino.h"
+#include "adc_scan.h"
 
 #ifdef __cplusplus
 namespace daisy
@@ -45,6 +46,14 @@ class AnalogControl
     */
     void InitBipolarCv(uint8_t pin, float sr);
 
+    /**
+    Reads the pin from a DMA scan instead of analogRead(), after Init.
+    Add the controls before scan.Start(); the pin must be on ADC1.
+    \param scan scan that converts the pin
+    \return false if the scan could not take the pin
+    */
+    bool UseScan(AdcScan& scan);
+
     /** 
     Filters, and transforms a raw ADC read into a normalized range.
     this should be called at the rate of specified by samplerate at Init time.   
@@ -59,6 +68,8 @@ class AnalogControl
   private:
   
     uint8_t pin_;
+    const AdcScan* scan_ = nullptr;
+    int       slot_ = -1;
     float     coeff_, samplerate_, val_;
 	float frac_ = 1.f / 1023.f;
     float     scale_, offset_;
@@ -0,0 +1,231 @@
+#include "dac_stream.h"
+#include "daisy_core.h"
+#include <stm32h7xx_hal.h>
+
+using namespace daisy;
+
+static DAC_HandleTypeDef dac_stream_dac;
+static TIM_HandleTypeDef dac_stream_tim;
+static DMA_HandleTypeDef dac_stream_dma;
+
+// Read by the DMA only, a DHR12RD word per frame: channel 1 in the low
+// halfword, channel 2 in the high. Uncached, so stores reach it as made.
+static volatile uint32_t DMA_BUFFER_MEM_SECTION
+    dac_stream_ring[DacStream::kRingFrames];
+
+static const uint32_t kChannels[2] = {DAC_CHANNEL_1, DAC_CHANNEL_2};
+
+int DacStream::AddPin(uint32_t pin)
+{
+    if(running_ || num_pins_ >= 2)
+        return -1;
+    const PinName name = digitalPinToPinName(pin);
+    if(pinmap_peripheral(name, PinMap_DAC) != DAC1)
+        return -1;
+    const uint32_t function = pinmap_function(name, PinMap_DAC);
+    const uint8_t  channel  = static_cast<uint8_t>(STM_PIN_CHANNEL(function) - 1);
+    for(size_t i = 0; i < num_pins_; i++)
+    {
+        if(channels_[i] == channel)
+            return -1;
+    }
+    pinmap_pinout(name, PinMap_DAC);
+    channels_[num_pins_] = channel;
+    return static_cast<int>(num_pins_++);
+}
+
+bool DacStream::Start(float rate)
+{
+    if(num_pins_ == 0 || running_ || rate <= 0.f)
+        return false;
+
+    __HAL_RCC_DAC12_CLK_ENABLE();
+    __HAL_RCC_TIM6_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    for(size_t i = 0; i < kRingFrames; i++)
+        dac_stream_ring[i] = 0;
+    for(size_t i = 0; i < num_pins_; i++)
+    {
+        last_pos_[i]  = 0;
+        write_[i]     = 0;
+        streaming_[i] = false;
+    }
+    slips_ = 0;
+
+    // TIM6 is on APB1: its clock is 2x PCLK1, as in TimerHandle.
+    const float clock = static_cast<float>(HAL_RCC_GetPCLK1Freq() * 2);
+    const float ticks = clock / rate;
+    const uint32_t psc
+        = ticks > 65536.f ? static_cast<uint32_t>(ticks / 65536.f) : 0;
+    uint32_t period = static_cast<uint32_t>(
+        ticks / static_cast<float>(psc + 1) + 0.5f);
+    period = period < 2 ? 2 : (period > 65536 ? 65536 : period);
+    rate_  = clock
+            / (static_cast<float>(psc + 1) * static_cast<float>(period));
+
+    TIM_HandleTypeDef* htim        = &dac_stream_tim;
+    htim->Instance                 = TIM6;
+    htim->Init.Prescaler           = psc;
+    htim->Init.CounterMode         = TIM_COUNTERMODE_UP;
+    htim->Init.Period              = period - 1;
+    htim->Init.AutoReloadPreload   = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if(HAL_TIM_Base_Init(htim) != HAL_OK)
+        return false;
+    TIM_MasterConfigTypeDef master = {};
+    master.MasterOutputTrigger     = TIM_TRGO_UPDATE;
+    master.MasterSlaveMode         = TIM_MASTERSLAVEMODE_DISABLE;
+    if(HAL_TIMEx_MasterConfigSynchronization(htim, &master) != HAL_OK)
+        return false;
+
+    DAC_HandleTypeDef* hdac = &dac_stream_dac;
+    hdac->Instance          = DAC1;
+    if(HAL_DAC_Init(hdac) != HAL_OK)
+        return false;
+    DAC_ChannelConfTypeDef channel      = {};
+    channel.DAC_SampleAndHold           = DAC_SAMPLEANDHOLD_DISABLE;
+    channel.DAC_Trigger                 = DAC_TRIGGER_T6_TRGO;
+    channel.DAC_OutputBuffer            = DAC_OUTPUTBUFFER_ENABLE;
+    channel.DAC_ConnectOnChipPeripheral = DAC_CHIPCONNECT_DISABLE;
+    channel.DAC_UserTrimming            = DAC_TRIMMING_FACTORY;
+    for(size_t i = 0; i < num_pins_; i++)
+    {
+        if(HAL_DAC_ConfigChannel(hdac, &channel, kChannels[channels_[i]])
+           != HAL_OK)
+            return false;
+    }
+
+    // Both channels take the same trigger; the first added one's request
+    // moves the whole word, so one stream serves both.
+    dma_channel_                   = channels_[0];
+    DMA_HandleTypeDef* hdma        = &dac_stream_dma;
+    hdma->Instance                 = DMA1_Stream7;
+    hdma->Init.Request             = dma_channel_ == 0 ? DMA_REQUEST_DAC1_CH1
+                                                       : DMA_REQUEST_DAC1_CH2;
+    hdma->Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    hdma->Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma->Init.MemInc              = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma->Init.MemDataAlignment    = DMA_MDATAALIGN_WORD;
+    hdma->Init.Mode                = DMA_CIRCULAR;
+    hdma->Init.Priority            = DMA_PRIORITY_MEDIUM;
+    hdma->Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+    if(HAL_DMA_Init(hdma) != HAL_OK)
+        return false;
+    if(HAL_DMA_Start_IT(hdma,
+                        (uint32_t)(uintptr_t)dac_stream_ring,
+                        (uint32_t)(uintptr_t)&DAC1->DHR12RD,
+                        kRingFrames)
+       != HAL_OK)
+        return false;
+    // Nothing to do per ring: only transfer errors interrupt.
+    __HAL_DMA_DISABLE_IT(hdma, DMA_IT_HT | DMA_IT_TC);
+    HAL_NVIC_EnableIRQ(DMA1_Stream7_IRQn);
+
+    for(size_t i = 0; i < num_pins_; i++)
+    {
+        if(HAL_DAC_Start(hdac, kChannels[channels_[i]]) != HAL_OK)
+            return false;
+    }
+    SET_BIT(DAC1->CR, dma_channel_ == 0 ? DAC_CR_DMAEN1 : DAC_CR_DMAEN2);
+
+    if(HAL_TIM_Base_Start(htim) != HAL_OK)
+        return false;
+    running_ = true;
+    return true;
+}
+
+void DacStream::Stop()
+{
+    if(!running_)
+        return;
+    HAL_TIM_Base_Stop(&dac_stream_tim);
+    CLEAR_BIT(DAC1->CR, DAC_CR_DMAEN1 | DAC_CR_DMAEN2);
+    HAL_DMA_Abort(&dac_stream_dma);
+    running_ = false;
+}
+
+size_t DacStream::ReadPos() const
+{
+    return (kRingFrames - __HAL_DMA_GET_COUNTER(&dac_stream_dma)) & kMask;
+}
+
+void DacStream::Fill(int slot, size_t pos, size_t count, size_t ramp, uint16_t code)
+{
+    volatile uint16_t* ring
+        = reinterpret_cast<volatile uint16_t*>(dac_stream_ring)
+          + channels_[slot];
+    float       v    = static_cast<float>(ring[(pos & kMask) * 2]);
+    const float step = ramp > 0 ? (static_cast<float>(code) - v)
+                                      / static_cast<float>(ramp)
+                                : 0.f;
+    for(size_t i = 0; i < count; i++)
+    {
+        uint16_t c = code;
+        if(i < ramp)
+        {
+            v += step;
+            c = static_cast<uint16_t>(v + 0.5f);
+        }
+        ring[((pos + i) & kMask) * 2] = c;
+    }
+}
+
+void DacStream::Ramp(int slot, float value)
+{
+    if(!running_ || slot < 0 || static_cast<size_t>(slot) >= num_pins_)
+        return;
+    const size_t r    = ReadPos();
+    size_t       ramp = (r - last_pos_[slot]) & kMask;
+    if(ramp > kRingFrames / 2)
+        ramp = kRingFrames / 2;
+    last_pos_[slot]  = r;
+    streaming_[slot] = false;
+    Fill(slot, r + kLead, kRingFrames - kLead, ramp, ToCode(value));
+}
+
+void DacStream::Set(int slot, float value)
+{
+    if(!running_ || slot < 0 || static_cast<size_t>(slot) >= num_pins_)
+        return;
+    const size_t r   = ReadPos();
+    last_pos_[slot]  = r;
+    streaming_[slot] = false;
+    Fill(slot, r, kRingFrames, 0, ToCode(value));
+}
+
+size_t DacStream::Write(int slot, const float* values, size_t n, float gain)
+{
+    if(!running_ || n == 0 || slot < 0 || static_cast<size_t>(slot) >= num_pins_)
+        return 0;
+    if(n > kMaxWrite)
+        n = kMaxWrite;
+    const size_t r     = ReadPos();
+    size_t       w     = write_[slot];
+    const size_t ahead = (w - r) & kMask;
+    volatile uint16_t* ring
+        = reinterpret_cast<volatile uint16_t*>(dac_stream_ring)
+          + channels_[slot];
+    if(!streaming_[slot] || ahead < kLead / 2
+       || ahead + n > kRingFrames - kLead)
+    {
+        // One block of slack either way before the next slip, the gap
+        // up to it held at the first value rather than a ring-old one.
+        if(streaming_[slot])
+            slips_++;
+        w                = r + kLead + n;
+        streaming_[slot] = true;
+        const uint16_t first = ToCode(values[0] * gain);
+        for(size_t i = r; i != w; i++)
+            ring[(i & kMask) * 2] = first;
+    }
+    for(size_t i = 0; i < n; i++)
+        ring[((w + i) & kMask) * 2] = ToCode(values[i] * gain);
+    write_[slot] = (w + n) & kMask;
+    return n;
+}
+
+extern "C" void DMA1_Stream7_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&dac_stream_dma);
+}
@@ -0,0 +1,128 @@
+#pragma once
+#ifndef DSY_DAC_STREAM_H
+#define DSY_DAC_STREAM_H
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace daisy
+{
+/** Timer-paced 12-bit output on DAC1 from a circular DMA ring.
+
+    analogWrite() is 8 bits and a blocking HAL setup per call, so a CV
+    written from the control task steps 20 mV at a time, at the control
+    rate. Here TIM6 triggers DAC1 at the rate given to Start(), up to
+    audio rates, and DMA (DMA1 stream 7) feeds both channels at once
+    from a ring of kRingFrames words in DMA_BUFFER_MEM_SECTION, so the
+    DAC runs with no CPU and no interrupt. Writers only store into the
+    ring, some frames ahead of where the DMA reads, which is the
+    stream's NDTR:
+
+    - Ramp() moves a channel to a new level linearly over the time since
+      its last Ramp(), capped at half the ring, and holds it: called at
+      the control rate, the output is the control values joined by
+      lines at the DAC rate instead of a staircase. One control period
+      of latency. It refills the ring but for the kLead frames the DMA
+      is about to read, which the next call refills; so it is for a
+      caller at a steady rate (the control task, loop()), as the ring
+      repeats otherwise. Finish with Set() to stop calling.
+    - Set() goes to a level at once and holds it.
+    - Write() streams samples, e.g. an envelope from the audio callback
+      with the DAC at the audio rate. The channel's write position is
+      kept between calls; if the two clocks have slipped it past the DMA
+      or a ring's length ahead, it is put back kLead + n frames ahead,
+      the frames skipped holding the block's first value, and Slips()
+      counts it.
+
+    A channel is for one context (control task or audio callback); the
+    two channels are independent. Pins must be on DAC1: PA4 is channel 1
+    and PA5 channel 2 (the Field's and Patch SM's CV outs). While
+    running, DAC1 and TIM6 belong to the stream: no analogWrite() on
+    those pins, and no tone(), which the core runs on TIM6.
+
+    One instance per firmware.
+*/
+class DacStream
+{
+  public:
+    static constexpr size_t kRingFrames = 512;
+
+    /** Frames ahead of the DMA that writes start at */
+    static constexpr size_t kLead = 16;
+
+    /** Most values one Write() takes */
+    static constexpr size_t kMaxWrite = kRingFrames / 2 - kLead;
+
+    DacStream() : num_pins_(0), slips_(0), rate_(0.f), running_(false) {}
+    ~DacStream() {}
+
+    /** Sets a pin to analog and to its DAC1 channel; before Start().
+        \return its slot, or -1 if the stream is running, the pin is
+                not on DAC1 or its channel was added already
+    */
+    int AddPin(uint32_t pin);
+
+    /** Starts TIM6, the DMA and the DAC, every slot at 0.
+        \param rate - DAC updates per second, e.g. the audio rate
+        \return false if no pins were added or the HAL failed
+    */
+    bool Start(float rate);
+
+    /** Stops the timer and the DMA; the outputs hold their last code. */
+    void Stop();
+
+    /** Moves slot to value (0 to 1, full scale) over the time since its
+        last call, then holds it
+    */
+    void Ramp(int slot, float value);
+
+    /** Moves slot to value (0 to 1) at once, and holds it */
+    void Set(int slot, float value);
+
+    /** Streams n values (0 to 1 after gain) to slot, at the DAC rate
+        \return values written, short of n only past kMaxWrite
+    */
+    size_t Write(int slot, const float* values, size_t n, float gain = 1.f);
+
+    /** \return the update rate the timer runs at, as near rate as its
+                dividers allow
+    */
+    inline float GetRate() const { return rate_; }
+
+    /** \return Write() calls that had to re-seat, since Start() */
+    inline uint32_t Slips() const { return slips_; }
+
+    inline bool   IsRunning() const { return running_; }
+    inline size_t GetNumPins() const { return num_pins_; }
+
+  private:
+    static constexpr size_t kMask = kRingFrames - 1;
+    static_assert((kRingFrames & kMask) == 0, "kRingFrames power of two");
+
+    /** Ring frame the DMA transfers next */
+    size_t ReadPos() const;
+
+    /** Stores count frames of slot from ring frame pos on: a line from
+        the code at pos to code over ramp frames, then code
+    */
+    void Fill(int slot, size_t pos, size_t count, size_t ramp, uint16_t code);
+
+    static inline uint16_t ToCode(float value)
+    {
+        const float c = value * 4095.f + 0.5f;
+        return c <= 0.f ? 0 : (c >= 4095.f ? 4095 : static_cast<uint16_t>(c));
+    }
+
+    uint8_t  channels_[2]; // 0 or 1, halfword in the DHR12RD word
+    uint8_t  dma_channel_; // the channel whose trigger requests the DMA
+    size_t   last_pos_[2]; // DMA position at the last Ramp()
+    size_t   write_[2];    // Write(): next ring frame
+    bool     streaming_[2];
+    size_t   num_pins_;
+    uint32_t slips_;
+    float    rate_;
+    bool     running_;
+};
+
+} // namespace daisy
+#endif
@@ -29,6 +29,16 @@ for DMA transfers. Performance is on par with internal SRAM w/
 cache enabled.
 */
 #define DTCM_MEM_SECTION __attribute__((section(".dtcmram_bss")))
+/**
+Code in ITCM RAM: zero wait states and no flash / I-cache fetch, so a
+function takes the same time on every call. Used on the audio interrupt
+path. The section needs a linker rule that runs it from ITCMRAM with a
+load image in flash, and a copy at startup before it is first called;
+without a rule the linker leaves it in flash with the rest of .text.
+Inlining is unaffected: a tagged function still inlines into its
+callers, wherever they live.
+*/
+#define DSY_ITCM_FUNC __attribute__((section(".itcmram_text")))
 
 #define FBIPMAX 0.999985f             /**< close to 1.0f-LSB at 16 bit */
 #define FBIPMIN (-FBIPMAX)            /**< - (1 - LSB) */
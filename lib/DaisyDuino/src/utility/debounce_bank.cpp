@@ -0,0 +1,62 @@
+#include "debounce_bank.h"
+
+using namespace daisy;
+
+bool DebounceBank::AddPin(uint8_t pin, bool invert, Pin *out) {
+  const PinName name = digitalPinToPinName(pin);
+  if (name == NC)
+    return false;
+  const uint32_t p = STM_PORT(name);
+  if (p >= kNumPorts)
+    return false;
+
+  Port &port = ports_[p];
+  if (gpio_[p] == nullptr) {
+    gpio_[p] = digitalPinToPort(pin);
+    port = Port{};
+    for (size_t i = 0; i < 4; i++)
+      port.raw[i] = 0xffff;
+    active_[num_active_++] = static_cast<uint8_t>(p);
+  }
+
+  const uint16_t mask = static_cast<uint16_t>(STM_GPIO_PIN(name));
+  port.used |= mask;
+  if (invert)
+    port.invert |= mask;
+  else
+    port.invert &= ~mask;
+
+  out->port = static_cast<uint8_t>(p);
+  out->mask = mask;
+  return true;
+}
+
+void DebounceBank::Update() {
+  for (size_t a = 0; a < num_active_; a++) {
+    const uint8_t p = active_[a];
+    Port &port = ports_[p];
+    const uint16_t in =
+        (static_cast<uint16_t>(gpio_[p]->IDR) ^ port.invert) & port.used;
+
+    // Count samples that disagree with the state; agreeing clears.
+    const uint16_t d = in ^ port.state;
+    const uint16_t c0 = ~port.cnt0 & d;
+    const uint16_t c1 = (port.cnt1 ^ port.cnt0) & d;
+    const uint16_t c2 = (port.cnt2 ^ (port.cnt1 & port.cnt0)) & d;
+    const uint16_t flip = c0 & c1 & c2;
+    port.cnt0 = c0 & ~flip;
+    port.cnt1 = c1 & ~flip;
+    port.cnt2 = c2 & ~flip;
+    port.state ^= flip;
+    port.rise = flip & port.state;
+    port.fall = flip & ~port.state;
+
+    port.raw[3] = port.raw[2];
+    port.raw[2] = port.raw[1];
+    port.raw[1] = port.raw[0];
+    port.raw[0] = in;
+    const uint16_t older = port.raw[1] & port.raw[2];
+    port.raw_fell = ~in & older & port.raw[3];
+    port.raw_low = ~(in | port.raw[1] | port.raw[2]);
+  }
+}
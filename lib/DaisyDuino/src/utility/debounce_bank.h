@@ -0,0 +1,75 @@
+#ifndef DSY_DEBOUNCE_BANK_H
+#define DSY_DEBOUNCE_BANK_H
+
+#include "Arduino.h"
+
+namespace daisy {
+/** Debounces every registered input pin at once, a GPIO port at a time.
+ *
+ * Update() reads each used port's IDR once and runs all of its pins
+ * through a 3-bit vertical counter: one counter bit plane per word, so
+ * 16 pins count with a handful of logic ops. A pin changes state on
+ * the 7th consecutive sample that disagrees with it, the sample on
+ * which Switch::RisingEdge() used to fire, and a bounce inside those 7
+ * restarts the count instead of dropping the state.
+ *
+ * Each port also keeps its last four raw samples for Encoder's
+ * quadrature patterns. Switch, GateIn and Encoder read the published
+ * masks after UseBank(), so scanning costs a few word ops per port
+ * however many controls share it.
+ */
+class DebounceBank {
+public:
+  /** GPIOA to GPIOK */
+  static constexpr size_t kNumPorts = 11;
+
+  /** A registered pin: its port and bit */
+  struct Pin {
+    uint8_t port;
+    uint16_t mask;
+  };
+
+  DebounceBank() : num_active_(0) {
+    for (size_t p = 0; p < kNumPorts; p++)
+      gpio_[p] = nullptr;
+  }
+  ~DebounceBank() {}
+
+  /** Adds a pin whose mode is already set.
+   * \param invert  true to count a low pin as pressed
+   * \param out     receives the handle
+   * \return false for a pin that is not on a GPIO port
+   */
+  bool AddPin(uint8_t pin, bool invert, Pin *out);
+
+  /** Samples and debounces every added pin; once per control update. */
+  void Update();
+
+  /** Debounced state, after inversion */
+  inline bool State(Pin p) const { return ports_[p.port].state & p.mask; }
+  /** Became true on the last Update() */
+  inline bool Rose(Pin p) const { return ports_[p.port].rise & p.mask; }
+  /** Became false on the last Update() */
+  inline bool Fell(Pin p) const { return ports_[p.port].fall & p.mask; }
+
+  /** Raw samples: last one low, the three before high */
+  inline bool RawFell(Pin p) const { return ports_[p.port].raw_fell & p.mask; }
+  /** Raw samples: last three low */
+  inline bool RawLow(Pin p) const { return ports_[p.port].raw_low & p.mask; }
+
+private:
+  struct Port {
+    uint16_t used, invert;
+    uint16_t state, cnt0, cnt1, cnt2;
+    uint16_t rise, fall;
+    uint16_t raw[4]; // newest first
+    uint16_t raw_fell, raw_low;
+  };
+
+  GPIO_TypeDef *gpio_[kNumPorts];
+  Port ports_[kNumPorts];
+  uint8_t active_[kNumPorts];
+  size_t num_active_;
+};
+} // namespace daisy
+#endif
@@ -1,7 +1,35 @@
 #include "encoder.h"
+#include "irq_priority.h"
+#include <math.h>
 
 using namespace daisy;
 
+// Quarter step for a transition, indexed by (previous << 2) | current,
+// where a state is (A << 1) | B. Clockwise runs 3 -> 2 -> 0 -> 1 -> 3:
+// B falls first, as in the polled decoding below. A bouncing contact
+// steps back and forth and cancels; a skipped state (both pins changed)
+// counts nothing.
+static const int8_t kQuarterStep[16] = {
+    0,  1,  -1, 0,  // from 0
+    -1, 0,  0,  1,  // from 1
+    1,  0,  0,  -1, // from 2
+    0,  -1, 1,  0,  // from 3
+};
+
+static IRQn_Type ExtiIrq(PinName pin) {
+  const uint32_t line = STM_PIN(pin);
+  if (line <= 4)
+    return (IRQn_Type)(EXTI0_IRQn + line);
+  return line <= 9 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+// Vectors 9_5 and 15_10 are shared; one already above CONTROL (e.g.
+// SampleSync's) keeps its level.
+static void RaiseToControl(IRQn_Type irq) {
+  if (NVIC_GetPriority(irq) > IRQ_PRIORITY_CONTROL)
+    HAL_NVIC_SetPriority(irq, IRQ_PRIORITY_CONTROL, 0);
+}
+
 void Encoder::Init(float update_rate, uint8_t pinA, uint8_t pinB,
                    uint8_t pinClick, uint8_t modeA, uint8_t modeB,
                    uint8_t modeC) {
@@ -14,23 +42,109 @@ void Encoder::Init(float update_rate, uint8_t pinA, uint8_t pinB,
   pinMode(pinA, modeA);
   pinMode(pinB, modeB);
 
+  update_rate_ = update_rate;
+  velocity_ = 0.f;
+  velocity_coeff_ = 1.f - expf(-1.f / (0.05f * update_rate));
+  accel_frac_ = 0.f;
+  accel_inc_ = 0;
+
   encSwitch.Init(update_rate, true, pinClick, modeC);
 }
 
-void Encoder::Debounce() {
-  uint8_t a_in = digitalRead(pinA_);
-  uint8_t b_in = digitalRead(pinB_);
+bool Encoder::UseInterrupts() {
+  pin_name_a_ = digitalPinToPinName(pinA_);
+  pin_name_b_ = digitalPinToPinName(pinB_);
+  if (pin_name_a_ == NC || pin_name_b_ == NC ||
+      STM_PIN(pin_name_a_) == STM_PIN(pin_name_b_))
+    return false;
 
-  encSwitch.Debounce();
+  state_ = (digitalReadFast(pin_name_a_) << 1) | digitalReadFast(pin_name_b_);
+  steps_ = 0;
+  detent_ = 0;
+  irq_ = true;
+  attachInterrupt(digitalPinToInterrupt(pinA_), [this]() { OnEdge(); },
+                  CHANGE);
+  attachInterrupt(digitalPinToInterrupt(pinB_), [this]() { OnEdge(); },
+                  CHANGE);
+  // attachInterrupt() leaves the vectors at the core's EXTI priority.
+  RaiseToControl(ExtiIrq(pin_name_a_));
+  RaiseToControl(ExtiIrq(pin_name_b_));
+  return true;
+}
 
-  a_ = (a_ << 1) | (a_in);
-  b_ = (b_ << 1) | (b_in);
+void Encoder::OnEdge() {
+  const uint8_t state =
+      (digitalReadFast(pin_name_a_) << 1) | digitalReadFast(pin_name_b_);
+  steps_ = steps_ + kQuarterStep[(state_ << 2) | state];
+  state_ = state;
+}
 
+bool Encoder::UseBank(DebounceBank &bank) {
+  if (irq_)
+    return encSwitch.UseBank(bank);
+  if (!bank.AddPin(pinA_, false, &bank_a_) ||
+      !bank.AddPin(pinB_, false, &bank_b_) || !encSwitch.UseBank(bank))
+    return false;
+  bank_ = &bank;
+  return true;
+}
+
+void Encoder::SetAcceleration(float speed, float max_gain) {
+  accel_speed_ = speed;
+  accel_max_ = max_gain;
+}
+
+void Encoder::Debounce() {
+  encSwitch.Debounce();
   inc_ = 0;
 
-  if ((a_ & 0x0f) == 0x0e && (b_ & 0x07) == 0x00) {
-    inc_ = 1;
-  } else if ((b_ & 0x0f) == 0x0e && (a_ & 0x07) == 0x00) {
-    inc_ = -1;
+  if (irq_) {
+    // Only OnEdge writes steps_, and a word load is atomic. A detent
+    // counts three quarter steps past the last one, so a contact
+    // bouncing at rest never reports one.
+    const int32_t steps = steps_;
+    while (steps - detent_ >= 3) {
+      detent_ += 4;
+      inc_++;
+    }
+    while (steps - detent_ <= -3) {
+      detent_ -= 4;
+      inc_--;
+    }
+  } else if (bank_) {
+    if (bank_->RawFell(bank_a_) && bank_->RawLow(bank_b_)) {
+      inc_ = 1;
+    } else if (bank_->RawFell(bank_b_) && bank_->RawLow(bank_a_)) {
+      inc_ = -1;
+    }
+  } else {
+    uint8_t a_in = digitalRead(pinA_);
+    uint8_t b_in = digitalRead(pinB_);
+
+    a_ = (a_ << 1) | (a_in);
+    b_ = (b_ << 1) | (b_in);
+
+    if ((a_ & 0x0f) == 0x0e && (b_ & 0x07) == 0x00) {
+      inc_ = 1;
+    } else if ((b_ & 0x0f) == 0x0e && (a_ & 0x07) == 0x00) {
+      inc_ = -1;
+    }
+  }
+
+  // A turn the other way starts from rest rather than decelerating
+  // through zero.
+  if ((inc_ > 0 && velocity_ < 0.f) || (inc_ < 0 && velocity_ > 0.f))
+    velocity_ = 0.f;
+  velocity_ += velocity_coeff_ * ((float)inc_ * update_rate_ - velocity_);
+
+  float gain = 1.f;
+  if (accel_speed_ > 0.f) {
+    gain = 1.f + fabsf(velocity_) / accel_speed_;
+    gain = gain < accel_max_ ? gain : accel_max_;
   }
+  accel_frac_ += (float)inc_ * gain;
+  accel_inc_ = (int32_t)accel_frac_;
+  accel_frac_ -= (float)accel_inc_;
+  if (inc_ == 0 && velocity_ > -1.f && velocity_ < 1.f)
+    accel_frac_ = 0.f;
 }
@@ -14,10 +14,31 @@ public:
   void Init(float update_rate, uint8_t pinA, uint8_t pinB, uint8_t pinClick,
             uint8_t modeA, uint8_t modeB, uint8_t modeC);
 
+  // decodes A and B in their pin change interrupts instead of polling
+  // them, so no step is lost at any spin speed; call after Init and
+  // before UseBank. A and B need EXTI lines (pin numbers within their
+  // port) that no other attachInterrupt() pin uses. Returns false, and
+  // keeps polling, for a pin without one.
+  bool UseInterrupts();
+
+  // hands the pins to a bank after Init, see Switch::UseBank; with
+  // UseInterrupts only the click
+  bool UseBank(DebounceBank &bank);
+
   void Debounce();
 
   int32_t Increment() { return inc_; }
 
+  // detents per second, signed, averaged over about 50 ms
+  float Velocity() { return velocity_; }
+
+  // Increment() scaled by 1 + |Velocity()| / speed, at most max_gain,
+  // for sweeping a wide parameter fast and still setting it finely.
+  // Off (gain 1) until set.
+  void SetAcceleration(float speed, float max_gain);
+
+  int32_t AcceleratedIncrement() { return accel_inc_; }
+
   bool RisingEdge() { return encSwitch.RisingEdge(); }
 
   bool FallingEdge() { return encSwitch.FallingEdge(); }
@@ -27,9 +48,25 @@ public:
   float TimeHeldMs() { return encSwitch.TimeHeldMs(); }
 
 private:
+  void OnEdge();
+
   Switch encSwitch;
   uint8_t a_, b_, pinA_, pinB_;
   int32_t inc_;
+
+  // interrupt decoding: quarter steps counted by OnEdge, and the
+  // quarter step of the last detent reported
+  bool irq_ = false;
+  PinName pin_name_a_, pin_name_b_;
+  uint8_t state_;
+  volatile int32_t steps_;
+  int32_t detent_;
+
+  float update_rate_, velocity_, velocity_coeff_;
+  float accel_speed_ = 0.f, accel_max_ = 1.f, accel_frac_;
+  int32_t accel_inc_;
+  const DebounceBank *bank_ = nullptr;
+  DebounceBank::Pin bank_a_, bank_b_;
 };
 } // namespace daisy
 #endif
\ No newline at end of file
@@ -20,6 +20,8 @@ public:
 
   void Debounce() { sw.Debounce(); }
 
+  bool UseBank(DebounceBank &bank) { return sw.UseBank(bank); }
+
 private:
   Switch sw;
 };
@@ -0,0 +1,93 @@
+#include "i2c_dma.h"
+#include <stm32h7xx_hal.h>
+
+using namespace daisy;
+
+static I2C_HandleTypeDef* i2c_dma_handle = nullptr;
+static DMA_HandleTypeDef  i2c_dma_tx;
+
+static volatile bool    i2c_dma_pending = false;
+static I2cDmaTx::DoneFn i2c_dma_done    = nullptr;
+static void*            i2c_dma_context = nullptr;
+
+bool I2cDmaTx::Init(TwoWire& wire)
+{
+    I2C_HandleTypeDef* hi2c = wire.getHandle();
+    uint32_t           request;
+    if(hi2c->Instance == I2C1)
+        request = DMA_REQUEST_I2C1_TX;
+    else if(hi2c->Instance == I2C2)
+        request = DMA_REQUEST_I2C2_TX;
+    else if(hi2c->Instance == I2C3)
+        request = DMA_REQUEST_I2C3_TX;
+    else
+        return false;
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    i2c_dma_tx.Instance                 = DMA1_Stream6;
+    i2c_dma_tx.Init.Request             = request;
+    i2c_dma_tx.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    i2c_dma_tx.Init.PeriphInc           = DMA_PINC_DISABLE;
+    i2c_dma_tx.Init.MemInc              = DMA_MINC_ENABLE;
+    i2c_dma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    i2c_dma_tx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    i2c_dma_tx.Init.Mode                = DMA_NORMAL;
+    i2c_dma_tx.Init.Priority            = DMA_PRIORITY_LOW;
+    i2c_dma_tx.Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+    if(HAL_DMA_Init(&i2c_dma_tx) != HAL_OK)
+        return false;
+    __HAL_LINKDMA(hi2c, hdmatx, i2c_dma_tx);
+    HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+
+    i2c_dma_pending = false;
+    i2c_dma_handle  = hi2c;
+    return true;
+}
+
+bool I2cDmaTx::Transmit(uint8_t        address,
+                        const uint8_t* data,
+                        uint16_t       size,
+                        DoneFn         done,
+                        void*          context)
+{
+    if(i2c_dma_handle == nullptr || IsBusy())
+        return false;
+    i2c_dma_done    = done;
+    i2c_dma_context = context;
+    i2c_dma_pending = true;
+    if(HAL_I2C_Master_Transmit_DMA(i2c_dma_handle,
+                                   static_cast<uint16_t>(address << 1),
+                                   const_cast<uint8_t*>(data),
+                                   size)
+       != HAL_OK)
+    {
+        i2c_dma_pending = false;
+        return false;
+    }
+    return true;
+}
+
+bool I2cDmaTx::IsBusy()
+{
+    if(!i2c_dma_pending)
+        return false;
+    // The HAL goes back to ready on an error too, without calling back.
+    if(HAL_I2C_GetState(i2c_dma_handle) == HAL_I2C_STATE_READY)
+        i2c_dma_pending = false;
+    return i2c_dma_pending;
+}
+
+extern "C" void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    if(hi2c != i2c_dma_handle || !i2c_dma_pending)
+        return;
+    i2c_dma_pending       = false;
+    I2cDmaTx::DoneFn done = i2c_dma_done;
+    if(done != nullptr)
+        done(i2c_dma_context);
+}
+
+extern "C" void DMA1_Stream6_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&i2c_dma_tx);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef DSY_I2C_DMA_H
+#define DSY_I2C_DMA_H
+
+#include "Arduino.h"
+#include <Wire.h>
+#include <stdint.h>
+
+namespace daisy
+{
+/** Background master writes on a Wire bus by DMA.
+
+    Borrows the I2C handle of a TwoWire that has been begun and links
+    DMA1 stream 6 to it for transmit, so a write is queued with
+    Transmit() and goes out with no CPU involvement; the Wire functions
+    keep working on the same bus between transfers. Completion is
+    reported from the I2C interrupt (IRQ_PRIORITY_I2C), which is where
+    a chain of writes, such as one per LED driver chip, starts its next
+    one.
+
+    A transfer that ends in a bus error has no completion: IsBusy()
+    notices that the bus went idle without one and frees the queue.
+
+    The data has to stay put until done and be in memory DMA1 reaches
+    without cache maintenance: DMA_BUFFER_MEM_SECTION. One transfer at a
+    time, one bus per firmware; I2C4 sits on the BDMA and is not
+    supported.
+*/
+class I2cDmaTx
+{
+  public:
+    /** Called from the I2C interrupt when a write has gone out */
+    typedef void (*DoneFn)(void* context);
+
+    /** Links the DMA stream to wire's bus; call after wire.begin().
+        \return false for I2C4 or if the HAL failed
+    */
+    static bool Init(TwoWire& wire);
+
+    /** Starts a write; returns at once.
+        \param address - 7-bit device address
+        \param data - bytes to send, untouched until done
+        \param size - byte count
+        \param done - called once they are out, may be nullptr
+        \param context - passed to done
+        \return false if not initialised or a transfer is running
+    */
+    static bool Transmit(uint8_t        address,
+                         const uint8_t* data,
+                         uint16_t       size,
+                         DoneFn         done,
+                         void*          context);
+
+    /** true while a write started here is on the bus */
+    static bool IsBusy();
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,53 @@
+#include "idle_sleep.h"
+
+using namespace daisy;
+
+// Sleep-mode clocks that nothing needs while the core is stopped.
+static constexpr uint32_t kAhb3SleepGate
+    = RCC_AHB3LPENR_FLASHLPEN | RCC_AHB3LPENR_ITCMLPEN | RCC_AHB3LPENR_QSPILPEN;
+// The Seed runs USB on the internal full-speed PHYs. With a ULPI sleep
+// clock left on and no ULPI PHY fitted, the OTG cores stall in sleep.
+static constexpr uint32_t kAhb1SleepGate
+    = RCC_AHB1LPENR_USB1OTGHSULPILPEN | RCC_AHB1LPENR_USB2OTGFSULPILPEN;
+
+void IdleSleep::Init(bool gate_clocks)
+{
+    if(gate_clocks)
+    {
+        RCC->AHB3LPENR &= ~kAhb3SleepGate;
+        RCC->AHB1LPENR &= ~kAhb1SleepGate;
+    }
+    else
+    {
+        RCC->AHB3LPENR |= kAhb3SleepGate;
+        RCC->AHB1LPENR |= kAhb1SleepGate;
+    }
+    // Sleep, not deep sleep.
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    wake_cycles_     = 0;
+    wake_cycles_max_ = 0;
+}
+
+void IdleSleep::Sleep()
+{
+    // WFI with PRIMASK set still wakes on a pending interrupt, but the
+    // interrupt runs only once the wake-up has been timestamped.
+    __disable_irq();
+    __DSB();
+    __WFI();
+    const uint32_t val  = SysTick->VAL;
+    const bool     tick = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+    __enable_irq();
+    __ISB();
+
+    if(!tick)
+        return;
+    // Counts down from LOAD since the tick; the external reference is
+    // the CPU clock / 8.
+    uint32_t cycles = SysTick->LOAD - val;
+    if((SysTick->CTRL & SysTick_CTRL_CLKSOURCE_Msk) == 0)
+        cycles *= 8;
+    wake_cycles_ = cycles;
+    if(cycles > wake_cycles_max_)
+        wake_cycles_max_ = cycles;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef DSY_IDLE_SLEEP_H
+#define DSY_IDLE_SLEEP_H
+
+#include <stdint.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** Sleeps the core between interrupts, for an otherwise idle loop().
+
+    Sleep() stops the CPU clock with WFI until the next interrupt, the
+    DMA stream of the next audio block or anything else enabled. It is
+    plain Sleep mode, not Stop: the PLLs, the SAI and its DMA keep
+    running, so the audio interrupt sees the clocks it always does and
+    enters a few cycles later than from a busy loop. Stop mode would
+    halt the SAI clock and drop audio.
+
+    The wake-up is timestamped against SysTick, which counts in sleep:
+    when the tick is what ended a Sleep(), the cycles from the tick to
+    the core running again are the wake latency, the same as any other
+    interrupt sees through this path. GetWakeCycles() reports it.
+
+    With gate_clocks, the memory interfaces that only the CPU uses
+    (flash, ITCM, QSPI) and the unused ULPI clocks of the USB cores stop
+    while the core sleeps, and restart with it. The SRAMs, the FMC (for
+    the SDRAM refresh) and every enabled peripheral keep their clocks.
+*/
+class IdleSleep
+{
+  public:
+    IdleSleep() : wake_cycles_(0), wake_cycles_max_(0) {}
+    ~IdleSleep() {}
+
+    /** \param gate_clocks - see above. Can be called again to switch. */
+    void Init(bool gate_clocks);
+
+    /** Returns after the next interrupt has run. Call from thread mode,
+        i.e. loop(), with interrupts enabled. */
+    void Sleep();
+
+    /** Wake latency in CPU cycles, last and largest, measured when a
+        SysTick ended the sleep. 0 until the first one. */
+    inline uint32_t GetWakeCycles() const { return wake_cycles_; }
+    inline uint32_t GetWakeCyclesMax() const { return wake_cycles_max_; }
+
+    inline void ResetWakeCycles() { wake_cycles_max_ = 0; }
+
+  private:
+    uint32_t wake_cycles_;
+    uint32_t wake_cycles_max_;
+};
+
+} // namespace daisy
+#endif
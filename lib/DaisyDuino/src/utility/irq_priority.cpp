@@ -0,0 +1,56 @@
+#include "irq_priority.h"
+
+using namespace daisy;
+
+static void SetLevel(IRQn_Type irq, uint32_t level)
+{
+    HAL_NVIC_SetPriority(irq, level, 0);
+}
+
+void daisy::ApplyIrqPriorities()
+{
+    // SAI1 / SAI2 streams, see SaiHandle::Impl::InitDma.
+    SetLevel(DMA1_Stream0_IRQn, IRQ_PRIORITY_AUDIO);
+    SetLevel(DMA1_Stream1_IRQn, IRQ_PRIORITY_AUDIO);
+    SetLevel(DMA1_Stream3_IRQn, IRQ_PRIORITY_AUDIO);
+    SetLevel(DMA1_Stream4_IRQn, IRQ_PRIORITY_AUDIO);
+    SetLevel(MDMA_IRQn, IRQ_PRIORITY_AUDIO);
+    SetLevel(SAI4_IRQn, IRQ_PRIORITY_AUDIO_RING);
+
+    // HAL_RCC_ClockConfig re-arms the tick at uwTickPrio.
+    SetLevel(SysTick_IRQn, IRQ_PRIORITY_SYSTICK);
+    uwTickPrio = IRQ_PRIORITY_SYSTICK;
+
+    SetLevel(PendSV_IRQn, IRQ_PRIORITY_CONTROL);
+    SetLevel(ADC_IRQn, IRQ_PRIORITY_CONTROL);
+    SetLevel(ADC3_IRQn, IRQ_PRIORITY_CONTROL);
+    // ADC1 scan stream, see AdcScan::Start; transfer errors only.
+    SetLevel(DMA1_Stream2_IRQn, IRQ_PRIORITY_CONTROL);
+    // DAC1 stream, see DacStream::Start; transfer errors only.
+    SetLevel(DMA1_Stream7_IRQn, IRQ_PRIORITY_CONTROL);
+
+    // UsbAudio; the core's own USB stack (USBCON) sets its own.
+#if !defined(USBCON)
+    SetLevel(OTG_FS_IRQn, IRQ_PRIORITY_USB);
+#endif
+
+    // I2C stream, see dsy_dma_init.
+    SetLevel(DMA1_Stream6_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C1_EV_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C1_ER_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C2_EV_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C2_ER_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C3_EV_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C3_ER_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C4_EV_IRQn, IRQ_PRIORITY_I2C);
+    SetLevel(I2C4_ER_IRQn, IRQ_PRIORITY_I2C);
+
+    // microSD, see SdCard::Init.
+    SetLevel(SDMMC1_IRQn, IRQ_PRIORITY_STORAGE);
+
+    // OLED SPI and its stream, see OledSsd1309::Init.
+    SetLevel(DMA2_Stream0_IRQn, IRQ_PRIORITY_DISPLAY);
+    SetLevel(SPI1_IRQn, IRQ_PRIORITY_DISPLAY);
+    SetLevel(SPI2_IRQn, IRQ_PRIORITY_DISPLAY);
+    SetLevel(SPI3_IRQn, IRQ_PRIORITY_DISPLAY);
+}
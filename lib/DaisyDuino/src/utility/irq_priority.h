@@ -0,0 +1,79 @@
+#pragma once
+#ifndef DSY_IRQ_PRIORITY_H
+#define DSY_IRQ_PRIORITY_H
+
+#include <stdint.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** Preemption levels for the interrupts DaisyDuino cares about. Lower
+    numbers preempt higher ones; the Arduino core runs the NVIC with all
+    four priority bits as preemption bits.
+
+    Level 0 cannot be masked by BASEPRI, so nothing that shares data
+    through an IrqPriorityLock may sit there.
+
+    - SYNC: SampleSync's edge interrupt, which has to timestamp the edge
+      even while the audio callback runs. It only reads counters.
+    - AUDIO: SAI DMA streams and the MDMA (de)interleave. A block is
+      never delayed by anything below.
+    - AUDIO_RING: callbacks of a deeper DMA ring (SAI4 vector).
+    - SYSTICK: millis() and HAL timeouts keep counting while the lower
+      levels below spin on them.
+    - CONTROL: AudioHandle's control callback (PendSV), the ADCs and
+      Encoder's pin change interrupts (Encoder::UseInterrupts).
+    - USB: UsbAudio's OTG interrupt. Its FIFO to the audio callback
+      relies on the callback preempting it, never the other way round.
+    - I2C: the I2C event / error interrupts and the I2C DMA stream,
+      which carry the PCA9685 LED refresh.
+    - STORAGE: SdCard's SDMMC1 interrupt, the end of a block transfer;
+      the card's own stalls are far longer than anything above.
+    - DISPLAY: OledSsd1309's SPI and DMA completions, which only chain
+      the next page run of a frame.
+*/
+enum IrqPriority : uint32_t
+{
+    IRQ_PRIORITY_SYNC       = 0,
+    IRQ_PRIORITY_AUDIO      = 1,
+    IRQ_PRIORITY_AUDIO_RING = 2,
+    IRQ_PRIORITY_SYSTICK    = 3,
+    IRQ_PRIORITY_CONTROL    = 6,
+    IRQ_PRIORITY_USB        = 8,
+    IRQ_PRIORITY_I2C        = 10,
+    IRQ_PRIORITY_STORAGE    = 11,
+    IRQ_PRIORITY_DISPLAY    = 12,
+};
+
+/** Sets every interrupt above to its level. DAISY.init() calls it last;
+    call it again after anything that sets its own priorities, e.g.
+    Wire.begin() (LedDriverPca9685::Init() does). */
+void ApplyIrqPriorities();
+
+/** Critical section for sharing data with an interrupt, by level.
+
+    Raises BASEPRI for its lifetime so that every interrupt at level or
+    lower priority waits, while the ones above keep running. Sharing a
+    parameter with the control callback from loop() takes
+    IrqPriorityLock lock(IRQ_PRIORITY_CONTROL) and never holds off an
+    audio block, which a PRIMASK section would. Nests: an inner lock
+    only ever raises the mask, and each restores what it found.
+*/
+class IrqPriorityLock
+{
+  public:
+    explicit IrqPriorityLock(uint32_t level) : saved_(__get_BASEPRI())
+    {
+        __set_BASEPRI_MAX(level << (8U - __NVIC_PRIO_BITS));
+    }
+    ~IrqPriorityLock() { __set_BASEPRI(saved_); }
+
+  private:
+    IrqPriorityLock(const IrqPriorityLock&) = delete;
+    IrqPriorityLock& operator=(const IrqPriorityLock&) = delete;
+
+    uint32_t saved_;
+};
+
+} // namespace daisy
+#endif
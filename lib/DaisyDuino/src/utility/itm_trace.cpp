@@ -0,0 +1,89 @@
+#include "itm_trace.h"
+
+using namespace daisy;
+
+// The H7's SWO output stage and its trace funnel sit on the debug APB,
+// outside what CMSIS describes (RM0433, debug infrastructure).
+static volatile uint32_t* const kDbgmcuCr = (volatile uint32_t*)0x5C001004;
+static volatile uint32_t* const kSwoCodr  = (volatile uint32_t*)0x5C003010;
+static volatile uint32_t* const kSwoSppr  = (volatile uint32_t*)0x5C0030F0;
+static volatile uint32_t* const kSwoLar   = (volatile uint32_t*)0x5C003FB0;
+static volatile uint32_t* const kSwtfCtrl = (volatile uint32_t*)0x5C004000;
+static volatile uint32_t* const kSwtfLar  = (volatile uint32_t*)0x5C004FB0;
+
+static const uint32_t kCoreSightKey = 0xC5ACCE55;
+
+// DBGMCU_CR: trace clock, D1 and D3 debug clocks.
+static const uint32_t kDbgmcuTraceClocks = 0x00700000;
+
+// A byte of text waits at most this many polls for the FIFO; without a
+// probe or UART reading the pin it still drains, so this only bounds a
+// misconfigured port.
+static const uint32_t kTextSpinLimit = 100000;
+
+void ItmTrace::Init(uint32_t baud, uint32_t port_mask)
+{
+    for(size_t i = 0; i < kPorts; i++)
+    {
+        slots_[i].seq = 0;
+        sent_[i]      = 0;
+    }
+    dropped_ = 0;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    *kDbgmcuCr |= kDbgmcuTraceClocks;
+
+    // SWO: NRZ at baud, fed by the funnel's ITM input.
+    *kSwoLar  = kCoreSightKey;
+    *kSwoCodr = SystemCoreClock / baud - 1;
+    *kSwoSppr = 2;
+    *kSwtfLar = kCoreSightKey;
+    *kSwtfCtrl |= 1;
+
+    // PB3 as TRACESWO.
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    GPIO_InitTypeDef gpio = {};
+    gpio.Pin              = GPIO_PIN_3;
+    gpio.Mode             = GPIO_MODE_AF_PP;
+    gpio.Pull             = GPIO_NOPULL;
+    gpio.Speed            = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio.Alternate        = GPIO_AF0_TRACE;
+    HAL_GPIO_Init(GPIOB, &gpio);
+
+    // ITM on trace bus 1, with sync packets off the cycle counter so a
+    // decoder that starts mid-stream finds the packet boundaries.
+    DWT->LAR = kCoreSightKey;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk | (1U << DWT_CTRL_SYNCTAP_Pos);
+    ITM->LAR = kCoreSightKey;
+    ITM->TCR = 0;
+    ITM->TPR = 0; // all ports writable unprivileged
+    ITM->TCR = (1U << 16) | ITM_TCR_SYNCENA_Msk | ITM_TCR_ITMENA_Msk;
+    ITM->TER = port_mask;
+    enabled_ = true;
+}
+
+void ItmTrace::Flush()
+{
+    for(size_t port = 1; port < kPorts; port++)
+    {
+        const uint32_t seq = slots_[port].seq;
+        if(seq == sent_[port])
+            continue;
+        if(ITM->PORT[port].u32 == 0)
+            return; // FIFO full again; the rest wait for the next pass
+        ITM->PORT[port].u32 = slots_[port].value;
+        dropped_ += seq - sent_[port] - 1;
+        sent_[port] = seq;
+    }
+}
+
+size_t ItmTrace::write(uint8_t c)
+{
+    if(!enabled_ || (ITM->TER & 1) == 0)
+        return 0;
+    for(uint32_t spin = 0; ITM->PORT[0].u32 == 0; spin++)
+        if(spin == kTextSpinLimit)
+            return 0;
+    ITM->PORT[0].u8 = c;
+    return 1;
+}
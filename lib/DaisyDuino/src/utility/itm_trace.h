@@ -0,0 +1,101 @@
+#pragma once
+#ifndef DSY_ITM_TRACE_H
+#define DSY_ITM_TRACE_H
+
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** Telemetry and logging over the SWO pin (PB3, the debug header's
+    TRACESWO) through the ITM stimulus ports, without the USB stack.
+
+    Port 0 is text: ItmTrace is an Arduino Print, so itm.print(...) from
+    loop() logs like Serial does, waiting only for the ITM's own FIFO,
+    a few cycles per byte at the SWO rate. Ports 1 to 31 carry 32-bit
+    metrics, one per port: Write(port, value) from any context,
+    including the audio callback, costs a register read and store when
+    the stimulus FIFO has room. When it has not, the value is parked in
+    the port's slot, newest wins, and Flush() from loop() sends it
+    later; a metric is a level, not a log, so nothing queues up behind
+    it. Each slot has one writer and the flusher only reads it, so
+    nothing is masked.
+
+    A second context can fill the FIFO between Flush()'s ready check
+    and its store; the ITM then drops that word, uncounted. The next
+    Write() to the port replaces it.
+
+    The SWO runs as NRZ (UART) at Init()'s baud rate, from the core
+    clock. scripts/swo_decode.py reads it from a USB UART on PB3, or from
+    a file of raw SWO bytes an ST-Link or J-Link probe captured.
+
+    usage:
+
+    static ItmTrace itm;
+    itm.Init(2000000);           // in setup()
+    itm.Write(kLoadPort, load);  // in the audio callback
+    itm.Flush();                 // in loop()
+    itm.println("started");      // in loop()
+*/
+class ItmTrace : public ::Print
+{
+  public:
+    static constexpr size_t kPorts = 32;
+
+    ItmTrace() {}
+    ~ItmTrace() {}
+
+    /** Routes the ITM to the SWO pin (PB3), NRZ at baud.
+        \param port_mask stimulus ports to enable, bit n for port n */
+    void Init(uint32_t baud = 2000000, uint32_t port_mask = 0xFFFFFFFF);
+
+    /** Any context: sends value on port, or parks it for Flush() */
+    inline void Write(uint8_t port, uint32_t value)
+    {
+        if(port == 0 || port >= kPorts)
+            return;
+        if(ITM->PORT[port].u32 != 0)
+        {
+            ITM->PORT[port].u32 = value;
+            return;
+        }
+        slots_[port].value = value;
+        slots_[port].seq   = slots_[port].seq + 1;
+    }
+
+    /** Any context: a float metric, as its bits */
+    inline void Write(uint8_t port, float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        Write(port, bits);
+    }
+
+    /** From loop(): sends what Write() had to park */
+    void Flush();
+
+    /** Parked values a newer one replaced before Flush() sent them */
+    uint32_t Dropped() const { return dropped_; }
+
+    /** Print: one byte of text on port 0; from loop() only */
+    size_t write(uint8_t c) override;
+    using ::Print::write;
+
+  private:
+    struct Slot
+    {
+        volatile uint32_t value;
+        volatile uint32_t seq;
+    };
+
+    bool     enabled_ = false;
+    Slot     slots_[kPorts];
+    uint32_t sent_[kPorts];
+    uint32_t dropped_;
+};
+
+} // namespace daisy
+#endif
@@ -5,7 +5,9 @@
 #ifdef __cplusplus
 
 #include "Arduino.h"
+#include "utility/i2c_dma.h"
 #include "utility/pca9685.h"
+#include "utility/irq_priority.h"
 #include <Wire.h>
 #include <stdint.h>
 
@@ -15,7 +17,12 @@ namespace daisy {
  * It includes gamma correction from 8bit brightness values but it
  * can also be supplied with raw 12bit values.
  * This driver uses two buffers - one for drawing, one for transmitting.
- * Multiple LedDriverPca9685 instances can be used at the same time.
+ * The transmit buffer goes out by DMA (I2cDmaTx), one auto-incremented
+ * 65 byte write per chip chained from the I2C interrupt, so a refresh
+ * costs loop() only the buffer swap. Without the DMA it falls back to
+ * blocking Wire writes.
+ * Multiple LedDriverPca9685 instances can be used at the same time, as
+ * long as their refreshes do not overlap.
  * \param numDrivers    The number of PCA9685 driver attached to the I2C
  *                      peripheral.
  * \param persistentBufferContents If set to true, the current draw buffer
@@ -75,6 +82,9 @@ public:
 
     InitializeBuffers();
     InitializeDrivers();
+    use_dma_ = I2cDmaTx::Init(Wire);
+    // Wire.begin() set its own I2C priority; put the refresh back below audio.
+    daisy::ApplyIrqPriorities();
   }
 
   /** Returns the number of leds available from this driver. */
@@ -128,12 +138,13 @@ public:
   }
 
   /** Swaps the current draw buffer and the current transmit buffer and
-   *  starts transmitting the values to all chips.
+   *  starts transmitting the values to all chips. Never waits: while the
+   *  last frame is still going out nothing is swapped and it returns
+   *  false; the draw buffer is kept for the next call.
    */
-  void SwapBuffersAndTransmit() {
-    // wait for current transmission to complete
-    while (current_driver_idx_ >= 0) {
-    };
+  bool SwapBuffersAndTransmit() {
+    if (IsTransmitting())
+      return false;
 
     // swap buffers
     auto tmp = transmit_buffer_;
@@ -150,10 +161,42 @@ public:
 
     // start transmission
     current_driver_idx_ = -1;
-    ContinueTransmission();
+    if (use_dma_)
+      ContinueDmaTransmission();
+    else
+      ContinueTransmission();
+    return true;
+  }
+
+  /** Returns true while a frame is still going out. */
+  bool IsTransmitting() {
+    if (current_driver_idx_ < 0)
+      return false;
+    // a bus error ends the chain without a completion
+    if (!I2cDmaTx::IsBusy())
+      current_driver_idx_ = -1;
+    return current_driver_idx_ >= 0;
   }
 
 private:
+  // Next chip's write; runs in the I2C interrupt after the first.
+  void ContinueDmaTransmission() {
+    const int d = current_driver_idx_ + 1;
+    if (d >= numDrivers) {
+      current_driver_idx_ = -1;
+      return;
+    }
+    current_driver_idx_ = d;
+    if (!I2cDmaTx::Transmit(PCA9685_I2C_BASE_ADDRESS | addresses_[d],
+                            reinterpret_cast<const uint8_t *>(&transmit_buffer_[d]),
+                            PCA9685TransmitBuffer::size, &OnTransmitDone, this))
+      current_driver_idx_ = -1;
+  }
+
+  static void OnTransmitDone(void *context) {
+    static_cast<LedDriverPca9685 *>(context)->ContinueDmaTransmission();
+  }
+
   void ContinueTransmission() {
     while (current_driver_idx_ < numDrivers) {
       current_driver_idx_++;
@@ -215,9 +258,10 @@ private:
   uint32_t oe_pin_;
 
   myPCA9685 driver_;
+  bool use_dma_ = false;
 
   // index of the driver that is currently updated.
-  int8_t current_driver_idx_;
+  volatile int8_t current_driver_idx_;
   uint16_t gamma_table_[256] = {
       0,    1,    1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
       2,    2,    2,    2,    2,    2,    2,    3,    3,    4,    4,    5,
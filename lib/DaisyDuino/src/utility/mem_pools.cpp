@@ -0,0 +1,166 @@
+#include "mem_pools.h"
+
+using namespace daisy;
+
+namespace
+{
+struct TierRange
+{
+    uintptr_t   start;
+    size_t      size;
+    const char* name;
+};
+
+// STM32H750 memory map, in MemTier order.
+const TierRange kTiers[MemPools::kNumTiers] = {
+    {0x20000000, 128 * 1024, "DTCM"},
+    {0x24000000, 512 * 1024, "AXI SRAM"},
+    {0x30000000, 288 * 1024, "SRAM D2"},
+    {0xC0000000, 64 * 1024 * 1024, "SDRAM"},
+};
+} // namespace
+
+MemTier daisy::GetMemTier(const void* p)
+{
+    const uintptr_t a = reinterpret_cast<uintptr_t>(p);
+    for(size_t i = 0; i < MemPools::kNumTiers; i++)
+    {
+        if(a - kTiers[i].start < kTiers[i].size)
+            return static_cast<MemTier>(i);
+    }
+    return MemTier::COUNT;
+}
+
+const char* daisy::GetMemTierName(MemTier tier)
+{
+    return tier < MemTier::COUNT ? kTiers[static_cast<size_t>(tier)].name
+                                 : "other";
+}
+
+bool MemPools::AddPool(void* mem, size_t size)
+{
+    const MemTier tier = GetMemTier(mem);
+    if(tier == MemTier::COUNT || GetPool(tier).GetCapacity() != 0)
+        return false;
+    GetPool(tier).Init(mem, size);
+    return true;
+}
+
+void* MemPools::Allocate(MemTier     tier,
+                         size_t      bytes,
+                         const char* name,
+                         size_t      align)
+{
+    if(tier >= MemTier::COUNT)
+        return nullptr;
+    void* p = GetPool(tier).Allocate(bytes, align);
+    if(p == nullptr)
+        return nullptr;
+
+    // Anything recorded at or above p was released and is gone now.
+    for(size_t i = 0; i < num_records_; i++)
+    {
+        Record& r = records_[i];
+        if(r.pooled && r.addr >= reinterpret_cast<uintptr_t>(p)
+           && GetMemTier(reinterpret_cast<const void*>(r.addr)) == tier)
+            r.name = nullptr;
+    }
+    if(name != nullptr)
+        AddRecord(name, p, bytes, true);
+    return p;
+}
+
+void* MemPools::AllocateFastest(MemTier     fastest,
+                                size_t      bytes,
+                                const char* name,
+                                size_t      align)
+{
+    for(size_t i = static_cast<size_t>(fastest); i < kNumTiers; i++)
+    {
+        void* p = Allocate(static_cast<MemTier>(i), bytes, name, align);
+        if(p != nullptr)
+            return p;
+    }
+    return nullptr;
+}
+
+void MemPools::Note(const char* name, const void* p, size_t bytes)
+{
+    AddRecord(name, p, bytes, false);
+}
+
+void MemPools::AddRecord(const char* name,
+                         const void* p,
+                         size_t      bytes,
+                         bool        pooled)
+{
+    // Records left behind by a Release() are reused first.
+    size_t slot = num_records_;
+    for(size_t i = 0; i < num_records_; i++)
+    {
+        if(!IsLive(records_[i]))
+        {
+            slot = i;
+            break;
+        }
+    }
+    if(slot == kMaxRecords)
+        return;
+    if(slot == num_records_)
+        num_records_++;
+    records_[slot].name   = name;
+    records_[slot].addr   = reinterpret_cast<uintptr_t>(p);
+    records_[slot].bytes  = bytes;
+    records_[slot].pooled = pooled;
+}
+
+bool MemPools::IsLive(const Record& r)
+{
+    if(r.name == nullptr)
+        return false;
+    if(!r.pooled)
+        return true;
+    const MemTier tier = GetMemTier(reinterpret_cast<const void*>(r.addr));
+    if(tier == MemTier::COUNT)
+        return false;
+    const SdramArena& pool = GetPool(tier);
+    return r.addr + r.bytes
+           <= reinterpret_cast<uintptr_t>(pool.GetBase()) + pool.GetUsed();
+}
+
+void MemPools::Report(Print& out)
+{
+    for(size_t i = 0; i < kNumTiers; i++)
+    {
+        const SdramArena& pool = pools_[i];
+        out.print(kTiers[i].name);
+        if(pool.GetCapacity() == 0)
+        {
+            out.println(": no pool");
+            continue;
+        }
+        out.print(": ");
+        out.print(static_cast<uint32_t>(pool.GetUsed()));
+        out.print(" / ");
+        out.print(static_cast<uint32_t>(pool.GetCapacity()));
+        out.print(" B used, high-water ");
+        out.print(static_cast<uint32_t>(pool.GetHighWater()));
+        out.print(" B, failed ");
+        out.println(static_cast<uint32_t>(pool.GetFailedAllocations()));
+    }
+    for(size_t i = 0; i < num_records_; i++)
+    {
+        const Record& r = records_[i];
+        if(!IsLive(r))
+            continue;
+        out.print("  ");
+        out.print(r.name);
+        out.print(": ");
+        out.print(GetMemTierName(GetMemTier(reinterpret_cast<const void*>(r.addr))));
+        out.print(r.pooled ? " pool 0x" : " static 0x");
+        out.print(static_cast<uint32_t>(r.addr), HEX);
+        out.print(", ");
+        out.print(static_cast<uint32_t>(r.bytes));
+        out.println(" B");
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+#ifndef DSY_MEM_POOLS_H
+#define DSY_MEM_POOLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Print.h>
+#include "daisy_core.h"
+#include "sdram.h"
+#include "sdram_arena.h"
+
+/** Static placement, one macro per tier, fastest first:
+
+    DSY_MEM_DTCM   DTCM, 128 KB. Zero wait states, not behind the cache,
+                   no DMA. May not be zeroed at startup: Init() it all.
+    DSY_MEM_AXI    AXI SRAM, 512 KB. Plain statics: the board script puts
+                   .bss there. Cached.
+    DSY_MEM_D2     SRAM1-3 on D2, the uncached DMA_BUFFER_MEM_SECTION
+                   window. For DMA buffers, slow for DSP state.
+    DSY_MEM_SDRAM  SDRAM on the FMC, 64 MB, cached. Large delay lines.
+
+    MemPools::Report() tells where things actually landed.
+*/
+#define DSY_MEM_DTCM DTCM_MEM_SECTION
+#define DSY_MEM_AXI
+#define DSY_MEM_D2 DMA_BUFFER_MEM_SECTION
+#define DSY_MEM_SDRAM DSY_SDRAM_BSS
+
+namespace daisy
+{
+/** Memories of the H750, fastest first */
+enum class MemTier : uint8_t
+{
+    DTCM,
+    AXI_SRAM,
+    SRAM_D2,
+    SDRAM,
+    COUNT,
+};
+
+/** \return the tier p is in, or COUNT (flash, ITCM, SRAM4, QSPI) */
+MemTier GetMemTier(const void* p);
+
+/** \return a short name for tier, for reports */
+const char* GetMemTierName(MemTier tier);
+
+/** One SdramArena per memory tier, and a record of what lives where.
+
+    Each tier gets its pool from a static block placed with the macros
+    above; AddPool() works out the tier from the address. Allocate()
+    takes memory from one tier, AllocateFastest() from the fastest tier
+    at or below the one asked for that still has room, so hot state goes
+    to DTCM while it lasts and spills over instead of failing.
+
+    Allocations with a name, and statics passed to Note(), are kept for
+    Report(): call it once at boot, after setup, to see every tier's use
+    and the placement of each named block. Released regions drop out.
+
+    The DaisySP modules with large internal arrays take caller memory
+    instead: build with -DDSY_REVERBSC_MAX_SIZE=0 and use ReverbSc's
+    Init(sample_rate, mem, size), and BasicPitchShifter<0>'s
+    Init(sr, mem, size).
+
+    From the main loop only, like SdramArena.
+
+    usage example:
+
+    static uint8_t DSY_MEM_DTCM  dtcm_pool[48 * 1024];
+    static uint8_t DSY_MEM_SDRAM sdram_pool[16 * 1024 * 1024];
+    MemPools mem;
+    mem.AddPool(dtcm_pool, sizeof(dtcm_pool));
+    mem.AddPool(sdram_pool, sizeof(sdram_pool));
+    size_t n  = ReverbSc::GetMemorySize(sample_rate);
+    float *rv = mem.AllocateFastest<float>(MemTier::DTCM, n, "reverb");
+    if(rv)
+        verb.Init(sample_rate, rv, n);
+    mem.Note("pipeline", &pipeline, sizeof(pipeline));
+    mem.Report(Serial);
+*/
+class MemPools
+{
+  public:
+    static constexpr size_t kNumTiers   = static_cast<size_t>(MemTier::COUNT);
+    static constexpr size_t kMaxRecords = 32;
+
+    MemPools() : num_records_(0) {}
+    ~MemPools() {}
+
+    /** Gives a tier its pool
+        \param mem Static block in one of the tiers
+        \param size Bytes at mem
+        \return false if mem is in no tier, or its tier already has one
+    */
+    bool AddPool(void* mem, size_t size);
+
+    /** \param tier Tier to take the memory from
+        \param bytes Size of the allocation
+        \param name Kept for Report(), or nullptr
+        \param align Power of two
+        \return memory in tier, or nullptr if it has no room
+    */
+    void* Allocate(MemTier     tier,
+                   size_t      bytes,
+                   const char* name  = nullptr,
+                   size_t      align = SdramArena::kDefaultAlign);
+
+    /** As Allocate(), trying fastest first, then each slower tier */
+    void* AllocateFastest(MemTier     fastest,
+                          size_t      bytes,
+                          const char* name  = nullptr,
+                          size_t      align = SdramArena::kDefaultAlign);
+
+    /** As above, for count Ts, uninitialised */
+    template <typename T>
+    T* Allocate(MemTier tier, size_t count, const char* name = nullptr)
+    {
+        return count > SIZE_MAX / sizeof(T)
+                   ? nullptr
+                   : static_cast<T*>(
+                       Allocate(tier, count * sizeof(T), name, AlignOf<T>()));
+    }
+    template <typename T>
+    T* AllocateFastest(MemTier fastest, size_t count, const char* name = nullptr)
+    {
+        return count > SIZE_MAX / sizeof(T)
+                   ? nullptr
+                   : static_cast<T*>(AllocateFastest(
+                       fastest, count * sizeof(T), name, AlignOf<T>()));
+    }
+
+    /** The pool of one tier, for Mark() / Release() at a mode switch */
+    inline SdramArena& GetPool(MemTier tier)
+    {
+        return pools_[static_cast<size_t>(tier)];
+    }
+
+    /** Records a static block for Report() */
+    void Note(const char* name, const void* p, size_t bytes);
+
+    /** Prints each tier's pool use, high-water mark and failed
+        allocations (AllocateFastest() spills included), then every named
+        block with its tier, address and size. */
+    void Report(Print& out);
+
+  private:
+    struct Record
+    {
+        const char* name; // nullptr: free slot
+        uintptr_t   addr;
+        size_t      bytes;
+        bool        pooled;
+    };
+
+    template <typename T>
+    static constexpr size_t AlignOf()
+    {
+        return alignof(T) > SdramArena::kDefaultAlign
+                   ? alignof(T)
+                   : SdramArena::kDefaultAlign;
+    }
+
+    void AddRecord(const char* name, const void* p, size_t bytes, bool pooled);
+    bool IsLive(const Record& r);
+
+    SdramArena pools_[kNumTiers];
+    Record     records_[kMaxRecords];
+    size_t     num_records_;
+};
+
+} // namespace daisy
+#endif
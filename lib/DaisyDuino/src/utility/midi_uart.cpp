@@ -0,0 +1,242 @@
+#include "midi_uart.h"
+#include "daisy_core.h"
+#include <stm32h7xx_hal.h>
+
+using namespace daisy;
+
+static DMA_HandleTypeDef midi_uart_dma;
+
+// Written by the DMA only.
+static volatile uint8_t DMA_BUFFER_MEM_SECTION
+    midi_uart_buffer[MidiUartRx::kDmaSize];
+
+static constexpr uint32_t kMidiBaud = 31250;
+
+// Kernel clocks are the reset defaults: PCLK2 for USART1 / 6, PCLK1 for
+// the rest.
+static bool EnableUart(USART_TypeDef* uart, uint32_t* request, uint32_t* clock)
+{
+    if(uart == USART1)
+    {
+        __HAL_RCC_USART1_CLK_ENABLE();
+        *request = DMA_REQUEST_USART1_RX;
+        *clock   = HAL_RCC_GetPCLK2Freq();
+    }
+    else if(uart == USART2)
+    {
+        __HAL_RCC_USART2_CLK_ENABLE();
+        *request = DMA_REQUEST_USART2_RX;
+        *clock   = HAL_RCC_GetPCLK1Freq();
+    }
+    else if(uart == USART3)
+    {
+        __HAL_RCC_USART3_CLK_ENABLE();
+        *request = DMA_REQUEST_USART3_RX;
+        *clock   = HAL_RCC_GetPCLK1Freq();
+    }
+    else if(uart == UART4)
+    {
+        __HAL_RCC_UART4_CLK_ENABLE();
+        *request = DMA_REQUEST_UART4_RX;
+        *clock   = HAL_RCC_GetPCLK1Freq();
+    }
+    else if(uart == UART5)
+    {
+        __HAL_RCC_UART5_CLK_ENABLE();
+        *request = DMA_REQUEST_UART5_RX;
+        *clock   = HAL_RCC_GetPCLK1Freq();
+    }
+    else if(uart == USART6)
+    {
+        __HAL_RCC_USART6_CLK_ENABLE();
+        *request = DMA_REQUEST_USART6_RX;
+        *clock   = HAL_RCC_GetPCLK2Freq();
+    }
+    else if(uart == UART7)
+    {
+        __HAL_RCC_UART7_CLK_ENABLE();
+        *request = DMA_REQUEST_UART7_RX;
+        *clock   = HAL_RCC_GetPCLK1Freq();
+    }
+    else if(uart == UART8)
+    {
+        __HAL_RCC_UART8_CLK_ENABLE();
+        *request = DMA_REQUEST_UART8_RX;
+        *clock   = HAL_RCC_GetPCLK1Freq();
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool MidiUartRx::Init(uint32_t rx_pin, float sample_rate, FrameCountFn frame_count)
+{
+    const PinName  name = digitalPinToPinName(rx_pin);
+    USART_TypeDef* uart
+        = static_cast<USART_TypeDef*>(pinmap_peripheral(name, PinMap_UART_RX));
+    uint32_t request, clock;
+    if(uart == nullptr || !EnableUart(uart, &request, &clock))
+        return false;
+    pinmap_pinout(name, PinMap_UART_RX);
+
+    frame_count_    = frame_count;
+    read_pos_       = 0;
+    last_poll_      = frame_count_ != nullptr ? frame_count_() : 0;
+    byte_frames_q8_ = static_cast<uint32_t>(sample_rate * 10.f * 256.f / kMidiBaud);
+    delay_          = 0;
+    dropped_        = 0;
+    running_        = 0;
+    have_ = need_ = 0;
+    sysex_        = false;
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    midi_uart_dma.Instance                 = DMA1_Stream5;
+    midi_uart_dma.Init.Request             = request;
+    midi_uart_dma.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+    midi_uart_dma.Init.PeriphInc           = DMA_PINC_DISABLE;
+    midi_uart_dma.Init.MemInc              = DMA_MINC_ENABLE;
+    midi_uart_dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    midi_uart_dma.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    midi_uart_dma.Init.Mode                = DMA_CIRCULAR;
+    midi_uart_dma.Init.Priority            = DMA_PRIORITY_LOW;
+    midi_uart_dma.Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+    if(HAL_DMA_Init(&midi_uart_dma) != HAL_OK)
+        return false;
+
+    // 8N1, receive only; an overrun must not stop the DMA.
+    uart->CR1 = 0;
+    uart->BRR = (clock + kMidiBaud / 2) / kMidiBaud;
+    uart->CR2 = 0;
+    uart->CR3 = USART_CR3_DMAR | USART_CR3_OVRDIS;
+    if(HAL_DMA_Start(&midi_uart_dma,
+                     (uint32_t)&uart->RDR,
+                     (uint32_t)(uintptr_t)midi_uart_buffer,
+                     kDmaSize)
+       != HAL_OK)
+        return false;
+    // Polled, never interrupts; the stream's vector stays unused.
+    __HAL_DMA_DISABLE_IT(&midi_uart_dma, DMA_IT_HT | DMA_IT_TC | DMA_IT_TE | DMA_IT_DME);
+    uart->CR1 = USART_CR1_RE | USART_CR1_UE;
+    return true;
+}
+
+size_t MidiUartRx::Poll()
+{
+    const uint32_t now = frame_count_ != nullptr ? frame_count_() : 0;
+    const uint32_t write_pos
+        = kDmaSize - __HAL_DMA_GET_COUNTER(&midi_uart_dma);
+    const uint32_t count = (write_pos - read_pos_) & (kDmaSize - 1);
+    if(count == 0)
+    {
+        last_poll_ = now;
+        return 0;
+    }
+
+    const size_t queued = queue_.Size();
+    // Back to back up to now, but not before the last poll.
+    const uint32_t span   = now - last_poll_;
+    uint32_t       behind = ((count - 1) * byte_frames_q8_) >> 8;
+    behind                = behind > span ? span : behind;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t ago   = ((count - 1 - i) * byte_frames_q8_) >> 8;
+        const uint32_t frame = now - (ago < behind ? ago : behind);
+        Parse(midi_uart_buffer[(read_pos_ + i) & (kDmaSize - 1)], frame);
+    }
+    read_pos_  = write_pos & (kDmaSize - 1);
+    last_poll_ = now;
+    const size_t now_queued = queue_.Size();
+    return now_queued > queued ? now_queued - queued : 0;
+}
+
+bool MidiUartRx::PopDue(uint32_t   block_frame,
+                        size_t     size,
+                        MidiEvent& out,
+                        size_t&    offset)
+{
+    const MidiEvent* ev = queue_.Peek();
+    if(ev == nullptr)
+        return false;
+    const int32_t at = static_cast<int32_t>(ev->frame + delay_ - block_frame);
+    if(at >= static_cast<int32_t>(size))
+        return false;
+    offset = at > 0 ? static_cast<size_t>(at) : 0;
+    return queue_.Pop(out);
+}
+
+void MidiUartRx::Emit(uint8_t  status,
+                      uint8_t  d0,
+                      uint8_t  d1,
+                      uint8_t  size,
+                      uint32_t frame)
+{
+    MidiEvent ev;
+    ev.frame   = frame;
+    ev.status  = status;
+    ev.data[0] = d0;
+    ev.data[1] = d1;
+    ev.size    = size;
+    if(!queue_.Push(ev))
+        dropped_++;
+}
+
+// Data bytes per status byte, 0 for a message that is complete as is.
+static uint8_t DataBytes(uint8_t status)
+{
+    switch(status & 0xF0)
+    {
+        case 0xC0:
+        case 0xD0: return 1;
+        case 0xF0:
+            switch(status)
+            {
+                case 0xF1:
+                case 0xF3: return 1;
+                case 0xF2: return 2;
+                default: return 0;
+            }
+        default: return 2;
+    }
+}
+
+void MidiUartRx::Parse(uint8_t byte, uint32_t frame)
+{
+    if(byte >= 0xF8)
+    {
+        // Realtime: may sit inside any message, leaves it alone.
+        Emit(byte, 0, 0, 1, frame);
+        return;
+    }
+    if(byte & 0x80)
+    {
+        sysex_ = byte == 0xF0;
+        have_  = 0;
+        if(sysex_ || byte == 0xF7)
+        {
+            running_ = 0;
+            return;
+        }
+        need_ = DataBytes(byte);
+        // System common cancels running status.
+        running_ = byte < 0xF0 ? byte : 0;
+        if(need_ == 0)
+            Emit(byte, 0, 0, 1, frame);
+        else if(byte >= 0xF0)
+            running_ = byte;
+        return;
+    }
+
+    if(sysex_ || running_ == 0)
+        return;
+    data_[have_++] = byte;
+    if(have_ < need_)
+        return;
+    // Stamped when complete: the last byte is when it can take effect.
+    Emit(running_, data_[0], need_ > 1 ? data_[1] : 0, need_ + 1, frame);
+    have_ = 0;
+    // System common messages do not repeat.
+    if(running_ >= 0xF0)
+        running_ = 0;
+}
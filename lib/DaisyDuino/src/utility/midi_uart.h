@@ -0,0 +1,121 @@
+#pragma once
+#ifndef DSY_MIDI_UART_H
+#define DSY_MIDI_UART_H
+
+#include "Arduino.h"
+#include "spsc_ring.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace daisy
+{
+/** One MIDI message, stamped with the audio frame it arrived on */
+struct MidiEvent
+{
+    uint32_t frame;   /**< audio frame count at arrival, estimated */
+    uint8_t  status;  /**< status byte, running status resolved */
+    uint8_t  data[2]; /**< data bytes, 0 when unused */
+    uint8_t  size;    /**< bytes in the message, 1 to 3 */
+
+    /** Message type, the status without the channel */
+    inline uint8_t Type() const
+    {
+        return status < 0xF0 ? status & 0xF0 : status;
+    }
+    /** Channel, 0 to 15, for channel messages */
+    inline uint8_t Channel() const { return status & 0x0F; }
+};
+
+/** DIN MIDI in on a UART, received by DMA and queued with timestamps.
+
+    The UART (31250 baud, RX only) is driven through its registers and
+    writes every byte into an uncached ring by circular DMA (DMA1
+    stream 5), with no interrupt at all. Poll() picks up what arrived,
+    parses it (running status, realtime bytes inside messages; SysEx is
+    skipped) and queues whole messages in a lock-free SPSC ring for one
+    consumer, typically the audio callback.
+
+    Each message is stamped in audio frames: a burst found by Poll() is
+    taken to have ended at the poll, one byte time (320 us) apart, but
+    never before the previous poll. PopDue() then releases a message at
+    its stamp plus a fixed delay, at its offset in the block, so notes
+    land with the UART's timing instead of the poll's. The delay has
+    to cover the polling interval; one audio block works when polling
+    from the control callback or at the top of the audio callback.
+
+    The pin must be a UART RX pin (D14 on the Seed, USART1), not in use
+    by a HardwareSerial. One instance per firmware.
+
+    declaration example:
+
+    MidiUartRx midi;
+    midi.Init(D14, DAISY.get_samplerate(), []() { return DAISY.AudioFrameCount(); });
+    ...
+    // audio callback
+    midi.Poll();
+    MidiEvent ev;
+    size_t    at;
+    while(midi.PopDue(DAISY.AudioBlockFrame(), size, ev, at)) { ... }
+*/
+class MidiUartRx
+{
+  public:
+    /** Returns the local frame count, e.g. DAISY.AudioFrameCount() */
+    typedef uint32_t (*FrameCountFn)();
+
+    static constexpr size_t kDmaSize   = 256;
+    static constexpr size_t kQueueSize = 64;
+
+    MidiUartRx() : frame_count_(nullptr) {}
+    ~MidiUartRx() {}
+
+    /** Starts receiving.
+        \param rx_pin - Arduino pin of the MIDI input
+        \param sample_rate - audio sample rate, for the byte time
+        \param frame_count - audio frame counter
+        \return false if the pin has no UART RX or the DMA failed
+    */
+    bool Init(uint32_t rx_pin, float sample_rate, FrameCountFn frame_count);
+
+    /** Frames added to each stamp before PopDue() releases it */
+    inline void SetDelay(uint32_t frames) { delay_ = frames; }
+
+    /** Parses what has arrived since the last call and queues it; from
+        one context only. \return messages queued
+    */
+    size_t Poll();
+
+    /** Pops the next message due before the end of a block.
+        \param block_frame - frame count at the block's first frame
+        \param size - frames in the block
+        \param out - the message
+        \param offset - frame in the block it is due at; 0 if late
+        \return false if none is due yet
+    */
+    bool PopDue(uint32_t block_frame, size_t size, MidiEvent& out, size_t& offset);
+
+    /** Pops the next message whatever its stamp */
+    inline bool Pop(MidiEvent& out) { return queue_.Pop(out); }
+
+    /** Messages lost to a full queue */
+    inline uint32_t GetDropped() const { return dropped_; }
+
+  private:
+    void Parse(uint8_t byte, uint32_t frame);
+    void Emit(uint8_t status, uint8_t d0, uint8_t d1, uint8_t size, uint32_t frame);
+
+    FrameCountFn                    frame_count_;
+    SpscRing<MidiEvent, kQueueSize> queue_;
+    uint32_t                        read_pos_;
+    uint32_t                        last_poll_;
+    uint32_t                        byte_frames_q8_; // frames per byte, Q8
+    uint32_t                        delay_;
+    uint32_t                        dropped_;
+    uint8_t                         running_;
+    uint8_t                         data_[2];
+    uint8_t                         have_, need_;
+    bool                            sysex_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,290 @@
+#include "oled_ssd1309.h"
+#include "daisy_core.h"
+#include <stm32h7xx_hal.h>
+#include <string.h>
+
+using namespace daisy;
+
+static SPI_HandleTypeDef oled_spi;
+static DMA_HandleTypeDef oled_dma;
+static OledSsd1309*      oled_instance = nullptr;
+
+// What the display shows once the transfers are done, and the window
+// command of the run going out; uncached, for DMA2.
+static uint8_t DMA_BUFFER_MEM_SECTION
+    oled_tx[OledSsd1309::kPages * OledSsd1309::kWidth];
+static uint8_t DMA_BUFFER_MEM_SECTION oled_cmd[6];
+
+// U8g2's SSD1309 128x64 setup, in horizontal addressing mode so that a
+// column / page window takes a run of pages in one transfer.
+static const uint8_t kSetup[] = {
+    0xae,       // display off
+    0xd5, 0x80, // clock divide, oscillator
+    0xa8, 0x3f, // multiplex 64
+    0xd3, 0x00, // display offset
+    0x40,       // start line 0
+    0x20, 0x00, // horizontal addressing
+    0xa1,       // segment remap
+    0xc8,       // COM scan reversed
+    0xda, 0x12, // COM pins
+    0x81, 0xcf, // contrast
+    0xd9, 0xf1, // pre-charge
+    0xdb, 0x40, // VCOMH deselect
+    0x2e,       // scroll off
+    0xa4,       // display from RAM
+    0xa6,       // not inverted
+};
+
+// SPI kernel clock dividers, by log2 - 1.
+static const uint32_t kPrescalers[] = {
+    SPI_BAUDRATEPRESCALER_2,
+    SPI_BAUDRATEPRESCALER_4,
+    SPI_BAUDRATEPRESCALER_8,
+    SPI_BAUDRATEPRESCALER_16,
+    SPI_BAUDRATEPRESCALER_32,
+    SPI_BAUDRATEPRESCALER_64,
+    SPI_BAUDRATEPRESCALER_128,
+    SPI_BAUDRATEPRESCALER_256,
+};
+
+bool OledSsd1309::Init(const Config& config)
+{
+    const PinName  sck  = digitalPinToPinName(config.sck_pin);
+    const PinName  mosi = digitalPinToPinName(config.mosi_pin);
+    SPI_TypeDef*   spi  = (SPI_TypeDef*)pinmap_peripheral(sck, PinMap_SPI_SCLK);
+    uint32_t       request;
+    IRQn_Type      irq;
+    if(spi != (SPI_TypeDef*)pinmap_peripheral(mosi, PinMap_SPI_MOSI))
+        return false;
+    if(spi == SPI1)
+    {
+        __HAL_RCC_SPI1_CLK_ENABLE();
+        request = DMA_REQUEST_SPI1_TX;
+        irq     = SPI1_IRQn;
+    }
+    else if(spi == SPI2)
+    {
+        __HAL_RCC_SPI2_CLK_ENABLE();
+        request = DMA_REQUEST_SPI2_TX;
+        irq     = SPI2_IRQn;
+    }
+    else if(spi == SPI3)
+    {
+        __HAL_RCC_SPI3_CLK_ENABLE();
+        request = DMA_REQUEST_SPI3_TX;
+        irq     = SPI3_IRQn;
+    }
+    else
+        return false;
+    pinmap_pinout(sck, PinMap_SPI_SCLK);
+    pinmap_pinout(mosi, PinMap_SPI_MOSI);
+
+    dc_ = digitalPinToPinName(config.dc_pin);
+    pinMode(config.dc_pin, OUTPUT);
+    digitalWriteFast(dc_, LOW);
+    pinMode(config.cs_pin, OUTPUT);
+    digitalWrite(config.cs_pin, LOW);
+    if(config.reset_pin < NUM_DIGITAL_PINS)
+    {
+        pinMode(config.reset_pin, OUTPUT);
+        digitalWrite(config.reset_pin, HIGH);
+        delay(1);
+        digitalWrite(config.reset_pin, LOW);
+        delay(10);
+        digitalWrite(config.reset_pin, HIGH);
+    }
+    delay(10);
+
+    const uint32_t kernel = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_SPI123);
+    size_t         div    = 0;
+    while(div < 7 && (kernel >> (div + 1)) > config.max_clock_hz)
+        div++;
+
+    SPI_HandleTypeDef* hspi       = &oled_spi;
+    hspi->Instance                = spi;
+    hspi->Init.Mode               = SPI_MODE_MASTER;
+    hspi->Init.Direction          = SPI_DIRECTION_2LINES_TXONLY;
+    hspi->Init.DataSize           = SPI_DATASIZE_8BIT;
+    hspi->Init.CLKPolarity        = SPI_POLARITY_LOW;
+    hspi->Init.CLKPhase           = SPI_PHASE_1EDGE;
+    hspi->Init.NSS                = SPI_NSS_SOFT;
+    hspi->Init.BaudRatePrescaler  = kPrescalers[div];
+    hspi->Init.FirstBit           = SPI_FIRSTBIT_MSB;
+    hspi->Init.TIMode             = SPI_TIMODE_DISABLE;
+    hspi->Init.CRCCalculation     = SPI_CRCCALCULATION_DISABLE;
+    hspi->Init.NSSPMode           = SPI_NSS_PULSE_DISABLE;
+    hspi->Init.NSSPolarity        = SPI_NSS_POLARITY_LOW;
+    hspi->Init.FifoThreshold      = SPI_FIFO_THRESHOLD_01DATA;
+    hspi->Init.MasterKeepIOState  = SPI_MASTER_KEEP_IO_STATE_ENABLE;
+    if(HAL_SPI_Init(hspi) != HAL_OK)
+        return false;
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    DMA_HandleTypeDef* hdma        = &oled_dma;
+    hdma->Instance                 = DMA2_Stream0;
+    hdma->Init.Request             = request;
+    hdma->Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    hdma->Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma->Init.MemInc              = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode                = DMA_NORMAL;
+    hdma->Init.Priority            = DMA_PRIORITY_LOW;
+    hdma->Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+    if(HAL_DMA_Init(hdma) != HAL_OK)
+        return false;
+    __HAL_LINKDMA(hspi, hdmatx, *hdma);
+
+    if(HAL_SPI_Transmit(hspi, const_cast<uint8_t*>(kSetup), sizeof(kSetup), 100)
+       != HAL_OK)
+        return false;
+
+    // Blank the display's RAM before it is switched on.
+    memset(oled_tx, 0, sizeof(oled_tx));
+    static const uint8_t kWindow[] = {0x21, 0, kWidth - 1, 0x22, 0, kPages - 1};
+    if(HAL_SPI_Transmit(hspi, const_cast<uint8_t*>(kWindow), sizeof(kWindow), 100)
+       != HAL_OK)
+        return false;
+    digitalWriteFast(dc_, HIGH);
+    if(HAL_SPI_Transmit(hspi, oled_tx, sizeof(oled_tx), 100) != HAL_OK)
+        return false;
+    digitalWriteFast(dc_, LOW);
+    const uint8_t on = 0xaf;
+    if(HAL_SPI_Transmit(hspi, const_cast<uint8_t*>(&on), 1, 100) != HAL_OK)
+        return false;
+
+    memset(buffer_, 0, sizeof(buffer_));
+    dirty_        = 0;
+    busy_         = false;
+    sending_data_ = false;
+    force_        = false;
+    frames_       = 0;
+    pages_sent_   = 0;
+    oled_instance = this;
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+    HAL_NVIC_EnableIRQ(irq);
+    ready_ = true;
+    return true;
+}
+
+bool OledSsd1309::Update(const uint8_t* frame)
+{
+    if(!ready_ || busy_)
+        return false;
+    uint8_t dirty = 0;
+    for(size_t p = 0; p < kPages; p++)
+    {
+        const size_t offset = p * kWidth;
+        if(force_ || memcmp(oled_tx + offset, frame + offset, kWidth) != 0)
+        {
+            memcpy(oled_tx + offset, frame + offset, kWidth);
+            dirty |= static_cast<uint8_t>(1u << p);
+        }
+    }
+    force_ = false;
+    if(dirty == 0)
+        return true;
+    dirty_ = dirty;
+    busy_  = true;
+    StartRun();
+    return true;
+}
+
+bool OledSsd1309::IsBusy() const
+{
+    return busy_;
+}
+
+void OledSsd1309::Fill(bool on)
+{
+    memset(buffer_, on ? 0xff : 0x00, sizeof(buffer_));
+}
+
+void OledSsd1309::StartRun()
+{
+    const uint8_t dirty = dirty_;
+    if(dirty == 0)
+    {
+        frames_ = frames_ + 1;
+        busy_   = false;
+        return;
+    }
+    size_t first = 0;
+    while(!(dirty & (1u << first)))
+        first++;
+    size_t last = first;
+    while(last + 1 < kPages && (dirty & (1u << (last + 1))))
+        last++;
+    run_first_ = first;
+    run_last_  = last;
+
+    oled_cmd[0] = 0x21; // columns
+    oled_cmd[1] = 0;
+    oled_cmd[2] = kWidth - 1;
+    oled_cmd[3] = 0x22; // pages
+    oled_cmd[4] = static_cast<uint8_t>(first);
+    oled_cmd[5] = static_cast<uint8_t>(last);
+    sending_data_ = false;
+    digitalWriteFast(dc_, LOW);
+    if(HAL_SPI_Transmit_DMA(&oled_spi, oled_cmd, sizeof(oled_cmd)) != HAL_OK)
+        TransferError();
+}
+
+void OledSsd1309::TransferDone()
+{
+    if(!sending_data_)
+    {
+        sending_data_ = true;
+        digitalWriteFast(dc_, HIGH);
+        const uint16_t size
+            = static_cast<uint16_t>((run_last_ - run_first_ + 1) * kWidth);
+        if(HAL_SPI_Transmit_DMA(&oled_spi, oled_tx + run_first_ * kWidth, size)
+           != HAL_OK)
+            TransferError();
+        return;
+    }
+    pages_sent_ = pages_sent_ + (run_last_ - run_first_ + 1);
+    const uint32_t run = (2u << run_last_) - (1u << run_first_);
+    dirty_             = dirty_ & static_cast<uint8_t>(~run);
+    StartRun();
+}
+
+void OledSsd1309::TransferError()
+{
+    // The display is somewhere between frames: send all of the next.
+    dirty_ = 0;
+    force_ = true;
+    busy_  = false;
+}
+
+extern "C" void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    if(hspi == &oled_spi && oled_instance != nullptr)
+        oled_instance->TransferDone();
+}
+
+extern "C" void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+    if(hspi == &oled_spi && oled_instance != nullptr)
+        oled_instance->TransferError();
+}
+
+extern "C" void DMA2_Stream0_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&oled_dma);
+}
+
+extern "C" void SPI1_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&oled_spi);
+}
+
+extern "C" void SPI2_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&oled_spi);
+}
+
+extern "C" void SPI3_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&oled_spi);
+}
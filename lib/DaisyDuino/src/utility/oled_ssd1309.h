@@ -0,0 +1,122 @@
+#pragma once
+#ifndef DSY_OLED_SSD1309_H
+#define DSY_OLED_SSD1309_H
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace daisy
+{
+/** 128x64 SSD1309 OLED (Patch, Field) on hardware SPI, pushed by DMA.
+
+    Bit-banged SPI (U8g2's _SW_SPI) costs loop() several milliseconds per
+    frame. Here the frame goes out on the SPI peripheral behind the
+    clock and data pins, fed by DMA2 stream 0, so Update() returns after
+    a compare and a copy and the transfer completes in the background,
+    ~1 ms for a full frame at 8 MHz.
+
+    The frame is page-major, as the controller and U8g2's full buffer
+    have it: 8 pages of 128 bytes, bit n of byte x in page p is pixel
+    (x, 8p + n). Update() compares each page with what was last sent and
+    copies only the dirty ones into a transmit buffer in
+    DMA_BUFFER_MEM_SECTION, then sends each run of dirty pages as a
+    column / page window command and its data, toggling D/C from the SPI
+    completion interrupt (IRQ_PRIORITY_DISPLAY). A meter that changes
+    one page costs 128 bytes, not 1024, and the caller's frame is free
+    again as soon as Update() returns.
+
+    Draw with DrawPixel() / Fill() into Buffer(), or with U8g2 into its
+    own buffer (never begin() it: the pins are this driver's) and pass
+    getBufferPtr() to Update(). Update() from one context, e.g. loop().
+
+    One instance per firmware; the CS pin is held low, so the bus is the
+    display's alone.
+*/
+class OledSsd1309
+{
+  public:
+    static constexpr size_t kWidth  = 128;
+    static constexpr size_t kHeight = 64;
+    static constexpr size_t kPages  = kHeight / 8;
+
+    /** Arduino pin numbers; the defaults are the Patch's and Field's.
+        reset_pin NUM_DIGITAL_PINS for a display without one.
+    */
+    struct Config
+    {
+        uint32_t sck_pin      = 8;
+        uint32_t mosi_pin     = 10;
+        uint32_t cs_pin       = 7;
+        uint32_t dc_pin       = 9;
+        uint32_t reset_pin    = 30;
+        uint32_t max_clock_hz = 8000000;
+    };
+
+    OledSsd1309() : busy_(false), frames_(0), pages_sent_(0), ready_(false) {}
+    ~OledSsd1309() {}
+
+    /** Resets the display, sets up SPI and DMA, clears the buffer and
+        sends the controller its setup; blocking, for setup().
+        \return false if sck / mosi are not one SPI1-3's, or the HAL failed
+    */
+    bool Init(const Config& config);
+
+    /** Init() with the Patch's / Field's pins */
+    inline bool Init() { return Init(Config()); }
+
+    /** Sends the pages of frame that differ from the last sent; returns
+        at once. Nothing to send is a success too.
+        \param frame - kPages * kWidth bytes, page-major; free on return
+        \return false while the previous update is still going out
+    */
+    bool Update(const uint8_t* frame);
+
+    /** Update() of Buffer() */
+    inline bool Update() { return Update(buffer_); }
+
+    /** true while an update is going out */
+    bool IsBusy() const;
+
+    /** Page-major frame for DrawPixel() and Fill(), or direct drawing */
+    inline uint8_t* Buffer() { return buffer_; }
+
+    inline void DrawPixel(size_t x, size_t y, bool on)
+    {
+        if(x >= kWidth || y >= kHeight)
+            return;
+        uint8_t&      b    = buffer_[(y >> 3) * kWidth + x];
+        const uint8_t mask = static_cast<uint8_t>(1u << (y & 7));
+        b = on ? b | mask : b & static_cast<uint8_t>(~mask);
+    }
+
+    void Fill(bool on);
+
+    /** \return updates that went out since Init() */
+    inline uint32_t Frames() const { return frames_; }
+
+    /** \return pages sent since Init(), at most kPages per frame */
+    inline uint32_t PagesSent() const { return pages_sent_; }
+
+    /** From the SPI interrupt: the last transfer went out */
+    void TransferDone();
+
+    /** From the SPI interrupt: the last transfer failed */
+    void TransferError();
+
+  private:
+    /** Sends the window command of the next dirty run, or ends */
+    void StartRun();
+
+    uint8_t           buffer_[kPages * kWidth];
+    PinName           dc_;
+    volatile uint8_t  dirty_;     // pages still to send, bit per page
+    size_t            run_first_, run_last_;
+    volatile bool     sending_data_;
+    volatile bool     busy_;
+    bool              force_;     // the display's RAM is unknown
+    volatile uint32_t frames_, pages_sent_;
+    bool              ready_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef DSY_PARAM_BLOCK_H
+#define DSY_PARAM_BLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+
+namespace daisy
+{
+/** Triple buffer handing a parameter set from one writer to one reader.
+
+    The writer fills Back() (or passes a whole T to Publish()) and
+    publishes it by swapping its buffer with the middle one; the reader
+    takes the middle one at the start of each block with Acquire() and
+    keeps it as long as it likes. Each side only ever touches its own
+    buffer, and the swaps are single atomic exchanges (ldrex / strex),
+    so neither side waits, tears or masks an interrupt, whichever
+    preempts the other: coefficients can be written from loop() while
+    the audio callback reads them.
+
+    Publishing faster than the reader acquires drops the sets between;
+    the reader always gets the newest one.
+
+    declaration example:
+
+    static ParamBlock<BiquadCoeffs> eq;
+    ...
+    eq.Back() = Design(freq, q); // loop()
+    eq.Publish();
+    ...
+    const BiquadCoeffs& c = eq.Acquire(); // AudioCallback, once per block
+*/
+template <typename T>
+class ParamBlock
+{
+  public:
+    ParamBlock() : middle_(1), back_(2), front_(0) {}
+    ~ParamBlock() {}
+
+    /** Sets every buffer to value; before either side runs */
+    void Init(const T& value)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            buf_[i] = value;
+        }
+        front_ = 0;
+        middle_.store(1);
+        back_ = 2;
+    }
+
+    /** The writer's buffer, yet to be published */
+    inline T& Back() { return buf_[back_]; }
+
+    /** Hands Back() to the reader; Back() is then a free buffer whose
+        contents are stale, so fill all of it before publishing again.
+    */
+    inline void Publish()
+    {
+        back_ = middle_.exchange(back_ | kFresh) & kIndex;
+    }
+
+    /** Copies value into Back() and publishes it */
+    inline void Publish(const T& value)
+    {
+        buf_[back_] = value;
+        Publish();
+    }
+
+    /** Reader: takes the newest published set, if any since the last
+        call, and returns the one held. Valid until the next call.
+    */
+    inline const T& Acquire()
+    {
+        if(middle_.load(std::memory_order_relaxed) & kFresh)
+        {
+            front_ = middle_.exchange(front_) & kIndex;
+        }
+        return buf_[front_];
+    }
+
+    /** Reader: the set held since the last Acquire() */
+    inline const T& Current() const { return buf_[front_]; }
+
+  private:
+    static constexpr uint32_t kIndex = 3;
+    static constexpr uint32_t kFresh = 4;
+
+    T                     buf_[3];
+    std::atomic<uint32_t> middle_;
+    uint32_t              back_;
+    uint32_t              front_;
+};
+
+} // namespace daisy
+#endif
@@ -1,35 +1,81 @@
 #include "parameter.h"
 #include <math.h>
+#include <string.h>
 
 using namespace daisy;
 
+// 2^(i / 256) over one octave, one guard entry.
+static constexpr size_t kExp2Size = 256;
+static float            exp2_table[kExp2Size + 1];
+static bool             exp2_ready = false;
+
+static void InitExp2Table()
+{
+    if(exp2_ready)
+        return;
+    for(size_t i = 0; i <= kExp2Size; i++)
+    {
+        exp2_table[i] = exp2f(static_cast<float>(i) / kExp2Size);
+    }
+    exp2_ready = true;
+}
+
+// 2^x from the table: the fraction interpolated, the integer part added
+// to the exponent bits.
+static inline float TableExp2(float x)
+{
+    x             = x < -126.f ? -126.f : (x > 126.f ? 126.f : x);
+    const float n = floorf(x);
+    const float t = (x - n) * kExp2Size;
+    const int   i = static_cast<int>(t);
+    const float a = exp2_table[i];
+    float       m = a + (exp2_table[i + 1] - a) * (t - static_cast<float>(i));
+    uint32_t    bits;
+    memcpy(&bits, &m, sizeof(bits));
+    bits += static_cast<uint32_t>(static_cast<int32_t>(n)) << 23;
+    memcpy(&m, &bits, sizeof(m));
+    return m;
+}
+
 void Parameter::Init(AnalogControl input, float min, float max, Curve curve)
 {
+    InitExp2Table();
     pmin_   = min;
     pmax_   = max;
     pcurve_ = curve;
     in_     = input;
-    lmin_   = logf(min < 0.0000001f ? 0.0000001f : min);
-    lmax_   = logf(max);
+    val_    = 0.f;
+    // exp(in * (ln max - ln min) + ln min) = min * 2^(in * log2(max / min))
+    const float lmin = min < 0.0000001f ? 0.0000001f : min;
+    lbase_           = lmin;
+    lspan_           = log2f(max) - log2f(lmin);
 }
 
-float Parameter::Process()
+float Parameter::Map(float in) const
 {
     switch(pcurve_)
     {
-        case LINEAR: val_ = (in_.Process() * (pmax_ - pmin_)) + pmin_; break;
-        case EXPONENTIAL:
-            val_ = in_.Process();
-            val_ = ((val_ * val_) * (pmax_ - pmin_)) + pmin_;
-            break;
-        case LOGARITHMIC:
-            val_ = expf((in_.Process() * (lmax_ - lmin_)) + lmin_);
-            break;
-        case CUBE:
-            val_ = in_.Process();
-            val_ = ((val_ * (val_ * val_)) * (pmax_ - pmin_)) + pmin_;
-            break;
-        default: break;
+        case LINEAR: return (in * (pmax_ - pmin_)) + pmin_;
+        case EXPONENTIAL: return ((in * in) * (pmax_ - pmin_)) + pmin_;
+        case LOGARITHMIC: return lbase_ * TableExp2(in * lspan_);
+        case CUBE: return ((in * (in * in)) * (pmax_ - pmin_)) + pmin_;
+        default: return val_;
     }
+}
+
+float Parameter::Process()
+{
+    val_ = Map(in_.Process());
     return val_;
+}
+
+void Parameter::ProcessAll(Parameter* params, size_t count, float* out)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        Parameter& p = params[i];
+        p.val_       = p.Map(p.in_.Process());
+        if(out != nullptr)
+            out[i] = p.val_;
+    }
 }
\ No newline at end of file
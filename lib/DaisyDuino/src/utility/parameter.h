@@ -1,10 +1,16 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 #include "ctrl.h"
 
 namespace daisy
 {
-/**      Simple parameter mapping tool that takes a 0-1 input from an hid_ctrl. */
+/**      Simple parameter mapping tool that takes a 0-1 input from an hid_ctrl.
+
+    LOGARITHMIC maps through a shared 256 entry table of 2^x instead of
+    expf() per call; the other curves are a multiply or two already.
+    The table is built by the first Init(); relative error under 2e-6.
+*/
 class Parameter
 {
   public:
@@ -36,6 +42,13 @@ class Parameter
     */
     float Process();
 
+    /** Processes count parameters in one pass, as Process() on each.
+    \param params - parameters to process
+    \param count - how many
+    \param out - receives the values if not nullptr
+    */
+    static void ProcessAll(Parameter* params, size_t count, float* out = nullptr);
+
     /** 
     \return the current value from the parameter without processing another sample.
     this is useful if you need to use the value multiple times, and don't store
@@ -44,9 +57,12 @@ class Parameter
     inline float Value() { return val_; }
 
   private:
+    /** Maps a 0-1 input through the curve */
+    float Map(float in) const;
+
     AnalogControl in_;
     float         pmin_, pmax_;
-    float         lmin_, lmax_; // for log range
+    float         lbase_, lspan_; // for log range: base * 2^(in * span)
     float         val_;
     Curve         pcurve_;
 };
@@ -0,0 +1,249 @@
+#include "preset_store.h"
+#include <string.h>
+
+using namespace daisy;
+
+namespace
+{
+constexpr uint32_t kMagic   = 0x50525354; // "PRST"
+constexpr uint32_t kErased  = 0xFFFFFFFF;
+constexpr uint16_t kNowhere = 0xFFFF; // a slot's latest record is lost
+
+// CRC-32 (IEEE), a nibble at a time: a 16-entry table instead of 256.
+constexpr uint32_t kCrcTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+    0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t CrcUpdate(uint32_t crc, const uint8_t* data, size_t size)
+{
+    for(size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ kCrcTable[crc & 15];
+        crc = (crc >> 4) ^ kCrcTable[crc & 15];
+    }
+    return crc;
+}
+} // namespace
+
+PresetStore::Result PresetStore::Init(QspiFlash& flash,
+                                      uint32_t   offset,
+                                      uint32_t   num_sectors,
+                                      void*      cache,
+                                      size_t     slot_bytes,
+                                      size_t     num_slots)
+{
+    flash_      = nullptr;
+    num_slots_  = 0;
+    errors_     = 0;
+    stride_     = sizeof(Header) + slot_bytes;
+    per_sector_ = QspiFlash::kSectorSize / stride_;
+    if(num_sectors < 2 || num_slots == 0 || num_slots > kMaxSlots
+       || (slot_bytes & 3) != 0 || slot_bytes > 0xFFFF
+       || per_sector_ <= num_slots
+       || (offset & (QspiFlash::kSectorSize - 1)) != 0
+       || offset + num_sectors * QspiFlash::kSectorSize > QspiFlash::kSize
+       || !QspiFlash::IsMemoryMapped())
+        return Result::ERR;
+
+    offset_      = offset;
+    num_sectors_ = num_sectors;
+    cache_       = static_cast<uint8_t*>(cache);
+    slot_bytes_  = slot_bytes;
+    num_slots_   = num_slots;
+    for(size_t i = 0; i < num_slots; i++)
+    {
+        seq_of_[i]    = 0;
+        sector_of_[i] = 0;
+        stored_[i]    = false;
+        dirty_[i]     = false;
+    }
+
+    // Newest intact record per slot; the newest of all marks the sector
+    // being appended. Each sector's records end at the first erased one.
+    bool any = false;
+    seq_     = 0;
+    cur_     = 0;
+    for(uint32_t s = 0; s < num_sectors; s++)
+    {
+        for(uint32_t r = 0; r < per_sector_; r++)
+        {
+            const uint8_t* rec = static_cast<const uint8_t*>(
+                QspiFlash::GetData(RecordOffset(s, r)));
+            Header h;
+            memcpy(&h, rec, sizeof(h));
+            if(h.magic == kErased)
+                break;
+            const uint8_t* payload = rec + sizeof(Header);
+            if(!Valid(h, payload))
+                continue;
+            if(!stored_[h.slot] || h.seq > seq_of_[h.slot])
+            {
+                memcpy(cache_ + h.slot * slot_bytes_, payload, slot_bytes_);
+                seq_of_[h.slot]    = h.seq;
+                sector_of_[h.slot] = s;
+                stored_[h.slot]    = true;
+            }
+            if(!any || h.seq > seq_)
+            {
+                seq_ = h.seq;
+                cur_ = s;
+                any  = true;
+            }
+        }
+    }
+
+    // An empty or foreign region starts afresh on the first write.
+    erase_cur_ = !any;
+    pos_       = 0;
+    if(any)
+    {
+        while(pos_ < per_sector_)
+        {
+            Header h;
+            memcpy(&h, QspiFlash::GetData(RecordOffset(cur_, pos_)), sizeof(h));
+            if(h.magic == kErased)
+                break;
+            pos_++;
+        }
+    }
+    flash_ = &flash;
+    return Result::OK;
+}
+
+void PresetStore::Save(size_t slot, const void* data)
+{
+    if(slot >= num_slots_)
+        return;
+    memcpy(cache_ + slot * slot_bytes_, data, slot_bytes_);
+    dirty_[slot] = true;
+}
+
+size_t PresetStore::Pending() const
+{
+    size_t n = 0;
+    for(size_t i = 0; i < num_slots_; i++)
+        n += dirty_[i];
+    return n;
+}
+
+size_t PresetStore::Service()
+{
+    if(flash_ == nullptr)
+        return 0;
+    size_t slot = num_slots_;
+    for(size_t i = 0; i < num_slots_ && slot == num_slots_; i++)
+    {
+        if(dirty_[i])
+            slot = i;
+    }
+    if(slot == num_slots_)
+        return 0;
+
+    if(erase_cur_)
+    {
+        if(flash_->EraseSector(offset_ + cur_ * QspiFlash::kSectorSize)
+           != QspiFlash::Result::OK)
+            errors_++;
+        erase_cur_ = false;
+        pos_       = 0;
+        return Pending();
+    }
+
+    // Room is kept in this sector for every slot whose latest record is
+    // in the next one, to move them before it is erased.
+    const uint32_t next = (cur_ + 1) % num_sectors_;
+    const size_t   live = LiveIn(next);
+    const size_t   room = per_sector_ - pos_;
+    if(room > live || (room == live && live > 0 && sector_of_[slot] == next))
+    {
+        Append(slot);
+    }
+    else if(live > 0 && room > 0)
+    {
+        size_t move = 0;
+        while(!(stored_[move] && sector_of_[move] == next))
+            move++;
+        Append(move);
+    }
+    else
+    {
+        // Only failed writes leave a slot here now; the cache still has
+        // it, so it is written again after the erase.
+        for(size_t i = 0; i < num_slots_; i++)
+        {
+            if(stored_[i] && sector_of_[i] == next)
+            {
+                sector_of_[i] = kNowhere;
+                dirty_[i]     = true;
+            }
+        }
+        if(flash_->EraseSector(offset_ + next * QspiFlash::kSectorSize)
+           != QspiFlash::Result::OK)
+            errors_++;
+        cur_ = next;
+        pos_ = 0;
+    }
+    return Pending();
+}
+
+uint32_t PresetStore::RecordOffset(uint32_t sector, uint32_t index) const
+{
+    return offset_ + sector * QspiFlash::kSectorSize + index * stride_;
+}
+
+bool PresetStore::Valid(const Header& h, const uint8_t* payload) const
+{
+    return h.magic == kMagic && h.slot < num_slots_ && h.size == slot_bytes_
+           && h.crc == Crc(h, payload);
+}
+
+uint32_t PresetStore::Crc(const Header& h, const uint8_t* payload) const
+{
+    uint32_t crc = ~0u;
+    crc = CrcUpdate(crc, reinterpret_cast<const uint8_t*>(&h.seq), 8);
+    crc = CrcUpdate(crc, payload, slot_bytes_);
+    return ~crc;
+}
+
+size_t PresetStore::LiveIn(uint32_t sector) const
+{
+    size_t n = 0;
+    for(size_t i = 0; i < num_slots_; i++)
+        n += stored_[i] && sector_of_[i] == sector;
+    return n;
+}
+
+void PresetStore::Append(size_t slot)
+{
+    const uint8_t* payload = cache_ + slot * slot_bytes_;
+    Header         h;
+    h.magic = kMagic;
+    h.seq   = seq_ + 1;
+    h.slot  = static_cast<uint16_t>(slot);
+    h.size  = static_cast<uint16_t>(slot_bytes_);
+    h.crc   = Crc(h, payload);
+
+    // The position is used up whatever happens: a record that did not
+    // program cleanly is skipped on the next Init() by its CRC.
+    const uint32_t at = RecordOffset(cur_, pos_++);
+    const bool     ok
+        = flash_->Write(at, &h, sizeof(h)) == QspiFlash::Result::OK
+          && flash_->Write(at + sizeof(h), payload, slot_bytes_)
+                 == QspiFlash::Result::OK
+          && memcmp(QspiFlash::GetData(at), &h, sizeof(h)) == 0
+          && memcmp(QspiFlash::GetData(at + sizeof(h)), payload, slot_bytes_)
+                 == 0;
+    if(!ok)
+    {
+        errors_++;
+        return;
+    }
+    seq_             = h.seq;
+    seq_of_[slot]    = h.seq;
+    sector_of_[slot] = static_cast<uint16_t>(cur_);
+    stored_[slot]    = true;
+    dirty_[slot]     = false;
+}
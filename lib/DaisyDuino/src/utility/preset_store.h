@@ -0,0 +1,137 @@
+#pragma once
+#ifndef DSY_PRESET_STORE_H
+#define DSY_PRESET_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "qspi_flash.h"
+
+namespace daisy
+{
+/** Presets kept in a few sectors of the QSPI flash, read from RAM.
+
+    Every slot has a copy in a RAM cache the caller provides, so Get()
+    is a plain read. Save() only updates the cache and marks the slot;
+    Service(), from loop() or a TaskRunner task, writes one marked slot
+    per call as a record appended to a log, never in place. The log
+    runs through the sectors in turn, so each is erased once per lap
+    rather than once per save. Write() and EraseSector() stall loop()
+    (an erase takes tens of milliseconds) but not the audio, as long as
+    the audio callback does not read the QSPI mapping meanwhile.
+
+    Each record carries a sequence number and a CRC; Init() reads the
+    region's headers once (a fixed bound: num_sectors sectors of
+    records) and keeps the newest intact record of each slot, so a
+    save cut short by power loss leaves the slot's previous version.
+    Before the sector after the current one is erased, the records that
+    are still the latest of their slot are copied forward, in room kept
+    for them, so an erase never loses a slot either.
+
+    Call Init() from setup() before the audio starts; afterwards no
+    call reads the flash but the check of a record just written.
+    Get() and Save() belong to the same context as Service(): hand
+    values to the audio callback through a ParamBlock.
+
+    usage:
+
+    static Settings    cache[8]; // filled with defaults
+    static PresetStore presets;
+    ...
+    flash.Init();
+    presets.Init(flash, 0x700000, 16, cache, sizeof(Settings), 8);
+    ...
+    presets.Save(2, &settings); // from the UI
+    presets.Service();          // from loop(), every pass or so
+*/
+class PresetStore
+{
+  public:
+    enum class Result
+    {
+        OK,
+        ERR,
+    };
+
+    static constexpr size_t kMaxSlots = 32;
+
+    PresetStore() {}
+    ~PresetStore() {}
+
+    /** Loads the newest stored version of each slot into cache.
+        \param flash memory-mapped, from QspiFlash::Init()
+        \param offset into the flash of the first sector, sector aligned
+        \param num_sectors 2 or more, kept for the store alone
+        \param cache num_slots * slot_bytes; slots never saved keep what
+               it held, so fill it with the defaults first
+        \param slot_bytes size of a preset, a multiple of 4
+        \param num_slots up to kMaxSlots; a sector must fit more records
+               than that
+        \return ERR if the layout does not fit, leaving the store unused
+    */
+    Result Init(QspiFlash& flash,
+                uint32_t   offset,
+                uint32_t   num_sectors,
+                void*      cache,
+                size_t     slot_bytes,
+                size_t     num_slots);
+
+    /** \return the cached preset in slot */
+    inline const void* Get(size_t slot) const
+    {
+        return cache_ + slot * slot_bytes_;
+    }
+
+    /** \return whether slot was found in the flash or has been saved */
+    inline bool IsStored(size_t slot) const { return stored_[slot]; }
+
+    /** Copies slot_bytes from data into the cache and marks the slot
+        for Service() to write. Saving again before then writes once.
+    */
+    void Save(size_t slot, const void* data);
+
+    /** Writes one marked slot, or takes one step of moving on to the
+        next sector: a copy forward or the erase.
+        \return slots still to write
+    */
+    size_t Service();
+
+    /** \return slots saved but not yet written */
+    size_t Pending() const;
+
+    /** \return records that failed to write or read back, since Init() */
+    inline uint32_t GetErrors() const { return errors_; }
+
+  private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t seq;
+        uint16_t slot;
+        uint16_t size;
+        uint32_t crc;
+    };
+
+    uint32_t RecordOffset(uint32_t sector, uint32_t index) const;
+    bool     Valid(const Header& h, const uint8_t* payload) const;
+    uint32_t Crc(const Header& h, const uint8_t* payload) const;
+    size_t   LiveIn(uint32_t sector) const;
+    void     Append(size_t slot);
+
+    QspiFlash* flash_;
+    uint32_t   offset_, num_sectors_;
+    uint8_t*   cache_;
+    size_t     slot_bytes_, num_slots_;
+    uint32_t   stride_, per_sector_; /**< record size, records a sector */
+    uint32_t   seq_;                 /**< of the newest record */
+    uint32_t   cur_, pos_;           /**< sector being appended, next record */
+    bool       erase_cur_;           /**< before its first record */
+    uint32_t   errors_;
+
+    uint32_t seq_of_[kMaxSlots];
+    uint16_t sector_of_[kMaxSlots];
+    bool     stored_[kMaxSlots];
+    bool     dirty_[kMaxSlots];
+};
+
+} // namespace daisy
+#endif
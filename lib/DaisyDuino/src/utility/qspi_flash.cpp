@@ -0,0 +1,231 @@
+#include "qspi_flash.h"
+#include "sys_mpu.h"
+
+using namespace daisy;
+
+// IS25LP064A instructions
+static const uint8_t kResetEnable   = 0x66;
+static const uint8_t kReset         = 0x99;
+static const uint8_t kWriteEnable   = 0x06;
+static const uint8_t kReadStatus    = 0x05;
+static const uint8_t kWriteStatus   = 0x01;
+static const uint8_t kSectorErase   = 0x20;
+static const uint8_t kPageProgram   = 0x02;
+static const uint8_t kQuadOutRead   = 0x6B;
+static const uint8_t kStatusWip     = 0x01;
+static const uint8_t kStatusQe      = 0x40;
+static const uint32_t kQuadOutDummy = 8;
+
+static const uint32_t kMaxClock = 80000000;
+
+// Line counts for the IMODE / ADMODE / DMODE fields
+static const uint32_t kOneLine   = 1;
+static const uint32_t kFourLines = 3;
+
+static const uint32_t kFmodeWrite  = 0;
+static const uint32_t kFmodeRead   = 1;
+static const uint32_t kFmodeMapped = 3;
+
+static inline uint32_t Ccr(uint8_t  instruction,
+                           uint32_t fmode,
+                           bool     address,
+                           uint32_t data_lines,
+                           uint32_t dummy)
+{
+    return instruction | (kOneLine << QUADSPI_CCR_IMODE_Pos)
+           | (address ? (kOneLine << QUADSPI_CCR_ADMODE_Pos)
+                            | (2U << QUADSPI_CCR_ADSIZE_Pos) // 24 bits
+                      : 0)
+           | (dummy << QUADSPI_CCR_DCYC_Pos)
+           | (data_lines << QUADSPI_CCR_DMODE_Pos)
+           | (fmode << QUADSPI_CCR_FMODE_Pos);
+}
+
+static bool WaitFlag(uint32_t flag, uint32_t timeout_ms)
+{
+    const uint32_t start = HAL_GetTick();
+    while((QUADSPI->SR & flag) == 0)
+    {
+        if(HAL_GetTick() - start > timeout_ms)
+            return false;
+    }
+    return true;
+}
+
+static bool WaitDone()
+{
+    if(!WaitFlag(QUADSPI_SR_TCF, 10))
+        return false;
+    QUADSPI->FCR = QUADSPI_FCR_CTCF;
+    return true;
+}
+
+static void InitPins()
+{
+    __HAL_RCC_GPIOF_CLK_ENABLE();
+    __HAL_RCC_GPIOG_CLK_ENABLE();
+
+    GPIO_InitTypeDef g = {0};
+    g.Mode             = GPIO_MODE_AF_PP;
+    g.Pull             = GPIO_NOPULL;
+    g.Speed            = GPIO_SPEED_FREQ_VERY_HIGH;
+
+    // IO2, IO3, CLK on AF9; IO0, IO1, NCS on AF10
+    g.Pin       = GPIO_PIN_6 | GPIO_PIN_7 | GPIO_PIN_10;
+    g.Alternate = GPIO_AF9_QUADSPI;
+    HAL_GPIO_Init(GPIOF, &g);
+    g.Pin       = GPIO_PIN_8 | GPIO_PIN_9;
+    g.Alternate = GPIO_AF10_QUADSPI;
+    HAL_GPIO_Init(GPIOF, &g);
+    g.Pin = GPIO_PIN_6;
+    HAL_GPIO_Init(GPIOG, &g);
+}
+
+bool QspiFlash::IsMemoryMapped()
+{
+    return (RCC->AHB3ENR & RCC_AHB3ENR_QSPIEN) != 0
+           && (QUADSPI->CR & QUADSPI_CR_EN) != 0
+           && ((QUADSPI->CCR & QUADSPI_CCR_FMODE) >> QUADSPI_CCR_FMODE_Pos)
+                  == kFmodeMapped;
+}
+
+QspiFlash::Result QspiFlash::Init()
+{
+    if(IsMemoryMapped())
+        return Result::OK;
+
+    InitPins();
+    __HAL_RCC_QSPI_CLK_ENABLE();
+    __HAL_RCC_QSPI_FORCE_RESET();
+    __HAL_RCC_QSPI_RELEASE_RESET();
+
+    // The kernel clock is HCLK3 (System's clock profiles select it).
+    const uint32_t ker       = HAL_RCC_GetHCLKFreq();
+    const uint32_t prescaler = (ker + kMaxClock - 1) / kMaxClock - 1;
+    QUADSPI->CR  = (prescaler << QUADSPI_CR_PRESCALER_Pos) | QUADSPI_CR_SSHIFT;
+    QUADSPI->DCR = (22U << QUADSPI_DCR_FSIZE_Pos) // 2^23 bytes
+                   | (1U << QUADSPI_DCR_CSHT_Pos);
+    QUADSPI->CR |= QUADSPI_CR_EN;
+
+    // Out of any mode a previous boot left the flash in.
+    if(Command(kResetEnable) != Result::OK || Command(kReset) != Result::OK)
+        return Result::ERR;
+    HAL_Delay(1);
+
+    uint8_t status;
+    if(ReadStatus(&status) != Result::OK)
+        return Result::ERR;
+    if((status & kStatusQe) == 0)
+    {
+        if(WriteEnable() != Result::OK)
+            return Result::ERR;
+        QUADSPI->DLR = 0;
+        QUADSPI->CCR = Ccr(kWriteStatus, kFmodeWrite, false, kOneLine, 0);
+        *(volatile uint8_t*)&QUADSPI->DR = status | kStatusQe;
+        if(!WaitDone() || WaitIdle(100) != Result::OK)
+            return Result::ERR;
+    }
+    return MemoryMap();
+}
+
+QspiFlash::Result QspiFlash::EraseSector(uint32_t offset)
+{
+    if(offset >= kSize || Unmap() != Result::OK || WriteEnable() != Result::OK)
+        return Result::ERR;
+    QUADSPI->CCR = Ccr(kSectorErase, kFmodeWrite, true, 0, 0);
+    QUADSPI->AR  = offset & ~(kSectorSize - 1);
+    if(!WaitDone() || WaitIdle(500) != Result::OK)
+        return Result::ERR;
+    dsy_dcache_invalidate(GetData(offset & ~(kSectorSize - 1)), kSectorSize);
+    return MemoryMap();
+}
+
+QspiFlash::Result QspiFlash::Write(uint32_t offset, const void* data, size_t size)
+{
+    if(offset + size > kSize || Unmap() != Result::OK)
+        return Result::ERR;
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    uint32_t       at  = offset;
+    size_t         left = size;
+    while(left > 0)
+    {
+        // A page program wraps within its page, so each stops at the end.
+        const uint32_t room = kPageSize - (at & (kPageSize - 1));
+        const uint32_t n    = left < room ? left : room;
+        if(WriteEnable() != Result::OK)
+            return Result::ERR;
+        QUADSPI->DLR = n - 1;
+        QUADSPI->CCR = Ccr(kPageProgram, kFmodeWrite, true, kOneLine, 0);
+        QUADSPI->AR  = at;
+        for(uint32_t i = 0; i < n; i++)
+        {
+            if(!WaitFlag(QUADSPI_SR_FTF, 10))
+                return Result::ERR;
+            *(volatile uint8_t*)&QUADSPI->DR = src[i];
+        }
+        if(!WaitDone() || WaitIdle(10) != Result::OK)
+            return Result::ERR;
+        src += n;
+        at += n;
+        left -= n;
+    }
+    dsy_dcache_invalidate(GetData(offset), size);
+    return MemoryMap();
+}
+
+QspiFlash::Result QspiFlash::Command(uint8_t instruction)
+{
+    QUADSPI->CCR = Ccr(instruction, kFmodeWrite, false, 0, 0);
+    return WaitDone() ? Result::OK : Result::ERR;
+}
+
+QspiFlash::Result QspiFlash::ReadStatus(uint8_t* status)
+{
+    QUADSPI->DLR = 0;
+    QUADSPI->CCR = Ccr(kReadStatus, kFmodeRead, false, kOneLine, 0);
+    if(!WaitDone())
+        return Result::ERR;
+    *status = *(volatile uint8_t*)&QUADSPI->DR;
+    return Result::OK;
+}
+
+QspiFlash::Result QspiFlash::WriteEnable()
+{
+    return Command(kWriteEnable);
+}
+
+QspiFlash::Result QspiFlash::WaitIdle(uint32_t timeout_ms)
+{
+    const uint32_t start = HAL_GetTick();
+    uint8_t        status;
+    do
+    {
+        if(ReadStatus(&status) != Result::OK)
+            return Result::ERR;
+        if(HAL_GetTick() - start > timeout_ms)
+            return Result::ERR;
+    } while(status & kStatusWip);
+    return Result::OK;
+}
+
+QspiFlash::Result QspiFlash::MemoryMap()
+{
+    QUADSPI->CCR = Ccr(kQuadOutRead, kFmodeMapped, true, kFourLines, kQuadOutDummy);
+    return Result::OK;
+}
+
+QspiFlash::Result QspiFlash::Unmap()
+{
+    if(!IsMemoryMapped())
+        return (QUADSPI->CR & QUADSPI_CR_EN) ? Result::OK : Result::ERR;
+    QUADSPI->CR |= QUADSPI_CR_ABORT;
+    const uint32_t start = HAL_GetTick();
+    while(QUADSPI->CR & QUADSPI_CR_ABORT)
+    {
+        if(HAL_GetTick() - start > 10)
+            return Result::ERR;
+    }
+    // With FMODE still mapped, the next read of kBase would restart it.
+    QUADSPI->CCR = 0;
+    return Result::OK;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef DSY_QSPI_FLASH_H
+#define DSY_QSPI_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** The Seed's 8 MB IS25LP064A QSPI flash, memory-mapped at 0x90000000.
+
+    Init() puts the QUADSPI into memory-mapped mode, with quad-output
+    reads (0x6B) at up to 80 MHz, so flash contents read like a const
+    array: execute-in-place data such as samples and wavetables, with
+    nothing to load into SDRAM at boot. If the Daisy bootloader (or
+    anything else) already mapped it, Init() leaves it as it is.
+
+    The default memory map makes 0x90000000 write-through cacheable, so
+    with the D-cache on, reads go through it; with it off every access
+    is a flash transaction, and copying in blocks (as SamplePlayer does)
+    is what pays.
+
+    Getting data in: flash a raw binary at 0x90000000 with the Daisy
+    bootloader's DFU, or program it at runtime with EraseSector() and
+    Write(), which leave memory-mapped mode for the duration. Nothing
+    may read the mapping meanwhile, the audio callback included, so not
+    from a program that itself runs from the QSPI.
+
+    Registers are programmed directly, as in SaiMdma: the HAL QSPI
+    module is not in every core's build.
+*/
+class QspiFlash
+{
+  public:
+    enum class Result
+    {
+        OK,
+        ERR,
+    };
+
+    static constexpr uint32_t kBase       = 0x90000000;
+    static constexpr uint32_t kSize       = 8 * 1024 * 1024;
+    static constexpr uint32_t kSectorSize = 4096;
+    static constexpr uint32_t kPageSize   = 256;
+
+    QspiFlash() {}
+    ~QspiFlash() {}
+
+    /** Sets up the pins and the QUADSPI, sets the flash's quad enable
+        bit if needed (once per device, non-volatile), and maps it. */
+    Result Init();
+
+    /** \return the mapped address of offset into the flash */
+    static inline const void* GetData(uint32_t offset)
+    {
+        return reinterpret_cast<const void*>(kBase + offset);
+    }
+
+    /** \return true while reads at kBase go to the flash */
+    static bool IsMemoryMapped();
+
+    /** Erases the 4 kB sector holding offset, to all ones. */
+    Result EraseSector(uint32_t offset);
+
+    /** Programs size bytes at offset, which must have been erased.
+        Crosses pages as needed. */
+    Result Write(uint32_t offset, const void* data, size_t size);
+
+  private:
+    Result Command(uint8_t instruction);
+    Result ReadStatus(uint8_t* status);
+    Result WriteEnable();
+    Result WaitIdle(uint32_t timeout_ms);
+    Result MemoryMap();
+    Result Unmap();
+};
+
+} // namespace daisy
+#endif
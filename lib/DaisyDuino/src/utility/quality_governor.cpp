@@ -0,0 +1,141 @@
+#include "quality_governor.h"
+#include <stdio.h>
+
+using namespace daisy;
+
+static uint32_t Blocks(float seconds, float block_rate)
+{
+    const float blocks = seconds * block_rate;
+    return blocks > 1.0f ? (uint32_t)blocks : 1;
+}
+
+void QualityGovernor::Init(float block_rate)
+{
+    block_rate_    = block_rate;
+    settle_blocks_ = Blocks(config_.settle_s, block_rate);
+    hold_blocks_   = Blocks(config_.hold_s, block_rate);
+    // A new block size changes every load: start the windows over and
+    // learn the savings again.
+    blocks_      = 0;
+    calm_blocks_ = 0;
+    peak_        = 0.0f;
+    measure_     = false;
+    for(size_t i = 0; i < depth_; i++)
+        steps_[i].saving = 0.0f;
+}
+
+void QualityGovernor::SetConfig(const Config& config)
+{
+    config_ = config;
+    Init(block_rate_);
+}
+
+QualityStage* QualityGovernor::Add(const char* name, uint8_t tiers)
+{
+    if(num_stages_ >= kMaxStages || tiers < 2
+       || max_depth_ + tiers - 1 > kMaxSteps)
+        return nullptr;
+    QualityStage& s = stages_[num_stages_];
+    s.name_         = name;
+    s.tiers_        = tiers;
+    s.tier_         = tiers - 1;
+    s.steps_down_   = 0;
+    max_depth_ += tiers - 1;
+    // Last: the audio interrupt may already be feeding OnBlockEnd().
+    num_stages_++;
+    return &s;
+}
+
+void QualityGovernor::Decide()
+{
+    const float peak = peak_;
+    blocks_          = 0;
+    peak_            = 0.0f;
+
+    // The first window after a step down is what that step bought.
+    if(measure_)
+    {
+        Step& last  = steps_[depth_ - 1];
+        last.saving = last.before > peak ? last.before - peak : 0.0f;
+        measure_    = false;
+    }
+
+    if(peak > config_.down_load)
+    {
+        calm_blocks_ = 0;
+        StepDown(peak);
+        return;
+    }
+    if(peak >= config_.up_load || depth_ == 0)
+    {
+        calm_blocks_ = 0;
+        return;
+    }
+    calm_blocks_ += settle_blocks_;
+    if(calm_blocks_ < hold_blocks_)
+        return;
+    calm_blocks_ = 0;
+
+    Step& last = steps_[depth_ - 1];
+    if(peak + last.saving >= config_.down_load)
+    {
+        last.saving *= 0.5f;
+        return;
+    }
+    QualityStage& s = stages_[last.stage];
+    s.tier_         = s.tier_ + 1;
+    depth_          = depth_ - 1;
+}
+
+void QualityGovernor::StepDown(float peak)
+{
+    for(size_t i = 0; i < num_stages_; i++)
+    {
+        QualityStage& s = stages_[i];
+        if(s.tier_ == 0)
+            continue;
+        s.tier_ = s.tier_ - 1;
+        s.steps_down_++;
+        Step& step  = steps_[depth_];
+        step.stage  = (uint8_t)i;
+        step.before = peak;
+        step.saving = 0.0f;
+        depth_      = depth_ + 1;
+        measure_    = true;
+        return;
+    }
+    // Every stage at tier 0 already: nothing left to give.
+}
+
+void QualityGovernor::Restore()
+{
+    for(size_t i = 0; i < num_stages_; i++)
+        stages_[i].tier_ = stages_[i].tiers_ - 1;
+    depth_       = 0;
+    blocks_      = 0;
+    calm_blocks_ = 0;
+    peak_        = 0.0f;
+    measure_     = false;
+}
+
+void QualityGovernor::Print(::Print& out) const
+{
+    char line[96];
+    snprintf(line,
+             sizeof(line),
+             "quality: %lu step(s) down\r\n",
+             (unsigned long)depth_);
+    out.print(line);
+    for(size_t i = 0; i < num_stages_; i++)
+    {
+        const QualityStage& s = stages_[i];
+        snprintf(line,
+                 sizeof(line),
+                 "  %-16s tier %u of %u, %lu step(s) down so far\r\n",
+                 s.name_ ? s.name_ : "?",
+                 (unsigned)s.tier_,
+                 (unsigned)(s.tiers_ - 1),
+                 (unsigned long)s.steps_down_);
+        out.print(line);
+    }
+}
@@ -0,0 +1,182 @@
+#pragma once
+#ifndef DSY_QUALITY_GOVERNOR_H
+#define DSY_QUALITY_GOVERNOR_H
+
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace daisy
+{
+class QualityGovernor;
+
+/** One processing stage the QualityGovernor may run cheaper: its
+    current tier and how often it was stepped down.
+
+    Tier 0 is the cheapest, GetNumTiers() - 1 full quality, where every
+    stage starts. The stage reads GetTier() at the start of each block
+    in the audio callback and runs that variant: a FIR or an IIR
+    Hilbert, cubic or linear interpolation, so many voices, with or
+    without oversampling. A change always lands between two blocks.
+*/
+class QualityStage
+{
+  public:
+    /** 0 cheapest to GetNumTiers() - 1 full quality */
+    inline uint8_t GetTier() const { return tier_; }
+
+    inline uint8_t GetNumTiers() const { return tiers_; }
+
+    inline const char* GetName() const { return name_; }
+
+    /** Times the governor took this stage down a tier since Add() */
+    inline uint32_t GetStepsDown() const { return steps_down_; }
+
+  private:
+    friend class QualityGovernor;
+
+    const char*      name_;
+    uint8_t          tiers_;
+    volatile uint8_t tier_;
+    uint32_t         steps_down_;
+};
+
+/** Keeps the audio callback inside its block period by trading quality
+    for cycles.
+
+    Without it, enabling one more expensive stage than the budget allows
+    (SSB with the FIR Hilbert, the compressor and a meter, say) just
+    glitches. Stages that have cheaper variants register with Add() and
+    poll their QualityStage each block. AudioHandle feeds the governor
+    the load of every callback, right after its CpuLoadMeter, and it
+    steps tiers from there:
+
+    - Down: when any block in a settle window (Config::settle_s) takes
+      more than Config::down_load of the period, the first stage Add()
+      registered that is not at tier 0 goes down one. Add the stage
+      whose loss is least audible first. The next window then shows
+      what the step saved, and a further step follows if it was not
+      enough.
+    - Up: once every block has stayed under Config::up_load for
+      Config::hold_s, the last step is undone, but only if the load
+      plus what that step saved stays under down_load. Otherwise it
+      waits, and the saving it remembers halves with every hold
+      period, so a saving overestimated from a one-off spike (a flash
+      erase behind the callback) does not keep the stage down for
+      good.
+
+    The gap between the two thresholds and the hold time are the
+    hysteresis: a load that sits near one tier's cost does not make it
+    flap. With no stage added the governor does nothing.
+
+    Everything runs in the audio interrupt except Add() and SetConfig(),
+    from setup() before the audio starts, and the getters, from loop().
+
+    usage:
+
+    static QualityStage* hilbert_tier;
+    ...
+    // setup()
+    hilbert_tier = DAISY.Governor().Add("hilbert", 2);
+    ...
+    // audio callback
+    if(hilbert_tier->GetTier() == 1)
+        fir.ProcessBlock(...);
+    else
+        iir.ProcessBlock(...);
+*/
+class QualityGovernor
+{
+  public:
+    static constexpr size_t kMaxStages = 8;
+    static constexpr size_t kMaxSteps  = 32;
+
+    struct Config
+    {
+        float down_load = 0.85f; // a block over this steps down
+        float up_load   = 0.6f;  // every block under this may step up
+        float settle_s  = 0.05f; // window between decisions
+        float hold_s    = 2.0f;  // under up_load this long before a step up
+    };
+
+    QualityGovernor() {}
+    ~QualityGovernor() {}
+
+    /** Sets the block rate the windows are counted in. AudioHandle
+        calls it on every start and block size change; the stages keep
+        their tiers. */
+    void Init(float block_rate);
+
+    void SetConfig(const Config& config);
+
+    /** Registers a stage at full quality.
+        \param name for Print(); kept, not copied
+        \param tiers variants, 2 or more
+        \return the stage, nullptr past kMaxStages or kMaxSteps tiers
+            in all
+    */
+    QualityStage* Add(const char* name, uint8_t tiers);
+
+    /** Call last thing after the audio callback, with its load.
+        \param load the block's busy time over its period,
+            CpuLoadMeter::GetLastCpuLoad() */
+    inline void OnBlockEnd(float load)
+    {
+        if(num_stages_ == 0)
+            return;
+        if(reset_)
+        {
+            Restore();
+            reset_ = false;
+        }
+        peak_ = load > peak_ ? load : peak_;
+        if(++blocks_ >= settle_blocks_)
+            Decide();
+    }
+
+    /** Every stage back to full quality at the next block */
+    void Reset() { reset_ = true; }
+
+    /** Steps down not yet undone */
+    inline size_t GetDepth() const { return depth_; }
+
+    inline size_t GetNumStages() const { return num_stages_; }
+
+    inline const QualityStage& GetStage(size_t idx) const
+    {
+        return stages_[idx];
+    }
+
+    /** From loop(): writes a row per stage */
+    void Print(::Print& out) const;
+
+  private:
+    struct Step
+    {
+        uint8_t stage;
+        float   before; // peak load of the window that took it
+        float   saving; // what it saved, 0 until measured
+    };
+
+    void Decide();
+    void StepDown(float peak);
+    void Restore();
+
+    Config          config_;
+    float           block_rate_    = 0.0f;
+    uint32_t        settle_blocks_ = 1;
+    uint32_t        hold_blocks_   = 1;
+    uint32_t        blocks_        = 0;
+    uint32_t        calm_blocks_   = 0;
+    float           peak_          = 0.0f;
+    bool            measure_       = false;
+    volatile bool   reset_         = false;
+    QualityStage    stages_[kMaxStages];
+    size_t          num_stages_ = 0;
+    size_t          max_depth_  = 0; // tiers below full, over every stage
+    Step            steps_[kMaxSteps];
+    volatile size_t depth_ = 0;
+};
+
+} // namespace daisy
+#endif
@@ -1,5 +1,7 @@
 #include "sai.h"
 #include "daisy_core.h"
+#include "irq_priority.h"
+#include "seqlock.h"
 extern "C"
 {
 #include "hal_map.h"
@@ -22,13 +24,21 @@ class SaiHandle::Impl
     SaiHandle::Result StartDmaTransfer(int32_t*                       buffer_rx,
                                        int32_t*                       buffer_tx,
                                        size_t                         size,
-                                       SaiHandle::CallbackFunctionPtr callback);
+                                       SaiHandle::CallbackFunctionPtr callback,
+                                       size_t                         segments);
     SaiHandle::Result StopDmaTransfer();
+    SaiHandle::Result RestartDmaTransfer(size_t size);
 
     // Utility functions
     float  GetSampleRate();
     size_t GetBlockSize();
     float  GetBlockRate();
+    size_t GetSlots() const;
+    size_t GetWordsPerFrame() const;
+    // Stream data items per buffer word: the SAI side moves half-words
+    // in packed mode.
+    inline size_t ItemsPerWord() const { return config_.packed16 ? 2 : 1; }
+    uint32_t GetFrameCount() const;
 
     SaiHandle::Config config_;
     SAI_HandleTypeDef sai_a_handle_, sai_b_handle_;
@@ -39,18 +49,79 @@ class SaiHandle::Impl
     size_t                         buff_size_;
     SaiHandle::CallbackFunctionPtr callback_;
 
+    // Free-running counts of receive blocks filled by the DMA and, in
+    // ring mode (segments_ > 2), handed to the callback. ring_filled_
+    // moves together with the clearing of the stream flag that marks
+    // the block, so GetFrameCount() sees one or the other.
+    size_t          segments_;
+    volatile size_t ring_filled_;
+    size_t          ring_served_;
+    size_t          ring_dropped_;
+
+    // Frame count at block 0 of the current start, carried across
+    // restarts, and at the first frame of the block being handled.
+    uint32_t frame_base_;
+    uint32_t block_frame_;
+
+    // block_frame_ widened to 64 bits, with the DWT time of the stream
+    // interrupt that ended the block's input, for readers anywhere. In
+    // ring mode each block's time waits in ring_cycles_ until
+    // ServiceRing() reaches it, at most segments - 1 blocks later; a
+    // ring of more than kRingStamps segments may time a late block from
+    // a newer one.
+    static constexpr size_t       kRingStamps = 16;
+    uint64_t                      block_frame64_;
+    uint32_t                      ring_cycles_[kRingStamps];
+    Seqlock<SaiHandle::BlockTime> block_time_;
+
+    /** Moves block_frame_ on to frame and publishes its BlockTime */
+    inline void SetBlock(uint32_t frame, uint32_t cycles)
+    {
+        block_frame64_ += (uint32_t)(frame - block_frame_);
+        block_frame_ = frame;
+        block_time_.Write({block_frame64_, cycles});
+    }
+    uint64_t GetFrameAt(uint32_t cycles);
+
+    /** The receive block's stream, nullptr if neither block receives. */
+    const DMA_HandleTypeDef* RxDma() const;
+
     /** Offset stored for weird inter-SAI stuff.*/
     size_t dma_offset;
 
     /** Callback that dispatches user callback from Cplt and HalfCplt DMA Callbacks */
     void InternalCallback(size_t offset);
 
+    /** Stream IRQ entry: half/full transfer on the receive stream goes
+     ** straight to InternalCallback, anything else through HAL. */
+    void ServiceDmaIrq(DMA_HandleTypeDef* hdma);
+
+    /** The transmit stream's half/full interrupts carry no work. */
+    void MuteTxDmaIrqs();
+
+    /** Ring mode, receive stream transfer complete: points the idle
+     ** memory address at the block after next and pends ServiceRing(). */
+    void AdvanceRing(DMA_HandleTypeDef* hdma);
+
+    /** Ring mode, from the ring interrupt: runs the callback on every
+     ** filled block in order. */
+    void ServiceRing();
+
+    /** Starts one block's DMA on the whole buffer, rx in ring mode as a
+     ** double-buffered stream. */
+    void StartBlock(SAI_HandleTypeDef* hsai, Config::Direction dir);
+
     /** Pin Initiazlization */
     void InitPins();
     void DeinitPins();
 
     /** DMA Initialization */
     void InitDma(PeripheralBlock block);
+    void RestartDma(SAI_HandleTypeDef* hsai, DMA_HandleTypeDef* hdma);
+
+    /** Switches a stopped stream between the configured FIFO / burst
+     ** and direct mode to suit the current block size. */
+    void ApplyDmaFifo(DMA_HandleTypeDef* hdma);
     void DeinitDma(PeripheralBlock block);
 };
 
@@ -70,6 +141,16 @@ static void Error_Handler()
 
 static SaiHandle::Impl sai_handles[2];
 
+// Ring mode callbacks run from this otherwise unused vector, pended from
+// the DMA interrupt: below the DMA streams, so a long callback never
+// holds up the ring bookkeeping, and above PendSV (AudioHandle's
+// control callback), see irq_priority.h.
+static const IRQn_Type kRingIrq         = SAI4_IRQn;
+static const uint32_t  kRingIrqPriority = IRQ_PRIORITY_AUDIO_RING;
+
+// Smallest block, in words, that runs the stream FIFO (Config::dma_fifo).
+static const size_t kDmaFifoMinWords = 16;
+
 // ================================================================
 // SAI Functions
 // ================================================================
@@ -80,11 +161,27 @@ SaiHandle::Result SaiHandle::Impl::Init(const SaiHandle::Config& config)
     const int sai_idx = int(config.periph);
     if(sai_idx >= 2)
         return Result::ERR;
+    // HAL_DMA_Init would reject these and trap in Error_Handler().
+    if(config.dma_burst == Config::DmaBurst::INC4
+       && config.dma_fifo != Config::DmaFifo::FULL)
+        return Result::ERR;
+    if(config.packed16 && config.bit_depth != Config::BitDepth::SAI_16BIT)
+        return Result::ERR;
+
+    // Switching the clock source changes which pins are driven: take the
+    // blocks down so MspInit sets the pins up again under the new config.
+    if(sai_a_handle_.State != HAL_SAI_STATE_RESET
+       && config.clock != config_.clock)
+    {
+        HAL_SAI_DeInit(&sai_a_handle_);
+        HAL_SAI_DeInit(&sai_b_handle_);
+    }
 
     // Default Buffer states
     buff_rx_   = nullptr;
     buff_tx_   = nullptr;
     buff_size_ = 0;
+    segments_  = 2;
     config_    = config;
 
     constexpr SAI_Block_TypeDef* a_instances[2] = {SAI1_Block_A, SAI2_Block_A};
@@ -152,6 +249,18 @@ SaiHandle::Result SaiHandle::Impl::Init(const SaiHandle::Config& config)
                                                           : SAI_MODESLAVE_RX;
         sai_b_handle_.Init.Synchro = SAI_SYNCHRONOUS;
     }
+    // External clocks: A takes SCK / FS from the pins, B follows A.
+    if(config.clock == Config::Clock::EXTERNAL)
+    {
+        sai_a_handle_.Init.AudioMode
+            = config.a_dir == Config::Direction::TRANSMIT ? SAI_MODESLAVE_TX
+                                                          : SAI_MODESLAVE_RX;
+        sai_a_handle_.Init.Synchro = SAI_ASYNCHRONOUS;
+        sai_b_handle_.Init.AudioMode
+            = config.b_dir == Config::Direction::TRANSMIT ? SAI_MODESLAVE_TX
+                                                          : SAI_MODESLAVE_RX;
+        sai_b_handle_.Init.Synchro = SAI_SYNCHRONOUS;
+    }
     // Bitdepth / protocol (currently based on bitdepth..)
     // TODO probably split these up for better flexibility..
     // These are also currently fixed to be the same per block.
@@ -174,6 +283,14 @@ SaiHandle::Result SaiHandle::Impl::Init(const SaiHandle::Config& config)
             break;
         default: break;
     }
+    if(config.packed16)
+    {
+        bd       = SAI_PROTOCOL_DATASIZE_16BITEXTENDED;
+        protocol = SAI_I2S_MSBJUSTIFIED;
+    }
+    const uint32_t nbslot = GetSlots();
+    if(nbslot > 2)
+        protocol = SAI_PCM_SHORT;
 
     // Generic Inits that we don't have API control over.
     // A
@@ -192,13 +309,13 @@ SaiHandle::Result SaiHandle::Impl::Init(const SaiHandle::Config& config)
     sai_b_handle_.Init.MonoStereoMode = SAI_STEREOMODE;
     sai_b_handle_.Init.CompandingMode = SAI_NOCOMPANDING;
     sai_b_handle_.Init.TriState       = SAI_OUTPUT_NOTRELEASED;
-    if(HAL_SAI_InitProtocol(&sai_a_handle_, protocol, bd, 2) != HAL_OK)
+    if(HAL_SAI_InitProtocol(&sai_a_handle_, protocol, bd, nbslot) != HAL_OK)
     {
         Error_Handler();
         return Result::ERR;
     }
 
-    if(HAL_SAI_InitProtocol(&sai_b_handle_, protocol, bd, 2) != HAL_OK)
+    if(HAL_SAI_InitProtocol(&sai_b_handle_, protocol, bd, nbslot) != HAL_OK)
     {
         Error_Handler();
         return Result::ERR;
@@ -251,11 +368,25 @@ void SaiHandle::Impl::InitDma(PeripheralBlock block)
     hdma->Init.Direction           = dir;
     hdma->Init.PeriphInc           = DMA_PINC_DISABLE;
     hdma->Init.MemInc              = DMA_MINC_ENABLE;
-    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma->Init.PeriphDataAlignment = config_.packed16 ? DMA_PDATAALIGN_HALFWORD
+                                                      : DMA_PDATAALIGN_WORD;
     hdma->Init.MemDataAlignment    = DMA_MDATAALIGN_WORD;
     hdma->Init.Mode                = DMA_CIRCULAR;
     hdma->Init.Priority            = DMA_PRIORITY_HIGH;
-    hdma->Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+    // The SAI side is always single words (half-words packed); the FIFO
+    // lets the memory side move them in fewer, wider transactions. In
+    // direct mode the memory side takes the SAI's size, and packed
+    // half-words land in the same place.
+    hdma->Init.FIFOMode = config_.dma_fifo == Config::DmaFifo::OFF
+                              ? DMA_FIFOMODE_DISABLE
+                              : DMA_FIFOMODE_ENABLE;
+    hdma->Init.FIFOThreshold = config_.dma_fifo == Config::DmaFifo::HALF
+                                   ? DMA_FIFO_THRESHOLD_HALFFULL
+                                   : DMA_FIFO_THRESHOLD_FULL;
+    hdma->Init.MemBurst = config_.dma_burst == Config::DmaBurst::INC4
+                              ? DMA_MBURST_INC4
+                              : DMA_MBURST_SINGLE;
+    hdma->Init.PeriphBurst = DMA_PBURST_SINGLE;
     if(HAL_DMA_Init(hdma) != HAL_OK)
     {
         Error_Handler();
@@ -278,45 +409,78 @@ void SaiHandle::Impl::DeinitDma(PeripheralBlock block)
     }
 }
 
-void SaiHandle::Impl::InternalCallback(size_t offset)
+DSY_ITCM_FUNC void SaiHandle::Impl::InternalCallback(size_t offset)
 {
     int32_t *in, *out;
     in  = buff_rx_ + offset;
     out = buff_tx_ + offset;
     if(callback_)
-        callback_(in, out, buff_size_ / 2);
+        callback_(in, out, buff_size_ / segments_);
 }
 
 SaiHandle::Result
 SaiHandle::Impl::StartDmaTransfer(int32_t*                       buffer_rx,
                                   int32_t*                       buffer_tx,
                                   size_t                         size,
-                                  SaiHandle::CallbackFunctionPtr callback)
+                                  SaiHandle::CallbackFunctionPtr callback,
+                                  size_t                         segments)
 {
-    buff_rx_   = buffer_rx;
-    buff_tx_   = buffer_tx;
-    buff_size_ = size;
-    callback_  = callback;
+    if(segments < 2 || size % segments != 0)
+        return Result::ERR;
+    buff_rx_      = buffer_rx;
+    buff_tx_      = buffer_tx;
+    buff_size_     = size;
+    callback_      = callback;
+    segments_      = segments;
+    dma_offset     = 0;
+    ring_filled_   = 0;
+    ring_served_   = 0;
+    ring_dropped_  = 0;
+    frame_base_    = 0;
+    block_frame_   = 0;
+    block_frame64_ = 0;
+    block_time_.Write({0, 0});
+    if(segments_ > 2)
+    {
+        HAL_NVIC_SetPriority(kRingIrq, kRingIrqPriority, 0);
+        HAL_NVIC_EnableIRQ(kRingIrq);
+    }
+    // Slave block first, so its stream is set up before the master
+    // starts the clocks.
     if(config_.a_sync == Config::Sync::SLAVE)    
     {
-        config_.a_dir == Config::Direction::RECEIVE
-            ? HAL_SAI_Receive_DMA(&sai_a_handle_, (uint8_t*)buffer_rx, size)
-            : HAL_SAI_Transmit_DMA(&sai_a_handle_, (uint8_t*)buffer_tx, size);
-        config_.b_dir == Config::Direction::RECEIVE
-            ? HAL_SAI_Receive_DMA(&sai_b_handle_, (uint8_t*)buffer_rx, size)
-            : HAL_SAI_Transmit_DMA(&sai_b_handle_, (uint8_t*)buffer_tx, size);
+        StartBlock(&sai_a_handle_, config_.a_dir);
+        StartBlock(&sai_b_handle_, config_.b_dir);
     }
     else
     {
-        config_.b_dir == Config::Direction::RECEIVE
-            ? HAL_SAI_Receive_DMA(&sai_b_handle_, (uint8_t*)buffer_rx, size)
-            : HAL_SAI_Transmit_DMA(&sai_b_handle_, (uint8_t*)buffer_tx, size);
-        config_.a_dir == Config::Direction::RECEIVE
-            ? HAL_SAI_Receive_DMA(&sai_a_handle_, (uint8_t*)buffer_rx, size)
-            : HAL_SAI_Transmit_DMA(&sai_a_handle_, (uint8_t*)buffer_tx, size);
+        StartBlock(&sai_b_handle_, config_.b_dir);
+        StartBlock(&sai_a_handle_, config_.a_dir);
     }
+    MuteTxDmaIrqs();
     return Result::OK;
 }
+
+void SaiHandle::Impl::StartBlock(SAI_HandleTypeDef* hsai, Config::Direction dir)
+{
+    ApplyDmaFifo(dir == Config::Direction::RECEIVE ? hsai->hdmarx
+                                                   : hsai->hdmatx);
+    if(dir == Config::Direction::RECEIVE)
+    {
+        HAL_SAI_Receive_DMA(
+            hsai, (uint8_t*)buff_rx_, buff_size_ * ItemsPerWord());
+        // HAL only knows circular mode; swap the stream over before any
+        // word arrives.
+        if(segments_ > 2)
+            RestartDma(hsai, hsai->hdmarx);
+    }
+    else
+    {
+        HAL_SAI_Transmit_DMA(
+            hsai, (uint8_t*)buff_tx_, buff_size_ * ItemsPerWord());
+    }
+}
+
 SaiHandle::Result SaiHandle::Impl::StopDmaTransfer()
 {
     HAL_SAI_DMAStop(&sai_a_handle_);
@@ -324,6 +488,203 @@ SaiHandle::Result SaiHandle::Impl::StopDmaTransfer()
     return Result::OK;
 }
 
+void SaiHandle::Impl::RestartDma(SAI_HandleTypeDef* hsai,
+                                 DMA_HandleTypeDef* hdma)
+{
+    // Abort only the stream: HAL_SAI_DMAStop would disable the block and
+    // drop frame sync. The SAI callbacks stay linked in hdma.
+    HAL_DMA_Abort(hdma);
+    ApplyDmaFifo(hdma);
+    const uint32_t dr    = (uint32_t)&hsai->Instance->DR;
+    const size_t   items = buff_size_ * ItemsPerWord();
+    if(hdma->Init.Direction != DMA_PERIPH_TO_MEMORY)
+    {
+        // The transmit side is a plain circular stream in either mode.
+        HAL_DMA_Start_IT(hdma, (uint32_t)buff_tx_, dr, items);
+    }
+    else if(segments_ > 2)
+    {
+        const size_t seg = buff_size_ / segments_;
+        HAL_DMAEx_MultiBufferStart_IT(hdma,
+                                      dr,
+                                      (uint32_t)buff_rx_,
+                                      (uint32_t)(buff_rx_ + seg),
+                                      items / segments_);
+        // Only the block boundaries matter.
+        __HAL_DMA_DISABLE_IT(hdma, DMA_IT_HT);
+    }
+    else
+    {
+        HAL_DMA_Start_IT(hdma, dr, (uint32_t)buff_rx_, items);
+    }
+}
+
+void SaiHandle::Impl::ApplyDmaFifo(DMA_HandleTypeDef* hdma)
+{
+    // HAL_DMA_Start_IT leaves FCR and MBURST alone, so the mode set here
+    // holds until the next (re)start.
+    DMA_Stream_TypeDef* stream = (DMA_Stream_TypeDef*)hdma->Instance;
+    const size_t        words  = buff_size_ / segments_;
+    const bool          fifo   = hdma->Init.FIFOMode == DMA_FIFOMODE_ENABLE
+                      && words >= kDmaFifoMinWords && words % 4 == 0;
+    uint32_t fcr = stream->FCR & ~(DMA_SxFCR_DMDIS | DMA_SxFCR_FTH);
+    uint32_t cr  = stream->CR & ~DMA_SxCR_MBURST;
+    if(fifo)
+    {
+        fcr |= DMA_SxFCR_DMDIS | hdma->Init.FIFOThreshold;
+        cr |= hdma->Init.MemBurst;
+    }
+    stream->FCR = fcr;
+    stream->CR  = cr;
+}
+
+SaiHandle::Result SaiHandle::Impl::RestartDmaTransfer(size_t size)
+{
+    if(buff_rx_ == nullptr || buff_tx_ == nullptr)
+        return Result::ERR;
+    if(size % segments_ != 0)
+        return Result::ERR;
+    // In ring mode this runs from the ring interrupt, which the stream
+    // interrupts would otherwise preempt halfway through.
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    // Counted up to here; the stream restarts from block 0.
+    frame_base_  = GetFrameCount();
+    buff_size_   = size;
+    dma_offset   = 0;
+    ring_filled_ = 0;
+    ring_served_ = 0;
+    RestartDma(&sai_a_handle_, &sai_a_dma_handle_);
+    RestartDma(&sai_b_handle_, &sai_b_dma_handle_);
+    MuteTxDmaIrqs();
+    __set_PRIMASK(primask);
+    return Result::OK;
+}
+
+void SaiHandle::Impl::MuteTxDmaIrqs()
+{
+    // At tiny block sizes every interrupt counts; the tx stream would
+    // otherwise fire as often as the rx stream just to reach HAL's empty
+    // weak Tx callbacks. Error interrupts stay on.
+    DMA_HandleTypeDef* streams[2] = {&sai_a_dma_handle_, &sai_b_dma_handle_};
+    for(DMA_HandleTypeDef* hdma : streams)
+    {
+        if(hdma->Init.Direction == DMA_MEMORY_TO_PERIPH)
+            __HAL_DMA_DISABLE_IT(hdma, DMA_IT_HT | DMA_IT_TC);
+    }
+}
+
+DSY_ITCM_FUNC void SaiHandle::Impl::ServiceDmaIrq(DMA_HandleTypeDef* hdma)
+{
+    // First: the closest this gets to when the block's last frame came
+    // in. StreamBaseAddress points at LISR or HISR; the matching clear
+    // register sits two words above it.
+    const uint32_t     now   = DWT->CYCCNT;
+    volatile uint32_t* isr   = (volatile uint32_t*)hdma->StreamBaseAddress;
+    volatile uint32_t* ifcr  = isr + 2;
+    const uint32_t     shift = hdma->StreamIndex & 0x1FU;
+    const uint32_t     ht    = DMA_FLAG_HTIF0_4 << shift;
+    const uint32_t     tc    = DMA_FLAG_TCIF0_4 << shift;
+    const uint32_t     err   = (DMA_FLAG_TEIF0_4 | DMA_FLAG_DMEIF0_4) << shift;
+    const uint32_t     fe    = DMA_FLAG_FEIF0_4 << shift;
+    const uint32_t     flags = *isr;
+    // A FIFO over/underrun is not fatal (HAL only records it); clear it
+    // here so it cannot keep the interrupt pending.
+    if(flags & fe)
+        *ifcr = fe;
+    if(hdma->Init.Direction != DMA_PERIPH_TO_MEMORY || (flags & err))
+    {
+        HAL_DMA_IRQHandler(hdma);
+        return;
+    }
+    // Each flag is cleared together with the block count it stands for,
+    // see GetFrameCount().
+    const uint32_t primask = __get_PRIMASK();
+    if(segments_ > 2)
+    {
+        __disable_irq();
+        *ifcr = flags & (ht | tc);
+        if(flags & tc)
+        {
+            ring_cycles_[ring_filled_ % kRingStamps] = now;
+            AdvanceRing(hdma);
+        }
+        __set_PRIMASK(primask);
+        return;
+    }
+    // Same work as HAL_DMA_IRQHandler -> SAI_DMARx(Half)Cplt ->
+    // HAL_SAI_Rx(Half)CpltCallback, without the dispatch chain.
+    const uint32_t block_frames = buff_size_ / 2 / GetWordsPerFrame();
+    if(flags & ht)
+    {
+        __disable_irq();
+        *ifcr = ht;
+        ring_filled_++;
+        __set_PRIMASK(primask);
+        SetBlock(frame_base_ + (ring_filled_ - 1) * block_frames, now);
+        dma_offset = 0;
+        InternalCallback(0);
+    }
+    if(flags & tc)
+    {
+        __disable_irq();
+        *ifcr = tc;
+        ring_filled_++;
+        __set_PRIMASK(primask);
+        SetBlock(frame_base_ + (ring_filled_ - 1) * block_frames, now);
+        dma_offset = buff_size_ / 2;
+        InternalCallback(dma_offset);
+    }
+}
+
+DSY_ITCM_FUNC void SaiHandle::Impl::AdvanceRing(DMA_HandleTypeDef* hdma)
+{
+    // The stream has just switched to the block after the one it
+    // filled; the register it left is idle until the next switch.
+    DMA_Stream_TypeDef* stream = (DMA_Stream_TypeDef*)hdma->Instance;
+    const size_t        filled = ring_filled_;
+    size_t              next   = filled % segments_ + 2;
+    if(next >= segments_)
+        next -= segments_;
+    const uint32_t addr = (uint32_t)(buff_rx_ + next * (buff_size_ / segments_));
+    if(stream->CR & DMA_SxCR_CT)
+        stream->M0AR = addr;
+    else
+        stream->M1AR = addr;
+    ring_filled_ = filled + 1;
+    if(callback_)
+        NVIC_SetPendingIRQ(kRingIrq);
+}
+
+DSY_ITCM_FUNC void SaiHandle::Impl::ServiceRing()
+{
+    if(segments_ <= 2 || callback_ == nullptr)
+        return;
+    while(ring_served_ != ring_filled_)
+    {
+        // Block n's input is overwritten, and its output slot played,
+        // segments - 1 periods after it fills. Anything older than the
+        // newest block is past saving.
+        const size_t filled = ring_filled_;
+        if(filled - ring_served_ >= segments_)
+        {
+            ring_dropped_ += filled - 1 - ring_served_;
+            ring_served_ = filled - 1;
+        }
+        dma_offset = (ring_served_ % segments_) * (buff_size_ / segments_);
+        SetBlock(frame_base_ + ring_served_ * GetBlockSize(),
+                 ring_cycles_[ring_served_ % kRingStamps]);
+        // Counted first: the callback may restart the ring.
+        ring_served_++;
+        for(Impl& h : sai_handles)
+        {
+            if(&h != this && h.segments_ == segments_ && h.callback_ == nullptr)
+                h.dma_offset = dma_offset;
+        }
+        InternalCallback(dma_offset);
+    }
+}
+
 float SaiHandle::Impl::GetSampleRate()
 {
     switch(config_.sr)
@@ -339,9 +700,83 @@ float SaiHandle::Impl::GetSampleRate()
 }
 size_t SaiHandle::Impl::GetBlockSize()
 {
-    // Buffer handled in halves, 2 samples per frame (1 per channel)
-    return buff_size_ / 2 / 2;
+    // Buffer handled in segments, one sample per slot in each frame
+    return buff_size_ / segments_ / GetWordsPerFrame();
+}
+const DMA_HandleTypeDef* SaiHandle::Impl::RxDma() const
+{
+    if(config_.a_dir == Config::Direction::RECEIVE)
+        return &sai_a_dma_handle_;
+    if(config_.b_dir == Config::Direction::RECEIVE)
+        return &sai_b_dma_handle_;
+    return nullptr;
+}
+
+DSY_ITCM_FUNC uint32_t SaiHandle::Impl::GetFrameCount() const
+{
+    const DMA_HandleTypeDef* hdma = RxDma();
+    if(hdma == nullptr || buff_size_ == 0)
+        return frame_base_;
+    const DMA_Stream_TypeDef* stream = (DMA_Stream_TypeDef*)hdma->Instance;
+    const volatile uint32_t*  isr
+        = (const volatile uint32_t*)hdma->StreamBaseAddress;
+    const uint32_t shift = hdma->StreamIndex & 0x1FU;
+    const uint32_t ht    = DMA_FLAG_HTIF0_4 << shift;
+    const uint32_t tc    = DMA_FLAG_TCIF0_4 << shift;
+    // The ring only clears half-transfer flags at block ends.
+    const uint32_t ends  = segments_ > 2 ? tc : (ht | tc);
+    // In stream items, one per sample whether packed or not.
+    const uint32_t items = buff_size_ * ItemsPerWord();
+    const uint32_t seg   = items / segments_;
+    const uint32_t span  = segments_ > 2 ? seg : items;
+    const uint32_t slots = GetSlots();
+
+    // A block end between the reads shows up as a changed count or flag.
+    size_t   filled;
+    uint32_t pending, ndtr;
+    do
+    {
+        filled  = ring_filled_;
+        pending = *isr & ends;
+        ndtr    = stream->NDTR;
+    } while(filled != ring_filled_ || pending != (*isr & ends));
+
+    // A raised flag is a finished block its interrupt has not counted.
+    uint32_t words = (span - ndtr) % seg;
+    if(pending & ht)
+        words += seg;
+    if(pending & tc)
+        words += seg;
+    return frame_base_ + (uint32_t)filled * (seg / slots) + words / slots;
+}
+
+uint64_t SaiHandle::Impl::GetFrameAt(uint32_t cycles)
+{
+    SaiHandle::BlockTime t;
+    block_time_.Read(t);
+    // At t.cycles the block had just come in whole: the next frame was
+    // arriving.
+    const int64_t since  = (int32_t)(cycles - t.cycles);
+    const int64_t frames = since * (int64_t)GetSampleRate()
+                           / (int64_t)SystemCoreClock;
+    return (uint64_t)((int64_t)(t.frame + GetBlockSize()) + frames);
+}
+
+size_t SaiHandle::Impl::GetSlots() const
+{
+    switch(config_.slots)
+    {
+        case Config::Slots::TDM_4: return 4;
+        case Config::Slots::TDM_8: return 8;
+        default: return 2;
+    }
 }
+
+size_t SaiHandle::Impl::GetWordsPerFrame() const
+{
+    return GetSlots() / ItemsPerWord();
+}
+
 float SaiHandle::Impl::GetBlockRate()
 {
     return GetSampleRate() / GetBlockSize();
@@ -359,8 +794,9 @@ void SaiHandle::Impl::InitPins()
                            &config_.pin_config.sb};
     // Special Case checks
     dsy_gpio_pin sck_af_pin = {DSY_GPIOA, 2};
-    is_master               = (config_.a_sync == Config::Sync::MASTER
-                 || config_.b_sync == Config::Sync::MASTER);
+    is_master = config_.clock == Config::Clock::INTERNAL
+                && (config_.a_sync == Config::Sync::MASTER
+                    || config_.b_sync == Config::Sync::MASTER);
     // Generics
     GPIO_InitStruct.Mode  = GPIO_MODE_AF_PP;
     GPIO_InitStruct.Pull  = GPIO_PULLUP;
@@ -396,8 +832,9 @@ void SaiHandle::Impl::DeinitPins()
     GPIO_TypeDef* port;
     uint16_t      pin;
     bool          is_master;
-    is_master = (config_.a_sync == Config::Sync::MASTER
-                 || config_.b_sync == Config::Sync::MASTER);
+    is_master = config_.clock == Config::Clock::INTERNAL
+                && (config_.a_sync == Config::Sync::MASTER
+                    || config_.b_sync == Config::Sync::MASTER);
     if(is_master)
     {
         port = dsy_hal_map_get_port(&config_.pin_config.mclk);
@@ -495,24 +932,30 @@ extern "C" void HAL_SAI_MspDeInit(SAI_HandleTypeDef* hsai)
 // ISRs and event handlers
 // ================================================================
 
-extern "C" void DMA1_Stream0_IRQHandler(void)
+extern "C" DSY_ITCM_FUNC void DMA1_Stream0_IRQHandler(void)
+{
+    sai_handles[0].ServiceDmaIrq(&sai_handles[0].sai_a_dma_handle_);
+}
+
+extern "C" DSY_ITCM_FUNC void DMA1_Stream1_IRQHandler(void)
 {
-    HAL_DMA_IRQHandler(&sai_handles[0].sai_a_dma_handle_);
+    sai_handles[0].ServiceDmaIrq(&sai_handles[0].sai_b_dma_handle_);
 }
 
-extern "C" void DMA1_Stream1_IRQHandler(void)
+extern "C" DSY_ITCM_FUNC void DMA1_Stream3_IRQHandler(void)
 {
-    HAL_DMA_IRQHandler(&sai_handles[0].sai_b_dma_handle_);
+    sai_handles[1].ServiceDmaIrq(&sai_handles[1].sai_a_dma_handle_);
 }
 
-extern "C" void DMA1_Stream3_IRQHandler(void)
+extern "C" DSY_ITCM_FUNC void DMA1_Stream4_IRQHandler(void)
 {
-    HAL_DMA_IRQHandler(&sai_handles[1].sai_a_dma_handle_);
+    sai_handles[1].ServiceDmaIrq(&sai_handles[1].sai_b_dma_handle_);
 }
 
-extern "C" void DMA1_Stream4_IRQHandler(void)
+extern "C" DSY_ITCM_FUNC void SAI4_IRQHandler(void)
 {
-    HAL_DMA_IRQHandler(&sai_handles[1].sai_b_dma_handle_);
+    sai_handles[0].ServiceRing();
+    sai_handles[1].ServiceRing();
 }
 
 extern "C" void HAL_SAI_RxHalfCpltCallback(SAI_HandleTypeDef* hsai)
@@ -560,9 +1003,11 @@ const SaiHandle::Config& SaiHandle::GetConfig() const
 SaiHandle::Result SaiHandle::StartDma(int32_t*            buffer_rx,
                                       int32_t*            buffer_tx,
                                       size_t              size,
-                                      CallbackFunctionPtr callback)
+                                      CallbackFunctionPtr callback,
+                                      size_t              segments)
 {
-    return pimpl_->StartDmaTransfer(buffer_rx, buffer_tx, size, callback);
+    return pimpl_->StartDmaTransfer(
+        buffer_rx, buffer_tx, size, callback, segments);
 }
 
 SaiHandle::Result SaiHandle::StopDma()
@@ -570,6 +1015,11 @@ SaiHandle::Result SaiHandle::StopDma()
     return pimpl_->StopDmaTransfer();
 }
 
+SaiHandle::Result SaiHandle::RestartDma(size_t size)
+{
+    return pimpl_->RestartDmaTransfer(size);
+}
+
 float SaiHandle::GetSampleRate()
 {
     return pimpl_->GetSampleRate();
@@ -585,10 +1035,61 @@ float SaiHandle::GetBlockRate()
     return pimpl_->GetBlockRate();
 }
 
+size_t SaiHandle::GetSlots() const
+{
+    return pimpl_->GetSlots();
+}
+
+size_t SaiHandle::GetWordsPerFrame() const
+{
+    return pimpl_->GetWordsPerFrame();
+}
+
+uint32_t SaiHandle::GetFrameCount() const
+{
+    return pimpl_->GetFrameCount();
+}
+
+uint32_t SaiHandle::GetBlockFrame() const
+{
+    return pimpl_->block_frame_;
+}
+
+SaiHandle::BlockTime SaiHandle::GetBlockTime() const
+{
+    BlockTime t;
+    pimpl_->block_time_.Read(t);
+    return t;
+}
+
+uint64_t SaiHandle::GetFrameCount64() const
+{
+    // Both counts move together mod 2^32, and the stream is never a
+    // whole wrap ahead of the block.
+    const BlockTime t   = GetBlockTime();
+    const uint32_t  now = pimpl_->GetFrameCount();
+    return t.frame + (uint32_t)(now - (uint32_t)t.frame);
+}
+
+uint64_t SaiHandle::GetFrameAt(uint32_t cycles) const
+{
+    return pimpl_->GetFrameAt(cycles);
+}
+
 size_t SaiHandle::GetOffset() const
 {
     return pimpl_->dma_offset;
 }
 
+size_t SaiHandle::GetSegments() const
+{
+    return pimpl_->segments_;
+}
+
+size_t SaiHandle::GetDroppedBlocks() const
+{
+    return pimpl_->ring_dropped_;
+}
+
 
 } // namespace daisy
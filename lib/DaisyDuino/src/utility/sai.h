@@ -91,6 +91,51 @@ class SaiHandle
             RECEIVE,
         };
 
+        /** DMA stream FIFO threshold. OFF is direct mode: every SAI
+         ** word is its own bus transaction on the memory side. */
+        enum class DmaFifo
+        {
+            OFF,
+            HALF,
+            FULL,
+        };
+
+        /** Memory-side DMA burst. INC4 moves the 4-word FIFO as one
+         ** burst and needs DmaFifo::FULL. */
+        enum class DmaBurst
+        {
+            SINGLE,
+            INC4,
+        };
+
+        /** Slots per frame, the same on both blocks. STEREO is the I2S
+         ** framing above. TDM_4 and TDM_8 run DSP-style TDM instead: a
+         ** one-bit frame sync pulse ahead of slot 0 and every slot active,
+         ** MSB first, 32-bit slots (16-bit at SAI_16BIT). The frame is at
+         ** most 256 bits, so the bit clock stays within the 256 * fs
+         ** master clock. DMA words are frame-interleaved, slot 0 first.
+         */
+        enum class Slots
+        {
+            STEREO,
+            TDM_4,
+            TDM_8,
+        };
+
+        /** Where the bit and frame clocks come from. EXTERNAL makes both
+         ** blocks slaves to SCK and FS on the pins, block A taking them
+         ** from outside and B following A, whatever a_sync and b_sync
+         ** say. It is for boards clocked from another board's master
+         ** SAI: wire MCLK, SCK and FS across, and since MCLK is left
+         ** undriven here the master's reaches this board's codec. sr
+         ** must match the master's.
+         */
+        enum class Clock
+        {
+            INTERNAL,
+            EXTERNAL,
+        };
+
         Peripheral periph;
         struct
         {
@@ -100,6 +145,26 @@ class SaiHandle
         BitDepth   bit_depth;
         Sync       a_sync, b_sync;
         Direction  a_dir, b_dir;
+        /** Applied to both blocks' streams. Blocks under 8 frames, or with
+         ** an odd frame count, run in direct mode whatever is set here:
+         ** the transmit FIFO reads up to 2 frames ahead of the SAI, which
+         ** tiny blocks cannot spare, and a burst must not straddle a
+         ** block boundary. With INC4 the buffers passed to StartDma()
+         ** must be 16-byte aligned, so no burst crosses a 1 kB line. */
+        DmaFifo  dma_fifo  = DmaFifo::FULL;
+        DmaBurst dma_burst = DmaBurst::INC4;
+        Slots    slots     = Slots::STEREO;
+        Clock    clock     = Clock::INTERNAL;
+        /** SAI_16BIT only: two samples per DMA buffer word, the earlier
+         ** slot in the low half, instead of one sample right-aligned in
+         ** each. The stream reads and writes half-words on the SAI side
+         ** and packs them in its FIFO, so the buffers and the memory
+         ** traffic are half the size. The 16 bits sit in 32-bit slots
+         ** (SAI_PROTOCOL_DATASIZE_16BITEXTENDED, MSB justified), framed as
+         ** at 24 bits, so a codec run at 24 bits takes them unchanged.
+         ** Buffer sizes and offsets stay in words; GetWordsPerFrame()
+         ** halves. */
+        bool packed16 = false;
     };
 
     /** Return values for SAI functions */
@@ -130,30 +195,100 @@ class SaiHandle
     /** Starts Rx and Tx in Circular Buffer Mode 
      ** The callback will be called when half of the buffer is ready, 
      ** and will handle size/2 samples per callback.
+     **
+     ** segments > 2 runs each buffer as a ring of that many blocks of
+     ** size/segments samples instead of two halves. The receive stream
+     ** goes to double-buffer mode and is pointed at the next free block
+     ** from its transfer-complete interrupt; the callback runs from a
+     ** lower-priority interrupt and writes the transmit block that plays
+     ** segments - 1 block periods later. One callback may then take up
+     ** to segments - 1 block periods, for segments - 2 blocks of extra
+     ** latency, as long as the average stays under one period. Blocks
+     ** it falls further behind than that are dropped, see
+     ** GetDroppedBlocks().
      */
     Result StartDma(int32_t*            buffer_rx,
                     int32_t*            buffer_tx,
                     size_t              size,
-                    CallbackFunctionPtr callback);
+                    CallbackFunctionPtr callback,
+                    size_t              segments = 2);
 
     /** Stops the DMA stream for the SAI blocks in use. */
     Result StopDma();
 
+    /** Restarts the running DMA streams from the top of the buffers passed
+     ** to StartDma(), with a new size and the same number of segments,
+     ** leaving the SAI itself running.
+     ** The SAI FIFO covers the few cycles the streams are off, so the
+     ** frame clock stays in step. Call from the DMA callback.
+     */
+    Result RestartDma(size_t size);
+
     /** Returns the samplerate based on the current configuration */
     float GetSampleRate();
 
-    /** Returns the number of samples per audio block 
-     ** Calculated as Buffer Size / 2 / number of channels */
+    /** Returns the number of frames per audio block
+     ** Calculated as Buffer Size / segments / GetWordsPerFrame() */
     size_t GetBlockSize();
 
+    /** Returns the samples per frame: 2, or 4 / 8 in TDM (Config::slots) */
+    size_t GetSlots() const;
+
+    /** Returns the DMA buffer words per frame: GetSlots(), half that
+     ** with Config::packed16 */
+    size_t GetWordsPerFrame() const;
+
     /** Returns the Block Rate of the current stream based on the size 
      ** of the buffer passed in, and the current samplerate. 
      */
     float GetBlockRate();
 
-    /** Returns the current offset within the SAI buffer, will be either 0 or size/2 */
+    /** Returns the current offset within the SAI buffer, a multiple of
+     ** size/segments. A ring started with no callback follows the block
+     ** being processed on the SAI that has one. */
     size_t GetOffset() const;
 
+    /** Returns the number of segments passed to StartDma() */
+    size_t GetSegments() const;
+
+    /** Returns the number of ring blocks skipped because the callback fell
+     ** too far behind, since StartDma() */
+    size_t GetDroppedBlocks() const;
+
+    /** Frames received since StartDma(), to the frame, at the moment of
+     ** the call: blocks completed plus the receive stream's position in
+     ** the current one. Wraps at 2^32. Safe from any interrupt, including
+     ** one above the DMA streams. A RestartDma() keeps the count going,
+     ** give or take the frame arriving while the streams restart. */
+    uint32_t GetFrameCount() const;
+
+    /** GetFrameCount() at the first frame of the block the callback is
+     ** handling. Call from the callback. */
+    uint32_t GetBlockFrame() const;
+
+    /** Where a block sits on the sample clock */
+    struct BlockTime
+    {
+        /** GetBlockFrame() counted in 64 bits: never wraps */
+        uint64_t frame;
+        /** DWT->CYCCNT at the DMA interrupt that ended its input */
+        uint32_t cycles;
+    };
+
+    /** The block the callback is handling, or last handled. Safe from
+     ** any interrupt, including one above the DMA streams. */
+    BlockTime GetBlockTime() const;
+
+    /** GetFrameCount() on BlockTime::frame's 64-bit count. Safe from
+     ** any interrupt. */
+    uint64_t GetFrameCount64() const;
+
+    /** The frame the receive stream was taking in at DWT time cycles,
+     ** e.g. a MIDI byte's timestamp from its UART interrupt, placed from
+     ** the latest block's interrupt at the nominal sample rate. cycles
+     ** must be within 2^31 core clocks (4.4 s at 480 MHz) of it. */
+    uint64_t GetFrameAt(uint32_t cycles) const;
+
     inline bool IsInitialized() const
     {
         return pimpl_ == nullptr ? false : true;
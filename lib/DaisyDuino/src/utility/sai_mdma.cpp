@@ -0,0 +1,151 @@
+#include "sai_mdma.h"
+#include "daisy_core.h"
+#include "irq_priority.h"
+
+using namespace daisy;
+
+static const size_t kMdmaChannels = 16;
+
+// Second node of each channel's list. DTCM is uncached, so the MDMA
+// always fetches what Start() just wrote; CLAR needs 8-byte alignment.
+static MDMA_LinkNodeTypeDef DTCM_MEM_SECTION __attribute__((aligned(8)))
+mdma_nodes[kMdmaChannels];
+
+static SaiMdma* mdma_owners[kMdmaChannels];
+
+static const uint32_t kMdmaClearAll = MDMA_CIFCR_CTEIF | MDMA_CIFCR_CCTCIF
+                                      | MDMA_CIFCR_CBRTIF | MDMA_CIFCR_CBTIF
+                                      | MDMA_CIFCR_CLTCIF;
+
+// TCM addresses go through the AHBS port, everything else over AXI;
+// same test as HAL_MDMA_Start.
+static inline bool IsTcm(const void* p)
+{
+    const uint32_t a = (uint32_t)p & 0xFF000000U;
+    return a == 0x20000000U || a == 0x00000000U;
+}
+
+static inline uint32_t BusSelect(const void* src, const void* dst)
+{
+    return (IsTcm(src) ? MDMA_CTBR_SBUS : 0) | (IsTcm(dst) ? MDMA_CTBR_DBUS : 0);
+}
+
+void SaiMdma::Init(size_t channel, Direction dir, DoneCallback done)
+{
+    if(channel >= kMdmaChannels)
+        return;
+    __HAL_RCC_MDMA_CLK_ENABLE();
+
+    ch_ = (MDMA_Channel_TypeDef*)(MDMA_Channel0_BASE
+                                  + channel
+                                        * (MDMA_Channel1_BASE
+                                           - MDMA_Channel0_BASE));
+    node_  = &mdma_nodes[channel];
+    dir_   = dir;
+    done_  = done;
+    ch_->CCR   = 0;
+    ch_->CIFCR = kMdmaClearAll;
+
+    // Word in, word out, one word per block; the block repeat and the
+    // linked list run off a single software request.
+    ctcr_ = MDMA_SRC_INC_WORD | MDMA_DEST_INC_WORD | MDMA_SRC_DATASIZE_WORD
+            | MDMA_DEST_DATASIZE_WORD | ((4U - 1U) << MDMA_CTCR_TLEN_Pos)
+            | MDMA_FULL_TRANSFER | MDMA_CTCR_SWRM;
+    ch_->CCR = MDMA_PRIORITY_VERY_HIGH | MDMA_CCR_CTCIE | MDMA_CCR_TEIE;
+
+    mdma_owners[channel] = this;
+    // Same priority as the audio DMA streams, so neither preempts the other.
+    HAL_NVIC_SetPriority(MDMA_IRQn, IRQ_PRIORITY_AUDIO, 0);
+    HAL_NVIC_EnableIRQ(MDMA_IRQn);
+}
+
+DSY_ITCM_FUNC void SaiMdma::Start(int32_t* interleaved, int32_t* l, int32_t* r, size_t frames)
+{
+    // BNDT is the block length in bytes, BRC the repeat count minus one.
+    const uint32_t bndtr
+        = 4U | ((uint32_t)(frames - 1) << MDMA_CBNDTR_BRC_Pos);
+
+    // After each word the interleaved side skips the other channel's
+    // word: 4 bytes of block address update on top of the increment.
+    int32_t *src0, *dst0, *src1, *dst1;
+    uint32_t brur;
+    if(dir_ == Direction::DEINTERLEAVE)
+    {
+        src0 = interleaved;
+        dst0 = l;
+        src1 = interleaved + 1;
+        dst1 = r;
+        brur = 4U << MDMA_CBRUR_SUV_Pos;
+    }
+    else
+    {
+        src0 = l;
+        dst0 = interleaved;
+        src1 = r;
+        dst1 = interleaved + 1;
+        brur = 4U << MDMA_CBRUR_DUV_Pos;
+    }
+
+    node_->CTCR   = ctcr_;
+    node_->CBNDTR = bndtr;
+    node_->CSAR   = (uint32_t)src1;
+    node_->CDAR   = (uint32_t)dst1;
+    node_->CBRUR  = brur;
+    node_->CLAR   = 0;
+    node_->CTBR   = BusSelect(src1, dst1);
+    node_->CMAR   = 0;
+    node_->CMDR   = 0;
+
+    ch_->CIFCR  = kMdmaClearAll;
+    ch_->CTCR   = ctcr_;
+    ch_->CBNDTR = bndtr;
+    ch_->CSAR   = (uint32_t)src0;
+    ch_->CDAR   = (uint32_t)dst0;
+    ch_->CBRUR  = brur;
+    ch_->CLAR   = (uint32_t)node_;
+    ch_->CTBR   = BusSelect(src0, dst0);
+    ch_->CMAR   = 0;
+    ch_->CMDR   = 0;
+
+    // The node and the source data must be in memory before the request.
+    __DSB();
+    ch_->CCR |= MDMA_CCR_EN;
+    ch_->CCR |= MDMA_CCR_SWRQ;
+}
+
+void SaiMdma::Abort()
+{
+    if(ch_ == nullptr)
+        return;
+    ch_->CCR &= ~MDMA_CCR_EN;
+    ch_->CIFCR = kMdmaClearAll;
+}
+
+DSY_ITCM_FUNC void SaiMdma::IrqHandler()
+{
+    for(size_t i = 0; i < kMdmaChannels; i++)
+    {
+        SaiMdma* m = mdma_owners[i];
+        if(m == nullptr)
+            continue;
+        const uint32_t isr = m->ch_->CISR;
+        if(isr & MDMA_CISR_TEIF)
+        {
+            // Bus error: drop this transfer. The done callback does not
+            // run, so the caller loses one block and starts afresh.
+            m->Abort();
+            continue;
+        }
+        if(isr & MDMA_CISR_CTCIF)
+        {
+            m->ch_->CIFCR = kMdmaClearAll;
+            if(m->done_)
+                m->done_();
+        }
+    }
+}
+
+extern "C" DSY_ITCM_FUNC void MDMA_IRQHandler(void)
+{
+    SaiMdma::IrqHandler();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef DSY_SAI_MDMA_H
+#define DSY_SAI_MDMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** Strided stereo word mover on one MDMA channel.
+
+    Splits one half of an interleaved stereo SAI buffer into two planar
+    int32 buffers, or merges two planar buffers back into it, without
+    the CPU touching the data. The transfer is a two-node linked list
+    (left, then right), each node a repeated block of one word with a
+    one-word skip on the interleaved side, started by a single software
+    request. The done callback runs from MDMA_IRQHandler once both
+    nodes have finished.
+
+    MDMA sits in the D1 domain and reaches SRAM1 as well as DTCM, so the
+    planar side can live in DTCM. MDMA only moves words: sign extension
+    and float conversion stay with the caller.
+
+    Start() programs the channel registers directly, a handful of
+    stores instead of a HAL call; the second node lives in DTCM, so
+    rewriting it needs no cache maintenance.
+*/
+class SaiMdma
+{
+  public:
+    enum class Direction
+    {
+        /** interleaved -> l, r */
+        DEINTERLEAVE,
+        /** l, r -> interleaved */
+        INTERLEAVE,
+    };
+
+    typedef void (*DoneCallback)();
+
+    SaiMdma() : ch_(nullptr), node_(nullptr), done_(nullptr) {}
+    ~SaiMdma() {}
+
+    /** Sets up the channel and enables the MDMA interrupt.
+        \param channel - 0 to 15, one per SaiMdma
+        \param dir - which way the words move
+        \param done - called from the MDMA interrupt when a Start() finishes
+    */
+    void Init(size_t channel, Direction dir, DoneCallback done);
+
+    /** Moves frames stereo frames between interleaved and l / r.
+        frames must be 1 to 4096. Must not be called while Busy().
+    */
+    void Start(int32_t* interleaved, int32_t* l, int32_t* r, size_t frames);
+
+    /** \return true from Start() until the done callback */
+    bool Busy() const { return ch_ != nullptr && (ch_->CCR & MDMA_CCR_EN); }
+
+    /** Disables the channel, dropping any transfer in flight. */
+    void Abort();
+
+    /** Dispatches channel-complete flags to each SaiMdma's callback. */
+    static void IrqHandler();
+
+  private:
+    MDMA_Channel_TypeDef* ch_;
+    MDMA_LinkNodeTypeDef* node_;
+    DoneCallback          done_;
+    Direction             dir_;
+    uint32_t              ctcr_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,63 @@
+#include "sample_sync.h"
+#include "irq_priority.h"
+
+using namespace daisy;
+
+static SampleSync* sample_sync_instance = nullptr;
+
+static IRQn_Type ExtiIrq(PinName pin)
+{
+    const uint32_t line = STM_PIN(pin);
+    if(line <= 4)
+        return (IRQn_Type)(EXTI0_IRQn + line);
+    return line <= 9 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+void SampleSync::Init(Role role, uint32_t pin, FrameCountFn frame_count)
+{
+    role_                = role;
+    pin_                 = digitalPinToPinName(pin);
+    frame_count_         = frame_count;
+    epoch_               = 0;
+    edges_               = 0;
+    sample_sync_instance = this;
+    if(role_ == Role::MASTER)
+    {
+        pinMode(pin, OUTPUT);
+        digitalWriteFast(pin_, LOW);
+        return;
+    }
+    pinMode(pin, INPUT_PULLDOWN);
+    attachInterrupt(digitalPinToInterrupt(pin), &SampleSync::OnEdge, RISING);
+    // attachInterrupt() leaves the vector at the core's EXTI priority.
+    HAL_NVIC_SetPriority(ExtiIrq(pin_), IRQ_PRIORITY_SYNC, 0);
+}
+
+void SampleSync::Pulse()
+{
+    if(role_ != Role::MASTER || frame_count_ == nullptr)
+        return;
+    {
+        // Both ends read their count within a couple of microseconds of
+        // the boundary, well inside the frame, so they read the same one.
+        IrqPriorityLock lock(IRQ_PRIORITY_AUDIO);
+        const uint32_t  start = frame_count_();
+        uint32_t        edge;
+        while((edge = frame_count_()) == start) {}
+        digitalWriteFast(pin_, HIGH);
+        epoch_ = edge;
+        edges_ = edges_ + 1;
+    }
+    const uint32_t held = frame_count_();
+    while(frame_count_() == held) {}
+    digitalWriteFast(pin_, LOW);
+}
+
+void SampleSync::OnEdge()
+{
+    SampleSync* s = sample_sync_instance;
+    if(s == nullptr || s->frame_count_ == nullptr)
+        return;
+    s->epoch_ = s->frame_count_();
+    s->edges_ = s->edges_ + 1;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef DSY_SAMPLE_SYNC_H
+#define DSY_SAMPLE_SYNC_H
+
+#include "Arduino.h"
+#include <stdint.h>
+
+namespace daisy
+{
+/** Common frame count across boards that share one audio clock.
+
+    Boards clocked from one master SAI (SaiHandle::Config::Clock) run
+    frame for frame, but each counts frames from its own start. A sync
+    line puts them on one count: the master raises it just after a frame
+    boundary, every board, the master included, notes its own frame
+    count at the edge, and from then on Shared() counts frames since
+    that edge, the same on every board. The clocks being shared, one
+    edge holds for good; a later one (for a board that booted late)
+    restarts the count on all boards at once.
+
+    The edge interrupt runs at IRQ_PRIORITY_SYNC, above the audio
+    callback, so a board busy in its callback still timestamps the edge
+    in the right frame. For a block's output to leave every board at the
+    same frame, all boards need the same block size and DMA segments.
+
+    One instance per firmware.
+*/
+class SampleSync
+{
+  public:
+    enum class Role
+    {
+        /** Drives the sync line */
+        MASTER,
+        /** Listens to it */
+        SLAVE,
+    };
+
+    /** Returns the local frame count, e.g. DAISY.AudioFrameCount() */
+    typedef uint32_t (*FrameCountFn)();
+
+    SampleSync() : frame_count_(nullptr), epoch_(0), edges_(0) {}
+    ~SampleSync() {}
+
+    /** \param role - which end of the line this board is
+        \param pin - Arduino pin of the sync line. Its EXTI vector goes to
+                     IRQ_PRIORITY_SYNC, taking along any other pin that
+                     shares it (lines 5-9 and 10-15 share one each).
+        \param frame_count - local frame counter, read in the edge
+                             interrupt
+    */
+    void Init(Role role, uint32_t pin, FrameCountFn frame_count);
+
+    /** Master only: raises the line just after the next frame boundary
+        and drops it a frame later. Holds off the audio interrupts for up
+        to a frame. Call from loop() once every board is running audio.
+    */
+    void Pulse();
+
+    /** Local frame count to the common one, valid once Synced() */
+    inline uint32_t Shared(uint32_t local) const { return local - epoch_; }
+
+    /** true once an edge has been seen */
+    inline bool Synced() const { return edges_ != 0; }
+
+    /** Edges seen since Init(); a change means the count restarted. */
+    inline uint32_t GetEdges() const { return edges_; }
+
+  private:
+    static void OnEdge();
+
+    Role              role_;
+    PinName           pin_;
+    FrameCountFn      frame_count_;
+    volatile uint32_t epoch_;
+    volatile uint32_t edges_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,188 @@
+#include "sd_card.h"
+#include <stm32h7xx_hal.h>
+
+#if defined(HAL_SD_MODULE_ENABLED)
+
+using namespace daisy;
+
+static SD_HandleTypeDef sd_card_handle;
+
+// Set from the SDMMC1 interrupt, cleared by StartWrite() / StartRead().
+static volatile bool sd_card_done  = false;
+static volatile bool sd_card_error = false;
+
+bool SdCard::Init(uint32_t max_clock_hz)
+{
+    ready_     = false;
+    in_flight_ = false;
+
+    __HAL_RCC_SDMMC1_CLK_ENABLE();
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    __HAL_RCC_GPIOD_CLK_ENABLE();
+
+    // D0-D3 and CMD pulled up as the bus idles high; CK driven.
+    GPIO_InitTypeDef gpio = {};
+    gpio.Mode             = GPIO_MODE_AF_PP;
+    gpio.Pull             = GPIO_PULLUP;
+    gpio.Speed            = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio.Alternate        = GPIO_AF12_SDIO1;
+    gpio.Pin              = GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11;
+    HAL_GPIO_Init(GPIOC, &gpio);
+    gpio.Pin = GPIO_PIN_2;
+    HAL_GPIO_Init(GPIOD, &gpio);
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Pin  = GPIO_PIN_12;
+    HAL_GPIO_Init(GPIOC, &gpio);
+
+    // SDMMC_CK = kernel / (2 * ClockDiv)
+    if(max_clock_hz > 25000000 || max_clock_hz == 0)
+        max_clock_hz = 25000000;
+    const uint32_t kernel = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_SDMMC);
+    const uint32_t div    = (kernel + 2 * max_clock_hz - 1) / (2 * max_clock_hz);
+
+    SD_HandleTypeDef* hsd         = &sd_card_handle;
+    hsd->Instance                 = SDMMC1;
+    hsd->Init.ClockEdge           = SDMMC_CLOCK_EDGE_RISING;
+    hsd->Init.ClockPowerSave      = SDMMC_CLOCK_POWER_SAVE_DISABLE;
+    hsd->Init.BusWide             = SDMMC_BUS_WIDE_4B;
+    hsd->Init.HardwareFlowControl = SDMMC_HARDWARE_FLOW_CONTROL_ENABLE;
+    hsd->Init.ClockDiv            = div < 1 ? 1 : div;
+    // Identification runs at 400 kHz on one line; then the wide bus.
+    if(HAL_SD_Init(hsd) != HAL_OK)
+        return false;
+    if(HAL_SD_ConfigWideBusOperation(hsd, SDMMC_BUS_WIDE_4B) != HAL_OK)
+        return false;
+
+    HAL_SD_CardInfoTypeDef info;
+    if(HAL_SD_GetCardInfo(hsd, &info) != HAL_OK)
+        return false;
+    blocks_ = info.LogBlockNbr;
+    errors_ = 0;
+    HAL_NVIC_EnableIRQ(SDMMC1_IRQn);
+    ready_ = true;
+    return true;
+}
+
+bool SdCard::StartWrite(uint32_t lba, const void* data, uint32_t blocks)
+{
+    if(!ready_ || in_flight_ || blocks == 0)
+        return false;
+    bytes_   = blocks * kBlockSize;
+    data_    = const_cast<void*>(data);
+    reading_ = false;
+    SCB_CleanDCache_by_Addr(static_cast<uint32_t*>(data_),
+                            static_cast<int32_t>(bytes_));
+    sd_card_done  = false;
+    sd_card_error = false;
+    if(HAL_SD_WriteBlocks_DMA(
+           &sd_card_handle, static_cast<uint8_t*>(data_), lba, blocks)
+       != HAL_OK)
+    {
+        errors_++;
+        return false;
+    }
+    in_flight_ = true;
+    return true;
+}
+
+bool SdCard::StartRead(uint32_t lba, void* data, uint32_t blocks)
+{
+    if(!ready_ || in_flight_ || blocks == 0)
+        return false;
+    bytes_   = blocks * kBlockSize;
+    data_    = data;
+    reading_ = true;
+    // No dirty line may be evicted over what the DMA writes.
+    SCB_InvalidateDCache_by_Addr(static_cast<uint32_t*>(data_),
+                                 static_cast<int32_t>(bytes_));
+    sd_card_done  = false;
+    sd_card_error = false;
+    if(HAL_SD_ReadBlocks_DMA(
+           &sd_card_handle, static_cast<uint8_t*>(data_), lba, blocks)
+       != HAL_OK)
+    {
+        errors_++;
+        return false;
+    }
+    in_flight_ = true;
+    return true;
+}
+
+SdCard::Result SdCard::Poll()
+{
+    if(!in_flight_)
+        return Result::OK;
+    if(sd_card_error)
+    {
+        in_flight_ = false;
+        errors_++;
+        return Result::ERR;
+    }
+    if(!sd_card_done)
+        return Result::BUSY;
+    // The data is across; a write is programmed only once the card is
+    // back in the transfer state.
+    if(HAL_SD_GetCardState(&sd_card_handle) != HAL_SD_CARD_TRANSFER)
+        return Result::BUSY;
+    if(reading_)
+    {
+        // Lines fetched speculatively during the transfer are stale.
+        SCB_InvalidateDCache_by_Addr(static_cast<uint32_t*>(data_),
+                                     static_cast<int32_t>(bytes_));
+    }
+    in_flight_ = false;
+    return Result::OK;
+}
+
+bool SdCard::Write(uint32_t lba, const void* data, uint32_t blocks, uint32_t timeout_ms)
+{
+    if(!StartWrite(lba, data, blocks))
+        return false;
+    const uint32_t start = millis();
+    Result         r;
+    while((r = Poll()) == Result::BUSY)
+    {
+        if(millis() - start > timeout_ms)
+            return false;
+    }
+    return r == Result::OK;
+}
+
+bool SdCard::Read(uint32_t lba, void* data, uint32_t blocks, uint32_t timeout_ms)
+{
+    if(!StartRead(lba, data, blocks))
+        return false;
+    const uint32_t start = millis();
+    Result         r;
+    while((r = Poll()) == Result::BUSY)
+    {
+        if(millis() - start > timeout_ms)
+            return false;
+    }
+    return r == Result::OK;
+}
+
+extern "C" void HAL_SD_TxCpltCallback(SD_HandleTypeDef* hsd)
+{
+    if(hsd == &sd_card_handle)
+        sd_card_done = true;
+}
+
+extern "C" void HAL_SD_RxCpltCallback(SD_HandleTypeDef* hsd)
+{
+    if(hsd == &sd_card_handle)
+        sd_card_done = true;
+}
+
+extern "C" void HAL_SD_ErrorCallback(SD_HandleTypeDef* hsd)
+{
+    if(hsd == &sd_card_handle)
+        sd_card_error = true;
+}
+
+extern "C" void SDMMC1_IRQHandler(void)
+{
+    HAL_SD_IRQHandler(&sd_card_handle);
+}
+
+#endif // HAL_SD_MODULE_ENABLED
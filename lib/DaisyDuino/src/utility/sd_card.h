@@ -0,0 +1,100 @@
+#pragma once
+#ifndef DSY_SD_CARD_H
+#define DSY_SD_CARD_H
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+// Only with the HAL SD driver built (HAL_SD_MODULE_ENABLED).
+#if defined(HAL_SD_MODULE_ENABLED)
+
+namespace daisy
+{
+/** Raw block access to the microSD card on SDMMC1, 4-bit, by IDMA.
+
+    The Seed's and Patch SM's card slot (PC8-PC12, PD2). StartWrite()
+    and StartRead() queue a multi-block transfer and return at once;
+    the SDMMC's own DMA moves the data and the SDMMC1 interrupt
+    (IRQ_PRIORITY_STORAGE) only flags the end. Poll() then waits out the
+    card's programming, so a write is done when Poll() says OK, ready
+    for the next one. One transfer at a time, from one context, e.g.
+    loop() or a TaskRunner task. Needs the HAL SD driver built
+    (-DHAL_SD_MODULE_ENABLED).
+
+    The IDMA is on the AXI bus: data must be in AXI SRAM or SDRAM (not
+    DTCM, not DMA_BUFFER_MEM_SECTION in D2), word aligned, and, as
+    StartWrite() / StartRead() clean and invalidate the D-cache over
+    it, best 32-byte aligned and a whole number of cache lines, so no
+    neighbour shares a line. Untouched until Poll() returns OK.
+
+    Default speed (25 MHz, 12.5 MB/s on the bus); what a card sustains
+    for long multi-block writes is its own, 5-10 MB/s for a decent one,
+    with programming stalls of up to a few hundred milliseconds that
+    the caller buffers. No file system: see SdRecorder for the layout
+    of a take.
+
+    One instance per firmware.
+*/
+class SdCard
+{
+  public:
+    static constexpr size_t kBlockSize = 512;
+
+    enum class Result
+    {
+        OK,   /**< idle: the last transfer, if any, completed */
+        BUSY, /**< a transfer or the card's programming is going on */
+        ERR,  /**< the last transfer failed; idle again */
+    };
+
+    SdCard() : ready_(false), in_flight_(false), blocks_(0), errors_(0) {}
+    ~SdCard() {}
+
+    /** Sets up the pins and SDMMC1, identifies the card and goes to the
+        4-bit bus; blocking, for setup().
+        \param max_clock_hz - bus clock cap, 25 MHz at most
+        \return false if there is no card or it failed to come up
+    */
+    bool Init(uint32_t max_clock_hz = 25000000);
+
+    /** Starts writing blocks from data to the card from lba on.
+        \return false if not ready, busy, or the HAL refused
+    */
+    bool StartWrite(uint32_t lba, const void* data, uint32_t blocks);
+
+    /** Starts reading blocks from lba on into data.
+        \return false if not ready, busy, or the HAL refused
+    */
+    bool StartRead(uint32_t lba, void* data, uint32_t blocks);
+
+    /** Where the transfer started last is; ERR once per failed one */
+    Result Poll();
+
+    /** StartWrite() and Poll() until done, up to timeout_ms */
+    bool Write(uint32_t lba, const void* data, uint32_t blocks, uint32_t timeout_ms = 1000);
+
+    /** StartRead() and Poll() until done, up to timeout_ms */
+    bool Read(uint32_t lba, void* data, uint32_t blocks, uint32_t timeout_ms = 1000);
+
+    /** \return the card's size in 512-byte blocks */
+    inline uint32_t GetBlockCount() const { return blocks_; }
+
+    /** \return transfers that failed since Init() */
+    inline uint32_t GetErrors() const { return errors_; }
+
+    inline bool IsReady() const { return ready_; }
+
+  private:
+    bool     ready_;
+    bool     in_flight_;
+    bool     reading_;
+    void*    data_;
+    size_t   bytes_;
+    uint32_t blocks_;
+    uint32_t errors_;
+};
+
+} // namespace daisy
+#endif // HAL_SD_MODULE_ENABLED
+#endif
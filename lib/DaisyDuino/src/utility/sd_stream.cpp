@@ -0,0 +1,415 @@
+#include "sd_stream.h"
+#include "sdram.h"
+#include <string.h>
+
+#if defined(HAL_SD_MODULE_ENABLED)
+
+using namespace daisy;
+
+static_assert(sizeof(SdTakeHeader) == 40, "scripts/sd_take.py reads 40 bytes");
+
+// Header blocks, where the IDMA reaches them; a cache line each end.
+static uint8_t DSY_SDRAM_BSS __attribute__((aligned(32)))
+sd_record_header[SdCard::kBlockSize];
+static uint8_t DSY_SDRAM_BSS __attribute__((aligned(32)))
+sd_play_header[SdCard::kBlockSize];
+
+static bool RingOk(const uint8_t* ring, size_t ring_bytes)
+{
+    return ring != nullptr && (reinterpret_cast<uintptr_t>(ring) & 31) == 0
+           && ring_bytes >= 2 * SdRecorder::kChunkBytes
+           && (ring_bytes & (ring_bytes - 1)) == 0;
+}
+
+static inline int32_t To24(float x)
+{
+    x = x > 1.f ? 1.f : (x < -1.f ? -1.f : x);
+    return static_cast<int32_t>(x * 8388607.f);
+}
+
+bool SdRecorder::Init(SdCard* card, uint8_t* ring, size_t ring_bytes)
+{
+    if(card == nullptr || !RingOk(ring, ring_bytes))
+        return false;
+    card_       = card;
+    ring_       = ring;
+    ring_bytes_ = ring_bytes;
+    mask_       = ring_bytes - 1;
+    state_      = State::IDLE;
+    channels_   = 1;
+    frame_bytes_ = kBytesPerSample;
+    head_ = tail_ = 0;
+    frames_       = 0;
+    written_      = 0;
+    overruns_     = 0;
+    max_used_     = 0;
+    next_lba_     = 0;
+    return true;
+}
+
+void SdRecorder::MakeHeader(bool closed)
+{
+    SdTakeHeader h;
+    h.magic       = SdTakeHeader::kMagic;
+    h.version     = SdTakeHeader::kVersion;
+    h.sample_rate = sample_rate_;
+    h.channels    = static_cast<uint32_t>(channels_);
+    h.bits        = 8 * kBytesPerSample;
+    h.data_lba    = take_lba_ + 1;
+    h.frames      = written_ / frame_bytes_;
+    h.closed      = closed ? 1 : 0;
+    memset(sd_record_header, 0, sizeof(sd_record_header));
+    memcpy(sd_record_header, &h, sizeof(h));
+}
+
+bool SdRecorder::Start(uint32_t lba, uint32_t sample_rate, size_t channels)
+{
+    if(card_ == nullptr || !card_->IsReady() || channels == 0
+       || channels > kMaxChannels
+       || !(state_ == State::IDLE || state_ == State::FAILED))
+        return false;
+    if(static_cast<uint64_t>(lba) + 1 + kChunkBlocks > card_->GetBlockCount())
+        return false;
+    channels_     = channels;
+    frame_bytes_  = channels * kBytesPerSample;
+    sample_rate_  = sample_rate;
+    take_lba_     = lba;
+    next_lba_     = lba + 1;
+    head_ = tail_ = 0;
+    max_used_     = 0;
+    frames_       = 0;
+    written_      = 0;
+    overruns_     = 0;
+    since_header_ = 0;
+    op_           = Op::NONE;
+    retries_      = 0;
+    MakeHeader(false);
+    if(!card_->Write(take_lba_, sd_record_header, 1))
+        return false;
+    state_ = State::RECORDING;
+    return true;
+}
+
+void SdRecorder::Stop()
+{
+    if(state_ == State::RECORDING)
+        state_ = State::STOPPING;
+}
+
+void SdRecorder::Process(const float* const* in, size_t frames)
+{
+    if(state_ != State::RECORDING)
+        return;
+    const size_t bytes = frames * frame_bytes_;
+    size_t       h     = head_;
+    const size_t used  = h - tail_;
+    if(ring_bytes_ - used < bytes)
+    {
+        overruns_ = overruns_ + 1;
+        return;
+    }
+    uint8_t* const ring = ring_;
+    const size_t   mask = mask_;
+    for(size_t i = 0; i < frames; i++)
+    {
+        for(size_t c = 0; c < channels_; c++)
+        {
+            const int32_t s = To24(in[c][i]);
+            ring[h & mask]       = static_cast<uint8_t>(s);
+            ring[(h + 1) & mask] = static_cast<uint8_t>(s >> 8);
+            ring[(h + 2) & mask] = static_cast<uint8_t>(s >> 16);
+            h += kBytesPerSample;
+        }
+    }
+    head_   = h;
+    frames_ = frames_ + frames;
+    if(used + bytes > max_used_)
+        max_used_ = used + bytes;
+}
+
+float SdRecorder::GetFill() const
+{
+    return static_cast<float>(head_ - tail_) / static_cast<float>(ring_bytes_);
+}
+
+float SdRecorder::GetMaxFill() const
+{
+    return static_cast<float>(max_used_) / static_cast<float>(ring_bytes_);
+}
+
+bool SdRecorder::Issue()
+{
+    switch(op_)
+    {
+        case Op::CHUNK:
+        case Op::TAIL:
+            return card_->StartWrite(
+                next_lba_,
+                ring_ + (tail_ & mask_),
+                static_cast<uint32_t>((op_bytes_ + SdCard::kBlockSize - 1)
+                                      / SdCard::kBlockSize));
+        case Op::HEADER:
+        case Op::CLOSE: return card_->StartWrite(take_lba_, sd_record_header, 1);
+        default: return false;
+    }
+}
+
+void SdRecorder::Begin(Op op)
+{
+    op_      = op;
+    retries_ = 0;
+    issued_  = Issue();
+}
+
+void SdRecorder::StartNext()
+{
+    const State state = state_;
+    if(state != State::RECORDING && state != State::STOPPING)
+        return;
+    const size_t   used  = head_ - tail_;
+    const uint32_t space = card_->GetBlockCount() - next_lba_;
+    if(since_header_ >= kHeaderEvery)
+    {
+        since_header_ = 0;
+        MakeHeader(false);
+        Begin(Op::HEADER);
+        return;
+    }
+    if(used >= kChunkBytes && space >= kChunkBlocks)
+    {
+        op_bytes_ = kChunkBytes;
+        Begin(Op::CHUNK);
+        return;
+    }
+    if(space < kChunkBlocks)
+    {
+        // The card is full: what is queued goes in the tail that fits.
+        state_ = State::STOPPING;
+    }
+    else if(state == State::RECORDING)
+        return;
+
+    // Process() is off: the partial chunk at the tail is the last. It
+    // is contiguous, as the tail only moves by whole chunks.
+    size_t bytes = used < kChunkBytes ? used : kChunkBytes;
+    if(bytes > space * SdCard::kBlockSize)
+        bytes = space * SdCard::kBlockSize;
+    if(bytes == 0)
+    {
+        MakeHeader(true);
+        Begin(Op::CLOSE);
+        return;
+    }
+    const size_t padded = (bytes + SdCard::kBlockSize - 1) / SdCard::kBlockSize
+                          * SdCard::kBlockSize;
+    memset(ring_ + (tail_ & mask_) + bytes, 0, padded - bytes);
+    op_bytes_ = bytes;
+    Begin(Op::TAIL);
+}
+
+void SdRecorder::Service()
+{
+    if(card_ == nullptr)
+        return;
+    const SdCard::Result r = card_->Poll();
+    if(r == SdCard::Result::BUSY)
+        return;
+    if(op_ != Op::NONE && (!issued_ || r == SdCard::Result::ERR))
+    {
+        // Refused or failed, and the card idle again: the same once more.
+        if(++retries_ > kMaxRetries)
+        {
+            op_    = Op::NONE;
+            state_ = State::FAILED;
+            return;
+        }
+        issued_ = Issue();
+        return;
+    }
+    const Op done = op_;
+    op_           = Op::NONE;
+    switch(done)
+    {
+        case Op::CHUNK:
+            next_lba_ += kChunkBlocks;
+            written_ += kChunkBytes;
+            tail_ = tail_ + kChunkBytes;
+            since_header_++;
+            break;
+        case Op::TAIL:
+            next_lba_ += static_cast<uint32_t>(
+                (op_bytes_ + SdCard::kBlockSize - 1) / SdCard::kBlockSize);
+            written_ += op_bytes_;
+            tail_ = head_;
+            MakeHeader(true);
+            Begin(Op::CLOSE);
+            return;
+        case Op::CLOSE: state_ = State::IDLE; return;
+        default: break;
+    }
+    StartNext();
+}
+
+bool SdPlayer::Init(SdCard* card, uint8_t* ring, size_t ring_bytes)
+{
+    if(card == nullptr || !RingOk(ring, ring_bytes))
+        return false;
+    card_        = card;
+    ring_        = ring;
+    ring_bytes_  = ring_bytes;
+    mask_        = ring_bytes - 1;
+    open_        = false;
+    playing_     = false;
+    primed_      = false;
+    failed_      = false;
+    reading_     = false;
+    frame_bytes_ = SdRecorder::kBytesPerSample;
+    data_bytes_  = 0;
+    consumed_    = 0;
+    underruns_   = 0;
+    head_ = tail_ = 0;
+    return true;
+}
+
+bool SdPlayer::Open(uint32_t lba)
+{
+    if(card_ == nullptr || playing_)
+        return false;
+    open_ = false;
+    if(!card_->Read(lba, sd_play_header, 1))
+        return false;
+    SdTakeHeader h;
+    memcpy(&h, sd_play_header, sizeof(h));
+    if(h.magic != SdTakeHeader::kMagic || h.version != SdTakeHeader::kVersion
+       || h.bits != 8 * SdRecorder::kBytesPerSample || h.channels == 0
+       || h.channels > SdRecorder::kMaxChannels)
+        return false;
+    header_      = h;
+    frame_bytes_ = h.channels * SdRecorder::kBytesPerSample;
+    data_bytes_  = h.frames * frame_bytes_;
+    end_lba_     = h.data_lba
+               + static_cast<uint32_t>((data_bytes_ + SdCard::kBlockSize - 1)
+                                       / SdCard::kBlockSize);
+    consumed_    = 0;
+    open_        = true;
+    return true;
+}
+
+bool SdPlayer::Start()
+{
+    if(!open_ || playing_)
+        return false;
+    playing_   = false;
+    primed_    = false;
+    failed_    = false;
+    head_ = tail_ = 0;
+    consumed_  = 0;
+    underruns_ = 0;
+    read_lba_  = header_.data_lba;
+    retries_   = 0;
+    reading_   = false;
+    playing_   = true;
+    StartNext();
+    return true;
+}
+
+void SdPlayer::Stop()
+{
+    playing_ = false;
+    primed_  = false;
+}
+
+void SdPlayer::StartNext()
+{
+    if(!playing_ || read_lba_ >= end_lba_
+       || ring_bytes_ - (head_ - tail_) < kChunkBytes)
+        return;
+    const uint32_t left = end_lba_ - read_lba_;
+    read_blocks_ = left < kChunkBlocks ? left : kChunkBlocks;
+    if(card_->StartRead(read_lba_, ring_ + (head_ & mask_), read_blocks_))
+        reading_ = true;
+    else if(++retries_ > kMaxRetries)
+        failed_ = true;
+}
+
+void SdPlayer::Service()
+{
+    if(card_ == nullptr || failed_)
+        return;
+    const SdCard::Result r = card_->Poll();
+    if(r == SdCard::Result::BUSY)
+        return;
+    if(reading_)
+    {
+        reading_ = false;
+        if(r == SdCard::Result::ERR)
+        {
+            if(++retries_ > kMaxRetries)
+            {
+                failed_ = true;
+                return;
+            }
+        }
+        else
+        {
+            retries_ = 0;
+            read_lba_ += read_blocks_;
+            // Past the take's end the ring holds padding, never read.
+            head_ = head_ + kChunkBytes;
+            if(head_ - tail_ >= ring_bytes_ / 2 || read_lba_ >= end_lba_)
+                primed_ = true;
+        }
+    }
+    StartNext();
+}
+
+void SdPlayer::Process(float* const* out, size_t channels, size_t frames)
+{
+    const size_t bytes = frames * frame_bytes_;
+    uint64_t     left  = data_bytes_ - consumed_;
+    if(!playing_ || !primed_ || left == 0)
+    {
+        for(size_t c = 0; c < channels; c++)
+            memset(out[c], 0, frames * sizeof(float));
+        return;
+    }
+    const size_t t      = tail_;
+    size_t       in     = head_ - t;
+    if(in > left)
+        in = static_cast<size_t>(left);
+    if(in < bytes && in < left)
+    {
+        // Never half a block: the ring catches up instead.
+        underruns_ = underruns_ + 1;
+        for(size_t c = 0; c < channels; c++)
+            memset(out[c], 0, frames * sizeof(float));
+        return;
+    }
+    const size_t   n    = in < bytes ? in / frame_bytes_ : frames;
+    const size_t   take = header_.channels;
+    const uint8_t* ring = ring_;
+    const size_t   mask = mask_;
+    size_t         p    = t;
+    for(size_t i = 0; i < n; i++)
+    {
+        for(size_t c = 0; c < take; c++)
+        {
+            const uint32_t u = ring[p & mask]
+                               | (uint32_t(ring[(p + 1) & mask]) << 8)
+                               | (uint32_t(ring[(p + 2) & mask]) << 16);
+            if(c < channels)
+                out[c][i] = static_cast<float>(static_cast<int32_t>(u << 8) >> 8)
+                            * (1.f / 8388608.f);
+            p += SdRecorder::kBytesPerSample;
+        }
+    }
+    for(size_t c = 0; c < channels; c++)
+    {
+        for(size_t i = (c < take ? n : 0); i < frames; i++)
+            out[c][i] = 0.f;
+    }
+    tail_     = p;
+    consumed_ = consumed_ + (p - t);
+}
+
+#endif // HAL_SD_MODULE_ENABLED
@@ -0,0 +1,264 @@
+#pragma once
+#ifndef DSY_SD_STREAM_H
+#define DSY_SD_STREAM_H
+#include "sd_card.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(HAL_SD_MODULE_ENABLED)
+
+namespace daisy
+{
+/** On-card layout of a take written by SdRecorder.
+
+    No file system: a take is a run of raw blocks from its first LBA.
+    That block holds this header (little-endian, zero padded to 512
+    bytes); the samples follow from the next block on, packed 24-bit
+    little-endian, channels interleaved, the last block zero padded.
+    scripts/sd_take.py turns a take on a card (or an image of one) into
+    a WAV file.
+
+    frames is rewritten as the take grows, so a take cut short by a
+    power loss still reads back up to its last header update; closed is
+    set once Stop() has flushed everything.
+*/
+struct SdTakeHeader
+{
+    static constexpr uint32_t kMagic   = 0x4b415444; // "DTAK"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t bits;     // per sample, 24
+    uint32_t data_lba; // first sample block
+    uint64_t frames;
+    uint32_t closed;
+};
+
+/** Streams multichannel audio to the SD card, in the background.
+
+    The audio callback hands each block to Process(), which packs it to
+    24 bits into a large ring in SDRAM and returns; Service(), called
+    from loop() or a TaskRunner task, writes the ring out to the card a
+    64 KB chunk at a time by SdCard's DMA. The ring is what rides out a
+    card's programming stalls: 4 channels at 96 kHz are 1.152 MB/s, so
+    a 4 MB ring covers 3.6 s of stall or starved loop().
+
+    Should the ring fill up anyway, Process() drops whole blocks (never
+    a part of one, which would shift the channels) and counts them in
+    GetOverruns(); the take is then shorter than the time it ran.
+
+    Process() from the audio callback only, everything else from one
+    lower context. The ring is the caller's: SDRAM (AXI SRAM would do),
+    32-byte aligned, a power of two and at least two chunks.
+*/
+class SdRecorder
+{
+  public:
+    static constexpr size_t   kChunkBlocks = 128;
+    static constexpr size_t   kChunkBytes  = kChunkBlocks * SdCard::kBlockSize;
+    static constexpr size_t   kMaxChannels = 8;
+    static constexpr size_t   kBytesPerSample = 3;
+    static constexpr uint32_t kHeaderEvery = 16; // chunks: ~1 MB
+    static constexpr uint32_t kMaxRetries  = 3;
+
+    enum class State
+    {
+        IDLE,
+        RECORDING,
+        STOPPING, /**< Stop() called or the card full: flushing */
+        FAILED,   /**< the card kept failing; the take is as far as it got */
+    };
+
+    SdRecorder()
+    : card_(nullptr),
+      state_(State::IDLE),
+      frame_bytes_(kBytesPerSample),
+      frames_(0),
+      written_(0),
+      overruns_(0),
+      op_(Op::NONE)
+    {
+    }
+    ~SdRecorder() {}
+
+    /** \return false if the ring does not meet the requirements above */
+    bool Init(SdCard* card, uint8_t* ring, size_t ring_bytes);
+
+    /** Starts a take at lba: writes its header, blocking, and arms
+        Process(). Anything still on the card past lba is overwritten.
+        \return false if not idle, channels is out of range, or the
+        header write failed
+    */
+    bool Start(uint32_t lba, uint32_t sample_rate, size_t channels);
+
+    /** Stops taking blocks; Service() flushes the rest and closes the
+        take, after which the state is IDLE.
+    */
+    void Stop();
+
+    /** Audio callback: queues frames of channels channels, in[c][i] */
+    void Process(const float* const* in, size_t frames);
+
+    /** Moves a chunk to the card when one is ready; returns at once */
+    void Service();
+
+    inline State GetState() const { return state_; }
+    inline bool  IsRecording() const { return state_ == State::RECORDING; }
+
+    /** \return frames queued since Start() */
+    inline uint64_t GetFrames() const { return frames_; }
+
+    /** \return frames on the card */
+    inline uint64_t GetFramesWritten() const
+    {
+        return written_ / frame_bytes_;
+    }
+
+    /** \return blocks dropped for a full ring since Start() */
+    inline uint32_t GetOverruns() const { return overruns_; }
+
+    /** \return the ring's fill, now and at most since Start(), 0 to 1 */
+    float GetFill() const;
+    float GetMaxFill() const;
+
+    /** \return the first block past the take, e.g. for the next one */
+    inline uint32_t GetEndLba() const { return next_lba_; }
+
+  private:
+    enum class Op
+    {
+        NONE,
+        CHUNK,
+        TAIL,
+        HEADER,
+        CLOSE,
+    };
+
+    /** Fills the header block from the take so far */
+    void MakeHeader(bool closed);
+    /** Starts the next transfer the ring calls for, if any */
+    void StartNext();
+    /** Starts the transfer of op_ (again) */
+    bool Issue();
+    /** Makes op the one in hand and starts it */
+    void Begin(Op op);
+
+    SdCard*           card_;
+    uint8_t*          ring_;
+    size_t            ring_bytes_, mask_;
+    volatile State    state_;
+    size_t            channels_, frame_bytes_;
+    uint32_t          sample_rate_;
+    uint32_t          take_lba_, next_lba_;
+    volatile size_t   head_, tail_; // free-running byte counts
+    size_t            max_used_;
+    volatile uint64_t frames_;
+    uint64_t          written_;   // sample bytes on the card
+    volatile uint32_t overruns_;
+    uint32_t          since_header_;
+    Op                op_;
+    bool              issued_;    // op_'s transfer is on the card
+    size_t            op_bytes_;  // of a CHUNK or TAIL, valid ones
+    uint32_t          retries_;
+};
+
+/** Plays a take written by SdRecorder back, read ahead in the background.
+
+    Service(), from loop() or a task, keeps the SDRAM ring topped up a
+    chunk at a time; Process() in the audio callback unpacks from it.
+    After Start(), Process() gives silence until the ring is half full
+    (or the whole take is in), so playback begins with half a ring of
+    slack. A block the ring cannot cover is silence too, counted in
+    GetUnderruns(); playback then catches up with what is read next.
+    The take plays once; IsFinished() after its last frame.
+
+    Same contexts and ring requirements as SdRecorder.
+*/
+class SdPlayer
+{
+  public:
+    static constexpr size_t   kChunkBlocks = SdRecorder::kChunkBlocks;
+    static constexpr size_t   kChunkBytes  = SdRecorder::kChunkBytes;
+    static constexpr uint32_t kMaxRetries  = SdRecorder::kMaxRetries;
+
+    SdPlayer()
+    : card_(nullptr),
+      header_(),
+      open_(false),
+      playing_(false),
+      primed_(false),
+      failed_(false),
+      frame_bytes_(SdRecorder::kBytesPerSample),
+      data_bytes_(0),
+      consumed_(0),
+      underruns_(0)
+    {
+    }
+    ~SdPlayer() {}
+
+    /** \return false if the ring does not meet the requirements */
+    bool Init(SdCard* card, uint8_t* ring, size_t ring_bytes);
+
+    /** Reads the header of the take at lba, blocking.
+        \return false if there is no take there or it cannot be read
+    */
+    bool Open(uint32_t lba);
+
+    /** Starts reading ahead from the take's first frame */
+    bool Start();
+
+    /** Stops; Process() gives silence */
+    void Stop();
+
+    /** Reads the next chunk when the ring has room; returns at once */
+    void Service();
+
+    /** Audio callback: the take's first channels channels into out[c],
+        silence in any past the take's
+    */
+    void Process(float* const* out, size_t channels, size_t frames);
+
+    inline uint32_t GetSampleRate() const { return header_.sample_rate; }
+    inline size_t   GetChannels() const { return header_.channels; }
+    inline uint64_t GetFrames() const { return header_.frames; }
+
+    /** \return frames played since Start() */
+    inline uint64_t GetPosition() const { return consumed_ / frame_bytes_; }
+
+    /** \return blocks played as silence for an empty ring */
+    inline uint32_t GetUnderruns() const { return underruns_; }
+
+    /** \return the card kept failing */
+    inline bool IsFailed() const { return failed_; }
+
+    /** \return past the take's last frame */
+    inline bool IsFinished() const { return open_ && consumed_ >= data_bytes_; }
+
+    inline bool IsPlaying() const { return playing_ && primed_; }
+
+  private:
+    void StartNext();
+
+    SdCard*           card_;
+    uint8_t*          ring_;
+    size_t            ring_bytes_, mask_;
+    SdTakeHeader      header_;
+    bool              open_;
+    volatile bool     playing_, primed_;
+    bool              failed_, reading_;
+    size_t            frame_bytes_;
+    uint64_t          data_bytes_;
+    uint32_t          read_lba_, end_lba_;
+    uint32_t          read_blocks_;
+    volatile size_t   head_, tail_; // free-running byte counts
+    volatile uint64_t consumed_;
+    volatile uint32_t underruns_;
+    uint32_t          retries_;
+};
+
+} // namespace daisy
+#endif // HAL_SD_MODULE_ENABLED
+#endif
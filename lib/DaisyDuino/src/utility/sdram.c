@@ -5,7 +5,6 @@
 
 // TODO:
 // - Consider alternative to libdaisy.h inclusion for board specific details.
-// - Optimize Timing Variables, etc. for Maximum Speed.
 
 // For now all configuration is done specifically for
 //    the AS4C16M32MSA-6BIN 64MB SDRAM from Alliance Memory.
@@ -15,6 +14,12 @@
 // tAC(3) - Access time from Clk (max.) 5.5ns
 // tRAS	  - Row Active time (min.) 48ns
 // tRC    - Row Cycle time (min.) 60ns
+// tRCD   - Active to Read/Write (min.) 18ns
+// tRP    - Precharge to Active (min.) 18ns
+// tXSR   - Exit Self Refresh to Active (min.) 72ns
+// tWR    - Write Recovery (min.) 2 clocks
+// tMRD   - Load Mode Register to Active (min.) 2 clocks
+// tREF   - 8192 rows in 64ms, one every 7.8125us
 
 // 166MHz = 6.024ns
 // RAS = 8 ticks at 166
@@ -42,10 +47,32 @@ typedef struct
 
 static dsy_sdram_t dsy_sdram;
 
+// Clock-to-precharge wait (Step 4). The device needs 200us of stable
+// clock; 100 ms is the original margin. With DSY_FAST_BOOT it is two
+// SysTick periods, so at least 1 ms.
+#if defined(DSY_FAST_BOOT)
+#define SDRAM_POWER_UP_MS 2
+#else
+#define SDRAM_POWER_UP_MS 100
+#endif
+
+static uint32_t sdram_clock_tick;
+static uint32_t sdram_refresh_count;
+
 static uint8_t sdram_periph_init();
-static uint8_t sdram_device_init();
+static uint8_t sdram_device_start();
+static uint8_t sdram_device_finish();
 
 uint8_t dsy_sdram_init(dsy_sdram_handle *dsy_hsdram)
+{
+    if(dsy_sdram_init_start(dsy_hsdram) != DSY_SDRAM_OK)
+    {
+        return DSY_SDRAM_ERR;
+    }
+    return dsy_sdram_init_finish();
+}
+
+uint8_t dsy_sdram_init_start(dsy_sdram_handle *dsy_hsdram)
 {
     //dsy_sdram.board = board;
     dsy_sdram.dsy_hsdram = dsy_hsdram;
@@ -55,7 +82,7 @@ uint8_t dsy_sdram_init(dsy_sdram_handle *dsy_hsdram)
         {
             return DSY_SDRAM_ERR;
         }
-        if(sdram_device_init() != DSY_SDRAM_OK)
+        if(sdram_device_start() != DSY_SDRAM_OK)
         {
             return DSY_SDRAM_ERR;
         }
@@ -63,6 +90,70 @@ uint8_t dsy_sdram_init(dsy_sdram_handle *dsy_hsdram)
     return DSY_SDRAM_OK;
 }
 
+uint8_t dsy_sdram_init_finish(void)
+{
+    if(dsy_sdram.dsy_hsdram != NULL
+       && dsy_sdram.dsy_hsdram->state == DSY_SDRAM_STATE_ENABLE)
+    {
+        return sdram_device_finish();
+    }
+    return DSY_SDRAM_OK;
+}
+
+uint32_t dsy_sdram_get_clock(void)
+{
+    PLL1_ClocksTypeDef pll1;
+    PLL2_ClocksTypeDef pll2;
+    uint32_t           ker_ck;
+    switch(__HAL_RCC_GET_FMC_SOURCE())
+    {
+        case RCC_FMCCLKSOURCE_D1HCLK: ker_ck = HAL_RCC_GetHCLKFreq(); break;
+        case RCC_FMCCLKSOURCE_PLL:
+            HAL_RCCEx_GetPLL1ClockFreq(&pll1);
+            ker_ck = pll1.PLL1_Q_Frequency;
+            break;
+        case RCC_FMCCLKSOURCE_PLL2:
+            HAL_RCCEx_GetPLL2ClockFreq(&pll2);
+            ker_ck = pll2.PLL2_R_Frequency;
+            break;
+        // per_ck, on the undivided HSI out of reset
+        default: ker_ck = HSI_VALUE; break;
+    }
+    return ker_ck / 2;
+}
+
+// Whole SDCLK periods covering ns, in the FMC's 1 to 16 range.
+static uint32_t sdram_cycles(uint32_t ns, uint32_t clk_khz)
+{
+    uint32_t c = (ns * clk_khz + 999999) / 1000000;
+    return c < 1 ? 1 : (c > 16 ? 16 : c);
+}
+
+static void sdram_datasheet_timing(FMC_SDRAM_TimingTypeDef *t)
+{
+    const uint32_t khz = dsy_sdram_get_clock() / 1000;
+
+    t->LoadToActiveDelay    = 2;
+    t->ExitSelfRefreshDelay = sdram_cycles(72, khz);
+    t->SelfRefreshTime      = sdram_cycles(48, khz);
+    t->RowCycleDelay        = sdram_cycles(60, khz);
+    t->RPDelay              = sdram_cycles(18, khz);
+    t->RCDDelay             = sdram_cycles(18, khz);
+
+    // The FMC needs TWR >= TRAS - TRCD and TWR >= TRC - TRCD - TRP.
+    t->WriteRecoveryTime = 2;
+    if(t->SelfRefreshTime - t->RCDDelay > t->WriteRecoveryTime)
+        t->WriteRecoveryTime = t->SelfRefreshTime - t->RCDDelay;
+    if(t->RowCycleDelay - t->RCDDelay - t->RPDelay > t->WriteRecoveryTime)
+        t->WriteRecoveryTime = t->RowCycleDelay - t->RCDDelay - t->RPDelay;
+
+    // Read data arrives late relative to a fast SDCLK.
+    dsy_sdram.hsdram.Init.ReadPipeDelay = khz > 100000
+                                              ? FMC_SDRAM_RPIPE_DELAY_1
+                                              : FMC_SDRAM_RPIPE_DELAY_0;
+    sdram_refresh_count = khz * 781 / 100000 - 20;
+}
+
 static uint8_t sdram_periph_init()
 {
     FMC_SDRAM_TimingTypeDef SdramTiming = {0};
@@ -93,6 +184,14 @@ static uint8_t sdram_periph_init()
     //	SdramTiming.WriteRecoveryTime = 16;
     //	SdramTiming.RPDelay = 16;
     //	SdramTiming.RCDDelay = 16;
+    sdram_refresh_count = 0x81A - 20;
+
+    // RPDelay 0 above wraps to the 16-cycle maximum in SDTR1, and the
+    // wrap takes TRCD up to 16 as well; LEGACY keeps that as it shipped.
+    if(dsy_sdram.dsy_hsdram->timing == DSY_SDRAM_TIMING_DATASHEET)
+    {
+        sdram_datasheet_timing(&SdramTiming);
+    }
 
     if(HAL_SDRAM_Init(&dsy_sdram.hsdram, &SdramTiming) != HAL_OK)
     {
@@ -102,11 +201,10 @@ static uint8_t sdram_periph_init()
     return DSY_SDRAM_OK;
 }
 // For now this is
-static uint8_t sdram_device_init()
+static uint8_t sdram_device_start()
 {
     FMC_SDRAM_CommandTypeDef Command;
 
-    __IO uint32_t tmpmrd = 0;
     /* Step 3:  Configure a clock configuration enable command */
     Command.CommandMode            = FMC_SDRAM_CMD_CLK_ENABLE;
     Command.CommandTarget          = FMC_SDRAM_CMD_TARGET_BANK1;
@@ -116,9 +214,18 @@ static uint8_t sdram_device_init()
     /* Send the command */
     HAL_SDRAM_SendCommand(&dsy_sdram.hsdram, &Command, 0x1000);
 
-    /* Step 4: Insert 100 ms delay */
-    HAL_Delay(100);
+    sdram_clock_tick = HAL_GetTick();
+    return DSY_SDRAM_OK;
+}
+
+static uint8_t sdram_device_finish()
+{
+    FMC_SDRAM_CommandTypeDef Command;
+
+    __IO uint32_t tmpmrd = 0;
 
+    /* Step 4: Wait out the power-up time, less whatever ran since Step 3 */
+    while(HAL_GetTick() - sdram_clock_tick < SDRAM_POWER_UP_MS) {}
 
     /* Step 5: Configure a PALL (precharge all) command */
     Command.CommandMode            = FMC_SDRAM_CMD_PALL;
@@ -153,7 +260,7 @@ static uint8_t sdram_device_init()
     HAL_SDRAM_SendCommand(&dsy_sdram.hsdram, &Command, 0x1000);
 
     //HAL_SDRAM_ProgramRefreshRate(hsdram, 0x56A - 20);
-    HAL_SDRAM_ProgramRefreshRate(&dsy_sdram.hsdram, 0x81A - 20);
+    HAL_SDRAM_ProgramRefreshRate(&dsy_sdram.hsdram, sdram_refresh_count);
     return DSY_SDRAM_OK;
 }
 
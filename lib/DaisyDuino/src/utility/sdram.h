@@ -115,16 +115,41 @@ extern "C"
     } dsy_sdram_pin;
 
 
+    /** FMC timing profile.
+        LEGACY is the original hand-tuned set, kept as the default.
+        DATASHEET derives every delay from the AS4C16M32MSA-6 figures at
+        the SDRAM clock the FMC actually gets (see dsy_sdram_get_clock()),
+        so it follows the System clock profile, and refreshes every
+        7.8us as 8192 rows in 64ms require. */
+    typedef enum
+    {
+        DSY_SDRAM_TIMING_LEGACY,    /**< & */
+        DSY_SDRAM_TIMING_DATASHEET, /**< & */
+        DSY_SDRAM_TIMING_LAST,      /**< & */
+    } dsy_sdram_timing;
+
     /** Configuration struct for passing to initialization */
     typedef struct
     {
-        dsy_sdram_state state;                          /**< & */
-        dsy_gpio_pin    pin_config[DSY_SDRAM_PIN_LAST]; /**< & */
+        dsy_sdram_state  state;                          /**< & */
+        dsy_gpio_pin     pin_config[DSY_SDRAM_PIN_LAST]; /**< & */
+        dsy_sdram_timing timing;                         /**< & */
     } dsy_sdram_handle;
 
     /** Initializes the SDRAM peripheral */
     uint8_t dsy_sdram_init(dsy_sdram_handle *dsy_hsdram);
 
+    /** dsy_sdram_init() in two halves, so other setup can run through the
+        device's power-up wait: start sets up the FMC and starts the SDRAM
+        clock, finish waits out what is left of the power-up time and
+        programs the device. SDRAM is usable after finish. */
+    uint8_t dsy_sdram_init_start(dsy_sdram_handle *dsy_hsdram);
+    uint8_t dsy_sdram_init_finish(void);
+
+    /** \return SDCLK in Hz: the FMC kernel clock over the SDClockPeriod
+        of 2. 100MHz from PLL2R under System's clock profiles. */
+    uint32_t dsy_sdram_get_clock(void);
+
 #ifdef __cplusplus
 }
 #endif
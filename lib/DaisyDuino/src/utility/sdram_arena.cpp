@@ -0,0 +1,43 @@
+#include "sdram_arena.h"
+#include <string.h>
+
+using namespace daisy;
+
+void SdramArena::Init(void* mem, size_t size)
+{
+    base_       = reinterpret_cast<uintptr_t>(mem);
+    size_       = mem ? size : 0;
+    top_        = 0;
+    high_water_ = 0;
+    failed_     = 0;
+}
+
+void* SdramArena::Allocate(size_t bytes, size_t align)
+{
+    align = align < 4 ? 4 : align;
+    if((align & (align - 1)) != 0 || bytes == 0)
+    {
+        failed_++;
+        return nullptr;
+    }
+
+    // Aligned on the address, not the offset: mem need not be aligned.
+    const uintptr_t start
+        = (base_ + top_ + (align - 1)) & ~static_cast<uintptr_t>(align - 1);
+    const size_t offset = start - base_;
+    if(offset > size_ || bytes > size_ - offset)
+    {
+        failed_++;
+        return nullptr;
+    }
+
+    top_ = offset + bytes;
+    if(top_ > high_water_)
+        high_water_ = top_;
+    return reinterpret_cast<void*>(start);
+}
+
+void SdramArena::Clear(void* p, size_t bytes)
+{
+    memset(p, 0, bytes);
+}
@@ -0,0 +1,179 @@
+#pragma once
+#ifndef DSY_SDRAM_ARENA_H
+#define DSY_SDRAM_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+
+namespace daisy
+{
+/** Bump allocator over a block of SDRAM, for buffers sized at runtime.
+    MemPools runs one over each of the other memories as well.
+
+    Takes one large DSY_SDRAM_BSS array and hands out pieces of it from
+    the bottom up. Nothing is freed one at a time: Mark() remembers the
+    top, Release() drops everything allocated since, and Reset() drops it
+    all. That fits patch and mode switches, where one mode's delay lines
+    and loopers go away together and the next mode's take their place.
+
+    Each allocation starts on a 32-byte boundary by default: one M7 cache
+    line, so cache maintenance on a buffer touches nothing else, and a
+    multiple of the 16-byte SDRAM burst (four 32-bit words).
+
+    GetHighWater() reports the most that was ever in use, to size the
+    block from a run through every mode.
+
+    From the main loop only, and stop using a region (audio running over
+    it included) before releasing it. Objects made with New() do not have
+    their destructors run.
+
+    usage example:
+
+    static uint8_t DSY_SDRAM_BSS sdram_pool[32 * 1024 * 1024];
+    SdramArena arena;
+    arena.Init(sdram_pool, sizeof(sdram_pool));
+    SdramArena::Marker modes = arena.Mark();
+    ...
+    // On a mode switch, with the audio stopped or off the old buffers:
+    arena.Release(modes);
+    size_t n   = seconds * sample_rate;
+    float *buf = arena.Allocate<float>(n);
+    if(buf)
+        looper.Init(buf, n);
+    float *ap = arena.AllocateCleared<float>(m);
+    allpass.Init(sample_rate, ap, m);
+    fir.SetStateBuffer(arena.Allocate<float>(taps + block - 1),
+                       taps + block - 1);
+    auto *del = arena.New<DelayLine<float, 96000>>();
+    auto *rev = arena.NewCleared<ReverbSc>();
+    rev->Init(sample_rate, ZeroedMemory());
+*/
+class SdramArena
+{
+  public:
+    /** Cache line, and a whole number of SDRAM bursts */
+    static constexpr size_t kDefaultAlign = 32;
+
+    /** A top of the arena, from Mark() */
+    typedef size_t Marker;
+
+    /** Releases what was allocated in its lifetime when it goes out of
+        scope. */
+    class Scope
+    {
+      public:
+        explicit Scope(SdramArena& arena) : arena_(arena), mark_(arena.Mark())
+        {
+        }
+        ~Scope() { arena_.Release(mark_); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+      private:
+        SdramArena& arena_;
+        Marker      mark_;
+    };
+
+    SdramArena() : base_(0), size_(0), top_(0), high_water_(0), failed_(0) {}
+    ~SdramArena() {}
+
+    /** \param mem Block to allocate from, e.g. a DSY_SDRAM_BSS array
+        \param size Bytes at mem
+    */
+    void Init(void* mem, size_t size);
+
+    /** \param bytes Size of the allocation
+        \param align Power of two, at least 4
+        \return Uninitialised memory, or nullptr if it does not fit
+    */
+    void* Allocate(size_t bytes, size_t align = kDefaultAlign);
+
+    /** As above, for count Ts, uninitialised */
+    template <typename T>
+    T* Allocate(size_t count, size_t align = kDefaultAlign)
+    {
+        return count > SIZE_MAX / sizeof(T)
+                   ? nullptr
+                   : static_cast<T*>(Allocate(count * sizeof(T), align));
+    }
+
+    /** count Ts, zeroed: for Allpass and Comb, which do not clear their
+        buffers. Clearing megabytes of SDRAM takes milliseconds. */
+    template <typename T>
+    T* AllocateCleared(size_t count, size_t align = kDefaultAlign)
+    {
+        T* p = Allocate<T>(count, align);
+        if(p)
+            Clear(p, count * sizeof(T));
+        return p;
+    }
+
+    /** Constructs a T in the arena, e.g. a DelayLine
+        \return nullptr if it does not fit
+    */
+    template <typename T, typename... Args>
+    T* New(Args&&... args)
+    {
+        const size_t align = alignof(T) > kDefaultAlign ? alignof(T)
+                                                        : kDefaultAlign;
+        void* p = Allocate(sizeof(T), align);
+        return p ? new(p) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    /** As New(), on memory cleared first, so the object's Init() can
+        skip clearing it again: the DaisySP Init(ZeroedMemory) overloads.
+        \return nullptr if it does not fit
+    */
+    template <typename T, typename... Args>
+    T* NewCleared(Args&&... args)
+    {
+        const size_t align = alignof(T) > kDefaultAlign ? alignof(T)
+                                                        : kDefaultAlign;
+        void* p = Allocate(sizeof(T), align);
+        if(!p)
+            return nullptr;
+        Clear(p, sizeof(T));
+        return new(p) T(std::forward<Args>(args)...);
+    }
+
+    /** \return the current top, for Release() */
+    inline Marker Mark() const { return top_; }
+
+    /** Drops everything allocated since mark */
+    inline void Release(Marker mark)
+    {
+        if(mark < top_)
+            top_ = mark;
+    }
+
+    /** Drops every allocation; the high-water mark stays */
+    inline void Reset() { top_ = 0; }
+
+    /** \return bytes in use now, alignment padding included */
+    inline size_t GetUsed() const { return top_; }
+    /** \return bytes left, before any alignment */
+    inline size_t GetFree() const { return size_ - top_; }
+    /** \return the block from Init() */
+    inline void* GetBase() const { return reinterpret_cast<void*>(base_); }
+    /** \return bytes the arena was given */
+    inline size_t GetCapacity() const { return size_; }
+    /** \return the most bytes ever in use at once */
+    inline size_t GetHighWater() const { return high_water_; }
+    /** \return allocations that did not fit */
+    inline size_t GetFailedAllocations() const { return failed_; }
+
+  private:
+    static void Clear(void* p, size_t bytes);
+
+    uintptr_t base_;
+    size_t    size_;
+    size_t    top_;
+    size_t    high_water_;
+    size_t    failed_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,228 @@
+#include "sdram_fill.h"
+#include <string.h>
+#include "daisy_core.h"
+#include "sys_mpu.h"
+
+using namespace daisy;
+
+static const size_t kMdmaChannels = 16;
+
+// BNDT counts up to 64 kB per block, BRC up to 4096 blocks per leg.
+static const uint32_t kMaxBlock  = 65536;
+static const uint32_t kMaxBlocks = 4096;
+
+static const uint32_t kMdmaClearAll = MDMA_CIFCR_CTEIF | MDMA_CIFCR_CCTCIF
+                                      | MDMA_CIFCR_CBRTIF | MDMA_CIFCR_CBTIF
+                                      | MDMA_CIFCR_CLTCIF;
+
+// The MDMA reads the fill word over AHBS: DTCM is uncached, so it always
+// sees what StartLeg() wrote.
+static uint32_t DTCM_MEM_SECTION fill_words[kMdmaChannels];
+
+// Past the 16 kB D-cache, cleaning the whole cache by set and way is
+// cheaper than walking megabytes by address, and just as safe.
+static void Flush(const void* p, uint32_t bytes)
+{
+    if(bytes > 16 * 1024 && (SCB->CCR & SCB_CCR_DC_Msk) != 0)
+        SCB_CleanInvalidateDCache();
+    else
+        dsy_dcache_clean_invalidate(p, bytes);
+}
+
+void SdramFill::Init(size_t channel)
+{
+    if(channel >= kMdmaChannels)
+        return;
+    __HAL_RCC_MDMA_CLK_ENABLE();
+    channel_ = channel;
+    ch_      = (MDMA_Channel_TypeDef*)(MDMA_Channel0_BASE
+                                  + channel
+                                        * (MDMA_Channel1_BASE
+                                           - MDMA_Channel0_BASE));
+    ch_->CCR   = 0;
+    ch_->CIFCR = kMdmaClearAll;
+    head_ = tail_ = 0;
+    leg_offset_   = 0;
+}
+
+SdramFill::Ticket SdramFill::Queue(void* dst, size_t bytes, uint32_t value)
+{
+    const uint32_t addr = (uint32_t)dst;
+    const size_t   next = (tail_ + 1) % kMaxQueued;
+    if(ch_ == nullptr || (addr & 3) != 0 || (bytes & 3) != 0 || bytes == 0
+       || next == head_)
+    {
+        return 0;
+    }
+
+    // Whatever the cache holds of the region is dead: written back now,
+    // it cannot land on top of the fill later.
+    Flush(dst, bytes);
+
+    Region& r = queue_[tail_];
+    r.addr    = addr;
+    r.bytes   = bytes;
+    r.value   = value;
+    r.ticket  = ++next_;
+    if(r.ticket == 0) // 0 is never ready
+        r.ticket = ++next_;
+    tail_ = next;
+
+    Process();
+    return r.ticket;
+}
+
+bool SdramFill::Process()
+{
+    while(ch_ != nullptr && head_ != tail_)
+    {
+        // EN drops at the end of the transfer, or on a bus error.
+        if(ch_->CCR & MDMA_CCR_EN)
+            return false;
+
+        Region& r = queue_[head_];
+        if(ch_->CISR & MDMA_CISR_TEIF)
+        {
+            // The leg may be partly written; finish the region on the CPU
+            // rather than leave a ticket that never comes ready.
+            ch_->CIFCR = kMdmaClearAll;
+            uint32_t* p = (uint32_t*)r.addr;
+            for(size_t i = 0; i < r.bytes / 4; i++)
+                p[i] = r.value;
+            leg_offset_ = r.bytes;
+        }
+
+        if(leg_offset_ < r.bytes)
+        {
+            StartLeg();
+            return false;
+        }
+
+        // Lines the core fetched speculatively while the MDMA ran.
+        Flush((const void*)r.addr, r.bytes);
+        leg_offset_ = 0;
+        done_       = r.ticket;
+        head_       = (head_ + 1) % kMaxQueued;
+    }
+    return head_ == tail_;
+}
+
+void SdramFill::FillBlocking(void* dst, size_t bytes, uint32_t value)
+{
+    const Ticket t = Queue(dst, bytes, value);
+    if(t == 0)
+    {
+        // Not queueable; the CPU does it.
+        if(((uint32_t)dst & 3) == 0 && (bytes & 3) == 0)
+        {
+            uint32_t* p = (uint32_t*)dst;
+            for(size_t i = 0; i < bytes / 4; i++)
+                p[i] = value;
+        }
+        else if(value == 0)
+        {
+            memset(dst, 0, bytes);
+        }
+        return;
+    }
+    while(!IsReady(t))
+        Process();
+}
+
+void SdramFill::StartLeg()
+{
+    const Region&  r    = queue_[head_];
+    const uint32_t left = r.bytes - leg_offset_;
+    uint32_t       block, blocks;
+    if(left >= kMaxBlock)
+    {
+        block  = kMaxBlock;
+        blocks = left / kMaxBlock > kMaxBlocks ? kMaxBlocks : left / kMaxBlock;
+    }
+    else
+    {
+        block  = left;
+        blocks = 1;
+    }
+
+    fill_words[channel_] = r.value;
+
+    // One fixed source word, destination bursts of 16 words, every block
+    // of the leg off a single software request.
+    ch_->CIFCR  = kMdmaClearAll;
+    ch_->CTCR   = MDMA_SRC_INC_DISABLE | MDMA_DEST_INC_WORD
+                | MDMA_SRC_DATASIZE_WORD | MDMA_DEST_DATASIZE_WORD
+                | MDMA_DEST_BURST_16BEATS | ((128U - 1U) << MDMA_CTCR_TLEN_Pos)
+                | MDMA_FULL_TRANSFER | MDMA_CTCR_SWRM;
+    ch_->CBNDTR = block | ((blocks - 1U) << MDMA_CBNDTR_BRC_Pos);
+    ch_->CSAR   = (uint32_t)&fill_words[channel_];
+    ch_->CDAR   = r.addr + leg_offset_;
+    ch_->CBRUR  = 0;
+    ch_->CLAR   = 0;
+    ch_->CTBR   = MDMA_CTBR_SBUS;
+    ch_->CMAR   = 0;
+    ch_->CMDR   = 0;
+    leg_offset_ += block * blocks;
+
+    // Below the SAI channels, so the audio's transfers go first.
+    __DSB();
+    ch_->CCR = MDMA_PRIORITY_LOW | MDMA_CCR_EN;
+    ch_->CCR |= MDMA_CCR_SWRQ;
+}
+
+// Each word goes to the SDRAM and comes back from it, not the cache.
+static void Put(volatile uint32_t* p, uint32_t v)
+{
+    *p = v;
+    dsy_dcache_clean_invalidate((const void*)p, 4);
+}
+
+static uint32_t Get(volatile uint32_t* p)
+{
+    dsy_dcache_clean_invalidate((const void*)p, 4);
+    return *p;
+}
+
+bool SdramFill::QuickTest(void* base, size_t bytes)
+{
+    volatile uint32_t* p     = (volatile uint32_t*)base;
+    const size_t       words = bytes / 4;
+    if(((uint32_t)base & 3) != 0 || words == 0)
+        return false;
+
+    // Data lines: a walking one at one address.
+    for(uint32_t bit = 1; bit != 0; bit <<= 1)
+    {
+        Put(p, bit);
+        if(Get(p) != bit)
+            return false;
+    }
+
+    // Address lines: the pattern at every power-of-two offset, then the
+    // inverse at each one in turn; a stuck or shorted line aliases two
+    // of the offsets.
+    const uint32_t pattern = 0xAAAAAAAA, inverse = 0x55555555;
+    for(size_t off = 1; off < words; off <<= 1)
+        Put(p + off, pattern);
+    Put(p, inverse);
+    for(size_t off = 1; off < words; off <<= 1)
+    {
+        if(Get(p + off) != pattern)
+            return false;
+    }
+
+    Put(p, pattern);
+    for(size_t test = 1; test < words; test <<= 1)
+    {
+        Put(p + test, inverse);
+        if(Get(p) != pattern)
+            return false;
+        for(size_t off = 1; off < words; off <<= 1)
+        {
+            if(off != test && Get(p + off) != pattern)
+                return false;
+        }
+        Put(p + test, pattern);
+    }
+    return true;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#ifndef DSY_SDRAM_FILL_H
+#define DSY_SDRAM_FILL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** Clears (or fills) large SDRAM buffers with the MDMA, while the CPU
+    gets on with boot and the audio.
+
+    Clearing a few megabytes of delay memory on the CPU takes tens to
+    hundreds of milliseconds. Queue() hands a region to the MDMA instead
+    and returns a ticket; Process() from loop() starts each queued region
+    as the one before finishes, and IsReady(ticket) tells the audio
+    callback when a region is usable. Until then the module on it stays
+    muted and untouched:
+
+    A DelayLine (or MultiTapDelay, InterleavedDelay) that is all zero
+    bytes is a valid cleared line, so queue the whole object instead of
+    calling its Init(), and SetDelay() once it is ready.
+
+    Runs polled on one MDMA channel, with no interrupt. The channel must
+    not be one a SaiMdma uses. Cache maintenance is done here: do not
+    read or write a region before it is ready.
+
+    QuickTest() checks the SDRAM's data and address lines in well under
+    a millisecond, for a boot-time self-test.
+
+    usage example:
+
+    static DelayLine<float, 48000 * 8> DSY_SDRAM_BSS big_delay;
+    SdramFill fill;
+    SdramFill::Ticket delay_ready;
+
+    void AudioCallback(float **in, float **out, size_t size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            float wet = 0.f;
+            if(fill.IsReady(delay_ready))
+            {
+                wet = big_delay.Read();
+                big_delay.Write(in[0][i] + wet * 0.5f);
+            }
+            out[0][i] = out[1][i] = in[0][i] + wet;
+        }
+    }
+
+    void setup()
+    {
+        DAISY.init(DAISY_SEED, AUDIO_SR_48K);
+        if(!SdramFill::QuickTest(&big_delay, sizeof(big_delay)))
+            ...
+        fill.Init();
+        delay_ready = fill.Queue(&big_delay, sizeof(big_delay));
+        DAISY.begin(AudioCallback);
+    }
+
+    void loop()
+    {
+        fill.Process();
+        if(fill.IsReady(delay_ready) && !delay_set)
+            ... big_delay.SetDelay(48000.f * 4.f) ...
+    }
+*/
+class SdramFill
+{
+  public:
+    /** From Queue(); IsReady() once its region is filled */
+    typedef uint32_t Ticket;
+
+    static constexpr size_t kMaxQueued = 8;
+
+    SdramFill()
+    : ch_(nullptr),
+      channel_(0),
+      head_(0),
+      tail_(0),
+      done_(0),
+      next_(0),
+      leg_offset_(0)
+    {
+    }
+    ~SdramFill() {}
+
+    /** \param channel MDMA channel, 0 to 15, not used by any SaiMdma */
+    void Init(size_t channel = 15);
+
+    /** Queues [dst, dst + bytes) to be filled with value, and starts it
+        if nothing is running.
+        \param dst Word-aligned; best 32-byte aligned, so no cache line
+                   is shared with memory outside the region
+        \param bytes A multiple of 4
+        \return the region's ticket, or 0 (never ready) if the queue is
+                full or the region is misaligned
+    */
+    Ticket Queue(void* dst, size_t bytes, uint32_t value = 0);
+
+    /** Finishes the running region and starts the next. Call from loop().
+        \return true once nothing is left to fill
+    */
+    bool Process();
+
+    /** \return true once the region of ticket is filled. Safe from the
+        audio callback or any interrupt. */
+    inline bool IsReady(Ticket ticket) const
+    {
+        return ticket != 0 && (int32_t)(done_ - ticket) >= 0;
+    }
+
+    /** \return true while a region is still queued or being filled */
+    inline bool Busy() const { return head_ != tail_; }
+
+    /** Queues then waits for a region; a CPU-free memset for setup(). */
+    void FillBlocking(void* dst, size_t bytes, uint32_t value = 0);
+
+    /** Walks a one through every data line at base, then a one through
+        every address line above base, with the cache cleaned and
+        invalidated around each check so the SDRAM is what gets tested.
+        Overwrites what it touches: run it before filling.
+        \param base Start of the region to test, word-aligned
+        \param bytes Size of the region; address lines beyond it are
+                     not tested
+        \return true if every check read back what was written
+    */
+    static bool QuickTest(void* base, size_t bytes);
+
+  private:
+    struct Region
+    {
+        uint32_t addr;
+        uint32_t bytes;
+        uint32_t value;
+        Ticket   ticket;
+    };
+
+    void StartLeg();
+
+    MDMA_Channel_TypeDef* ch_;
+    size_t                channel_;
+    Region                queue_[kMaxQueued];
+    volatile size_t       head_, tail_;
+    volatile Ticket       done_;
+    Ticket                next_;
+    uint32_t              leg_offset_; // bytes of the head region started
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,134 @@
+#include "section_profiler.h"
+#include "cpu_load_meter.h"
+
+#if defined(DSY_PROFILE)
+
+#include <stdio.h>
+
+using namespace daisy;
+
+SectionProfiler daisy::section_profiler;
+
+void SectionProfiler::Init()
+{
+    EnableCycleCounter();
+    depth_       = 0;
+    next_order_  = 0;
+    block_count_ = 0;
+    Reset();
+}
+
+void SectionProfiler::Reset()
+{
+    num_sections_ = 0;
+    blocks_       = 0;
+    dropped_      = 0;
+}
+
+uint32_t SectionProfiler::AverageCycles(const char* name, uint8_t depth) const
+{
+    for(size_t i = 0; i < num_sections_; i++)
+        if(sections_[i].name == name && sections_[i].depth == depth)
+            return blocks_ ? (uint32_t)(sections_[i].total / blocks_) : 0;
+    return 0;
+}
+
+void SectionProfiler::Aggregate()
+{
+    Record r;
+    while(ring_.Pop(r))
+    {
+        if(r.depth == 0)
+            blocks_++;
+        size_t i = 0;
+        while(i < num_sections_
+              && (sections_[i].name != r.name || sections_[i].depth != r.depth))
+            i++;
+        if(i == num_sections_)
+        {
+            if(num_sections_ == kMaxSections)
+                continue;
+            sections_[i] = {r.name, r.depth, r.order, 0, 0, 0};
+            num_sections_++;
+        }
+        Section& s = sections_[i];
+        s.calls++;
+        s.total += r.cycles;
+        s.max = r.cycles > s.max ? r.cycles : s.max;
+    }
+}
+
+void SectionProfiler::Print(::Print& out, uint32_t budget_cycles, bool reset)
+{
+    Aggregate();
+    const uint32_t blocks = blocks_ ? blocks_ : 1;
+    if(budget_cycles == 0)
+        budget_cycles = 1;
+
+    // Rows in the order their sections start, so children follow their
+    // parent as in the code.
+    uint8_t rows[kMaxSections];
+    for(size_t i = 0; i < num_sections_; i++)
+    {
+        size_t j = i;
+        for(; j > 0 && sections_[rows[j - 1]].order > sections_[i].order; j--)
+            rows[j] = rows[j - 1];
+        rows[j] = (uint8_t)i;
+    }
+
+    char line[96];
+    snprintf(line,
+             sizeof(line),
+             "%-24s %9s %9s %9s %9s %7s\r\n",
+             "section",
+             "calls/blk",
+             "avg cyc",
+             "max cyc",
+             "self cyc",
+             "% block");
+    out.print(line);
+    for(size_t k = 0; k < num_sections_; k++)
+    {
+        const Section& s = sections_[rows[k]];
+        // Self: minus the time of the sections directly inside this one.
+        uint64_t inner = 0;
+        for(size_t c = k + 1;
+            c < num_sections_ && sections_[rows[c]].depth > s.depth;
+            c++)
+        {
+            if(sections_[rows[c]].depth == s.depth + 1)
+                inner += sections_[rows[c]].total;
+        }
+        const uint64_t self = s.total > inner ? s.total - inner : 0;
+        const uint32_t avg  = (uint32_t)(s.total / blocks);
+        // Tenths of a percent, integers only: newlib-nano has no %f.
+        const uint32_t share
+            = (uint32_t)((s.total * 1000) / ((uint64_t)blocks * budget_cycles));
+
+        char name[25];
+        snprintf(name, sizeof(name), "%*s%s", 2 * s.depth, "", s.name);
+        snprintf(line,
+                 sizeof(line),
+                 "%-24s %5lu.%02lu %9lu %9lu %9lu %5lu.%lu\r\n",
+                 name,
+                 (unsigned long)(s.calls / blocks),
+                 (unsigned long)((s.calls % blocks) * 100 / blocks),
+                 (unsigned long)avg,
+                 (unsigned long)s.max,
+                 (unsigned long)(self / blocks),
+                 (unsigned long)(share / 10),
+                 (unsigned long)(share % 10));
+        out.print(line);
+    }
+    snprintf(line,
+             sizeof(line),
+             "%lu blocks, budget %lu cycles, %lu records dropped\r\n",
+             (unsigned long)blocks_,
+             (unsigned long)budget_cycles,
+             (unsigned long)dropped_);
+    out.print(line);
+    if(reset)
+        Reset();
+}
+
+#endif // DSY_PROFILE
@@ -0,0 +1,183 @@
+#pragma once
+#ifndef DSY_SECTION_PROFILER_H
+#define DSY_SECTION_PROFILER_H
+
+/** Cycle counts per named section of the audio callback.
+
+    DSY_PROFILE_SCOPE("bandpass") times the rest of the enclosing scope
+    with the DWT cycle counter and hands the count to a ring; loop()
+    drains the ring with section_profiler.Aggregate() and prints a
+    flame-style table with Print(): one row per section, indented under
+    the section it ran in, with calls and average / worst / self cycles
+    per block and the share of the block period.
+
+    Built with -DDSY_PROFILE only. Without it the macro is an empty
+    statement and nothing below is compiled, so scopes can stay in the
+    audio path for good.
+
+    Put one scope at the top of the callback: depth-0 scopes mark the
+    blocks the table averages over. Scopes nest by lexical lifetime, so
+    all of them must run from the one interrupt level (the audio
+    callback); a scope in a preempting interrupt would corrupt the
+    nesting. Each costs two cycle counter reads and a ring push, about
+    20 cycles, which the enclosing sections see as their own time.
+
+    usage:
+
+    DSY_PROFILE_SCOPE("callback");
+    {
+        DSY_PROFILE_SCOPE("filters");
+        ...
+    }
+    ...
+    // loop()
+    section_profiler.Aggregate();
+    if(once a second)
+        section_profiler.Print(Serial, DAISY.CpuLoad().GetPeriodCycles());
+*/
+
+#if defined(DSY_PROFILE)
+
+#include "Arduino.h"
+#include "spsc_ring.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+class SectionProfiler
+{
+  public:
+    /** Distinct (name, depth) rows the table holds */
+    static constexpr size_t kMaxSections = 32;
+
+    /** Records waiting between the callback and Aggregate() */
+    static constexpr size_t kRingSize = 256;
+
+    SectionProfiler() {}
+    ~SectionProfiler() {}
+
+    /** Enables the DWT cycle counter and clears everything */
+    void Init();
+
+    /** From loop(): folds the records waiting in the ring into the
+        table. Call every pass; the ring holds about ten blocks. */
+    void Aggregate();
+
+    /** From loop(): writes the table, as shares of budget_cycles per
+        block, then starts a new window if reset is set */
+    void Print(::Print& out, uint32_t budget_cycles, bool reset = true);
+
+    /** Clears the table and the dropped count */
+    void Reset();
+
+    /** Records lost to a full ring since Reset() */
+    uint32_t Dropped() const { return dropped_; }
+
+    /** Sections of the block whose root scope closed last, in start
+        order, for WcetTracker to keep with its worst block. From the
+        audio callback's level, after the root scope. */
+    struct BlockSection
+    {
+        const char* name;
+        uint32_t    cycles;
+        uint8_t     depth;
+    };
+    static constexpr size_t kBlockSections = 16;
+    const BlockSection*     LastBlock(size_t& count) const
+    {
+        count = block_count_;
+        return block_;
+    }
+
+    /** From loop(): average cycles per block of a section in the
+        current window, 0 if it has not run */
+    uint32_t AverageCycles(const char* name, uint8_t depth) const;
+
+    /** One timed section, for DSY_PROFILE_SCOPE */
+    class Scope
+    {
+      public:
+        explicit Scope(const char* name);
+        inline ~Scope();
+
+      private:
+        const char* name_;
+        uint8_t     depth_;
+        uint8_t     order_;
+        uint32_t    start_;
+    };
+
+  private:
+    struct Record
+    {
+        const char* name;
+        uint32_t    cycles;
+        uint8_t     depth;
+        uint8_t     order; // start order within its block
+    };
+
+    struct Section
+    {
+        const char* name;
+        uint8_t     depth;
+        uint8_t     order;
+        uint32_t    calls;
+        uint32_t    max;
+        uint64_t    total;
+    };
+
+    SpscRing<Record, kRingSize> ring_;
+    uint8_t                     depth_;
+    uint8_t                     next_order_;
+    volatile uint32_t           dropped_;
+    BlockSection                block_[kBlockSections];
+    size_t                      block_count_;
+
+    Section  sections_[kMaxSections];
+    size_t   num_sections_;
+    uint32_t blocks_;
+};
+
+extern SectionProfiler section_profiler;
+
+inline SectionProfiler::Scope::Scope(const char* name)
+: name_(name), depth_(section_profiler.depth_++)
+{
+    if(depth_ == 0)
+        section_profiler.next_order_ = 0;
+    order_ = section_profiler.next_order_++;
+    start_ = DWT->CYCCNT;
+}
+
+inline SectionProfiler::Scope::~Scope()
+{
+    const uint32_t cycles = DWT->CYCCNT - start_;
+    section_profiler.depth_--;
+    if(order_ < kBlockSections)
+        section_profiler.block_[order_] = {name_, cycles, depth_};
+    if(depth_ == 0)
+        section_profiler.block_count_ = section_profiler.next_order_ < kBlockSections
+                                            ? section_profiler.next_order_
+                                            : kBlockSections;
+    if(!section_profiler.ring_.Push({name_, cycles, depth_, order_}))
+        section_profiler.dropped_++;
+}
+
+} // namespace daisy
+
+#define DSY_PROFILE_CAT_(a, b) a##b
+#define DSY_PROFILE_CAT(a, b) DSY_PROFILE_CAT_(a, b)
+#define DSY_PROFILE_SCOPE(name) \
+    daisy::SectionProfiler::Scope DSY_PROFILE_CAT(dsy_profile_, __LINE__)(name)
+
+#else
+
+#define DSY_PROFILE_SCOPE(name) \
+    do                          \
+    {                           \
+    } while(0)
+
+#endif // DSY_PROFILE
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef DSY_SEQLOCK_H
+#define DSY_SEQLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+
+namespace daisy
+{
+/** Single-writer snapshot of a T for readers in any interrupt context.
+
+    Two copies and a sequence count: Write() fills the copy the count
+    does not point at, then bumps the count, so the latest complete
+    value is always published. A reader that the writer can preempt,
+    e.g. loop() under a control interrupt, copies the current one and
+    retries if the count moved meanwhile; one that preempts the writer,
+    e.g. the audio callback, always succeeds on the first pass, since
+    the writer never touches the copy it reads. Nothing is masked.
+
+    Single core, so compiler fences are enough. T is copied whole:
+    keep it plain data.
+*/
+template <typename T>
+class Seqlock
+{
+  public:
+    Seqlock() : seq_(0) {}
+    ~Seqlock() {}
+
+    /** Publishes value; from one context only */
+    void Write(const T& value)
+    {
+        const uint32_t next = seq_ + 1;
+        copies_[next & 1]   = value;
+        std::atomic_signal_fence(std::memory_order_release);
+        seq_ = next;
+    }
+
+    /** Copies the latest published value into out */
+    void Read(T& out) const
+    {
+        uint32_t seq;
+        do
+        {
+            seq = seq_;
+            std::atomic_signal_fence(std::memory_order_acquire);
+            out = copies_[seq & 1];
+            std::atomic_signal_fence(std::memory_order_acquire);
+        } while(seq_ != seq);
+    }
+
+    /** Writes so far; a change means a new value */
+    inline uint32_t GetSequence() const { return seq_; }
+
+  private:
+    T                 copies_[2];
+    volatile uint32_t seq_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef DSY_SPSC_RING_H
+#define DSY_SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace daisy
+{
+/** Fixed-size FIFO between one producer and one consumer context.
+
+    Each side owns one index and only reads the other's, so a push that
+    preempts a pop, or the other way round, needs no lock. Single core:
+    compiler fences order the slot against its index. Full pushes fail
+    rather than overwrite.
+
+    \param T plain data
+    \param N capacity, a power of two
+*/
+template <typename T, size_t N>
+class SpscRing
+{
+  public:
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+    SpscRing() : head_(0), tail_(0) {}
+    ~SpscRing() {}
+
+    /** Producer: appends item, false if full */
+    bool Push(const T& item)
+    {
+        const uint32_t head = head_;
+        if(head - tail_ >= N)
+            return false;
+        items_[head & (N - 1)] = item;
+        std::atomic_signal_fence(std::memory_order_release);
+        head_ = head + 1;
+        return true;
+    }
+
+    /** Consumer: the oldest item without removing it, nullptr if empty */
+    const T* Peek() const
+    {
+        const uint32_t tail = tail_;
+        if(tail == head_)
+            return nullptr;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        return &items_[tail & (N - 1)];
+    }
+
+    /** Consumer: removes the oldest item into out, false if empty */
+    bool Pop(T& out)
+    {
+        const T* item = Peek();
+        if(item == nullptr)
+            return false;
+        out = *item;
+        std::atomic_signal_fence(std::memory_order_release);
+        tail_ = tail_ + 1;
+        return true;
+    }
+
+    /** Consumer: removes the oldest item, once done with what Peek()
+        returned; nothing if empty */
+    void Discard()
+    {
+        if(tail_ == head_)
+            return;
+        std::atomic_signal_fence(std::memory_order_release);
+        tail_ = tail_ + 1;
+    }
+
+    /** Either side: items waiting */
+    inline size_t Size() const { return head_ - tail_; }
+
+  private:
+    T                 items_[N];
+    volatile uint32_t head_;
+    volatile uint32_t tail_;
+};
+
+} // namespace daisy
+#endif
@@ -3,6 +3,7 @@
 #define DEV_SR_4021_H
 #include "Arduino.h"
 #include "system.h"
+#include "utility/irq_priority.h"
 
 namespace daisy {
 /** @brief Device Driver for CD4021 shift register
@@ -34,6 +35,16 @@ namespace daisy {
  *devices chained should match
  ** for each parallel device chain.
  **
+ ** Update() bit-bangs the chain with a microsecond delay per edge. After
+ ** StartScan() a hardware timer interrupt does it instead, one clock
+ ** edge per tick through the GPIO registers, and Update() only picks up
+ ** the last complete scan: a word copy. The 4021 is static, so the slow
+ ** clock costs nothing but latency; at the default 32 kHz tick two
+ ** chained devices are read about 900 times a second, for a few hundred
+ ** cycles of interrupt per scan.
+ **
+ ** States are packed one bit per input, so 32 inputs at most.
+ **
  ***/
 template <size_t num_daisychained = 1, size_t num_parallel = 1>
 class ShiftRegister4021 {
@@ -65,34 +76,66 @@ public:
     }
 
     // Init States
-    for (size_t i = 0; i < kTotalStates; i++) {
-      states_[i] = false;
+    states_ = 0;
+    scanned_ = 0;
+    scans_ = 0;
+    timer_ = nullptr;
+  }
+
+  /** Reads the chain in the background from here on.
+   ** \param instance timer to tick on, not used by anything else
+   ** \param tick_hz  clock edges per second; a scan takes
+   **                 2 + 16 * num_daisychained of them
+   **/
+  void StartScan(TIM_TypeDef *instance = TIM17, uint32_t tick_hz = 32000) {
+    if (timer_ != nullptr)
+      return;
+    for (size_t j = 0; j < num_parallel; j++) {
+      data_port_[j] = digitalPinToPort(data_[j]);
+      data_mask_[j] = digitalPinToBitMask(data_[j]);
     }
+    clk_port_ = digitalPinToPort(clk_);
+    clk_mask_ = digitalPinToBitMask(clk_);
+    latch_port_ = digitalPinToPort(latch_);
+    latch_mask_ = digitalPinToBitMask(latch_);
+    phase_ = 0;
+
+    timer_ = new HardwareTimer(instance);
+    timer_->setOverflow(tick_hz, HERTZ_FORMAT);
+    timer_->setInterruptPriority(IRQ_PRIORITY_CONTROL, 0);
+    timer_->attachInterrupt([this]() { Tick(); });
+    timer_->resume();
   }
 
-  /** Reads the states of all pins on the connected device(s) */
+  /** Reads the states of all pins on the connected device(s); once
+   ** scanning, takes the last complete scan instead.
+   **/
   void Update() {
+    if (timer_ != nullptr) {
+      states_ = scanned_;
+      return;
+    }
+
+    uint32_t words[num_parallel] = {};
     digitalWrite(clk_, 0);
     digitalWrite(latch_, 1);
 
     delayMicroseconds(1);
 
     digitalWrite(latch_, 0);
-    uint32_t idx;
     for (size_t i = 0; i < 8 * num_daisychained; i++) {
       digitalWrite(clk_, 0);
 
       delayMicroseconds(1);
 
       for (size_t j = 0; j < num_parallel; j++) {
-        idx = (8 * num_daisychained - 1) - i;
-        idx += (8 * num_daisychained * j);
-        states_[idx] = digitalRead(data_[j]);
+        words[j] = (words[j] << 1) | (digitalRead(data_[j]) ? 1 : 0);
       }
       digitalWrite(clk_, 1);
 
       delayMicroseconds(1);
     }
+    states_ = Pack(words);
   }
 
   /** returns the last read state of the input at the index.
@@ -101,17 +144,74 @@ public:
    ** See above for the layout of data when using multiple
    ** devices in series or parallel.
    ***/
-  inline const bool State(int index) const { return states_[index]; }
+  inline const bool State(int index) const { return (states_ >> index) & 1; }
+
+  /** Every state of the last Update(), bit n for State(n). */
+  inline uint32_t States() const { return states_; }
+
+  /** Scans completed in the background so far. */
+  inline uint32_t GetScanCount() const { return scans_; }
 
   inline const Config &GetConfig() const { return config_; }
 
 private:
   static constexpr int kTotalStates = 8 * num_daisychained * num_parallel;
+  static constexpr size_t kChainBits = 8 * num_daisychained;
+  static_assert(kTotalStates <= 32, "ShiftRegister4021 packs at most 32 states");
+
+  // The first bit shifted out of each chain ends up on top of its
+  // chain's kChainBits, chains side by side from the bottom.
+  static uint32_t Pack(const uint32_t (&words)[num_parallel]) {
+    uint32_t packed = 0;
+    for (size_t j = 0; j < num_parallel; j++)
+      packed |= words[j] << (kChainBits * j);
+    return packed;
+  }
+
+  // One clock edge per call: load, then read and clock each bit.
+  void Tick() {
+    const uint32_t phase = phase_;
+    if (phase == 0) {
+      clk_port_->BSRR = clk_mask_ << 16;
+      latch_port_->BSRR = latch_mask_;
+    } else if (phase == 1) {
+      latch_port_->BSRR = latch_mask_ << 16;
+      for (size_t j = 0; j < num_parallel; j++)
+        words_[j] = 0;
+    } else if ((phase & 1) == 0) {
+      for (size_t j = 0; j < num_parallel; j++)
+        words_[j] = (words_[j] << 1) | ((data_port_[j]->IDR & data_mask_[j]) ? 1 : 0);
+      clk_port_->BSRR = clk_mask_;
+    } else {
+      clk_port_->BSRR = clk_mask_ << 16;
+      if (phase == 1 + 2 * kChainBits) {
+        scanned_ = Pack(words_);
+        scans_ = scans_ + 1;
+        phase_ = 0;
+        return;
+      }
+    }
+    phase_ = phase + 1;
+  }
+
   Config config_;
-  bool states_[kTotalStates];
+  uint32_t states_;
   uint32_t clk_;
   uint32_t latch_;
   uint32_t data_[num_parallel];
+
+  // background scan, written by Tick()
+  HardwareTimer *timer_;
+  volatile uint32_t scanned_;
+  volatile uint32_t scans_;
+  uint32_t phase_;
+  uint32_t words_[num_parallel];
+  GPIO_TypeDef *clk_port_;
+  GPIO_TypeDef *latch_port_;
+  GPIO_TypeDef *data_port_[num_parallel];
+  uint32_t clk_mask_;
+  uint32_t latch_mask_;
+  uint32_t data_mask_[num_parallel];
 };
 
 } // namespace daisy
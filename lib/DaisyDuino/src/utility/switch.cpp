@@ -11,8 +11,23 @@ void Switch::Init(float update_rate, bool invert, uint8_t pin, uint8_t mode) {
   pinMode(pin, mode);
 }
 
+bool Switch::UseBank(DebounceBank &bank) {
+  if (!bank.AddPin(pin_, flip_, &bank_pin_))
+    return false;
+  bank_ = &bank;
+  return true;
+}
+
 // debounces and processes input
 void Switch::Debounce() {
+  if (bank_) {
+    if (RisingEdge() || FallingEdge())
+      time_held_ = 0;
+    else if (Pressed())
+      time_held_ += time_per_update_;
+    return;
+  }
+
   uint8_t in = digitalRead(pin_);
   state_ = (state_ << 1) | (flip_ ? !in : in);
 
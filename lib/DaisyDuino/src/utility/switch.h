@@ -2,6 +2,7 @@
 #define DSY_SWITCH_H
 
 #include "Arduino.h"
+#include "debounce_bank.h"
 
 namespace daisy {
 class Switch {
@@ -11,14 +12,18 @@ public:
 
   void Init(float update_rate, bool invert, uint8_t pin, uint8_t mode);
 
+  // hands debouncing to a bank after Init; Debounce() then only
+  // keeps the held time, and the bank's Update() has to run first
+  bool UseBank(DebounceBank &bank);
+
   // debounces and processes input
   void Debounce();
 
-  bool RisingEdge() { return state_ == 0x7f; }
+  bool RisingEdge() { return bank_ ? bank_->Rose(bank_pin_) : state_ == 0x7f; }
 
-  bool FallingEdge() { return state_ == 0x80; }
+  bool FallingEdge() { return bank_ ? bank_->Fell(bank_pin_) : state_ == 0x80; }
 
-  bool Pressed() { return state_ == 0xff; }
+  bool Pressed() { return bank_ ? bank_->State(bank_pin_) : state_ == 0xff; }
 
   float TimeHeldMs() { return Pressed() ? time_held_ * 1000.f : 0; }
 
@@ -26,6 +31,8 @@ private:
   bool flip_;
   float time_per_update_, time_held_;
   uint8_t state_, pin_;
+  const DebounceBank *bank_ = nullptr;
+  DebounceBank::Pin bank_pin_;
 };
 } // namespace daisy
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "sys_mpu.h"    
 #include <stm32h7xx_hal.h>
 
+static uint32_t sdram_window_base[DSY_MPU_SDRAM_WINDOWS];
+static uint32_t sdram_window_size[DSY_MPU_SDRAM_WINDOWS];
 
 void dsy_mpu_init()
 {
@@ -31,6 +33,152 @@ void dsy_mpu_init()
     MPU_InitStruct.BaseAddress  = 0xC0000000;
     HAL_MPU_ConfigRegion(&MPU_InitStruct);
 
+    // SDRAM windows from before
+    for(int i = 0; i < DSY_MPU_SDRAM_WINDOWS; i++)
+    {
+        MPU_InitStruct.Enable = MPU_REGION_DISABLE;
+        MPU_InitStruct.Number = (uint8_t)(MPU_REGION_NUMBER3 + i);
+        HAL_MPU_ConfigRegion(&MPU_InitStruct);
+        sdram_window_size[i] = 0;
+    }
+
     HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
 }
 
+void dsy_mpu_set_cacheable(void* base, uint32_t size)
+{
+    MPU_Region_InitTypeDef MPU_InitStruct;
+    HAL_MPU_Disable();
+
+    // Higher region numbers win where regions overlap, so this carves a
+    // cacheable window out of region 0. The size field encodes
+    // log2(size) - 1.
+    MPU_InitStruct.Enable           = MPU_REGION_ENABLE;
+    MPU_InitStruct.BaseAddress      = (uint32_t)base;
+    MPU_InitStruct.Size             = (uint8_t)(__builtin_ctz(size) - 1);
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.IsBufferable     = MPU_ACCESS_BUFFERABLE;
+    MPU_InitStruct.IsCacheable      = MPU_ACCESS_CACHEABLE;
+    MPU_InitStruct.IsShareable      = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.Number           = MPU_REGION_NUMBER2;
+    MPU_InitStruct.TypeExtField     = MPU_TEX_LEVEL0;
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.DisableExec      = MPU_INSTRUCTION_ACCESS_ENABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
+static void mpu_sdram_region(int window, uint32_t enable, uint32_t base,
+                             uint32_t size, dsy_mpu_policy policy)
+{
+    MPU_Region_InitTypeDef MPU_InitStruct;
+    HAL_MPU_Disable();
+
+    // Write-back is region 1's TEX 0, C, B; write-through drops B.
+    // Non-cached is normal memory, TEX 1 with neither, as region 0.
+    MPU_InitStruct.Enable           = enable;
+    MPU_InitStruct.BaseAddress      = base;
+    MPU_InitStruct.Size             = (uint8_t)(__builtin_ctz(size) - 1);
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.IsBufferable     = policy == DSY_MPU_WRITE_BACK
+                                          ? MPU_ACCESS_BUFFERABLE
+                                          : MPU_ACCESS_NOT_BUFFERABLE;
+    MPU_InitStruct.IsCacheable      = policy == DSY_MPU_NON_CACHED
+                                          ? MPU_ACCESS_NOT_CACHEABLE
+                                          : MPU_ACCESS_CACHEABLE;
+    MPU_InitStruct.IsShareable      = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.Number           = (uint8_t)(MPU_REGION_NUMBER3 + window);
+    MPU_InitStruct.TypeExtField     = policy == DSY_MPU_NON_CACHED
+                                          ? MPU_TEX_LEVEL1
+                                          : MPU_TEX_LEVEL0;
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.DisableExec      = MPU_INSTRUCTION_ACCESS_ENABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
+int dsy_mpu_set_sdram_policy(void* base, uint32_t size, dsy_mpu_policy policy)
+{
+    const uint32_t addr = (uint32_t)base;
+    if(size < 32 || (size & (size - 1)) != 0 || (addr & (size - 1)) != 0
+       || addr < 0xC0000000 || addr - 0xC0000000 >= 0x04000000)
+    {
+        return -1;
+    }
+
+    int window = -1;
+    for(int i = 0; i < DSY_MPU_SDRAM_WINDOWS; i++)
+    {
+        if(sdram_window_size[i] != 0 && sdram_window_base[i] == addr
+           && sdram_window_size[i] == size)
+        {
+            window = i;
+            break;
+        }
+        if(window < 0 && sdram_window_size[i] == 0)
+            window = i;
+    }
+    if(window < 0)
+        return -1;
+
+    dsy_dcache_clean_invalidate(base, size);
+    sdram_window_base[window] = addr;
+    sdram_window_size[window] = size;
+    mpu_sdram_region(window, MPU_REGION_ENABLE, addr, size, policy);
+    return window;
+}
+
+void dsy_mpu_clear_sdram_policy(int window)
+{
+    if(window < 0 || window >= DSY_MPU_SDRAM_WINDOWS
+       || sdram_window_size[window] == 0)
+    {
+        return;
+    }
+    // A write-through or non-cached window may hold stale lines from
+    // before it was set.
+    dsy_dcache_invalidate((void*)sdram_window_base[window],
+                          sdram_window_size[window]);
+    mpu_sdram_region(window,
+                     MPU_REGION_DISABLE,
+                     sdram_window_base[window],
+                     sdram_window_size[window],
+                     DSY_MPU_WRITE_BACK);
+    sdram_window_size[window] = 0;
+}
+
+static int dcache_lines(const void* p, uint32_t bytes, uint32_t** addr)
+{
+    const uint32_t start = (uint32_t)p & ~(uint32_t)31;
+    const uint32_t end   = ((uint32_t)p + bytes + 31) & ~(uint32_t)31;
+    *addr                = (uint32_t*)start;
+    return (SCB->CCR & SCB_CCR_DC_Msk) != 0 && bytes != 0
+               ? (int)(end - start)
+               : 0;
+}
+
+void dsy_dcache_clean(const void* p, uint32_t bytes)
+{
+    uint32_t* addr;
+    const int len = dcache_lines(p, bytes, &addr);
+    if(len > 0)
+        SCB_CleanDCache_by_Addr(addr, len);
+}
+
+void dsy_dcache_invalidate(const void* p, uint32_t bytes)
+{
+    uint32_t* addr;
+    const int len = dcache_lines(p, bytes, &addr);
+    if(len > 0)
+        SCB_InvalidateDCache_by_Addr(addr, len);
+}
+
+void dsy_dcache_clean_invalidate(const void* p, uint32_t bytes)
+{
+    uint32_t* addr;
+    const int len = dcache_lines(p, bytes, &addr);
+    if(len > 0)
+        SCB_CleanInvalidateDCache_by_Addr(addr, len);
+}
@@ -1,6 +1,8 @@
 #ifndef DAISYDUINO_MPU
 #define DAISYDUINO_MPU
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -8,9 +10,59 @@ extern "C"
 
 // Initializes, and configures MPU to: 
 // - mark DMA buffer area for SAI as cacheless
-// - marks the SDRAM as cacheable
+// - marks the SDRAM as cacheable (write-back)
+// - clears the SDRAM windows of dsy_mpu_set_sdram_policy()
 void dsy_mpu_init();
 
+// Marks [base, base + size) as write-back cacheable, overriding the
+// non-cached SRAM1 window for that range. Uses MPU region 2.
+// size must be a power of two, 32 bytes or more, and base aligned to it.
+// Whoever owns the range does its own cache maintenance around DMA.
+void dsy_mpu_set_cacheable(void* base, uint32_t size);
+
+// Cache policies for a window of SDRAM.
+typedef enum
+{
+    // The dsy_mpu_init() default. Fastest for DSP state such as delay
+    // lines. DMA needs dsy_dcache_clean() before reading the window and
+    // dsy_dcache_invalidate() after writing it.
+    DSY_MPU_WRITE_BACK,
+    // Reads are cached, every write also goes to SDRAM: a DMA reading the
+    // window (a looper streamed out over USB) needs no clean. DMA writes
+    // still need an invalidate.
+    DSY_MPU_WRITE_THROUGH,
+    // Every access goes to SDRAM; coherent with DMA both ways.
+    DSY_MPU_NON_CACHED,
+} dsy_mpu_policy;
+
+#define DSY_MPU_SDRAM_WINDOWS 4
+
+// Gives [base, base + size) of the SDRAM its own policy, over region 1.
+// Same size and alignment rules as dsy_mpu_set_cacheable(). The range is
+// cleaned and invalidated first, so no dirty line outlives a write-back
+// policy. Windows use MPU regions 3 to 6; setting a range again changes
+// its window in place.
+// Returns the window, or -1 if the range is not SDRAM, is misaligned, or
+// all windows are taken.
+int dsy_mpu_set_sdram_policy(void* base, uint32_t size, dsy_mpu_policy policy);
+
+// Frees a window from dsy_mpu_set_sdram_policy(); its range goes back to
+// write-back.
+void dsy_mpu_clear_sdram_policy(int window);
+
+// D-cache maintenance for DMA on cached memory, rounded out to whole
+// 32-byte lines. No-ops with the D-cache off. Keep DMA buffers on their
+// own lines (SdramArena's default alignment does): invalidating a line
+// also drops CPU writes to anything else in it.
+
+// Writes the CPU's changes to memory, before a DMA reads it.
+void dsy_dcache_clean(const void* p, uint32_t bytes);
+// Drops cached copies, after a DMA wrote the memory and before the CPU
+// reads it.
+void dsy_dcache_invalidate(const void* p, uint32_t bytes);
+// Both, for a buffer the CPU and a DMA take turns writing.
+void dsy_dcache_clean_invalidate(const void* p, uint32_t bytes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -100,6 +100,42 @@ void System::Init(const System::Config& config)
     tim_.Start();
 }
 
+void System::InitClocks(const System::Config& config)
+{
+    cfg_ = config;
+    // HAL will not reprogram PLL1 while it clocks the system.
+    if(__HAL_RCC_GET_SYSCLK_SOURCE() == RCC_CFGR_SWS_PLL1)
+    {
+        if(!__HAL_RCC_GET_FLAG(RCC_FLAG_HSIRDY))
+        {
+            __HAL_RCC_HSI_CONFIG(RCC_HSI_DIV1);
+            while(!__HAL_RCC_GET_FLAG(RCC_FLAG_HSIRDY)) {}
+        }
+        RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+        RCC_ClkInitStruct.ClockType          = RCC_CLOCKTYPE_SYSCLK;
+        RCC_ClkInitStruct.SYSCLKSource       = RCC_SYSCLKSOURCE_HSI;
+        // Keep the current wait states; more are always safe.
+        if(HAL_RCC_ClockConfig(&RCC_ClkInitStruct, __HAL_FLASH_GET_LATENCY())
+           != HAL_OK)
+        {
+            Error_Handler();
+        }
+    }
+    __HAL_RCC_SYSCFG_CLK_ENABLE(); // VOS0 needs the overdrive bit
+    ConfigureClocks();
+
+    if(config.use_icache)
+        SCB_EnableICache();
+    else
+        SCB_DisableICache();
+    // The Arduino core leaves the D-cache off; only touch it on a change.
+    const bool dcache_on = (SCB->CCR & SCB_CCR_DC_Msk) != 0;
+    if(config.use_dcache && !dcache_on)
+        SCB_EnableDCache();
+    else if(!config.use_dcache && dcache_on)
+        SCB_DisableDCache();
+}
+
 void System::JumpToQspi()
 {
     __JUMPTOQSPI();
@@ -169,6 +205,9 @@ void System::ConfigureClocks()
             flash_latency = FLASH_LATENCY_2;
             break;
     }
+    // FLASH_LATENCY_n is n on the H7.
+    if(cfg_.flash_wait_states > flash_latency)
+        flash_latency = cfg_.flash_wait_states > 7 ? 7 : cfg_.flash_wait_states;
 
     while(!__HAL_PWR_GET_FLAG(PWR_FLAG_VOSRDY)) {}
     /** Macro to configure the PLL clock source 
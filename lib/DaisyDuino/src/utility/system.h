@@ -26,31 +26,51 @@ class System
             FREQ_480MHZ,
         };
 
+        /** SDRAM timing profile, see dsy_sdram_timing. Both clock
+         ** profiles feed the FMC 200MHz from PLL2R, so DATASHEET works
+         ** out the same delays under either. */
+        enum class SdramTiming
+        {
+            LEGACY,
+            DATASHEET,
+        };
+
         /** Method to call on the struct to set to defaults
          ** CPU Freq set to 400MHz
          ** Cache Enabled 
+         ** Flash at 2 wait states
          ** */
         void Defaults()
         {
-            cpu_freq   = SysClkFreq::FREQ_400MHZ;
-            use_dcache = true;
-            use_icache = true;
+            cpu_freq          = SysClkFreq::FREQ_400MHZ;
+            use_dcache        = true;
+            use_icache        = true;
+            flash_wait_states = 2;
+            sdram_timing      = SdramTiming::LEGACY;
         }
 
         /** Method to call on the struct to set to boost mode:
          ** CPU Freq set to 480MHz
          ** Cache Enabled 
+         ** Flash at 4 wait states
          ** */
         void Boost()
         {
-            cpu_freq   = SysClkFreq::FREQ_480MHZ;
-            use_dcache = true;
-            use_icache = true;
+            cpu_freq          = SysClkFreq::FREQ_480MHZ;
+            use_dcache        = true;
+            use_icache        = true;
+            flash_wait_states = 4;
+            sdram_timing      = SdramTiming::LEGACY;
         }
 
         SysClkFreq cpu_freq;
         bool       use_dcache;
         bool       use_icache;
+        /** Internal flash wait states, 0 to 7. Raised to the minimum the
+         ** AXI clock needs (2 at 400MHz, 4 at 480MHz) if set lower. */
+        uint8_t flash_wait_states;
+        /** Applied by AudioClass::init(), which starts the SDRAM */
+        SdramTiming sdram_timing;
     };
 
     System() {}
@@ -67,6 +87,12 @@ class System
      */
     void Init(const Config& config);
 
+    /** Applies only the clock tree and cache settings of config, for a
+     ** system that is already running, e.g. on the Arduino core's clocks.
+     ** SYSCLK parks on HSI while PLL1 is reprogrammed. Call before
+     ** starting any peripheral that depends on the bus clocks. */
+    void InitClocks(const Config& config);
+
     /** Jumps to the first address of the external flash chip (0x90000000)
      ** If there is no code there, the chip will likely fall through to the while() loop
      ** TODO: Documentation/Loader for using external flash coming soon.
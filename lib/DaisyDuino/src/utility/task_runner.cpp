@@ -0,0 +1,116 @@
+#include "task_runner.h"
+#include "cpu_load_meter.h"
+#include <stdio.h>
+
+using namespace daisy;
+
+void TaskRunner::Init()
+{
+    EnableCycleCounter();
+    num_tasks_ = 0;
+}
+
+Task* TaskRunner::Add(const char* name, Task::Fn fn, void* ctx, uint32_t period_us)
+{
+    if(num_tasks_ >= kMaxTasks || fn == nullptr)
+        return nullptr;
+    Task& t          = tasks_[num_tasks_++];
+    t.resume_        = 0;
+    t.fn_            = fn;
+    t.ctx_           = ctx;
+    t.name_          = name;
+    t.period_us_     = period_us;
+    t.wake_us_       = micros();
+    t.sleeping_      = false;
+    t.runs_          = 0;
+    t.total_cycles_  = 0;
+    t.worst_cycles_  = 0;
+    t.worst_late_us_ = 0;
+    t.overruns_      = 0;
+    return &t;
+}
+
+size_t TaskRunner::Run()
+{
+    size_t run = 0;
+    for(size_t i = 0; i < num_tasks_; i++)
+    {
+        Task& t = tasks_[i];
+        if(t.fn_ == nullptr)
+            continue;
+        // Wrap-safe: micros() rolls over every 71 minutes.
+        const uint32_t now  = micros();
+        const uint32_t late = now - t.wake_us_;
+        if((int32_t)late < 0)
+            continue;
+
+        t.sleeping_          = false;
+        const uint32_t start = DWT->CYCCNT;
+        t.fn_(t, t.ctx_);
+        const uint32_t cycles = DWT->CYCCNT - start;
+        run++;
+
+        t.runs_++;
+        t.total_cycles_ += cycles;
+        if(cycles > t.worst_cycles_)
+            t.worst_cycles_ = cycles;
+        if(late > t.worst_late_us_)
+            t.worst_late_us_ = late;
+
+        // A sleep has set the next deadline already.
+        if(t.sleeping_)
+            continue;
+        t.wake_us_ += t.period_us_;
+        if(t.period_us_ > 0 && (int32_t)(now - t.wake_us_) >= 0)
+        {
+            t.overruns_++;
+            t.wake_us_ = now + t.period_us_;
+        }
+    }
+    return run;
+}
+
+void TaskRunner::ResetStats()
+{
+    for(size_t i = 0; i < num_tasks_; i++)
+    {
+        Task& t          = tasks_[i];
+        t.runs_          = 0;
+        t.total_cycles_  = 0;
+        t.worst_cycles_  = 0;
+        t.worst_late_us_ = 0;
+        t.overruns_      = 0;
+    }
+}
+
+void TaskRunner::Print(::Print& out, bool reset)
+{
+    char line[96];
+    snprintf(line,
+             sizeof(line),
+             "%-16s %8s %9s %9s %8s %6s\r\n",
+             "task",
+             "runs",
+             "avg cyc",
+             "worst cyc",
+             "late us",
+             "over");
+    out.print(line);
+    for(size_t i = 0; i < num_tasks_; i++)
+    {
+        const Task& t = tasks_[i];
+        snprintf(line,
+                 sizeof(line),
+                 "%-16s %8lu %9lu %9lu %8lu %6lu%s\r\n",
+                 t.name_ ? t.name_ : "?",
+                 (unsigned long)t.runs_,
+                 (unsigned long)t.GetAverageCycles(),
+                 (unsigned long)t.worst_cycles_,
+                 (unsigned long)t.worst_late_us_,
+                 (unsigned long)t.overruns_,
+                 t.fn_ ? "" : "  done");
+        out.print(line);
+    }
+    if(reset)
+        ResetStats();
+}
@@ -0,0 +1,213 @@
+#pragma once
+#ifndef DSY_TASK_RUNNER_H
+#define DSY_TASK_RUNNER_H
+
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+class TaskRunner;
+
+/** One cooperative task of a TaskRunner: its resume point, its next
+    deadline and its runtime stats.
+
+    A task is a plain function the runner calls when it is due. It
+    either does its work and returns, to run again a period later, or
+    is written as a stackless coroutine with the DSY_TASK_ macros,
+    which return to the runner at each wait and resume after it on the
+    next call. Locals do not survive a wait: keep what a task carries
+    across one in its context or in statics. Each wait marks its place
+    by its line number, so put no two on one line, and none inside a
+    switch of the task's own.
+
+    static void Sweep(Task& t, void* ctx)
+    {
+        static int step;
+        DSY_TASK_BEGIN(t);
+        for(step = 0; step < 16; step++)
+        {
+            SetDac(step);
+            DSY_TASK_SLEEP_MS(t, 50);
+            Measure(step);
+        }
+        DSY_TASK_END(t);
+    }
+*/
+class Task
+{
+  public:
+    typedef void (*Fn)(Task& task, void* ctx);
+
+    /** Calls made, since the stats were reset */
+    inline uint32_t GetRuns() const { return runs_; }
+
+    /** Average DWT cycles a call took */
+    inline uint32_t GetAverageCycles() const
+    {
+        return runs_ ? (uint32_t)(total_cycles_ / runs_) : 0;
+    }
+
+    /** Longest call, in DWT cycles */
+    inline uint32_t GetWorstCycles() const { return worst_cycles_; }
+
+    /** Latest a call started after its deadline, in microseconds: how
+        long the other tasks, together, held it up
+    */
+    inline uint32_t GetWorstLateUs() const { return worst_late_us_; }
+
+    /** Deadlines passed by more than a whole period, which are skipped
+        rather than run back to back
+    */
+    inline uint32_t GetOverruns() const { return overruns_; }
+
+    /** false once the coroutine reached DSY_TASK_END */
+    inline bool IsRunning() const { return fn_ != nullptr; }
+
+    /** For the macros: the next call comes no earlier than us from now */
+    inline void SleepUs(uint32_t us)
+    {
+        wake_us_  = micros() + us;
+        sleeping_ = true;
+    }
+
+    /** For the macros: ends the task */
+    inline void Finish() { fn_ = nullptr; }
+
+    /** For the macros: where the coroutine resumes, 0 at its start */
+    uint32_t resume_;
+
+  private:
+    friend class TaskRunner;
+
+    Fn          fn_;
+    void*       ctx_;
+    const char* name_;
+    uint32_t    period_us_;
+    uint32_t    wake_us_;
+    bool        sleeping_;
+
+    uint32_t runs_;
+    uint64_t total_cycles_;
+    uint32_t worst_cycles_;
+    uint32_t worst_late_us_;
+    uint32_t overruns_;
+};
+
+/** Starts a coroutine body; the first statement of the task */
+#define DSY_TASK_BEGIN(t) \
+    switch((t).resume_)   \
+    {                     \
+        case 0:
+
+/** Returns to the runner and resumes here on the task's next call */
+#define DSY_TASK_YIELD(t)          \
+    do                             \
+    {                              \
+        (t).resume_ = __LINE__;    \
+        return;                    \
+        case __LINE__:;            \
+    } while(0)
+
+/** Returns to the runner and resumes here ms milliseconds later */
+#define DSY_TASK_SLEEP_MS(t, ms)          \
+    do                                    \
+    {                                     \
+        (t).SleepUs((uint32_t)(ms)*1000); \
+        (t).resume_ = __LINE__;           \
+        return;                           \
+        case __LINE__:;                   \
+    } while(0)
+
+/** Returns to the runner until cond holds, tested on each call */
+#define DSY_TASK_WAIT_UNTIL(t, cond) \
+    do                               \
+    {                                \
+        (t).resume_ = __LINE__;      \
+        case __LINE__:               \
+        if(!(cond))                  \
+            return;                  \
+    } while(0)
+
+/** Ends a coroutine body; the task is not called again */
+#define DSY_TASK_END(t) \
+    }                   \
+    (t).Finish()
+
+/** Cooperative scheduler for what loop() does besides waiting: controls,
+    LEDs, serial telemetry, calibration sweeps.
+
+    Instead of a millis() check per job, each is a Task added with a
+    period, and loop() calls Run(). A pass runs every task whose
+    deadline has come, in the order they were added, and times each
+    call with the DWT cycle counter. Deadlines advance by the period
+    from the previous one rather than from when the task ran, so a
+    late call does not drift the ones after it; one that fell more than
+    a period behind is an overrun and skips ahead instead of catching
+    up. A coroutine's sleep overrides its period for the next call.
+
+    Nothing preempts a task but interrupts, so a task's lateness is the
+    sum of the calls that ran before it: keep each call short, and
+    split long work with DSY_TASK_YIELD. Print() shows, per task, where
+    the time went and how late each was held up.
+
+    usage:
+
+    static TaskRunner tasks;
+    ...
+    // setup()
+    tasks.Init();
+    tasks.Add("leds", UpdateLeds, nullptr, 1000);  // every millisecond
+    tasks.Add("sweep", Sweep, nullptr, 0);         // as often as it can
+    ...
+    // loop()
+    tasks.Run();
+    if(print_due)
+        tasks.Print(Serial);
+*/
+class TaskRunner
+{
+  public:
+    static constexpr size_t kMaxTasks = 16;
+
+    TaskRunner() {}
+    ~TaskRunner() {}
+
+    /** Enables the DWT cycle counter and clears the task list */
+    void Init();
+
+    /** Adds a task, first due straight away.
+        \param name for Print(); kept, not copied
+        \param fn called when due
+        \param ctx passed to fn
+        \param period_us between deadlines, 0 for every pass
+        \return the task, nullptr when kMaxTasks are already added
+    */
+    Task* Add(const char* name, Task::Fn fn, void* ctx, uint32_t period_us);
+
+    /** From loop(): runs the tasks that are due, each once.
+        \return tasks run
+    */
+    size_t Run();
+
+    /** Restarts every task's stats */
+    void ResetStats();
+
+    /** Writes a row of stats per task, then resets them if reset is
+        set
+    */
+    void Print(::Print& out, bool reset = true);
+
+    inline size_t GetNumTasks() const { return num_tasks_; }
+
+    inline const Task& GetTask(size_t idx) const { return tasks_[idx]; }
+
+  private:
+    Task   tasks_[kMaxTasks];
+    size_t num_tasks_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,590 @@
+#include "usb_audio.h"
+#include "irq_priority.h"
+#include <string.h>
+
+#if !defined(USBCON) && defined(HAL_PCD_MODULE_ENABLED)
+
+using namespace daisy;
+
+static PCD_HandleTypeDef usb_audio_pcd;
+static UsbAudio*         usb_audio_owner;
+
+// Entity and endpoint numbers, as in the descriptors below.
+static const uint8_t kInterfaceControl   = 0;
+static const uint8_t kInterfaceStreaming = 1;
+static const uint8_t kInputTerminalId    = 1;
+static const uint8_t kOutputTerminalId   = 2;
+static const uint8_t kClockId            = 3;
+static const uint8_t kEpData             = 0x01;
+static const uint8_t kEpFeedback         = 0x81;
+static const size_t  kEp0Size            = 64;
+
+// Two 24-bit channels in 4-byte subslots; one frame more than nominal
+// at 96 kHz, for the host to catch up with.
+static const size_t kFrameBytes  = 8;
+static const size_t kMaxDataSize = (96 + 1) * kFrameBytes;
+
+// Feedback: 10.14 frames per 1 ms frame (full speed), one count of FIFO
+// error worth 2^-10 frames a frame, within 1/256 of nominal.
+static const int32_t kFeedbackGainShift = 4;
+static const int32_t kFeedbackRangeShift = 8;
+
+// SOFs without a data packet before the stream counts as stopped.
+static const uint32_t kIdleSofs = 8;
+
+#define LO(x) (uint8_t)((x)&0xFF)
+#define HI(x) (uint8_t)(((x) >> 8) & 0xFF)
+
+static const uint8_t kDeviceDescriptor[18] = {
+    18,   0x01, LO(0x0200), HI(0x0200),
+    0xEF, 0x02, 0x01, // miscellaneous, interface association
+    kEp0Size,
+    LO(0x0483), HI(0x0483), // STMicroelectronics
+    LO(0x5730), HI(0x5730), // their audio device PID
+    LO(0x0100), HI(0x0100),
+    1,    2,    0,    1,
+};
+
+static const size_t kConfigSize = 9 + 8 + 9 + 46 + 9 + 9 + 16 + 6 + 7 + 8 + 7;
+static const size_t kAcSize     = 9 + 8 + 17 + 12;
+
+static const uint8_t kConfigDescriptor[kConfigSize] = {
+    // Configuration: two interfaces, bus powered, 100 mA
+    9, 0x02, LO(kConfigSize), HI(kConfigSize), 2, 1, 0, 0x80, 50,
+    // Interface association: audio function, UAC 2.0
+    8, 0x0B, kInterfaceControl, 2, 0x01, 0x00, 0x20, 0,
+    // Audio control interface
+    9, 0x04, kInterfaceControl, 0, 0, 0x01, 0x01, 0x20, 0,
+    // Class-specific AC header: UAC 2.0, desktop speaker
+    9, 0x24, 0x01, LO(0x0200), HI(0x0200), 0x01, LO(kAcSize), HI(kAcSize),
+    0x00,
+    // Clock source: internal fixed (the SAI), frequency and validity
+    // read-only
+    8, 0x24, 0x0A, kClockId, 0x01, 0x05, 0, 0,
+    // Input terminal: USB streaming, two channels, front left / right
+    17, 0x24, 0x02, kInputTerminalId, LO(0x0101), HI(0x0101), 0, kClockId,
+    2, 0x03, 0x00, 0x00, 0x00, 0, LO(0x0000), HI(0x0000), 0,
+    // Output terminal: speaker, fed by the input terminal
+    12, 0x24, 0x03, kOutputTerminalId, LO(0x0301), HI(0x0301), 0,
+    kInputTerminalId, kClockId, LO(0x0000), HI(0x0000), 0,
+    // Audio streaming interface, alternate 0: no bandwidth
+    9, 0x04, kInterfaceStreaming, 0, 0, 0x01, 0x02, 0x20, 0,
+    // Alternate 1: streaming, data and feedback endpoints
+    9, 0x04, kInterfaceStreaming, 1, 2, 0x01, 0x02, 0x20, 0,
+    // Class-specific AS general: PCM, two channels
+    16, 0x24, 0x01, kInputTerminalId, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 2,
+    0x03, 0x00, 0x00, 0x00, 0,
+    // Type I format: 4-byte subslots, 24 bits
+    6, 0x24, 0x02, 0x01, 4, 24,
+    // Data endpoint: isochronous, asynchronous, every frame
+    7, 0x05, kEpData, 0x05, LO(kMaxDataSize), HI(kMaxDataSize), 1,
+    // Class-specific data endpoint
+    8, 0x25, 0x01, 0x00, 0x00, 0, LO(0x0000), HI(0x0000),
+    // Explicit feedback endpoint: isochronous, feedback, 3 bytes
+    7, 0x05, kEpFeedback, 0x11, LO(3), HI(3), 1,
+};
+
+static const uint8_t kLanguages[4] = {4, 0x03, LO(0x0409), HI(0x0409)};
+static const char*   kStrings[]    = {nullptr, "Electrosmith", "Daisy Seed Audio"};
+
+UsbAudio::Result UsbAudio::Init(float sample_rate)
+{
+    sample_rate_ = (uint32_t)(sample_rate + 0.5f);
+    if(sample_rate_ != 48000 && sample_rate_ != 96000)
+        return Result::ERR;
+    nominal_ = (sample_rate_ << 14) / 1000;
+
+    config_        = 0;
+    alt_           = 0;
+    address_       = 0;
+    ep0_left_      = 0;
+    ep0_zlp_       = false;
+    ep0_out_       = false;
+    feedback_busy_ = false;
+    fill_avg_      = (int32_t)kTargetFrames << 6;
+    idle_sofs_     = 0;
+    head_          = 0;
+    tail_          = 0;
+    primed_        = false;
+    underruns_     = 0;
+    overruns_      = 0;
+    pcd_           = &usb_audio_pcd;
+    usb_audio_owner = this;
+
+    // OTG FS on the Seed's USB connector.
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    GPIO_InitTypeDef gpio = {};
+    gpio.Pin       = GPIO_PIN_11 | GPIO_PIN_12;
+    gpio.Mode      = GPIO_MODE_AF_PP;
+    gpio.Pull      = GPIO_NOPULL;
+    gpio.Speed     = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio.Alternate = GPIO_AF10_OTG1_FS;
+    HAL_GPIO_Init(GPIOA, &gpio);
+    __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
+
+    // The HSI48 that clocks the PHY (SystemClock_Config) is only good to
+    // a few percent untrimmed; the CRS holds it to the host's SOFs.
+    __HAL_RCC_CRS_CLK_ENABLE();
+    RCC_CRSInitTypeDef crs    = {};
+    crs.Prescaler             = RCC_CRS_SYNC_DIV1;
+    crs.Source                = RCC_CRS_SYNC_SOURCE_USB2;
+    crs.Polarity              = RCC_CRS_SYNC_POLARITY_RISING;
+    crs.ReloadValue           = __HAL_RCC_CRS_RELOADVALUE_CALCULATE(48000000, 1000);
+    crs.ErrorLimitValue       = RCC_CRS_ERRORLIMIT_DEFAULT;
+    crs.HSI48CalibrationValue = RCC_CRS_HSI48CALIBRATION_DEFAULT;
+    HAL_RCCEx_CRSConfig(&crs);
+
+    PCD_HandleTypeDef& pcd            = usb_audio_pcd;
+    pcd.Instance                      = USB_OTG_FS;
+    pcd.Init.dev_endpoints            = 9;
+    pcd.Init.speed                    = PCD_SPEED_FULL;
+    pcd.Init.dma_enable               = DISABLE;
+    pcd.Init.phy_itface               = PCD_PHY_EMBEDDED;
+    pcd.Init.Sof_enable               = ENABLE;
+    pcd.Init.low_power_enable         = DISABLE;
+    pcd.Init.lpm_enable               = DISABLE;
+    pcd.Init.battery_charging_enable  = DISABLE;
+    pcd.Init.vbus_sensing_enable      = DISABLE; // VBUS is not on PA9
+    pcd.Init.use_dedicated_ep1        = DISABLE;
+    if(HAL_PCD_Init(&pcd) != HAL_OK)
+        return Result::ERR;
+
+    // 4 KB of FIFO RAM, in words: two full data packets in, EP0 and the
+    // feedback out.
+    HAL_PCDEx_SetRxFiFo(&pcd, 0x200);
+    HAL_PCDEx_SetTxFiFo(&pcd, 0, 0x40);
+    HAL_PCDEx_SetTxFiFo(&pcd, 1, 0x40);
+
+    // Under the audio interrupts: the FIFO in between needs no lock.
+    HAL_NVIC_SetPriority(OTG_FS_IRQn, IRQ_PRIORITY_USB, 0);
+    HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
+    return HAL_PCD_Start(&pcd) == HAL_OK ? Result::OK : Result::ERR;
+}
+
+template <bool add>
+size_t UsbAudio::Pull(float* l, float* r, size_t size)
+{
+    const float kScale = 1.0f / 2147483648.0f;
+    uint32_t    tail   = tail_;
+    size_t      n      = 0;
+    if(primed_)
+    {
+        const uint32_t fill = head_ - tail;
+        n                   = fill < size ? fill : size;
+        for(size_t i = 0; i < n; i++, tail++)
+        {
+            const int32_t* frame = &fifo_[2 * (tail % kFifoFrames)];
+            const float    a     = (float)frame[0] * kScale;
+            const float    b     = (float)frame[1] * kScale;
+            l[i]                 = add ? l[i] + a : a;
+            r[i]                 = add ? r[i] + b : b;
+        }
+        tail_ = tail;
+        if(n < size)
+        {
+            // Wait for kTargetFrames again rather than click every block.
+            underruns_++;
+            primed_ = false;
+        }
+    }
+    else if(head_ - tail >= kTargetFrames)
+    {
+        primed_ = true;
+    }
+    if(!add)
+    {
+        for(size_t i = n; i < size; i++)
+            l[i] = r[i] = 0.0f;
+    }
+    return n;
+}
+
+size_t UsbAudio::Read(float* l, float* r, size_t size)
+{
+    return Pull<false>(l, r, size);
+}
+
+size_t UsbAudio::Add(float* l, float* r, size_t size)
+{
+    return Pull<true>(l, r, size);
+}
+
+void UsbAudio::Push(const uint8_t* data, size_t bytes)
+{
+    const uint32_t head   = head_;
+    const uint32_t room   = kFifoFrames - (head - tail_);
+    size_t         frames = bytes / kFrameBytes;
+    if(frames > room)
+    {
+        overruns_ += frames - room;
+        frames = room;
+    }
+    int32_t* fifo = fifo_;
+    for(size_t i = 0; i < frames; i++)
+    {
+        int32_t* frame = &fifo[2 * ((head + i) % kFifoFrames)];
+        memcpy(frame, data + i * kFrameBytes, kFrameBytes);
+    }
+    head_ = head + frames;
+}
+
+void UsbAudio::SetStreaming(bool on)
+{
+    if(on)
+    {
+        HAL_PCD_EP_Open(pcd_, kEpData, kMaxDataSize, EP_TYPE_ISOC);
+        HAL_PCD_EP_Open(pcd_, kEpFeedback, 3, EP_TYPE_ISOC);
+        HAL_PCD_EP_Receive(pcd_, kEpData, rx_, kMaxDataSize);
+        // Nothing stale from an earlier stream: the audio interrupt only
+        // preempts this one, so it never sees tail_ move under it.
+        tail_ = head_;
+    }
+    else
+    {
+        HAL_PCD_EP_Close(pcd_, kEpData);
+        HAL_PCD_EP_Flush(pcd_, kEpFeedback);
+        HAL_PCD_EP_Close(pcd_, kEpFeedback);
+        primed_ = false;
+    }
+    feedback_busy_ = false;
+    fill_avg_      = (int32_t)kTargetFrames << 6;
+    idle_sofs_     = 0;
+}
+
+void UsbAudio::SendControl(const void* data, size_t size)
+{
+    const size_t length = setup_[6] | (setup_[7] << 8);
+    if(size > length)
+        size = length;
+    ep0_data_ = (const uint8_t*)data;
+    ep0_left_ = size;
+    // A reply short of what was asked ends with a short packet.
+    ep0_zlp_ = size < length && size % kEp0Size == 0;
+    ep0_out_ = false;
+    const size_t chunk = size < kEp0Size ? size : kEp0Size;
+    ep0_left_ -= chunk;
+    ep0_data_ += chunk;
+    HAL_PCD_EP_Transmit(pcd_, 0x80, (uint8_t*)data, chunk);
+}
+
+void UsbAudio::SendStatus()
+{
+    HAL_PCD_EP_Transmit(pcd_, 0x80, nullptr, 0);
+}
+
+void UsbAudio::Stall()
+{
+    HAL_PCD_EP_SetStall(pcd_, 0x80);
+    HAL_PCD_EP_SetStall(pcd_, 0x00);
+}
+
+void UsbAudio::OnSetup()
+{
+    memcpy(setup_, pcd_->Setup, sizeof(setup_));
+    ep0_left_ = 0;
+    ep0_zlp_  = false;
+    ep0_out_  = false;
+    switch(setup_[0] & 0x60)
+    {
+        case 0x00: StandardRequest(); break;
+        case 0x20: ClassRequest(); break;
+        default: Stall(); break;
+    }
+}
+
+void UsbAudio::StandardRequest()
+{
+    const uint8_t  request   = setup_[1];
+    const uint16_t value     = setup_[2] | (setup_[3] << 8);
+    const uint8_t  recipient = setup_[0] & 0x1F;
+    switch(request)
+    {
+        case 0x00: // GET_STATUS
+            ep0_buf_[0] = ep0_buf_[1] = 0;
+            SendControl(ep0_buf_, 2);
+            return;
+        case 0x01: // CLEAR_FEATURE
+        case 0x03: // SET_FEATURE
+            SendStatus();
+            return;
+        case 0x05: // SET_ADDRESS, applied ahead of the status stage on OTG
+            address_ = value & 0x7F;
+            HAL_PCD_SetAddress(pcd_, address_);
+            SendStatus();
+            return;
+        case 0x06: // GET_DESCRIPTOR
+            switch(value >> 8)
+            {
+                case 0x01:
+                    SendControl(kDeviceDescriptor, sizeof(kDeviceDescriptor));
+                    return;
+                case 0x02:
+                    SendControl(kConfigDescriptor, sizeof(kConfigDescriptor));
+                    return;
+                case 0x03:
+                {
+                    const uint8_t index = value & 0xFF;
+                    if(index == 0)
+                    {
+                        SendControl(kLanguages, sizeof(kLanguages));
+                        return;
+                    }
+                    if(index >= sizeof(kStrings) / sizeof(kStrings[0]))
+                        break;
+                    // UTF-16 of an ASCII string, built in place.
+                    static uint8_t string[2 + 2 * 32];
+                    size_t         n = 0;
+                    for(const char* c = kStrings[index]; *c && n < 32; c++, n++)
+                    {
+                        string[2 + 2 * n] = (uint8_t)*c;
+                        string[3 + 2 * n] = 0;
+                    }
+                    string[0] = (uint8_t)(2 + 2 * n);
+                    string[1] = 0x03;
+                    SendControl(string, string[0]);
+                    return;
+                }
+                default: break; // no qualifier: full speed only
+            }
+            break;
+        case 0x08: // GET_CONFIGURATION
+            ep0_buf_[0] = config_;
+            SendControl(ep0_buf_, 1);
+            return;
+        case 0x09: // SET_CONFIGURATION
+            if(value > 1)
+                break;
+            if(config_ && alt_)
+                SetStreaming(false);
+            config_ = (uint8_t)value;
+            alt_    = 0;
+            SendStatus();
+            return;
+        case 0x0A: // GET_INTERFACE
+            if(recipient != 0x01)
+                break;
+            ep0_buf_[0] = setup_[4] == kInterfaceStreaming ? alt_ : 0;
+            SendControl(ep0_buf_, 1);
+            return;
+        case 0x0B: // SET_INTERFACE
+            if(recipient != 0x01 || !config_)
+                break;
+            if(setup_[4] == kInterfaceStreaming && value <= 1)
+            {
+                if(value != alt_)
+                    SetStreaming(value == 1);
+                alt_ = (uint8_t)value;
+            }
+            else if(setup_[4] != kInterfaceControl || value != 0)
+            {
+                break;
+            }
+            SendStatus();
+            return;
+        default: break;
+    }
+    Stall();
+}
+
+void UsbAudio::ClassRequest()
+{
+    // Only the clock source has controls: its rate and validity.
+    const uint8_t request  = setup_[1];
+    const uint8_t selector = setup_[3];
+    const uint8_t entity   = setup_[5];
+    const bool    in       = setup_[0] & 0x80;
+    if((setup_[0] & 0x1F) != 0x01 || setup_[4] != kInterfaceControl
+       || entity != kClockId)
+    {
+        Stall();
+        return;
+    }
+    if(selector == 0x01 && request == 0x01 && in) // SAM_FREQ CUR
+    {
+        memcpy(ep0_buf_, &sample_rate_, 4);
+        SendControl(ep0_buf_, 4);
+    }
+    else if(selector == 0x01 && request == 0x02 && in) // SAM_FREQ RANGE
+    {
+        // One subrange, min = max, no step.
+        ep0_buf_[0] = 1;
+        ep0_buf_[1] = 0;
+        memcpy(&ep0_buf_[2], &sample_rate_, 4);
+        memcpy(&ep0_buf_[6], &sample_rate_, 4);
+        memset(&ep0_buf_[10], 0, 4);
+        SendControl(ep0_buf_, 14);
+    }
+    else if(selector == 0x01 && request == 0x01) // SET SAM_FREQ CUR
+    {
+        // Taken and ignored: the rate is the codec's. Hosts only ask for
+        // the one rate the range offers.
+        ep0_out_ = true;
+        HAL_PCD_EP_Receive(pcd_, 0x00, ep0_buf_, 4);
+    }
+    else if(selector == 0x02 && request == 0x01 && in) // CLOCK_VALID CUR
+    {
+        ep0_buf_[0] = 1;
+        SendControl(ep0_buf_, 1);
+    }
+    else
+    {
+        Stall();
+    }
+}
+
+void UsbAudio::OnDataOut(uint8_t ep)
+{
+    if(ep == 0)
+    {
+        // The end of an OUT data stage; a status ZLP needs nothing.
+        if(ep0_out_)
+        {
+            ep0_out_ = false;
+            SendStatus();
+        }
+        return;
+    }
+    if(ep == (kEpData & 0x7F))
+    {
+        Push(rx_, HAL_PCD_EP_GetRxCount(pcd_, kEpData));
+        idle_sofs_ = 0;
+        HAL_PCD_EP_Receive(pcd_, kEpData, rx_, kMaxDataSize);
+    }
+}
+
+void UsbAudio::OnDataIn(uint8_t ep)
+{
+    if(ep == 0)
+    {
+        if(ep0_left_ > 0)
+        {
+            const size_t chunk = ep0_left_ < kEp0Size ? ep0_left_ : kEp0Size;
+            HAL_PCD_EP_Transmit(pcd_, 0x80, (uint8_t*)ep0_data_, chunk);
+            ep0_data_ += chunk;
+            ep0_left_ -= chunk;
+        }
+        else if(ep0_zlp_)
+        {
+            ep0_zlp_ = false;
+            HAL_PCD_EP_Transmit(pcd_, 0x80, nullptr, 0);
+        }
+        else
+        {
+            // Data stage done: the host's status ZLP.
+            HAL_PCD_EP_Receive(pcd_, 0x00, nullptr, 0);
+        }
+        return;
+    }
+    if(ep == (kEpFeedback & 0x7F))
+        feedback_busy_ = false;
+}
+
+void UsbAudio::OnSof()
+{
+    if(alt_ != 1)
+        return;
+    if(++idle_sofs_ > kIdleSofs && primed_)
+    {
+        // The host paused without leaving alternate 1.
+        primed_ = false;
+        tail_   = head_;
+    }
+
+    // Steer the smoothed fill to the target: a full FIFO asks for less.
+    const int32_t fill = (int32_t)(head_ - tail_) << 6;
+    fill_avg_ += (fill - fill_avg_) / 64;
+    const int32_t error  = ((int32_t)kTargetFrames << 6) - fill_avg_;
+    const int32_t range  = (int32_t)nominal_ >> kFeedbackRangeShift;
+    int32_t       adjust = error * (1 << kFeedbackGainShift) / 64;
+    adjust = adjust > range ? range : (adjust < -range ? -range : adjust);
+
+    if(feedback_busy_)
+        return;
+    const uint32_t feedback = nominal_ + adjust;
+    feedback_[0]            = feedback & 0xFF;
+    feedback_[1]            = (feedback >> 8) & 0xFF;
+    feedback_[2]            = (feedback >> 16) & 0xFF;
+    feedback_busy_          = true;
+    HAL_PCD_EP_Transmit(pcd_, kEpFeedback, feedback_, 3);
+}
+
+void UsbAudio::OnReset()
+{
+    HAL_PCD_EP_Open(pcd_, 0x00, kEp0Size, EP_TYPE_CTRL);
+    HAL_PCD_EP_Open(pcd_, 0x80, kEp0Size, EP_TYPE_CTRL);
+    if(alt_)
+        SetStreaming(false);
+    config_  = 0;
+    alt_     = 0;
+    address_ = 0;
+}
+
+void UsbAudio::OnIsoOutIncomplete()
+{
+    if(alt_ == 1)
+        HAL_PCD_EP_Receive(pcd_, kEpData, rx_, kMaxDataSize);
+}
+
+void UsbAudio::OnIsoInIncomplete()
+{
+    // The host skipped a poll: drop the stale value, send a fresh one.
+    if(feedback_busy_)
+    {
+        HAL_PCD_EP_Flush(pcd_, kEpFeedback);
+        feedback_busy_ = false;
+    }
+}
+
+// The HAL's weak PCD callbacks, all from the OTG interrupt.
+extern "C" void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef* hpcd)
+{
+    if(usb_audio_owner)
+        usb_audio_owner->OnSetup();
+}
+
+extern "C" void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef* hpcd,
+                                             uint8_t            epnum)
+{
+    if(usb_audio_owner)
+        usb_audio_owner->OnDataOut(epnum);
+}
+
+extern "C" void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef* hpcd,
+                                            uint8_t            epnum)
+{
+    if(usb_audio_owner)
+        usb_audio_owner->OnDataIn(epnum);
+}
+
+extern "C" void HAL_PCD_SOFCallback(PCD_HandleTypeDef* hpcd)
+{
+    if(usb_audio_owner)
+        usb_audio_owner->OnSof();
+}
+
+extern "C" void HAL_PCD_ResetCallback(PCD_HandleTypeDef* hpcd)
+{
+    if(usb_audio_owner)
+        usb_audio_owner->OnReset();
+}
+
+extern "C" void HAL_PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef* hpcd,
+                                                 uint8_t            epnum)
+{
+    if(usb_audio_owner)
+        usb_audio_owner->OnIsoOutIncomplete();
+}
+
+extern "C" void HAL_PCD_ISOINIncompleteCallback(PCD_HandleTypeDef* hpcd,
+                                                uint8_t            epnum)
+{
+    if(usb_audio_owner)
+        usb_audio_owner->OnIsoInIncomplete();
+}
+
+extern "C" void OTG_FS_IRQHandler(void)
+{
+    HAL_PCD_IRQHandler(&usb_audio_pcd);
+}
+
+#endif // !USBCON && HAL_PCD_MODULE_ENABLED
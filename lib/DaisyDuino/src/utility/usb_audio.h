@@ -0,0 +1,138 @@
+#pragma once
+#ifndef DSY_USB_AUDIO_H
+#define DSY_USB_AUDIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+// The Arduino core's USB stack (USBCON, for CDC serial) owns the same
+// peripheral and interrupt; UsbAudio is only there without it, and with
+// the HAL PCD driver built (HAL_PCD_MODULE_ENABLED).
+#if !defined(USBCON) && defined(HAL_PCD_MODULE_ENABLED)
+
+namespace daisy
+{
+/** USB Audio Class 2.0 stereo input on the Seed's own USB port.
+
+    The board enumerates as a two-channel, 24-bit speaker at the codec's
+    sample rate, and the audio callback takes what the host plays with
+    Read() (in place of the codec input) or Add() (mixed into it). The
+    stream is asynchronous: the SAI clock is the master, and an explicit
+    feedback endpoint tells the host how many frames per millisecond to
+    send, steered by how full the FIFO between the USB interrupt and the
+    callback runs. The host then follows the codec crystal, with nothing
+    resampled on the board.
+
+    Latency is the FIFO's target fill, kTargetFrames (4 ms at 96 kHz),
+    plus one block. Until the FIFO first reaches it, and after any
+    underrun, Read() returns silence; Underruns() and Overruns() count
+    the glitches.
+
+    Full-speed only (OTG FS, PA11 / PA12), 48 or 96 kHz. No volume or
+    mute control: the host's mixer does that before it sends. Builds
+    without USBCON, so not together with USB serial. The HAL PCD driver
+    does the endpoint work; the device requests, the UAC2 descriptors
+    and the clock source requests are answered here.
+
+    usage:
+
+    static UsbAudio usb_audio;
+    usb_audio.Init(DAISY.get_samplerate()); // after DAISY.init()
+    ...
+    usb_audio.Read(out[0], out[1], size); // in the audio callback
+*/
+class UsbAudio
+{
+  public:
+    enum class Result
+    {
+        OK,
+        ERR,
+    };
+
+    /** FIFO capacity and the fill the feedback steers for, in frames */
+    static constexpr size_t kFifoFrames   = 1024;
+    static constexpr size_t kTargetFrames = 384;
+
+    UsbAudio() {}
+    ~UsbAudio() {}
+
+    /** Starts the USB device and connects to the host.
+        \param sample_rate The codec rate, 48000 or 96000
+    */
+    Result Init(float sample_rate);
+
+    /** From the audio callback: size frames of the host's stream into
+        l and r, silence where there is none. \return frames from USB */
+    size_t Read(float* l, float* r, size_t size);
+
+    /** As Read(), added to what l and r hold */
+    size_t Add(float* l, float* r, size_t size);
+
+    /** \return true while the host streams and the FIFO is primed */
+    bool IsStreaming() const { return primed_; }
+
+    /** Frames waiting in the FIFO */
+    size_t Fill() const { return head_ - tail_; }
+
+    /** Callback reads that found the FIFO short, since Init() */
+    uint32_t Underruns() const { return underruns_; }
+
+    /** Frames dropped from USB packets that found the FIFO full */
+    uint32_t Overruns() const { return overruns_; }
+
+    /** Device side of the PCD callbacks; not for users */
+    void OnSetup();
+    void OnDataOut(uint8_t ep);
+    void OnDataIn(uint8_t ep);
+    void OnSof();
+    void OnReset();
+    void OnIsoOutIncomplete();
+    void OnIsoInIncomplete();
+
+  private:
+    template <bool add>
+    size_t Pull(float* l, float* r, size_t size);
+    void   Push(const uint8_t* data, size_t bytes);
+    void   StandardRequest();
+    void   ClassRequest();
+    void   SendControl(const void* data, size_t size);
+    void   SendStatus();
+    void   Stall();
+    void   SetStreaming(bool on);
+
+    PCD_HandleTypeDef* pcd_;
+    uint32_t           sample_rate_;
+    uint32_t           nominal_; // host frames per 1 ms, 10.14
+    uint8_t            config_;
+    uint8_t            alt_;
+    uint8_t            address_;
+
+    // EP0: the request being answered and what is left of its data stage
+    uint8_t        setup_[8];
+    uint8_t        ep0_buf_[16];
+    const uint8_t* ep0_data_;
+    size_t         ep0_left_;
+    bool           ep0_zlp_;
+    bool           ep0_out_;
+
+    uint8_t  feedback_[4];
+    bool     feedback_busy_;
+    int32_t  fill_avg_; // FIFO fill, 1/64 frames, smoothed per SOF
+    uint32_t idle_sofs_;
+
+    // FIFO of left-justified 24-in-32 frames, USB interrupt to callback
+    int32_t           fifo_[2 * kFifoFrames];
+    volatile uint32_t head_;
+    volatile uint32_t tail_;
+    volatile bool     primed_;
+    uint32_t          underruns_;
+    uint32_t          overruns_;
+
+    uint8_t rx_[1024] __attribute__((aligned(4)));
+};
+
+} // namespace daisy
+#endif // !USBCON && HAL_PCD_MODULE_ENABLED
+#endif
@@ -0,0 +1,117 @@
+#include "wcet_tracker.h"
+#include "section_profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace daisy;
+
+void WcetTracker::Init(uint32_t period_cycles)
+{
+    period_cycles_    = period_cycles;
+    threshold_cycles_ = (uint32_t)((float)period_cycles * threshold_);
+    worst_            = 0;
+    blocks_           = 0;
+    overruns_         = 0;
+    reset_            = false;
+    scratch_          = {};
+    capture_.Write(scratch_);
+}
+
+void WcetTracker::SetTrigger(uint32_t pin, float threshold)
+{
+    ClearTrigger();
+    threshold_        = threshold;
+    threshold_cycles_ = (uint32_t)((float)period_cycles_ * threshold);
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    trigger_ = digitalPinToPinName(pin);
+}
+
+void WcetTracker::ClearTrigger()
+{
+    const PinName trigger = trigger_;
+    trigger_              = NC;
+    if(trigger != NC)
+        digitalWriteFast(trigger, LOW);
+}
+
+void WcetTracker::Reset()
+{
+    reset_ = true;
+}
+
+void WcetTracker::Publish(uint32_t cycles, uint32_t block, uint32_t frame)
+{
+    scratch_.cycles        = cycles;
+    scratch_.period_cycles = period_cycles_;
+    scratch_.block         = block;
+    scratch_.frame         = frame;
+    scratch_.num_sections  = 0;
+#if defined(DSY_PROFILE)
+    size_t                                 count;
+    const SectionProfiler::BlockSection* s = section_profiler.LastBlock(count);
+    count = count < kMaxSections ? count : kMaxSections;
+    for(size_t i = 0; i < count; i++)
+        scratch_.sections[i] = {s[i].name, s[i].cycles, s[i].depth};
+    scratch_.num_sections = count;
+#endif
+    capture_.Write(scratch_);
+}
+
+void WcetTracker::Print(::Print& out) const
+{
+    Capture c;
+    Read(c);
+    char line[128];
+    if(c.cycles == 0)
+    {
+        snprintf(line,
+                 sizeof(line),
+                 "wcet: no block yet, %lu over threshold\r\n",
+                 (unsigned long)overruns_);
+        out.print(line);
+        return;
+    }
+    // Tenths of a percent, integers only: newlib-nano has no %f.
+    const uint32_t share
+        = (uint32_t)((uint64_t)c.cycles * 1000 / (c.period_cycles ? c.period_cycles : 1));
+    snprintf(line,
+             sizeof(line),
+             "wcet: %lu cycles (%lu.%lu%% of %lu) at block %lu, frame %lu; "
+             "%lu over threshold\r\n",
+             (unsigned long)c.cycles,
+             (unsigned long)(share / 10),
+             (unsigned long)(share % 10),
+             (unsigned long)c.period_cycles,
+             (unsigned long)c.block,
+             (unsigned long)c.frame,
+             (unsigned long)overruns_);
+    out.print(line);
+    for(size_t i = 0; i < c.num_sections; i++)
+    {
+        const Section& s = c.sections[i];
+        char           name[25];
+        snprintf(name, sizeof(name), "%*s%s", 2 * s.depth + 2, "", s.name);
+#if defined(DSY_PROFILE)
+        const uint32_t avg = section_profiler.AverageCycles(s.name, s.depth);
+#else
+        const uint32_t avg = 0;
+#endif
+        // How far over its average the section ran in the worst block.
+        if(avg > 0)
+            snprintf(line,
+                     sizeof(line),
+                     "%-24s %9lu  avg %9lu  %+ld%%\r\n",
+                     name,
+                     (unsigned long)s.cycles,
+                     (unsigned long)avg,
+                     (long)(((int64_t)s.cycles - avg) * 100 / avg));
+        else
+            snprintf(line,
+                     sizeof(line),
+                     "%-24s %9lu\r\n",
+                     name,
+                     (unsigned long)s.cycles);
+        out.print(line);
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+#ifndef DSY_WCET_TRACKER_H
+#define DSY_WCET_TRACKER_H
+
+#include "Arduino.h"
+#include "seqlock.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stm32h7xx_hal.h>
+
+namespace daisy
+{
+/** Worst-case callback time, with the context of the block it happened
+    in.
+
+    The average load hides the one block in ten thousand that runs past
+    its period and clicks. AudioHandle times every callback with this as
+    well as the CpuLoadMeter, and keeps a Capture of the slowest one
+    since Reset(): its cycles, its block index and first frame, and, in
+    -DDSY_PROFILE builds, what each profiled section took in that block
+    (SectionProfiler::LastBlock), so Print() can set them against their
+    averages. The M7 has no cache-miss counter to add: the DWT's stall
+    counters are 8 bits wide and wrap many times a block.
+
+    The first kSettleBlocks blocks after Init() or Reset() are left out
+    of the worst case: the cold caches of a fresh start would otherwise
+    hide every later spike. They still count as overruns.
+
+    SetTrigger() pulses a pin around every block over a threshold
+    (default the block period), high from the end of the late callback
+    to the end of the next, for a logic analyser to trigger on.
+
+    From loop(): DAISY.Wcet().Print(Serial) once a second.
+*/
+class WcetTracker
+{
+  public:
+    static constexpr size_t   kMaxSections  = 16;
+    static constexpr uint32_t kSettleBlocks = 16;
+
+    struct Section
+    {
+        const char* name;
+        uint32_t    cycles;
+        uint8_t     depth;
+    };
+
+    /** The slowest block since Reset() */
+    struct Capture
+    {
+        uint32_t cycles;        // 0 until a block has been timed
+        uint32_t period_cycles; // the block period it ran against
+        uint32_t block;         // blocks since Reset()
+        uint32_t frame;         // AudioFrameCount() at its first frame
+        size_t   num_sections;
+        Section  sections[kMaxSections];
+    };
+
+    WcetTracker() {}
+    ~WcetTracker() {}
+
+    /** Sets the block period and clears the capture. AudioHandle calls
+        it on every start, as it does CpuLoadMeter::Init(). */
+    void Init(uint32_t period_cycles);
+
+    /** Pulses pin on every block over threshold times the period.
+        Leaves the pin configured as an output. */
+    void SetTrigger(uint32_t pin, float threshold = 1.0f);
+
+    /** Stops the trigger pulses, leaving the pin low */
+    void ClearTrigger();
+
+    /** Call first thing in the audio callback, after CpuLoadMeter */
+    inline void OnBlockStart() { start_ = DWT->CYCCNT; }
+
+    /** Call last thing in the audio callback
+        \param frame the block's first frame, SaiHandle::GetBlockFrame() */
+    inline void OnBlockEnd(uint32_t frame)
+    {
+        const uint32_t cycles = DWT->CYCCNT - start_;
+        if(reset_)
+        {
+            worst_    = 0;
+            blocks_   = 0;
+            overruns_ = 0;
+            reset_    = false;
+        }
+        const uint32_t block = blocks_++;
+        const bool     late  = cycles > threshold_cycles_;
+        if(late)
+            overruns_++;
+        // One store a block: low again after the next on-time block.
+        const PinName trigger = trigger_;
+        if(trigger != NC)
+            digitalWriteFast(trigger, late ? HIGH : LOW);
+        if(cycles > worst_ && block >= kSettleBlocks)
+        {
+            worst_ = cycles;
+            Publish(cycles, block, frame);
+        }
+    }
+
+    /** Copies the slowest block since Reset() into out, from any
+        context below the audio interrupt */
+    void Read(Capture& out) const { capture_.Read(out); }
+
+    /** Blocks over the trigger threshold since Reset() */
+    uint32_t Overruns() const { return overruns_; }
+
+    /** Starts a new capture window at the next block */
+    void Reset();
+
+    /** From loop(): writes the capture, one line per section in
+        -DDSY_PROFILE builds */
+    void Print(::Print& out) const;
+
+  private:
+    void Publish(uint32_t cycles, uint32_t block, uint32_t frame);
+
+    uint32_t          start_;
+    uint32_t          worst_;
+    uint32_t          blocks_;
+    uint32_t          period_cycles_ = 0;
+    volatile uint32_t threshold_cycles_;
+    volatile uint32_t overruns_;
+    volatile bool     reset_;
+    float             threshold_ = 1.0f;
+    volatile PinName  trigger_   = NC;
+    Capture           scratch_;
+    Seqlock<Capture>  capture_;
+};
+
+} // namespace daisy
+#endif
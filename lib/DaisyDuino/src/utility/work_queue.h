@@ -0,0 +1,122 @@
+#pragma once
+#ifndef DSY_WORK_QUEUE_H
+#define DSY_WORK_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "spsc_ring.h"
+
+namespace daisy
+{
+/** Jobs the audio callback hands to a lower priority context to run.
+
+    Designing a filter, retuning a carrier or building a FIR table takes
+    longer than a block can spare. The callback Post()s it instead, a
+    function, a context and a few float arguments, and the executor
+    runs it later with Run(): from loop(), or from the control callback
+    (PendSV at IRQ_PRIORITY_CONTROL), which the audio callback preempts
+    but which does not wait on loop(). Use one executor, since the
+    queue is an SpscRing: each side only owns one index, so posting
+    never waits and never masks an interrupt.
+
+    The job hands its result back without a lock either: a ParamBlock
+    the job Publish()es and the callback Acquire()s at the start of
+    its next block. A full queue drops the post and counts it, so post
+    on change rather than every block.
+
+    usage:
+
+    static WorkQueue<8>             work;
+    static ParamBlock<BiquadCoeffs> hp;
+
+    static void DesignHighpass(void* ctx, const float* args)
+    {
+        hp.Publish(Design(args[0], args[1]));
+    }
+    ...
+    // AudioCallback
+    if(cutoff != last_cutoff)
+        work.Post(DesignHighpass, nullptr, cutoff, 0.7f);
+    const BiquadCoeffs& c = hp.Acquire();
+    ...
+    // loop()
+    work.Run();
+
+    \param N jobs that may wait, a power of two
+*/
+template <size_t N>
+class WorkQueue
+{
+  public:
+    /** Floats a job carries */
+    static constexpr size_t kMaxArgs = 4;
+
+    /** A job: ctx and its arguments, copied in when posted */
+    typedef void (*JobFn)(void* ctx, const float* args);
+
+    WorkQueue() : dropped_(0) {}
+    ~WorkQueue() {}
+
+    /** Producer: queues fn(ctx, args).
+        \return false, counting a drop, if the queue is full
+    */
+    bool Post(JobFn fn,
+              void* ctx,
+              float a0 = 0.0f,
+              float a1 = 0.0f,
+              float a2 = 0.0f,
+              float a3 = 0.0f)
+    {
+        Job job;
+        job.fn      = fn;
+        job.ctx     = ctx;
+        job.args[0] = a0;
+        job.args[1] = a1;
+        job.args[2] = a2;
+        job.args[3] = a3;
+        if(ring_.Push(job))
+            return true;
+        dropped_ = dropped_ + 1;
+        return false;
+    }
+
+    /** Consumer: runs waiting jobs in order, up to max_jobs of them,
+        each finishing before the next starts.
+        \return jobs run
+    */
+    size_t Run(size_t max_jobs = N)
+    {
+        size_t run = 0;
+        while(run < max_jobs)
+        {
+            // Runs in place; the slot is released once the job is done.
+            const Job* job = ring_.Peek();
+            if(job == nullptr)
+                break;
+            job->fn(job->ctx, job->args);
+            ring_.Discard();
+            run++;
+        }
+        return run;
+    }
+
+    /** Either side: jobs waiting */
+    inline size_t Pending() const { return ring_.Size(); }
+
+    /** Posts dropped on a full queue so far */
+    inline uint32_t GetDropped() const { return dropped_; }
+
+  private:
+    struct Job
+    {
+        JobFn fn;
+        void* ctx;
+        float args[kMaxArgs];
+    };
+
+    SpscRing<Job, N>  ring_;
+    volatile uint32_t dropped_;
+};
+
+} // namespace daisy
+#endif
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+# Records a pipeline tap from a MODULATOR_CAPTURE build over USB serial
+# (include/audio_capture.h) into a 16-bit WAV file:
+#
+#   python3 scripts/capture.py /dev/ttyACM0 out.wav --point 0 --seconds 5
+#   python3 scripts/capture.py /dev/ttyACM0 out.wav --point 3 --spectrum
+#
+# Points as in src/main.cpp: 0 baseband, 1 after the modulator, 2 after
+# the band-pass, 3 output. --decimate N keeps every Nth frame (no
+# filter: only for the baseband points), --channel l|r|both picks what
+# is sent. Lost packets show as sequence gaps and are reported; the file
+# closes the gaps with silence so its timing stays right.
+#
+# --spectrum prints the strongest peaks of a Hann-windowed FFT of the
+# left (or only) channel. The file also feeds the host runner and
+# golden.py --speech, e.g. a baseband capture as a real-world stimulus.
+#
+# Standard library only; POSIX serial ports.
+
+import argparse
+import array
+import math
+import os
+import struct
+import sys
+import termios
+import time
+import wave
+
+MAGIC = b"DCAP"
+PACKET_FRAMES = 64
+HEADER = struct.Struct("<4sIIBBH")
+PACKET_BYTES = HEADER.size + 2 * 2 * PACKET_FRAMES
+
+CHANNELS = {"l": 1, "r": 2, "both": 3}
+
+
+def _open(port):
+    fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0  # iflag
+    attrs[1] = 0  # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0  # lflag: raw
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 1
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def _packets(fd, seconds):
+    # Yields (header fields, samples) until seconds of data have come in.
+    buf = b""
+    deadline = None
+    while deadline is None or time.monotonic() < deadline:
+        chunk = os.read(fd, 65536)
+        if not chunk:
+            continue
+        buf += chunk
+        while True:
+            at = buf.find(MAGIC)
+            if at < 0:
+                buf = buf[-3:]
+                break
+            if len(buf) - at < PACKET_BYTES:
+                buf = buf[at:]
+                break
+            _, seq, rate, point, channels, frames = HEADER.unpack_from(buf, at)
+            samples = array.array("h")
+            samples.frombytes(buf[at + HEADER.size : at + PACKET_BYTES])
+            if sys.byteorder != "little":
+                samples.byteswap()
+            width = 2 if channels == 3 else 1
+            yield seq, rate, point, channels, samples[: frames * width]
+            buf = buf[at + PACKET_BYTES :]
+            if deadline is None:
+                deadline = time.monotonic() + seconds
+
+
+def _fft(x):
+    # Iterative radix-2, in place on a list of complex.
+    n = len(x)
+    j = 0
+    for i in range(1, n):
+        bit = n >> 1
+        while j & bit:
+            j ^= bit
+            bit >>= 1
+        j |= bit
+        if i < j:
+            x[i], x[j] = x[j], x[i]
+    size = 2
+    while size <= n:
+        w = complex(math.cos(2 * math.pi / size), -math.sin(2 * math.pi / size))
+        for start in range(0, n, size):
+            t = 1 + 0j
+            for k in range(size // 2):
+                a = x[start + k]
+                b = x[start + k + size // 2] * t
+                x[start + k] = a + b
+                x[start + k + size // 2] = a - b
+                t *= w
+        size *= 2
+    return x
+
+
+def _spectrum(samples, rate, stride, peaks=8, n=16384):
+    mono = samples[0::stride]
+    n = min(n, 1 << (len(mono).bit_length() - 1))
+    if n < 256:
+        print("spectrum: too few samples")
+        return
+    mono = mono[len(mono) - n :]
+    x = [
+        complex(mono[i] / 32768.0 * (0.5 - 0.5 * math.cos(2 * math.pi * i / n)), 0.0)
+        for i in range(n)
+    ]
+    mag = [abs(v) * 4.0 / n for v in _fft(x)[: n // 2]]  # Hann: 2 for one side, 2 for the window
+    found = []
+    for k in range(1, n // 2 - 1):
+        if mag[k] > mag[k - 1] and mag[k] >= mag[k + 1] and mag[k] > 1e-6:
+            found.append((mag[k], k))
+    found.sort(reverse=True)
+    print("spectrum: %d-point FFT, %.1f Hz bins" % (n, rate / n))
+    for m, k in found[:peaks]:
+        print("  %9.1f Hz  %6.1f dBFS" % (k * rate / n, 20.0 * math.log10(m)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Record a pipeline tap over USB serial")
+    parser.add_argument("port")
+    parser.add_argument("out")
+    parser.add_argument("--point", type=int, default=3)
+    parser.add_argument("--decimate", type=int, default=1)
+    parser.add_argument("--channel", choices=sorted(CHANNELS), default="both")
+    parser.add_argument("--seconds", type=float, default=5.0)
+    parser.add_argument("--spectrum", action="store_true")
+    args = parser.parse_args()
+
+    fd = _open(args.port)
+    command = "tap %d %d %d\n" % (args.point, args.decimate, CHANNELS[args.channel])
+    os.write(fd, command.encode())
+
+    samples = array.array("h")
+    rate = channels = None
+    expected = None
+    lost = 0
+    try:
+        for seq, r, point, ch, data in _packets(fd, args.seconds):
+            if point != args.point or ch != CHANNELS[args.channel]:
+                continue  # still from an earlier selection
+            if rate is None:
+                rate, channels = r, ch
+            if expected is not None and seq != expected:
+                gap = (seq - expected) & 0xFFFFFFFF
+                lost += gap
+                samples.extend([0] * (gap * len(data)))
+            expected = (seq + 1) & 0xFFFFFFFF
+            samples.extend(data)
+    finally:
+        os.write(fd, b"tap off\n")
+        os.close(fd)
+
+    if rate is None:
+        print("no packets from point %d; is this a MODULATOR_CAPTURE build?" % args.point)
+        return 1
+    width = 2 if channels == 3 else 1
+    with wave.open(args.out, "wb") as w:
+        w.setnchannels(width)
+        w.setsampwidth(2)
+        w.setframerate(rate)
+        data = array.array("h", samples)
+        if sys.byteorder != "little":
+            data.byteswap()
+        w.writeframes(data.tobytes())
+    frames = len(samples) // width
+    print(
+        "point %d: %d frames at %d Hz (%.2f s) to %s, %d packet%s lost"
+        % (args.point, frames, rate, frames / rate, args.out, lost, "" if lost == 1 else "s")
+    )
+    if args.spectrum:
+        _spectrum(samples, rate, width)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
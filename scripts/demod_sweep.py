@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+# Audible-output comparison of modulator builds, on the build machine.
+#
+# Builds env:native once per configuration, runs the golden.py stimulus
+# set through each with the host runner, and tabulates what the
+# demodulation model (host/demod_model.h) makes of the output: the
+# audible level, distortion and noise against the input, and the lag.
+#
+#   python3 scripts/demod_sweep.py                       the default build
+#   python3 scripts/demod_sweep.py --flags= \
+#       --flags=-DMODULATOR_SRAM --flags=-DMODULATOR_SSB  one row per build
+#   python3 scripts/demod_sweep.py --env native_q31      another native env
+#
+# Each --flags is one configuration (with the =, as the value starts
+# with a dash), added to the env's build_flags through
+# PLATFORMIO_BUILD_FLAGS; every --env is built with every --flags. Each program is copied out of .pio before the next build, so
+# the runs all happen after the builds. --speech DIR adds every .wav in
+# DIR, as for golden.py.
+#
+# Standard library only.
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+from os.path import abspath, basename, dirname, join
+
+sys.path.insert(0, dirname(abspath(__file__)))
+import golden  # noqa: E402
+
+PROJECT = golden.PROJECT
+
+_AUDIBLE = re.compile(
+    r"audible\[(\d)\] level (\S+) dB\s+distortion\+noise (\S+) dB \((\S+)%\)\s+lag (-?\d+)"
+)
+_SPEED = re.compile(r"([\d.]+)x real time")
+
+
+def _build(env, flags, dest):
+    environ = dict(os.environ)
+    if flags:
+        environ["PLATFORMIO_BUILD_FLAGS"] = flags
+    else:
+        environ.pop("PLATFORMIO_BUILD_FLAGS", None)
+    subprocess.check_call(["pio", "run", "-e", env, "-d", PROJECT], env=environ)
+    shutil.copyfile(join(PROJECT, ".pio", "build", env, "program"), dest)
+    os.chmod(dest, 0o755)
+
+
+def _run(program, stimulus):
+    result = subprocess.run([program, stimulus], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError("%s %s: %s" % (program, basename(stimulus), result.stderr.strip()))
+    speed = _SPEED.search(result.stdout)
+    channels = {int(m.group(1)): m.groups()[1:] for m in _AUDIBLE.finditer(result.stdout)}
+    return (speed.group(1) if speed else "?"), channels
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Audible-output comparison of modulator builds")
+    parser.add_argument("--env", action="append", help="native env to build (default native)")
+    parser.add_argument(
+        "--flags", action="append", help="extra build flags, one configuration each"
+    )
+    parser.add_argument("--speech", metavar="DIR", help="add the .wav files in DIR to the stimuli")
+    args = parser.parse_args()
+
+    envs = args.env or ["native"]
+    flag_sets = args.flags or [""]
+
+    work = join(PROJECT, ".pio", "demod_sweep")
+    shutil.rmtree(work, ignore_errors=True)
+    os.makedirs(join(work, "stimuli"))
+    stimuli = golden._stimuli(join(work, "stimuli"), args.speech)
+
+    configs = []
+    for env in envs:
+        for flags in flag_sets:
+            program = join(work, "program.%d" % len(configs))
+            _build(env, flags, program)
+            configs.append((("%s %s" % (env, flags)).strip(), program))
+
+    width = max(len(label) for label, _ in configs)
+    print(
+        "%-10s %-*s %8s  %-32s  %-32s"
+        % ("stimulus", width, "build", "speed", "audible[0] level/dist/lag", "audible[1]")
+    )
+    for stimulus in stimuli:
+        name = basename(stimulus)[:-4]
+        for label, program in configs:
+            speed, channels = _run(program, stimulus)
+            cells = []
+            for ch in range(2):
+                if ch in channels:
+                    level, dist, _, lag = channels[ch]
+                    cells.append("%7s dB %7s dB %6s" % (level, dist, lag))
+                else:
+                    cells.append("too short")
+            print("%-10s %-*s %7sx  %-32s  %-32s" % (name, width, label, speed, cells[0], cells[1]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
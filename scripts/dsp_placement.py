@@ -0,0 +1,72 @@
+Import("env")
+
+import subprocess
+import sys
+from os.path import join
+
+sys.path.insert(0, join(env.subst("$PROJECT_DIR"), "scripts"))
+from memory_map import region, region_size, sections, tool
+
+# Adds ld/dsp_sections.ld to the link and reports, after every link,
+# where the DSP_DTCM / DSP_ITCM objects (include/dsp_placement.h) ended up.
+#
+# The STM32 Arduino core passes the board script with --default-script, so
+# a -T script that uses INSERT augments it instead of replacing it.
+
+LD_SUPPLEMENT = join(env.subst("$PROJECT_DIR"), "ld", "dsp_sections.ld")
+
+# Output section -> region it must live in.
+REQUIRED = {
+    ".dsp_dtcm_bss": "DTCM",
+    ".dsp_itcm_text": "ITCM",
+    ".dtcmram_bss": "DTCM",
+}
+
+TOP_SYMBOLS = 8
+
+
+def _symbols(elf):
+    # nm -S rows: address size type name
+    out = subprocess.check_output(
+        [tool(env, "nm"), "-S", "-C", "--size-sort", elf], universal_newlines=True
+    )
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4:
+            symbols.append((int(fields[0], 16), int(fields[1], 16), fields[3]))
+    return symbols
+
+
+def _report(target, source, env):
+    elf = target[0].get_abspath()
+    symbols = _symbols(elf)
+
+    print("[dsp_placement] Section placement:")
+    errors = []
+    for name, size, vma, _, _ in sections(env, elf):
+        if size == 0:
+            continue
+        where = region(vma)
+        print("  %-20s %8d B  0x%08X  %s" % (name, size, vma, where))
+        want = REQUIRED.get(name)
+        if want and where != want:
+            errors.append("%s is in %s, expected %s" % (name, where, want))
+
+    for name in ("DTCM", "ITCM"):
+        placed = [s for s in symbols if region(s[0]) == name]
+        placed.sort(key=lambda s: s[1], reverse=True)
+        total = sum(s[1] for s in placed)
+        print("[dsp_placement] %s: %d / %d B in symbols" % (name, total, region_size(name)))
+        for addr, sym_size, sym in placed[:TOP_SYMBOLS]:
+            print("  %8d B  0x%08X  %s" % (sym_size, addr, sym))
+
+    if errors:
+        for e in errors:
+            print("[dsp_placement] ERROR: " + e)
+        return 1
+    return 0
+
+
+env.Append(LINKFLAGS=["-Wl,-T,%s" % LD_SUPPLEMENT])
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", _report)
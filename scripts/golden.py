@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+# Golden-output check for the modulator, on the build machine.
+#
+# Builds the native envs (platformio.ini), runs a stimulus set through
+# each one's callback with the host runner (host/host_main.cpp), and
+# compares every variant's output against env:native, the float
+# reference build of src/main.cpp:
+#
+#   python3 scripts/golden.py                    variants vs reference
+#   python3 scripts/golden.py --record DIR       also save the reference
+#                                                output as the golden set
+#   python3 scripts/golden.py --against DIR      also check the reference
+#                                                itself against DIR
+#
+# Record before optimising src/main.cpp or the include/ stages and check
+# against it after: the variant envs compare only against today's
+# reference, the golden set against yesterday's.
+#
+# Stimuli are generated at the codec rate: a log sweep, pink noise, a
+# two-tone, and a tone burst out of silence (filter tails, denormals).
+# --speech DIR adds every .wav in DIR; they run at the firmware's rate
+# whatever theirs is, which is fine for a like-for-like comparison.
+#
+# Each output channel, clipped to full scale as the codec would, passes
+# if its SNR against the reference (after SETTLE_SECONDS of start-up) is
+# at least the variant's min_snr_db, or every sample is within max_ulp
+# float ULPs of it. --target-log FILE adds
+# the cycles per block from a serial log of env:electrosmith_daisy_bench_q31
+# to the report, for the speed side of the same change.
+#
+# Standard library only; exits non-zero on any failure.
+
+import argparse
+import array
+import math
+import os
+import random
+import re
+import shutil
+import struct
+import subprocess
+import sys
+from os.path import abspath, basename, dirname, isdir, join
+
+PROJECT = dirname(dirname(abspath(__file__)))
+REFERENCE = "native"
+
+# env -> tolerance against the reference. The float builds differ only
+# in how the work is split into blocks, so in rounding at most; Q31 is
+# bounded by its 31-bit arithmetic and the 24-bit codec words.
+VARIANTS = {
+    "native_lowlat": {"max_ulp": 4096, "min_snr_db": 120.0},
+    "native_q31": {"max_ulp": None, "min_snr_db": 90.0},
+}
+
+# The golden set is written by the same build, so it should match
+# exactly; this leaves room for a compiler upgrade's contractions.
+GOLDEN = {"max_ulp": 64, "min_snr_db": 140.0}
+
+SAMPLE_RATE = 96000
+STIMULUS_SECONDS = 4.0
+SETTLE_SECONDS = 0.05
+
+_TARGET = re.compile(r"cycles/block float (\d+) q31 (\d+) \(budget (\d+)\)\s+snr (\S+) dB")
+
+
+def _write_wav(path, left, right, rate):
+    # 32-bit float stereo, as the runner writes.
+    frames = array.array("f")
+    for a, b in zip(left, right):
+        frames.append(a)
+        frames.append(b)
+    data = frames.tobytes()
+    with open(path, "wb") as f:
+        f.write(b"RIFF" + struct.pack("<I", 36 + len(data)) + b"WAVE")
+        f.write(b"fmt " + struct.pack("<IHHIIHH", 16, 3, 2, rate, rate * 8, 8, 32))
+        f.write(b"data" + struct.pack("<I", len(data)))
+        f.write(data)
+
+
+def _read_float_wav(path):
+    # Only the runner's own output: float stereo, fmt then data.
+    with open(path, "rb") as f:
+        raw = f.read()
+    at = 12
+    while at + 8 <= len(raw):
+        tag, size = raw[at : at + 4], struct.unpack("<I", raw[at + 4 : at + 8])[0]
+        if tag == b"data":
+            samples = array.array("f")
+            samples.frombytes(raw[at + 8 : at + 8 + size])
+            return samples[0::2], samples[1::2]
+        at += 8 + size + (size & 1)
+    raise ValueError("%s: no data chunk" % path)
+
+
+def _stimuli(out_dir, speech_dir):
+    n = int(SAMPLE_RATE * STIMULUS_SECONDS)
+    rng = random.Random(1)
+    paths = []
+
+    def add(name, left, right):
+        path = join(out_dir, name + ".wav")
+        _write_wav(path, left, right, SAMPLE_RATE)
+        paths.append(path)
+
+    # 20 Hz to 20 kHz, -6 dBFS, the sweep falling on the right.
+    k = math.log(1000.0) / n
+    up, down = [], []
+    phase_up = phase_down = 0.0
+    for i in range(n):
+        phase_up += 2.0 * math.pi * 20.0 * math.exp(k * i) / SAMPLE_RATE
+        phase_down += 2.0 * math.pi * 20000.0 * math.exp(-k * i) / SAMPLE_RATE
+        up.append(0.5 * math.sin(phase_up))
+        down.append(0.5 * math.sin(phase_down))
+    add("sweep", up, down)
+
+    # Pink noise, -12 dBFS, Paul Kellet's filter on white noise.
+    def pink():
+        b = [0.0] * 7
+        out = []
+        for _ in range(n):
+            w = rng.uniform(-1.0, 1.0)
+            b[0] = 0.99886 * b[0] + w * 0.0555179
+            b[1] = 0.99332 * b[1] + w * 0.0750759
+            b[2] = 0.96900 * b[2] + w * 0.1538520
+            b[3] = 0.86650 * b[3] + w * 0.3104856
+            b[4] = 0.55000 * b[4] + w * 0.5329522
+            b[5] = -0.7616 * b[5] - w * 0.0168980
+            out.append(0.25 * 0.11 * (sum(b[:6]) + b[6] + w * 0.5362))
+            b[6] = w * 0.115926
+        return out
+
+    add("pink", pink(), pink())
+
+    # 1 kHz + 1.1 kHz at -12 dBFS each: the intermodulation case.
+    tones = [
+        0.25 * math.sin(2.0 * math.pi * 1000.0 * i / SAMPLE_RATE)
+        + 0.25 * math.sin(2.0 * math.pi * 1100.0 * i / SAMPLE_RATE)
+        for i in range(n)
+    ]
+    add("two_tone", tones, tones)
+
+    # 100 ms 400 Hz bursts at full scale, 900 ms of silence after each.
+    burst = [
+        math.sin(2.0 * math.pi * 400.0 * i / SAMPLE_RATE)
+        if i % SAMPLE_RATE < SAMPLE_RATE // 10
+        else 0.0
+        for i in range(n)
+    ]
+    add("burst", burst, [0.0] * n)
+
+    if speech_dir:
+        for name in sorted(os.listdir(speech_dir)):
+            if name.lower().endswith(".wav"):
+                paths.append(join(speech_dir, name))
+    return paths
+
+
+def _bits(samples):
+    # Float bit patterns mapped so adjacent floats differ by one.
+    ints = array.array("i")
+    ints.frombytes(samples.tobytes())
+    return [v if v >= 0 else -2147483648 - v for v in ints]
+
+
+def _compare(ref, got, tolerance):
+    settle = int(SETTLE_SECONDS * SAMPLE_RATE)
+    if len(ref) != len(got):
+        return False, "length %d, reference %d" % (len(got), len(ref))
+    # At the DAC, where the float build clips and Q31 saturates alike.
+    ref = array.array("f", (min(max(v, -1.0), 1.0) for v in ref))
+    got = array.array("f", (min(max(v, -1.0), 1.0) for v in got))
+    signal = noise = 0.0
+    for a, b in zip(ref[settle:], got[settle:]):
+        signal += a * a
+        noise += (a - b) * (a - b)
+    snr = float("inf") if noise == 0.0 else 10.0 * math.log10(max(signal, 1e-30) / noise)
+    ulp = max((abs(a - b) for a, b in zip(_bits(ref), _bits(got))), default=0)
+    max_ulp = tolerance["max_ulp"]
+    ok = snr >= tolerance["min_snr_db"] or (max_ulp is not None and ulp <= max_ulp)
+    return ok, "snr %s dB, max %d ulp" % ("inf" if snr == float("inf") else "%.1f" % snr, ulp)
+
+
+def _build(env):
+    subprocess.check_call(["pio", "run", "-e", env, "-d", PROJECT])
+
+
+def _run(env, stimulus, out_path):
+    program = join(PROJECT, ".pio", "build", env, "program")
+    result = subprocess.run([program, stimulus, out_path], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError("%s %s: %s" % (env, basename(stimulus), result.stderr.strip()))
+    speed = re.search(r"([\d.]+)x real time", result.stdout)
+    return speed.group(1) if speed else "?"
+
+
+def _target_report(path):
+    last = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = _TARGET.search(line)
+            if m:
+                last = m
+    if not last:
+        print("target: no bench_q31 lines in %s" % path)
+        return
+    float_cycles, q31_cycles, budget, snr = last.groups()
+    print(
+        "target: cycles/block float %s (%.1f%%), q31 %s (%.1f%%) of %s, on-target snr %s dB"
+        % (
+            float_cycles,
+            100.0 * int(float_cycles) / int(budget),
+            q31_cycles,
+            100.0 * int(q31_cycles) / int(budget),
+            budget,
+            snr,
+        )
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Golden-output check for the modulator")
+    parser.add_argument("--record", metavar="DIR", help="save the reference output here")
+    parser.add_argument(
+        "--against", metavar="DIR", help="check the reference against a recorded set"
+    )
+    parser.add_argument("--speech", metavar="DIR", help="add the .wav files in DIR to the stimuli")
+    parser.add_argument(
+        "--target-log", metavar="FILE", help="serial log of env:electrosmith_daisy_bench_q31"
+    )
+    parser.add_argument("--no-build", action="store_true", help="use the programs already built")
+    args = parser.parse_args()
+
+    work = join(PROJECT, ".pio", "golden")
+    shutil.rmtree(work, ignore_errors=True)
+    os.makedirs(join(work, "stimuli"))
+    stimuli = _stimuli(join(work, "stimuli"), args.speech)
+
+    envs = [REFERENCE] + list(VARIANTS)
+    if not args.no_build:
+        for env in envs:
+            _build(env)
+
+    failures = 0
+    for stimulus in stimuli:
+        name = basename(stimulus)[:-4]
+        outputs = {}
+        for env in envs:
+            outputs[env] = join(work, "%s.%s.wav" % (name, env))
+            speed = _run(env, stimulus, outputs[env])
+            print("%-10s %-14s %sx real time" % (name, env, speed))
+        ref = _read_float_wav(outputs[REFERENCE])
+
+        # (label, expected, actual, tolerance)
+        checks = [(env, ref, _read_float_wav(outputs[env]), VARIANTS[env]) for env in VARIANTS]
+        if args.against:
+            golden = join(args.against, name + ".wav")
+            if os.path.exists(golden):
+                checks.insert(0, ("golden", _read_float_wav(golden), ref, GOLDEN))
+            else:
+                print("%-10s golden         missing, %s" % (name, golden))
+                failures += 1
+        for label, expected, got, tolerance in checks:
+            for ch in range(2):
+                ok, detail = _compare(expected[ch], got[ch], tolerance)
+                failures += 0 if ok else 1
+                status = "ok  " if ok else "FAIL"
+                print("%-10s %-14s out[%d] %s  %s" % (name, label, ch, status, detail))
+
+        if args.record:
+            if not isdir(args.record):
+                os.makedirs(args.record)
+            shutil.copyfile(outputs[REFERENCE], join(args.record, name + ".wav"))
+
+    if args.target_log:
+        _target_report(args.target_log)
+    print("%d failure%s" % (failures, "" if failures == 1 else "s"))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
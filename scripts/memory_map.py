@@ -0,0 +1,56 @@
+# STM32H750 memory map and ELF helpers shared by the post-link reports
+# (dsp_placement.py, memory_report.py). Not an extra_script itself.
+
+import subprocess
+
+# name, start, size
+REGIONS = [
+    ("ITCM", 0x00000000, 64 * 1024),
+    ("FLASH", 0x08000000, 128 * 1024),
+    ("DTCM", 0x20000000, 128 * 1024),
+    ("AXI SRAM", 0x24000000, 512 * 1024),
+    ("SRAM1-3", 0x30000000, 288 * 1024),
+    ("SRAM4", 0x38000000, 64 * 1024),
+    ("QSPI", 0x90000000, 8 * 1024 * 1024),
+    ("SDRAM", 0xC0000000, 64 * 1024 * 1024),
+]
+
+
+def region(addr):
+    for name, start, size in REGIONS:
+        if start <= addr < start + size:
+            return name
+    return "?"
+
+
+def region_size(name):
+    return next(r[2] for r in REGIONS if r[0] == name)
+
+
+def tool(env, name):
+    # arm-none-eabi-gcc -> arm-none-eabi-<name>
+    return env.subst("$CC")[: -len("gcc")] + name
+
+
+def sections(env, elf):
+    # objdump -h rows: Idx Name Size VMA LMA File-off Align, followed by
+    # a flags line. Only ALLOC sections occupy target memory; those with
+    # LOAD also take their size at the LMA (.data's image in flash).
+    out = subprocess.check_output([tool(env, "objdump"), "-h", elf], universal_newlines=True)
+    lines = out.splitlines()
+    result = []
+    for i, line in enumerate(lines):
+        fields = line.split()
+        if len(fields) >= 6 and fields[0].isdigit():
+            flags = lines[i + 1] if i + 1 < len(lines) else ""
+            if "ALLOC" in flags:
+                result.append(
+                    (
+                        fields[1],
+                        int(fields[2], 16),
+                        int(fields[3], 16),
+                        int(fields[4], 16),
+                        "LOAD" in flags,
+                    )
+                )
+    return result
@@ -0,0 +1,125 @@
+Import("env")
+
+import re
+import sys
+from os.path import basename, join
+
+sys.path.insert(0, join(env.subst("$PROJECT_DIR"), "scripts"))
+from memory_map import REGIONS, region, sections
+
+# Reports, after every link, how full each memory region is and which
+# object files fill it, from the linker map. DTCM, AXI SRAM and SRAM1-3
+# are what a patch's DSP state competes for; once it spills into SDRAM
+# every cache miss costs ~100 cycles, so say so before the link fails.
+#
+# Totals come from the ELF's section headers (.data counts in both its
+# RAM region and FLASH, where its image is); the per-object breakdown
+# from the map, which the script asks the linker for.
+
+MAP = join("$BUILD_DIR", "${PROGNAME}.map")
+
+TOP_OBJECTS = 5
+
+# Percent of a region past which the report warns.
+WARN_PERCENT = 90
+
+_INPUT = re.compile(r"^ (\S+)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)(?:\s+(\S.*))?$")
+_NAME_ONLY = re.compile(r"^ (\S+)$")
+_OUTPUT = re.compile(r"^(\S+)(\s+0x[0-9a-f]+\s+0x[0-9a-f]+)?")
+
+
+def _short(obj, build_dir):
+    # The map names objects as the linker was given them, relative to the
+    # project or absolute; keep what follows the build directory.
+    marker = "/" + basename(build_dir) + "/"
+    at = obj.find(marker)
+    return obj[at + len(marker) :] if at >= 0 else obj
+
+
+def _objects(map_path, alloc, build_dir):
+    # Input section lines of the "Linker script and memory map" part:
+    #  .bss.name      0xADDR      0xSIZE path/to/file.o
+    # with the section name on a line of its own when it is long, and
+    # *fill* for padding. Only those under an ALLOC output section count.
+    usage = {}
+    in_map = False
+    output = None
+    pending = False
+    with open(map_path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            if line and not line[0].isspace():
+                m = _OUTPUT.match(line)
+                output = m.group(1) if m else None
+                pending = False
+                continue
+            if output not in alloc:
+                continue
+            if _NAME_ONLY.match(line):
+                pending = True
+                continue
+            m = _INPUT.match(line)
+            if not m or (m.group(1) is None and not pending):
+                pending = False
+                continue
+            pending = False
+            addr, size = int(m.group(2), 16), int(m.group(3), 16)
+            if size == 0:
+                continue
+            obj = m.group(4)
+            if m.group(1) == "*fill*":
+                obj = "(padding)"
+            elif obj is None:
+                continue
+            else:
+                obj = _short(obj, build_dir)
+            key = (region(addr), obj)
+            usage[key] = usage.get(key, 0) + size
+    return usage
+
+
+def _report(target, source, env):
+    elf = target[0].get_abspath()
+    found = sections(env, elf)
+
+    used = {}
+    for name, size, vma, lma, load in found:
+        used[region(vma)] = used.get(region(vma), 0) + size
+        if load and lma != vma:
+            used[region(lma)] = used.get(region(lma), 0) + size
+
+    print("[memory_report] Region use:")
+    warnings = []
+    for name, _, size in REGIONS:
+        n = used.get(name, 0)
+        percent = 100.0 * n / size
+        print("  %-10s %9d / %9d B  %5.1f%%" % (name, n, size, percent))
+        if percent >= WARN_PERCENT:
+            warnings.append("%s is %.1f%% full" % (name, percent))
+
+    map_path = env.subst(MAP)
+    try:
+        usage = _objects(map_path, set(s[0] for s in found), env.subst("$BUILD_DIR"))
+    except IOError:
+        print("[memory_report] no map at %s; skipping objects" % map_path)
+        usage = {}
+    for name, _, _ in REGIONS:
+        objs = [(size, obj) for (where, obj), size in usage.items() if where == name]
+        if not objs or name in ("FLASH", "QSPI"):
+            continue
+        objs.sort(reverse=True)
+        print("[memory_report] %s, largest objects:" % name)
+        for size, obj in objs[:TOP_OBJECTS]:
+            print("  %9d B  %s" % (size, obj))
+
+    for w in warnings:
+        print("[memory_report] WARNING: " + w)
+    return 0
+
+
+if not any("-Map" in str(f) for f in env.get("LINKFLAGS", [])):
+    env.Append(LINKFLAGS=["-Wl,-Map,%s" % MAP])
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", _report)
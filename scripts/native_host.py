@@ -0,0 +1,19 @@
+Import("env")
+
+from os.path import join
+
+# Builds the native env: src/main.cpp against host/DaisyDuino.h (a host
+# stand-in for the Arduino core and AudioClass), the real DaisySP, and the
+# WAV runner in host/. The DaisyDuino library itself is not built; only
+# its hardware-free headers (utility/param_block.h and the like) are used.
+
+PROJECT = env.subst("$PROJECT_DIR")
+DAISYDUINO = join(PROJECT, "lib", "DaisyDuino", "src")
+DAISYSP = join(DAISYDUINO, "utility", "DaisySP")
+
+# host/ first, so its DaisyDuino.h is the one found.
+env.Prepend(CPPPATH=[join(PROJECT, "host")])
+env.Append(CPPPATH=[DAISYDUINO, DAISYSP, join(DAISYSP, "modules")])
+
+env.BuildSources(join("$BUILD_DIR", "daisysp"), join(DAISYSP, "modules"))
+env.BuildSources(join("$BUILD_DIR", "host"), join(PROJECT, "host"))
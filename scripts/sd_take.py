@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# Extracts a take written by a MODULATOR_SD_RECORD build (SdRecorder,
+# lib/DaisyDuino/src/utility/sd_stream.h) from the raw microSD card, or
+# an image of it, into a 24-bit WAV file:
+#
+#   sudo python3 scripts/sd_take.py /dev/sdX take.wav
+#   python3 scripts/sd_take.py card.img take.wav --lba 2048 --channels 0,1
+#
+# The card has no file system: the take starts at block --lba (where
+# the firmware put it, kSdTakeLba in src/main.cpp) with a 512-byte
+# header, the interleaved samples following. --info prints the header
+# only. --channels picks and orders the channels written (all by
+# default). A take that was never closed (power cut, card pulled) is
+# read up to its last header update and reported as such.
+#
+# Standard library only.
+
+import argparse
+import struct
+import sys
+import wave
+
+BLOCK = 512
+MAGIC = b"DTAK"
+HEADER = struct.Struct("<4sIIIIIQI")
+
+
+def _read_header(f, lba):
+    f.seek(lba * BLOCK)
+    raw = f.read(HEADER.size)
+    if len(raw) < HEADER.size:
+        return None
+    magic, version, rate, channels, bits, data_lba, frames, closed = HEADER.unpack(raw)
+    if magic != MAGIC or version != 1 or bits != 24 or not 1 <= channels <= 8:
+        return None
+    return {
+        "rate": rate,
+        "channels": channels,
+        "data_lba": data_lba,
+        "frames": frames,
+        "closed": bool(closed),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Extract an SdRecorder take to WAV")
+    parser.add_argument("device", help="card device or image")
+    parser.add_argument("out", nargs="?")
+    parser.add_argument("--lba", type=int, default=2048)
+    parser.add_argument("--channels", help="comma separated, e.g. 0,1")
+    parser.add_argument("--info", action="store_true")
+    args = parser.parse_args()
+
+    with open(args.device, "rb") as f:
+        h = _read_header(f, args.lba)
+        if h is None:
+            print("no take at block %d" % args.lba)
+            return 1
+        print(
+            "%d ch, %d Hz, %d frames (%.2f s)%s"
+            % (
+                h["channels"],
+                h["rate"],
+                h["frames"],
+                h["frames"] / h["rate"] if h["rate"] else 0.0,
+                "" if h["closed"] else ", not closed",
+            )
+        )
+        if args.info or args.out is None:
+            return 0
+
+        n = h["channels"]
+        pick = list(range(n))
+        if args.channels:
+            pick = [int(c) for c in args.channels.split(",")]
+            if any(c < 0 or c >= n for c in pick):
+                print("channels are 0 to %d" % (n - 1))
+                return 1
+        frame = 3 * n
+        f.seek(h["data_lba"] * BLOCK)
+        with wave.open(args.out, "wb") as w:
+            w.setnchannels(len(pick))
+            w.setsampwidth(3)
+            w.setframerate(h["rate"])
+            left = h["frames"]
+            while left > 0:
+                count = min(left, 16384)
+                data = f.read(count * frame)
+                count = len(data) // frame
+                if count == 0:
+                    break
+                if pick == list(range(n)):
+                    w.writeframes(data[: count * frame])
+                else:
+                    out = bytearray()
+                    for i in range(count):
+                        base = i * frame
+                        for c in pick:
+                            out += data[base + 3 * c : base + 3 * c + 3]
+                    w.writeframes(bytes(out))
+                left -= count
+        if left > 0:
+            print("the device ends %d frames early" % left)
+        print("wrote %s" % args.out)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
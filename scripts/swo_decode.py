@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+# Decodes ITM telemetry from a MODULATOR_SWO build (utility/itm_trace.h)
+# off the SWO pin, PB3 on the debug header:
+#
+#   python3 scripts/swo_decode.py /dev/ttyUSB0               USB UART on PB3
+#   python3 scripts/swo_decode.py /dev/ttyUSB0 --csv t.csv   also log values
+#   python3 scripts/swo_decode.py swo.bin                    raw SWO capture
+#
+# A serial device is opened raw at --baud (the firmware's kSwoBaud); any
+# other path is read as a file of raw SWO bytes, e.g. what OpenOCD writes
+# with "tpiu config internal swo.bin uart off <core hz> <baud>", or "-"
+# for stdin.
+#
+# Port 0 is text and is printed as it arrives; the metric ports are
+# summarised every --interval seconds (latest, min and max since the last
+# line). PORTS below follows src/main.cpp; ports not listed print as hex.
+#
+# Standard library only; POSIX serial ports.
+
+import argparse
+import os
+import stat
+import struct
+import sys
+import termios
+import time
+
+# port -> (name, "f" float bits or "u" unsigned)
+PORTS = {
+    1: ("load", "f"),
+    2: ("peak_l", "f"),
+    3: ("peak_r", "f"),
+    4: ("overruns", "u"),
+}
+
+_BAUDS = {
+    115200: termios.B115200,
+    230400: termios.B230400,
+    460800: getattr(termios, "B460800", None),
+    921600: getattr(termios, "B921600", None),
+    1000000: getattr(termios, "B1000000", None),
+    2000000: getattr(termios, "B2000000", None),
+    3000000: getattr(termios, "B3000000", None),
+    4000000: getattr(termios, "B4000000", None),
+}
+
+
+class ItmParser:
+    # ITM packets out of a byte stream (ARMv7-M ARM, appendix D4): sync,
+    # overflow, timestamps and extensions are skipped; source packets
+    # come out as (port, value, hardware).
+
+    def __init__(self):
+        self.buf = b""
+        self.overflows = 0
+        self.skipped = 0
+
+    def _continued(self, at):
+        # Length of a header at `at` followed by bytes while bit 7 is set.
+        n = 1
+        if self.buf[at] & 0x80:
+            while True:
+                if at + n >= len(self.buf):
+                    return None
+                n += 1
+                if not self.buf[at + n - 1] & 0x80:
+                    break
+        return n
+
+    def feed(self, data):
+        self.buf += data
+        at = 0
+        out = []
+        while at < len(self.buf):
+            h = self.buf[at]
+            if h == 0x00 or h == 0x80:
+                at += 1  # sync: a run of zeros, then 0x80
+                continue
+            if h == 0x70:
+                self.overflows += 1
+                at += 1
+                continue
+            size = (0, 1, 2, 4)[h & 0x03]
+            if size:
+                if at + 1 + size > len(self.buf):
+                    break
+                value = int.from_bytes(self.buf[at + 1 : at + 1 + size], "little")
+                out.append((h >> 3, value, bool(h & 0x04)))
+                at += 1 + size
+                continue
+            if (h & 0x0F) == 0x00 or (h & 0x0B) == 0x08 or h in (0x94, 0xB4):
+                # Local timestamp, extension or global timestamp.
+                n = self._continued(at) if (h & 0x80) or h in (0x94, 0xB4) else 1
+                if n is None:
+                    break
+                at += n
+                continue
+            self.skipped += 1
+            at += 1
+        self.buf = self.buf[at:]
+        return out
+
+
+def _open(source, baud):
+    if source == "-":
+        return sys.stdin.fileno(), False
+    fd = os.open(source, os.O_RDONLY | os.O_NOCTTY)
+    if not stat.S_ISCHR(os.fstat(fd).st_mode):
+        return fd, False
+    speed = _BAUDS.get(baud)
+    if speed is None:
+        raise SystemExit("baud %d is not available on this system" % baud)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0
+    attrs[1] = 0
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0
+    attrs[4] = attrs[5] = speed
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 1
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    return fd, True
+
+
+def _value(port, raw):
+    kind = PORTS.get(port, (None, "x"))[1]
+    if kind == "f":
+        return struct.unpack("<f", struct.pack("<I", raw & 0xFFFFFFFF))[0]
+    return raw
+
+
+def _format(port, v):
+    kind = PORTS.get(port, (None, "x"))[1]
+    if kind == "f":
+        return "%.4g" % v
+    if kind == "u":
+        return "%d" % v
+    return "0x%08x" % v
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode ITM telemetry off SWO")
+    parser.add_argument("source", help="serial device, raw SWO file, or -")
+    parser.add_argument("--baud", type=int, default=2000000)
+    parser.add_argument("--interval", type=float, default=1.0)
+    parser.add_argument("--csv", metavar="FILE", help="log every metric value")
+    args = parser.parse_args()
+
+    fd, live = _open(args.source, args.baud)
+    itm = ItmParser()
+    csv = open(args.csv, "w") if args.csv else None
+    if csv:
+        csv.write("time,port,name,value\n")
+    stats = {}  # port -> [latest, min, max, count]
+    text = b""
+    start = time.monotonic()
+    last = start
+
+    def summary():
+        if not stats:
+            return
+        fields = []
+        for port in sorted(stats):
+            latest, lo, hi, count = stats[port]
+            name = PORTS.get(port, ("port%d" % port,))[0]
+            fields.append(
+                "%s %s [%s..%s]"
+                % (name, _format(port, latest), _format(port, lo), _format(port, hi))
+            )
+        print("%8.2fs  %s" % (time.monotonic() - start, "  ".join(fields)))
+        stats.clear()
+
+    try:
+        while True:
+            chunk = os.read(fd, 65536)
+            if not chunk and not live:
+                break
+            for port, raw, hardware in itm.feed(chunk):
+                if hardware:
+                    continue
+                if port == 0:
+                    text += bytes([raw & 0xFF])
+                    while b"\n" in text:
+                        line, text = text.split(b"\n", 1)
+                        print("itm: %s" % line.decode(errors="replace").rstrip("\r"))
+                    continue
+                v = _value(port, raw)
+                s = stats.setdefault(port, [v, v, v, 0])
+                s[0] = v
+                s[1] = min(s[1], v)
+                s[2] = max(s[2], v)
+                s[3] += 1
+                if csv:
+                    name = PORTS.get(port, ("port%d" % port,))[0]
+                    csv.write("%.6f,%d,%s,%s\n" % (time.monotonic() - start, port, name, v))
+            now = time.monotonic()
+            if now - last >= args.interval:
+                summary()
+                last = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        summary()
+        if csv:
+            csv.close()
+    if itm.overflows or itm.skipped:
+        print("%d ITM overflows, %d bytes skipped" % (itm.overflows, itm.skipped))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+# Tunes a MODULATOR_TUNING build live over USB serial
+# (include/tuning_link.h):
+#
+#   python3 scripts/tune.py /dev/ttyACM0 ping
+#   python3 scripts/tune.py /dev/ttyACM0 get carrier_freq
+#   python3 scripts/tune.py /dev/ttyACM0 set mod_depth 0.8 carrier_level 0.45
+#   python3 scripts/tune.py /dev/ttyACM0 meters
+#   python3 scripts/tune.py /dev/ttyACM0 stream --rate 100 --seconds 10
+#   python3 scripts/tune.py /dev/ttyACM0 calibrate reset|resweep
+#
+# Zone parameters are zone_carrier_freq.N and zone_gain.N. stream prints
+# one line per meter frame and, at the end, how many the sequence shows
+# were skipped. A request with no reply in --timeout seconds is sent
+# again, up to three times.
+#
+# Standard library only; POSIX serial ports.
+
+import argparse
+import binascii
+import os
+import struct
+import sys
+import termios
+import time
+
+OP_PING, OP_SET, OP_GET, OP_METERS, OP_STREAM, OP_CALIBRATE = range(6)
+REPLY = 0x80
+METER_FRAME = REPLY | OP_METERS
+
+PARAMS = [
+    "carrier_freq",
+    "carrier_level",
+    "carrier_floor",
+    "carrier_release",
+    "mod_depth",
+    "baseband_gain",
+    "comp_threshold",
+    "comp_ratio",
+    "comp_attack",
+    "comp_release",
+    "limit_index",
+    "limit_release",
+    "modulation",
+]
+ZONE_CARRIER_FREQ = 0x10
+ZONE_GAIN = 0x20
+MAX_ZONES = 4
+
+METERS = struct.Struct("<IffIIfffI2f")
+METER_FIELDS = (
+    "time_ms",
+    "load_avg",
+    "load_max",
+    "overruns",
+    "dropped_blocks",
+    "carrier_hz",
+    "mod_peak",
+    "mod_rms",
+    "mod_over",
+    "drive_gain_l",
+    "drive_gain_r",
+)
+
+STATUS = ["ok", "unknown op", "bad length", "bad param", "out of range", "not in this build"]
+CALIBRATIONS = {"reset": 0, "resweep": 1}
+
+
+def _open(port):
+    fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0  # iflag
+    attrs[1] = 0  # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0  # lflag: raw
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 1
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at = 0
+    for b in data:
+        if b != 0:
+            out.append(b)
+        if b == 0 or len(out) - code_at == 0xFF:
+            out[code_at] = len(out) - code_at
+            code_at = len(out)
+            out.append(0)
+    out[code_at] = len(out) - code_at
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1 : i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def crc16(data):
+    # CRC-16/CCITT, init 0xFFFF, as the firmware's.
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def frame(op, tag, body=b""):
+    payload = bytes([op, tag]) + body
+    return cobs_encode(payload + struct.pack("<H", crc16(payload))) + b"\0"
+
+
+def unframe(raw):
+    # (op, tag, body) of one frame without its zero, or None if damaged.
+    data = cobs_decode(raw)
+    if data is None or len(data) < 4:
+        return None
+    if struct.unpack_from("<H", data, len(data) - 2)[0] != crc16(data[:-2]):
+        return None
+    return data[0], data[1], data[2:-2]
+
+
+def param_id(name):
+    if name in PARAMS:
+        return PARAMS.index(name)
+    base, _, zone = name.partition(".")
+    if zone.isdigit() and int(zone) < MAX_ZONES:
+        if base == "zone_carrier_freq":
+            return ZONE_CARRIER_FREQ + int(zone)
+        if base == "zone_gain":
+            return ZONE_GAIN + int(zone)
+    raise SystemExit("unknown parameter " + name)
+
+
+class Link:
+    def __init__(self, port, timeout):
+        self.fd = _open(port)
+        self.timeout = timeout
+        self.buf = b""
+        self.tag = 0
+        self.meter_frames = []
+
+    def frames(self, seconds):
+        # Yields (op, tag, body) as frames come in, for up to seconds.
+        deadline = time.monotonic() + seconds
+        while time.monotonic() < deadline:
+            while b"\0" in self.buf:
+                raw, _, self.buf = self.buf.partition(b"\0")
+                f = unframe(raw) if raw else None
+                if f is not None:
+                    yield f
+            chunk = os.read(self.fd, 4096)
+            self.buf += chunk
+
+    def request(self, op, body=b""):
+        self.tag = (self.tag + 1) & 0xFF
+        for _ in range(3):
+            os.write(self.fd, frame(op, self.tag, body))
+            for rop, rtag, rbody in self.frames(self.timeout):
+                if rop == METER_FRAME:
+                    self.meter_frames.append((rtag, rbody))
+                elif rop == (op | REPLY) and rtag == self.tag:
+                    if rbody[0] != 0:
+                        raise SystemExit("error: " + STATUS[min(rbody[0], len(STATUS) - 1)])
+                    return rbody[1:]
+        raise SystemExit("no reply")
+
+
+def print_meters(body):
+    values = METERS.unpack(body)
+    print("  ".join("%s %.4g" % kv if isinstance(kv[1], float) else "%s %d" % kv
+                    for kv in zip(METER_FIELDS, values)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("port")
+    ap.add_argument("command", choices=["ping", "get", "set", "meters", "stream", "calibrate"])
+    ap.add_argument("args", nargs="*")
+    ap.add_argument("--rate", type=float, default=100.0, help="meter frames per second")
+    ap.add_argument("--seconds", type=float, default=5.0)
+    ap.add_argument("--timeout", type=float, default=0.5)
+    a = ap.parse_args()
+    link = Link(a.port, a.timeout)
+
+    if a.command == "ping":
+        version, params = link.request(OP_PING)
+        print("version %d, %d parameters" % (version, params))
+    elif a.command == "get":
+        for name in a.args or PARAMS:
+            (value,) = struct.unpack("<f", link.request(OP_GET, bytes([param_id(name)])))
+            print("%s %g" % (name, value))
+    elif a.command == "set":
+        if len(a.args) % 2:
+            raise SystemExit("set takes name value pairs")
+        for name, value in zip(a.args[::2], a.args[1::2]):
+            link.request(OP_SET, bytes([param_id(name)]) + struct.pack("<f", float(value)))
+    elif a.command == "meters":
+        print_meters(link.request(OP_METERS))
+    elif a.command == "stream":
+        period = max(10, int(round(1000.0 / a.rate)))
+        link.request(OP_STREAM, struct.pack("<H", period))
+        frames = 0
+        skipped = 0
+        last = None
+        for tag, body in link.meter_frames:
+            last = tag
+        try:
+            for op, tag, body in link.frames(a.seconds):
+                if op != METER_FRAME:
+                    continue
+                if last is not None:
+                    skipped += (tag - last - 1) & 0xFF
+                last = tag
+                frames += 1
+                print_meters(body)
+        finally:
+            link.request(OP_STREAM, struct.pack("<H", 0))
+        print("%d frames, %d skipped" % (frames, skipped), file=sys.stderr)
+    elif a.command == "calibrate":
+        if len(a.args) != 1 or a.args[0] not in CALIBRATIONS:
+            raise SystemExit("calibrate reset|resweep")
+        link.request(OP_CALIBRATE, bytes([CALIBRATIONS[a.args[0]]]))
+
+
+if __name__ == "__main__":
+    main()
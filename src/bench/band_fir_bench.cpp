@@ -0,0 +1,173 @@
+// IIR band limit against the linear-phase FIR (env
+// electrosmith_daisy_bench_band_fir).
+//
+// The default build's BandPass + PostHpf (five biquads per channel)
+// against BandFir<63>, MODULATOR_BAND_FIR's replacement, at 96 kHz:
+//   - cycles per stereo sample, over noise blocks, and
+//   - from each one's impulse response, computed once in setup(): gain
+//     at the band edges and the carrier, and the spread of group delay
+//     across the sidebands, 34.5 to 44.5 kHz. Group delay that changes
+//     with frequency shifts the sidebands against the carrier, which is
+//     the phase distortion the FIR removes.
+// Prints over USB serial once a second. The audio engine is never
+// started.
+#include <DaisyDuino.h>
+#include <cmath>
+#include "dsp_placement.h"
+#include "modulator_params.h"
+#include "modulator_stages.h"
+
+static constexpr float kRate = 96000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocks = 1000;
+static constexpr size_t kImpulse = 2048; // both have rung out by then
+static constexpr float kBandLoHz = 34500.0f;
+static constexpr float kBandHiHz = 44500.0f;
+static constexpr float kDelayStepHz = 250.0f;
+
+using Iir = Pipeline<BandPass, PostHpf>;
+using Fir = BandFir<63>;
+
+static Iir DSP_DTCM iir;
+static Fir DSP_DTCM fir;
+static ModulatorParams params;
+
+static float DSP_DTCM block_l[kBlockSize];
+static float DSP_DTCM block_r[kBlockSize];
+static float noise[kBlockSize];
+static float impulse[kImpulse];
+static volatile float sink; // keeps the loops from being optimised away
+static CpuLoadMeter meter;
+
+struct Summary
+{
+  float edge_lo_db;
+  float carrier_db;
+  float edge_hi_db;
+  float delay_min_us;
+  float delay_max_us;
+};
+static Summary iir_summary;
+static Summary fir_summary;
+
+// Phase and magnitude of impulse[] at hz.
+static void Response(float hz, double& mag, double& phase)
+{
+  const double w = 2.0 * 3.14159265358979323846 * (double)hz / (double)kRate;
+  double re = 0.0, im = 0.0;
+  for (size_t i = 0; i < kImpulse; i++)
+  {
+    re += (double)impulse[i] * cos(w * (double)i);
+    im -= (double)impulse[i] * sin(w * (double)i);
+  }
+  mag = sqrt(re * re + im * im);
+  phase = atan2(im, re);
+}
+
+static float Db(float hz)
+{
+  double mag, phase;
+  Response(hz, mag, phase);
+  return (float)(20.0 * log10(mag > 1e-12 ? mag : 1e-12));
+}
+
+// -d(phase)/d(omega) from two points 20 Hz apart, microseconds.
+static float GroupDelayUs(float hz)
+{
+  double m0, p0, m1, p1;
+  Response(hz - 10.0f, m0, p0);
+  Response(hz + 10.0f, m1, p1);
+  double d = p1 - p0;
+  while (d > 3.14159265358979323846)
+    d -= 2.0 * 3.14159265358979323846;
+  while (d < -3.14159265358979323846)
+    d += 2.0 * 3.14159265358979323846;
+  return (float)(-d / (2.0 * 3.14159265358979323846 * 20.0) * 1e6);
+}
+
+template <typename Stage>
+static void Measure(Stage& stage, Summary& out)
+{
+  stage.Init(kRate);
+  for (size_t i = 0; i < kImpulse; i++)
+    impulse[i] = i == 0 ? 1.0f : 0.0f;
+  for (size_t start = 0; start < kImpulse; start += kBlockSize)
+  {
+    StereoBlock block{impulse + start, block_r, kBlockSize, params.Snapshot()};
+    stage.Process(block);
+  }
+  out.edge_lo_db = Db(kBandLoHz);
+  out.carrier_db = Db(39500.0f);
+  out.edge_hi_db = Db(kBandHiHz);
+  out.delay_min_us = 1e9f;
+  out.delay_max_us = -1e9f;
+  for (float hz = kBandLoHz; hz <= kBandHiHz; hz += kDelayStepHz)
+  {
+    const float d = GroupDelayUs(hz);
+    out.delay_min_us = d < out.delay_min_us ? d : out.delay_min_us;
+    out.delay_max_us = d > out.delay_max_us ? d : out.delay_max_us;
+  }
+  stage.Init(kRate);
+}
+
+template <typename Stage>
+static uint32_t Time(Stage& stage)
+{
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    memcpy(block_l, noise, sizeof(noise));
+    memcpy(block_r, noise, sizeof(noise));
+    StereoBlock block{block_l, block_r, kBlockSize, params.Snapshot()};
+    stage.Process(block);
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = block_l[0];
+  return t1 - t0;
+}
+
+static void Report(const char* name, uint32_t cycles, const Summary& s)
+{
+  Serial.print("  ");
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print((double)((float)cycles / (float)(kBlocks * kBlockSize)), 1);
+  Serial.print(" cycles/stereo sample, ");
+  Serial.print((double)s.edge_lo_db, 2);
+  Serial.print(" / ");
+  Serial.print((double)s.carrier_db, 2);
+  Serial.print(" / ");
+  Serial.print((double)s.edge_hi_db, 2);
+  Serial.print(" dB at 34.5 / 39.5 / 44.5 kHz, group delay ");
+  Serial.print((double)s.delay_min_us, 1);
+  Serial.print(" to ");
+  Serial.print((double)s.delay_max_us, 1);
+  Serial.println(" us");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  DAISY.init(DAISY_SEED, AUDIO_SR_96K);
+
+  // Only for the DWT cycle counter.
+  meter.Init(kRate, kBlockSize);
+
+  params.Init(kRate);
+  uint32_t x = 1;
+  for (float& s : noise)
+  {
+    x = x * 1664525u + 1013904223u;
+    s = (float)(int32_t)x * (0.5f / 2147483648.0f);
+  }
+  Measure(iir, iir_summary);
+  Measure(fir, fir_summary);
+}
+
+void loop()
+{
+  Serial.println("band limit at 96 kHz:");
+  Report("BandPass + PostHpf", Time(iir), iir_summary);
+  Report("BandFir<63>       ", Time(fir), fir_summary);
+  delay(1000);
+}
@@ -0,0 +1,147 @@
+// Beam steering cost per element (env electrosmith_daisy_bench_beam_steer).
+//
+// Times the two ways MODULATOR_BEAM can drive an array, for 8, 16 and
+// 32 elements, with the beam held and with it sweeping (a new angle
+// every block, so every delay glides):
+//   delay bank   FractionalDelayBank, 8 taps, at 192 kHz, where it is
+//                accurate; the shared modulator ahead of it is not counted
+//   phase        PhaseSteer at 96 kHz: baseband delay plus carrier
+//                rotation per element, modulation included
+// Prints over USB serial, once a second, cycles per element and sample
+// and the share of the core that that array takes at its rate. The
+// audio engine is never started.
+#include <DaisyDuino.h>
+#include "beam_steer.h"
+#include "dsp_placement.h"
+#include "modulator_params.h"
+#include "phase_steer.h"
+
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocks = 1000;
+static constexpr size_t kMaxDelay = 192; // 32 x 10 mm spans 177 at 192 kHz
+static constexpr float kPitchM = 0.010f;
+static constexpr float kBankRate = 192000.0f;
+static constexpr float kPhaseRate = 96000.0f;
+
+template <size_t n>
+using Bank = daisysp::FractionalDelayBank<n, kMaxDelay, 8>;
+template <size_t n>
+using Phase = PhaseSteer<n, kMaxDelay>;
+
+static Bank<8> DSP_DTCM bank8;
+static Bank<16> DSP_DTCM bank16;
+static Bank<32> DSP_DTCM bank32;
+static Phase<8> DSP_DTCM phase8;
+static Phase<16> DSP_DTCM phase16;
+static Phase<32> DSP_DTCM phase32;
+static BeamSteer<8> beam8;
+static BeamSteer<16> beam16;
+static BeamSteer<32> beam32;
+static ModulatorParams params;
+
+static float DSP_DTCM input[kBlockSize];
+static float DSP_DTCM outputs[32][kBlockSize];
+static float* out[32];
+static volatile float sink; // keeps the loops from being optimised away
+static CpuLoadMeter meter;
+
+// The bank takes the modulated signal; PhaseSteer wants the carrier.
+template <size_t n>
+static void Carrier(Bank<n>&)
+{
+}
+template <size_t n>
+static void Carrier(Phase<n>& phase)
+{
+  StereoBlock block{input, input, kBlockSize, params.Snapshot()};
+  phase.SetCarrier(block);
+}
+
+// Total cycles for kBlocks blocks through engine, sweeping the angle
+// over +/-30 degrees if asked.
+template <typename Engine, typename Steer>
+static uint32_t Time(Engine& engine, Steer& beam, bool sweep)
+{
+  beam.SetAngle(0.0f);
+  beam.Update();
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    if (sweep)
+    {
+      beam.SetAngle(-30.0f + 60.0f * (float)(b % 100) / 100.0f);
+      beam.Update();
+    }
+    Carrier(engine);
+    beam.Process(engine, input, out, kBlockSize);
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = outputs[0][0];
+  return t1 - t0;
+}
+
+static void Report(const char* name, size_t elements, float rate, uint32_t held, uint32_t swept)
+{
+  const float samples = (float)(kBlocks * kBlockSize * elements);
+  Serial.print("  ");
+  Serial.print(name);
+  Serial.print(" x");
+  Serial.print((uint32_t)elements);
+  Serial.print(": held ");
+  Serial.print((double)((float)held / samples), 1);
+  Serial.print(", swept ");
+  Serial.print((double)((float)swept / samples), 1);
+  Serial.print(" cycles/element/sample, ");
+  const float load = (float)swept / (float)(kBlocks * kBlockSize) * rate / (float)DAISY.SysClkFreq();
+  Serial.print((double)(load * 100.0f), 1);
+  Serial.println("% of the core swept");
+}
+
+template <typename B, typename P, typename S>
+static void Run(size_t n, B& bank, P& phase, S& beam)
+{
+  beam.Init(kBankRate, kPitchM, bank.GetMinDelay());
+  const uint32_t bank_held = Time(bank, beam, false);
+  const uint32_t bank_swept = Time(bank, beam, true);
+  beam.Init(kPhaseRate, kPitchM, phase.GetMinDelay());
+  const uint32_t phase_held = Time(phase, beam, false);
+  const uint32_t phase_swept = Time(phase, beam, true);
+  Report("delay bank", n, kBankRate, bank_held, bank_swept);
+  Report("phase     ", n, kPhaseRate, phase_held, phase_swept);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  DAISY.init(DAISY_SEED, AUDIO_SR_96K);
+
+  // Only for the DWT cycle counter.
+  meter.Init(kPhaseRate, kBlockSize);
+
+  bank8.Init(kBankRate, 34500.0f, 44500.0f);
+  bank16.Init(kBankRate, 34500.0f, 44500.0f);
+  bank32.Init(kBankRate, 34500.0f, 44500.0f);
+  phase8.Init(kPhaseRate);
+  phase16.Init(kPhaseRate);
+  phase32.Init(kPhaseRate);
+  params.Init(kPhaseRate);
+  for (size_t e = 0; e < 32; e++)
+    out[e] = outputs[e];
+  uint32_t x = 1;
+  for (float& s : input)
+  {
+    x = x * 1664525u + 1013904223u;
+    s = (float)(int32_t)x * (0.5f / 2147483648.0f);
+  }
+}
+
+void loop()
+{
+  Serial.print("beam steering, ");
+  Serial.print((uint32_t)kBlockSize);
+  Serial.println("-frame blocks:");
+  Run(8, bank8, phase8, beam8);
+  Run(16, bank16, phase16, beam16);
+  Run(32, bank32, phase32, beam32);
+  delay(1000);
+}
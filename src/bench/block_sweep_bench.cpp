@@ -0,0 +1,292 @@
+// Block size and sample rate sweep (env electrosmith_daisy_bench_block_sweep).
+//
+// Needs a patch cable from audio output 1 to audio input 1. For every
+// sample rate and block size below, restarts the audio and measures:
+//   - overhead: cycles per sample the audio interrupt path takes with a
+//     callback that only clears its outputs (DMA and SAI handlers, the
+//     conversion to and from the codec words, interrupt entry and exit)
+//   - load: share of the CPU the interrupts take while the AM modulator
+//     pipeline runs in the callback, plus the callback's own peak and
+//     its overruns from DAISY.CpuLoad()
+//   - latency: round trip of a click from output 1 back to input 1,
+//     buffering and codec filters together, as in codec_latency_bench
+// The load is what loop() loses: it counts the gaps in a tight DWT read
+// loop, less the gaps with the audio stopped (SysTick, USB), so it sees
+// the per-interrupt cost the callback's own meter cannot.
+//
+// After the sweep, prints a table over USB serial with the settings on
+// the latency / load Pareto front marked, among those that fit: no
+// overruns, load under kMaxLoad, and a rate that puts the carrier
+// band below Nyquist. Then sweeps again.
+//
+// The Seed's stock codec tops out at 96 kHz; its 192 kHz rows show the
+// CPU cost only, with no loopback latency.
+#include <DaisyDuino.h>
+#include "dsp_placement.h"
+#include "modulator_params.h"
+#include "modulator_pipeline.h"
+#include "modulator_stages.h"
+#include <string.h>
+
+using SampleRate = SaiHandle::Config::SampleRate;
+
+struct Rate
+{
+  SampleRate sr;
+  float hz;
+};
+static constexpr Rate kRates[] = {
+  {SampleRate::SAI_48KHZ, 48000.0f},
+  {SampleRate::SAI_96KHZ, 96000.0f},
+  {SampleRate::SAI_192KHZ, 192000.0f},
+};
+static constexpr size_t kBlockSizes[] = {1, 2, 4, 8, 16, 32, 48, 64, 128, 256};
+static constexpr size_t kNumRates = sizeof(kRates) / sizeof(kRates[0]);
+static constexpr size_t kNumBlockSizes = sizeof(kBlockSizes) / sizeof(kBlockSizes[0]);
+static constexpr size_t kNumSettings = kNumRates * kNumBlockSizes;
+
+static constexpr float kCarrierHz = 39500.0f;
+static constexpr float kSidebandHz = 5000.0f; // BaseLpf's corner
+static constexpr float kMaxLoad = 0.75f;      // headroom for loop() and control
+static constexpr uint32_t kSettleMs = 200;
+static constexpr uint32_t kMeasureMs = 1000;
+static constexpr uint32_t kGapCycles = 40; // longer than one pass of the read loop
+
+// Loopback clicks, one every kPeriodMs while the modulator runs.
+static constexpr uint32_t kPeriodMs = 100;
+static constexpr uint32_t kWindowFrames = 2048;
+static constexpr uint32_t kPulses = 8;
+static constexpr float kClick = 0.5f;
+static constexpr float kMinArrival = 0.05f; // below this, no loopback
+
+using ModulatorPipeline = Pipeline<BaseHpf, BaseLpf, LowShelf, AmMod<>, BandPass, PostHpf>;
+static ModulatorPipeline DSP_DTCM pipeline;
+static ModulatorParams params;
+
+struct Row
+{
+  float rate;
+  size_t block;
+  float overhead;  // cycles per sample, bare callback
+  float modulator; // cycles per sample, pipeline on top of the overhead
+  float load;      // interrupts' share of the CPU, modulator running
+  float peak;      // callback's highest block load
+  uint32_t overruns;
+  float latency;   // round trip in frames, 0 if no click came back
+  bool fits;
+  bool pareto;
+};
+static Row rows[kNumSettings];
+
+// Written by ModulatorCallback, read by loop() after the window.
+static uint32_t frame;
+static uint32_t period_frames;
+static uint32_t click_frame;
+static uint32_t best_frame;
+static float best;
+static volatile uint32_t pulses;
+static volatile uint32_t sum_delay;
+
+DSP_ITCM void BareCallback(float** in, float** out, size_t size)
+{
+  (void)in;
+  memset(out[0], 0, size * sizeof(float));
+  memset(out[1], 0, size * sizeof(float));
+}
+
+// The modulator on input 2, an open input standing in for the baseband;
+// output 1 then carries the clicks instead of its left channel.
+DSP_ITCM void ModulatorCallback(float** in, float** out, size_t size)
+{
+  memcpy(out[0], in[1], size * sizeof(float));
+  memcpy(out[1], in[1], size * sizeof(float));
+  StereoBlock block{out[0], out[1], size, params.Snapshot()};
+  pipeline.Process(block);
+
+  for (size_t i = 0; i < size; i++, frame++)
+  {
+    const uint32_t since = frame - click_frame;
+    out[0][i] = 0.0f;
+    if (pulses >= kPulses)
+      continue;
+    if (since >= period_frames)
+    {
+      click_frame = frame;
+      best = 0.0f;
+      best_frame = frame;
+      out[0][i] = kClick;
+      continue;
+    }
+    const float a = fabsf(in[0][i]);
+    if (since < kWindowFrames && a > best)
+    {
+      best = a;
+      best_frame = frame;
+    }
+    if (since == kWindowFrames && best > kMinArrival)
+    {
+      sum_delay = sum_delay + (best_frame - click_frame);
+      pulses = pulses + 1;
+    }
+  }
+}
+
+// Share of the cycles over ms that something other than this loop took.
+static float Stolen(uint32_t ms)
+{
+  const uint32_t window = (uint32_t)((uint64_t)DAISY.SysClkFreq() * ms / 1000);
+  const uint32_t start = DWT->CYCCNT;
+  uint32_t last = start;
+  uint32_t stolen = 0;
+  while (last - start < window)
+  {
+    const uint32_t now = DWT->CYCCNT;
+    if (now - last > kGapCycles)
+      stolen += now - last;
+    last = now;
+  }
+  return (float)stolen / (float)(last - start);
+}
+
+static CpuLoadMeter meter;
+static float baseline;
+
+static void Start(const Rate& rate, size_t block, bool modulator)
+{
+  DAISY.end();
+  DAISY.SetAudioSampleRate(rate.sr);
+  DAISY.SetAudioBlockSize(block);
+  if (modulator)
+  {
+    pipeline.Init(rate.hz);
+    params.Init(rate.hz);
+    period_frames = (uint32_t)(rate.hz * (float)kPeriodMs / 1000.0f);
+    pulses = 0;
+    sum_delay = 0;
+    click_frame = frame - period_frames; // click on the next frame
+    DAISY.begin(ModulatorCallback);
+  }
+  else
+  {
+    DAISY.begin(BareCallback);
+  }
+  delay(kSettleMs);
+  DAISY.CpuLoad().Reset();
+}
+
+static void Measure(Row& row, const Rate& rate, size_t block)
+{
+  const float cycles_per_sample = (float)DAISY.SysClkFreq() / rate.hz;
+  row.rate = rate.hz;
+  row.block = block;
+
+  Start(rate, block, false);
+  const float bare = Stolen(kMeasureMs) - baseline;
+  row.overhead = (bare > 0.0f ? bare : 0.0f) * cycles_per_sample;
+
+  Start(rate, block, true);
+  const float load = Stolen(kMeasureMs) - baseline;
+  row.load = load > 0.0f ? load : 0.0f;
+  row.modulator = row.load * cycles_per_sample - row.overhead;
+  row.peak = DAISY.CpuLoad().GetMaxCpuLoad();
+  row.overruns = DAISY.CpuLoad().GetOverruns();
+  const uint32_t n = pulses;
+  row.latency = n > 0 ? (float)sum_delay / (float)n : 0.0f;
+
+  row.fits = row.overruns == 0 && row.load < kMaxLoad && row.latency > 0.0f
+             && rate.hz > 2.0f * (kCarrierHz + kSidebandHz);
+}
+
+// On the front if no other fitting row is as good on both and better on one.
+static void MarkPareto()
+{
+  for (size_t i = 0; i < kNumSettings; i++)
+  {
+    Row& r = rows[i];
+    r.pareto = r.fits;
+    const float r_s = r.latency / r.rate;
+    for (size_t j = 0; j < kNumSettings && r.pareto; j++)
+    {
+      const Row& o = rows[j];
+      const float o_s = o.latency / o.rate;
+      if (j != i && o.fits && o_s <= r_s && o.load <= r.load && (o_s < r_s || o.load < r.load))
+        r.pareto = false;
+    }
+  }
+}
+
+static void PrintRow(const Row& r)
+{
+  Serial.print((uint32_t)(r.rate / 1000.0f));
+  Serial.print("k\t");
+  Serial.print((uint32_t)r.block);
+  Serial.print("\t");
+  Serial.print((double)r.overhead, 1);
+  Serial.print("\t");
+  Serial.print((double)r.modulator, 1);
+  Serial.print("\t");
+  Serial.print((double)(r.load * 100.0f), 1);
+  Serial.print("\t");
+  Serial.print((double)(r.peak * 100.0f), 1);
+  Serial.print("\t");
+  Serial.print(r.overruns);
+  Serial.print("\t");
+  if (r.latency > 0.0f)
+  {
+    Serial.print((double)r.latency, 1);
+    Serial.print("\t");
+    Serial.print((double)(r.latency * 1.0e6f / r.rate), 0);
+  }
+  else
+  {
+    Serial.print("-\t-");
+  }
+  Serial.print("\t");
+  Serial.println(r.pareto ? "pareto" : (r.fits ? "fits" : ""));
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  DAISY.init(DAISY_SEED, AUDIO_SR_96K, true);
+  // Only for the DWT cycle counter before the first start.
+  meter.Init(96000.0f, 48);
+  params.SetCarrierFreq(kCarrierHz);
+}
+
+void loop()
+{
+  DAISY.end();
+  delay(kSettleMs);
+  baseline = Stolen(kMeasureMs);
+
+  for (size_t r = 0; r < kNumRates; r++)
+    for (size_t b = 0; b < kNumBlockSizes; b++)
+      Measure(rows[r * kNumBlockSizes + b], kRates[r], kBlockSizes[b]);
+  DAISY.end();
+  MarkPareto();
+
+  Serial.print("sysclk ");
+  Serial.print(DAISY.SysClkFreq() / 1000000);
+  Serial.print(" MHz, idle baseline ");
+  Serial.print((double)(baseline * 100.0f), 2);
+  Serial.println("%");
+  Serial.println("rate\tblock\tovh c/s\tmod c/s\tload %\tpeak %\tovr\trt fr\trt us");
+  for (const Row& r : rows)
+    PrintRow(r);
+
+  const Row* best_row = nullptr;
+  for (const Row& r : rows)
+    if (r.fits && (best_row == nullptr || r.latency / r.rate < best_row->latency / best_row->rate))
+      best_row = &r;
+  if (best_row != nullptr)
+  {
+    Serial.print("lowest latency that fits: ");
+    PrintRow(*best_row);
+  }
+  else
+  {
+    Serial.println("no setting fits");
+  }
+  Serial.println();
+}
@@ -0,0 +1,168 @@
+// Codec filter latency benchmark.
+//
+// Needs a patch cable from audio output 1 to audio input 1. Sends a
+// one-sample click every 100 ms and times its arrival at the input,
+// stepping through the codec's filter settings (Pcm3060::Config on the
+// Patch SM, Wm8731::Config on a Seed 1.1; the Seed's AK4556 has none).
+// Prints over USB serial, per setting, the round trip in frames and the
+// part of it that is the codec's:
+//   round trip = buffering (AudioLatency()) + DAC + ADC filters + analog
+// The arrival is the largest input sample after the click, so a filter
+// with a long linear-phase response lands on its centre tap.
+//
+// Built for the Patch SM by default; env electrosmith_daisy_bench_codec_seed
+// builds it for the Seed with -DCODEC_BENCH_SEED.
+#include <DaisyDuino.h>
+
+#if defined(CODEC_BENCH_SEED)
+static constexpr DaisyDuinoDevice kDevice = DAISY_SEED;
+#else
+static constexpr DaisyDuinoDevice kDevice = DAISY_PATCH_SM;
+#endif
+
+static constexpr uint32_t kPeriodFrames = 9600; // 100 ms at 96 kHz
+static constexpr uint32_t kWindowFrames = 2048;
+static constexpr uint32_t kPulses = 16;
+static constexpr float kClick = 0.5f;
+static constexpr uint32_t kSettleMs = 300; // filter change, then DC settles
+
+struct Setting
+{
+  const char* name;
+  Pcm3060::Config::DacFilter dac_filter;
+  Pcm3060::Config::DacOversampling dac_oversampling;
+  bool adc_hpf;
+};
+
+using DacFilter = Pcm3060::Config::DacFilter;
+using DacOversampling = Pcm3060::Config::DacOversampling;
+static const Setting kSettings[] = {
+  {"sharp, normal os, hpf", DacFilter::SHARP_ROLLOFF, DacOversampling::NORMAL, true},
+  {"sharp, double os, hpf", DacFilter::SHARP_ROLLOFF, DacOversampling::DOUBLE, true},
+  {"slow, normal os, hpf", DacFilter::SLOW_ROLLOFF, DacOversampling::NORMAL, true},
+  {"slow, double os, hpf", DacFilter::SLOW_ROLLOFF, DacOversampling::DOUBLE, true},
+  {"sharp, normal os, no hpf", DacFilter::SHARP_ROLLOFF, DacOversampling::NORMAL, false},
+};
+static constexpr size_t kNumSettings = sizeof(kSettings) / sizeof(kSettings[0]);
+
+// Written by the callback, read by loop() once done is set.
+static volatile bool armed;
+static volatile bool done;
+static uint32_t frame;
+static uint32_t click_frame;
+static uint32_t pulses;
+static uint32_t sum_delay;
+static uint32_t min_delay, max_delay;
+static uint32_t best_frame;
+static float best;
+
+static size_t step;
+
+void AudioCallback(float** in, float** out, size_t size)
+{
+  for (size_t i = 0; i < size; i++, frame++)
+  {
+    const uint32_t since = frame - click_frame;
+    out[0][i] = 0.0f;
+    out[1][i] = 0.0f;
+    if (!armed || done)
+      continue;
+
+    if (since >= kPeriodFrames)
+    {
+      click_frame = frame;
+      best = 0.0f;
+      best_frame = frame;
+      out[0][i] = kClick;
+      continue;
+    }
+    const float a = fabsf(in[0][i]);
+    if (since < kWindowFrames && a > best)
+    {
+      best = a;
+      best_frame = frame;
+    }
+    if (since == kWindowFrames)
+    {
+      const uint32_t d = best_frame - click_frame;
+      sum_delay += d;
+      min_delay = d < min_delay ? d : min_delay;
+      max_delay = d > max_delay ? d : max_delay;
+      if (++pulses == kPulses)
+        done = true;
+    }
+  }
+}
+
+static void Apply(const Setting& s)
+{
+  if (kDevice == DAISY_PATCH_SM)
+  {
+    Pcm3060::Config cfg;
+    cfg.dac_filter = s.dac_filter;
+    cfg.dac_oversampling = s.dac_oversampling;
+    cfg.adc_hpf = s.adc_hpf;
+    DAISY.SetCodecConfig(cfg);
+  }
+  else
+  {
+    Wm8731::Config cfg;
+    cfg.Defaults();
+    cfg.adc_hpf = s.adc_hpf;
+    DAISY.SetCodecConfig(cfg);
+  }
+}
+
+static void StartStep()
+{
+  armed = false;
+  Apply(kSettings[step]);
+  delay(kSettleMs);
+  pulses = 0;
+  sum_delay = 0;
+  min_delay = 0xffffffff;
+  max_delay = 0;
+  done = false;
+  click_frame = frame - kPeriodFrames; // click on the next frame
+  armed = true;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  DAISY.init(kDevice, AUDIO_SR_96K);
+  DAISY.begin(AudioCallback);
+  StartStep();
+}
+
+void loop()
+{
+  if (!done)
+    return;
+
+  const float fs = DAISY.AudioSampleRate();
+  const float buffering = DAISY.AudioLatency() * fs;
+  const float mean = (float)sum_delay / (float)kPulses;
+  Serial.print(kSettings[step].name);
+  Serial.print(": round trip ");
+  Serial.print((double)mean, 1);
+  Serial.print(" frames (");
+  Serial.print(min_delay);
+  Serial.print("..");
+  Serial.print(max_delay);
+  Serial.print("), codec ");
+  Serial.print((double)(mean - buffering), 1);
+  Serial.print(" frames = ");
+  Serial.print((double)((mean - buffering) * 1.0e6f / fs), 1);
+  Serial.println(" us");
+
+  // The WM8731 only has the high-pass to change.
+  step = (step + 1) % kNumSettings;
+  if (kDevice != DAISY_PATCH_SM)
+  {
+    while (kSettings[step].dac_filter != DacFilter::SHARP_ROLLOFF ||
+           kSettings[step].dac_oversampling != DacOversampling::NORMAL)
+      step = (step + 1) % kNumSettings;
+  }
+  StartStep();
+}
@@ -0,0 +1,146 @@
+// Delay memory layout benchmark, on the Patch MultiDelay example's
+// per-sample loop: three 1-second lines in SDRAM, each with its own
+// gliding delay time, read then written with feedback.
+//   separate     DelayLine<float, 48000> DSY_SDRAM_BSS[3], as the
+//                example shipped: the lines are 256 kB + 12 bytes apart,
+//                so their write pointers share D-cache sets
+//   interleaved  InterleavedDelay<float, 48000, 3>: one frame per sample
+//                holds all three lines
+// The delay targets jump every half second, like knob moves. Prints
+// over USB serial, once a second, cycles per sample and the share of the
+// 48 kHz block period for each layout.
+#include <DaisyDuino.h>
+
+static constexpr float kSampleRate = 48000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocks = 1000; // 1 s of audio
+static constexpr size_t kMaxDelay = 48000;
+static constexpr size_t kLines = 3;
+
+static DelayLine<float, kMaxDelay> DSY_SDRAM_BSS separate[kLines];
+static InterleavedDelay<float, kMaxDelay, kLines> DSY_SDRAM_BSS interleaved;
+
+static CpuLoadMeter meter;
+static float input[kBlockSize];
+static volatile float sink; // keeps the loops from being optimised away
+
+struct Glide
+{
+  float current[kLines];
+  float target[kLines];
+
+  void Reset()
+  {
+    for (size_t d = 0; d < kLines; d++)
+      current[d] = target[d] = 2400.0f;
+  }
+
+  // Half-second knob moves through the example's .05 s to 1 s range.
+  void Move(size_t block)
+  {
+    if (block % 500 != 0)
+      return;
+    static const float kTargets[2][kLines] = {{14400.0f, 26400.0f, 38400.0f},
+                                              {31000.0f, 9000.0f, 45000.0f}};
+    for (size_t d = 0; d < kLines; d++)
+      target[d] = kTargets[(block / 500) % 2][d];
+  }
+};
+
+static Glide glide;
+static const float kFeedback = 0.6f;
+
+static uint32_t TimeSeparate()
+{
+  glide.Reset();
+  float mix = 0.0f;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    glide.Move(b);
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      for (size_t d = 0; d < kLines; d++)
+      {
+        fonepole(glide.current[d], glide.target[d], .0002f);
+        separate[d].SetDelay(glide.current[d]);
+        const float read = separate[d].Read();
+        separate[d].Write(kFeedback * read + input[i]);
+        mix += read;
+      }
+    }
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = mix;
+  return t1 - t0;
+}
+
+static uint32_t TimeInterleaved()
+{
+  glide.Reset();
+  float mix = 0.0f;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    glide.Move(b);
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      float frame[kLines];
+      for (size_t d = 0; d < kLines; d++)
+      {
+        fonepole(glide.current[d], glide.target[d], .0002f);
+        interleaved.SetDelay(d, glide.current[d]);
+        const float read = interleaved.Read(d);
+        frame[d] = kFeedback * read + input[i];
+        mix += read;
+      }
+      interleaved.Write(frame);
+    }
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = mix;
+  return t1 - t0;
+}
+
+static void Report(const char* name, uint32_t cycles)
+{
+  const float per_sample = (float)cycles / (float)(kBlocks * kBlockSize);
+  Serial.print("  ");
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((double)per_sample, 1);
+  Serial.print(" cycles/sample, ");
+  Serial.print((double)(per_sample * (float)kBlockSize * 100.0f / (float)meter.GetPeriodCycles()), 2);
+  Serial.println("% of block");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  System::Config sys;
+  sys.Defaults();
+  DAISY.init(DAISY_SEED, AUDIO_SR_48K, sys);
+
+  // Only for the DWT cycle counter and the block budget; the audio
+  // engine is never started.
+  meter.Init(kSampleRate, kBlockSize);
+
+  for (auto& line : separate)
+    line.Init();
+  interleaved.Init();
+  uint32_t x = 1;
+  for (float& s : input)
+  {
+    x = x * 1664525u + 1013904223u;
+    s = (float)(int32_t)x * (1.0f / 2147483648.0f);
+  }
+}
+
+void loop()
+{
+  Serial.println("MultiDelay, 3 lines:");
+  Report("separate   ", TimeSeparate());
+  Report("interleaved", TimeInterleaved());
+  delay(1000);
+}
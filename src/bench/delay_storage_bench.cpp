@@ -0,0 +1,152 @@
+// Delay storage type benchmark: the same feedback delay with float,
+// int16_t and __fp16 samples (DelayLine<T, N>), in two places:
+//   SDRAM   10 s lines at 48 kHz, 2 MB as float and 1 MB as 16-bit, read
+//           4 s back, so every sample moved is a memory access the
+//           D-cache cannot hide; a narrower type halves that traffic
+//   DTCM    4096-sample lines, no waits at all, so what is left is the
+//           cost of the conversions
+// Each place runs a block loop (ReadBlock() / WriteBlock()) and a
+// per-sample modulated Read(float) / Write(), over 1 s of 48-sample
+// blocks. Prints over USB serial, once a second, cycles per sample for
+// each type. __fp16 needs -mfp16-format=ieee, which this env passes.
+#include <DaisyDuino.h>
+
+static constexpr float kSampleRate = 48000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocks = 1000; // 1 s of audio
+static constexpr size_t kLong = 480000;
+static constexpr size_t kShort = 4096;
+static const float kFeedback = 0.5f;
+
+static DelayLine<float, kLong> DSY_SDRAM_BSS long_f32;
+static DelayLine<int16_t, kLong> DSY_SDRAM_BSS long_i16;
+static DelayLine<float, kShort> DTCM_MEM_SECTION short_f32;
+static DelayLine<int16_t, kShort> DTCM_MEM_SECTION short_i16;
+#if defined(__ARM_FP16_FORMAT_IEEE)
+static DelayLine<__fp16, kLong> DSY_SDRAM_BSS long_f16;
+static DelayLine<__fp16, kShort> DTCM_MEM_SECTION short_f16;
+#endif
+
+static float input[kBlockSize];
+static volatile float sink; // keeps the loops from being optimised away
+
+template <typename Line>
+static uint32_t TimeBlocks(Line& line, size_t delay)
+{
+  float read[kBlockSize];
+  float write[kBlockSize];
+  float mix = 0.0f;
+  line.SetDelay(delay);
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    line.ReadBlock(read, kBlockSize);
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      write[i] = input[i] + kFeedback * read[i];
+      mix += read[i];
+    }
+    line.WriteBlock(write, kBlockSize);
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = mix;
+  return t1 - t0;
+}
+
+template <typename Line>
+static uint32_t TimeModulated(Line& line, float delay)
+{
+  float mix = 0.0f;
+  float phase = 0.0f;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      // A +-32 sample triangle sweep, chorus style.
+      phase += 1.0f / 4800.0f;
+      phase -= (float)(int32_t)phase;
+      const float tri = phase < 0.5f ? phase : 1.0f - phase;
+      const float read = line.Read(delay + 128.0f * tri - 32.0f);
+      line.Write(input[i] + kFeedback * read);
+      mix += read;
+    }
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = mix;
+  return t1 - t0;
+}
+
+static void Report(const char* name, uint32_t cycles)
+{
+  Serial.print("    ");
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((double)((float)cycles / (float)(kBlocks * kBlockSize)), 2);
+  Serial.println(" cycles/sample");
+}
+
+template <typename Line>
+static void Run(const char* name, Line& line, size_t delay)
+{
+  line.Init();
+  Report(name, TimeBlocks(line, delay));
+}
+
+template <typename Line>
+static void RunModulated(const char* name, Line& line, float delay)
+{
+  line.Init();
+  Report(name, TimeModulated(line, delay));
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  System::Config sys;
+  sys.Defaults();
+  DAISY.init(DAISY_SEED, AUDIO_SR_48K, sys);
+
+  EnableCycleCounter();
+
+  uint32_t x = 1;
+  for (float& s : input)
+  {
+    x = x * 1664525u + 1013904223u;
+    s = (float)(int32_t)x * (0.25f / 2147483648.0f);
+  }
+}
+
+void loop()
+{
+  const size_t long_delay = (size_t)(4.0f * kSampleRate);
+  const size_t short_delay = 3000;
+
+  Serial.println("SDRAM, 10 s line, blocks:");
+  Run("float ", long_f32, long_delay);
+  Run("int16 ", long_i16, long_delay);
+#if defined(__ARM_FP16_FORMAT_IEEE)
+  Run("fp16  ", long_f16, long_delay);
+#endif
+  Serial.println("SDRAM, 10 s line, modulated:");
+  RunModulated("float ", long_f32, (float)long_delay);
+  RunModulated("int16 ", long_i16, (float)long_delay);
+#if defined(__ARM_FP16_FORMAT_IEEE)
+  RunModulated("fp16  ", long_f16, (float)long_delay);
+#endif
+  Serial.println("DTCM, 4096 samples, blocks:");
+  Run("float ", short_f32, short_delay);
+  Run("int16 ", short_i16, short_delay);
+#if defined(__ARM_FP16_FORMAT_IEEE)
+  Run("fp16  ", short_f16, short_delay);
+#endif
+  Serial.println("DTCM, 4096 samples, modulated:");
+  RunModulated("float ", short_f32, (float)short_delay);
+  RunModulated("int16 ", short_i16, (float)short_delay);
+#if defined(__ARM_FP16_FORMAT_IEEE)
+  RunModulated("fp16  ", short_f16, (float)short_delay);
+#endif
+  Serial.println();
+  delay(1000);
+}
@@ -0,0 +1,82 @@
+// Audio DMA buffer layout benchmark.
+//
+// Built twice from this file:
+//   env electrosmith_daisy_bench_dma         buffers in non-cached SRAM1
+//   env electrosmith_daisy_bench_dma_cached  -DDSY_AUDIO_DMA_CACHED, buffers
+//                                            cached with per-block
+//                                            invalidate / clean
+// Runs a planar pass-through callback, so the measured load is almost
+// all conversion to and from the DMA words, which is exactly the
+// traffic the layout changes. Steps through a few block sizes and prints
+// the callback load for each over USB serial; compare the two builds'
+// logs line by line.
+#include <DaisyDuino.h>
+
+static constexpr size_t kBlockSizes[] = {4, 16, 48, 128, 256};
+static constexpr size_t kNumBlockSizes = sizeof(kBlockSizes) / sizeof(kBlockSizes[0]);
+static constexpr uint32_t kSettleMs = 500;  // meter rearms on every resize
+static constexpr uint32_t kMeasureMs = 2000;
+
+#if defined(DSY_AUDIO_DMA_CACHED)
+static const char* const kLayout = "cached";
+#else
+static const char* const kLayout = "non-cached";
+#endif
+
+static size_t step;
+static uint32_t step_start_ms;
+static bool measuring;
+
+void AudioCallback(float** in, float** out, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    out[0][i] = in[0][i];
+    out[1][i] = in[1][i];
+  }
+}
+
+static void StartStep()
+{
+  DAISY.SetAudioBlockSize(kBlockSizes[step]);
+  step_start_ms = millis();
+  measuring = false;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  // The Arduino core leaves the D-cache off (see hal_conf_extra.h);
+  // both builds turn it on, so the comparison isolates the buffer layout.
+  if ((SCB->CCR & SCB_CCR_DC_Msk) == 0)
+    SCB_EnableDCache();
+  DAISY.init(DAISY_SEED, AUDIO_SR_96K, true);
+  DAISY.begin(AudioCallback);
+  StartStep();
+}
+
+void loop()
+{
+  const uint32_t elapsed = millis() - step_start_ms;
+  if (!measuring && elapsed >= kSettleMs)
+  {
+    DAISY.CpuLoad().Reset();
+    measuring = true;
+  }
+  if (!measuring || elapsed < kSettleMs + kMeasureMs)
+    return;
+
+  const CpuLoadMeter& meter = DAISY.CpuLoad();
+  Serial.print(kLayout);
+  Serial.print(" blocksize ");
+  Serial.print((uint32_t)DAISY.AudioBlockSize());
+  Serial.print(" load avg ");
+  Serial.print((double)(meter.GetAvgCpuLoad() * 100.0f), 2);
+  Serial.print("% max ");
+  Serial.print((double)(meter.GetMaxCpuLoad() * 100.0f), 2);
+  Serial.print("%  cycles/frame ");
+  Serial.println((double)(meter.GetAvgCpuLoad() * (float)meter.GetPeriodCycles() / (float)DAISY.AudioBlockSize()), 1);
+
+  step = (step + 1) % kNumBlockSizes;
+  StartStep();
+}
@@ -0,0 +1,191 @@
+// daisysp::fast benchmark.
+//
+// Built twice from this file:
+//   env electrosmith_daisy_bench_fast_math       modules on libm (math::)
+//   env electrosmith_daisy_bench_fast_math_fast  -DDAISYSP_FAST_MATH, the
+//                                                modules on fast::
+// Prints over USB serial, once a second, DWT cycles per call for:
+//   - each fast:: function, scalar and block, against its libm
+//     counterpart, over an input sweep in its range, with the largest
+//     difference from libm seen
+//   - each DaisySP module migrated to math::, on this build's choice
+// The function lines are the same in both builds; compare the module
+// lines between the two logs for the per-module saving.
+#include <DaisyDuino.h>
+
+static constexpr float kSampleRate = 48000.0f;
+static constexpr size_t kSize = 256;
+static constexpr size_t kRounds = 200;
+
+static CpuLoadMeter meter;
+static float in[kSize];
+static float out[kSize];
+static float ref[kSize];
+static volatile float sink; // keeps the loops from being optimised away
+
+static MoogLadder moog;
+static Compressor comp;
+static Autowah wah;
+static Svf svf;
+static Drip drip;
+
+using Scalar = float (*)(float);
+using Block = void (*)(const float*, float*, size_t);
+
+struct Function
+{
+  const char* name;
+  float lo, hi;
+  Scalar libm;
+  Scalar fast;
+  Block block;
+  bool relative;
+};
+
+static float LibSin(float x) { return sinf(x); }
+static float LibCos(float x) { return cosf(x); }
+static float LibTan(float x) { return tanf(x); }
+static float LibExp2(float x) { return exp2f(x); }
+static float LibExp(float x) { return expf(x); }
+static float LibLog2(float x) { return log2f(x); }
+static float LibTanh(float x) { return tanhf(x); }
+static float LibSqrt(float x) { return sqrtf(x); }
+
+static const Function kFunctions[] = {
+    {"sin ", -100.0f, 100.0f, LibSin, fast::sin, fast::sin, false},
+    {"cos ", -100.0f, 100.0f, LibCos, fast::cos, fast::cos, false},
+    {"tan ", -1.5f, 1.5f, LibTan, fast::tan, fast::tan, true},
+    {"exp2", -20.0f, 20.0f, LibExp2, fast::exp2, fast::exp2, true},
+    {"exp ", -10.0f, 10.0f, LibExp, fast::exp, fast::exp, true},
+    {"log2", 1e-6f, 1e6f, LibLog2, fast::log2, fast::log2, false},
+    {"tanh", -5.0f, 5.0f, LibTanh, fast::tanh, fast::tanh, false},
+    {"sqrt", 0.0f, 1000.0f, LibSqrt, fast::sqrt, fast::sqrt, false},
+};
+
+static float PerCall(uint32_t cycles)
+{
+  return (float)cycles / (float)(kRounds * kSize);
+}
+
+// One call per input, the result fed to the sink so the call stays.
+static uint32_t TimeScalar(Scalar f)
+{
+  float acc = 0.0f;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t r = 0; r < kRounds; r++)
+  {
+    for (size_t i = 0; i < kSize; i++)
+      acc += f(in[i]);
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = acc;
+  return t1 - t0;
+}
+
+static uint32_t TimeBlock(Block f)
+{
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t r = 0; r < kRounds; r++)
+    f(in, out, kSize);
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = out[kSize - 1];
+  return t1 - t0;
+}
+
+static void ReportFunction(const Function& f)
+{
+  for (size_t i = 0; i < kSize; i++)
+    in[i] = f.lo + (f.hi - f.lo) * (float)i / (float)kSize;
+  const float libm = PerCall(TimeScalar(f.libm));
+  const float scalar = PerCall(TimeScalar(f.fast));
+  const float block = PerCall(TimeBlock(f.block));
+  float worst = 0.0f;
+  for (size_t i = 0; i < kSize; i++)
+  {
+    ref[i] = f.libm(in[i]);
+    float e = fabsf(f.fast(in[i]) - ref[i]);
+    if (f.relative && ref[i] != 0.0f)
+      e /= fabsf(ref[i]);
+    worst = e > worst ? e : worst;
+  }
+  Serial.print("  ");
+  Serial.print(f.name);
+  Serial.print("  libm ");
+  Serial.print((double)libm, 1);
+  Serial.print("  fast ");
+  Serial.print((double)scalar, 1);
+  Serial.print("  block ");
+  Serial.print((double)block, 1);
+  Serial.print(f.relative ? "  max rel " : "  max abs ");
+  Serial.println((double)worst, 9);
+}
+
+template <class F>
+static void ReportModule(const char* name, F process)
+{
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t r = 0; r < kRounds; r++)
+  {
+    for (size_t i = 0; i < kSize; i++)
+      out[i] = process(in[i]);
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = out[0];
+  Serial.print("  ");
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((double)PerCall(t1 - t0), 1);
+  Serial.println(" cycles/sample");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  // Only for the DWT cycle counter; the audio engine is never started.
+  meter.Init(kSampleRate, kSize);
+
+  moog.Init(kSampleRate);
+  moog.SetRes(0.7f);
+  comp.Init(kSampleRate);
+  wah.Init(kSampleRate);
+  svf.Init(kSampleRate);
+  drip.Init(kSampleRate, 0.1f);
+}
+
+void loop()
+{
+  Serial.println("fast:: against libm, cycles per call:");
+  for (const Function& f : kFunctions)
+    ReportFunction(f);
+
+#if defined(DAISYSP_FAST_MATH)
+  Serial.println("Modules on fast:: (DAISYSP_FAST_MATH):");
+#else
+  Serial.println("Modules on libm:");
+#endif
+  for (size_t i = 0; i < kSize; i++)
+    in[i] = 0.5f * sinf(TWOPI_F * (float)i / (float)kSize);
+  float cutoff = 100.0f;
+  ReportModule("MoogLadder, cutoff per sample", [&](float x) {
+    cutoff = cutoff > 8000.0f ? 100.0f : cutoff * 1.001f;
+    moog.SetFreq(cutoff);
+    return moog.Process(x);
+  });
+  float attack = 0.001f;
+  ReportModule("Compressor, attack per sample", [&](float x) {
+    attack = attack > 0.1f ? 0.001f : attack * 1.001f;
+    comp.SetAttack(attack);
+    return comp.Process(x);
+  });
+  ReportModule("Autowah                      ", [&](float x) { return wah.Process(x); });
+  ReportModule("Svf, resonance per sample    ", [&](float x) {
+    svf.SetRes(0.5f + 0.4f * x);
+    svf.Process(x);
+    return svf.Low();
+  });
+  ReportModule("Drip                         ", [&](float) { return drip.Process(false); });
+  Serial.println();
+
+  delay(1000);
+}
@@ -0,0 +1,212 @@
+// daisysp::fixed benchmark (env electrosmith_daisy_bench_fixed).
+//
+// Runs each fixed-point module, Q31 and Q15, beside its float
+// counterpart over the same two-tone block, with the audio engine off.
+// Prints over USB serial, once a second:
+//   - DWT cycles per sample for float, Q31 and Q15
+//   - SNR of the Q31 and Q15 outputs against the float output, for
+//     the modules that compute the same response (the fixed Svf is
+//     the trapezoidal form, the float one the double-sampled, so it
+//     gets cycles only)
+#include <DaisyDuino.h>
+#include "dsp_placement.h"
+#include <math.h>
+
+static constexpr float kSampleRate = 48000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kRounds = 1000; // ~1 s of audio at 48 kHz
+static constexpr size_t kDelay = 4800;
+
+static CpuLoadMeter meter;
+
+static float DSP_DTCM in_f[kBlockSize];
+static float DSP_DTCM out_f[kBlockSize];
+static int32_t DSP_DTCM in_31[kBlockSize];
+static int32_t DSP_DTCM out_31[kBlockSize];
+static int16_t DSP_DTCM in_15[kBlockSize];
+static int16_t DSP_DTCM out_15[kBlockSize];
+
+static BiquadCascade<1> biquad_f;
+static fixed::Biquad<fixed::Q31> biquad_31;
+static fixed::Biquad<fixed::Q15> biquad_15;
+static Tone onepole_f;
+static fixed::OnePole<fixed::Q31> onepole_31;
+static fixed::OnePole<fixed::Q15> onepole_15;
+static Svf svf_f;
+static fixed::Svf<fixed::Q31> svf_31;
+static fixed::Svf<fixed::Q15> svf_15;
+static Nco nco_f;
+static fixed::Nco<fixed::Q31> nco_31;
+static fixed::Nco<fixed::Q15> nco_15;
+static DelayLine<float, kDelay> DSY_SDRAM_BSS delay_f;
+static fixed::DelayLine<fixed::Q31, kDelay> DSY_SDRAM_BSS delay_31;
+static fixed::DelayLine<fixed::Q15, kDelay> DSY_SDRAM_BSS delay_15;
+
+static Nco tone_a, tone_b;
+
+struct Result
+{
+  uint64_t cycles[3];
+  float signal, error[2];
+};
+
+static void Accumulate(Result& r)
+{
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    const float e31 = fixed::Q31::ToFloat(out_31[i]) - out_f[i];
+    const float e15 = fixed::Q15::ToFloat(out_15[i]) - out_f[i];
+    r.signal += out_f[i] * out_f[i];
+    r.error[0] += e31 * e31;
+    r.error[1] += e15 * e15;
+  }
+}
+
+template <class F, class Q, class H>
+static void Run(Result& r, F run_float, Q run_q31, H run_q15)
+{
+  const uint32_t t0 = DWT->CYCCNT;
+  run_float();
+  const uint32_t t1 = DWT->CYCCNT;
+  run_q31();
+  const uint32_t t2 = DWT->CYCCNT;
+  run_q15();
+  const uint32_t t3 = DWT->CYCCNT;
+  r.cycles[0] += t1 - t0;
+  r.cycles[1] += t2 - t1;
+  r.cycles[2] += t3 - t2;
+  Accumulate(r);
+}
+
+static void Report(const char* name, Result& r, bool snr)
+{
+  const float per_sample = 1.0f / (float)(kRounds * kBlockSize);
+  Serial.print(name);
+  Serial.print("  float ");
+  Serial.print((double)((float)r.cycles[0] * per_sample), 1);
+  Serial.print("  q31 ");
+  Serial.print((double)((float)r.cycles[1] * per_sample), 1);
+  Serial.print("  q15 ");
+  Serial.print((double)((float)r.cycles[2] * per_sample), 1);
+  if (snr)
+  {
+    for (size_t k = 0; k < 2; k++)
+    {
+      Serial.print(k == 0 ? "  snr q31 " : " q15 ");
+      Serial.print((double)(r.error[k] > 0.0f ? 10.0f * log10f(r.signal / r.error[k]) : 999.0f), 1);
+    }
+    Serial.print(" dB");
+  }
+  Serial.println();
+  r = Result();
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  // Only for the DWT cycle counter; the audio engine is never started.
+  meter.Init(kSampleRate, kBlockSize);
+  // Same flush-to-zero / default-NaN mode the audio ISR runs with.
+  __set_FPSCR(__get_FPSCR() | FPU_FPDSCR_FZ_Msk | FPU_FPDSCR_DN_Msk);
+
+  const BiquadSection hpf = IirDesign::Butterworth<2>(IirDesign::Response::HIGHPASS, kSampleRate, 80.0f)[0];
+  biquad_f.Init();
+  biquad_f.SetSection(0, hpf);
+  biquad_31.Init();
+  biquad_31.SetSection(hpf);
+  biquad_15.Init();
+  biquad_15.SetSection(hpf);
+
+  // Tone is y += a * (x - y) too, with its own pole for the corner:
+  // c2 = b - sqrt(b^2 - 1), b = 2 - cos(w). The OnePoles get the same a.
+  float corner = 500.0f;
+  onepole_f.Init(kSampleRate);
+  onepole_f.SetFreq(corner);
+  const float b = 2.0f - cosf(TWOPI_F * corner / kSampleRate);
+  const float a = 1.0f - (b - sqrtf(b * b - 1.0f));
+  onepole_31.Init(kSampleRate);
+  onepole_31.SetCoeff(a);
+  onepole_15.Init(kSampleRate);
+  onepole_15.SetCoeff(a);
+
+  svf_f.Init(kSampleRate);
+  svf_31.Init(kSampleRate);
+  svf_15.Init(kSampleRate);
+  svf_f.SetFreq(1200.0f);
+  svf_31.SetFreq(1200.0f);
+  svf_15.SetFreq(1200.0f);
+  svf_f.SetRes(0.6f);
+  svf_31.SetRes(0.6f);
+  svf_15.SetRes(0.6f);
+
+  nco_f.Init(kSampleRate);
+  nco_31.Init(kSampleRate);
+  nco_15.Init(kSampleRate);
+  nco_f.SetFreq(440.0f);
+  nco_31.SetFreq(440.0f);
+  nco_15.SetFreq(440.0f);
+
+  delay_f.Init();
+  delay_31.Init();
+  delay_15.Init();
+  delay_f.SetDelay(2400.5f);
+  delay_31.SetDelay(2400.5f);
+  delay_15.SetDelay(2400.5f);
+
+  // Two tones at -10 dBFS and -14 dBFS.
+  tone_a.Init(kSampleRate);
+  tone_b.Init(kSampleRate);
+  tone_a.SetFreq(220.0f);
+  tone_b.SetFreq(3100.0f);
+}
+
+void loop()
+{
+  static Result biquad, onepole, svf, nco, delay;
+
+  for (size_t round = 0; round < kRounds; round++)
+  {
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      in_f[i] = 0.3f * tone_a.Process() + 0.2f * tone_b.Process();
+      in_31[i] = fixed::Q31::FromFloat(in_f[i]);
+      in_15[i] = fixed::Q15::FromFloat(in_f[i]);
+    }
+
+    Run(
+        biquad, [] { biquad_f.ProcessBlock(in_f, out_f, kBlockSize); },
+        [] { biquad_31.ProcessBlock(in_31, out_31, kBlockSize); },
+        [] { biquad_15.ProcessBlock(in_15, out_15, kBlockSize); });
+    Run(
+        onepole, [] { onepole_f.ProcessBlock(in_f, out_f, kBlockSize); },
+        [] { onepole_31.ProcessBlock(in_31, out_31, nullptr, kBlockSize); },
+        [] { onepole_15.ProcessBlock(in_15, out_15, nullptr, kBlockSize); });
+    Run(
+        svf, [] { svf_f.ProcessBlock(in_f, out_f, nullptr, nullptr, nullptr, nullptr, kBlockSize); },
+        [] { svf_31.ProcessBlock(in_31, out_31, nullptr, nullptr, nullptr, kBlockSize); },
+        [] { svf_15.ProcessBlock(in_15, out_15, nullptr, nullptr, nullptr, kBlockSize); });
+    Run(
+        nco, [] { nco_f.ProcessBlock(out_f, nullptr, kBlockSize); },
+        [] { nco_31.ProcessBlock(out_31, nullptr, kBlockSize); },
+        [] { nco_15.ProcessBlock(out_15, nullptr, kBlockSize); });
+    Run(
+        delay,
+        [] {
+          for (size_t i = 0; i < kBlockSize; i++)
+          {
+            out_f[i] = delay_f.Read();
+            delay_f.Write(in_f[i]);
+          }
+        },
+        [] { delay_31.ProcessBlock(in_31, out_31, kBlockSize); },
+        [] { delay_15.ProcessBlock(in_15, out_15, kBlockSize); });
+  }
+
+  Serial.println("cycles/sample:");
+  Report("  Biquad   ", biquad, true);
+  Report("  OnePole  ", onepole, true);
+  Report("  Svf      ", svf, false);
+  Report("  Nco      ", nco, true);
+  Report("  DelayLine", delay, true);
+}
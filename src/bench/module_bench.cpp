@@ -0,0 +1,644 @@
+// DaisySP module benchmark.
+//
+// Times each module's Process() / ProcessBlock() over 48-sample blocks
+// of noise with the DWT cycle counter and prints a table over USB serial,
+// once every few seconds. Each module is initialized at 48 kHz and again
+// at 96 kHz; at each rate it gets two figures, in cycles per sample:
+//   cold   the first block after the D-cache is cleaned and invalidated
+//          and the I-cache invalidated: code and state come from flash,
+//          AXI SRAM or SDRAM, as for a module reached once per block
+//          behind much other work
+//   warm   the mean over kWarmBlocks blocks after a few untimed ones,
+//          with everything already in cache, as for a module that owns
+//          the callback
+// The last column is the warm 96 kHz figure as a share of the cycles one
+// sample period allows at this build's core clock.
+//
+// Modules are set up as in the examples, with defaults where there is a
+// choice. Those marked [SDRAM] keep their buffers there, where they would
+// in a real build, so their cold figure includes SDRAM misses; everything
+// else is in AXI SRAM. Triggered voices (drums, envelopes, plucks) fire
+// every kTrigBlocks blocks, so the mean includes the attacks.
+// "DrumKit<8> idle" is the same kit never struck, all eight asleep.
+// The voice banks strike a four-note chord, against one ModalVoice or
+// StringVoice above them.
+//
+// Run it after patching lib/DaisyDuino and compare the logs: the table is
+// the same from one build to the next, module for module.
+#include <DaisyDuino.h>
+
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kWarmBlocks = 200;
+static constexpr size_t kTrigBlocks = 50;
+static const float kRates[] = {48000.0f, 96000.0f};
+
+static float in[kBlockSize];
+static float out[kBlockSize];
+static float out2[kBlockSize];
+static float out3[kBlockSize];
+static int32_t in_q31[kBlockSize];
+static int32_t out_q31[kBlockSize];
+static volatile float sink; // keeps the loops from being optimised away
+
+template <class F>
+static void EachSample(F f)
+{
+  for (size_t i = 0; i < kBlockSize; i++)
+    out[i] = f(in[i]);
+}
+
+// A minimal voice for VoiceAllocator, as in its example.
+struct BenchVoice
+{
+  Oscillator osc;
+  Adsr env;
+  bool gate;
+
+  void Init(float sample_rate)
+  {
+    osc.Init(sample_rate);
+    osc.SetWaveform(Oscillator::WAVE_POLYBLEP_SAW);
+    env.Init(sample_rate);
+    gate = false;
+  }
+  void NoteOn(float note, float velocity)
+  {
+    osc.SetFreq(mtof(note));
+    osc.SetAmp(velocity);
+    gate = true;
+  }
+  void NoteOff() { gate = false; }
+  bool IsActive() const { return env.IsRunning(); }
+  float Process() { return osc.Process() * env.Process(gate); }
+};
+
+static void NoStftFrame(float*, size_t, void*) {}
+
+// Oscillators and noise
+static Oscillator osc;
+static BlOsc blosc;
+static Fm2 fm2;
+static FmVoice<fm_algorithm::Stack4> fm_voice;
+static FormantOscillator formant;
+static GrainletOscillator grainlet;
+static HarmonicOscillator<16> harmonic;
+static Nco nco;
+static OscillatorBank osc_bank;
+static AdditiveBank<16> additive;
+static Phasor phasor;
+static VariableSawOscillator var_saw;
+static VariableShapeOscillator var_shape;
+static VosimOscillator vosim;
+static ZOscillator zosc;
+static Wavetable saw_table;
+static float saw_mem[Wavetable::kStorageSize];
+static WavetableOsc wavetable;
+static WhiteNoise noise;
+static ClockedNoise clocked_noise;
+static Dust dust;
+static Particle particle;
+static FractalRandomGenerator<ClockedNoise, 5> fractal;
+static SmoothRandomGenerator smooth_random;
+static Jitter jitter;
+
+// Filters
+static Biquad biquad;
+static BiquadCascade<4> biquad_cascade;
+static StereoBiquadCascade<4> stereo_cascade;
+static StereoBiquadCascadeQ31<4> stereo_cascade_q31;
+static Svf svf;
+static MoogLadder moog;
+static Tone tone;
+static ATone atone;
+static DcBlock dc_block;
+static Mode mode;
+static NlFilt nlfilt;
+static Resonator resonator;
+static FIR<64, kBlockSize> fir;
+static float fir_ir[64];
+static Upsampler2x<19, kBlockSize> upsampler;
+static Downsampler2x<19, kBlockSize> downsampler;
+static Resampler<32, 256> resampler;
+static HilbertFir<31> hilbert_fir;
+static HilbertIir hilbert_iir;
+static FFTConvolver<16, 64> fft_convolver; // 48 is a multiple of 16
+static float convolver_ir[1024];
+static Stft<1024, 256> stft;
+static BlockChain<Biquad, Tone, DcBlock> block_chain;
+static FunctionChain<3> function_chain;
+
+// Effects and dynamics
+static Autowah autowah;
+static Balance balance;
+static Bitcrush bitcrush;
+static Chorus chorus;
+static Compressor compressor;
+static CrossFade crossfade;
+static Decimator decimator;
+static Flanger flanger;
+static Fold fold;
+static Limiter limiter;
+static Overdrive overdrive;
+static Phaser phaser;
+static SampleRateReducer sr_reducer;
+static Tremolo tremolo;
+static Waveshaper<SoftClipLutCurve, 2> waveshaper;
+static PitchShifter pitch_shifter;
+static ModDelay<20> mod_delay;
+static SmoothDelay<4096> smooth_delay;
+static float comb_buf[4096];
+static Comb comb;
+static float allpass_buf[2048];
+static Allpass allpass;
+static float bank_slab[8192];
+static CombBank<4> comb_bank;
+static AllpassBank<4> allpass_bank;
+static const size_t kBankLengths[4] = {1557, 1617, 1491, 1422};
+
+// Large state, in SDRAM
+static ReverbSc DSY_SDRAM_BSS reverb;
+static DelayLine<float, 48000> DSY_SDRAM_BSS delay_line;
+static InterleavedDelay<float, 48000, 2> DSY_SDRAM_BSS interleaved;
+static MultiTapDelay<float, 48000, 4> DSY_SDRAM_BSS multitap;
+static float DSY_SDRAM_BSS looper_mem[48000];
+static Looper looper;
+static float DSY_SDRAM_BSS granulator_mem[96000];
+static Granulator granulator;
+static float DSY_SDRAM_BSS convolution_mem[16 * 4 * 64];
+static ConvolutionReverb<16> convolution;
+static int16_t sample_data[8192];
+static int16_t sample_cache[SamplePlayer::kCacheSamples];
+static SamplePlayer sample_player;
+static SamplePlayer::Sample sample;
+
+// Envelopes, control and voices
+static AdEnv ad_env;
+static Adsr adsr;
+static Line line;
+static Metro metro;
+static Port port;
+static SampleHold sample_hold;
+static Maytrig maytrig;
+static SmootherBank<8> smoother;
+static AnalogBassDrum analog_bd;
+static AnalogSnareDrum analog_sd;
+static SyntheticBassDrum synth_bd;
+static SyntheticSnareDrum synth_sd;
+static HiHat<> hihat;
+static ModalVoice modal;
+static StringVoice string_voice;
+static ModalVoiceBank<4> modal_bank;
+static StringVoiceBank<4> string_voice_bank;
+static StringOsc string_osc;
+static constexpr size_t kStringMem = StringOsc::GetMemorySize(512);
+static float string_mem[16][kStringMem];
+static StringOsc string_bank[16];
+static float pluck_buf[256];
+static Pluck pluck;
+static PolyPluck<4> poly_pluck;
+static Drip drip;
+static VoiceAllocator<BenchVoice, 8> voices;
+static DrumKit<AnalogBassDrum, AnalogSnareDrum, SyntheticBassDrum, SyntheticSnareDrum, HiHat<>, ModalVoice, StringVoice,
+               HiHat<>>
+    drum_kit;
+
+static size_t block; // blocks since Init, for the triggers
+static bool Trig() { return block % kTrigBlocks == 0; }
+
+struct ModuleBench
+{
+  const char* name;
+  void (*init)(float sample_rate);
+  void (*run)(); // one kBlockSize block, in to out
+};
+
+// clang-format off
+static const ModuleBench kModules[] = {
+  // Oscillators and noise
+  {"Oscillator", [](float sr) { osc.Init(sr); osc.SetFreq(440.0f); },
+   [] { osc.ProcessBlock(out, kBlockSize); }},
+  {"BlOsc", [](float sr) { blosc.Init(sr); },
+   [] { EachSample([](float) { return blosc.Process(); }); }},
+  {"Fm2", [](float sr) { fm2.Init(sr); },
+   [] { EachSample([](float) { return fm2.Process(); }); }},
+  {"FmVoice<Stack4>", [](float sr) { fm_voice.Init(sr); fm_voice.SetFreq(220.0f); },
+   [] { fm_voice.ProcessBlock(out, kBlockSize); }},
+  {"FormantOscillator", [](float sr) { formant.Init(sr); },
+   [] { formant.ProcessBlock(out, kBlockSize); }},
+  {"GrainletOscillator", [](float sr) { grainlet.Init(sr); },
+   [] { grainlet.ProcessBlock(out, kBlockSize); }},
+  {"HarmonicOscillator<16>", [](float sr) { harmonic.Init(sr); harmonic.SetFreq(110.0f); },
+   [] { harmonic.ProcessBlock(out, kBlockSize); }},
+  {"Nco", [](float sr) { nco.Init(sr); nco.SetFreq(1000.0f); },
+   [] { nco.ProcessBlock(out, out2, kBlockSize); }},
+  {"OscillatorBank", [](float sr) { osc_bank.Init(sr); },
+   [] { osc_bank.ProcessBlock(out, kBlockSize); }},
+  {"AdditiveBank<16>", [](float sr) { additive.Init(sr); },
+   [] { additive.ProcessBlock(out, kBlockSize); }},
+  {"Phasor", [](float sr) { phasor.Init(sr, 1.0f); },
+   [] { phasor.ProcessBlock(out, kBlockSize); }},
+  {"VariableSawOscillator", [](float sr) { var_saw.Init(sr); },
+   [] { var_saw.ProcessBlock(out, kBlockSize); }},
+  {"VariableShapeOscillator", [](float sr) { var_shape.Init(sr); },
+   [] { var_shape.ProcessBlock(out, kBlockSize); }},
+  {"VosimOscillator", [](float sr) { vosim.Init(sr); },
+   [] { vosim.ProcessBlock(out, kBlockSize); }},
+  {"ZOscillator", [](float sr) { zosc.Init(sr); },
+   [] { EachSample([](float) { return zosc.Process(); }); }},
+  {"WavetableOsc", [](float sr) { wavetable.Init(sr, &saw_table); },
+   [] { wavetable.ProcessBlock(out, kBlockSize); }},
+  {"WhiteNoise", [](float) { noise.Init(); },
+   [] { EachSample([](float) { return noise.Process(); }); }},
+  {"ClockedNoise", [](float sr) { clocked_noise.Init(sr); clocked_noise.SetFreq(1000.0f); },
+   [] { EachSample([](float) { return clocked_noise.Process(); }); }},
+  {"Dust", [](float) { dust.Init(); },
+   [] { EachSample([](float) { return dust.Process(); }); }},
+  {"Particle", [](float sr) { particle.Init(sr); },
+   [] { particle.ProcessBlock(out, kBlockSize); }},
+  {"FractalRandomGenerator<5>", [](float sr) { fractal.Init(sr); },
+   [] { EachSample([](float) { return fractal.Process(); }); }},
+  {"SmoothRandomGenerator", [](float sr) { smooth_random.Init(sr); },
+   [] { EachSample([](float) { return smooth_random.Process(); }); }},
+  {"Jitter", [](float sr) { jitter.Init(sr); },
+   [] { EachSample([](float) { return jitter.Process(); }); }},
+
+  // Filters
+  {"Biquad", [](float sr) { biquad.Init(sr); },
+   [] { biquad.ProcessBlock(in, out, kBlockSize); }},
+  {"BiquadCascade<4>", [](float) { biquad_cascade.Init(); },
+   [] { biquad_cascade.ProcessBlock(in, out, kBlockSize); }},
+  {"StereoBiquadCascade<4>", [](float) { stereo_cascade.Init(); },
+   [] { stereo_cascade.ProcessBlock(in, in, out, out2, kBlockSize); }},
+  {"StereoBiquadCascadeQ31<4>", [](float) { stereo_cascade_q31.Init(); },
+   [] { stereo_cascade_q31.ProcessBlock(in_q31, in_q31, out_q31, out_q31, kBlockSize); }},
+  {"Svf", [](float sr) { svf.Init(sr); },
+   [] { svf.ProcessBlock(in, out, out2, out3, out3, out3, kBlockSize); }},
+  {"MoogLadder", [](float sr) { moog.Init(sr); },
+   [] { moog.ProcessBlock(in, out, kBlockSize); }},
+  {"Tone", [](float sr) { tone.Init(sr); },
+   [] { tone.ProcessBlock(in, out, kBlockSize); }},
+  {"ATone", [](float sr) { atone.Init(sr); },
+   [] { atone.ProcessBlock(in, out, kBlockSize); }},
+  {"DcBlock", [](float sr) { dc_block.Init(sr); },
+   [] { dc_block.ProcessBlock(in, out, kBlockSize); }},
+  {"Mode", [](float sr) { mode.Init(sr); },
+   [] { EachSample([](float x) { return mode.Process(x); }); }},
+  {"NlFilt", [](float) { nlfilt.Init(); },
+   [] { nlfilt.ProcessBlock(in, out, kBlockSize); }},
+  {"Resonator", [](float sr) { resonator.Init(0.1f, 24, sr); },
+   [] { EachSample([](float x) { return resonator.Process(x); }); }},
+  {"FIR<64>", [](float) { fir.Init(fir_ir, 64, false); },
+   [] { fir.ProcessBlock(in, out, kBlockSize); }},
+  {"Upsampler2x<19>", [](float) { upsampler.Init(); },
+   [] { upsampler.ProcessBlock(in, out, kBlockSize / 2); }},
+  {"Downsampler2x<19>", [](float) { downsampler.Init(); },
+   [] { downsampler.ProcessBlock(in, out, kBlockSize / 2); }},
+  {"Resampler<32> 44.1 kHz stereo", [](float sr) { resampler.Init(44100.0f, sr); },
+   [] {
+     resampler.Write(in, in, resampler.FramesNeeded(kBlockSize));
+     resampler.Read(out, out2, kBlockSize);
+   }},
+  {"HilbertFir<31>", [](float) { hilbert_fir.Init(); },
+   [] { hilbert_fir.ProcessBlock(in, out, out2, kBlockSize); }},
+  {"HilbertIir", [](float) { hilbert_iir.Init(); },
+   [] { hilbert_iir.ProcessBlock(in, out, out2, kBlockSize); }},
+  {"FFTConvolver<16> 1024 taps", [](float) { fft_convolver.Init(convolver_ir, 1024); },
+   [] { fft_convolver.ProcessBlock(in, out, kBlockSize); }},
+  {"Stft<1024, 256>", [](float) { stft.Init(kBlockSize, NoStftFrame, nullptr); },
+   [] { stft.ProcessBlock(in, out, kBlockSize); stft.ProcessFrames(); }},
+  {"BlockChain<Biquad, Tone, DcBlock>",
+   [](float sr) { block_chain.ForEach([sr](auto& s) { s.Init(sr); }); },
+   [] { block_chain.ProcessBlock(in, out, kBlockSize); }},
+  {"FunctionChain<3>",
+   [](float sr) {
+     biquad.Init(sr);
+     tone.Init(sr);
+     dc_block.Init(sr);
+     function_chain.Init();
+     function_chain.Add(biquad);
+     function_chain.Add(tone);
+     function_chain.Add(dc_block);
+   },
+   [] { function_chain.ProcessBlock(in, out, kBlockSize); }},
+
+  // Effects and dynamics
+  {"Autowah", [](float sr) { autowah.Init(sr); },
+   [] { autowah.ProcessBlock(in, out, kBlockSize); }},
+  {"Balance", [](float sr) { balance.Init(sr); },
+   [] { balance.ProcessBlock(in, in, out, kBlockSize); }},
+  {"Bitcrush", [](float sr) { bitcrush.Init(sr); },
+   [] { EachSample([](float x) { return bitcrush.Process(x); }); }},
+  {"Chorus", [](float sr) { chorus.Init(sr); },
+   [] { chorus.ProcessBlock(in, out, out2, kBlockSize); }},
+  {"Compressor", [](float sr) { compressor.Init(sr); },
+   [] { compressor.ProcessBlock(in, out, kBlockSize); }},
+  {"CrossFade", [](float) { crossfade.Init(); },
+   [] { crossfade.ProcessBlock(in, in, out, kBlockSize); }},
+  {"Decimator", [](float) { decimator.Init(); },
+   [] { EachSample([](float x) { return decimator.Process(x); }); }},
+  {"Flanger", [](float sr) { flanger.Init(sr); },
+   [] { flanger.ProcessBlock(in, out, kBlockSize); }},
+  {"Fold", [](float) { fold.Init(); },
+   [] { EachSample([](float x) { return fold.Process(x); }); }},
+  {"Limiter", [](float) { limiter.Init(); },
+   [] { memcpy(out, in, sizeof(out)); limiter.ProcessBlock(out, kBlockSize, 1.0f); }},
+  {"Overdrive", [](float) { overdrive.Init(); },
+   [] { EachSample([](float x) { return overdrive.Process(x); }); }},
+  {"Phaser", [](float sr) { phaser.Init(sr); },
+   [] { phaser.ProcessBlock(in, out, kBlockSize); }},
+  {"SampleRateReducer", [](float) { sr_reducer.Init(); },
+   [] { EachSample([](float x) { return sr_reducer.Process(x); }); }},
+  {"Tremolo", [](float sr) { tremolo.Init(sr); },
+   [] { tremolo.ProcessBlock(in, out, kBlockSize); }},
+  {"Waveshaper<SoftClipLut, 2>", [](float) { waveshaper.Init(); },
+   [] { waveshaper.ProcessBlock(in, out, kBlockSize); }},
+  {"PitchShifter", [](float sr) { pitch_shifter.Init(sr); pitch_shifter.SetTransposition(7.0f); },
+   [] { pitch_shifter.ProcessBlock(in, out, kBlockSize); }},
+  {"ModDelay<20>", [](float sr) { mod_delay.Init(sr); },
+   [] { mod_delay.ProcessBlock(in, out, kBlockSize); }},
+  {"SmoothDelay<4096>", [](float sr) { smooth_delay.Init(sr); },
+   [] { smooth_delay.ProcessBlock(in, out, kBlockSize); }},
+  {"Comb", [](float sr) { comb.Init(sr, comb_buf, 4096); },
+   [] { comb.ProcessBlock(in, out, kBlockSize); }},
+  {"Allpass", [](float sr) { allpass.Init(sr, allpass_buf, 2048); },
+   [] { allpass.ProcessBlock(in, out, kBlockSize); }},
+  {"CombBank<4>", [](float sr) { comb_bank.Init(sr, bank_slab, 8192, kBankLengths); },
+   [] { comb_bank.ProcessBlock(in, out, kBlockSize); }},
+  {"AllpassBank<4>", [](float sr) { allpass_bank.Init(sr, bank_slab, 8192, kBankLengths); },
+   [] { allpass_bank.ProcessBlock(in, out, kBlockSize); }},
+  {"ReverbSc [SDRAM]", [](float sr) { reverb.Init(sr); },
+   [] { reverb.ProcessBlock(in, in, out, out2, kBlockSize); }},
+  {"DelayLine<float> [SDRAM]", [](float) { delay_line.Init(); delay_line.SetDelay(12000.5f); },
+   [] { EachSample([](float x) { delay_line.Write(x); return delay_line.Read(); }); }},
+  {"InterleavedDelay<2> [SDRAM]",
+   [](float) { interleaved.Init(); interleaved.SetDelay(0, 12000.5f); interleaved.SetDelay(1, 9000.25f); },
+   [] {
+     for (size_t i = 0; i < kBlockSize; i++)
+     {
+       float frame[2] = {in[i], in[i]};
+       interleaved.Write(frame);
+       interleaved.Read(frame);
+       out[i] = frame[0] + frame[1];
+     }
+   }},
+  {"MultiTapDelay<4> [SDRAM]",
+   [](float)
+   {
+     static const float delays[4] = {3000.0f, 7000.5f, 11000.25f, 23000.75f};
+     multitap.Init();
+     multitap.SetDelays(delays);
+   },
+   [] {
+     for (size_t i = 0; i < kBlockSize; i++)
+     {
+       float taps[4];
+       multitap.Write(in[i]);
+       multitap.Read(taps);
+       out[i] = taps[0] + taps[1] + taps[2] + taps[3];
+     }
+   }},
+  {"Looper [SDRAM]", [](float) { looper.Init(looper_mem, 48000); looper.TrigRecord(); },
+   [] { looper.ProcessBlock(in, out, kBlockSize); }},
+  {"Granulator [SDRAM]", [](float sr) { granulator.Init(sr, granulator_mem, 96000); },
+   [] { granulator.ProcessBlock(in, out, kBlockSize); }},
+  {"ConvolutionReverb<16> [SDRAM]",
+   [](float sr)
+   {
+     convolution.Init(sr, convolution_mem, 16 * 4 * 64);
+     convolution.Load(convolver_ir, convolution.Plan(1024, 1.0f, (float)SystemCoreClock));
+     while (!convolution.LoadStep())
+     {
+     }
+   },
+   [] { convolution.ProcessBlock(in, out, kBlockSize); }},
+  {"SamplePlayer", [](float sr) { sample_player.Init(sr, sample_cache); sample_player.SetLoop(true); sample_player.Play(sample); },
+   [] { sample_player.ProcessBlock(out, out2, kBlockSize); }},
+
+  // Envelopes, control and voices
+  {"AdEnv", [](float sr) { ad_env.Init(sr); },
+   [] {
+     if (Trig())
+       ad_env.Trigger();
+     ad_env.ProcessBlock(out, kBlockSize);
+   }},
+  {"Adsr", [](float sr) { adsr.Init(sr); },
+   [] { adsr.ProcessBlock(out, kBlockSize, block % kTrigBlocks < kTrigBlocks / 2); }},
+  {"Line", [](float sr) { line.Init(sr); line.Start(0.0f, 1.0f, 10.0f); },
+   [] {
+     uint8_t done;
+     EachSample([&done](float) { return line.Process(&done); });
+   }},
+  {"Metro", [](float sr) { metro.Init(2.0f, sr); },
+   [] { EachSample([](float) { return (float)metro.Process(); }); }},
+  {"Port", [](float sr) { port.Init(sr, 0.02f); },
+   [] { EachSample([](float x) { return port.Process(x); }); }},
+  {"SampleHold", [](float) {},
+   [] { EachSample([](float x) { return sample_hold.Process(x > 0.9f, x); }); }},
+  {"Maytrig", [](float) {},
+   [] { EachSample([](float) { return maytrig.Process(0.5f); }); }},
+  {"SmootherBank<8>", [](float sr) { smoother.Init(sr, kBlockSize); },
+   [] {
+     for (size_t i = 0; i < 8; i++)
+       smoother.Set(i, in[i]);
+     smoother.Update(kBlockSize);
+     smoother.Fill(0, out, kBlockSize);
+   }},
+  {"AnalogBassDrum", [](float sr) { analog_bd.Init(sr); },
+   [] {
+     if (Trig())
+       analog_bd.Trig();
+     analog_bd.ProcessBlock(out, kBlockSize);
+   }},
+  {"AnalogSnareDrum", [](float sr) { analog_sd.Init(sr); },
+   [] {
+     const bool trig = Trig();
+     EachSample([trig](float) { return analog_sd.Process(trig); });
+   }},
+  {"SyntheticBassDrum", [](float sr) { synth_bd.Init(sr); },
+   [] {
+     if (Trig())
+       synth_bd.Trig();
+     synth_bd.ProcessBlock(out, kBlockSize);
+   }},
+  {"SyntheticSnareDrum", [](float sr) { synth_sd.Init(sr); },
+   [] {
+     const bool trig = Trig();
+     EachSample([trig](float) { return synth_sd.Process(trig); });
+   }},
+  {"HiHat<>", [](float sr) { hihat.Init(sr); },
+   [] {
+     if (Trig())
+       hihat.Trig();
+     hihat.ProcessBlock(out, kBlockSize);
+   }},
+  {"ModalVoice", [](float sr) { modal.Init(sr); },
+   [] {
+     const bool trig = Trig();
+     EachSample([trig](float) { return modal.Process(trig); });
+   }},
+  {"StringVoice", [](float sr) { string_voice.Init(sr); },
+   [] {
+     const bool trig = Trig();
+     EachSample([trig](float) { return string_voice.Process(trig); });
+   }},
+  {"ModalVoiceBank<4>", [](float sr) { modal_bank.Init(sr); },
+   [] {
+     if (Trig())
+       for (size_t i = 0; i < 4; i++)
+         modal_bank.Strike(mtof(48.0f + 4.0f * (float)i));
+     modal_bank.ProcessBlock(out, kBlockSize);
+   }},
+  {"StringVoiceBank<4>", [](float sr) { string_voice_bank.Init(sr); },
+   [] {
+     if (Trig())
+       for (size_t i = 0; i < 4; i++)
+         string_voice_bank.Strike(mtof(48.0f + 4.0f * (float)i));
+     string_voice_bank.ProcessBlock(out, kBlockSize);
+   }},
+  {"StringOsc", [](float sr) { string_osc.Init(sr); string_osc.SetFreq(110.0f); },
+   [] { EachSample([](float x) { return string_osc.Process(x); }); }},
+  {"StringOsc x16, caller memory",
+   [](float sr)
+   {
+     for (size_t i = 0; i < 16; i++)
+     {
+       string_bank[i].Init(sr, string_mem[i], kStringMem);
+       string_bank[i].SetFreq(mtof(36.0f + 3.0f * (float)i));
+     }
+   },
+   [] {
+     for (size_t i = 0; i < 16; i++)
+       string_bank[i].ProcessBlock(in, i == 0 ? out : out2, kBlockSize);
+   }},
+  {"Pluck", [](float sr) { pluck.Init(sr, pluck_buf, 256, PLUCK_MODE_RECURSIVE); },
+   [] {
+     float trig = Trig() ? 1.0f : 0.0f;
+     EachSample([&trig](float) { const float s = pluck.Process(trig); trig = 0.0f; return s; });
+   }},
+  {"PolyPluck<4>", [](float sr) { poly_pluck.Init(sr); },
+   [] {
+     float trig = Trig() ? 1.0f : 0.0f;
+     EachSample([&trig](float) { const float s = poly_pluck.Process(trig, 48.0f); trig = 0.0f; return s; });
+   }},
+  {"Drip", [](float sr) { drip.Init(sr, 0.01f); },
+   [] {
+     const bool trig = Trig();
+     EachSample([trig](float) { return drip.Process(trig); });
+   }},
+  {"VoiceAllocator<8>",
+   [](float sr)
+   {
+     for (size_t i = 0; i < 8; i++)
+       voices.GetVoice(i).Init(sr);
+     voices.Init();
+   },
+   [] {
+     if (Trig())
+     {
+       voices.AllNotesOff();
+       for (size_t i = 0; i < 8; i++)
+         voices.NoteOn(48.0f + 3.0f * (float)i, 0.5f);
+     }
+     voices.ProcessBlock(out, kBlockSize);
+   }},
+  {"DrumKit<8>", [](float sr) { drum_kit.Init(sr); },
+   [] {
+     if (Trig())
+       for (size_t i = 0; i < drum_kit.kNumVoices; i++)
+         drum_kit.Trig(i);
+     drum_kit.ProcessBlock(out, kBlockSize);
+   }},
+  {"DrumKit<8> idle", [](float sr) { drum_kit.Init(sr); }, [] { drum_kit.ProcessBlock(out, kBlockSize); }},
+};
+// clang-format on
+
+static constexpr size_t kNumModules = sizeof(kModules) / sizeof(kModules[0]);
+
+static void InvalidateCaches()
+{
+  SCB_CleanInvalidateDCache();
+  SCB_InvalidateICache();
+  __DSB();
+  __ISB();
+}
+
+static float Run(const ModuleBench& m, size_t blocks)
+{
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < blocks; b++, block++)
+    m.run();
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = out[0];
+  return (float)(t1 - t0) / (float)(blocks * kBlockSize);
+}
+
+static void Column(float value, int width)
+{
+  char text[16];
+  snprintf(text, sizeof(text), "%*.1f", width, (double)value);
+  Serial.print(text);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  System::Config sys;
+  sys.Defaults();
+  DAISY.init(DAISY_SEED, AUDIO_SR_48K, sys);
+
+  EnableCycleCounter();
+  __set_FPSCR(__get_FPSCR() | FPU_FPDSCR_FZ_Msk | FPU_FPDSCR_DN_Msk);
+
+  // A quarter-scale noise input, and the tables some modules read.
+  WhiteNoise source;
+  source.Init();
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    in[i] = 0.25f * source.Process();
+    in_q31[i] = (int32_t)(in[i] * 2147483647.0f);
+  }
+  for (size_t i = 0; i < 64; i++)
+    fir_ir[i] = (i == 0 ? 1.0f : 0.0f) + 0.01f * source.Process();
+  for (size_t i = 0; i < 1024; i++)
+    convolver_ir[i] = source.Process() * (1.0f - (float)i / 1024.0f);
+  for (size_t i = 0; i < 8192; i++)
+    sample_data[i] = (int16_t)(8192.0f * source.Process());
+  sample.data = sample_data;
+  sample.frames = 4096;
+  sample.channels = 2;
+  sample.sample_rate = 48000.0f;
+  saw_table.Init(saw_mem);
+  saw_table.BuildSaw();
+}
+
+void loop()
+{
+  Serial.print(kNumModules);
+  Serial.print(" modules, cycles/sample at ");
+  Serial.print(SystemCoreClock / 1000000);
+  Serial.println(" MHz, 48-sample blocks");
+  Serial.println("module                          48k cold  48k warm  96k cold  96k warm  96k load%");
+
+  for (const ModuleBench& m : kModules)
+  {
+    char name[33];
+    snprintf(name, sizeof(name), "%-32s", m.name);
+    Serial.print(name);
+    float warm = 0.0f;
+    for (float rate : kRates)
+    {
+      m.init(rate);
+      block = 0;
+      InvalidateCaches();
+      Column(Run(m, 1), 8);
+      Run(m, 4);
+      warm = Run(m, kWarmBlocks);
+      Column(warm, 10);
+    }
+    Column(100.0f * warm * kRates[1] / (float)SystemCoreClock, 11);
+    Serial.println();
+  }
+  Serial.println();
+  delay(5000);
+}
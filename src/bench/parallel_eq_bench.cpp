@@ -0,0 +1,131 @@
+// Serial against parallel biquad EQ (env electrosmith_daisy_bench_parallel_eq).
+//
+// An EQ of 2, 4, 8 and 10 peaking bands (ConfigurePeaking, 60 Hz to
+// 16 kHz, Q 1.4, +-6 dB) at 96 kHz, as BiquadCascade<n> and as the
+// ParallelBiquad<n> SetCascade() expands it to. Prints over USB serial,
+// once a second:
+//   - DWT cycles per sample of each, over noise blocks
+//   - SNR of each against the same cascade in double, over the blocks
+// The audio engine is never started.
+#include <DaisyDuino.h>
+#include "biquad_design.h"
+#include "dsp_placement.h"
+
+static constexpr float kRate = 96000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocks = 1000;
+static constexpr size_t kMaxBands = 10;
+
+static constexpr float kBandHz[kMaxBands] = {60.0f, 120.0f, 250.0f, 500.0f, 1000.0f,
+                                             2000.0f, 4000.0f, 8000.0f, 12000.0f, 16000.0f};
+static constexpr float kBandDb[kMaxBands] = {4.0f, -3.0f, 2.5f, -1.5f, -6.0f, 3.0f, -2.0f, 5.0f, -4.0f, 6.0f};
+
+static CpuLoadMeter meter;
+static float DSP_DTCM in[kBlockSize];
+static float DSP_DTCM out_serial[kBlockSize];
+static float DSP_DTCM out_parallel[kBlockSize];
+static WhiteNoise noise;
+
+// The reference: the same sections, coefficients and state in double.
+struct DoubleSection
+{
+  double b0, b1, b2, a1, a2, z1, z2;
+};
+
+template <size_t n>
+static void Run()
+{
+  static BiquadCascade<n> DSP_DTCM serial;
+  static ParallelBiquad<n> DSP_DTCM parallel;
+  static DoubleSection ref[n];
+
+  // Spread the bands over the whole range whatever n is.
+  BiquadSection bands[n];
+  serial.Init();
+  for (size_t k = 0; k < n; k++)
+  {
+    const size_t b = n > 1 ? k * (kMaxBands - 1) / (n - 1) : 0;
+    ConfigurePeaking(bands[k], kRate, kBandHz[b], 1.4f, kBandDb[b]);
+    serial.SetSection(k, bands[k]);
+    ref[k] = DoubleSection{bands[k].b0, bands[k].b1, bands[k].b2, bands[k].a1, bands[k].a2, 0.0, 0.0};
+  }
+  parallel.Init();
+  if (!parallel.SetCascade(bands, n))
+  {
+    Serial.print("  ");
+    Serial.print((int)n);
+    Serial.println(" bands: no parallel form");
+    return;
+  }
+
+  uint32_t cycles_serial = 0, cycles_parallel = 0;
+  double signal = 0.0, err_serial = 0.0, err_parallel = 0.0;
+  for (size_t blk = 0; blk < kBlocks; blk++)
+  {
+    for (size_t i = 0; i < kBlockSize; i++)
+      in[i] = 0.25f * noise.Process();
+
+    const uint32_t t0 = DWT->CYCCNT;
+    serial.ProcessBlock(in, out_serial, kBlockSize);
+    const uint32_t t1 = DWT->CYCCNT;
+    parallel.ProcessBlock(in, out_parallel, kBlockSize);
+    const uint32_t t2 = DWT->CYCCNT;
+    cycles_serial += t1 - t0;
+    cycles_parallel += t2 - t1;
+
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      double x = in[i];
+      for (DoubleSection& s : ref)
+      {
+        const double y = s.b0 * x + s.z1;
+        s.z1 = s.b1 * x - s.a1 * y + s.z2;
+        s.z2 = s.b2 * x - s.a2 * y;
+        x = y;
+      }
+      const double es = (double)out_serial[i] - x;
+      const double ep = (double)out_parallel[i] - x;
+      signal += x * x;
+      err_serial += es * es;
+      err_parallel += ep * ep;
+    }
+  }
+
+  const float per_sample = 1.0f / (float)(kBlocks * kBlockSize);
+  Serial.print("  ");
+  Serial.print((int)n);
+  Serial.print(" bands  serial ");
+  Serial.print((double)((float)cycles_serial * per_sample), 1);
+  Serial.print("  parallel ");
+  Serial.print((double)((float)cycles_parallel * per_sample), 1);
+  Serial.print(" cycles/sample  snr serial ");
+  Serial.print(10.0 * log10(signal / err_serial), 1);
+  Serial.print(" parallel ");
+  Serial.print(10.0 * log10(signal / err_parallel), 1);
+  Serial.println(" dB");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  // Only for the DWT cycle counter; the audio engine is never started.
+  meter.Init(kRate, kBlockSize);
+  // Same flush-to-zero / default-NaN mode the audio ISR runs with.
+  __set_FPSCR(__get_FPSCR() | FPU_FPDSCR_FZ_Msk | FPU_FPDSCR_DN_Msk);
+  noise.Init();
+}
+
+void loop()
+{
+#if defined(USE_ARM_DSP)
+  Serial.println("BiquadCascade on CMSIS arm_biquad_cascade_df2T_f32:");
+#else
+  Serial.println("BiquadCascade, generic loop:");
+#endif
+  Run<2>();
+  Run<4>();
+  Run<8>();
+  Run<10>();
+  delay(1000);
+}
@@ -0,0 +1,154 @@
+// Float vs Q31 AM pipeline benchmark (env electrosmith_daisy_bench_q31).
+//
+// Runs the same synthetic two-tone input through both pipelines, one
+// block at a time as the audio callback would, with the audio engine
+// off. Prints over USB serial, once a second:
+//   - DWT cycles per block for each path, including the conversion to
+//     and from the codec's 24-bit words
+//   - SNR of the Q31 output against the float output, both taken at
+//     the 24-bit codec words the DAC would receive
+#include <DaisyDuino.h>
+#include "dsp_placement.h"
+#include "modulator_params.h"
+#include "modulator_pipeline.h"
+#include "modulator_stages.h"
+#include "modulator_stages_q31.h"
+#include <math.h>
+
+static constexpr float kSampleRate = 96000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocksPerReport = 2000; // ~1 s of audio at 96 kHz
+static constexpr size_t kSettleBlocks = 200;     // skip filter start-up in the SNR
+
+using FloatPipeline = Pipeline<BaseHpf, BaseLpf, LowShelf, AmMod<>, BandPass, PostHpf>;
+using Q31Pipeline = Pipeline<Q31Filter<BaseHpf>,
+                             Q31Filter<BaseLpf>,
+                             Q31Filter<LowShelf>,
+                             AmModQ31<>,
+                             Q31Filter<BandPass>,
+                             Q31Filter<PostHpf>>;
+
+static FloatPipeline DSP_DTCM float_pipeline;
+static Q31Pipeline DSP_DTCM q31_pipeline;
+static ModulatorParams params;
+
+// Interleaved 24-bit words, as the native callback sees them.
+static int32_t DSP_DTCM in_words[2 * kBlockSize];
+static int32_t DSP_DTCM out_float[2 * kBlockSize];
+static int32_t DSP_DTCM out_q31[2 * kBlockSize];
+static float DSP_DTCM f_l[kBlockSize];
+static float DSP_DTCM f_r[kBlockSize];
+static int32_t DSP_DTCM q_l[kBlockSize];
+static int32_t DSP_DTCM q_r[kBlockSize];
+
+static CpuLoadMeter meter;
+static Nco tone_l, tone_r;
+static size_t block_count;
+static uint64_t float_cycles, q31_cycles;
+static float signal_energy, error_energy;
+
+// Float path as AudioCallback runs it behind AudioHandle's conversion.
+static DSP_ITCM void RunFloat()
+{
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    f_l[i] = s242f(in_words[2 * i]);
+    f_r[i] = s242f(in_words[2 * i + 1]);
+  }
+  StereoBlock block{f_l, f_r, kBlockSize, params.Snapshot()};
+  float_pipeline.Process(block);
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    out_float[2 * i] = f2s24(f_l[i]);
+    out_float[2 * i + 1] = f2s24(f_r[i]);
+  }
+}
+
+// Q31 path as AudioCallbackQ31 runs it.
+static DSP_ITCM void RunQ31()
+{
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    q_l[i] = Sai24ToQ31(in_words[2 * i]);
+    q_r[i] = Sai24ToQ31(in_words[2 * i + 1]);
+  }
+  Q31Block block{q_l, q_r, kBlockSize, params.Snapshot()};
+  q31_pipeline.Process(block);
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    out_q31[2 * i] = Q31ToSai24(q_l[i]);
+    out_q31[2 * i + 1] = Q31ToSai24(q_r[i]);
+  }
+}
+
+static inline int32_t SignExtend24(int32_t w)
+{
+  return (int32_t)((uint32_t)w << 8) >> 8;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  // Only for the DWT cycle counter and the block budget; the audio
+  // engine is never started.
+  meter.Init(kSampleRate, kBlockSize);
+  // Same flush-to-zero / default-NaN mode the audio ISR runs with.
+  __set_FPSCR(__get_FPSCR() | FPU_FPDSCR_FZ_Msk | FPU_FPDSCR_DN_Msk);
+
+  float_pipeline.Init(kSampleRate);
+  q31_pipeline.Init(kSampleRate);
+  params.Init(kSampleRate);
+
+  // Two baseband tones at -10 dBFS and -14 dBFS.
+  tone_l.Init(kSampleRate);
+  tone_r.Init(kSampleRate);
+  tone_l.SetFreq(1000.0f);
+  tone_r.SetFreq(3100.0f);
+}
+
+void loop()
+{
+  for (size_t i = 0; i < kBlockSize; i++)
+  {
+    in_words[2 * i] = f2s24(0.3f * tone_l.Process()) & 0xffffff;
+    in_words[2 * i + 1] = f2s24(0.2f * tone_r.Process()) & 0xffffff;
+  }
+
+  uint32_t t0 = DWT->CYCCNT;
+  RunFloat();
+  uint32_t t1 = DWT->CYCCNT;
+  RunQ31();
+  uint32_t t2 = DWT->CYCCNT;
+  float_cycles += t1 - t0;
+  q31_cycles += t2 - t1;
+
+  if (block_count >= kSettleBlocks)
+  {
+    for (size_t i = 0; i < 2 * kBlockSize; i++)
+    {
+      const float ref = (float)SignExtend24(out_float[i]);
+      const float err = ref - (float)SignExtend24(out_q31[i]);
+      signal_energy += ref * ref;
+      error_energy += err * err;
+    }
+  }
+
+  if (++block_count % kBlocksPerReport == 0)
+  {
+    const float snr_db = error_energy > 0.0f ? 10.0f * log10f(signal_energy / error_energy) : 999.0f;
+    Serial.print("cycles/block float ");
+    Serial.print((uint32_t)(float_cycles / kBlocksPerReport));
+    Serial.print(" q31 ");
+    Serial.print((uint32_t)(q31_cycles / kBlocksPerReport));
+    Serial.print(" (budget ");
+    Serial.print(meter.GetPeriodCycles());
+    Serial.print(")  snr ");
+    Serial.print((double)snr_db, 1);
+    Serial.println(" dB");
+    float_cycles = 0;
+    q31_cycles = 0;
+    signal_energy = 0.0f;
+    error_energy = 0.0f;
+  }
+}
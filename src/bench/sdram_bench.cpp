@@ -0,0 +1,232 @@
+// SDRAM timing profile benchmark.
+//
+// Built three times from this file:
+//   env electrosmith_daisy_bench_sdram             400 MHz, LEGACY timing
+//   env electrosmith_daisy_bench_sdram_fast        400 MHz, DATASHEET timing
+//   env electrosmith_daisy_bench_sdram_fast_boost  480 MHz, DATASHEET timing
+// First checks all 64 MB with two address-derived patterns; a profile
+// with errors is not usable, whatever its speed. Then prints over USB
+// serial, once every few seconds:
+//   - sequential write and read bandwidth over 4 MB
+//   - strided reads: one per 32-byte cache line, and one per 2 KB row,
+//     so every access opens a new row
+//   - random access latency, as a pointer chase through 32 MB
+//   - a 1 MB SDRAM to SDRAM copy by the MDMA against memcpy
+// The D-cache is on throughout; every pass starts with the lines it
+// touches out of the cache, so each access reaches the SDRAM.
+#include <DaisyDuino.h>
+#include <string.h>
+
+#if defined(SDRAM_BENCH_DATASHEET)
+static constexpr System::Config::SdramTiming kTiming = System::Config::SdramTiming::DATASHEET;
+static const char* const kProfile = "datasheet";
+#else
+static constexpr System::Config::SdramTiming kTiming = System::Config::SdramTiming::LEGACY;
+static const char* const kProfile = "legacy";
+#endif
+
+static constexpr size_t kWords = 64 * 1024 * 1024 / 4;
+static constexpr size_t kSeqBytes = 4 * 1024 * 1024;
+static constexpr size_t kCopyBytes = 1024 * 1024;
+static constexpr size_t kChaseNodes = 32 * 1024 * 1024 / 32; // one per line
+static constexpr size_t kChaseHops = 1 << 16;
+
+static uint32_t DSY_SDRAM_BSS ram[kWords];
+static volatile uint32_t sink; // keeps the read loops from being optimised away
+
+static MDMA_HandleTypeDef hmdma;
+static uint32_t errors;
+
+static uint32_t Pattern(size_t i, uint32_t seed)
+{
+  // Address in every bit position, so stuck and shorted address lines
+  // show up as well as data lines.
+  const uint32_t a = (uint32_t)i;
+  return (a * 0x9E3779B1u) ^ (a << 16) ^ seed;
+}
+
+static uint32_t Check(uint32_t seed)
+{
+  for (size_t i = 0; i < kWords; i++)
+    ram[i] = Pattern(i, seed);
+  SCB_CleanInvalidateDCache();
+  uint32_t bad = 0;
+  for (size_t i = 0; i < kWords; i++)
+    bad += ram[i] != Pattern(i, seed);
+  return bad;
+}
+
+static void Flush(const void* p, size_t bytes)
+{
+  SCB_CleanInvalidateDCache_by_Addr((uint32_t*)p, (int32_t)bytes);
+}
+
+static void PrintRate(const char* name, size_t bytes, uint32_t cycles)
+{
+  const float mbs = (float)bytes * (float)SystemCoreClock / (float)cycles / 1.0e6f;
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((double)mbs, 1);
+  Serial.println(" MB/s");
+}
+
+static void PrintLatency(const char* name, size_t accesses, uint32_t cycles)
+{
+  const float ns = (float)cycles * 1.0e9f / (float)SystemCoreClock / (float)accesses;
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((double)ns, 1);
+  Serial.println(" ns/access");
+}
+
+static void Sequential()
+{
+  const size_t n = kSeqBytes / 4;
+  Flush(ram, kSeqBytes);
+  uint32_t t0 = DWT->CYCCNT;
+  for (size_t i = 0; i < n; i++)
+    ram[i] = (uint32_t)i;
+  SCB_CleanDCache_by_Addr(ram, (int32_t)kSeqBytes); // the write is done once it is in SDRAM
+  uint32_t t1 = DWT->CYCCNT;
+  PrintRate("seq write", kSeqBytes, t1 - t0);
+
+  SCB_InvalidateDCache_by_Addr(ram, (int32_t)kSeqBytes);
+  uint32_t sum = 0;
+  t0 = DWT->CYCCNT;
+  for (size_t i = 0; i < n; i++)
+    sum += ram[i];
+  t1 = DWT->CYCCNT;
+  sink = sum;
+  PrintRate("seq read", kSeqBytes, t1 - t0);
+}
+
+static void Strided(const char* name, size_t stride_bytes)
+{
+  const size_t step = stride_bytes / 4;
+  const size_t n = kSeqBytes / stride_bytes;
+  SCB_InvalidateDCache_by_Addr(ram, (int32_t)kSeqBytes);
+  uint32_t sum = 0;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t i = 0; i < n; i++)
+    sum += ram[i * step];
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = sum;
+  PrintLatency(name, n, t1 - t0);
+}
+
+// Sattolo's shuffle gives a single cycle through every node, so the
+// chase visits lines in random order and never settles into the cache.
+static void BuildChase()
+{
+  uint32_t* next = ram;
+  for (size_t i = 0; i < kChaseNodes; i++)
+    next[i * 8] = (uint32_t)i;
+  uint32_t x = 0x12345678;
+  for (size_t i = kChaseNodes - 1; i > 0; i--)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    const size_t j = x % i;
+    const uint32_t t = next[i * 8];
+    next[i * 8] = next[j * 8];
+    next[j * 8] = t;
+  }
+  SCB_CleanInvalidateDCache();
+}
+
+static void Chase()
+{
+  const uint32_t* next = ram;
+  uint32_t node = 0;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t i = 0; i < kChaseHops; i++)
+    node = next[node * 8];
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = node;
+  PrintLatency("random", kChaseHops, t1 - t0);
+  SCB_InvalidateDCache_by_Addr((uint32_t*)ram, 32 * 1024 * 1024);
+}
+
+static void InitMdma()
+{
+  __HAL_RCC_MDMA_CLK_ENABLE();
+  hmdma.Instance = MDMA_Channel15; // the SAI MDMA channels count up from 0
+  hmdma.Init.Request = MDMA_REQUEST_SW;
+  hmdma.Init.TransferTriggerMode = MDMA_FULL_TRANSFER;
+  hmdma.Init.Priority = MDMA_PRIORITY_HIGH;
+  hmdma.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+  hmdma.Init.SourceInc = MDMA_SRC_INC_WORD;
+  hmdma.Init.DestinationInc = MDMA_DEST_INC_WORD;
+  hmdma.Init.SourceDataSize = MDMA_SRC_DATASIZE_WORD;
+  hmdma.Init.DestDataSize = MDMA_DEST_DATASIZE_WORD;
+  hmdma.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+  hmdma.Init.BufferTransferLength = 128;
+  hmdma.Init.SourceBurst = MDMA_SOURCE_BURST_16BEATS;
+  hmdma.Init.DestBurst = MDMA_DEST_BURST_16BEATS;
+  hmdma.Init.SourceBlockAddressOffset = 0;
+  hmdma.Init.DestBlockAddressOffset = 0;
+  HAL_MDMA_Init(&hmdma);
+}
+
+static void Copy()
+{
+  uint32_t* src = ram;
+  uint32_t* dst = ram + kCopyBytes / 4;
+
+  // 32 blocks of 32 KB; the MDMA block length tops out at 64 KB.
+  Flush(src, 2 * kCopyBytes);
+  uint32_t t0 = DWT->CYCCNT;
+  HAL_MDMA_Start(&hmdma, (uint32_t)src, (uint32_t)dst, 32 * 1024, 32);
+  HAL_MDMA_PollForTransfer(&hmdma, HAL_MDMA_FULL_TRANSFER, 100);
+  uint32_t t1 = DWT->CYCCNT;
+  PrintRate("mdma copy", kCopyBytes, t1 - t0);
+
+  Flush(src, 2 * kCopyBytes);
+  t0 = DWT->CYCCNT;
+  memcpy(dst, src, kCopyBytes);
+  SCB_CleanDCache_by_Addr(dst, (int32_t)kCopyBytes);
+  t1 = DWT->CYCCNT;
+  PrintRate("cpu copy", kCopyBytes, t1 - t0);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  System::Config sys;
+#if defined(SDRAM_BENCH_BOOST)
+  sys.Boost();
+#else
+  sys.Defaults();
+#endif
+  sys.sdram_timing = kTiming;
+  DAISY.init(DAISY_SEED, AUDIO_SR_48K, sys);
+
+  // Only for the DWT cycle counter; the audio engine is never started.
+  EnableCycleCounter();
+
+  errors = Check(0) + Check(0xFFFFFFFFu);
+  InitMdma();
+}
+
+void loop()
+{
+  Serial.print(kProfile);
+  Serial.print(" timing, ");
+  Serial.print(DAISY.SysClkFreq() / 1000000);
+  Serial.print(" MHz cpu, ");
+  Serial.print(dsy_sdram_get_clock() / 1000000);
+  Serial.print(" MHz sdclk, ");
+  Serial.print(errors);
+  Serial.println(" errors in 2 x 64 MB");
+
+  Sequential();
+  Strided("stride 32B", 32);
+  Strided("stride 2KB", 2048);
+  BuildChase();
+  Chase();
+  Copy();
+  Serial.println();
+  delay(3000);
+}
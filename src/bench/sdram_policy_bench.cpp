@@ -0,0 +1,119 @@
+// SDRAM cache policy benchmark.
+//
+// Four DelayLine<float, 65536> with modulated taps far back in the line,
+// plus a one-second record buffer written alongside, as a looper would,
+// all in one 2 MB SDRAM window. Each pass re-runs the same 48-sample
+// blocks with the window under another dsy_mpu_policy:
+//   write-back          the default; the record buffer is not DMA-safe
+//   write-back + clean  dsy_dcache_clean() on each block's record span,
+//                       what a DMA reading the looper needs
+//   write-through       DMA-safe for reads with no maintenance
+//   non-cached          DMA-safe both ways
+// Prints over USB serial, once every few seconds, cycles per sample and
+// the share of the 48 kHz block period.
+#include <DaisyDuino.h>
+
+static constexpr float kSampleRate = 48000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocks = 1000; // 1 s of audio
+static constexpr size_t kLines = 4;
+static constexpr size_t kRecFrames = 48000;
+static constexpr uint32_t kWindowBytes = 2 * 1024 * 1024;
+
+using Line = DelayLine<float, 65536>;
+
+static uint8_t DSY_SDRAM_BSS __attribute__((aligned(2 * 1024 * 1024))) window[kWindowBytes];
+
+static CpuLoadMeter meter;
+static SdramArena arena;
+static Line* lines[kLines];
+static float* rec;
+static Oscillator lfo;
+static volatile float sink; // keeps the loops from being optimised away
+
+struct Pass
+{
+  const char* name;
+  dsy_mpu_policy policy;
+  bool clean;
+};
+
+static const Pass kPasses[] = {
+  {"write-back", DSY_MPU_WRITE_BACK, false},
+  {"write-back + clean", DSY_MPU_WRITE_BACK, true},
+  {"write-through", DSY_MPU_WRITE_THROUGH, false},
+  {"non-cached", DSY_MPU_NON_CACHED, false},
+};
+
+static uint32_t Run(bool clean)
+{
+  size_t rec_pos = 0;
+  float x = 0.0f;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    float* const span = rec + rec_pos;
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      const float mod = lfo.Process();
+      float sum = 0.0f;
+      for (size_t l = 0; l < kLines; l++)
+      {
+        const float d = 20000.0f + 9000.0f * (float)l + 200.0f * mod;
+        const float y = lines[l]->Read(d);
+        lines[l]->Write(x + 0.4f * y);
+        sum += y;
+      }
+      x = 0.999f * x + 0.001f * sum;
+      span[i] = sum;
+    }
+    if (clean)
+      dsy_dcache_clean(span, kBlockSize * sizeof(float));
+    rec_pos = (rec_pos + kBlockSize) % kRecFrames;
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = x;
+  return t1 - t0;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  System::Config sys;
+  sys.Defaults();
+  DAISY.init(DAISY_SEED, AUDIO_SR_48K, sys);
+
+  // Only for the DWT cycle counter and the block budget; the audio
+  // engine is never started.
+  meter.Init(kSampleRate, kBlockSize);
+
+  arena.Init(window, sizeof(window));
+  for (size_t l = 0; l < kLines; l++)
+    lines[l] = arena.New<Line>();
+  rec = arena.AllocateCleared<float>(kRecFrames);
+  lfo.Init(kSampleRate);
+  lfo.SetFreq(0.3f);
+}
+
+void loop()
+{
+  Serial.println("policy, cycles/sample, % of block");
+  for (const Pass& pass : kPasses)
+  {
+    dsy_mpu_set_sdram_policy(window, kWindowBytes, pass.policy);
+    for (Line* line : lines)
+      line->Init();
+    Run(pass.clean); // fills the lines, so the timed pass reads real data
+    const uint32_t cycles = Run(pass.clean);
+
+    const float per_sample = (float)cycles / (float)(kBlocks * kBlockSize);
+    Serial.print(pass.name);
+    Serial.print(", ");
+    Serial.print((double)per_sample, 1);
+    Serial.print(", ");
+    Serial.println((double)(per_sample * (float)kBlockSize * 100.0f / (float)meter.GetPeriodCycles()), 2);
+  }
+  Serial.println();
+  delay(3000);
+}
@@ -0,0 +1,118 @@
+// FastSin benchmark.
+//
+// Built twice from this file:
+//   env electrosmith_daisy_bench_sine       oscillators on the default
+//                                           FastSin tier (POLY7)
+//   env electrosmith_daisy_bench_sine_libm  -DDSY_FASTSIN_TIER=LIBM, the
+//                                           sinf() they used before
+// Prints over USB serial, once a second, DWT cycles per sample for:
+//   - each FastSin tier on its own, over a sweep of phases
+//   - each DaisySP oscillator that goes through FastSin, on this
+//     build's tier
+// The tier lines are the same in both builds; compare the oscillator
+// lines between the two logs for the per-module saving.
+#include <DaisyDuino.h>
+
+static constexpr float kSampleRate = 96000.0f;
+static constexpr size_t kBlockSize = 48;
+static constexpr size_t kBlocks = 2000; // ~1 s of audio at 96 kHz
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+static CpuLoadMeter meter;
+static Oscillator osc;
+static HarmonicOscillator<16> harmonic;
+static ZOscillator zosc;
+static FormantOscillator formant;
+static VosimOscillator vosim;
+static GrainletOscillator grainlet;
+static float out[kBlockSize];
+static volatile float sink; // keeps the loops from being optimised away
+
+template <FastSin::Tier tier>
+static uint32_t TimeTier()
+{
+  float phase = 0.0f;
+  float acc = 0.0f;
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    for (size_t i = 0; i < kBlockSize; i++)
+    {
+      acc += FastSin::Sin<tier>(phase);
+      phase += 0.01234f;
+    }
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = acc;
+  return t1 - t0;
+}
+
+template <class Osc>
+static uint32_t TimeOsc(Osc& o)
+{
+  const uint32_t t0 = DWT->CYCCNT;
+  for (size_t b = 0; b < kBlocks; b++)
+  {
+    for (size_t i = 0; i < kBlockSize; i++)
+      out[i] = o.Process();
+  }
+  const uint32_t t1 = DWT->CYCCNT;
+  sink = out[0];
+  return t1 - t0;
+}
+
+static void Report(const char* name, uint32_t cycles)
+{
+  Serial.print("  ");
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print((double)((float)cycles / (float)(kBlocks * kBlockSize)), 1);
+  Serial.println(" cycles/sample");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  // Only for the DWT cycle counter; the audio engine is never started.
+  meter.Init(kSampleRate, kBlockSize);
+  __set_FPSCR(__get_FPSCR() | FPU_FPDSCR_FZ_Msk | FPU_FPDSCR_DN_Msk);
+
+  FastSin::Init();
+  osc.Init(kSampleRate);
+  osc.SetFreq(440.0f);
+  harmonic.Init(kSampleRate);
+  harmonic.SetFreq(110.0f);
+  zosc.Init(kSampleRate);
+  zosc.SetFreq(220.0f);
+  formant.Init(kSampleRate);
+  formant.SetFormantFreq(1200.0f);
+  formant.SetCarrierFreq(220.0f);
+  vosim.Init(kSampleRate);
+  vosim.SetFreq(220.0f);
+  grainlet.Init(kSampleRate);
+  grainlet.SetFreq(220.0f);
+}
+
+void loop()
+{
+  Serial.println("FastSin tiers:");
+  Report("LIBM ", TimeTier<FastSin::Tier::LIBM>());
+  Report("TABLE", TimeTier<FastSin::Tier::TABLE>());
+  Report("POLY5", TimeTier<FastSin::Tier::POLY5>());
+  Report("POLY7", TimeTier<FastSin::Tier::POLY7>());
+  Report("POLY9", TimeTier<FastSin::Tier::POLY9>());
+
+  Serial.println("Oscillators on tier " STR(DSY_FASTSIN_TIER) ":");
+  Report("Oscillator (sine)     ", TimeOsc(osc));
+  Report("HarmonicOscillator<16>", TimeOsc(harmonic));
+  Report("ZOscillator           ", TimeOsc(zosc));
+  Report("FormantOscillator     ", TimeOsc(formant));
+  Report("VosimOscillator       ", TimeOsc(vosim));
+  Report("GrainletOscillator    ", TimeOsc(grainlet));
+  Serial.println();
+
+  delay(1000);
+}
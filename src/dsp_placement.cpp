@@ -0,0 +1,28 @@
+#include "dsp_placement.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__arm__)
+// Provided by ld/dsp_sections.ld.
+extern "C" uint32_t _sdsp_dtcm_bss;
+extern "C" uint32_t _edsp_dtcm_bss;
+extern "C" uint32_t _sdsp_itcm_text;
+extern "C" uint32_t _edsp_itcm_text;
+extern "C" uint32_t _sidsp_itcm_text;
+
+// Runs from the init array ahead of every default-priority constructor,
+// so C++ objects in DTCM are zeroed before they are constructed and ITCM
+// code is in place before anything can call it.
+__attribute__((constructor(101))) static void DspPlacementInit()
+{
+  uint8_t* dtcm = reinterpret_cast<uint8_t*>(&_sdsp_dtcm_bss);
+  memset(dtcm, 0, reinterpret_cast<uint8_t*>(&_edsp_dtcm_bss) - dtcm);
+
+  uint8_t* itcm = reinterpret_cast<uint8_t*>(&_sdsp_itcm_text);
+  memcpy(itcm, &_sidsp_itcm_text, reinterpret_cast<uint8_t*>(&_edsp_itcm_text) - itcm);
+
+  // Make the copied instructions visible to the fetch unit.
+  __DSB();
+  __ISB();
+}
+#endif
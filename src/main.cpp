@@ -1,318 +1,938 @@
 #include <DaisyDuino.h>
-#include <cmath>
+#include "drive_governor.h"
+#include "dsp_placement.h"
+#include "input_gate.h"
+#include "modulator_params.h"
+#include "modulator_pipeline.h"
+#include "modulator_stages.h"
+#include "modulator_stages_q31.h"
+#if defined(MODULATOR_CAPTURE)
+#include "audio_capture.h"
+#endif
+#if defined(MODULATOR_MEASURE)
+#include "spectral_monitor.h"
+#endif
+#if defined(MODULATOR_AUTOTUNE)
+#include "resonance_tracker.h"
+#endif
+#if defined(MODULATOR_MOD_METER)
+#include "mod_index_meter.h"
+#endif
+#if defined(MODULATOR_BEAM)
+#include "beam_steer.h"
+#include "phase_steer.h"
+#endif
+#if defined(MODULATOR_TUNING)
+#include "tuning_link.h"
+#endif
+#include <cstring>
 
 static float sample_rate_hz = 96000.0f;
 
 static constexpr int kInputChannel = 0;
 static constexpr float kCarrierHz = 39500.0f;
-static float carrier_phase = 0.0f;
+// kCarrierHz / sample rate is 79/192 (79/384 at 192 kHz), so the
+// modulators play one exact period from PeriodicCarrier's table; the
+// backend is for carriers without a short period. LUT is cheapest per
+// sample; ROTATION trades the table reads for 4 multiplies and needs no
+// table memory traffic in the hot loop.
+static constexpr Nco::Backend kCarrierBackend = Nco::Backend::LUT;
 static constexpr float kModDepth = 1.0f;
 static constexpr float kCarrierLevel = 0.5f;
+// Adaptive carrier: the level follows the baseband envelope per block,
+// between ModulatorParams' carrier floor and kCarrierLevel, keeping the
+// modulation index near 1, so the transducers idle at the floor in
+// silence instead of full carrier power. AM only.
+static constexpr bool kAdaptiveCarrier = false;
 static constexpr float kBasebandGain = 1.0f;
 
-struct SimpleBiquad
+// Boot values above; live values and their derived coefficients.
+static ModulatorParams modulator_params;
+
+// Optional baseband stages. Disabled ones compile to nothing.
+static constexpr bool kEnablePreEmphasis = false;
+static constexpr bool kEnableCompressor = false;
+// Bass-only compression below 300 Hz with the same settings; an
+// alternative to kEnableCompressor, not on top of it.
+static constexpr bool kEnableBassCompressor = false;
+static_assert(!(kEnableCompressor && kEnableBassCompressor), "enable one compressor");
+// Lookahead limiter ahead of the modulator: holds the modulation index
+// to ModulatorParams::SetLimitIndex(), so kModDepth can go up without
+// transients over-modulating. Adds 1 ms of latency.
+static constexpr bool kEnableLimiter = false;
+// Thermal protection on every output (see drive_governor.h): turns a
+// channel down while its RMS over kDriveWindowS stays above
+// kDriveLimitRms. Off by default; set the limit from the transducers'
+// rated continuous drive first.
+static constexpr bool kEnableDriveGovernor = false;
+static constexpr float kDriveLimitRms = 0.45f;
+static constexpr float kDriveWindowS = 2.0f;
+// Input gate (see input_gate.h): once the input peak has stayed under
+// kGateThreshold for kGateHoldS, the baseband stages stop running and
+// only the carrier goes out, or with kGateMode kMute nothing at all
+// after a kGateFadeS fade. Loud enough input brings the full path back
+// within the block. Off by default; kMute stops the transducers idling
+// at kCarrierLevel, but not with the auto-tune, which needs the carrier.
+static constexpr bool kEnableInputGate = false;
+static constexpr InputGate::Mode kGateMode = InputGate::Mode::kCarrier;
+static constexpr float kGateThreshold = 0.0001f; // -80 dBFS
+static constexpr float kGateHoldS = 0.25f;
+static constexpr float kGateFadeS = 0.005f;
+static InputGate input_gate;
+
+// Modulation mode, picked per build environment in platformio.ini:
+//   -DMODULATOR_SSB_USB  upper sideband + carrier
+//   -DMODULATOR_SSB_LSB  lower sideband + carrier
+//   -DMODULATOR_SRAM     square-root AM, predistorted for the array's
+//                        self-demodulation (see SramMod)
+//   -DMODULATOR_MULTIZONE  kZones AM carriers, each with its own input,
+//                        frequency and outputs (see MultiZoneMod); by
+//                        default left in to left out at 39.5 kHz, right
+//                        to right at 40.5 kHz
+//   -DMODULATOR_SWITCHABLE  all of AM, DSB-SC, USB, LSB, SRAM and
+//                        adaptive AM, picked at run time with
+//                        ModulatorParams::SetModulation() or the button on
+//                        kModeButtonPin, crossfaded (see SwitchableMod)
+//   (none)               double sideband AM with carrier
+// SSB uses the 255-tap FIR Hilbert by default; -DMODULATOR_SSB_IIR
+// selects the allpass splitter (see SsbMod for the trade-off). Under
+// the FIR, DAISY.Governor() falls back to the allpass splitter while the
+// callback runs near its block period, and returns to the FIR once the
+// load allows (TieredHilbert).
+#if defined(MODULATOR_SSB_IIR)
+using SsbHilbert = HilbertIir;
+#else
+static QualityStage* ssb_quality = nullptr;
+using SsbHilbert = TieredHilbert<ssb_quality, HilbertFir<255>, HilbertIir>;
+// Only the SSB modes run SsbHilbert; the others register no stage.
+#if defined(MODULATOR_SSB_USB) || defined(MODULATOR_SSB_LSB) || defined(MODULATOR_SWITCHABLE)
+#define MODULATOR_TIERED_SSB
+#endif
+#endif
+
+#if defined(MODULATOR_SSB_USB) || defined(MODULATOR_SSB_LSB) || defined(MODULATOR_SRAM) || defined(MODULATOR_MULTIZONE)
+static_assert(!kAdaptiveCarrier, "the adaptive carrier is AM only");
+#endif
+#if defined(MODULATOR_SWITCHABLE)
+#if defined(MODULATOR_SSB_USB) || defined(MODULATOR_SSB_LSB) || defined(MODULATOR_SRAM) || defined(MODULATOR_MULTIZONE)
+#error "MODULATOR_SWITCHABLE already has every mode"
+#endif
+static_assert(!kAdaptiveCarrier, "MODULATOR_SWITCHABLE has the adaptive carrier as a mode");
+// Each press steps to the next ModulationMode. Button to ground.
+static constexpr uint32_t kModeButtonPin = D9;
+static Switch mode_button;
+#endif
+static constexpr size_t kZones = 2;
+#if defined(MODULATOR_SWITCHABLE)
+using Modulation = SwitchableMod<SsbHilbert, kCarrierBackend>;
+#elif defined(MODULATOR_SSB_USB)
+using Modulation = SsbMod<Sideband::Upper, SsbHilbert, kCarrierBackend>;
+#elif defined(MODULATOR_SSB_LSB)
+using Modulation = SsbMod<Sideband::Lower, SsbHilbert, kCarrierBackend>;
+#elif defined(MODULATOR_SRAM)
+using Modulation = SramMod<kCarrierBackend>;
+#elif defined(MODULATOR_MULTIZONE)
+using Modulation = MultiZoneMod<kZones, kCarrierBackend>;
+#else
+using Modulation = AmMod<kCarrierBackend, kAdaptiveCarrier>;
+#endif
+
+// Carrier-rate processing, also picked per build environment:
+//   -DMODULATOR_OVERSAMPLE_2X  modulation and band-limit at 192 kHz
+//                              between half-band resamplers, codec at 96 kHz
+//   -DMODULATOR_NATIVE_192K    whole pipeline at 192 kHz, for codecs
+//                              that run at that rate
+//   (neither)                  everything at 96 kHz
+// At 192 kHz the SSB Hilbert covers half the time span, so its lower
+// accurate frequency doubles.
+static constexpr size_t kUpsampleTaps = 23;    // 5 kHz images down ~80 dB
+static constexpr size_t kDownsampleTaps = 127; // flat to 44.5 kHz, -56 dB at 51.5 kHz
+
+// Baseband rate: -DMODULATOR_DECIMATED_BASEBAND runs everything ahead of
+// the modulator (filters, compressor, limiter) at a quarter of the codec
+// rate, between polyphase FIR resamplers (see DecimatedBaseband), which
+// leaves the cycles for SRAM or the multiband compressor. Adds
+// kBasebandTaps - 1 samples (0.5 ms at 96 kHz) of latency.
+static constexpr size_t kBasebandDecimation = 4;
+static constexpr size_t kBasebandTaps = 48;
+
+#if defined(MODULATOR_NATIVE_192K)
+static constexpr DaisyDuinoSampleRate kCodecRate = AUDIO_SR_192K;
+#else
+static constexpr DaisyDuinoSampleRate kCodecRate = AUDIO_SR_96K;
+#endif
+
+// Block size: -DMODULATOR_LOW_LATENCY runs 4-frame blocks, which take
+// the fixed-size conversion handlers and cut the buffering delay from
+// 2 x 48 to 2 x 4 frames (1 ms -> 83 us at 96 kHz). Costs more of
+// the CPU to per-block overhead; check DAISY.CpuLoad().
+#if defined(MODULATOR_LOW_LATENCY)
+static constexpr size_t kBlockSize = 4;
+#else
+static constexpr size_t kBlockSize = 48;
+#endif
+#if defined(MODULATOR_DECIMATED_BASEBAND)
+static_assert(kBlockSize % kBasebandDecimation == 0, "blocks must decimate whole");
+template <typename... Stages>
+using Baseband = DecimatedBaseband<kBasebandDecimation, kBasebandTaps, Stages...>;
+#else
+template <typename... Stages>
+using Baseband = Pipeline<Stages...>;
+#endif
+
+// DMA ring depth: -DMODULATOR_DMA_SEGMENTS=3 (or 4) queues one (two)
+// more blocks of output, so a callback that now and then runs past its
+// block period, e.g. behind a USB or flash interrupt, no longer drops
+// out. Each segment adds a block of latency: 3 x 4 frames = 125 us at
+// 96 kHz with MODULATOR_LOW_LATENCY. Dropped blocks show up in
+// DAISY.AudioDroppedBlocks().
+#if defined(MODULATOR_DMA_SEGMENTS)
+static constexpr size_t kDmaSegments = MODULATOR_DMA_SEGMENTS;
+#else
+static constexpr size_t kDmaSegments = 2;
+#endif
+
+// Multi-board array, picked per build environment:
+//   -DMODULATOR_ARRAY_MASTER  clocks its SAI and drives the sync line
+//   -DMODULATOR_ARRAY_SLAVE   runs its SAI off the master's SCK and FS
+//   (neither)                 one board, free-running carrier
+// Wire SCK, FS and kSyncPin from the master to every slave, plus ground.
+// The boards then run frame for frame, and once the master has pulsed
+// the sync line every carrier starts each block at the phase of a common
+// frame count, so the array radiates coherently. All boards need the
+// same build apart from the role. Power the slaves up with or before the
+// master: one that starts after the pulse runs unlocked.
+#if defined(MODULATOR_ARRAY_MASTER) || defined(MODULATOR_ARRAY_SLAVE)
+#define MODULATOR_ARRAY
+#if defined(MODULATOR_ARRAY_MASTER)
+static constexpr SampleSync::Role kSyncRole = SampleSync::Role::MASTER;
+#else
+static constexpr SampleSync::Role kSyncRole = SampleSync::Role::SLAVE;
+#endif
+static constexpr uint32_t kSyncPin = D7;
+// Time for the slaves' audio to come up before the master pulses.
+static constexpr uint32_t kSyncSettleMs = 500;
+static SampleSync sample_sync;
+#endif
+
+// Battery builds: -DMODULATOR_LOW_POWER sleeps the core in loop()
+// between interrupts and stops the flash and ITCM clocks while it
+// sleeps. The audio interrupt wakes it; DAISY.IdleWakeCycles() shows
+// what that costs.
+#if defined(MODULATOR_LOW_POWER)
+static constexpr bool kIdleSleep = true;
+#else
+static constexpr bool kIdleSleep = false;
+#endif
+
+// USB capture: -DMODULATOR_CAPTURE (with the core's CDC serial) puts
+// taps at these points, and scripts/capture.py records whichever one it
+// selects (see audio_capture.h). Without it the taps compile to nothing.
+static constexpr uint8_t kTapBaseband = 0;  // filtered baseband, pre-mod
+static constexpr uint8_t kTapModulated = 1; // straight after the modulator
+static constexpr uint8_t kTapBandPass = 2;  // after the band-pass
+static constexpr uint8_t kTapOutput = 3;    // what goes to the codec
+#if defined(MODULATOR_CAPTURE)
+static AudioCapture capture;
+template <uint8_t point>
+using Tap = CaptureTap<capture, point>;
+#else
+template <uint8_t point>
+using Tap = NullStage;
+#endif
+
+// Modulation index meter: -DMODULATOR_MOD_METER (with the core's CDC
+// serial) meters the baseband going into the modulator, and loop()
+// prints its peak and RMS index and the over-modulated blocks once per
+// kModMeterPrintMs (see mod_index_meter.h).
+#if defined(MODULATOR_MOD_METER)
+#if defined(MODULATOR_CAPTURE) || defined(MODULATOR_USB_AUDIO) || defined(MODULATOR_Q31)
+#error "MODULATOR_MOD_METER needs the float pipeline and the serial port to itself"
+#endif
+static constexpr uint32_t kModMeterPrintMs = 1000;
+static ModIndexMeter mod_meter;
+using ModMeter = ModIndexTap<mod_meter>;
+#else
+using ModMeter = NullStage;
+#endif
+
+// USB input: -DMODULATOR_USB_AUDIO makes the board a UAC2 speaker
+// (utility/usb_audio.h), and what the host plays feeds the pipeline in
+// place of the codec input, or mixed into it. Takes the USB port, so not
+// with the CDC serial of MODULATOR_CAPTURE.
+static constexpr bool kUsbMixWithCodec = false;
+#if defined(MODULATOR_USB_AUDIO)
+#if defined(MODULATOR_CAPTURE) || defined(MODULATOR_Q31)
+#error "MODULATOR_USB_AUDIO needs the float pipeline and the USB port to itself"
+#endif
+static UsbAudio usb_audio;
+#endif
+
+// SD take: -DMODULATOR_SD_RECORD records the baseband (straight after
+// the baseband stages) and the output, 4 channels of 24 bits, for
+// kSdRecordSeconds from boot into a raw take on the microSD card at
+// block kSdTakeLba (utility/sd_stream.h); scripts/sd_take.py extracts
+// it as a WAV. -DMODULATOR_SD_PLAY plays that take's first two channels
+// into the pipeline in place of the codec input, e.g. a recorded
+// baseband through a retuned pipeline. One or the other: one card.
+static constexpr uint32_t kSdTakeLba = 2048;
+static constexpr uint32_t kSdRecordSeconds = 60;
+#if defined(MODULATOR_SD_RECORD) || defined(MODULATOR_SD_PLAY)
+#if defined(MODULATOR_Q31) || defined(MODULATOR_USB_AUDIO)
+#error "MODULATOR_SD_RECORD / MODULATOR_SD_PLAY need the float pipeline and the codec input"
+#endif
+#if defined(MODULATOR_SD_RECORD) && defined(MODULATOR_SD_PLAY)
+#error "MODULATOR_SD_RECORD and MODULATOR_SD_PLAY share the card"
+#endif
+static SdCard sd_card;
+// 3.6 s of 4 channels at 96 kHz: the card's write stalls, and loop().
+static uint8_t DSY_SDRAM_BSS __attribute__((aligned(32))) sd_ring[4 * 1024 * 1024];
+#endif
+#if defined(MODULATOR_SD_RECORD)
+static SdRecorder sd_recorder;
+static uint32_t sd_started_ms = 0;
+static float DSP_DTCM sd_base_l[kPipelineMaxBlock];
+static float DSP_DTCM sd_base_r[kPipelineMaxBlock];
+// Keeps the baseband for AudioCallback to record next to the output.
+struct SdBasebandTap
 {
-  float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
-  float a1 = 0.0f, a2 = 0.0f;
-  float z1 = 0.0f, z2 = 0.0f;
-
-  inline float Process(float x)
+  void Init(float) {}
+  inline void Process(StereoBlock& b)
   {
-    const float y = (b0 * x) + z1;
-    z1 = (b1 * x) - (a1 * y) + z2;
-    z2 = (b2 * x) - (a2 * y);
-    return y;
+    memcpy(sd_base_l, b.l, b.size * sizeof(float));
+    memcpy(sd_base_r, b.r, b.size * sizeof(float));
   }
 };
-
-static SimpleBiquad base_hpf_l;
-static SimpleBiquad base_hpf_r;
-static SimpleBiquad base_lpf_l;
-static SimpleBiquad base_lpf_r;
-static SimpleBiquad low_shelf_l;
-static SimpleBiquad low_shelf_r;
-static SimpleBiquad pre_emph_l;
-static SimpleBiquad pre_emph_r;
-static SimpleBiquad bandpass_hpf_l;
-static SimpleBiquad bandpass_hpf_r;
-static SimpleBiquad bandpass_lpf_l;
-static SimpleBiquad bandpass_lpf_r;
-static SimpleBiquad bandpass_lpf2_l;
-static SimpleBiquad bandpass_lpf2_r;
-static SimpleBiquad post_hpf_l;
-static SimpleBiquad post_hpf_r;
-static SimpleBiquad post_hpf2_l;
-static SimpleBiquad post_hpf2_r;
-
-static constexpr size_t kHilbertTaps = 256;
-static constexpr size_t kHilbertCenter = (kHilbertTaps - 1) / 2;
-static float hilbert_coeffs[kHilbertTaps] = {};
-static float hilbert_state_l[kHilbertTaps] = {};
-static float hilbert_state_r[kHilbertTaps] = {};
-static size_t hilbert_index = 0;
-
-static void ConfigurePeaking(SimpleBiquad& bq, float fs, float f0, float q, float gain_db)
+#else
+using SdBasebandTap = NullStage;
+#endif
+#if defined(MODULATOR_SD_PLAY)
+static SdPlayer sd_player;
+#endif
+
+// Section profiler: -DDSY_PROFILE (with the core's CDC serial) times
+// these stages and the whole callback per block, and loop() prints the
+// table once a second (utility/section_profiler.h). Without it the
+// Profiled<> wrappers are the plain stages.
+static constexpr char kSecBaseHpf[] = "base hpf";
+static constexpr char kSecBaseLpf[] = "base lpf";
+static constexpr char kSecLowShelf[] = "low shelf";
+static constexpr char kSecModulation[] = "modulation";
+static constexpr char kSecBandPass[] = "bandpass";
+static constexpr char kSecPostHpf[] = "post hpf";
+static constexpr uint32_t kProfilePrintMs = 1000;
+#if defined(DSY_PROFILE)
+// The worst callback is printed with the table; this pin goes high after
+// every block over kWcetTriggerLoad of the period, for a logic analyser.
+static constexpr uint32_t kWcetTriggerPin = D8;
+static constexpr float kWcetTriggerLoad = 0.9f;
+#endif
+#if defined(DSY_PROFILE) && (defined(MODULATOR_CAPTURE) || defined(MODULATOR_USB_AUDIO))
+#error "DSY_PROFILE prints over the serial port MODULATOR_CAPTURE / MODULATOR_USB_AUDIO take"
+#endif
+
+// SWO telemetry: -DMODULATOR_SWO sends each block's output peaks, the
+// callback load and the overrun count on ITM ports (utility/itm_trace.h)
+// for scripts/swo_decode.py, at a few stores per block and with no USB.
+#if defined(MODULATOR_SWO)
+static ItmTrace itm;
+static constexpr uint32_t kSwoBaud = 2000000;
+static constexpr uint8_t kSwoLoad = 1;     // float, last block's load
+static constexpr uint8_t kSwoPeakL = 2;    // float, |out[0]| peak, 1.0 full scale
+static constexpr uint8_t kSwoPeakR = 3;    // float, |out[1]| peak
+static constexpr uint8_t kSwoOverruns = 4; // u32, since start
+
+template <typename T>
+static inline void SwoReport(const T* l, const T* r, size_t size, float unity)
 {
-  const float A = powf(10.0f, gain_db / 40.0f);
-  const float w0 = 2.0f * 3.14159265358979323846f * (f0 / fs);
-  const float cosw0 = cosf(w0);
-  const float sinw0 = sinf(w0);
-  const float alpha = sinw0 / (2.0f * q);
-
-  const float b0 = 1.0f + alpha * A;
-  const float b1 = -2.0f * cosw0;
-  const float b2 = 1.0f - alpha * A;
-  const float a0 = 1.0f + alpha / A;
-  const float a1 = -2.0f * cosw0;
-  const float a2 = 1.0f - alpha / A;
-
-  bq.b0 = b0 / a0;
-  bq.b1 = b1 / a0;
-  bq.b2 = b2 / a0;
-  bq.a1 = a1 / a0;
-  bq.a2 = a2 / a0;
-  bq.z1 = 0.0f;
-  bq.z2 = 0.0f;
+  T peak_l = 0;
+  T peak_r = 0;
+  for (size_t i = 0; i < size; i++)
+  {
+    const T a = l[i] < 0 ? -l[i] : l[i];
+    const T b = r[i] < 0 ? -r[i] : r[i];
+    peak_l = a > peak_l ? a : peak_l;
+    peak_r = b > peak_r ? b : peak_r;
+  }
+  itm.Write(kSwoPeakL, (float)peak_l / unity);
+  itm.Write(kSwoPeakR, (float)peak_r / unity);
+  itm.Write(kSwoLoad, DAISY.CpuLoad().GetLastCpuLoad());
+  itm.Write(kSwoOverruns, DAISY.CpuLoad().GetOverruns());
 }
+#endif
+
+// Loopback measurement: -DMODULATOR_MEASURE (with the core's CDC
+// serial) analyses output 1 as it comes back on input 2 (patch OUT L to
+// IN R) and prints its carrier level and frequency, sideband power, THD
+// and out-of-band leakage once per kMeasureIntervalMs (see
+// spectral_monitor.h). Input 1 then feeds both channels. The callback
+// only copies one block in while a frame fills; the FFT runs in loop().
+#if defined(MODULATOR_MEASURE)
+#if defined(MODULATOR_CAPTURE) || defined(MODULATOR_USB_AUDIO)
+#error "MODULATOR_MEASURE prints over the serial port MODULATOR_CAPTURE / MODULATOR_USB_AUDIO take"
+#endif
+#if defined(MODULATOR_AUTOTUNE)
+#error "MODULATOR_MEASURE and MODULATOR_AUTOTUNE both listen on input 2"
+#endif
+static constexpr int kLoopbackChannel = 1;
+static constexpr int kRightInput = kInputChannel;
+static_assert(kLoopbackChannel != kInputChannel, "the loopback needs an input of its own");
+static constexpr uint32_t kMeasureIntervalMs = 1000;
+static constexpr float kSidebandHz = 5000.0f; // BaseLpf's corner
+static SpectralMonitor<4096> spectral_monitor;
+#elif defined(MODULATOR_AUTOTUNE)
+// Carrier auto-tune: -DMODULATOR_AUTOTUNE (with the core's CDC serial)
+// sweeps the carrier across the transducers' band at boot, settles on
+// their resonance as it comes back on input 2 (a microphone in front of
+// the array, or a current-sense amplifier), then re-checks it every
+// few seconds as it drifts (see resonance_tracker.h). kCarrierHz is
+// only the start. Input 1 then feeds both channels. One board only: in
+// an array every board would tune its own carrier.
+#if defined(MODULATOR_Q31) || defined(MODULATOR_ARRAY)
+#error "MODULATOR_AUTOTUNE needs the float pipeline on a single board"
+#endif
+static_assert(!kEnableInputGate || kGateMode != InputGate::Mode::kMute, "the auto-tune needs the carrier running");
+static constexpr int kResponseChannel = 1;
+static constexpr int kRightInput = kInputChannel;
+static_assert(kResponseChannel != kInputChannel, "the response needs an input of its own");
+static ResonanceTracker resonance_tracker;
+#else
+static constexpr int kRightInput = 1;
+#endif
+
+// Beam steering: -DMODULATOR_BEAM runs SAI1 as an 8-slot TDM port for a
+// TDM DAC and drives a linear array of kBeamElements transducers, one
+// per slot. The pipeline modulates input 1 once, into out[0], and a
+// FractionalDelayBank fans that out to every element with the delay and
+// gain that steers the beam to kBeamAngleDeg (see beam_steer.h); loop()
+// or the control callback can move it with beam.SetAngle(). Build it with
+// MODULATOR_NATIVE_192K: at 96 kHz the carrier band sits too close to
+// Nyquist for short delay FIRs, and even 16 taps leave -35 dB of error.
+//
+// -DMODULATOR_BEAM_PHASE steers by the carrier's phase instead (see
+// phase_steer.h): the pipeline stops at the baseband, and a PhaseSteer
+// modulates every element from it with its own baseband delay and a
+// rotation of the one carrier NCO. Exact at 96 kHz, and cheap enough per
+// element for arrays of 16 and more; AM only, without the band-pass.
+#if defined(MODULATOR_BEAM)
+#if defined(MODULATOR_Q31)
+#error "MODULATOR_BEAM needs the float pipeline"
+#endif
+#if defined(MODULATOR_BEAM_PHASE) && (defined(MODULATOR_SSB_USB) || defined(MODULATOR_SSB_LSB) || defined(MODULATOR_SRAM) || defined(MODULATOR_MULTIZONE) || defined(MODULATOR_SWITCHABLE) || defined(MODULATOR_OVERSAMPLE_2X))
+#error "MODULATOR_BEAM_PHASE only implements the AM pipeline at the codec rate"
+#endif
+static constexpr size_t kBeamElements = 8;
+static constexpr size_t kBeamTaps = 8;        // 16 at 96 kHz
+static constexpr size_t kBeamMaxDelay = 64;   // samples; 8 x 10 mm spans 42 at 192 kHz
+static constexpr float kBeamPitchM = 0.010f;  // element centre to centre
+static constexpr float kBeamAngleDeg = 0.0f;  // from broadside
+static constexpr float kBeamBandHz = 5000.0f; // carrier +/- the baseband
+#if defined(MODULATOR_BEAM_PHASE)
+static_assert(!kAdaptiveCarrier, "PhaseSteer has a fixed carrier level");
+using BeamBank = PhaseSteer<kBeamElements, kBeamMaxDelay, 256, kCarrierBackend>;
+#else
+using BeamBank = daisysp::FractionalDelayBank<kBeamElements, kBeamMaxDelay, kBeamTaps>;
+#endif
+static BeamBank DSP_DTCM beam_bank;
+static BeamSteer<kBeamElements> beam;
+#endif
+
+// Live tuning: -DMODULATOR_TUNING (with the core's CDC serial) takes
+// binary commands from scripts/tune.py that set ModulatorParams, read
+// the meters and start a calibration, and streams the meters at up to
+// 100 Hz (see tuning_link.h). loop() does all of it; a setting reaches
+// the audio callback the way every setter's does, through Update().
+// MODULATOR_MOD_METER and MODULATOR_AUTOTUNE then report in the meter
+// frames instead of printing lines.
+#if defined(MODULATOR_TUNING)
+#if defined(MODULATOR_CAPTURE) || defined(MODULATOR_USB_AUDIO) || defined(MODULATOR_MEASURE) || defined(DSY_PROFILE)
+#error "MODULATOR_TUNING needs the serial port to itself"
+#endif
+static TuningLink tuning;
+#endif
+
+#if defined(MODULATOR_BEAM)
+static constexpr size_t kDriveChannels = kBeamElements;
+#else
+static constexpr size_t kDriveChannels = 2;
+#endif
+static DriveGovernor<kDriveChannels> drive_governor;
+
+// Band limit after the modulator, picked per build environment:
+//   -DMODULATOR_BAND_FIR  one linear-phase FIR band-pass (see BandFir):
+//                         flat group delay across the sidebands, for a
+//                         few more multiplies and 0.33 ms of latency
+//   (none)                BandPass then PostHpf, five biquads
+#if defined(MODULATOR_BAND_FIR)
+#if defined(MODULATOR_OVERSAMPLE_2X) || defined(MODULATOR_NATIVE_192K)
+static constexpr size_t kBandFirTaps = 127;
+#else
+static constexpr size_t kBandFirTaps = 63;
+#endif
+using BandLimit = Pipeline<Profiled<kSecBandPass, BandFir<kBandFirTaps>>, Tap<kTapBandPass>>;
+#else
+using BandLimit = Pipeline<Profiled<kSecBandPass, BandPass>, Tap<kTapBandPass>, Profiled<kSecPostHpf, PostHpf>>;
+#endif
+
+// Everything ahead of the modulator, at the codec rate or decimated.
+// Skipped while the input gate is closed.
+using BasebandStages = GatedIf<kEnableInputGate,
+                               input_gate,
+                               Baseband<Profiled<kSecBaseHpf, BaseHpf>,
+                                        Profiled<kSecBaseLpf, BaseLpf>,
+                                        Profiled<kSecLowShelf, LowShelf>,
+                                        StageIf<kEnablePreEmphasis, PreEmphasis>,
+                                        StageIf<kEnableCompressor, BaseComp>,
+                                        StageIf<kEnableBassCompressor, BaseBassComp>,
+                                        StageIf<kEnableLimiter, BaseLimit<>>>>;
+
+// Sample format, picked per build environment:
+//   -DMODULATOR_Q31  AM pipeline in Q31 fixed point on the codec's native
+//                    24-bit words (NativeAudioCallback, no float
+//                    conversion), see modulator_stages_q31.h
+//   (neither)        float pipeline
+// The Q31 build covers the default AM chain only.
+#if defined(MODULATOR_Q31)
+#if defined(MODULATOR_SSB_USB) || defined(MODULATOR_SSB_LSB) || defined(MODULATOR_SRAM) || defined(MODULATOR_MULTIZONE) || defined(MODULATOR_SWITCHABLE) || defined(MODULATOR_OVERSAMPLE_2X) || defined(MODULATOR_DECIMATED_BASEBAND) || defined(MODULATOR_BAND_FIR)
+#error "MODULATOR_Q31 only implements the AM pipeline at the codec rate"
+#endif
+static_assert(!kEnableCompressor, "BaseComp has no Q31 version");
+static_assert(!kEnableBassCompressor, "BaseBassComp has no Q31 version");
+static_assert(!kEnableLimiter, "BaseLimit has no Q31 version");
+static_assert(!kEnableDriveGovernor, "DriveGovernor has no Q31 version");
+static_assert(!kEnableInputGate, "InputGate has no Q31 version");
+static_assert(!kAdaptiveCarrier, "AmModQ31 has a fixed carrier level");
+using ModulatorPipeline = Pipeline<Profiled<kSecBaseHpf, Q31Filter<BaseHpf>>,
+                                   Profiled<kSecBaseLpf, Q31Filter<BaseLpf>>,
+                                   Profiled<kSecLowShelf, Q31Filter<LowShelf>>,
+                                   StageIf<kEnablePreEmphasis, Q31Filter<PreEmphasis>>,
+                                   Tap<kTapBaseband>,
+                                   Profiled<kSecModulation, AmModQ31<kCarrierBackend>>,
+                                   Tap<kTapModulated>,
+                                   Profiled<kSecBandPass, Q31Filter<BandPass>>,
+                                   Tap<kTapBandPass>,
+                                   Profiled<kSecPostHpf, Q31Filter<PostHpf>>,
+                                   Tap<kTapOutput>>;
+#elif defined(MODULATOR_BEAM_PHASE)
+// Baseband only: PhaseSteer modulates per element after the pipeline.
+using ModulatorPipeline = Pipeline<BasebandStages,
+                                   Tap<kTapBaseband>,
+                                   SdBasebandTap,
+                                   ModMeter>;
+#elif defined(MODULATOR_OVERSAMPLE_2X)
+using CarrierStages = Oversample2x<kUpsampleTaps,
+                                   kDownsampleTaps,
+                                   Profiled<kSecModulation, Modulation>,
+                                   Tap<kTapModulated>,
+                                   BandLimit>;
+using ModulatorPipeline = Pipeline<BasebandStages,
+                                   Tap<kTapBaseband>,
+                                   SdBasebandTap,
+                                   ModMeter,
+                                   CarrierStages,
+                                   Tap<kTapOutput>>;
+#else
+using ModulatorPipeline = Pipeline<BasebandStages,
+                                   Tap<kTapBaseband>,
+                                   SdBasebandTap,
+                                   ModMeter,
+                                   Profiled<kSecModulation, Modulation>,
+                                   Tap<kTapModulated>,
+                                   BandLimit,
+                                   Tap<kTapOutput>>;
+#endif
+// Filter state, NCO and scratch buffers are touched every sample; keep
+// them in DTCM so the ISR never waits on the D-cache.
+static ModulatorPipeline DSP_DTCM pipeline;
+
+// Coefficient updates run at about this rate from the control
+// callback, below the audio interrupt and independent of loop().
+static constexpr float kControlRateHz = 1000.0f;
 
-static void ConfigureHighShelf(SimpleBiquad& bq, float fs, float f0, float q, float gain_db)
-{
-  const float A = powf(10.0f, gain_db / 40.0f);
-  const float w0 = 2.0f * 3.14159265358979323846f * (f0 / fs);
-  const float cosw0 = cosf(w0);
-  const float sinw0 = sinf(w0);
-  const float alpha = sinw0 / (2.0f * q);
-  const float sqrtA = sqrtf(A);
-
-  const float b0 =    A * ((A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha);
-  const float b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0);
-  const float b2 =    A * ((A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha);
-  const float a0 =         (A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha;
-  const float a1 =  2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0);
-  const float a2 =         (A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha;
-
-  bq.b0 = b0 / a0;
-  bq.b1 = b1 / a0;
-  bq.b2 = b2 / a0;
-  bq.a1 = a1 / a0;
-  bq.a2 = a2 / a0;
-  bq.z1 = 0.0f;
-  bq.z2 = 0.0f;
-}
+// Output:
+// - out[0]: in[kInputChannel] modulated onto the carrier, band-limited
+// - out[1]: in[1] modulated onto the carrier, band-limited
+// - with MODULATOR_BEAM, out[0 .. kBeamElements - 1]: out[0] steered
 
-static void ConfigureLowShelf(SimpleBiquad& bq, float fs, float f0, float q, float gain_db)
+#if !defined(MODULATOR_Q31)
+DSP_ITCM void AudioCallback(float** in, float** out, size_t size)
 {
-  const float A = powf(10.0f, gain_db / 40.0f);
-  const float w0 = 2.0f * 3.14159265358979323846f * (f0 / fs);
-  const float cosw0 = cosf(w0);
-  const float sinw0 = sinf(w0);
-  const float alpha = sinw0 / (2.0f * q);
-  const float sqrtA = sqrtf(A);
-
-  const float b0 =    A * ((A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha);
-  const float b1 =  2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw0);
-  const float b2 =    A * ((A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha);
-  const float a0 =         (A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtA * alpha;
-  const float a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw0);
-  const float a2 =         (A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtA * alpha;
-
-  bq.b0 = b0 / a0;
-  bq.b1 = b1 / a0;
-  bq.b2 = b2 / a0;
-  bq.a1 = a1 / a0;
-  bq.a2 = a2 / a0;
-  bq.z1 = 0.0f;
-  bq.z2 = 0.0f;
-}
+  DSY_PROFILE_SCOPE("callback");
+  const bool have_in1 = (in != nullptr) && (in[kInputChannel] != nullptr);
+  const bool have_in2 = (in != nullptr) && (in[kRightInput] != nullptr);
 
-static float Compress(float x, float& env, float threshold, float ratio, float attack, float release)
-{
-  const float ax = fabsf(x);
-  if (ax > env)
-    env += (ax - env) * attack;
-  else
-    env += (ax - env) * release;
+  float* out_l = out[0];
+  float* out_r = out[1];
 
-  float gain = 1.0f;
-  if (env > threshold)
+  // The pipeline works in place, so the output buffers carry the
+  // block from the first stage to the last.
+  if (have_in1)
+    memcpy(out_l, in[kInputChannel], size * sizeof(float));
+  else
+    memset(out_l, 0, size * sizeof(float));
+  if (have_in2)
+    memcpy(out_r, in[kRightInput], size * sizeof(float));
+  else
+    memset(out_r, 0, size * sizeof(float));
+#if defined(MODULATOR_MEASURE)
+  if (in != nullptr && in[kLoopbackChannel] != nullptr)
+    spectral_monitor.Capture(in[kLoopbackChannel], size);
+#endif
+#if defined(MODULATOR_SD_PLAY)
+  float* play[2] = {out_l, out_r};
+  sd_player.Process(play, 2, size);
+#endif
+#if defined(MODULATOR_USB_AUDIO)
+  if (kUsbMixWithCodec)
+    usb_audio.Add(out_l, out_r, size);
+  else
+    usb_audio.Read(out_l, out_r, size);
+#endif
+  if (kEnableInputGate)
+    input_gate.Detect(out_l, out_r, size);
+
+  // One consistent coefficient set for the whole block; no libm here.
+  StereoBlock block{out_l, out_r, size, modulator_params.Snapshot()};
+#if defined(MODULATOR_ARRAY)
+  block.has_frame = sample_sync.Synced();
+  block.frame = sample_sync.Shared(DAISY.AudioBlockFrame());
+#endif
+  // A muted input gate skips the pipeline; its stages wait where they
+  // are for the fade back in.
+  if (!input_gate.Muted())
   {
-    const float over = env / threshold;
-    gain = powf(over, (1.0f / ratio) - 1.0f);
+    pipeline.Process(block);
+#if defined(MODULATOR_AUTOTUNE)
+    if (in != nullptr && in[kResponseChannel] != nullptr)
+      resonance_tracker.Capture(out_l, in[kResponseChannel], size);
+#endif
+#if defined(MODULATOR_BEAM)
+#if defined(MODULATOR_BEAM_PHASE)
+    beam_bank.SetCarrier(block);
+#endif
+    beam.Process(beam_bank, out_l, out, size);
+#endif
   }
-  return x * gain;
-}
-
-static void ConfigureHighpass(SimpleBiquad& bq, float fs, float fc, float q)
-{
-  const float w0 = 2.0f * 3.14159265358979323846f * (fc / fs);
-  const float cosw0 = cosf(w0);
-  const float sinw0 = sinf(w0);
-  const float alpha = sinw0 / (2.0f * q);
-
-  const float b0 = (1.0f + cosw0) * 0.5f;
-  const float b1 = -(1.0f + cosw0);
-  const float b2 = (1.0f + cosw0) * 0.5f;
-  const float a0 = 1.0f + alpha;
-  const float a1 = -2.0f * cosw0;
-  const float a2 = 1.0f - alpha;
-
-  bq.b0 = b0 / a0;
-  bq.b1 = b1 / a0;
-  bq.b2 = b2 / a0;
-  bq.a1 = a1 / a0;
-  bq.a2 = a2 / a0;
-  bq.z1 = 0.0f;
-  bq.z2 = 0.0f;
-}
-
-static void ConfigureLowpass(SimpleBiquad& bq, float fs, float fc, float q)
-{
-  const float w0 = 2.0f * 3.14159265358979323846f * (fc / fs);
-  const float cosw0 = cosf(w0);
-  const float sinw0 = sinf(w0);
-  const float alpha = sinw0 / (2.0f * q);
-
-  const float b0 = (1.0f - cosw0) * 0.5f;
-  const float b1 = 1.0f - cosw0;
-  const float b2 = (1.0f - cosw0) * 0.5f;
-  const float a0 = 1.0f + alpha;
-  const float a1 = -2.0f * cosw0;
-  const float a2 = 1.0f - alpha;
-
-  bq.b0 = b0 / a0;
-  bq.b1 = b1 / a0;
-  bq.b2 = b2 / a0;
-  bq.a1 = a1 / a0;
-  bq.a2 = a2 / a0;
-  bq.z1 = 0.0f;
-  bq.z2 = 0.0f;
+  if (kEnableInputGate)
+    input_gate.Apply(out, kDriveChannels, size);
+  if (kEnableDriveGovernor)
+    drive_governor.Process(out, kDriveChannels, size);
+#if defined(MODULATOR_SD_RECORD)
+  if (input_gate.Muted())
+  {
+    // No baseband stages ran: the gate took the input to silence.
+    memset(sd_base_l, 0, size * sizeof(float));
+    memset(sd_base_r, 0, size * sizeof(float));
+  }
+  const float* take[4] = {sd_base_l, sd_base_r, out_l, out_r};
+  sd_recorder.Process(take, size);
+#endif
+#if defined(MODULATOR_SWO)
+  SwoReport(out_l, out_r, size, 1.0f);
+#endif
 }
-
-static void InitHilbertCoeffs()
+#else
+// Planar Q31 work buffers; the native callback hands out interleaved
+// SAI words.
+static int32_t DSP_DTCM q31_l[kPipelineMaxBlock];
+static int32_t DSP_DTCM q31_r[kPipelineMaxBlock];
+
+// Same routing as AudioCallback, on 24-bit words. size is in frames
+// per SAI, two interleaved words each.
+DSP_ITCM void AudioCallbackQ31(const int32_t* const* in, int32_t* const* out, size_t size)
 {
-  for (size_t i = 0; i < kHilbertTaps; ++i)
+  DSY_PROFILE_SCOPE("callback");
+  const size_t frames = size;
+  const int32_t* src = in[0];
+  for (size_t i = 0; i < frames; i++)
   {
-    const int n = static_cast<int>(i) - static_cast<int>(kHilbertCenter);
-    if (n == 0)
-    {
-      hilbert_coeffs[i] = 0.0f;
-      continue;
-    }
-
-    const bool is_odd = (n & 1) != 0;
-    const float ideal = is_odd ? (2.0f / (3.14159265358979323846f * static_cast<float>(n))) : 0.0f;
-    const float t = static_cast<float>(i) / static_cast<float>(kHilbertTaps - 1);
-    const float w = 0.35875f
-            - 0.48829f * cosf(2.0f * 3.14159265358979323846f * t)
-            + 0.14128f * cosf(4.0f * 3.14159265358979323846f * t)
-            - 0.01168f * cosf(6.0f * 3.14159265358979323846f * t);
-    hilbert_coeffs[i] = ideal * w;
+    q31_l[i] = Sai24ToQ31(src[2 * i + kInputChannel]);
+    q31_r[i] = Sai24ToQ31(src[2 * i + kRightInput]);
   }
-
-  for (size_t i = 0; i < kHilbertTaps; ++i)
+#if defined(MODULATOR_MEASURE)
+  spectral_monitor.Capture(src + kLoopbackChannel, 2, frames, [](int32_t w) { return (float)Sai24ToQ31(w) / kQ31Unity; });
+#endif
+
+  Q31Block block{q31_l, q31_r, frames, modulator_params.Snapshot()};
+#if defined(MODULATOR_ARRAY)
+  block.has_frame = sample_sync.Synced();
+  block.frame = sample_sync.Shared(DAISY.AudioBlockFrame());
+#endif
+  pipeline.Process(block);
+#if defined(MODULATOR_SWO)
+  SwoReport(q31_l, q31_r, frames, kQ31Unity);
+#endif
+
+  int32_t* dst = out[0];
+  for (size_t i = 0; i < frames; i++)
   {
-    hilbert_state_l[i] = 0.0f;
-    hilbert_state_r[i] = 0.0f;
+    dst[2 * i] = Q31ToSai24(q31_l[i]);
+    dst[2 * i + 1] = Q31ToSai24(q31_r[i]);
   }
-  hilbert_index = 0;
 }
+#endif
 
-static float ProcessHilbert(float x, float* state)
+void ControlCallback(size_t frames)
 {
-  state[hilbert_index] = x;
-  float y = 0.0f;
-
-  size_t idx = hilbert_index;
-  for (size_t i = 0; i < kHilbertTaps; ++i)
+  if (kEnableDriveGovernor)
+    drive_governor.Govern(frames);
+#if defined(MODULATOR_SWITCHABLE)
+  mode_button.Debounce();
+  if (mode_button.RisingEdge())
   {
-    y += hilbert_coeffs[i] * state[idx];
-    if (idx == 0)
-      idx = kHilbertTaps - 1;
-    else
-      --idx;
+    const size_t next = ((size_t)modulator_params.Modulation() + 1) % kModulationModes;
+    modulator_params.SetModulation((ModulationMode)next);
   }
-
-  return y;
+#endif
+#if defined(MODULATOR_MOD_METER)
+  mod_meter.Poll();
+#endif
+  // Recomputes derived coefficients only after a setter changed something.
+  modulator_params.Update();
+#if defined(MODULATOR_BEAM)
+  beam.Update();
+#endif
 }
 
-// Output:
-// - out[0]: input passthrough (96 kHz)
-// - out[1]: input passthrough (96 kHz)
-
-void AudioCallback(float** in, float** out, size_t size)
+#if defined(MODULATOR_TUNING)
+static void TuningMeters(TuningLink::Meters& m)
 {
-  const bool have_in1 = (in != nullptr) && (in[kInputChannel] != nullptr);
-  const bool have_in2 = (in != nullptr) && (in[1] != nullptr);
-  const float phase_inc = (2.0f * 3.14159265358979323846f * kCarrierHz) / sample_rate_hz;
-  const float attack = 1.0f - expf(-1.0f / (0.005f * sample_rate_hz));
-  const float release = 1.0f - expf(-1.0f / (0.050f * sample_rate_hz));
-  const float threshold = 0.6f;
-  const float ratio = 3.0f;
-  static float env_l = 0.0f;
-  static float env_r = 0.0f;
+  m.load_avg = DAISY.CpuLoad().GetAvgCpuLoad();
+  m.load_max = DAISY.CpuLoad().GetMaxCpuLoad();
+  m.overruns = DAISY.CpuLoad().GetOverruns();
+  m.dropped_blocks = (uint32_t)DAISY.AudioDroppedBlocks();
+  m.carrier_hz = modulator_params.CarrierFreq();
+#if defined(MODULATOR_MOD_METER)
+  const ModIndexMeter::Report r = mod_meter.GetReport();
+  m.mod_peak = r.peak;
+  m.mod_rms = r.rms;
+  m.mod_over = r.over_total;
+#endif
+  m.drive_gain[0] = drive_governor.Gain(0);
+  m.drive_gain[1] = drive_governor.Gain(1);
+}
 
-  for (size_t i = 0; i < size; i++)
+static TuningLink::Status TuningCalibrate(uint8_t what)
+{
+  switch (what)
   {
-    float x = have_in1 ? in[kInputChannel][i] : 0.0f;
-    float y = have_in2 ? in[1][i] : 0.0f;
-
-    x = base_lpf_l.Process(base_hpf_l.Process(x));
-    y = base_lpf_r.Process(base_hpf_r.Process(y));
-
-    x = low_shelf_l.Process(x);
-    y = low_shelf_r.Process(y);
-
-    // x = pre_emph_l.Process(x);
-    // y = pre_emph_r.Process(y);
-
-    // x = Compress(x, env_l, threshold, ratio, attack, release);
-    // y = Compress(y, env_r, threshold, ratio, attack, release);
-
-    const float carrier = sinf(carrier_phase);
-    carrier_phase += phase_inc;
-    if (carrier_phase > 2.0f * 3.14159265358979323846f)
-      carrier_phase -= 2.0f * 3.14159265358979323846f;
-
-    const float mod_l = (kCarrierLevel + (kModDepth * kBasebandGain * x)) * carrier;
-    const float mod_r = (kCarrierLevel + (kModDepth * kBasebandGain * y)) * carrier;
-
-    const float bp_l = bandpass_lpf2_l.Process(bandpass_lpf_l.Process(bandpass_hpf_l.Process(mod_l)));
-    const float bp_r = bandpass_lpf2_r.Process(bandpass_lpf_r.Process(bandpass_hpf_r.Process(mod_r)));
-
-    out[0][i] = post_hpf2_l.Process(post_hpf_l.Process(bp_l));
-    out[1][i] = post_hpf2_r.Process(post_hpf_r.Process(bp_r));
+    case TuningLink::kResetMeters:
+      DAISY.CpuLoad().Reset();
+#if defined(MODULATOR_MOD_METER)
+      mod_meter.ResetHold();
+#endif
+      return TuningLink::kOk;
+#if defined(MODULATOR_AUTOTUNE)
+    case TuningLink::kResweep:
+      resonance_tracker.Resweep();
+      return TuningLink::kOk;
+#endif
+    default:
+      return TuningLink::kUnsupported;
   }
 }
+#endif
 
 void setup()
 {
-  // ADC supports up to 96 kHz on this hardware.
-  DAISY.init(DAISY_SEED, AUDIO_SR_96K);
-  DAISY.SetAudioBlockSize(48);
+  // The Seed's stock codec tops out at 96 kHz; AUDIO_SR_192K is only for
+  // boards whose codec supports it (MODULATOR_NATIVE_192K).
+  // Flush denormals in the audio ISR: the 19-24 kHz high-Q sections
+  // ring down into them on near-silent input.
+#if defined(MODULATOR_CPU_BOOST)
+  // 480 MHz at VOS0: about 20% more cycles per block for more supply
+  // current. D- and I-cache on, flash at 4 wait states. DAISY.SysClkFreq()
+  // reports what the PLL actually settled on.
+  System::Config sys;
+  sys.Boost();
+  DAISY.init(DAISY_SEED, kCodecRate, sys, true);
+#else
+  DAISY.init(DAISY_SEED, kCodecRate, true);
+#endif
+#if defined(MODULATOR_BEAM)
+  // First: the TDM frame sets how many frames the DMA buffers hold.
+  DAISY.SetAudioSlots(SaiHandle::Config::Slots::TDM_8);
+#endif
+  DAISY.SetAudioDmaSegments(kDmaSegments);
+  DAISY.SetAudioBlockSize(kBlockSize);
   sample_rate_hz = DAISY.get_samplerate();
 
-  ConfigureHighpass(base_hpf_l, sample_rate_hz, 200.0f, 0.70710678f);
-  ConfigureHighpass(base_hpf_r, sample_rate_hz, 200.0f, 0.70710678f);
-  ConfigureLowpass(base_lpf_l, sample_rate_hz, 5000.0f, 0.70710678f);
-  ConfigureLowpass(base_lpf_r, sample_rate_hz, 5000.0f, 0.70710678f);
-  ConfigureLowShelf(low_shelf_l, sample_rate_hz, 200.0f, 1.5f, -3.0f);
-  ConfigureLowShelf(low_shelf_r, sample_rate_hz, 200.0f, 1.5f, -3.0f);
-  // ConfigureHighShelf(pre_emph_l, sample_rate_hz, 3000.0f, 0.7f, 6.0f);
-  // ConfigureHighShelf(pre_emph_r, sample_rate_hz, 3000.0f, 0.7f, 6.0f);
-  ConfigureHighpass(bandpass_hpf_l, sample_rate_hz, 24000.0f, 0.70710678f);
-  ConfigureHighpass(bandpass_hpf_r, sample_rate_hz, 24000.0f, 0.70710678f);
-  ConfigureLowpass(bandpass_lpf_l, sample_rate_hz, 45000.0f, 0.70710678f);
-  ConfigureLowpass(bandpass_lpf_r, sample_rate_hz, 45000.0f, 0.70710678f);
-  ConfigureLowpass(bandpass_lpf2_l, sample_rate_hz, 45000.0f, 0.70710678f);
-  ConfigureLowpass(bandpass_lpf2_r, sample_rate_hz, 45000.0f, 0.70710678f);
-  ConfigureHighpass(post_hpf_l, sample_rate_hz, 19000.0f, 0.70710678f);
-  ConfigureHighpass(post_hpf_r, sample_rate_hz, 19000.0f, 0.70710678f);
-  ConfigureHighpass(post_hpf2_l, sample_rate_hz, 19000.0f, 0.70710678f);
-  ConfigureHighpass(post_hpf2_r, sample_rate_hz, 19000.0f, 0.70710678f);
-
-  InitHilbertCoeffs();
-
+#if defined(MODULATOR_CAPTURE)
+  Serial.begin(115200);
+  capture.Init(); // before the taps' Init() gives it their rates
+#endif
+#if defined(DSY_PROFILE)
+  Serial.begin(115200);
+  section_profiler.Init();
+  DAISY.Wcet().SetTrigger(kWcetTriggerPin, kWcetTriggerLoad);
+#endif
+#if defined(MODULATOR_SWO)
+  itm.Init(kSwoBaud);
+  itm.println("modulator: SWO telemetry on ports 1-4");
+#endif
+#if defined(MODULATOR_MEASURE)
+  Serial.begin(115200);
+  spectral_monitor.Init(sample_rate_hz);
+#endif
+#if defined(MODULATOR_AUTOTUNE)
+  Serial.begin(115200);
+  resonance_tracker.Init(sample_rate_hz);
+#endif
+#if defined(MODULATOR_MOD_METER)
+  Serial.begin(115200);
+#endif
+#if defined(MODULATOR_TUNING)
+  Serial.begin(115200);
+  tuning.Init(modulator_params, TuningMeters, TuningCalibrate);
+#endif
+#if defined(MODULATOR_USB_AUDIO)
+  // Silence from USB if the rate is not one it offers (48 or 96 kHz).
+  usb_audio.Init(sample_rate_hz);
+#endif
+  pipeline.Init(sample_rate_hz);
+#if defined(MODULATOR_TIERED_SSB)
+  // Before begin(): the governor starts stepping with the first block.
+  ssb_quality = DAISY.Governor().Add("ssb hilbert", 2);
+#endif
+
+  modulator_params.SetCarrierFreq(kCarrierHz);
+  modulator_params.SetCarrierLevel(kCarrierLevel);
+  modulator_params.SetModDepth(kModDepth);
+  modulator_params.SetBasebandGain(kBasebandGain);
+  modulator_params.Init(sample_rate_hz);
+
+  DriveGovernor<kDriveChannels>::Config drive;
+  drive.window_s = kDriveWindowS;
+  drive.limit_rms = kDriveLimitRms;
+  drive_governor.Init(sample_rate_hz, drive);
+
+  InputGate::Config gate;
+  gate.threshold = kGateThreshold;
+  gate.hold_s = kGateHoldS;
+  gate.fade_s = kGateFadeS;
+  gate.mode = kGateMode;
+  input_gate.Init(sample_rate_hz, gate);
+
+#if defined(MODULATOR_BEAM)
+#if defined(MODULATOR_BEAM_PHASE)
+  beam_bank.Init(sample_rate_hz);
+#else
+  beam_bank.Init(sample_rate_hz, kCarrierHz - kBeamBandHz, kCarrierHz + kBeamBandHz);
+#endif
+  beam.SetAngle(kBeamAngleDeg);
+  beam.Init(sample_rate_hz, kBeamPitchM, BeamBank::GetMinDelay());
+#endif
+
+#if defined(MODULATOR_ARRAY)
+  // Before begin(): the slaves' SAI must not drive the shared clock lines.
+  if (kSyncRole == SampleSync::Role::SLAVE)
+    DAISY.SetAudioClock(SaiHandle::Config::Clock::EXTERNAL);
+  sample_sync.Init(kSyncRole, kSyncPin, []() { return DAISY.AudioFrameCount(); });
+#endif
+
+#if defined(MODULATOR_SWITCHABLE)
+  mode_button.Init(kControlRateHz, true, kModeButtonPin, INPUT_PULLUP);
+#endif
+
+  const float blocks_per_tick = sample_rate_hz / (kBlockSize * kControlRateHz);
+  DAISY.SetControlCallback(ControlCallback, blocks_per_tick > 1.0f ? (size_t)blocks_per_tick : 1);
+
+  DAISY.SetIdleSleep(kIdleSleep, kIdleSleep);
+
+#if defined(MODULATOR_SD_RECORD) || defined(MODULATOR_SD_PLAY)
+  // Without a card the modulator runs as it would without the take.
+  const bool have_card = sd_card.Init();
+#endif
+#if defined(MODULATOR_SD_RECORD)
+  if (have_card && sd_recorder.Init(&sd_card, sd_ring, sizeof(sd_ring)))
+  {
+    sd_recorder.Start(kSdTakeLba, (uint32_t)sample_rate_hz, 4);
+    sd_started_ms = millis();
+  }
+#endif
+#if defined(MODULATOR_SD_PLAY)
+  // A take at another rate would play at the wrong pitch: not at all.
+  if (have_card && sd_player.Init(&sd_card, sd_ring, sizeof(sd_ring))
+      && sd_player.Open(kSdTakeLba) && sd_player.GetSampleRate() == (uint32_t)sample_rate_hz)
+    sd_player.Start();
+#endif
+
+#if defined(MODULATOR_Q31)
+  // Sai24ToQ31 assumes the Seed's 24-bit codec words; any other format
+  // leaves the audio off rather than playing garbage.
+  if (DAISY.AudioBitDepth() == SaiHandle::Config::BitDepth::SAI_24BIT)
+    DAISY.begin(AudioCallbackQ31);
+#elif defined(MODULATOR_BEAM)
+  // Without the TDM slots there is nowhere to put the elements.
+  if (DAISY.AudioChannels() >= kBeamElements)
+    DAISY.begin(AudioCallback);
+#else
   DAISY.begin(AudioCallback);
+#endif
 }
 
-void loop() {}
\ No newline at end of file
+void loop()
+{
+  // Setters may be called from here; ControlCallback publishes them.
+#if defined(MODULATOR_ARRAY_MASTER)
+  if (!sample_sync.Synced() && millis() >= kSyncSettleMs)
+    sample_sync.Pulse();
+#endif
+#if defined(MODULATOR_CAPTURE)
+  capture.Poll(Serial);
+#endif
+#if defined(MODULATOR_SWO)
+  itm.Flush();
+#endif
+#if defined(MODULATOR_SD_RECORD)
+  if (sd_recorder.IsRecording() && millis() - sd_started_ms >= kSdRecordSeconds * 1000)
+    sd_recorder.Stop();
+  sd_recorder.Service();
+#endif
+#if defined(MODULATOR_SD_PLAY)
+  sd_player.Service();
+#endif
+#if defined(MODULATOR_MEASURE)
+  static uint32_t measured_ms = 0;
+  if (millis() - measured_ms >= kMeasureIntervalMs)
+  {
+    measured_ms = millis();
+    spectral_monitor.Trigger();
+  }
+  if (spectral_monitor.Poll(modulator_params.CarrierFreq(), kSidebandHz))
+    spectral_monitor.Print(Serial);
+#endif
+#if defined(MODULATOR_AUTOTUNE)
+  const ResonanceTracker::Event tune = resonance_tracker.Poll(millis());
+  if (tune != ResonanceTracker::Event::kNone)
+    modulator_params.SetCarrierFreq(resonance_tracker.Carrier());
+#if !defined(MODULATOR_TUNING)
+  if (tune == ResonanceTracker::Event::kLocked)
+    resonance_tracker.Print(Serial);
+#endif
+#endif
+#if defined(MODULATOR_TUNING)
+  tuning.Poll(Serial, millis());
+#endif
+#if defined(MODULATOR_MOD_METER) && !defined(MODULATOR_TUNING)
+  static uint32_t meter_printed_ms = 0;
+  if (millis() - meter_printed_ms >= kModMeterPrintMs)
+  {
+    meter_printed_ms = millis();
+    mod_meter.Print(Serial);
+  }
+#endif
+#if defined(DSY_PROFILE)
+  static uint32_t profile_printed_ms = 0;
+  section_profiler.Aggregate();
+  if (millis() - profile_printed_ms >= kProfilePrintMs)
+  {
+    profile_printed_ms = millis();
+    // WCET first: it sets its sections against this window's averages.
+    DAISY.Wcet().Print(Serial);
+    section_profiler.Print(Serial, DAISY.CpuLoad().GetPeriodCycles());
+    DAISY.Governor().Print(Serial);
+  }
+#endif
+  DAISY.Idle();
+}
\ No newline at end of file